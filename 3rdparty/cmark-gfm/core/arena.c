@@ -1,10 +1,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include "config.h"
 #include "cmark-gfm.h"
 #include "cmark-gfm-extension_api.h"
 
-static struct arena_chunk {
+// Each thread gets its own arena, so that cmark_arena_reset() only frees
+// the memory of the documents parsed on the calling thread.
+static CMARK_THREAD_LOCAL struct arena_chunk {
   size_t sz, used;
   uint8_t push_point;
   void *ptr;
@@ -134,6 +134,27 @@ static void cmark_parser_reset(cmark_parser *parser) {
   parser->options = saved_options;
 }
 
+void cmark_parser_reuse(cmark_parser *parser, int options, cmark_mem *mem,
+                        int free_state) {
+  cmark_llist *saved_exts = parser->syntax_extensions;
+  cmark_llist *saved_inline_exts = parser->inline_syntax_extensions;
+
+  if (free_state) {
+    cmark_parser_dispose(parser);
+    cmark_strbuf_free(&parser->curline);
+    cmark_strbuf_free(&parser->linebuf);
+  }
+
+  // Clear the state before resetting, so that the reset does not free it.
+  memset(parser, 0, sizeof(cmark_parser));
+  parser->mem = mem;
+  parser->options = options;
+  parser->syntax_extensions = saved_exts;
+  parser->inline_syntax_extensions = saved_inline_exts;
+
+  cmark_parser_reset(parser);
+}
+
 cmark_parser *cmark_parser_new_with_mem(int options, cmark_mem *mem) {
   cmark_parser *parser = (cmark_parser *)mem->calloc(1, sizeof(cmark_parser));
   parser->mem = mem;
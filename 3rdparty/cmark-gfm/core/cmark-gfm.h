@@ -568,6 +568,19 @@ cmark_parser *cmark_parser_new_with_mem(int options, cmark_mem *mem);
 CMARK_GFM_EXPORT
 void cmark_parser_free(cmark_parser *parser);
 
+/** Prepares a parser to parse a new document with the given options,
+ * keeping its attached syntax extensions, and allocating the state of the
+ * parse with the given memory allocator.  If 'free_state' is zero, the
+ * state of the previous parse is dropped rather than freed, which is only
+ * correct if it was allocated from an arena that has since been reset.
+ * Note that the parser object and its list of extensions are still freed
+ * with the allocator it was created with, so give it the same allocator
+ * again before calling cmark_parser_free().
+ */
+CMARK_GFM_EXPORT
+void cmark_parser_reuse(cmark_parser *parser, int options, cmark_mem *mem,
+                        int free_state);
+
 /** Feeds a string of length 'len' to 'parser'.
  */
 CMARK_GFM_EXPORT
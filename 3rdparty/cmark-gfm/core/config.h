@@ -33,6 +33,19 @@ extern "C" {
   #endif
 #endif
 
+/* Storage class for state that must not be shared between threads
+   (the arena allocator and the inline special character tables), so
+   that documents can be parsed on several threads at once.
+*/
+
+#ifndef CMARK_THREAD_LOCAL
+  #if defined(_MSC_VER)
+    #define CMARK_THREAD_LOCAL __declspec(thread)
+  #else
+    #define CMARK_THREAD_LOCAL __thread
+  #endif
+#endif
+
 /* snprintf and vsnprintf fallbacks for MSVC before 2015,
    due to Valentin Milea http://stackoverflow.com/questions/2915672/
 */
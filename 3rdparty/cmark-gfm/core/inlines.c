@@ -57,8 +57,9 @@ typedef struct subject{
   bool scanned_for_backticks;
 } subject;
 
-// Extensions may populate this.
-static int8_t SKIP_CHARS[256];
+// Extensions may populate this.  Thread-local since extensions add and
+// remove their characters around each parse.
+static CMARK_THREAD_LOCAL int8_t SKIP_CHARS[256];
 
 static CMARK_INLINE bool S_is_line_end_char(char c) {
   return (c == '\n' || c == '\r');
@@ -1225,7 +1226,7 @@ static cmark_node *handle_newline(subject *subj) {
 }
 
 // "\r\n\\`&_*[]<!"
-static int8_t SPECIAL_CHARS[256] = {
+static CMARK_THREAD_LOCAL int8_t SPECIAL_CHARS[256] = {
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
       0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0,
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -1253,9 +1254,95 @@ static char SMART_PUNCT_CHARS[] = {
       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 };
 
+// The special characters (with and without the smart punctuation ones) as
+// lists, so that a whole stride of bytes can be compared against each of
+// them at once.  Rebuilt from the tables above whenever they change.  If
+// there are more than MAX_SPECIAL_CHAR_LIST special characters, the bytes
+// are only ever scanned one at a time.
+#define MAX_SPECIAL_CHAR_LIST 32
+
+static CMARK_THREAD_LOCAL unsigned char SPECIAL_CHAR_LIST[2][MAX_SPECIAL_CHAR_LIST];
+static CMARK_THREAD_LOCAL int SPECIAL_CHAR_COUNT[2];
+static CMARK_THREAD_LOCAL bool SPECIAL_CHAR_LIST_VALID;
+
+static void build_special_char_list(void) {
+  int smart;
+  int c;
+
+  for (smart = 0; smart < 2; smart++) {
+    int count = 0;
+
+    for (c = 0; c < 256; c++) {
+      if (SPECIAL_CHARS[c] || (smart && SMART_PUNCT_CHARS[c])) {
+        if (count < MAX_SPECIAL_CHAR_LIST)
+          SPECIAL_CHAR_LIST[smart][count] = (unsigned char)c;
+        count++;
+      }
+    }
+
+    SPECIAL_CHAR_COUNT[smart] = count;
+  }
+
+  SPECIAL_CHAR_LIST_VALID = true;
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CMARK_SPECIAL_CHAR_STRIDE 16
+
+// Returns whether any of the 16 bytes at data is one of the given chars.
+static CMARK_INLINE bool stride_has_special_char(const unsigned char *data,
+                                                 const unsigned char *chars,
+                                                 int count) {
+  __m128i bytes = _mm_loadu_si128((const __m128i *)data);
+  __m128i hits = _mm_setzero_si128();
+  int i;
+
+  for (i = 0; i < count; i++)
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)chars[i])));
+
+  return _mm_movemask_epi8(hits) != 0;
+}
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define CMARK_SPECIAL_CHAR_STRIDE 16
+
+// Returns whether any of the 16 bytes at data is one of the given chars.
+static CMARK_INLINE bool stride_has_special_char(const unsigned char *data,
+                                                 const unsigned char *chars,
+                                                 int count) {
+  uint8x16_t bytes = vld1q_u8(data);
+  uint8x16_t hits = vdupq_n_u8(0);
+  int i;
+
+  for (i = 0; i < count; i++)
+    hits = vorrq_u8(hits, vceqq_u8(bytes, vdupq_n_u8(chars[i])));
+
+  return vmaxvq_u8(hits) != 0;
+}
+#endif
+
 static bufsize_t subject_find_special_char(subject *subj, int options) {
   bufsize_t n = subj->pos + 1;
 
+#ifdef CMARK_SPECIAL_CHAR_STRIDE
+  int smart = (options & CMARK_OPT_SMART) ? 1 : 0;
+
+  if (!SPECIAL_CHAR_LIST_VALID)
+    build_special_char_list();
+
+  // Skip whole strides of ordinary bytes, such as those of long runs of
+  // prose, leaving the stride with the special character to the loop
+  // below.
+  if (SPECIAL_CHAR_COUNT[smart] <= MAX_SPECIAL_CHAR_LIST) {
+    while (n + CMARK_SPECIAL_CHAR_STRIDE <= subj->input.len &&
+           !stride_has_special_char(subj->input.data + n,
+                                    SPECIAL_CHAR_LIST[smart],
+                                    SPECIAL_CHAR_COUNT[smart]))
+      n += CMARK_SPECIAL_CHAR_STRIDE;
+  }
+#endif
+
   while (n < subj->input.len) {
     if (SPECIAL_CHARS[subj->input.data[n]])
       return n;
@@ -1269,12 +1356,14 @@ static bufsize_t subject_find_special_char(subject *subj, int options) {
 
 void cmark_inlines_add_special_character(unsigned char c, bool emphasis) {
   SPECIAL_CHARS[c] = 1;
+  SPECIAL_CHAR_LIST_VALID = false;
   if (emphasis)
     SKIP_CHARS[c] = 1;
 }
 
 void cmark_inlines_remove_special_character(unsigned char c, bool emphasis) {
   SPECIAL_CHARS[c] = 0;
+  SPECIAL_CHAR_LIST_VALID = false;
   if (emphasis)
     SKIP_CHARS[c] = 0;
 }
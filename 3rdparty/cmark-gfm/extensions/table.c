@@ -1,10 +1,12 @@
 #include <cmark-gfm-extension_api.h>
 #include <html.h>
+#include <cmark_ctype.h>
 #include <inlines.h>
 #include <parser.h>
 #include <references.h>
 #include <string.h>
 #include <render.h>
+#include <utf8.h>
 
 #include "ext_scanners.h"
 #include "strikethrough.h"
@@ -14,10 +16,22 @@
 cmark_node_type CMARK_NODE_TABLE, CMARK_NODE_TABLE_ROW,
     CMARK_NODE_TABLE_CELL;
 
+typedef struct {
+  int start_offset, end_offset, internal_offset;
+  bufsize_t text_offset, text_len;
+} node_cell;
+
 typedef struct {
   uint16_t n_columns;
   int paragraph_offset;
-  cmark_llist *cells;
+
+  // The cells of a row are kept in a single array, and their unescaped and
+  // trimmed contents are packed one after the other, NUL terminated, into a
+  // single buffer.  A row thus costs a handful of allocations however many
+  // cells it has, rather than a few per cell.
+  node_cell *cells;
+  int n_cells, cells_size;
+  cmark_strbuf text;
 } table_row;
 
 typedef struct {
@@ -29,27 +43,19 @@ typedef struct {
   bool is_header;
 } node_table_row;
 
-typedef struct {
-  cmark_strbuf *buf;
-  int start_offset, end_offset, internal_offset;
-} node_cell;
-
-static void free_table_cell(cmark_mem *mem, void *data) {
-  node_cell *cell = (node_cell *)data;
-  cmark_strbuf_free((cmark_strbuf *)cell->buf);
-  mem->free(cell->buf);
-  mem->free(cell);
-}
-
 static void free_table_row(cmark_mem *mem, table_row *row) {
   if (!row)
     return;
 
-  cmark_llist_free_full(mem, row->cells, (cmark_free_func)free_table_cell);
-
+  mem->free(row->cells);
+  cmark_strbuf_free(&row->text);
   mem->free(row);
 }
 
+static const char *cell_text(table_row *row, node_cell *cell) {
+  return (const char *)row->text.ptr + cell->text_offset;
+}
+
 static void free_node_table(cmark_mem *mem, void *ptr) {
   node_table *t = (node_table *)ptr;
   mem->free(t->alignments);
@@ -111,67 +117,181 @@ static cmark_strbuf *unescape_pipes(cmark_mem *mem, unsigned char *string, bufsi
   return res;
 }
 
-static table_row *row_from_string(cmark_syntax_extension *self,
-                                  cmark_parser *parser, unsigned char *string,
-                                  int len) {
-  table_row *row = NULL;
-  bufsize_t cell_matched = 1, pipe_matched = 1, offset;
-  int cell_end_offset;
+static bool is_table_spacechar(unsigned char c) {
+  return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// The scanners below match the same input as the table_cell, table_cell_end
+// and table_row_end rules of ext_scanners.re, but work within the bounds of
+// the string instead of terminating it, so that a row is split in a single
+// pass.
+
+static bufsize_t scan_cell(const unsigned char *string, bufsize_t len,
+                           bufsize_t offset) {
+  bufsize_t i = offset;
 
-  row = (table_row *)parser->mem->calloc(1, sizeof(table_row));
-  row->n_columns = 0;
-  row->cells = NULL;
+  while (i < len) {
+    unsigned char c = string[i];
 
-  offset = scan_table_cell_end(string, len, 0);
+    if (c == '\\' && i + 1 < len && string[i + 1] == '|') {
+      i += 2;
+    } else if (c == '|' || c == '\r' || c == '\n' || c == '\0') {
+      break;
+    } else if (c < 0x80) {
+      ++i;
+    } else {
+      // Like the scanner, end the cell before invalid UTF-8, which is only
+      // replaced by the parser with CMARK_OPT_VALIDATE_UTF8.
+      int32_t uc;
+      int n = cmark_utf8proc_iterate(string + i, len - i, &uc);
+
+      if (n < 0)
+        break;
+
+      i += n;
+    }
+  }
+
+  return i - offset;
+}
+
+static bufsize_t scan_cell_end(const unsigned char *string, bufsize_t len,
+                               bufsize_t offset) {
+  bufsize_t i = offset;
+
+  if (i >= len || string[i] != '|')
+    return 0;
+
+  for (++i; i < len && is_table_spacechar(string[i]); ++i)
+    ;
+
+  return i - offset;
+}
+
+static bufsize_t scan_row_end(const unsigned char *string, bufsize_t len,
+                              bufsize_t offset) {
+  bufsize_t i = offset;
+
+  while (i < len && is_table_spacechar(string[i]))
+    ++i;
+
+  if (i < len && string[i] == '\r')
+    ++i;
+
+  if (i < len && string[i] == '\n')
+    return i + 1 - offset;
+
+  return 0;
+}
+
+static void add_cell(cmark_mem *mem, table_row *row,
+                     const unsigned char *string, bufsize_t offset,
+                     bufsize_t cell_len) {
+  node_cell *cell;
+  bufsize_t start = offset, end = offset + cell_len, run, r;
+
+  if (row->n_cells == row->cells_size) {
+    row->cells_size = row->cells_size ? row->cells_size * 2 : 8;
+    row->cells = (node_cell *)mem->realloc(
+        row->cells, row->cells_size * sizeof(node_cell));
+  }
+
+  cell = &row->cells[row->n_cells++];
+  cell->start_offset = offset;
+  cell->end_offset = offset + cell_len - 1;
+  cell->internal_offset = 0;
+
+  while (cell->start_offset > 0 && string[cell->start_offset - 1] != '|') {
+    --cell->start_offset;
+    ++cell->internal_offset;
+  }
+
+  // Trimming before unescaping gives the same contents as the other way
+  // round, since an escaped pipe is never whitespace.
+  while (start < end && cmark_isspace(string[start]))
+    ++start;
+
+  while (end > start && cmark_isspace(string[end - 1]))
+    --end;
+
+  cell->text_offset = row->text.size;
+
+  for (run = r = start; r < end; ++r) {
+    if (string[r] == '\\' && r + 1 < end && string[r + 1] == '|') {
+      cmark_strbuf_put(&row->text, string + run, r - run);
+      run = ++r;
+    }
+  }
+
+  cmark_strbuf_put(&row->text, string + run, end - run);
+  cell->text_len = row->text.size - cell->text_offset;
+  cmark_strbuf_putc(&row->text, '\0');
+}
+
+// Splits the string into the cells of a table row, filling in the given row
+// if there is one, and returns the number of cells, or 0 if the string is not
+// a table row.  Without a row, nothing is allocated, so this is cheap enough
+// to check whether a line continues a table before committing to it.
+static int split_row(cmark_mem *mem, const unsigned char *string, int len,
+                     table_row *row) {
+  bufsize_t cell_matched = 1, pipe_matched = 1, offset;
+  int cell_end_offset, n_columns = 0;
+
+  offset = scan_cell_end(string, len, 0);
 
   // Parse the cells of the row. Stop if we reach the end of the input, or if we
   // cannot detect any more cells.
   while (offset < len && (cell_matched || pipe_matched)) {
-    cell_matched = scan_table_cell(string, len, offset);
-    pipe_matched = scan_table_cell_end(string, len, offset + cell_matched);
+    cell_matched = scan_cell(string, len, offset);
+    pipe_matched = scan_cell_end(string, len, offset + cell_matched);
 
     if (cell_matched || pipe_matched) {
       cell_end_offset = offset + cell_matched - 1;
 
       if (string[cell_end_offset] == '\n' || string[cell_end_offset] == '\r') {
-        row->paragraph_offset = cell_end_offset;
+        n_columns = 0;
 
-        cmark_llist_free_full(parser->mem, row->cells, (cmark_free_func)free_table_cell);
-        row->cells = NULL;
-        row->n_columns = 0;
-      } else {
-        cmark_strbuf *cell_buf = unescape_pipes(parser->mem, string + offset,
-            cell_matched);
-        cmark_strbuf_trim(cell_buf);
-
-        node_cell *cell = (node_cell *)parser->mem->calloc(1, sizeof(*cell));
-        cell->buf = cell_buf;
-        cell->start_offset = offset;
-        cell->end_offset = cell_end_offset;
-
-        while (cell->start_offset > 0 && string[cell->start_offset - 1] != '|') {
-          --cell->start_offset;
-          ++cell->internal_offset;
+        if (row) {
+          row->paragraph_offset = cell_end_offset;
+          row->n_cells = 0;
+          cmark_strbuf_clear(&row->text);
         }
+      } else {
+        n_columns += 1;
 
-        row->n_columns += 1;
-        row->cells = cmark_llist_append(parser->mem, row->cells, cell);
+        if (row)
+          add_cell(mem, row, string, offset, cell_matched);
       }
     }
 
     offset += cell_matched + pipe_matched;
 
     if (!pipe_matched) {
-      pipe_matched = scan_table_row_end(string, len, offset);
+      pipe_matched = scan_row_end(string, len, offset);
       offset += pipe_matched;
     }
   }
 
-  if (offset != len || !row->n_columns) {
-    free_table_row(parser->mem, row);
-    row = NULL;
+  if (offset != len)
+    return 0;
+
+  return n_columns;
+}
+
+static table_row *row_from_string(cmark_mem *mem, const unsigned char *string,
+                                  int len) {
+  table_row *row = (table_row *)mem->calloc(1, sizeof(table_row));
+  int n_columns;
+
+  cmark_strbuf_init(mem, &row->text, len + 1);
+  n_columns = split_row(mem, string, len, row);
+
+  if (!n_columns) {
+    free_table_row(mem, row);
+    return NULL;
   }
 
+  row->n_columns = (uint16_t)n_columns;
   return row;
 }
 
@@ -199,51 +319,38 @@ static cmark_node *try_opening_table_header(cmark_syntax_extension *self,
                                             cmark_parser *parser,
                                             cmark_node *parent_container,
                                             unsigned char *input, int len) {
-  bufsize_t matched =
-      scan_table_start(input, len, cmark_parser_get_first_nonspace(parser));
+  int first_nonspace = cmark_parser_get_first_nonspace(parser);
+  bufsize_t matched = scan_table_start(input, len, first_nonspace);
   cmark_node *table_header;
   table_row *header_row = NULL;
   table_row *marker_row = NULL;
   node_table_row *ntr;
   const char *parent_string;
+  int parent_len, n_columns;
   uint16_t i;
 
   if (!matched)
     return parent_container;
 
   parent_string = cmark_node_get_string_content(parent_container);
+  parent_len = (int)strlen(parent_string);
 
-  cmark_arena_push();
-
-  header_row = row_from_string(self, parser, (unsigned char *)parent_string,
-                               (int)strlen(parent_string));
+  // Count the cells of both rows before building either of them, so that
+  // nothing is allocated for paragraphs that do not turn into tables.
+  n_columns = split_row(parser->mem, (const unsigned char *)parent_string,
+                        parent_len, NULL);
 
-  if (!header_row) {
-    free_table_row(parser->mem, header_row);
-    cmark_arena_pop();
+  if (!n_columns ||
+      n_columns != split_row(parser->mem, input + first_nonspace,
+                             len - first_nonspace, NULL))
     return parent_container;
-  }
-
-  marker_row = row_from_string(self, parser,
-                               input + cmark_parser_get_first_nonspace(parser),
-                               len - cmark_parser_get_first_nonspace(parser));
 
-  assert(marker_row);
+  header_row = row_from_string(parser->mem,
+                               (const unsigned char *)parent_string, parent_len);
+  marker_row = row_from_string(parser->mem, input + first_nonspace,
+                               len - first_nonspace);
 
-  if (header_row->n_columns != marker_row->n_columns) {
-    free_table_row(parser->mem, header_row);
-    free_table_row(parser->mem, marker_row);
-    cmark_arena_pop();
-    return parent_container;
-  }
-
-  if (cmark_arena_pop()) {
-    header_row = row_from_string(self, parser, (unsigned char *)parent_string,
-                                 (int)strlen(parent_string));
-    marker_row = row_from_string(self, parser,
-                                 input + cmark_parser_get_first_nonspace(parser),
-                                 len - cmark_parser_get_first_nonspace(parser));
-  }
+  assert(header_row && marker_row);
 
   if (!cmark_node_set_type(parent_container, CMARK_NODE_TABLE)) {
     free_table_row(parser->mem, header_row);
@@ -264,10 +371,10 @@ static cmark_node *try_opening_table_header(cmark_syntax_extension *self,
 
   uint8_t *alignments =
       (uint8_t *)parser->mem->calloc(header_row->n_columns, sizeof(uint8_t));
-  cmark_llist *it = marker_row->cells;
-  for (i = 0; it; it = it->next, ++i) {
-    node_cell *node = (node_cell *)it->data;
-    bool left = node->buf->ptr[0] == ':', right = node->buf->ptr[node->buf->size - 1] == ':';
+  for (i = 0; i < marker_row->n_cells; ++i) {
+    node_cell *node = &marker_row->cells[i];
+    const char *text = cell_text(marker_row, node);
+    bool left = text[0] == ':', right = text[node->text_len - 1] == ':';
 
     if (left && right)
       alignments[i] = 'c';
@@ -282,23 +389,23 @@ static cmark_node *try_opening_table_header(cmark_syntax_extension *self,
       cmark_parser_add_child(parser, parent_container, CMARK_NODE_TABLE_ROW,
                              parent_container->start_column);
   cmark_node_set_syntax_extension(table_header, self);
-  table_header->end_column = parent_container->start_column + (int)strlen(parent_string) - 2;
+  table_header->end_column = parent_container->start_column + parent_len - 2;
   table_header->start_line = table_header->end_line = parent_container->start_line;
 
   table_header->as.opaque = ntr = (node_table_row *)parser->mem->calloc(1, sizeof(node_table_row));
   ntr->is_header = true;
 
   {
-    cmark_llist *tmp;
+    int c;
 
-    for (tmp = header_row->cells; tmp; tmp = tmp->next) {
-      node_cell *cell = (node_cell *) tmp->data;
+    for (c = 0; c < header_row->n_cells; ++c) {
+      node_cell *cell = &header_row->cells[c];
       cmark_node *header_cell = cmark_parser_add_child(parser, table_header,
           CMARK_NODE_TABLE_CELL, parent_container->start_column + cell->start_offset);
       header_cell->start_line = header_cell->end_line = parent_container->start_line;
       header_cell->internal_offset = cell->internal_offset;
       header_cell->end_column = parent_container->start_column + cell->end_offset;
-      cmark_node_set_string_content(header_cell, (char *) cell->buf->ptr);
+      cmark_node_set_string_content(header_cell, cell_text(header_row, cell));
       cmark_node_set_syntax_extension(header_cell, self);
     }
   }
@@ -329,20 +436,19 @@ static cmark_node *try_opening_table_row(cmark_syntax_extension *self,
   table_row_block->end_column = parent_container->end_column;
   table_row_block->as.opaque = parser->mem->calloc(1, sizeof(node_table_row));
 
-  row = row_from_string(self, parser, input + cmark_parser_get_first_nonspace(parser),
+  row = row_from_string(parser->mem, input + cmark_parser_get_first_nonspace(parser),
       len - cmark_parser_get_first_nonspace(parser));
 
   {
-    cmark_llist *tmp;
     int i, table_columns = get_n_table_columns(parent_container);
 
-    for (tmp = row->cells, i = 0; tmp && i < table_columns; tmp = tmp->next, ++i) {
-      node_cell *cell = (node_cell *) tmp->data;
+    for (i = 0; i < row->n_cells && i < table_columns; ++i) {
+      node_cell *cell = &row->cells[i];
       cmark_node *node = cmark_parser_add_child(parser, table_row_block,
           CMARK_NODE_TABLE_CELL, parent_container->start_column + cell->start_offset);
       node->internal_offset = cell->internal_offset;
       node->end_column = parent_container->start_column + cell->end_offset;
-      cmark_node_set_string_content(node, (char *) cell->buf->ptr);
+      cmark_node_set_string_content(node, cell_text(row, cell));
       cmark_node_set_syntax_extension(node, self);
     }
 
@@ -382,14 +488,10 @@ static int matches(cmark_syntax_extension *self, cmark_parser *parser,
   int res = 0;
 
   if (cmark_node_get_type(parent_container) == CMARK_NODE_TABLE) {
-    cmark_arena_push();
-    table_row *new_row = row_from_string(
-        self, parser, input + cmark_parser_get_first_nonspace(parser),
-        len - cmark_parser_get_first_nonspace(parser));
-    if (new_row && new_row->n_columns)
+    // Only the number of cells matters here, so the row is not built.
+    if (split_row(parser->mem, input + cmark_parser_get_first_nonspace(parser),
+                  len - cmark_parser_get_first_nonspace(parser), NULL))
       res = 1;
-    free_table_row(parser->mem, new_row);
-    cmark_arena_pop();
   }
 
   return res;
@@ -0,0 +1,363 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFont>
+#include <QHash>
+#include <QScopedPointer>
+#include <QSignalSpy>
+#include <QString>
+#include <QtTest>
+
+#include "3rdparty/cmark-gfm/core/cmark-gfm.h"
+#include "3rdparty/cmark-gfm/core/cmark-gfm-extension_api.h"
+#include "3rdparty/cmark-gfm/extensions/cmark-gfm-core-extensions.h"
+
+#include "cmarkgfmapi.h"
+#include "colorscheme.h"
+#include "documentstatistics.h"
+#include "literalsearcher.h"
+#include "markdownast.h"
+#include "markdowndocument.h"
+#include "markdowneditor.h"
+#include "markdownhighlighter.h"
+#include "stylesheetbuilder.h"
+#include "spelling/dictionary_manager.h"
+#include "spelling/dictionary_ref.h"
+
+#include "corpusgenerator.h"
+
+using namespace ghostwriter;
+
+/*
+* Benchmarks of the editing pipeline, each run over a small, a medium and
+* a huge document.  Run the benchmarks binary with QtTest's -csv or -xml
+* option (or with -o results.xml,xml) for results that can be tracked
+* from one build to the next.
+*/
+class Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void parse_data();
+    void parse();
+    void setRoot_data();
+    void setRoot();
+    void findBlockAtLine_data();
+    void findBlockAtLine();
+    void rehighlight_data();
+    void rehighlight();
+    void countWords_data();
+    void countWords();
+    void checkSpelling_data();
+    void checkSpelling();
+    void highlightAllMatches_data();
+    void highlightAllMatches();
+    void buildStyleSheets();
+
+private:
+    // Sizes of the documents, in bytes of UTF-8.
+    static const int SmallSize = 10 * 1024;
+    static const int MediumSize = 1024 * 1024;
+    static const int HugeSize = 10 * 1024 * 1024;
+
+    // Language of the dictionary to check spelling with.
+    static const char *const SpellingLanguage;
+
+    QHash<int, QString> documents;
+
+    void addDocumentRows();
+    const QString &document(int size);
+
+    static cmark_node *parseTree(const QString &text);
+    static ColorScheme colorScheme();
+};
+
+const char *const Benchmarks::SpellingLanguage = "en_US";
+
+void Benchmarks::initTestCase()
+{
+    cmark_gfm_core_extensions_ensure_registered();
+
+    // Load the dictionary up front, since it is loaded in the background.
+    DictionaryManager &manager = DictionaryManager::instance();
+
+    if (manager.availableDictionaries().contains(SpellingLanguage)) {
+        QSignalSpy loaded(&manager, &DictionaryManager::changed);
+        manager.requestDictionary(SpellingLanguage);
+        loaded.wait(30 * 1000);
+    }
+}
+
+void Benchmarks::parse_data()
+{
+    addDocumentRows();
+}
+
+void Benchmarks::parse()
+{
+    QFETCH(int, size);
+    const QString &text = document(size);
+
+    QBENCHMARK {
+        delete CmarkGfmAPI::instance()->parse(text, false);
+    }
+}
+
+void Benchmarks::setRoot_data()
+{
+    addDocumentRows();
+}
+
+void Benchmarks::setRoot()
+{
+    QFETCH(int, size);
+    cmark_node *root = parseTree(document(size));
+    MarkdownAST ast;
+
+    QBENCHMARK {
+        ast.setRoot(root);
+    }
+
+    cmark_node_free(root);
+}
+
+void Benchmarks::findBlockAtLine_data()
+{
+    addDocumentRows();
+}
+
+void Benchmarks::findBlockAtLine()
+{
+    QFETCH(int, size);
+    const QString &text = document(size);
+    QScopedPointer<MarkdownAST> ast(CmarkGfmAPI::instance()->parse(text, false));
+    int lineCount = text.count('\n') + 1;
+    int found = 0;
+
+    // Look up every line, as highlighting the whole document does.
+    QBENCHMARK {
+        for (int line = 1; line <= lineCount; line++) {
+            if (nullptr != ast->findBlockAtLine(line)) {
+                found++;
+            }
+        }
+    }
+
+    QVERIFY(found > 0);
+}
+
+void Benchmarks::rehighlight_data()
+{
+    addDocumentRows();
+}
+
+void Benchmarks::rehighlight()
+{
+    QFETCH(int, size);
+
+    MarkdownDocument markdownDocument;
+    MarkdownEditor editor(&markdownDocument, colorScheme());
+    QSignalSpy parsed(&markdownDocument, &MarkdownDocument::markdownASTChanged);
+
+    editor.setPlainText(document(size));
+
+    // Highlight with the AST of the whole document, as once it is loaded.
+    QTRY_VERIFY_WITH_TIMEOUT(parsed.count() > 0, 5 * 60 * 1000);
+
+    MarkdownHighlighter *highlighter = editor.findChild<MarkdownHighlighter *>();
+    QVERIFY(nullptr != highlighter);
+
+    QBENCHMARK {
+        highlighter->rehighlight();
+    }
+}
+
+void Benchmarks::countWords_data()
+{
+    addDocumentRows();
+}
+
+void Benchmarks::countWords()
+{
+    QFETCH(int, size);
+    const QString &text = document(size);
+    DocumentStatistics::Statistics statistics;
+
+    // DocumentStatistics counts the words of a document with the same
+    // code as those of files that are not open.
+    QBENCHMARK {
+        statistics = DocumentStatistics::statisticsOf(text);
+    }
+
+    QVERIFY(statistics.wordCount > 0);
+}
+
+void Benchmarks::checkSpelling_data()
+{
+    addDocumentRows();
+}
+
+void Benchmarks::checkSpelling()
+{
+    QFETCH(int, size);
+    const QString &text = document(size);
+    DictionaryManager &manager = DictionaryManager::instance();
+
+    if (!manager.availableDictionaries().contains(SpellingLanguage)) {
+        QSKIP("No dictionary is installed for en_US.");
+    }
+
+    DictionaryRef dictionary = manager.requestDictionary(SpellingLanguage);
+
+    QBENCHMARK {
+        // Check against a cold cache, as when a document is opened.
+        manager.releaseCaches();
+
+        int position = 0;
+
+        forever {
+            QStringRef word = dictionary.check(text, position);
+
+            if (word.isNull()) {
+                break;
+            }
+
+            position = word.position() + word.length();
+        }
+    }
+}
+
+void Benchmarks::highlightAllMatches_data()
+{
+    addDocumentRows();
+}
+
+void Benchmarks::highlightAllMatches()
+{
+    QFETCH(int, size);
+    const QString &text = document(size);
+
+    // FindReplace highlights all matches of a plain text query by finding
+    // them in the document text with a LiteralSearcher, as here.
+    LiteralSearcher searcher("the", Qt::CaseInsensitive);
+    QVector<int> matches;
+
+    QBENCHMARK {
+        matches = searcher.indexesIn(text);
+    }
+
+    QVERIFY(!matches.isEmpty());
+}
+
+void Benchmarks::buildStyleSheets()
+{
+    ColorScheme colors = colorScheme();
+    QFont textFont("Serif", 12);
+    QFont codeFont("Monospace", 11);
+    QString css;
+
+    // Construct the builder rather than using StyleSheetBuilder::cached(),
+    // since that would only build the style sheets once.
+    QBENCHMARK {
+        StyleSheetBuilder builder(colors, true, textFont, codeFont);
+        css = builder.htmlPreviewCss();
+    }
+
+    QVERIFY(!css.isEmpty());
+}
+
+void Benchmarks::addDocumentRows()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("small") << int(SmallSize);
+    QTest::newRow("medium") << int(MediumSize);
+    QTest::newRow("huge") << int(HugeSize);
+}
+
+// Returns the document of the given size, generating it the first time.
+// The documents mix all the shapes of the corpus generator.
+//
+const QString &Benchmarks::document(int size)
+{
+    if (!documents.contains(size)) {
+        CorpusGenerator generator;
+        documents.insert(size, generator.generate(CorpusGenerator::Mixed, size));
+    }
+
+    return documents[size];
+}
+
+// Parses the given text into a cmark_node tree allocated outside of the
+// arena, with the same extensions as CmarkGfmAPI.
+//
+cmark_node *Benchmarks::parseTree(const QString &text)
+{
+    int options = CMARK_OPT_DEFAULT | CMARK_OPT_FOOTNOTES;
+    cmark_parser *parser = cmark_parser_new(options);
+    const char *extensions[] = { "table", "strikethrough", "autolink", "tasklist" };
+
+    for (const char *name : extensions) {
+        cmark_syntax_extension *extension = cmark_find_syntax_extension(name);
+
+        if (nullptr != extension) {
+            cmark_parser_attach_syntax_extension(parser, extension);
+        }
+    }
+
+    QByteArray utf8 = text.toUtf8();
+    cmark_parser_feed(parser, utf8.constData(), utf8.size());
+
+    cmark_node *root = cmark_parser_finish(parser);
+    cmark_parser_free(parser);
+
+    return root;
+}
+
+ColorScheme Benchmarks::colorScheme()
+{
+    ColorScheme colors;
+
+    colors.foreground = QColor("#222222");
+    colors.background = QColor("#fafafa");
+    colors.selection = QColor("#b4d5fe");
+    colors.cursor = QColor("#222222");
+    colors.link = QColor("#0969da");
+    colors.image = QColor("#0969da");
+    colors.inlineHtml = QColor("#8250df");
+    colors.headingText = QColor("#cf222e");
+    colors.headingMarkup = QColor("#a40e26");
+    colors.emphasisText = QColor("#953800");
+    colors.emphasisMarkup = QColor("#7d4e00");
+    colors.blockquoteText = QColor("#57606a");
+    colors.blockquoteMarkup = QColor("#8c959f");
+    colors.divider = QColor("#d0d7de");
+    colors.listMarkup = QColor("#1a7f37");
+    colors.codeText = QColor("#116329");
+    colors.codeMarkup = QColor("#6e7781");
+    colors.error = QColor("#cf222e");
+
+    return colors;
+}
+
+QTEST_MAIN(Benchmarks)
+#include "benchmarks.moc"
@@ -0,0 +1,54 @@
+################################################################################
+#
+# Copyright (C) 2021 wereturtle
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+
+# Benchmarks of the editing pipeline.  Build core.pro first, from the same
+# build directory as this project.  The benchmarks are not run by "make
+# check", but by hand, e.g. with "./benchmarks -csv" or with
+# "./benchmarks -o results.xml,xml" for machine-readable results.  Run with
+# QT_QPA_PLATFORM=offscreen where there is no display.
+
+include(../tests/tests.pri)
+
+CONFIG -= testcase
+
+QT += widgets
+
+TARGET = benchmarks
+
+INCLUDEPATH += corpusgenerator
+
+# The highlighter needs the editor, which is not part of the core library.
+HEADERS += \
+    corpusgenerator/corpusgenerator.h \
+    ../src/latencymonitor.h \
+    ../src/markdowneditor.h \
+    ../src/markdownhighlighter.h \
+    ../src/spelling/spell_checker.h \
+    ../src/stylesheetbuilder.h
+
+SOURCES += \
+    benchmarks.cpp \
+    corpusgenerator/corpusgenerator.cpp \
+    ../src/latencymonitor.cpp \
+    ../src/markdowneditor.cpp \
+    ../src/markdownhighlighter.cpp \
+    ../src/spelling/spell_checker.cpp \
+    ../src/stylesheetbuilder.cpp
+
+RESOURCES += ../resources.qrc
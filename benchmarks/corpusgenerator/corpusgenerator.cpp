@@ -0,0 +1,572 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QBuffer>
+#include <QVector>
+
+#include "corpusgenerator.h"
+
+namespace ghostwriter
+{
+namespace
+{
+const char *const ShapeNames[CorpusGenerator::ShapeCount] =
+{
+    "mixed",
+    "nested-lists",
+    "pipe-tables",
+    "headings",
+    "long-paragraphs",
+    "inline-markup",
+    "reference-links",
+    "math",
+    "multilingual"
+};
+
+const char *const EnglishWords[] =
+{
+    "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "and",
+    "a", "writer", "types", "words", "into", "document", "while", "editor",
+    "keeps", "up", "with", "every", "keystroke", "of", "long", "chapter",
+    "draft", "story", "notes", "about", "river", "mountain", "city", "night",
+    "morning", "letter", "table", "figure", "section", "reference", "list",
+    "markdown", "preview", "paragraph", "sentence", "is", "was", "to", "in"
+};
+
+// Words of other languages and scripts, including ones written right to
+// left and ones written without spaces between words.  Each line holds the
+// words of one language, separated by spaces.
+//
+const char *const ForeignWords[] =
+{
+    "der die das und schnelle braune Fuchs springt über den faulen Hund Straße Grüße",
+    "le la les et un une rapide renard brun saute par-dessus chien paresseux été",
+    "быстрая коричневая лиса прыгает через ленивую собаку и пишет длинный текст",
+    "η γρήγορη καφέ αλεπού πηδάει πάνω από τον τεμπέλη σκύλο και γράφει",
+    "الثعلب البني السريع يقفز فوق الكلب الكسول ويكتب نصا طويلا",
+    "השועל החום המהיר קופץ מעל הכלב העצלן וכותב טקסט ארוך",
+    "敏捷的 棕色 狐狸 跳过了 懒惰的 狗 并且 写了 一篇 很长的 文章",
+    "素早い 茶色の 狐が 怠惰な 犬を 飛び越えて 長い 文章を 書く",
+    "빠른 갈색 여우가 게으른 개를 뛰어넘어 긴 글을 쓴다",
+    "สุนัขจิ้งจอก สีน้ำตาล กระโดด ข้าม สุนัข ขี้เกียจ และ เขียน บทความ",
+    "तेज़ भूरी लोमड़ी आलसी कुत्ते के ऊपर कूदती है और लिखती है",
+    "🦊 🐕 ✍️ 📄 ✨ 🚀"
+};
+
+const char *const LanguageCodes[] =
+{
+    "de", "fr", "ru", "el", "ar", "he", "zh", "ja", "ko", "th", "hi", "emoji"
+};
+
+const char *const MathExpressions[] =
+{
+    "x^2 + y^2 = z^2",
+    "e^{i\\pi} + 1 = 0",
+    "\\sum_{i=1}^{n} i = \\frac{n(n+1)}{2}",
+    "\\int_0^\\infty e^{-x^2} \\, dx = \\frac{\\sqrt{\\pi}}{2}",
+    "\\mathbf{A}\\mathbf{x} = \\mathbf{b}",
+    "\\lim_{h \\to 0} \\frac{f(x + h) - f(x)}{h}",
+    "\\alpha_{k+1} = \\alpha_k - \\eta \\nabla L(\\alpha_k)",
+    "P(A \\mid B) = \\frac{P(B \\mid A) P(A)}{P(B)}"
+};
+
+const int EnglishWordCount = sizeof(EnglishWords) / sizeof(EnglishWords[0]);
+const int LanguageCount = sizeof(ForeignWords) / sizeof(ForeignWords[0]);
+const int MathExpressionCount = sizeof(MathExpressions) / sizeof(MathExpressions[0]);
+
+// Deepest level of the nested lists.
+const int MaxListDepth = 12;
+
+// Number of rows of a pipe table block.
+const int TableBlockRows = 100;
+
+// Number of columns of the pipe tables.
+const int TableColumns = 8;
+} // namespace
+
+CorpusGenerator::CorpusGenerator(quint64 seed)
+    : referenceCount(0),
+      headingCount(0)
+{
+    // Scramble the seed with SplitMix64, so that nearby seeds give
+    // unrelated documents, and so that the state is never zero.
+    quint64 z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    state = z ^ (z >> 31);
+
+    if (0 == state) {
+        state = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+CorpusGenerator::~CorpusGenerator()
+{
+    ;
+}
+
+QStringList CorpusGenerator::shapeNames()
+{
+    QStringList names;
+
+    for (int i = 0; i < ShapeCount; i++) {
+        names.append(QString::fromLatin1(ShapeNames[i]));
+    }
+
+    return names;
+}
+
+bool CorpusGenerator::shapeFromName(const QString &name, Shape &shape)
+{
+    int index = shapeNames().indexOf(name.trimmed().toLower());
+
+    if (index < 0) {
+        return false;
+    }
+
+    shape = (Shape) index;
+    return true;
+}
+
+bool CorpusGenerator::write(Shape shape, qint64 size, QIODevice *device)
+{
+    qint64 written = 0;
+    bool first = true;
+    QString block;
+
+    while (written < size) {
+        block.clear();
+        appendBlock(shape, first, size - written, block);
+        first = false;
+
+        QByteArray utf8 = block.toUtf8();
+
+        if (device->write(utf8) != utf8.size()) {
+            return false;
+        }
+
+        written += utf8.size();
+    }
+
+    return true;
+}
+
+QString CorpusGenerator::generate(Shape shape, qint64 size)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    write(shape, size, &buffer);
+
+    return QString::fromUtf8(buffer.data());
+}
+
+// Returns the next number of the xorshift64* generator, whose output is
+// the same on every platform, unlike that of the standard distributions.
+//
+quint32 CorpusGenerator::next()
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+
+    return (quint32) ((state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+int CorpusGenerator::below(int n)
+{
+    return (n <= 1) ? 0 : (int) (next() % (quint32) n);
+}
+
+bool CorpusGenerator::chance(int percent)
+{
+    return below(100) < percent;
+}
+
+QString CorpusGenerator::word()
+{
+    return QString::fromLatin1(EnglishWords[below(EnglishWordCount)]);
+}
+
+QString CorpusGenerator::words(int count)
+{
+    QString text;
+
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            text += ' ';
+        }
+
+        text += word();
+    }
+
+    return text;
+}
+
+QString CorpusGenerator::sentence()
+{
+    QString text = words(4 + below(14));
+    text[0] = text[0].toUpper();
+    text += chance(85) ? '.' : '?';
+
+    return text;
+}
+
+void CorpusGenerator::appendBlock(Shape shape, bool first, qint64 remaining, QString &out)
+{
+    switch (shape) {
+    case Mixed:
+        // Interleave blocks of the other shapes, with tables kept short.
+        shape = (Shape) (Mixed + 1 + below(ShapeCount - 1));
+
+        if (PipeTables == shape) {
+            appendTableRows(true, 5 + below(30), out);
+            out += '\n';
+        } else {
+            appendBlock(shape, true, remaining, out);
+        }
+        break;
+    case NestedLists:
+        appendNestedList(out);
+        break;
+    case PipeTables:
+        // Pipe tables go on for the whole document, as one giant table.
+        appendTableRows(first, TableBlockRows, out);
+        break;
+    case Headings:
+        appendHeading(out);
+        break;
+    case LongParagraphs:
+        appendLongParagraph(remaining, out);
+        break;
+    case InlineMarkup:
+        appendInlineMarkup(out);
+        break;
+    case ReferenceLinks:
+        appendReferenceLinks(out);
+        break;
+    case Math:
+        appendMath(out);
+        break;
+    case Multilingual:
+        appendMultilingual(out);
+        break;
+    default:
+        break;
+    }
+}
+
+// Appends a list that wanders up and down to the deepest level, switching
+// between bullet and numbered markers, with the occasional task item and
+// continuation paragraph.
+//
+void CorpusGenerator::appendNestedList(QString &out)
+{
+    int itemCount = 20 + below(40);
+    int depth = 0;
+
+    // Indentation of the items of each level, which is past the marker of
+    // the items of the level above.
+    QVector<int> indents(MaxListDepth + 2, 0);
+    QVector<bool> numbered(MaxListDepth + 1, false);
+    numbered[0] = chance(50);
+
+    for (int i = 0; i < itemCount; i++) {
+        int step = below(3) - 1;
+
+        if ((step > 0) && (depth < MaxListDepth)) {
+            depth++;
+            numbered[depth] = chance(50);
+        } else if ((step < 0) && (depth > 0)) {
+            depth--;
+        }
+
+        QString indent(indents[depth], ' ');
+        QString marker = numbered[depth] ? QString("%1. ").arg(1 + below(9)) : QString("- ");
+
+        // Content starts after the marker, before any task box.
+        indents[depth + 1] = indents[depth] + marker.length();
+
+        if (chance(10)) {
+            marker += chance(50) ? "[ ] " : "[x] ";
+        }
+
+        out += indent + marker + sentence() + '\n';
+
+        if (chance(5)) {
+            QString continuation(indents[depth + 1], ' ');
+            out += '\n' + continuation + sentence() + '\n';
+        }
+    }
+
+    out += '\n';
+}
+
+void CorpusGenerator::appendTableRows(bool header, int rowCount, QString &out)
+{
+    if (header) {
+        out += '|';
+
+        for (int column = 0; column < TableColumns; column++) {
+            out += ' ' + words(1 + below(2)) + " |";
+        }
+
+        out += "\n|";
+
+        for (int column = 0; column < TableColumns; column++) {
+            switch (column % 3) {
+            case 0:
+                out += ":---|";
+                break;
+            case 1:
+                out += ":---:|";
+                break;
+            default:
+                out += "---:|";
+                break;
+            }
+        }
+
+        out += '\n';
+    }
+
+    for (int row = 0; row < rowCount; row++) {
+        out += '|';
+
+        for (int column = 0; column < TableColumns; column++) {
+            switch (column % 3) {
+            case 0:
+                out += ' ' + words(1 + below(4));
+                break;
+            case 1:
+                out += chance(20) ? " *" + word() + "* " : ' ' + word();
+                break;
+            default:
+                out += ' ' + QString::number(below(1000000));
+                break;
+            }
+
+            out += " |";
+        }
+
+        out += '\n';
+    }
+}
+
+void CorpusGenerator::appendHeading(QString &out)
+{
+    headingCount++;
+
+    QString text = QString("%1 %2").arg(headingCount).arg(words(2 + below(6)));
+    int level = 1 + below(6);
+
+    if ((level <= 2) && chance(30)) {
+        // Setext heading.
+        out += text + '\n' + QString(text.length(), (1 == level) ? '=' : '-') + "\n\n";
+    } else {
+        out += QString(level, '#') + ' ' + text + "\n\n";
+    }
+
+    out += sentence() + ' ' + sentence() + "\n\n";
+}
+
+void CorpusGenerator::appendLongParagraph(qint64 remaining, QString &out)
+{
+    // English words take about six bytes each with their space.
+    int wordCount = 300 + below(2700);
+    wordCount = (int) qMax(qint64(50), qMin(qint64(wordCount), remaining / 6));
+
+    // Most paragraphs are wrapped at 80 columns, but some are one long line.
+    bool wrapped = chance(75);
+    int lineLength = 0;
+
+    for (int i = 0; i < wordCount; i++) {
+        QString next = word();
+
+        if (0 == (i % 12)) {
+            next[0] = next[0].toUpper();
+        }
+
+        if (i > 0) {
+            if (wrapped && ((lineLength + 1 + next.length()) > 80)) {
+                out += '\n';
+                lineLength = 0;
+            } else {
+                out += ' ';
+                lineLength++;
+            }
+        }
+
+        out += next;
+        lineLength += next.length();
+
+        if (0 == ((i + 1) % 12)) {
+            out += '.';
+            lineLength++;
+        }
+    }
+
+    out += ".\n\n";
+}
+
+void CorpusGenerator::appendInlineMarkup(QString &out)
+{
+    int tokenCount = 60 + below(60);
+
+    for (int i = 0; i < tokenCount; i++) {
+        QString w = word();
+
+        if (i > 0) {
+            out += ' ';
+        }
+
+        switch (below(14)) {
+        case 0:
+            out += '*' + w + '*';
+            break;
+        case 1:
+            out += "**" + w + "**";
+            break;
+        case 2:
+            out += '_' + w + '_';
+            break;
+        case 3:
+            out += "***" + w + "***";
+            break;
+        case 4:
+            out += '`' + w + "()`";
+            break;
+        case 5:
+            out += "~~" + w + "~~";
+            break;
+        case 6:
+            out += '[' + w + "](https://example.com/" + w + ')';
+            break;
+        case 7:
+            out += "![" + w + "](images/" + w + ".png)";
+            break;
+        case 8:
+            out += "<kbd>" + w + "</kbd>";
+            break;
+        case 9:
+            out += "\\*" + w + "\\*";
+            break;
+        case 10:
+            out += "https://" + w + ".example.org";
+            break;
+        case 11:
+            out += "**" + w + " *" + word() + "* " + word() + "**";
+            break;
+        default:
+            out += w;
+            break;
+        }
+    }
+
+    out += ".\n\n";
+}
+
+void CorpusGenerator::appendReferenceLinks(QString &out)
+{
+    int linkCount = 10 + below(10);
+    int firstNew = referenceCount;
+
+    for (int i = 0; i < linkCount; i++) {
+        out += words(1 + below(5)) + ' ';
+
+        // Refer back to earlier definitions as well as to new ones.
+        if ((referenceCount > 0) && chance(30)) {
+            out += QString("[%1][ref-%2]").arg(word()).arg(below(referenceCount));
+        } else if (chance(20)) {
+            out += QString("[ref-%1]").arg(referenceCount++);
+        } else {
+            out += QString("[%1][ref-%2]").arg(word()).arg(referenceCount++);
+        }
+
+        out += ' ';
+    }
+
+    out += sentence() + "\n\n";
+
+    for (int i = firstNew; i < referenceCount; i++) {
+        out += QString("[ref-%1]: https://example.com/reference/%1").arg(i);
+
+        if (chance(50)) {
+            out += QString(" \"%1\"").arg(words(2));
+        }
+
+        out += '\n';
+    }
+
+    out += '\n';
+}
+
+void CorpusGenerator::appendMath(QString &out)
+{
+    int sentenceCount = 2 + below(4);
+
+    for (int i = 0; i < sentenceCount; i++) {
+        out += sentence() + " Let $" + MathExpressions[below(MathExpressionCount)] + "$ hold. ";
+    }
+
+    out += "\n\n";
+
+    if (chance(60)) {
+        out += "$$\n";
+        out += MathExpressions[below(MathExpressionCount)];
+        out += "\n$$\n\n";
+    }
+}
+
+void CorpusGenerator::appendMultilingual(QString &out)
+{
+    int language = below(LanguageCount);
+    QString code = QString::fromLatin1(LanguageCodes[language]);
+    QStringList foreign = QString::fromUtf8(ForeignWords[language]).split(' ');
+
+    // Chinese, Japanese and Thai are written without spaces between words.
+    bool spaced = (code != "zh") && (code != "ja") && (code != "th");
+
+    if (chance(20)) {
+        out += QString("## %1 %2\n\n").arg(code, foreign.value(below(foreign.size())));
+    }
+
+    int sentenceCount = 2 + below(5);
+
+    for (int i = 0; i < sentenceCount; i++) {
+        int wordCount = 4 + below(12);
+
+        for (int j = 0; j < wordCount; j++) {
+            if (spaced && (j > 0)) {
+                out += ' ';
+            }
+
+            out += foreign.value(below(foreign.size()));
+        }
+
+        out += ". ";
+
+        // Mix in English, as text quoting another language would.
+        if (chance(30)) {
+            out += sentence() + ' ';
+        }
+    }
+
+    out += "\n\n";
+}
+} // namespace ghostwriter
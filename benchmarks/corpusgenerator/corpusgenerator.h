@@ -0,0 +1,119 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef CORPUS_GENERATOR_H
+#define CORPUS_GENERATOR_H
+
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+
+namespace ghostwriter
+{
+/**
+ * Generates synthetic Markdown documents of a chosen size and shape, for
+ * charting how parsing, highlighting and the preview scale with documents
+ * that stress a particular path.  Generation is seeded, so that the same
+ * seed, shape and size always give the same document, on any platform.
+ *
+ * Documents end at the end of a block, so that they are only about the
+ * size asked for, and slightly larger.
+ */
+class CorpusGenerator
+{
+public:
+    /**
+     * Shapes of document.  Mixed documents interleave blocks of all the
+     * other shapes.
+     */
+    typedef enum
+    {
+        Mixed,
+        NestedLists,
+        PipeTables,
+        Headings,
+        LongParagraphs,
+        InlineMarkup,
+        ReferenceLinks,
+        Math,
+        Multilingual,
+        ShapeCount
+    } Shape;
+
+    /**
+     * Constructor.  Takes the seed of the generated documents.
+     */
+    CorpusGenerator(quint64 seed = 1);
+
+    /**
+     * Destructor.
+     */
+    ~CorpusGenerator();
+
+    /**
+     * Returns the names of the shapes, in the order of Shape.
+     */
+    static QStringList shapeNames();
+
+    /**
+     * Sets shape to the shape with the given name, as returned by
+     * shapeNames().  Returns false if there is no such shape.
+     */
+    static bool shapeFromName(const QString &name, Shape &shape);
+
+    /**
+     * Writes a document of the given shape and of about the given size in
+     * bytes to the given device, as UTF-8.  The document is written one
+     * block at a time, so that huge documents need not fit in memory.
+     * Returns false if writing to the device failed.
+     */
+    bool write(Shape shape, qint64 size, QIODevice *device);
+
+    /**
+     * Returns a document of the given shape and of about the given size in
+     * bytes of UTF-8.
+     */
+    QString generate(Shape shape, qint64 size);
+
+private:
+    quint64 state;
+    int referenceCount;
+    int headingCount;
+
+    quint32 next();
+    int below(int n);
+    bool chance(int percent);
+
+    QString word();
+    QString words(int count);
+    QString sentence();
+
+    void appendBlock(Shape shape, bool first, qint64 remaining, QString &out);
+    void appendNestedList(QString &out);
+    void appendTableRows(bool header, int rowCount, QString &out);
+    void appendHeading(QString &out);
+    void appendLongParagraph(qint64 remaining, QString &out);
+    void appendInlineMarkup(QString &out);
+    void appendReferenceLinks(QString &out);
+    void appendMath(QString &out);
+    void appendMultilingual(QString &out);
+};
+} // namespace ghostwriter
+
+#endif // CORPUS_GENERATOR_H
@@ -0,0 +1,36 @@
+################################################################################
+#
+# Copyright (C) 2021 wereturtle
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+
+# Generator of synthetic Markdown documents for the benchmarks, of a chosen
+# shape and size.  Build core.pro first, from the same build directory as
+# this project.  Run "corpusgenerator --help" for its options.
+
+include(../../tests/tests.pri)
+
+CONFIG -= testcase
+
+QT -= testlib
+
+TARGET = corpusgenerator
+
+HEADERS += corpusgenerator.h
+
+SOURCES += \
+    corpusgenerator.cpp \
+    main.cpp
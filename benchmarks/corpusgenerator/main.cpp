@@ -0,0 +1,220 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <cstdio>
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QScopedPointer>
+#include <QTextStream>
+
+#include "allocationcounter.h"
+#include "cmarkgfmapi.h"
+#include "markdownast.h"
+
+#include "corpusgenerator.h"
+
+using namespace ghostwriter;
+
+// Parses a size such as "10K", "1.5M" or "100M" into bytes.  Returns a
+// negative size if the text is not a size.
+//
+static qint64 parseSize(const QString &text)
+{
+    QString number = text.trimmed().toUpper();
+    qint64 unit = 1;
+
+    if (number.endsWith('B')) {
+        number.chop(1);
+    }
+
+    if (number.endsWith('K')) {
+        unit = 1024;
+    } else if (number.endsWith('M')) {
+        unit = 1024 * 1024;
+    } else if (number.endsWith('G')) {
+        unit = 1024 * 1024 * 1024;
+    }
+
+    if (unit > 1) {
+        number.chop(1);
+    }
+
+    bool ok = false;
+    double value = number.toDouble(&ok);
+
+    if (!ok || (value <= 0.0)) {
+        return -1;
+    }
+
+    return (qint64) (value * unit);
+}
+
+// Parses and renders the given document the way the editor and the live
+// preview do, writing one line of comma-separated values to the given
+// stream.  The allocation counts are left empty unless the core library
+// was built with CONFIG+=count_allocations.
+//
+static void measure
+(
+    const QString &shapeName,
+    quint64 seed,
+    const QString &text,
+    QTextStream &stream
+)
+{
+    QElapsedTimer timer;
+    AllocationCounter::resetPeak();
+    AllocationCounter::Counts before = AllocationCounter::counts();
+
+    timer.start();
+    QScopedPointer<MarkdownAST> ast(CmarkGfmAPI::instance()->parse(text, false));
+    qint64 parseTime = timer.nsecsElapsed();
+
+    timer.restart();
+    QString html = CmarkGfmAPI::instance()->renderToHtml(text, false);
+    qint64 renderTime = timer.nsecsElapsed();
+
+    AllocationCounter::Counts after = AllocationCounter::counts();
+
+    stream << shapeName
+        << ',' << seed
+        << ',' << text.toUtf8().size()
+        << ',' << (parseTime / 1000)
+        << ',' << (renderTime / 1000)
+        << ',' << html.toUtf8().size();
+
+    if (AllocationCounter::isEnabled()) {
+        stream << ',' << (after.allocations - before.allocations)
+            << ',' << (after.bytes - before.bytes)
+            << ',' << after.peakLiveBytes;
+    } else {
+        stream << ",,,";
+    }
+
+    stream << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("corpusgenerator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription
+    (
+        "Generates a synthetic Markdown document of the given size and "
+        "shape.  The same seed, shape and size always give the same "
+        "document."
+    );
+    parser.addHelpOption();
+
+    QCommandLineOption shapeOption
+    (
+        QStringList() << "s" << "shape",
+        "Shape of the document, one of: " + CorpusGenerator::shapeNames().join(", ") + ".",
+        "shape",
+        "mixed"
+    );
+    QCommandLineOption sizeOption
+    (
+        QStringList() << "b" << "size",
+        "Size of the document, in bytes, or with a K, M or G suffix.",
+        "size",
+        "1M"
+    );
+    QCommandLineOption seedOption
+    (
+        QStringList() << "r" << "seed",
+        "Seed of the document.",
+        "seed",
+        "1"
+    );
+    QCommandLineOption outputOption
+    (
+        QStringList() << "o" << "output",
+        "File to write the document to, rather than to standard output.",
+        "file"
+    );
+    QCommandLineOption measureOption
+    (
+        QStringList() << "m" << "measure",
+        "Instead of writing the document out, parse and render it, and "
+        "write a line of comma-separated values to standard output: shape, "
+        "seed, bytes, parse and render times in microseconds, HTML bytes, "
+        "and allocations, allocated bytes and peak live bytes if counted."
+    );
+
+    parser.addOption(shapeOption);
+    parser.addOption(sizeOption);
+    parser.addOption(seedOption);
+    parser.addOption(outputOption);
+    parser.addOption(measureOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+    CorpusGenerator::Shape shape;
+
+    if (!CorpusGenerator::shapeFromName(parser.value(shapeOption), shape)) {
+        err << "Unknown shape: " << parser.value(shapeOption) << endl;
+        return 1;
+    }
+
+    qint64 size = parseSize(parser.value(sizeOption));
+
+    if (size <= 0) {
+        err << "Invalid size: " << parser.value(sizeOption) << endl;
+        return 1;
+    }
+
+    bool ok = false;
+    quint64 seed = parser.value(seedOption).toULongLong(&ok);
+
+    if (!ok) {
+        err << "Invalid seed: " << parser.value(seedOption) << endl;
+        return 1;
+    }
+
+    CorpusGenerator generator(seed);
+
+    if (parser.isSet(measureOption)) {
+        QTextStream out(stdout);
+        measure(CorpusGenerator::shapeNames().at(shape), seed, generator.generate(shape, size), out);
+        return 0;
+    }
+
+    QFile output;
+
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        ok = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    } else {
+        ok = output.open(stdout, QIODevice::WriteOnly);
+    }
+
+    if (!ok || !generator.write(shape, size, &output)) {
+        err << "Could not write the document: " << output.errorString() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+################################################################################
+#
+# Copyright (C) 2021 wereturtle
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+
+# Builds the engine of ghostwriter (see src/core.pri) as a static library
+# without QtWidgets or QtWebEngine, for tools that need no user interface,
+# such as benchmarks, batch export and preview services.  PDF export, which
+# prints with QtWebEngine, is left out.
+
+VERSION = 2.0.1
+
+lessThan(QT_MAJOR_VERSION, 5) {
+    error("ghostwriter requires Qt 5.8 or greater")
+}
+
+isEqual(QT_MAJOR_VERSION, 5) : lessThan(QT_MINOR_VERSION, 8) {
+    error("ghostwriter requires Qt 5.8 or greater")
+}
+
+TEMPLATE = lib
+
+QT = core gui concurrent network
+
+CONFIG += staticlib
+CONFIG += warn_on
+CONFIG += c++11
+
+DEFINES += APPVERSION='\\"$${VERSION}\\"'
+DEFINES += GW_NO_WEBENGINE
+
+CONFIG(debug, debug|release) {
+    DESTDIR = build/debug
+}
+else {
+    DESTDIR = build/release
+}
+
+DEFINES += QT_NO_DEBUG_OUTPUT=1
+OBJECTS_DIR = $${DESTDIR}/core
+MOC_DIR = $${DESTDIR}/core
+RCC_DIR = $${DESTDIR}/core
+
+TARGET = ghostwriter-core
+
+include(src/core.pri)
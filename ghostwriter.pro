@@ -30,7 +30,7 @@ isEqual(QT_MAJOR_VERSION, 5) : lessThan(QT_MINOR_VERSION, 8) {
 
 TEMPLATE = app
 
-QT += widgets concurrent svg webenginewidgets webengine webchannel gui
+QT += widgets concurrent network svg webenginewidgets webengine webchannel gui
 
 #CONFIG += debug
 CONFIG += warn_on
@@ -55,79 +55,61 @@ TARGET = ghostwriter
 
 CONFIG+=fontAwesomeFree
 include(3rdparty/QtAwesome/QtAwesome.pri)
-include(3rdparty/cmark-gfm/cmark-gfm.pri)
+include(src/core.pri)
 
 # Input
 
 macx {
     QMAKE_MACOSX_DEPLOYMENT_TARGET = 10.10
-
-    LIBS += -framework AppKit
-
-    HEADERS += src/spelling/dictionary_provider_nsspellchecker.h
-
-    OBJECTIVE_SOURCES += src/spelling/dictionary_provider_nsspellchecker.mm
-} else:win32 {
-    include(3rdparty/hunspell/hunspell.pri)
-
-    HEADERS += src/spelling/dictionary_provider_hunspell.h \
-        src/spelling/dictionary_provider_voikko.h
-
-    SOURCES += src/spelling/dictionary_provider_hunspell.cpp \
-        src/spelling/dictionary_provider_voikko.cpp
-
-} else:unix {
-    CONFIG += link_pkgconfig
-    PKGCONFIG += hunspell
-    
-    HEADERS += src/spelling/dictionary_provider_hunspell.h \
-        src/spelling/dictionary_provider_voikko.h
-
-    SOURCES += src/spelling/dictionary_provider_hunspell.cpp \
-        src/spelling/dictionary_provider_voikko.cpp
 }
 
-INCLUDEPATH += src src/spelling
-
 HEADERS += \
     src/abstractstatisticswidget.h \
     src/appsettings.h \
-    src/cmarkgfmapi.h \
-    src/cmarkgfmexporter.h \
     src/colorscheme.h \
     src/colorschemepreviewer.h \
-    src/commandlineexporter.h \
     src/documenthistory.h \
     src/documentmanager.h \
-    src/documentstatistics.h \
     src/documentstatisticswidget.h \
+    src/editjournal.h \
     src/exportdialog.h \
-    src/exporter.h \
-    src/exporterfactory.h \
-    src/exportformat.h \
+    src/foldersearchwidget.h \
+    src/fontcatalogue.h \
+    src/glyphiconcache.h \
     src/htmlpreview.h \
+    src/hugefileviewer.h \
+    src/jumpdialog.h \
+    src/latencymonitor.h \
+    src/lintwidget.h \
     src/localedialog.h \
     src/mainwindow.h \
-    src/markdowndocument.h \
     src/markdowneditor.h \
     src/markdowneditortypes.h \
     src/markdownhighlighter.h \
-    src/markdownast.h \
-    src/markdownnode.h \
     src/markdownstates.h \
-    src/memoryarena.h \
+    src/memorypressuremonitor.h \
+    src/memoryreport.h \
     src/messageboxhelper.h \
     src/outlinewidget.h \
+    src/pdfprinter.h \
     src/preferencesdialog.h \
+    src/previewbenchmark.h \
     src/previewoptionsdialog.h \
+    src/previewprofile.h \
+    src/previewtiming.h \
+    src/projectstatisticswidget.h \
+    src/projecttreewidget.h \
     src/sandboxedwebpage.h \
+    src/sessionrecorder.h \
+    src/sessionreplayer.h \
     src/sessionstatistics.h \
     src/sessionstatisticswidget.h \
     src/sidebar.h \
+    src/stallwatchdog.h \
     src/simplefontdialog.h \
-    src/stringobserver.h \
+    src/singleinstance.h \
     src/stylesheetbuilder.h \
-    src/textblockdata.h \
+    src/tasklistwidget.h \
     src/theme.h \
     src/themeeditordialog.h \
     src/themerepository.h \
@@ -135,48 +117,53 @@ HEADERS += \
     src/timelabel.h \
     src/findreplace.h \
     src/color_button.h \
-    src/spelling/abstract_dictionary.h \
-    src/spelling/abstract_dictionary_provider.h \
-    src/spelling/dictionary_manager.h \
-    src/spelling/dictionary_ref.h \
     src/spelling/spell_checker.h
 
 SOURCES += \
     src/abstractstatisticswidget.cpp \
     src/appmain.cpp \
     src/appsettings.cpp \
-    src/cmarkgfmapi.cpp \
-    src/cmarkgfmexporter.cpp \
     src/colorschemepreviewer.cpp \
-    src/commandlineexporter.cpp \
     src/documenthistory.cpp \
     src/documentmanager.cpp \
-    src/documentstatistics.cpp \
     src/documentstatisticswidget.cpp \
+    src/editjournal.cpp \
     src/exportdialog.cpp \
-    src/exporter.cpp \
-    src/exporterfactory.cpp \
-    src/exportformat.cpp \
+    src/foldersearchwidget.cpp \
+    src/fontcatalogue.cpp \
+    src/glyphiconcache.cpp \
     src/htmlpreview.cpp \
+    src/hugefileviewer.cpp \
+    src/jumpdialog.cpp \
+    src/latencymonitor.cpp \
+    src/lintwidget.cpp \
     src/localedialog.cpp \
     src/mainwindow.cpp \
-    src/markdowndocument.cpp \
     src/markdowneditor.cpp \
     src/markdownhighlighter.cpp \
-    src/markdownast.cpp \
-    src/markdownnode.cpp \
-    src/memoryarena.cpp \
+    src/memorypressuremonitor.cpp \
+    src/memoryreport.cpp \
     src/messageboxhelper.cpp \
     src/outlinewidget.cpp \
+    src/pdfprinter.cpp \
     src/preferencesdialog.cpp \
+    src/previewbenchmark.cpp \
     src/previewoptionsdialog.cpp \
+    src/previewprofile.cpp \
+    src/previewtiming.cpp \
+    src/projectstatisticswidget.cpp \
+    src/projecttreewidget.cpp \
     src/sandboxedwebpage.cpp \
+    src/sessionrecorder.cpp \
+    src/sessionreplayer.cpp \
     src/sessionstatistics.cpp \
     src/sessionstatisticswidget.cpp \
     src/sidebar.cpp \
+    src/stallwatchdog.cpp \
     src/simplefontdialog.cpp \
-    src/stringobserver.cpp \
+    src/singleinstance.cpp \
     src/stylesheetbuilder.cpp \
+    src/tasklistwidget.cpp \
     src/theme.cpp \
     src/themeeditordialog.cpp \
     src/themerepository.cpp \
@@ -184,7 +171,6 @@ SOURCES += \
     src/timelabel.cpp \
     src/color_button.cpp \
     src/findreplace.cpp \
-    src/spelling/dictionary_manager.cpp \
     src/spelling/spell_checker.cpp
 
 # Generate translations
@@ -20,6 +20,7 @@ BuildRequires: gcc-c++
 BuildRequires: make
 BuildRequires: pkgconfig
 BuildRequires: pkgconfig(hunspell)
+BuildRequires: pkgconfig(icu-i18n)
 BuildRequires: cmake(Qt5Concurrent)
 BuildRequires: cmake(Qt5Core)
 BuildRequires: cmake(Qt5DBus)
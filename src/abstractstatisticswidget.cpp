@@ -19,6 +19,7 @@
 
 #include <QHBoxLayout>
 #include <QApplication>
+#include <QShowEvent>
 
 #include "abstractstatisticswidget.h"
 
@@ -28,7 +29,8 @@ AbstractStatisticsWidget::AbstractStatisticsWidget(QWidget *parent)
     : QListWidget(parent),
       LESS_THAN_ONE_MINUTE_STR(tr("&lt; 1m")),
       LESS_THAN_ONE_STR(tr("&lt; 1")),
-      PAGE_STATISTIC_INFO_TOOLTIP_STR(tr("250 words per page"))
+      PAGE_STATISTIC_INFO_TOOLTIP_STR(tr("250 words per page")),
+      displayPending(false)
 {
 
 }
@@ -38,6 +40,26 @@ AbstractStatisticsWidget::~AbstractStatisticsWidget()
 
 }
 
+bool AbstractStatisticsWidget::deferDisplay()
+{
+    if (!isVisible()) {
+        displayPending = true;
+        return true;
+    }
+
+    return false;
+}
+
+void AbstractStatisticsWidget::showEvent(QShowEvent *event)
+{
+    QListWidget::showEvent(event);
+
+    if (displayPending) {
+        displayPending = false;
+        displayStatistics();
+    }
+}
+
 void AbstractStatisticsWidget::setIntegerValueForLabel(QLabel *label, int value)
 {
     label->setText(QString("<b>%L1</b>").arg(value));
@@ -27,8 +27,13 @@ namespace ghostwriter
 {
 /**
  * Abstract class to layout statistics data into a QListWidget.
- * This class is inherited by DocumentStatisticsWidget and
- * SessionStatisticsWidget.
+ * This class is inherited by DocumentStatisticsWidget,
+ * SessionStatisticsWidget and ProjectStatisticsWidget.
+ *
+ * Statistics keep changing while the widget is hidden, such as when its
+ * sidebar tab is not selected or the sidebar is closed.  Subclasses then
+ * only store the latest values rather than formatting them into labels,
+ * and the widget displays them all at once when it is next shown.
  */
 class AbstractStatisticsWidget : public QListWidget
 {
@@ -43,6 +48,26 @@ protected:
     const QString LESS_THAN_ONE_STR;
     const QString PAGE_STATISTIC_INFO_TOOLTIP_STR;
 
+    /**
+     * Returns true if the widget is hidden, in which case the caller
+     * should only store the statistics it was given, which will be
+     * displayed with displayStatistics() once the widget is shown.
+     * Returns false if the statistics should be displayed now.
+     */
+    bool deferDisplay();
+
+    /**
+     * Displays the latest statistics stored by the subclass in all of
+     * its labels.
+     */
+    virtual void displayStatistics() = 0;
+
+    /**
+     * Overridden to display the statistics that changed while the widget
+     * was hidden.
+     */
+    void showEvent(QShowEvent *event);
+
     /**
      * Sets the text of the given value label to be an integer.
      * Calling this method assures uniform formatting is applied
@@ -87,6 +112,10 @@ protected:
         const QString &initialValue,
         const QString &toolTip = QString()
     );
+
+private:
+    // Whether statistics changed while the widget was hidden.
+    bool displayPending;
 };
 }
 
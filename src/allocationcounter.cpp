@@ -0,0 +1,200 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <cstddef>
+
+#include "allocationcounter.h"
+
+// The C library is known once any of its headers is included.
+#if defined(GW_COUNT_ALLOCATIONS) && defined(__GLIBC__)
+#define GW_ALLOCATION_COUNTER_ENABLED
+
+#include <atomic>
+#include <cerrno>
+#include <malloc.h>
+
+// The allocator of the C library, which the replacements below forward to.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void *__libc_valloc(size_t size);
+void *__libc_pvalloc(size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace
+{
+// Plain atomics rather than Qt's, since they are used before Qt is.
+std::atomic<qint64> allocationCount(0);
+std::atomic<qint64> allocatedBytes(0);
+std::atomic<qint64> liveBytes(0);
+std::atomic<qint64> peakLiveBytes(0);
+
+void countAllocation(void *ptr)
+{
+    if (nullptr == ptr) {
+        return;
+    }
+
+    // Count the usable size, which the C library also reports when the
+    // block is freed, so that the live bytes balance.
+    qint64 size = (qint64) malloc_usable_size(ptr);
+    qint64 live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    qint64 peak = peakLiveBytes.load(std::memory_order_relaxed);
+
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    while ((live > peak) && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        ;
+    }
+}
+
+void countFree(void *ptr)
+{
+    if (nullptr != ptr) {
+        liveBytes.fetch_sub((qint64) malloc_usable_size(ptr), std::memory_order_relaxed);
+    }
+}
+} // namespace
+
+extern "C" {
+void *malloc(size_t size)
+{
+    void *ptr = __libc_malloc(size);
+    countAllocation(ptr);
+    return ptr;
+}
+
+void *calloc(size_t count, size_t size)
+{
+    void *ptr = __libc_calloc(count, size);
+    countAllocation(ptr);
+    return ptr;
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    qint64 oldSize = (nullptr != ptr) ? (qint64) malloc_usable_size(ptr) : 0;
+    void *newPtr = __libc_realloc(ptr, size);
+
+    // A failed reallocation leaves the block as it was.
+    if ((nullptr == newPtr) && (size > 0)) {
+        return newPtr;
+    }
+
+    liveBytes.fetch_sub(oldSize, std::memory_order_relaxed);
+    countAllocation(newPtr);
+    return newPtr;
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    void *ptr = __libc_memalign(alignment, size);
+    countAllocation(ptr);
+    return ptr;
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+// Every function that allocates a block the application may free must be
+// replaced, since free() counts whatever it is given, and the live bytes
+// would otherwise drift.
+//
+void *valloc(size_t size)
+{
+    void *ptr = __libc_valloc(size);
+    countAllocation(ptr);
+    return ptr;
+}
+
+void *pvalloc(size_t size)
+{
+    void *ptr = __libc_pvalloc(size);
+    countAllocation(ptr);
+    return ptr;
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    if ((0 == alignment) || (0 != (alignment & (alignment - 1))) || (0 != (alignment % sizeof(void *)))) {
+        return EINVAL;
+    }
+
+    void *block = memalign(alignment, size);
+
+    if ((nullptr == block) && (size > 0)) {
+        return ENOMEM;
+    }
+
+    *ptr = block;
+    return 0;
+}
+
+void free(void *ptr)
+{
+    countFree(ptr);
+    __libc_free(ptr);
+}
+}
+#endif
+
+namespace ghostwriter
+{
+AllocationCounter::Counts::Counts()
+    : allocations(0), bytes(0), liveBytes(0), peakLiveBytes(0)
+{
+    ;
+}
+
+bool AllocationCounter::isEnabled()
+{
+#ifdef GW_ALLOCATION_COUNTER_ENABLED
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationCounter::Counts AllocationCounter::counts()
+{
+    Counts counts;
+
+#ifdef GW_ALLOCATION_COUNTER_ENABLED
+    counts.allocations = allocationCount.load(std::memory_order_relaxed);
+    counts.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    counts.liveBytes = liveBytes.load(std::memory_order_relaxed);
+    counts.peakLiveBytes = peakLiveBytes.load(std::memory_order_relaxed);
+#endif
+
+    return counts;
+}
+
+void AllocationCounter::resetPeak()
+{
+#ifdef GW_ALLOCATION_COUNTER_ENABLED
+    peakLiveBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+#endif
+}
+} // namespace ghostwriter
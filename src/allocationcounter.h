@@ -0,0 +1,83 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+namespace ghostwriter
+{
+/**
+ * Counts the heap allocations of the process, so that the benchmarks can
+ * report allocation churn and peak memory next to their timings.  Counting
+ * replaces malloc() and its siblings, through which operator new and the
+ * containers of Qt allocate, and so slows down every allocation.  It is
+ * therefore only built in when qmake is run with CONFIG+=count_allocations,
+ * for benchmark builds, and is only supported with the GNU C library.
+ * Otherwise, isEnabled() returns false, and the counts stay zero.
+ *
+ * The counts cover every thread of the process, including the thread pool.
+ */
+class AllocationCounter
+{
+public:
+    /**
+     * Counts of the allocations made since the application started.
+     */
+    struct Counts
+    {
+        Counts();
+
+        // Number of allocations, including reallocations.
+        qint64 allocations;
+
+        // Total bytes allocated.
+        qint64 bytes;
+
+        // Bytes currently allocated and not yet freed.
+        qint64 liveBytes;
+
+        // Highest number of live bytes since resetPeak() was last called.
+        qint64 peakLiveBytes;
+    };
+
+    /**
+     * Returns whether allocations are being counted.
+     */
+    static bool isEnabled();
+
+    /**
+     * Returns the counts so far.
+     */
+    static Counts counts();
+
+    /**
+     * Lowers the peak of live bytes to the bytes currently live, so that
+     * the peak of a benchmark case can be told apart from those of the
+     * cases before it.
+     */
+    static void resetPeak();
+
+private:
+    AllocationCounter();
+};
+} // namespace ghostwriter
+
+#endif // ALLOCATIONCOUNTER_H
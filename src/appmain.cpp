@@ -21,11 +21,20 @@
 #include <QCoreApplication>
 #include <QTranslator>
 #include <QLocale>
+#include <QStringList>
 
 #include <QDebug>
 
 #include "mainwindow.h"
 #include "appsettings.h"
+#include "batchexporter.h"
+#include "exporterfactory.h"
+#include "previewbenchmark.h"
+#include "sessionreplayer.h"
+#include "singleinstance.h"
+#include "startupprofiler.h"
+#include "statisticsreporter.h"
+#include "tracer.h"
 
 int main(int argc, char *argv[])
 {
@@ -34,7 +43,34 @@ int main(int argc, char *argv[])
     QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 #endif
 
+    QStringList arguments;
+
+    for (int i = 0; i < argc; i++) {
+        arguments.append(QString::fromLocal8Bit(argv[i]));
+    }
+
+    ghostwriter::StartupProfiler::start(arguments);
+    ghostwriter::Tracer::start();
+
+    bool batchExport = ghostwriter::BatchExporter::isRequested(arguments);
+    bool replay = ghostwriter::SessionReplayer::isRequested(arguments);
+    bool stats = ghostwriter::StatisticsReporter::isRequested(arguments);
+    bool previewBenchmark = ghostwriter::PreviewBenchmark::isRequested(arguments);
+
+    // Batch export, session replay, statistics reports and the preview
+    // benchmark need no display, so let them run on machines without one,
+    // such as build servers.
+    if
+    (
+        (batchExport || replay || stats || previewBenchmark)
+        && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")
+    ) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    ghostwriter::StartupProfiler::Scope appScope("QApplication");
     QApplication app(argc, argv);
+    appScope.end();
     
 #if defined(Q_OS_WIN)
     // Use ANGLE instead of OpenGL to bypass bug where full screen windows
@@ -48,12 +84,49 @@ int main(int argc, char *argv[])
     QGuiApplication::setDesktopFileName("ghostwriter");
 #endif
 
+    // Hold off running the external Markdown processors to detect them
+    // until the main window has shown the first document.  Headless runs
+    // need them right away.
+    //
+    if (!batchExport && !replay && !previewBenchmark) {
+        ghostwriter::ExporterFactory::setDetectionDeferred(true);
+    }
+
     // Call this to force settings initialization before the application
     // fully launches.
     //
+    ghostwriter::StartupProfiler::Scope settingsScope("AppSettings");
     ghostwriter::AppSettings *appSettings = ghostwriter::AppSettings::instance();
+    settingsScope.end();
+
+    QString filePath = QString();
+
+    for (int i = 1; i < app.arguments().size(); i++) {
+        if (ghostwriter::StartupProfiler::PROFILE_OPTION != app.arguments().at(i)) {
+            filePath = app.arguments().at(i);
+            break;
+        }
+    }
+
+    // Hand the file to the instance that is already running, if any, so
+    // that this launch can exit before paying for a full startup.
+    //
+    if
+    (
+        !batchExport
+        && !replay
+        && !stats
+        && !previewBenchmark
+        && appSettings->singleInstanceEnabled()
+        && ghostwriter::SingleInstance::forward(filePath)
+    ) {
+        ghostwriter::Tracer::finish();
+        return 0;
+    }
     QLocale::setDefault(appSettings->locale());
 
+    ghostwriter::StartupProfiler::Scope translationsScope("Translations");
+
     QTranslator qtTranslator;
     bool ok = qtTranslator.load("qt_" + appSettings->locale(),
                                 QLibraryInfo::location(QLibraryInfo::TranslationsPath));
@@ -92,15 +165,62 @@ int main(int argc, char *argv[])
     }
 
     app.installTranslator(&appTranslator);
+    translationsScope.end();
 
-    QString filePath = QString();
+    if (batchExport) {
+        ghostwriter::BatchExporter batchExporter;
+        int exitCode = batchExporter.exec(app.arguments());
+        ghostwriter::Tracer::finish();
+        return exitCode;
+    }
+
+    if (stats) {
+        ghostwriter::StatisticsReporter statisticsReporter;
+        int exitCode = statisticsReporter.exec(app.arguments());
+        ghostwriter::Tracer::finish();
+        return exitCode;
+    }
+
+    if (previewBenchmark) {
+        ghostwriter::PreviewBenchmark benchmark;
+        int exitCode = benchmark.exec(app.arguments());
+        ghostwriter::Tracer::finish();
+        return exitCode;
+    }
 
-    if (argc > 1) {
-        filePath = app.arguments().at(1);
+    if (replay) {
+        ghostwriter::SessionReplayer sessionReplayer;
+        int exitCode = sessionReplayer.exec(app.arguments());
+        ghostwriter::Tracer::finish();
+        return exitCode;
     }
 
+    ghostwriter::StartupProfiler::Scope windowScope("MainWindow");
     ghostwriter::MainWindow window(filePath);
 
     window.show();
-    return app.exec();
+    windowScope.end();
+
+    ghostwriter::SingleInstance singleInstance;
+    singleInstance.setEnabled(appSettings->singleInstanceEnabled());
+
+    QObject::connect
+    (
+        appSettings,
+        &ghostwriter::AppSettings::singleInstanceChanged,
+        &singleInstance,
+        &ghostwriter::SingleInstance::setEnabled
+    );
+
+    QObject::connect
+    (
+        &singleInstance,
+        &ghostwriter::SingleInstance::openRequested,
+        &window,
+        &ghostwriter::MainWindow::openRequestedFile
+    );
+
+    int exitCode = app.exec();
+    ghostwriter::Tracer::finish();
+    return exitCode;
 }
@@ -23,15 +23,20 @@
 #include <QDir>
 #include <QFontDatabase>
 #include <QFontInfo>
+#include <QHash>
 #include <QLocale>
+#include <QSet>
 #include <QSettings>
 #include <QStringList>
+#include <QTimer>
 
 #include "appsettings.h"
 #include "dictionary_manager.h"
 #include "exporterfactory.h"
+#include "startupprofiler.h"
 
 #define GW_AUTOSAVE_KEY "Save/autoSave"
+#define GW_AUTOSAVE_JOURNAL_KEY "Save/autoSaveJournal"
 #define GW_BACKUP_FILE_KEY "Save/backupFile"
 #define GW_REMEMBER_FILE_HISTORY_KEY "Save/rememberFileHistory"
 #define GW_EDITOR_FONT_KEY "Style/editorFont"
@@ -39,6 +44,10 @@
 #define GW_AUTO_MATCH_KEY "Typing/autoMatchEnabled"
 #define GW_AUTO_MATCH_FILTER_KEY "Typing/autoMatchFilter"
 #define GW_BULLET_CYCLING_KEY "Typing/bulletPointCyclingEnabled"
+#define GW_IMAGE_IMPORT_KEY "Typing/importDroppedImages"
+#define GW_WORD_COMPLETION_KEY "Typing/wordCompletionEnabled"
+#define GW_TABLE_FORMATTING_KEY "Typing/tableFormattingEnabled"
+#define GW_IMAGE_IMPORT_MAX_WIDTH_KEY "Typing/importedImageMaxWidth"
 #define GW_UNDERLINE_ITALICS_KEY "Style/underlineInsteadOfItalics"
 #define GW_FOCUS_MODE_KEY "Style/focusMode"
 #define GW_HIDE_MENU_BAR_IN_FULL_SCREEN_KEY "Style/hideMenuBarInFullScreenEnabled"
@@ -51,19 +60,38 @@
 #define GW_TAB_WIDTH_KEY "Tabs/tabWidth"
 #define GW_SPACES_FOR_TABS_KEY "Tabs/insertSpacesForTabs"
 #define GW_DICTIONARY_KEY "Spelling/locale"
+#define GW_ALTERNATIVE_DICTIONARIES_KEY "Spelling/alternativeLocales"
 #define GW_LOCALE_KEY "Application/locale"
+#define GW_SINGLE_INSTANCE_KEY "Application/singleInstance"
 #define GW_LIVE_SPELL_CHECK_KEY "Spelling/liveSpellCheck"
+#define GW_LINT_ENABLED_KEY "Lint/enabled"
+#define GW_LINT_LINE_LENGTH_KEY "Lint/lineLength"
+#define GW_LINT_WEB_LINKS_KEY "Lint/checkWebLinks"
+#define GW_READABILITY_HIGHLIGHT_KEY "Lint/highlightHardSentences"
 #define GW_SIDEBAR_OPEN_KEY "Window/sidebarOpen"
 #define GW_HTML_PREVIEW_OPEN_KEY "Preview/htmlPreviewOpen"
 #define GW_LAST_USED_EXPORTER_KEY "Preview/lastUsedExporter"
 #define GW_PREVIEW_TEXT_FONT_KEY "Preview/textFont"
 #define GW_PREVIEW_CODE_FONT_KEY "Preview/codeFont"
+#define GW_LARGE_DOCUMENT_MODE_KEY "Performance/largeDocumentMode"
+#define GW_LARGE_DOCUMENT_THRESHOLD_KEY "Performance/largeDocumentThreshold"
+#define GW_HUGE_DOCUMENT_THRESHOLD_KEY "Performance/hugeDocumentThreshold"
+#define GW_LONG_LINE_THRESHOLD_KEY "Performance/longLineThreshold"
+#define GW_GPU_VIEWPORT_KEY "Performance/gpuViewport"
+#define GW_PREVIEW_IDLE_TIMEOUT_KEY "Performance/previewIdleTimeout"
+#define GW_MEMORY_CEILING_KEY "Performance/memoryCeiling"
+#define GW_UNDO_MEMORY_LIMIT_KEY "Performance/undoMemoryLimit"
+#define GW_STALL_REPORTS_KEY "Performance/stallReports"
 
 namespace ghostwriter
 {
 class AppSettingsPrivate
 {
 public:
+    // Time, in milliseconds, to wait for further changes before writing
+    // changed settings to disk.
+    static const int STORE_DELAY = 1000;
+
     static AppSettings *instance;
 
     AppSettingsPrivate()
@@ -78,21 +106,51 @@ public:
 
     QString firstAvailableFont(const QStringList& fontList) const;
 
+    /*
+    * Records that the setting with the given key changed, and schedules
+    * writing it to disk together with any other changes made in the
+    * meantime.
+    */
+    void markDirty(const QString &key);
+
     bool autoMatchEnabled;
     bool autoSaveEnabled;
+    bool autoSaveJournalEnabled;
     bool backupFileEnabled;
     bool bulletPointCyclingEnabled;
+    bool wordCompletionEnabled;
+    bool tableFormattingEnabled;
+    bool imageImportEnabled;
+    int imageImportMaxWidth;
     bool displayTimeInFullScreenEnabled;
     bool fileHistoryEnabled;
     bool hideMenuBarInFullScreenEnabled;
     bool htmlPreviewVisible;
     bool sidebarVisible;
+    bool singleInstanceEnabled;
     bool insertSpacesForTabsEnabled;
     bool largeHeadingSizesEnabled;
+    bool largeDocumentModeEnabled;
+    int largeDocumentThreshold;
+    int hugeDocumentThreshold;
+    int longLineThreshold;
+    bool gpuViewportEnabled;
+    int previewIdleTimeout;
+    int memoryCeiling;
+    int undoMemoryLimit;
+    bool stallReportsEnabled;
     bool liveSpellCheckEnabled;
+    bool lintEnabled;
+    int lintLineLength;
+    bool lintWebLinksEnabled;
+    bool readabilityHighlightEnabled;
     bool useUnderlineForEmphasis;
     EditorWidth editorWidth;
     Exporter *currentHtmlExporter;
+
+    // Name of the HTML exporter chosen by the user, which may not have
+    // been detected yet.
+    QString htmlExporterName;
     FocusMode focusMode;
     int tabWidth;
     InterfaceStyle interfaceStyle;
@@ -102,12 +160,17 @@ public:
     QFont previewCodeFont;
     QString autoMatchedCharFilter;
     QString dictionaryLanguage;
+    QStringList alternativeDictionaryLanguages;
     QString dictionaryPath;
     QString locale;
     QString themeDirectoryPath;
     QString themeName;
     bool darkModeEnabled;
     QString translationsPath;
+
+    // Keys of the settings changed since they were last written.
+    QSet<QString> dirtyKeys;
+    QTimer *storeTimer;
 };
 
 AppSettings *AppSettingsPrivate::instance = nullptr;
@@ -130,36 +193,69 @@ void AppSettings::store()
 {
     Q_D(AppSettings);
 
+    d->storeTimer->stop();
+
+    if (d->dirtyKeys.isEmpty()) {
+        return;
+    }
+
+    QHash<QString, QVariant> values;
+
+    values.insert(GW_AUTO_MATCH_FILTER_KEY, QVariant(d->autoMatchedCharFilter));
+    values.insert(GW_AUTO_MATCH_KEY, QVariant(d->autoMatchEnabled));
+    values.insert(GW_AUTOSAVE_KEY, QVariant(d->autoSaveEnabled));
+    values.insert(GW_AUTOSAVE_JOURNAL_KEY, QVariant(d->autoSaveJournalEnabled));
+    values.insert(GW_BACKUP_FILE_KEY, QVariant(d->backupFileEnabled));
+    values.insert(GW_BULLET_CYCLING_KEY, QVariant(d->bulletPointCyclingEnabled));
+    values.insert(GW_WORD_COMPLETION_KEY, QVariant(d->wordCompletionEnabled));
+    values.insert(GW_TABLE_FORMATTING_KEY, QVariant(d->tableFormattingEnabled));
+    values.insert(GW_IMAGE_IMPORT_KEY, QVariant(d->imageImportEnabled));
+    values.insert(GW_IMAGE_IMPORT_MAX_WIDTH_KEY, QVariant(d->imageImportMaxWidth));
+    values.insert(GW_DICTIONARY_KEY, QVariant(d->dictionaryLanguage));
+    values.insert(GW_ALTERNATIVE_DICTIONARIES_KEY, QVariant(d->alternativeDictionaryLanguages));
+    values.insert(GW_DISPLAY_TIME_IN_FULL_SCREEN_KEY, QVariant(d->displayTimeInFullScreenEnabled));
+    values.insert(GW_EDITOR_WIDTH_KEY, QVariant(d->editorWidth));
+    values.insert(GW_FOCUS_MODE_KEY, QVariant(d->focusMode));
+    values.insert(GW_EDITOR_FONT_KEY, QVariant(d->editorFont.toString()));
+    values.insert(GW_PREVIEW_TEXT_FONT_KEY, QVariant(d->previewTextFont.toString()));
+    values.insert(GW_PREVIEW_CODE_FONT_KEY, QVariant(d->previewCodeFont.toString()));
+    values.insert(GW_HIDE_MENU_BAR_IN_FULL_SCREEN_KEY, QVariant(d->hideMenuBarInFullScreenEnabled));
+    values.insert(GW_INTERFACE_STYLE_KEY, QVariant(d->interfaceStyle));
+    values.insert(GW_BLOCKQUOTE_STYLE_KEY, QVariant(d->italicizeBlockquotes));
+    values.insert(GW_LARGE_HEADINGS_KEY, QVariant(d->largeHeadingSizesEnabled));
+    values.insert(GW_LARGE_DOCUMENT_MODE_KEY, QVariant(d->largeDocumentModeEnabled));
+    values.insert(GW_LARGE_DOCUMENT_THRESHOLD_KEY, QVariant(d->largeDocumentThreshold));
+    values.insert(GW_HUGE_DOCUMENT_THRESHOLD_KEY, QVariant(d->hugeDocumentThreshold));
+    values.insert(GW_LONG_LINE_THRESHOLD_KEY, QVariant(d->longLineThreshold));
+    values.insert(GW_GPU_VIEWPORT_KEY, QVariant(d->gpuViewportEnabled));
+    values.insert(GW_PREVIEW_IDLE_TIMEOUT_KEY, QVariant(d->previewIdleTimeout));
+    values.insert(GW_MEMORY_CEILING_KEY, QVariant(d->memoryCeiling));
+    values.insert(GW_UNDO_MEMORY_LIMIT_KEY, QVariant(d->undoMemoryLimit));
+    values.insert(GW_STALL_REPORTS_KEY, QVariant(d->stallReportsEnabled));
+    values.insert(GW_SIDEBAR_OPEN_KEY, QVariant(d->sidebarVisible));
+    values.insert(GW_HTML_PREVIEW_OPEN_KEY, QVariant(d->htmlPreviewVisible));
+    values.insert(GW_LAST_USED_EXPORTER_KEY, QVariant(d->htmlExporterName));
+    values.insert(GW_LIVE_SPELL_CHECK_KEY, QVariant(d->liveSpellCheckEnabled));
+    values.insert(GW_LINT_ENABLED_KEY, QVariant(d->lintEnabled));
+    values.insert(GW_LINT_LINE_LENGTH_KEY, QVariant(d->lintLineLength));
+    values.insert(GW_LINT_WEB_LINKS_KEY, QVariant(d->lintWebLinksEnabled));
+    values.insert(GW_READABILITY_HIGHLIGHT_KEY, QVariant(d->readabilityHighlightEnabled));
+    values.insert(GW_LOCALE_KEY, QVariant(d->locale));
+    values.insert(GW_REMEMBER_FILE_HISTORY_KEY, QVariant(d->fileHistoryEnabled));
+    values.insert(GW_SINGLE_INSTANCE_KEY, QVariant(d->singleInstanceEnabled));
+    values.insert(GW_SPACES_FOR_TABS_KEY, QVariant(d->insertSpacesForTabsEnabled));
+    values.insert(GW_TAB_WIDTH_KEY, QVariant(d->tabWidth));
+    values.insert(GW_THEME_KEY, QVariant(d->themeName));
+    values.insert(GW_DARK_MODE_KEY, QVariant(d->darkModeEnabled));
+    values.insert(GW_UNDERLINE_ITALICS_KEY, QVariant(d->useUnderlineForEmphasis));
+
     QSettings appSettings;
 
-    appSettings.setValue(GW_AUTO_MATCH_FILTER_KEY, QVariant(d->autoMatchedCharFilter));
-    appSettings.setValue(GW_AUTO_MATCH_KEY, QVariant(d->autoMatchEnabled));
-    appSettings.setValue(GW_AUTOSAVE_KEY, QVariant(d->autoSaveEnabled));
-    appSettings.setValue(GW_BACKUP_FILE_KEY, QVariant(d->backupFileEnabled));
-    appSettings.setValue(GW_BULLET_CYCLING_KEY, QVariant(d->bulletPointCyclingEnabled));
-    appSettings.setValue(GW_DICTIONARY_KEY, QVariant(d->dictionaryLanguage));
-    appSettings.setValue(GW_DISPLAY_TIME_IN_FULL_SCREEN_KEY, QVariant(d->displayTimeInFullScreenEnabled));
-    appSettings.setValue(GW_EDITOR_WIDTH_KEY, QVariant(d->editorWidth));
-    appSettings.setValue(GW_FOCUS_MODE_KEY, QVariant(d->focusMode));
-    appSettings.setValue(GW_EDITOR_FONT_KEY, QVariant(d->editorFont.toString()));
-    appSettings.setValue(GW_PREVIEW_TEXT_FONT_KEY,     QVariant(d->previewTextFont.toString()));
-    appSettings.setValue(GW_PREVIEW_CODE_FONT_KEY, QVariant(d->previewCodeFont.toString()));
-    appSettings.setValue(GW_HIDE_MENU_BAR_IN_FULL_SCREEN_KEY, QVariant(d->hideMenuBarInFullScreenEnabled));
-    appSettings.setValue(GW_INTERFACE_STYLE_KEY, QVariant(d->interfaceStyle));
-    appSettings.setValue(GW_BLOCKQUOTE_STYLE_KEY, QVariant(d->italicizeBlockquotes));
-    appSettings.setValue(GW_LARGE_HEADINGS_KEY, QVariant(d->largeHeadingSizesEnabled));
-    appSettings.setValue(GW_SIDEBAR_OPEN_KEY, QVariant(d->sidebarVisible));
-    appSettings.setValue(GW_HTML_PREVIEW_OPEN_KEY, QVariant(d->htmlPreviewVisible));
-    appSettings.setValue(GW_LAST_USED_EXPORTER_KEY, QVariant(d->currentHtmlExporter->name()));
-    appSettings.setValue(GW_LIVE_SPELL_CHECK_KEY, QVariant(d->liveSpellCheckEnabled));
-    appSettings.setValue(GW_LOCALE_KEY, QVariant(d->locale));
-    appSettings.setValue(GW_REMEMBER_FILE_HISTORY_KEY, QVariant(d->fileHistoryEnabled));
-    appSettings.setValue(GW_SPACES_FOR_TABS_KEY, QVariant(d->insertSpacesForTabsEnabled));
-    appSettings.setValue(GW_TAB_WIDTH_KEY, QVariant(d->tabWidth));
-    appSettings.setValue(GW_THEME_KEY, QVariant(d->themeName));
-    appSettings.setValue(GW_DARK_MODE_KEY, QVariant(d->darkModeEnabled));
-    appSettings.setValue(GW_UNDERLINE_ITALICS_KEY, QVariant(d->useUnderlineForEmphasis));
+    foreach (const QString &key, d->dirtyKeys) {
+        appSettings.setValue(key, values.value(key));
+    }
 
+    d->dirtyKeys.clear();
     appSettings.sync();
 }
 
@@ -196,9 +292,26 @@ void AppSettings::setAutoSaveEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->autoSaveEnabled = enabled;
+    d->markDirty(GW_AUTOSAVE_KEY);
     emit autoSaveChanged(enabled);
 }
 
+bool AppSettings::autoSaveJournalEnabled() const
+{
+    Q_D(const AppSettings);
+
+    return d->autoSaveJournalEnabled;
+}
+
+void AppSettings::setAutoSaveJournalEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+
+    d->autoSaveJournalEnabled = enabled;
+    d->markDirty(GW_AUTOSAVE_JOURNAL_KEY);
+    emit autoSaveJournalChanged(enabled);
+}
+
 bool AppSettings::backupFileEnabled() const
 {
     Q_D(const AppSettings);
@@ -211,6 +324,7 @@ void AppSettings::setBackupFileEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->backupFileEnabled = enabled;
+    d->markDirty(GW_BACKUP_FILE_KEY);
     emit backupFileChanged(enabled);
 }
 
@@ -226,6 +340,7 @@ void AppSettings::setEditorFont(const QFont &font)
     Q_D(AppSettings);
     
     d->editorFont = font;
+    d->markDirty(GW_EDITOR_FONT_KEY);
 }
 
 QFont AppSettings::previewTextFont() const
@@ -240,6 +355,7 @@ void AppSettings::setPreviewTextFont(const QFont &font)
     Q_D(AppSettings);
     
     d->previewTextFont = font;
+    d->markDirty(GW_PREVIEW_TEXT_FONT_KEY);
     emit previewTextFontChanged(font);
 }
 
@@ -255,6 +371,7 @@ void AppSettings::setPreviewCodeFont(const QFont &font)
     Q_D(AppSettings);
     
     d->previewCodeFont = font;
+    d->markDirty(GW_PREVIEW_CODE_FONT_KEY);
     emit previewCodeFontChanged(font);
 }
 
@@ -271,6 +388,7 @@ void AppSettings::setTabWidth(int width)
     
     if ((d->tabWidth >= MIN_TAB_WIDTH) && (d->tabWidth <= MAX_TAB_WIDTH)) {
         d->tabWidth = width;
+        d->markDirty(GW_TAB_WIDTH_KEY);
         emit tabWidthChanged(width);
     }
 }
@@ -287,6 +405,7 @@ void AppSettings::setInsertSpacesForTabsEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->insertSpacesForTabsEnabled = enabled;
+    d->markDirty(GW_SPACES_FOR_TABS_KEY);
     emit insertSpacesForTabsChanged(enabled);
 }
 
@@ -302,6 +421,7 @@ void AppSettings::setUseUnderlineForEmphasis(bool enabled)
     Q_D(AppSettings);
     
     d->useUnderlineForEmphasis = enabled;
+    d->markDirty(GW_UNDERLINE_ITALICS_KEY);
     emit useUnderlineForEmphasisChanged(enabled);
 }
 
@@ -317,6 +437,7 @@ void AppSettings::setLargeHeadingSizesEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->largeHeadingSizesEnabled = enabled;
+    d->markDirty(GW_LARGE_HEADINGS_KEY);
     emit largeHeadingSizesChanged(enabled);
 }
 
@@ -332,6 +453,7 @@ void AppSettings::setAutoMatchEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->autoMatchEnabled = enabled;
+    d->markDirty(GW_AUTO_MATCH_KEY);
     emit autoMatchChanged(enabled);
 }
 
@@ -364,6 +486,7 @@ void AppSettings::setAutoMatchCharEnabled(const QChar openingCharacter, bool ena
             d->autoMatchedCharFilter.remove(openingCharacter);
         }
 
+        d->markDirty(GW_AUTO_MATCH_FILTER_KEY);
         emit autoMatchCharChanged(openingCharacter, enabled);
 
         break;
@@ -384,9 +507,80 @@ void AppSettings::setBulletPointCyclingEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->bulletPointCyclingEnabled = enabled;
+    d->markDirty(GW_BULLET_CYCLING_KEY);
     emit bulletPointCyclingChanged(enabled);
 }
 
+bool AppSettings::wordCompletionEnabled() const
+{
+    Q_D(const AppSettings);
+
+    return d->wordCompletionEnabled;
+}
+
+void AppSettings::setWordCompletionEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+
+    d->wordCompletionEnabled = enabled;
+    d->markDirty(GW_WORD_COMPLETION_KEY);
+    emit wordCompletionChanged(enabled);
+}
+
+bool AppSettings::tableFormattingEnabled() const
+{
+    Q_D(const AppSettings);
+
+    return d->tableFormattingEnabled;
+}
+
+void AppSettings::setTableFormattingEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+
+    d->tableFormattingEnabled = enabled;
+    d->markDirty(GW_TABLE_FORMATTING_KEY);
+    emit tableFormattingChanged(enabled);
+}
+
+bool AppSettings::imageImportEnabled() const
+{
+    Q_D(const AppSettings);
+    
+    return d->imageImportEnabled;
+}
+
+void AppSettings::setImageImportEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+    
+    d->imageImportEnabled = enabled;
+    d->markDirty(GW_IMAGE_IMPORT_KEY);
+    emit imageImportEnabledChanged(enabled);
+}
+
+int AppSettings::imageImportMaxWidth() const
+{
+    Q_D(const AppSettings);
+    
+    return d->imageImportMaxWidth;
+}
+
+void AppSettings::setImageImportMaxWidth(int pixels)
+{
+    Q_D(AppSettings);
+    
+    if
+    (
+        (pixels >= MIN_IMAGE_IMPORT_MAX_WIDTH)
+        && (pixels <= MAX_IMAGE_IMPORT_MAX_WIDTH)
+    ) {
+        d->imageImportMaxWidth = pixels;
+        d->markDirty(GW_IMAGE_IMPORT_MAX_WIDTH_KEY);
+        emit imageImportMaxWidthChanged(pixels);
+    }
+}
+
 FocusMode AppSettings::focusMode() const
 {
     Q_D(const AppSettings);
@@ -400,6 +594,7 @@ void AppSettings::setFocusMode(FocusMode focusMode)
     
     if ((focusMode >= FocusModeFirst) && (focusMode <= FocusModeLast)) {
         d->focusMode = focusMode;
+        d->markDirty(GW_FOCUS_MODE_KEY);
         emit focusModeChanged(focusMode);
     }
 }
@@ -416,6 +611,7 @@ void AppSettings::setHideMenuBarInFullScreenEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->hideMenuBarInFullScreenEnabled = enabled;
+    d->markDirty(GW_HIDE_MENU_BAR_IN_FULL_SCREEN_KEY);
     emit hideMenuBarInFullScreenChanged(enabled);
 }
 
@@ -431,9 +627,26 @@ void AppSettings::setFileHistoryEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->fileHistoryEnabled = enabled;
+    d->markDirty(GW_REMEMBER_FILE_HISTORY_KEY);
     emit fileHistoryChanged(enabled);
 }
 
+bool AppSettings::singleInstanceEnabled() const
+{
+    Q_D(const AppSettings);
+
+    return d->singleInstanceEnabled;
+}
+
+void AppSettings::setSingleInstanceEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+
+    d->singleInstanceEnabled = enabled;
+    d->markDirty(GW_SINGLE_INSTANCE_KEY);
+    emit singleInstanceChanged(enabled);
+}
+
 bool AppSettings::displayTimeInFullScreenEnabled()
 {
     Q_D(AppSettings);
@@ -446,6 +659,7 @@ void AppSettings::setDisplayTimeInFullScreenEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->displayTimeInFullScreenEnabled = enabled;
+    d->markDirty(GW_DISPLAY_TIME_IN_FULL_SCREEN_KEY);
     emit displayTimeInFullScreenChanged(enabled);
 }
 
@@ -461,6 +675,7 @@ void AppSettings::setThemeName(const QString &name)
     Q_D(AppSettings);
     
     d->themeName = name;
+    d->markDirty(GW_THEME_KEY);
 }
 
 bool AppSettings::darkModeEnabled() const
@@ -475,6 +690,7 @@ void AppSettings::setDarkModeEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->darkModeEnabled = enabled;
+    d->markDirty(GW_DARK_MODE_KEY);
 }
 
 QString AppSettings::dictionaryLanguage() const
@@ -489,9 +705,26 @@ void AppSettings::setDictionaryLanguage(const QString &language)
     Q_D(AppSettings);
     
     d->dictionaryLanguage = language;
+    d->markDirty(GW_DICTIONARY_KEY);
     emit dictionaryLanguageChanged(language);
 }
 
+QStringList AppSettings::alternativeDictionaryLanguages() const
+{
+    Q_D(const AppSettings);
+
+    return d->alternativeDictionaryLanguages;
+}
+
+void AppSettings::setAlternativeDictionaryLanguages(const QStringList &languages)
+{
+    Q_D(AppSettings);
+
+    d->alternativeDictionaryLanguages = languages;
+    d->markDirty(GW_ALTERNATIVE_DICTIONARIES_KEY);
+    emit alternativeDictionaryLanguagesChanged(languages);
+}
+
 QString AppSettings::locale() const
 {
     Q_D(const AppSettings);
@@ -504,6 +737,7 @@ void AppSettings::setLocale(const QString &locale)
     Q_D(AppSettings);
     
     d->locale = locale;
+    d->markDirty(GW_LOCALE_KEY);
 }
 
 bool AppSettings::liveSpellCheckEnabled() const
@@ -518,9 +752,80 @@ void AppSettings::setLiveSpellCheckEnabled(bool enabled)
     Q_D(AppSettings);
     
     d->liveSpellCheckEnabled = enabled;
+    d->markDirty(GW_LIVE_SPELL_CHECK_KEY);
     emit liveSpellCheckChanged(enabled);
 }
 
+bool AppSettings::lintEnabled() const
+{
+    Q_D(const AppSettings);
+    
+    return d->lintEnabled;
+}
+
+void AppSettings::setLintEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+    
+    d->lintEnabled = enabled;
+    d->markDirty(GW_LINT_ENABLED_KEY);
+    emit lintEnabledChanged(enabled);
+}
+
+int AppSettings::lintLineLength() const
+{
+    Q_D(const AppSettings);
+    
+    return d->lintLineLength;
+}
+
+void AppSettings::setLintLineLength(int characters)
+{
+    Q_D(AppSettings);
+    
+    if
+    (
+        (characters >= MIN_LINT_LINE_LENGTH)
+        && (characters <= MAX_LINT_LINE_LENGTH)
+    ) {
+        d->lintLineLength = characters;
+        d->markDirty(GW_LINT_LINE_LENGTH_KEY);
+        emit lintLineLengthChanged(characters);
+    }
+}
+
+bool AppSettings::lintWebLinksEnabled() const
+{
+    Q_D(const AppSettings);
+    
+    return d->lintWebLinksEnabled;
+}
+
+void AppSettings::setLintWebLinksEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+    
+    d->lintWebLinksEnabled = enabled;
+    d->markDirty(GW_LINT_WEB_LINKS_KEY);
+    emit lintWebLinksEnabledChanged(enabled);
+}
+
+bool AppSettings::readabilityHighlightEnabled() const
+{
+    Q_D(const AppSettings);
+
+    return d->readabilityHighlightEnabled;
+}
+
+void AppSettings::setReadabilityHighlightEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+
+    d->readabilityHighlightEnabled = enabled;
+    d->markDirty(GW_READABILITY_HIGHLIGHT_KEY);
+    emit readabilityHighlightEnabledChanged(enabled);
+}
+
 EditorWidth AppSettings::editorWidth() const
 {
     Q_D(const AppSettings);
@@ -534,6 +839,7 @@ void AppSettings::setEditorWidth(EditorWidth editorWidth)
     
     if ((editorWidth >= EditorWidthFirst) && (editorWidth <= EditorWidthLast)) {
         d->editorWidth = editorWidth;
+        d->markDirty(GW_EDITOR_WIDTH_KEY);
         emit editorWidthChanged(editorWidth);
     }
 }
@@ -550,6 +856,7 @@ void AppSettings::setInterfaceStyle(InterfaceStyle style)
     Q_D(AppSettings);
     
     d->interfaceStyle = style;
+    d->markDirty(GW_INTERFACE_STYLE_KEY);
     emit interfaceStyleChanged(style);
 }
 
@@ -565,6 +872,7 @@ void AppSettings::setItalicizeBlockquotes(bool enabled)
     Q_D(AppSettings);
     
     d->italicizeBlockquotes = enabled;
+    d->markDirty(GW_BLOCKQUOTE_STYLE_KEY);
     emit italicizeBlockquotesChanged(enabled);
 }
 
@@ -580,6 +888,7 @@ void AppSettings::setHtmlPreviewVisible(bool visible)
     Q_D(AppSettings);
     
     d->htmlPreviewVisible = visible;
+    d->markDirty(GW_HTML_PREVIEW_OPEN_KEY);
 }
 
 bool AppSettings::sidebarVisible() const
@@ -594,6 +903,187 @@ void AppSettings::setSidebarVisible(bool visible)
     Q_D(AppSettings);
     
     d->sidebarVisible = visible;
+    d->markDirty(GW_SIDEBAR_OPEN_KEY);
+}
+
+bool AppSettings::largeDocumentModeEnabled() const
+{
+    Q_D(const AppSettings);
+    
+    return d->largeDocumentModeEnabled;
+}
+
+void AppSettings::setLargeDocumentModeEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+    
+    d->largeDocumentModeEnabled = enabled;
+    d->markDirty(GW_LARGE_DOCUMENT_MODE_KEY);
+    emit largeDocumentModeChanged(enabled);
+}
+
+int AppSettings::largeDocumentThreshold() const
+{
+    Q_D(const AppSettings);
+    
+    return d->largeDocumentThreshold;
+}
+
+void AppSettings::setLargeDocumentThreshold(int characters)
+{
+    Q_D(AppSettings);
+    
+    if
+    (
+        (characters >= MIN_LARGE_DOCUMENT_THRESHOLD)
+        && (characters <= MAX_LARGE_DOCUMENT_THRESHOLD)
+    ) {
+        d->largeDocumentThreshold = characters;
+        d->markDirty(GW_LARGE_DOCUMENT_THRESHOLD_KEY);
+        emit largeDocumentThresholdChanged(characters);
+    }
+}
+
+int AppSettings::hugeDocumentThreshold() const
+{
+    Q_D(const AppSettings);
+    
+    return d->hugeDocumentThreshold;
+}
+
+void AppSettings::setHugeDocumentThreshold(int characters)
+{
+    Q_D(AppSettings);
+    
+    if
+    (
+        (characters >= MIN_LARGE_DOCUMENT_THRESHOLD)
+        && (characters <= MAX_LARGE_DOCUMENT_THRESHOLD)
+    ) {
+        d->hugeDocumentThreshold = characters;
+        d->markDirty(GW_HUGE_DOCUMENT_THRESHOLD_KEY);
+        emit hugeDocumentThresholdChanged(characters);
+    }
+}
+
+int AppSettings::longLineThreshold() const
+{
+    Q_D(const AppSettings);
+
+    return d->longLineThreshold;
+}
+
+void AppSettings::setLongLineThreshold(int characters)
+{
+    Q_D(AppSettings);
+
+    if
+    (
+        (characters >= MIN_LONG_LINE_THRESHOLD)
+        && (characters <= MAX_LONG_LINE_THRESHOLD)
+    ) {
+        d->longLineThreshold = characters;
+        d->markDirty(GW_LONG_LINE_THRESHOLD_KEY);
+        emit longLineThresholdChanged(characters);
+    }
+}
+
+bool AppSettings::gpuViewportEnabled() const
+{
+    Q_D(const AppSettings);
+
+    return d->gpuViewportEnabled;
+}
+
+void AppSettings::setGpuViewportEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+
+    d->gpuViewportEnabled = enabled;
+    d->markDirty(GW_GPU_VIEWPORT_KEY);
+    emit gpuViewportChanged(enabled);
+}
+
+int AppSettings::previewIdleTimeout() const
+{
+    Q_D(const AppSettings);
+    
+    return d->previewIdleTimeout;
+}
+
+void AppSettings::setPreviewIdleTimeout(int seconds)
+{
+    Q_D(AppSettings);
+    
+    if
+    (
+        (seconds >= MIN_PREVIEW_IDLE_TIMEOUT)
+        && (seconds <= MAX_PREVIEW_IDLE_TIMEOUT)
+    ) {
+        d->previewIdleTimeout = seconds;
+        d->markDirty(GW_PREVIEW_IDLE_TIMEOUT_KEY);
+        emit previewIdleTimeoutChanged(seconds);
+    }
+}
+
+int AppSettings::memoryCeiling() const
+{
+    Q_D(const AppSettings);
+    
+    return d->memoryCeiling;
+}
+
+void AppSettings::setMemoryCeiling(int megabytes)
+{
+    Q_D(AppSettings);
+    
+    if
+    (
+        (megabytes >= MIN_MEMORY_CEILING)
+        && (megabytes <= MAX_MEMORY_CEILING)
+    ) {
+        d->memoryCeiling = megabytes;
+        d->markDirty(GW_MEMORY_CEILING_KEY);
+        emit memoryCeilingChanged(megabytes);
+    }
+}
+
+int AppSettings::undoMemoryLimit() const
+{
+    Q_D(const AppSettings);
+    
+    return d->undoMemoryLimit;
+}
+
+void AppSettings::setUndoMemoryLimit(int megabytes)
+{
+    Q_D(AppSettings);
+    
+    if
+    (
+        (megabytes >= MIN_UNDO_MEMORY_LIMIT)
+        && (megabytes <= MAX_UNDO_MEMORY_LIMIT)
+    ) {
+        d->undoMemoryLimit = megabytes;
+        d->markDirty(GW_UNDO_MEMORY_LIMIT_KEY);
+        emit undoMemoryLimitChanged(megabytes);
+    }
+}
+
+bool AppSettings::stallReportsEnabled() const
+{
+    Q_D(const AppSettings);
+
+    return d->stallReportsEnabled;
+}
+
+void AppSettings::setStallReportsEnabled(bool enabled)
+{
+    Q_D(AppSettings);
+
+    d->stallReportsEnabled = enabled;
+    d->markDirty(GW_STALL_REPORTS_KEY);
+    emit stallReportsChanged(enabled);
 }
 
 Exporter *AppSettings::currentHtmlExporter() const
@@ -608,6 +1098,8 @@ void AppSettings::setCurrentHtmlExporter(Exporter *exporter)
     Q_D(AppSettings);
     
     d->currentHtmlExporter = exporter;
+    d->htmlExporterName = exporter->name();
+    d->markDirty(GW_LAST_USED_EXPORTER_KEY);
     emit currentHtmlExporterChanged(exporter);
 }
 
@@ -615,6 +1107,29 @@ AppSettings::AppSettings()
     : d_ptr(new AppSettingsPrivate())
 {
     Q_D(AppSettings);
+
+    d->storeTimer = new QTimer(this);
+    d->storeTimer->setSingleShot(true);
+    d->storeTimer->setInterval(AppSettingsPrivate::STORE_DELAY);
+
+    this->connect
+    (
+        d->storeTimer,
+        &QTimer::timeout,
+        [this]() {
+            store();
+        }
+    );
+
+    // Write any pending changes before the application exits.
+    this->connect
+    (
+        qApp,
+        &QCoreApplication::aboutToQuit,
+        [this]() {
+            store();
+        }
+    );
     
     QCoreApplication::setOrganizationName("ghostwriter");
     QCoreApplication::setApplicationName("ghostwriter");
@@ -744,6 +1259,7 @@ AppSettings::AppSettings()
     QSettings appSettings;
 
     d->autoSaveEnabled = appSettings.value(GW_AUTOSAVE_KEY, QVariant(true)).toBool();
+    d->autoSaveJournalEnabled = appSettings.value(GW_AUTOSAVE_JOURNAL_KEY, QVariant(false)).toBool();
     d->backupFileEnabled = appSettings.value(GW_BACKUP_FILE_KEY, QVariant(true)).toBool();
     d->editorFont.fromString(appSettings.value(GW_EDITOR_FONT_KEY, QVariant(monospaceFont)).toString());
     d->previewTextFont.fromString(appSettings.value(GW_PREVIEW_TEXT_FONT_KEY, QVariant(variableFont)).toString());
@@ -757,9 +1273,86 @@ AppSettings::AppSettings()
     d->insertSpacesForTabsEnabled = appSettings.value(GW_SPACES_FOR_TABS_KEY, QVariant(false)).toBool();
     d->useUnderlineForEmphasis = appSettings.value(GW_UNDERLINE_ITALICS_KEY, QVariant(false)).toBool();
     d->largeHeadingSizesEnabled = appSettings.value(GW_LARGE_HEADINGS_KEY, QVariant(true)).toBool();
+    d->largeDocumentModeEnabled = appSettings.value(GW_LARGE_DOCUMENT_MODE_KEY, QVariant(true)).toBool();
+    d->largeDocumentThreshold = appSettings.value(GW_LARGE_DOCUMENT_THRESHOLD_KEY, QVariant(DEFAULT_LARGE_DOCUMENT_THRESHOLD)).toInt();
+    d->hugeDocumentThreshold = appSettings.value(GW_HUGE_DOCUMENT_THRESHOLD_KEY, QVariant(DEFAULT_HUGE_DOCUMENT_THRESHOLD)).toInt();
+
+    if
+    (
+        (d->largeDocumentThreshold < MIN_LARGE_DOCUMENT_THRESHOLD)
+        || (d->largeDocumentThreshold > MAX_LARGE_DOCUMENT_THRESHOLD)
+    ) {
+        d->largeDocumentThreshold = DEFAULT_LARGE_DOCUMENT_THRESHOLD;
+    }
+
+    if
+    (
+        (d->hugeDocumentThreshold < MIN_LARGE_DOCUMENT_THRESHOLD)
+        || (d->hugeDocumentThreshold > MAX_LARGE_DOCUMENT_THRESHOLD)
+    ) {
+        d->hugeDocumentThreshold = DEFAULT_HUGE_DOCUMENT_THRESHOLD;
+    }
+
+    d->longLineThreshold = appSettings.value(GW_LONG_LINE_THRESHOLD_KEY, QVariant(DEFAULT_LONG_LINE_THRESHOLD)).toInt();
+
+    if
+    (
+        (d->longLineThreshold < MIN_LONG_LINE_THRESHOLD)
+        || (d->longLineThreshold > MAX_LONG_LINE_THRESHOLD)
+    ) {
+        d->longLineThreshold = DEFAULT_LONG_LINE_THRESHOLD;
+    }
+
+    d->gpuViewportEnabled = appSettings.value(GW_GPU_VIEWPORT_KEY, QVariant(false)).toBool();
+
+    d->previewIdleTimeout = appSettings.value(GW_PREVIEW_IDLE_TIMEOUT_KEY, QVariant(DEFAULT_PREVIEW_IDLE_TIMEOUT)).toInt();
+
+    if
+    (
+        (d->previewIdleTimeout < MIN_PREVIEW_IDLE_TIMEOUT)
+        || (d->previewIdleTimeout > MAX_PREVIEW_IDLE_TIMEOUT)
+    ) {
+        d->previewIdleTimeout = DEFAULT_PREVIEW_IDLE_TIMEOUT;
+    }
+
+    d->memoryCeiling = appSettings.value(GW_MEMORY_CEILING_KEY, QVariant(DEFAULT_MEMORY_CEILING)).toInt();
+
+    if
+    (
+        (d->memoryCeiling < MIN_MEMORY_CEILING)
+        || (d->memoryCeiling > MAX_MEMORY_CEILING)
+    ) {
+        d->memoryCeiling = DEFAULT_MEMORY_CEILING;
+    }
+
+    d->undoMemoryLimit = appSettings.value(GW_UNDO_MEMORY_LIMIT_KEY, QVariant(DEFAULT_UNDO_MEMORY_LIMIT)).toInt();
+
+    if
+    (
+        (d->undoMemoryLimit < MIN_UNDO_MEMORY_LIMIT)
+        || (d->undoMemoryLimit > MAX_UNDO_MEMORY_LIMIT)
+    ) {
+        d->undoMemoryLimit = DEFAULT_UNDO_MEMORY_LIMIT;
+    }
+
+    d->stallReportsEnabled = appSettings.value(GW_STALL_REPORTS_KEY, QVariant(true)).toBool();
+
     d->autoMatchEnabled = appSettings.value(GW_AUTO_MATCH_KEY, QVariant(true)).toBool();
     d->autoMatchedCharFilter = appSettings.value(GW_AUTO_MATCH_FILTER_KEY, QVariant("\"\'([{*_`<")).toString();
     d->bulletPointCyclingEnabled = appSettings.value(GW_BULLET_CYCLING_KEY, QVariant(true)).toBool();
+    d->wordCompletionEnabled = appSettings.value(GW_WORD_COMPLETION_KEY, QVariant(true)).toBool();
+    d->tableFormattingEnabled = appSettings.value(GW_TABLE_FORMATTING_KEY, QVariant(true)).toBool();
+    d->imageImportEnabled = appSettings.value(GW_IMAGE_IMPORT_KEY, QVariant(false)).toBool();
+    d->imageImportMaxWidth = appSettings.value(GW_IMAGE_IMPORT_MAX_WIDTH_KEY, QVariant(DEFAULT_IMAGE_IMPORT_MAX_WIDTH)).toInt();
+
+    if
+    (
+        (d->imageImportMaxWidth < MIN_IMAGE_IMPORT_MAX_WIDTH)
+        || (d->imageImportMaxWidth > MAX_IMAGE_IMPORT_MAX_WIDTH)
+    ) {
+        d->imageImportMaxWidth = DEFAULT_IMAGE_IMPORT_MAX_WIDTH;
+    }
+
     d->focusMode = (FocusMode) appSettings.value(GW_FOCUS_MODE_KEY, QVariant(FocusModeSentence)).toInt();
 
     if ((d->focusMode < FocusModeFirst) || (d->focusMode > FocusModeLast)) {
@@ -768,12 +1361,15 @@ AppSettings::AppSettings()
 
     d->hideMenuBarInFullScreenEnabled = appSettings.value(GW_HIDE_MENU_BAR_IN_FULL_SCREEN_KEY, QVariant(true)).toBool();
     d->fileHistoryEnabled = appSettings.value(GW_REMEMBER_FILE_HISTORY_KEY, QVariant(true)).toBool();
+    d->singleInstanceEnabled = appSettings.value(GW_SINGLE_INSTANCE_KEY, QVariant(false)).toBool();
     d->displayTimeInFullScreenEnabled = appSettings.value(GW_DISPLAY_TIME_IN_FULL_SCREEN_KEY, QVariant(true)).toBool();
     d->themeName = appSettings.value(GW_THEME_KEY, QVariant("Classic Light")).toString();
     d->darkModeEnabled = appSettings.value(GW_DARK_MODE_KEY, QVariant(true)).toBool();
     d->dictionaryLanguage = appSettings.value(GW_DICTIONARY_KEY, QLocale().name()).toString();
+    d->alternativeDictionaryLanguages = appSettings.value(GW_ALTERNATIVE_DICTIONARIES_KEY, QStringList()).toStringList();
 
     // Determine locale for dictionary language (for use in spell checking).
+    StartupProfiler::Scope dictionaryScope("Dictionaries");
     QString language = DictionaryManager::instance().availableDictionary(d->dictionaryLanguage);
 
     // If we have an available dictionary, then set the default dictionary language.
@@ -781,8 +1377,23 @@ AppSettings::AppSettings()
         DictionaryManager::instance().setDefaultLanguage(language);
     }
 
+    dictionaryScope.end();
+
     d->locale = appSettings.value(GW_LOCALE_KEY, QLocale().name()).toString();
     d->liveSpellCheckEnabled = appSettings.value(GW_LIVE_SPELL_CHECK_KEY, QVariant(true)).toBool();
+    d->lintEnabled = appSettings.value(GW_LINT_ENABLED_KEY, QVariant(false)).toBool();
+    d->lintLineLength = appSettings.value(GW_LINT_LINE_LENGTH_KEY, QVariant(DEFAULT_LINT_LINE_LENGTH)).toInt();
+
+    if
+    (
+        (d->lintLineLength < MIN_LINT_LINE_LENGTH)
+        || (d->lintLineLength > MAX_LINT_LINE_LENGTH)
+    ) {
+        d->lintLineLength = DEFAULT_LINT_LINE_LENGTH;
+    }
+
+    d->lintWebLinksEnabled = appSettings.value(GW_LINT_WEB_LINKS_KEY, QVariant(false)).toBool();
+    d->readabilityHighlightEnabled = appSettings.value(GW_READABILITY_HIGHLIGHT_KEY, QVariant(false)).toBool();
     d->editorWidth = (EditorWidth) appSettings.value(GW_EDITOR_WIDTH_KEY, QVariant(EditorWidthMedium)).toInt();
     d->interfaceStyle = (InterfaceStyle) appSettings.value(GW_INTERFACE_STYLE_KEY, QVariant(InterfaceStyleRounded)).toInt();
     d->italicizeBlockquotes = appSettings.value(GW_BLOCKQUOTE_STYLE_KEY, QVariant(false)).toBool();
@@ -798,12 +1409,43 @@ AppSettings::AppSettings()
     d->sidebarVisible = appSettings.value(GW_SIDEBAR_OPEN_KEY, QVariant(true)).toBool();
     d->htmlPreviewVisible = appSettings.value(GW_HTML_PREVIEW_OPEN_KEY, QVariant(true)).toBool();
 
-    QString exporterName = appSettings.value(GW_LAST_USED_EXPORTER_KEY).toString();
-    d->currentHtmlExporter = ExporterFactory::instance()->exporterByName(exporterName);
+    d->htmlExporterName = appSettings.value(GW_LAST_USED_EXPORTER_KEY).toString();
+    d->currentHtmlExporter = ExporterFactory::instance()->exporterByName(d->htmlExporterName);
 
     if (nullptr == d->currentHtmlExporter) {
         d->currentHtmlExporter = ExporterFactory::instance()->htmlExporters().first();
+
+        if (d->htmlExporterName.isEmpty()) {
+            d->htmlExporterName = d->currentHtmlExporter->name();
+        }
     }
+
+    // Switch to the exporter chosen by the user once its processor has
+    // been detected, or away from an exporter whose processor is gone.
+    // The user's choice is kept in the meantime.
+    //
+    this->connect
+    (
+        ExporterFactory::instance(),
+        &ExporterFactory::exportersChanged,
+        [this, d]() {
+            ExporterFactory *factory = ExporterFactory::instance();
+            Exporter *exporter = factory->exporterByName(d->htmlExporterName);
+
+            if (nullptr == exporter) {
+                if (factory->htmlExporters().contains(d->currentHtmlExporter)) {
+                    return;
+                }
+
+                exporter = factory->htmlExporters().first();
+            }
+
+            if (exporter != d->currentHtmlExporter) {
+                d->currentHtmlExporter = exporter;
+                emit currentHtmlExporterChanged(exporter);
+            }
+        }
+    );
 }
 
 QString AppSettingsPrivate::firstAvailableFont(const QStringList& fontList) const
@@ -843,4 +1485,13 @@ QString AppSettingsPrivate::firstAvailableFont(const QStringList& fontList) cons
     systemFont.setStyleHint(QFont::Monospace);
     return systemFont.family();
 }
+
+void AppSettingsPrivate::markDirty(const QString &key)
+{
+    dirtyKeys.insert(key);
+
+    if (!storeTimer->isActive()) {
+        storeTimer->start();
+    }
+}
 }
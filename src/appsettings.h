@@ -47,9 +47,56 @@ public:
     static const int MAX_TAB_WIDTH = 8;
     static const int DEFAULT_TAB_WIDTH = 4;
 
+    // Document sizes, in characters, at which large document mode scales
+    // back live features.
+    static const int MIN_LARGE_DOCUMENT_THRESHOLD = 100000;
+    static const int MAX_LARGE_DOCUMENT_THRESHOLD = 200000000;
+    static const int DEFAULT_LARGE_DOCUMENT_THRESHOLD = 1000000;
+    static const int DEFAULT_HUGE_DOCUMENT_THRESHOLD = 10000000;
+
+    // Line length, in characters, above which a line is neither
+    // highlighted nor spell checked.
+    static const int MIN_LONG_LINE_THRESHOLD = 1000;
+    static const int MAX_LONG_LINE_THRESHOLD = 10000000;
+    static const int DEFAULT_LONG_LINE_THRESHOLD = 20000;
+
+    // Time, in seconds, after which a hidden preview unloads its page.
+    static const int MIN_PREVIEW_IDLE_TIMEOUT = 10;
+    static const int MAX_PREVIEW_IDLE_TIMEOUT = 3600;
+    static const int DEFAULT_PREVIEW_IDLE_TIMEOUT = 60;
+
+    // Resident memory, in megabytes, above which caches are shed as under
+    // memory pressure.  Zero disables the ceiling.
+    static const int MIN_MEMORY_CEILING = 0;
+    static const int MAX_MEMORY_CEILING = 65536;
+    static const int DEFAULT_MEMORY_CEILING = 0;
+
+    // Estimated memory, in megabytes, that the undo history may hold
+    // before it is cleared.  Zero sets no limit.
+    static const int MIN_UNDO_MEMORY_LIMIT = 0;
+    static const int MAX_UNDO_MEMORY_LIMIT = 4096;
+    static const int DEFAULT_UNDO_MEMORY_LIMIT = 0;
+
+    // Maximum line length, in characters, checked by the style check.
+    // Zero sets no limit.
+    static const int MIN_LINT_LINE_LENGTH = 0;
+    static const int MAX_LINT_LINE_LENGTH = 1000;
+    static const int DEFAULT_LINT_LINE_LENGTH = 80;
+
+    // Width, in pixels, to which imported images are downscaled.  Zero
+    // imports images at full size.
+    static const int MIN_IMAGE_IMPORT_MAX_WIDTH = 0;
+    static const int MAX_IMAGE_IMPORT_MAX_WIDTH = 10000;
+    static const int DEFAULT_IMAGE_IMPORT_MAX_WIDTH = 0;
+
     static AppSettings *instance();
     ~AppSettings();
 
+    /**
+     * Writes the settings changed since they were last written to disk.
+     * Changes are otherwise written in batches, shortly after they are
+     * made, and when the application quits.
+     */
     void store();
 
     QString themeDirectoryPath() const;
@@ -60,6 +107,10 @@ public:
     Q_SLOT void setAutoSaveEnabled(bool enabled);
     Q_SIGNAL void autoSaveChanged(bool enabled);
 
+    bool autoSaveJournalEnabled() const;
+    Q_SLOT void setAutoSaveJournalEnabled(bool enabled);
+    Q_SIGNAL void autoSaveJournalChanged(bool enabled);
+
     bool backupFileEnabled() const;
     Q_SLOT void setBackupFileEnabled(bool enabled);
     Q_SIGNAL void backupFileChanged(bool enabled);
@@ -103,6 +154,22 @@ public:
     Q_SLOT void setBulletPointCyclingEnabled(bool enabled);
     Q_SIGNAL void bulletPointCyclingChanged(bool enabled);
 
+    bool wordCompletionEnabled() const;
+    Q_SLOT void setWordCompletionEnabled(bool enabled);
+    Q_SIGNAL void wordCompletionChanged(bool enabled);
+
+    bool tableFormattingEnabled() const;
+    Q_SLOT void setTableFormattingEnabled(bool enabled);
+    Q_SIGNAL void tableFormattingChanged(bool enabled);
+
+    bool imageImportEnabled() const;
+    Q_SLOT void setImageImportEnabled(bool enabled);
+    Q_SIGNAL void imageImportEnabledChanged(bool enabled);
+
+    int imageImportMaxWidth() const;
+    Q_SLOT void setImageImportMaxWidth(int pixels);
+    Q_SIGNAL void imageImportMaxWidthChanged(int pixels);
+
     FocusMode focusMode() const;
     void setFocusMode(FocusMode focusMode);
     Q_SIGNAL void focusModeChanged(FocusMode focusMode);
@@ -115,6 +182,14 @@ public:
     Q_SLOT void setFileHistoryEnabled(bool enabled);
     Q_SIGNAL void fileHistoryChanged(bool enabled);
 
+    /**
+     * Whether files opened while ghostwriter is already running are
+     * handed to the running instance rather than starting a new one.
+     */
+    bool singleInstanceEnabled() const;
+    Q_SLOT void setSingleInstanceEnabled(bool enabled);
+    Q_SIGNAL void singleInstanceChanged(bool enabled);
+
     bool displayTimeInFullScreenEnabled();
     Q_SLOT void setDisplayTimeInFullScreenEnabled(bool enabled);
     Q_SIGNAL void displayTimeInFullScreenChanged(bool enabled);
@@ -129,6 +204,15 @@ public:
     void setDictionaryLanguage(const QString &language);
     Q_SIGNAL void dictionaryLanguageChanged(const QString &language);
 
+    /**
+     * Languages, besides the dictionary language, in which paragraphs may
+     * be written.  Each paragraph is spell checked against whichever of
+     * the dictionaries recognizes the most of its words.
+     */
+    QStringList alternativeDictionaryLanguages() const;
+    void setAlternativeDictionaryLanguages(const QStringList &languages);
+    Q_SIGNAL void alternativeDictionaryLanguagesChanged(const QStringList &languages);
+
     QString locale() const;
     void setLocale(const QString &locale);
 
@@ -136,6 +220,22 @@ public:
     Q_SLOT void setLiveSpellCheckEnabled(bool enabled);
     Q_SIGNAL void liveSpellCheckChanged(bool enabled);
 
+    bool lintEnabled() const;
+    Q_SLOT void setLintEnabled(bool enabled);
+    Q_SIGNAL void lintEnabledChanged(bool enabled);
+
+    int lintLineLength() const;
+    Q_SLOT void setLintLineLength(int characters);
+    Q_SIGNAL void lintLineLengthChanged(int characters);
+
+    bool lintWebLinksEnabled() const;
+    Q_SLOT void setLintWebLinksEnabled(bool enabled);
+    Q_SIGNAL void lintWebLinksEnabledChanged(bool enabled);
+
+    bool readabilityHighlightEnabled() const;
+    Q_SLOT void setReadabilityHighlightEnabled(bool enabled);
+    Q_SIGNAL void readabilityHighlightEnabledChanged(bool enabled);
+
     EditorWidth editorWidth() const;
     void setEditorWidth(EditorWidth editorWidth);
     Q_SIGNAL void editorWidthChanged(EditorWidth editorWidth);
@@ -154,6 +254,42 @@ public:
     bool sidebarVisible() const;
     void setSidebarVisible(bool visible);
 
+    bool largeDocumentModeEnabled() const;
+    Q_SLOT void setLargeDocumentModeEnabled(bool enabled);
+    Q_SIGNAL void largeDocumentModeChanged(bool enabled);
+
+    int largeDocumentThreshold() const;
+    Q_SLOT void setLargeDocumentThreshold(int characters);
+    Q_SIGNAL void largeDocumentThresholdChanged(int characters);
+
+    int hugeDocumentThreshold() const;
+    Q_SLOT void setHugeDocumentThreshold(int characters);
+    Q_SIGNAL void hugeDocumentThresholdChanged(int characters);
+
+    int longLineThreshold() const;
+    Q_SLOT void setLongLineThreshold(int characters);
+    Q_SIGNAL void longLineThresholdChanged(int characters);
+
+    bool gpuViewportEnabled() const;
+    Q_SLOT void setGpuViewportEnabled(bool enabled);
+    Q_SIGNAL void gpuViewportChanged(bool enabled);
+
+    int previewIdleTimeout() const;
+    Q_SLOT void setPreviewIdleTimeout(int seconds);
+    Q_SIGNAL void previewIdleTimeoutChanged(int seconds);
+
+    int memoryCeiling() const;
+    Q_SLOT void setMemoryCeiling(int megabytes);
+    Q_SIGNAL void memoryCeilingChanged(int megabytes);
+
+    int undoMemoryLimit() const;
+    Q_SLOT void setUndoMemoryLimit(int megabytes);
+    Q_SIGNAL void undoMemoryLimitChanged(int megabytes);
+
+    bool stallReportsEnabled() const;
+    Q_SLOT void setStallReportsEnabled(bool enabled);
+    Q_SIGNAL void stallReportsChanged(bool enabled);
+
     Exporter *currentHtmlExporter() const;
     Q_SLOT void setCurrentHtmlExporter(Exporter *exporter);
     Q_SIGNAL void currentHtmlExporterChanged(Exporter *exporter);
@@ -0,0 +1,822 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QRegularExpression>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QUrl>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include "batchexporter.h"
+#include "cmarkgfmapi.h"
+#include "commandlineexporter.h"
+#include "exportcache.h"
+#include "exporter.h"
+#include "exporterfactory.h"
+#include "exportformat.h"
+#include "markdownast.h"
+#include "markdownnode.h"
+
+#define GW_LAST_EXPORTER_KEY "Export/lastUsedExporter"
+#define GW_SMART_TYPOGRAPHY_KEY "Export/smartTypographyEnabled"
+
+namespace ghostwriter
+{
+const QString BatchExporter::EXPORT_OPTION = "export";
+
+class BatchExporterPrivate
+{
+public:
+    BatchExporterPrivate()
+        : out(stdout), err(stderr)
+    {
+        ;
+    }
+
+    ~BatchExporterPrivate()
+    {
+        ;
+    }
+
+    // Exit codes of the application.
+    enum {
+        ExitSuccess = 0,
+        ExitExportFailed = 1,
+        ExitUsageError = 2
+    };
+
+    // Largest number of export commands run at once, unless the number of
+    // jobs is given on the command line.  Each command is a process of its
+    // own, which can take much more memory than exporting in-process.
+    static const int MaxProcesses = 4;
+
+    // Top-level heading of an exported file, for the index page.
+    typedef struct {
+        int level;
+        QString text;
+    } Heading;
+
+    // Result of exporting a single file.
+    typedef struct {
+        QString inputFilePath;
+        QString outputFilePath;
+        QString error;
+        qint64 elapsedTime;
+        bool upToDate;
+        QVector<Heading> headings;
+    } Result;
+
+    QTextStream out;
+    QTextStream err;
+
+    /*
+    * Returns the files matching the given paths, which may contain
+    * wildcards in their file names.  Paths to directories match the
+    * Markdown files within them and their subdirectories, which are added
+    * to folderFiles along with the directory given for them.  Paths
+    * matching no file are added to the unmatched list.
+    */
+    QStringList expandInputs
+    (
+        const QStringList &paths,
+        QHash<QString, QString> &folderFiles,
+        QStringList &unmatched
+    ) const;
+
+    /*
+    * Returns the supported format of the exporter with the given name,
+    * ignoring case, or nullptr if there is none.
+    */
+    const ExportFormat *findFormat
+    (
+        const Exporter *exporter,
+        const QString &name
+    ) const;
+
+    /*
+    * Returns the path of the file to which to export the given input file.
+    * The exported file is placed in the output directory if one is given,
+    * or else next to the input file.  Files found in a given folder keep
+    * their path relative to the folder within the output directory.
+    */
+    QString outputFilePath
+    (
+        const QString &inputFilePath,
+        const QString &folder,
+        const QString &outputDir,
+        const ExportFormat *format
+    ) const;
+
+    /*
+    * Writes an HTML page to the given path listing the top-level headings
+    * of each exported file, linked to the first file exported from it.
+    * Returns false if the page cannot be written.
+    */
+    bool writeIndex
+    (
+        const QString &indexFilePath,
+        const QList<QList<Result>> &results,
+        QString &error
+    ) const;
+
+    /*
+    * Exports the given file to each of the given formats, writing each
+    * to the output file path at the same index, and timing how long it
+    * takes.  The exports to all formats share the time taken.  Exports
+    * are skipped for output files that are up to date, unless force is
+    * true.  The headings of the file are gathered if indexed is true.
+    * This method is run on the thread pool.
+    */
+    static QList<Result> exportFile
+    (
+        Exporter *exporter,
+        const QList<const ExportFormat *> &formats,
+        const QString &inputFilePath,
+        const QStringList &outputFilePaths,
+        bool force,
+        bool indexed
+    );
+};
+
+BatchExporter::BatchExporter()
+    : d_ptr(new BatchExporterPrivate())
+{
+    ;
+}
+
+BatchExporter::~BatchExporter()
+{
+    ;
+}
+
+bool BatchExporter::isRequested(const QStringList &arguments)
+{
+    return arguments.contains(QString("--") + EXPORT_OPTION);
+}
+
+int BatchExporter::exec(const QStringList &arguments)
+{
+    Q_D(BatchExporter);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QObject::tr("Exports Markdown files without opening the editor."));
+    QCommandLineOption helpOption = parser.addHelpOption();
+
+    QCommandLineOption exportOption
+    (
+        EXPORT_OPTION,
+        QObject::tr("Export the given files, and exit.")
+    );
+    QCommandLineOption exporterOption
+    (
+        QStringList() << "e" << "exporter",
+        QObject::tr("Markdown processor to export with, as named in the "
+            "Export dialog.  Defaults to the one last used for export."),
+        QObject::tr("name")
+    );
+    QCommandLineOption formatOption
+    (
+        QStringList() << "f" << "format",
+        QObject::tr("Format to export to, as named in the Export dialog.  "
+            "Give more than once to export each file to several formats, "
+            "parsing it only once where the Markdown processor allows.  "
+            "Defaults to the first format of the Markdown processor."),
+        QObject::tr("format")
+    );
+    QCommandLineOption outputDirOption
+    (
+        QStringList() << "o" << "output-dir",
+        QObject::tr("Directory in which to write the exported files.  "
+            "Defaults to the directory of each input file."),
+        QObject::tr("directory")
+    );
+    QCommandLineOption jobsOption
+    (
+        QStringList() << "j" << "jobs",
+        QObject::tr("Number of files to export at once."),
+        QObject::tr("count")
+    );
+    QCommandLineOption smartTypographyOption
+    (
+        "smart-typography",
+        QObject::tr("Whether to use smart typography.  Defaults to the "
+            "setting last used for export."),
+        "on|off"
+    );
+    QCommandLineOption forceOption
+    (
+        "force",
+        QObject::tr("Export files even if they are up to date.")
+    );
+    QCommandLineOption indexOption
+    (
+        "index",
+        QObject::tr("HTML page to write listing the headings of every "
+            "exported file, linked to the exported files."),
+        QObject::tr("file")
+    );
+
+    parser.addOption(exportOption);
+    parser.addOption(exporterOption);
+    parser.addOption(formatOption);
+    parser.addOption(outputDirOption);
+    parser.addOption(jobsOption);
+    parser.addOption(smartTypographyOption);
+    parser.addOption(forceOption);
+    parser.addOption(indexOption);
+    parser.addPositionalArgument
+    (
+        "files",
+        QObject::tr("Markdown files to export.  File names may contain "
+            "wildcards.  Folders export every Markdown file within them, "
+            "keeping their layout in the output directory."),
+        "files..."
+    );
+
+    if (!parser.parse(arguments)) {
+        d->err << parser.errorText() << "\n";
+        return BatchExporterPrivate::ExitUsageError;
+    }
+
+    if (parser.isSet(helpOption)) {
+        parser.showHelp(BatchExporterPrivate::ExitSuccess);
+    }
+
+    ExporterFactory *factory = ExporterFactory::instance();
+
+    // Wait for the Markdown processors to be detected.  Detection finishes
+    // on this thread, so it cannot finish before the loop runs.
+    if (!factory->isDetectionFinished()) {
+        QEventLoop loop;
+        QObject::connect(factory, &ExporterFactory::detectionFinished, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    QSettings settings;
+    Exporter *exporter = nullptr;
+
+    if (parser.isSet(exporterOption)) {
+        exporter = factory->exporterByName(parser.value(exporterOption));
+
+        if (nullptr == exporter) {
+            QStringList names;
+
+            foreach (const Exporter *available, factory->fileExporters()) {
+                names.append(available->name());
+            }
+
+            d->err << QObject::tr("Unknown Markdown processor %1.  Available processors: %2")
+                .arg(parser.value(exporterOption))
+                .arg(names.join(", ")) << "\n";
+            return BatchExporterPrivate::ExitUsageError;
+        }
+    } else {
+        exporter = factory->exporterByName(settings.value(GW_LAST_EXPORTER_KEY).toString());
+
+        if (nullptr == exporter) {
+            exporter = factory->fileExporters().first();
+        }
+    }
+
+    QList<const ExportFormat *> formats;
+
+    foreach (const QString &name, parser.values(formatOption)) {
+        const ExportFormat *format = d->findFormat(exporter, name);
+
+        if (nullptr == format) {
+            QStringList names;
+
+            foreach (const ExportFormat *available, exporter->supportedFormats()) {
+                names.append(available->name());
+            }
+
+            d->err << QObject::tr("%1 cannot export to %2.  Available formats: %3")
+                .arg(exporter->name())
+                .arg(name)
+                .arg(names.join(", ")) << "\n";
+            return BatchExporterPrivate::ExitUsageError;
+        }
+
+        if (formats.contains(format)) {
+            continue;
+        }
+
+        // Formats sharing a file extension would overwrite each other.
+        foreach (const ExportFormat *other, formats) {
+            if (other->defaultFileExtension() == format->defaultFileExtension()) {
+                d->err << QObject::tr("%1 and %2 cannot both be exported, since both export to .%3 files.")
+                    .arg(other->name())
+                    .arg(format->name())
+                    .arg(format->defaultFileExtension()) << "\n";
+                return BatchExporterPrivate::ExitUsageError;
+            }
+        }
+
+        formats.append(format);
+    }
+
+    if (formats.isEmpty()) {
+        formats.append(exporter->supportedFormats().first());
+    }
+
+    bool smartTypographyEnabled = settings.value(GW_SMART_TYPOGRAPHY_KEY, true).toBool();
+
+    if (parser.isSet(smartTypographyOption)) {
+        QString value = parser.value(smartTypographyOption).toLower();
+
+        if ("on" == value) {
+            smartTypographyEnabled = true;
+        } else if ("off" == value) {
+            smartTypographyEnabled = false;
+        } else {
+            d->err << QObject::tr("Smart typography must be on or off.") << "\n";
+            return BatchExporterPrivate::ExitUsageError;
+        }
+    }
+
+    // Exporters in-process use the processor cores, while each export
+    // command is a process of its own.
+    //
+    int jobs = QThread::idealThreadCount();
+
+    if (nullptr != dynamic_cast<CommandLineExporter *>(exporter)) {
+        jobs = (jobs < BatchExporterPrivate::MaxProcesses)
+            ? jobs : BatchExporterPrivate::MaxProcesses;
+    }
+
+    if (parser.isSet(jobsOption)) {
+        bool ok = false;
+        jobs = parser.value(jobsOption).toInt(&ok);
+
+        if (!ok || (jobs < 1)) {
+            d->err << QObject::tr("The number of jobs must be a positive number.") << "\n";
+            return BatchExporterPrivate::ExitUsageError;
+        }
+    }
+
+    QString outputDir = parser.value(outputDirOption);
+
+    if (!outputDir.isEmpty() && !QDir().mkpath(outputDir)) {
+        d->err << QObject::tr("Could not create directory %1.").arg(outputDir) << "\n";
+        return BatchExporterPrivate::ExitUsageError;
+    }
+
+    QStringList unmatched;
+    QHash<QString, QString> folderFiles;
+    QStringList inputs = d->expandInputs(parser.positionalArguments(), folderFiles, unmatched);
+
+    foreach (const QString &path, unmatched) {
+        d->err << QObject::tr("No file matches %1.").arg(path) << "\n";
+    }
+
+    if (inputs.isEmpty()) {
+        d->err << QObject::tr("There are no files to export.") << "\n";
+        return BatchExporterPrivate::ExitUsageError;
+    }
+
+    exporter->setSmartTypographyEnabled(smartTypographyEnabled);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    QList<QFuture<QList<BatchExporterPrivate::Result>>> futures;
+    QString indexFilePath = parser.value(indexOption);
+
+    foreach (const QString &input, inputs) {
+        QStringList outputFilePaths;
+
+        foreach (const ExportFormat *format, formats) {
+            outputFilePaths.append
+            (
+                d->outputFilePath(input, folderFiles.value(input), outputDir, format)
+            );
+        }
+
+        QDir().mkpath(QFileInfo(outputFilePaths.first()).absolutePath());
+
+        futures.append
+        (
+            QtConcurrent::run
+            (
+                &pool,
+                &BatchExporterPrivate::exportFile,
+                exporter,
+                formats,
+                input,
+                outputFilePaths,
+                parser.isSet(forceOption),
+                !indexFilePath.isEmpty()
+            )
+        );
+    }
+
+    int failures = 0;
+    int upToDate = 0;
+    QStringList formatNames;
+    QList<QList<BatchExporterPrivate::Result>> allResults;
+
+    foreach (const ExportFormat *format, formats) {
+        formatNames.append(format->name());
+    }
+
+    // Report the files in the order given, as each finishes exporting.
+    foreach (QFuture<QList<BatchExporterPrivate::Result>> future, futures) {
+        // Keep the event loop running while waiting, since exports to PDF
+        // are printed on this thread.
+        //
+        if (!future.isFinished()) {
+            QFutureWatcher<QList<BatchExporterPrivate::Result>> watcher;
+            QEventLoop loop;
+
+            QObject::connect
+            (
+                &watcher,
+                &QFutureWatcherBase::finished,
+                &loop,
+                &QEventLoop::quit
+            );
+            watcher.setFuture(future);
+            loop.exec();
+        }
+
+        allResults.append(future.result());
+
+        foreach (const BatchExporterPrivate::Result &result, future.result()) {
+            if (result.upToDate) {
+                upToDate++;
+                d->out << QObject::tr("up to date") << "  "
+                    << result.inputFilePath << " -> " << result.outputFilePath << "\n";
+                d->out.flush();
+            } else if (result.error.isNull()) {
+                d->out << QString("%1 ms").arg(result.elapsedTime, 8) << "  "
+                    << result.inputFilePath << " -> " << result.outputFilePath << "\n";
+                d->out.flush();
+            } else {
+                failures++;
+                d->err << QObject::tr("Failed to export %1 to %2: %3")
+                    .arg(result.inputFilePath)
+                    .arg(result.outputFilePath)
+                    .arg(result.error.trimmed()) << "\n";
+                d->err.flush();
+            }
+        }
+    }
+
+    d->out << QObject::tr("Exported %1 of %2 files with %3 to %4 in %5 ms, %6 at a time.")
+        .arg(inputs.size() * formats.size() - failures - upToDate)
+        .arg(inputs.size() * formats.size())
+        .arg(exporter->name())
+        .arg(formatNames.join(", "))
+        .arg(totalTimer.elapsed())
+        .arg(jobs) << "\n";
+
+    if (upToDate > 0) {
+        d->out << QObject::tr("%1 files were already up to date.").arg(upToDate) << "\n";
+    }
+
+    d->out.flush();
+
+    if (!indexFilePath.isEmpty()) {
+        QString error;
+
+        if (!d->writeIndex(indexFilePath, allResults, error)) {
+            d->err << QObject::tr("Failed to write index %1: %2")
+                .arg(indexFilePath)
+                .arg(error) << "\n";
+            d->err.flush();
+            failures++;
+        }
+    }
+
+    if ((failures > 0) || !unmatched.isEmpty()) {
+        return BatchExporterPrivate::ExitExportFailed;
+    }
+
+    return BatchExporterPrivate::ExitSuccess;
+}
+
+QStringList BatchExporterPrivate::expandInputs
+(
+    const QStringList &paths,
+    QHash<QString, QString> &folderFiles,
+    QStringList &unmatched
+) const
+{
+    static const QStringList markdownFilters =
+    {
+        "*.md", "*.markdown", "*.mdown", "*.mkdn", "*.mkd",
+        "*.mdwn", "*.mdtxt", "*.mdtext", "*.Rmd"
+    };
+
+    QStringList files;
+
+    foreach (const QString &path, paths) {
+        QFileInfo pathInfo(path);
+        QString name = pathInfo.fileName();
+        int count = files.size();
+
+        if (pathInfo.isDir()) {
+            QString folder = pathInfo.absoluteFilePath();
+            QStringList folderMatches;
+            QDirIterator it
+            (
+                folder,
+                markdownFilters,
+                QDir::Files | QDir::Readable,
+                QDirIterator::Subdirectories
+            );
+
+            while (it.hasNext()) {
+                folderMatches.append(QFileInfo(it.next()).absoluteFilePath());
+            }
+
+            // Export in a stable order, whatever the order of the file
+            // system.
+            folderMatches.sort();
+
+            foreach (const QString &match, folderMatches) {
+                if (!folderFiles.contains(match)) {
+                    folderFiles.insert(match, folder);
+                }
+            }
+
+            files.append(folderMatches);
+        } else if (name.contains('*') || name.contains('?') || name.contains('[')) {
+            // Shells on some platforms leave wildcards for the program to
+            // expand.
+            QDir dir = pathInfo.dir();
+
+            foreach (const QString &match, dir.entryList(QStringList(name), QDir::Files, QDir::Name)) {
+                files.append(QFileInfo(dir.filePath(match)).absoluteFilePath());
+            }
+        } else if (pathInfo.isFile()) {
+            files.append(pathInfo.absoluteFilePath());
+        }
+
+        if (files.size() == count) {
+            unmatched.append(path);
+        }
+    }
+
+    files.removeDuplicates();
+    return files;
+}
+
+const ExportFormat *BatchExporterPrivate::findFormat
+(
+    const Exporter *exporter,
+    const QString &name
+) const
+{
+    foreach (const ExportFormat *format, exporter->supportedFormats()) {
+        if (0 == format->name().compare(name, Qt::CaseInsensitive)) {
+            return format;
+        }
+    }
+
+    return nullptr;
+}
+
+QString BatchExporterPrivate::outputFilePath
+(
+    const QString &inputFilePath,
+    const QString &folder,
+    const QString &outputDir,
+    const ExportFormat *format
+) const
+{
+    QFileInfo inputInfo(inputFilePath);
+    QDir dir(outputDir.isEmpty() ? inputInfo.absolutePath() : outputDir);
+    QString fileName = inputInfo.completeBaseName();
+
+    if (!outputDir.isEmpty() && !folder.isEmpty()) {
+        dir.setPath(dir.absoluteFilePath(QDir(folder).relativeFilePath(inputInfo.absolutePath())));
+    }
+
+    if (!format->defaultFileExtension().isEmpty()) {
+        fileName += "." + format->defaultFileExtension();
+    }
+
+    return QDir::cleanPath(dir.absoluteFilePath(fileName));
+}
+
+bool BatchExporterPrivate::writeIndex
+(
+    const QString &indexFilePath,
+    const QList<QList<Result>> &results,
+    QString &error
+) const
+{
+    QFile indexFile(indexFilePath);
+
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error = indexFile.errorString();
+        return false;
+    }
+
+    QDir indexDir = QFileInfo(indexFilePath).absoluteDir();
+    QTextStream stream(&indexFile);
+    stream.setCodec("UTF-8");
+
+    stream << "<html><head><meta http-equiv=\"Content-Type\" "
+        "content=\"text/html; charset=utf-8\" />"
+        "<title>" << QObject::tr("Index") << "</title></head><body>\n";
+
+    foreach (const QList<Result> &fileResults, results) {
+        const Result &result = fileResults.first();
+
+        QString link = QString::fromLatin1
+            (
+                QUrl::toPercentEncoding(indexDir.relativeFilePath(result.outputFilePath), "/")
+            );
+
+        stream << "<h2><a href=\"" << link << "\">"
+            << QFileInfo(result.inputFilePath).completeBaseName().toHtmlEscaped()
+            << "</a></h2>\n";
+
+        // Nest the lists of headings by level, closing a list for each
+        // level that a heading rises above.
+        QVector<int> levels;
+
+        foreach (const Heading &heading, result.headings) {
+            while (!levels.isEmpty() && (levels.last() > heading.level)) {
+                levels.removeLast();
+                stream << "</li></ul>";
+            }
+
+            if (levels.isEmpty() || (levels.last() < heading.level)) {
+                levels.append(heading.level);
+                stream << "<ul>";
+            } else {
+                stream << "</li>";
+            }
+
+            stream << "<li>" << heading.text.toHtmlEscaped();
+        }
+
+        for (int i = 0; i < levels.size(); i++) {
+            stream << "</li></ul>";
+        }
+
+        stream << "\n";
+    }
+
+    stream << "</body></html>\n";
+    stream.flush();
+    indexFile.close();
+
+    if (QFile::NoError != indexFile.error()) {
+        error = indexFile.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+QList<BatchExporterPrivate::Result> BatchExporterPrivate::exportFile
+(
+    Exporter *exporter,
+    const QList<const ExportFormat *> &formats,
+    const QString &inputFilePath,
+    const QStringList &outputFilePaths,
+    bool force,
+    bool indexed
+)
+{
+    QList<Result> results;
+    QElapsedTimer timer;
+
+    timer.start();
+
+    for (int i = 0; i < formats.size(); i++) {
+        Result result;
+        result.inputFilePath = inputFilePath;
+        result.outputFilePath = outputFilePaths[i];
+        result.upToDate = false;
+        results.append(result);
+    }
+
+    QFile inputFile(inputFilePath);
+    QString readError;
+    QString text;
+
+    if (inputFile.open(QIODevice::ReadOnly)) {
+        text = QString::fromUtf8(inputFile.readAll());
+        inputFile.close();
+    } else {
+        readError = inputFile.errorString();
+    }
+
+    // Export to all formats at once, so that the exporter can share
+    // work between them, leaving out those that would replace the input.
+    //
+    QList<const ExportFormat *> exportedFormats;
+    QStringList exportedFilePaths;
+
+    for (int i = 0; i < formats.size(); i++) {
+        if (!readError.isNull()) {
+            results[i].error = readError;
+        } else if (outputFilePaths[i] == inputFilePath) {
+            results[i].error = QObject::tr("The exported file would replace the input file.");
+        } else {
+            exportedFormats.append(formats[i]);
+            exportedFilePaths.append(outputFilePaths[i]);
+        }
+    }
+
+    if (!exportedFormats.isEmpty()) {
+        QStringList errors;
+        QList<bool> skipped =
+            ExportCache::exportToFiles
+            (
+                exporter,
+                exportedFormats,
+                inputFilePath,
+                text,
+                exportedFilePaths,
+                errors,
+                force
+            );
+
+        for (int i = 0, exported = 0; i < formats.size(); i++) {
+            if (results[i].error.isNull()) {
+                results[i].error = errors[exported];
+                results[i].upToDate = skipped[exported];
+                exported++;
+            }
+        }
+    }
+
+    QVector<Heading> headings;
+
+    if (indexed && readError.isNull()) {
+        QScopedPointer<MarkdownAST> ast
+        (
+            CmarkGfmAPI::instance()->parse(text, exporter->smartTypographyEnabled())
+        );
+        QStringList lines = text.split('\n');
+
+        foreach (const MarkdownNode *node, ast->headings()) {
+            int line = node->startLine() - 1;
+
+            if ((line < 0) || (line >= lines.size())) {
+                continue;
+            }
+
+            // Strip the markup of ATX headings, while setext headings are
+            // the text of their first line.
+            QString headingText = lines[line].trimmed();
+
+            if (node->isAtxHeading()) {
+                headingText.remove(QRegularExpression("^#+\\s*"));
+                headingText.remove(QRegularExpression("\\s+#+$"));
+            }
+
+            headings.append({ node->headingLevel(), headingText });
+        }
+    }
+
+    for (int i = 0; i < results.size(); i++) {
+        results[i].elapsedTime = timer.elapsed();
+        results[i].headings = headings;
+    }
+
+    return results;
+}
+} // namespace ghostwriter
@@ -0,0 +1,79 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef BATCH_EXPORTER_H
+#define BATCH_EXPORTER_H
+
+#include <QScopedPointer>
+#include <QStringList>
+
+namespace ghostwriter
+{
+/**
+ * Exports Markdown files without a user interface, for use from scripts.
+ * Files are exported in parallel with the same exporter and smart
+ * typography setting as last chosen in the Export dialog, unless
+ * overridden on the command line.  Exporters that run in-process export
+ * one file per processor core, while those launching a command are
+ * limited to a few processes at a time.  Whole folders can be exported
+ * as a static site, re-exporting only the files that changed since the
+ * last export and writing an index page of the headings of every file.
+ */
+class BatchExporterPrivate;
+class BatchExporter
+{
+    Q_DECLARE_PRIVATE(BatchExporter)
+
+public:
+    /**
+     * Name of the command line option that selects batch export.
+     */
+    static const QString EXPORT_OPTION;
+
+    /**
+     * Constructor.
+     */
+    BatchExporter();
+
+    /**
+     * Destructor.
+     */
+    ~BatchExporter();
+
+    /**
+     * Returns true if the given application arguments ask for batch
+     * export rather than for the editor.
+     */
+    static bool isRequested(const QStringList &arguments);
+
+    /**
+     * Exports the files given by the application arguments, printing a
+     * summary with the time taken by each file.  Input file names may
+     * contain wildcards.  Returns the exit code for the application,
+     * which is zero only if every file was exported.
+     */
+    int exec(const QStringList &arguments);
+
+private:
+    QScopedPointer<BatchExporterPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // BATCH_EXPORTER_H
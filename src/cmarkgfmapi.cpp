@@ -17,21 +17,278 @@
  *
  ***********************************************************************/
 
+#include <cstring>
+
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
 #include <QMutex>
+#include <QMutexLocker>
+#include <QThreadStorage>
+#include <QTextBlock>
+#include <QVector>
 
 #include "3rdparty/cmark-gfm/core/cmark-gfm-extension_api.h"
+#include "3rdparty/cmark-gfm/core/node.h"
 #include "3rdparty/cmark-gfm/extensions/cmark-gfm-core-extensions.h"
 
 #include "cmarkgfmapi.h"
+#include "htmlblockobserver.h"
+#include "utf8columnmap.h"
 
 namespace ghostwriter
 {
-class CmarkGfmAPIPrivate
+/*
+* Encodes text to UTF-8 into a fixed-size scratch buffer as it is appended,
+* feeding the buffer to a cmark-gfm parser each time it fills up.  This way,
+* large documents are never copied into another encoding in their entirety.
+* If given a column map, the feed also records in it how the UTF-8 columns
+* of each line correspond to the UTF-16 columns of the original text.
+*/
+class ParserFeed
 {
 public:
+    ParserFeed(cmark_parser *parser, Utf8ColumnMap *columns = nullptr);
+    ~ParserFeed();
+
+    void append(const QChar *text, int length);
+    void append(const QChar c);
+    void finish();
+
+private:
+    // Size of the scratch buffer, in bytes.
+    static const int BufferSize = 64 * 1024;
+
+    cmark_parser *parser;
+    Utf8ColumnMap *columns;
+    QByteArray buffer;
+    int used;
+
+    // A high surrogate from the end of the previously appended text, if
+    // any, whose low surrogate has yet to be appended.
+    QChar highSurrogate;
+
+    int asciiRunLength(const QChar *text, int length) const;
+    int encode(uint ucs4);
+    void reserve(int length);
+};
+
+ParserFeed::ParserFeed(cmark_parser *parser, Utf8ColumnMap *columns)
+    : parser(parser), columns(columns), used(0), highSurrogate(0)
+{
+    buffer.resize(BufferSize);
+}
+
+ParserFeed::~ParserFeed()
+{
+    finish();
+}
+
+void ParserFeed::append(const QChar *text, int length)
+{
+    int i = 0;
+
+    while (i < length) {
+        int run = 0;
+
+        if (highSurrogate.isNull()) {
+            run = asciiRunLength(text + i, length - i);
+        }
+
+        if (run <= 0) {
+            append(text[i]);
+            i++;
+            continue;
+        }
+
+        // ASCII is the same in UTF-8, so copy it straight into the buffer.
+        for (int copied = 0; copied < run;) {
+            reserve(1);
+
+            int count = qMin(run - copied, BufferSize - used);
+            char *out = buffer.data() + used;
+
+            for (int j = 0; j < count; j++) {
+                out[j] = (char) text[i + copied + j].unicode();
+            }
+
+            used += count;
+            copied += count;
+        }
+
+        if (nullptr != columns) {
+            columns->appendAscii(run);
+        }
+
+        i += run;
+    }
+}
+
+void ParserFeed::append(const QChar c)
+{
+    if (!highSurrogate.isNull()) {
+        QChar high = highSurrogate;
+        highSurrogate = QChar(0);
+
+        if (c.isLowSurrogate()) {
+            int bytes = encode(QChar::surrogateToUcs4(high, c));
+
+            if (nullptr != columns) {
+                columns->appendCharacter(2, bytes);
+            }
+
+            return;
+        }
+
+        int bytes = encode(QChar::ReplacementCharacter);
+
+        if (nullptr != columns) {
+            columns->appendCharacter(1, bytes);
+        }
+    }
+
+    if (c.isHighSurrogate()) {
+        highSurrogate = c;
+        return;
+    }
+
+    // Note:  cmark-gfm replaces null characters with the replacement
+    //        character itself, so do it here to keep the columns in sync.
+    uint ucs4 = c.unicode();
+
+    if (c.isLowSurrogate() || (0 == ucs4)) {
+        ucs4 = QChar::ReplacementCharacter;
+    }
+
+    int bytes = encode(ucs4);
+
+    if (nullptr == columns) {
+        return;
+    }
+
+    if ('\n' == c) {
+        columns->endLine();
+    } else {
+        columns->appendCharacter(1, bytes);
+    }
+}
+
+void ParserFeed::finish()
+{
+    if (!highSurrogate.isNull()) {
+        highSurrogate = QChar(0);
+        int bytes = encode(QChar::ReplacementCharacter);
+
+        if (nullptr != columns) {
+            columns->appendCharacter(1, bytes);
+        }
+    }
 
-    static CmarkGfmAPI *instance;
+    if (nullptr != columns) {
+        columns->finish();
+    }
 
+    if (used > 0) {
+        cmark_parser_feed(parser, buffer.constData(), used);
+        used = 0;
+    }
+}
+
+// Returns the number of characters at the start of the given text that are
+// ASCII, excluding line breaks and null characters, which need special
+// handling.  The characters are checked four at a time where possible.
+//
+int ParserFeed::asciiRunLength(const QChar *text, int length) const
+{
+    const quint64 nonAsciiMask = Q_UINT64_C(0xFF80FF80FF80FF80);
+    const quint64 lowBits = Q_UINT64_C(0x0001000100010001);
+    const quint64 highBits = Q_UINT64_C(0x8000800080008000);
+    const quint64 lineFeeds = Q_UINT64_C(0x000A000A000A000A);
+
+    int run = 0;
+
+    while ((run + 4) <= length) {
+        quint64 word;
+        memcpy(&word, text + run, sizeof(word));
+
+        quint64 xorLineFeeds = word ^ lineFeeds;
+
+        // Stop at any character that is non-ASCII, null, or a line feed.
+        // (A 16-bit lane x is zero when (x - 1) & ~x has its high bit set.)
+        if
+        (
+            (0 != (word & nonAsciiMask))
+            || (0 != ((word - lowBits) & ~word & highBits))
+            || (0 != ((xorLineFeeds - lowBits) & ~xorLineFeeds & highBits))
+        ) {
+            break;
+        }
+
+        run += 4;
+    }
+
+    while (run < length) {
+        ushort c = text[run].unicode();
+
+        if ((c >= 0x80) || (0 == c) || ('\n' == c)) {
+            break;
+        }
+
+        run++;
+    }
+
+    return run;
+}
+
+// Appends the UTF-8 encoding of the given character to the buffer,
+// returning the number of bytes it took.
+//
+int ParserFeed::encode(uint ucs4)
+{
+    // Make sure there is room for the longest possible UTF-8 sequence.
+    reserve(4);
+
+    char *out = buffer.data() + used;
+
+    if (ucs4 < 0x80) {
+        out[0] = (char) ucs4;
+        used += 1;
+        return 1;
+    } else if (ucs4 < 0x800) {
+        out[0] = (char) (0xC0 | (ucs4 >> 6));
+        out[1] = (char) (0x80 | (ucs4 & 0x3F));
+        used += 2;
+        return 2;
+    } else if (ucs4 < 0x10000) {
+        out[0] = (char) (0xE0 | (ucs4 >> 12));
+        out[1] = (char) (0x80 | ((ucs4 >> 6) & 0x3F));
+        out[2] = (char) (0x80 | (ucs4 & 0x3F));
+        used += 3;
+        return 3;
+    } else {
+        out[0] = (char) (0xF0 | (ucs4 >> 18));
+        out[1] = (char) (0x80 | ((ucs4 >> 12) & 0x3F));
+        out[2] = (char) (0x80 | ((ucs4 >> 6) & 0x3F));
+        out[3] = (char) (0x80 | (ucs4 & 0x3F));
+        used += 4;
+        return 4;
+    }
+}
+
+// Feeds the buffer to the parser if it doesn't have room for the given
+// number of bytes.
+//
+void ParserFeed::reserve(int length)
+{
+    if ((BufferSize - used) < length) {
+        cmark_parser_feed(parser, buffer.constData(), used);
+        used = 0;
+    }
+}
+
+class CmarkGfmAPIPrivate
+{
+public:
     CmarkGfmAPIPrivate()
     {
         ;
@@ -49,18 +306,440 @@ public:
     cmark_syntax_extension *tagfilterExt;
     cmark_syntax_extension *tasklistExt;
 
-    QMutex apiMutex;
+    // Parser with the extensions attached, kept by each thread for reuse.
+    // The parser itself and its list of extensions are allocated outside
+    // of the arena, while the state of each parse is allocated with the
+    // allocator of that parse.  State allocated from the arena is dropped
+    // when the arena is reset, so whether the state is in the arena is
+    // kept to know whether it must be freed before the next parse.
+    struct ParserTemplate
+    {
+        cmark_parser *parser;
+        bool stateInArena;
+
+        ~ParserTemplate()
+        {
+            cmark_parser_reuse
+            (
+                parser,
+                CMARK_OPT_DEFAULT,
+                cmark_get_default_mem_allocator(),
+                stateInArena ? 0 : 1
+            );
+            cmark_parser_free(parser);
+        }
+    };
+
+    QThreadStorage<ParserTemplate *> parserTemplates;
+
+    // HTML rendered for each top-level block during the last render for
+    // the preview, keyed by the block's source and context.  Guarded by blockCacheMutex, since
+    // renders can run on several threads.
+    QHash<QString, QString> blockCache;
+    QMutex blockCacheMutex;
+
+    int options(const bool smartTypographyEnabled) const;
+    cmark_parser *arenaParser(const int opts);
+    cmark_parser *reusableParser(const int opts, cmark_mem *mem);
+    cmark_parser *createParser(const int opts, cmark_mem *mem) const;
+
+    QString renderHtml
+    (
+        cmark_node *root,
+        const QString &text,
+        const int opts,
+        cmark_llist *extensions,
+        const bool sourceLinesEnabled,
+        const bool cacheUpdated
+    );
+    QString blockCacheKey
+    (
+        cmark_node *node,
+        cmark_node *next,
+        const QString &text,
+        const QVector<int> &lineStarts,
+        const int opts
+    ) const;
+    QString renderNode(cmark_node *node, const int opts, cmark_llist *extensions) const;
+    bool writeNode
+    (
+        QIODevice *device,
+        cmark_node *node,
+        const int opts,
+        cmark_llist *extensions,
+        bool &lineEnded
+    ) const;
+    void appendBlockHtml(QString &html, const QString &blockHtml) const;
+    QString annotateSourceLines(const QString &blockHtml, cmark_node *node) const;
 };
 
-CmarkGfmAPI *CmarkGfmAPIPrivate::instance = nullptr;
+int CmarkGfmAPIPrivate::options(const bool smartTypographyEnabled) const
+{
+    int opts = CMARK_OPT_DEFAULT | CMARK_OPT_FOOTNOTES | CMARK_OPT_UNSAFE;
 
-CmarkGfmAPI *CmarkGfmAPI::instance()
+    if (smartTypographyEnabled) {
+        opts |= CMARK_OPT_SMART;
+    }
+
+    return opts;
+}
+
+// Returns the calling thread's parser, ready to parse into the thread's
+// arena with the given options.  The parser is not to be freed, and the
+// arena is to be reset once done with the parse, before the parser is
+// used again.
+//
+cmark_parser *CmarkGfmAPIPrivate::arenaParser(const int opts)
 {
-    if (nullptr == CmarkGfmAPIPrivate::instance) {
-        CmarkGfmAPIPrivate::instance = new CmarkGfmAPI();
+    // Note:  The arena allocator is thread-local, so each thread parses
+    //        into its own arena.  Resetting it after parsing only frees the
+    //        memory for the calling thread, leaving parses on other threads
+    //        untouched.
+    //
+    return reusableParser(opts, cmark_get_arena_mem_allocator());
+}
+
+// Returns the calling thread's parser, ready to parse with the given
+// options into memory from the given allocator.  The parser is not to be
+// freed.
+//
+cmark_parser *CmarkGfmAPIPrivate::reusableParser(const int opts, cmark_mem *mem)
+{
+    if (!parserTemplates.hasLocalData()) {
+        ParserTemplate *parserTemplate = new ParserTemplate();
+        parserTemplate->parser = createParser(opts, cmark_get_default_mem_allocator());
+        parserTemplate->stateInArena = false;
+        parserTemplates.setLocalData(parserTemplate);
     }
 
-    return CmarkGfmAPIPrivate::instance;
+    ParserTemplate *parserTemplate = parserTemplates.localData();
+
+    cmark_parser_reuse
+    (
+        parserTemplate->parser,
+        opts,
+        mem,
+        parserTemplate->stateInArena ? 0 : 1
+    );
+    parserTemplate->stateInArena = (cmark_get_arena_mem_allocator() == mem);
+
+    return parserTemplate->parser;
+}
+
+cmark_parser *CmarkGfmAPIPrivate::createParser(const int opts, cmark_mem *mem) const
+{
+    cmark_parser *parser = cmark_parser_new_with_mem(opts, mem);
+
+    cmark_parser_attach_syntax_extension(parser, tableExt);
+    cmark_parser_attach_syntax_extension(parser, strikethroughExt);
+    cmark_parser_attach_syntax_extension(parser, autolinkExt);
+    cmark_parser_attach_syntax_extension(parser, tagfilterExt);
+    cmark_parser_attach_syntax_extension(parser, tasklistExt);
+
+    return parser;
+}
+
+// Renders the parsed document one top-level block at a time, reusing the
+// HTML from the previous render for blocks whose cache key is unchanged.
+// Footnote definitions, which cmark-gfm moves to the end of the document,
+// are numbered by their order of reference, and are always rendered
+// together, after which they are appended back to the document.  If
+// sourceLinesEnabled is true, the top-level elements are annotated with
+// the source lines they were rendered from.  If cacheUpdated is true, the
+// cache is replaced with the blocks of this render.  Otherwise, the cache
+// is only read, so that one-off renders of other text leave the blocks of
+// the preview in place.
+//
+QString CmarkGfmAPIPrivate::renderHtml
+(
+    cmark_node *root,
+    const QString &text,
+    const int opts,
+    cmark_llist *extensions,
+    const bool sourceLinesEnabled,
+    const bool cacheUpdated
+)
+{
+    QVector<int> lineStarts;
+    bool cacheable = true;
+
+    lineStarts.append(0);
+
+    for (int i = 0; i < text.length(); i++) {
+        if ('\n' == text[i]) {
+            lineStarts.append(i + 1);
+        } else if ('\r' == text[i]) {
+            // cmark-gfm also breaks lines at carriage returns, so line
+            // numbers would not match the ones counted here.
+            cacheable = false;
+            break;
+        }
+    }
+
+    QHash<QString, QString> usedBlocks;
+    QList<cmark_node *> footnotes;
+    QString html;
+
+    for (cmark_node *node = cmark_node_first_child(root); nullptr != node;) {
+        cmark_node *next = cmark_node_next(node);
+
+        if (CMARK_NODE_FOOTNOTE_DEFINITION == cmark_node_get_type(node)) {
+            footnotes.append(node);
+            node = next;
+            continue;
+        }
+
+        QString key;
+        QString blockHtml;
+        bool cached = false;
+
+        if (cacheable) {
+            key = blockCacheKey(node, next, text, lineStarts, opts);
+        }
+
+        if (!key.isNull()) {
+            QMutexLocker locker(&blockCacheMutex);
+            QHash<QString, QString>::const_iterator iter = blockCache.constFind(key);
+
+            if (iter != blockCache.constEnd()) {
+                blockHtml = iter.value();
+                cached = true;
+            }
+        }
+
+        if (!cached) {
+            blockHtml = renderNode(node, opts, extensions);
+        }
+
+        if (cacheUpdated && !key.isNull()) {
+            usedBlocks.insert(key, blockHtml);
+        }
+
+        // Annotate after caching, since moving a block changes its lines
+        // but not the rest of its HTML.
+        if (sourceLinesEnabled) {
+            blockHtml = annotateSourceLines(blockHtml, node);
+        }
+
+        appendBlockHtml(html, blockHtml);
+        node = next;
+    }
+
+    if (!footnotes.isEmpty()) {
+        // The footnotes can only be moved under a root allocated the same
+        // way as the document, since cmark-gfm refuses to reparent nodes
+        // across allocators.
+        //
+        cmark_node *footnotesRoot =
+            cmark_node_new_with_mem(CMARK_NODE_DOCUMENT, cmark_node_mem(root));
+
+        for (cmark_node *footnote : footnotes) {
+            cmark_node_append_child(footnotesRoot, footnote);
+        }
+
+        appendBlockHtml(html, renderNode(footnotesRoot, opts, extensions));
+
+        // Give the footnotes back, since the document may outlive this
+        // render if adopted by a MarkdownAST.
+        for (cmark_node *footnote : footnotes) {
+            cmark_node_append_child(root, footnote);
+        }
+
+        cmark_node_free(footnotesRoot);
+    }
+
+    // Keep only the blocks of this render so that the cache does not grow
+    // with every edit.
+    if (cacheUpdated) {
+        QMutexLocker locker(&blockCacheMutex);
+        blockCache.swap(usedBlocks);
+    }
+
+    return html;
+}
+
+// Returns the key under which to cache the HTML of the given top-level
+// block, or a null string if the block cannot be cached.  The key holds the
+// source from the block's first line up to the next block, which covers
+// any lines that cmark-gfm leaves out of the block's own range.  Since
+// reference links and footnote references are resolved from elsewhere in
+// the document, the key also holds their resolved destinations and
+// footnote numbers, which invalidates the block whenever these change.
+//
+QString CmarkGfmAPIPrivate::blockCacheKey
+(
+    cmark_node *node,
+    cmark_node *next,
+    const QString &text,
+    const QVector<int> &lineStarts,
+    const int opts
+) const
+{
+    int startLine = cmark_node_get_start_line(node);
+
+    if ((startLine < 1) || (startLine > lineStarts.size())) {
+        return QString();
+    }
+
+    int start = lineStarts[startLine - 1];
+    int end = text.length();
+
+    if
+    (
+        (nullptr != next)
+        && (CMARK_NODE_FOOTNOTE_DEFINITION != cmark_node_get_type(next))
+    ) {
+        int nextLine = cmark_node_get_start_line(next);
+
+        if ((nextLine > startLine) && (nextLine <= lineStarts.size())) {
+            end = lineStarts[nextLine - 1];
+        }
+    }
+
+    QString key = QString("%1:%2:").arg(opts).arg(cmark_node_get_type(node));
+    key += text.midRef(start, end - start);
+
+    cmark_iter *iter = cmark_iter_new(node);
+    cmark_event_type eventType;
+
+    while (CMARK_EVENT_DONE != (eventType = cmark_iter_next(iter))) {
+        cmark_node *current = cmark_iter_get_node(iter);
+
+        if (CMARK_EVENT_ENTER != eventType) {
+            continue;
+        }
+
+        switch (cmark_node_get_type(current)) {
+        case CMARK_NODE_LINK:
+        case CMARK_NODE_IMAGE:
+            key += QChar(0);
+            key += QString::fromUtf8(cmark_node_get_url(current));
+            key += QChar(0);
+            key += QString::fromUtf8(cmark_node_get_title(current));
+            break;
+        case CMARK_NODE_FOOTNOTE_REFERENCE:
+            key += QChar(0);
+            key += QString::fromUtf8(cmark_node_get_literal(current));
+            break;
+        default:
+            break;
+        }
+    }
+
+    cmark_iter_free(iter);
+    return key;
+}
+
+// Renders the given node and its children to HTML.  The HTML is rendered
+// into the arena, whatever the allocator of the node, so the arena must be
+// reset afterwards.
+//
+QString CmarkGfmAPIPrivate::renderNode
+(
+    cmark_node *node,
+    const int opts,
+    cmark_llist *extensions
+) const
+{
+    char *output = cmark_render_html_with_mem(node, opts, extensions, cmark_get_arena_mem_allocator());
+    return QString::fromUtf8(output);
+}
+
+// Renders the given node and its children to HTML, writing the HTML to the
+// device.  Since the arena never frees memory until reset, the HTML is
+// rendered into memory from the default allocator, which is freed as soon
+// as it is written.  The blocks are separated by a line break the same way
+// as in appendBlockHtml(), for which lineEnded keeps track of whether the
+// HTML written so far ends with a line break.
+//
+bool CmarkGfmAPIPrivate::writeNode
+(
+    QIODevice *device,
+    cmark_node *node,
+    const int opts,
+    cmark_llist *extensions,
+    bool &lineEnded
+) const
+{
+    cmark_mem *mem = cmark_get_default_mem_allocator();
+    char *output = cmark_render_html_with_mem(node, opts, extensions, mem);
+    qint64 length = (qint64) strlen(output);
+    bool ok = true;
+
+    if (length > 0) {
+        if (!lineEnded) {
+            ok = (1 == device->write("\n", 1));
+        }
+
+        ok = ok && (length == device->write(output, length));
+        lineEnded = ('\n' == output[length - 1]);
+    }
+
+    mem->free(output);
+    return ok;
+}
+
+// Appends a block's HTML to the document HTML, separating the two by a line
+// break the same way cmark-gfm does when rendering the whole document.
+//
+void CmarkGfmAPIPrivate::appendBlockHtml(QString &html, const QString &blockHtml) const
+{
+    if (!html.isEmpty() && !blockHtml.isEmpty() && !html.endsWith('\n')) {
+        html += '\n';
+    }
+
+    html += blockHtml;
+}
+
+// Adds the source lines attribute to the start tag at the beginning of the
+// given block's HTML.  Raw HTML blocks are left alone, since they need not
+// begin with a start tag.
+//
+QString CmarkGfmAPIPrivate::annotateSourceLines(const QString &blockHtml, cmark_node *node) const
+{
+    int firstLine = cmark_node_get_start_line(node);
+    int lastLine = cmark_node_get_end_line(node);
+
+    if
+    (
+        (CMARK_NODE_HTML_BLOCK == cmark_node_get_type(node))
+        || (firstLine < 1)
+        || (lastLine < firstLine)
+        || !blockHtml.startsWith('<')
+    ) {
+        return blockHtml;
+    }
+
+    int nameEnd = 1;
+
+    while ((nameEnd < blockHtml.length()) && blockHtml[nameEnd].isLetterOrNumber()) {
+        nameEnd++;
+    }
+
+    if (nameEnd <= 1) {
+        return blockHtml;
+    }
+
+    QString annotated = blockHtml;
+    annotated.insert
+    (
+        nameEnd,
+        QString(" %1=\"%2-%3\"")
+            .arg(HtmlBlockObserver::SOURCE_LINES_ATTR)
+            .arg(firstLine)
+            .arg(lastLine)
+    );
+
+    return annotated;
+}
+
+CmarkGfmAPI *CmarkGfmAPI::instance()
+{
+    // Function-local statics are initialized in a thread-safe manner,
+    // which matters since the first call can come from a worker thread.
+    static CmarkGfmAPI *instance = new CmarkGfmAPI();
+
+    return instance;
 }
 
 CmarkGfmAPI::~CmarkGfmAPI()
@@ -72,75 +751,199 @@ MarkdownAST *CmarkGfmAPI::parse(const QString &text, const bool smartTypographyE
 {
     Q_D(CmarkGfmAPI);
 
-    int opts = CMARK_OPT_DEFAULT | CMARK_OPT_FOOTNOTES | CMARK_OPT_UNSAFE;
+    // Parse with the default allocator rather than the arena so that the
+    // new AST can adopt the tree instead of copying it.
+    cmark_parser *parser =
+        d->reusableParser(d->options(smartTypographyEnabled), cmark_get_default_mem_allocator());
+    Utf8ColumnMap columns;
 
-    if (smartTypographyEnabled) {
-        opts |= CMARK_OPT_SMART;
+    {
+        ParserFeed feed(parser, &columns);
+        feed.append(text.constData(), text.length());
     }
 
-    d->apiMutex.lock();
+    MarkdownAST *ast = new MarkdownAST();
+    ast->adoptRoot(cmark_parser_finish(parser), &columns);
 
-    cmark_mem *mem = cmark_get_arena_mem_allocator();
-    cmark_parser *parser = cmark_parser_new_with_mem(opts, mem);
+    return ast;
+}
+
+void CmarkGfmAPI::parse(const QString &text, const bool smartTypographyEnabled, MarkdownAST *ast)
+{
+    Q_D(CmarkGfmAPI);
 
-    cmark_parser_attach_syntax_extension(parser, d->tableExt);
-    cmark_parser_attach_syntax_extension(parser, d->strikethroughExt);
-    cmark_parser_attach_syntax_extension(parser, d->autolinkExt);
-    cmark_parser_attach_syntax_extension(parser, d->tagfilterExt);
-    cmark_parser_attach_syntax_extension(parser, d->tasklistExt);
+    cmark_parser *parser = d->arenaParser(d->options(smartTypographyEnabled));
 
-    // Use Latin1 instead of UTF-8 since the column numbers and even
-    // the nodes returned in the AST are shifted or missing when
-    // UTF-8 characters longer than 1 byte are encountered.
-    //
-    cmark_parser_feed(parser, text.toLatin1().data(), text.length());
+    // cmark-gfm reports columns in UTF-8 bytes, so map them back to
+    // QString positions for the AST.
+    Utf8ColumnMap columns;
+
+    {
+        ParserFeed feed(parser, &columns);
+        feed.append(text.constData(), text.length());
+    }
 
     cmark_node *root = cmark_parser_finish(parser);
-    MarkdownAST *ast = new MarkdownAST(root);
-    cmark_parser_free(parser);
+    ast->setRoot(root, &columns);
     cmark_node_free(root);
     cmark_arena_reset();
+}
 
-    d->apiMutex.unlock();
+void CmarkGfmAPI::parse
+(
+    const QTextBlock &firstBlock,
+    const QTextBlock &lastBlock,
+    const bool smartTypographyEnabled,
+    MarkdownAST *ast
+)
+{
+    Q_D(CmarkGfmAPI);
 
-    return ast;
+    cmark_parser *parser = d->arenaParser(d->options(smartTypographyEnabled));
+
+    Utf8ColumnMap columns;
+
+    // Feed the blocks one at a time rather than first gathering them into
+    // one string.
+    {
+        ParserFeed feed(parser, &columns);
+
+        for (QTextBlock block = firstBlock; block.isValid(); block = block.next()) {
+            QString text = block.text();
+            feed.append(text.constData(), text.length());
+            feed.append(QChar('\n'));
+
+            if (block == lastBlock) {
+                break;
+            }
+        }
+    }
+
+    cmark_node *root = cmark_parser_finish(parser);
+    ast->setRoot(root, &columns);
+    cmark_node_free(root);
+    cmark_arena_reset();
 }
 
-QString CmarkGfmAPI::renderToHtml(const QString &text, const bool smartTypographyEnabled)
+MarkdownAST *CmarkGfmAPI::parseAndRenderHtml
+(
+    const QString &text,
+    const bool smartTypographyEnabled,
+    QString &html
+)
 {
     Q_D(CmarkGfmAPI);
-    
-    int opts = CMARK_OPT_DEFAULT | CMARK_OPT_FOOTNOTES | CMARK_OPT_UNSAFE;
 
-    if (smartTypographyEnabled) {
-        opts |= CMARK_OPT_SMART;
+    // Parse with the default allocator, as parse() does, so that the AST
+    // can adopt the tree.  Only the rendered HTML goes into the arena.
+    int opts = d->options(smartTypographyEnabled);
+    cmark_parser *parser = d->reusableParser(opts, cmark_get_default_mem_allocator());
+    Utf8ColumnMap columns;
+
+    {
+        ParserFeed feed(parser, &columns);
+        feed.append(text.constData(), text.length());
     }
 
-    d->apiMutex.lock();
+    cmark_node *root = cmark_parser_finish(parser);
 
-    cmark_mem *mem = cmark_get_arena_mem_allocator();
-    cmark_parser *parser = cmark_parser_new_with_mem(opts, mem);
+    // Build the AST first, since rendering moves the footnote definitions
+    // to the end of the document.
+    MarkdownAST *ast = new MarkdownAST();
+    ast->adoptRoot(root, &columns);
 
-    cmark_parser_attach_syntax_extension(parser, d->tableExt);
-    cmark_parser_attach_syntax_extension(parser, d->strikethroughExt);
-    cmark_parser_attach_syntax_extension(parser, d->autolinkExt);
-    cmark_parser_attach_syntax_extension(parser, d->tagfilterExt);
-    cmark_parser_attach_syntax_extension(parser, d->tasklistExt);
+    html = d->renderHtml(root, text, opts, cmark_parser_get_syntax_extensions(parser), true, true);
+    cmark_arena_reset();
 
-    cmark_parser_feed(parser, text.toUtf8().data(), text.length());
+    return ast;
+}
+
+QString CmarkGfmAPI::renderToHtml
+(
+    const QString &text,
+    const bool smartTypographyEnabled,
+    const bool cacheUpdated
+)
+{
+    Q_D(CmarkGfmAPI);
+
+    int opts = d->options(smartTypographyEnabled);
+    cmark_parser *parser = d->arenaParser(opts);
+
+    {
+        ParserFeed feed(parser);
+        feed.append(text.constData(), text.length());
+    }
 
     cmark_node *root = cmark_parser_finish(parser);
-    char *output = cmark_render_html(root, opts, cmark_parser_get_syntax_extensions(parser));
-    QString html = QString::fromUtf8(output);
+    QString html = d->renderHtml
+                   (
+                       root,
+                       text,
+                       opts,
+                       cmark_parser_get_syntax_extensions(parser),
+                       false,
+                       cacheUpdated
+                   );
 
-    cmark_parser_free(parser);
     cmark_arena_reset();
 
-    d->apiMutex.unlock();
-
     return html;
 }
 
+bool CmarkGfmAPI::renderToHtml
+(
+    const QString &text,
+    const bool smartTypographyEnabled,
+    QIODevice *device
+)
+{
+    Q_D(CmarkGfmAPI);
+
+    // Parse with the default allocator rather than the arena, so that the
+    // HTML of each block can be freed once written, and so that the arena
+    // of this thread is left alone.
+    //
+    cmark_mem *mem = cmark_get_default_mem_allocator();
+    int opts = d->options(smartTypographyEnabled);
+    cmark_parser *parser = d->createParser(opts, mem);
+
+    {
+        ParserFeed feed(parser);
+        feed.append(text.constData(), text.length());
+    }
+
+    cmark_node *root = cmark_parser_finish(parser);
+    cmark_llist *extensions = cmark_parser_get_syntax_extensions(parser);
+    cmark_node *footnotesRoot = cmark_node_new_with_mem(CMARK_NODE_DOCUMENT, mem);
+    bool lineEnded = true;
+    bool ok = true;
+
+    // Render the footnote definitions together at the end, as renderHtml()
+    // does.
+    for (cmark_node *node = cmark_node_first_child(root); ok && (nullptr != node);) {
+        cmark_node *next = cmark_node_next(node);
+
+        if (CMARK_NODE_FOOTNOTE_DEFINITION == cmark_node_get_type(node)) {
+            cmark_node_append_child(footnotesRoot, node);
+        } else {
+            ok = d->writeNode(device, node, opts, extensions, lineEnded);
+        }
+
+        node = next;
+    }
+
+    if (ok && (nullptr != cmark_node_first_child(footnotesRoot))) {
+        ok = d->writeNode(device, footnotesRoot, opts, extensions, lineEnded);
+    }
+
+    cmark_node_free(footnotesRoot);
+    cmark_node_free(root);
+    cmark_parser_free(parser);
+
+    return ok;
+}
+
 CmarkGfmAPI::CmarkGfmAPI()
     : d_ptr(new CmarkGfmAPIPrivate())
 {
@@ -24,10 +24,16 @@
 
 #include "markdownast.h"
 
+class QIODevice;
+class QTextBlock;
+
 namespace ghostwriter
 {
 /**
- * This class wraps the cmark-gfm API to make it thread-safe.
+ * This class wraps the cmark-gfm API to make it thread-safe.  Each thread
+ * that calls into this class parses with its own cmark-gfm memory arena,
+ * so that parsing and rendering on different threads (i.e., the editor,
+ * the live preview, and exports) can run in parallel without locking.
  */
 class CmarkGfmAPIPrivate;
 class CmarkGfmAPI
@@ -52,11 +58,78 @@ public:
      */
     MarkdownAST *parse(const QString &text, const bool smartTypographyEnabled);
 
+    /**
+     * Parses the given Markdown text into the given AST, replacing its
+     * previous contents.  Re-using the same AST between parses avoids
+     * reallocating the memory for its nodes each time.
+     */
+    void parse(const QString &text, const bool smartTypographyEnabled, MarkdownAST *ast);
+
+    /**
+     * Parses the text of the given range of text blocks (inclusive) into
+     * the given AST, replacing its previous contents.  The blocks' text is
+     * fed to the parser one block at a time, without first copying the text
+     * of the entire range.  Since QTextBlock is not thread-safe, only call
+     * this method from the GUI thread.
+     */
+    void parse
+    (
+        const QTextBlock &firstBlock,
+        const QTextBlock &lastBlock,
+        const bool smartTypographyEnabled,
+        MarkdownAST *ast
+    );
+
+    /**
+     * Parses the given Markdown text, returning an AST representation of
+     * the text, and setting the html parameter to the HTML rendered from
+     * the same parse.  Use this method when both are needed to avoid
+     * parsing the text twice.  Pass in true for smartTypographyEnabled to
+     * enable smart typography.  Since the HTML is meant for the Live HTML
+     * Preview, its top-level elements are annotated with the source lines
+     * from which they were rendered, for HtmlBlockObserver to take out.
+     */
+    MarkdownAST *parseAndRenderHtml
+    (
+        const QString &text,
+        const bool smartTypographyEnabled,
+        QString &html
+    );
+
     /**
      * Returns HTML text for the Markdown text.  Pass in true for
      * smartTypographyEnabled to enable smart typography.
+     *
+     * Both this method and parseAndRenderHtml() render the document one
+     * top-level block at a time, reusing the HTML of any block whose
+     * source and resolved links are unchanged since the previous render
+     * for the Live HTML Preview.  Pass in true for cacheUpdated only when
+     * rendering for the preview, since the blocks of this render then
+     * replace the cached ones.  One-off renders, such as for copying or
+     * exporting HTML, only read the cache.  parseAndRenderHtml() always
+     * updates the cache.
+     */
+    QString renderToHtml
+    (
+        const QString &text,
+        const bool smartTypographyEnabled,
+        const bool cacheUpdated = false
+    );
+
+    /**
+     * Renders the Markdown text to HTML, writing the HTML as UTF-8 to the
+     * given device one top-level block at a time.  Unlike the other render
+     * methods, the HTML of the whole document is never held in memory, and
+     * the cache of rendered blocks is neither used nor changed, which suits
+     * exporting large documents to a file.  Returns false if writing to
+     * the device failed.
      */
-    QString renderToHtml(const QString &text, const bool smartTypographyEnabled);
+    bool renderToHtml
+    (
+        const QString &text,
+        const bool smartTypographyEnabled,
+        QIODevice *device
+    );
 
 private:
     QScopedPointer<CmarkGfmAPIPrivate> d_ptr;
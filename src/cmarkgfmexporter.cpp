@@ -20,7 +20,6 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QObject>
-#include <QTextStream>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,12 +27,41 @@
 #include "cmarkgfmexporter.h"
 
 #include "cmarkgfmapi.h"
+#include "officedocumentwriter.h"
+#include "resourceinliner.h"
+#include "tracer.h"
+
+#ifndef GW_NO_WEBENGINE
+#include "pdfprinter.h"
+#endif
 
 namespace ghostwriter
 {
+// Specify the character set (UTF-8) for the HTML document.
+// Browsers typically can't tell if the HTML has unicode characters
+// unless UTF-8 is specified in the <head> section.
+//
+static const char HtmlHeader[] =
+    "<html><head><meta http-equiv=\"Content-Type\" "
+    "content=\"text/html; charset=utf-8\" />"
+    "<title></title></head><body>";
+
+static const char HtmlFooter[] = "</body></html>";
+
 CmarkGfmExporter::CmarkGfmExporter() : Exporter("cmark-gfm")
 {
     m_supportedFormats.append(ExportFormat::HTML);
+    m_supportedFormats.append(ExportFormat::HTML_SELF_CONTAINED);
+    m_supportedFormats.append(ExportFormat::DOCX);
+    m_supportedFormats.append(ExportFormat::ODT);
+
+#ifndef GW_NO_WEBENGINE
+    m_supportedFormats.append(ExportFormat::PDF);
+
+    // Create the printer on this thread, which is the main thread, since
+    // exports to PDF run on worker threads.
+    PdfPrinter::instance();
+#endif
 }
 
 CmarkGfmExporter::~CmarkGfmExporter()
@@ -46,6 +74,11 @@ void CmarkGfmExporter::exportToHtml(const QString &text, QString &html)
     html = CmarkGfmAPI::instance()->renderToHtml(text, this->m_smartTypographyEnabled);
 }
 
+void CmarkGfmExporter::exportToPreviewHtml(const QString &text, QString &html)
+{
+    html = CmarkGfmAPI::instance()->renderToHtml(text, this->m_smartTypographyEnabled, true);
+}
+
 void CmarkGfmExporter::exportToFile
 (
     const ExportFormat *format,
@@ -55,49 +88,136 @@ void CmarkGfmExporter::exportToFile
     QString &err
 )
 {
-    Q_UNUSED(inputFilePath);
+#ifndef GW_NO_WEBENGINE
+    if (ExportFormat::PDF == format) {
+        QString baseDir;
+
+        if (!inputFilePath.isEmpty()) {
+            baseDir = QFileInfo(inputFilePath).absolutePath();
+        }
+
+        PdfPrinter::instance()->print
+        (
+            CmarkGfmAPI::instance()->renderToHtml(text, this->m_smartTypographyEnabled),
+            baseDir,
+            outputFilePath,
+            this,
+            err
+        );
+        return;
+    }
+#endif
+
+    if (OfficeDocumentWriter::isFormatSupported(format)) {
+        OfficeDocumentWriter::write
+        (
+            format,
+            text,
+            this->m_smartTypographyEnabled,
+            outputFilePath,
+            err
+        );
+        return;
+    }
 
-    QString html;
+    bool selfContained = (ExportFormat::HTML_SELF_CONTAINED == format);
 
-    if (ExportFormat::HTML != format) {
+    if ((ExportFormat::HTML != format) && !selfContained) {
         err = QObject::tr("%1 format is unsupported by the cmark-gfm processor.")
               .arg(format->name());
         return;
     }
 
-    exportToHtml(text, html);
+    QFile outputFile(outputFilePath);
 
-    if (html.isNull()) {
-        err = QObject::tr("Export failed");
+    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err = outputFile.errorString();
         return;
     }
 
+    outputFile.write(HtmlHeader);
+
+    bool ok = true;
+
+    if (selfContained) {
+        // The files referenced by the HTML are embedded into it, which
+        // needs the whole HTML at once.
+        QString baseDir;
+
+        if (!inputFilePath.isEmpty()) {
+            baseDir = QFileInfo(inputFilePath).absolutePath();
+        }
+
+        outputFile.write
+        (
+            ResourceInliner::inlineResources
+            (
+                CmarkGfmAPI::instance()->renderToHtml(text, this->m_smartTypographyEnabled),
+                baseDir
+            ).toUtf8()
+        );
+    } else {
+        // Write the HTML straight to the file as it is rendered, so that the
+        // HTML of the whole document is never held in memory.
+        ok = CmarkGfmAPI::instance()->renderToHtml
+            (
+                text,
+                this->m_smartTypographyEnabled,
+                &outputFile
+            );
+    }
+
+    outputFile.write(HtmlFooter);
+
+    // Close the file, which writes out what is left in its buffer.
+    outputFile.close();
+
+    if (QFile::NoError != outputFile.error()) {
+        err = outputFile.errorString();
+    } else if (!ok) {
+        err = QObject::tr("Export failed");
+    }
+}
+
+bool CmarkGfmExporter::exportRenderedHtml
+(
+    const ExportFormat *format,
+    const QStringList &htmlBlocks,
+    const QString &outputFilePath,
+    QString &err
+)
+{
+    // Self-contained HTML and PDF need the files referenced by the HTML,
+    // which are looked up relative to the input file, so export those.
+    if (ExportFormat::HTML != format) {
+        return false;
+    }
+
+    GW_TRACE_SCOPE("CmarkGfmExporter::exportRenderedHtml");
+
     QFile outputFile(outputFilePath);
 
     if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
         err = outputFile.errorString();
-        return;
+        return true;
     }
 
-    // Write contents to disk.
-    QTextStream outStream(&outputFile);
+    outputFile.write(HtmlHeader);
 
-    // Specify the character set (UTF-8) for the HTML document.
-    // Browsers typically can't tell if the HTML has unicode characters
-    // unless UTF-8 is specified in the <head> section.
-    //
-    outStream << "<html><head><meta http-equiv=\"Content-Type\" "
-              "content=\"text/html; charset=utf-8\" />"
-              "<title></title></head><body>";
+    for (const QString &block : htmlBlocks) {
+        outputFile.write(block.toUtf8());
+        outputFile.write("\n");
+    }
 
-    outStream << html;
-    outStream << "</body></html>";
+    outputFile.write(HtmlFooter);
+    outputFile.close();
 
     if (QFile::NoError != outputFile.error()) {
         err = outputFile.errorString();
+    } else {
+        err = QString();
     }
 
-    // Close the file.  All done!
-    outputFile.close();
+    return true;
 }
 }
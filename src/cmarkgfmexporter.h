@@ -26,6 +26,10 @@ namespace ghostwriter
 {
 /**
  * Exports Markdown text to HTML via the built-in cmark-gfm processor.
+ * The HTML can also be printed to PDF in-process with PdfPrinter, except
+ * in builds without QtWebEngine (see GW_NO_WEBENGINE in core.pro).  Word
+ * and OpenDocument Text files are written in-process from the parsed
+ * Markdown with OfficeDocumentWriter.
  */
 class CmarkGfmExporter : public Exporter
 {
@@ -46,11 +50,20 @@ public:
      */
     void exportToHtml(const QString &text, QString &html);
 
+    /**
+     * Exports the given Markdown text to HTML for the Live HTML Preview,
+     * which, unlike exportToHtml(), keeps the rendered blocks cached for
+     * the preview's next update.
+     */
+    void exportToPreviewHtml(const QString &text, QString &html);
+
     /**
      * Exports the given Markdown text to the given export format and
      * output file path.  Sets err to a non-null string error message
-     * if the export fails.  Note that the only supported format for
-     * this exporter is HTML.
+     * if the export fails.  Note that the only supported formats for
+     * this exporter are HTML, PDF, DOCX and ODT.  Exports to
+     * self-contained HTML embed the images and style sheets referenced by
+     * the document.
      */
     void exportToFile
     (
@@ -60,6 +73,19 @@ public:
         const QString &outputFilePath,
         QString &err
     );
+
+    /**
+     * Writes HTML blocks already rendered from the text, such as by the
+     * Live HTML Preview, to an HTML file, wrapped as by exportToFile().
+     * Only plain HTML is supported.
+     */
+    bool exportRenderedHtml
+    (
+        const ExportFormat *format,
+        const QStringList &htmlBlocks,
+        const QString &outputFilePath,
+        QString &err
+    );
 };
 }
 
@@ -0,0 +1,335 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSharedPointer>
+
+#include "codelexer.h"
+
+namespace ghostwriter
+{
+// Lexer states beyond the initial one.  The states from
+// MultilineStringState on are within the multiline string having the
+// corresponding delimiter.
+static const int BlockCommentState = 1;
+static const int MultilineStringState = 2;
+
+// Resource holding the table of languages, which is shared with the
+// preview's code highlighter.
+static const char *LanguagesResource = ":/resources/codelanguages.json";
+
+static QStringList toStringList(const QJsonValue &value)
+{
+    QStringList list;
+
+    for (const QJsonValue &item : value.toArray()) {
+        list.append(item.toString());
+    }
+
+    return list;
+}
+
+const CodeLexer *CodeLexer::forLanguage(const QStringRef &language)
+{
+    if (language.isEmpty()) {
+        return nullptr;
+    }
+
+    static const QVector<QSharedPointer<const CodeLexer>> lexers = []() {
+        QVector<QSharedPointer<const CodeLexer>> lexers;
+        QFile file(LanguagesResource);
+
+        if (!file.open(QFile::ReadOnly)) {
+            qWarning() << "Could not read" << LanguagesResource;
+            return lexers;
+        }
+
+        QJsonArray languages = QJsonDocument::fromJson(file.readAll()).array();
+
+        for (const QJsonValue &language : languages) {
+            lexers.append(QSharedPointer<const CodeLexer>(new CodeLexer(language.toObject())));
+        }
+
+        return lexers;
+    }();
+
+    // Index the lexers by each of their names.
+    static const QHash<QString, const CodeLexer *> index = []() {
+        QHash<QString, const CodeLexer *> index;
+
+        for (const QSharedPointer<const CodeLexer> &lexer : lexers) {
+            for (const QString &name : lexer->names) {
+                index.insert(name, lexer.data());
+            }
+        }
+
+        return index;
+    }();
+
+    return index.value(language.toString().toLower(), nullptr);
+}
+
+CodeLexer::CodeLexer(const QJsonObject &language)
+    : names(toStringList(language["names"])),
+      lineComments(toStringList(language["lineComments"])),
+      blockCommentStart(language["blockCommentStart"].toString()),
+      blockCommentEnd(language["blockCommentEnd"].toString()),
+      quotes(language["quotes"].toString()),
+      multilineQuotes(toStringList(language["multilineQuotes"])),
+      directive(language["directive"].toString().value(0)),
+      caseInsensitive(language["caseInsensitive"].toBool())
+{
+    // Keep the keywords sorted for binary searches, which need no copy of
+    // the word looked up.
+    for (const QString &keyword : toStringList(language["keywords"])) {
+        keywords.append(caseInsensitive ? keyword.toLower() : keyword);
+    }
+
+    Qt::CaseSensitivity sensitivity = caseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive;
+
+    std::sort
+    (
+        keywords.begin(),
+        keywords.end(),
+        [sensitivity](const QString &a, const QString &b) {
+            return QString::compare(a, b, sensitivity) < 0;
+        }
+    );
+
+    // Stay within the states that the highlighter can carry over.
+    while ((MultilineStringState + multilineQuotes.size()) > (MaxState + 1)) {
+        multilineQuotes.removeLast();
+    }
+}
+
+int CodeLexer::lex
+(
+    const QString &text,
+    int start,
+    int state,
+    QVector<Token> &tokens
+) const
+{
+    int length = text.length();
+    int i = qMax(0, start);
+
+    if (BlockCommentState == state) {
+        int end = blockCommentEnd.isEmpty() ? -1 : text.indexOf(blockCommentEnd, i);
+
+        if (end < 0) {
+            tokens.append({i, length - i, Comment});
+            return state;
+        }
+
+        end += blockCommentEnd.length();
+        tokens.append({i, end - i, Comment});
+        i = end;
+    } else if (state >= MultilineStringState) {
+        int delimiter = state - MultilineStringState;
+
+        if (delimiter < multilineQuotes.size()) {
+            int end = findClosing(text, i, multilineQuotes.at(delimiter));
+
+            if (end < 0) {
+                tokens.append({i, length - i, String});
+                return state;
+            }
+
+            tokens.append({i, end - i, String});
+            i = end;
+        }
+    }
+
+    int firstNonSpace = i;
+
+    while ((firstNonSpace < length) && text.at(firstNonSpace).isSpace()) {
+        firstNonSpace++;
+    }
+
+    while (i < length) {
+        QChar c = text.at(i);
+
+        if (c.isSpace()) {
+            i++;
+            continue;
+        }
+
+        // Directives, such as preprocessor lines, take the whole line, and
+        // annotations, such as Python decorators, the name that follows.
+        if ((i == firstNonSpace) && !directive.isNull() && (directive == c)) {
+            if ('#' == c) {
+                tokens.append({i, length - i, Directive});
+                return InitialState;
+            }
+
+            int end = i + 1;
+
+            while ((end < length) && (text.at(end).isLetterOrNumber() || ('_' == text.at(end)) || ('.' == text.at(end)))) {
+                end++;
+            }
+
+            tokens.append({i, end - i, Directive});
+            i = end;
+            continue;
+        }
+
+        // Block comments go first, as they may begin with a line comment,
+        // as in Lua.
+        if (!blockCommentStart.isEmpty() && (text.midRef(i, blockCommentStart.length()) == blockCommentStart)) {
+            int end = text.indexOf(blockCommentEnd, i + blockCommentStart.length());
+
+            if (end < 0) {
+                tokens.append({i, length - i, Comment});
+                return BlockCommentState;
+            }
+
+            end += blockCommentEnd.length();
+            tokens.append({i, end - i, Comment});
+            i = end;
+            continue;
+        }
+
+        for (const QString &lineComment : lineComments) {
+            if (text.midRef(i, lineComment.length()) == lineComment) {
+                tokens.append({i, length - i, Comment});
+                return InitialState;
+            }
+        }
+
+        bool matched = false;
+
+        for (int q = 0; q < multilineQuotes.size(); q++) {
+            const QString &delimiter = multilineQuotes.at(q);
+
+            if (text.midRef(i, delimiter.length()) == delimiter) {
+                int end = findClosing(text, i + delimiter.length(), delimiter);
+
+                if (end < 0) {
+                    tokens.append({i, length - i, String});
+                    return MultilineStringState + q;
+                }
+
+                tokens.append({i, end - i, String});
+                i = end;
+                matched = true;
+                break;
+            }
+        }
+
+        if (matched) {
+            continue;
+        }
+
+        if (quotes.contains(c)) {
+            // Strings left open at the end of the line end there.
+            int end = findClosing(text, i + 1, QString(c));
+
+            if (end < 0) {
+                end = length;
+            }
+
+            tokens.append({i, end - i, String});
+            i = end;
+            continue;
+        }
+
+        bool afterWord = (i > 0)
+            && (text.at(i - 1).isLetterOrNumber() || ('_' == text.at(i - 1)));
+
+        if
+        (
+            !afterWord
+            && (
+                c.isDigit()
+                || (('.' == c) && ((i + 1) < length) && text.at(i + 1).isDigit())
+            )
+        ) {
+            int end = i + 1;
+
+            while
+            (
+                (end < length)
+                && (text.at(end).isLetterOrNumber() || ('.' == text.at(end)) || ('_' == text.at(end)))
+            ) {
+                end++;
+            }
+
+            tokens.append({i, end - i, Number});
+            i = end;
+            continue;
+        }
+
+        if (c.isLetter() || ('_' == c)) {
+            int end = i + 1;
+
+            while ((end < length) && (text.at(end).isLetterOrNumber() || ('_' == text.at(end)))) {
+                end++;
+            }
+
+            if (!afterWord && isKeyword(text.midRef(i, end - i))) {
+                tokens.append({i, end - i, Keyword});
+            }
+
+            i = end;
+            continue;
+        }
+
+        i++;
+    }
+
+    return InitialState;
+}
+
+bool CodeLexer::isKeyword(const QStringRef &word) const
+{
+    Qt::CaseSensitivity sensitivity = caseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive;
+
+    auto it = std::lower_bound
+        (
+            keywords.constBegin(),
+            keywords.constEnd(),
+            word,
+            [sensitivity](const QString &keyword, const QStringRef &word) {
+                return QStringRef::compare(word, keyword, sensitivity) > 0;
+            }
+        );
+
+    return (it != keywords.constEnd())
+        && (0 == QStringRef::compare(word, *it, sensitivity));
+}
+
+int CodeLexer::findClosing(const QString &text, int from, const QString &delimiter)
+{
+    for (int i = from; i < text.length(); i++) {
+        if ('\\' == text.at(i)) {
+            i++;
+        } else if (text.midRef(i, delimiter.length()) == delimiter) {
+            return i + delimiter.length();
+        }
+    }
+
+    return -1;
+}
+} // namespace ghostwriter
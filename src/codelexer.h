@@ -0,0 +1,114 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef CODE_LEXER_H
+#define CODE_LEXER_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QStringRef>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Splits the lines of the code of a fenced code block into the tokens to
+ * color in the editor, for the language named in the block's info string.
+ *
+ * Lexers are table driven, one per language, and are built once, the first
+ * time any is requested, from the table of languages in the
+ * resources/codelanguages.json resource.  The live preview highlights
+ * code with the same table, so that both color code alike.  A line is lexed on its own, given the state in
+ * which the previous line left the lexer, such as within a block comment,
+ * so that editing a line only needs that line lexed again, along with the
+ * lines that follow it if its end state changed.
+ *
+ * Lexers are immutable, and may be used from any thread.
+ */
+class CodeLexer
+{
+public:
+    typedef enum
+    {
+        Keyword,
+        String,
+        Number,
+        Comment,
+        Directive
+    } TokenType;
+
+    struct Token
+    {
+        int start;
+        int length;
+        TokenType type;
+    };
+
+    /**
+     * State of the lexer at the start of the first line of code.  States
+     * fit in MaxState.
+     */
+    static const int InitialState = 0;
+    static const int MaxState = 15;
+
+    /**
+     * Returns the lexer for the language with the given name or alias,
+     * such as "cpp" or "python", or nullptr if there is none.
+     */
+    static const CodeLexer *forLanguage(const QStringRef &language);
+
+    /**
+     * Appends the tokens of the given line of code, starting at the given
+     * position, to the given tokens, and returns the state in which the
+     * line leaves the lexer.  The state passed in is that returned for
+     * the previous line.
+     */
+    int lex
+    (
+        const QString &text,
+        int start,
+        int state,
+        QVector<Token> &tokens
+    ) const;
+
+private:
+    QStringList names;
+    QVector<QString> keywords;
+    QStringList lineComments;
+    QString blockCommentStart;
+    QString blockCommentEnd;
+    QString quotes;
+    QStringList multilineQuotes;
+    QChar directive;
+    bool caseInsensitive;
+
+    CodeLexer(const QJsonObject &language);
+
+    bool isKeyword(const QStringRef &word) const;
+
+    /*
+    * Returns the position just past the given closing delimiter, skipping
+    * escaped characters, or -1 if the line does not close it.
+    */
+    static int findClosing(const QString &text, int from, const QString &delimiter);
+};
+} // namespace ghostwriter
+
+#endif // CODE_LEXER_H
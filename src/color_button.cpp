@@ -67,9 +67,17 @@ void ColorButton::setColor(const QColor &color)
 
 void ColorButton::onClicked()
 {
-    QColor color = QColorDialog::getColor(m_color, this);
-    if (color.isValid()) {
-        setColor(color);
+    // Report each color as the user drags through the dialog so that it can
+    // be previewed live, and report the original color again if the user
+    // cancels so that the preview can be reverted.
+    QColor original = m_color;
+    QColorDialog dialog(m_color, this);
+    connect(&dialog, SIGNAL(currentColorChanged(QColor)), this, SIGNAL(previewed(QColor)));
+
+    if ((QDialog::Accepted == dialog.exec()) && dialog.selectedColor().isValid()) {
+        setColor(dialog.selectedColor());
+    } else {
+        emit previewed(original);
     }
 }
 
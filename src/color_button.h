@@ -35,6 +35,7 @@ public:
 
 signals:
     void changed(const QColor &color);
+    void previewed(const QColor &color);
 
 public slots:
     void setColor(const QColor &color);
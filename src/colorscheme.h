@@ -43,6 +43,33 @@ typedef struct ColorScheme {
     QColor codeText;
     QColor codeMarkup;
     QColor error;
+
+    bool operator==(const struct ColorScheme &other) const
+    {
+        return (foreground == other.foreground)
+            && (background == other.background)
+            && (selection == other.selection)
+            && (cursor == other.cursor)
+            && (link == other.link)
+            && (image == other.image)
+            && (inlineHtml == other.inlineHtml)
+            && (headingText == other.headingText)
+            && (headingMarkup == other.headingMarkup)
+            && (emphasisText == other.emphasisText)
+            && (emphasisMarkup == other.emphasisMarkup)
+            && (blockquoteText == other.blockquoteText)
+            && (blockquoteMarkup == other.blockquoteMarkup)
+            && (divider == other.divider)
+            && (listMarkup == other.listMarkup)
+            && (codeText == other.codeText)
+            && (codeMarkup == other.codeMarkup)
+            && (error == other.error);
+    }
+
+    bool operator!=(const struct ColorScheme &other) const
+    {
+        return !(*this == other);
+    }
 } ColorScheme;
 } // namespace ghostwriter
 
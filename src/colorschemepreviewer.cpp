@@ -18,14 +18,20 @@
  *
  ***********************************************************************/
 
-#include <QCommonStyle>
-#include <QDebug>
+#include <QAbstractTextDocumentLayout>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFontDatabase>
+#include <QFutureInterface>
 #include <QPainter>
 #include <QPixmap>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QStaticText>
-#include <QTextEdit>
+#include <QTextDocument>
 
 #include "colorschemepreviewer.h"
+#include "taskscheduler.h"
 #include "3rdparty/QtAwesome/QtAwesome.h"
 
 namespace ghostwriter
@@ -34,12 +40,13 @@ namespace ghostwriter
 class ColorSchemePreviewerPrivate
 {
 public:
+    // Version of the preview rendering, to be incremented whenever the
+    // previews change, so that stale cached previews are not shown.
+    static const int RENDER_VERSION = 1;
+
     ColorSchemePreviewerPrivate()
     {
-        if (nullptr == this->awesome) {
-            this->awesome = new QtAwesome();
-            this->awesome->initFontAwesome();
-        }
+        initAwesome();
     }
 
     ~ColorSchemePreviewerPrivate()
@@ -50,6 +57,61 @@ public:
     static QtAwesome *awesome;
     QIcon thumbnailPreviewIcon;
     static const QString loremIpsum;
+
+    /*
+    * Loads the icon font, if not done already.  Must be called from the
+    * main thread.
+    */
+    static void initAwesome();
+
+    /*
+    * Renders the preview into an image.  This does not use any widgets,
+    * so that it can run on the thread pool.
+    */
+    static QImage render
+    (
+        const ColorScheme &colors,
+        bool builtIn,
+        bool valid,
+        int width,
+        int height,
+        qreal dpr,
+        const QFont &symbolFont
+    );
+
+    /*
+    * Parameters of a preview to render in the background.
+    */
+    struct Request
+    {
+        ColorScheme colors;
+        bool builtIn;
+        bool valid;
+        int width;
+        int height;
+        qreal dpr;
+        QFont symbolFont;
+        QString cacheFilePath;
+    };
+
+    /*
+    * Reads the requested preview from the disk cache, rendering it and
+    * adding it to the cache if it is not there.
+    */
+    static QImage renderCached(const Request &request);
+
+    /*
+    * Returns the path of the disk cache file for the given preview.
+    */
+    static QString cacheFilePath
+    (
+        const ColorScheme &colors,
+        bool builtIn,
+        bool valid,
+        int width,
+        int height,
+        qreal dpr
+    );
 };
 
 QtAwesome *ColorSchemePreviewerPrivate::awesome = nullptr;
@@ -87,10 +149,104 @@ ColorSchemePreviewer::ColorSchemePreviewer
     int height,
     qreal dpr
 ) : d_ptr(new ColorSchemePreviewerPrivate())
+{
+    Q_D(ColorSchemePreviewer);
+
+    QImage thumbnail = d->render
+    (
+        colors,
+        builtIn,
+        valid,
+        width,
+        height,
+        dpr,
+        d->awesome->font(style::stfas, 16)
+    );
+
+    d->thumbnailPreviewIcon = QPixmap::fromImage(thumbnail);
+}
+
+ColorSchemePreviewer::~ColorSchemePreviewer()
+{
+    ;
+}
+
+QIcon ColorSchemePreviewer::icon()
 {
     Q_D(ColorSchemePreviewer);
     
-    QString text = d->loremIpsum;
+    return d->thumbnailPreviewIcon;
+}
+QFuture<QImage> ColorSchemePreviewer::renderAsync
+(
+    const ColorScheme &colors,
+    bool builtIn,
+    bool valid,
+    int width,
+    int height,
+    qreal dpr
+)
+{
+    ColorSchemePreviewerPrivate::initAwesome();
+
+    ColorSchemePreviewerPrivate::Request request;
+    request.colors = colors;
+    request.builtIn = builtIn;
+    request.valid = valid;
+    request.width = width;
+    request.height = height;
+    request.dpr = dpr;
+    request.symbolFont = ColorSchemePreviewerPrivate::awesome->font(style::stfas, 16);
+    request.cacheFilePath = ColorSchemePreviewerPrivate::cacheFilePath
+        (
+            colors,
+            builtIn,
+            valid,
+            width,
+            height,
+            dpr
+        );
+
+    // Text can only be rendered on the main thread on some platforms.
+    if (!QFontDatabase::supportsThreadedFontRendering()) {
+        QFutureInterface<QImage> result;
+
+        result.reportStarted();
+        result.reportResult(ColorSchemePreviewerPrivate::renderCached(request));
+        result.reportFinished();
+
+        return result.future();
+    }
+
+    return TaskScheduler::instance()->run
+    (
+        TaskScheduler::Preview,
+        [request]() {
+            return ColorSchemePreviewerPrivate::renderCached(request);
+        }
+    );
+}
+
+void ColorSchemePreviewerPrivate::initAwesome()
+{
+    if (nullptr == awesome) {
+        awesome = new QtAwesome();
+        awesome->initFontAwesome();
+    }
+}
+
+QImage ColorSchemePreviewerPrivate::render
+(
+    const ColorScheme &colors,
+    bool builtIn,
+    bool valid,
+    int width,
+    int height,
+    qreal dpr,
+    const QFont &symbolFont
+)
+{
+    QString text = loremIpsum;
 
     text.replace("@headingMarkup", colors.headingMarkup.name());
     text.replace("@headingText", colors.headingText.name());
@@ -100,29 +256,27 @@ ColorSchemePreviewer::ColorSchemePreviewer
     text.replace("@codeMarkup", colors.codeMarkup.name());
     text.replace("@codeText", colors.codeText.name());
 
-    QTextEdit textEdit;
-    textEdit.setHtml(text);
-    textEdit.setFrameStyle(QFrame::NoFrame);
-    textEdit.setAutoFillBackground(false);
-    textEdit.setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    textEdit.setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    textEdit.setFixedSize(width, height);
-    textEdit.setStyle(new QCommonStyle());
-    textEdit.setStyleSheet
-    (
-        "QTextEdit { color: "
-        + colors.foreground.name()
-        + "; background-color: "
-        + colors.background.name()
-        + "; font-family: Roboto Mono, monospace; font-size: 20px }"
-    );
+    QFont textFont("Roboto Mono");
+    textFont.setStyleHint(QFont::Monospace);
+    textFont.setPixelSize(20);
+
+    QTextDocument document;
+    document.setDefaultFont(textFont);
+    document.setHtml(text);
+    document.setTextWidth(width);
+
+    QImage thumbnail(width * dpr, height * dpr, QImage::Format_ARGB32_Premultiplied);
+    thumbnail.setDevicePixelRatio(dpr);
+    thumbnail.fill(colors.background);
 
-    QPixmap thumbnailPixmap(width * dpr, height * dpr);
-    thumbnailPixmap.setDevicePixelRatio(dpr);
-    QPainter painter(&thumbnailPixmap);
-    painter.fillRect(thumbnailPixmap.rect(), colors.background);
+    QPainter painter(&thumbnail);
     painter.setRenderHints(QPainter::Antialiasing);
-    textEdit.render(&painter);
+
+    QAbstractTextDocumentLayout::PaintContext context;
+    context.palette.setColor(QPalette::Text, colors.foreground);
+    context.clip = QRectF(0, 0, width, height);
+    painter.setClipRect(context.clip);
+    document.documentLayout()->draw(&painter, context);
 
     if (!valid || builtIn) {
         QString symbol = QChar(fa::lock);
@@ -133,7 +287,7 @@ ColorSchemePreviewer::ColorSchemePreviewer
             color = colors.error;
         }
 
-        QFont font(d->awesome->font(style::stfas, 16));
+        QFont font(symbolFont);
         font.setPixelSize(22);
 
         QFontMetricsF metrics(font);
@@ -147,18 +301,94 @@ ColorSchemePreviewer::ColorSchemePreviewer
     }
 
     painter.end();
-    d->thumbnailPreviewIcon = thumbnailPixmap;
+    return thumbnail;
 }
 
-ColorSchemePreviewer::~ColorSchemePreviewer()
+QImage ColorSchemePreviewerPrivate::renderCached(const Request &request)
 {
-    ;
+    QImage thumbnail;
+
+    if
+    (
+        !request.cacheFilePath.isEmpty()
+        && thumbnail.load(request.cacheFilePath, "PNG")
+    ) {
+        thumbnail.setDevicePixelRatio(request.dpr);
+        return thumbnail;
+    }
+
+    thumbnail = render
+        (
+            request.colors,
+            request.builtIn,
+            request.valid,
+            request.width,
+            request.height,
+            request.dpr,
+            request.symbolFont
+        );
+
+    if (!request.cacheFilePath.isEmpty()) {
+        // Save atomically, so that a preview being rendered at the same
+        // time elsewhere is never read back half-written.
+        QSaveFile cacheFile(request.cacheFilePath);
+
+        if (cacheFile.open(QIODevice::WriteOnly) && thumbnail.save(&cacheFile, "PNG")) {
+            cacheFile.commit();
+        }
+    }
+
+    return thumbnail;
 }
 
-QIcon ColorSchemePreviewer::icon()
+QString ColorSchemePreviewerPrivate::cacheFilePath
+(
+    const ColorScheme &colors,
+    bool builtIn,
+    bool valid,
+    int width,
+    int height,
+    qreal dpr
+)
 {
-    Q_D(ColorSchemePreviewer);
-    
-    return d->thumbnailPreviewIcon;
+    QString cacheDirPath =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    if (cacheDirPath.isEmpty()) {
+        return QString();
+    }
+
+    cacheDirPath += "/themepreviews";
+
+    if (!QDir().mkpath(cacheDirPath)) {
+        return QString();
+    }
+
+    QStringList key;
+
+    key << QString::number(RENDER_VERSION)
+        << colors.foreground.name(QColor::HexArgb)
+        << colors.background.name(QColor::HexArgb)
+        << colors.link.name(QColor::HexArgb)
+        << colors.headingText.name(QColor::HexArgb)
+        << colors.headingMarkup.name(QColor::HexArgb)
+        << colors.emphasisText.name(QColor::HexArgb)
+        << colors.emphasisMarkup.name(QColor::HexArgb)
+        << colors.codeText.name(QColor::HexArgb)
+        << colors.codeMarkup.name(QColor::HexArgb)
+        << colors.error.name(QColor::HexArgb)
+        << (builtIn ? "builtin" : "custom")
+        << (valid ? "valid" : "invalid")
+        << QString::number(width)
+        << QString::number(height)
+        << QString::number(dpr);
+
+    QByteArray hash = QCryptographicHash::hash
+        (
+            key.join('\n').toUtf8(),
+            QCryptographicHash::Sha1
+        );
+
+    return cacheDirPath + "/" + QString::fromLatin1(hash.toHex()) + ".png";
 }
 } // namespace ghostwriter
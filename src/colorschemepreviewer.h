@@ -20,7 +20,9 @@
 #ifndef COLOR_SCHEME_PREVIEWER_H
 #define COLOR_SCHEME_PREVIEWER_H
 
+#include <QFuture>
 #include <QIcon>
+#include <QImage>
 #include <QScopedPointer>
 
 #include "colorscheme.h"
@@ -28,7 +30,8 @@
 namespace ghostwriter
 {
 /**
- * Renders a thumbnail preview of a theme.
+ * Renders a thumbnail preview of a theme, either right away or in the
+ * background with renderAsync().
  */
 class ColorSchemePreviewerPrivate;
 class ColorSchemePreviewer
@@ -63,6 +66,23 @@ public:
      */
     QIcon icon();
 
+    /**
+     * Renders the thumbnail preview of the given colors on the thread
+     * pool, taking the same parameters as the constructor.  Previews are
+     * cached as PNG images on disk, keyed by the colors they show and
+     * their size, so that a preview rendered before is simply read back.
+     * Must be called from the main thread.
+     */
+    static QFuture<QImage> renderAsync
+    (
+        const ColorScheme &colors,
+        bool builtIn,
+        bool valid,
+        int width,
+        int height,
+        qreal dpr = 1.0
+    );
+
 private:
     QScopedPointer<ColorSchemePreviewerPrivate> d_ptr;
 
@@ -17,8 +17,13 @@
  *
  ***********************************************************************/
 
+#include <QCryptographicHash>
+#include <QElapsedTimer>
 #include <QProcess>
 #include <QFileInfo>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QObject>
 #include <QDir>
 
@@ -39,10 +44,98 @@ public:
         ;
     }
 
+    /*
+    * Interval in milliseconds at which a command exporting to file is
+    * checked for whether the export has been cancelled.
+    */
+    static const int CANCEL_POLL_INTERVAL = 100;
+
+    /*
+    * Time in milliseconds after which commands that cannot be cancelled,
+    * such as those rendering HTML for the live preview, are given up on.
+    */
+    static const int COMMAND_TIMEOUT = 30000;
+
+    /*
+    * Number of characters of text written to a command's stdin at a time.
+    */
+    static const int WRITE_CHUNK_SIZE = 64 * 1024;
+
     QMap<const ExportFormat *, QString> formatToCommandMap;
     QString smartTypographyOnArgument = "";
     QString smartTypographyOffArgument = "";
     QString htmlRenderCommand = QString();
+    QString intermediateCommand;
+    QString intermediateInputArgument;
+    QString intermediateArgument;
+    ExportServer *htmlRenderServer = nullptr;
+    QJsonObject htmlRenderRequest;
+
+    /*
+    * Intermediate document parsed by prepareExport(), along with the hash
+    * of the text and the options it was parsed with.  The mutex is held
+    * while the intermediate command runs, so that an export of the text
+    * being prepared waits for the intermediate document rather than
+    * parsing the text a second time.
+    */
+    QMutex preparedMutex;
+    QByteArray preparedTextHash;
+    QString preparedInputFilePath;
+    bool preparedSmartTypography = false;
+    QString preparedIntermediate;
+
+    static QByteArray textHash(const QString &text);
+
+    /*
+    * Sets intermediate to the intermediate document prepared for the
+    * given text and options, and returns true if there is one.
+    */
+    bool findPrepared
+    (
+        const QString &inputFilePath,
+        const QString &text,
+        bool smartTypographyEnabled,
+        QString &intermediate
+    );
+
+    /*
+    * Runs the given file export command on the given text, setting err
+    * to a non-null error message if the export fails or is cancelled.
+    */
+    void exportWithCommand
+    (
+        const CommandLineExporter *exporter,
+        const QString &command,
+        const QString &inputFilePath,
+        const QString &text,
+        const QString &outputFilePath,
+        QString &err
+    );
+
+    /*
+    * Kills the given process and returns true if the export for which it
+    * runs was cancelled or, if the export cannot be cancelled, if it has
+    * been running for longer than COMMAND_TIMEOUT.
+    */
+    bool killIfAbandoned
+    (
+        QProcess &process,
+        const Exporter *cancellable,
+        const QElapsedTimer &timer
+    ) const;
+
+    bool renderWithServer
+    (
+        const QString &text,
+        const bool smartTypographyEnabled,
+        QString &html
+    );
+
+    QString expandSmartTypographyArg
+    (
+        const QString &str,
+        const bool smartTypographyEnabled
+    ) const;
 
     bool executeCommand
     (
@@ -52,7 +145,8 @@ public:
         const QString &outputFilePath,
         const bool smartTypographyEnabled,
         QString &stdoutOutput,
-        QString &stderrOutput
+        QString &stderrOutput,
+        const Exporter *cancellable = nullptr
     );
 };
 
@@ -79,6 +173,18 @@ void CommandLineExporter::setHtmlRenderCommand(const QString &command)
     d->htmlRenderCommand = command;
 }
 
+void CommandLineExporter::setHtmlRenderServer
+(
+    ExportServer *server,
+    const QJsonObject &request
+)
+{
+    Q_D(CommandLineExporter);
+
+    d->htmlRenderServer = server;
+    d->htmlRenderRequest = request;
+}
+
 void CommandLineExporter::addFileExportCommand
 (
     const ExportFormat *format,
@@ -130,6 +236,10 @@ void CommandLineExporter::exportToHtml(const QString &text, QString &html)
         return;
     }
 
+    if (d->renderWithServer(text, this->m_smartTypographyEnabled, html)) {
+        return;
+    }
+
     if
     (
         ! d->executeCommand
@@ -163,9 +273,6 @@ void CommandLineExporter::exportToFile
 )
 {
     Q_D(CommandLineExporter);
-    
-    QString stdoutOutput;
-    QString stderrOutput;
 
     if (!d->formatToCommandMap.contains(format)) {
         err = QObject::tr("%1 format is not supported by this processor.").arg(format->name());
@@ -173,21 +280,191 @@ void CommandLineExporter::exportToFile
     }
 
     QString command = d->formatToCommandMap.value(format);
+    QString intermediate;
 
+    // Render from the intermediate document if the text was prepared.
     if
     (
-        ! d->executeCommand
+        !d->intermediateCommand.isEmpty()
+        && command.contains(d->intermediateInputArgument)
+        && d->findPrepared(inputFilePath, text, this->m_smartTypographyEnabled, intermediate)
+    ) {
+        command.replace(d->intermediateInputArgument, d->intermediateArgument);
+        d->exportWithCommand(this, command, inputFilePath, intermediate, outputFilePath, err);
+        return;
+    }
+
+    d->exportWithCommand
+    (
+        this,
+        command,
+        inputFilePath,
+        text,
+        outputFilePath,
+        err
+    );
+}
+
+void CommandLineExporter::prepareExport
+(
+    const QString &inputFilePath,
+    const QString &text,
+    bool smartTypographyEnabled
+)
+{
+    Q_D(CommandLineExporter);
+
+    if (d->intermediateCommand.isEmpty()) {
+        return;
+    }
+
+    QByteArray hash = CommandLineExporterPrivate::textHash(text);
+    QMutexLocker locker(&d->preparedMutex);
+
+    if
+    (
+        (hash == d->preparedTextHash)
+        && (inputFilePath == d->preparedInputFilePath)
+        && (smartTypographyEnabled == d->preparedSmartTypography)
+    ) {
+        return;
+    }
+
+    QString intermediate;
+    QString stderrOutput;
+
+    // There is no export to cancel yet, so the command is only given up
+    // on after COMMAND_TIMEOUT.
+    bool parsed =
+        d->executeCommand
+        (
+            d->intermediateCommand,
+            inputFilePath,
+            text,
+            QString(),
+            smartTypographyEnabled,
+            intermediate,
+            stderrOutput
+        );
+
+    if (parsed) {
+        d->preparedTextHash = hash;
+        d->preparedInputFilePath = inputFilePath;
+        d->preparedSmartTypography = smartTypographyEnabled;
+        d->preparedIntermediate = intermediate;
+    } else {
+        d->preparedTextHash.clear();
+        d->preparedInputFilePath.clear();
+        d->preparedIntermediate.clear();
+    }
+}
+
+void CommandLineExporter::exportToFiles
+(
+    const QList<const ExportFormat *> &formats,
+    const QString &inputFilePath,
+    const QString &text,
+    const QStringList &outputFilePaths,
+    QStringList &errors
+)
+{
+    Q_D(CommandLineExporter);
+
+    // Parsing the text on its own only pays off for several formats.
+    if (d->intermediateCommand.isEmpty() || (formats.size() < 2)) {
+        Exporter::exportToFiles(formats, inputFilePath, text, outputFilePaths, errors);
+        return;
+    }
+
+    QString intermediate;
+    QString stderrOutput;
+
+    bool parsed =
+        d->findPrepared(inputFilePath, text, this->m_smartTypographyEnabled, intermediate)
+        || d->executeCommand
+        (
+            d->intermediateCommand,
+            inputFilePath,
+            text,
+            QString(),
+            this->m_smartTypographyEnabled,
+            intermediate,
+            stderrOutput,
+            this
+        );
+
+    errors.clear();
+
+    for (int i = 0; i < formats.size(); i++) {
+        QString err;
+
+        if (this->isExportCancelled()) {
+            err = QObject::tr("Export cancelled.");
+        } else if (!d->formatToCommandMap.contains(formats[i])) {
+            err = QObject::tr("%1 format is not supported by this processor.").arg(formats[i]->name());
+        } else {
+            QString command = d->formatToCommandMap.value(formats[i]);
+
+            // Render from the parsed document if possible.  Otherwise,
+            // fall back to exporting the text as usual, which reports
+            // why the text could not be parsed.
+            //
+            if (parsed && command.contains(d->intermediateInputArgument)) {
+                command.replace(d->intermediateInputArgument, d->intermediateArgument);
+                d->exportWithCommand(this, command, inputFilePath, intermediate, outputFilePaths[i], err);
+            } else {
+                d->exportWithCommand(this, command, inputFilePath, text, outputFilePaths[i], err);
+            }
+        }
+
+        errors.append(err);
+    }
+}
+
+void CommandLineExporter::setIntermediateCommand
+(
+    const QString &command,
+    const QString &inputArgument,
+    const QString &intermediateArgument
+)
+{
+    Q_D(CommandLineExporter);
+
+    d->intermediateCommand = command;
+    d->intermediateInputArgument = inputArgument;
+    d->intermediateArgument = intermediateArgument;
+}
+
+void CommandLineExporterPrivate::exportWithCommand
+(
+    const CommandLineExporter *exporter,
+    const QString &command,
+    const QString &inputFilePath,
+    const QString &text,
+    const QString &outputFilePath,
+    QString &err
+)
+{
+    QString stdoutOutput;
+    QString stderrOutput;
+
+    if
+    (
+        ! executeCommand
         (
             command,
             inputFilePath,
             text,
             outputFilePath,
-            this->m_smartTypographyEnabled,
+            exporter->smartTypographyEnabled(),
             stdoutOutput,
-            stderrOutput
+            stderrOutput,
+            exporter
         )
     ) {
-        if (!stderrOutput.isNull() && !stderrOutput.isEmpty()) {
+        if (exporter->isExportCancelled()) {
+            err = QObject::tr("Export cancelled.");
+        } else if (!stderrOutput.isNull() && !stderrOutput.isEmpty()) {
             err = stderrOutput;
         } else {
             err = QObject::tr("Failed to execute command: ") + QString("%1").arg(command);
@@ -205,7 +482,8 @@ bool CommandLineExporterPrivate::executeCommand
     const QString &outputFilePath,
     const bool smartTypographyEnabled,
     QString &stdoutOutput,
-    QString &stderrOutput
+    QString &stderrOutput,
+    const Exporter *cancellable
 )
 {
     QProcess process;
@@ -229,12 +507,218 @@ bool CommandLineExporterPrivate::executeCommand
         }
     }
 
+    expandedCommand = expandSmartTypographyArg(expandedCommand, smartTypographyEnabled);
+
+    if (!inputFilePath.isNull() && !inputFilePath.isEmpty()) {
+        process.setWorkingDirectory(QFileInfo(inputFilePath).dir().path());
+    }
+
+    process.start(expandedCommand);
+
+    if (!process.waitForStarted()) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    QByteArray stdoutData;
+
+    timer.start();
+
+    // Feed the text to stdin one chunk at a time as the process consumes
+    // it, rather than converting all of it to UTF-8 up front.  Whatever
+    // the process writes to stdout in the meantime is collected right
+    // away, so that it never stalls on a full pipe.
+    //
+    if (!textInput.isNull() && !textInput.isEmpty()) {
+        int position = 0;
+
+        while
+        (
+            (position < textInput.length())
+            && (QProcess::Running == process.state())
+        ) {
+            int length = textInput.length() - position;
+            length = (length < WRITE_CHUNK_SIZE) ? length : WRITE_CHUNK_SIZE;
+
+            // Don't split a surrogate pair between chunks.
+            if
+            (
+                ((position + length) < textInput.length())
+                && textInput.at(position + length - 1).isHighSurrogate()
+            ) {
+                length--;
+            }
+
+            process.write(textInput.midRef(position, length).toUtf8());
+            position += length;
+
+            while
+            (
+                (process.bytesToWrite() > 0)
+                && (QProcess::Running == process.state())
+            ) {
+                process.waitForBytesWritten(CANCEL_POLL_INTERVAL);
+                stdoutData.append(process.readAllStandardOutput());
+
+                if (killIfAbandoned(process, cancellable, timer)) {
+                    return false;
+                }
+            }
+        }
+
+        process.closeWriteChannel();
+    }
+
+    while
+    (
+        (QProcess::NotRunning != process.state())
+        && !process.waitForFinished(CANCEL_POLL_INTERVAL)
+    ) {
+        stdoutData.append(process.readAllStandardOutput());
+
+        if (killIfAbandoned(process, cancellable, timer)) {
+            return false;
+        }
+    }
+
+    stdoutData.append(process.readAllStandardOutput());
+    stdoutOutput = QString::fromUtf8(stdoutData);
+    stderrOutput = QString::fromUtf8(process.readAllStandardError());
+
+    if
+    (
+        (QProcess::NormalExit != process.exitStatus()) ||
+        (0 != process.exitCode())
+    ) {
+        return false;
+    }
+
+    return true;
+}
+QByteArray CommandLineExporterPrivate::textHash(const QString &text)
+{
+    return QCryptographicHash::hash
+    (
+        QByteArray::fromRawData((const char *) text.constData(), text.size() * sizeof(QChar)),
+        QCryptographicHash::Md5
+    );
+}
+
+bool CommandLineExporterPrivate::findPrepared
+(
+    const QString &inputFilePath,
+    const QString &text,
+    bool smartTypographyEnabled,
+    QString &intermediate
+)
+{
+    QByteArray hash = textHash(text);
+    QMutexLocker locker(&preparedMutex);
+
+    if
+    (
+        preparedTextHash.isEmpty()
+        || (hash != preparedTextHash)
+        || (inputFilePath != preparedInputFilePath)
+        || (smartTypographyEnabled != preparedSmartTypography)
+    ) {
+        return false;
+    }
+
+    intermediate = preparedIntermediate;
+    return true;
+}
+
+bool CommandLineExporterPrivate::killIfAbandoned
+(
+    QProcess &process,
+    const Exporter *cancellable,
+    const QElapsedTimer &timer
+) const
+{
+    bool abandoned = false;
+
+    if (nullptr == cancellable) {
+        abandoned = timer.hasExpired(COMMAND_TIMEOUT);
+    } else {
+        abandoned = cancellable->isExportCancelled();
+    }
+
+    if (abandoned) {
+        process.kill();
+        process.waitForFinished();
+    }
+
+    return abandoned;
+}
+
+bool CommandLineExporterPrivate::renderWithServer
+(
+    const QString &text,
+    const bool smartTypographyEnabled,
+    QString &html
+)
+{
+    if (nullptr == htmlRenderServer) {
+        return false;
+    }
+
+    QJsonObject request;
+
+    for
+    (
+        QJsonObject::const_iterator i = htmlRenderRequest.constBegin();
+        i != htmlRenderRequest.constEnd();
+        i++
+    ) {
+        if (i.value().isString()) {
+            request.insert(i.key(), expandSmartTypographyArg(i.value().toString(), smartTypographyEnabled));
+        } else {
+            request.insert(i.key(), i.value());
+        }
+    }
+
+    request.insert("text", text);
+
+    QByteArray response;
+    QString err;
+
+    if
+    (
+        !htmlRenderServer->post
+        (
+            QJsonDocument(request).toJson(QJsonDocument::Compact),
+            response,
+            err
+        )
+    ) {
+        return false;
+    }
+
+    QJsonObject result = QJsonDocument::fromJson(response).object();
+
+    if (!result.value("output").isString()) {
+        return false;
+    }
+
+    html = result.value("output").toString();
+    return true;
+}
+
+QString CommandLineExporterPrivate::expandSmartTypographyArg
+(
+    const QString &str,
+    const bool smartTypographyEnabled
+) const
+{
+    QString expanded = str;
+
     if
     (
         smartTypographyEnabled &&
         !smartTypographyOnArgument.isNull()
     ) {
-        expandedCommand.replace
+        expanded.replace
         (
             CommandLineExporter::SMART_TYPOGRAPHY_ARG,
             smartTypographyOnArgument
@@ -244,7 +728,7 @@ bool CommandLineExporterPrivate::executeCommand
         !smartTypographyEnabled &&
         !smartTypographyOffArgument.isNull()
     ) {
-        expandedCommand.replace
+        expanded.replace
         (
             CommandLineExporter::SMART_TYPOGRAPHY_ARG,
             smartTypographyOffArgument
@@ -253,43 +737,13 @@ bool CommandLineExporterPrivate::executeCommand
         // Replace the smart typography argument with an empty string
         // in case the above two cases are not applicable.
         //
-        expandedCommand.replace
+        expanded.replace
         (
             CommandLineExporter::SMART_TYPOGRAPHY_ARG,
             ""
         );
     }
 
-    if (!inputFilePath.isNull() && !inputFilePath.isEmpty()) {
-        process.setWorkingDirectory(QFileInfo(inputFilePath).dir().path());
-    }
-
-    process.start(expandedCommand);
-
-    if (!process.waitForStarted()) {
-        return false;
-    } else {
-        if (!textInput.isNull() && !textInput.isEmpty()) {
-            process.write(textInput.toUtf8());
-            process.closeWriteChannel();
-        }
-
-        if (!process.waitForFinished()) {
-            return false;
-        } else {
-            stdoutOutput = QString::fromUtf8(process.readAllStandardOutput().data());
-            stderrOutput = QString::fromUtf8(process.readAllStandardError().data());
-
-            if
-            (
-                (QProcess::NormalExit != process.exitStatus()) ||
-                (0 != process.exitCode())
-            ) {
-                return false;
-            }
-        }
-    }
-
-    return true;
+    return expanded;
 }
 }
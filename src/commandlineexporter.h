@@ -21,9 +21,11 @@
 #define COMMAND_LINE_EXPORTER_H
 
 #include <QString>
+#include <QJsonObject>
 #include <QMap>
 
 #include "exporter.h"
+#include "exportserver.h"
 
 namespace ghostwriter
 {
@@ -57,6 +59,18 @@ public:
      */
     void setHtmlRenderCommand(const QString &command);
 
+    /**
+     * Sets a long-lived server to which to post requests for rendering
+     * text to HTML for the Live HTML Preview, rather than executing the
+     * HTML render command for each render.  Each request posts the given
+     * JSON object with its "text" field set to the text to render, and
+     * with the SMART_TYPOGRAPHY_ARG constant replaced in its string values.
+     * The server must respond with a JSON object holding the HTML in its
+     * "output" field, as pandoc server does.  The HTML render command is
+     * still executed whenever the server is unavailable.
+     */
+    void setHtmlRenderServer(ExportServer *server, const QJsonObject &request);
+
     /**
      * Adds a command to execute for exporting text to the specified
      * export format.
@@ -67,6 +81,31 @@ public:
         const QString &command
     );
 
+    /**
+     * Sets the command with which to parse the text into an intermediate
+     * document, which the command prints to stdout, when exporting to
+     * several formats at once.  Each file export command then renders
+     * its format from the intermediate document, rather than parsing the
+     * text all over again.  For this, the input argument is replaced with
+     * the intermediate argument in each file export command, which then
+     * reads the intermediate document from stdin.  File export commands
+     * that do not contain the input argument export the text as usual.
+     * For example, for Pandoc:
+     *
+     *      setIntermediateCommand
+     *      (
+     *          "pandoc -f markdown -t json",
+     *          "-f markdown",
+     *          "-f json"
+     *      );
+     */
+    void setIntermediateCommand
+    (
+        const QString &command,
+        const QString &inputArgument,
+        const QString &intermediateArgument
+    );
+
     /**
      * Gets the command line argument used to enable smart typography
      * in the exporter.
@@ -111,6 +150,33 @@ public:
         QString &err
     );
 
+    /**
+     * Runs the intermediate command on the given text, if one is set, and
+     * keeps the intermediate document for the next export of the same
+     * text, which then renders its format from the intermediate document
+     * rather than parsing the text again.
+     */
+    void prepareExport
+    (
+        const QString &inputFilePath,
+        const QString &text,
+        bool smartTypographyEnabled
+    );
+
+    /**
+     * Exports the given text to each of the given formats.  If an
+     * intermediate command is set, the text is parsed only once for all
+     * of the formats.  See setIntermediateCommand() for details.
+     */
+    void exportToFiles
+    (
+        const QList<const ExportFormat *> &formats,
+        const QString &inputFilePath,
+        const QString &text,
+        const QStringList &outputFilePaths,
+        QStringList &errors
+    );
+
     /**
      * Contains the variable string for output file path.  Callers can
      * set this exporter to use a command having the output file path
@@ -0,0 +1,190 @@
+################################################################################
+#
+# Copyright (C) 2021 wereturtle
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+
+# Engine of ghostwriter that needs neither QtWidgets nor QtWebEngine:  the
+# document model and parser, the exporters, the statistics and the spell
+# checking.  Included by both ghostwriter.pro and core.pro, which builds
+# it as the ghostwriter-core library for headless tools.
+
+include(../3rdparty/cmark-gfm/cmark-gfm.pri)
+
+macx {
+    LIBS += -framework AppKit
+
+    HEADERS += $$PWD/spelling/dictionary_provider_nsspellchecker.h
+
+    OBJECTIVE_SOURCES += $$PWD/spelling/dictionary_provider_nsspellchecker.mm
+} else:win32 {
+    include(../3rdparty/hunspell/hunspell.pri)
+
+    HEADERS += $$PWD/spelling/dictionary_compiler.h \
+        $$PWD/spelling/dictionary_provider_compiled.h \
+        $$PWD/spelling/dictionary_provider_hunspell.h \
+        $$PWD/spelling/dictionary_provider_voikko.h
+
+    SOURCES += $$PWD/spelling/dictionary_compiler.cpp \
+        $$PWD/spelling/dictionary_provider_compiled.cpp \
+        $$PWD/spelling/dictionary_provider_hunspell.cpp \
+        $$PWD/spelling/dictionary_provider_voikko.cpp
+
+} else:unix {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += hunspell
+    
+    HEADERS += $$PWD/spelling/dictionary_compiler.h \
+        $$PWD/spelling/dictionary_provider_compiled.h \
+        $$PWD/spelling/dictionary_provider_hunspell.h \
+        $$PWD/spelling/dictionary_provider_voikko.h
+
+    SOURCES += $$PWD/spelling/dictionary_compiler.cpp \
+        $$PWD/spelling/dictionary_provider_compiled.cpp \
+        $$PWD/spelling/dictionary_provider_hunspell.cpp \
+        $$PWD/spelling/dictionary_provider_voikko.cpp
+}
+
+INCLUDEPATH += $$PWD $$PWD/spelling
+
+# Benchmark builds can count every allocation of the process, which slows
+# allocation down.  Run qmake with CONFIG+=count_allocations to do so.
+count_allocations {
+    DEFINES += GW_COUNT_ALLOCATIONS
+}
+
+# Words and sentences of scripts written without spaces, such as Chinese,
+# Japanese and Thai, are segmented with ICU where it is available.
+unix:!macx {
+    packagesExist(icu-uc icu-i18n) {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += icu-uc icu-i18n
+        DEFINES += GW_USE_ICU
+    }
+}
+
+HEADERS += \
+    $$PWD/allocationcounter.h \
+    $$PWD/batchexporter.h \
+    $$PWD/cmarkgfmapi.h \
+    $$PWD/cmarkgfmexporter.h \
+    $$PWD/codelexer.h \
+    $$PWD/commandlineexporter.h \
+    $$PWD/diagramrenderer.h \
+    $$PWD/documentcache.h \
+    $$PWD/documentstatistics.h \
+    $$PWD/documentwriter.h \
+    $$PWD/exportcache.h \
+    $$PWD/exporter.h \
+    $$PWD/exporterfactory.h \
+    $$PWD/exportformat.h \
+    $$PWD/exportjobmanager.h \
+    $$PWD/exportonsave.h \
+    $$PWD/exportserver.h \
+    $$PWD/headingindex.h \
+    $$PWD/highlightprofiler.h \
+    $$PWD/htmlblockobserver.h \
+    $$PWD/imagestore.h \
+    $$PWD/incrementalparser.h \
+    $$PWD/linediff.h \
+    $$PWD/linkchecker.h \
+    $$PWD/literalsearcher.h \
+    $$PWD/mappedtextfile.h \
+    $$PWD/markdownast.h \
+    $$PWD/markdowndocument.h \
+    $$PWD/markdownlinter.h \
+    $$PWD/markdownnode.h \
+    $$PWD/markdownprocessorplugin.h \
+    $$PWD/memoryarena.h \
+    $$PWD/officedocumentwriter.h \
+    $$PWD/pluginexporter.h \
+    $$PWD/projectstatistics.h \
+    $$PWD/readabilityanalyzer.h \
+    $$PWD/referenceindex.h \
+    $$PWD/resourceinliner.h \
+    $$PWD/spellcheckservice.h \
+    $$PWD/spelling/abstract_dictionary.h \
+    $$PWD/spelling/abstract_dictionary_provider.h \
+    $$PWD/spelling/dictionary_manager.h \
+    $$PWD/spelling/dictionary_ref.h \
+    $$PWD/startupprofiler.h \
+    $$PWD/statisticsreporter.h \
+    $$PWD/stringobserver.h \
+    $$PWD/tableformatter.h \
+    $$PWD/taskindex.h \
+    $$PWD/taskscheduler.h \
+    $$PWD/textblockdata.h \
+    $$PWD/textsegmenter.h \
+    $$PWD/texttokenizer.h \
+    $$PWD/tracer.h \
+    $$PWD/typingactivity.h \
+    $$PWD/utf8columnmap.h \
+    $$PWD/vocabularyindex.h \
+    $$PWD/zipwriter.h
+
+SOURCES += \
+    $$PWD/allocationcounter.cpp \
+    $$PWD/batchexporter.cpp \
+    $$PWD/cmarkgfmapi.cpp \
+    $$PWD/cmarkgfmexporter.cpp \
+    $$PWD/codelexer.cpp \
+    $$PWD/commandlineexporter.cpp \
+    $$PWD/diagramrenderer.cpp \
+    $$PWD/documentcache.cpp \
+    $$PWD/documentstatistics.cpp \
+    $$PWD/documentwriter.cpp \
+    $$PWD/exportcache.cpp \
+    $$PWD/exporter.cpp \
+    $$PWD/exporterfactory.cpp \
+    $$PWD/exportformat.cpp \
+    $$PWD/exportjobmanager.cpp \
+    $$PWD/exportonsave.cpp \
+    $$PWD/exportserver.cpp \
+    $$PWD/headingindex.cpp \
+    $$PWD/highlightprofiler.cpp \
+    $$PWD/htmlblockobserver.cpp \
+    $$PWD/imagestore.cpp \
+    $$PWD/incrementalparser.cpp \
+    $$PWD/linediff.cpp \
+    $$PWD/linkchecker.cpp \
+    $$PWD/literalsearcher.cpp \
+    $$PWD/mappedtextfile.cpp \
+    $$PWD/markdownast.cpp \
+    $$PWD/markdowndocument.cpp \
+    $$PWD/markdownlinter.cpp \
+    $$PWD/markdownnode.cpp \
+    $$PWD/memoryarena.cpp \
+    $$PWD/officedocumentwriter.cpp \
+    $$PWD/pluginexporter.cpp \
+    $$PWD/projectstatistics.cpp \
+    $$PWD/readabilityanalyzer.cpp \
+    $$PWD/referenceindex.cpp \
+    $$PWD/resourceinliner.cpp \
+    $$PWD/spellcheckservice.cpp \
+    $$PWD/spelling/dictionary_manager.cpp \
+    $$PWD/startupprofiler.cpp \
+    $$PWD/statisticsreporter.cpp \
+    $$PWD/stringobserver.cpp \
+    $$PWD/tableformatter.cpp \
+    $$PWD/taskindex.cpp \
+    $$PWD/taskscheduler.cpp \
+    $$PWD/textsegmenter.cpp \
+    $$PWD/texttokenizer.cpp \
+    $$PWD/tracer.cpp \
+    $$PWD/typingactivity.cpp \
+    $$PWD/utf8columnmap.cpp \
+    $$PWD/vocabularyindex.cpp \
+    $$PWD/zipwriter.cpp
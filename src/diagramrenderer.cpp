@@ -0,0 +1,492 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QFutureWatcher>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSet>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTimer>
+
+#include "diagramrenderer.h"
+#include "taskscheduler.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+class DiagramRendererPrivate
+{
+    Q_DECLARE_PUBLIC(DiagramRenderer)
+
+public:
+    DiagramRendererPrivate(DiagramRenderer *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~DiagramRendererPrivate()
+    {
+        ;
+    }
+
+    typedef enum {
+        NoDiagram,
+        Mermaid,
+        Graphviz,
+        DiagramTypeCount
+    } DiagramType;
+
+    // Longest time, in milliseconds, that a diagram may take to render
+    // before its process is killed.
+    static const int RenderTimeout = 15000;
+
+    // Kilobytes of SVG kept in the cache.
+    static const int MaxCacheCost = 32 * 1024;
+
+    DiagramRenderer *q_ptr;
+
+    QColor foreground;
+    QColor background;
+
+    // Hash of the colors, which is part of the key of every diagram.
+    QByteArray colorsHash;
+
+    // SVG of the rendered diagrams, by key.
+    QCache<QByteArray, QString> svgs;
+
+    // Keys of the diagrams being rendered, and of those that failed to
+    // render, which are not tried again until their source changes.
+    QSet<QByteArray> pending;
+    QSet<QByteArray> failed;
+
+    // Paths of the command line tools by diagram type, looked up once.
+    bool toolsFound;
+    QString toolPaths[DiagramTypeCount];
+
+    QRegularExpression codeBlockExp;
+    QRegularExpression classExp;
+    QTimer *notifyTimer;
+
+    QString diagramHtml
+    (
+        DiagramType type,
+        const QString &preAttributes,
+        const QString &source
+    );
+    void setColorsHash();
+    QByteArray diagramKey(DiagramType type, const QString &source) const;
+    DiagramType diagramType(const QString &preAttributes, const QString &codeAttributes) const;
+    void startRender(DiagramType type, const QByteArray &key, const QString &source);
+    void onRenderFinished(const QByteArray &key, const QString &svg);
+    QStringList toolArguments(DiagramType type, const QByteArray &key) const;
+    void findTools();
+
+    static QString unescapeHtml(const QString &html);
+    static QString runTool
+    (
+        const QString &program,
+        const QStringList &arguments,
+        const QString &source
+    );
+};
+
+DiagramRenderer::DiagramRenderer(QObject *parent)
+    : QObject(parent),
+      d_ptr(new DiagramRendererPrivate(this))
+{
+    Q_D(DiagramRenderer);
+
+    d->toolsFound = false;
+    d->svgs.setMaxCost(DiagramRendererPrivate::MaxCacheCost);
+    d->codeBlockExp.setPattern("<pre([^>]*)>\\s*<code([^>]*)>(.*?)</code>\\s*</pre>");
+    d->codeBlockExp.setPatternOptions(QRegularExpression::DotMatchesEverythingOption);
+    d->classExp.setPattern("\\s+class\\s*=\\s*\"([^\"]*)\"");
+    d->setColorsHash();
+
+    d->notifyTimer = new QTimer(this);
+    d->notifyTimer->setSingleShot(true);
+    d->notifyTimer->setInterval(0);
+    this->connect
+    (
+        d->notifyTimer,
+        &QTimer::timeout,
+        [this]() {
+            emit diagramsRendered();
+        }
+    );
+}
+
+DiagramRenderer::~DiagramRenderer()
+{
+    ;
+}
+
+QString DiagramRenderer::render(const QString &html)
+{
+    Q_D(DiagramRenderer);
+
+    // Most documents have no diagrams, so skip them before matching.
+    if
+    (
+        !html.contains(QLatin1String("<pre"))
+        || !(
+            html.contains(QLatin1String("mermaid"))
+            || html.contains(QLatin1String("dot"))
+            || html.contains(QLatin1String("graphviz"))
+        )
+    ) {
+        return html;
+    }
+
+    GW_TRACE_SCOPE("DiagramRenderer::render");
+
+    QString result;
+    int position = 0;
+    QRegularExpressionMatchIterator i = d->codeBlockExp.globalMatch(html);
+
+    while (i.hasNext()) {
+        QRegularExpressionMatch match = i.next();
+        DiagramRendererPrivate::DiagramType type =
+            d->diagramType(match.captured(1), match.captured(2));
+
+        if (DiagramRendererPrivate::NoDiagram == type) {
+            continue;
+        }
+
+        QString replacement = d->diagramHtml
+            (
+                type,
+                match.captured(1),
+                DiagramRendererPrivate::unescapeHtml(match.captured(3))
+            );
+
+        if (replacement.isNull()) {
+            continue;
+        }
+
+        if (result.isNull()) {
+            result.reserve(html.length());
+        }
+
+        result.append(html.midRef(position, match.capturedStart() - position));
+        result.append(replacement);
+        position = match.capturedEnd();
+    }
+
+    if (result.isNull()) {
+        return html;
+    }
+
+    result.append(html.midRef(position));
+    return result;
+}
+
+void DiagramRenderer::setColors(const QColor &foreground, const QColor &background)
+{
+    Q_D(DiagramRenderer);
+
+    if ((foreground == d->foreground) && (background == d->background)) {
+        return;
+    }
+
+    d->foreground = foreground;
+    d->background = background;
+    d->setColorsHash();
+}
+
+void DiagramRenderer::clearCache()
+{
+    Q_D(DiagramRenderer);
+
+    d->svgs.clear();
+    d->failed.clear();
+}
+
+void DiagramRendererPrivate::setColorsHash()
+{
+    colorsHash = foreground.name(QColor::HexArgb).toLatin1()
+        + background.name(QColor::HexArgb).toLatin1();
+}
+
+// Returns the HTML of the SVG of the given diagram, or a null string if
+// the diagram is left as a code block, such as while it renders.
+//
+QString DiagramRendererPrivate::diagramHtml
+(
+    DiagramType type,
+    const QString &preAttributes,
+    const QString &source
+)
+{
+    QByteArray key = diagramKey(type, source);
+    QString *svg = svgs.object(key);
+
+    if (nullptr == svg) {
+        if (!pending.contains(key) && !failed.contains(key)) {
+            startRender(type, key, source);
+        }
+
+        return QString();
+    }
+
+    // Keep attributes such as the source lines of the block, but not the
+    // classes of its code.
+    QString attributes = preAttributes;
+    attributes.remove(classExp);
+
+    return QString("<div class=\"diagram\"%1>%2</div>").arg(attributes, *svg);
+}
+
+QByteArray DiagramRendererPrivate::diagramKey(DiagramType type, const QString &source) const
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    hash.addData(QByteArray::number(type));
+    hash.addData(colorsHash);
+    hash.addData
+    (
+        QByteArray::fromRawData((const char *) source.constData(), source.size() * sizeof(QChar))
+    );
+
+    return hash.result();
+}
+
+// Finds the language of a code block from the classes of its <pre> and
+// <code> elements, which differ between processors, such as
+// class="language-mermaid" on <code> for cmark-gfm, or class="mermaid" on
+// <pre> for pandoc.
+//
+DiagramRendererPrivate::DiagramType DiagramRendererPrivate::diagramType
+(
+    const QString &preAttributes,
+    const QString &codeAttributes
+) const
+{
+    QStringList classes;
+
+    QRegularExpressionMatch match = classExp.match(preAttributes);
+
+    if (match.hasMatch()) {
+        classes += match.captured(1).split(' ', QString::SkipEmptyParts);
+    }
+
+    match = classExp.match(codeAttributes);
+
+    if (match.hasMatch()) {
+        classes += match.captured(1).split(' ', QString::SkipEmptyParts);
+    }
+
+    for (QString name : classes) {
+        if (name.startsWith(QLatin1String("language-"))) {
+            name = name.mid(9);
+        }
+
+        if (0 == name.compare(QLatin1String("mermaid"), Qt::CaseInsensitive)) {
+            return Mermaid;
+        }
+
+        if
+        (
+            (0 == name.compare(QLatin1String("dot"), Qt::CaseInsensitive))
+            || (0 == name.compare(QLatin1String("graphviz"), Qt::CaseInsensitive))
+        ) {
+            return Graphviz;
+        }
+    }
+
+    return NoDiagram;
+}
+
+void DiagramRendererPrivate::startRender
+(
+    DiagramType type,
+    const QByteArray &key,
+    const QString &source
+)
+{
+    Q_Q(DiagramRenderer);
+
+    findTools();
+
+    QString program = toolPaths[type];
+
+    // Without the tool, the diagram stays a code block.
+    if (program.isEmpty()) {
+        failed.insert(key);
+        return;
+    }
+
+    pending.insert(key);
+
+    QStringList arguments = toolArguments(type, key);
+    QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>(q);
+
+    q->connect
+    (
+        watcher,
+        &QFutureWatcher<QString>::finished,
+        [this, watcher, key]() {
+            QString svg;
+
+            if (!watcher->isCanceled()) {
+                svg = watcher->result();
+            }
+
+            watcher->deleteLater();
+            onRenderFinished(key, svg);
+        }
+    );
+
+    watcher->setFuture
+    (
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Preview,
+            [program, arguments, source]() {
+                return runTool(program, arguments, source);
+            }
+        )
+    );
+}
+
+void DiagramRendererPrivate::onRenderFinished(const QByteArray &key, const QString &svg)
+{
+    pending.remove(key);
+
+    if (svg.isEmpty()) {
+        failed.insert(key);
+        return;
+    }
+
+    svgs.insert(key, new QString(svg), 1 + ((svg.size() * sizeof(QChar)) / 1024));
+    notifyTimer->start();
+}
+
+QStringList DiagramRendererPrivate::toolArguments(DiagramType type, const QByteArray &key) const
+{
+    QStringList arguments;
+
+    if (Mermaid == type) {
+        // Every diagram of the page needs its own SVG id, since Mermaid
+        // scopes the styles of a diagram to its id.
+        arguments
+            << "--quiet"
+            << "--input" << "-"
+            << "--output" << "-"
+            << "--outputFormat" << "svg"
+            << "--backgroundColor" << "transparent"
+            << "--theme" << ((background.lightness() < 128) ? "dark" : "default")
+            << "--svgId" << (QString("diagram-") + QString::fromLatin1(key.toHex()));
+    } else if (Graphviz == type) {
+        QString color = foreground.name();
+
+        arguments
+            << "-Tsvg"
+            << "-Gbgcolor=transparent"
+            << ("-Gcolor=" + color)
+            << ("-Gfontcolor=" + color)
+            << ("-Ncolor=" + color)
+            << ("-Nfontcolor=" + color)
+            << ("-Ecolor=" + color)
+            << ("-Efontcolor=" + color);
+    }
+
+    return arguments;
+}
+
+void DiagramRendererPrivate::findTools()
+{
+    if (toolsFound) {
+        return;
+    }
+
+    toolsFound = true;
+    toolPaths[Mermaid] = QStandardPaths::findExecutable("mmdc");
+    toolPaths[Graphviz] = QStandardPaths::findExecutable("dot");
+}
+
+QString DiagramRendererPrivate::unescapeHtml(const QString &html)
+{
+    QString text = html;
+
+    text.replace(QLatin1String("&lt;"), QLatin1String("<"));
+    text.replace(QLatin1String("&gt;"), QLatin1String(">"));
+    text.replace(QLatin1String("&quot;"), QLatin1String("\""));
+    text.replace(QLatin1String("&#39;"), QLatin1String("'"));
+    text.replace(QLatin1String("&#x27;"), QLatin1String("'"));
+    text.replace(QLatin1String("&amp;"), QLatin1String("&"));
+
+    return text;
+}
+
+// Runs the given tool with the diagram's source on stdin, and returns the
+// SVG that it writes to stdout, or an empty string if it fails.
+//
+QString DiagramRendererPrivate::runTool
+(
+    const QString &program,
+    const QStringList &arguments,
+    const QString &source
+)
+{
+    GW_TRACE_SCOPE("DiagramRenderer::runTool");
+
+    QProcess process;
+    process.start(program, arguments);
+
+    if (!process.waitForStarted()) {
+        return QString();
+    }
+
+    process.write(source.toUtf8());
+    process.closeWriteChannel();
+
+    if (!process.waitForFinished(RenderTimeout)) {
+        process.kill();
+        process.waitForFinished();
+        return QString();
+    }
+
+    if
+    (
+        (QProcess::NormalExit != process.exitStatus()) ||
+        (0 != process.exitCode())
+    ) {
+        return QString();
+    }
+
+    QString svg = QString::fromUtf8(process.readAllStandardOutput());
+    int start = svg.indexOf(QLatin1String("<svg"));
+
+    if (start < 0) {
+        return QString();
+    }
+
+    // Drop the XML declaration, the doctype and the comments, so that the
+    // SVG splits into a single top-level block of the page.
+    svg.remove(0, start);
+    svg.remove(QRegularExpression("<!--.*?-->", QRegularExpression::DotMatchesEverythingOption));
+
+    return svg.trimmed();
+}
+} // namespace ghostwriter
@@ -0,0 +1,91 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef DIAGRAM_RENDERER_H
+#define DIAGRAM_RENDERER_H
+
+#include <QColor>
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+namespace ghostwriter
+{
+/**
+ * Diagram stage of the preview pipeline.  Replaces the Mermaid and Graphviz
+ * code blocks of rendered HTML (i.e., fenced code blocks whose language is
+ * "mermaid", "dot" or "graphviz") with SVG images of their diagrams.
+ *
+ * Diagrams are rendered by the mmdc and dot command line tools, one process
+ * per diagram, in the preview lane of the TaskScheduler, so that the page
+ * never waits on them.  The SVG is cached by the hash of the diagram's
+ * source and of the colors it was rendered with, so that only diagrams
+ * whose source changed are rendered again.  Until its SVG is ready, a
+ * diagram is left as a code block.
+ */
+class DiagramRendererPrivate;
+class DiagramRenderer : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(DiagramRenderer)
+
+public:
+    /**
+     * Constructor.
+     */
+    explicit DiagramRenderer(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~DiagramRenderer();
+
+    /**
+     * Returns the given HTML with the diagrams whose SVG is cached put in
+     * place of their code blocks.  Diagrams that are not cached yet are
+     * rendered in the background, after which diagramsRendered() is
+     * emitted.  HTML without diagrams is returned as is.
+     */
+    QString render(const QString &html);
+
+    /**
+     * Sets the colors with which diagrams are drawn.  Diagrams rendered
+     * with other colors are rendered again as they are needed.
+     */
+    void setColors(const QColor &foreground, const QColor &background);
+
+    /**
+     * Drops the cached SVG of all diagrams.
+     */
+    void clearCache();
+
+signals:
+    /**
+     * Emitted once diagrams rendered in the background are cached, so
+     * that the HTML can be passed through render() again.  Diagrams that
+     * finish together are reported once.
+     */
+    void diagramsRendered();
+
+private:
+    QScopedPointer<DiagramRendererPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // DIAGRAM_RENDERER_H
@@ -0,0 +1,474 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <string.h>
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QTextBlock>
+
+#include "documentcache.h"
+#include "markdowndocument.h"
+#include "taskscheduler.h"
+#include "textblockdata.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+static const char CacheMagic[8] = { 'G', 'W', 'C', 'A', 'C', 'H', 'E', '1' };
+static const quint32 CacheVersion = 3;
+
+// Written in the byte order of the machine, so that a cache copied over
+// from a machine of the other byte order is rejected.
+static const quint32 ByteOrderMark = 0x01020304;
+
+static const int HashLength = 20;
+
+//
+// Layout of a cache file:  the header, followed by the block records, the
+// misspellings as pairs of position and length, and the AST as written by
+// MarkdownAST::write().  Each section starts at an offset aligned to eight
+// bytes, so that the records can be read in place from the mapping.
+//
+struct DocumentCache::Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    qint64 fileSize;
+    qint64 fileModified;
+    qint64 blocksOffset;
+    qint64 misspellingsOffset;
+    qint64 astOffset;
+    qint64 astLength;
+    qint32 textLength;
+    qint32 blockCount;
+    qint32 misspellingCount;
+    qint32 smartTypography;
+    char contentHash[HashLength];
+    char spellingKeyHash[HashLength];
+};
+
+struct DocumentCache::BlockRecord
+{
+    quint32 textHash;
+    qint32 words;
+    qint32 longWords;
+    qint32 alphaNumericCharacters;
+    qint32 sentences;
+
+    // Index of the block's first misspelling, and the number of its
+    // misspellings, or -1 if the block was not spell checked.
+    qint32 misspellingOffset;
+    qint32 misspellingCount;
+
+    qint32 dictionaryIndex;
+};
+
+static qint64 alignedOffset(qint64 offset)
+{
+    return (offset + 7) & ~((qint64) 7);
+}
+
+static QByteArray spellingKeyHash(const QString &spellingKey)
+{
+    return QCryptographicHash::hash(spellingKey.toUtf8(), QCryptographicHash::Sha1);
+}
+
+QSharedPointer<DocumentCache> DocumentCache::load
+(
+    const QString &filePath,
+    const QString &spellingKey
+)
+{
+    GW_TRACE_SCOPE("DocumentCache::load");
+
+    QFileInfo info(filePath);
+
+    // A file smaller than MinTextLength bytes can't hold MinTextLength
+    // characters.
+    if (!info.isFile() || (info.size() < MinTextLength)) {
+        return QSharedPointer<DocumentCache>();
+    }
+
+    QSharedPointer<DocumentCache> cache(new DocumentCache());
+    cache->file.setFileName(cacheFilePath(info.absoluteFilePath()));
+
+    if (!cache->file.open(QIODevice::ReadOnly)) {
+        return QSharedPointer<DocumentCache>();
+    }
+
+    qint64 size = cache->file.size();
+
+    if (size < (qint64) sizeof(Header)) {
+        return QSharedPointer<DocumentCache>();
+    }
+
+    const uchar *data = cache->file.map(0, size);
+
+    if (nullptr == data) {
+        return QSharedPointer<DocumentCache>();
+    }
+
+    const Header *header = (const Header *) data;
+
+    if
+    (
+        (0 != memcmp(header->magic, CacheMagic, sizeof(CacheMagic)))
+        || (CacheVersion != header->version)
+        || (ByteOrderMark != header->byteOrder)
+        || (info.size() != header->fileSize)
+        || (info.lastModified().toMSecsSinceEpoch() != header->fileModified)
+        || (header->blockCount < 0)
+        || (header->misspellingCount < 0)
+        || (header->blocksOffset < (qint64) sizeof(Header))
+        || (header->misspellingsOffset < (qint64) sizeof(Header))
+        || (header->astOffset < (qint64) sizeof(Header))
+        || (header->astLength < 0)
+        || ((header->blocksOffset + header->blockCount * (qint64) sizeof(BlockRecord)) > size)
+        || ((header->misspellingsOffset + header->misspellingCount * 2 * (qint64) sizeof(qint32)) > size)
+        || ((header->astOffset + header->astLength) > size)
+    ) {
+        return QSharedPointer<DocumentCache>();
+    }
+
+    // Editors can preserve the modification time of a file, so check the
+    // contents as well.
+    if (contentHash(filePath) != QByteArray::fromRawData(header->contentHash, HashLength)) {
+        return QSharedPointer<DocumentCache>();
+    }
+
+    cache->header = header;
+    cache->blocks = (const BlockRecord *) (data + header->blocksOffset);
+
+    if (spellingKeyHash(spellingKey) == QByteArray::fromRawData(header->spellingKeyHash, HashLength)) {
+        cache->misspellingData = (const qint32 *) (data + header->misspellingsOffset);
+    }
+
+    QByteArray astData =
+        QByteArray::fromRawData((const char *) (data + header->astOffset), header->astLength);
+    QDataStream stream(astData);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    cache->ast = new MarkdownAST();
+
+    if (!cache->ast->read(stream)) {
+        delete cache->ast;
+        cache->ast = nullptr;
+    }
+
+    return cache;
+}
+
+void DocumentCache::save
+(
+    const MarkdownDocument *document,
+    const QString &spellingKey,
+    bool smartTypography,
+    uint spellingGeneration
+)
+{
+    GW_TRACE_SCOPE("DocumentCache::save");
+
+    QFileInfo info(document->filePath());
+
+    if
+    (
+        document->isNew()
+        || document->isModified()
+        || (nullptr == document->markdownAST())
+        || ((document->characterCount() - 1) < MinTextLength)
+        || !info.isFile()
+        || (info.lastModified() != document->timestamp())
+    ) {
+        return;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+    header.version = CacheVersion;
+    header.byteOrder = ByteOrderMark;
+    header.fileSize = info.size();
+    header.fileModified = info.lastModified().toMSecsSinceEpoch();
+    header.textLength = document->characterCount() - 1;
+    header.blockCount = document->blockCount();
+    header.smartTypography = smartTypography ? 1 : 0;
+    memcpy(header.spellingKeyHash, spellingKeyHash(spellingKey).constData(), HashLength);
+
+    // Gather the text and the misspellings of the blocks here, since they
+    // can only be read on the GUI thread.  The statistics are counted
+    // afresh in the background rather than copied, since those of the
+    // blocks may be waiting to be updated.
+    //
+    QStringList texts;
+    QVector<BlockRecord> records;
+    QVector<qint32> misspellings;
+
+    texts.reserve(header.blockCount);
+    records.reserve(header.blockCount);
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        BlockRecord record;
+        memset(&record, 0, sizeof(BlockRecord));
+
+        QString text = block.text();
+        record.textHash = qHash(text);
+        record.misspellingCount = -1;
+
+        const TextBlockData *blockData = (const TextBlockData *) block.userData();
+
+        if
+        (
+            (nullptr != blockData)
+            && blockData->spellingChecked
+            && (spellingGeneration == blockData->spellingGeneration)
+            && (record.textHash == blockData->spellingTextHash)
+        ) {
+            record.misspellingOffset = misspellings.size() / 2;
+            record.misspellingCount = blockData->misspellings.size();
+            record.dictionaryIndex = blockData->spellingDictionary;
+
+            for (const QPair<int, int> &misspelling : blockData->misspellings) {
+                misspellings.append(misspelling.first);
+                misspellings.append(misspelling.second);
+            }
+        }
+
+        texts.append(text);
+        records.append(record);
+    }
+
+    header.misspellingCount = misspellings.size() / 2;
+
+    QByteArray astData;
+    QDataStream stream(&astData, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_6);
+    document->markdownAST()->write(stream);
+
+    header.blocksOffset = alignedOffset(sizeof(Header));
+    header.misspellingsOffset =
+        alignedOffset(header.blocksOffset + records.size() * sizeof(BlockRecord));
+    header.astOffset =
+        alignedOffset(header.misspellingsOffset + misspellings.size() * sizeof(qint32));
+    header.astLength = astData.size();
+
+    QString filePath = info.absoluteFilePath();
+
+    TaskScheduler::instance()->run
+    (
+        TaskScheduler::Interactive,
+        [filePath, header, texts, records, misspellings, astData]() mutable {
+            GW_TRACE_SCOPE("DocumentCache::save (background)");
+
+            for (int i = 0; i < records.size(); i++) {
+                TextTokenizer::Counts counts = TextTokenizer::count(texts.at(i));
+
+                records[i].words = counts.words;
+                records[i].longWords = counts.longWords;
+                records[i].alphaNumericCharacters = counts.alphaNumericCharacters;
+                records[i].sentences = counts.sentences;
+            }
+
+            QByteArray hash = contentHash(filePath);
+
+            if (HashLength != hash.size()) {
+                return;
+            }
+
+            memcpy(header.contentHash, hash.constData(), HashLength);
+
+            QString path = cacheFilePath(filePath);
+
+            if (!QDir().mkpath(QFileInfo(path).path())) {
+                return;
+            }
+
+            // Write to a temporary file, renamed once complete, so that a
+            // partly written cache is never loaded.
+            QString tempPath = path + ".part";
+            QFile file(tempPath);
+
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                return;
+            }
+
+            QByteArray padding(8, '\0');
+            bool written =
+                (file.write((const char *) &header, sizeof(Header)) == (qint64) sizeof(Header))
+                && file.write(padding.constData(), header.blocksOffset - file.pos()) >= 0
+                && file.write((const char *) records.constData(), records.size() * sizeof(BlockRecord)) >= 0
+                && file.write(padding.constData(), header.misspellingsOffset - file.pos()) >= 0
+                && file.write((const char *) misspellings.constData(), misspellings.size() * sizeof(qint32)) >= 0
+                && file.write(padding.constData(), header.astOffset - file.pos()) >= 0
+                && (file.write(astData) == astData.size());
+
+            file.close();
+
+            if (!written || (QFile::NoError != file.error())) {
+                QFile::remove(tempPath);
+                return;
+            }
+
+            QFile::remove(path);
+
+            if (!QFile::rename(tempPath, path)) {
+                QFile::remove(tempPath);
+            }
+        }
+    );
+}
+
+DocumentCache::DocumentCache()
+    : header(nullptr), blocks(nullptr), misspellingData(nullptr), ast(nullptr)
+{
+    ;
+}
+
+DocumentCache::~DocumentCache()
+{
+    delete ast;
+}
+
+int DocumentCache::textLength() const
+{
+    return header->textLength;
+}
+
+bool DocumentCache::smartTypography() const
+{
+    return (0 != header->smartTypography);
+}
+
+bool DocumentCache::blockStatistics
+(
+    int blockNumber,
+    const QString &text,
+    TextTokenizer::Counts &counts
+) const
+{
+    const BlockRecord *record = block(blockNumber, text);
+
+    if (nullptr == record) {
+        return false;
+    }
+
+    counts.words = record->words;
+    counts.longWords = record->longWords;
+    counts.alphaNumericCharacters = record->alphaNumericCharacters;
+    counts.sentences = record->sentences;
+    return true;
+}
+
+bool DocumentCache::misspellings
+(
+    int blockNumber,
+    const QString &text,
+    QVector<QPair<int, int>> &misspellings,
+    int &dictionaryIndex
+) const
+{
+    if (nullptr == misspellingData) {
+        return false;
+    }
+
+    const BlockRecord *record = block(blockNumber, text);
+
+    if
+    (
+        (nullptr == record)
+        || (record->misspellingCount < 0)
+        || (record->misspellingOffset < 0)
+        || ((record->misspellingOffset + record->misspellingCount) > header->misspellingCount)
+    ) {
+        return false;
+    }
+
+    const qint32 *data = misspellingData + (2 * record->misspellingOffset);
+
+    misspellings.clear();
+    misspellings.reserve(record->misspellingCount);
+
+    for (int i = 0; i < record->misspellingCount; i++) {
+        misspellings.append(QPair<int, int>(data[2 * i], data[(2 * i) + 1]));
+    }
+
+    dictionaryIndex = record->dictionaryIndex;
+    return true;
+}
+
+void DocumentCache::discardMisspellings()
+{
+    misspellingData = nullptr;
+}
+
+MarkdownAST *DocumentCache::takeAST()
+{
+    MarkdownAST *taken = ast;
+    ast = nullptr;
+    return taken;
+}
+
+const DocumentCache::BlockRecord *DocumentCache::block
+(
+    int blockNumber,
+    const QString &text
+) const
+{
+    if ((blockNumber < 0) || (blockNumber >= header->blockCount)) {
+        return nullptr;
+    }
+
+    const BlockRecord *record = blocks + blockNumber;
+
+    if (qHash(text) != record->textHash) {
+        return nullptr;
+    }
+
+    return record;
+}
+
+QString DocumentCache::cacheFilePath(const QString &filePath)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + "/documents/"
+        + QString::fromLatin1
+            (
+                QCryptographicHash::hash(filePath.toUtf8(), QCryptographicHash::Sha1).toHex()
+            );
+}
+
+QByteArray DocumentCache::contentHash(const QString &filePath)
+{
+    QFile file(filePath);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+        return QByteArray();
+    }
+
+    return hash.result();
+}
+} // namespace ghostwriter
@@ -0,0 +1,173 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef DOCUMENT_CACHE_H
+#define DOCUMENT_CACHE_H
+
+#include <QFile>
+#include <QPair>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "markdownast.h"
+#include "texttokenizer.h"
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+
+/**
+ * Keeps a disk cache of the AST, the statistics of each block and the
+ * misspellings of each block of large documents, so that reopening such a
+ * document neither parses it, nor tokenizes it, nor spell checks it again
+ * from scratch.
+ *
+ * A document's cache is tied to the size, modification time and content
+ * hash of its file, and is ignored as a whole if any of them changed.  The
+ * statistics and misspellings of each block are further tied to a hash of
+ * the block's text, and the misspellings to the spelling key given when
+ * the cache was saved, which should identify the dictionaries in use.
+ *
+ * The per-block records are read straight from a memory mapping of the
+ * cache file, so that looking them up costs nothing until a block needs
+ * them.
+ */
+class DocumentCache
+{
+public:
+    /**
+     * Documents with fewer characters than this are quick enough to
+     * parse, count and check again that they are never cached.
+     */
+    static const int MinTextLength = 1024 * 1024;
+
+    /**
+     * Loads the cache of the file at the given path, returning a null
+     * pointer if there is none or if it is out of date.  The misspellings
+     * are dropped if they were saved under a spelling key other than the
+     * given one.  This method blocks, and is meant to run on a worker
+     * thread.
+     */
+    static QSharedPointer<DocumentCache> load
+    (
+        const QString &filePath,
+        const QString &spellingKey
+    );
+
+    /**
+     * Saves the cache of the given document, which must be unmodified
+     * since it was last saved to its file, along with its current AST.
+     * The AST must have been parsed with the given smart typography
+     * setting.  Only the misspellings found in the given spelling
+     * generation of the MarkdownHighlighter are saved.  The data is
+     * gathered on the calling thread, and written to disk in the
+     * background.  Documents shorter than MinTextLength are not saved.
+     */
+    static void save
+    (
+        const MarkdownDocument *document,
+        const QString &spellingKey,
+        bool smartTypography,
+        uint spellingGeneration
+    );
+
+    /**
+     * Destructor.
+     */
+    ~DocumentCache();
+
+    /**
+     * Returns the length of the text of the document when it was cached.
+     */
+    int textLength() const;
+
+    /**
+     * Returns whether the cached AST was parsed with smart typography.
+     */
+    bool smartTypography() const;
+
+    /**
+     * Sets the cached statistics of the block with the given number into
+     * counts, returning true if the block had the given text when cached.
+     */
+    bool blockStatistics
+    (
+        int blockNumber,
+        const QString &text,
+        TextTokenizer::Counts &counts
+    ) const;
+
+    /**
+     * Sets the cached misspellings of the block with the given number and
+     * the index of the dictionary detected for it, returning true if the
+     * block had the given text and had been spell checked when cached.
+     */
+    bool misspellings
+    (
+        int blockNumber,
+        const QString &text,
+        QVector<QPair<int, int>> &misspellings,
+        int &dictionaryIndex
+    ) const;
+
+    /**
+     * Drops the cached misspellings, such as when the dictionaries change.
+     */
+    void discardMisspellings();
+
+    /**
+     * Returns the cached AST, passing ownership of it to the caller, or
+     * nullptr if it was already taken.
+     */
+    MarkdownAST *takeAST();
+
+private:
+    struct Header;
+    struct BlockRecord;
+
+    QFile file;
+    const Header *header;
+    const BlockRecord *blocks;
+    const qint32 *misspellingData;
+    MarkdownAST *ast;
+
+    DocumentCache();
+
+    /*
+    * Returns the record of the block with the given number, or nullptr if
+    * the block did not have the given text when cached.
+    */
+    const BlockRecord *block(int blockNumber, const QString &text) const;
+
+    /*
+    * Returns the path of the cache file of the document at the given
+    * absolute file path.
+    */
+    static QString cacheFilePath(const QString &filePath);
+
+    /*
+    * Returns the SHA-1 hash of the contents of the file at the given path,
+    * or an empty array if the file cannot be read.
+    */
+    static QByteArray contentHash(const QString &filePath);
+};
+} // namespace ghostwriter
+
+#endif // DOCUMENT_CACHE_H
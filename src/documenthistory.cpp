@@ -17,13 +17,19 @@
  *
  ***********************************************************************/
 
-#include <QString>
-#include <QStringList>
-#include <QList>
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QFutureWatcher>
+#include <QList>
+#include <QSet>
 #include <QSettings>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
 
 #include "documenthistory.h"
+#include "taskscheduler.h"
 
 #define MAX_FILE_HISTORY_SIZE 20
 #define FILE_HISTORY_KEY "FileHistory"
@@ -49,30 +55,146 @@ public:
 
 typedef QList<RecentFile> RecentFilesList;
 
-RecentFilesList loadFromSettings(int max = -1);
-void storeToSettings(const RecentFilesList &recentFiles);
-void cleanUpHistory(RecentFilesList &recentFiles);
+class DocumentHistoryPrivate
+{
+    Q_DECLARE_PUBLIC(DocumentHistory)
+
+public:
+    // Time, in milliseconds, to wait for further changes before writing
+    // the history to the settings.
+    static const int STORE_DELAY = 2000;
 
+    // Minimum time, in milliseconds, between checks for missing files.
+    static const int CHECK_INTERVAL = 5000;
+
+    DocumentHistoryPrivate(DocumentHistory *q_ptr)
+        : q_ptr(q_ptr),
+          checkInProgress(false)
+    {
+        ;
+    }
+
+    ~DocumentHistoryPrivate()
+    {
+        ;
+    }
+
+    static DocumentHistory *instance;
+    DocumentHistory *q_ptr;
+    RecentFilesList recentFiles;
+    QTimer *storeTimer;
+    QFutureWatcher<QStringList> *checkWatcher;
+    bool checkInProgress;
+    QElapsedTimer lastCheck;
+
+    /*
+    * Reads the history from the settings.
+    */
+    void load();
+
+    /*
+    * Writes the history to the settings.
+    */
+    void store();
+
+    /*
+    * Schedules writing the history to the settings, coalescing it with
+    * any other changes made in the meantime.
+    */
+    void scheduleStore();
+
+    /*
+    * Starts checking for missing recent files in the background, unless
+    * a check is in progress or one was made too recently.
+    */
+    void checkFiles();
+
+    /*
+    * Drops the files found missing by the background check from the
+    * history.
+    */
+    void onCheckFinished();
+
+    /*
+    * Removes entries beyond the maximum history size.
+    */
+    void cleanUpHistory();
+
+    /*
+    * Returns the paths among those given that no longer exist.  This is
+    * run on the thread pool.
+    */
+    static QStringList findMissingFiles(const QStringList &filePaths);
+};
+
+DocumentHistory *DocumentHistoryPrivate::instance = nullptr;
+
+DocumentHistory *DocumentHistory::instance()
+{
+    if (nullptr == DocumentHistoryPrivate::instance) {
+        DocumentHistoryPrivate::instance = new DocumentHistory();
+    }
+
+    return DocumentHistoryPrivate::instance;
+}
 
 DocumentHistory::DocumentHistory()
+    : d_ptr(new DocumentHistoryPrivate(this))
 {
-    ;
+    Q_D(DocumentHistory);
+
+    d->storeTimer = new QTimer(this);
+    d->storeTimer->setSingleShot(true);
+    d->storeTimer->setInterval(DocumentHistoryPrivate::STORE_DELAY);
+
+    this->connect
+    (
+        d->storeTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->store();
+        }
+    );
+
+    d->checkWatcher = new QFutureWatcher<QStringList>(this);
+
+    this->connect
+    (
+        d->checkWatcher,
+        &QFutureWatcher<QStringList>::finished,
+        [d]() {
+            d->onCheckFinished();
+        }
+    );
+
+    // Write any pending changes before the application exits.
+    this->connect(qApp, &QCoreApplication::aboutToQuit, this, &DocumentHistory::flush);
+
+    d->load();
+    d->checkFiles();
 }
 
 DocumentHistory::~DocumentHistory()
 {
-    ;
+    flush();
 }
 
 QStringList DocumentHistory::recentFiles(int max)
 {
-    RecentFilesList recentFiles = loadFromSettings(max);
+    Q_D(DocumentHistory);
+
     QStringList filePathList;
 
-    for (int i = 0; i < recentFiles.size(); i++) {
-        filePathList.append(recentFiles.at(i).filePath);
+    if (max < 0) {
+        max = d->recentFiles.size();
+    }
+
+    for (int i = 0; (i < d->recentFiles.size()) && (i < max); i++) {
+        filePathList.append(d->recentFiles.at(i).filePath);
     }
 
+    d->checkFiles();
+
     return filePathList;
 }
 
@@ -82,31 +204,33 @@ void DocumentHistory::add
     int cursorPosition
 )
 {
+    Q_D(DocumentHistory);
+
     QFileInfo fileInfo(filePath);
 
     if (fileInfo.exists()) {
         QString sanitizedPath = fileInfo.canonicalFilePath();
-        RecentFilesList recentFiles = loadFromSettings();
         RecentFile lastFile;
 
         lastFile.filePath = sanitizedPath;
         lastFile.position = cursorPosition;
-        recentFiles.removeAll(lastFile);
-        recentFiles.prepend(lastFile);
-        cleanUpHistory(recentFiles);
-        storeToSettings(recentFiles);
+        d->recentFiles.removeAll(lastFile);
+        d->recentFiles.prepend(lastFile);
+        d->cleanUpHistory();
+        d->scheduleStore();
+
+        emit recentFilesChanged();
     }
 }
 
 int DocumentHistory::cursorPosition(const QString &filePath)
 {
+    Q_D(DocumentHistory);
+
     QString sanitizedPath = QFileInfo(filePath).canonicalFilePath();
     int position = 0;
 
-    RecentFilesList recentFiles = loadFromSettings();
-    cleanUpHistory(recentFiles);
-
-    foreach (RecentFile file, recentFiles) {
+    foreach (const RecentFile &file, d->recentFiles) {
         if (sanitizedPath == file.filePath) {
             position = file.position;
             break;
@@ -122,47 +246,50 @@ int DocumentHistory::cursorPosition(const QString &filePath)
 
 void DocumentHistory::clear()
 {
-    QSettings settings;
-    settings.remove(FILE_HISTORY_KEY);
+    Q_D(DocumentHistory);
+
+    d->recentFiles.clear();
+    d->scheduleStore();
+
+    emit recentFilesChanged();
 }
 
-RecentFilesList loadFromSettings(int max)
+void DocumentHistory::flush()
 {
-    QSettings settings;
-    int size = settings.beginReadArray(FILE_HISTORY_KEY);
+    Q_D(DocumentHistory);
 
-    RecentFilesList recentFiles;
-
-    if (max < 0) {
-        max = size;
+    if (d->storeTimer->isActive()) {
+        d->storeTimer->stop();
+        d->store();
     }
+}
+
+void DocumentHistoryPrivate::load()
+{
+    QSettings settings;
+    int size = settings.beginReadArray(FILE_HISTORY_KEY);
 
-    int filesAdded = 0;
+    recentFiles.clear();
 
-    for (int i = 0; (i < size) && (filesAdded < max); i++) {
+    for (int i = 0; i < size; i++) {
         settings.setArrayIndex(i);
 
         QString filePath = settings.value(FILE_PATH_KEY).toString();
         int position = settings.value(CURSOR_POSITION_KEY, 0).toInt();
 
-        if (!filePath.isNull() && !filePath.isEmpty() && QFileInfo(filePath).exists()) {
+        if (!filePath.isNull() && !filePath.isEmpty()) {
             RecentFile recentFile;
             recentFile.filePath = filePath;
             recentFile.position = position;
             recentFiles.append(recentFile);
-            filesAdded++;
         }
     }
 
     settings.endArray();
-
-    return recentFiles;
+    cleanUpHistory();
 }
 
-void storeToSettings
-(
-    const RecentFilesList &recentFiles
-)
+void DocumentHistoryPrivate::store()
 {
     QSettings settings;
 
@@ -174,7 +301,7 @@ void storeToSettings
     settings.beginWriteArray(FILE_HISTORY_KEY, recentFiles.size());
 
     for (int i = 0; i < recentFiles.size(); i++) {
-        RecentFile recentFile = recentFiles.at(i);
+        const RecentFile &recentFile = recentFiles.at(i);
 
         settings.setArrayIndex(i);
         settings.setValue(FILE_PATH_KEY, recentFile.filePath);
@@ -188,13 +315,83 @@ void storeToSettings
     settings.endArray();
 }
 
-void cleanUpHistory
-(
-    RecentFilesList &recentFiles
-)
+void DocumentHistoryPrivate::scheduleStore()
+{
+    if (!storeTimer->isActive()) {
+        storeTimer->start();
+    }
+}
+
+void DocumentHistoryPrivate::checkFiles()
+{
+    if
+    (
+        checkInProgress
+        || recentFiles.isEmpty()
+        || (lastCheck.isValid() && (lastCheck.elapsed() < CHECK_INTERVAL))
+    ) {
+        return;
+    }
+
+    QStringList filePaths;
+
+    foreach (const RecentFile &file, recentFiles) {
+        filePaths.append(file.filePath);
+    }
+
+    checkInProgress = true;
+    checkWatcher->setFuture
+    (
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Indexing,
+            [filePaths]() {
+                return findMissingFiles(filePaths);
+            }
+        )
+    );
+}
+
+void DocumentHistoryPrivate::onCheckFinished()
+{
+    Q_Q(DocumentHistory);
+
+    checkInProgress = false;
+    lastCheck.start();
+
+    QSet<QString> missingFiles = checkWatcher->result().toSet();
+    bool changed = false;
+
+    for (int i = recentFiles.size() - 1; i >= 0; i--) {
+        if (missingFiles.contains(recentFiles.at(i).filePath)) {
+            recentFiles.removeAt(i);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        scheduleStore();
+        emit q->recentFilesChanged();
+    }
+}
+
+void DocumentHistoryPrivate::cleanUpHistory()
 {
     while (recentFiles.size() > MAX_FILE_HISTORY_SIZE) {
         recentFiles.removeLast();
     }
 }
-}
\ No newline at end of file
+
+QStringList DocumentHistoryPrivate::findMissingFiles(const QStringList &filePaths)
+{
+    QStringList missingFiles;
+
+    foreach (const QString &filePath, filePaths) {
+        if (!QFileInfo(filePath).exists()) {
+            missingFiles.append(filePath);
+        }
+    }
+
+    return missingFiles;
+}
+}
@@ -21,7 +21,7 @@
 #define DOCUMENTHISTORY_H
 
 #include <QObject>
-#include <QHash>
+#include <QScopedPointer>
 #include <QString>
 #include <QStringList>
 
@@ -29,16 +29,25 @@ namespace ghostwriter
 {
 /**
  * This class stores and retrieves recent file history using QSettings.
- * It is reentrant, and different instances can be used from anywhere to
- * access the same file history.
+ * The history is read from the settings once and cached for the whole
+ * process.  Changes are written back in batches after a short delay, and
+ * when the application quits.  Recent files that no longer exist are
+ * detected in the background, after which recentFilesChanged() is
+ * emitted, so that slow file systems do not stall the caller.
+ *
+ * The history is meant to be used from the main thread only.
  */
-class DocumentHistory
+class DocumentHistoryPrivate;
+class DocumentHistory : public QObject
 {
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(DocumentHistory)
+
 public:
     /**
-     * Constructor.
+     * Gets the singleton instance of this class.
      */
-    DocumentHistory();
+    static DocumentHistory *instance();
 
     /**
      * Destructor.
@@ -47,7 +56,9 @@ public:
 
     /**
      * Returns the list of recent files, up to the maximum number specified.
-     * Specify a value of -1 to get the entire history.
+     * Specify a value of -1 to get the entire history.  Files that have
+     * gone missing since last checked may still be listed until the
+     * background check removes them.
      */
     QStringList recentFiles(int max = -1);
 
@@ -68,11 +79,22 @@ public:
      */
     void clear();
 
+public slots:
+    /**
+     * Writes pending changes to the settings right away.
+     */
+    void flush();
+
 signals:
     /**
      * Emitted when a recent file is added/removed from the history.
      */
     void recentFilesChanged();
+
+private:
+    QScopedPointer<DocumentHistoryPrivate> d_ptr;
+
+    DocumentHistory();
 };
 }
 
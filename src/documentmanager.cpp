@@ -17,8 +17,14 @@
  *
  ***********************************************************************/
 
+#include <limits>
+
 #include <QApplication>
+#include <QAtomicInt>
+#include <QCryptographicHash>
+#include <QDesktopServices>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
@@ -27,21 +33,35 @@
 #include <QFutureWatcher>
 #include <QMessageBox>
 #include <QPair>
+#include <QScopedPointer>
+#include <QStorageInfo>
 #include <QString>
-#include <QtConcurrentRun>
+#include <QTextBlock>
+#include <QTextCodec>
+#include <QTextCursor>
 #include <QTextDocument>
-#include <QTextStream>
 #include <QTimer>
+#include <QUrl>
 
+#include "appsettings.h"
+#include "documentcache.h"
 #include "documenthistory.h"
 #include "documentmanager.h"
+#include "documentwriter.h"
+#include "editjournal.h"
 #include "exportdialog.h"
 #include "exporter.h"
 #include "exporterfactory.h"
+#include "exportjobmanager.h"
+#include "exportonsave.h"
+#include "linediff.h"
 #include "markdowndocument.h"
 #include "markdowneditor.h"
 #include "messageboxhelper.h"
+#include "spelling/dictionary_manager.h"
+#include "taskscheduler.h"
 #include "themerepository.h"
+#include "tracer.h"
 
 namespace ghostwriter
 {
@@ -65,10 +85,37 @@ public:
 
     }
 
+    /*
+    * Result of reading a file from disk in readFromDisk().
+    */
+    struct ReadResult
+    {
+        QString text;
+        QString error;
+        bool cancelled;
+        QByteArray textHash;
+        QSharedPointer<DocumentCache> cache;
+
+        ReadResult() : cancelled(false) { }
+    };
+
+    struct ReloadResult
+    {
+        QString error;
+        QStringList lines;
+        QVector<LineDiff::Hunk> hunks;
+        QByteArray textHash;
+        bool diffable;
+
+        ReloadResult() : diffable(false) { }
+    };
+
     DocumentManager *q_ptr;
     MarkdownDocument *document;
     MarkdownEditor *editor;
     QFutureWatcher<QString> *saveFutureWatcher;
+    QFutureWatcher<ReadResult> *readFutureWatcher;
+    ExportJobManager *exportJobManager;
     QFileSystemWatcher *fileWatcher;
     bool fileHistoryEnabled;
     bool createBackupOnSave;
@@ -87,6 +134,58 @@ public:
     QTimer *autoSaveTimer;
     bool autoSaveEnabled;
 
+    /*
+    * Auto-saving adapts to how much and how the document is edited, to
+    * keep disk writes down on slow or metered storage.  The document is
+    * auto-saved once the user pauses typing, either after editing at
+    * least AUTOSAVE_EDIT_VOLUME characters, or after the auto-save
+    * interval elapsed since the last save.  That interval starts at
+    * AUTOSAVE_INTERVAL and grows by as much again for every
+    * AUTOSAVE_SIZE_STEP characters of the document, up to
+    * AUTOSAVE_MAX_INTERVAL, since large files take longer to write.
+    * Auto-saves are never AUTOSAVE_MIN_INTERVAL apart or less, and are
+    * made regardless of typing once AUTOSAVE_MAX_INTERVAL elapsed.  All
+    * times are in milliseconds.
+    */
+    static const int AUTOSAVE_POLL_INTERVAL = 10000;
+    static const int AUTOSAVE_MIN_INTERVAL = 10000;
+    static const int AUTOSAVE_INTERVAL = 60000;
+    static const int AUTOSAVE_MAX_INTERVAL = 600000;
+    static const int AUTOSAVE_EDIT_VOLUME = 2000;
+    static const int AUTOSAVE_SIZE_STEP = 1024 * 1024;
+    QElapsedTimer lastAutoSaveTimer;
+    qint64 unsavedEditVolume;
+    int editVolumeRevision;
+    bool typing;
+
+    /*
+    * When auto-saving to a journal is enabled, edits are appended to an
+    * edit journal next to the file, and auto-saving only writes the
+    * journal to disk.  The file itself is only written on an explicit
+    * save or when the file is closed.  savingFilePath is the path of the
+    * file being saved asynchronously, since the document may be closed
+    * before the save completes.
+    */
+    bool autoSaveJournalEnabled;
+    EditJournal journal;
+    int journaledRevision;
+    QString savingFilePath;
+
+    /*
+    * Documents chosen to be exported whenever they are saved (see
+    * ExportOnSave) are exported in the background once saved.  The text
+    * of the save is kept for the export, and saves less than
+    * EXPORT_ON_SAVE_DELAY milliseconds apart are exported once.  Should
+    * an export fail, the user is told only once until one succeeds
+    * again, rather than on every save.
+    */
+    static const int EXPORT_ON_SAVE_DELAY = 1000;
+    QString savingText;
+    QString exportOnSaveText;
+    QString exportOnSaveFilePath;
+    QTimer *exportOnSaveTimer;
+    bool exportOnSaveFailed;
+
     /*
     * Boolean flag used to track if the prompt for the file having been
     * externally modified is already displayed and should not be displayed
@@ -94,6 +193,108 @@ public:
     */
     bool documentModifiedNotifVisible;
 
+    /*
+    * Hash of the text of the file as last loaded or saved, against which
+    * the file's text is compared when the file watcher reports a change,
+    * since sync tools often touch files without changing them.  The hash
+    * of a save is set by the save worker, and is only read once the save
+    * has completed.  Watcher events are debounced by
+    * FILE_CHANGE_DEBOUNCE_INTERVAL milliseconds, as editors and sync tools
+    * often write a file in several steps.
+    */
+    static const int FILE_CHANGE_DEBOUNCE_INTERVAL = 500;
+    QByteArray fileTextHash;
+    QByteArray savingTextHash;
+    QString changedFilePath;
+    QTimer *fileChangeTimer;
+    QFutureWatcher<QByteArray> *fileChangeWatcher;
+
+    /*
+    * Files with more characters than this are loaded progressively: the
+    * first screen of text is shown right away, and the rest is appended
+    * in chunks from the event loop, for at most LOAD_BATCH_TIME
+    * milliseconds at a time.
+    */
+    static const int PROGRESSIVE_LOAD_SIZE = 256 * 1024;
+    static const int LOAD_CHUNK_SIZE = 256 * 1024;
+    static const int LOAD_BATCH_TIME = 20;
+
+    /*
+    * Files are read from disk on a worker thread, READ_CHUNK_SIZE bytes
+    * at a time, so that slow (e.g., network) drives don't block the GUI.
+    * The progress of the read is reported every READ_PROGRESS_INTERVAL
+    * milliseconds.
+    */
+    static const int READ_CHUNK_SIZE = 1024 * 1024;
+    static const int READ_PROGRESS_INTERVAL = 100;
+
+    /*
+    * UTF-8 files of at least this many bytes on local drives are mapped
+    * into memory and decoded straight from the mapping, which saves
+    * copying the whole file into a buffer first.
+    */
+    static const int MAP_MIN_SIZE = 1024 * 1024;
+
+    /*
+    * Files of at least this many bytes would take several times their
+    * size in memory once loaded into the editor, so they are handed to
+    * the read-only viewer instead.
+    */
+    static const qint64 HUGE_FILE_SIZE = 128 * 1024 * 1024;
+
+    /*
+    * State of a load.  While the file is being read, the current document
+    * is left in place, and readCancelled tells the worker thread to stop
+    * reading.  Once the file has been read, its text is set into the
+    * document, progressively if it is large: loadTextPosition is how much
+    * of the text has been appended to the document so far.  The cursor
+    * is placed at loadCursorPosition once it has all been appended (or at
+    * the position from the file history if -1).  The editor is read-only
+    * for the duration of the load.
+    */
+    bool loadInProgress;
+    bool loadReading;
+    QString loadFilePath;
+    QAtomicInt readCancelled;
+    QAtomicInteger<qint64> readBytes;
+    qint64 readSize;
+    QTimer *readProgressTimer;
+    QString loadText;
+    int loadTextPosition;
+    int loadCursorPosition;
+    bool loadRecovered;
+    QTimer *loadTimer;
+
+    /*
+    * Position that the cursor of a progressive load is placed at, and
+    * whether the cursor was placed there already.  The cursor is placed
+    * as soon as the text around it has been appended, so that the region
+    * of the document last worked on is shown without waiting for the rest
+    * of the document.
+    */
+    int loadTargetPosition;
+    bool loadNavigated;
+
+    /*
+    * Disk cache of the AST, statistics and misspellings of the file being
+    * loaded, if it has one and the file is unchanged since.  Parsing is
+    * suspended for the duration of the load, after which the cached AST
+    * is published rather than parsed anew.
+    */
+    QSharedPointer<DocumentCache> loadCache;
+
+    /*
+    * A reload diffs the file's text against the document's on a worker,
+    * and then replaces only the lines that changed in a single edit, so
+    * that the rest of the document need not be parsed, highlighted and
+    * counted again, and so that the reload can be undone.  The diff is
+    * dropped in favor of a full load if the document changed meanwhile.
+    */
+    QFutureWatcher<ReloadResult> *reloadFutureWatcher;
+    QString reloadFilePath;
+    int reloadRevision;
+    int reloadCursorPosition;
+
     /*
     * Begins asynchronous save operation.  Called by save() and saveAs().
     */
@@ -101,12 +302,122 @@ public:
 
     void onSaveCompleted();
 
+    /*
+    * Queues the export of the last saved text, if the saved document is
+    * to be exported whenever it is saved.
+    */
+    void exportOnSave();
+
     void onFileChangedExternally(const QString &path);
 
     /*
-    * Loads the document with the file contents at the given path.
+    * Handles a change to the file reported by the file watcher once the
+    * file has settled, checking whether its text really changed.
+    */
+    void checkFileChange();
+
+    /*
+    * Prompts to reload the document once the file's text is found to
+    * have changed.
+    */
+    void onFileChangeChecked();
+
+    /*
+    * Begins loading the document with the file contents at the given
+    * path, placing the text cursor at the given position once loaded.
+    * If the position is negative, the cursor is placed at the position
+    * remembered in the file history instead.  The file is loaded after
+    * this method returns, and the current document is left in place
+    * if it cannot be read.
+    */
+    void loadFile(const QString &filePath, int cursorPosition = -1);
+
+    /*
+    * Begins reloading the document from its file, falling back on
+    * loadFile() whenever the changes cannot be applied as a diff.
+    */
+    void reloadFile(int cursorPosition);
+
+    void onReloadCompleted();
+
+    /*
+    * Replaces the lines of the document covered by the given hunks with
+    * the given new lines, as a single undoable edit.
+    */
+    void applyHunks
+    (
+        const QVector<LineDiff::Hunk> &hunks,
+        const QStringList &lines
+    );
+
+    /*
+    * Reads and decodes the file at the given path.  Note that this
+    * method is intended to be run in a separate thread from the main
+    * Qt event loop, and should thus never interact with any widgets.
+    */
+    ReadResult readFromDisk(const QString &filePath);
+
+    /*
+    * Maps the given open file into memory and decodes it if it is UTF-8
+    * encoded, returning true if successful.  Returns false if the file
+    * should be read by other means instead.  Intended to be run in a
+    * separate thread from the main Qt event loop like readFromDisk().
+    */
+    bool readMappedFile(QFile &inputFile, ReadResult &result);
+
+    /*
+    * Sets the text read by readFromDisk() into the document, or reports
+    * the error if the file could not be read.
+    */
+    void onReadCompleted();
+
+    /*
+    * Sets the text of the file being loaded into the document, appending
+    * it progressively if it is large.
+    */
+    void setLoadedText(const QString &text);
+
+    /*
+    * Appends the next chunks of text of a progressive load to the
+    * document.
+    */
+    void loadNextChunks();
+
+    /*
+    * Appends the rest of the text of a progressive load to the document
+    * at once.  Call before anything that needs the entire document.
+    */
+    void completeLoad();
+
+    /*
+    * Abandons a progressive load, leaving the document only partially
+    * loaded.
+    */
+    void cancelLoad();
+
+    /*
+    * Finishes loading the document once all its text is in place.
+    */
+    void finishLoad();
+
+    /*
+    * Places the cursor of a freshly loaded document where it was left
+    * when the document was last closed.
+    */
+    void navigateLoadedDocument();
+
+    /*
+    * Places the cursor of a progressive load at the target position once
+    * the text around it has been appended.
+    */
+    void navigateLoadTarget();
+
+    /*
+    * Returns the length of the text of a progressive load to append in
+    * one go starting from the given position, which is at least the
+    * given length, extended to the end of its last line.
     */
-    bool loadFile(const QString &filePath);
+    int loadChunkLength(int position, int length) const;
 
     /*
     * Sets the file path for the document, such that the file will be
@@ -130,27 +441,76 @@ public:
     bool checkPermissionsBeforeSave();
 
     /*
-    * Saves the given text to the given file path, returning a null
-    * string if successful, otherwise an error message.  Note that this
-    * method is intended to be run in a separate thread from the main
-    * Qt event loop, and should thus never interact with any widgets.
+    * Returns a hash of the given text, ignoring carriage returns, since
+    * saving writes native line endings.
     */
-    QString saveToDisk
-    (
-        const QString &filePath,
-        const QString &text,
-        bool createBackup
-    ) const;
+    static QByteArray textHash(const QString &text);
 
     /*
-    * Creates a backup file with a ".backup" extension of the file having
-    * the specified path.  Note that this method is intended to be run in
-    * a separate thread from the main Qt event loop, and should thus never
-    * interact with any widgets.
+    * Reads and decodes the file at the given path as readFromDisk() does,
+    * returning the hash of its text, or an empty array if it cannot be
+    * read.  This method is meant to run on a worker thread.
     */
-    void backupFile(const QString &filePath) const;
+    static QByteArray readTextHash(const QString &filePath);
 
     void autoSaveFile();
+
+    /*
+    * Returns the auto-save interval for the current document size.
+    */
+    qint64 autoSaveInterval() const;
+
+    /*
+    * Adds an edit to the volume of unsaved edits.
+    */
+    void countEdit(int charsRemoved, int charsAdded);
+
+    /*
+    * Starts counting the edits and time to the next auto-save over.
+    */
+    void resetAutoSave();
+
+    /*
+    * Returns true if the edits to the document should be journaled.
+    */
+    bool journalWanted() const;
+
+    /*
+    * Starts or stops journaling the edits made to the document as needed
+    * after a setting or the document changes.
+    */
+    void updateJournal();
+
+    /*
+    * Stops journaling the edits made to the document, deleting the
+    * journal unless the document is being saved, in which case the
+    * journal is deleted once saving completes.
+    */
+    void closeJournal();
+
+    /*
+    * Appends the given edit to the document to the edit journal.
+    */
+    void journalEdit(int position, int charsRemoved, int charsAdded);
+
+    /*
+    * Replays the edits from the journal left by a previous session for
+    * the file being loaded onto the given text of the file, if the user
+    * chooses to recover them.  Returns true if the edits were replayed.
+    */
+    bool recoverFromJournal(QString &text);
+
+    /*
+    * Returns the key identifying the dictionaries that the spelling of the
+    * document is checked against, under which its misspellings are cached.
+    */
+    QString spellingKey() const;
+
+    /*
+    * Saves the disk cache of the current document, unless it is still
+    * being loaded.
+    */
+    void saveDocumentCache();
 };
 
 const QString DocumentManagerPrivate::FILE_CHOOSER_FILTER =
@@ -173,15 +533,188 @@ DocumentManager::DocumentManager
     d->createBackupOnSave = true;
     d->saveInProgress = false;
     d->autoSaveEnabled = false;
+    d->autoSaveJournalEnabled = false;
+    d->journaledRevision = -1;
     d->documentModifiedNotifVisible = false;
+    d->fileChangeTimer = new QTimer(this);
+    d->fileChangeTimer->setSingleShot(true);
+    d->fileChangeTimer->setInterval(DocumentManagerPrivate::FILE_CHANGE_DEBOUNCE_INTERVAL);
+
+    this->connect
+    (
+        d->fileChangeTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->checkFileChange();
+        }
+    );
+
+    d->fileChangeWatcher = new QFutureWatcher<QByteArray>(this);
+
+    this->connect
+    (
+        d->fileChangeWatcher,
+        &QFutureWatcher<QByteArray>::finished,
+        [d]() {
+            d->onFileChangeChecked();
+        }
+    );
+    d->loadInProgress = false;
+    d->loadReading = false;
+    d->readSize = 0;
+    d->loadTextPosition = 0;
+    d->loadCursorPosition = -1;
+    d->loadRecovered = false;
+    d->loadTargetPosition = 0;
+    d->loadNavigated = false;
     d->saveFutureWatcher = new QFutureWatcher<QString>(this);
+    d->readFutureWatcher = new QFutureWatcher<DocumentManagerPrivate::ReadResult>(this);
+    d->reloadFutureWatcher = new QFutureWatcher<DocumentManagerPrivate::ReloadResult>(this);
+    d->reloadRevision = -1;
+    d->reloadCursorPosition = 0;
+
+    this->connect
+    (
+        d->reloadFutureWatcher,
+        &QFutureWatcher<DocumentManagerPrivate::ReloadResult>::finished,
+        [d]() {
+            d->onReloadCompleted();
+        }
+    );
+
+    this->connect
+    (
+        d->readFutureWatcher,
+        &QFutureWatcher<DocumentManagerPrivate::ReadResult>::finished,
+        [d]() {
+            d->onReadCompleted();
+        }
+    );
+
+    d->readProgressTimer = new QTimer(this);
+    d->readProgressTimer->setInterval(DocumentManagerPrivate::READ_PROGRESS_INTERVAL);
+
+    this->connect
+    (
+        d->readProgressTimer,
+        &QTimer::timeout,
+        [this, d]() {
+            if (d->readSize > 0) {
+                int percent = (int) ((100.0 * d->readBytes.loadAcquire()) / d->readSize);
+
+                emit operationUpdate
+                (
+                    tr("reading %1 (%2%)")
+                        .arg(d->loadFilePath)
+                        .arg(qMin(percent, 100))
+                );
+            }
+        }
+    );
+
+    d->loadTimer = new QTimer(this);
+    d->loadTimer->setInterval(0);
+
+    this->connect
+    (
+        d->loadTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->loadNextChunks();
+        }
+    );
+
+    d->exportJobManager = new ExportJobManager(this);
+
+    connect(d->exportJobManager, SIGNAL(exportStarted(QString)), this, SIGNAL(operationStarted(QString)));
+    connect(d->exportJobManager, SIGNAL(allExportsFinished()), this, SIGNAL(operationFinished()));
+
+    this->connect
+    (
+        d->exportJobManager,
+        &ExportJobManager::exportSucceeded,
+        [](const QString &outputFilePath) {
+            QDesktopServices::openUrl(QUrl::fromLocalFile(outputFilePath));
+        }
+    );
+
+    this->connect
+    (
+        d->exportJobManager,
+        &ExportJobManager::exportFailed,
+        [d](const QString &outputFilePath, const QString &err) {
+            Q_UNUSED(outputFilePath)
+
+            MessageBoxHelper::critical(d->editor, tr("Export failed."), err);
+        }
+    );
+
+    d->exportOnSaveFailed = false;
+    d->exportOnSaveTimer = new QTimer(this);
+    d->exportOnSaveTimer->setSingleShot(true);
+    d->exportOnSaveTimer->setInterval(DocumentManagerPrivate::EXPORT_ON_SAVE_DELAY);
+
+    this->connect
+    (
+        d->exportOnSaveTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->exportOnSave();
+        }
+    );
+
+    this->connect
+    (
+        d->exportJobManager,
+        &ExportJobManager::saveExportFinished,
+        [d](const QString &outputFilePath, const QString &err) {
+            if (err.isNull()) {
+                d->exportOnSaveFailed = false;
+            } else if (!d->exportOnSaveFailed) {
+                d->exportOnSaveFailed = true;
+
+                MessageBoxHelper::critical
+                (
+                    d->editor,
+                    tr("Export on save to %1 failed.").arg(outputFilePath),
+                    err
+                );
+            }
+        }
+    );
 
     d->fileWatcher = new QFileSystemWatcher(this);
     d->document = (MarkdownDocument *) editor->document();
 
-    // Set up auto-save timer to save the file once every minute.
+    // Set up auto-save timer to check whether the file is due for saving.
+    // The exact second does not matter, so let the system batch the
+    // wakeups with those of other timers.
     d->autoSaveTimer = new QTimer(this);
-    d->autoSaveTimer->start(60000);
+    d->autoSaveTimer->setTimerType(Qt::VeryCoarseTimer);
+    d->autoSaveTimer->start(DocumentManagerPrivate::AUTOSAVE_POLL_INTERVAL);
+    d->unsavedEditVolume = 0;
+    d->editVolumeRevision = -1;
+    d->typing = false;
+    d->lastAutoSaveTimer.start();
+
+    this->connect
+    (
+        editor,
+        &MarkdownEditor::typingResumed,
+        [d]() {
+            d->typing = true;
+        }
+    );
+
+    this->connect
+    (
+        editor,
+        &MarkdownEditor::typingPaused,
+        [d]() {
+            d->typing = false;
+            d->autoSaveFile();
+        }
+    );
 
     this->connect
     (
@@ -209,6 +742,16 @@ DocumentManager::DocumentManager
         }
     );
 
+    this->connect
+    (
+        d->document,
+        &MarkdownDocument::contentsChange,
+        [d](int position, int charsRemoved, int charsAdded) {
+            d->countEdit(charsRemoved, charsAdded);
+            d->journalEdit(position, charsRemoved, charsAdded);
+        }
+    );
+
     this->connect
     (
         d->saveFutureWatcher,
@@ -232,7 +775,11 @@ DocumentManager::~DocumentManager()
 {
     Q_D(DocumentManager);
     
+    d->readCancelled.storeRelease(1);
+    d->readFutureWatcher->waitForFinished();
     d->saveFutureWatcher->waitForFinished();
+    d->fileChangeWatcher->waitForFinished();
+    d->reloadFutureWatcher->waitForFinished();
 }
 
 MarkdownDocument *DocumentManager::document() const
@@ -256,6 +803,20 @@ bool DocumentManager::fileBackupEnabled() const
     return d->createBackupOnSave;
 }
 
+bool DocumentManager::isLoading() const
+{
+    Q_D(const DocumentManager);
+
+    return d->loadInProgress;
+}
+
+bool DocumentManager::isExporting() const
+{
+    Q_D(const DocumentManager);
+
+    return d->exportJobManager->isBusy();
+}
+
 void DocumentManager::setFileHistoryEnabled(bool enabled)
 {
     Q_D(DocumentManager);
@@ -274,6 +835,16 @@ void DocumentManager::setAutoSaveEnabled(bool enabled)
     } else if (d->document->isModified()) {
         d->document->setModified(false);
     }
+
+    d->updateJournal();
+}
+
+void DocumentManager::setAutoSaveJournalEnabled(bool enabled)
+{
+    Q_D(DocumentManager);
+
+    d->autoSaveJournalEnabled = enabled;
+    d->updateJournal();
 }
 
 void DocumentManager::setFileBackupEnabled(bool enabled)
@@ -283,10 +854,27 @@ void DocumentManager::setFileBackupEnabled(bool enabled)
     d->createBackupOnSave = enabled;
 }
 
-void DocumentManager::open(const QString &filePath)
+void DocumentManager::open(const QString &filePath, int position)
 {
     Q_D(DocumentManager);
-    
+
+    if
+    (
+        (position >= 0)
+        && !d->loadInProgress
+        && !d->document->isNew()
+        && (d->document->filePath() == filePath)
+    ) {
+        d->editor->navigateDocument(position);
+        return;
+    }
+
+    // Don't ask to save changes to a document that won't be replaced.
+    if (!filePath.isEmpty() && (QFileInfo(filePath).size() >= DocumentManagerPrivate::HUGE_FILE_SIZE)) {
+        emit hugeFileOpened(filePath);
+        return;
+    }
+
     if (d->checkSaveChanges()) {
         QString path;
 
@@ -323,27 +911,33 @@ void DocumentManager::open(const QString &filePath)
                 return;
             }
 
+            if (fileInfo.size() >= DocumentManagerPrivate::HUGE_FILE_SIZE) {
+                emit hugeFileOpened(path);
+                return;
+            }
+
             QString oldFilePath = d->document->filePath();
             int oldCursorPosition = d->editor->textCursor().position();
             bool oldFileWasNew = d-> document->isNew();
-
-            if (!d->loadFile(path)) {
-                // The error dialog should already have been displayed
-                // in loadFile().
-                //
-                return;
-            } else if (oldFilePath == d->document->filePath()) {
-                d->editor->navigateDocument(oldCursorPosition);
-            } else if (d->fileHistoryEnabled) {
-                if (!oldFileWasNew) {
-                    DocumentHistory history;
-                    history.add
-                    (
-                        oldFilePath,
-                        oldCursorPosition
-                    );
-                }
+            bool sameFile = !oldFileWasNew && (oldFilePath == path);
+
+            // Remember the old file's cursor position now, since the
+            // new file is loaded asynchronously.  Should the new file fail
+            // to load, the old file will simply remain open.
+            //
+            if (!sameFile && !oldFileWasNew && !d->loadInProgress && d->fileHistoryEnabled) {
+                DocumentHistory::instance()->add
+                (
+                    oldFilePath,
+                    oldCursorPosition
+                );
+            }
+
+            if (position < 0) {
+                position = sameFile ? oldCursorPosition : -1;
             }
+
+            d->loadFile(path, position);
         }
     }
 }
@@ -353,8 +947,7 @@ void DocumentManager::reopenLastClosedFile()
     Q_D(DocumentManager);
     
     if (d->fileHistoryEnabled) {
-        DocumentHistory history;
-        QStringList recentFiles = history.recentFiles(2);
+        QStringList recentFiles = DocumentHistory::instance()->recentFiles(2);
 
         if (!d->document->isNew()) {
             recentFiles.removeAll(d->document->filePath());
@@ -389,13 +982,9 @@ void DocumentManager::reload()
             }
         }
 
-        QTextCursor cursor = d->editor->textCursor();
-        int pos = cursor.position();
+        int pos = d->editor->textCursor().position();
 
-        if (d->loadFile(d->document->filePath())) {
-            cursor.setPosition(pos);
-            d->editor->setTextCursor(cursor);
-        }
+        d->reloadFile(pos);
     }
 }
 
@@ -475,6 +1064,18 @@ bool DocumentManager::saveAs()
     return false;
 }
 
+void DocumentManager::cancelLoad()
+{
+    Q_D(DocumentManager);
+
+    if (d->loadReading) {
+        d->cancelLoad();
+    } else if (d->loadInProgress) {
+        // The document is only partially loaded, so it can't be kept.
+        close();
+    }
+}
+
 bool DocumentManager::close()
 {
     Q_D(DocumentManager);
@@ -485,11 +1086,17 @@ bool DocumentManager::close()
         }
 
         // Get the document's information before closing it out
-        // so we can store history information about it.
+        // so we can store history information about it.  A document
+        // that is still loading has no meaningful cursor position yet.
         //
         QString filePath = d->document->filePath();
         int cursorPosition = d->editor->textCursor().position();
         bool documentIsNew = d->document->isNew();
+        bool documentWasLoading = d->loadInProgress;
+
+        d->saveDocumentCache();
+        d->cancelLoad();
+        d->closeJournal();
 
         // Set up a new, untitled document.  Note that the document
         // needs to be wiped clean before emitting the documentClosed()
@@ -507,15 +1114,15 @@ bool DocumentManager::close()
         d->editor->setTextCursor(cursor);
 
         d->document->setPlainText("");
+        d->document->setDocumentCache(QSharedPointer<DocumentCache>());
         d->document->clearUndoRedoStacks();
         d->editor->setReadOnly(false);
         d->document->setReadOnly(false);
         d->setFilePath(QString());
         d->document->setModified(false);
 
-        if (d->fileHistoryEnabled && !documentIsNew) {
-            DocumentHistory history;
-            history.add
+        if (d->fileHistoryEnabled && !documentIsNew && !documentWasLoading) {
+            DocumentHistory::instance()->add
             (
                 filePath,
                 cursorPosition
@@ -530,42 +1137,104 @@ bool DocumentManager::close()
     return false;
 }
 
+void DocumentManager::cancelExports()
+{
+    Q_D(DocumentManager);
+
+    d->exportJobManager->cancelAll();
+}
+
 void DocumentManager::exportFile()
 {
     Q_D(DocumentManager);
     
-    ExportDialog exportDialog(d->document);
-
-    connect(&exportDialog, SIGNAL(exportStarted(QString)), this, SIGNAL(operationStarted(QString)));
-    connect(&exportDialog, SIGNAL(exportComplete()), this, SIGNAL(operationFinished()));
+    d->completeLoad();
 
+    ExportDialog exportDialog(d->document, d->exportJobManager);
     exportDialog.exec();
 }
 
 void DocumentManagerPrivate::onSaveCompleted()
 {
     QString err = this->saveFutureWatcher->result();
+    bool saved = err.isNull() || err.isEmpty();
 
-    if (!err.isNull() && !err.isEmpty()) {
+    if (!saved) {
         MessageBoxHelper::critical
         (
             editor,
             QObject::tr("Error saving %1").arg(this->document->filePath()),
             err
         );
-    } else if (!this->fileWatcher->files().contains(this->document->filePath())) {
-        fileWatcher->addPath(document->filePath());
+    } else {
+        if (savingFilePath == document->filePath()) {
+            fileTextHash = savingTextHash;
+        }
+    }
+
+    DocumentWriter::rewatch(fileWatcher, document->filePath());
+
+    // The saved file has all the journaled edits, so start the journal
+    // over (with any edits made during the save), or delete it if the
+    // document is no longer being journaled.  Should saving have failed,
+    // keep adding to the old journal instead.
+    //
+    if (journalWanted() && (savingFilePath == document->filePath())) {
+        journal.start(savingFilePath, !saved);
+    } else if (saved) {
+        if (journal.filePath() == savingFilePath) {
+            journal.stop();
+        }
+
+        EditJournal::remove(savingFilePath);
     }
 
     this->document->setTimestamp(QDateTime::currentDateTime());
     this->saveInProgress = false;
+
+    if (saved && !savingText.isNull()) {
+        exportOnSaveText = savingText;
+        exportOnSaveFilePath = savingFilePath;
+        exportOnSaveTimer->start();
+    }
+
+    savingText = QString();
+}
+
+void DocumentManagerPrivate::exportOnSave()
+{
+    ExportOnSave::Target target = ExportOnSave::target(exportOnSaveFilePath);
+
+    if (target.isValid()) {
+        exportJobManager->enqueueOnSave
+        (
+            target.exporter,
+            target.format,
+            exportOnSaveFilePath,
+            exportOnSaveText,
+            target.outputFilePath,
+            target.smartTypographyEnabled
+        );
+    }
+
+    exportOnSaveText = QString();
 }
 
 void DocumentManagerPrivate::onFileChangedExternally(const QString &path)
+{
+    changedFilePath = path;
+    fileChangeTimer->start();
+}
+
+void DocumentManagerPrivate::checkFileChange()
 {
     Q_Q(DocumentManager);
 
-    QFileInfo fileInfo(path);
+    if (changedFilePath != document->filePath()) {
+        return;
+    }
+
+    QFileInfo fileInfo(changedFilePath);
 
     if (!fileInfo.exists()) {
         emit q->documentModifiedChanged(true);
@@ -597,29 +1266,68 @@ void DocumentManagerPrivate::onFileChangedExternally(const QString &path)
         (
             !saveInProgress &&
             (fileInfo.lastModified() > document->timestamp()) &&
-            !documentModifiedNotifVisible
+            !documentModifiedNotifVisible &&
+            !fileChangeWatcher->isRunning()
         ) {
-            documentModifiedNotifVisible = true;
+            QString filePath = changedFilePath;
 
-            int response =
-                MessageBoxHelper::question
+            QFuture<QByteArray> future =
+                TaskScheduler::instance()->run
                 (
-                    editor,
-                    QObject::tr("The document has been modified by another program."),
-                    QObject::tr("Would you like to reload the document?"),
-                    QMessageBox::Yes | QMessageBox::No,
-                    QMessageBox::Yes
+                    TaskScheduler::Interactive,
+                    [filePath]() {
+                        return readTextHash(filePath);
+                    }
                 );
 
-            documentModifiedNotifVisible = false;
-
-            if (QMessageBox::Yes == response) {
-                q->reload();
-            }
+            fileChangeWatcher->setFuture(future);
         }
     }
 }
 
+void DocumentManagerPrivate::onFileChangeChecked()
+{
+    Q_Q(DocumentManager);
+
+    QByteArray hash = fileChangeWatcher->result();
+
+    if
+    (
+        saveInProgress
+        || loadInProgress
+        || documentModifiedNotifVisible
+        || (changedFilePath != document->filePath())
+    ) {
+        return;
+    }
+
+    // The file was only touched.  Catch up with its timestamp so that
+    // it is not read again until it is next modified.
+    //
+    if (!hash.isEmpty() && (hash == fileTextHash)) {
+        document->setTimestamp(QFileInfo(changedFilePath).lastModified());
+        return;
+    }
+
+    documentModifiedNotifVisible = true;
+
+    int response =
+        MessageBoxHelper::question
+        (
+            editor,
+            QObject::tr("The document has been modified by another program."),
+            QObject::tr("Would you like to reload the document?"),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::Yes
+        );
+
+    documentModifiedNotifVisible = false;
+
+    if (QMessageBox::Yes == response) {
+        q->reload();
+    }
+}
+
 void DocumentManagerPrivate::autoSaveFile()
 {
     Q_Q(DocumentManager);
@@ -627,20 +1335,180 @@ void DocumentManagerPrivate::autoSaveFile()
     if
     (
         this->autoSaveEnabled &&
+        !this->loadInProgress &&
         !this->document->isNew() &&
         !this->document->isReadOnly() &&
         this->document->isModified()
     ) {
-        q->save();
+        qint64 elapsed = lastAutoSaveTimer.elapsed();
+
+        if (elapsed < AUTOSAVE_MIN_INTERVAL) {
+            return;
+        }
+
+        bool due = (elapsed >= AUTOSAVE_MAX_INTERVAL)
+            || (
+                !typing
+                && (
+                    (unsavedEditVolume >= AUTOSAVE_EDIT_VOLUME)
+                    || (elapsed >= autoSaveInterval())
+                )
+            );
+
+        if (!due) {
+            return;
+        }
+
+        if (journal.isActive()) {
+            journal.flush();
+            resetAutoSave();
+        } else {
+            q->save();
+        }
+    }
+}
+
+qint64 DocumentManagerPrivate::autoSaveInterval() const
+{
+    qint64 steps = document->characterCount() / AUTOSAVE_SIZE_STEP;
+
+    return qMin<qint64>(AUTOSAVE_INTERVAL * (steps + 1), AUTOSAVE_MAX_INTERVAL);
+}
+
+void DocumentManagerPrivate::countEdit(int charsRemoved, int charsAdded)
+{
+    // Rehighlighting the document also signals a change to its contents,
+    // but without changing its revision.
+    //
+    if (loadInProgress || (document->revision() == editVolumeRevision)) {
+        return;
+    }
+
+    editVolumeRevision = document->revision();
+    unsavedEditVolume += charsRemoved + charsAdded;
+}
+
+void DocumentManagerPrivate::resetAutoSave()
+{
+    unsavedEditVolume = 0;
+    lastAutoSaveTimer.restart();
+}
+
+bool DocumentManagerPrivate::journalWanted() const
+{
+    return autoSaveEnabled
+        && autoSaveJournalEnabled
+        && !loadInProgress
+        && !document->isNew()
+        && !document->isReadOnly();
+}
+
+void DocumentManagerPrivate::updateJournal()
+{
+    Q_Q(DocumentManager);
+
+    if (loadInProgress || saveInProgress) {
+        // The journal is brought up to date once done.
+        return;
+    }
+
+    if (!journalWanted()) {
+        closeJournal();
+    } else if (!journal.isActive()) {
+        // The journal's edits must apply to the file on disk, so save any
+        // changes first.  The journal is started once saving completes.
+        //
+        if (document->isModified()) {
+            q->save();
+        } else {
+            journal.start(document->filePath());
+        }
+    }
+}
+
+void DocumentManagerPrivate::closeJournal()
+{
+    if (!journal.isActive() && !journal.isSuspended()) {
+        return;
+    }
+
+    QString filePath = journal.filePath();
+
+    journal.stop();
+
+    if (!saveInProgress) {
+        EditJournal::remove(filePath);
+    }
+}
+
+void DocumentManagerPrivate::journalEdit(int position, int charsRemoved, int charsAdded)
+{
+    if (loadInProgress || (!journal.isActive() && !journal.isSuspended())) {
+        return;
+    }
+
+    // Rehighlighting the document also signals a change to its contents,
+    // but without changing its revision.
+    //
+    if (document->revision() == journaledRevision) {
+        return;
+    }
+
+    journaledRevision = document->revision();
+
+    QString insertedText;
+
+    if (charsAdded > 0) {
+        QTextCursor cursor(document);
+        int end = qMin(position + charsAdded, document->characterCount() - 1);
+
+        cursor.setPosition(position);
+        cursor.setPosition(end, QTextCursor::KeepAnchor);
+        insertedText = cursor.selectedText();
+        insertedText.replace(QChar::ParagraphSeparator, '\n');
+    }
+
+    journal.record(position, charsRemoved, insertedText);
+}
+
+bool DocumentManagerPrivate::recoverFromJournal(QString &text)
+{
+    QString recoveredText = text;
+
+    if (!EditJournal::replay(loadFilePath, recoveredText) || (recoveredText == text)) {
+        EditJournal::remove(loadFilePath);
+        return false;
     }
+
+    int response =
+        MessageBoxHelper::question
+        (
+            editor,
+            QObject::tr("%1 has unsaved changes from a previous session.")
+                .arg(QFileInfo(loadFilePath).fileName()),
+            QObject::tr("Would you like to recover them?"),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::Yes
+        );
+
+    if (QMessageBox::Yes != response) {
+        EditJournal::remove(loadFilePath);
+        return false;
+    }
+
+    text = recoveredText;
+    return true;
 }
 
 void DocumentManagerPrivate::saveFile()
 {
     Q_Q(DocumentManager);
 
+    completeLoad();
+
     document->setModified(false);
     emit q->documentModifiedChanged(false);
+    resetAutoSave();
 
     if
     (
@@ -650,7 +1518,19 @@ void DocumentManagerPrivate::saveFile()
         this->saveFutureWatcher->waitForFinished();
     }
 
+    // Hold the edits made during the save for the journal of the newly
+    // saved file.
+    //
+    if (journal.isActive() || journal.isSuspended()) {
+        if (journal.filePath() == document->filePath()) {
+            journal.suspend();
+        } else {
+            closeJournal();
+        }
+    }
+
     saveInProgress = true;
+    savingFilePath = document->filePath();
 
     if (fileWatcher->files().contains(document->filePath())) {
         this->fileWatcher->removePath(document->filePath());
@@ -658,36 +1538,443 @@ void DocumentManagerPrivate::saveFile()
 
     document->setTimestamp(QDateTime::currentDateTime());
 
+    QString filePath = document->filePath();
+    QString text = document->plainTextSnapshot();
+    bool createBackup = createBackupOnSave;
+
+    // Keep the saved text for exporting once saved, if the document is
+    // exported on save.
+    if (ExportOnSave::target(filePath).isValid()) {
+        savingText = text;
+    } else {
+        savingText = QString();
+    }
+
     QFuture<QString> future =
-        QtConcurrent::run
+        TaskScheduler::instance()->run
         (
-            this,
-            &DocumentManagerPrivate::saveToDisk,
-            document->filePath(),
-            document->toPlainText(),
-            createBackupOnSave
+            TaskScheduler::Interactive,
+            [this, filePath, text, createBackup]() {
+                QString err = DocumentWriter::write(filePath, text, createBackup);
+                savingTextHash = textHash(text);
+                return err;
+            }
         );
 
     this->saveFutureWatcher->setFuture(future);
 }
 
-bool DocumentManagerPrivate::loadFile(const QString &filePath)
+void DocumentManagerPrivate::loadFile(const QString &filePath, int cursorPosition)
 {
     Q_Q(DocumentManager);
 
+    saveDocumentCache();
+    cancelLoad();
+
     QFileInfo fileInfo(filePath);
+    QString spellingKey = this->spellingKey();
+
+    loadInProgress = true;
+    loadReading = true;
+    loadFilePath = filePath;
+    loadCursorPosition = cursorPosition;
+    readCancelled.storeRelease(0);
+    readBytes.storeRelease(0);
+    readSize = fileInfo.size();
+
+    // Don't let the user edit the current document in the meantime,
+    // since it is about to be replaced.
+    //
+    editor->setReadOnly(true);
+
+    QFuture<ReadResult> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Interactive,
+            [this, filePath, spellingKey]() {
+                ReadResult result = readFromDisk(filePath);
+
+                if (result.error.isNull() && !result.cancelled) {
+                    result.textHash = textHash(result.text);
+                    result.cache = DocumentCache::load(filePath, spellingKey);
+                }
+
+                return result;
+            }
+        );
+
+    this->readFutureWatcher->setFuture(future);
+    readProgressTimer->start();
+
+    // Note that this must be the last thing done, since listeners may
+    // process events, which could cancel the load.
+    emit q->operationStarted(QObject::tr("opening %1").arg(filePath));
+}
+
+void DocumentManagerPrivate::reloadFile(int cursorPosition)
+{
+    Q_Q(DocumentManager);
+
+    QString filePath = document->filePath();
+
+    if (loadInProgress || reloadFutureWatcher->isRunning()) {
+        loadFile(filePath, cursorPosition);
+        return;
+    }
+
+    // Line breaks inside blocks would throw off the line numbering of
+    // the document's text.
+    QString text = document->plainTextSnapshot();
+
+    if ((text.count('\n') + 1) != document->blockCount()) {
+        loadFile(filePath, cursorPosition);
+        return;
+    }
+
+    reloadFilePath = filePath;
+    reloadRevision = document->revision();
+    reloadCursorPosition = cursorPosition;
+    readCancelled.storeRelease(0);
+
+    QFuture<ReloadResult> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Interactive,
+            [this, filePath, text]() {
+                ReloadResult result;
+                ReadResult read = readFromDisk(filePath);
+
+                if (!read.error.isNull()) {
+                    result.error = read.error;
+                    return result;
+                }
+
+                if (read.cancelled) {
+                    return result;
+                }
+
+                result.textHash = textHash(read.text);
+                result.lines = read.text.split('\n');
+
+                // Text that the document would break into lines
+                // differently must be loaded in full.
+                for (QString &line : result.lines) {
+                    if (line.endsWith('\r')) {
+                        line.chop(1);
+                    }
+
+                    if
+                    (
+                        line.contains('\r')
+                        || line.contains(QChar::ParagraphSeparator)
+                        || line.contains(QChar::LineSeparator)
+                    ) {
+                        return result;
+                    }
+                }
+
+                result.hunks = LineDiff::compute(text.split('\n'), result.lines);
+                result.diffable = true;
+                return result;
+            }
+        );
+
+    reloadFutureWatcher->setFuture(future);
+    emit q->operationStarted(QObject::tr("reloading %1").arg(filePath));
+}
+
+void DocumentManagerPrivate::onReloadCompleted()
+{
+    Q_Q(DocumentManager);
+
+    ReloadResult result = reloadFutureWatcher->result();
+
+    emit q->operationFinished();
+
+    if
+    (
+        loadInProgress
+        || (reloadFilePath != document->filePath())
+        || (reloadRevision != document->revision())
+    ) {
+        // The user edited, closed or replaced the document in the
+        // meantime, so the diff no longer applies.
+        if (!loadInProgress && (reloadFilePath == document->filePath())) {
+            loadFile(reloadFilePath, editor->textCursor().position());
+        }
+
+        return;
+    }
+
+    if (!result.error.isNull()) {
+        MessageBoxHelper::critical
+        (
+            editor,
+            QObject::tr("Could not read %1").arg(reloadFilePath),
+            result.error
+        );
+        return;
+    }
+
+    if (!result.diffable) {
+        loadFile(reloadFilePath, reloadCursorPosition);
+        return;
+    }
+
+    // The changes being discarded no longer need their journal.
+    closeJournal();
+    applyHunks(result.hunks, result.lines);
+
+    QFileInfo fileInfo(reloadFilePath);
+
+    fileTextHash = result.textHash;
+    document->setModified(false);
+    resetAutoSave();
+    document->setReadOnly(!fileInfo.isWritable());
+    document->setTimestamp(fileInfo.lastModified());
+
+    if (journalWanted()) {
+        journal.start(reloadFilePath);
+    }
+
+    emit q->documentModifiedChanged(false);
+}
+
+void DocumentManagerPrivate::applyHunks
+(
+    const QVector<LineDiff::Hunk> &hunks,
+    const QStringList &lines
+)
+{
+    if (hunks.isEmpty()) {
+        return;
+    }
+
+    QTextCursor cursor(document);
+    document->beginTransaction();
+    cursor.beginEditBlock();
+
+    // Apply the hunks from the bottom up, so that the line numbers of
+    // those above still hold.
+    for (int i = hunks.size() - 1; i >= 0; i--) {
+        const LineDiff::Hunk &hunk = hunks.at(i);
+        QString text = lines.mid(hunk.newLine, hunk.newCount).join('\n');
+        QTextBlock first = document->findBlockByNumber(hunk.oldLine);
+
+        if (hunk.oldCount <= 0) {
+            if (first.isValid()) {
+                cursor.setPosition(first.position());
+                cursor.insertText(text + '\n');
+            } else {
+                cursor.movePosition(QTextCursor::End);
+                cursor.insertText('\n' + text);
+            }
+
+            continue;
+        }
+
+        QTextBlock last = document->findBlockByNumber(hunk.oldLine + hunk.oldCount - 1);
+        int start = first.position();
+        int end = last.position() + last.length() - 1;
+
+        // Lines removed outright take one of the line breaks around them
+        // along.
+        if (hunk.newCount <= 0) {
+            if (last.next().isValid()) {
+                end++;
+            } else if (first.previous().isValid()) {
+                start--;
+            }
+        }
+
+        cursor.setPosition(start);
+        cursor.setPosition(end, QTextCursor::KeepAnchor);
+        cursor.insertText(text);
+    }
+
+    cursor.endEditBlock();
+    document->commit();
+}
+
+DocumentManagerPrivate::ReadResult DocumentManagerPrivate::readFromDisk(const QString &filePath)
+{
+    ReadResult result;
     QFile inputFile(filePath);
 
     if (!inputFile.open(QIODevice::ReadOnly)) {
+        result.error = inputFile.errorString();
+        return result;
+    }
+
+    if (readMappedFile(inputFile, result)) {
+        return result;
+    }
+
+    QByteArray bytes;
+
+    if (inputFile.size() > 0) {
+        bytes.reserve(inputFile.size());
+    }
+
+    forever {
+        if (readCancelled.loadAcquire()) {
+            result.cancelled = true;
+            return result;
+        }
+
+        QByteArray chunk = inputFile.read(READ_CHUNK_SIZE);
+
+        if (chunk.isEmpty()) {
+            break;
+        }
+
+        bytes.append(chunk);
+        readBytes.storeRelease(bytes.size());
+    }
+
+    if (QFile::NoError != inputFile.error()) {
+        result.error = inputFile.errorString();
+        return result;
+    }
+
+    inputFile.close();
+
+    // Markdown files need to be in UTF-8 format, so assume that is
+    // what the user is opening by default.  Enable autodection
+    // of of UTF-16 or UTF-32 BOM in case the file isn't UTF-8 encoded.
+    //
+    QTextCodec *codec =
+        QTextCodec::codecForUtfText(bytes, QTextCodec::codecForName("UTF-8"));
+
+    result.text = codec->toUnicode(bytes);
+    return result;
+}
+
+bool DocumentManagerPrivate::readMappedFile(QFile &inputFile, ReadResult &result)
+{
+    qint64 size = inputFile.size();
+
+    if ((size < MAP_MIN_SIZE) || (size > std::numeric_limits<int>::max())) {
+        return false;
+    }
+
+    // Reading from a mapping raises SIGBUS if the file can't be read any
+    // more, which is far likelier to happen on a network drive.
+    //
+    QByteArray fileSystemType = QStorageInfo(inputFile.fileName()).fileSystemType();
+
+    if
+    (
+        fileSystemType.startsWith("nfs")
+        || fileSystemType.startsWith("cifs")
+        || fileSystemType.startsWith("smb")
+        || fileSystemType.startsWith("fuse")
+        || fileSystemType.startsWith("afs")
+    ) {
+        return false;
+    }
+
+    const char *bytes = (const char *) inputFile.map(0, size);
+
+    if (nullptr == bytes) {
+        return false;
+    }
+
+    // Leave files with a UTF-16 or UTF-32 BOM to readFromDisk().
+    QTextCodec *utf8 = QTextCodec::codecForName("UTF-8");
+    QTextCodec *codec =
+        QTextCodec::codecForUtfText(QByteArray::fromRawData(bytes, 4), utf8);
+
+    if (codec != utf8) {
+        inputFile.unmap((uchar *) bytes);
+        return false;
+    }
+
+    // Decode in chunks to allow cancelling.  The decoder carries any
+    // multibyte sequence split between chunks over to the next chunk,
+    // and skips the UTF-8 BOM, if any.
+    //
+    QScopedPointer<QTextDecoder> decoder(codec->makeDecoder());
+    result.text.reserve(size);
+
+    for (qint64 position = 0; position < size; position += READ_CHUNK_SIZE) {
+        if (readCancelled.loadAcquire()) {
+            result.text.clear();
+            result.cancelled = true;
+            break;
+        }
+
+        int length = (int) qMin<qint64>(READ_CHUNK_SIZE, size - position);
+
+        decoder->toUnicode(&result.text, bytes + position, length);
+        readBytes.storeRelease(position + length);
+    }
+
+    inputFile.unmap((uchar *) bytes);
+    return true;
+}
+
+void DocumentManagerPrivate::onReadCompleted()
+{
+    Q_Q(DocumentManager);
+
+    // Ignore reads that were cancelled, or whose text was already set
+    // into the document by completeLoad().
+    //
+    if (!loadReading) {
+        return;
+    }
+
+    ReadResult result = readFutureWatcher->result();
+
+    loadReading = false;
+    readProgressTimer->stop();
+
+    if (result.cancelled) {
+        return;
+    }
+
+    if (!result.error.isNull()) {
+        loadInProgress = false;
+        editor->setReadOnly(false);
+        emit q->operationFinished();
+
         MessageBoxHelper::critical
         (
             editor,
-            QObject::tr("Could not read %1").arg(filePath),
-            inputFile.errorString()
+            QObject::tr("Could not read %1").arg(loadFilePath),
+            result.error
         );
-        return false;
+        return;
     }
 
+    // The document being replaced no longer needs its journal.
+    closeJournal();
+
+    QString text = result.text;
+
+    loadRecovered = false;
+
+    if (EditJournal::exists(loadFilePath)) {
+        loadRecovered = recoverFromJournal(text);
+
+        // Bail if the load was cancelled while the user was asked.
+        if (!loadInProgress) {
+            return;
+        }
+    }
+
+    // The cache is of the file's text, not of the recovered edits.
+    loadCache = loadRecovered ? QSharedPointer<DocumentCache>() : result.cache;
+    fileTextHash = result.textHash;
+
+    setLoadedText(text);
+}
+
+void DocumentManagerPrivate::setLoadedText(const QString &text)
+{
+    Q_Q(DocumentManager);
+
     // NOTE: Must set editor's text cursor to the beginning
     // of the document before clearing the document/editor
     // of text to prevent a crash in Qt 5.10 on opening or
@@ -698,51 +1985,171 @@ bool DocumentManagerPrivate::loadFile(const QString &filePath)
     cursor.setPosition(0);
     editor->setTextCursor(cursor);
 
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
     document->clearUndoRedoStacks();
     document->setUndoRedoEnabled(false);
     document->setPlainText("");
+    document->setDocumentCache(loadCache);
 
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-    emit q->operationStarted(QObject::tr("opening %1").arg(filePath));
-    QTextStream inStream(&inputFile);
+    if (!loadCache.isNull()) {
+        editor->suspendParsing();
+    }
 
-    // Markdown files need to be in UTF-8 format, so assume that is
-    // what the user is opening by default.  Enable autodection
-    // of of UTF-16 or UTF-32 BOM in case the file isn't UTF-8 encoded.
-    //
-    inStream.setCodec("UTF-8");
-    inStream.setAutoDetectUnicode(true);
+    setFilePath(loadFilePath);
 
-    QString text = inStream.readAll();
+    if (text.length() <= PROGRESSIVE_LOAD_SIZE) {
+        editor->setPlainText(text);
+        editor->navigateDocument(0);
 
-    editor->setPlainText(text);
+        finishLoad();
+        QApplication::restoreOverrideCursor();
+        emit q->documentLoaded();
+        return;
+    }
+
+    // Show the first screen of text (allowing for wrapped lines) right
+    // away, and append the rest of the text from the event loop.
+    int firstScreenLines = 2 * editor->viewport()->height()
+        / qMax(1, editor->fontMetrics().lineSpacing());
+    int firstScreenLength = 0;
+
+    for (int i = 0; (i < firstScreenLines) && (firstScreenLength < text.length()); i++) {
+        firstScreenLength = loadChunkLength(firstScreenLength, 1);
+    }
+
+    loadText = text;
+    loadTextPosition = firstScreenLength;
+    loadTargetPosition = loadCursorPosition;
+
+    if (loadTargetPosition < 0) {
+        loadTargetPosition = fileHistoryEnabled
+            ? DocumentHistory::instance()->cursorPosition(loadFilePath)
+            : 0;
+    }
+
+    loadNavigated = false;
+    editor->setPlainText(text.left(firstScreenLength));
     editor->navigateDocument(0);
-    emit q->operationUpdate();
+    navigateLoadTarget();
+    document->setModified(false);
+    loadTimer->start();
 
-    document->setUndoRedoEnabled(true);
+    QApplication::restoreOverrideCursor();
+    emit q->operationUpdate(QObject::tr("loading %1 (0%)").arg(loadFilePath));
+}
 
-    if (QFile::NoError != inputFile.error()) {
-        MessageBoxHelper::critical
-        (
-            editor,
-            QObject::tr("Could not read %1").arg(filePath),
-            inputFile.errorString()
-        );
+void DocumentManagerPrivate::loadNextChunks()
+{
+    Q_Q(DocumentManager);
 
-        inputFile.close();
-        return false;
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    QTextCursor cursor(document);
+    cursor.movePosition(QTextCursor::End);
+
+    while ((loadTextPosition < loadText.length()) && (elapsed.elapsed() < LOAD_BATCH_TIME)) {
+        int length = loadChunkLength(loadTextPosition, LOAD_CHUNK_SIZE);
+
+        cursor.insertText(loadText.mid(loadTextPosition, length));
+        loadTextPosition += length;
     }
 
-    inputFile.close();
+    document->setModified(false);
+    navigateLoadTarget();
 
-    if (fileHistoryEnabled) {
-        DocumentHistory history;
-        editor->navigateDocument(history.cursorPosition(filePath));
-    } else {
-        editor->navigateDocument(0);
+    if (loadTextPosition >= loadText.length()) {
+        finishLoad();
+        emit q->documentLoaded();
+        return;
+    }
+
+    // Note that this must be the last thing done, since listeners may
+    // process events, which could start another load.
+    emit q->operationUpdate
+    (
+        QObject::tr("loading %1 (%2%)")
+            .arg(document->filePath())
+            .arg((int) ((100.0 * loadTextPosition) / loadText.length()))
+    );
+}
+
+void DocumentManagerPrivate::completeLoad()
+{
+    Q_Q(DocumentManager);
+
+    if (loadReading) {
+        readFutureWatcher->waitForFinished();
+        onReadCompleted();
     }
 
-    setFilePath(filePath);
+    if (!loadInProgress) {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    QTextCursor cursor(document);
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(loadText.mid(loadTextPosition));
+    loadTextPosition = loadText.length();
+
+    finishLoad();
+    QApplication::restoreOverrideCursor();
+    emit q->documentLoaded();
+}
+
+void DocumentManagerPrivate::cancelLoad()
+{
+    Q_Q(DocumentManager);
+
+    if (!loadInProgress) {
+        return;
+    }
+
+    if (loadReading) {
+        readCancelled.storeRelease(1);
+        readFutureWatcher->waitForFinished();
+        readProgressTimer->stop();
+        loadReading = false;
+    }
+
+    loadTimer->stop();
+    loadInProgress = false;
+    loadText.clear();
+    loadTextPosition = 0;
+    loadNavigated = false;
+    loadCache.clear();
+    document->setUndoRedoEnabled(true);
+    editor->resumeParsing();
+    editor->setReadOnly(false);
+    emit q->operationFinished();
+}
+
+void DocumentManagerPrivate::finishLoad()
+{
+    Q_Q(DocumentManager);
+
+    loadTimer->stop();
+    loadInProgress = false;
+    loadText.clear();
+    loadTextPosition = 0;
+    loadCache.clear();
+
+    document->setUndoRedoEnabled(true);
+    editor->resumeParsing();
+
+    bool centered = loadNavigated;
+    loadNavigated = false;
+
+    // A cursor placed during the load is left where it is, in case the
+    // user moved it since.
+    if (!centered) {
+        navigateLoadedDocument();
+    }
+
+    QFileInfo fileInfo(document->filePath());
     editor->setReadOnly(false);
 
     if (!fileInfo.isWritable()) {
@@ -751,8 +2158,9 @@ bool DocumentManagerPrivate::loadFile(const QString &filePath)
         document->setReadOnly(false);
     }
 
-    document->setModified(false);
+    document->setModified(loadRecovered);
     document->setTimestamp(fileInfo.lastModified());
+    resetAutoSave();
 
     QString watchedFile;
 
@@ -760,15 +2168,96 @@ bool DocumentManagerPrivate::loadFile(const QString &filePath)
         fileWatcher->removePath(watchedFile);
     }
 
-    fileWatcher->addPath(filePath);
+    fileWatcher->addPath(document->filePath());
+
+    // Keep adding to the journal of recovered edits, since they are not
+    // in the file yet.
+    //
+    if (journalWanted()) {
+        journal.start(document->filePath(), loadRecovered);
+    }
+
     emit q->operationFinished();
-    emit q->documentModifiedChanged(false);
-    QApplication::restoreOverrideCursor();
 
+    if (!loadRecovered) {
+        emit q->documentModifiedChanged(false);
+    }
+
+    if (!centered) {
+        editor->centerCursor();
+    }
+}
+
+void DocumentManagerPrivate::navigateLoadedDocument()
+{
+    if (loadCursorPosition >= 0) {
+        editor->navigateDocument(loadCursorPosition);
+    } else if (fileHistoryEnabled) {
+        editor->navigateDocument
+        (
+            DocumentHistory::instance()->cursorPosition(document->filePath())
+        );
+    } else {
+        editor->navigateDocument(0);
+    }
+}
+
+void DocumentManagerPrivate::navigateLoadTarget()
+{
+    // Wait for the screen of text following the target as well, so that
+    // the cursor can be centered.
+    if
+    (
+        loadNavigated
+        || (
+            (loadTextPosition < loadText.length())
+            && (loadTextPosition <= (loadTargetPosition + LOAD_CHUNK_SIZE))
+        )
+    ) {
+        return;
+    }
+
+    loadNavigated = true;
+    editor->navigateDocument(qMin(loadTargetPosition, document->characterCount() - 1));
     editor->centerCursor();
-    emit q->documentLoaded();
+}
 
-    return true;
+int DocumentManagerPrivate::loadChunkLength(int position, int length) const
+{
+    int end = position + length;
+
+    if (end >= loadText.length()) {
+        return loadText.length() - position;
+    }
+
+    // Don't split lines, and with them any "\r\n" line endings.
+    int newline = loadText.indexOf('\n', end - 1);
+
+    if (newline < 0) {
+        return loadText.length() - position;
+    }
+
+    return newline + 1 - position;
+}
+
+QString DocumentManagerPrivate::spellingKey() const
+{
+    AppSettings *settings = AppSettings::instance();
+    QStringList personal = DictionaryManager::instance().personal();
+
+    personal.sort();
+
+    return QString("%1\n%2\n%3")
+        .arg(settings->dictionaryLanguage())
+        .arg(settings->alternativeDictionaryLanguages().join(','))
+        .arg(personal.join('\n'));
+}
+
+void DocumentManagerPrivate::saveDocumentCache()
+{
+    if (!loadInProgress) {
+        editor->saveDocumentCache(spellingKey());
+    }
 }
 
 void DocumentManagerPrivate::setFilePath(const QString &filePath)
@@ -800,6 +2289,11 @@ bool DocumentManagerPrivate::checkSaveChanges()
 {
     Q_Q(DocumentManager);
 
+    // The user can't have changed a document that is still loading.
+    if (loadInProgress) {
+        return true;
+    }
+
     if (document->isModified()) {
         if (autoSaveEnabled && !document->isNew() && !document->isReadOnly()) {
             return q->save();
@@ -886,67 +2380,49 @@ bool DocumentManagerPrivate::checkPermissionsBeforeSave()
     return true;
 }
 
-QString DocumentManagerPrivate::saveToDisk
-(
-    const QString &filePath,
-    const QString &text,
-    bool createBackup
-) const
+QByteArray DocumentManagerPrivate::textHash(const QString &text)
 {
-    QString err;
-
-    if (filePath.isNull() || filePath.isEmpty()) {
-        return QObject::tr("Null or empty file path provided for writing.");
-    }
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    int start = 0;
 
-    QFile outputFile(filePath);
+    forever {
+        int end = text.indexOf('\r', start);
 
-    if (createBackup && outputFile.exists()) {
-        backupFile(filePath);
-    }
-
-    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
-        return outputFile.errorString();
-    }
+        if (end < 0) {
+            end = text.length();
+        }
 
-    // Write contents to disk.
-    QTextStream outStream(&outputFile);
+        hash.addData((const char *) (text.constData() + start), (end - start) * sizeof(QChar));
 
-    // Markdown files need to be in UTF-8, since most Markdown processors
-    // (i.e., Pandoc, et. al.) can only read UTF-8 encoded text files.
-    //
-    outStream.setCodec("UTF-8");
-    outStream << text;
+        if (end >= text.length()) {
+            break;
+        }
 
-    if (QFile::NoError != outputFile.error()) {
-        err = outputFile.errorString();
+        start = end + 1;
     }
 
-    // Close the file.  All done!
-    outputFile.close();
-    return err;
+    return hash.result();
 }
 
-void DocumentManagerPrivate::backupFile(const QString &filePath) const
+QByteArray DocumentManagerPrivate::readTextHash(const QString &filePath)
 {
-    QString backupFilePath = filePath + ".backup";
-    QFile backupFile(backupFilePath);
+    GW_TRACE_SCOPE("readTextHash");
 
-    if (backupFile.exists()) {
-        if (!backupFile.remove()) {
-            qCritical("Could not remove backup file %s before saving: %s",
-                      backupFilePath.toLatin1().data(),
-                      backupFile.errorString().toLatin1().data());
-            return;
-        }
+    QFile inputFile(filePath);
+
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+        return QByteArray();
     }
 
-    QFile file(filePath);
+    QByteArray bytes = inputFile.readAll();
 
-    if (!file.copy(backupFilePath)) {
-        qCritical("Failed to backup file to %s: %s",
-                  backupFilePath.toLatin1().data(),
-                  file.errorString().toLatin1().data());
+    if (QFile::NoError != inputFile.error()) {
+        return QByteArray();
     }
+
+    QTextCodec *codec =
+        QTextCodec::codecForUtfText(bytes, QTextCodec::codecForName("UTF-8"));
+
+    return textHash(codec->toUnicode(bytes));
 }
 }
@@ -71,6 +71,20 @@ public:
      */
     bool fileBackupEnabled() const;
 
+    /**
+     * Returns true if a document is being loaded, in which case it is
+     * loaded asynchronously and the editor is read-only until loading
+     * has finished.
+     */
+    bool isLoading() const;
+
+    /**
+     * Returns true if exports of the document are in progress.  Exports
+     * run in the background, and the user can keep editing in the
+     * meantime.
+     */
+    bool isExporting() const;
+
     /**
      * Gets whether tracking the recent file history is enabled.
      */
@@ -135,6 +149,13 @@ signals:
      */
     void documentClosed();
 
+    /**
+     * Emitted instead of opening a file too large to load into the editor,
+     * with the path of the file, so that it can be shown in a read-only
+     * viewer.  The current document is left open.
+     */
+    void hugeFileOpened(const QString &filePath);
+
 public slots:
 
     /**
@@ -142,6 +163,16 @@ public slots:
      */
     void setAutoSaveEnabled(bool enabled);
 
+    /**
+     * Sets whether auto-saving appends the edits made to the document to
+     * a journal next to the file, rather than saving the entire file.
+     * The file itself is then saved only when saved explicitly or closed.
+     * Should the application crash, the journaled edits are offered for
+     * recovery the next time the file is opened.  Has no effect unless
+     * auto-saving is enabled.
+     */
+    void setAutoSaveJournalEnabled(bool enabled);
+
     /**
      * Sets whether a backup file is created (with a .backup extension)
      * on disk before the document is saved.
@@ -150,9 +181,12 @@ public slots:
 
     /**
      * Prompts the user for a file path, and loads the document with the
-     * file contents at the selected path.
+     * file contents at the selected path.  If a position is given, the
+     * cursor is placed there once the file is loaded.  If the file is
+     * already open, the editor then simply navigates to the position.
+     * Files too large for the editor are passed on with hugeFileOpened().
      */
-    void open(const QString &filePath = QString());
+    void open(const QString &filePath = QString(), int position = -1);
 
     /**
      * Reopens the last closed file, if any is available in the document
@@ -198,9 +232,22 @@ public slots:
      */
     bool close();
 
+    /**
+     * Cancels loading a document.  If the file is still being read, the
+     * current document is kept.  Otherwise, the partially loaded document
+     * is closed.
+     */
+    void cancelLoad();
+
+    /**
+     * Cancels all exports of the document in progress or waiting to run.
+     */
+    void cancelExports();
+
     /**
      * Exports the current file, prompting the user for the desired
-     * export format.
+     * export format.  The export is queued to run in the background,
+     * after any other exports in progress.
      */
     void exportFile();
 
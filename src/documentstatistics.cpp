@@ -17,10 +17,17 @@
  *
  ***********************************************************************/
 
+#include <QElapsedTimer>
+#include <QTextCursor>
+#include <QTimer>
+#include <QVector>
+#include <QtConcurrentMap>
 #include <QtCore/qmath.h>
-#include <QTextBoundaryFinder>
 
+#include "documentcache.h"
 #include "documentstatistics.h"
+#include "texttokenizer.h"
+#include "tracer.h"
 
 namespace ghostwriter
 {
@@ -61,21 +68,70 @@ public:
     int paragraphCount;
     int lixLongWordCount;
 
+    // Statistics of the selected text, if any, which are published
+    // instead of those of the entire document while selectionActive is
+    // true.
+    bool selectionActive;
+    DocumentStatistics::Statistics selectionStatistics;
+
+    // Selection being counted.  Blocks that are selected in full are
+    // counted from their cached counts, and only partially selected
+    // blocks at either end are tokenized.  selectionPosition is where the
+    // next batch of counting picks up.
+    int selectionStart;
+    int selectionEnd;
+    int selectionPosition;
+    TextTokenizer::Counts selectionCounts;
+    int selectionParagraphCount;
+    QTimer *selectionTimer;
+
+    // Last statistics published, and the timer that publishes changes to
+    // them no more often than once per DocumentStatistics::PublishInterval.
+    DocumentStatistics::Statistics publishedStatistics;
+    QTimer *publishTimer;
+
+    // Range of edited text whose blocks have yet to be counted when
+    // updates are deferred, and the timer that counts them in batches.
+    bool deferredUpdatesEnabled;
+    bool dirty;
+    QTextCursor dirtyStart;
+    QTextCursor dirtyEnd;
+    QTimer *updateTimer;
+
+    // Time after the last edit before the edited blocks are counted, and
+    // the maximum time spent counting them before yielding to the event
+    // loop, in milliseconds.
+    static const int DeferredUpdateDelay = 250;
+    static const int DeferredBatchTime = 10;
+
+    // Ranges of at least this many blocks, such as when a document is
+    // loaded, are counted in bulk across the global thread pool.
+    static const int BulkBlockCount = 1000;
+
+    // Fenwick (binary indexed) tree of the blocks' word counts by block
+    // number, indexed from 1, for summing the word counts of ranges of
+    // blocks.  Block numbers shift when blocks are inserted or removed, so
+    // the tree is then rebuilt when next queried.  Otherwise, it is
+    // updated in place as blocks are counted.
+    QVector<int> blockWordCounts;
+    bool blockWordCountsValid;
+
+    void markDirty(int startIndex, int endIndex);
+    void updateDirtyBlocks(int timeLimit);
     void updateStatistics();
+    void publishStatistics();
+    void countSelection(int timeLimit);
     void updateBlockStatistics(QTextBlock &block);
-    void countWords
-    (
-        const QString &text,
-        int &words,
-        int &lixLongWords,
-        int &alphaNumericCharacters
-    );
-    int countSentences(const QString &text);
-    int calculatePageCount(int words);
-    int calculateCLI(int characters, int words, int sentences);
-    int calculateLIX(int totalWords, int longWords, int sentences);
-    int calculateComplexWords(int totalWords, int longWords);
-    int calculateReadingTime(int words);
+    void updateBlockStatistics(QTextBlock &block, const TextTokenizer::Counts &counts);
+    bool updateBlockStatisticsInBulk(const QTextBlock &startBlock, const QTextBlock &endBlock);
+    void updateBlockWordCount(const QTextBlock &block, int delta);
+    void rebuildBlockWordCounts();
+    int blockWordCountSum(int blockCount) const;
+    static int calculatePageCount(int words);
+    static int calculateCLI(int characters, int words, int sentences);
+    static int calculateLIX(int totalWords, int longWords, int sentences);
+    static int calculateComplexWords(int totalWords, int longWords);
+    static int calculateReadingTime(int words);
 };
 
 DocumentStatistics::DocumentStatistics(MarkdownDocument *document, QObject *parent)
@@ -89,9 +145,58 @@ DocumentStatistics::DocumentStatistics(MarkdownDocument *document, QObject *pare
     d->sentenceCount = 0;
     d->paragraphCount = 0;
     d->lixLongWordCount = 0;
+    d->deferredUpdatesEnabled = false;
+    d->dirty = false;
+    d->dirtyStart = QTextCursor(document);
+    d->dirtyEnd = QTextCursor(document);
+    d->selectionActive = false;
+    d->selectionStart = 0;
+    d->selectionEnd = 0;
+    d->selectionPosition = 0;
+    d->selectionCounts = TextTokenizer::Counts();
+    d->selectionParagraphCount = 0;
+    d->blockWordCountsValid = false;
+
+    d->selectionTimer = new QTimer(this);
+    d->selectionTimer->setSingleShot(true);
+
+    this->connect
+    (
+        d->selectionTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->countSelection(DocumentStatisticsPrivate::DeferredBatchTime);
+        }
+    );
+
+    d->publishTimer = new QTimer(this);
+    d->publishTimer->setSingleShot(true);
+    d->publishTimer->setInterval(PublishInterval);
+
+    this->connect
+    (
+        d->publishTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->publishStatistics();
+        }
+    );
+
+    d->updateTimer = new QTimer(this);
+    d->updateTimer->setSingleShot(true);
+
+    this->connect
+    (
+        d->updateTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->updateDirtyBlocks(DocumentStatisticsPrivate::DeferredBatchTime);
+        }
+    );
 
     connect(d->document, SIGNAL(contentsChange(int, int, int)), this, SLOT(onTextChanged(int, int, int)));
-    connect(d->document, SIGNAL(textBlockRemoved(const QTextBlock &)), this, SLOT(onTextBlockRemoved(const QTextBlock &)));
+    connect(d->document, SIGNAL(transactionCommitted(int, int, int)), this, SLOT(onTextChanged(int, int, int)));
+    connect(d->document, &MarkdownDocument::textBlocksRemoved, this, &DocumentStatistics::onTextBlocksRemoved);
 }
 
 DocumentStatistics::~DocumentStatistics()
@@ -99,76 +204,121 @@ DocumentStatistics::~DocumentStatistics()
     ;
 }
 
+DocumentStatistics::Statistics::Statistics()
+    : wordCount(0),
+      totalWordCount(0),
+      characterCount(0),
+      sentenceCount(0),
+      paragraphCount(0),
+      pageCount(0),
+      complexWords(0),
+      readingTime(0),
+      lixReadingEase(0),
+      readabilityIndex(0)
+{
+    ;
+}
+
+bool DocumentStatistics::Statistics::operator==(const Statistics &other) const
+{
+    return (wordCount == other.wordCount)
+        && (totalWordCount == other.totalWordCount)
+        && (characterCount == other.characterCount)
+        && (sentenceCount == other.sentenceCount)
+        && (paragraphCount == other.paragraphCount)
+        && (pageCount == other.pageCount)
+        && (complexWords == other.complexWords)
+        && (readingTime == other.readingTime)
+        && (lixReadingEase == other.lixReadingEase)
+        && (readabilityIndex == other.readabilityIndex);
+}
+
+bool DocumentStatistics::Statistics::operator!=(const Statistics &other) const
+{
+    return !(*this == other);
+}
+
 int DocumentStatistics::wordCount() const
 {
     Q_D(const DocumentStatistics);
     
+    if (d->dirty) {
+        const_cast<DocumentStatisticsPrivate *>(d)->updateDirtyBlocks(-1);
+    }
+
     return d->wordCount;
 }
 
-void DocumentStatistics::onTextSelected
-(
-    const QString &selectedText,
-    int selectionStart,
-    int selectionEnd
-)
+int DocumentStatistics::wordCount(int firstBlockNumber, int lastBlockNumber) const
 {
-    Q_D(DocumentStatistics);
-    
-    int selectionWordCount;
-    int selectionLixLongWordCount;
-    int selectionWordCharacterCount;
+    Q_D(const DocumentStatistics);
 
-    d->countWords
-    (
-        selectedText,
-        selectionWordCount,
-        selectionLixLongWordCount,
-        selectionWordCharacterCount
-    );
+    if (!d->blockWordCountsValid) {
+        const_cast<DocumentStatisticsPrivate *>(d)->rebuildBlockWordCounts();
+    }
 
-    int selectionSentenceCount = d->countSentences(selectedText);
+    int blockCount = d->blockWordCounts.size() - 1;
 
-    // Count the number of selected paragraphs.
-    int selectedParagraphCount = 0;
+    firstBlockNumber = qMax(firstBlockNumber, 0);
+    lastBlockNumber = qMin(lastBlockNumber, blockCount - 1);
 
-    QTextBlock block = d->document->findBlock(selectionStart);
-    QTextBlock end = d->document->findBlock(selectionEnd).next();
+    if (lastBlockNumber < firstBlockNumber) {
+        return 0;
+    }
 
-    while (block != end) {
-        TextBlockData *blockData = (TextBlockData *) block.userData();
+    return d->blockWordCountSum(lastBlockNumber + 1)
+        - d->blockWordCountSum(firstBlockNumber);
+}
 
-        if ((nullptr != blockData) && !blockData->blankLine) {
-            selectedParagraphCount++;
-        }
+void DocumentStatistics::setDeferredUpdatesEnabled(bool enabled)
+{
+    Q_D(DocumentStatistics);
 
-        block = block.next();
+    d->deferredUpdatesEnabled = enabled;
+
+    if (!enabled && d->dirty) {
+        d->updateDirtyBlocks(-1);
     }
+}
+
+void DocumentStatistics::onTextSelected(int selectionStart, int selectionEnd)
+{
+    Q_D(DocumentStatistics);
 
-    emit wordCountChanged(selectionWordCount);
-    emit characterCountChanged(selectedText.length());
-    emit sentenceCountChanged(selectionSentenceCount);
-    emit paragraphCountChanged(selectedParagraphCount);
-    emit pageCountChanged(d->calculatePageCount(selectionWordCount));
-    emit complexWordsChanged(d->calculateComplexWords(selectionWordCount, selectionLixLongWordCount));
-    emit readingTimeChanged(d->calculateReadingTime(selectionWordCount));
-    emit lixReadingEaseChanged(d->calculateLIX(selectionWordCount, selectionLixLongWordCount, selectionSentenceCount));
-    emit readabilityIndexChanged(d->calculateCLI(selectionWordCharacterCount, selectionWordCount, selectionSentenceCount));
+    // The blocks' counts must be up to date to be summed.
+    if (d->dirty) {
+        d->updateDirtyBlocks(-1);
+    }
+
+    d->selectionStart = selectionStart;
+    d->selectionEnd = selectionEnd;
+    d->selectionPosition = selectionStart;
+    d->selectionCounts = TextTokenizer::Counts();
+    d->selectionParagraphCount = 0;
+    d->countSelection(DocumentStatisticsPrivate::DeferredBatchTime);
 }
 
 void DocumentStatistics::onTextDeselected()
 {
     Q_D(DocumentStatistics);
     
+    d->selectionTimer->stop();
     d->updateStatistics();
 }
 
 void DocumentStatistics::onTextChanged(int position, int charsRemoved, int charsAdded)
 {
     Q_D(DocumentStatistics);
+    GW_TRACE_SCOPE("DocumentStatistics::onTextChanged");
     
     Q_UNUSED(charsRemoved)
 
+    // Changes made during a transaction are counted at once when it is
+    // committed.
+    if (d->document->isInTransaction()) {
+        return;
+    }
+
     int startIndex = position - charsRemoved;
 
     if (startIndex < 0) {
@@ -181,6 +331,11 @@ void DocumentStatistics::onTextChanged(int position, int charsRemoved, int chars
         endIndex = d->document->characterCount() - 1;
     }
 
+    if (d->deferredUpdatesEnabled) {
+        d->markDirty(startIndex, endIndex);
+        return;
+    }
+
     // Update the word counts of affected blocks.  Note that there is no need to
     // check for changes to section headings, since the Highlighter class will
     // take care of this for us.
@@ -188,6 +343,11 @@ void DocumentStatistics::onTextChanged(int position, int charsRemoved, int chars
     QTextBlock startBlock = d->document->findBlock(startIndex);
     QTextBlock endBlock = d->document->findBlock(endIndex);
 
+    if (d->updateBlockStatisticsInBulk(startBlock, endBlock)) {
+        d->updateStatistics();
+        return;
+    }
+
     QTextBlock block = startBlock;
 
     d->updateBlockStatistics(block);
@@ -200,43 +360,219 @@ void DocumentStatistics::onTextChanged(int position, int charsRemoved, int chars
     d->updateStatistics();
 }
 
-void DocumentStatistics::onTextBlockRemoved(const QTextBlock &block)
+void DocumentStatistics::onTextBlocksRemoved(const MarkdownDocument::RemovedBlocks &removed)
 {
     Q_D(DocumentStatistics);
     
-    TextBlockData *blockData = (TextBlockData *) block.userData();
+    // Block numbers after the removed blocks have shifted.
+    d->blockWordCountsValid = false;
+
+    d->wordCount -= removed.wordCount;
+    d->lixLongWordCount -= removed.lixLongWordCount;
+    d->wordCharacterCount -= removed.alphaNumericCharacterCount;
+    d->sentenceCount -= removed.sentenceCount;
+    d->paragraphCount -= removed.nonBlankCount;
+
+    if (d->deferredUpdatesEnabled) {
+        if (!d->updateTimer->isActive()) {
+            d->updateTimer->start(DocumentStatisticsPrivate::DeferredUpdateDelay);
+        }
+    } else {
+        d->updateStatistics();
+    }
+}
 
-    if (nullptr != blockData) {
-        d->wordCount -= blockData->wordCount;
-        d->lixLongWordCount -= blockData->lixLongWordCount;
-        d->wordCharacterCount -= blockData->alphaNumericCharacterCount;
-        d->sentenceCount -= blockData->sentenceCount;
+// Adds the given range of text to the range whose blocks have yet to be
+// counted, and (re)starts the timer for counting them.
+//
+void DocumentStatisticsPrivate::markDirty(int startIndex, int endIndex)
+{
+    if (!dirty) {
+        dirty = true;
+        dirtyStart.setPosition(startIndex);
+        dirtyEnd.setPosition(endIndex);
+    } else {
+        dirtyStart.setPosition(qMin(startIndex, dirtyStart.position()));
+        dirtyEnd.setPosition(qMax(endIndex, dirtyEnd.position()));
+    }
+
+    updateTimer->start(DeferredUpdateDelay);
+}
+
+// Counts the blocks of the dirty range, for at most the given time in
+// milliseconds (or until done if negative), and emits the statistics once
+// all of them are counted.
+//
+void DocumentStatisticsPrivate::updateDirtyBlocks(int timeLimit)
+{
+    if (!dirty) {
+        updateStatistics();
+        return;
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    QTextBlock block = document->findBlock(dirtyStart.position());
+    QTextBlock endBlock = document->findBlock(dirtyEnd.position());
+
+    if (updateBlockStatisticsInBulk(block, endBlock)) {
+        block = QTextBlock();
+    }
 
-        if (!blockData->blankLine) {
-            d->paragraphCount--;
+    while (block.isValid()) {
+        updateBlockStatistics(block);
+
+        if (block == endBlock) {
+            break;
         }
 
-        d->updateStatistics();
+        block = block.next();
+
+        if ((timeLimit >= 0) && (elapsed.elapsed() >= timeLimit) && block.isValid()) {
+            dirtyStart.setPosition(block.position());
+            updateTimer->start(0);
+            return;
+        }
+    }
+
+    dirty = false;
+    updateTimer->stop();
+    updateStatistics();
+}
+
+// Counts the blocks of the selection from selectionPosition onward, for at
+// most the given time in milliseconds (or until done if negative), and
+// publishes the statistics of the selection once all of it is counted.
+//
+void DocumentStatisticsPrivate::countSelection(int timeLimit)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    QTextBlock block = document->findBlock(selectionPosition);
+
+    while (block.isValid() && (block.position() <= selectionEnd)) {
+        int blockStart = block.position();
+        int blockEnd = blockStart + block.length() - 1;
+        TextBlockData *blockData = (TextBlockData *) block.userData();
+
+        if ((nullptr == blockData) || (blockStart < selectionStart) || (blockEnd > selectionEnd)) {
+            int start = qMax(selectionStart, blockStart) - blockStart;
+            int end = qMin(selectionEnd, blockEnd) - blockStart;
+            TextTokenizer::Counts counts =
+                TextTokenizer::count(block.text().mid(start, end - start));
+
+            selectionCounts.words += counts.words;
+            selectionCounts.longWords += counts.longWords;
+            selectionCounts.alphaNumericCharacters += counts.alphaNumericCharacters;
+            selectionCounts.sentences += counts.sentences;
+        } else {
+            selectionCounts.words += blockData->wordCount;
+            selectionCounts.longWords += blockData->lixLongWordCount;
+            selectionCounts.alphaNumericCharacters += blockData->alphaNumericCharacterCount;
+            selectionCounts.sentences += blockData->sentenceCount;
+        }
+
+        if ((nullptr != blockData) && !blockData->blankLine) {
+            selectionParagraphCount++;
+        }
+
+        block = block.next();
+
+        if ((timeLimit >= 0) && (elapsed.elapsed() >= timeLimit) && block.isValid()) {
+            selectionPosition = block.position();
+            selectionTimer->start(0);
+            return;
+        }
+    }
+
+    int words = selectionCounts.words;
+    int longWords = selectionCounts.longWords;
+    int sentences = selectionCounts.sentences;
+    DocumentStatistics::Statistics &statistics = selectionStatistics;
+
+    statistics.wordCount = words;
+    statistics.characterCount = selectionEnd - selectionStart;
+    statistics.sentenceCount = sentences;
+    statistics.paragraphCount = selectionParagraphCount;
+    statistics.pageCount = calculatePageCount(words);
+    statistics.complexWords = calculateComplexWords(words, longWords);
+    statistics.readingTime = calculateReadingTime(words);
+    statistics.lixReadingEase = calculateLIX(words, longWords, sentences);
+    statistics.readabilityIndex = calculateCLI(selectionCounts.alphaNumericCharacters, words, sentences);
+
+    selectionActive = true;
+
+    if (!publishTimer->isActive()) {
+        publishTimer->start();
     }
 }
 
+// Schedules publishing the statistics of the entire document.  Note that
+// the counts are always kept up to date; only publishing them is delayed.
+//
 void DocumentStatisticsPrivate::updateStatistics()
+{
+    selectionActive = false;
+    selectionTimer->stop();
+
+    if (!publishTimer->isActive()) {
+        publishTimer->start();
+    }
+}
+
+// Emits the statistics of the selected text or of the entire document, if
+// they differ from those last emitted.
+//
+void DocumentStatisticsPrivate::publishStatistics()
 {
     Q_Q(DocumentStatistics);
-    
-    emit q->wordCountChanged(wordCount);
-    emit q->totalWordCountChanged(wordCount);
-    emit q->characterCountChanged(document->characterCount() - 1);
-    emit q->sentenceCountChanged(sentenceCount);
-    emit q->paragraphCountChanged(paragraphCount);
-    emit q->pageCountChanged(calculatePageCount(wordCount));
-    emit q->complexWordsChanged(calculateComplexWords(wordCount, lixLongWordCount));
-    emit q->readingTimeChanged(calculateReadingTime(wordCount));
-    emit q->lixReadingEaseChanged(calculateLIX(wordCount, lixLongWordCount, sentenceCount));
-    emit q->readabilityIndexChanged(calculateCLI(wordCharacterCount, wordCount, sentenceCount));
+
+    DocumentStatistics::Statistics statistics;
+
+    if (selectionActive) {
+        statistics = selectionStatistics;
+    } else {
+        statistics.wordCount = wordCount;
+        statistics.characterCount = document->characterCount() - 1;
+        statistics.sentenceCount = sentenceCount;
+        statistics.paragraphCount = paragraphCount;
+        statistics.pageCount = calculatePageCount(wordCount);
+        statistics.complexWords = calculateComplexWords(wordCount, lixLongWordCount);
+        statistics.readingTime = calculateReadingTime(wordCount);
+        statistics.lixReadingEase = calculateLIX(wordCount, lixLongWordCount, sentenceCount);
+        statistics.readabilityIndex = calculateCLI(wordCharacterCount, wordCount, sentenceCount);
+    }
+
+    statistics.totalWordCount = wordCount;
+
+    if (statistics != publishedStatistics) {
+        publishedStatistics = statistics;
+        emit q->statisticsChanged(statistics);
+    }
 }
 
 void DocumentStatisticsPrivate::updateBlockStatistics(QTextBlock &block)
+{
+    QString text = block.text();
+    QSharedPointer<DocumentCache> cache = document->documentCache();
+    TextTokenizer::Counts counts;
+
+    // Tokenize the block's text once for all of its statistics, unless
+    // they were cached from when the document was last open.
+    if (cache.isNull() || !cache->blockStatistics(block.blockNumber(), text, counts)) {
+        counts = TextTokenizer::count(text);
+    }
+
+    updateBlockStatistics(block, counts);
+}
+
+void DocumentStatisticsPrivate::updateBlockStatistics
+(
+    QTextBlock &block,
+    const TextTokenizer::Counts &counts
+)
 {
     TextBlockData *blockData = (TextBlockData *) block.userData();
 
@@ -248,21 +584,18 @@ void DocumentStatisticsPrivate::updateBlockStatistics(QTextBlock &block)
     int oldWordCount = blockData->wordCount;
     int oldLixLongWordCount = blockData->lixLongWordCount;
     int oldAlphaNumCharCount = blockData->alphaNumericCharacterCount;
+    int oldSentenceCount = blockData->sentenceCount;
 
-    countWords
-    (
-        block.text(),
-        blockData->wordCount,
-        blockData->lixLongWordCount,
-        blockData->alphaNumericCharacterCount
-    );
+    blockData->wordCount = counts.words;
+    blockData->lixLongWordCount = counts.longWords;
+    blockData->alphaNumericCharacterCount = counts.alphaNumericCharacters;
+    blockData->sentenceCount = counts.sentences;
 
     wordCount += blockData->wordCount - oldWordCount;
+    updateBlockWordCount(block, blockData->wordCount - oldWordCount);
     lixLongWordCount += blockData->lixLongWordCount - oldLixLongWordCount;
     wordCharacterCount += blockData->alphaNumericCharacterCount - oldAlphaNumCharCount;
 
-    int oldSentenceCount = blockData->sentenceCount;
-    blockData->sentenceCount = countSentences(block.text());
     sentenceCount += blockData->sentenceCount - oldSentenceCount;
 
     if (blockData->blankLine) {
@@ -276,114 +609,184 @@ void DocumentStatisticsPrivate::updateBlockStatistics(QTextBlock &block)
     }
 }
 
-void DocumentStatisticsPrivate::countWords
+// Updates the statistics of the given range of blocks (inclusive) if the
+// range is large enough to be worth tokenizing the blocks' text across the
+// global thread pool, returning false otherwise.  The TextBlockData is only
+// touched here on the GUI thread; the worker threads only see copies of
+// the blocks' text.
+//
+bool DocumentStatisticsPrivate::updateBlockStatisticsInBulk
 (
-    const QString &text,
-    int &words,
-    int &lixLongWords,
-    int &alphaNumericCharacters
+    const QTextBlock &startBlock,
+    const QTextBlock &endBlock
 )
 {
-    bool inWord = false;
-    int separatorCount = 0;
-    int wordLen = 0;
-
-    words = 0;
-    lixLongWords = 0;
-    alphaNumericCharacters = 0;
-
-    for (int i = 0; i < text.length(); i++) {
-        if (text[i].isLetterOrNumber()) {
-            inWord = true;
-            separatorCount = 0;
-            wordLen++;
-            alphaNumericCharacters++;
-        } else if (text[i].isSpace() && inWord) {
-            inWord = false;
-            words++;
-
-            if (separatorCount > 0) {
-                wordLen--;
-                alphaNumericCharacters--;
-            }
-
-            separatorCount = 0;
+    if
+    (
+        !startBlock.isValid()
+        || !endBlock.isValid()
+        || ((endBlock.blockNumber() - startBlock.blockNumber() + 1) < BulkBlockCount)
+    ) {
+        return false;
+    }
 
-            if (wordLen > 6) {
-                lixLongWords++;
-            }
+    typedef struct
+    {
+        QString text;
+        TextTokenizer::Counts counts;
+        bool cached;
+    } Job;
+
+    QSharedPointer<DocumentCache> cache = document->documentCache();
+    int blockNumber = startBlock.blockNumber();
+    QVector<Job> jobs;
+    jobs.reserve(endBlock.blockNumber() - blockNumber + 1);
+
+    for (QTextBlock block = startBlock; block.isValid(); block = block.next()) {
+        Job job;
+        job.text = block.text();
+        job.cached = !cache.isNull()
+            && cache->blockStatistics(blockNumber++, job.text, job.counts);
+        jobs.append(job);
+
+        if (block == endBlock) {
+            break;
+        }
+    }
 
-            wordLen = 0;
-        } else {
-            // This is to handle things like double dashes (`--`)
-            // that separate words, while still counting hyphenated
-            // words as a single word.
-            //
-            separatorCount++;
-
-            if (inWord) {
-                if (separatorCount > 1) {
-                    separatorCount = 0;
-                    inWord = false;
-                    words++;
-                    wordLen--;
-                    alphaNumericCharacters--;
-
-                    if (wordLen > 6) {
-                        lixLongWords++;
-                    }
-
-                    wordLen = 0;
-                } else {
-                    wordLen++;
-                    alphaNumericCharacters++;
-                }
+    QtConcurrent::blockingMap
+    (
+        jobs,
+        [](Job &job) {
+            if (!job.cached) {
+                job.counts = TextTokenizer::count(job.text);
             }
         }
+    );
+
+    // Rebuild the word count tree when next queried rather than looking up
+    // the block number of each block to update it.
+    blockWordCountsValid = false;
+
+    QTextBlock block = startBlock;
+
+    for (const Job &job : jobs) {
+        updateBlockStatistics(block, job.counts);
+        block = block.next();
+    }
+
+    return true;
+}
+
+// Adds the given change in word count of the given block to the word count
+// tree, unless the tree is to be rebuilt anyway.  Blocks that are inserted
+// change the block count, which invalidates the tree.
+//
+void DocumentStatisticsPrivate::updateBlockWordCount(const QTextBlock &block, int delta)
+{
+    if (!blockWordCountsValid || (0 == delta)) {
+        return;
     }
 
-    if (inWord) {
-        words++;
+    int size = blockWordCounts.size() - 1;
+
+    if (size != document->blockCount()) {
+        blockWordCountsValid = false;
+        return;
+    }
 
-        if (separatorCount > 0) {
-            wordLen--;
-            alphaNumericCharacters--;
+    for (int i = block.blockNumber() + 1; i <= size; i += (i & -i)) {
+        blockWordCounts[i] += delta;
+    }
+}
+
+// Rebuilds the word count tree from the blocks' counts in linear time.
+//
+void DocumentStatisticsPrivate::rebuildBlockWordCounts()
+{
+    int size = document->blockCount();
+
+    blockWordCounts.fill(0, size + 1);
+
+    int i = 1;
+
+    for (QTextBlock block = document->begin(); block.isValid() && (i <= size); block = block.next()) {
+        TextBlockData *blockData = (TextBlockData *) block.userData();
+
+        if (nullptr != blockData) {
+            blockWordCounts[i] += blockData->wordCount;
         }
 
-        if (wordLen > 6) {
-            lixLongWords++;
+        int parent = i + (i & -i);
+
+        if (parent <= size) {
+            blockWordCounts[parent] += blockWordCounts[i];
         }
+
+        i++;
+    }
+
+    blockWordCountsValid = true;
+}
+
+// Returns the sum of the word counts of the first blockCount blocks.
+//
+int DocumentStatisticsPrivate::blockWordCountSum(int blockCount) const
+{
+    int sum = 0;
+
+    for (int i = blockCount; i > 0; i -= (i & -i)) {
+        sum += blockWordCounts[i];
     }
+
+    return sum;
 }
 
-int DocumentStatisticsPrivate::countSentences(const QString &text)
+DocumentStatistics::Statistics DocumentStatistics::statisticsOf(const QString &text)
 {
-    int count = 0;
+    int words = 0;
+    int longWords = 0;
+    int wordCharacters = 0;
+    int sentences = 0;
+    int paragraphs = 0;
 
-    QString trimmedText = text.trimmed();
+    // Count line by line, as the blocks of a document are counted.
+    int start = 0;
 
-    if (trimmedText.length() > 0) {
-        QTextBoundaryFinder boundaryFinder(QTextBoundaryFinder::Sentence, trimmedText);
-        int nextSentencePos = 0;
+    while (start <= text.length()) {
+        int end = text.indexOf('\n', start);
 
-        boundaryFinder.setPosition(0);
+        if (end < 0) {
+            end = text.length();
+        }
 
-        while (nextSentencePos >= 0) {
-            int oldPos = nextSentencePos;
-            nextSentencePos = boundaryFinder.toNextBoundary();
+        QString line = text.mid(start, end - start);
+        TextTokenizer::Counts counts = TextTokenizer::count(line);
 
-            if
-            (
-                ((nextSentencePos - oldPos) > 1) ||
-                (((nextSentencePos - oldPos) > 0) &&
-                 !trimmedText[oldPos].isSpace())
-            ) {
-                count++;
-            }
+        words += counts.words;
+        longWords += counts.longWords;
+        wordCharacters += counts.alphaNumericCharacters;
+        sentences += counts.sentences;
+
+        if (line.trimmed().length() > 0) {
+            paragraphs++;
         }
+
+        start = end + 1;
     }
 
-    return count;
+    Statistics statistics;
+    statistics.wordCount = words;
+    statistics.totalWordCount = words;
+    statistics.characterCount = text.length();
+    statistics.sentenceCount = sentences;
+    statistics.paragraphCount = paragraphs;
+    statistics.pageCount = DocumentStatisticsPrivate::calculatePageCount(words);
+    statistics.complexWords = DocumentStatisticsPrivate::calculateComplexWords(words, longWords);
+    statistics.readingTime = DocumentStatisticsPrivate::calculateReadingTime(words);
+    statistics.lixReadingEase = DocumentStatisticsPrivate::calculateLIX(words, longWords, sentences);
+    statistics.readabilityIndex = DocumentStatisticsPrivate::calculateCLI(wordCharacters, words, sentences);
+    return statistics;
 }
 
 int DocumentStatisticsPrivate::calculatePageCount(int words)
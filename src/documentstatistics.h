@@ -39,83 +39,101 @@ class DocumentStatistics : public QObject
 
 public:
     /**
-     * Constructor.  Pass in the MarkdownDocument as parameter.
+     * Snapshot of the statistics published by statisticsChanged().
      */
-    DocumentStatistics(MarkdownDocument *document, QObject *parent = nullptr);
+    struct Statistics
+    {
+        // Word count of the entire document or of the selected text.
+        int wordCount;
 
-    /**
-     * Destructor.
-     */
-    virtual ~DocumentStatistics();
+        // Word count of the entire document, even if text is selected.
+        int totalWordCount;
 
-    /**
-     * Gets the word count of the document.
-     */
-    int wordCount() const;
+        int characterCount;
+        int sentenceCount;
+        int paragraphCount;
+        int pageCount;
 
-signals:
-    /**
-     * Emitted when word count changes.  May be word count
-     * of entire document or of selected text.
-     */
-    void wordCountChanged(int value);
+        // Percentage of complex words.
+        int complexWords;
 
-    /**
-     * Emitted when word count changes.  The value is
-     * always the word count of the entire document.
-     */
-    void totalWordCountChanged(int value);
+        // Reading time in minutes.
+        int readingTime;
+
+        // LIX reading ease.
+        int lixReadingEase;
+
+        // Coleman-Liau readability index (CLI).
+        int readabilityIndex;
+
+        Statistics();
+
+        bool operator==(const Statistics &other) const;
+        bool operator!=(const Statistics &other) const;
+    };
 
     /**
-     * Emitted when character count changes.
+     * Minimum time between publishing statistics, in milliseconds,
+     * which is about one frame.
      */
-    void characterCountChanged(int value);
+    static const int PublishInterval = 16;
 
     /**
-     * Emitted when paragraph count changes.
+     * Constructor.  Pass in the MarkdownDocument as parameter.
      */
-    void paragraphCountChanged(int value);
+    DocumentStatistics(MarkdownDocument *document, QObject *parent = nullptr);
 
     /**
-     * Emitted when sentence count changes.
+     * Destructor.
      */
-    void sentenceCountChanged(int value);
+    virtual ~DocumentStatistics();
 
     /**
-     * Emitted when page count changes.
+     * Computes the statistics of the given text the same way as those of
+     * a document, such as for files that are not open.  This method may
+     * be called from any thread.
      */
-    void pageCountChanged(int value);
+    static Statistics statisticsOf(const QString &text);
 
     /**
-     * Emitted when complex word percentage changes.
+     * Gets the word count of the document.
      */
-    void complexWordsChanged(int percentage);
+    int wordCount() const;
 
     /**
-     * Emitted when reading time changes.
+     * Gets the word count of the given range of blocks (inclusive), by
+     * block number, such as that of a section of the document.  This takes
+     * logarithmic time in the number of blocks, apart from once after
+     * blocks are inserted or removed.  Edits whose counting is deferred
+     * are included once they are counted.
      */
-    void readingTimeChanged(int minutes);
+    int wordCount(int firstBlockNumber, int lastBlockNumber) const;
 
     /**
-     * Emitted when LIX reading ease value changes.
+     * Sets whether the statistics of edited blocks are updated in batches
+     * shortly after the edits, rather than immediately on every edit.  Use
+     * for large documents, where edits can span many blocks.  Note that
+     * wordCount() always includes pending edits.
      */
-    void lixReadingEaseChanged(int value);
+    void setDeferredUpdatesEnabled(bool enabled);
 
+signals:
     /**
-     * Emitted when Coleman-Liau readability index (CLI) changes.
+     * Emitted when the statistics change, at most once per
+     * PublishInterval milliseconds no matter how many edits are made in
+     * the meantime.  The statistics may be of the entire document or of
+     * the selected text.
      */
-    void readabilityIndexChanged(int value);
+    void statisticsChanged(const DocumentStatistics::Statistics &statistics);
 
 public slots:
     /**
-     * Recalculates statistics text selected in the document's editor.
+     * Recalculates statistics for the text selected in the document's
+     * editor.  Large selections are counted in batches from the event
+     * loop, and the statistics are published once they are all counted.
+     * A new selection abandons counting the previous one.
      */
-    void onTextSelected
-    (
-        const QString &selectedText,
-        int selectionStart,
-        int selectionEnd
-    );
+    void onTextSelected(int selectionStart, int selectionEnd);
 
     /**
      * Reverts statistics to be for entire document after text has been
@@ -126,7 +144,7 @@ public slots:
 
 protected slots:
     void onTextChanged(int position, int charsRemoved, int charsAdded);
-    void onTextBlockRemoved(const QTextBlock &blockData);
+    void onTextBlocksRemoved(const MarkdownDocument::RemovedBlocks &removed);
 
 private:
     QScopedPointer<DocumentStatisticsPrivate> d_ptr;
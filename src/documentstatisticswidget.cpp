@@ -21,6 +21,8 @@
 #include <QLabel>
 
 #include "documentstatisticswidget.h"
+#include "texttokenizer.h"
+#include "vocabularyindex.h"
 
 namespace ghostwriter
 {
@@ -62,6 +64,15 @@ public:
 
     // Coleman-Liau readability index (CLI)
     QLabel *cliLabel;
+
+    // Long words used most often, which a writer may want to vary.
+    static const int RepeatedWordCount = 3;
+    QLabel *repeatedWordsLabel;
+    VocabularyIndex *vocabularyIndex;
+
+    // Latest statistics set, which are displayed once the widget is shown
+    // if it was hidden.
+    DocumentStatistics::Statistics statistics;
 };
 
 DocumentStatisticsWidget::DocumentStatisticsWidget(QWidget *parent)
@@ -79,7 +90,8 @@ DocumentStatisticsWidget::DocumentStatisticsWidget(QWidget *parent)
     d->readingTimeLabel = addStatisticLabel(tr("Reading Time:"), LESS_THAN_ONE_MINUTE_STR);
     d->lixReadingEaseLabel = addStatisticLabel(tr("Reading Ease:"), d->VERY_EASY_READING_EASE_STR, tr("LIX Reading Ease"));
     d->cliLabel = addStatisticLabel(tr("Grade Level:"), "0", tr("Coleman-Liau Readability Index (CLI)"));
-
+    d->repeatedWordsLabel = addStatisticLabel(tr("Most Repeated:"), "-", tr("Long words used most often"));
+    d->vocabularyIndex = nullptr;
 }
 
 DocumentStatisticsWidget::~DocumentStatisticsWidget()
@@ -87,6 +99,63 @@ DocumentStatisticsWidget::~DocumentStatisticsWidget()
 
 }
 
+void DocumentStatisticsWidget::setVocabularyIndex(VocabularyIndex *index)
+{
+    Q_D(DocumentStatisticsWidget);
+
+    d->vocabularyIndex = index;
+}
+
+void DocumentStatisticsWidget::setStatistics(const DocumentStatistics::Statistics &statistics)
+{
+    Q_D(DocumentStatisticsWidget);
+
+    d->statistics = statistics;
+
+    if (!deferDisplay()) {
+        displayStatistics();
+    }
+}
+
+void DocumentStatisticsWidget::displayStatistics()
+{
+    Q_D(DocumentStatisticsWidget);
+
+    const DocumentStatistics::Statistics &statistics = d->statistics;
+
+    setWordCount(statistics.wordCount);
+    setCharacterCount(statistics.characterCount);
+    setSentenceCount(statistics.sentenceCount);
+    setParagraphCount(statistics.paragraphCount);
+    setPageCount(statistics.pageCount);
+    setComplexWords(statistics.complexWords);
+    setReadingTime(statistics.readingTime);
+    setLixReadingEase(statistics.lixReadingEase);
+    setReadabilityIndex(statistics.readabilityIndex);
+
+    // The index is only scanned for the most repeated words while they
+    // are displayed.
+    if (nullptr != d->vocabularyIndex) {
+        QStringList repeatedWords;
+        QVector<QPair<QString, int>> mostFrequent =
+            d->vocabularyIndex->mostFrequentWords
+            (
+                DocumentStatisticsWidgetPrivate::RepeatedWordCount,
+                TextTokenizer::LongWordLength + 1
+            );
+
+        for (const QPair<QString, int> &word : mostFrequent) {
+            repeatedWords.append(tr("%1 (%2)").arg(word.first).arg(word.second));
+        }
+
+        setStringValueForLabel
+        (
+            d->repeatedWordsLabel,
+            repeatedWords.isEmpty() ? QString("-") : repeatedWords.join(", ")
+        );
+    }
+}
+
 void DocumentStatisticsWidget::setWordCount(int value)
 {
     Q_D(DocumentStatisticsWidget);
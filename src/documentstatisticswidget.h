@@ -23,9 +23,12 @@
 #include <QScopedPointer>
 
 #include "abstractstatisticswidget.h"
+#include "documentstatistics.h"
 
 namespace ghostwriter
 {
+class VocabularyIndex;
+
 /**
  * Widget to display document statistics
  */
@@ -46,7 +49,19 @@ public:
      */
     virtual ~DocumentStatisticsWidget();
 
+    /**
+     * Sets the index of the document's words, from which the words that
+     * the document repeats most are displayed along with its statistics.
+     */
+    void setVocabularyIndex(VocabularyIndex *index);
+
 public slots:
+    /**
+     * Sets all the statistics to display.  While the widget is hidden, the
+     * statistics are only stored, and are displayed once it is shown.
+     */
+    void setStatistics(const DocumentStatistics::Statistics &statistics);
+
     /**
      * Sets the word count to display.
      */
@@ -92,6 +107,12 @@ public slots:
      */
     void setReadabilityIndex(int value);
 
+protected:
+    /**
+     * Overridden to display the latest statistics set.
+     */
+    void displayStatistics();
+
 private:
     QScopedPointer<DocumentStatisticsWidgetPrivate> d_ptr;
 };
@@ -0,0 +1,131 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFile>
+#include <QObject>
+#include <QSaveFile>
+#include <QTextStream>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "documentwriter.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+QString DocumentWriter::write
+(
+    const QString &filePath,
+    const QString &text,
+    bool createBackup
+)
+{
+    GW_TRACE_SCOPE("saveToDisk");
+    QString err;
+
+    if (filePath.isNull() || filePath.isEmpty()) {
+        return QObject::tr("Null or empty file path provided for writing.");
+    }
+
+    if (createBackup && QFile::exists(filePath)) {
+        backup(filePath);
+    }
+
+    // Write the text to a temporary file that then replaces the file, so
+    // that the file is never left half written should saving fail midway.
+    // Writing directly to the file is only permitted as a fallback if its
+    // directory is not writable, in which case no backup could have been
+    // made either.
+    //
+    QSaveFile outputFile(filePath);
+    outputFile.setDirectWriteFallback(true);
+
+    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return outputFile.errorString();
+    }
+
+    // Write contents to disk.
+    QTextStream outStream(&outputFile);
+
+    // Markdown files need to be in UTF-8, since most Markdown processors
+    // (i.e., Pandoc, et. al.) can only read UTF-8 encoded text files.
+    //
+    outStream.setCodec("UTF-8");
+    outStream << text;
+    outStream.flush();
+
+    if (QFile::NoError != outputFile.error()) {
+        err = outputFile.errorString();
+        outputFile.cancelWriting();
+    }
+
+    // Flush the file to disk and replace the old one with it.  All done!
+    if (!outputFile.commit() && err.isNull()) {
+        err = outputFile.errorString();
+    }
+
+    return err;
+}
+
+void DocumentWriter::backup(const QString &filePath)
+{
+    QString backupFilePath = filePath + ".backup";
+    QFile backupFile(backupFilePath);
+
+    if (backupFile.exists()) {
+        if (!backupFile.remove()) {
+            qCritical("Could not remove backup file %s before saving: %s",
+                      backupFilePath.toLatin1().data(),
+                      backupFile.errorString().toLatin1().data());
+            return;
+        }
+    }
+
+#ifdef Q_OS_UNIX
+    // Since saving replaces the file with a new one rather than rewriting
+    // it, the backup can simply be another link to the old file, which
+    // saves copying it.  Not all file systems support hard links, though.
+    //
+    if (0 == ::link(QFile::encodeName(filePath).constData(), QFile::encodeName(backupFilePath).constData())) {
+        return;
+    }
+#endif
+
+    QFile file(filePath);
+
+    if (!file.copy(backupFilePath)) {
+        qCritical("Failed to backup file to %s: %s",
+                  backupFilePath.toLatin1().data(),
+                  file.errorString().toLatin1().data());
+    }
+}
+
+void DocumentWriter::rewatch(QFileSystemWatcher *watcher, const QString &filePath)
+{
+    // Watching a path that is already watched does nothing, even if the
+    // path now names another file, so stop watching it first.
+    watcher->removePath(filePath);
+
+    if (QFile::exists(filePath)) {
+        watcher->addPath(filePath);
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,69 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef DOCUMENT_WRITER_H
+#define DOCUMENT_WRITER_H
+
+#include <QFileSystemWatcher>
+#include <QString>
+
+namespace ghostwriter
+{
+/**
+ * Writes documents to disk on behalf of the DocumentManager, and keeps
+ * its file watcher on the written files.  The methods that write to disk
+ * may be called from any thread, and should never interact with any
+ * widgets.
+ */
+class DocumentWriter
+{
+public:
+    /**
+     * Saves the given text to the given file path as UTF-8, first
+     * creating a backup of any existing file if createBackup is true.
+     * Returns a null string if successful, otherwise an error message.
+     */
+    static QString write
+    (
+        const QString &filePath,
+        const QString &text,
+        bool createBackup
+    );
+
+    /**
+     * Creates a backup file with a ".backup" extension of the file having
+     * the specified path.
+     */
+    static void backup(const QString &filePath);
+
+    /**
+     * Has the given watcher watch the file at the given path again, which
+     * must be done after every write.  Saving replaces the file with a new
+     * one rather than rewriting it, and the backup may take over the old
+     * one, so that the watcher would otherwise either lose track of the
+     * file or follow the backup.  Call from the thread of the watcher.
+     */
+    static void rewatch(QFileSystemWatcher *watcher, const QString &filePath);
+
+private:
+    DocumentWriter();
+};
+} // namespace ghostwriter
+
+#endif // DOCUMENT_WRITER_H
@@ -0,0 +1,219 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+
+#include "editjournal.h"
+
+namespace ghostwriter
+{
+// Identifies the version of a file by its size and modification time.
+static void fileVersion(const QString &filePath, qint64 &size, qint64 &lastModified)
+{
+    QFileInfo fileInfo(filePath);
+
+    size = fileInfo.size();
+    lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+}
+
+EditJournal::EditJournal()
+    : suspended(false)
+{
+    ;
+}
+
+EditJournal::~EditJournal()
+{
+    stop();
+}
+
+QString EditJournal::journalPath(const QString &filePath)
+{
+    return filePath + ".journal";
+}
+
+bool EditJournal::exists(const QString &filePath)
+{
+    return QFile::exists(journalPath(filePath));
+}
+
+bool EditJournal::replay(const QString &filePath, QString &text)
+{
+    QFile journalFile(journalPath(filePath));
+
+    if (!journalFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&journalFile);
+    quint32 magic;
+    quint32 version;
+    qint64 size;
+    qint64 lastModified;
+
+    in >> magic >> version >> size >> lastModified;
+
+    qint64 fileSize;
+    qint64 fileLastModified;
+
+    fileVersion(filePath, fileSize, fileLastModified);
+
+    if
+    (
+        (QDataStream::Ok != in.status())
+        || (MAGIC != magic)
+        || (VERSION != version)
+        || (fileSize != size)
+        || (fileLastModified != lastModified)
+    ) {
+        return false;
+    }
+
+    QString replayed = text;
+
+    while (!in.atEnd()) {
+        qint32 position;
+        qint32 charsRemoved;
+        QString insertedText;
+
+        in >> position >> charsRemoved >> insertedText;
+
+        if (QDataStream::Ok != in.status()) {
+            break;
+        }
+
+        if ((position < 0) || (position > replayed.length()) || (charsRemoved < 0)) {
+            return false;
+        }
+
+        replayed.replace
+        (
+            position,
+            qMin(charsRemoved, replayed.length() - position),
+            insertedText
+        );
+    }
+
+    text = replayed;
+    return true;
+}
+
+void EditJournal::remove(const QString &filePath)
+{
+    QFile::remove(journalPath(filePath));
+}
+
+bool EditJournal::start(const QString &filePath, bool append)
+{
+    if (file.isOpen()) {
+        file.close();
+    }
+
+    journaledFilePath = filePath;
+    suspended = false;
+    file.setFileName(journalPath(filePath));
+
+    bool opened;
+
+    if (append && file.exists()) {
+        opened = file.open(QIODevice::WriteOnly | QIODevice::Append);
+    } else {
+        opened = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+
+        if (opened) {
+            writeHeader(filePath);
+        }
+    }
+
+    if (opened) {
+        file.write(pendingRecords);
+        file.flush();
+    }
+
+    pendingRecords.clear();
+    return opened;
+}
+
+void EditJournal::suspend()
+{
+    if (file.isOpen()) {
+        file.close();
+    }
+
+    suspended = true;
+}
+
+void EditJournal::stop()
+{
+    if (file.isOpen()) {
+        file.close();
+    }
+
+    suspended = false;
+    pendingRecords.clear();
+}
+
+bool EditJournal::isActive() const
+{
+    return file.isOpen();
+}
+
+bool EditJournal::isSuspended() const
+{
+    return suspended;
+}
+
+QString EditJournal::filePath() const
+{
+    return journaledFilePath;
+}
+
+void EditJournal::record(int position, int charsRemoved, const QString &insertedText)
+{
+    if (file.isOpen()) {
+        QDataStream out(&file);
+        out << (qint32) position << (qint32) charsRemoved << insertedText;
+    } else if (suspended) {
+        QDataStream out(&pendingRecords, QIODevice::WriteOnly | QIODevice::Append);
+        out << (qint32) position << (qint32) charsRemoved << insertedText;
+    }
+}
+
+void EditJournal::flush()
+{
+    if (file.isOpen()) {
+        file.flush();
+    }
+}
+
+void EditJournal::writeHeader(const QString &filePath)
+{
+    qint64 size;
+    qint64 lastModified;
+
+    fileVersion(filePath, size, lastModified);
+
+    QDataStream out(&file);
+
+    out << MAGIC << VERSION << size << lastModified;
+}
+} // namespace ghostwriter
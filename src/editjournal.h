@@ -0,0 +1,146 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef EDIT_JOURNAL_H
+#define EDIT_JOURNAL_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+namespace ghostwriter
+{
+/**
+ * Append-only journal of the edits made to a document since it was last
+ * saved, kept in a file next to the document's file for crash recovery.
+ *
+ * The journal begins with a header identifying the version of the file
+ * that the edits apply to, followed by one record per edit giving its
+ * position, the number of characters removed and the text inserted.
+ * Should ghostwriter crash, the edits can be replayed onto the file
+ * the next time it is opened.
+ */
+class EditJournal
+{
+public:
+    /**
+     * Constructor.
+     */
+    EditJournal();
+
+    /**
+     * Destructor.  Closes the journal file, but leaves it on disk.
+     */
+    ~EditJournal();
+
+    /**
+     * Returns the path of the journal for the file at the given path.
+     */
+    static QString journalPath(const QString &filePath);
+
+    /**
+     * Returns true if there is a journal on disk for the file at the given
+     * path.
+     */
+    static bool exists(const QString &filePath);
+
+    /**
+     * Replays the edits from the journal for the file at the given path
+     * onto the given text, which must be the contents of the file.
+     * Returns false if the journal does not apply to the current version
+     * of the file, in which case the text is left as is.  An incomplete
+     * last record, such as one cut short by a crash, is ignored.
+     */
+    static bool replay(const QString &filePath, QString &text);
+
+    /**
+     * Deletes the journal for the file at the given path, if any.
+     */
+    static void remove(const QString &filePath);
+
+    /**
+     * Starts a new journal for the file at the given path, replacing any
+     * old one.  If append is true, an existing journal for the current
+     * version of the file is added to instead, i.e., after its edits were
+     * replayed.  Any records made while the journal was suspended are
+     * written to the new journal.  Returns false if the journal could not
+     * be written.
+     */
+    bool start(const QString &filePath, bool append = false);
+
+    /**
+     * Closes the journal file, and holds the records made from here on in
+     * memory until the journal is started again.  Call when saving the
+     * file, so that the edits made while it is being saved can be written
+     * to the journal for the newly saved version of the file.
+     */
+    void suspend();
+
+    /**
+     * Closes the journal, leaving it on disk, and discards any records
+     * held while it was suspended.
+     */
+    void stop();
+
+    /**
+     * Returns true if a journal has been started and is being written.
+     */
+    bool isActive() const;
+
+    /**
+     * Returns true if the journal has been suspended.
+     */
+    bool isSuspended() const;
+
+    /**
+     * Returns the path of the file whose edits are being journaled.
+     */
+    QString filePath() const;
+
+    /**
+     * Appends a record of an edit to the journal.
+     */
+    void record(int position, int charsRemoved, const QString &insertedText);
+
+    /**
+     * Writes any buffered records to disk.
+     */
+    void flush();
+
+private:
+    QFile file;
+    QString journaledFilePath;
+    bool suspended;
+
+    // Records made while the journal is suspended.
+    QByteArray pendingRecords;
+
+    static const quint32 MAGIC = 0x67774a4e; // "gwJN"
+    static const quint32 VERSION = 1;
+
+    /*
+    * Writes the header for the current version of the file at the given
+    * path to the journal.
+    */
+    void writeHeader(const QString &filePath);
+};
+} // namespace ghostwriter
+
+#endif // EDIT_JOURNAL_H
@@ -0,0 +1,264 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+#include "exportcache.h"
+#include "tracer.h"
+#ifndef GW_NO_WEBENGINE
+#include "pdfprinter.h"
+#endif
+
+#define GW_EXPORT_CACHE_FILE_NAME "exportcache.ini"
+#define GW_EXPORT_HASH_KEY "hash"
+#define GW_EXPORT_MODIFIED_KEY "modified"
+#define GW_EXPORT_SIZE_KEY "size"
+
+namespace ghostwriter
+{
+bool ExportCache::exportToFile
+(
+    Exporter *exporter,
+    const ExportFormat *format,
+    const QString &inputFilePath,
+    const QString &text,
+    const QString &outputFilePath,
+    QString &err,
+    bool force,
+    const QStringList &renderedHtml
+)
+{
+    QStringList errors;
+    QList<bool> skipped =
+        exportToFiles
+        (
+            exporter,
+            QList<const ExportFormat *>() << format,
+            inputFilePath,
+            text,
+            QStringList(outputFilePath),
+            errors,
+            force,
+            renderedHtml
+        );
+
+    err = errors.first();
+    return skipped.first();
+}
+
+QList<bool> ExportCache::exportToFiles
+(
+    Exporter *exporter,
+    const QList<const ExportFormat *> &formats,
+    const QString &inputFilePath,
+    const QString &text,
+    const QStringList &outputFilePaths,
+    QStringList &errors,
+    bool force,
+    const QStringList &renderedHtml
+)
+{
+    GW_TRACE_SCOPE("ExportCache::exportToFiles");
+
+    QSettings cache(cacheFilePath(), QSettings::IniFormat);
+    QList<bool> skipped;
+    QStringList hashes;
+    QList<const ExportFormat *> staleFormats;
+    QStringList staleFilePaths;
+
+    for (int i = 0; i < formats.size(); i++) {
+        QString hash = QString::fromLatin1
+            (
+                exportHash(exporter, formats[i], inputFilePath, text).toHex()
+            );
+
+        hashes.append(hash);
+
+        if (!force && isUpToDate(cache, outputFilePaths[i], hash)) {
+            skipped.append(true);
+        } else {
+            skipped.append(false);
+            staleFormats.append(formats[i]);
+            staleFilePaths.append(outputFilePaths[i]);
+
+            // Forget the last export right away, in case this one fails
+            // after having overwritten the file.
+            //
+            cache.remove(entryGroup(outputFilePaths[i]));
+        }
+    }
+
+    cache.sync();
+
+    QStringList staleErrors;
+    QList<const ExportFormat *> exportFormats;
+    QStringList exportFilePaths;
+    QList<int> exportIndexes;
+
+    // Write out the HTML already rendered for the formats that the
+    // exporter can write from it, and export the text to the others.
+    for (int i = 0; i < staleFormats.size(); i++) {
+        QString err;
+
+        if
+        (
+            !renderedHtml.isEmpty()
+            && exporter->exportRenderedHtml(staleFormats[i], renderedHtml, staleFilePaths[i], err)
+        ) {
+            staleErrors.append(err);
+        } else {
+            staleErrors.append(QString());
+            exportFormats.append(staleFormats[i]);
+            exportFilePaths.append(staleFilePaths[i]);
+            exportIndexes.append(i);
+        }
+    }
+
+    if (!exportFormats.isEmpty()) {
+        QStringList exportErrors;
+
+        exporter->exportToFiles
+        (
+            exportFormats,
+            inputFilePath,
+            text,
+            exportFilePaths,
+            exportErrors
+        );
+
+        for (int i = 0; i < exportIndexes.size(); i++) {
+            staleErrors[exportIndexes[i]] = exportErrors[i];
+        }
+    }
+
+    errors.clear();
+
+    for (int i = 0, stale = 0; i < formats.size(); i++) {
+        if (skipped[i]) {
+            errors.append(QString());
+            continue;
+        }
+
+        QString err = staleErrors[stale++];
+        QFileInfo outputInfo(outputFilePaths[i]);
+
+        if (err.isNull() && outputInfo.exists()) {
+            cache.beginGroup(entryGroup(outputFilePaths[i]));
+            cache.setValue(GW_EXPORT_HASH_KEY, hashes[i]);
+            cache.setValue
+            (
+                GW_EXPORT_MODIFIED_KEY,
+                outputInfo.lastModified().toMSecsSinceEpoch()
+            );
+            cache.setValue(GW_EXPORT_SIZE_KEY, outputInfo.size());
+            cache.endGroup();
+        }
+
+        errors.append(err);
+    }
+
+    return skipped;
+}
+
+QByteArray ExportCache::exportHash
+(
+    const Exporter *exporter,
+    const ExportFormat *format,
+    const QString &inputFilePath,
+    const QString &text
+)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    // The application version stands in for the version of the Markdown
+    // processors bundled with the application.
+    //
+    QStringList settings;
+    settings << QCoreApplication::applicationVersion()
+             << exporter->name()
+             << exporter->version()
+             << format->name()
+             << (exporter->smartTypographyEnabled() ? "smart" : "plain")
+             << inputFilePath;
+
+#ifndef GW_NO_WEBENGINE
+    if (ExportFormat::PDF == format) {
+        settings << QString::number((int) PdfPrinter::pageSize());
+    }
+#endif
+
+    hash.addData(settings.join(QChar('\n')).toUtf8());
+    hash.addData("\n\n", 2);
+    hash.addData(text.toUtf8());
+
+    return hash.result();
+}
+
+QString ExportCache::entryGroup(const QString &outputFilePath)
+{
+    // Output file paths make for poor setting keys, since slashes
+    // separate groups.
+    //
+    return QString::fromLatin1
+        (
+            QCryptographicHash::hash
+            (
+                QFileInfo(outputFilePath).absoluteFilePath().toUtf8(),
+                QCryptographicHash::Sha1
+            ).toHex()
+        );
+}
+
+bool ExportCache::isUpToDate
+(
+    QSettings &cache,
+    const QString &outputFilePath,
+    const QString &hash
+)
+{
+    QFileInfo outputInfo(outputFilePath);
+    bool upToDate = false;
+
+    cache.beginGroup(entryGroup(outputFilePath));
+
+    upToDate =
+        outputInfo.exists()
+        && (cache.value(GW_EXPORT_HASH_KEY).toString() == hash)
+        && (cache.value(GW_EXPORT_MODIFIED_KEY).toLongLong()
+            == outputInfo.lastModified().toMSecsSinceEpoch())
+        && (cache.value(GW_EXPORT_SIZE_KEY).toLongLong() == outputInfo.size());
+
+    cache.endGroup();
+
+    return upToDate;
+}
+
+QString ExportCache::cacheFilePath()
+{
+    QSettings settings;
+
+    return QFileInfo(settings.fileName())
+        .dir()
+        .absoluteFilePath(GW_EXPORT_CACHE_FILE_NAME);
+}
+} // namespace ghostwriter
@@ -0,0 +1,132 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef EXPORT_CACHE_H
+#define EXPORT_CACHE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QSettings>
+#include <QString>
+#include <QStringList>
+
+#include "exporter.h"
+#include "exportformat.h"
+
+namespace ghostwriter
+{
+/**
+ * Remembers what was last exported to each output file, so that exporting
+ * the same text again is skipped rather than rerun, which can take seconds
+ * with some processors.  An export is only skipped if the text, the input
+ * file path, the exporter and its version, the format and the smart
+ * typography setting are all the same as for the last export to that
+ * file, and if the file has not been modified since.  Note that changes
+ * to files referenced by the text, such as images, are not detected.
+ *
+ * This class may be used from any thread.
+ */
+class ExportCache
+{
+public:
+    /**
+     * Exports the given text to the given format and output file path
+     * with the given exporter, unless the output file already holds the
+     * same export.  Set the force parameter to true to export regardless.
+     * Returns true if the export was skipped, in which case err is set to
+     * a null string.  Otherwise, err is set as by Exporter::exportToFile().
+     *
+     * If the top-level HTML blocks that the exporter rendered from the
+     * same text are given, such as those of the live preview, they are
+     * written out instead of exporting the text again, if the exporter
+     * supports it for the format.  See Exporter::exportRenderedHtml().
+     */
+    static bool exportToFile
+    (
+        Exporter *exporter,
+        const ExportFormat *format,
+        const QString &inputFilePath,
+        const QString &text,
+        const QString &outputFilePath,
+        QString &err,
+        bool force = false,
+        const QStringList &renderedHtml = QStringList()
+    );
+
+    /**
+     * Exports the given text to each of the given formats, writing each
+     * to the output file path at the same index, as with
+     * Exporter::exportToFiles().  Only the output files that do not
+     * already hold the same export are exported, unless force is true.
+     * Returns whether the export to each format was skipped.  The HTML
+     * blocks rendered from the text may be given as for exportToFile().
+     */
+    static QList<bool> exportToFiles
+    (
+        Exporter *exporter,
+        const QList<const ExportFormat *> &formats,
+        const QString &inputFilePath,
+        const QString &text,
+        const QStringList &outputFilePaths,
+        QStringList &errors,
+        bool force = false,
+        const QStringList &renderedHtml = QStringList()
+    );
+
+private:
+    /*
+    * Returns the hash identifying the export of the given text with the
+    * given exporter settings.
+    */
+    static QByteArray exportHash
+    (
+        const Exporter *exporter,
+        const ExportFormat *format,
+        const QString &inputFilePath,
+        const QString &text
+    );
+
+    /*
+    * Returns the settings group of the cache entry for the given
+    * output file.
+    */
+    static QString entryGroup(const QString &outputFilePath);
+
+    /*
+    * Returns true if the given output file holds the export with the
+    * given hash, according to the cache.
+    */
+    static bool isUpToDate
+    (
+        QSettings &cache,
+        const QString &outputFilePath,
+        const QString &hash
+    );
+
+    /*
+    * Returns the path of the file holding the cache, which is kept next
+    * to the application settings.
+    */
+    static QString cacheFilePath();
+
+    ExportCache();
+};
+} // namespace ghostwriter
+
+#endif // EXPORT_CACHE_H
@@ -17,10 +17,8 @@
  *
  ***********************************************************************/
 
-#include <QApplication>
 #include <QCheckBox>
 #include <QComboBox>
-#include <QDesktopServices>
 #include <QDialogButtonBox>
 #include <QFileDialog>
 #include <QFileInfo>
@@ -28,24 +26,31 @@
 #include <QGroupBox>
 #include <QLabel>
 #include <QList>
+#include <QPageSize>
 #include <QPushButton>
 #include <QSettings>
+#include <QStandardPaths>
 #include <QString>
-#include <QUrl>
 #include <QVBoxLayout>
+#include <QtConcurrentRun>
 
 #include "exportdialog.h"
 #include "exporter.h"
 #include "exporterfactory.h"
-#include "messageboxhelper.h"
+#include "exportonsave.h"
+#include "pdfprinter.h"
 
 #define GW_LAST_EXPORTER_KEY "Export/lastUsedExporter"
 #define GW_SMART_TYPOGRAPHY_KEY "Export/smartTypographyEnabled"
 
 namespace ghostwriter
 {
-ExportDialog::ExportDialog(MarkdownDocument *document, QWidget *parent)
-    : QDialog(parent), document(document)
+ExportDialog::ExportDialog
+(
+    MarkdownDocument *document,
+    ExportJobManager *jobManager,
+    QWidget *parent
+) : QDialog(parent), document(document), jobManager(jobManager)
 {
     QList<Exporter *> exporters =
         ExporterFactory::instance()->fileExporters();
@@ -80,16 +85,39 @@ ExportDialog::ExportDialog(MarkdownDocument *document, QWidget *parent)
         fileFormatComboBox->addItem(format->name(), QVariant::fromValue((void *) format));
     }
     
+    // The page size only applies to PDF printed in-process.
+    pageSizeComboBox = new QComboBox();
+
+    QList<QPageSize::PageSizeId> pageSizes;
+    pageSizes << QPageSize::A4 << QPageSize::A5 << QPageSize::Letter << QPageSize::Legal;
+
+    foreach (QPageSize::PageSizeId pageSize, pageSizes) {
+        pageSizeComboBox->addItem(QPageSize::name(pageSize), (int) pageSize);
+
+        if (PdfPrinter::pageSize() == pageSize) {
+            pageSizeComboBox->setCurrentIndex(pageSizeComboBox->count() - 1);
+        }
+    }
+
+    onFileFormatChanged(fileFormatComboBox->currentIndex());
+
     bool smartTypographyEnabled =
         settings.value(GW_SMART_TYPOGRAPHY_KEY, true).toBool();
     smartTypographyCheckBox = new QCheckBox(tr("Smart Typography"));
     smartTypographyCheckBox->setChecked(smartTypographyEnabled);
 
+    // Only documents saved to a file can be exported when saved.
+    exportOnSaveCheckBox = new QCheckBox(tr("Export again whenever the document is saved"));
+    exportOnSaveCheckBox->setEnabled(!document->filePath().isEmpty());
+    exportOnSaveCheckBox->setChecked(ExportOnSave::target(document->filePath()).isValid());
+
     QGroupBox *optionsGroupBox = new QGroupBox(tr("Export Options"));
     QFormLayout *optionsLayout = new QFormLayout();
     optionsLayout->addRow(tr("Markdown Converter"), exporterComboBox);
     optionsLayout->addRow(tr("File Format"), fileFormatComboBox);
+    optionsLayout->addRow(tr("Page Size"), pageSizeComboBox);
     optionsLayout->addRow(smartTypographyCheckBox);
+    optionsLayout->addRow(exportOnSaveCheckBox);
     optionsGroupBox->setLayout(optionsLayout);
 
     QVBoxLayout *layout = new QVBoxLayout(this);
@@ -103,8 +131,12 @@ ExportDialog::ExportDialog(MarkdownDocument *document, QWidget *parent)
     layout->addWidget(buttonBox);
     
     connect(exporterComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onExporterChanged(int)));
+    connect(fileFormatComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onFileFormatChanged(int)));
+    connect(smartTypographyCheckBox, SIGNAL(toggled(bool)), this, SLOT(prepareExport()));
     connect(buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
     connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+
+    prepareExport();
 }
 
 ExportDialog::~ExportDialog()
@@ -112,6 +144,7 @@ ExportDialog::~ExportDialog()
     QSettings settings;
     settings.setValue(GW_LAST_EXPORTER_KEY, exporterComboBox->currentText());
     settings.setValue(GW_SMART_TYPOGRAPHY_KEY, smartTypographyCheckBox->isChecked());
+    PdfPrinter::setPageSize((QPageSize::PageSizeId) pageSizeComboBox->currentData().toInt());
 }
 
 void ExportDialog::accept()
@@ -165,28 +198,42 @@ void ExportDialog::accept()
     }
 
     QString fileName = fileDialog.selectedFiles().at(0);
-    QString err;
 
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-    emit exportStarted(tr("exporting to %1").arg(fileName));
-
-    exporter->setSmartTypographyEnabled(smartTypographyCheckBox->isChecked());
-    exporter->exportToFile
+    // Save the page size right away, since the export may start printing
+    // before this dialog is closed.
+    //
+    PdfPrinter::setPageSize((QPageSize::PageSizeId) pageSizeComboBox->currentData().toInt());
+
+    // If the live preview is up to date with the text and was rendered
+    // the same way, the export can write out its HTML instead.
+    //
+    QStringList previewHtml;
+    document->previewHtml(exporter, smartTypographyCheckBox->isChecked(), previewHtml);
+
+    // Export a snapshot of the text in the background, so that the user
+    // can keep writing in the meantime.
+    //
+    jobManager->enqueue
     (
+        exporter,
         format,
-        this->document->filePath(),
-        document->toPlainText(),
+        document->filePath(),
+        document->plainTextSnapshot(),
         fileName,
-        err
-    );    
-    
-    emit exportComplete();
-    QApplication::restoreOverrideCursor();
-
-    if (!err.isNull()) {
-        MessageBoxHelper::critical(this, tr("Export failed."), err);
+        smartTypographyCheckBox->isChecked(),
+        previewHtml
+    );
+
+    if (exportOnSaveCheckBox->isChecked()) {
+        ExportOnSave::Target target;
+        target.exporter = exporter;
+        target.format = format;
+        target.outputFilePath = fileName;
+        target.smartTypographyEnabled = smartTypographyCheckBox->isChecked();
+
+        ExportOnSave::setTarget(document->filePath(), target);
     } else {
-        QDesktopServices::openUrl(QUrl::fromLocalFile(fileName));
+        ExportOnSave::clearTarget(document->filePath());
     }
 
     QDialog::accept();
@@ -197,6 +244,14 @@ void ExportDialog::reject()
     QDialog::reject();
 }
 
+void ExportDialog::onFileFormatChanged(int index)
+{
+    const ExportFormat *format =
+        (const ExportFormat *) fileFormatComboBox->itemData(index).value<void *>();
+
+    pageSizeComboBox->setEnabled(ExportFormat::PDF == format);
+}
+
 void ExportDialog::onExporterChanged(int index)
 {
     QVariant exporterVariant = exporterComboBox->itemData(index);
@@ -211,6 +266,30 @@ void ExportDialog::onExporterChanged(int index)
 
     QSettings settings;
     settings.setValue(GW_LAST_EXPORTER_KEY, exporter->name());
+
+    prepareExport();
+}
+
+void ExportDialog::prepareExport()
+{
+    Exporter *exporter = (Exporter *) exporterComboBox->currentData().value<void *>();
+
+    if (nullptr == exporter) {
+        return;
+    }
+
+    QString inputFilePath = document->filePath();
+    QString text = document->plainTextSnapshot();
+    bool smartTypographyEnabled = smartTypographyCheckBox->isChecked();
+
+    // Exporters outlive the dialog, so the preparation is left to finish
+    // on its own should the dialog be closed first.
+    QtConcurrent::run
+    (
+        [exporter, inputFilePath, text, smartTypographyEnabled]() {
+            exporter->prepareExport(inputFilePath, text, smartTypographyEnabled);
+        }
+    );
 }
 
 } // namespace ghostwriter
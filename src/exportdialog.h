@@ -22,6 +22,7 @@
 
 #include <QDialog>
 
+#include "exportjobmanager.h"
 #include "markdowndocument.h"
 
 class QFileDialog;
@@ -35,7 +36,9 @@ namespace ghostwriter
  * logic is performed by Exporters, which are provided by ExporterFactory.  The
  * user can select which exporter to use in a combo box.  Also, an option for
  * enabling/disabling smart typography during export is provided in the form of
- * a checkbox.
+ * a checkbox.  The export itself is queued with an ExportJobManager, which
+ * runs it in the background.  While the dialog is open, the selected exporter
+ * prepares the export ahead of time.
  */
 class ExportDialog : public QDialog
 {
@@ -44,27 +47,18 @@ class ExportDialog : public QDialog
 public:
     /**
      * Constructor that takes text document to export as the parameter,
-     * as well as the parent widget which will own this dialog.
+     * the job manager with which to queue the export once the user has
+     * chosen where to export to, as well as the parent widget which will
+     * own this dialog.
      */
-    ExportDialog(MarkdownDocument *document, QWidget *parent = 0);
+    ExportDialog
+    (
+        MarkdownDocument *document,
+        ExportJobManager *jobManager,
+        QWidget *parent = 0
+    );
     virtual ~ExportDialog();
 
-signals:
-    /**
-     * Emitted when an export operation has begun, so that some sort of
-     * notification can be provided to the user by the calling program,
-     * such as displaying a progress bar.
-     */
-    void exportStarted(const QString &description);
-
-    /**
-     * Emitted when an exprot operation has completed, so that some sort of
-     * notification can be provided to the user by the calling program,
-     * such as removing a progress bar previously shown when the export
-     * operation began.
-     */
-    void exportComplete();
-
 private slots:
     /*
     * Called when the user clicks on Export button.
@@ -82,11 +76,27 @@ private slots:
     */
     void onExporterChanged(int index);
 
+    /*
+    * Called when the user changes which format to export to, in order to
+    * enable choosing the page size only for formats that use it.
+    */
+    void onFileFormatChanged(int index);
+
+    /*
+    * Lets the selected exporter prepare a snapshot of the document's text
+    * in the background while the user chooses the format and file, so
+    * that the export only has to render the format.
+    */
+    void prepareExport();
+
 private:
     QComboBox *fileFormatComboBox;
     QComboBox *exporterComboBox;
+    QComboBox *pageSizeComboBox;
     QCheckBox *smartTypographyCheckBox;
+    QCheckBox *exportOnSaveCheckBox;
     MarkdownDocument *document;
+    ExportJobManager *jobManager;
 };
 } // namespace ghostwriter
 
@@ -30,7 +30,7 @@
 namespace ghostwriter
 {
 Exporter::Exporter(const QString &name)
-    : m_smartTypographyEnabled(false), m_name(name)
+    : m_smartTypographyEnabled(false), m_name(name), m_exportCancelled(0)
 {
     ;
 }
@@ -45,6 +45,16 @@ QString Exporter::name() const
     return m_name;
 }
 
+QString Exporter::version() const
+{
+    return m_version;
+}
+
+void Exporter::setVersion(const QString &version)
+{
+    m_version = version;
+}
+
 const QList<const ExportFormat *> Exporter::supportedFormats() const
 {
     return m_supportedFormats;
@@ -60,6 +70,16 @@ void Exporter::setSmartTypographyEnabled(bool enabled)
     m_smartTypographyEnabled = enabled;
 }
 
+bool Exporter::isExportCancelled() const
+{
+    return 0 != m_exportCancelled.loadAcquire();
+}
+
+void Exporter::setExportCancelled(bool cancelled)
+{
+    m_exportCancelled.storeRelease(cancelled ? 1 : 0);
+}
+
 void Exporter::exportToHtml(const QString &text, QString &html)
 {
     Q_UNUSED(text)
@@ -68,5 +88,62 @@ void Exporter::exportToHtml(const QString &text, QString &html)
            QObject::tr("Export to HTML is not supported with this processor.") +
            QString("</b></center>)");
 }
+
+void Exporter::exportToPreviewHtml(const QString &text, QString &html)
+{
+    exportToHtml(text, html);
+}
+
+void Exporter::exportToFiles
+(
+    const QList<const ExportFormat *> &formats,
+    const QString &inputFilePath,
+    const QString &text,
+    const QStringList &outputFilePaths,
+    QStringList &errors
+)
+{
+    errors.clear();
+
+    for (int i = 0; i < formats.size(); i++) {
+        QString err;
+
+        if (isExportCancelled()) {
+            err = QObject::tr("Export cancelled.");
+        } else {
+            exportToFile(formats[i], inputFilePath, text, outputFilePaths[i], err);
+        }
+
+        errors.append(err);
+    }
+}
+
+void Exporter::prepareExport
+(
+    const QString &inputFilePath,
+    const QString &text,
+    bool smartTypographyEnabled
+)
+{
+    Q_UNUSED(inputFilePath)
+    Q_UNUSED(text)
+    Q_UNUSED(smartTypographyEnabled)
+}
+
+bool Exporter::exportRenderedHtml
+(
+    const ExportFormat *format,
+    const QStringList &htmlBlocks,
+    const QString &outputFilePath,
+    QString &err
+)
+{
+    Q_UNUSED(format)
+    Q_UNUSED(htmlBlocks)
+    Q_UNUSED(outputFilePath)
+    Q_UNUSED(err)
+
+    return false;
+}
 } // namespace ghostwriter
 
@@ -20,7 +20,9 @@
 #ifndef _EXPORTER_H
 #define _EXPORTER_H
 
+#include <QAtomicInt>
 #include <QString>
+#include <QStringList>
 #include <QList>
 
 #include "exportformat.h"
@@ -58,6 +60,17 @@ public:
      */
     void setName(const QString &name);
 
+    /**
+     * Gets the version of the Markdown processor behind the exporter, or
+     * a null string if it is unknown or bundled with the application.
+     */
+    QString version() const;
+
+    /**
+     * Sets the version of the Markdown processor behind the exporter.
+     */
+    void setVersion(const QString &version);
+
     /**
      * Returns the supported formats to which this exporter can export.
      * This method will return the value of the protected field
@@ -78,6 +91,20 @@ public:
      */
     void setSmartTypographyEnabled(bool enabled);
 
+    /**
+     * Returns true if exports to file have been requested to stop.
+     */
+    bool isExportCancelled() const;
+
+    /**
+     * Set to true to request that exports to file in progress stop as
+     * soon as possible, in which case exportToFile() fails.  This method
+     * may be called from any thread.  Implementors of this class that can
+     * interrupt an export should check isExportCancelled() while
+     * exporting.  Set to false again before the next export.
+     */
+    void setExportCancelled(bool cancelled);
+
     /**
      * Override this method to transform the given text into HTML for
      * use in the Live HTML Preview.  By default, this method will set the
@@ -86,6 +113,15 @@ public:
      */
     virtual void exportToHtml(const QString &text, QString &html);
 
+    /**
+     * Override this method to transform the given text into HTML for the
+     * Live HTML Preview itself, as opposed to other uses of exportToHtml()
+     * such as copying HTML, when the exporter keeps state between renders
+     * that only the preview should update.  By default, this method calls
+     * exportToHtml().
+     */
+    virtual void exportToPreviewHtml(const QString &text, QString &html);
+
     /**
      * Implement this method to export the given text to a file of the
      * given format.  Set the err variable to an error string if
@@ -106,6 +142,57 @@ public:
         QString &err
     ) = 0;
 
+    /**
+     * Override this method to write the given top-level HTML blocks, which
+     * this exporter rendered from the text with exportToHtml(), to a file
+     * of the given format, as exportToFile() would have exported the text.
+     * This lets HTML already rendered for the Live HTML Preview be exported
+     * without rendering it again.  Returns false if the exporter cannot
+     * write the format from HTML, in which case the text is exported with
+     * exportToFile() instead.  Otherwise, err is set as by exportToFile().
+     * By default, this method returns false.
+     */
+    virtual bool exportRenderedHtml
+    (
+        const ExportFormat *format,
+        const QStringList &htmlBlocks,
+        const QString &outputFilePath,
+        QString &err
+    );
+
+    /**
+     * Override this method to do ahead of time the work that exporting the
+     * given text would do whatever the format, such as starting a program
+     * or parsing the text, so that a later export of the same text only
+     * pays for rendering its format.  It is called from a worker thread,
+     * such as while the user picks the format, and so must not block the
+     * exports that may start in the meantime for longer than the work
+     * would take them.  By default, this method does nothing.
+     */
+    virtual void prepareExport
+    (
+        const QString &inputFilePath,
+        const QString &text,
+        bool smartTypographyEnabled
+    );
+
+    /**
+     * Exports the given text to each of the given formats, writing each
+     * to the output file path at the same index.  Upon return, errors
+     * holds an error string for each format, which is a null QString if
+     * the export to that format succeeded.  By default, this method calls
+     * exportToFile() for each format in turn.  Override it to share work
+     * between the formats, such as parsing the text only once.
+     */
+    virtual void exportToFiles
+    (
+        const QList<const ExportFormat *> &formats,
+        const QString &inputFilePath,
+        const QString &text,
+        const QStringList &outputFilePaths,
+        QStringList &errors
+    );
+
 protected:
     /*
     * Implementors of this class should add their supported export formats
@@ -125,6 +212,8 @@ protected:
 
 private:
     QString m_name;
+    QString m_version;
+    QAtomicInt m_exportCancelled;
 };
 } // namespace ghostwriter
 
@@ -17,23 +17,47 @@
  *
  ***********************************************************************/
 
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QJsonObject>
+#include <QLibrary>
+#include <QPluginLoader>
 #include <QProcess>
 #include <QRegularExpression>
 #include <QSettings>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QtConcurrentRun>
 #include <QVersionNumber> 
 
 #include "exporterfactory.h"
 #include "cmarkgfmexporter.h"
 #include "commandlineexporter.h"
+#include "markdownprocessorplugin.h"
+#include "pluginexporter.h"
+#include "startupprofiler.h"
+
+#define GW_EXPORTER_CACHE_GROUP "ExporterCache"
+#define GW_EXPORTER_CACHE_PATH_KEY "path"
+#define GW_EXPORTER_CACHE_MODIFIED_KEY "modified"
+#define GW_EXPORTER_CACHE_VERSION_KEY "version"
 
 namespace ghostwriter
 {
 
 class ExporterFactoryPrivate
 {
+    Q_DECLARE_PUBLIC(ExporterFactory)
+
 public:
-    ExporterFactoryPrivate()
+    ExporterFactoryPrivate(ExporterFactory *q_ptr)
+        : q_ptr(q_ptr)
     {
         ;
     }
@@ -44,8 +68,63 @@ public:
     }
 
     static ExporterFactory *instance;
+    ExporterFactory *q_ptr;
     QList<Exporter *> fileExporters;
     QList<Exporter *> htmlExporters;
+    Exporter *cmarkGfmExporter;
+
+    // Exporters of the Markdown processors provided by plugins, which are
+    // listed right after the built-in processor.
+    QList<PluginExporter *> pluginExporters;
+
+    // Commands of the external Markdown processors, in the order that
+    // their exporters are listed.
+    QStringList commands;
+
+    // Detected version of each command, and the exporters created for
+    // it.  A command is missing from versions until it is detected.
+    QHash<QString, QVersionNumber> versions;
+    QHash<QString, QList<Exporter *>> commandExporters;
+
+    // Executable of each command, which is watched for changes.
+    QHash<QString, QString> commandPaths;
+    QFileSystemWatcher *executableWatcher;
+
+    // Number of commands whose version is being queried.
+    int pendingDetections = 0;
+
+    // Whether querying the versions of commands is held off, and the
+    // commands held off.  See ExporterFactory::setDetectionDeferred().
+    static bool detectionDeferred;
+    QStringList deferredCommands;
+
+    // pandoc server shared by all Pandoc exporters for rendering HTML,
+    // if the version of Pandoc has one.
+    ExportServer *pandocServer = nullptr;
+
+    /*
+    * Loads the Markdown processor plugins from the plugins directories,
+    * creating an exporter for each.
+    */
+    void loadPlugins();
+
+    /*
+    * Finds the executable of the given command and sets its version from
+    * the cache if the executable has not changed since it was cached.
+    * Otherwise, the version is queried in the background.
+    */
+    void detectCommand(const QString &command);
+
+    /*
+    * Sets the version of the given command, with a null version meaning
+    * that the command is unavailable, and updates the exporter lists.
+    */
+    void setCommandVersion(const QString &command, const QVersionNumber &version);
+
+    /*
+    * Rebuilds the exporter lists from the exporters of each command.
+    */
+    void updateExporterLists();
 
     /*
     * Executes the given terminal command to see if the executable is
@@ -54,10 +133,21 @@ public:
     *      <process_name> --version
     *
     * Returns the version number if the command is available, or else
-    * a null version number.
+    * a null version number.  This method blocks and is safe to call
+    * from any thread.
+    */
+    static QVersionNumber isCommandAvailable(const QString &command,
+        const QStringList &args);
+
+    /*
+    * Creates the exporters for the given version of a command.
     */
-    QVersionNumber isCommandAvailable(const QString &command,
-        const QStringList &args) const;
+    QList<Exporter *> createExporters(const QString &command,
+        const QVersionNumber &version);
+
+    QList<Exporter *> createPandocExporters(const QVersionNumber &version);
+    Exporter *createMultiMarkdownExporter(const QVersionNumber &version);
+    Exporter *createCmarkExporter();
 
     /*
     * Convenience method to create a Pandoc exporter with the given name
@@ -66,10 +156,12 @@ public:
     * each one (i.e., for Pandoc GitHub Flavored Markdown, Pandoc Strict,
     * Pandoc CommonMark, etc.).  The inputFormat parameter specifies
     * the argument to be passed to the -f option--for example,
-    * markdown, markdown_mmd, etc.
+    * markdown, markdown_mmd, etc.  The new exporter is appended to the
+    * given list.
     */
     void addPandocExporter
     (
+        QList<Exporter *> &exporters,
         const QString &name,
         const QString &inputFormat,
         int majorVersion,
@@ -78,6 +170,7 @@ public:
 };
 
 ExporterFactory *ExporterFactoryPrivate::instance = nullptr;
+bool ExporterFactoryPrivate::detectionDeferred = false;
 
 ExporterFactory::~ExporterFactory()
 {
@@ -89,6 +182,7 @@ ExporterFactory::~ExporterFactory()
 ExporterFactory *ExporterFactory::instance()
 {
     if (nullptr == ExporterFactoryPrivate::instance) {
+        StartupProfiler::Scope scope("ExporterFactory");
         ExporterFactoryPrivate::instance = new ExporterFactory();
     }
 
@@ -136,159 +230,443 @@ Exporter *ExporterFactory::exporterByName(const QString &name)
     return nullptr;
 }
 
+bool ExporterFactory::isDetectionFinished() const
+{
+    Q_D(const ExporterFactory);
+
+    return (0 == d->pendingDetections);
+}
+
+void ExporterFactory::setDetectionDeferred(bool deferred)
+{
+    ExporterFactoryPrivate::detectionDeferred = deferred;
+
+    ExporterFactory *factory = ExporterFactoryPrivate::instance;
+
+    if (deferred || (nullptr == factory) || factory->d_func()->deferredCommands.isEmpty()) {
+        return;
+    }
+
+    ExporterFactoryPrivate *d = factory->d_func();
+    QStringList commands = d->deferredCommands;
+
+    d->deferredCommands.clear();
+    d->pendingDetections -= commands.size();
+
+    foreach (const QString &command, commands) {
+        d->detectCommand(command);
+    }
+
+    if (0 == d->pendingDetections) {
+        emit factory->detectionFinished();
+    }
+}
+
 ExporterFactory::ExporterFactory()
-    : d_ptr(new ExporterFactoryPrivate())
+    : d_ptr(new ExporterFactoryPrivate(this))
 {
     Q_D(ExporterFactory);
     
-    CommandLineExporter *exporter = nullptr;
-    QVersionNumber pandocVersion = d->isCommandAvailable("pandoc", QStringList("--version"));
-    QVersionNumber mmdVersion = d->isCommandAvailable("multimarkdown", QStringList("--version"));
-    QVersionNumber cmarkVersion = d->isCommandAvailable("cmark", QStringList("--version"));
-
-    CmarkGfmExporter *cmarkGfmExporter = new CmarkGfmExporter();
-    d->fileExporters.append(cmarkGfmExporter);
-    d->htmlExporters.append(cmarkGfmExporter);
-
-    if (!pandocVersion.isNull()) {
-        int majorVersion = pandocVersion.majorVersion();
-        int minorVersion = pandocVersion.minorVersion();
-
-        // Check version of Pandoc. Drop support for version 1.
-        if (majorVersion >= 2) {
-            d->addPandocExporter("Pandoc", "markdown", majorVersion, minorVersion);
-
-            if ((majorVersion > 1) ||
-                ((1 == majorVersion) && (minorVersion >= 14))) {
-                d->addPandocExporter("Pandoc CommonMark", "commonmark", majorVersion, minorVersion);
+    d->cmarkGfmExporter = new CmarkGfmExporter();
+    d->commands << "pandoc" << "multimarkdown" << "cmark";
+
+    d->loadPlugins();
+
+    d->executableWatcher = new QFileSystemWatcher(this);
+
+    this->connect
+    (
+        d->executableWatcher,
+        &QFileSystemWatcher::fileChanged,
+        [d](const QString &path) {
+            // The executable was replaced or removed, so detect its
+            // command again.
+            foreach (const QString &command, d->commands) {
+                if (d->commandPaths.value(command) == path) {
+                    d->detectCommand(command);
+                }
+            }
+        }
+    );
+
+    d->updateExporterLists();
+
+    foreach (const QString &command, d->commands) {
+        d->detectCommand(command);
+    }
+}
+
+void ExporterFactoryPrivate::loadPlugins()
+{
+    QString appDir = QCoreApplication::applicationDirPath();
+
+    QStringList pluginDirs;
+    pluginDirs.append(appDir + "/plugins");
+    pluginDirs.append(appDir + "/../lib/ghostwriter/plugins");
+    pluginDirs.append(QFileInfo(QSettings().fileName()).dir().absoluteFilePath("plugins"));
+
+    foreach (const QString &pluginDir, pluginDirs) {
+        QDir dir(pluginDir);
+
+        if (!dir.exists()) {
+            continue;
+        }
+
+        foreach (const QFileInfo &fileInfo, dir.entryInfoList(QDir::Files)) {
+            if (!QLibrary::isLibrary(fileInfo.fileName())) {
+                continue;
+            }
+
+            // The loader does not unload the plugin when it goes out of
+            // scope, so the plugin stays loaded for the exporter.
+            QPluginLoader loader(fileInfo.absoluteFilePath());
+            MarkdownProcessorPlugin *plugin =
+                qobject_cast<MarkdownProcessorPlugin *>(loader.instance());
+
+            if (nullptr == plugin) {
+                qWarning() << "Could not load Markdown processor plugin"
+                    << fileInfo.absoluteFilePath() << loader.errorString();
+                continue;
             }
 
-            d->addPandocExporter("Pandoc GitHub-flavored Markdown", "markdown_github-hard_line_breaks", majorVersion, minorVersion);
-            d->addPandocExporter("Pandoc PHP Markdown Extra", "markdown_phpextra", majorVersion, minorVersion);
-            d->addPandocExporter("Pandoc MultiMarkdown", "markdown_mmd", majorVersion, minorVersion);
-            d->addPandocExporter("Pandoc Strict", "markdown_strict", majorVersion, minorVersion);
+            qInfo().noquote() << "Using" << plugin->name() << "version"
+                << plugin->version() << "from" << fileInfo.absoluteFilePath();
+            pluginExporters.append(new PluginExporter(plugin));
         }
-        else {
-            qWarning() << "Version" << pandocVersion << "of pandoc is unsupported.";
+    }
+}
+
+void ExporterFactoryPrivate::detectCommand(const QString &command)
+{
+    Q_Q(ExporterFactory);
+
+    QString path = QStandardPaths::findExecutable(command);
+    QString oldPath = commandPaths.value(command);
+
+    if (!oldPath.isEmpty() && (oldPath != path)) {
+        executableWatcher->removePath(oldPath);
+    }
+
+    commandPaths.insert(command, path);
+
+    if (path.isEmpty()) {
+        qWarning() << "Command" << command << "is not available.";
+        setCommandVersion(command, QVersionNumber());
+        return;
+    }
+
+    // Watchers stop watching files that are replaced, so watch the new
+    // file, too.
+    if (!executableWatcher->files().contains(path)) {
+        executableWatcher->addPath(path);
+    }
+
+    QDateTime modified = QFileInfo(path).lastModified();
+
+    QSettings settings;
+    settings.beginGroup(GW_EXPORTER_CACHE_GROUP);
+    settings.beginGroup(command);
+
+    if
+    (
+        (settings.value(GW_EXPORTER_CACHE_PATH_KEY).toString() == path)
+        && (settings.value(GW_EXPORTER_CACHE_MODIFIED_KEY).toDateTime() == modified)
+        && settings.contains(GW_EXPORTER_CACHE_VERSION_KEY)
+    ) {
+        QVersionNumber version =
+            QVersionNumber::fromString(settings.value(GW_EXPORTER_CACHE_VERSION_KEY).toString());
+
+        setCommandVersion(command, version);
+        return;
+    }
+
+    if (detectionDeferred) {
+        if (!deferredCommands.contains(command)) {
+            deferredCommands.append(command);
+            pendingDetections++;
         }
+
+        return;
     }
 
-    if (!mmdVersion.isNull()) {
-        int majorVersion = mmdVersion.majorVersion();
+    QFutureWatcher<QVersionNumber> *futureWatcher =
+        new QFutureWatcher<QVersionNumber>(q);
 
-        exporter = new CommandLineExporter("MultiMarkdown");
+    q->connect
+    (
+        futureWatcher,
+        &QFutureWatcher<QVersionNumber>::finished,
+        [this, futureWatcher, command, path, modified]() {
+            Q_Q(ExporterFactory);
+
+            QVersionNumber version = futureWatcher->result();
+            futureWatcher->deleteLater();
+            pendingDetections--;
+
+            // Drop the result if the executable changed in the meantime,
+            // since the command has been detected again in that case.
+            if (commandPaths.value(command) == path) {
+                // Only cache versions of commands that ran, so that a
+                // command that timed out is tried again next time.
+                if (!version.isNull()) {
+                    QSettings settings;
+                    settings.beginGroup(GW_EXPORTER_CACHE_GROUP);
+                    settings.beginGroup(command);
+                    settings.setValue(GW_EXPORTER_CACHE_PATH_KEY, path);
+                    settings.setValue(GW_EXPORTER_CACHE_MODIFIED_KEY, modified);
+                    settings.setValue(GW_EXPORTER_CACHE_VERSION_KEY, version.toString());
+                }
+
+                setCommandVersion(command, version);
+            }
 
-        // Smart typography option (--smart) is only availabe in version 5 and below.
-        // The option is was removed and enabled by default in version 6 and above.
-        //
-        if (majorVersion < 6) {
-            exporter->setSmartTypographyOnArgument("--smart");
+            if (0 == pendingDetections) {
+                emit q->detectionFinished();
+            }
         }
+    );
 
-        exporter->setSmartTypographyOffArgument("--nosmart");
-        exporter->setHtmlRenderCommand(QString("multimarkdown %1 -t html")
-                                       .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG));
-        exporter->addFileExportCommand
+    pendingDetections++;
+    futureWatcher->setFuture
+    (
+        QtConcurrent::run
         (
-            ExportFormat::HTML,
-            QString("multimarkdown %1 -t html -o %2")
-            .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
-            .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
-        );
+            &ExporterFactoryPrivate::isCommandAvailable,
+            path,
+            QStringList("--version")
+        )
+    );
+}
+
+void ExporterFactoryPrivate::setCommandVersion
+(
+    const QString &command,
+    const QVersionNumber &version
+)
+{
+    Q_Q(ExporterFactory);
+
+    if (versions.contains(command) && (versions.value(command) == version)) {
+        return;
+    }
+
+    versions.insert(command, version);
+
+    // The exporters for the previous version are left alive, since they
+    // may still be in use.
+    if (version.isNull()) {
+        commandExporters.remove(command);
+    } else {
+        commandExporters.insert(command, createExporters(command, version));
+    }
 
-        // Version 6 removed ODF option and replaced it with ODT and FODT.
-        if (majorVersion >= 6) {
-            exporter->addFileExportCommand
-            (
-                ExportFormat::ODT,
-                QString("multimarkdown %1 -t odt -o %2")
-                .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
-                .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
-            );
-
-            exporter->addFileExportCommand
-            (
-                ExportFormat::ODF,
-                QString("multimarkdown %1 -t fodt -o %2")
-                .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
-                .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
-            );
-        } else {
-            exporter->addFileExportCommand
-            (
-                ExportFormat::ODF,
-                QString("multimarkdown %1 -t odf -o %2")
-                .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
-                .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
-            );
+    updateExporterLists();
+    emit q->exportersChanged();
+}
+
+void ExporterFactoryPrivate::updateExporterLists()
+{
+    fileExporters.clear();
+    htmlExporters.clear();
+
+    fileExporters.append(cmarkGfmExporter);
+    htmlExporters.append(cmarkGfmExporter);
+
+    foreach (PluginExporter *exporter, pluginExporters) {
+        if (!exporter->supportedFormats().isEmpty()) {
+            fileExporters.append(exporter);
         }
 
-        // Version 6 added EPUB 3
-        if (majorVersion >= 6) {
-            exporter->addFileExportCommand
-            (
-                ExportFormat::EPUBV3,
-                QString("multimarkdown %1 -b -t epub -o %2")
-                .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
-                .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
-            );
+        if (exporter->isHtmlSupported()) {
+            htmlExporters.append(exporter);
         }
+    }
 
+    foreach (const QString &command, commands) {
+        foreach (Exporter *exporter, commandExporters.value(command)) {
+            fileExporters.append(exporter);
+            htmlExporters.append(exporter);
+        }
+    }
+}
+
+QList<Exporter *> ExporterFactoryPrivate::createExporters
+(
+    const QString &command,
+    const QVersionNumber &version
+)
+{
+    QList<Exporter *> exporters;
+
+    if ("pandoc" == command) {
+        exporters = createPandocExporters(version);
+    } else if ("multimarkdown" == command) {
+        exporters.append(createMultiMarkdownExporter(version));
+    } else if ("cmark" == command) {
+        exporters.append(createCmarkExporter());
+    }
+
+    foreach (Exporter *exporter, exporters) {
+        exporter->setVersion(version.toString());
+    }
+
+    return exporters;
+}
+
+QList<Exporter *> ExporterFactoryPrivate::createPandocExporters(const QVersionNumber &version)
+{
+    QList<Exporter *> exporters;
+    int majorVersion = version.majorVersion();
+    int minorVersion = version.minorVersion();
+
+    // Check version of Pandoc. Drop support for version 1.
+    if (majorVersion < 2) {
+        qWarning() << "Version" << version << "of pandoc is unsupported.";
+        return exporters;
+    }
+
+    // Pandoc 3 added a server mode, which saves launching pandoc for
+    // each render of the Live HTML Preview.
+    if ((majorVersion >= 3) && (nullptr == pandocServer)) {
+        pandocServer = new ExportServer
+        (
+            "pandoc",
+            QStringList() << "server" << "--port" << ExportServer::PORT_VAR
+        );
+    }
+
+    addPandocExporter(exporters, "Pandoc", "markdown", majorVersion, minorVersion);
+
+    if ((majorVersion > 1) ||
+        ((1 == majorVersion) && (minorVersion >= 14))) {
+        addPandocExporter(exporters, "Pandoc CommonMark", "commonmark", majorVersion, minorVersion);
+    }
+
+    addPandocExporter(exporters, "Pandoc GitHub-flavored Markdown", "markdown_github-hard_line_breaks", majorVersion, minorVersion);
+    addPandocExporter(exporters, "Pandoc PHP Markdown Extra", "markdown_phpextra", majorVersion, minorVersion);
+    addPandocExporter(exporters, "Pandoc MultiMarkdown", "markdown_mmd", majorVersion, minorVersion);
+    addPandocExporter(exporters, "Pandoc Strict", "markdown_strict", majorVersion, minorVersion);
+
+    return exporters;
+}
+
+Exporter *ExporterFactoryPrivate::createMultiMarkdownExporter(const QVersionNumber &version)
+{
+    int majorVersion = version.majorVersion();
+
+    CommandLineExporter *exporter = new CommandLineExporter("MultiMarkdown");
+
+    // Smart typography option (--smart) is only availabe in version 5 and below.
+    // The option is was removed and enabled by default in version 6 and above.
+    //
+    if (majorVersion < 6) {
+        exporter->setSmartTypographyOnArgument("--smart");
+    }
+
+    exporter->setSmartTypographyOffArgument("--nosmart");
+    exporter->setHtmlRenderCommand(QString("multimarkdown %1 -t html")
+                                   .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG));
+    exporter->addFileExportCommand
+    (
+        ExportFormat::HTML,
+        QString("multimarkdown %1 -t html -o %2")
+        .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
+        .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
+    );
+
+    // Version 6 removed ODF option and replaced it with ODT and FODT.
+    if (majorVersion >= 6) {
         exporter->addFileExportCommand
         (
-            ExportFormat::LATEX,
-            QString("multimarkdown %1 -t latex -o %2")
+            ExportFormat::ODT,
+            QString("multimarkdown %1 -t odt -o %2")
             .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
             .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
         );
+
         exporter->addFileExportCommand
         (
-            ExportFormat::MEMOIR,
-            QString("multimarkdown %1 -t memoir -o %2")
+            ExportFormat::ODF,
+            QString("multimarkdown %1 -t fodt -o %2")
             .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
             .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
         );
+    } else {
         exporter->addFileExportCommand
         (
-            ExportFormat::LYX,
-            QString("multimarkdown %1 -t lyx -o %2")
+            ExportFormat::ODF,
+            QString("multimarkdown %1 -t odf -o %2")
             .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
             .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
         );
-        d->fileExporters.append(exporter);
-        d->htmlExporters.append(exporter);
     }
 
-    if (!cmarkVersion.isNull()) {
-        exporter = new CommandLineExporter("cmark");
-        exporter->setSmartTypographyOnArgument("--smart");
-        exporter->setHtmlRenderCommand(QString("cmark -t html --smart %1")
-                                       .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG));
+    // Version 6 added EPUB 3
+    if (majorVersion >= 6) {
         exporter->addFileExportCommand
         (
-            ExportFormat::HTML,
-            QString("cmark -t html %1")
-            .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
-        );
-        exporter->addFileExportCommand
-        (
-            ExportFormat::LATEX,
-            QString("cmark -t latex %1")
-            .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
-        );
-        exporter->addFileExportCommand
-        (
-            ExportFormat::MANPAGE,
-            QString("cmark -t man %1")
+            ExportFormat::EPUBV3,
+            QString("multimarkdown %1 -b -t epub -o %2")
             .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
+            .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
         );
-        d->fileExporters.append(exporter);
-        d->htmlExporters.append(exporter);
     }
+
+    exporter->addFileExportCommand
+    (
+        ExportFormat::LATEX,
+        QString("multimarkdown %1 -t latex -o %2")
+        .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
+        .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
+    );
+    exporter->addFileExportCommand
+    (
+        ExportFormat::MEMOIR,
+        QString("multimarkdown %1 -t memoir -o %2")
+        .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
+        .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
+    );
+    exporter->addFileExportCommand
+    (
+        ExportFormat::LYX,
+        QString("multimarkdown %1 -t lyx -o %2")
+        .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
+        .arg(CommandLineExporter::OUTPUT_FILE_PATH_VAR)
+    );
+
+    return exporter;
+}
+
+Exporter *ExporterFactoryPrivate::createCmarkExporter()
+{
+    CommandLineExporter *exporter = new CommandLineExporter("cmark");
+    exporter->setSmartTypographyOnArgument("--smart");
+    exporter->setHtmlRenderCommand(QString("cmark -t html --smart %1")
+                                   .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG));
+    exporter->addFileExportCommand
+    (
+        ExportFormat::HTML,
+        QString("cmark -t html %1")
+        .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
+    );
+    exporter->addFileExportCommand
+    (
+        ExportFormat::LATEX,
+        QString("cmark -t latex %1")
+        .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
+    );
+    exporter->addFileExportCommand
+    (
+        ExportFormat::MANPAGE,
+        QString("cmark -t man %1")
+        .arg(CommandLineExporter::SMART_TYPOGRAPHY_ARG)
+    );
+
+    return exporter;
 }
 
 QVersionNumber ExporterFactoryPrivate::isCommandAvailable(const QString &command,
-    const QStringList &args) const
+    const QStringList &args)
 {
     QProcess process;
     process.start(command, args);
@@ -331,6 +709,7 @@ QVersionNumber ExporterFactoryPrivate::isCommandAvailable(const QString &command
 
 void ExporterFactoryPrivate::addPandocExporter
 (
+    QList<Exporter *> &exporters,
     const QString &name,
     const QString &inputFormat,
     int majorVersion,
@@ -352,13 +731,36 @@ void ExporterFactoryPrivate::addPandocExporter
         " -t html --mathjax"
     );
 
+    if (nullptr != pandocServer) {
+        QJsonObject request;
+        request.insert("from", inputFormat + CommandLineExporter::SMART_TYPOGRAPHY_ARG);
+        request.insert("to", "html");
+        request.insert("html-math-method", "mathjax");
+
+        exporter->setHtmlRenderServer(pandocServer, request);
+    }
+
     QString standardExportStr =
         QString("pandoc -f ") +
         inputFormat +
         CommandLineExporter::SMART_TYPOGRAPHY_ARG +
         " -t %1 --standalone --quiet -o " +
         CommandLineExporter::OUTPUT_FILE_PATH_VAR;
-    
+
+    // When exporting to several formats at once, parse the text into
+    // Pandoc's JSON AST only once, and render each format from it.
+    //
+    exporter->setIntermediateCommand
+    (
+        QString("pandoc -f ") +
+        inputFormat +
+        CommandLineExporter::SMART_TYPOGRAPHY_ARG +
+        " -t json",
+        QString("-f ") +
+        inputFormat +
+        CommandLineExporter::SMART_TYPOGRAPHY_ARG,
+        "-f json"
+    );
 
     exporter->addFileExportCommand
     (
@@ -441,8 +843,7 @@ void ExporterFactoryPrivate::addPandocExporter
         ExportFormat::GROFFMAN,
         standardExportStr.arg("man")
     );
-    fileExporters.append(exporter);
-    htmlExporters.append(exporter);
+    exporters.append(exporter);
 }
 
 } // namespace ghostwriter
@@ -21,6 +21,8 @@
 #define EXPORTERFACTORY_H
 
 #include <QList>
+#include <QObject>
+#include <QScopedPointer>
 
 #include "exporter.h"
 
@@ -28,10 +30,19 @@ namespace ghostwriter
 {
 /**
  * Creates Exporters for use with HTML live preview and exporting to disk.
+ *
+ * The external Markdown processors are detected in the background, so
+ * that the lists of exporters may grow after construction.  Processors
+ * detected in a previous run are available right away, as long as their
+ * executables have not changed since.  Markdown processors provided by
+ * plugins (see MarkdownProcessorPlugin) are loaded at construction and
+ * run in-process.  Exporters are never deleted, so that an exporter
+ * remains valid even after it is dropped from the lists.
  */
 class ExporterFactoryPrivate;
-class ExporterFactory
+class ExporterFactory : public QObject
 {
+    Q_OBJECT
     Q_DECLARE_PRIVATE(ExporterFactory)
 
 public:
@@ -62,6 +73,36 @@ public:
      */
     Exporter *exporterByName(const QString &name);
 
+    /**
+     * Returns true if no Markdown processor is still being detected in
+     * the background.
+     */
+    bool isDetectionFinished() const;
+
+    /**
+     * Sets whether running the external Markdown processors to detect
+     * their versions is held off, such as until the first document is
+     * shown at startup.  Processors whose versions are cached from a
+     * previous run are still available right away.  May be called before
+     * the instance is created.  The processors held off count as still
+     * being detected until deferral ends.
+     */
+    static void setDetectionDeferred(bool deferred);
+
+signals:
+    /**
+     * Emitted when the lists of exporters change, either because the
+     * detection of a Markdown processor finished, or because its
+     * executable was added, removed or replaced.
+     */
+    void exportersChanged();
+
+    /**
+     * Emitted when the last Markdown processor being detected in the
+     * background has been detected.
+     */
+    void detectionFinished();
+
 private:
     QScopedPointer<ExporterFactoryPrivate> d_ptr;
 
@@ -52,6 +52,8 @@ const ExportFormat *const ExportFormat::HTML =
     new ExportFormat("HTML", "(*.html *.htm)", "html");
 const ExportFormat *const ExportFormat::HTML5
     = new ExportFormat("HTML 5", "(*.html *.htm)", "html");
+const ExportFormat *const ExportFormat::HTML_SELF_CONTAINED
+    = new ExportFormat("HTML (self-contained)", "(*.html *.htm)", "html");
 const ExportFormat *const ExportFormat::ODT
     = new ExportFormat("OpenDocument Text", "(*.odt)", "odt", true);
 const ExportFormat *const ExportFormat::ODF
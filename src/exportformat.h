@@ -120,6 +120,7 @@ public:
     // Some common file formats.
     static const ExportFormat *const HTML;
     static const ExportFormat *const HTML5;
+    static const ExportFormat *const HTML_SELF_CONTAINED;
     static const ExportFormat *const ODT;
     static const ExportFormat *const ODF;
     static const ExportFormat *const RTF;
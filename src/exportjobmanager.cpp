@@ -0,0 +1,325 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <QFile>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QQueue>
+#include <QtConcurrentRun>
+
+#include "exportcache.h"
+#include "exportjobmanager.h"
+
+namespace ghostwriter
+{
+class ExportJobManagerPrivate
+{
+    Q_DECLARE_PUBLIC(ExportJobManager)
+
+public:
+    ExportJobManagerPrivate(ExportJobManager *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~ExportJobManagerPrivate()
+    {
+        ;
+    }
+
+    /*
+    * An export to file, holding everything needed to run it on a
+    * worker thread.
+    */
+    struct Job
+    {
+        Exporter *exporter;
+        const ExportFormat *format;
+        QString inputFilePath;
+        QString text;
+        QString outputFilePath;
+        bool smartTypographyEnabled;
+        QStringList renderedHtml;
+
+        // Whether the export was queued by enqueueOnSave().
+        bool onSave;
+
+        Job()
+            : exporter(nullptr),
+              format(nullptr),
+              smartTypographyEnabled(false),
+              onSave(false)
+        {
+            ;
+        }
+    };
+
+    ExportJobManager *q_ptr;
+    QQueue<Job> queue;
+    Job currentJob;
+    bool running;
+    bool currentJobCancelled;
+    QFutureWatcher<QString> *futureWatcher;
+
+    /*
+    * Runs the given export on a worker thread, returning the error
+    * message if the export failed, or a null string otherwise.
+    */
+    static QString runJob(Job job);
+
+    /*
+    * Starts the next queued export, if any.  Otherwise, notifies
+    * listeners that all exports have finished.
+    */
+    void startNextJob();
+
+    /*
+    * Called when the export in progress has finished.
+    */
+    void onJobFinished();
+
+    /*
+    * Notifies listeners of the export in progress, along with the
+    * number of exports queued behind it.
+    */
+    void notifyJobStarted();
+};
+
+ExportJobManager::ExportJobManager(QObject *parent)
+    : QObject(parent),
+      d_ptr(new ExportJobManagerPrivate(this))
+{
+    Q_D(ExportJobManager);
+
+    d->running = false;
+    d->currentJobCancelled = false;
+    d->futureWatcher = new QFutureWatcher<QString>(this);
+
+    this->connect
+    (
+        d->futureWatcher,
+        &QFutureWatcher<QString>::finished,
+        [d]() {
+            d->onJobFinished();
+        }
+    );
+}
+
+ExportJobManager::~ExportJobManager()
+{
+    Q_D(ExportJobManager);
+
+    d->queue.clear();
+
+    if (d->running) {
+        d->currentJob.exporter->setExportCancelled(true);
+        d->futureWatcher->waitForFinished();
+    }
+}
+
+bool ExportJobManager::isBusy() const
+{
+    Q_D(const ExportJobManager);
+
+    return d->running;
+}
+
+void ExportJobManager::enqueue
+(
+    Exporter *exporter,
+    const ExportFormat *format,
+    const QString &inputFilePath,
+    const QString &text,
+    const QString &outputFilePath,
+    bool smartTypographyEnabled,
+    const QStringList &renderedHtml
+)
+{
+    Q_D(ExportJobManager);
+
+    ExportJobManagerPrivate::Job job;
+    job.exporter = exporter;
+    job.format = format;
+    job.inputFilePath = inputFilePath;
+    job.text = text;
+    job.outputFilePath = outputFilePath;
+    job.smartTypographyEnabled = smartTypographyEnabled;
+    job.renderedHtml = renderedHtml;
+
+    d->queue.enqueue(job);
+
+    if (d->running) {
+        d->notifyJobStarted();
+    } else {
+        d->startNextJob();
+    }
+}
+
+void ExportJobManager::enqueueOnSave
+(
+    Exporter *exporter,
+    const ExportFormat *format,
+    const QString &inputFilePath,
+    const QString &text,
+    const QString &outputFilePath,
+    bool smartTypographyEnabled
+)
+{
+    Q_D(ExportJobManager);
+
+    for (ExportJobManagerPrivate::Job &job : d->queue) {
+        if (job.onSave && (job.outputFilePath == outputFilePath)) {
+            job.exporter = exporter;
+            job.format = format;
+            job.inputFilePath = inputFilePath;
+            job.text = text;
+            job.smartTypographyEnabled = smartTypographyEnabled;
+            return;
+        }
+    }
+
+    ExportJobManagerPrivate::Job job;
+    job.exporter = exporter;
+    job.format = format;
+    job.inputFilePath = inputFilePath;
+    job.text = text;
+    job.outputFilePath = outputFilePath;
+    job.smartTypographyEnabled = smartTypographyEnabled;
+    job.onSave = true;
+
+    d->queue.enqueue(job);
+
+    if (d->running) {
+        d->notifyJobStarted();
+    } else {
+        d->startNextJob();
+    }
+}
+
+void ExportJobManager::cancelAll()
+{
+    Q_D(ExportJobManager);
+
+    d->queue.clear();
+
+    if (d->running && !d->currentJobCancelled) {
+        d->currentJobCancelled = true;
+        d->currentJob.exporter->setExportCancelled(true);
+
+        emit exportStarted
+        (
+            tr("cancelling export to %1").arg(d->currentJob.outputFilePath)
+        );
+    }
+}
+
+QString ExportJobManagerPrivate::runJob(Job job)
+{
+    QString err;
+
+    job.exporter->setSmartTypographyEnabled(job.smartTypographyEnabled);
+    ExportCache::exportToFile
+    (
+        job.exporter,
+        job.format,
+        job.inputFilePath,
+        job.text,
+        job.outputFilePath,
+        err,
+        false,
+        job.renderedHtml
+    );
+
+    return err;
+}
+
+void ExportJobManagerPrivate::startNextJob()
+{
+    Q_Q(ExportJobManager);
+
+    if (queue.isEmpty()) {
+        running = false;
+        emit q->allExportsFinished();
+        return;
+    }
+
+    running = true;
+    currentJobCancelled = false;
+    currentJob = queue.dequeue();
+    currentJob.exporter->setExportCancelled(false);
+
+    QFuture<QString> future =
+        QtConcurrent::run(&ExportJobManagerPrivate::runJob, currentJob);
+    futureWatcher->setFuture(future);
+
+    notifyJobStarted();
+}
+
+void ExportJobManagerPrivate::onJobFinished()
+{
+    Q_Q(ExportJobManager);
+
+    QString err = futureWatcher->result();
+    Job job = currentJob;
+    bool cancelled = currentJobCancelled;
+
+    // Move on to the next export before reporting on this one, since
+    // listeners may show the user a modal message box.  Note that this
+    // also frees the text snapshot of the finished export.
+    //
+    currentJob = Job();
+    startNextJob();
+
+    if (cancelled) {
+        // Don't leave a partially written file behind.
+        if (!err.isNull()) {
+            QFile::remove(job.outputFilePath);
+        }
+    } else if (job.onSave) {
+        emit q->saveExportFinished(job.outputFilePath, err);
+    } else if (!err.isNull()) {
+        emit q->exportFailed(job.outputFilePath, err);
+    } else {
+        emit q->exportSucceeded(job.outputFilePath);
+    }
+}
+
+void ExportJobManagerPrivate::notifyJobStarted()
+{
+    Q_Q(ExportJobManager);
+
+    if (currentJobCancelled) {
+        return;
+    }
+
+    QString description =
+        ExportJobManager::tr("exporting to %1").arg(currentJob.outputFilePath);
+
+    if (!queue.isEmpty()) {
+        description =
+            ExportJobManager::tr("exporting to %1 (%2 more queued)")
+                .arg(currentJob.outputFilePath)
+                .arg(queue.size());
+    }
+
+    emit q->exportStarted(description);
+}
+} // namespace ghostwriter
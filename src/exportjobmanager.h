@@ -0,0 +1,148 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef EXPORTJOBMANAGER_H
+#define EXPORTJOBMANAGER_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+
+#include "exporter.h"
+#include "exportformat.h"
+
+namespace ghostwriter
+{
+/**
+ * Queues exports to file and runs them one at a time in the background,
+ * so that the user can keep writing while a document is exported.  Each
+ * export works from a snapshot of the document text taken when it was
+ * queued.  Queued exports run in the order in which they were added,
+ * and can be cancelled, in which case an export in progress is stopped
+ * if its exporter supports it.  Exports that would write the same file
+ * as the last export to it are skipped, as described in ExportCache.
+ */
+class ExportJobManagerPrivate;
+class ExportJobManager : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(ExportJobManager)
+
+public:
+    /**
+     * Constructor.
+     */
+    ExportJobManager(QObject *parent = 0);
+
+    /**
+     * Destructor.  Cancels all exports, waiting for the export in
+     * progress, if any, to stop.
+     */
+    virtual ~ExportJobManager();
+
+    /**
+     * Returns true if an export is in progress or queued.
+     */
+    bool isBusy() const;
+
+    /**
+     * Queues exporting the given text to the given format and output
+     * file path with the given exporter.  The input file path is that of
+     * the document from which the text was taken, and may be empty if the
+     * document is new and untitled.  The top-level HTML blocks that the
+     * exporter already rendered from the text, such as for the live
+     * preview, may be given to be written out instead of exporting the
+     * text again.  See ExportCache::exportToFile().
+     */
+    void enqueue
+    (
+        Exporter *exporter,
+        const ExportFormat *format,
+        const QString &inputFilePath,
+        const QString &text,
+        const QString &outputFilePath,
+        bool smartTypographyEnabled,
+        const QStringList &renderedHtml = QStringList()
+    );
+
+    /**
+     * Queues exporting the given text as enqueue() does, for a document
+     * that is exported again whenever it is saved.  If an export to the
+     * same output file path is queued and has yet to start, it is
+     * replaced by this one, so that saves in quick succession make a
+     * single export.  The outcome is reported with saveExportFinished()
+     * rather than exportSucceeded() or exportFailed().
+     */
+    void enqueueOnSave
+    (
+        Exporter *exporter,
+        const ExportFormat *format,
+        const QString &inputFilePath,
+        const QString &text,
+        const QString &outputFilePath,
+        bool smartTypographyEnabled
+    );
+
+public slots:
+    /**
+     * Cancels all queued exports, as well as the export in progress.
+     */
+    void cancelAll();
+
+signals:
+    /**
+     * Emitted when an export begins, as well as whenever the number of
+     * exports queued behind it changes.  The description parameter will
+     * contain descriptive text to display to the user regarding the export.
+     */
+    void exportStarted(const QString &description);
+
+    /**
+     * Emitted when an export has completed successfully.
+     */
+    void exportSucceeded(const QString &outputFilePath);
+
+    /**
+     * Emitted when an export has failed.  The err parameter contains
+     * the error message.  Note that this signal is not emitted for
+     * cancelled exports.
+     */
+    void exportFailed(const QString &outputFilePath, const QString &err);
+
+    /**
+     * Emitted when an export queued with enqueueOnSave() has completed.
+     * The err parameter is null if the export succeeded, and contains
+     * the error message otherwise.
+     */
+    void saveExportFinished(const QString &outputFilePath, const QString &err);
+
+    /**
+     * Emitted when the last queued export has finished or has been
+     * cancelled.
+     */
+    void allExportsFinished();
+
+private:
+    QScopedPointer<ExportJobManagerPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // EXPORTJOBMANAGER_H
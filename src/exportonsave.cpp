@@ -0,0 +1,128 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QSettings>
+
+#include "exporterfactory.h"
+#include "exportonsave.h"
+
+#define GW_EXPORT_ON_SAVE_GROUP "ExportOnSave"
+#define GW_EXPORTER_KEY "exporter"
+#define GW_FORMAT_KEY "format"
+#define GW_OUTPUT_FILE_KEY "outputFile"
+#define GW_SMART_TYPOGRAPHY_KEY "smartTypographyEnabled"
+
+namespace ghostwriter
+{
+ExportOnSave::Target::Target()
+    : exporter(nullptr),
+      format(nullptr),
+      smartTypographyEnabled(true)
+{
+    ;
+}
+
+bool ExportOnSave::Target::isValid() const
+{
+    return (nullptr != exporter)
+        && (nullptr != format)
+        && !outputFilePath.isEmpty();
+}
+
+ExportOnSave::Target ExportOnSave::target(const QString &documentFilePath)
+{
+    Target target;
+
+    if (documentFilePath.isEmpty()) {
+        return target;
+    }
+
+    QSettings settings;
+    settings.beginGroup(targetGroup(documentFilePath));
+
+    QString exporterName = settings.value(GW_EXPORTER_KEY).toString();
+    QString formatName = settings.value(GW_FORMAT_KEY).toString();
+    target.outputFilePath = settings.value(GW_OUTPUT_FILE_KEY).toString();
+    target.smartTypographyEnabled = settings.value(GW_SMART_TYPOGRAPHY_KEY, true).toBool();
+
+    settings.endGroup();
+
+    if (exporterName.isEmpty()) {
+        return target;
+    }
+
+    target.exporter = ExporterFactory::instance()->exporterByName(exporterName);
+
+    if (nullptr == target.exporter) {
+        return target;
+    }
+
+    foreach (const ExportFormat *format, target.exporter->supportedFormats()) {
+        if (format->name() == formatName) {
+            target.format = format;
+            break;
+        }
+    }
+
+    return target;
+}
+
+void ExportOnSave::setTarget(const QString &documentFilePath, const Target &target)
+{
+    if (documentFilePath.isEmpty() || !target.isValid()) {
+        return;
+    }
+
+    QSettings settings;
+    settings.beginGroup(targetGroup(documentFilePath));
+    settings.setValue(GW_EXPORTER_KEY, target.exporter->name());
+    settings.setValue(GW_FORMAT_KEY, target.format->name());
+    settings.setValue(GW_OUTPUT_FILE_KEY, target.outputFilePath);
+    settings.setValue(GW_SMART_TYPOGRAPHY_KEY, target.smartTypographyEnabled);
+    settings.endGroup();
+}
+
+void ExportOnSave::clearTarget(const QString &documentFilePath)
+{
+    if (documentFilePath.isEmpty()) {
+        return;
+    }
+
+    QSettings settings;
+    settings.remove(targetGroup(documentFilePath));
+}
+
+QString ExportOnSave::targetGroup(const QString &documentFilePath)
+{
+    // File paths make for poor setting keys, since slashes separate
+    // groups.
+    //
+    return QString(GW_EXPORT_ON_SAVE_GROUP "/")
+        + QString::fromLatin1
+        (
+            QCryptographicHash::hash
+            (
+                QFileInfo(documentFilePath).absoluteFilePath().toUtf8(),
+                QCryptographicHash::Sha1
+            ).toHex()
+        );
+}
+} // namespace ghostwriter
@@ -0,0 +1,88 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef EXPORT_ON_SAVE_H
+#define EXPORT_ON_SAVE_H
+
+#include <QString>
+
+#include "exporter.h"
+#include "exportformat.h"
+
+namespace ghostwriter
+{
+/**
+ * Remembers, for each document file, the export that is to be made again
+ * whenever the document is saved, as chosen in the export dialog.  The
+ * targets are kept in the application settings, keyed by the document's
+ * file path.
+ *
+ * This class is meant to be used from the main thread only.
+ */
+class ExportOnSave
+{
+public:
+    /**
+     * Export to make when a document is saved.
+     */
+    struct Target
+    {
+        Exporter *exporter;
+        const ExportFormat *format;
+        QString outputFilePath;
+        bool smartTypographyEnabled;
+
+        Target();
+
+        /**
+         * Returns true if the target names an exporter and a format.
+         */
+        bool isValid() const;
+    };
+
+    /**
+     * Returns the export to make when the document at the given file path
+     * is saved.  The returned target is invalid if there is none, or if
+     * its exporter or format is no longer available.
+     */
+    static Target target(const QString &documentFilePath);
+
+    /**
+     * Sets the export to make when the document at the given file path is
+     * saved.
+     */
+    static void setTarget(const QString &documentFilePath, const Target &target);
+
+    /**
+     * Stops exporting the document at the given file path when it is
+     * saved.
+     */
+    static void clearTarget(const QString &documentFilePath);
+
+private:
+    /*
+    * Returns the settings group of the target of the given document.
+    */
+    static QString targetGroup(const QString &documentFilePath);
+
+    ExportOnSave();
+};
+} // namespace ghostwriter
+
+#endif // EXPORT_ON_SAVE_H
@@ -0,0 +1,236 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QList>
+#include <QMetaObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "exportserver.h"
+
+namespace ghostwriter
+{
+const QString ExportServer::PORT_VAR = QString("${PORT}");
+
+ExportServer::ExportServer
+(
+    const QString &program,
+    const QStringList &arguments,
+    QObject *parent
+) : QObject(parent),
+    program(program),
+    arguments(arguments),
+    process(nullptr),
+    processPort(0),
+    serverPort(0),
+    startRequested(0),
+    startAttempts(0)
+{
+    // Exporters live until the application exits, so make sure the server
+    // does not outlive the application.
+    this->connect
+    (
+        QCoreApplication::instance(),
+        &QCoreApplication::aboutToQuit,
+        this,
+        &ExportServer::stop
+    );
+}
+
+ExportServer::~ExportServer()
+{
+    stop();
+}
+
+bool ExportServer::post(const QByteArray &request, QByteArray &response, QString &err)
+{
+    int port = serverPort.load();
+
+    if (0 == port) {
+        if (startRequested.testAndSetOrdered(0, 1)) {
+            QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+        }
+
+        err = tr("The export server is not running.");
+        return false;
+    }
+
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress(QHostAddress::LocalHost), port);
+
+    // Note that the server refuses connections for a short while after it
+    // starts, until it is listening.
+    if (!socket.waitForConnected(ConnectTimeout)) {
+        err = socket.errorString();
+        return false;
+    }
+
+    // HTTP/1.0 has the server close the connection after its response,
+    // which then marks the end of the response body.
+    QByteArray header =
+        QByteArray("POST / HTTP/1.0\r\n")
+        + "Host: 127.0.0.1:" + QByteArray::number(port) + "\r\n"
+        + "Content-Type: application/json\r\n"
+        + "Accept: application/json\r\n"
+        + "Content-Length: " + QByteArray::number(request.size()) + "\r\n"
+        + "\r\n";
+
+    socket.write(header);
+    socket.write(request);
+
+    while (socket.bytesToWrite() > 0) {
+        if (!socket.waitForBytesWritten(ResponseTimeout)) {
+            err = socket.errorString();
+            return false;
+        }
+    }
+
+    QByteArray reply;
+
+    while (socket.waitForReadyRead(ResponseTimeout)) {
+        reply += socket.readAll();
+    }
+
+    reply += socket.readAll();
+
+    if (QAbstractSocket::SocketTimeoutError == socket.error()) {
+        socket.abort();
+        err = tr("The export server timed out.");
+        return false;
+    }
+
+    int headerEnd = reply.indexOf("\r\n\r\n");
+    QList<QByteArray> statusLine = reply.left(reply.indexOf("\r\n")).split(' ');
+    bool ok = false;
+    int status = statusLine.value(1).toInt(&ok);
+
+    if ((headerEnd < 0) || !ok) {
+        err = tr("The export server sent an invalid response.");
+        return false;
+    }
+
+    response = reply.mid(headerEnd + 4);
+
+    if ((status < 200) || (status >= 300)) {
+        err = QString::fromUtf8(response);
+
+        if (err.trimmed().isEmpty()) {
+            err = tr("The export server failed with status %1.").arg(status);
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+void ExportServer::start()
+{
+    if (nullptr == process) {
+        process = new QProcess(this);
+        process->setStandardOutputFile(QProcess::nullDevice());
+        process->setStandardErrorFile(QProcess::nullDevice());
+
+        this->connect
+        (
+            process,
+            &QProcess::started,
+            [this]() {
+                serverPort.store(processPort);
+            }
+        );
+
+        this->connect
+        (
+            process,
+            &QProcess::errorOccurred,
+            [this](QProcess::ProcessError error) {
+                if (QProcess::FailedToStart == error) {
+                    serverPort.store(0);
+                    startRequested.store(0);
+                }
+            }
+        );
+
+        // Allow the next request to restart the server if it exits.
+        this->connect
+        (
+            process,
+            static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            [this]() {
+                serverPort.store(0);
+                startRequested.store(0);
+            }
+        );
+    }
+
+    if (QProcess::NotRunning != process->state()) {
+        return;
+    }
+
+    // Give up on servers that keep failing, such as for versions of the
+    // program that lack a server mode.  Leaving the start request flag set
+    // keeps further requests from asking for a start.
+    if (startAttempts >= MaxStartAttempts) {
+        return;
+    }
+
+    startAttempts++;
+    processPort = findFreePort();
+
+    if (processPort <= 0) {
+        startRequested.store(0);
+        return;
+    }
+
+    QStringList expandedArguments;
+
+    for (const QString &argument : arguments) {
+        expandedArguments << QString(argument).replace(PORT_VAR, QString::number(processPort));
+    }
+
+    process->start(program, expandedArguments);
+}
+
+void ExportServer::stop()
+{
+    serverPort.store(0);
+
+    if ((nullptr != process) && (QProcess::NotRunning != process->state())) {
+        process->kill();
+        process->waitForFinished(ConnectTimeout);
+    }
+}
+
+int ExportServer::findFreePort() const
+{
+    QTcpServer server;
+
+    if (!server.listen(QHostAddress::LocalHost, 0)) {
+        return 0;
+    }
+
+    int port = server.serverPort();
+    server.close();
+    return port;
+}
+} // namespace ghostwriter
@@ -0,0 +1,120 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef EXPORT_SERVER_H
+#define EXPORT_SERVER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+
+namespace ghostwriter
+{
+/**
+ * Long-lived process serving export requests over HTTP on the local host,
+ * such as pandoc server.  Sending requests to a server that is already
+ * running saves the startup time of launching a new process for every
+ * export.  The process is started on demand and restarted whenever it
+ * exits, up to a limit for servers that fail repeatedly.
+ *
+ * Requests can be posted from any thread.  The process itself is managed
+ * on the thread owning this object.
+ */
+class ExportServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.  Takes the program to run as the server, and its
+     * arguments.  Any argument containing PORT_VAR will have it replaced
+     * with the port on which the server is to listen.
+     */
+    ExportServer
+    (
+        const QString &program,
+        const QStringList &arguments,
+        QObject *parent = nullptr
+    );
+
+    /**
+     * Destructor.  Stops the server if it is running.
+     */
+    virtual ~ExportServer();
+
+    /**
+     * Posts the given JSON request body to the server, returning true and
+     * setting response to the body of the response if the server replies
+     * with success.  If the server is not yet running, this method asks
+     * for it to be started and returns false immediately, so that callers
+     * can fall back on another way of exporting in the meantime.  On
+     * failure, err is set to an error message.
+     */
+    bool post(const QByteArray &request, QByteArray &response, QString &err);
+
+    /**
+     * Contains the variable string for the server's port in the arguments
+     * passed to the constructor, namely "${PORT}".
+     */
+    static const QString PORT_VAR;
+
+private slots:
+    void start();
+    void stop();
+
+private:
+    /*
+    * Number of times the server may exit before giving up on it.
+    */
+    static const int MaxStartAttempts = 3;
+
+    /*
+    * Timeouts, in milliseconds, for connecting to the server and for
+    * receiving its response.
+    */
+    static const int ConnectTimeout = 500;
+    static const int ResponseTimeout = 30000;
+
+    QString program;
+    QStringList arguments;
+    QProcess *process;
+    int processPort;
+
+    /*
+    * Port of the running server, or zero if the server is not ready to
+    * accept requests.  Read from any thread.
+    */
+    QAtomicInt serverPort;
+
+    /*
+    * Whether a start request is already queued or the process is running.
+    */
+    QAtomicInt startRequested;
+
+    int startAttempts;
+
+    int findFreePort() const;
+};
+} // namespace ghostwriter
+
+#endif // EXPORT_SERVER_H
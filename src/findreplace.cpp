@@ -18,19 +18,27 @@
  ***********************************************************************/
 
 #include <QApplication>
+#include <QFutureWatcher>
 #include <QGridLayout>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMenu>
+#include <QPainter>
+#include <QPaintEvent>
 #include <QPushButton>
 #include <QRegularExpression>
 #include <QSettings>
 #include <QStringList>
-#include <QTextEdit>
+#include <QTextBlock>
 #include <QTextCursor>
+#include <QTextLayout>
 #include <QTimer>
+#include <QVector>
 
 #include "findreplace.h"
+#include "literalsearcher.h"
+#include "markdowndocument.h"
+#include "taskscheduler.h"
 #include "3rdparty/QtAwesome/QtAwesome.h"
 
 #define GW_FIND_REPLACE_MATCH_CASE "FindReplace/matchCase"
@@ -59,6 +67,56 @@ public:
 
     bool findMatch(QTextCursor& cursor, bool wrap = true, bool backwards = false);
     void highlightMatches(bool enabled);
+    void compileMatchQuery();
+    void paintMatches(const QRect &rect);
+    void startMatchCount();
+    void onMatchCountFinished();
+    void onContentsChange(int charsRemoved, int charsAdded);
+
+    // Match found within a line of text.
+    typedef struct
+    {
+        int start;
+        int length;
+    } Match;
+
+    // Query compiled for matching, which is searched for literally with
+    // the searcher unless it is a regular expression.  Copies of it may be
+    // used by worker threads.
+    //
+    typedef struct
+    {
+        bool literal;
+        LiteralSearcher searcher;
+        QRegularExpression expression;
+        bool wholeWords;
+    } MatchQuery;
+
+    static int findMatches
+    (
+        const QString &text,
+        const MatchQuery &query,
+        int limit,
+        QVector<Match> *matches
+    );
+
+    static int findTextMatches
+    (
+        const QString &text,
+        const MatchQuery &query,
+        int limit,
+        QVector<Match> *matches
+    );
+
+    static bool isWholeWord(const QString &text, int start, int length);
+
+    bool findLiteralMatch(QTextCursor &cursor, bool backwards);
+    QString documentText() const;
+
+    // Maximum number of matches to count, beyond which the count is only
+    // reported as exceeding it.
+    static const int MaxMatchCount = 10000;
+
     void setQueryFromSelection();
     void setReplaceRowVisible(bool visible);
     void startHighlightTimer();
@@ -85,6 +143,16 @@ public:
     bool replaceRowVisible;
     QTimer *highlightTimer;
 
+    // Query compiled once for highlighting matches.  Only the matches
+    // within the region of the editor's viewport being painted are found
+    // and painted, while the total number of matches is counted on a
+    // worker thread from a snapshot of the text.
+    bool matchesHighlighted;
+    MatchQuery matchQuery;
+    QColor matchColor;
+    int matchRevision;
+    QFutureWatcher<int> *matchCountWatcher;
+
     QStringList searchHistory;
     int searchHistoryIndex;
 
@@ -99,6 +167,20 @@ FindReplace::FindReplace(QPlainTextEdit *editor, QWidget *parent)
     
     d->editor = editor;
     d->highlightTimer = nullptr;
+    d->matchesHighlighted = false;
+    d->matchQuery.literal = true;
+    d->matchQuery.wholeWords = false;
+    d->matchRevision = -1;
+
+    d->matchCountWatcher = new QFutureWatcher<int>(this);
+
+    this->connect(d->matchCountWatcher,
+        &QFutureWatcher<int>::finished,
+        [d]() {
+            d->onMatchCountFinished();
+        });
+
+    d->editor->viewport()->installEventFilter(this);
 
     QSettings settings;
 
@@ -231,12 +313,22 @@ FindReplace::FindReplace(QPlainTextEdit *editor, QWidget *parent)
             }
         });
 
+    // Changing how to match requires compiling the query anew.
+    for (QPushButton *button : { d->matchCaseButton, d->wholeWordButton, d->regularExpressionButton }) {
+        this->connect(button,
+            &QPushButton::clicked,
+            [d]() {
+                if (d->highlightMatchesButton->isChecked()) {
+                    d->startHighlightTimer();
+                }
+            });
+    }
+
     this->connect(d->editor->document(),
-        &QTextDocument::contentsChanged,
-        [this, d]() {
-            if (this->isVisible() && d->highlightMatchesButton->isChecked()) {
-                d->highlightMatches(true);
-            }
+        &QTextDocument::contentsChange,
+        [d](int position, int charsRemoved, int charsAdded) {
+            Q_UNUSED(position)
+            d->onContentsChange(charsRemoved, charsAdded);
         });
 
     showFindView();
@@ -296,6 +388,23 @@ void FindReplace::keyPressEvent(QKeyEvent *event)
     }
 }
 
+bool FindReplace::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_D(FindReplace);
+
+    // Paint the matches before the editor paints its text over them.
+    if
+    (
+        d->matchesHighlighted
+        && (watched == d->editor->viewport())
+        && (QEvent::Paint == event->type())
+    ) {
+        d->paintMatches(static_cast<QPaintEvent *>(event)->rect());
+    }
+
+    return QWidget::eventFilter(watched, event);
+}
+
 void FindReplace::showFindView()
 {
     Q_D(FindReplace);
@@ -387,37 +496,57 @@ void FindReplace::replaceAll()
         showReplaceView();
     }
     
-    QTextCursor cursor = d->editor->textCursor();
-    cursor.movePosition(QTextCursor::Start);
+    // Find all of the matches in one pass over a snapshot of the text, and
+    // then replace them from last to first, so that the positions of the
+    // matches yet to be replaced stay valid.  Doing so within one edit
+    // block makes for a single undo step, and within a transaction, the
+    // document is parsed and counted once, when the transaction commits.
+    //
+    QVector<FindReplacePrivate::Match> matches;
+    QString replacement = d->replaceField->text();
+
+    d->compileMatchQuery();
+    FindReplacePrivate::findTextMatches
+    (
+        d->documentText(),
+        d->matchQuery,
+        -1,
+        &matches
+    );
 
-    int count = 0;
+    if (!matches.isEmpty()) {
+        MarkdownDocument *document = (MarkdownDocument *) d->editor->document();
+        QTextCursor cursor(document);
 
-    while (d->findMatch(cursor, false)) {
-        cursor.insertText(d->replaceField->text());
-        count++;
+        document->beginTransaction();
+        cursor.beginEditBlock();
+
+        for (int i = matches.count() - 1; i >= 0; i--) {
+            const FindReplacePrivate::Match &match = matches.at(i);
+
+            cursor.setPosition(match.start);
+            cursor.setPosition(match.start + match.length, QTextCursor::KeepAnchor);
+            cursor.insertText(replacement);
+        }
+
+        cursor.endEditBlock();
+        document->commit();
     }
 
-    d->statusLabel->setText(tr("%1 replacements").arg(count));
+    d->statusLabel->setText(tr("%1 replacements").arg(matches.count()));
+    d->statusLabel->setProperty("error", false);
     d->editor->setFocus();
 }
 
 bool FindReplacePrivate::findMatch(QTextCursor& cursor, bool wrap, bool backwards)
 {
-    QString searchText = this->findField->text();
     QTextDocument::FindFlags findFlags;
-    QRegularExpression expr;
 
     findFlags.setFlag(QTextDocument::FindCaseSensitively, this->matchCaseButton->isChecked());
     findFlags.setFlag(QTextDocument::FindWholeWords, this->wholeWordButton->isChecked());
     findFlags.setFlag(QTextDocument::FindBackward, backwards);
 
-    if (this->regularExpressionButton->isChecked()) {
-        expr.setPattern(searchText);
-        QRegularExpression::PatternOptions options = expr.patternOptions();
-        options.setFlag(QRegularExpression::CaseInsensitiveOption,
-            !this->matchCaseButton->isChecked());
-        expr.setPatternOptions(options);
-    }
+    compileMatchQuery();
 
     bool found = false;
     int wrapCount = 0;
@@ -425,15 +554,16 @@ bool FindReplacePrivate::findMatch(QTextCursor& cursor, bool wrap, bool backward
     this->statusLabel->setProperty("error", false);
 
     while (!found && (wrapCount < 2)) {
-        if (expr.pattern().isEmpty() || expr.pattern().isNull()) {
-            cursor = this->editor->document()->find(searchText, cursor, findFlags);
+        if (this->matchQuery.literal) {
+            found = findLiteralMatch(cursor, backwards);
         }
         else {
-            cursor = this->editor->document()->find(expr, cursor, findFlags);
+            cursor = this->editor->document()->find(this->matchQuery.expression, cursor, findFlags);
+            found = !cursor.isNull();
         }
 
-        if (!cursor.isNull()) {
-            found = true;
+        if (found) {
+            break;
         }
         else if (!wrap) {
             break;
@@ -465,39 +595,398 @@ void FindReplacePrivate::highlightMatches(bool enabled)
 {
     // If highlights are enabled, clear any current highlights and return.
     if (!enabled) {
-        this->editor->setExtraSelections(QList<QTextEdit::ExtraSelection>());
+        if (this->matchesHighlighted) {
+            this->matchesHighlighted = false;
+            this->matchCountWatcher->cancel();
+            this->editor->viewport()->update();
+        }
+
         return;
     }
 
-    QList<QTextEdit::ExtraSelection> selections;
-    QColor highlightedTextColor = this->editor->palette().color(QPalette::HighlightedText);
-    QColor highlightColor = this->editor->palette().color(QPalette::Highlight);
-    highlightColor.setAlpha(150);
+    this->matchColor = this->editor->palette().color(QPalette::Highlight);
+    this->matchColor.setAlpha(150);
 
-    QTextCursor cursor = this->editor->textCursor();
-    cursor.movePosition(QTextCursor::Start);
+    compileMatchQuery();
+    this->matchesHighlighted = true;
+    this->matchRevision = this->editor->document()->revision();
 
-    QTextEdit::ExtraSelection match;
-    match.format.setForeground(highlightedTextColor);
-    match.format.setBackground(highlightColor);
-
-    bool movedToMatch = false;
-    
-    while (findMatch(cursor, false)) {
-        match.cursor = cursor;
-        selections.append(match);
+    if (!editor->hasFocus()) {
+        QTextCursor cursor = this->editor->textCursor();
+        cursor.setPosition(cursor.selectionStart());
 
-        if (!movedToMatch && !editor->hasFocus() && (cursor >= this->editor->textCursor())) {
+        if (findMatch(cursor, false)) {
             this->editor->setTextCursor(cursor);
-            movedToMatch = true;
         }
     }
 
-    this->editor->setExtraSelections(selections);
+    this->editor->viewport()->update();
+    startMatchCount();
+}
+
+// Compiles the query and its options for matching.  Plain text queries are
+// searched for literally, without going through a regular expression.
+//
+void FindReplacePrivate::compileMatchQuery()
+{
+    QString searchText = this->findField->text();
+    bool matchCase = this->matchCaseButton->isChecked();
+
+    this->matchQuery.literal = !this->regularExpressionButton->isChecked();
+    this->matchQuery.wholeWords = this->wholeWordButton->isChecked();
+
+    if (this->matchQuery.literal) {
+        this->matchQuery.searcher =
+            LiteralSearcher(searchText, matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive);
+        this->matchQuery.expression = QRegularExpression();
+    } else {
+        QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+
+        if (!matchCase) {
+            options |= QRegularExpression::CaseInsensitiveOption;
+        }
+
+        this->matchQuery.searcher = LiteralSearcher();
+        this->matchQuery.expression.setPattern(searchText);
+        this->matchQuery.expression.setPatternOptions(options);
+        this->matchQuery.expression.optimize();
+    }
+}
+
+// Finds the next (or previous) literal match from the given cursor in the
+// same way QTextDocument::find() does, searching one block at a time.
+// Sets the cursor to select the match and returns true if one is found.
+//
+bool FindReplacePrivate::findLiteralMatch(QTextCursor &cursor, bool backwards)
+{
+    const LiteralSearcher &searcher = this->matchQuery.searcher;
+    int length = searcher.length();
+    QTextDocument *document = this->editor->document();
+    int position = backwards ? (cursor.selectionStart() - 1) : cursor.selectionEnd();
+
+    if ((length <= 0) || (position < 0)) {
+        return false;
+    }
+
+    QTextBlock block = document->findBlock(position);
+    int offset = position - block.position();
+
+    while (block.isValid()) {
+        QString text = block.text();
+        text.replace(QChar::Nbsp, QLatin1Char(' '));
+
+        int index;
+
+        if (backwards) {
+            index = searcher.lastIndexIn(text, offset);
+
+            while ((index >= 0) && this->matchQuery.wholeWords && !isWholeWord(text, index, length)) {
+                index = (index > 0) ? searcher.lastIndexIn(text, index - 1) : -1;
+            }
+        } else {
+            index = searcher.indexIn(text, offset);
+
+            while ((index >= 0) && this->matchQuery.wholeWords && !isWholeWord(text, index, length)) {
+                index = searcher.indexIn(text, index + 1);
+            }
+        }
+
+        if (index >= 0) {
+            cursor = QTextCursor(block);
+            cursor.setPosition(block.position() + index);
+            cursor.setPosition(block.position() + index + length, QTextCursor::KeepAnchor);
+            return true;
+        }
+
+        if (backwards) {
+            block = block.previous();
+            offset = -1;
+        } else {
+            block = block.next();
+            offset = 0;
+        }
+    }
+
+    return false;
+}
+
+// Paints the background of the matches within the blocks that intersect
+// the given rectangle of the editor's viewport.
+//
+void FindReplacePrivate::paintMatches(const QRect &rect)
+{
+    QTextBlock block = this->editor->cursorForPosition(rect.topLeft()).block();
+    int endPosition = this->editor->cursorForPosition(rect.bottomRight()).position();
+
+    QPainter painter(this->editor->viewport());
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(this->matchColor);
+
+    QVector<Match> matches;
+
+    while (block.isValid() && (block.position() <= endPosition)) {
+        QTextLayout *layout = block.layout();
+
+        if (!block.isVisible() || (nullptr == layout) || (layout->lineCount() <= 0)) {
+            block = block.next();
+            continue;
+        }
+
+        QString text = block.text();
+        text.replace(QChar::Nbsp, QLatin1Char(' '));
+
+        matches.clear();
+        findMatches(text, this->matchQuery, -1, &matches);
+
+        if (!matches.isEmpty()) {
+            // Find where the block is laid out within the viewport from
+            // where the editor places the cursor at the block's start.
+            //
+            QTextLine firstLine = layout->lineAt(0);
+            QRect blockStartRect = this->editor->cursorRect(QTextCursor(block));
+            QPointF origin
+            (
+                blockStartRect.left() - firstLine.cursorToX(0),
+                blockStartRect.top() - firstLine.y()
+            );
+
+            for (const Match &match : matches) {
+                int start = match.start;
+                int end = match.start + match.length;
+
+                for (int i = layout->lineForTextPosition(start).lineNumber(); (i >= 0) && (i < layout->lineCount()); i++) {
+                    QTextLine line = layout->lineAt(i);
+
+                    if (line.textStart() >= end) {
+                        break;
+                    }
+
+                    qreal x1 = line.cursorToX(qMax(start, line.textStart()));
+                    qreal x2 = line.cursorToX(qMin(end, line.textStart() + line.textLength()));
+
+                    painter.drawRect
+                    (
+                        QRectF
+                        (
+                            origin.x() + qMin(x1, x2),
+                            origin.y() + line.y(),
+                            qAbs(x2 - x1),
+                            line.height()
+                        )
+                    );
+                }
+            }
+        }
+
+        block = block.next();
+    }
+
+    painter.end();
+}
+
+// Counts the matches in a snapshot of the text on a worker thread, abandoning
+// any count still in progress.
+//
+void FindReplacePrivate::startMatchCount()
+{
+    this->matchCountWatcher->cancel();
+    QString text = documentText();
+    MatchQuery query = this->matchQuery;
+
+    this->matchCountWatcher->setFuture
+    (
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Statistics,
+            [text, query]() {
+                return findTextMatches(text, query, MaxMatchCount + 1, nullptr);
+            }
+        )
+    );
+}
+
+void FindReplacePrivate::onMatchCountFinished()
+{
+    if (!this->matchesHighlighted || this->matchCountWatcher->isCanceled()) {
+        return;
+    }
+
+    int count = this->matchCountWatcher->result();
+
+    if (count <= 0) {
+        this->statusLabel->setText(QObject::tr("No results"));
+        this->statusLabel->setProperty("error", true);
+    } else if (count > MaxMatchCount) {
+        this->statusLabel->setText(QObject::tr("%L1+ matches").arg(MaxMatchCount));
+        this->statusLabel->setProperty("error", false);
+    } else {
+        this->statusLabel->setText(QObject::tr("%L1 matches").arg(count));
+        this->statusLabel->setProperty("error", false);
+    }
+}
+
+// Recounts the matches shortly after the text is edited.  The viewport
+// repaints the matches of the edited text on its own.
+//
+void FindReplacePrivate::onContentsChange(int charsRemoved, int charsAdded)
+{
+    if (!this->matchesHighlighted) {
+        return;
+    }
+
+    QTextDocument *document = this->editor->document();
+
+    // Highlighting also signals a change to the contents, but with the
+    // same number of characters removed as added and without changing the
+    // revision, so the matches stay the same then.
+    //
+    if ((charsRemoved == charsAdded) && (document->revision() == this->matchRevision)) {
+        return;
+    }
+
+    this->matchRevision = document->revision();
+    startHighlightTimer();
+}
+
+// Appends the matches within the given line of text to matches (if not
+// null), in the same way QTextDocument::find() matches within a block,
+// stopping after limit matches if limit is not negative.  Returns the
+// number of matches found.
+//
+int FindReplacePrivate::findMatches
+(
+    const QString &text,
+    const MatchQuery &query,
+    int limit,
+    QVector<Match> *matches
+)
+{
+    int count = 0;
+
+    if (query.literal) {
+        int length = query.searcher.length();
+
+        for (int start : query.searcher.indexesIn(text)) {
+            if ((limit >= 0) && (count >= limit)) {
+                break;
+            }
+
+            if (query.wholeWords && !isWholeWord(text, start, length)) {
+                continue;
+            }
+
+            if (nullptr != matches) {
+                Match found;
+                found.start = start;
+                found.length = length;
+                matches->append(found);
+            }
+
+            count++;
+        }
+
+        return count;
+    }
+
+    if (query.expression.pattern().isEmpty() || !query.expression.isValid()) {
+        return 0;
+    }
+
+    QRegularExpressionMatchIterator it = query.expression.globalMatch(text);
+
+    while (it.hasNext() && ((limit < 0) || (count < limit))) {
+        QRegularExpressionMatch match = it.next();
+        int start = match.capturedStart();
+        int length = match.capturedLength();
+
+        if (length <= 0) {
+            continue;
+        }
+
+        if (query.wholeWords && !isWholeWord(text, start, length)) {
+            continue;
+        }
+
+        if (nullptr != matches) {
+            Match found;
+            found.start = start;
+            found.length = length;
+            matches->append(found);
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+// Returns true if the given range of the text is not preceded or followed
+// by a letter or number, as QTextDocument::FindWholeWords requires.
+//
+bool FindReplacePrivate::isWholeWord(const QString &text, int start, int length)
+{
+    return !((start > 0) && text.at(start - 1).isLetterOrNumber())
+        && !(((start + length) < text.length()) && text.at(start + length).isLetterOrNumber());
+}
+
+// Finds the matches within each line of the given text, stopping after
+// limit matches if limit is not negative, and appends them to matches (if
+// not null) by position within the text.  Returns the number of matches
+// found.  Safe to run on a worker thread.
+//
+int FindReplacePrivate::findTextMatches
+(
+    const QString &text,
+    const MatchQuery &query,
+    int limit,
+    QVector<Match> *matches
+)
+{
+    int count = 0;
+    int lineStart = 0;
+
+    while ((lineStart <= text.length()) && ((limit < 0) || (count < limit))) {
+        int lineEnd = text.indexOf(QLatin1Char('\n'), lineStart);
+
+        if (lineEnd < 0) {
+            lineEnd = text.length();
+        }
+
+        int first = (nullptr != matches) ? matches->count() : 0;
+
+        count += findMatches
+            (
+                text.mid(lineStart, lineEnd - lineStart),
+                query,
+                (limit < 0) ? -1 : (limit - count),
+                matches
+            );
+
+        if (nullptr != matches) {
+            for (int i = first; i < matches->count(); i++) {
+                (*matches)[i].start += lineStart;
+            }
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    return count;
+}
+
+// Gets a plain text snapshot of the editor's document, sharing that of a
+// MarkdownDocument.
+//
+QString FindReplacePrivate::documentText() const
+{
+    QTextDocument *document = this->editor->document();
+    MarkdownDocument *markdownDocument = qobject_cast<MarkdownDocument *>(document);
+
+    if (nullptr != markdownDocument) {
+        return markdownDocument->plainTextSnapshot();
+    }
 
-    if (!selections.isEmpty()) {
-        this->statusLabel->setText(QObject::tr("%1 matches").arg(selections.count()));
-    }    
+    return document->toPlainText();
 }
 
 void FindReplacePrivate::setQueryFromSelection()
@@ -65,6 +65,8 @@ public:
      */
     void keyPressEvent(QKeyEvent *event);
 
+    bool eventFilter(QObject *watched, QEvent *event);
+
 public slots:
     // NOTE:  The following slots should be triggered by shortcut keys.
     //        For example, you can connect the CTRL+F shortcut to the
@@ -0,0 +1,518 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <limits>
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QListWidgetItem>
+#include <QPushButton>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVBoxLayout>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include "foldersearchwidget.h"
+#include "literalsearcher.h"
+
+namespace ghostwriter
+{
+// Match found in a file.
+typedef struct
+{
+    // Position of the match within the text of the file, as it would
+    // be in the editor's document.
+    int position;
+
+    // Line number of the match, starting from 1.
+    int lineNumber;
+
+    // Text of the line around the match, for display.
+    QString excerpt;
+} FileMatch;
+
+// Matches found in a file.
+typedef struct
+{
+    QString filePath;
+    QVector<FileMatch> matches;
+} FileMatches;
+
+// Searches a file for a query.  Applied to each of the files to search
+// from the global thread pool, so it must not change once constructed.
+//
+class FileSearch
+{
+public:
+    typedef FileMatches result_type;
+
+    FileSearch(const QString &query, bool caseSensitive, bool regularExpression);
+
+    FileMatches operator()(const QString &filePath) const;
+
+private:
+    // Maximum number of matches listed per file.
+    static const int MaxMatchesPerFile = 1000;
+
+    // Length of the excerpt of each match's line and how much of the line
+    // before the match it includes.
+    static const int ExcerptLength = 80;
+    static const int ExcerptLead = 20;
+
+    bool regularExpression;
+    LiteralSearcher searcher;
+    QRegularExpression expression;
+
+    void searchLine
+    (
+        const QString &line,
+        int lineNumber,
+        int position,
+        QVector<FileMatch> &matches
+    ) const;
+};
+
+class FolderSearchWidgetPrivate
+{
+    Q_DECLARE_PUBLIC(FolderSearchWidget)
+
+public:
+    FolderSearchWidgetPrivate(FolderSearchWidget *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~FolderSearchWidgetPrivate()
+    {
+        ;
+    }
+
+    static const int FILE_PATH_ROLE;
+    static const int POSITION_ROLE;
+
+    FolderSearchWidget *q_ptr;
+
+    QString folderPath;
+    QLineEdit *queryField;
+    QPushButton *matchCaseButton;
+    QPushButton *regularExpressionButton;
+    QListWidget *resultsList;
+    QLabel *statusLabel;
+    QFutureWatcher<FileMatches> *searchWatcher;
+    int matchCount;
+    int fileCount;
+
+    void onResultReady(int index);
+    void onSearchFinished();
+    void onItemSelected(QListWidgetItem *item);
+};
+
+const int FolderSearchWidgetPrivate::FILE_PATH_ROLE = Qt::UserRole + 1;
+const int FolderSearchWidgetPrivate::POSITION_ROLE = Qt::UserRole + 2;
+
+FolderSearchWidget::FolderSearchWidget(QWidget *parent)
+    : QWidget(parent),
+      d_ptr(new FolderSearchWidgetPrivate(this))
+{
+    Q_D(FolderSearchWidget);
+
+    d->matchCount = 0;
+    d->fileCount = 0;
+
+    d->queryField = new QLineEdit();
+    d->queryField->setPlaceholderText(tr("Find in folder"));
+    d->queryField->setClearButtonEnabled(true);
+    this->setFocusProxy(d->queryField);
+
+    d->matchCaseButton = new QPushButton("Aa");
+    d->matchCaseButton->setCheckable(true);
+    d->matchCaseButton->setToolTip(tr("Match case"));
+
+    d->regularExpressionButton = new QPushButton(".*");
+    d->regularExpressionButton->setCheckable(true);
+    d->regularExpressionButton->setToolTip(tr("Regular expression"));
+
+    d->resultsList = new QListWidget();
+    d->resultsList->setAlternatingRowColors(false);
+    d->resultsList->setTextElideMode(Qt::ElideRight);
+
+    d->statusLabel = new QLabel();
+    d->statusLabel->setWordWrap(true);
+
+    QHBoxLayout *queryLayout = new QHBoxLayout();
+    queryLayout->setContentsMargins(0, 0, 0, 0);
+    queryLayout->addWidget(d->queryField, 1);
+    queryLayout->addWidget(d->matchCaseButton);
+    queryLayout->addWidget(d->regularExpressionButton);
+
+    QVBoxLayout *layout = new QVBoxLayout();
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(queryLayout);
+    layout->addWidget(d->statusLabel);
+    layout->addWidget(d->resultsList, 1);
+    this->setLayout(layout);
+
+    d->searchWatcher = new QFutureWatcher<FileMatches>(this);
+
+    this->connect
+    (
+        d->searchWatcher,
+        &QFutureWatcher<FileMatches>::resultReadyAt,
+        [d](int index) {
+            d->onResultReady(index);
+        }
+    );
+
+    this->connect
+    (
+        d->searchWatcher,
+        &QFutureWatcher<FileMatches>::finished,
+        [d]() {
+            d->onSearchFinished();
+        }
+    );
+
+    this->connect
+    (
+        d->queryField,
+        &QLineEdit::returnPressed,
+        this,
+        &FolderSearchWidget::search
+    );
+
+    this->connect
+    (
+        d->resultsList,
+        &QListWidget::itemActivated,
+        [d](QListWidgetItem *item) {
+            d->onItemSelected(item);
+        }
+    );
+
+    this->connect
+    (
+        d->resultsList,
+        &QListWidget::itemClicked,
+        [d](QListWidgetItem *item) {
+            d->onItemSelected(item);
+        }
+    );
+}
+
+FolderSearchWidget::~FolderSearchWidget()
+{
+    Q_D(FolderSearchWidget);
+
+    d->searchWatcher->cancel();
+    d->searchWatcher->waitForFinished();
+}
+
+QString FolderSearchWidget::folder() const
+{
+    Q_D(const FolderSearchWidget);
+
+    return d->folderPath;
+}
+
+void FolderSearchWidget::setFolder(const QString &path)
+{
+    Q_D(FolderSearchWidget);
+
+    if (path != d->folderPath) {
+        cancel();
+        d->folderPath = path;
+        d->resultsList->clear();
+        d->statusLabel->clear();
+    }
+}
+
+void FolderSearchWidget::search()
+{
+    Q_D(FolderSearchWidget);
+
+    cancel();
+    d->resultsList->clear();
+    d->matchCount = 0;
+    d->fileCount = 0;
+
+    QString query = d->queryField->text();
+
+    if (query.isEmpty()) {
+        d->statusLabel->clear();
+        return;
+    }
+
+    if (d->folderPath.isEmpty()) {
+        d->statusLabel->setText(tr("Save the document to search its folder."));
+        return;
+    }
+
+    if (d->regularExpressionButton->isChecked() && !QRegularExpression(query).isValid()) {
+        d->statusLabel->setText(tr("Invalid regular expression"));
+        return;
+    }
+
+    QStringList nameFilters;
+    nameFilters << "*.md" << "*.markdown" << "*.mdown" << "*.mkdn" << "*.mkd"
+        << "*.mdwn" << "*.mdtxt" << "*.mdtext" << "*.Rmd";
+
+    QStringList files;
+    QDirIterator it
+    (
+        d->folderPath,
+        nameFilters,
+        QDir::Files | QDir::Readable,
+        QDirIterator::Subdirectories
+    );
+
+    while (it.hasNext()) {
+        files.append(it.next());
+    }
+
+    if (files.isEmpty()) {
+        d->statusLabel->setText(tr("No Markdown files in %1").arg(QDir::toNativeSeparators(d->folderPath)));
+        return;
+    }
+
+    files.sort();
+    d->statusLabel->setText(tr("Searching..."));
+
+    d->searchWatcher->setFuture
+    (
+        QtConcurrent::mapped
+        (
+            files,
+            FileSearch
+            (
+                query,
+                d->matchCaseButton->isChecked(),
+                d->regularExpressionButton->isChecked()
+            )
+        )
+    );
+}
+
+void FolderSearchWidget::cancel()
+{
+    Q_D(FolderSearchWidget);
+
+    if (d->searchWatcher->isRunning()) {
+        d->searchWatcher->cancel();
+        d->statusLabel->clear();
+    }
+}
+
+void FolderSearchWidgetPrivate::onResultReady(int index)
+{
+    if (searchWatcher->isCanceled()) {
+        return;
+    }
+
+    FileMatches result = searchWatcher->resultAt(index);
+
+    if (result.matches.isEmpty()) {
+        return;
+    }
+
+    QListWidgetItem *fileItem = new QListWidgetItem();
+    fileItem->setText
+    (
+        FolderSearchWidget::tr("%1 (%L2)")
+            .arg(QDir::toNativeSeparators(QDir(folderPath).relativeFilePath(result.filePath)))
+            .arg(result.matches.count())
+    );
+    fileItem->setToolTip(QDir::toNativeSeparators(result.filePath));
+    fileItem->setData(FILE_PATH_ROLE, result.filePath);
+    fileItem->setData(POSITION_ROLE, 0);
+    resultsList->addItem(fileItem);
+
+    for (const FileMatch &match : result.matches) {
+        QListWidgetItem *item = new QListWidgetItem();
+        item->setText(QString("    %1: %2").arg(match.lineNumber).arg(match.excerpt));
+        item->setData(FILE_PATH_ROLE, result.filePath);
+        item->setData(POSITION_ROLE, match.position);
+        resultsList->addItem(item);
+    }
+
+    matchCount += result.matches.count();
+    fileCount++;
+}
+
+void FolderSearchWidgetPrivate::onSearchFinished()
+{
+    if (searchWatcher->isCanceled()) {
+        return;
+    }
+
+    if (matchCount <= 0) {
+        statusLabel->setText(FolderSearchWidget::tr("No results"));
+    } else {
+        statusLabel->setText
+        (
+            FolderSearchWidget::tr("%L1 matches in %L2 files")
+                .arg(matchCount)
+                .arg(fileCount)
+        );
+    }
+}
+
+void FolderSearchWidgetPrivate::onItemSelected(QListWidgetItem *item)
+{
+    Q_Q(FolderSearchWidget);
+
+    if (nullptr == item) {
+        return;
+    }
+
+    emit q->resultSelected
+    (
+        item->data(FILE_PATH_ROLE).toString(),
+        item->data(POSITION_ROLE).toInt()
+    );
+}
+
+FileSearch::FileSearch(const QString &query, bool caseSensitive, bool regularExpression)
+    : regularExpression(regularExpression),
+      searcher(query, caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive)
+{
+    if (regularExpression) {
+        expression.setPattern(query);
+
+        if (!caseSensitive) {
+            expression.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+        }
+
+        expression.optimize();
+    }
+}
+
+// Maps the file into memory to decode it, and searches it one line at a
+// time, as the editor would have the file's text in blocks.
+//
+FileMatches FileSearch::operator()(const QString &filePath) const
+{
+    FileMatches result;
+    result.filePath = filePath;
+
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+
+    QString text;
+    qint64 size = file.size();
+
+    if ((size > 0) && (size <= std::numeric_limits<int>::max())) {
+        uchar *data = file.map(0, size);
+
+        if (nullptr != data) {
+            text = QString::fromUtf8((const char *) data, (int) size);
+            file.unmap(data);
+        } else {
+            text = QString::fromUtf8(file.readAll());
+        }
+    }
+
+    file.close();
+
+    int start = 0;
+
+    if (text.startsWith(QChar(0xFEFF))) {
+        start = 1;
+    }
+
+    int position = 0;
+    int lineNumber = 1;
+
+    while ((start <= text.length()) && (result.matches.count() < MaxMatchesPerFile)) {
+        int end = text.indexOf(QLatin1Char('\n'), start);
+
+        if (end < 0) {
+            end = text.length();
+        }
+
+        // Carriage returns before line feeds don't make it into the
+        // editor's document.
+        int lineLength = end - start;
+
+        if ((lineLength > 0) && (QLatin1Char('\r') == text.at(end - 1))) {
+            lineLength--;
+        }
+
+        searchLine(text.mid(start, lineLength), lineNumber, position, result.matches);
+
+        position += lineLength + 1;
+        lineNumber++;
+        start = end + 1;
+    }
+
+    if (result.matches.count() > MaxMatchesPerFile) {
+        result.matches.resize(MaxMatchesPerFile);
+    }
+
+    return result;
+}
+
+// Appends the matches within the given line to matches.  The position is
+// that of the start of the line.
+//
+void FileSearch::searchLine
+(
+    const QString &line,
+    int lineNumber,
+    int position,
+    QVector<FileMatch> &matches
+) const
+{
+    QVector<int> columns;
+
+    if (regularExpression) {
+        QRegularExpressionMatchIterator it = expression.globalMatch(line);
+
+        while (it.hasNext()) {
+            QRegularExpressionMatch match = it.next();
+
+            if (match.capturedLength() > 0) {
+                columns.append(match.capturedStart());
+            }
+        }
+    } else {
+        columns = searcher.indexesIn(line);
+    }
+
+    for (int column : columns) {
+        FileMatch match;
+        match.position = position + column;
+        match.lineNumber = lineNumber;
+        match.excerpt = line.mid(qMax(0, column - ExcerptLead), ExcerptLength).trimmed();
+        matches.append(match);
+    }
+}
+} // namespace ghostwriter
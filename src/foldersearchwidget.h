@@ -0,0 +1,87 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef FOLDERSEARCHWIDGET_H
+#define FOLDERSEARCHWIDGET_H
+
+#include <QScopedPointer>
+#include <QString>
+#include <QWidget>
+
+namespace ghostwriter
+{
+/**
+ * Sidebar widget to search the Markdown files of a folder, including its
+ * subfolders.  Files are scanned in parallel on the global thread pool,
+ * and their matches are listed as each file is done.
+ */
+class FolderSearchWidgetPrivate;
+class FolderSearchWidget : public QWidget
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(FolderSearchWidget)
+
+public:
+    /**
+     * Constructor.
+     */
+    FolderSearchWidget(QWidget *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~FolderSearchWidget();
+
+    /**
+     * Gets the folder to search.
+     */
+    QString folder() const;
+
+    /**
+     * Sets the folder to search.  Pass an empty path if there is no folder
+     * to search, such as when the document has not been saved yet.
+     */
+    void setFolder(const QString &path);
+
+signals:
+    /**
+     * Emitted when the user selects a match in the search results, with
+     * the path of the file and the position of the match within its text.
+     */
+    void resultSelected(const QString &filePath, int position);
+
+public slots:
+    /**
+     * Searches the folder for the query entered by the user, abandoning
+     * any search still in progress.
+     */
+    void search();
+
+    /**
+     * Abandons the search in progress, if any.
+     */
+    void cancel();
+
+private:
+    QScopedPointer<FolderSearchWidgetPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // FOLDERSEARCHWIDGET_H
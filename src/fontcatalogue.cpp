@@ -0,0 +1,118 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFontDatabase>
+#include <QMutexLocker>
+#include <QTimer>
+
+#include "fontcatalogue.h"
+#include "taskscheduler.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+FontCatalogue *FontCatalogue::instance()
+{
+    static FontCatalogue catalogue;
+    return &catalogue;
+}
+
+FontCatalogue::FontCatalogue()
+    : loaded(false),
+      prefetching(false)
+{
+    ;
+}
+
+FontCatalogue::~FontCatalogue()
+{
+    ;
+}
+
+void FontCatalogue::prefetch()
+{
+    {
+        QMutexLocker locker(&mutex);
+
+        if (loaded || prefetching) {
+            return;
+        }
+
+        prefetching = true;
+    }
+
+    // Without threaded font rendering, the font database may only be used
+    // on the GUI thread, so enumerate there once the event loop is idle.
+    if (QFontDatabase::supportsThreadedFontRendering()) {
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Indexing,
+            [this]() {
+                load();
+            }
+        );
+    } else {
+        QTimer::singleShot(0, [this]() { load(); });
+    }
+}
+
+QStringList FontCatalogue::families()
+{
+    load();
+    return allFamilies;
+}
+
+QStringList FontCatalogue::monospaceFamilies()
+{
+    load();
+    return fixedPitchFamilies;
+}
+
+QList<int> FontCatalogue::standardSizes()
+{
+    load();
+    return sizes;
+}
+
+void FontCatalogue::load()
+{
+    QMutexLocker locker(&mutex);
+
+    if (loaded) {
+        return;
+    }
+
+    GW_TRACE_SCOPE("FontCatalogue::load");
+
+    QFontDatabase fontDb;
+
+    allFamilies = fontDb.families();
+    allFamilies.sort(Qt::CaseInsensitive);
+
+    for (const QString &family : allFamilies) {
+        if (fontDb.isFixedPitch(family)) {
+            fixedPitchFamilies.append(family);
+        }
+    }
+
+    sizes = QFontDatabase::standardSizes();
+    loaded = true;
+    prefetching = false;
+}
+} // namespace ghostwriter
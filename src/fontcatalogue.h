@@ -0,0 +1,83 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef FONT_CATALOGUE_H
+#define FONT_CATALOGUE_H
+
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+
+namespace ghostwriter
+{
+/**
+ * Catalogue of the installed font families, enumerated once per session.
+ * Enumerating the font database can take hundreds of milliseconds on
+ * systems with thousands of fonts, so the font pickers share this
+ * catalogue rather than each querying the font database anew.
+ *
+ * Call prefetch() once the application is idle to enumerate the fonts
+ * ahead of time, on a background thread if the platform allows it.  If
+ * the catalogue is asked for before then, it is enumerated on the
+ * calling thread, or the caller waits for the enumeration under way.
+ */
+class FontCatalogue
+{
+public:
+    /**
+     * Returns the single instance of the catalogue.
+     */
+    static FontCatalogue *instance();
+
+    /**
+     * Starts enumerating the fonts, if they have not been already.
+     */
+    void prefetch();
+
+    /**
+     * Returns the sorted list of installed font families.
+     */
+    QStringList families();
+
+    /**
+     * Returns the sorted list of installed fixed pitch font families.
+     */
+    QStringList monospaceFamilies();
+
+    /**
+     * Returns the standard font sizes, in points.
+     */
+    QList<int> standardSizes();
+
+private:
+    QMutex mutex;
+    bool loaded;
+    bool prefetching;
+    QStringList allFamilies;
+    QStringList fixedPitchFamilies;
+    QList<int> sizes;
+
+    FontCatalogue();
+    ~FontCatalogue();
+
+    void load();
+};
+} // namespace ghostwriter
+
+#endif // FONT_CATALOGUE_H
@@ -0,0 +1,263 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QIconEngine>
+#include <QList>
+#include <QPainter>
+#include <QPixmapCache>
+#include <QPointer>
+
+#include "glyphiconcache.h"
+
+namespace ghostwriter
+{
+namespace
+{
+// Draws a glyph from pixmaps rendered once per size, color and device
+// pixel ratio.
+//
+class GlyphIconEngine : public QIconEngine
+{
+public:
+    GlyphIconEngine
+    (
+        QtAwesome *awesome,
+        style::styles fontStyle,
+        int character,
+        const QColor &normal,
+        const QColor &highlight,
+        bool highlighted
+    ) : awesome(awesome),
+        fontStyle(fontStyle),
+        character(character),
+        normal(normal),
+        highlight(highlight),
+        highlighted(highlighted)
+    {
+        ;
+    }
+
+    QIconEngine *clone() const
+    {
+        return new GlyphIconEngine(awesome, fontStyle, character, normal, highlight, highlighted);
+    }
+
+    void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state)
+    {
+        qreal ratio = painter->device()->devicePixelRatioF();
+
+        painter->drawPixmap
+        (
+            rect,
+            glyphPixmap(rect.size() * ratio, color(mode, state), ratio)
+        );
+    }
+
+    QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state)
+    {
+        // QIcon passes sizes in device pixels, and sets the pixel ratio of
+        // the pixmap itself.
+        return glyphPixmap(size, color(mode, state), 1.0);
+    }
+
+private:
+    QtAwesome *awesome;
+    style::styles fontStyle;
+    int character;
+    QColor normal;
+    QColor highlight;
+    bool highlighted;
+
+    QColor color(QIcon::Mode mode, QIcon::State state) const
+    {
+        if (QIcon::Disabled == mode) {
+            QColor disabled = normal;
+            disabled.setAlphaF(normal.alphaF() * 0.5);
+            return disabled;
+        }
+
+        if
+        (
+            highlighted
+            && ((QIcon::Active == mode) || (QIcon::Selected == mode) || (QIcon::On == state))
+        ) {
+            return highlight;
+        }
+
+        return normal;
+    }
+
+    QPixmap glyphPixmap(const QSize &size, const QColor &color, qreal ratio) const
+    {
+        QString key = QString("ghostwriter-glyph:%1:%2:%3x%4:%5:%6")
+            .arg((int) fontStyle)
+            .arg(character, 0, 16)
+            .arg(size.width())
+            .arg(size.height())
+            .arg(color.rgba(), 0, 16)
+            .arg(ratio);
+
+        QPixmap pixmap;
+
+        if (QPixmapCache::find(key, &pixmap)) {
+            return pixmap;
+        }
+
+        pixmap = QPixmap(size);
+        pixmap.fill(Qt::transparent);
+
+        QPainter painter(&pixmap);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        painter.setFont(awesome->font(fontStyle, size.height()));
+        painter.setPen(color);
+        painter.drawText
+        (
+            QRect(QPoint(0, 0), size),
+            Qt::AlignCenter,
+            QString(QChar(character))
+        );
+        painter.end();
+
+        QPixmapCache::insert(key, pixmap);
+        return pixmap;
+    }
+};
+} // namespace
+
+class GlyphIconCachePrivate
+{
+public:
+    GlyphIconCachePrivate()
+    {
+        ;
+    }
+
+    ~GlyphIconCachePrivate()
+    {
+        ;
+    }
+
+    // Button given a glyph with setGlyph().
+    struct Glyph
+    {
+        QPointer<QAbstractButton> button;
+        style::styles fontStyle;
+        int character;
+        bool highlighted;
+    };
+
+    QtAwesome *awesome;
+    QColor normal;
+    QColor highlight;
+    QList<Glyph> glyphs;
+};
+
+GlyphIconCache::GlyphIconCache(QtAwesome *awesome, QObject *parent)
+    : QObject(parent),
+      d_ptr(new GlyphIconCachePrivate())
+{
+    Q_D(GlyphIconCache);
+
+    d->awesome = awesome;
+    d->normal = QColor(Qt::black);
+    d->highlight = QColor(Qt::black);
+}
+
+GlyphIconCache::~GlyphIconCache()
+{
+    ;
+}
+
+QIcon GlyphIconCache::icon(style::styles fontStyle, int character, bool highlighted) const
+{
+    Q_D(const GlyphIconCache);
+
+    return QIcon
+        (
+            new GlyphIconEngine
+            (
+                d->awesome,
+                fontStyle,
+                character,
+                d->normal,
+                d->highlight,
+                highlighted
+            )
+        );
+}
+
+void GlyphIconCache::setGlyph
+(
+    QAbstractButton *button,
+    style::styles fontStyle,
+    int character,
+    bool highlighted,
+    int size
+)
+{
+    Q_D(GlyphIconCache);
+
+    bool found = false;
+
+    for (GlyphIconCachePrivate::Glyph &glyph : d->glyphs) {
+        if (glyph.button == button) {
+            glyph.fontStyle = fontStyle;
+            glyph.character = character;
+            glyph.highlighted = highlighted;
+            found = true;
+            break;
+        }
+    }
+
+    if (!found) {
+        GlyphIconCachePrivate::Glyph glyph;
+        glyph.button = button;
+        glyph.fontStyle = fontStyle;
+        glyph.character = character;
+        glyph.highlighted = highlighted;
+        d->glyphs.append(glyph);
+
+        button->setIconSize(QSize(size, size));
+    }
+
+    button->setIcon(icon(fontStyle, character, highlighted));
+}
+
+void GlyphIconCache::setColors(const QColor &normal, const QColor &highlight)
+{
+    Q_D(GlyphIconCache);
+
+    if ((normal == d->normal) && (highlight == d->highlight)) {
+        return;
+    }
+
+    d->normal = normal;
+    d->highlight = highlight;
+
+    for (int i = d->glyphs.size() - 1; i >= 0; i--) {
+        const GlyphIconCachePrivate::Glyph &glyph = d->glyphs[i];
+
+        if (glyph.button.isNull()) {
+            d->glyphs.removeAt(i);
+        } else {
+            glyph.button->setIcon(icon(glyph.fontStyle, glyph.character, glyph.highlighted));
+        }
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,93 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef GLYPH_ICON_CACHE_H
+#define GLYPH_ICON_CACHE_H
+
+#include <QAbstractButton>
+#include <QColor>
+#include <QIcon>
+#include <QObject>
+#include <QScopedPointer>
+
+#include "3rdparty/QtAwesome/QtAwesome.h"
+
+namespace ghostwriter
+{
+/**
+ * Gives buttons Font Awesome glyphs as icons drawn from pre-rendered
+ * pixmaps, rather than as text drawn with the icon font on every paint.
+ *
+ * Each glyph is rendered once per size, color and device pixel ratio into
+ * QPixmapCache, from which every later paint is served.  The icons of the
+ * buttons are set again with new colors when the theme changes, and the
+ * pixmaps of the colors of earlier themes stay cached for when the user
+ * switches back.
+ */
+class GlyphIconCachePrivate;
+class GlyphIconCache : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(GlyphIconCache)
+
+public:
+    /**
+     * Constructor.  Pass in the initialized QtAwesome instance whose fonts
+     * hold the glyphs.
+     */
+    GlyphIconCache(QtAwesome *awesome, QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~GlyphIconCache();
+
+    /**
+     * Returns an icon of the given glyph, drawn in the normal color, or in
+     * the highlight color while hovered or checked if highlighted is true.
+     */
+    QIcon icon(style::styles fontStyle, int character, bool highlighted) const;
+
+    /**
+     * Sets the icon of the given button to the given glyph, as returned
+     * by icon(), and keeps it in the colors set by setColors() for as long
+     * as the button lives.  The button's icon size is set to the given
+     * size, unless its style sheet sets one.
+     */
+    void setGlyph
+    (
+        QAbstractButton *button,
+        style::styles fontStyle,
+        int character,
+        bool highlighted = false,
+        int size = 16
+    );
+
+    /**
+     * Sets the colors in which glyphs are drawn, and updates the icons of
+     * the buttons given to setGlyph().
+     */
+    void setColors(const QColor &normal, const QColor &highlight);
+
+private:
+    QScopedPointer<GlyphIconCachePrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // GLYPH_ICON_CACHE_H
@@ -0,0 +1,273 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <algorithm>
+
+#include <QRegularExpression>
+
+#include "headingindex.h"
+#include "markdownast.h"
+#include "markdowndocument.h"
+#include "markdownnode.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+// Score of each character of the query matched at the start of a word,
+// or right after the previous character matched, and the penalty for each
+// character skipped between two matches.
+static const int WordStartBonus = 10;
+static const int ConsecutiveBonus = 8;
+static const int GapPenalty = 1;
+
+HeadingIndex::HeadingIndex(MarkdownDocument *document)
+    : QObject(document), document(document), stale(true)
+{
+    this->connect
+    (
+        document,
+        &MarkdownDocument::markdownASTChanged,
+        [this]() {
+            this->stale = true;
+        }
+    );
+}
+
+HeadingIndex::~HeadingIndex()
+{
+    ;
+}
+
+QVector<HeadingIndex::Match> HeadingIndex::search(const QString &query, int maxResults)
+{
+    if (stale) {
+        refresh();
+    }
+
+    static const QRegularExpression whitespaceRegex("\\s");
+
+    QString foldedQuery = query.toCaseFolded();
+    foldedQuery.remove(whitespaceRegex);
+
+    quint64 queryMask = characterMask(foldedQuery);
+    QVector<Match> matches;
+
+    for (const Entry &entry : entries) {
+        Match result;
+
+        if
+        (
+            ((entry.characterMask & queryMask) != queryMask)
+            || !match(entry.foldedText, foldedQuery, result.score)
+        ) {
+            continue;
+        }
+
+        result.block = entry.block;
+        result.level = entry.level;
+        result.text = entry.text;
+        matches.append(result);
+
+        // Without a query, the headings are simply listed in order.
+        if (foldedQuery.isEmpty() && (matches.size() >= maxResults)) {
+            break;
+        }
+    }
+
+    std::stable_sort
+    (
+        matches.begin(),
+        matches.end(),
+        [](const Match &a, const Match &b) {
+            return a.score > b.score;
+        }
+    );
+
+    if (matches.size() > maxResults) {
+        matches.resize(maxResults);
+    }
+
+    return matches;
+}
+
+void HeadingIndex::refresh()
+{
+    GW_TRACE_SCOPE("HeadingIndex::refresh");
+
+    stale = false;
+
+    MarkdownAST *ast = document->markdownAST();
+
+    if (nullptr == ast) {
+        entries.clear();
+        return;
+    }
+
+    QVector<MarkdownNode *> headings = ast->headings();
+    QVector<QPair<QTextBlock, int>> blocks;
+    blocks.reserve(headings.size());
+
+    for (MarkdownNode *heading : headings) {
+        QTextBlock block = document->findBlockByNumber(heading->startLine() - 1);
+
+        if (block.isValid()) {
+            blocks.append(qMakePair(block, heading->headingLevel()));
+        }
+    }
+
+    // Most reparses leave the headings as they were, or change only the
+    // few around the edit.  Keep the entries that still match at the start
+    // and at the end, and only index the headings in between.
+    auto isSame = [](const Entry &entry, const QPair<QTextBlock, int> &heading) {
+        return (entry.level == heading.second) && (entry.lineText == heading.first.text());
+    };
+
+    int oldCount = entries.size();
+    int newCount = blocks.size();
+    int prefix = 0;
+    int suffix = 0;
+
+    while ((prefix < oldCount) && (prefix < newCount) && isSame(entries[prefix], blocks[prefix])) {
+        prefix++;
+    }
+
+    while
+    (
+        (suffix < (oldCount - prefix))
+        && (suffix < (newCount - prefix))
+        && isSame(entries[oldCount - 1 - suffix], blocks[newCount - 1 - suffix])
+    ) {
+        suffix++;
+    }
+
+    QVector<Entry> changed(newCount - prefix - suffix);
+
+    for (int i = 0; i < changed.size(); i++) {
+        setEntry(changed[i], blocks[prefix + i].first, blocks[prefix + i].second);
+    }
+
+    QVector<Entry> updated;
+    updated.reserve(newCount);
+    updated.append(entries.mid(0, prefix));
+    updated.append(changed);
+    updated.append(entries.mid(oldCount - suffix));
+
+    // Headings after an edit keep their text but may have moved to other
+    // blocks.
+    for (int i = 0; i < newCount; i++) {
+        updated[i].block = blocks[i].first;
+    }
+
+    entries = updated;
+}
+
+void HeadingIndex::setEntry(Entry &entry, const QTextBlock &block, int level)
+{
+    static const QRegularExpression headingRegex("^\\s*#*(.*?)\\s*#*?\\s*$");
+
+    entry.block = block;
+    entry.level = level;
+    entry.lineText = block.text();
+
+    QRegularExpressionMatch match = headingRegex.match(entry.lineText);
+    entry.text = match.hasMatch() ? match.captured(1).trimmed() : entry.lineText.trimmed();
+    entry.foldedText = entry.text.toCaseFolded();
+    entry.characterMask = characterMask(entry.foldedText);
+}
+
+quint64 HeadingIndex::characterMask(const QString &foldedText)
+{
+    quint64 mask = 0;
+
+    for (const QChar c : foldedText) {
+        ushort code = c.unicode();
+
+        if ((code >= 'a') && (code <= 'z')) {
+            mask |= Q_UINT64_C(1) << (code - 'a');
+        } else if ((code >= '0') && (code <= '9')) {
+            mask |= Q_UINT64_C(1) << (26 + code - '0');
+        } else if (!c.isSpace()) {
+            mask |= Q_UINT64_C(1) << (36 + (code % 28));
+        }
+    }
+
+    return mask;
+}
+
+bool HeadingIndex::match(const QString &foldedText, const QString &foldedQuery, int &score)
+{
+    score = 0;
+
+    if (foldedQuery.isEmpty()) {
+        return true;
+    }
+
+    bool found = false;
+
+    // Match the query greedily from each occurrence of its first character,
+    // keeping the best scoring match.
+    for
+    (
+        int start = foldedText.indexOf(foldedQuery[0]);
+        start >= 0;
+        start = foldedText.indexOf(foldedQuery[0], start + 1)
+    ) {
+        int candidateScore = 0;
+        int matched = 0;
+        int previous = -1;
+        int pos = start;
+
+        for (const QChar c : foldedQuery) {
+            pos = foldedText.indexOf(c, pos);
+
+            if (pos < 0) {
+                break;
+            }
+
+            if ((0 == pos) || !foldedText[pos - 1].isLetterOrNumber()) {
+                candidateScore += WordStartBonus;
+            }
+
+            if (previous >= 0) {
+                if ((previous + 1) == pos) {
+                    candidateScore += ConsecutiveBonus;
+                } else {
+                    candidateScore -= GapPenalty * (pos - previous - 1);
+                }
+            }
+
+            matched++;
+            previous = pos;
+            pos++;
+        }
+
+        // No later start can match either if this one ran out of text.
+        if (matched < foldedQuery.length()) {
+            break;
+        }
+
+        if (!found || (candidateScore > score)) {
+            found = true;
+            score = candidateScore;
+        }
+    }
+
+    return found;
+}
+} // namespace ghostwriter
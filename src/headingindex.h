@@ -0,0 +1,124 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef HEADINGINDEX_H
+#define HEADINGINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QTextBlock>
+#include <QVector>
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+
+/**
+ * Index of the headings of a document for finding them by fuzzy search,
+ * where the characters of the query must appear in the heading in order,
+ * but not necessarily next to each other.
+ *
+ * The index follows the headings of the document's AST.  It is refreshed
+ * when next searched after the AST changes, and the refresh only indexes
+ * the headings that differ from those already indexed, as the outline
+ * does.  Each heading keeps its case folded text and a bit mask of the
+ * characters that it contains, so that most headings are ruled out by
+ * comparing their mask with the query's before matching their text.
+ */
+class HeadingIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * A heading matching a search.
+     */
+    struct Match
+    {
+        QTextBlock block;
+        int level;
+
+        // Text of the heading, without its Markdown markup.
+        QString text;
+
+        // How well the heading matches the query.  Higher is better.
+        int score;
+    };
+
+    /**
+     * Constructor.
+     */
+    explicit HeadingIndex(MarkdownDocument *document);
+
+    /**
+     * Destructor.
+     */
+    virtual ~HeadingIndex();
+
+    /**
+     * Returns at most maxResults headings matching the given query, the
+     * best matches first.  Matches that score the same are in document
+     * order, and an empty query matches every heading in document order.
+     */
+    QVector<Match> search(const QString &query, int maxResults);
+
+private:
+    struct Entry
+    {
+        QTextBlock block;
+        int level;
+        QString lineText;
+        QString text;
+        QString foldedText;
+        quint64 characterMask;
+    };
+
+    MarkdownDocument *document;
+    QVector<Entry> entries;
+
+    // Whether the AST changed since the index was last refreshed.
+    bool stale;
+
+    /*
+    * Updates the entries with the headings of the document's AST.
+    */
+    void refresh();
+
+    /*
+    * Fills in the entry for the heading of the given block and level.
+    */
+    static void setEntry(Entry &entry, const QTextBlock &block, int level);
+
+    /*
+    * Returns the bit mask of the characters in the given case folded
+    * text.  Each letter and digit has a bit of its own, while the other
+    * characters share bits by their code.
+    */
+    static quint64 characterMask(const QString &foldedText);
+
+    /*
+    * Matches the given case folded query against the given case folded
+    * text, returning true and filling in the score if all of the query's
+    * characters appear in the text in order.
+    */
+    static bool match(const QString &foldedText, const QString &foldedQuery, int &score);
+};
+} // namespace ghostwriter
+
+#endif // HEADINGINDEX_H
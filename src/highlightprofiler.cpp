@@ -0,0 +1,211 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+
+#include <cstring>
+
+#include "highlightprofiler.h"
+
+namespace ghostwriter
+{
+HighlightProfiler::Scope::Scope(HighlightProfiler *profiler, Phase phase)
+    : profiler(profiler), phase(phase), nodeType(-1)
+{
+    if ((nullptr != profiler) && profiler->isEnabled()) {
+        timer.start();
+    }
+}
+
+HighlightProfiler::Scope::Scope
+(
+    HighlightProfiler *profiler,
+    MarkdownNode::NodeType nodeType
+) : profiler(profiler), phase(-1), nodeType(nodeType)
+{
+    if ((nullptr != profiler) && profiler->isEnabled()) {
+        timer.start();
+    }
+}
+
+HighlightProfiler::Scope::~Scope()
+{
+    if (!timer.isValid()) {
+        return;
+    }
+
+    qint64 nsecs = timer.nsecsElapsed();
+    QMutexLocker locker(&profiler->mutex);
+
+    if (phase >= 0) {
+        profiler->record(profiler->phases[phase], nsecs);
+    } else {
+        profiler->record(profiler->nodeTypes[nodeType], nsecs);
+    }
+}
+
+HighlightProfiler::HighlightProfiler()
+    : enabled(false)
+{
+    reset();
+}
+
+HighlightProfiler::~HighlightProfiler()
+{
+    ;
+}
+
+void HighlightProfiler::setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+bool HighlightProfiler::isEnabled() const
+{
+    return enabled;
+}
+
+void HighlightProfiler::reset()
+{
+    QMutexLocker locker(&mutex);
+
+    memset(phases, 0, sizeof(phases));
+    memset(nodeTypes, 0, sizeof(nodeTypes));
+}
+
+QString HighlightProfiler::report() const
+{
+    static const char *phaseNames[PhaseCount] = {
+        "FindBlock",
+        "CacheKey",
+        "ComputeFormats",
+        "RefLinks",
+        "SpellCheck",
+        "ApplyFormats"
+    };
+
+    QMutexLocker locker(&mutex);
+    QString text;
+    QTextStream stream(&text);
+
+    QString header =
+        QString("%1 %2 %3 %4 %5 %6 %7\n")
+        .arg("", -20)
+        .arg("calls", 10)
+        .arg("total ms", 12)
+        .arg("mean us", 10)
+        .arg("p50 us", 10)
+        .arg("p99 us", 10)
+        .arg("max us", 10);
+
+    stream << "Highlighting phases\n" << header;
+
+    for (int i = 0; i < PhaseCount; i++) {
+        stream << reportLine(phaseNames[i], phases[i]);
+    }
+
+    stream << "\nFormatting by block node type\n" << header;
+
+    for (int i = 0; i < NodeTypeCount; i++) {
+        if (nodeTypes[i].count > 0) {
+            stream << reportLine
+                (
+                    MarkdownNode::toString((MarkdownNode::NodeType) i),
+                    nodeTypes[i]
+                );
+        }
+    }
+
+    stream.flush();
+    return text;
+}
+
+bool HighlightProfiler::dump(const QString &filePath) const
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << report();
+    stream.flush();
+
+    return QTextStream::Ok == stream.status();
+}
+
+void HighlightProfiler::record(Histogram &histogram, qint64 nsecs)
+{
+    int bucket = 0;
+
+    while (((bucket + 1) < BucketCount) && ((qint64(1) << (bucket + 1)) <= nsecs)) {
+        bucket++;
+    }
+
+    histogram.count++;
+    histogram.total += nsecs;
+    histogram.buckets[bucket]++;
+
+    if (nsecs > histogram.max) {
+        histogram.max = nsecs;
+    }
+}
+
+QString HighlightProfiler::reportLine(const QString &name, const Histogram &histogram) const
+{
+    double mean = 0.0;
+
+    if (histogram.count > 0) {
+        mean = (double) histogram.total / (double) histogram.count;
+    }
+
+    return
+        QString("%1 %2 %3 %4 %5 %6 %7\n")
+        .arg(name, -20)
+        .arg(histogram.count, 10)
+        .arg(histogram.total / 1.0e6, 12, 'f', 3)
+        .arg(mean / 1.0e3, 10, 'f', 2)
+        .arg(percentile(histogram, 0.50) / 1.0e3, 10, 'f', 2)
+        .arg(percentile(histogram, 0.99) / 1.0e3, 10, 'f', 2)
+        .arg(histogram.max / 1.0e3, 10, 'f', 2);
+}
+
+// Returns an estimate, in nanoseconds, of the given percentile of the
+// durations in the histogram:  the upper bound of the bucket that holds it.
+//
+qint64 HighlightProfiler::percentile(const Histogram &histogram, double fraction) const
+{
+    qint64 target = (qint64) (fraction * histogram.count);
+    qint64 seen = 0;
+
+    for (int i = 0; i < BucketCount; i++) {
+        seen += histogram.buckets[i];
+
+        if (seen > target) {
+            return qMin(qint64(1) << (i + 1), histogram.max);
+        }
+    }
+
+    return histogram.max;
+}
+} // namespace ghostwriter
@@ -0,0 +1,133 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef HIGHLIGHTPROFILER_H
+#define HIGHLIGHTPROFILER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+
+#include "markdownnode.h"
+
+namespace ghostwriter
+{
+/**
+ * Collects the durations of the phases of syntax highlighting into
+ * histograms, by phase and by the type of the block node highlighted, for
+ * diagnosing slow rehighlights.  Recording is thread-safe, so that
+ * highlights computed on the thread pool can be timed as well.  The
+ * profiler is disabled by default, in which case timing costs a single
+ * check per phase.
+ */
+class HighlightProfiler
+{
+public:
+    /**
+     * Timed phases of highlighting a block.
+     */
+    typedef enum {
+        FindBlock,
+        CacheKey,
+        ComputeFormats,
+        RefLinks,
+        SpellCheck,
+        ApplyFormats,
+        PhaseCount
+    } Phase;
+
+    /**
+     * Times the enclosing scope as the given phase, or as the highlighting
+     * of a block node of the given type.
+     */
+    class Scope
+    {
+    public:
+        Scope(HighlightProfiler *profiler, Phase phase);
+        Scope(HighlightProfiler *profiler, MarkdownNode::NodeType nodeType);
+        ~Scope();
+
+    private:
+        HighlightProfiler *profiler;
+        int phase;
+        int nodeType;
+        QElapsedTimer timer;
+    };
+
+    /**
+     * Constructor.
+     */
+    HighlightProfiler();
+
+    /**
+     * Destructor.
+     */
+    ~HighlightProfiler();
+
+    /**
+     * Enables or disables recording.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns whether recording is enabled.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Discards everything recorded so far.
+     */
+    void reset();
+
+    /**
+     * Returns a plain text report of the histograms.
+     */
+    QString report() const;
+
+    /**
+     * Writes the report to the given file.  Returns false if the file
+     * could not be written.
+     */
+    bool dump(const QString &filePath) const;
+
+private:
+    // Histogram buckets are powers of two of nanoseconds.
+    static const int BucketCount = 40;
+    static const int NodeTypeCount = MarkdownNode::LastInlineType + 1;
+
+    struct Histogram
+    {
+        qint64 count;
+        qint64 total;
+        qint64 max;
+        qint64 buckets[BucketCount];
+    };
+
+    bool enabled;
+    mutable QMutex mutex;
+    Histogram phases[PhaseCount];
+    Histogram nodeTypes[NodeTypeCount];
+
+    void record(Histogram &histogram, qint64 nsecs);
+    QString reportLine(const QString &name, const Histogram &histogram) const;
+    qint64 percentile(const Histogram &histogram, double fraction) const;
+};
+} // namespace ghostwriter
+
+#endif // HIGHLIGHTPROFILER_H
@@ -0,0 +1,347 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <QCryptographicHash>
+#include <QVector>
+#include <QtGlobal>
+
+#include "htmlblockobserver.h"
+
+namespace ghostwriter
+{
+const QString HtmlBlockObserver::SOURCE_LINES_ATTR = QString("data-source-lines");
+
+//
+// Returns true if the given lowercase tag name is that of an element that
+// has no closing tag.
+//
+static bool isVoidElement(const QString &name)
+{
+    static const QStringList voidElements = {
+        "area", "base", "br", "col", "embed", "hr", "img", "input",
+        "link", "meta", "param", "source", "track", "wbr"
+    };
+
+    return voidElements.contains(name);
+}
+
+//
+// Returns true if the given lowercase tag name is that of an element whose
+// content is not parsed as HTML, and may therefore contain '<' characters.
+//
+static bool isRawTextElement(const QString &name)
+{
+    static const QStringList rawTextElements = {
+        "script", "style", "textarea", "title"
+    };
+
+    return rawTextElements.contains(name);
+}
+
+//
+// Skips over the tag (or comment) starting at the '<' character at the
+// given position, adjusting the element depth accordingly.  Returns the
+// position following the tag.
+//
+static int skipTag(const QString &html, int pos, int &depth)
+{
+    const int length = html.length();
+
+    if (html.midRef(pos, 4) == QLatin1String("<!--")) {
+        int end = html.indexOf(QLatin1String("-->"), pos + 4);
+        return (end < 0) ? length : (end + 3);
+    }
+
+    if
+    (
+        ((pos + 1) < length) &&
+        (('!' == html[pos + 1]) || ('?' == html[pos + 1]))
+    ) {
+        int end = html.indexOf('>', pos);
+        return (end < 0) ? length : (end + 1);
+    }
+
+    bool closing = ((pos + 1) < length) && ('/' == html[pos + 1]);
+    int nameStart = pos + (closing ? 2 : 1);
+    int nameEnd = nameStart;
+
+    while
+    (
+        (nameEnd < length) &&
+        (html[nameEnd].isLetterOrNumber() || ('-' == html[nameEnd]))
+    ) {
+        nameEnd++;
+    }
+
+    // A '<' that does not begin a tag name is plain text.
+    if (nameEnd == nameStart) {
+        return pos + 1;
+    }
+
+    QChar quote;
+    int i = nameEnd;
+
+    for (; i < length; i++) {
+        QChar c = html[i];
+
+        if (!quote.isNull()) {
+            if (c == quote) {
+                quote = QChar();
+            }
+        } else if (('"' == c) || ('\'' == c)) {
+            quote = c;
+        } else if ('>' == c) {
+            break;
+        }
+    }
+
+    bool selfClosing = (i < length) && ('/' == html[i - 1]);
+    int end = (i < length) ? (i + 1) : length;
+
+    if (closing) {
+        depth = qMax(0, depth - 1);
+        return end;
+    }
+
+    QString name = html.mid(nameStart, nameEnd - nameStart).toLower();
+
+    if (selfClosing || isVoidElement(name)) {
+        return end;
+    }
+
+    if (isRawTextElement(name)) {
+        int close = html.indexOf("</" + name, end, Qt::CaseInsensitive);
+
+        if (close < 0) {
+            return length;
+        }
+
+        int closeEnd = html.indexOf('>', close);
+        return (closeEnd < 0) ? length : (closeEnd + 1);
+    }
+
+    depth++;
+    return end;
+}
+
+//
+// Appends the HTML between the given positions to the block list, unless
+// it is only whitespace.
+//
+static void appendBlock(QStringList &blocks, const QString &html, int start, int end)
+{
+    QStringRef block = html.midRef(start, end - start);
+
+    if (!block.trimmed().isEmpty()) {
+        blocks.append(block.toString());
+    }
+}
+
+HtmlBlockObserver::HtmlBlockObserver(QObject *parent) : QObject(parent)
+{
+    ;
+}
+
+HtmlBlockObserver::~HtmlBlockObserver()
+{
+    ;
+}
+
+void HtmlBlockObserver::setHtml(const QString &html)
+{
+    // Rerenders often produce the same HTML, such as after edits that only
+    // touch whitespace, so skip splitting and comparing the blocks then.
+    QByteArray htmlHash =
+        QCryptographicHash::hash
+        (
+            QByteArray::fromRawData((const char *) html.constData(), html.size() * sizeof(QChar)),
+            QCryptographicHash::Md5
+        );
+
+    if (htmlHash == mHtmlHash) {
+        return;
+    }
+
+    mHtmlHash = htmlHash;
+
+    QStringList newBlocks = split(html);
+    QVariantList newBlockLines;
+
+    for (int i = 0; i < newBlocks.size(); i++) {
+        int firstLine;
+        int lastLine;
+
+        if (takeSourceLines(newBlocks[i], firstLine, lastLine)) {
+            newBlockLines << i << firstLine << lastLine;
+        }
+    }
+
+    int oldCount = mBlocks.size();
+    int newCount = newBlocks.size();
+    int maxCommon = qMin(oldCount, newCount);
+    int prefix = 0;
+    int suffix = 0;
+
+    while ((prefix < maxCommon) && (mBlocks[prefix] == newBlocks[prefix])) {
+        prefix++;
+    }
+
+    while
+    (
+        (suffix < (maxCommon - prefix)) &&
+        (mBlocks[oldCount - 1 - suffix] == newBlocks[newCount - 1 - suffix])
+    ) {
+        suffix++;
+    }
+
+    int removeCount = oldCount - prefix - suffix;
+    QStringList inserted = newBlocks.mid(prefix, newCount - prefix - suffix);
+
+    mBlocks = newBlocks;
+
+    if (inserted.isEmpty()) {
+        if (removeCount > 0) {
+            emit blocksChanged(prefix, removeCount, inserted, true);
+        }
+    } else {
+        int chunkStart = 0;
+        int chunkLength = 0;
+
+        for (int i = 0; i < inserted.size(); i++) {
+            if ((i > chunkStart) && ((chunkLength + inserted[i].length()) > MAX_CHUNK_LENGTH)) {
+                emit blocksChanged
+                (
+                    prefix + chunkStart,
+                    (0 == chunkStart) ? removeCount : 0,
+                    inserted.mid(chunkStart, i - chunkStart),
+                    false
+                );
+
+                chunkStart = i;
+                chunkLength = 0;
+            }
+
+            chunkLength += inserted[i].length();
+        }
+
+        emit blocksChanged
+        (
+            prefix + chunkStart,
+            (0 == chunkStart) ? removeCount : 0,
+            inserted.mid(chunkStart),
+            true
+        );
+    }
+
+    if (newBlockLines != mBlockLines) {
+        mBlockLines = newBlockLines;
+        emit blockLinesChanged(mBlockLines);
+    }
+}
+
+QStringList HtmlBlockObserver::blocks() const
+{
+    return mBlocks;
+}
+
+qint64 HtmlBlockObserver::memoryUsage() const
+{
+    qint64 bytes = 0;
+
+    foreach (const QString &block, mBlocks) {
+        bytes += block.capacity() * sizeof(QChar);
+    }
+
+    return bytes;
+}
+
+QVariantList HtmlBlockObserver::blockLines() const
+{
+    return mBlockLines;
+}
+
+QStringList HtmlBlockObserver::split(const QString &html)
+{
+    QStringList blocks;
+    const int length = html.length();
+    int depth = 0;
+    int blockStart = 0;
+    int i = 0;
+
+    while (i < length) {
+        QChar c = html[i];
+
+        if ('<' == c) {
+            i = skipTag(html, i, depth);
+        } else {
+            if (('\n' == c) && (0 == depth)) {
+                appendBlock(blocks, html, blockStart, i);
+                blockStart = i + 1;
+            }
+
+            i++;
+        }
+    }
+
+    appendBlock(blocks, html, blockStart, length);
+    return blocks;
+}
+// Removes the source lines attribute from the start tag at the beginning
+// of the given block, if it is there, returning whether it was found.  The
+// attribute is expected to follow the tag name right away.
+//
+bool HtmlBlockObserver::takeSourceLines(QString &block, int &firstLine, int &lastLine)
+{
+    if (!block.startsWith('<')) {
+        return false;
+    }
+
+    int nameEnd = 1;
+
+    while ((nameEnd < block.length()) && block[nameEnd].isLetterOrNumber()) {
+        nameEnd++;
+    }
+
+    QString prefix = QString(" %1=\"").arg(SOURCE_LINES_ATTR);
+
+    if ((nameEnd <= 1) || (block.midRef(nameEnd, prefix.length()) != prefix)) {
+        return false;
+    }
+
+    int valueStart = nameEnd + prefix.length();
+    int valueEnd = block.indexOf('"', valueStart);
+
+    if (valueEnd < 0) {
+        return false;
+    }
+
+    QVector<QStringRef> lines = block.midRef(valueStart, valueEnd - valueStart).split('-');
+    bool firstOk = false;
+    bool lastOk = false;
+
+    if (2 == lines.size()) {
+        firstLine = lines[0].toInt(&firstOk);
+        lastLine = lines[1].toInt(&lastOk);
+    }
+
+    block.remove(nameEnd, valueEnd + 1 - nameEnd);
+    return firstOk && lastOk;
+}
+} // namespace ghostwriter
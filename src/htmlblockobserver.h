@@ -0,0 +1,141 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef HTMLBLOCKOBSERVER_H
+#define HTMLBLOCKOBSERVER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+
+namespace ghostwriter
+{
+/**
+ * Observer for rendered HTML that is split into its top-level blocks.  Used
+ * in notifying the web channel in QtWebEngine (Chromium) of only the blocks
+ * that changed since the last update, so that the page can patch those
+ * nodes instead of reparsing the entire document.  Large changes are sent
+ * in several chunks, so that no single message over the web channel holds
+ * megabytes of HTML, and so that the page can paint between chunks.
+ */
+class HtmlBlockObserver : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.
+     */
+    explicit HtmlBlockObserver(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~HtmlBlockObserver();
+
+    /**
+     * Sets the HTML to observe.  The HTML is split into top-level blocks,
+     * which are compared against the previous blocks.  The blocksChanged()
+     * signal is emitted for the range that differs, if any, once per chunk
+     * of at most MAX_CHUNK_LENGTH characters of blocks.  Unchanged HTML is
+     * not sent at all.
+     */
+    void setHtml(const QString &html);
+
+    /**
+     * Gets all the HTML blocks currently observed.  The web page calls this
+     * method once when it loads to populate its content, after which it
+     * relies on the blocksChanged() signal.
+     */
+    Q_INVOKABLE QStringList blocks() const;
+
+    /**
+     * Gets the source lines of the blocks whose top-level element was
+     * annotated with the SOURCE_LINES_ATTR attribute, as a flat list of
+     * block index, first line, and last line for each such block, in
+     * document order.  The attribute itself is removed from the blocks,
+     * so that moving a block's lines does not change its HTML.
+     */
+    Q_INVOKABLE QVariantList blockLines() const;
+
+    /**
+     * Returns the bytes of memory held by the text of the blocks.
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * Splits the given HTML into its top-level blocks.  A block ends at a
+     * newline outside of any element.  HTML that has unclosed elements
+     * is kept whole from the start of the first unclosed element.
+     */
+    static QStringList split(const QString &html);
+
+    /**
+     * Contains the name of the attribute with which renderers can annotate
+     * the top-level elements of the HTML with the range of source lines
+     * that they were rendered from, such as data-source-lines="3-5".
+     */
+    static const QString SOURCE_LINES_ATTR;
+
+    /**
+     * Maximum number of characters of blocks in a chunk, unless a single
+     * block is longer, in which case it is sent as a chunk on its own.
+     */
+    static const int MAX_CHUNK_LENGTH = 256 * 1024;
+
+signals:
+    /**
+     * Emitted when the observed blocks change.  The blocks in the range
+     * starting at index start with length removeCount are replaced with
+     * the given blocks.  A change that is split into chunks is emitted as
+     * a replacement by the first chunk, followed by insertions of the
+     * others after it.  The last parameter is false for all but the last
+     * chunk of a change.
+     */
+    void blocksChanged(int start, int removeCount, const QStringList &blocks, bool last);
+
+    /**
+     * Emitted when the source lines of the blocks change.
+     */
+    void blockLinesChanged(const QVariantList &lines);
+
+private:
+    /*
+    * Top-level blocks of the observed HTML.
+    */
+    QStringList mBlocks;
+
+    /*
+    * Source lines of the blocks, in the format given by blockLines().
+    */
+    QVariantList mBlockLines;
+
+    /*
+    * Hash of the observed HTML, by which unchanged HTML is skipped.
+    */
+    QByteArray mHtmlHash;
+
+    static bool takeSourceLines(QString &block, int &firstLine, int &lastLine);
+};
+} // namespace ghostwriter
+
+#endif // HTMLBLOCKOBSERVER_H
@@ -25,14 +25,24 @@
 #include <QStack>
 #include <QDir>
 #include <QDesktopServices>
-#include <QtConcurrentRun>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <QFuture>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <QTimer>
 #include <QWebChannel>
 
+#include "diagramrenderer.h"
 #include "exporter.h"
+#include "htmlblockobserver.h"
 #include "htmlpreview.h"
+#include "previewprofile.h"
 #include "sandboxedwebpage.h"
 #include "stringobserver.h"
+#include "taskscheduler.h"
+#include "tracer.h"
 
 namespace ghostwriter
 {
@@ -54,19 +64,89 @@ public:
 
     HtmlPreview *q_ptr;
 
+    // Renders taking at most this long, in milliseconds, need no debounce.
+    static const int FrameTime = 16;
+
+    // Longest delay, in milliseconds, before rendering an update.
+    static const int MaxRenderDelay = 1000;
+
+    // Number of characters that the exporter is assumed to render per
+    // millisecond before the first render time has been measured.
+    static const int CharactersPerMillisecond = 10000;
+
+    // Default time, in milliseconds, that the preview stays suspended
+    // before unloading its page.
+    static const int DefaultIdleTimeout = 60000;
+
     MarkdownDocument *document;
     bool updateInProgress;
     bool updateAgain;
-    StringObserver livePreviewHtml;
+
+    // Whether an update was requested during a transaction on the
+    // document, to be made once the transaction is committed.
+    bool updateAfterTransaction;
+    QTimer *renderTimer;
+    QElapsedTimer renderClock;
+    int lastRenderTime;
+
+    // Whether the widget last received a show event rather than a hide
+    // event.  Unlike isVisible(), this is also false while the window is
+    // minimized.
+    bool shown;
+    bool suspended;
+    bool pageDiscarded;
+    QTimer *idleTimer;
+
+    // Source line to which the preview was last scrolled.
+    qreal lastLineNumber;
+
+    // Cancellation token of the render in progress.  Once set, the render
+    // is obsolete, so that it is either skipped or its result dropped.
+    QSharedPointer<QAtomicInt> renderCancelled;
+
+    // Times taken by the application for the last update sent to the
+    // page, while timing is enabled.
+    PreviewTimingHook timingHook;
+    PreviewTiming timing;
+
+    HtmlBlockObserver livePreviewHtml;
+
+    // Replaces diagram code blocks with their SVG.  The HTML from the
+    // exporter is kept along with its revision, so that it can be passed
+    // through the diagrams again once more of them are rendered.
+    DiagramRenderer *diagrams;
+    QString exportedHtml;
+    int exportedRevision;
+
     StringObserver styleSheet;
-    QString baseUrl;
+
+    // Values of the style sheet's CSS custom properties, as a JSON object.
+    StringObserver styleSheetVariables;
+    StringObserver baseUrl;
+
+    // Base URL with which wrapperHtml was last loaded.
+    QString pageBaseUrl;
+
     QRegularExpression headingTagExp;
     Exporter *exporter;
     QString wrapperHtml;
     QFutureWatcher<QString> *futureWatcher;
 
+    // Revision of the document being rendered.
+    int renderRevision;
+
     void onHtmlReady();
+    void scheduleRender();
+    void startRender();
+    void cancelRender();
+    int renderDelay() const;
+    void updateSuspended();
+    void suspend();
+    void resume();
+    void discardPage();
+    void onHtmlRendered(const QString &html, int revision);
     void onLoadFinished(bool ok);
+    void refreshDiagrams();
 
     /**
      * Sets the base directory path for determining resource
@@ -75,13 +155,17 @@ public:
      */
     void updateBaseDir();
     /*
-    * Sets the HTML contents to display, and creates a backup of the old
-    * HTML for diffing to scroll to the first difference whenever
-    * updatePreview() is called.
+    * Sets the HTML contents to display.  Only the top-level blocks that
+    * differ from the previous contents are sent to the web page.
     */
-    void setHtmlContent(const QString &html);
+    void setHtmlContent(const QString &html, int revision = -1);
 
-    QString exportToHtml(const QString &text, Exporter *exporter) const;
+    static QString exportToHtml
+    (
+        const QString &text,
+        Exporter *exporter,
+        QSharedPointer<QAtomicInt> cancelled
+    );
 };
 
 HtmlPreview::HtmlPreview
@@ -97,13 +181,39 @@ HtmlPreview::HtmlPreview
     d->document = document;
     d->updateInProgress = false;
     d->updateAgain = false;
+    d->updateAfterTransaction = false;
+    d->lastRenderTime = -1;
+    d->shown = false;
+    d->suspended = true;
+    d->pageDiscarded = false;
+    d->lastLineNumber = -1.0;
+    d->renderRevision = -1;
+    d->exportedRevision = -1;
+    d->renderCancelled.reset(new QAtomicInt(0));
     d->exporter = exporter;
 
-    d->baseUrl = "";
-    d->livePreviewHtml.setText("");
+    d->baseUrl.setText("");
     d->styleSheet.setText("");
+    d->styleSheetVariables.setText("{}");
+    d->timing = PreviewTiming();
 
-    this->setPage(new SandboxedWebPage(this));
+    this->connect
+    (
+        &d->timingHook,
+        &PreviewTimingHook::reported,
+        [this, d](double received, double patched, double typeset, double painted) {
+            PreviewTiming timing = d->timing;
+            timing.received = received;
+            timing.patched = patched;
+            timing.typeset = typeset;
+            timing.painted = painted;
+
+            d->timing = PreviewTiming();
+            emit updateTimed(timing);
+        }
+    );
+
+    this->setPage(new SandboxedWebPage(PreviewProfile::instance(), this));
     this->settings()->setDefaultTextEncoding("utf-8");
     this->settings()->setAttribute(QWebEngineSettings::LocalContentCanAccessFileUrls, true);
     this->settings()->setAttribute(QWebEngineSettings::LocalContentCanAccessRemoteUrls, true);
@@ -114,9 +224,6 @@ HtmlPreview::HtmlPreview
     this->page()->action(QWebEnginePage::OpenLinkInNewWindow)->setVisible(false);
     this->page()->action(QWebEnginePage::ViewSource)->setVisible(false);
     this->page()->action(QWebEnginePage::SavePage)->setVisible(false);
-    QWebEngineProfile::defaultProfile()->setHttpCacheType(QWebEngineProfile::NoCache);
-    QWebEngineProfile::defaultProfile()->clearHttpCache();
-    QWebEngineProfile::defaultProfile()->clearAllVisitedLinks();
 
     this->connect
     (
@@ -129,6 +236,39 @@ HtmlPreview::HtmlPreview
 
     d->headingTagExp.setPattern("^[Hh][1-6]$");
 
+    d->diagrams = new DiagramRenderer(this);
+    this->connect
+    (
+        d->diagrams,
+        &DiagramRenderer::diagramsRendered,
+        [d]() {
+            d->refreshDiagrams();
+        }
+    );
+
+    d->renderTimer = new QTimer(this);
+    d->renderTimer->setSingleShot(true);
+    this->connect
+    (
+        d->renderTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->startRender();
+        }
+    );
+
+    d->idleTimer = new QTimer(this);
+    d->idleTimer->setSingleShot(true);
+    d->idleTimer->setInterval(HtmlPreviewPrivate::DefaultIdleTimeout);
+    this->connect
+    (
+        d->idleTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->discardPage();
+        }
+    );
+
     d->futureWatcher = new QFutureWatcher<QString>(this);
     this->connect
     (
@@ -139,6 +279,27 @@ HtmlPreview::HtmlPreview
         }
     );
 
+    this->connect
+    (
+        document,
+        &MarkdownDocument::htmlRendered,
+        [d](const QString &html, int revision) {
+            d->onHtmlRendered(html, revision);
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::transactionCommitted,
+        [this, d]() {
+            if (d->updateAfterTransaction) {
+                d->updateAfterTransaction = false;
+                this->updatePreview();
+            }
+        }
+    );
+
     this->connect
     (
         document,
@@ -156,7 +317,10 @@ HtmlPreview::HtmlPreview
 
     QWebChannel *channel = new QWebChannel(this);
     channel->registerObject(QStringLiteral("stylesheet"), &d->styleSheet);
+    channel->registerObject(QStringLiteral("stylesheetvariables"), &d->styleSheetVariables);
     channel->registerObject(QStringLiteral("livepreviewcontent"), &d->livePreviewHtml);
+    channel->registerObject(QStringLiteral("baseurl"), &d->baseUrl);
+    channel->registerObject(QStringLiteral("previewtimings"), &d->timingHook);
     this->page()->setWebChannel(channel);
 
     QFile wrapperHtmlFile(":/resources/preview.html");
@@ -169,16 +333,35 @@ HtmlPreview::HtmlPreview
         wrapperHtmlFile.close();
     }
 
+    // Give the preview's code highlighter the table of languages that the
+    // editor's CodeLexer reads, so that there is only one to maintain.
+    // Escape '<' so that the table cannot end the script element early.
+    //
+    QFile languagesFile(":/resources/codelanguages.json");
+
+    if (languagesFile.open(QFile::ReadOnly)) {
+        QString languages = QString::fromUtf8(languagesFile.readAll());
+        languages.replace('<', "\\u003c");
+        d->wrapperHtml.replace("/* CODE_LANGUAGES */ []", languages);
+        languagesFile.close();
+    }
+
     // Set the base URL and load the preview using wrapperHtml above.
     d->updateBaseDir();
+
+    // The preview is suspended until it is first shown.
+    d->idleTimer->start();
 }
 
 HtmlPreview::~HtmlPreview()
 {
     Q_D(HtmlPreview);
-    
-    // Wait for thread to finish if in the middle of updating the preview.
-    d->futureWatcher->waitForFinished();
+
+    // Rather than wait for a render in progress to finish, let it finish
+    // on its own.  It only uses its own copy of the text and the exporter,
+    // which lives until the application exits.
+    //
+    d->cancelRender();
 }
 
 void HtmlPreview::contextMenuEvent(QContextMenuEvent *event)
@@ -187,37 +370,55 @@ void HtmlPreview::contextMenuEvent(QContextMenuEvent *event)
     menu->popup(event->globalPos());
 }
 
+bool HtmlPreview::isSuspended() const
+{
+    Q_D(const HtmlPreview);
+
+    return d->suspended;
+}
+
+qint64 HtmlPreview::htmlMemory() const
+{
+    Q_D(const HtmlPreview);
+
+    return d->livePreviewHtml.memoryUsage()
+        + (d->exportedHtml.capacity() * sizeof(QChar))
+        + (d->wrapperHtml.capacity() * sizeof(QChar));
+}
+
+void HtmlPreview::setTimingEnabled(bool enabled)
+{
+    Q_D(HtmlPreview);
+
+    d->timing = PreviewTiming();
+    d->timingHook.setEnabled(enabled);
+}
+
 void HtmlPreview::updatePreview()
 {
     Q_D(HtmlPreview);
-    
-    if (d->updateInProgress) {
-        d->updateAgain = true;
+    GW_TRACE_SCOPE("HtmlPreview::updatePreview");
+
+    // Render the document once all changes of a transaction are in.
+    if (d->document->isInTransaction()) {
+        d->updateAfterTransaction = true;
         return;
     }
 
-    if (this->isVisible()) {
+    if (!d->suspended) {
         // Some markdown processors don't handle empty text very well
         // and will err.  Thus, only pass in text from the document
         // into the markdown processor if the text isn't empty or null.
         //
         if (d->document->isEmpty()) {
+            d->cancelRender();
             d->setHtmlContent("");
+        } else if (d->document->isHtmlRenderPending()) {
+            // The editor is already parsing the text and will render the
+            // HTML from the same parse, so wait for it.
+            d->cancelRender();
         } else if (nullptr != d->exporter) {
-            QString text = d->document->toPlainText();
-
-            if (!text.isNull() && !text.isEmpty()) {
-                d->updateInProgress = true;
-                QFuture<QString> future =
-                    QtConcurrent::run
-                    (
-                        d,
-                        &HtmlPreviewPrivate::exportToHtml,
-                        d->document->toPlainText(),
-                        d->exporter
-                    );
-                d->futureWatcher->setFuture(future);
-            }
+            d->scheduleRender();
         }
     }
 }
@@ -233,11 +434,32 @@ void HtmlPreview::navigateToHeading(int headingSequenceNumber)
     );
 }
 
+void HtmlPreview::scrollToLine(qreal lineNumber)
+{
+    Q_D(HtmlPreview);
+
+    d->lastLineNumber = lineNumber;
+
+    if (d->suspended) {
+        return;
+    }
+
+    this->page()->runJavaScript
+    (
+        QString
+        (
+            "scrollToLine(%1);"
+        ).arg(lineNumber)
+    );
+}
+
 void HtmlPreview::setHtmlExporter(Exporter *exporter)
 {
     Q_D(HtmlPreview);
     
+    d->cancelRender();
     d->exporter = exporter;
+    d->lastRenderTime = -1;
     d->setHtmlContent("");
     updatePreview();
 }
@@ -245,22 +467,173 @@ void HtmlPreview::setHtmlExporter(Exporter *exporter)
 void HtmlPreview::setStyleSheet(const QString &css)
 {
     Q_D(HtmlPreview);
-    
+
+    // Resending an unchanged style sheet would still restyle the page.
+    if (d->styleSheet.text() == css) {
+        return;
+    }
+
     d->styleSheet.setText(css);
 }
 
+void HtmlPreview::setStyleSheetVariables(const QHash<QString, QString> &variables)
+{
+    Q_D(HtmlPreview);
+
+    QJsonObject json;
+
+    for
+    (
+        QHash<QString, QString>::const_iterator i = variables.constBegin();
+        i != variables.constEnd();
+        ++i
+    ) {
+        json.insert(i.key(), i.value());
+    }
+
+    QString text = QString::fromUtf8(QJsonDocument(json).toJson(QJsonDocument::Compact));
+
+    if (d->styleSheetVariables.text() == text) {
+        return;
+    }
+
+    d->styleSheetVariables.setText(text);
+}
+
+void HtmlPreview::setDiagramColors(const QColor &foreground, const QColor &background)
+{
+    Q_D(HtmlPreview);
+
+    d->diagrams->setColors(foreground, background);
+    d->refreshDiagrams();
+}
+
+void HtmlPreview::setIdleTimeout(int seconds)
+{
+    Q_D(HtmlPreview);
+
+    d->idleTimer->setInterval(seconds * 1000);
+}
+
+void HtmlPreview::releaseMemory()
+{
+    Q_D(HtmlPreview);
+
+    if (d->suspended) {
+        d->idleTimer->stop();
+        d->discardPage();
+    }
+}
+
 void HtmlPreviewPrivate::onHtmlReady()
 {
-    Q_Q(HtmlPreview);
-    
-    setHtmlContent(futureWatcher->result());
     updateInProgress = false;
+    lastRenderTime = renderClock.elapsed();
+
+    if (timingHook.isEnabled()) {
+        timing.htmlExported = PreviewTimingHook::now();
+    }
+
+    // Drop the HTML of obsolete renders, since it no longer matches the text.
+    if (!renderCancelled->load()) {
+        setHtmlContent(futureWatcher->result(), renderRevision);
+    }
 
+    // If the debounce delay for a newer update has already passed while
+    // rendering, render the newer update right away.
     if (updateAgain) {
         updateAgain = false;
-        q->updatePreview();
+        startRender();
+    }
+}
+
+// Schedules rendering the document after a delay, making any render in
+// progress obsolete.
+//
+void HtmlPreviewPrivate::scheduleRender()
+{
+    if (updateInProgress) {
+        renderCancelled->store(1);
+    }
+
+    updateAgain = false;
+    renderTimer->start(renderDelay());
+}
+
+void HtmlPreviewPrivate::startRender()
+{
+    if (updateInProgress) {
+        // Exporters render one text at a time, so wait for the obsolete
+        // render to finish.
+        updateAgain = true;
+        return;
+    }
+
+    if (document->isEmpty() || (nullptr == exporter)) {
+        return;
+    }
+
+    QString text = document->plainTextSnapshot();
+
+    if (text.isNull() || text.isEmpty()) {
+        return;
+    }
+
+    renderRevision = document->revision();
+
+    renderCancelled.reset(new QAtomicInt(0));
+    updateInProgress = true;
+    renderClock.start();
+
+    if (timingHook.isEnabled()) {
+        timing.renderStarted = PreviewTimingHook::now();
+    }
+
+    Exporter *exporter = this->exporter;
+    QSharedPointer<QAtomicInt> cancelled = renderCancelled;
+
+    QFuture<QString> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Preview,
+            [text, exporter, cancelled]() {
+                return exportToHtml(text, exporter, cancelled);
+            }
+        );
+    futureWatcher->setFuture(future);
+}
+
+void HtmlPreviewPrivate::cancelRender()
+{
+    renderTimer->stop();
+    renderCancelled->store(1);
+    updateAgain = false;
+}
+
+// Returns the delay before rendering an update, in milliseconds.  The
+// delay is as long as the last render took, so that rendering keeps pace
+// with typing without rendering text that is already obsolete.  Until a
+// render has been measured, the delay is estimated from the document size.
+//
+int HtmlPreviewPrivate::renderDelay() const
+{
+    int sizeDelay = document->characterCount() / CharactersPerMillisecond;
+    int delay = qMax(lastRenderTime, sizeDelay);
+
+    if (delay <= FrameTime) {
+        return 0;
     }
 
+    return (delay < MaxRenderDelay) ? delay : MaxRenderDelay;
+}
+
+void HtmlPreviewPrivate::onHtmlRendered(const QString &html, int revision)
+{
+    // Ignore HTML for text that has since changed, since a newer update
+    // will have been requested in that case.
+    if (!suspended && (revision == document->revision())) {
+        setHtmlContent(html, revision);
+    }
 }
 
 void HtmlPreviewPrivate::onLoadFinished(bool ok)
@@ -269,26 +642,163 @@ void HtmlPreviewPrivate::onLoadFinished(bool ok)
     
     if (ok) {
         q->page()->runJavaScript("document.documentElement.contentEditable = false;");
+
+        // Let a reloaded page scroll back to where the editor is once its
+        // blocks arrive.
+        if (!pageDiscarded && (lastLineNumber >= 0.0)) {
+            q->page()->runJavaScript
+            (
+                QString("scrollToLine(%1);").arg(lastLineNumber)
+            );
+        }
     }
 }
 
+// Passes the last HTML from the exporter through the diagrams again, if it
+// still matches the text.  Only the blocks of diagrams whose SVG changed
+// are sent to the page.
+//
+void HtmlPreviewPrivate::refreshDiagrams()
+{
+    if
+    (
+        !suspended
+        && !exportedHtml.isEmpty()
+        && (exportedRevision == document->revision())
+    ) {
+        setHtmlContent(exportedHtml, exportedRevision);
+    }
+}
+
+// Suspends the preview if it can no longer be seen, or resumes it if it
+// can be seen again.
+//
+void HtmlPreviewPrivate::updateSuspended()
+{
+    Q_Q(HtmlPreview);
+
+    bool hidden = !shown || q->size().isEmpty();
+
+    if (hidden && !suspended) {
+        suspend();
+    } else if (!hidden && suspended) {
+        resume();
+    }
+}
+
+// Stops rendering and releases the rendered HTML.  The page itself stays
+// loaded, throttled by QtWebEngine, until the idle timeout unloads it.
+//
+void HtmlPreviewPrivate::suspend()
+{
+    Q_Q(HtmlPreview);
+
+    suspended = true;
+    cancelRender();
+    setHtmlContent("");
+    idleTimer->start();
+
+    emit q->suspendedChanged(true);
+}
+
+// Reloads the page if it was unloaded while suspended, and renders the
+// current text once.
+//
+void HtmlPreviewPrivate::resume()
+{
+    Q_Q(HtmlPreview);
+
+    suspended = false;
+    idleTimer->stop();
+
+    emit q->suspendedChanged(false);
+
+    if (pageDiscarded) {
+        pageDiscarded = false;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        if (QWebEnginePage::LifecycleState::Discarded == q->page()->lifecycleState()) {
+            q->page()->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+        }
+#endif
+
+        // Updates the preview, too.
+        updateBaseDir();
+    } else {
+        // The page keeps the line until its blocks arrive.
+        if (lastLineNumber >= 0.0) {
+            q->page()->runJavaScript
+            (
+                QString("scrollToLine(%1);").arg(lastLineNumber)
+            );
+        }
+
+        q->updatePreview();
+    }
+}
+
+// Unloads the page of a suspended preview to free the memory of its
+// renderer.
+//
+void HtmlPreviewPrivate::discardPage()
+{
+    Q_Q(HtmlPreview);
+
+    if (!suspended || pageDiscarded) {
+        return;
+    }
+
+    pageDiscarded = true;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    // Only pages of hidden views can be discarded, which excludes those
+    // of minimized windows.
+    if (!q->page()->isVisible()) {
+        q->page()->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+        return;
+    }
+#endif
+
+    pageBaseUrl = QString();
+    q->setHtml(QString());
+}
+
 void HtmlPreviewPrivate::updateBaseDir()
 {
     Q_Q(HtmlPreview);
     
+    // The page is loaded with the new base URL once the preview resumes.
+    if (pageDiscarded) {
+        return;
+    }
+
+    QString url = "";
+
     if (!document->filePath().isNull() && !document->filePath().isEmpty()) {
         // Note that a forward slash ("/") is appended to the path to
         // ensure it works.  If the slash isn't there, then it won't
         // recognize the base URL for some reason.
         //
-        baseUrl =
+        url =
             QUrl::fromLocalFile(QFileInfo(document->filePath()).dir().absolutePath()
                                 + "/").toString();
+    }
+
+    // Once the page is loaded from a local directory, let the page switch
+    // its base URL itself rather than reload the page and its scripts.
+    // A page loaded without a base URL cannot access local files, though,
+    // so it still needs reloading.
+    //
+    if (!pageBaseUrl.isEmpty() && !url.isEmpty()) {
+        if (url != baseUrl.text()) {
+            baseUrl.setText(url);
+        }
     } else {
-        this->baseUrl = "";
+        baseUrl.setText(url);
+        pageBaseUrl = url;
+        q->setHtml(wrapperHtml, url);
     }
 
-    q->setHtml(wrapperHtml, baseUrl);
     q->updatePreview();
 }
 
@@ -297,28 +807,93 @@ void HtmlPreview::closeEvent(QCloseEvent *event)
     Q_UNUSED(event);
     Q_D(HtmlPreview);
     
+    d->cancelRender();
     d->setHtmlContent("");
 }
 
-void HtmlPreviewPrivate::setHtmlContent(const QString &html)
+void HtmlPreview::showEvent(QShowEvent *event)
+{
+    Q_D(HtmlPreview);
+
+    QWebEngineView::showEvent(event);
+    d->shown = true;
+    d->updateSuspended();
+}
+
+void HtmlPreview::hideEvent(QHideEvent *event)
+{
+    Q_D(HtmlPreview);
+
+    QWebEngineView::hideEvent(event);
+    d->shown = false;
+    d->updateSuspended();
+}
+
+void HtmlPreview::resizeEvent(QResizeEvent *event)
+{
+    Q_D(HtmlPreview);
+
+    QWebEngineView::resizeEvent(event);
+    d->updateSuspended();
+}
+
+void HtmlPreviewPrivate::setHtmlContent(const QString &html, int revision)
 {
-    this->livePreviewHtml.setText(html);
+    exportedHtml = html;
+    exportedRevision = revision;
+
+    QString previewHtml = diagrams->render(html);
+    this->livePreviewHtml.setHtml(previewHtml);
+
+    // Let HTML export of the same revision write out the blocks, which
+    // the document shares with the preview rather than copies.  Blocks
+    // with diagrams are not shared, since which of them have their SVG
+    // yet depends on timing.  The diagram stage returns HTML without
+    // diagrams as is.
+    //
+    if
+    (
+        (revision >= 0)
+        && !html.isEmpty()
+        && (previewHtml.constData() == html.constData())
+    ) {
+        document->setPreviewHtml
+        (
+            livePreviewHtml.blocks(),
+            livePreviewHtml.blockLines(),
+            revision,
+            exporter
+        );
+    } else {
+        document->setPreviewHtml(QStringList(), QVariantList(), -1, nullptr);
+    }
+
+    if (timingHook.isEnabled()) {
+        timing.htmlSent = PreviewTimingHook::now();
+    }
 }
 
 QString HtmlPreviewPrivate::exportToHtml
 (
     const QString &text,
-    Exporter *exporter
-) const
+    Exporter *exporter,
+    QSharedPointer<QAtomicInt> cancelled
+)
 {
+    GW_TRACE_SCOPE("HtmlPreview::exportToHtml");
     QString html;
 
+    // Skip renders that became obsolete while waiting for a thread.
+    if (cancelled->load()) {
+        return html;
+    }
+
     // Enable smart typography for preview, if available for the exporter.
     bool smartTypographyEnabled = exporter->smartTypographyEnabled();
     exporter->setSmartTypographyEnabled(true);
 
     // Export to HTML.
-    exporter->exportToHtml(text, html);
+    exporter->exportToPreviewHtml(text, html);
 
     // Put smart typography setting back to the way it was before
     // so that the last setting used during document export is remembered.
@@ -20,6 +20,8 @@
 #ifndef HTML_PREVIEW_H
 #define HTML_PREVIEW_H
 
+#include <QColor>
+#include <QHash>
 #include <QScopedPointer>
 #include <QString>
 #include <QtWebEngineWidgets>
@@ -27,6 +29,7 @@
 
 #include "exporter.h"
 #include "markdowndocument.h"
+#include "previewtiming.h"
 
 namespace ghostwriter
 {
@@ -61,6 +64,42 @@ public:
      */
     void contextMenuEvent(QContextMenuEvent *event);
 
+    /**
+     * Returns true if the preview is suspended because it is hidden,
+     * minimized, or collapsed to zero size.  Nothing is rendered while the
+     * preview is suspended.  Once it is shown again, the preview renders
+     * the document once to catch up.
+     */
+    bool isSuspended() const;
+
+    /**
+     * Returns the bytes of memory held by the copies of the rendered HTML
+     * kept for patching the page.  The memory used by the page itself
+     * lives in the web engine's process and is not included.
+     */
+    qint64 htmlMemory() const;
+
+    /**
+     * Sets whether the preview times each update through the stages of
+     * the preview pipeline, emitting updateTimed() once the page paints
+     * the update.  Timing is meant for benchmarks and is off by default.
+     */
+    void setTimingEnabled(bool enabled);
+
+signals:
+    /**
+     * Emitted when the preview is suspended or resumed.
+     */
+    void suspendedChanged(bool suspended);
+
+    /**
+     * Emitted while timing is enabled, once the page paints an update.
+     * The times taken by the application are those of the last update
+     * sent to the page, or zero if the page painted the update of its own
+     * accord, such as after loading.
+     */
+    void updateTimed(const PreviewTiming &timing);
+
 public slots:
     /**
      * Call this method to re-render the HTML for the document.
@@ -76,6 +115,15 @@ public slots:
      */
     void navigateToHeading(int headingSequenceNumber);
 
+    /**
+     * Call this method to scroll the preview to the HTML rendered from the
+     * given source line, so that it stays aligned with the editor.  The
+     * fraction of the line number gives how far to scroll past the start
+     * of the line.  Only HTML annotated with source lines can be scrolled
+     * this way.
+     */
+    void scrollToLine(qreal lineNumber);
+
     /**
      * Call this method to set the HTML exporter used in
      * generating HTML from the Markdown document.
@@ -87,8 +135,39 @@ public slots:
      */
     void setStyleSheet(const QString &css);
 
+    /**
+     * Call this method to change the values of the CSS custom properties
+     * used by the style sheet, keyed by property name without the leading
+     * dashes.  Only these values are sent to the page, so that switching
+     * themes does not reload the style sheet.
+     */
+    void setStyleSheetVariables(const QHash<QString, QString> &variables);
+
+    /**
+     * Call this method to set the colors with which Mermaid and Graphviz
+     * diagrams are drawn, which should be those of the style sheet.
+     */
+    void setDiagramColors(const QColor &foreground, const QColor &background);
+
+    /**
+     * Call this method to set how long, in seconds, the preview stays
+     * suspended before it unloads its web page to free memory.  The page
+     * is loaded again when the preview is resumed.
+     */
+    void setIdleTimeout(int seconds);
+
+    /**
+     * Call this method when memory runs low.  If the preview is suspended,
+     * its web page is unloaded right away rather than once the idle
+     * timeout elapses.  A visible preview keeps its page.
+     */
+    void releaseMemory();
+
 protected:
     void closeEvent(QCloseEvent *event);
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+    void resizeEvent(QResizeEvent *event);
 
 private:
     QScopedPointer<HtmlPreviewPrivate> d_ptr;
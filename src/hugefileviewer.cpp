@@ -0,0 +1,378 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLocale>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSharedPointer>
+#include <QSplitter>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "appsettings.h"
+#include "htmlpreview.h"
+#include "hugefileviewer.h"
+#include "mappedtextfile.h"
+#include "markdowndocument.h"
+#include "markdowneditor.h"
+#include "messageboxhelper.h"
+#include "taskscheduler.h"
+
+namespace ghostwriter
+{
+class HugeFileViewerPrivate
+{
+    Q_DECLARE_PUBLIC(HugeFileViewer)
+
+public:
+    HugeFileViewerPrivate(HugeFileViewer *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~HugeFileViewerPrivate()
+    {
+        ;
+    }
+
+    HugeFileViewer *q_ptr;
+
+    QSharedPointer<MappedTextFile> file;
+    TaskScheduler::CancellationToken token;
+    QFutureWatcher<bool> *indexWatcher;
+    bool indexed;
+
+    MarkdownEditor *editor;
+    QScrollBar *scrollBar;
+    QPushButton *previewButton;
+    QLabel *statusLabel;
+    QSplitter *splitter;
+    HtmlPreview *preview;
+    QString previewCss;
+    QHash<QString, QString> previewCssVariables;
+
+    // Coalesces the scrolling of an event loop turn into a single
+    // materialization of the lines in view.
+    QTimer *materializeTimer;
+
+    int shownFirstLine;
+    int shownLineCount;
+
+    int visibleLineCount() const;
+    void updateScrollRange();
+    void materialize();
+    void onIndexed();
+    void showPreview(bool visible);
+};
+
+HugeFileViewer::HugeFileViewer
+(
+    const QString &filePath,
+    const ColorScheme &colors,
+    QWidget *parent
+)
+    : QWidget(parent, Qt::Window),
+      d_ptr(new HugeFileViewerPrivate(this))
+{
+    Q_D(HugeFileViewer);
+
+    this->setAttribute(Qt::WA_DeleteOnClose);
+    this->setWindowTitle(tr("%1 (read-only)").arg(QFileInfo(filePath).fileName()));
+
+    d->file = QSharedPointer<MappedTextFile>(new MappedTextFile(filePath));
+    d->token = TaskScheduler::createCancellationToken();
+    d->indexed = false;
+    d->preview = nullptr;
+    d->shownFirstLine = -1;
+    d->shownLineCount = 0;
+
+    MarkdownDocument *document = new MarkdownDocument();
+    d->editor = new MarkdownEditor(document, colors);
+    document->setParent(d->editor);
+    d->editor->setReadOnly(true);
+    d->editor->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    d->editor->setFont(AppSettings::instance()->editorFont().family(), AppSettings::instance()->editorFont().pointSize());
+    d->editor->setSpellCheckEnabled(false);
+    d->editor->viewport()->installEventFilter(this);
+    d->editor->installEventFilter(this);
+
+    d->scrollBar = new QScrollBar(Qt::Vertical);
+    d->scrollBar->setRange(0, 0);
+    d->scrollBar->setSingleStep(3);
+
+    d->statusLabel = new QLabel(tr("Indexing %1...").arg(QDir::toNativeSeparators(filePath)));
+
+    d->previewButton = new QPushButton(tr("Preview"));
+    d->previewButton->setCheckable(true);
+    d->previewButton->setChecked(false);
+
+    QHBoxLayout *statusLayout = new QHBoxLayout();
+    statusLayout->addWidget(d->statusLabel, 1);
+    statusLayout->addWidget(d->previewButton);
+
+    QWidget *editorPane = new QWidget();
+    QHBoxLayout *editorLayout = new QHBoxLayout();
+    editorLayout->setContentsMargins(0, 0, 0, 0);
+    editorLayout->setSpacing(0);
+    editorLayout->addWidget(d->editor, 1);
+    editorLayout->addWidget(d->scrollBar);
+    editorPane->setLayout(editorLayout);
+
+    d->splitter = new QSplitter(Qt::Horizontal);
+    d->splitter->addWidget(editorPane);
+
+    QVBoxLayout *layout = new QVBoxLayout();
+    layout->addWidget(d->splitter, 1);
+    layout->addLayout(statusLayout);
+    this->setLayout(layout);
+
+    d->materializeTimer = new QTimer(this);
+    d->materializeTimer->setSingleShot(true);
+    d->materializeTimer->setInterval(0);
+
+    this->connect
+    (
+        d->materializeTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->materialize();
+        }
+    );
+
+    this->connect
+    (
+        d->scrollBar,
+        &QScrollBar::valueChanged,
+        [d]() {
+            d->materializeTimer->start();
+        }
+    );
+
+    this->connect
+    (
+        d->previewButton,
+        &QPushButton::toggled,
+        [d](bool checked) {
+            d->showPreview(checked);
+        }
+    );
+
+    QString err;
+
+    if (!d->file->open(err)) {
+        d->statusLabel->setText(tr("Could not open %1: %2").arg(QDir::toNativeSeparators(filePath)).arg(err));
+        return;
+    }
+
+    d->indexWatcher = new QFutureWatcher<bool>(this);
+
+    this->connect
+    (
+        d->indexWatcher,
+        &QFutureWatcher<bool>::finished,
+        [d]() {
+            d->onIndexed();
+        }
+    );
+
+    QSharedPointer<MappedTextFile> file = d->file;
+    TaskScheduler::CancellationToken token = d->token;
+
+    d->indexWatcher->setFuture
+    (
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Interactive,
+            [file, token]() {
+                return file->buildIndex(token);
+            },
+            token
+        )
+    );
+}
+
+HugeFileViewer::~HugeFileViewer()
+{
+    Q_D(HugeFileViewer);
+
+    // The worker holds its own reference to the file, so it only needs to
+    // be told to stop.
+    TaskScheduler::cancel(d->token);
+}
+
+void HugeFileViewer::setPreviewStyleSheet
+(
+    const QString &css,
+    const QHash<QString, QString> &variables
+)
+{
+    Q_D(HugeFileViewer);
+
+    d->previewCss = css;
+    d->previewCssVariables = variables;
+
+    if (nullptr != d->preview) {
+        d->preview->setStyleSheetVariables(variables);
+        d->preview->setStyleSheet(css);
+    }
+}
+
+bool HugeFileViewer::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_D(HugeFileViewer);
+
+    // The editor only holds the lines in view, so scrolling it is scrolling
+    // through the file.
+    if ((watched == d->editor->viewport()) && (QEvent::Wheel == event->type())) {
+        QCoreApplication::sendEvent(d->scrollBar, event);
+        return true;
+    }
+
+    if ((watched == d->editor) && (QEvent::KeyPress == event->type())) {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+        bool control = keyEvent->modifiers() & Qt::ControlModifier;
+
+        switch (keyEvent->key()) {
+            case Qt::Key_PageDown:
+                d->scrollBar->triggerAction(QAbstractSlider::SliderPageStepAdd);
+                return true;
+            case Qt::Key_PageUp:
+                d->scrollBar->triggerAction(QAbstractSlider::SliderPageStepSub);
+                return true;
+            case Qt::Key_Home:
+                if (control) {
+                    d->scrollBar->triggerAction(QAbstractSlider::SliderToMinimum);
+                    return true;
+                }
+                break;
+            case Qt::Key_End:
+                if (control) {
+                    d->scrollBar->triggerAction(QAbstractSlider::SliderToMaximum);
+                    return true;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return QWidget::eventFilter(watched, event);
+}
+
+void HugeFileViewer::resizeEvent(QResizeEvent *event)
+{
+    Q_D(HugeFileViewer);
+
+    QWidget::resizeEvent(event);
+    d->updateScrollRange();
+    d->materializeTimer->start();
+}
+
+int HugeFileViewerPrivate::visibleLineCount() const
+{
+    int lineHeight = qMax(editor->fontMetrics().lineSpacing(), 1);
+    return qMax(editor->viewport()->height() / lineHeight, 1) + 1;
+}
+
+void HugeFileViewerPrivate::updateScrollRange()
+{
+    if (!indexed) {
+        return;
+    }
+
+    int visible = visibleLineCount();
+    scrollBar->setPageStep(visible);
+    scrollBar->setRange(0, qMax(file->lineCount() - visible + 1, 0));
+}
+
+void HugeFileViewerPrivate::materialize()
+{
+    if (!indexed) {
+        return;
+    }
+
+    int first = scrollBar->value();
+    int count = visibleLineCount();
+
+    if ((first == shownFirstLine) && (count == shownLineCount)) {
+        return;
+    }
+
+    shownFirstLine = first;
+    shownLineCount = count;
+
+    editor->setPlainText(file->lines(first, count));
+
+    int last = qMin(first + count, file->lineCount());
+    QLocale locale;
+
+    statusLabel->setText
+    (
+        HugeFileViewer::tr("Lines %1 to %2 of %3")
+            .arg(locale.toString(first + 1))
+            .arg(locale.toString(last))
+            .arg(locale.toString(file->lineCount()))
+    );
+
+    if ((nullptr != preview) && preview->isVisible()) {
+        preview->updatePreview();
+    }
+}
+
+void HugeFileViewerPrivate::onIndexed()
+{
+    if (indexWatcher->isCanceled() || !indexWatcher->result()) {
+        return;
+    }
+
+    indexed = true;
+    updateScrollRange();
+    materialize();
+}
+
+void HugeFileViewerPrivate::showPreview(bool visible)
+{
+    if (visible && (nullptr == preview)) {
+        preview = new HtmlPreview
+        (
+            editor->document(),
+            AppSettings::instance()->currentHtmlExporter()
+        );
+        preview->setStyleSheetVariables(previewCssVariables);
+        preview->setStyleSheet(previewCss);
+        splitter->addWidget(preview);
+    }
+
+    if (nullptr != preview) {
+        preview->setVisible(visible);
+
+        if (visible) {
+            preview->updatePreview();
+        }
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,82 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef HUGE_FILE_VIEWER_H
+#define HUGE_FILE_VIEWER_H
+
+#include <QHash>
+#include <QScopedPointer>
+#include <QString>
+#include <QWidget>
+
+#include "colorscheme.h"
+
+namespace ghostwriter
+{
+/**
+ * Read-only window for viewing files too large to open in the editor, such
+ * as generated exports of hundreds of megabytes.  The file is mapped into
+ * memory and indexed by line on a worker thread.  Only the lines in view
+ * are decoded into a small document, which is highlighted and, if the
+ * preview is shown, rendered as HTML, so that memory use stays
+ * proportional to the window rather than to the file.
+ */
+class HugeFileViewerPrivate;
+class HugeFileViewer : public QWidget
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(HugeFileViewer)
+
+public:
+    /**
+     * Constructor.  Takes the path of the file to view and the colors with
+     * which to highlight it.  The window deletes itself when closed.
+     */
+    HugeFileViewer
+    (
+        const QString &filePath,
+        const ColorScheme &colors,
+        QWidget *parent = nullptr
+    );
+
+    /**
+     * Destructor.
+     */
+    virtual ~HugeFileViewer();
+
+    /**
+     * Sets the style sheet and its variables with which the preview is
+     * shown.
+     */
+    void setPreviewStyleSheet
+    (
+        const QString &css,
+        const QHash<QString, QString> &variables
+    );
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event);
+    void resizeEvent(QResizeEvent *event);
+
+private:
+    QScopedPointer<HugeFileViewerPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // HUGE_FILE_VIEWER_H
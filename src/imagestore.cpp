@@ -0,0 +1,274 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QStandardPaths>
+
+#include "imagestore.h"
+#include "taskscheduler.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+// Images smaller than this many bytes load quickly enough to display as
+// they are, whatever their resolution.
+static const qint64 MinThumbnailFileSize = 512 * 1024;
+
+// Cache keys of the thumbnails being made, and of the images found not to
+// need one.
+static QMutex thumbnailMutex;
+static QSet<QString> pendingThumbnails;
+static QSet<QString> fullSizeImages;
+
+//
+// Returns whether images of the given format are best left untouched,
+// as downscaling would drop their animation or their scalability.
+//
+static bool isCopiedAsIs(const QString &suffix)
+{
+    return ("gif" == suffix) || ("svg" == suffix);
+}
+
+//
+// Returns the given size scaled down to the given width, keeping its
+// aspect ratio.
+//
+static QSize scaledToWidth(const QSize &size, int width)
+{
+    return QSize(width, qMax(1, qRound(size.height() * (qreal(width) / size.width()))));
+}
+
+static QString thumbnailDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + "/thumbnails";
+}
+
+//
+// Downscales the given image to the given width into the thumbnail cache,
+// under the given key.  Returns false if the image needs no thumbnail or
+// cannot be read.
+//
+static bool makeThumbnail(const QString &imagePath, const QString &key, int width)
+{
+    GW_TRACE_SCOPE("ImageStore::makeThumbnail");
+
+    QImageReader reader(imagePath);
+    reader.setAutoTransform(true);
+    QSize size = reader.size();
+
+    if (!size.isValid() || (size.width() <= width)) {
+        return false;
+    }
+
+    // Decoders such as the JPEG one decode straight to the scaled size,
+    // which is much faster than decoding the full image and scaling it.
+    reader.setScaledSize(scaledToWidth(size, width));
+    QImage image = reader.read();
+
+    if (image.isNull()) {
+        return false;
+    }
+
+    QString dir = thumbnailDir();
+
+    if (!QDir().mkpath(dir)) {
+        return false;
+    }
+
+    bool alpha = image.hasAlphaChannel();
+    QString path = dir + "/" + key + (alpha ? ".png" : ".jpg");
+
+    // Write to a temporary file, renamed once complete, so that the preview
+    // never loads a partly written thumbnail.
+    QString tempPath = path + ".part";
+
+    if (!image.save(tempPath, alpha ? "PNG" : "JPG", alpha ? -1 : 85)) {
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    QFile::remove(path);
+    return QFile::rename(tempPath, path);
+}
+
+bool ImageStore::isImageFile(const QString &path)
+{
+    static const QStringList extensions =
+    {
+        "jpg", "jpeg", "gif", "bmp", "png", "tif", "tiff", "svg"
+    };
+
+    return extensions.contains(QFileInfo(path).suffix().toLower());
+}
+
+QString ImageStore::importImage
+(
+    const QString &sourcePath,
+    const QString &assetsDir,
+    int maxWidth,
+    QString &err
+)
+{
+    GW_TRACE_SCOPE("ImageStore::importImage");
+
+    QFileInfo source(sourcePath);
+
+    if (!source.isFile()) {
+        err = QCoreApplication::translate("ImageStore", "%1 does not exist.")
+            .arg(QDir::toNativeSeparators(sourcePath));
+        return QString();
+    }
+
+    QDir dir(assetsDir);
+
+    if (!dir.mkpath(".")) {
+        err = QCoreApplication::translate("ImageStore", "Could not create folder %1.")
+            .arg(QDir::toNativeSeparators(assetsDir));
+        return QString();
+    }
+
+    QString suffix = source.suffix().toLower();
+    QImage image;
+
+    if ((maxWidth > 0) && !isCopiedAsIs(suffix)) {
+        QImageReader reader(sourcePath);
+        reader.setAutoTransform(true);
+        QSize size = reader.size();
+
+        if (size.isValid() && (size.width() > maxWidth)) {
+            reader.setScaledSize(scaledToWidth(size, maxWidth));
+            image = reader.read();
+        }
+    }
+
+    // Formats that Qt reads but cannot write are downscaled to PNG.
+    if (!image.isNull() && !QImageWriter::supportedImageFormats().contains(suffix.toLatin1())) {
+        suffix = "png";
+    }
+
+    QString baseName = source.completeBaseName();
+    QString targetPath = dir.filePath(baseName + "." + suffix);
+
+    for (int i = 1; QFileInfo::exists(targetPath); i++) {
+        targetPath = dir.filePath(QString("%1-%2.%3").arg(baseName).arg(i).arg(suffix));
+    }
+
+    bool written = image.isNull()
+        ? QFile::copy(sourcePath, targetPath)
+        : image.save(targetPath, nullptr, 90);
+
+    if (!written) {
+        QFile::remove(targetPath);
+        err = QCoreApplication::translate("ImageStore", "Could not write %1.")
+            .arg(QDir::toNativeSeparators(targetPath));
+        return QString();
+    }
+
+    err = QString();
+    return targetPath;
+}
+
+QString ImageStore::thumbnail(const QString &imagePath, int width)
+{
+    QFileInfo info(imagePath);
+
+    if
+    (
+        (width <= 0)
+        || isCopiedAsIs(info.suffix().toLower())
+        || !info.isFile()
+        || (info.size() < MinThumbnailFileSize)
+    ) {
+        return QString();
+    }
+
+    QString key = QString::fromLatin1
+        (
+            QCryptographicHash::hash
+            (
+                QString("%1\n%2\n%3\n%4")
+                    .arg(info.absoluteFilePath())
+                    .arg(info.size())
+                    .arg(info.lastModified().toMSecsSinceEpoch())
+                    .arg(width)
+                    .toUtf8(),
+                QCryptographicHash::Sha1
+            ).toHex()
+        );
+
+    {
+        QMutexLocker locker(&thumbnailMutex);
+
+        if (fullSizeImages.contains(key) || pendingThumbnails.contains(key)) {
+            return QString();
+        }
+    }
+
+    QString path = thumbnailDir() + "/" + key;
+
+    if (QFileInfo::exists(path + ".jpg")) {
+        return path + ".jpg";
+    }
+
+    if (QFileInfo::exists(path + ".png")) {
+        return path + ".png";
+    }
+
+    {
+        QMutexLocker locker(&thumbnailMutex);
+
+        if (pendingThumbnails.contains(key)) {
+            return QString();
+        }
+
+        pendingThumbnails.insert(key);
+    }
+
+    QString absolutePath = info.absoluteFilePath();
+
+    TaskScheduler::instance()->run
+    (
+        TaskScheduler::Preview,
+        [absolutePath, key, width]() {
+            bool made = makeThumbnail(absolutePath, key, width);
+
+            QMutexLocker locker(&thumbnailMutex);
+            pendingThumbnails.remove(key);
+
+            if (!made) {
+                fullSizeImages.insert(key);
+            }
+        }
+    );
+
+    return QString();
+}
+} // namespace ghostwriter
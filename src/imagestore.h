@@ -0,0 +1,79 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef IMAGE_STORE_H
+#define IMAGE_STORE_H
+
+#include <QString>
+
+namespace ghostwriter
+{
+/**
+ * Copies images into a document's assets folder, and keeps a disk cache
+ * of downscaled copies of large images for display in the live preview,
+ * so that the preview does not decode full resolution camera photos with
+ * every update.
+ *
+ * This class may be used from any thread.
+ */
+class ImageStore
+{
+public:
+    /**
+     * Returns true if the given file path has the extension of an image
+     * format that can be inserted into a document.
+     */
+    static bool isImageFile(const QString &path);
+
+    /**
+     * Copies the image at the given source path into the given assets
+     * folder, creating the folder if needed, and returns the path of the
+     * copy.  If maxWidth is greater than zero, images wider than it are
+     * downscaled to that width instead of copied.  Animated and vector
+     * images are always copied.  An existing file of the same name is
+     * never overwritten; a numbered name is used instead.
+     *
+     * Returns a null string and sets err on failure.  This method blocks,
+     * and is meant to run on a worker thread.
+     */
+    static QString importImage
+    (
+        const QString &sourcePath,
+        const QString &assetsDir,
+        int maxWidth,
+        QString &err
+    );
+
+    /**
+     * Returns the path of the cached copy of the given local image,
+     * downscaled to the given width, or a null string if the image is
+     * small enough to display as is or if its copy is not cached yet.
+     * In the latter case, the copy is made in the background, ready for
+     * the next time that the image is displayed.  Copies are tied to the
+     * size and modification time of the image, so that an edited image is
+     * downscaled again.
+     */
+    static QString thumbnail(const QString &imagePath, int width);
+
+private:
+    ImageStore();
+};
+} // namespace ghostwriter
+
+#endif // IMAGE_STORE_H
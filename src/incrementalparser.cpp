@@ -0,0 +1,280 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <QTextBlock>
+
+#include "cmarkgfmapi.h"
+#include "incrementalparser.h"
+#include "markdowndocument.h"
+#include "markdownnode.h"
+#include "referenceindex.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+IncrementalParser::IncrementalParser(MarkdownDocument *document)
+    : document(document),
+      lastRemovalCount(document->referenceIndex()->removalCount())
+{
+    ;
+}
+
+IncrementalParser::~IncrementalParser()
+{
+    ;
+}
+
+void IncrementalParser::findEdit
+(
+    int position,
+    int charsAdded,
+    int oldBlockCount,
+    Region &region
+)
+{
+    region.oldBlockCount = oldBlockCount;
+    region.lineDelta = document->blockCount() - oldBlockCount;
+
+    // Determine the lines that were edited, both in terms of the new
+    // and the old document text.
+    region.editStartLine = document->findBlock(position).blockNumber() + 1;
+    region.editEndLine = document->findBlock(position + charsAdded).blockNumber() + 1;
+    region.oldEditEndLine = region.editEndLine - region.lineDelta;
+
+    // The removed text is gone by now, but the reference index, which sees
+    // the edit first, counts the definitions and references that went
+    // with it.
+    int removalCount = document->referenceIndex()->removalCount();
+    region.referencesRemoved = (removalCount != lastRemovalCount);
+    lastRemovalCount = removalCount;
+
+    region.firstLine = -1;
+    region.lastLine = -1;
+    region.oldLastLine = -1;
+    region.guard = nullptr;
+}
+
+bool IncrementalParser::findRegion(Region &region) const
+{
+    MarkdownAST *ast = document->markdownAST();
+
+    if
+    (
+        (nullptr == ast)
+        || (nullptr == ast->root())
+        || ast->needsCompaction()
+        || region.referencesRemoved
+        || (region.editStartLine < 1)
+        || (region.oldEditEndLine < region.editStartLine)
+    ) {
+        return false;
+    }
+
+    // Find the top-level blocks to re-parse.  Include the block before the
+    // one containing the edit, since edits can merge paragraphs, turn a
+    // paragraph into a setext heading, etc.  Likewise, include the first
+    // block following the edit as a guard to verify that the edit did not
+    // change how the rest of the document is parsed (i.e., by opening a
+    // fenced code block).  The footnote definitions, which cmark-gfm moves
+    // to the end of the document, are left out.
+    //
+    const MarkdownNode *first = nullptr;
+    const MarkdownNode *guard = nullptr;
+
+    for (const MarkdownNode *node = ast->root()->firstChild(); nullptr != node; node = node->next()) {
+        if (MarkdownNode::FootnoteDefinition == node->type()) {
+            break;
+        }
+
+        if (node->startLine() <= region.editStartLine) {
+            first = node;
+        } else if (node->startLine() > region.oldEditEndLine) {
+            guard = node;
+            break;
+        }
+    }
+
+    if ((nullptr != first) && (nullptr != first->previous())) {
+        first = first->previous();
+    }
+
+    // Make sure the region starts right after a blank line so that the
+    // text preceding it can't be lazily continued into it.
+    while ((nullptr != first) && !isBlankLine(first->startLine() - 1)) {
+        first = first->previous();
+    }
+
+    // Find where the first footnote definition starts in the text.
+    int footnotesLine = -1;
+
+    for (const MarkdownNode *node = ast->root()->lastChild(); nullptr != node; node = node->previous()) {
+        if (MarkdownNode::FootnoteDefinition != node->type()) {
+            break;
+        }
+
+        if ((footnotesLine < 0) || (node->startLine() < footnotesLine)) {
+            footnotesLine = node->startLine();
+        }
+    }
+
+    int firstLine = (nullptr != first) ? first->startLine() : 1;
+    int oldLastLine = region.oldBlockCount;
+
+    if (nullptr != guard) {
+        const MarkdownNode *following = guard->next();
+
+        if ((nullptr != following) && (MarkdownNode::FootnoteDefinition != following->type())) {
+            oldLastLine = following->startLine() - 1;
+        }
+
+        if ((footnotesLine > guard->startLine()) && (footnotesLine <= oldLastLine)) {
+            oldLastLine = footnotesLine - 1;
+        }
+    }
+
+    // The footnote definitions are not in the text order of the other
+    // blocks, so only splice regions that they all follow.
+    if ((footnotesLine > 0) && (footnotesLine <= oldLastLine)) {
+        return false;
+    }
+
+    int lastLine = oldLastLine + region.lineDelta;
+
+    // Don't bother with splicing if most of the document would be
+    // re-parsed anyway.
+    if
+    (
+        (firstLine < 1)
+        || (lastLine < firstLine)
+        || ((lastLine - firstLine) > (document->blockCount() / 2))
+    ) {
+        return false;
+    }
+
+    // The region is parsed without the link reference and footnote
+    // definitions of the rest of the document, so parse the whole
+    // document instead if the region depends on them, or if it has
+    // definitions of its own that the rest of the document may use.
+    //
+    if (involvesReferences(firstLine, lastLine)) {
+        return false;
+    }
+
+    region.firstLine = firstLine;
+    region.lastLine = lastLine;
+    region.oldLastLine = oldLastLine;
+    region.guard = guard;
+
+    return true;
+}
+
+bool IncrementalParser::splice
+(
+    const Region &region,
+    bool smartTypographyEnabled,
+    QVector<MarkdownAST::LineRange> &changes
+)
+{
+    GW_TRACE_SCOPE("IncrementalParser::splice");
+
+    MarkdownAST *ast = document->markdownAST();
+    QTextBlock lastBlock = document->findBlockByNumber(region.lastLine - 1);
+
+    if (!lastBlock.isValid()) {
+        lastBlock = document->lastBlock();
+    }
+
+    CmarkGfmAPI::instance()->parse
+    (
+        document->findBlockByNumber(region.firstLine - 1),
+        lastBlock,
+        smartTypographyEnabled,
+        &fragmentAST
+    );
+
+    // Verify that the guard block parsed the same as before.  If not, the
+    // edit changed the structure of the text following it as well.
+    if (nullptr != region.guard) {
+        const MarkdownNode *guard = region.guard;
+        const MarkdownNode *newGuard = nullptr;
+        int guardStartLine = guard->startLine() + region.lineDelta - region.firstLine + 1;
+
+        if (nullptr != fragmentAST.root()) {
+            newGuard = fragmentAST.root()->lastChild();
+        }
+
+        if
+        (
+            (nullptr == newGuard)
+            || (newGuard->type() != guard->type())
+            || (newGuard->startLine() != guardStartLine)
+            || (newGuard->endLine() != (guard->endLine() - guard->startLine() + guardStartLine))
+        ) {
+            return false;
+        }
+    }
+
+    changes = ast->replaceBlocks(region.firstLine, region.oldLastLine, region.lineDelta, &fragmentAST);
+    return true;
+}
+
+MarkdownAST *IncrementalParser::fragment()
+{
+    return &fragmentAST;
+}
+
+bool IncrementalParser::isBlankLine(int lineNumber) const
+{
+    if (lineNumber < 1) {
+        return true;
+    }
+
+    QTextBlock block = document->findBlockByNumber(lineNumber - 1);
+
+    return !block.isValid() || block.text().trimmed().isEmpty();
+}
+
+bool IncrementalParser::involvesReferences(int firstLine, int lastLine) const
+{
+    const ReferenceIndex *index = document->referenceIndex();
+    QTextBlock block = document->findBlockByNumber(firstLine - 1);
+
+    for (int line = firstLine; block.isValid() && (line <= lastLine); line++) {
+        QString text = block.text();
+
+        // Most lines have no brackets at all.
+        if (text.contains('[')) {
+            if (!ReferenceIndex::parseDefinition(text).isNull()) {
+                return true;
+            }
+
+            for (const ReferenceIndex::Reference &reference : ReferenceIndex::parseReferences(text)) {
+                if ((nullptr == index) || index->isDefined(reference.label)) {
+                    return true;
+                }
+            }
+        }
+
+        block = block.next();
+    }
+
+    return false;
+}
+} // namespace ghostwriter
@@ -0,0 +1,173 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef INCREMENTAL_PARSER_H
+#define INCREMENTAL_PARSER_H
+
+#include <QVector>
+
+#include "markdownast.h"
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+class MarkdownNode;
+
+/**
+ * Re-parses only the top-level blocks of a document surrounding an edit,
+ * and splices the result into the document's AST, so that the AST agrees
+ * with a full parse of the edited text without the cost of one.
+ *
+ * An edit is spliced in three steps, so that the caller can decide in
+ * between whether to go on:  findEdit() finds the lines that the edit
+ * touched, findRegion() finds the top-level blocks to re-parse, and
+ * splice() re-parses them and replaces them in the AST.  The last two
+ * return false whenever the edit might affect the document beyond the
+ * re-parsed blocks, in which case the whole document must be parsed
+ * instead.  That is the case when the edit involves link reference or
+ * footnote definitions, or references to them, including those that the
+ * edit removed.
+ *
+ * Since QTextBlock is not thread-safe, only use this class from the GUI
+ * thread.
+ */
+class IncrementalParser
+{
+public:
+    /**
+     * Lines of an edit, and of the top-level blocks to re-parse for it.
+     * Line numbers are one-based.
+     */
+    struct Region
+    {
+        /**
+         * Line count of the document as of the last parse.
+         */
+        int oldBlockCount;
+
+        /**
+         * Number of lines the edit added (or removed, if negative).
+         */
+        int lineDelta;
+
+        /**
+         * Lines that were edited, in terms of the new text, and the last
+         * of them in terms of the old text.
+         */
+        int editStartLine;
+        int editEndLine;
+        int oldEditEndLine;
+
+        /**
+         * Whether a link reference or footnote definition, or a reference
+         * to one, was removed since the previous edit.
+         */
+        bool referencesRemoved;
+
+        /**
+         * Lines to re-parse, in terms of the new text, and the last of them
+         * in terms of the old text.
+         */
+        int firstLine;
+        int lastLine;
+        int oldLastLine;
+
+        /**
+         * First top-level block of the AST following the edit, if any,
+         * which is re-parsed as well to verify that the edit did not change
+         * how the rest of the document is parsed.
+         */
+        const MarkdownNode *guard;
+    };
+
+    /**
+     * Constructor.  Parses edits of the given document into its AST.
+     */
+    explicit IncrementalParser(MarkdownDocument *document);
+
+    /**
+     * Destructor.
+     */
+    ~IncrementalParser();
+
+    /**
+     * Fills in the edited lines of the region for the edit at the given
+     * position, as given by QTextDocument::contentsChange(), given the
+     * line count of the document as of the last parse.  Call this method
+     * for every edit, even those that are not to be parsed, so that the
+     * definitions and references removed by each edit are accounted for.
+     */
+    void findEdit(int position, int charsAdded, int oldBlockCount, Region &region);
+
+    /**
+     * Fills in the lines to re-parse for the edit found by findEdit().
+     * Returns false if the edit cannot be spliced into the document's
+     * AST, in which case the whole document must be parsed.
+     */
+    bool findRegion(Region &region) const;
+
+    /**
+     * Re-parses the lines of the region found by findRegion() and replaces
+     * them in the document's AST, setting changes to the ranges of lines
+     * whose block structure changed.  The AST is only changed in place, so
+     * that it is up to the caller to hand it back to the document.  Returns
+     * false, without changing the AST, if the edit changed how the text
+     * following it is parsed, in which case the whole document must be
+     * parsed.
+     */
+    bool splice
+    (
+        const Region &region,
+        bool smartTypographyEnabled,
+        QVector<MarkdownAST::LineRange> &changes
+    );
+
+    /**
+     * Returns the AST of the lines last re-parsed by splice(), whose line
+     * numbers are relative to the first of them.
+     */
+    MarkdownAST *fragment();
+
+private:
+    MarkdownDocument *document;
+
+    // Removal count of the document's ReferenceIndex as of the last edit.
+    int lastRemovalCount;
+
+    // Scratch AST for the re-parsed lines.  It is re-used between edits so
+    // that its arena keeps its memory rather than being reallocated on
+    // every keystroke.
+    MarkdownAST fragmentAST;
+
+    /*
+    * Returns whether the given line is blank or out of the document.
+    */
+    bool isBlankLine(int lineNumber) const;
+
+    /*
+    * Returns whether the given range of lines (inclusive) refers to a link
+    * reference or footnote definition of the document, or has a
+    * definition.
+    */
+    bool involvesReferences(int firstLine, int lastLine) const;
+};
+} // namespace ghostwriter
+
+#endif // INCREMENTAL_PARSER_H
@@ -0,0 +1,198 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QApplication>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QVBoxLayout>
+
+#include "headingindex.h"
+#include "jumpdialog.h"
+#include "markdowneditor.h"
+
+namespace ghostwriter
+{
+class JumpDialogPrivate
+{
+    Q_DECLARE_PUBLIC(JumpDialog)
+
+public:
+    JumpDialogPrivate(JumpDialog *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~JumpDialogPrivate()
+    {
+        ;
+    }
+
+    // Most headings listed at once.  More specific queries narrow the
+    // results down from there.
+    static const int MaxResults = 100;
+
+    static const int DOCUMENT_POSITION_ROLE;
+
+    JumpDialog *q_ptr;
+    QPointer<MarkdownEditor> editor;
+    HeadingIndex *index;
+    QLineEdit *queryEdit;
+    QListWidget *resultList;
+
+    /*
+    * Lists the line or the headings matching the query.
+    */
+    void search(const QString &query);
+
+    /*
+    * Jumps to the position of the given result, and closes the dialog.
+    */
+    void jump(QListWidgetItem *item);
+};
+
+const int JumpDialogPrivate::DOCUMENT_POSITION_ROLE = Qt::UserRole + 1;
+
+JumpDialog::JumpDialog(MarkdownEditor *editor, HeadingIndex *index, QWidget *parent)
+    : QDialog(parent, Qt::Popup),
+      d_ptr(new JumpDialogPrivate(this))
+{
+    Q_D(JumpDialog);
+
+    d->editor = editor;
+    d->index = index;
+
+    d->queryEdit = new QLineEdit();
+    d->queryEdit->setPlaceholderText(tr("Go to heading, or to :line"));
+    d->queryEdit->setClearButtonEnabled(true);
+    d->queryEdit->installEventFilter(this);
+
+    d->resultList = new QListWidget();
+    d->resultList->setAlternatingRowColors(false);
+    d->resultList->setUniformItemSizes(true);
+    d->resultList->setFocusPolicy(Qt::NoFocus);
+
+    QVBoxLayout *layout = new QVBoxLayout();
+    layout->addWidget(d->queryEdit);
+    layout->addWidget(d->resultList);
+    this->setLayout(layout);
+
+    this->connect
+    (
+        d->queryEdit,
+        &QLineEdit::textChanged,
+        [d](const QString &query) {
+            d->search(query);
+        }
+    );
+    this->connect
+    (
+        d->queryEdit,
+        &QLineEdit::returnPressed,
+        [d]() {
+            d->jump(d->resultList->currentItem());
+        }
+    );
+    this->connect
+    (
+        d->resultList,
+        &QListWidget::itemClicked,
+        [d](QListWidgetItem *item) {
+            d->jump(item);
+        }
+    );
+
+    d->search(QString());
+    d->queryEdit->setFocus();
+}
+
+JumpDialog::~JumpDialog()
+{
+    ;
+}
+
+bool JumpDialog::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_D(JumpDialog);
+
+    if ((watched == d->queryEdit) && (QEvent::KeyPress == event->type())) {
+        switch (static_cast<QKeyEvent *>(event)->key()) {
+        case Qt::Key_Up:
+        case Qt::Key_Down:
+        case Qt::Key_PageUp:
+        case Qt::Key_PageDown:
+            QApplication::sendEvent(d->resultList, event);
+            return true;
+        default:
+            break;
+        }
+    }
+
+    return QDialog::eventFilter(watched, event);
+}
+
+void JumpDialogPrivate::search(const QString &query)
+{
+    static const QRegularExpression lineRegex("^\\s*:\\s*(\\d+)\\s*$");
+
+    resultList->clear();
+
+    if (!editor) {
+        return;
+    }
+
+    QRegularExpressionMatch lineMatch = lineRegex.match(query);
+
+    if (lineMatch.hasMatch()) {
+        QTextDocument *document = editor->document();
+        int line = qBound(1, lineMatch.captured(1).toInt(), document->blockCount());
+        QListWidgetItem *item = new QListWidgetItem(JumpDialog::tr("Line %1").arg(line));
+
+        item->setData(DOCUMENT_POSITION_ROLE, document->findBlockByNumber(line - 1).position());
+        resultList->addItem(item);
+    } else {
+        for (const HeadingIndex::Match &match : index->search(query, MaxResults)) {
+            QListWidgetItem *item = new QListWidgetItem
+            (
+                QString(4 * (match.level - 1), ' ') + match.text
+            );
+
+            item->setData(DOCUMENT_POSITION_ROLE, match.block.position());
+            resultList->addItem(item);
+        }
+    }
+
+    resultList->setCurrentRow(0);
+}
+
+void JumpDialogPrivate::jump(QListWidgetItem *item)
+{
+    Q_Q(JumpDialog);
+
+    if ((nullptr != item) && editor) {
+        editor->navigateDocument(item->data(DOCUMENT_POSITION_ROLE).toInt());
+        editor->centerCursor();
+    }
+
+    q->accept();
+}
+} // namespace ghostwriter
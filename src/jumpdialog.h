@@ -0,0 +1,67 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef JUMPDIALOG_H
+#define JUMPDIALOG_H
+
+#include <QDialog>
+#include <QScopedPointer>
+
+namespace ghostwriter
+{
+class HeadingIndex;
+class MarkdownEditor;
+
+/**
+ * Palette for jumping to a heading of the document by typing part of it,
+ * or to a line by typing its number after a colon, such as ":120".  The
+ * headings are searched as the query is typed, and choosing one moves the
+ * editor's text cursor to it.
+ */
+class JumpDialogPrivate;
+class JumpDialog : public QDialog
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(JumpDialog)
+
+public:
+    /**
+     * Constructor.  Searches the given index for headings to jump to in the
+     * given editor.
+     */
+    JumpDialog(MarkdownEditor *editor, HeadingIndex *index, QWidget *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~JumpDialog();
+
+protected:
+    /**
+     * Overridden to let the arrow and page keys typed in the query move
+     * the selection of the results.
+     */
+    bool eventFilter(QObject *watched, QEvent *event);
+
+private:
+    QScopedPointer<JumpDialogPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // JUMPDIALOG_H
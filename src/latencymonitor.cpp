@@ -0,0 +1,120 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QStringList>
+
+#include <algorithm>
+
+#include "latencymonitor.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+LatencyMonitor::LatencyMonitor(QObject *parent)
+    : QObject(parent), enabled(false), inputTraceTime(-1), nextSample(0)
+{
+    ;
+}
+
+LatencyMonitor::~LatencyMonitor()
+{
+    ;
+}
+
+void LatencyMonitor::setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+
+    inputTimer.invalidate();
+    samples.clear();
+    nextSample = 0;
+}
+
+bool LatencyMonitor::isEnabled() const
+{
+    return enabled;
+}
+
+void LatencyMonitor::inputReceived()
+{
+    if (!enabled || inputTimer.isValid()) {
+        return;
+    }
+
+    inputTimer.start();
+    inputTraceTime = Tracer::isEnabled() ? Tracer::now() : -1;
+}
+
+void LatencyMonitor::framePainted()
+{
+    if (!inputTimer.isValid()) {
+        return;
+    }
+
+    qint64 latency = inputTimer.elapsed();
+    inputTimer.invalidate();
+
+    if (latency > StaleThreshold) {
+        return;
+    }
+
+    if (samples.size() < WindowSize) {
+        samples.append(latency);
+    } else {
+        samples[nextSample] = latency;
+        nextSample = (nextSample + 1) % WindowSize;
+    }
+
+    if (latency > OutlierThreshold) {
+        QString spans;
+
+        if (inputTraceTime >= 0) {
+            spans = Tracer::mainThreadSpansSince(inputTraceTime).join(", ");
+        }
+
+        qWarning
+        (
+            "Input latency of %lld ms%s%s",
+            latency,
+            spans.isEmpty() ? "" : ", during ",
+            qPrintable(spans)
+        );
+    }
+
+    emit measured();
+}
+
+int LatencyMonitor::sampleCount() const
+{
+    return samples.size();
+}
+
+double LatencyMonitor::percentile(double fraction) const
+{
+    if (samples.isEmpty()) {
+        return 0.0;
+    }
+
+    QVector<qint64> sorted = samples;
+    int index = qMin(sorted.size() - 1, (int) (fraction * sorted.size()));
+
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+} // namespace ghostwriter
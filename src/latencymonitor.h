@@ -0,0 +1,110 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef LATENCY_MONITOR_H
+#define LATENCY_MONITOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Measures input latency:  the time from a key press until the next
+ * frame is painted.  The monitor keeps the most recent measurements, from
+ * which it reports rolling percentiles, and logs each outlier as a
+ * warning.  If tracing is enabled (see Tracer), the warning names the
+ * spans of work that ran on the main thread in between.  The monitor is
+ * disabled by default, in which case each key press and frame costs a
+ * single check.
+ */
+class LatencyMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.
+     */
+    LatencyMonitor(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~LatencyMonitor();
+
+    /**
+     * Enables or disables measuring.  Disabling discards the measurements.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns whether measuring is enabled.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Call when a key press is received.  Key presses received before
+     * the next frame is painted count towards the same measurement.
+     */
+    void inputReceived();
+
+    /**
+     * Call when a frame has finished painting.
+     */
+    void framePainted();
+
+    /**
+     * Returns the number of measurements kept.
+     */
+    int sampleCount() const;
+
+    /**
+     * Returns the given percentile (between 0 and 1) of the measurements
+     * kept, in milliseconds.
+     */
+    double percentile(double fraction) const;
+
+signals:
+    /**
+     * Emitted whenever a measurement is taken.
+     */
+    void measured();
+
+private:
+    // Number of most recent measurements kept.
+    static const int WindowSize = 500;
+
+    // Latency in milliseconds beyond which a measurement is logged.
+    static const int OutlierThreshold = 50;
+
+    // Latency in milliseconds beyond which a key press that was never
+    // followed by a frame, such as a press of a modifier key, is dropped.
+    static const int StaleThreshold = 1000;
+
+    bool enabled;
+    QElapsedTimer inputTimer;
+    qint64 inputTraceTime;
+    QVector<qint64> samples;
+    int nextSample;
+};
+} // namespace ghostwriter
+
+#endif // LATENCY_MONITOR_H
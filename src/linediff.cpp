@@ -0,0 +1,200 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QHash>
+
+#include "linediff.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+QVector<LineDiff::Hunk> LineDiff::compute
+(
+    const QStringList &oldLines,
+    const QStringList &newLines,
+    int maxEdits
+)
+{
+    GW_TRACE_SCOPE("LineDiff::compute");
+
+    QVector<Hunk> hunks;
+    int oldCount = oldLines.size();
+    int newCount = newLines.size();
+    int prefix = 0;
+    int suffix = 0;
+
+    while
+    (
+        (prefix < oldCount)
+        && (prefix < newCount)
+        && (oldLines.at(prefix) == newLines.at(prefix))
+    ) {
+        prefix++;
+    }
+
+    while
+    (
+        (suffix < (oldCount - prefix))
+        && (suffix < (newCount - prefix))
+        && (oldLines.at(oldCount - 1 - suffix) == newLines.at(newCount - 1 - suffix))
+    ) {
+        suffix++;
+    }
+
+    int n = oldCount - prefix - suffix;
+    int m = newCount - prefix - suffix;
+
+    if ((n <= 0) && (m <= 0)) {
+        return hunks;
+    }
+
+    if ((n <= 0) || (m <= 0)) {
+        hunks.append({prefix, n, prefix, m});
+        return hunks;
+    }
+
+    // Compare hashes before comparing the lines themselves, as most lines
+    // differ.
+    QVector<uint> a(n);
+    QVector<uint> b(m);
+
+    for (int i = 0; i < n; i++) {
+        a[i] = qHash(oldLines.at(prefix + i));
+    }
+
+    for (int j = 0; j < m; j++) {
+        b[j] = qHash(newLines.at(prefix + j));
+    }
+
+    // v[offset + k] is the furthest x reached on diagonal k.  The part of
+    // v in use is kept for every edit count d, to trace the path back.
+    int max = qMin(n + m, maxEdits);
+    int offset = max + 1;
+    QVector<int> v(2 * offset + 1, 0);
+    QVector<QVector<int>> trace;
+    int editCount = -1;
+
+    for (int d = 0; (d <= max) && (editCount < 0); d++) {
+        trace.append(v.mid(offset - d, (2 * d) + 1));
+
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+
+            if ((k == -d) || ((k != d) && (v[offset + k - 1] < v[offset + k + 1]))) {
+                x = v[offset + k + 1];
+            } else {
+                x = v[offset + k - 1] + 1;
+            }
+
+            int y = x - k;
+
+            while
+            (
+                (x < n)
+                && (y < m)
+                && (a[x] == b[y])
+                && (oldLines.at(prefix + x) == newLines.at(prefix + y))
+            ) {
+                x++;
+                y++;
+            }
+
+            v[offset + k] = x;
+
+            if ((x >= n) && (y >= m)) {
+                editCount = d;
+                break;
+            }
+        }
+    }
+
+    if (editCount < 0) {
+        hunks.append({prefix, n, prefix, m});
+        return hunks;
+    }
+
+    QVector<bool> removed(n, false);
+    QVector<bool> inserted(m, false);
+    int x = n;
+    int y = m;
+
+    for (int d = editCount; d > 0; d--) {
+        const QVector<int> &previous = trace.at(d);
+        int k = x - y;
+        int previousK;
+
+        if
+        (
+            (k == -d)
+            || ((k != d) && (previous.at(d + k - 1) < previous.at(d + k + 1)))
+        ) {
+            previousK = k + 1;
+        } else {
+            previousK = k - 1;
+        }
+
+        int previousX = previous.at(d + previousK);
+        int previousY = previousX - previousK;
+
+        while ((x > previousX) && (y > previousY)) {
+            x--;
+            y--;
+        }
+
+        if (x == previousX) {
+            inserted[previousY] = true;
+        } else {
+            removed[previousX] = true;
+        }
+
+        x = previousX;
+        y = previousY;
+    }
+
+    // Lines neither removed nor inserted match up in order, so each run
+    // of removed and inserted lines between them makes a hunk.
+    int i = 0;
+    int j = 0;
+
+    while ((i < n) || (j < m)) {
+        if ((i < n) && (j < m) && !removed[i] && !inserted[j]) {
+            i++;
+            j++;
+            continue;
+        }
+
+        int firstOld = i;
+        int firstNew = j;
+
+        while (((i < n) && removed[i]) || ((j < m) && inserted[j])) {
+            while ((i < n) && removed[i]) {
+                i++;
+            }
+
+            while ((j < m) && inserted[j]) {
+                j++;
+            }
+        }
+
+        hunks.append({prefix + firstOld, i - firstOld, prefix + firstNew, j - firstNew});
+    }
+
+    return hunks;
+}
+} // namespace ghostwriter
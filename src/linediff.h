@@ -0,0 +1,68 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef LINE_DIFF_H
+#define LINE_DIFF_H
+
+#include <QStringList>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Computes the differences between two versions of a text, line by line,
+ * so that the old version can be turned into the new one by replacing
+ * only the lines that changed.
+ *
+ * This class may be used from any thread.
+ */
+class LineDiff
+{
+public:
+    /**
+     * Run of lines of the old text replaced by a run of lines of the new
+     * text.  Either run may be empty, for lines that were only inserted or
+     * only removed.
+     */
+    struct Hunk
+    {
+        int oldLine;
+        int oldCount;
+        int newLine;
+        int newCount;
+    };
+
+    /**
+     * Returns the hunks turning the old lines into the new lines, in
+     * order.  Lines common to the start and the end of both texts are
+     * skipped first, and the lines in between are compared with Myers'
+     * algorithm.  Should they differ in more than the given number of
+     * lines, which bounds the time and memory the comparison takes, they
+     * are returned as a single hunk.
+     */
+    static QVector<Hunk> compute
+    (
+        const QStringList &oldLines,
+        const QStringList &newLines,
+        int maxEdits = 1000
+    );
+};
+} // namespace ghostwriter
+
+#endif // LINE_DIFF_H
@@ -0,0 +1,615 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QQueue>
+#include <QSet>
+#include <QTimer>
+#include <QUrl>
+
+#include "linkchecker.h"
+#include "markdownast.h"
+#include "markdowndocument.h"
+#include "markdownnode.h"
+#include "taskscheduler.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+class LinkCheckerPrivate
+{
+    Q_DECLARE_PUBLIC(LinkChecker)
+
+public:
+    // Delay, in milliseconds, after the AST changes before the links are
+    // collected again, so that typing does not rescan the document with
+    // every keystroke.
+    static const int ScanDelay = 1000;
+
+    // Time, in milliseconds, for which the outcomes of checking local paths
+    // and web addresses are trusted.  Local paths are cheap to check, and
+    // are soon checked again so that adding a missing image is noticed.
+    static const qint64 LocalTimeToLive = 30 * 1000;
+    static const qint64 RemoteTimeToLive = 15 * 60 * 1000;
+
+    // Most web addresses requested at once, and the time, in milliseconds,
+    // after which a request is given up on.
+    static const int MaxConcurrentRequests = 4;
+    static const int RequestTimeout = 15 * 1000;
+
+    struct CacheEntry
+    {
+        LinkChecker::Status status;
+        QString message;
+        qint64 checkedAt;
+    };
+
+    LinkCheckerPrivate(LinkChecker *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~LinkCheckerPrivate()
+    {
+        ;
+    }
+
+    LinkChecker *q_ptr;
+    MarkdownDocument *document;
+    bool enabled;
+    bool remoteCheckEnabled;
+    QTimer *scanTimer;
+
+    // Links of the document, along with the cache key of each link's
+    // destination, or an empty key if it cannot be checked.
+    QVector<LinkChecker::Link> links;
+    QVector<QString> keys;
+
+    // Outcomes of the checks, keyed by absolute local path or web address.
+    QHash<QString, CacheEntry> cache;
+    QElapsedTimer clock;
+
+    QFutureWatcher<QHash<QString, bool>> *localWatcher;
+    bool localCheckInProgress;
+
+    // Whether to scan again once the local check in progress finishes.
+    bool scanPending;
+
+    QNetworkAccessManager *network;
+    QQueue<QString> requestQueue;
+
+    // Web addresses queued or being requested.
+    QSet<QString> requestsPending;
+    int activeRequests;
+
+    void scan();
+    void checkLocalPaths(const QStringList &paths);
+    void onLocalCheckFinished();
+    void startRequests();
+    void sendRequest(const QString &url, bool headOnly);
+    void onReplyFinished(QNetworkReply *reply, const QString &url, bool headOnly);
+    void cancelRequests();
+    void updateStatuses();
+    bool isFresh(const QString &key) const;
+    static bool isRemote(const QString &key);
+    static QString cacheKey(const QString &destination, const QString &baseDir);
+};
+
+LinkChecker::LinkChecker(MarkdownDocument *document, QObject *parent)
+    : QObject(parent),
+      d_ptr(new LinkCheckerPrivate(this))
+{
+    Q_D(LinkChecker);
+
+    d->document = document;
+    d->enabled = false;
+    d->remoteCheckEnabled = false;
+    d->localCheckInProgress = false;
+    d->scanPending = false;
+    d->activeRequests = 0;
+    d->clock.start();
+    d->network = new QNetworkAccessManager(this);
+    d->localWatcher = new QFutureWatcher<QHash<QString, bool>>(this);
+
+    d->scanTimer = new QTimer(this);
+    d->scanTimer->setSingleShot(true);
+    d->scanTimer->setInterval(LinkCheckerPrivate::ScanDelay);
+
+    this->connect
+    (
+        d->scanTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->scan();
+        }
+    );
+
+    this->connect
+    (
+        d->localWatcher,
+        &QFutureWatcher<QHash<QString, bool>>::finished,
+        [d]() {
+            d->onLocalCheckFinished();
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::markdownASTChanged,
+        this,
+        [d]() {
+            if (d->enabled) {
+                d->scanTimer->start();
+            }
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::filePathChanged,
+        this,
+        [d]() {
+            if (d->enabled) {
+                d->scanTimer->start();
+            }
+        }
+    );
+}
+
+LinkChecker::~LinkChecker()
+{
+    Q_D(LinkChecker);
+
+    d->cancelRequests();
+    d->localWatcher->waitForFinished();
+}
+
+bool LinkChecker::isEnabled() const
+{
+    Q_D(const LinkChecker);
+
+    return d->enabled;
+}
+
+void LinkChecker::setEnabled(bool enabled)
+{
+    Q_D(LinkChecker);
+
+    if (enabled == d->enabled) {
+        return;
+    }
+
+    d->enabled = enabled;
+
+    if (enabled) {
+        d->scan();
+    } else {
+        d->scanTimer->stop();
+        d->cancelRequests();
+        d->links.clear();
+        d->keys.clear();
+        emit linksChanged();
+    }
+}
+
+bool LinkChecker::isRemoteCheckEnabled() const
+{
+    Q_D(const LinkChecker);
+
+    return d->remoteCheckEnabled;
+}
+
+void LinkChecker::setRemoteCheckEnabled(bool enabled)
+{
+    Q_D(LinkChecker);
+
+    if (enabled == d->remoteCheckEnabled) {
+        return;
+    }
+
+    d->remoteCheckEnabled = enabled;
+
+    if (!enabled) {
+        d->cancelRequests();
+    }
+
+    if (d->enabled) {
+        d->scan();
+    }
+}
+
+QVector<LinkChecker::Link> LinkChecker::links() const
+{
+    Q_D(const LinkChecker);
+
+    return d->links;
+}
+
+QVector<LinkChecker::Link> LinkChecker::brokenLinks() const
+{
+    Q_D(const LinkChecker);
+
+    QVector<Link> broken;
+
+    for (const Link &link : d->links) {
+        if (Broken == link.status) {
+            broken.append(link);
+        }
+    }
+
+    return broken;
+}
+
+// Collects the links and images of the AST, and checks those whose
+// destinations have no fresh outcome in the cache.
+//
+void LinkCheckerPrivate::scan()
+{
+    GW_TRACE_SCOPE("LinkChecker::scan");
+
+    if (!enabled) {
+        return;
+    }
+
+    if (localCheckInProgress) {
+        scanPending = true;
+        return;
+    }
+
+    MarkdownAST *ast = document->markdownAST();
+
+    if (nullptr == ast) {
+        return;
+    }
+
+    QString baseDir;
+
+    if (!document->filePath().isEmpty()) {
+        baseDir = QFileInfo(document->filePath()).dir().absolutePath();
+    }
+
+    links.clear();
+    keys.clear();
+
+    for (MarkdownNode *node : ast->nodesOfType<MarkdownNode::Link, MarkdownNode::Image>()) {
+        LinkChecker::Link link;
+        link.line = node->startLine();
+        link.position = node->position();
+        link.url = node->text();
+        link.image = (MarkdownNode::Image == node->type());
+        link.status = LinkChecker::Unchecked;
+
+        links.append(link);
+        keys.append(cacheKey(link.url, baseDir));
+    }
+
+    QSet<QString> currentKeys;
+    QStringList stalePaths;
+
+    for (const QString &key : keys) {
+        if (key.isEmpty() || currentKeys.contains(key)) {
+            continue;
+        }
+
+        currentKeys.insert(key);
+
+        if (isFresh(key)) {
+            continue;
+        }
+
+        if (!isRemote(key)) {
+            stalePaths.append(key);
+        } else if (remoteCheckEnabled && !requestsPending.contains(key)) {
+            requestsPending.insert(key);
+            requestQueue.enqueue(key);
+        }
+    }
+
+    // Forget the expired outcomes of destinations no longer linked to,
+    // so that the cache does not grow for as long as the document is open.
+    for (auto iter = cache.begin(); iter != cache.end();) {
+        if (!currentKeys.contains(iter.key()) && !isFresh(iter.key())) {
+            iter = cache.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    if (!stalePaths.isEmpty()) {
+        checkLocalPaths(stalePaths);
+    }
+
+    startRequests();
+    updateStatuses();
+}
+
+void LinkCheckerPrivate::checkLocalPaths(const QStringList &paths)
+{
+    localCheckInProgress = true;
+
+    QFuture<QHash<QString, bool>> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Indexing,
+            [paths]() {
+                GW_TRACE_SCOPE("LinkChecker::checkLocalPaths");
+                QHash<QString, bool> exists;
+
+                for (const QString &path : paths) {
+                    exists.insert(path, QFileInfo::exists(path));
+                }
+
+                return exists;
+            }
+        );
+    localWatcher->setFuture(future);
+}
+
+void LinkCheckerPrivate::onLocalCheckFinished()
+{
+    localCheckInProgress = false;
+
+    if (localWatcher->isCanceled()) {
+        return;
+    }
+
+    QHash<QString, bool> exists = localWatcher->result();
+    qint64 now = clock.elapsed();
+
+    for (auto iter = exists.constBegin(); iter != exists.constEnd(); ++iter) {
+        CacheEntry entry;
+        entry.status = iter.value() ? LinkChecker::Valid : LinkChecker::Broken;
+        entry.message = iter.value() ? QString() : LinkChecker::tr("File not found");
+        entry.checkedAt = now;
+        cache.insert(iter.key(), entry);
+    }
+
+    if (scanPending) {
+        scanPending = false;
+        scan();
+    } else if (enabled) {
+        updateStatuses();
+    }
+}
+
+void LinkCheckerPrivate::startRequests()
+{
+    while ((activeRequests < MaxConcurrentRequests) && !requestQueue.isEmpty()) {
+        sendRequest(requestQueue.dequeue(), true);
+    }
+}
+
+// Requests the given web address, only asking for its headers.  Servers
+// that do not support HEAD requests are sent a GET request instead, which
+// is aborted as soon as the headers arrive.
+//
+void LinkCheckerPrivate::sendRequest(const QString &url, bool headOnly)
+{
+    Q_Q(LinkChecker);
+
+    QNetworkRequest request((QUrl(url)));
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+    request.setHeader
+    (
+        QNetworkRequest::UserAgentHeader,
+        QCoreApplication::applicationName() + "/" + QCoreApplication::applicationVersion()
+    );
+
+    QNetworkReply *reply = headOnly ? network->head(request) : network->get(request);
+    activeRequests++;
+
+    QTimer::singleShot
+    (
+        RequestTimeout,
+        reply,
+        [reply]() {
+            reply->setProperty("timedOut", true);
+            reply->abort();
+        }
+    );
+
+    if (!headOnly) {
+        q->connect
+        (
+            reply,
+            &QNetworkReply::metaDataChanged,
+            q,
+            [reply]() {
+                QVariant code = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+
+                if ((code.toInt() < 300) || (code.toInt() >= 400)) {
+                    reply->setProperty("statusCode", code);
+                    reply->abort();
+                }
+            }
+        );
+    }
+
+    q->connect
+    (
+        reply,
+        &QNetworkReply::finished,
+        q,
+        [this, reply, url, headOnly]() {
+            onReplyFinished(reply, url, headOnly);
+        }
+    );
+}
+
+void LinkCheckerPrivate::onReplyFinished
+(
+    QNetworkReply *reply,
+    const QString &url,
+    bool headOnly
+)
+{
+    activeRequests--;
+    reply->deleteLater();
+
+    QVariant statusCode = reply->property("statusCode");
+
+    if (!statusCode.isValid()) {
+        statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    }
+
+    int code = statusCode.toInt();
+
+    // Method Not Allowed or Not Implemented.
+    if (headOnly && ((405 == code) || (501 == code))) {
+        sendRequest(url, false);
+        return;
+    }
+
+    CacheEntry entry;
+    entry.checkedAt = clock.elapsed();
+
+    if ((code >= 200) && (code < 400)) {
+        entry.status = LinkChecker::Valid;
+    } else {
+        entry.status = LinkChecker::Broken;
+
+        if (code >= 400) {
+            entry.message = LinkChecker::tr("HTTP status %1").arg(code);
+        } else if (reply->property("timedOut").toBool()) {
+            entry.message = LinkChecker::tr("Timed out");
+        } else {
+            entry.message = reply->errorString();
+        }
+    }
+
+    requestsPending.remove(url);
+    cache.insert(url, entry);
+    startRequests();
+
+    if (enabled) {
+        updateStatuses();
+    }
+}
+
+void LinkCheckerPrivate::cancelRequests()
+{
+    Q_Q(LinkChecker);
+
+    while (!requestQueue.isEmpty()) {
+        requestsPending.remove(requestQueue.dequeue());
+    }
+
+    for (QNetworkReply *reply : network->findChildren<QNetworkReply *>()) {
+        reply->disconnect(q);
+        reply->abort();
+        reply->deleteLater();
+    }
+
+    requestsPending.clear();
+    activeRequests = 0;
+}
+
+void LinkCheckerPrivate::updateStatuses()
+{
+    Q_Q(LinkChecker);
+
+    for (int i = 0; i < links.size(); i++) {
+        auto iter = cache.constFind(keys[i]);
+
+        if (keys[i].isEmpty() || (cache.constEnd() == iter)) {
+            links[i].status = LinkChecker::Unchecked;
+            links[i].message = QString();
+        } else {
+            links[i].status = iter->status;
+            links[i].message = iter->message;
+        }
+    }
+
+    emit q->linksChanged();
+}
+
+bool LinkCheckerPrivate::isFresh(const QString &key) const
+{
+    auto iter = cache.constFind(key);
+
+    if (cache.constEnd() == iter) {
+        return false;
+    }
+
+    qint64 timeToLive = isRemote(key) ? RemoteTimeToLive : LocalTimeToLive;
+
+    return (clock.elapsed() - iter->checkedAt) < timeToLive;
+}
+
+bool LinkCheckerPrivate::isRemote(const QString &key)
+{
+    return key.startsWith("http://") || key.startsWith("https://");
+}
+
+// Returns the web address or the absolute local path that the given link
+// destination refers to, or an empty string if it cannot be checked, such
+// as a relative path of an untitled document or a mailto: link.
+//
+QString LinkCheckerPrivate::cacheKey(const QString &destination, const QString &baseDir)
+{
+    QString url = destination.trimmed();
+
+    // Links to headings within the document.
+    if (url.isEmpty() || url.startsWith('#')) {
+        return QString();
+    }
+
+    QUrl parsed(url);
+    QString scheme = parsed.scheme().toLower();
+    QString path;
+
+    if (("http" == scheme) || ("https" == scheme)) {
+        return parsed.toString(QUrl::RemoveFragment);
+    } else if ("file" == scheme) {
+        path = parsed.toLocalFile();
+    } else if (1 == scheme.length()) {
+        // Absolute path with a Windows drive letter.
+        path = url;
+    } else if (scheme.isEmpty()) {
+        path = parsed.path(QUrl::FullyDecoded);
+    } else {
+        return QString();
+    }
+
+    if (path.isEmpty()) {
+        return QString();
+    }
+
+    if (QDir::isRelativePath(path)) {
+        if (baseDir.isEmpty()) {
+            return QString();
+        }
+
+        path = QDir(baseDir).absoluteFilePath(path);
+    }
+
+    return QDir::cleanPath(path);
+}
+} // namespace ghostwriter
@@ -0,0 +1,133 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef LINK_CHECKER_H
+#define LINK_CHECKER_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+
+/**
+ * Checks the destinations of the links and images of a MarkdownDocument
+ * in the background.  Local paths are resolved relative to the document's
+ * directory and checked for existence, and web addresses are optionally
+ * requested, a few at a time.
+ *
+ * The outcome of each check is cached per destination for a while, so
+ * that rechecking the document after an edit only checks the links that
+ * are new to it.
+ */
+class LinkCheckerPrivate;
+class LinkChecker : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(LinkChecker)
+
+public:
+    /**
+     * Outcome of checking a link.
+     */
+    typedef enum {
+        // Not checked yet, or cannot be checked, such as a relative path
+        // of an untitled document or a web address while web links are not
+        // checked.
+        Unchecked,
+        Valid,
+        Broken
+    } Status;
+
+    /**
+     * Link or image of the document.
+     */
+    struct Link
+    {
+        // Line number, starting from 1, and the position of the link
+        // within the line.
+        int line;
+        int position;
+
+        QString url;
+        bool image;
+        Status status;
+
+        // Why the link is broken, if it is.
+        QString message;
+    };
+
+    /**
+     * Constructor.  Pass in the document whose links to check.
+     */
+    LinkChecker(MarkdownDocument *document, QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~LinkChecker();
+
+    /**
+     * Returns whether the document's links are being checked.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Sets whether to check the document's links.  Disabling forgets the
+     * links, but not the cached outcomes.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns whether web addresses are checked, besides local paths.
+     */
+    bool isRemoteCheckEnabled() const;
+
+    /**
+     * Sets whether to check web addresses, besides local paths.
+     */
+    void setRemoteCheckEnabled(bool enabled);
+
+    /**
+     * Returns the links and images of the document, in order, as of the
+     * last check.
+     */
+    QVector<Link> links() const;
+
+    /**
+     * Returns the links and images of the document found to be broken, in
+     * order.
+     */
+    QVector<Link> brokenLinks() const;
+
+signals:
+    /**
+     * Emitted when the links of the document or their status change.
+     */
+    void linksChanged();
+
+private:
+    QScopedPointer<LinkCheckerPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // LINK_CHECKER_H
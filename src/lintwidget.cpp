@@ -0,0 +1,176 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QTextBlock>
+
+#include "lintwidget.h"
+
+namespace ghostwriter
+{
+// Roles of the item data holding the line and column of each warning.
+static const int LINE_ROLE = Qt::UserRole + 1;
+static const int COLUMN_ROLE = Qt::UserRole + 2;
+
+LintWidget::LintWidget
+(
+    MarkdownLinter *linter,
+    LinkChecker *linkChecker,
+    MarkdownEditor *editor,
+    QWidget *parent
+) : QListWidget(parent),
+    linter(linter),
+    linkChecker(linkChecker),
+    editor(editor),
+    stale(false)
+{
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(RefreshInterval);
+
+    this->connect
+    (
+        refreshTimer,
+        &QTimer::timeout,
+        [this]() {
+            refresh();
+        }
+    );
+
+    this->connect
+    (
+        linter,
+        &MarkdownLinter::warningsChanged,
+        this,
+        [this]() {
+            scheduleRefresh();
+        }
+    );
+
+    this->connect
+    (
+        linkChecker,
+        &LinkChecker::linksChanged,
+        this,
+        [this]() {
+            scheduleRefresh();
+        }
+    );
+
+    this->connect
+    (
+        this,
+        &LintWidget::itemActivated,
+        [this](QListWidgetItem *item) {
+            onItemActivated(item);
+        }
+    );
+}
+
+LintWidget::~LintWidget()
+{
+    ;
+}
+
+void LintWidget::showEvent(QShowEvent *event)
+{
+    QListWidget::showEvent(event);
+
+    if (stale) {
+        refresh();
+    }
+}
+
+void LintWidget::refresh()
+{
+    stale = false;
+    clear();
+
+    QVector<MarkdownLinter::Warning> warnings;
+    QVector<LinkChecker::Link> brokenLinks;
+
+    if (linter) {
+        warnings = linter->warnings();
+    }
+
+    if (linkChecker) {
+        brokenLinks = linkChecker->brokenLinks();
+    }
+
+    int w = 0;
+    int l = 0;
+
+    // Both lists are in order of line, so merge them.
+    while ((w < warnings.size()) || (l < brokenLinks.size())) {
+        int line;
+        int column;
+        QString message;
+
+        if
+        (
+            (l >= brokenLinks.size())
+            || ((w < warnings.size()) && (warnings[w].line <= brokenLinks[l].line))
+        ) {
+            const MarkdownLinter::Warning &warning = warnings[w++];
+            line = warning.line;
+            column = warning.position;
+            message = warning.message;
+        } else {
+            const LinkChecker::Link &link = brokenLinks[l++];
+            line = link.line;
+            column = link.position;
+            message = (link.image ? tr("Broken image %1 (%2)") : tr("Broken link %1 (%2)"))
+                .arg(link.url, link.message);
+        }
+
+        QListWidgetItem *item = new QListWidgetItem
+            (
+                tr("Line %1: %2").arg(line).arg(message),
+                this
+            );
+        item->setData(LINE_ROLE, line);
+        item->setData(COLUMN_ROLE, column);
+    }
+}
+
+void LintWidget::scheduleRefresh()
+{
+    if (isVisible()) {
+        refreshTimer->start();
+    } else {
+        stale = true;
+    }
+}
+
+void LintWidget::onItemActivated(QListWidgetItem *item)
+{
+    // Make sure editor and document haven't been deleted.
+    if (!editor) {
+        return;
+    }
+
+    QTextBlock block =
+        editor->document()->findBlockByNumber(item->data(LINE_ROLE).toInt() - 1);
+
+    if (block.isValid()) {
+        int column = qMin(item->data(COLUMN_ROLE).toInt(), block.length() - 1);
+        editor->navigateDocument(block.position() + column);
+        editor->setFocus();
+    }
+}
+} // namespace ghostwriter
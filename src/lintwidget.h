@@ -0,0 +1,96 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef LINT_WIDGET_H
+#define LINT_WIDGET_H
+
+#include <QListWidget>
+#include <QPointer>
+#include <QTimer>
+
+#include "linkchecker.h"
+#include "markdowneditor.h"
+#include "markdownlinter.h"
+
+namespace ghostwriter
+{
+/**
+ * Sidebar list of the style warnings found by a MarkdownLinter and of the
+ * broken links found by a LinkChecker, for use in navigating to them in the
+ * editor.
+ */
+class LintWidget : public QListWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.  Lists the warnings of the given linter and the broken
+     * links of the given link checker, which check the given editor's
+     * document.
+     */
+    LintWidget
+    (
+        MarkdownLinter *linter,
+        LinkChecker *linkChecker,
+        MarkdownEditor *editor,
+        QWidget *parent = nullptr
+    );
+
+    /**
+     * Destructor.
+     */
+    virtual ~LintWidget();
+
+protected:
+    void showEvent(QShowEvent *event);
+
+private:
+    // Interval, in milliseconds, over which changes to the warnings are
+    // gathered before the list is rebuilt.
+    static const int RefreshInterval = 250;
+
+    QPointer<MarkdownLinter> linter;
+    QPointer<LinkChecker> linkChecker;
+    QPointer<MarkdownEditor> editor;
+    QTimer *refreshTimer;
+
+    // Whether the warnings changed while the widget was hidden, so that
+    // the list is rebuilt once it is shown.
+    bool stale;
+
+    /*
+    * Rebuilds the list from the linter's warnings and the link checker's
+    * broken links, in order of line.
+    */
+    void refresh();
+
+    /*
+    * Rebuilds the list once shown, or shortly if already shown.
+    */
+    void scheduleRefresh();
+
+    /*
+    * Moves the editor's cursor to the warning of the given item.
+    */
+    void onItemActivated(QListWidgetItem *item);
+};
+} // namespace ghostwriter
+
+#endif // LINT_WIDGET_H
@@ -0,0 +1,192 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <cstring>
+
+#include "literalsearcher.h"
+
+namespace ghostwriter
+{
+LiteralSearcher::LiteralSearcher
+(
+    const QString &query,
+    Qt::CaseSensitivity caseSensitivity
+)
+    : originalQuery(query),
+      caseSensitivity(caseSensitivity)
+{
+    if (Qt::CaseInsensitive == caseSensitivity) {
+        foldedQuery = fold(query);
+    } else {
+        foldedQuery = query;
+    }
+}
+
+QString LiteralSearcher::query() const
+{
+    return originalQuery;
+}
+
+int LiteralSearcher::length() const
+{
+    return foldedQuery.length();
+}
+
+int LiteralSearcher::indexIn(const QString &text, int from) const
+{
+    if (Qt::CaseInsensitive == caseSensitivity) {
+        return find(fold(text), from);
+    }
+
+    return find(text, from);
+}
+
+int LiteralSearcher::lastIndexIn(const QString &text, int from) const
+{
+    if (Qt::CaseInsensitive == caseSensitivity) {
+        return findLast(fold(text), from);
+    }
+
+    return findLast(text, from);
+}
+
+QVector<int> LiteralSearcher::indexesIn(const QString &text, int limit) const
+{
+    QVector<int> indexes;
+
+    if (foldedQuery.isEmpty()) {
+        return indexes;
+    }
+
+    QString searchText = text;
+
+    if (Qt::CaseInsensitive == caseSensitivity) {
+        searchText = fold(text);
+    }
+
+    int index = find(searchText, 0);
+
+    while ((index >= 0) && ((limit < 0) || (indexes.count() < limit))) {
+        indexes.append(index);
+        index = find(searchText, index + foldedQuery.length());
+    }
+
+    return indexes;
+}
+
+// Folds the case of the given text, keeping the positions of its
+// characters so that matches in the folded text are at the same positions
+// in the original.
+//
+QString LiteralSearcher::fold(const QString &text)
+{
+    QString folded = text.toCaseFolded();
+
+    if (folded.length() != text.length()) {
+        folded = text;
+
+        for (int i = 0; i < folded.length(); i++) {
+            folded[i] = folded.at(i).toCaseFolded();
+        }
+    }
+
+    return folded;
+}
+
+// Finds the first match in the (already folded) text at or after the given
+// position.
+//
+int LiteralSearcher::find(const QString &text, int from) const
+{
+    int length = foldedQuery.length();
+
+    if ((length <= 0) || (from < 0)) {
+        return -1;
+    }
+
+    int lastStart = text.length() - length;
+    QChar first = foldedQuery.at(0);
+    int index = text.indexOf(first, from, Qt::CaseSensitive);
+
+    while ((index >= 0) && (index <= lastStart)) {
+        if (matchesAt(text, index)) {
+            return index;
+        }
+
+        index = text.indexOf(first, index + 1, Qt::CaseSensitive);
+    }
+
+    return -1;
+}
+
+// Finds the last match in the (already folded) text starting at or before
+// the given position, or anywhere if it is negative.
+//
+int LiteralSearcher::findLast(const QString &text, int from) const
+{
+    int length = foldedQuery.length();
+    int lastStart = text.length() - length;
+
+    if ((length <= 0) || (lastStart < 0)) {
+        return -1;
+    }
+
+    if ((from < 0) || (from > lastStart)) {
+        from = lastStart;
+    }
+
+    QChar first = foldedQuery.at(0);
+    int index = text.lastIndexOf(first, from, Qt::CaseSensitive);
+
+    while (index >= 0) {
+        if (matchesAt(text, index)) {
+            return index;
+        }
+
+        if (index <= 0) {
+            break;
+        }
+
+        index = text.lastIndexOf(first, index - 1, Qt::CaseSensitive);
+    }
+
+    return -1;
+}
+
+// Returns true if the query matches the (already folded) text at the given
+// position, whose first character is known to match.
+//
+bool LiteralSearcher::matchesAt(const QString &text, int position) const
+{
+    int length = foldedQuery.length();
+
+    if (text.at(position + length - 1) != foldedQuery.at(length - 1)) {
+        return false;
+    }
+
+    return (length <= 2)
+        || (0 == std::memcmp
+            (
+                text.constData() + position + 1,
+                foldedQuery.constData() + 1,
+                (length - 2) * sizeof(QChar)
+            ));
+}
+} // namespace ghostwriter
@@ -0,0 +1,96 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef LITERALSEARCHER_H
+#define LITERALSEARCHER_H
+
+#include <QString>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Searches text for a literal (i.e., non-regular expression) query.
+ *
+ * Candidate matches are found by scanning for the first character of the
+ * query with QString::indexOf(QChar), which Qt vectorizes, and then
+ * filtered by the last character before the rest of the query is
+ * compared.  For case insensitive searches, the query is case folded once
+ * on construction, and the text once per search.
+ *
+ * Note that the searcher does not change once constructed, so that it may
+ * be shared by worker threads.
+ */
+class LiteralSearcher
+{
+public:
+    /**
+     * Constructor.  An empty query matches nothing.
+     */
+    LiteralSearcher
+    (
+        const QString &query = QString(),
+        Qt::CaseSensitivity caseSensitivity = Qt::CaseSensitive
+    );
+
+    /**
+     * Gets the query, as given.
+     */
+    QString query() const;
+
+    /**
+     * Gets the length of the query, which is also that of its matches.
+     */
+    int length() const;
+
+    /**
+     * Returns the position of the first match in the given text at or after
+     * the given position, or -1 if there is none.
+     */
+    int indexIn(const QString &text, int from = 0) const;
+
+    /**
+     * Returns the position of the last match in the given text that starts
+     * at or before the given position (or anywhere if from is negative),
+     * or -1 if there is none.
+     */
+    int lastIndexIn(const QString &text, int from = -1) const;
+
+    /**
+     * Returns the positions of all of the non-overlapping matches in the
+     * given text, in order, stopping after limit matches if limit is not
+     * negative.  The text is only case folded once for all of them.
+     */
+    QVector<int> indexesIn(const QString &text, int limit = -1) const;
+
+private:
+    QString originalQuery;
+    QString foldedQuery;
+    Qt::CaseSensitivity caseSensitivity;
+
+    static QString fold(const QString &text);
+
+    int find(const QString &text, int from) const;
+    int findLast(const QString &text, int from) const;
+    bool matchesAt(const QString &text, int position) const;
+};
+} // namespace ghostwriter
+
+#endif // LITERALSEARCHER_H
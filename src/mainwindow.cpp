@@ -39,22 +39,36 @@
 #include <QScrollBar>
 #include <QSettings>
 #include <QStatusBar>
+#include <QTextBlock>
+#include <QTextDocument>
 #include <QTextStream>
+#include <QTimer>
 
 #include "3rdparty/QtAwesome/QtAwesome.h"
 
+#include "cmarkgfmexporter.h"
 #include "documenthistory.h"
 #include "exporter.h"
 #include "exporterfactory.h"
 #include "findreplace.h"
+#include "fontcatalogue.h"
+#include "hugefileviewer.h"
+#include "jumpdialog.h"
+#include "latencymonitor.h"
 #include "localedialog.h"
 #include "mainwindow.h"
+#include "memorypressuremonitor.h"
+#include "memoryreport.h"
 #include "messageboxhelper.h"
+#include "pdfprinter.h"
 #include "preferencesdialog.h"
 #include "previewoptionsdialog.h"
 #include "sandboxedwebpage.h"
+#include "sessionrecorder.h"
 #include "simplefontdialog.h"
+#include "startupprofiler.h"
 #include "stylesheetbuilder.h"
+#include "taskscheduler.h"
 #include "themeselectiondialog.h"
 #include "spelling/dictionary_manager.h"
 
@@ -65,43 +79,95 @@ enum SidebarTabIndex {
     OutlineSidebarTab = FirstSidebarTab,
     SessionStatsSidebarTab,
     DocumentStatsSidebarTab,
+    ProjectStatsSidebarTab,
     CheatSheetSidebarTab,
-    LastSidebarTab = CheatSheetSidebarTab
+    ProjectTreeSidebarTab,
+    FolderSearchSidebarTab,
+    LintSidebarTab,
+    TasksSidebarTab,
+    LastSidebarTab = TasksSidebarTab
 };
 
 #define GW_MAIN_WINDOW_GEOMETRY_KEY "Window/mainWindowGeometry"
 #define GW_MAIN_WINDOW_STATE_KEY "Window/mainWindowState"
 
+// Time, in milliseconds, after startup at which a hidden preview is
+// created in the background.
+#define GW_PREVIEW_PREWARM_DELAY 2000
+
 MainWindow::MainWindow(const QString &filePath, QWidget *parent)
     : QMainWindow(parent)
 {
+    StartupProfiler::Scope awesomeScope("QtAwesome");
     this->awesome = new QtAwesome(qApp);
     this->awesome->initFontAwesome();
+    this->glyphIcons = new GlyphIconCache(this->awesome, this);
+    awesomeScope.end();
+
     QString fileToOpen;
     setWindowIcon(QIcon(":/resources/images/ghostwriter.svg"));
     this->setObjectName("mainWindow");
     this->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
 
     appSettings = AppSettings::instance();
+    documentSize = DocumentSizeNormal;
+    colorSchemeApplied = false;
+    themePreviewActive = false;
+    colorSchemePreviewed = false;
+    powerSaving = false;
+    warmStartPending = false;
+    firstTextPainted = false;
+
+    themePreviewSettleTimer = new QTimer(this);
+    themePreviewSettleTimer->setSingleShot(true);
+    themePreviewSettleTimer->setInterval(THEME_PREVIEW_SETTLE_DELAY);
+
+    this->connect
+    (
+        themePreviewSettleTimer,
+        &QTimer::timeout,
+        [this]() {
+            if (colorSchemePreviewed) {
+                editor->setColorScheme(appliedColorScheme);
+                colorSchemePreviewed = false;
+            }
+        }
+    );
+
+    copyHtmlWatcher = new QFutureWatcher<QString>(this);
+    connect(copyHtmlWatcher, SIGNAL(finished()), this, SLOT(onHtmlCopied()));
 
     QString themeName = appSettings->themeName();
 
     QString err;
+    StartupProfiler::Scope themeScope("Theme");
     theme = ThemeRepository::instance()->loadTheme(themeName, err);
+    themeScope.end();
 
+    StartupProfiler::Scope editorScope("Editor");
     MarkdownDocument *document = new MarkdownDocument();
 
     editor = new MarkdownEditor(document, theme.lightColorScheme(), this);
+    SessionRecorder::recordIfRequested(editor);
     editor->setFont(appSettings->editorFont().family(), appSettings->editorFont().pointSize());
     editor->setUseUnderlineForEmphasis(appSettings->useUnderlineForEmphasis());
     editor->setEnableLargeHeadingSizes(appSettings->largeHeadingSizesEnabled());
     editor->setAutoMatchEnabled(appSettings->autoMatchEnabled());
     editor->setBulletPointCyclingEnabled(appSettings->bulletPointCyclingEnabled());
+    editor->setWordCompletionEnabled(appSettings->wordCompletionEnabled());
+    editor->setTableFormattingEnabled(appSettings->tableFormattingEnabled());
+    editor->setImageImportEnabled(appSettings->imageImportEnabled());
+    editor->setImageImportMaxWidth(appSettings->imageImportMaxWidth());
     editor->setPlainText("");
     editor->setEditorWidth((EditorWidth) appSettings->editorWidth());
     editor->setEditorCorners((InterfaceStyle) appSettings->interfaceStyle());
-    editor->setSpellCheckEnabled(appSettings->liveSpellCheckEnabled());
+
+    // Spell checking is enabled along with its dictionary in
+    // initializeDeferredFeatures().
+    editor->setSpellCheckEnabled(false);
     editor->setItalicizeBlockquotes(appSettings->italicizeBlockquotes());
+    editor->setLongLineThreshold(appSettings->longLineThreshold());
+    editor->setGpuViewportEnabled(appSettings->gpuViewportEnabled());
     editor->setTabulationWidth(appSettings->tabWidth());
     editor->setInsertSpacesForTabs(appSettings->insertSpacesForTabsEnabled());
     connect(editor, SIGNAL(fontSizeChanged(int)), this, SLOT(onFontSizeChanged(int)));
@@ -115,11 +181,15 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
     //
     editor->verticalScrollBar()->setStyle(new QCommonStyle());
     editor->horizontalScrollBar()->setStyle(new QCommonStyle());
+    editorScope.end();
 
+    StartupProfiler::Scope sidebarScope("Sidebar");
     buildSidebar();
+    sidebarScope.end();
 
     documentManager = new DocumentManager(editor, this);
     documentManager->setAutoSaveEnabled(appSettings->autoSaveEnabled());
+    documentManager->setAutoSaveJournalEnabled(appSettings->autoSaveJournalEnabled());
     documentManager->setFileBackupEnabled(appSettings->backupFileEnabled());
     documentManager->setFileHistoryEnabled(appSettings->fileHistoryEnabled());
     setWindowTitle(documentManager->document()->displayName() + "[*] - " + qAppName());
@@ -128,7 +198,21 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
     connect(documentManager, SIGNAL(operationStarted(QString)), this, SLOT(onOperationStarted(QString)));
     connect(documentManager, SIGNAL(operationUpdate(QString)), this, SLOT(onOperationStarted(QString)));
     connect(documentManager, SIGNAL(operationFinished()), this, SLOT(onOperationFinished()));
+    connect(editor, SIGNAL(operationStarted(QString)), this, SLOT(onOperationStarted(QString)));
+    connect(editor, SIGNAL(operationUpdate(QString)), this, SLOT(onOperationStarted(QString)));
+    connect(editor, SIGNAL(operationFinished()), this, SLOT(onOperationFinished()));
     connect(documentManager, SIGNAL(documentClosed()), this, SLOT(refreshRecentFiles()));
+    connect(DocumentHistory::instance(), SIGNAL(recentFilesChanged()), this, SLOT(refreshRecentFiles()));
+
+    documentManager->document()->setUndoMemoryLimit(((qint64) appSettings->undoMemoryLimit()) * 1024 * 1024);
+    this->connect
+    (
+        appSettings,
+        &AppSettings::undoMemoryLimitChanged,
+        [this](int megabytes) {
+            documentManager->document()->setUndoMemoryLimit(((qint64) megabytes) * 1024 * 1024);
+        }
+    );
 
     editor->setAutoMatchEnabled('\"', appSettings->autoMatchCharEnabled('\"'));
     editor->setAutoMatchEnabled('\'', appSettings->autoMatchCharEnabled('\''));
@@ -144,11 +228,19 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
     editorPane->setObjectName("editorLayoutArea");
     editorPane->setLayout(editor->preferredLayout());
 
+    // The editor sits in a splitter, into which the split view of the
+    // document is added below it.
+    splitEditor = nullptr;
+    editorSplitter = new QSplitter(Qt::Vertical, editorPane);
+    editorSplitter->addWidget(editor);
+    editorSplitter->setChildrenCollapsible(false);
+    editor->preferredLayout()->addWidget(editorSplitter, 0, 0);
+
     QStringList recentFiles;
 
     if (appSettings->fileHistoryEnabled()) {
-        DocumentHistory history;
-        recentFiles = history.recentFiles(MAX_RECENT_FILES + 2);
+        StartupProfiler::Scope historyScope("DocumentHistory");
+        recentFiles = DocumentHistory::instance()->recentFiles(MAX_RECENT_FILES + 2);
     }
 
     bool fileLoadError = false;
@@ -188,6 +280,12 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
         }
     }
 
+    // Show the text of the document first, and initialize the rest after.
+    if (!fileToOpen.isNull() && !fileToOpen.isEmpty()) {
+        warmStartPending = true;
+        documentStats->setDeferredUpdatesEnabled(true);
+    }
+
     for (int i = 0; i < MAX_RECENT_FILES; i++) {
         recentFilesActions[i] = new QAction(this);
 
@@ -237,22 +335,35 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
     }
 
     connect(appSettings, SIGNAL(autoSaveChanged(bool)), documentManager, SLOT(setAutoSaveEnabled(bool)));
+    connect(appSettings, SIGNAL(autoSaveJournalChanged(bool)), documentManager, SLOT(setAutoSaveJournalEnabled(bool)));
     connect(appSettings, SIGNAL(backupFileChanged(bool)), documentManager, SLOT(setFileBackupEnabled(bool)));
     connect(appSettings, SIGNAL(tabWidthChanged(int)), editor, SLOT(setTabulationWidth(int)));
     connect(appSettings, SIGNAL(insertSpacesForTabsChanged(bool)), editor, SLOT(setInsertSpacesForTabs(bool)));
     connect(appSettings, SIGNAL(useUnderlineForEmphasisChanged(bool)), editor, SLOT(setUseUnderlineForEmphasis(bool)));
     connect(appSettings, SIGNAL(italicizeBlockquotesChanged(bool)), editor, SLOT(setItalicizeBlockquotes(bool)));
+    connect(appSettings, SIGNAL(longLineThresholdChanged(int)), editor, SLOT(setLongLineThreshold(int)));
+    connect(appSettings, SIGNAL(gpuViewportChanged(bool)), editor, SLOT(setGpuViewportEnabled(bool)));
     connect(appSettings, SIGNAL(largeHeadingSizesChanged(bool)), editor, SLOT(setEnableLargeHeadingSizes(bool)));
     connect(appSettings, SIGNAL(autoMatchChanged(bool)), editor, SLOT(setAutoMatchEnabled(bool)));
     connect(appSettings, SIGNAL(autoMatchCharChanged(QChar, bool)), editor, SLOT(setAutoMatchEnabled(QChar, bool)));
     connect(appSettings, SIGNAL(bulletPointCyclingChanged(bool)), editor, SLOT(setBulletPointCyclingEnabled(bool)));
+    connect(appSettings, SIGNAL(wordCompletionChanged(bool)), editor, SLOT(setWordCompletionEnabled(bool)));
+    connect(appSettings, SIGNAL(tableFormattingChanged(bool)), editor, SLOT(setTableFormattingEnabled(bool)));
+    connect(appSettings, &AppSettings::imageImportEnabledChanged, editor, &MarkdownEditor::setImageImportEnabled);
+    connect(appSettings, &AppSettings::imageImportMaxWidthChanged, editor, &MarkdownEditor::setImageImportMaxWidth);
     connect(appSettings, SIGNAL(autoMatchChanged(bool)), editor, SLOT(setAutoMatchEnabled(bool)));
     connect(appSettings, SIGNAL(focusModeChanged(FocusMode)), this, SLOT(changeFocusMode(FocusMode)));
     connect(appSettings, SIGNAL(hideMenuBarInFullScreenChanged(bool)), this, SLOT(toggleHideMenuBarInFullScreen(bool)));
     connect(appSettings, SIGNAL(fileHistoryChanged(bool)), this, SLOT(toggleFileHistoryEnabled(bool)));
     connect(appSettings, SIGNAL(displayTimeInFullScreenChanged(bool)), this, SLOT(toggleDisplayTimeInFullScreen(bool)));
     connect(appSettings, SIGNAL(dictionaryLanguageChanged(QString)), editor, SLOT(setDictionary(QString)));
+    connect(appSettings, SIGNAL(alternativeDictionaryLanguagesChanged(QStringList)), editor, SLOT(setAlternativeDictionaries(QStringList)));
     connect(appSettings, SIGNAL(liveSpellCheckChanged(bool)), editor, SLOT(setSpellCheckEnabled(bool)));
+    connect(appSettings, &AppSettings::lintEnabledChanged, linter, &MarkdownLinter::setEnabled);
+    connect(appSettings, &AppSettings::lintLineLengthChanged, linter, &MarkdownLinter::setMaxLineLength);
+    connect(appSettings, &AppSettings::lintEnabledChanged, linkChecker, &LinkChecker::setEnabled);
+    connect(appSettings, &AppSettings::lintWebLinksEnabledChanged, linkChecker, &LinkChecker::setRemoteCheckEnabled);
+    connect(appSettings, &AppSettings::readabilityHighlightEnabledChanged, readabilityAnalyzer, &ReadabilityAnalyzer::setEnabled);
     connect(appSettings, SIGNAL(editorWidthChanged(EditorWidth)), this, SLOT(changeEditorWidth(EditorWidth)));
     connect(appSettings, SIGNAL(interfaceStyleChanged(InterfaceStyle)), this, SLOT(changeInterfaceStyle(InterfaceStyle)));
     connect(appSettings, SIGNAL(previewTextFontChanged(QFont)), this, SLOT(applyTheme()));
@@ -262,23 +373,13 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
         this->menuBar()->hide();
     }
 
-    // Default language for dictionary is set from AppSettings intialization.
-    QString language = appSettings->dictionaryLanguage();
-
-    // If we have an available dictionary, then set up spell checking.
-    if (!language.isNull() && !language.isEmpty()) {
-        editor->setDictionary(language);
-        editor->setSpellCheckEnabled(appSettings->liveSpellCheckEnabled());
-    } else {
-        editor->setSpellCheckEnabled(false);
-    }
-
-    connect
+    this->connect
     (
         documentStats,
-        SIGNAL(wordCountChanged(int)),
-        this,
-        SLOT(updateWordCount(int))
+        &DocumentStatistics::statisticsChanged,
+        [this](const DocumentStatistics::Statistics &statistics) {
+            updateWordCount(statistics.wordCount);
+        }
     );
 
     this->connect
@@ -288,49 +389,137 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
         [this]() {
             this->sessionStats->startNewSession(this->documentStats->wordCount());
             refreshRecentFiles();
+            updateSearchFolder();
         }
     );
 
     this->connect
     (
-        documentManager,
-        &DocumentManager::documentClosed,
+        documentManager->document(),
+        &MarkdownDocument::filePathChanged,
         [this]() {
-            this->sessionStats->startNewSession(0);
+            updateSearchFolder();
         }
     );
 
-    // Note that the parent widget for this new window must be NULL, so that
-    // it will hide beneath other windows when it is deactivated.
-    //
-    htmlPreview = new HtmlPreview
+    this->connect
     (
-        documentManager->document(),
-        appSettings->currentHtmlExporter(),
-        this
+        projectTreeWidget,
+        &ProjectTreeWidget::fileSelected,
+        [this](const QString &filePath) {
+            documentManager->open(filePath);
+        }
     );
 
-    connect(editor, SIGNAL(textChanged()), htmlPreview, SLOT(updatePreview()));
-    connect(outlineWidget, SIGNAL(headingNumberNavigated(int)), htmlPreview, SLOT(navigateToHeading(int)));
-    connect(appSettings, SIGNAL(currentHtmlExporterChanged(Exporter *)), htmlPreview, SLOT(setHtmlExporter(Exporter *)));
+    this->connect
+    (
+        folderSearchWidget,
+        &FolderSearchWidget::resultSelected,
+        [this](const QString &filePath, int position) {
+            documentManager->open(filePath, position);
+        }
+    );
 
-    htmlPreview->setMinimumWidth(0);
-    htmlPreview->setObjectName("htmlpreview");
-    htmlPreview->setVisible(appSettings->htmlPreviewVisible());
+    this->connect
+    (
+        documentManager,
+        &DocumentManager::hugeFileOpened,
+        [this](const QString &filePath) {
+            HugeFileViewer *viewer = new HugeFileViewer(filePath, appliedColorScheme, this);
+            viewer->setPreviewStyleSheet(htmlPreviewBaseCss, htmlPreviewCssVariables);
+            viewer->resize(this->size());
+            viewer->show();
+        }
+    );
+
+    this->connect
+    (
+        documentManager,
+        &DocumentManager::documentClosed,
+        [this]() {
+            this->sessionStats->startNewSession(0);
+        }
+    );
 
     previewSplitter = new QSplitter(this);
     previewSplitter->addWidget(editorPane);
-    previewSplitter->addWidget(htmlPreview);
     previewSplitter->setCollapsible(0, true);
-    previewSplitter->setCollapsible(1, true);
+
+    // Booting QtWebEngine for the preview slows down startup, so only
+    // create the preview now if it is to be shown right away and there is
+    // no document to show first.  Otherwise, it is created once the window
+    // or the document has been painted.
+    //
+    htmlPreview = nullptr;
+
+    if (appSettings->htmlPreviewVisible() && !warmStartPending) {
+        StartupProfiler::Scope previewScope("HtmlPreview");
+        createHtmlPreview();
+    }
+
+    this->connect
+    (
+        appSettings,
+        &AppSettings::currentHtmlExporterChanged,
+        [this]() {
+            updateHtmlRendering();
+        }
+    );
+
+    updateHtmlRendering();
 
 
     this->findReplace = new FindReplace(this->editor, this);
     statusBarWidgets.append(this->findReplace);
     this->findReplace->setVisible(false);
 
+    StartupProfiler::Scope barsScope("Menu and status bars");
     buildMenuBar();
     buildStatusBar();
+    barsScope.end();
+
+    stallWatchdog = new StallWatchdog(this);
+    stallWatchdog->setDocumentSize(editor->document()->characterCount());
+    stallWatchdog->setEnabled(appSettings->stallReportsEnabled());
+    connect(appSettings, SIGNAL(stallReportsChanged(bool)), stallWatchdog, SLOT(setEnabled(bool)));
+
+    // Scale back live features as the document grows past the large
+    // document thresholds, and restore them as it shrinks.
+    this->connect
+    (
+        editor->document(),
+        &QTextDocument::contentsChange,
+        [this]() {
+            updateDocumentSize();
+        }
+    );
+
+    this->connect
+    (
+        appSettings,
+        &AppSettings::largeDocumentModeChanged,
+        [this]() {
+            updateDocumentSize();
+        }
+    );
+
+    this->connect
+    (
+        appSettings,
+        &AppSettings::largeDocumentThresholdChanged,
+        [this]() {
+            updateDocumentSize();
+        }
+    );
+
+    this->connect
+    (
+        appSettings,
+        &AppSettings::hugeDocumentThresholdChanged,
+        [this]() {
+            updateDocumentSize();
+        }
+    );
     
     QVBoxLayout *mainLayout = new QVBoxLayout();
     QWidget *mainPane = new QWidget(this);
@@ -348,6 +537,7 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
     this->setCentralWidget(sidebarSplitter);
 
     // Show the main window.
+    StartupProfiler::Scope showScope("Show and apply theme");
     show();
 
     // Apply the theme only after show() is called on all the widgets,
@@ -359,11 +549,72 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
 
     this->update();
     qApp->processEvents();
+    showScope.end();
 
     if (!fileToOpen.isNull() && !fileToOpen.isEmpty()) {
+        StartupProfiler::Scope openScope("Open document");
         documentManager->open(fileToOpen);
     }
 
+    if (warmStartPending) {
+        // The first text is painted once the document has loaded, which is
+        // caught by eventFilter().  Don't wait for a document that failed
+        // to load or is empty, nor for a window that is never painted.
+        this->connect
+        (
+            documentManager,
+            &DocumentManager::operationFinished,
+            [this]() {
+                if (warmStartPending && (editor->document()->characterCount() <= 1)) {
+                    finishWarmStart();
+                }
+            }
+        );
+
+        QTimer::singleShot
+        (
+            WARM_START_TIMEOUT,
+            this,
+            [this]() {
+                finishWarmStart();
+            }
+        );
+    } else {
+        initializeDeferredFeatures();
+    }
+
+    // End the startup profile once the first document has finished
+    // loading and the deferred features are initialized, or once the
+    // event loop is first idle if there is no document.
+    //
+    if (StartupProfiler::isEnabled()) {
+        this->connect
+        (
+            documentManager,
+            &DocumentManager::operationFinished,
+            [this]() {
+                StartupProfiler::mark("Document load finished");
+
+                if (!warmStartPending) {
+                    StartupProfiler::finish();
+                }
+            }
+        );
+
+        QTimer::singleShot
+        (
+            0,
+            this,
+            [this]() {
+                StartupProfiler::mark("Event loop idle");
+
+                if (!documentManager->isLoading() && !warmStartPending) {
+                    StartupProfiler::finish();
+                }
+            }
+        );
+    }
+
     if (fileLoadError) {
         QMessageBox::critical
         (
@@ -373,10 +624,26 @@ MainWindow::MainWindow(const QString &filePath, QWidget *parent)
         );
     }
 
+    memoryPressureMonitor = new MemoryPressureMonitor(this);
+    connect(memoryPressureMonitor, SIGNAL(pressureChanged(bool)), this, SLOT(onMemoryPressureChanged(bool)));
+    connect(appSettings, SIGNAL(memoryCeilingChanged(int)), memoryPressureMonitor, SLOT(setResidentSetCeiling(int)));
+    memoryPressureMonitor->setResidentSetCeiling(appSettings->memoryCeiling());
+
     toggleHideMenuBarInFullScreen(appSettings->hideMenuBarInFullScreenEnabled());
     menuBarMenuActivated = false;
 
     qApp->installEventFilter(this);
+
+    if (nullptr == htmlPreview) {
+        QTimer::singleShot
+        (
+            GW_PREVIEW_PREWARM_DELAY,
+            this,
+            [this]() {
+                createHtmlPreview();
+            }
+        );
+    }
 }
 
 MainWindow::~MainWindow()
@@ -432,6 +699,29 @@ void MainWindow::keyPressEvent(QKeyEvent *e)
 
 bool MainWindow::eventFilter(QObject *obj, QEvent *event)
 {
+    // Finish the warm start right after the text of the document is first
+    // painted.
+    if
+    (
+        warmStartPending
+        && !firstTextPainted
+        && (QEvent::Paint == event->type())
+        && (editor->viewport() == obj)
+        && (editor->document()->characterCount() > 1)
+    ) {
+        firstTextPainted = true;
+
+        QTimer::singleShot
+        (
+            0,
+            this,
+            [this]() {
+                StartupProfiler::markFirstText();
+                finishWarmStart();
+            }
+        );
+    }
+
     if (this->isFullScreen() && appSettings->hideMenuBarInFullScreenEnabled()) {
         if ((this->menuBar() == obj) 
                 && (QEvent::Leave == event->type()) 
@@ -452,6 +742,39 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
     return false;
 }
 
+void MainWindow::changeEvent(QEvent *event)
+{
+    if
+    (
+        (QEvent::ActivationChange == event->type())
+        || (QEvent::WindowStateChange == event->type())
+    ) {
+        updatePowerSaving();
+    }
+
+    QMainWindow::changeEvent(event);
+}
+
+void MainWindow::openRequestedFile(const QString &filePath)
+{
+    if (isMinimized()) {
+        setWindowState((windowState() & ~Qt::WindowMinimized) | Qt::WindowActive);
+    }
+
+    raise();
+    activateWindow();
+
+    MarkdownDocument *document = editor->document();
+
+    if
+    (
+        !filePath.isEmpty()
+        && (document->isNew() || (document->filePath() != filePath))
+    ) {
+        documentManager->open(filePath);
+    }
+}
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     if (documentManager->close()) {
@@ -477,7 +800,9 @@ void MainWindow::quitApplication()
 
         this->editor->document()->disconnect();
         this->editor->disconnect();
-        this->htmlPreview->disconnect();
+        if (nullptr != this->htmlPreview) {
+            this->htmlPreview->disconnect();
+        }
 
         qApp->quit();
     }
@@ -494,11 +819,20 @@ void MainWindow::changeTheme()
         &ThemeSelectionDialog::finished,
         [this, themeDialog](int result) {
             Q_UNUSED(result)
+            themePreviewSettleTimer->stop();
             this->theme = themeDialog->theme();
             applyTheme();
         }
     );
 
+    this->connect
+    (
+        themeDialog,
+        &ThemeSelectionDialog::themePreviewed,
+        this,
+        &MainWindow::previewTheme
+    );
+
     themeDialog->open();
 }
 
@@ -515,12 +849,21 @@ void MainWindow::toggleHtmlPreview(bool checked)
     htmlPreviewMenuAction->blockSignals(true);
 
     htmlPreviewMenuAction->setChecked(checked);
-    htmlPreview->setVisible(checked);
-    htmlPreview->updatePreview();
+    appSettings->setHtmlPreviewVisible(checked);
+
+    if (checked) {
+        createHtmlPreview();
+    }
+
+    if (nullptr != htmlPreview) {
+        htmlPreview->setVisible(checked);
+        updateHtmlRendering();
+        htmlPreview->updatePreview();
+    }
+
     adjustEditorWidth(this->width());
 
     htmlPreviewMenuAction->blockSignals(false);
-    appSettings->setHtmlPreviewVisible(checked);
 }
 
 void MainWindow::toggleHemingwayMode(bool checked)
@@ -543,6 +886,57 @@ void MainWindow::toggleFocusMode(bool checked)
     sidebar->setAutoHideEnabled(checked);
 }
 
+void MainWindow::toggleSplitView(bool checked)
+{
+    if (checked == (nullptr != splitEditor)) {
+        return;
+    }
+
+    if (!checked) {
+        bool hadFocus = splitEditor->hasFocus();
+
+        delete splitEditor;
+        splitEditor = nullptr;
+
+        if (hadFocus) {
+            editor->setFocus();
+        }
+
+        return;
+    }
+
+    // The view shares the editor's document, layout, highlighter and AST,
+    // as well as the document statistics computed from the document.
+    // Stacking the views keeps them the same width, which the document
+    // layout that they share requires.
+    //
+    splitEditor = new MarkdownEditor(editor, editorSplitter);
+    splitEditor->verticalScrollBar()->setStyle(new QCommonStyle());
+    splitEditor->horizontalScrollBar()->setStyle(new QCommonStyle());
+    splitEditor->setStyleSheet(editor->styleSheet());
+    splitEditor->addActions(editor->actions());
+    editorSplitter->addWidget(splitEditor);
+
+    connect(splitEditor, SIGNAL(textSelected(int, int)), documentStats, SLOT(onTextSelected(int, int)));
+    connect(splitEditor, SIGNAL(textDeselected()), documentStats, SLOT(onTextDeselected()));
+
+    QTextCursor cursor = editor->textCursor();
+    cursor.clearSelection();
+    splitEditor->setTextCursor(cursor);
+    splitEditor->setFocus();
+
+    // Set up the view's margins once the splitter has given it its width.
+    QTimer::singleShot
+    (
+        0,
+        splitEditor,
+        [this]() {
+            splitEditor->setupPaperMargins();
+            splitEditor->centerCursor();
+        }
+    );
+}
+
 void MainWindow::toggleFullScreen(bool checked)
 {
     static bool lastStateWasMaximized = false;
@@ -639,6 +1033,18 @@ void MainWindow::changeInterfaceStyle(InterfaceStyle style)
     applyTheme();
 }
 
+void MainWindow::showJumpDialog()
+{
+    JumpDialog *dialog = new JumpDialog(activeEditor(), headingIndex, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+
+    // Drop the palette down from the top of the window, like the menus.
+    int width = qMin(this->width(), qMax(400, this->width() / 2));
+    dialog->resize(width, this->height() / 2);
+    dialog->move(mapToGlobal(QPoint((this->width() - width) / 2, menuBar()->height())));
+    dialog->show();
+}
+
 void MainWindow::insertImage()
 {
     QString startingDirectory = QString();
@@ -693,6 +1099,95 @@ void MainWindow::showWikiPage()
     QDesktopServices::openUrl(QUrl("https://github.com/wereturtle/ghostwriter/wiki"));
 }
 
+// Returns the view of the document that has the focus, or else the editor.
+//
+MarkdownEditor *MainWindow::activeEditor() const
+{
+    if ((nullptr != splitEditor) && splitEditor->hasFocus()) {
+        return splitEditor;
+    }
+
+    return editor;
+}
+
+void MainWindow::toggleLatencyMonitor(bool checked)
+{
+    editor->latencyMonitor()->setEnabled(checked);
+    latencyLabelTimer->stop();
+    updateLatencyLabel();
+    latencyLabel->setVisible(checked);
+}
+
+void MainWindow::updateLatencyLabel()
+{
+    LatencyMonitor *monitor = editor->latencyMonitor();
+
+    if (monitor->sampleCount() <= 0) {
+        latencyLabel->setText(tr("Latency: start typing"));
+        return;
+    }
+
+    latencyLabel->setText
+    (
+        tr("Latency p50 %1 ms, p95 %2 ms, p99 %3 ms")
+            .arg(monitor->percentile(0.50))
+            .arg(monitor->percentile(0.95))
+            .arg(monitor->percentile(0.99))
+    );
+}
+
+void MainWindow::onMemoryPressureChanged(bool underPressure)
+{
+    // Sweeps only get ahead of what the writer will look at next, so they
+    // can wait until memory is available again.
+    editor->setBackgroundSweepPaused(underPressure);
+    TaskScheduler::instance()->setLaneSuspended(TaskScheduler::Indexing, underPressure);
+
+    if (!underPressure) {
+        return;
+    }
+
+    qWarning() << "Memory is under pressure, releasing caches";
+
+    editor->releaseCaches();
+    DictionaryManager::instance().releaseCaches();
+
+    if (nullptr != htmlPreview) {
+        htmlPreview->releaseMemory();
+    }
+}
+
+// Keeps timers from waking up the application while the window is in the
+// background, so that it idles at next to no CPU.  The cursor blink,
+// typing pause and clock timers are cosmetic, and the session statistics
+// catch up once the window is active again.  Autosave keeps running.
+//
+void MainWindow::updatePowerSaving()
+{
+    bool enabled = this->isMinimized() || !this->isActiveWindow();
+
+    if (enabled == powerSaving) {
+        return;
+    }
+
+    powerSaving = enabled;
+    editor->setPowerSavingEnabled(enabled);
+    sessionStats->setPowerSavingEnabled(enabled);
+    timeLabel->setPowerSavingEnabled(enabled);
+}
+
+void MainWindow::showMemoryReport()
+{
+    MemoryReport report(documentManager->document(), htmlPreview);
+
+    MessageBoxHelper::information
+    (
+        this,
+        tr("Memory usage of the open document"),
+        QString("<pre>") + report.toString().toHtmlEscaped() + QString("</pre>")
+    );
+}
+
 void MainWindow::showAbout()
 {
     QString aboutText =
@@ -739,8 +1234,8 @@ void MainWindow::changeFocusMode(FocusMode focusMode)
 void MainWindow::refreshRecentFiles()
 {
     if (appSettings->fileHistoryEnabled()) {
-        DocumentHistory history;
-        QStringList recentFiles = history.recentFiles(MAX_RECENT_FILES + 1);
+        QStringList recentFiles =
+            DocumentHistory::instance()->recentFiles(MAX_RECENT_FILES + 1);
         MarkdownDocument *document = documentManager->document();
 
         if (!document->isNew()) {
@@ -763,8 +1258,7 @@ void MainWindow::refreshRecentFiles()
 
 void MainWindow::clearRecentFileHistory()
 {
-    DocumentHistory history;
-    history.clear();
+    DocumentHistory::instance()->clear();
 
     for (int i = 0; i < MAX_RECENT_FILES; i++) {
         recentFilesActions[i]->setVisible(false);
@@ -790,6 +1284,16 @@ void MainWindow::onOperationStarted(const QString &description)
 
     wordCountLabel->hide();
     statusLabel->show();
+    if (documentManager->isLoading()) {
+        cancelLoadButton->setToolTip(tr("Cancel opening the file"));
+        cancelLoadButton->show();
+    } else if (documentManager->isExporting()) {
+        cancelLoadButton->setToolTip(tr("Cancel exporting"));
+        cancelLoadButton->show();
+    } else {
+        cancelLoadButton->hide();
+    }
+
     this->update();
     qApp->processEvents();
 }
@@ -799,6 +1303,7 @@ void MainWindow::onOperationFinished()
     statusLabel->setText(QString());
     wordCountLabel->show();
     statusLabel->hide();
+    cancelLoadButton->hide();
     this->update();
     qApp->processEvents();
 }
@@ -851,34 +1356,154 @@ void MainWindow::copyHtml()
 {
     Exporter *htmlExporter = appSettings->currentHtmlExporter();
 
-    if (nullptr != htmlExporter) {
-        QTextCursor c = editor->textCursor();
-        QString markdownText;
-        QString html;
+    if (nullptr == htmlExporter) {
+        return;
+    }
 
-        if (c.hasSelection()) {
-            // Get only selected text from the document.
-            markdownText = c.selection().toPlainText();
-        } else {
-            // Get all text from the document.
-            markdownText = editor->toPlainText();
+    MarkdownDocument *document = documentManager->document();
+    QTextCursor c = editor->textCursor();
+    bool smartTypographyEnabled = htmlExporter->smartTypographyEnabled();
+    QString markdownText;
+    QString html;
+
+    if (c.hasSelection()) {
+        QTextBlock first = document->findBlock(c.selectionStart());
+        QTextBlock last = document->findBlock(c.selectionEnd());
+
+        // A selection ending at the start of a line ends with the line
+        // before it.
+        if ((last != first) && (c.selectionEnd() == last.position())) {
+            last = last.previous();
         }
 
-        // Convert Markdown to HTML.
-        htmlExporter->exportToHtml(markdownText, html);
+        // Serve selections of whole lines from the HTML blocks of the
+        // preview, if they cover whole blocks.
+        if
+        (
+            (c.selectionStart() == first.position())
+            && (c.selectionEnd() >= (last.position() + last.length() - 1))
+        ) {
+            while ((first != last) && first.text().trimmed().isEmpty()) {
+                first = first.next();
+            }
 
-        // Insert HTML into clipboard.
-        QClipboard *clipboard = QApplication::clipboard();
-        clipboard->setText(html);
-    }
-}
+            while ((last != first) && last.text().trimmed().isEmpty()) {
+                last = last.previous();
+            }
 
-void MainWindow::showPreviewOptions()
-{
-    static PreviewOptionsDialog *dialog = new PreviewOptionsDialog(this);
-    
-    dialog->setModal(false);
-    dialog->show();
+            if
+            (
+                document->previewHtml
+                (
+                    htmlExporter,
+                    smartTypographyEnabled,
+                    first.blockNumber() + 1,
+                    last.blockNumber() + 1,
+                    html
+                )
+            ) {
+                copyHtmlWatcher->cancel();
+                setClipboardHtml(html);
+                return;
+            }
+        }
+
+        // Get only selected text from the document.
+        markdownText = c.selection().toPlainText();
+    } else {
+        QStringList blocks;
+
+        if (document->previewHtml(htmlExporter, smartTypographyEnabled, blocks)) {
+            copyHtmlWatcher->cancel();
+            setClipboardHtml(blocks.join('\n'));
+            return;
+        }
+
+        // Get all text from the document.
+        markdownText = document->plainTextSnapshot();
+    }
+
+    // Convert Markdown to HTML in the background, since the exporter may
+    // run an external processor such as Pandoc.  A copy started while
+    // another is rendering replaces it.
+    //
+    QFuture<QString> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Interactive,
+            [htmlExporter, markdownText]() {
+                QString html;
+                htmlExporter->exportToHtml(markdownText, html);
+                return html;
+            }
+        );
+
+    copyHtmlWatcher->setFuture(future);
+    onOperationStarted(tr("copying HTML"));
+}
+
+void MainWindow::onHtmlCopied()
+{
+    if (copyHtmlWatcher->isCanceled()) {
+        return;
+    }
+
+    setClipboardHtml(copyHtmlWatcher->result());
+}
+
+void MainWindow::setClipboardHtml(const QString &html)
+{
+    // Insert HTML into clipboard.
+    QApplication::clipboard()->setText(html);
+
+    QString notice = tr("HTML copied to clipboard");
+    onOperationStarted(notice);
+
+    // Leave the notice up for a moment, unless another operation
+    // replaces it first.
+    QTimer::singleShot
+    (
+        HTML_COPIED_NOTICE_DURATION,
+        this,
+        [this, notice]() {
+            if (statusLabel->isVisible() && (statusLabel->text() == notice)) {
+                onOperationFinished();
+            }
+        }
+    );
+}
+
+void MainWindow::exportSessionLog()
+{
+    QString filePath =
+        QFileDialog::getSaveFileName
+        (
+            this,
+            tr("Export Session Log"),
+            QString(),
+            QString("%1 (*.csv);;%2 (*)").arg(tr("CSV")).arg(tr("All"))
+        );
+
+    if (!filePath.isNull() && !filePath.isEmpty()) {
+        QString err;
+
+        if (!sessionStats->exportCsv(filePath, err)) {
+            MessageBoxHelper::critical
+            (
+                this,
+                tr("Failed to export session log to %1").arg(filePath),
+                err
+            );
+        }
+    }
+}
+
+void MainWindow::showPreviewOptions()
+{
+    static PreviewOptionsDialog *dialog = new PreviewOptionsDialog(this);
+    
+    dialog->setModal(false);
+    dialog->show();
 }
 
 void MainWindow::onAboutToHideMenuBarMenu()
@@ -909,9 +1534,9 @@ void MainWindow::onSidebarVisibilityChanged(bool visible)
     this->adjustEditorWidth(this->width());
 
     if (visible) {
-        toggleSidebarButton->setText(QChar(fa::chevronleft));
+        glyphIcons->setGlyph(toggleSidebarButton, style::stfas, fa::chevronleft, true);
     } else {
-        toggleSidebarButton->setText(QChar(fa::chevronright));
+        glyphIcons->setGlyph(toggleSidebarButton, style::stfas, fa::chevronright, true);
     }
 
     if (!visible) {
@@ -959,8 +1584,27 @@ QAction* MainWindow::createWidgetAction
     QAction* action = new QAction(text, receiver);
     action->setShortcut(shortcut);
     action->setShortcutContext(Qt::WidgetWithChildrenShortcut);
-    
-    connect(action, SIGNAL(triggered(bool)), receiver, member);
+
+    // Editor actions apply to whichever view of the document has focus.
+    // The views are also given the actions, so that their shortcuts work
+    // in each view.
+    //
+    if (receiver == editor) {
+        QByteArray method(member + 1);
+        method.truncate(method.indexOf('('));
+
+        this->connect
+        (
+            action,
+            &QAction::triggered,
+            [this, method]() {
+                QMetaObject::invokeMethod(this->activeEditor(), method.constData());
+            }
+        );
+    } else {
+        connect(action, SIGNAL(triggered(bool)), receiver, member);
+    }
+
     receiver->addAction(action);
 
     return action;
@@ -994,6 +1638,7 @@ void MainWindow::buildMenuBar()
     fileMenu->addAction(createWindowAction(tr("Re&load from Disk..."), documentManager, SLOT(reload())));
     fileMenu->addSeparator();
     fileMenu->addAction(createWindowAction(tr("&Export"), documentManager, SLOT(exportFile()), QKeySequence("CTRL+E")));
+    fileMenu->addAction(createWindowAction(tr("Export Session &Log..."), this, SLOT(exportSessionLog())));
     fileMenu->addSeparator();
     QAction *quitAction = createWindowAction(tr("&Quit"), this, SLOT(quitApplication()), QKeySequence::Quit);
     quitAction->setMenuRole(QAction::QuitRole);
@@ -1015,6 +1660,7 @@ void MainWindow::buildMenuBar()
     editMenu->addAction(createWindowAction(tr("Rep&lace"), findReplace, SLOT(showReplaceView()), QKeySequence::Replace));
     editMenu->addAction(createWindowAction(tr("Find &Next"), findReplace, SLOT(findNext()), QKeySequence::FindNext));
     editMenu->addAction(createWindowAction(tr("Find &Previous"), findReplace, SLOT(findPrevious()), QKeySequence::FindPrevious));
+    editMenu->addAction(createWindowAction(tr("&Jump to Heading or Line..."), this, SLOT(showJumpDialog()), QKeySequence("CTRL+L")));
     editMenu->addSeparator();
     editMenu->addAction(createWindowAction(tr("&Spell check"), editor, SLOT(runSpellChecker())));
 
@@ -1040,6 +1686,8 @@ void MainWindow::buildMenuBar()
     formatMenu->addSeparator();
     formatMenu->addAction(createWidgetAction(tr("&Task List"), editor, SLOT(createTaskList()), QKeySequence("Ctrl+T")));
     formatMenu->addAction(createWidgetAction(tr("Toggle Task(s) &Complete"), editor, SLOT(toggleTaskComplete()), QKeySequence("Ctrl+D")));
+    formatMenu->addSeparator();
+    formatMenu->addAction(createWidgetAction(tr("Align Ta&ble Columns"), editor, SLOT(formatTable()), QKeySequence()));
 
 
     QMenu *viewMenu = this->menuBar()->addMenu(tr("&View"));
@@ -1052,6 +1700,15 @@ void MainWindow::buildMenuBar()
     connect(fullScreenMenuAction, SIGNAL(toggled(bool)), this, SLOT(toggleFullScreen(bool)));
     viewMenu->addAction(fullScreenMenuAction);
     
+    viewMenu->addSeparator();
+    viewMenu->addAction(createWidgetAction(tr("Fold/Unfold Secti&on"), editor, SLOT(toggleFold()), QKeySequence("Ctrl+Shift+[")));
+    viewMenu->addAction(createWidgetAction(tr("U&nfold All Sections"), editor, SLOT(unfoldAll()), QKeySequence("Ctrl+Shift+]")));
+    viewMenu->addSeparator();
+
+    QAction *splitViewAction = createWindowAction(tr("Spli&t View"), this, SLOT(toggleSplitView(bool)), QKeySequence("CTRL+\\"));
+    splitViewAction->setCheckable(true);
+    viewMenu->addAction(splitViewAction);
+    
     htmlPreviewMenuAction = createWindowAction(tr("&Preview in HTML"), this, SLOT(toggleHtmlPreview(bool)), QKeySequence("CTRL+P"));
     htmlPreviewMenuAction->setCheckable(true);
     htmlPreviewMenuAction->setChecked(appSettings->htmlPreviewVisible());
@@ -1088,6 +1745,15 @@ void MainWindow::buildMenuBar()
     showSidebarTabAction->setShortcutContext(Qt::WindowShortcut);
     this->addAction(showSidebarTabAction);
 
+    showSidebarTabAction = viewMenu->addAction(tr("&Project Statistics"),
+        this,
+        [this]() {
+            sidebar->setVisible(true);
+            sidebar->setCurrentTabIndex(ProjectStatsSidebarTab);
+        });
+    showSidebarTabAction->setShortcutContext(Qt::WindowShortcut);
+    this->addAction(showSidebarTabAction);
+
     showSidebarTabAction = viewMenu->addAction(tr("&Cheat Sheet"),
         this,
         [this]() {
@@ -1097,10 +1763,54 @@ void MainWindow::buildMenuBar()
         QKeySequence::HelpContents);
     showSidebarTabAction->setShortcutContext(Qt::WindowShortcut);
     this->addAction(showSidebarTabAction);
+
+    showSidebarTabAction = viewMenu->addAction(tr("F&iles"),
+        this,
+        [this]() {
+            sidebar->setVisible(true);
+            sidebar->setCurrentTabIndex(ProjectTreeSidebarTab);
+        });
+    showSidebarTabAction->setShortcutContext(Qt::WindowShortcut);
+    this->addAction(showSidebarTabAction);
+
+    showSidebarTabAction = viewMenu->addAction(tr("Find in &Folder"),
+        this,
+        [this]() {
+            sidebar->setVisible(true);
+            sidebar->setCurrentTabIndex(FolderSearchSidebarTab);
+            folderSearchWidget->setFocus();
+        },
+        QKeySequence("SHIFT+CTRL+F"));
+    showSidebarTabAction->setShortcutContext(Qt::WindowShortcut);
+    this->addAction(showSidebarTabAction);
+
+    showSidebarTabAction = viewMenu->addAction(tr("St&yle Check"),
+        this,
+        [this]() {
+            sidebar->setVisible(true);
+            sidebar->setCurrentTabIndex(LintSidebarTab);
+        });
+    showSidebarTabAction->setShortcutContext(Qt::WindowShortcut);
+    this->addAction(showSidebarTabAction);
+
+    showSidebarTabAction = viewMenu->addAction(tr("&Tasks"),
+        this,
+        [this]() {
+            sidebar->setVisible(true);
+            sidebar->setCurrentTabIndex(TasksSidebarTab);
+        });
+    showSidebarTabAction->setShortcutContext(Qt::WindowShortcut);
+    this->addAction(showSidebarTabAction);
     
     viewMenu->addSeparator();
     viewMenu->addAction(createWidgetAction(tr("Increase Font Size"), editor, SLOT(increaseFontSize()), QKeySequence("CTRL+=")));
     viewMenu->addAction(createWidgetAction(tr("Decrease Font Size"), editor, SLOT(decreaseFontSize()), QKeySequence("CTRL+-")));
+    viewMenu->addSeparator();
+
+    QAction *latencyAction = viewMenu->addAction(tr("Show Typing &Latency"));
+    latencyAction->setCheckable(true);
+    latencyAction->setChecked(false);
+    connect(latencyAction, SIGNAL(toggled(bool)), this, SLOT(toggleLatencyMonitor(bool)));
 
     QMenu *settingsMenu = this->menuBar()->addMenu(tr("&Settings"));
     settingsMenu->addAction(createWindowAction(tr("Themes..."), this, SLOT(changeTheme())));
@@ -1120,6 +1830,8 @@ void MainWindow::buildMenuBar()
     helpMenu->addAction(helpAction);
     helpMenu->addAction(createWindowAction(tr("Quick &Reference Guide"), this, SLOT(showQuickReferenceGuide())));
     helpMenu->addAction(createWindowAction(tr("Wiki"), this, SLOT(showWikiPage())));
+    helpMenu->addSeparator();
+    helpMenu->addAction(createWindowAction(tr("&Memory Usage"), this, SLOT(showMemoryReport())));
 
     connect(fileMenu, SIGNAL(aboutToShow()), this, SLOT(onAboutToShowMenuBarMenu()));
     connect(fileMenu, SIGNAL(aboutToHide()), this, SLOT(onAboutToHideMenuBarMenu()));
@@ -1165,11 +1877,9 @@ void MainWindow::buildStatusBar()
     rightLayout->setMargin(0);
 
     // Add left-most widgets to status bar.
-    QFont buttonFont(this->awesome->font(style::stfas, 16));
-
-    toggleSidebarButton = new QPushButton(QChar(fa::chevronright));
+    toggleSidebarButton = new QPushButton();
     toggleSidebarButton->setObjectName("showSidebarButton");
-    toggleSidebarButton->setFont(buttonFont);
+    glyphIcons->setGlyph(toggleSidebarButton, style::stfas, fa::chevronright, true);
     toggleSidebarButton->setFocusPolicy(Qt::NoFocus);
     toggleSidebarButton->setToolTip(tr("Toggle sidebar"));
     toggleSidebarButton->setCheckable(false);
@@ -1179,7 +1889,7 @@ void MainWindow::buildStatusBar()
     statusBarWidgets.append(toggleSidebarButton);
 
     if (appSettings->sidebarVisible()) {
-        toggleSidebarButton->setText(QChar(fa::chevronleft));
+        glyphIcons->setGlyph(toggleSidebarButton, style::stfas, fa::chevronleft, true);
     }
 
     this->connect(toggleSidebarButton,
@@ -1205,19 +1915,73 @@ void MainWindow::buildStatusBar()
     midLayout->addWidget(statusLabel, 0, Qt::AlignCenter);
     statusLabel->hide();
 
+    cancelLoadButton = new QPushButton();
+    glyphIcons->setGlyph(cancelLoadButton, style::stfas, fa::timescircle);
+    cancelLoadButton->setFocusPolicy(Qt::NoFocus);
+    cancelLoadButton->setToolTip(tr("Cancel opening the file"));
+
+    this->connect
+    (
+        cancelLoadButton,
+        &QPushButton::clicked,
+        [this]() {
+            if (documentManager->isLoading()) {
+                documentManager->cancelLoad();
+            } else {
+                documentManager->cancelExports();
+            }
+        }
+    );
+
+    midLayout->addWidget(cancelLoadButton, 0, Qt::AlignCenter);
+    statusBarWidgets.append(cancelLoadButton);
+    cancelLoadButton->hide();
+
     wordCountLabel = new QLabel();
     wordCountLabel->setAlignment(Qt::AlignCenter);
     wordCountLabel->setFrameShape(QFrame::NoFrame);
     wordCountLabel->setLineWidth(0);
     updateWordCount(0);
     midLayout->addWidget(wordCountLabel, 0, Qt::AlignCenter);
+
+    largeDocumentLabel = new QLabel();
+    largeDocumentLabel->setAlignment(Qt::AlignCenter);
+    largeDocumentLabel->setFrameShape(QFrame::NoFrame);
+    largeDocumentLabel->setLineWidth(0);
+    largeDocumentLabel->hide();
+    midLayout->addWidget(largeDocumentLabel, 0, Qt::AlignCenter);
+    statusBarWidgets.append(largeDocumentLabel);
+
+    latencyLabel = new QLabel();
+    latencyLabel->setAlignment(Qt::AlignCenter);
+    latencyLabel->setFrameShape(QFrame::NoFrame);
+    latencyLabel->setLineWidth(0);
+    latencyLabel->hide();
+    midLayout->addWidget(latencyLabel, 0, Qt::AlignCenter);
+    statusBarWidgets.append(latencyLabel);
+
+    latencyLabelTimer = new QTimer(this);
+    latencyLabelTimer->setSingleShot(true);
+    latencyLabelTimer->setInterval(LATENCY_LABEL_INTERVAL);
+    connect(latencyLabelTimer, SIGNAL(timeout()), this, SLOT(updateLatencyLabel()));
+
+    this->connect
+    (
+        editor->latencyMonitor(),
+        &LatencyMonitor::measured,
+        [this]() {
+            if (!latencyLabelTimer->isActive()) {
+                latencyLabelTimer->start();
+            }
+        }
+    );
     midWidget->setContentsMargins(0, 0, 0, 0);
     statusBarLayout->addWidget(midWidget, 1, 1, 1, 1, Qt::AlignCenter);
     statusBarWidgets.append(wordCountLabel);
 
     // Add right-most widgets to status bar.
-    QPushButton *button = new QPushButton(QChar(fa::moon));
-    button->setFont(buttonFont);
+    QPushButton *button = new QPushButton();
+    glyphIcons->setGlyph(button, style::stfas, fa::moon);
     button->setFocusPolicy(Qt::NoFocus);
     button->setToolTip(tr("Toggle dark mode"));
     button->setCheckable(true);
@@ -1236,8 +2000,8 @@ void MainWindow::buildStatusBar()
     rightLayout->addWidget(button, 0, Qt::AlignRight);
     statusBarWidgets.append(button);
 
-    button = new QPushButton(QChar(fa::code));
-    button->setFont(buttonFont);
+    button = new QPushButton();
+    glyphIcons->setGlyph(button, style::stfas, fa::code);
     button->setFocusPolicy(Qt::NoFocus);
     button->setToolTip(tr("Toggle Live HTML Preview"));
     button->setCheckable(true);
@@ -1257,8 +2021,8 @@ void MainWindow::buildStatusBar()
         }
     );
 
-    button = new QPushButton(QChar(fa::backspace));
-    button->setFont(buttonFont);
+    button = new QPushButton();
+    glyphIcons->setGlyph(button, style::stfas, fa::backspace);
     button->setFocusPolicy(Qt::NoFocus);
     button->setToolTip(tr("Toggle Hemingway mode"));
     button->setCheckable(true);
@@ -1266,8 +2030,8 @@ void MainWindow::buildStatusBar()
     rightLayout->addWidget(button, 0, Qt::AlignRight);
     statusBarWidgets.append(button);
 
-    button = new QPushButton(QChar(fa::headphonesalt));
-    button->setFont(buttonFont);
+    button = new QPushButton();
+    glyphIcons->setGlyph(button, style::stfas, fa::headphonesalt);
     button->setFocusPolicy(Qt::NoFocus);
     button->setToolTip(tr("Toggle distraction free mode"));
     button->setCheckable(true);
@@ -1275,8 +2039,8 @@ void MainWindow::buildStatusBar()
     rightLayout->addWidget(button, 0, Qt::AlignRight);
     statusBarWidgets.append(button);
 
-    button = new QPushButton(QChar(fa::expand));
-    button->setFont(buttonFont);
+    button = new QPushButton();
+    glyphIcons->setGlyph(button, style::stfas, fa::expand);
     button->setFocusPolicy(Qt::NoFocus);
     button->setObjectName("fullscreenButton");
     button->setToolTip(tr("Toggle full screen mode"));
@@ -1339,6 +2103,11 @@ void MainWindow::buildSidebar()
     cheatSheetWidget->addItem(tr("![Image](./image.jpg \"Title\")"));
     cheatSheetWidget->addItem(tr("--- *** ___ Horizontal Rule"));
 
+    projectTreeWidget = new ProjectTreeWidget();
+    projectTreeWidget->setAlternatingRowColors(false);
+
+    folderSearchWidget = new FolderSearchWidget();
+
     documentStatsWidget = new DocumentStatisticsWidget();
     documentStatsWidget->setSelectionMode(QAbstractItemView::NoSelection);
     documentStatsWidget->setAlternatingRowColors(false);
@@ -1347,24 +2116,61 @@ void MainWindow::buildSidebar()
     sessionStatsWidget->setSelectionMode(QAbstractItemView::NoSelection);
     sessionStatsWidget->setAlternatingRowColors(false);
 
+    projectStatsWidget = new ProjectStatisticsWidget();
+    projectStatsWidget->setSelectionMode(QAbstractItemView::NoSelection);
+    projectStatsWidget->setAlternatingRowColors(false);
+
     outlineWidget = new OutlineWidget(editor, this);
     outlineWidget->setAlternatingRowColors(false);
+    headingIndex = new HeadingIndex((MarkdownDocument *) editor->document());
 
     documentStats = new DocumentStatistics((MarkdownDocument *) editor->document(), this);
-    connect(documentStats, SIGNAL(wordCountChanged(int)), documentStatsWidget, SLOT(setWordCount(int)));
-    connect(documentStats, SIGNAL(characterCountChanged(int)), documentStatsWidget, SLOT(setCharacterCount(int)));
-    connect(documentStats, SIGNAL(sentenceCountChanged(int)), documentStatsWidget, SLOT(setSentenceCount(int)));
-    connect(documentStats, SIGNAL(paragraphCountChanged(int)), documentStatsWidget, SLOT(setParagraphCount(int)));
-    connect(documentStats, SIGNAL(pageCountChanged(int)), documentStatsWidget, SLOT(setPageCount(int)));
-    connect(documentStats, SIGNAL(complexWordsChanged(int)), documentStatsWidget, SLOT(setComplexWords(int)));
-    connect(documentStats, SIGNAL(readingTimeChanged(int)), documentStatsWidget, SLOT(setReadingTime(int)));
-    connect(documentStats, SIGNAL(lixReadingEaseChanged(int)), documentStatsWidget, SLOT(setLixReadingEase(int)));
-    connect(documentStats, SIGNAL(readabilityIndexChanged(int)), documentStatsWidget, SLOT(setReadabilityIndex(int)));
-    connect(editor, SIGNAL(textSelected(QString, int, int)), documentStats, SLOT(onTextSelected(QString, int, int)));
+    connect(documentStats, &DocumentStatistics::statisticsChanged, documentStatsWidget, &DocumentStatisticsWidget::setStatistics);
+    connect(editor, SIGNAL(textSelected(int, int)), documentStats, SLOT(onTextSelected(int, int)));
     connect(editor, SIGNAL(textDeselected()), documentStats, SLOT(onTextDeselected()));
+    outlineWidget->setDocumentStatistics(documentStats);
+    documentStatsWidget->setVocabularyIndex(((MarkdownDocument *) editor->document())->vocabularyIndex());
+
+    projectStats = new ProjectStatistics(this);
+    connect(projectStats, &ProjectStatistics::statisticsChanged, projectStatsWidget, &ProjectStatisticsWidget::setStatistics);
+    this->connect
+    (
+        documentStats,
+        &DocumentStatistics::statisticsChanged,
+        [this](const DocumentStatistics::Statistics &statistics) {
+            projectStats->setOpenDocumentWordCount(statistics.totalWordCount);
+        }
+    );
+
+    linter = new MarkdownLinter((MarkdownDocument *) editor->document(), this);
+    linter->setMaxLineLength(appSettings->lintLineLength());
+    linter->setEnabled(appSettings->lintEnabled());
+    connect(linter, &MarkdownLinter::warningsChanged, editor, &MarkdownEditor::rehighlightLines);
+
+    readabilityAnalyzer = new ReadabilityAnalyzer((MarkdownDocument *) editor->document(), this);
+    readabilityAnalyzer->setEnabled(appSettings->readabilityHighlightEnabled());
+    connect(readabilityAnalyzer, &ReadabilityAnalyzer::difficultSentencesChanged, editor, &MarkdownEditor::rehighlightLines);
+
+    linkChecker = new LinkChecker((MarkdownDocument *) editor->document(), this);
+    linkChecker->setRemoteCheckEnabled(appSettings->lintWebLinksEnabled());
+    linkChecker->setEnabled(appSettings->lintEnabled());
+
+    lintWidget = new LintWidget(linter, linkChecker, editor, this);
+    lintWidget->setAlternatingRowColors(false);
+
+    taskIndex = new TaskIndex((MarkdownDocument *) editor->document(), this);
+    taskListWidget = new TaskListWidget(taskIndex, editor, this);
+    taskListWidget->setAlternatingRowColors(false);
 
     sessionStats = new SessionStatistics(this);
-    connect(documentStats, SIGNAL(totalWordCountChanged(int)), sessionStats, SLOT(onDocumentWordCountChanged(int)));
+    this->connect
+    (
+        documentStats,
+        &DocumentStatistics::statisticsChanged,
+        [this](const DocumentStatistics::Statistics &statistics) {
+            sessionStats->onDocumentWordCountChanged(statistics.totalWordCount);
+        }
+    );
     connect(sessionStats, SIGNAL(wordCountChanged(int)), sessionStatsWidget, SLOT(setWordCount(int)));
     connect(sessionStats, SIGNAL(pageCountChanged(int)), sessionStatsWidget, SLOT(setPageCount(int)));
     connect(sessionStats, SIGNAL(wordsPerMinuteChanged(int)), sessionStatsWidget, SLOT(setWordsPerMinute(int)));
@@ -1378,29 +2184,50 @@ void MainWindow::buildSidebar()
     sidebar->setMaximumWidth(0.33 * QGuiApplication::primaryScreen()->availableSize().width());
 
     QPushButton *tabButton = new QPushButton();
-    tabButton->setFont(this->awesome->font(style::stfas, 16));
-    tabButton->setText(QChar(fa::hashtag));
+    glyphIcons->setGlyph(tabButton, style::stfas, fa::hashtag, true, 22);
     tabButton->setToolTip(tr("Outline"));
     sidebar->addTab(tabButton, outlineWidget);
 
     tabButton = new QPushButton();
-    tabButton->setFont(this->awesome->font(style::stfas, 16));
-    tabButton->setText(QChar(fa::tachometeralt));
+    glyphIcons->setGlyph(tabButton, style::stfas, fa::tachometeralt, true, 22);
     tabButton->setToolTip(tr("Session Statistics"));
     sidebar->addTab(tabButton, sessionStatsWidget);
 
     tabButton = new QPushButton();
-    tabButton->setFont(this->awesome->font(style::stfas, 16));
-    tabButton->setText(QChar(fa::chartbar));
+    glyphIcons->setGlyph(tabButton, style::stfas, fa::chartbar, true, 22);
     tabButton->setToolTip(tr("Document Statistics"));
     sidebar->addTab(tabButton, documentStatsWidget);
 
     tabButton = new QPushButton();
-    tabButton->setFont(this->awesome->font(style::stfab, 16));
-    tabButton->setText(QChar(fa::markdown));
+    glyphIcons->setGlyph(tabButton, style::stfas, fa::book, true, 22);
+    tabButton->setToolTip(tr("Project Statistics"));
+    sidebar->addTab(tabButton, projectStatsWidget);
+
+    tabButton = new QPushButton();
+    glyphIcons->setGlyph(tabButton, style::stfab, fa::markdown, true, 22);
     tabButton->setToolTip(tr("Cheat Sheet"));
     sidebar->addTab(tabButton, cheatSheetWidget);
 
+    tabButton = new QPushButton();
+    glyphIcons->setGlyph(tabButton, style::stfas, fa::folderopen, true, 22);
+    tabButton->setToolTip(tr("Files"));
+    sidebar->addTab(tabButton, projectTreeWidget);
+
+    tabButton = new QPushButton();
+    glyphIcons->setGlyph(tabButton, style::stfas, fa::search, true, 22);
+    tabButton->setToolTip(tr("Find in Folder"));
+    sidebar->addTab(tabButton, folderSearchWidget);
+
+    tabButton = new QPushButton();
+    glyphIcons->setGlyph(tabButton, style::stfas, fa::clipboardcheck, true, 22);
+    tabButton->setToolTip(tr("Style Check"));
+    sidebar->addTab(tabButton, lintWidget);
+
+    tabButton = new QPushButton();
+    glyphIcons->setGlyph(tabButton, style::stfas, fa::tasks, true, 22);
+    tabButton->setToolTip(tr("Tasks"));
+    sidebar->addTab(tabButton, taskListWidget);
+
     // We need to set an empty style for the scrollbar in order for the
     // scrollbar CSS stylesheet to take full effect.  Otherwise, the scrollbar's
     // background color will have the Windows 98 checkered look rather than
@@ -1412,8 +2239,16 @@ void MainWindow::buildSidebar()
     documentStatsWidget->horizontalScrollBar()->setStyle(new QCommonStyle());
     sessionStatsWidget->verticalScrollBar()->setStyle(new QCommonStyle());
     sessionStatsWidget->horizontalScrollBar()->setStyle(new QCommonStyle());
+    projectStatsWidget->verticalScrollBar()->setStyle(new QCommonStyle());
+    projectStatsWidget->horizontalScrollBar()->setStyle(new QCommonStyle());
     cheatSheetWidget->verticalScrollBar()->setStyle(new QCommonStyle());
     cheatSheetWidget->horizontalScrollBar()->setStyle(new QCommonStyle());
+    projectTreeWidget->verticalScrollBar()->setStyle(new QCommonStyle());
+    projectTreeWidget->horizontalScrollBar()->setStyle(new QCommonStyle());
+    lintWidget->verticalScrollBar()->setStyle(new QCommonStyle());
+    lintWidget->horizontalScrollBar()->setStyle(new QCommonStyle());
+    taskListWidget->verticalScrollBar()->setStyle(new QCommonStyle());
+    taskListWidget->horizontalScrollBar()->setStyle(new QCommonStyle());
 
     int tabIndex = QSettings().value("sidebarCurrentTab", (int)FirstSidebarTab).toInt();
 
@@ -1423,8 +2258,8 @@ void MainWindow::buildSidebar()
 
     sidebar->setCurrentTabIndex(tabIndex);
 
-    QPushButton *button = new QPushButton(QChar(fa::cog));
-    button->setFont(this->awesome->font(style::stfas, 16));
+    QPushButton *button = new QPushButton();
+    glyphIcons->setGlyph(button, style::stfas, fa::cog, true, 22);
     button->setFocusPolicy(Qt::NoFocus);
     button->setToolTip(tr("Settings"));
     button->setCheckable(false);
@@ -1471,7 +2306,7 @@ void MainWindow::adjustEditorWidth(int width)
 
     sidebarSplitterSizes.append(editorWidth);
 
-    if (htmlPreview->isVisible()) {
+    if ((nullptr != htmlPreview) && htmlPreview->isVisible()) {
         editorWidth /= 2;
         previewSplitterSizes.append(editorWidth);
     }
@@ -1480,6 +2315,12 @@ void MainWindow::adjustEditorWidth(int width)
     previewSplitter->setSizes(previewSplitterSizes);
     sidebarSplitter->setSizes(sidebarSplitterSizes);
 
+    // While the window is being resized, the editor keeps the width of its
+    // text, and sets up its margins and scrolls once resizing settles.
+    if (editor->isResizing()) {
+        return;
+    }
+
     // Resize the editor's margins based on the size of the window.
     editor->setupPaperMargins();
 
@@ -1489,7 +2330,7 @@ void MainWindow::adjustEditorWidth(int width)
 
 void MainWindow::applyTheme()
 {
-    if (!theme.name().isNull() && !theme.name().isEmpty()) {
+    if (!themePreviewActive && !theme.name().isNull() && !theme.name().isEmpty()) {
         appSettings->setThemeName(theme.name());
     }
 
@@ -1499,46 +2340,369 @@ void MainWindow::applyTheme()
         colorScheme = theme.darkColorScheme();
     }
 
-    StyleSheetBuilder styler(colorScheme,
+    StyleSheetBuilder styler = StyleSheetBuilder::cached(colorScheme,
         (InterfaceStyleRounded == appSettings->interfaceStyle()),
         appSettings->previewTextFont(),
         appSettings->previewCodeFont());
 
-    editor->setColorScheme(colorScheme);
-    editor->setStyleSheet(styler.editorStyleSheet());
+    // Only rehighlight the document if its colors actually changed.  While
+    // a theme is being previewed, only the visible blocks are rehighlighted.
+    if (themePreviewActive) {
+        if (!colorSchemeApplied || (appliedColorScheme != colorScheme)) {
+            editor->previewColorScheme(colorScheme);
+            appliedColorScheme = colorScheme;
+            colorSchemeApplied = true;
+            colorSchemePreviewed = true;
+        }
+    } else if
+    (
+        colorSchemePreviewed
+        || !colorSchemeApplied
+        || (appliedColorScheme != colorScheme)
+    ) {
+        editor->setColorScheme(colorScheme);
+        appliedColorScheme = colorScheme;
+        colorSchemeApplied = true;
+        colorSchemePreviewed = false;
+    }
+
+    applyStyleSheet(editor, styler.editorStyleSheet());
+
+    if (nullptr != splitEditor) {
+        applyStyleSheet(splitEditor, styler.editorStyleSheet());
+    }
 
     // Do not call this->setStyleSheet().  Calling it more than once in a run
     // (i.e., when changing a theme) causes a crash in Qt 5.11.  Instead,
     // change the main window's style sheet via qApp.
     //
-    qApp->setStyleSheet(styler.layoutStyleSheet());
+    if (qApp->styleSheet() != styler.layoutStyleSheet()) {
+        qApp->setStyleSheet(styler.layoutStyleSheet());
+    }
 
-    previewSplitter->setStyleSheet(styler.splitterStyleSheet());
-    sidebarSplitter->setStyleSheet(styler.splitterStyleSheet());
-    this->statusBar()->setStyleSheet(styler.statusBarStyleSheet());
+    applyStyleSheet(previewSplitter, styler.splitterStyleSheet());
+    applyStyleSheet(sidebarSplitter, styler.splitterStyleSheet());
+    applyStyleSheet(this->statusBar(), styler.statusBarStyleSheet());
 
     foreach (QWidget *w, statusBarWidgets) {
-        w->setStyleSheet(styler.statusBarWidgetsStyleSheet());
+        applyStyleSheet(w, styler.statusBarWidgetsStyleSheet());
     }
 
-    findReplace->setStyleSheet(styler.findReplaceStyleSheet());
-    sidebar->setStyleSheet(styler.sidebarStyleSheet());
+    applyStyleSheet(findReplace, styler.findReplaceStyleSheet());
+    applyStyleSheet(sidebar, styler.sidebarStyleSheet());
 
     // Clear style sheet cache by setting to empty string before
     // setting the new style sheet.
     //
-    outlineWidget->setStyleSheet("");
-    outlineWidget->setStyleSheet(styler.sidebarWidgetStyleSheet());
-    cheatSheetWidget->setStyleSheet("");
-    cheatSheetWidget->setStyleSheet(styler.sidebarWidgetStyleSheet());
-    documentStatsWidget->setStyleSheet("");
-    documentStatsWidget->setStyleSheet(styler.sidebarWidgetStyleSheet());
-    sessionStatsWidget->setStyleSheet("");
-    sessionStatsWidget->setStyleSheet(styler.sidebarWidgetStyleSheet());
+    applyStyleSheet(outlineWidget, styler.sidebarWidgetStyleSheet(), true);
+    applyStyleSheet(cheatSheetWidget, styler.sidebarWidgetStyleSheet(), true);
+    applyStyleSheet(documentStatsWidget, styler.sidebarWidgetStyleSheet(), true);
+    applyStyleSheet(sessionStatsWidget, styler.sidebarWidgetStyleSheet(), true);
+    applyStyleSheet(projectTreeWidget, styler.sidebarWidgetStyleSheet(), true);
+    applyStyleSheet(folderSearchWidget, styler.sidebarWidgetStyleSheet(), true);
+    applyStyleSheet(lintWidget, styler.sidebarWidgetStyleSheet(), true);
+    applyStyleSheet(taskListWidget, styler.sidebarWidgetStyleSheet(), true);
+
+    glyphIcons->setColors(styler.interfaceTextColor(), colorScheme.foreground);
+
+    htmlPreviewCss = styler.htmlPreviewCss();
+
+    // Print to PDF with the light colors of the theme, which suit paper.
+    if (themePreviewActive) {
+        // Leave the printer alone until the theme is applied for real.
+    } else if (appSettings->darkModeEnabled()) {
+        StyleSheetBuilder printStyler = StyleSheetBuilder::cached(theme.lightColorScheme(),
+            (InterfaceStyleRounded == appSettings->interfaceStyle()),
+            appSettings->previewTextFont(),
+            appSettings->previewCodeFont());
+
+        PdfPrinter::instance()->setStyleSheet(printStyler.htmlPreviewCss());
+    } else {
+        PdfPrinter::instance()->setStyleSheet(htmlPreviewCss);
+    }
 
-    htmlPreview->setStyleSheet(styler.htmlPreviewCss());
+    htmlPreviewBaseCss = styler.htmlPreviewBaseCss();
+    htmlPreviewCssVariables = styler.htmlPreviewCssVariables();
+
+    if (nullptr != htmlPreview) {
+        htmlPreview->setStyleSheetVariables(htmlPreviewCssVariables);
+        htmlPreview->setStyleSheet(htmlPreviewBaseCss);
+        htmlPreview->setDiagramColors(colorScheme.foreground, colorScheme.background);
+    }
 
     adjustEditorWidth(this->width());
 }
 
+void MainWindow::previewTheme(const Theme &previewedTheme)
+{
+    Theme currentTheme = this->theme;
+
+    this->theme = previewedTheme;
+    themePreviewActive = true;
+    applyTheme();
+    themePreviewActive = false;
+    this->theme = currentTheme;
+
+    // Rehighlight the rest of the document once the colors stop changing.
+    themePreviewSettleTimer->start();
+}
+
+void MainWindow::applyStyleSheet
+(
+    QWidget *widget,
+    const QString &styleSheet,
+    bool clearFirst
+)
+{
+    // Setting a style sheet re-polishes the widget and all of its
+    // children, so skip widgets whose style sheet is unchanged.
+    if (widget->styleSheet() == styleSheet) {
+        return;
+    }
+
+    if (clearFirst) {
+        widget->setStyleSheet("");
+    }
+
+    widget->setStyleSheet(styleSheet);
+}
+
+// Lets the editor render HTML for the live preview from the same parse it
+// uses for highlighting whenever the preview uses the built-in cmark-gfm
+// processor, rather than having the preview parse the document again.
+//
+void MainWindow::updateHtmlRendering()
+{
+    bool builtInExporter =
+        (nullptr != dynamic_cast<CmarkGfmExporter *>(appSettings->currentHtmlExporter()));
+
+    editor->setHtmlRenderingEnabled
+    (
+        appSettings->htmlPreviewVisible()
+        && (nullptr != htmlPreview)
+        && !htmlPreview->isSuspended()
+        && builtInExporter
+        && (DocumentSizeNormal == documentSize)
+    );
+}
+
+// Initializes the features held off by a warm start.  See
+// initializeDeferredFeatures().
+//
+void MainWindow::finishWarmStart()
+{
+    if (!warmStartPending) {
+        return;
+    }
+
+    warmStartPending = false;
+    initializeDeferredFeatures();
+
+    if (StartupProfiler::isEnabled() && !documentManager->isLoading()) {
+        StartupProfiler::finish();
+    }
+}
+
+// Initializes the features that showing the first document does not need:
+// detecting the external Markdown processors, counting statistics as the
+// text changes, spell checking, and the preview, if visible.
+//
+void MainWindow::initializeDeferredFeatures()
+{
+    StartupProfiler::Scope deferredScope("Deferred features");
+
+    ExporterFactory::setDetectionDeferred(false);
+    documentStats->setDeferredUpdatesEnabled(DocumentSizeNormal != documentSize);
+
+    // Default language for dictionary is set from AppSettings intialization.
+    QString language = appSettings->dictionaryLanguage();
+
+    // If we have an available dictionary, then set up spell checking.
+    if (!language.isNull() && !language.isEmpty()) {
+        StartupProfiler::Scope dictionaryScope("Dictionary");
+        editor->setDictionary(language);
+        editor->setAlternativeDictionaries(appSettings->alternativeDictionaryLanguages());
+        editor->setSpellCheckEnabled(appSettings->liveSpellCheckEnabled());
+    } else {
+        editor->setSpellCheckEnabled(false);
+    }
+
+    if (appSettings->htmlPreviewVisible() && (nullptr == htmlPreview)) {
+        StartupProfiler::Scope previewScope("HtmlPreview");
+        createHtmlPreview();
+    }
+
+    updateHtmlRendering();
+
+    // Enumerate the fonts for the font pickers ahead of time.
+    FontCatalogue::instance()->prefetch();
+}
+
+// Creates the live preview, if it has not been created yet.  Creating the
+// preview boots QtWebEngine, which takes long enough to be left out of
+// startup.
+//
+void MainWindow::createHtmlPreview()
+{
+    if (nullptr != htmlPreview) {
+        return;
+    }
+
+    htmlPreview = new HtmlPreview
+    (
+        documentManager->document(),
+        appSettings->currentHtmlExporter(),
+        this
+    );
+
+    connect(outlineWidget, SIGNAL(headingNumberNavigated(int)), htmlPreview, SLOT(navigateToHeading(int)));
+    connect(editor, SIGNAL(scrolled(qreal)), htmlPreview, SLOT(scrollToLine(qreal)));
+    connect(appSettings, SIGNAL(currentHtmlExporterChanged(Exporter *)), htmlPreview, SLOT(setHtmlExporter(Exporter *)));
+    connect(appSettings, SIGNAL(previewIdleTimeoutChanged(int)), htmlPreview, SLOT(setIdleTimeout(int)));
+    htmlPreview->setIdleTimeout(appSettings->previewIdleTimeout());
+    connectPreviewUpdates();
+
+    // Stop rendering HTML in the editor while the preview is hidden or
+    // minimized.
+    this->connect
+    (
+        htmlPreview,
+        &HtmlPreview::suspendedChanged,
+        [this]() {
+            updateHtmlRendering();
+        }
+    );
+
+    htmlPreview->setMinimumWidth(0);
+    htmlPreview->setObjectName("htmlpreview");
+    htmlPreview->setStyleSheetVariables(htmlPreviewCssVariables);
+    htmlPreview->setStyleSheet(htmlPreviewBaseCss);
+
+    if (colorSchemeApplied) {
+        htmlPreview->setDiagramColors(appliedColorScheme.foreground, appliedColorScheme.background);
+    }
+
+    // Hide the preview before adding it so that the splitter does not
+    // show it by itself.
+    htmlPreview->setVisible(false);
+    previewSplitter->addWidget(htmlPreview);
+    previewSplitter->setCollapsible(1, true);
+    htmlPreview->setVisible(appSettings->htmlPreviewVisible());
+}
+
+// Refreshes the preview whenever the text changes or, for large documents,
+// whenever typing pauses.
+//
+void MainWindow::connectPreviewUpdates()
+{
+    if (nullptr == htmlPreview) {
+        return;
+    }
+
+    disconnect(editor, SIGNAL(textChanged()), htmlPreview, SLOT(updatePreview()));
+    disconnect(editor, SIGNAL(typingPaused()), htmlPreview, SLOT(updatePreview()));
+
+    if (DocumentSizeNormal != documentSize) {
+        connect(editor, SIGNAL(typingPaused()), htmlPreview, SLOT(updatePreview()));
+    } else {
+        connect(editor, SIGNAL(textChanged()), htmlPreview, SLOT(updatePreview()));
+        htmlPreview->updatePreview();
+    }
+}
+
+// Sets the folder searched by Find in Folder and shown in the file tree to
+// that of the document, if the document has been saved.  Otherwise, the
+// last folder is kept.  The project statistics follow the document's
+// folder, or only count the document while it is new.
+//
+void MainWindow::updateSearchFolder()
+{
+    MarkdownDocument *document = documentManager->document();
+
+    if (!document->isNew() && !document->filePath().isEmpty()) {
+        QString folder = QFileInfo(document->filePath()).absolutePath();
+        folderSearchWidget->setFolder(folder);
+        projectTreeWidget->setFolder(folder);
+        projectStats->setOpenFile(document->filePath());
+    } else {
+        projectStats->setOpenFile(QString());
+    }
+}
+
+// Determines the size class of the document from its character count.  The
+// document must shrink somewhat below a threshold before returning to the
+// smaller size class, so that editing around a threshold doesn't toggle
+// large document mode back and forth.
+//
+void MainWindow::updateDocumentSize()
+{
+    DocumentSize size = DocumentSizeNormal;
+
+    stallWatchdog->setDocumentSize(editor->document()->characterCount());
+
+    if (appSettings->largeDocumentModeEnabled()) {
+        int characters = editor->document()->characterCount();
+        int largeThreshold = appSettings->largeDocumentThreshold();
+        int hugeThreshold = qMax(appSettings->hugeDocumentThreshold(), largeThreshold);
+
+        if
+        (
+            (characters >= hugeThreshold)
+            || ((DocumentSizeHuge == documentSize)
+                && (characters >= (hugeThreshold - (hugeThreshold / 10))))
+        ) {
+            size = DocumentSizeHuge;
+        } else if
+        (
+            (characters >= largeThreshold)
+            || ((DocumentSizeNormal != documentSize)
+                && (characters >= (largeThreshold - (largeThreshold / 10))))
+        ) {
+            size = DocumentSizeLarge;
+        }
+    }
+
+    if (size != documentSize) {
+        documentSize = size;
+        applyDocumentSize();
+    }
+}
+
+// Scales back the live features for the size class of the document.  Large
+// documents are spell checked only where visible, have their statistics
+// counted in batches, and have their preview refreshed only once typing
+// pauses.  Huge documents also wait for typing to pause before parsing the
+// whole document again.
+//
+void MainWindow::applyDocumentSize()
+{
+    bool large = (DocumentSizeNormal != documentSize);
+    bool huge = (DocumentSizeHuge == documentSize);
+
+    editor->setSpellCheckVisibleOnly(large);
+    editor->setBackgroundParseDeferred(huge);
+    documentStats->setDeferredUpdatesEnabled(large || warmStartPending);
+
+    connectPreviewUpdates();
+    updateHtmlRendering();
+
+    if (huge) {
+        largeDocumentLabel->setText(tr("Very large document mode"));
+        largeDocumentLabel->setToolTip
+        (
+            tr("Spell checking only the visible text, updating statistics "
+               "in batches, and updating the preview and parsing the whole "
+               "document only when typing pauses")
+        );
+    } else {
+        largeDocumentLabel->setText(tr("Large document mode"));
+        largeDocumentLabel->setToolTip
+        (
+            tr("Spell checking only the visible text, updating statistics "
+               "in batches, and updating the preview only when typing pauses")
+        );
+    }
+
+    largeDocumentLabel->setVisible(large);
+}
 } // namespace ghostwriter
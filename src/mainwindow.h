@@ -21,10 +21,12 @@
 #define MAIN_WINDOW_H
 
 #include <QAction>
+#include <QFutureWatcher>
 #include <QLabel>
 #include <QPushButton>
 #include <QSettings>
 #include <QSplitter>
+#include <QTimer>
 
 #include "3rdparty/QtAwesome/QtAwesome.h"
 
@@ -33,12 +35,24 @@
 #include "documentstatistics.h"
 #include "documentstatisticswidget.h"
 #include "findreplace.h"
+#include "foldersearchwidget.h"
+#include "glyphiconcache.h"
+#include "headingindex.h"
 #include "htmlpreview.h"
+#include "lintwidget.h"
 #include "mainwindow.h"
+#include "memorypressuremonitor.h"
 #include "outlinewidget.h"
+#include "projectstatistics.h"
+#include "projectstatisticswidget.h"
+#include "projecttreewidget.h"
+#include "readabilityanalyzer.h"
 #include "sessionstatistics.h"
 #include "sessionstatisticswidget.h"
 #include "sidebar.h"
+#include "stallwatchdog.h"
+#include "taskindex.h"
+#include "tasklistwidget.h"
 #include "theme.h"
 #include "themerepository.h"
 #include "timelabel.h"
@@ -58,11 +72,20 @@ public:
     MainWindow(const QString &filePath = QString(), QWidget *parent = 0);
     virtual ~MainWindow();
 
+public slots:
+    /**
+     * Opens the file at the given path on behalf of another launch of the
+     * application, and brings the window to the front.  An empty path
+     * only brings the window to the front.
+     */
+    void openRequestedFile(const QString &filePath);
+
 protected:
     QSize sizeHint() const;
     void resizeEvent(QResizeEvent *event);
     void keyPressEvent(QKeyEvent *e);
     bool eventFilter(QObject *obj, QEvent *event);
+    void changeEvent(QEvent *event);
     void closeEvent(QCloseEvent *event);
 
 private slots:
@@ -72,6 +95,7 @@ private slots:
     void toggleHtmlPreview(bool checked);
     void toggleHemingwayMode(bool checked);
     void toggleFocusMode(bool checked);
+    void toggleSplitView(bool checked);
     void toggleFullScreen(bool checked);
     void toggleHideMenuBarInFullScreen(bool checked);
     void toggleFileHistoryEnabled(bool checked);
@@ -79,12 +103,16 @@ private slots:
     void changeEditorWidth(EditorWidth editorWidth);
     void changeInterfaceStyle(InterfaceStyle style);
     void insertImage();
+    void showJumpDialog();
     void showQuickReferenceGuide();
     void showWikiPage();
     void showAbout();
+    void showMemoryReport();
+    void onMemoryPressureChanged(bool underPressure);
     void updateWordCount(int newWordCount);
     void changeFocusMode(FocusMode focusMode);
     void applyTheme();
+    void previewTheme(const Theme &previewedTheme);
     void refreshRecentFiles();
     void clearRecentFileHistory();
     void changeDocumentDisplayName(const QString &displayName);
@@ -94,15 +122,35 @@ private slots:
     void onFontSizeChanged(int size);
     void onSetLocale();
     void copyHtml();
+    void onHtmlCopied();
+    void exportSessionLog();
     void showPreviewOptions();
     void onAboutToHideMenuBarMenu();
     void onAboutToShowMenuBarMenu();
     void onSidebarVisibilityChanged(bool visible);
     void toggleSidebarVisible(bool visible);
+    void toggleLatencyMonitor(bool checked);
+    void updateLatencyLabel();
 
 private:
+    // Size class of the open document, by which large document mode
+    // scales back live features.
+    typedef enum {
+        DocumentSizeNormal,
+        DocumentSizeLarge,
+        DocumentSizeHuge
+    } DocumentSize;
+
     QtAwesome *awesome;
+
+    // Pre-rendered glyphs of the sidebar tabs and status bar buttons.
+    GlyphIconCache *glyphIcons;
     MarkdownEditor *editor;
+
+    // Second view of the document below the editor, while split.
+    MarkdownEditor *splitEditor;
+    QSplitter *editorSplitter;
+
     FindReplace* findReplace;
     QSplitter *previewSplitter;
     QSplitter *sidebarSplitter;
@@ -114,6 +162,9 @@ private:
     QPushButton *sidebarToggleButton;
     QLabel *wordCountLabel;
     QLabel *statusLabel;
+    QPushButton *cancelLoadButton;
+    QLabel *largeDocumentLabel;
+    QLabel *latencyLabel;
     TimeLabel *timeLabel;
     QPushButton *toggleSidebarButton;
     QPushButton *previewOptionsButton;
@@ -123,19 +174,76 @@ private:
     QPushButton *focusModeButton;
     QPushButton *htmlPreviewButton;
     HtmlPreview *htmlPreview;
+    QString htmlPreviewCss;
+    QString htmlPreviewBaseCss;
+    QHash<QString, QString> htmlPreviewCssVariables;
     QAction *htmlPreviewMenuAction;
     QAction *fullScreenMenuAction;
     QPushButton *fullScreenButton;
     OutlineWidget *outlineWidget;
+    HeadingIndex *headingIndex;
     DocumentStatistics *documentStats;
     DocumentStatisticsWidget *documentStatsWidget;
+    ProjectStatistics *projectStats;
+    ProjectStatisticsWidget *projectStatsWidget;
     SessionStatistics *sessionStats;
     SessionStatisticsWidget *sessionStatsWidget;
     QListWidget *cheatSheetWidget;
+    ProjectTreeWidget *projectTreeWidget;
+    FolderSearchWidget *folderSearchWidget;
+    MarkdownLinter *linter;
+    LinkChecker *linkChecker;
+    LintWidget *lintWidget;
+    TaskIndex *taskIndex;
+    TaskListWidget *taskListWidget;
+    ReadabilityAnalyzer *readabilityAnalyzer;
     QAction *recentFilesActions[MAX_RECENT_FILES];
     bool menuBarMenuActivated;
+    DocumentSize documentSize;
     QAction *showSidebarAction;
 
+    // Colors last applied to the editor, so that the document is only
+    // rehighlighted when they change.
+    ColorScheme appliedColorScheme;
+    bool colorSchemeApplied;
+
+    // Live theme editing only rehighlights the visible blocks until the
+    // colors settle, after which the whole document is rehighlighted.
+    static const int THEME_PREVIEW_SETTLE_DELAY = 300;
+    bool themePreviewActive;
+    bool colorSchemePreviewed;
+    QTimer *themePreviewSettleTimer;
+
+    // The typing latency readout is refreshed at most this often, in
+    // milliseconds, so that updating it does not itself add latency.
+    static const int LATENCY_LABEL_INTERVAL = 500;
+    QTimer *latencyLabelTimer;
+
+    // HTML copied with copyHtml() is rendered in the background, after
+    // which the status bar tells so for this long, in milliseconds.
+    static const int HTML_COPIED_NOTICE_DURATION = 2000;
+    QFutureWatcher<QString> *copyHtmlWatcher;
+
+    // Sheds caches and pauses sweeps while memory runs low.
+    MemoryPressureMonitor *memoryPressureMonitor;
+
+    // Writes a report of what the main thread was busy with whenever it
+    // stops responding.
+    StallWatchdog *stallWatchdog;
+
+    // Whether timers are kept from waking up the application, while the
+    // window is inactive or minimized.
+    bool powerSaving;
+
+    // When a document is opened at startup, the features that showing its
+    // text does not need, namely spell checking, the preview, detecting
+    // the external Markdown processors and counting statistics as the text
+    // loads, are initialized only once the text has been painted, or after
+    // WARM_START_TIMEOUT milliseconds at the latest.
+    static const int WARM_START_TIMEOUT = 3000;
+    bool warmStartPending;
+    bool firstTextPainted;
+
     QList<QWidget *> statusBarButtons;
     QList<QWidget *> statusBarWidgets;
 
@@ -162,6 +270,24 @@ private:
     void buildSidebar();
 
     void adjustEditorWidth(int width);
+    MarkdownEditor *activeEditor() const;
+
+    void applyStyleSheet
+    (
+        QWidget *widget,
+        const QString &styleSheet,
+        bool clearFirst = false
+    );
+    void createHtmlPreview();
+    void connectPreviewUpdates();
+    void updateHtmlRendering();
+    void updateDocumentSize();
+    void updateSearchFolder();
+    void applyDocumentSize();
+    void updatePowerSaving();
+    void setClipboardHtml(const QString &html);
+    void finishWarmStart();
+    void initializeDeferredFeatures();
 };
 } // namespace ghostwriter
 
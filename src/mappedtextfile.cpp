@@ -0,0 +1,204 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <cstring>
+#include <limits>
+
+#include <QObject>
+
+#include "mappedtextfile.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+MappedTextFile::MappedTextFile(const QString &filePath)
+    : file(filePath),
+      data(nullptr),
+      dataSize(0),
+      textStart(0),
+      lineTotal(0)
+{
+    ;
+}
+
+MappedTextFile::~MappedTextFile()
+{
+    if (nullptr != data) {
+        file.unmap((uchar *) data);
+    }
+}
+
+bool MappedTextFile::open(QString &err)
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        err = file.errorString();
+        return false;
+    }
+
+    dataSize = file.size();
+
+    if (dataSize > 0) {
+        data = (const char *) file.map(0, dataSize);
+
+        if (nullptr == data) {
+            err = file.errorString();
+            return false;
+        }
+    }
+
+    // Only UTF-8 is decoded straight from the mapping.  The byte order
+    // marks of UTF-16 and UTF-32 both start with 0xFF 0xFE or 0xFE 0xFF.
+    if
+    (
+        (dataSize >= 2)
+        && ((((uchar) data[0] == 0xFF) && ((uchar) data[1] == 0xFE))
+            || (((uchar) data[0] == 0xFE) && ((uchar) data[1] == 0xFF)))
+    ) {
+        err = QObject::tr("Only UTF-8 files can be viewed.");
+        return false;
+    }
+
+    if
+    (
+        (dataSize >= 3)
+        && ((uchar) data[0] == 0xEF)
+        && ((uchar) data[1] == 0xBB)
+        && ((uchar) data[2] == 0xBF)
+    ) {
+        textStart = 3;
+    }
+
+    return true;
+}
+
+bool MappedTextFile::buildIndex(const TaskScheduler::CancellationToken &token)
+{
+    GW_TRACE_SCOPE("MappedTextFile::buildIndex");
+
+    checkpoints.clear();
+    checkpoints.append(textStart);
+    lineTotal = 1;
+
+    qint64 offset = textStart;
+    qint64 chunkEnd = offset;
+
+    // memchr() is vectorized by the C library, which makes it much faster
+    // than comparing one byte at a time.
+    while (offset < dataSize) {
+        if (offset >= chunkEnd) {
+            if (TaskScheduler::isCancelled(token)) {
+                return false;
+            }
+
+            chunkEnd = qMin(offset + SCAN_CHUNK_SIZE, dataSize);
+        }
+
+        const char *lineBreak =
+            (const char *) memchr(data + offset, '\n', chunkEnd - offset);
+
+        if (nullptr == lineBreak) {
+            offset = chunkEnd;
+            continue;
+        }
+
+        offset = (lineBreak - data) + 1;
+
+        if (lineTotal == std::numeric_limits<int>::max()) {
+            break;
+        }
+
+        if (0 == (lineTotal % LINES_PER_CHECKPOINT)) {
+            checkpoints.append(offset);
+        }
+
+        lineTotal++;
+    }
+
+    return true;
+}
+
+QString MappedTextFile::filePath() const
+{
+    return file.fileName();
+}
+
+qint64 MappedTextFile::size() const
+{
+    return dataSize;
+}
+
+int MappedTextFile::lineCount() const
+{
+    return lineTotal;
+}
+
+QString MappedTextFile::lines(int first, int count) const
+{
+    first = qMax(first, 0);
+    count = qMin(count, lineTotal - first);
+
+    if (count <= 0) {
+        return QString();
+    }
+
+    qint64 start = lineOffset(first);
+    qint64 end = start;
+
+    for (int i = 0; i < count; i++) {
+        end = nextLineOffset(end);
+    }
+
+    // Leave out the line break of the last line.
+    if ((end > start) && ('\n' == data[end - 1])) {
+        end--;
+    }
+
+    QString text = QString::fromUtf8(data + start, (int) qMin<qint64>(end - start, std::numeric_limits<int>::max()));
+    text.remove(QChar('\r'));
+    return text;
+}
+
+qint64 MappedTextFile::lineOffset(int line) const
+{
+    int checkpoint = line / LINES_PER_CHECKPOINT;
+    qint64 offset = checkpoints[checkpoint];
+
+    for (int i = checkpoint * LINES_PER_CHECKPOINT; i < line; i++) {
+        offset = nextLineOffset(offset);
+    }
+
+    return offset;
+}
+
+qint64 MappedTextFile::nextLineOffset(qint64 offset) const
+{
+    if (offset >= dataSize) {
+        return dataSize;
+    }
+
+    const char *lineBreak =
+        (const char *) memchr(data + offset, '\n', dataSize - offset);
+
+    if (nullptr == lineBreak) {
+        return dataSize;
+    }
+
+    return (lineBreak - data) + 1;
+}
+} // namespace ghostwriter
@@ -0,0 +1,118 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef MAPPED_TEXT_FILE_H
+#define MAPPED_TEXT_FILE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "taskscheduler.h"
+
+namespace ghostwriter
+{
+/**
+ * Read-only view of a UTF-8 text file that is too large to load into a
+ * QTextDocument.  The file is mapped into memory, and only the lines that
+ * are asked for are decoded, so that the memory used is proportional to
+ * the lines read rather than to the file.
+ *
+ * Lines are found from a sparse index of the offset of every few hundred
+ * lines, which buildIndex() builds with a single scan for line breaks.
+ * The index can be built on a worker thread, but the file must not be
+ * used on another thread until buildIndex() has returned.
+ */
+class MappedTextFile
+{
+public:
+    /**
+     * Constructor.  Takes the path of the file as parameter.
+     */
+    MappedTextFile(const QString &filePath);
+
+    /**
+     * Destructor.  Unmaps the file.
+     */
+    ~MappedTextFile();
+
+    /**
+     * Maps the file into memory.  Returns false and sets err to a
+     * description of the problem if the file could not be mapped, or if it
+     * is not UTF-8 text.
+     */
+    bool open(QString &err);
+
+    /**
+     * Builds the line index, checking the given token every few megabytes
+     * so that indexing can be abandoned.  Returns false if it was.
+     */
+    bool buildIndex(const TaskScheduler::CancellationToken &token = TaskScheduler::CancellationToken());
+
+    /**
+     * Returns the path of the file.
+     */
+    QString filePath() const;
+
+    /**
+     * Returns the size of the file in bytes.
+     */
+    qint64 size() const;
+
+    /**
+     * Returns the number of lines in the file, once it is indexed.  A
+     * file ending with a line break has an empty last line, as in a
+     * QTextDocument.
+     */
+    int lineCount() const;
+
+    /**
+     * Returns the text of the given number of lines, starting from the
+     * given zero-based line, joined with line feeds.  The range is clipped
+     * to the lines of the file.
+     */
+    QString lines(int first, int count) const;
+
+private:
+    // Number of lines between the offsets kept in the index.
+    static const int LINES_PER_CHECKPOINT = 256;
+
+    // Number of bytes scanned for line breaks between checks for
+    // cancellation.
+    static const qint64 SCAN_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    QFile file;
+    const char *data;
+    qint64 dataSize;
+
+    // Offset of the start of text, past the byte order mark, if any.
+    qint64 textStart;
+
+    // Offsets of lines 0, LINES_PER_CHECKPOINT, 2 * LINES_PER_CHECKPOINT,
+    // and so on.
+    QVector<qint64> checkpoints;
+
+    int lineTotal;
+
+    qint64 lineOffset(int line) const;
+    qint64 nextLineOffset(qint64 offset) const;
+};
+} // namespace ghostwriter
+
+#endif // MAPPED_TEXT_FILE_H
@@ -17,6 +17,10 @@
  *
  ***********************************************************************/
 
+#include <algorithm>
+
+#include <QDataStream>
+#include <QHash>
 #include <QStack>
 #include <QTextStream>
 #include <QtGlobal>
@@ -31,25 +35,374 @@ class MarkdownASTPrivate
 {
 public:
     MarkdownASTPrivate()
+        : root(nullptr), adoptedRoot(nullptr), nodeCount(0), discardedNodeCount(0)
     {
         ;
     }
 
     ~MarkdownASTPrivate()
     {
-        ;
+        freeAdoptedRoot();
     }
 
     MemoryArena<MarkdownNode> arena;
     MarkdownNode *root;
+
+    // cmark_node AST that the nodes are views of, if adopted.
+    cmark_node *adoptedRoot;
+
+    // Text of all nodes in the AST.  See MarkdownNode for details.
+    QString textBuffer;
+
+    // Number of nodes allocated from the arena, and the number of those
+    // nodes that have since been unlinked from the tree by replaceBlocks().
+    int nodeCount;
+    int discardedNodeCount;
+
+    // Index of the children of container nodes (document, lists, block
+    // quotes, etc.), sorted by start line for binary searching.  Built
+    // lazily as the containers are searched.
+    mutable QHash<const MarkdownNode *, QVector<MarkdownNode *>> childIndex;
+
+    MarkdownNode *allocateNode();
+    void freeAdoptedRoot();
+    void build(cmark_node *root, const Utf8ColumnMap *columns, bool view);
+    MarkdownNode *searchStart(const MarkdownNode *parent, int lineNumber) const;
+    MarkdownNode *cloneSubtree(const MarkdownNode *source, int lineOffset);
+    int subtreeSize(const MarkdownNode *node) const;
+
+    bool isEquivalent(const MarkdownNode *oldNode, const MarkdownNode *newNode, int lineDelta) const;
+    void diffBlocks
+    (
+        const QVector<const MarkdownNode *> &oldBlocks,
+        const QVector<const MarkdownNode *> &newBlocks,
+        int lineDelta,
+        int firstLine,
+        int lastLine,
+        QVector<MarkdownAST::LineRange> &ranges
+    ) const;
 };
 
+MarkdownNode *MarkdownASTPrivate::allocateNode()
+{
+    nodeCount++;
+    return arena.allocate();
+}
+
+void MarkdownASTPrivate::freeAdoptedRoot()
+{
+    if (nullptr != adoptedRoot) {
+        cmark_node_free(adoptedRoot);
+        adoptedRoot = nullptr;
+    }
+}
+
+// Replaces the nodes of the AST with either clones or views of the given
+// cmark_node AST.
+//
+void MarkdownASTPrivate::build(cmark_node *root, const Utf8ColumnMap *columns, bool view)
+{
+    // Keep the arena's chunks and the text buffer's capacity so that
+    // repeated parses into the same AST don't return to the heap.
+    arena.reset();
+    childIndex.clear();
+    textBuffer.truncate(0);
+    nodeCount = 0;
+    discardedNodeCount = 0;
+
+    if (nullptr == root) {
+        this->root = nullptr;
+        return;
+    }
+
+    this->root = allocateNode();
+
+    QStack<cmark_node *> fromNodes;
+    QStack<MarkdownNode *> toNodes;
+
+    fromNodes.push(root);
+    toNodes.push(this->root);
+
+    while (!fromNodes.isEmpty()) {
+        cmark_node *source = fromNodes.pop();
+        MarkdownNode *dest = toNodes.pop();
+
+        if (view) {
+            dest->setViewOf(source, &textBuffer, columns);
+        } else {
+            dest->setDataFrom(source, &textBuffer, columns);
+        }
+
+        // Prep children nodes for cloning or viewing.
+        MarkdownNode *destParent = dest;
+        source = cmark_node_first_child(source);
+
+        while (NULL != source) {
+            fromNodes.push(source);
+            dest = allocateNode();
+            destParent->appendChild(dest);
+            toNodes.push(dest);
+            source = cmark_node_next(source);
+        }
+    }
+}
+
+// Returns the child of the given parent node from which to start searching
+// for the block at the given line number.  For container nodes, this is
+// the last child starting at or before the line number, as found with a
+// binary search of the child index.
+//
+MarkdownNode *MarkdownASTPrivate::searchStart(const MarkdownNode *parent, int lineNumber) const
+{
+    switch (parent->type()) {
+    case MarkdownNode::Document:
+    case MarkdownNode::BlockQuote:
+    case MarkdownNode::NumberedList:
+    case MarkdownNode::BulletList:
+    case MarkdownNode::FootnoteDefinition:
+    case MarkdownNode::Table:
+        break;
+    default:
+        return parent->firstChild();
+    }
+
+    QHash<const MarkdownNode *, QVector<MarkdownNode *>>::const_iterator iter =
+        childIndex.constFind(parent);
+
+    if (childIndex.constEnd() == iter) {
+        QVector<MarkdownNode *> children;
+
+        for (MarkdownNode *child = parent->firstChild(); nullptr != child; child = child->next()) {
+            children.append(child);
+        }
+
+        iter = childIndex.insert(parent, children);
+    }
+
+    const QVector<MarkdownNode *> &children = iter.value();
+
+    QVector<MarkdownNode *>::const_iterator found =
+        std::upper_bound
+        (
+            children.constBegin(),
+            children.constEnd(),
+            lineNumber,
+            [](int line, const MarkdownNode *node) {
+                return line < node->startLine();
+            }
+        );
+
+    if (children.constBegin() == found) {
+        return parent->firstChild();
+    }
+
+    return *(found - 1);
+}
+
+MarkdownNode *MarkdownASTPrivate::cloneSubtree(const MarkdownNode *source, int lineOffset)
+{
+    MarkdownNode *clone = allocateNode();
+
+    QStack<const MarkdownNode *> fromNodes;
+    QStack<MarkdownNode *> toNodes;
+
+    fromNodes.push(source);
+    toNodes.push(clone);
+
+    while (!fromNodes.isEmpty()) {
+        const MarkdownNode *from = fromNodes.pop();
+        MarkdownNode *to = toNodes.pop();
+
+        to->setDataFrom(from, &textBuffer, lineOffset);
+
+        for (const MarkdownNode *child = from->firstChild(); nullptr != child; child = child->next()) {
+            MarkdownNode *dest = allocateNode();
+            to->appendChild(dest);
+            fromNodes.push(child);
+            toNodes.push(dest);
+        }
+    }
+
+    return clone;
+}
+
+// Returns true if the given subtrees have the same structure, i.e., the
+// same node types and extents, once the old subtree's line numbers are
+// shifted by lineDelta.  Text content is not compared, since edits to the
+// text of a line get that line rehighlighted regardless.
+//
+bool MarkdownASTPrivate::isEquivalent
+(
+    const MarkdownNode *oldNode,
+    const MarkdownNode *newNode,
+    int lineDelta
+) const
+{
+    // Line numbers of zero are unset, and are never shifted.
+    int oldStartLine = (oldNode->startLine() > 0) ? (oldNode->startLine() + lineDelta) : 0;
+    int oldEndLine = (oldNode->endLine() > 0) ? (oldNode->endLine() + lineDelta) : 0;
+
+    if
+    (
+        (oldNode->type() != newNode->type())
+        || (oldStartLine != newNode->startLine())
+        || (oldEndLine != newNode->endLine())
+        || (oldNode->position() != newNode->position())
+        || (oldNode->length() != newNode->length())
+        || (oldNode->headingLevel() != newNode->headingLevel())
+        || (oldNode->isSetextHeading() != newNode->isSetextHeading())
+        || (oldNode->isFencedCodeBlock() != newNode->isFencedCodeBlock())
+        || (oldNode->listItemNumber() != newNode->listItemNumber())
+        || (oldNode->isFencedCodeBlock() && (oldNode->textRef() != newNode->textRef()))
+    ) {
+        return false;
+    }
+
+    const MarkdownNode *oldChild = oldNode->firstChild();
+    const MarkdownNode *newChild = newNode->firstChild();
+
+    while ((nullptr != oldChild) && (nullptr != newChild)) {
+        if (!isEquivalent(oldChild, newChild, lineDelta)) {
+            return false;
+        }
+
+        oldChild = oldChild->next();
+        newChild = newChild->next();
+    }
+
+    return (oldChild == newChild);
+}
+
+// Compares the given sibling blocks from the old and new ASTs, appending
+// the lines of the new AST (within firstLine and lastLine) whose structure
+// differs to the given ranges.  Identical blocks are matched from the front
+// of the lists at their original lines, and from the back shifted by
+// lineDelta.  If only a single container block differs, its children are
+// compared in the same manner to narrow down the range.
+//
+void MarkdownASTPrivate::diffBlocks
+(
+    const QVector<const MarkdownNode *> &oldBlocks,
+    const QVector<const MarkdownNode *> &newBlocks,
+    int lineDelta,
+    int firstLine,
+    int lastLine,
+    QVector<MarkdownAST::LineRange> &ranges
+) const
+{
+    int oldCount = oldBlocks.size();
+    int newCount = newBlocks.size();
+    int prefix = 0;
+    int suffix = 0;
+
+    while
+    (
+        (prefix < oldCount)
+        && (prefix < newCount)
+        && isEquivalent(oldBlocks[prefix], newBlocks[prefix], 0)
+    ) {
+        prefix++;
+    }
+
+    while
+    (
+        (suffix < (oldCount - prefix))
+        && (suffix < (newCount - prefix))
+        && isEquivalent(oldBlocks[oldCount - 1 - suffix], newBlocks[newCount - 1 - suffix], lineDelta)
+    ) {
+        suffix++;
+    }
+
+    if ((prefix == oldCount) && (prefix == newCount)) {
+        return;
+    }
+
+    if (((oldCount - prefix - suffix) == 1) && ((newCount - prefix - suffix) == 1)) {
+        const MarkdownNode *oldBlock = oldBlocks[prefix];
+        const MarkdownNode *newBlock = newBlocks[prefix];
+
+        switch (newBlock->type()) {
+        case MarkdownNode::BlockQuote:
+        case MarkdownNode::NumberedList:
+        case MarkdownNode::BulletList:
+        case MarkdownNode::ListItem:
+        case MarkdownNode::TaskListItem:
+        case MarkdownNode::FootnoteDefinition:
+            if
+            (
+                (oldBlock->type() == newBlock->type())
+                && (oldBlock->startLine() == newBlock->startLine())
+            ) {
+                QVector<const MarkdownNode *> oldChildren;
+                QVector<const MarkdownNode *> newChildren;
+                int rangeCount = ranges.size();
+
+                for (const MarkdownNode *child = oldBlock->firstChild(); nullptr != child; child = child->next()) {
+                    oldChildren.append(child);
+                }
+
+                for (const MarkdownNode *child = newBlock->firstChild(); nullptr != child; child = child->next()) {
+                    newChildren.append(child);
+                }
+
+                diffBlocks
+                (
+                    oldChildren,
+                    newChildren,
+                    lineDelta,
+                    newBlock->startLine(),
+                    newBlock->endLine(),
+                    ranges
+                );
+
+                // If the children are all the same, then the container
+                // itself changed.
+                if (ranges.size() == rangeCount) {
+                    ranges.append(MarkdownAST::LineRange(newBlock->startLine(), newBlock->endLine()));
+                }
+
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    int start = (prefix > 0) ? (newBlocks[prefix - 1]->endLine() + 1) : firstLine;
+    int end = (suffix > 0) ? (newBlocks[newCount - suffix]->startLine() - 1) : lastLine;
+
+    if (start <= end) {
+        ranges.append(MarkdownAST::LineRange(start, end));
+    }
+}
+
+int MarkdownASTPrivate::subtreeSize(const MarkdownNode *node) const
+{
+    int count = 0;
+    QStack<const MarkdownNode *> nodes;
+    nodes.push(node);
+
+    while (!nodes.isEmpty()) {
+        const MarkdownNode *current = nodes.pop();
+        count++;
+
+        for (const MarkdownNode *child = current->firstChild(); nullptr != child; child = child->next()) {
+            nodes.push(child);
+        }
+    }
+
+    return count;
+}
+
 MarkdownAST::MarkdownAST()
     : d_ptr(new MarkdownASTPrivate())
 {
     Q_D(MarkdownAST);
     
     d->root = nullptr;
+    d->nodeCount = 0;
+    d->discardedNodeCount = 0;
 }
 
 MarkdownAST::MarkdownAST(cmark_node *root)
@@ -73,44 +426,27 @@ MarkdownNode *MarkdownAST::root()
     return d->root;
 }
 
-void MarkdownAST::setRoot(cmark_node *root)
+void MarkdownAST::setRoot(cmark_node *root, const Utf8ColumnMap *columns)
 {
     Q_D(MarkdownAST);
-    
-    d->arena.freeAll();
-
-    if (nullptr == root) {
-        d->root = nullptr;
-        return;
-    }
-
-    d->root = d->arena.allocate();
 
     // Clone the node into memory that isn't allocated to
     // cmark-gfm's arena memory.
-    QStack<cmark_node *> fromNodes;
-    QStack<MarkdownNode *> toNodes;
-
-    fromNodes.push(root);
-    toNodes.push(d->root);
-
-    while (!fromNodes.isEmpty()) {
-        cmark_node *source = fromNodes.pop();
-        MarkdownNode *dest = toNodes.pop();
+    d->build(root, columns, false);
+    d->freeAdoptedRoot();
+}
 
-        dest->setDataFrom(source);
+void MarkdownAST::adoptRoot(cmark_node *root, const Utf8ColumnMap *columns)
+{
+    Q_D(MarkdownAST);
 
-        // Prep children nodes for cloning.
-        MarkdownNode *destParent = dest;
-        source = cmark_node_first_child(source);
+    // Build the views before freeing any prior tree, in case the given
+    // root is the one already adopted.
+    d->build(root, columns, true);
 
-        while (NULL != source) {
-            fromNodes.push(source);
-            dest = d->arena.allocate();
-            destParent->appendChild(dest);
-            toNodes.push(dest);
-            source = cmark_node_next(source);
-        }
+    if (d->adoptedRoot != root) {
+        d->freeAdoptedRoot();
+        d->adoptedRoot = root;
     }
 }
 
@@ -123,7 +459,7 @@ MarkdownNode *MarkdownAST::findBlockAtLine(int lineNumber) const
     }
 
     MarkdownNode *candidate = nullptr;
-    MarkdownNode *current = d->root->firstChild();
+    MarkdownNode *current = d->searchStart(d->root, lineNumber);
 
     while
     (
@@ -154,12 +490,12 @@ MarkdownNode *MarkdownAST::findBlockAtLine(int lineNumber) const
                     (lineNumber == current->endLine())) {
                     current = current->next();
                 } else {
-                    current = current->firstChild();
+                    current = d->searchStart(current, lineNumber);
                 }
                 break;
             }
             default:
-                current = current->firstChild();
+                current = d->searchStart(current, lineNumber);
                 break;
             }
         } else if (current->startLine() > lineNumber) {
@@ -172,6 +508,30 @@ MarkdownNode *MarkdownAST::findBlockAtLine(int lineNumber) const
     return candidate;
 }
 
+MarkdownNode *MarkdownAST::validRoot() const
+{
+    Q_D(const MarkdownAST);
+
+    if ((nullptr == d->root) || (MarkdownNode::Invalid == d->root->type())) {
+        return nullptr;
+    }
+
+    return d->root;
+}
+
+MarkdownNode *MarkdownAST::topLevelBlockAtLine(int lineNumber) const
+{
+    Q_D(const MarkdownAST);
+
+    MarkdownNode *root = validRoot();
+
+    if ((nullptr == root) || (nullptr == root->firstChild()) || root->firstChild()->isInvalid()) {
+        return nullptr;
+    }
+
+    return d->searchStart(root, lineNumber);
+}
+
 QVector<MarkdownNode *> MarkdownAST::headings() const
 {
     Q_D(const MarkdownAST);
@@ -195,12 +555,243 @@ QVector<MarkdownNode *> MarkdownAST::headings() const
     return headings;
 }
 
+QVector<MarkdownAST::LineRange> MarkdownAST::replaceBlocks
+(
+    int firstLine,
+    int lastLine,
+    int lineDelta,
+    const MarkdownAST *fragment
+)
+{
+    Q_D(MarkdownAST);
+
+    QVector<LineRange> ranges;
+
+    if (nullptr == d->root) {
+        return ranges;
+    }
+
+    // Note:  Unlinked blocks stay intact in the arena until the AST is
+    //        rebuilt, so they can still be compared against below.
+    QVector<const MarkdownNode *> oldBlocks;
+    QVector<const MarkdownNode *> newBlocks;
+
+    // Unlink the old top-level blocks in the range, remembering the
+    // first block that follows the range so that the new blocks can be
+    // inserted before it.
+    MarkdownNode *node = d->root->firstChild();
+
+    while ((nullptr != node) && (node->startLine() < firstLine)) {
+        node = node->next();
+    }
+
+    while ((nullptr != node) && (node->startLine() <= lastLine)) {
+        MarkdownNode *next = node->next();
+        oldBlocks.append(node);
+        d->discardedNodeCount += d->subtreeSize(node);
+        d->root->removeChild(node);
+        node = next;
+    }
+
+    MarkdownNode *insertionPoint = node;
+
+    // The document's children changed, so its index must be rebuilt.
+    d->childIndex.remove(d->root);
+
+    // Shift the line numbers of everything following the range.
+    if (0 != lineDelta) {
+        QStack<MarkdownNode *> nodes;
+
+        for (MarkdownNode *block = insertionPoint; nullptr != block; block = block->next()) {
+            nodes.push(block);
+        }
+
+        while (!nodes.isEmpty()) {
+            MarkdownNode *current = nodes.pop();
+            current->shiftLines(lineDelta);
+
+            for (MarkdownNode *child = current->firstChild(); nullptr != child; child = child->next()) {
+                nodes.push(child);
+            }
+        }
+
+        d->root->setEndLine(d->root->endLine() + lineDelta);
+    }
+
+    // Splice in copies of the fragment's blocks.
+    if ((nullptr != fragment) && (nullptr != fragment->d_func()->root)) {
+        const MarkdownNode *block = fragment->d_func()->root->firstChild();
+
+        while (nullptr != block) {
+            MarkdownNode *clone = d->cloneSubtree(block, firstLine - 1);
+            d->root->insertChildBefore(clone, insertionPoint);
+            newBlocks.append(clone);
+            block = block->next();
+        }
+    }
+
+    d->diffBlocks(oldBlocks, newBlocks, lineDelta, firstLine, lastLine + lineDelta, ranges);
+
+    return ranges;
+}
+
+QVector<MarkdownAST::LineRange> MarkdownAST::changedLineRanges
+(
+    const MarkdownAST *previous,
+    int lineDelta
+) const
+{
+    Q_D(const MarkdownAST);
+
+    QVector<LineRange> ranges;
+    QVector<const MarkdownNode *> oldBlocks;
+    QVector<const MarkdownNode *> newBlocks;
+    int lastLine = 1;
+
+    if ((nullptr != previous) && (nullptr != previous->d_func()->root)) {
+        for (const MarkdownNode *block = previous->d_func()->root->firstChild(); nullptr != block; block = block->next()) {
+            oldBlocks.append(block);
+        }
+    }
+
+    if (nullptr != d->root) {
+        lastLine = qMax(lastLine, d->root->endLine());
+
+        for (const MarkdownNode *block = d->root->firstChild(); nullptr != block; block = block->next()) {
+            newBlocks.append(block);
+        }
+    }
+
+    d->diffBlocks(oldBlocks, newBlocks, lineDelta, 1, lastLine, ranges);
+
+    return ranges;
+}
+
+bool MarkdownAST::needsCompaction() const
+{
+    Q_D(const MarkdownAST);
+
+    return d->discardedNodeCount > (d->nodeCount - d->discardedNodeCount);
+}
+
 void MarkdownAST::clear()
 {
     Q_D(MarkdownAST);
     
-    d->arena.freeAll();
+    d->arena.reset();
+    d->childIndex.clear();
+    d->textBuffer.truncate(0);
     d->root = nullptr;
+    d->nodeCount = 0;
+    d->discardedNodeCount = 0;
+    d->freeAdoptedRoot();
+}
+
+void MarkdownAST::trim()
+{
+    Q_D(MarkdownAST);
+
+    d->arena.trim();
+    d->childIndex = QHash<const MarkdownNode *, QVector<MarkdownNode *>>();
+}
+
+qint64 MarkdownAST::nodeMemory() const
+{
+    Q_D(const MarkdownAST);
+
+    qint64 bytes = (qint64) (d->arena.capacity() * sizeof(MarkdownNode));
+
+    for
+    (
+        QHash<const MarkdownNode *, QVector<MarkdownNode *>>::const_iterator it = d->childIndex.constBegin();
+        it != d->childIndex.constEnd();
+        ++it
+    ) {
+        bytes += it.value().capacity() * sizeof(MarkdownNode *);
+    }
+
+    return bytes;
+}
+
+qint64 MarkdownAST::textMemory() const
+{
+    Q_D(const MarkdownAST);
+
+    return d->textBuffer.capacity() * sizeof(QChar);
+}
+
+void MarkdownAST::write(QDataStream &stream) const
+{
+    Q_D(const MarkdownAST);
+
+    stream << (quint8) ((nullptr != d->root) ? 1 : 0);
+
+    if (nullptr == d->root) {
+        return;
+    }
+
+    // Write the nodes in pre-order, each followed by its number of
+    // children.
+    QStack<const MarkdownNode *> nodes;
+    nodes.push(d->root);
+
+    while (!nodes.isEmpty()) {
+        const MarkdownNode *node = nodes.pop();
+        qint32 childCount = 0;
+
+        node->writeData(stream);
+
+        for (const MarkdownNode *child = node->lastChild(); nullptr != child; child = child->previous()) {
+            nodes.push(child);
+            childCount++;
+        }
+
+        stream << childCount;
+    }
+}
+
+bool MarkdownAST::read(QDataStream &stream)
+{
+    Q_D(MarkdownAST);
+
+    clear();
+
+    quint8 hasRoot = 0;
+    stream >> hasRoot;
+
+    if ((QDataStream::Ok != stream.status()) || (0 == hasRoot)) {
+        return (QDataStream::Ok == stream.status());
+    }
+
+    QStack<QPair<MarkdownNode *, qint32>> parents;
+    qint32 childCount = 0;
+
+    d->root = d->allocateNode();
+    d->root->readData(stream, &d->textBuffer);
+    stream >> childCount;
+    parents.push(qMakePair(d->root, childCount));
+
+    while (!parents.isEmpty() && (QDataStream::Ok == stream.status())) {
+        if (parents.top().second <= 0) {
+            parents.pop();
+            continue;
+        }
+
+        parents.top().second--;
+
+        MarkdownNode *node = d->allocateNode();
+        parents.top().first->appendChild(node);
+        node->readData(stream, &d->textBuffer);
+        stream >> childCount;
+        parents.push(qMakePair(node, childCount));
+    }
+
+    if (QDataStream::Ok != stream.status()) {
+        clear();
+        return false;
+    }
+
+    return true;
 }
 
 QString MarkdownAST::toString() const
@@ -20,15 +20,222 @@
 #ifndef MARKDOWN_AST_H
 #define MARKDOWN_AST_H
 
+#include <limits>
+
+#include <QPair>
 #include <QScopedPointer>
+#include <QVector>
 
 #include "markdownnode.h"
 #include "memoryarena.h"
 
 class cmark_node;
+class QDataStream;
 
 namespace ghostwriter
 {
+class Utf8ColumnMap;
+
+/**
+ * Set of node types known at compile time, by which MarkdownNodeIterator
+ * filters the nodes it visits.  An empty set accepts every type.
+ */
+template <MarkdownNode::NodeType... Types>
+struct MarkdownNodeTypes;
+
+template <>
+struct MarkdownNodeTypes<>
+{
+    static constexpr bool contains(MarkdownNode::NodeType)
+    {
+        return false;
+    }
+
+    static constexpr bool accepts(MarkdownNode::NodeType)
+    {
+        return true;
+    }
+
+    // Whether all of the types are block types, and whether only block
+    // nodes are accepted, so that the inline children of blocks need not
+    // be walked.
+    static constexpr bool AllBlocks = true;
+    static constexpr bool BlocksOnly = false;
+};
+
+template <MarkdownNode::NodeType First, MarkdownNode::NodeType... Rest>
+struct MarkdownNodeTypes<First, Rest...>
+{
+    static constexpr bool contains(MarkdownNode::NodeType type)
+    {
+        return (First == type) || MarkdownNodeTypes<Rest...>::contains(type);
+    }
+
+    static constexpr bool accepts(MarkdownNode::NodeType type)
+    {
+        return contains(type);
+    }
+
+    static constexpr bool AllBlocks =
+        (First >= MarkdownNode::FirstBlockType)
+        && (First <= MarkdownNode::LastBlockType)
+        && MarkdownNodeTypes<Rest...>::AllBlocks;
+    static constexpr bool BlocksOnly = AllBlocks;
+};
+
+/**
+ * Walks the nodes of an AST in document order (i.e., depth first, each
+ * node before its children), stopping only at the nodes of the given types
+ * that lie within a range of lines.  Subtrees of blocks that end before
+ * the range are skipped, and the walk ends at the first block starting
+ * after it.  If only block types are given, the inline children of blocks
+ * are not walked at all.  Obtain iterators from MarkdownAST::nodesOfType()
+ * and MarkdownAST::nodesInLineRange().
+ *
+ * The AST must not change while it is being walked.
+ */
+template <MarkdownNode::NodeType... Types>
+class MarkdownNodeIterator
+{
+public:
+    /**
+     * Constructs the end iterator.
+     */
+    MarkdownNodeIterator()
+        : root(nullptr), current(nullptr), firstLine(0), lastLine(0)
+    {
+        ;
+    }
+
+    /**
+     * Constructs an iterator walking the tree under the given root from
+     * the given start node, stopping at the first node accepted.
+     */
+    MarkdownNodeIterator(MarkdownNode *root, MarkdownNode *start, int firstLine, int lastLine)
+        : root(root), current(start), firstLine(firstLine), lastLine(lastLine)
+    {
+        settle();
+    }
+
+    MarkdownNode *operator*() const
+    {
+        return current;
+    }
+
+    MarkdownNodeIterator &operator++()
+    {
+        step(true);
+        settle();
+        return *this;
+    }
+
+    bool operator==(const MarkdownNodeIterator &other) const
+    {
+        return current == other.current;
+    }
+
+    bool operator!=(const MarkdownNodeIterator &other) const
+    {
+        return current != other.current;
+    }
+
+private:
+    typedef MarkdownNodeTypes<Types...> Filter;
+
+    MarkdownNode *root;
+    MarkdownNode *current;
+    int firstLine;
+    int lastLine;
+
+    /*
+    * Moves to the next node in document order, descending into the
+    * children of the current node only if asked to.
+    */
+    void step(bool descend)
+    {
+        MarkdownNode *child = current->firstChild();
+
+        if
+        (
+            descend
+            && (nullptr != child)
+            && !child->isInvalid()
+            && !(Filter::BlocksOnly && child->isInlineType())
+        ) {
+            current = child;
+            return;
+        }
+
+        while ((current != root) && (nullptr == current->next())) {
+            current = current->parent();
+        }
+
+        current = (current == root) ? nullptr : current->next();
+    }
+
+    /*
+    * Moves forward from the current node to the first node that is
+    * accepted, if the current node is not.
+    */
+    void settle()
+    {
+        while (nullptr != current) {
+            int start = current->startLine();
+            int end = current->endLine();
+
+            if ((start > 0) && (start > lastLine)) {
+                // Blocks start in document order, so none further along
+                // can be within the range.
+                if (current->isBlockType()) {
+                    current = nullptr;
+                    return;
+                }
+
+                step(false);
+            } else if ((end > 0) && (end < firstLine)) {
+                step(false);
+            } else if (Filter::accepts(current->type())) {
+                return;
+            } else {
+                step(true);
+            }
+        }
+    }
+};
+
+/**
+ * Range of the nodes walked by a MarkdownNodeIterator, for use in
+ * range-based for loops.
+ */
+template <MarkdownNode::NodeType... Types>
+class MarkdownNodeRange
+{
+public:
+    typedef MarkdownNodeIterator<Types...> iterator;
+
+    MarkdownNodeRange(MarkdownNode *root, MarkdownNode *start, int firstLine, int lastLine)
+        : root(root), start(start), firstLine(firstLine), lastLine(lastLine)
+    {
+        ;
+    }
+
+    iterator begin() const
+    {
+        return iterator(root, start, firstLine, lastLine);
+    }
+
+    iterator end() const
+    {
+        return iterator();
+    }
+
+private:
+    MarkdownNode *root;
+    MarkdownNode *start;
+    int firstLine;
+    int lastLine;
+};
+
 /**
  * This class encapsulates an abstact syntax tree of Markdown nodes.
  * Use this class to clone a cmark_node AST and perform searches
@@ -37,7 +244,9 @@ namespace ghostwriter
  * Note:  Due to cmark-gfm's memory arena used ot allocate cmark_node
  *        objects being non-reentrant, this class is used to clone
  *        a cmark_node AST to prevent node memory from being overwritten
- *        by another call to the cmark-gfm API.
+ *        by another call to the cmark-gfm API.  A cmark_node AST that
+ *        was allocated outside of the arena can instead be adopted with
+ *        adoptRoot(), which keeps it alive alongside this AST.
  */
 class MarkdownASTPrivate;
 class MarkdownAST
@@ -45,6 +254,11 @@ class MarkdownAST
     Q_DECLARE_PRIVATE(MarkdownAST)
 
 public:
+    /**
+     * A range of line numbers, from first to last (inclusive).
+     */
+    typedef QPair<int, int> LineRange;
+
     /**
      * Constructor
      */
@@ -68,15 +282,35 @@ public:
 
     /**
      * Sets the root node of the AST, cloning the given cmark_node AST into
-     * a MarkdownNode AST.  Note that calling this routine will free the
-     * memory for the prior AST root node.
+     * a MarkdownNode AST.  Note that calling this routine will destroy the
+     * prior AST's nodes, though the memory backing them is retained and
+     * re-used for the new nodes.
+     *
+     * If the cmark_node AST was parsed from UTF-8 text, pass in the column
+     * map built while encoding the text so that the node positions are
+     * converted from byte offsets to QString offsets.
+     */
+    void setRoot(cmark_node *root, const Utf8ColumnMap *columns = nullptr);
+
+    /**
+     * Sets the root node of the AST, taking ownership of the given
+     * cmark_node AST rather than cloning it.  The nodes of this AST are
+     * views of the cmark_node AST, which is freed along with them.
+     *
+     * The cmark_node AST must have been allocated with cmark-gfm's default
+     * memory allocator rather than with its arena, which is reset after
+     * every parse.  See setRoot() regarding the column map.
      */
-    void setRoot(cmark_node *root);
+    void adoptRoot(cmark_node *root, const Utf8ColumnMap *columns = nullptr);
 
     /**
      * Finds the deepest node of type block (vs. inline) at the given
      * line number of the original Markdown text.  Returns nullptr if
      * no node is found at that location.
+     *
+     * The children of container nodes (i.e., the document, lists, and
+     * block quotes) are binary searched by line number, using an index
+     * that is built the first time each container is searched.
      */
     MarkdownNode *findBlockAtLine(int lineNumber) const;
 
@@ -87,10 +321,130 @@ public:
     QVector<MarkdownNode *> headings() const;
 
     /**
-     * Frees memory for this AST.
+     * Returns the nodes of the given types, in document order.  Without
+     * any types, returns every node, starting with the root.  For example:
+     *
+     *     for (MarkdownNode *link : ast->nodesOfType<MarkdownNode::Link>()) {
+     *         ...
+     *     }
+     *
+     * The nodes are found as the range is iterated over, without building
+     * a list of them, and only block nodes are walked if only block types
+     * are given.
+     */
+    template <MarkdownNode::NodeType... Types>
+    MarkdownNodeRange<Types...> nodesOfType() const
+    {
+        MarkdownNode *start = validRoot();
+
+        return MarkdownNodeRange<Types...>
+        (
+            start,
+            start,
+            0,
+            std::numeric_limits<int>::max()
+        );
+    }
+
+    /**
+     * Returns the nodes of the given types that lie within the given first
+     * and last lines (inclusive), in document order.  Without any types,
+     * returns every node within the lines, other than the root.  Nodes
+     * spanning either end of the range are included, such as the list
+     * containing the first line.
+     *
+     * The walk starts from the top-level block containing the first line,
+     * which is found with the same index as findBlockAtLine(), so that the
+     * cost depends on the size of the range rather than of the document.
+     */
+    template <MarkdownNode::NodeType... Types>
+    MarkdownNodeRange<Types...> nodesInLineRange(int firstLine, int lastLine) const
+    {
+        return MarkdownNodeRange<Types...>
+        (
+            validRoot(),
+            topLevelBlockAtLine(firstLine),
+            firstLine,
+            lastLine
+        );
+    }
+
+    /**
+     * Replaces the top-level blocks of this AST that start within the
+     * given first and last lines (inclusive) with copies of the top-level
+     * blocks of the given fragment AST.  The fragment's line numbers are
+     * taken to be relative to firstLine, i.e., line 1 of the fragment is
+     * placed at firstLine.  The top-level blocks following the replaced
+     * range have their line numbers shifted by lineDelta, which is the
+     * number of lines the document grew (or shrank) by within the range.
+     *
+     * Use this method to splice in the result of re-parsing only the
+     * region of the document that was edited.  The fragment AST is not
+     * modified, and can be freed afterwards.
+     *
+     * Returns the ranges of lines (in terms of the updated AST) whose
+     * block structure changed as a result of the replacement.
+     */
+    QVector<LineRange> replaceBlocks
+    (
+        int firstLine,
+        int lastLine,
+        int lineDelta,
+        const MarkdownAST *fragment
+    );
+
+    /**
+     * Compares this AST against the given previous AST for the same
+     * document, returning the ranges of lines whose node types or extents
+     * differ.  The lineDelta parameter is the number of lines the document
+     * grew (or shrank) by since the previous AST was parsed.
+     */
+    QVector<LineRange> changedLineRanges(const MarkdownAST *previous, int lineDelta) const;
+
+    /**
+     * Returns true if enough nodes have been discarded by calls to
+     * replaceBlocks() that the AST should be rebuilt from scratch to
+     * reclaim the memory of the discarded nodes.
+     */
+    bool needsCompaction() const;
+
+    /**
+     * Destroys the nodes of this AST.  The memory for the nodes is kept for
+     * re-use by the next call to setRoot().
      */
     void clear();
 
+    /**
+     * Frees the memory reserved for nodes beyond those of this tree, as
+     * well as the index of the nodes' children, which is rebuilt as it
+     * is needed.  Call when memory runs low.
+     */
+    void trim();
+
+    /**
+     * Returns the bytes of memory held by the nodes of this tree, including
+     * the arena capacity reserved for further nodes and the child index.
+     */
+    qint64 nodeMemory() const;
+
+    /**
+     * Returns the bytes of memory held by the text of the nodes.
+     */
+    qint64 textMemory() const;
+
+    /**
+     * Writes the nodes of this tree to the given stream, such as for
+     * caching the AST on disk.
+     */
+    void write(QDataStream &stream) const;
+
+    /**
+     * Replaces the nodes of this tree with those written to the given
+     * stream by write().  Returns false and leaves the tree empty if the
+     * stream could not be read.
+     */
+    bool read(QDataStream &stream);
+
     /**
      * Returns a string representation of this tree for use in debugging.
      */
@@ -98,6 +452,17 @@ public:
 
 private:
     QScopedPointer<MarkdownASTPrivate> d_ptr;
+
+    /*
+    * Returns the root node, or nullptr if the tree is empty.
+    */
+    MarkdownNode *validRoot() const;
+
+    /*
+    * Returns the last top-level block starting at or before the given
+    * line, or the first top-level block if none does.
+    */
+    MarkdownNode *topLevelBlockAtLine(int lineNumber) const;
 };
 } // namespace ghostwriter
 
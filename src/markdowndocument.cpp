@@ -19,21 +19,35 @@
 
 #include <QString>
 #include <QTextDocument>
+#include <QTimer>
 #include <QPlainTextDocumentLayout>
 #include <QFileInfo>
 
+#include "documentcache.h"
 #include "markdowndocument.h"
+#include "referenceindex.h"
+#include "tableformatter.h"
+#include "textblockdata.h"
+#include "vocabularyindex.h"
 
 namespace ghostwriter
 {
 MarkdownDocument::MarkdownDocument(QObject *parent)
-    : QTextDocument(parent), ast(nullptr)
+    : QTextDocument(parent), ast(nullptr), pendingHtmlRevision(-1),
+      previewRevision(-1), previewExporter(nullptr), refIndex(nullptr), vocabIndex(nullptr), tableFmt(nullptr), snapshotRevision(-1), undoMemoryEstimate(0),
+      undoMemoryLimit(0), undoRevision(-1), undoTrimPending(false),
+      removedBlocks(), transactionDepth(0), transactionStart(-1),
+      transactionEnd(-1), transactionDelta(0), transactionRevision(-1)
 {
     initializeUntitledDocument();
 }
 
 MarkdownDocument::MarkdownDocument(const QString &text, QObject *parent)
-    : QTextDocument(text, parent), ast(nullptr)
+    : QTextDocument(text, parent), ast(nullptr), pendingHtmlRevision(-1),
+      previewRevision(-1), previewExporter(nullptr), refIndex(nullptr), vocabIndex(nullptr), tableFmt(nullptr), snapshotRevision(-1), undoMemoryEstimate(0),
+      undoMemoryLimit(0), undoRevision(-1), undoTrimPending(false),
+      removedBlocks(), transactionDepth(0), transactionStart(-1),
+      transactionEnd(-1), transactionDelta(0), transactionRevision(-1)
 {
     initializeUntitledDocument();
 }
@@ -53,6 +67,12 @@ MarkdownDocument::~MarkdownDocument()
         delete ast;
         ast = nullptr;
     }
+
+    // The blocks outlive the indexes, and check for them as they are freed.
+    delete refIndex;
+    refIndex = nullptr;
+    delete vocabIndex;
+    vocabIndex = nullptr;
 }
 
 QString MarkdownDocument::displayName() const
@@ -107,6 +127,43 @@ void MarkdownDocument::setTimestamp(const QDateTime &timestamp)
 }
 
 
+QString MarkdownDocument::plainTextSnapshot() const
+{
+    if (snapshotRevision < 0) {
+        snapshotText = toPlainText();
+        snapshotRevision = revision();
+    }
+
+    return snapshotText;
+}
+
+qint64 MarkdownDocument::snapshotMemory() const
+{
+    return snapshotText.capacity() * sizeof(QChar);
+}
+
+qint64 MarkdownDocument::undoMemory() const
+{
+    return undoMemoryEstimate;
+}
+
+void MarkdownDocument::setUndoMemoryLimit(qint64 bytes)
+{
+    undoMemoryLimit = bytes;
+    countUndoMemory(0, 0);
+}
+
+void MarkdownDocument::releaseCaches()
+{
+    // Threads holding a copy of the snapshot keep their copy.
+    snapshotText = QString();
+    snapshotRevision = -1;
+
+    if (nullptr != ast) {
+        ast->trim();
+    }
+}
+
 MarkdownAST *MarkdownDocument::markdownAST() const
 {
     return ast;
@@ -114,13 +171,236 @@ MarkdownAST *MarkdownDocument::markdownAST() const
 
 void MarkdownDocument::setMarkdownAST(MarkdownAST *ast)
 {
+    QVector<MarkdownAST::LineRange> changedLines;
+
+    changedLines.append(MarkdownAST::LineRange(1, blockCount()));
+    setMarkdownAST(ast, changedLines);
+}
+
+void MarkdownDocument::setMarkdownAST
+(
+    MarkdownAST *ast,
+    const QVector<MarkdownAST::LineRange> &changedLines
+)
+{
+    if ((nullptr != this->ast) && (ast != this->ast)) {
+        delete this->ast;
+    }
+
     this->ast = ast;
+    this->astChanges = changedLines;
+    emit markdownASTChanged();
+}
+
+QVector<MarkdownAST::LineRange> MarkdownDocument::markdownASTChanges() const
+{
+    return astChanges;
+}
+
+bool MarkdownDocument::isHtmlRenderPending() const
+{
+    return (pendingHtmlRevision >= 0) && (pendingHtmlRevision == revision());
+}
+
+void MarkdownDocument::setHtmlRenderPending(int revision)
+{
+    pendingHtmlRevision = revision;
+}
+
+void MarkdownDocument::setRenderedHtml(const QString &html, int revision)
+{
+    if (revision == pendingHtmlRevision) {
+        pendingHtmlRevision = -1;
+    }
+
+    emit htmlRendered(html, revision);
+}
+
+void MarkdownDocument::setPreviewHtml
+(
+    const QStringList &blocks,
+    const QVariantList &blockLines,
+    int revision,
+    const Exporter *exporter
+)
+{
+    previewBlocks = blocks;
+    previewBlockLines = blocks.isEmpty() ? QVariantList() : blockLines;
+    previewRevision = blocks.isEmpty() ? -1 : revision;
+    previewExporter = blocks.isEmpty() ? nullptr : exporter;
 }
 
-void MarkdownDocument::notifyTextBlockRemoved(const QTextBlock &block)
+bool MarkdownDocument::previewHtml
+(
+    const Exporter *exporter,
+    bool smartTypographyEnabled,
+    QStringList &blocks
+) const
 {
-    emit textBlockRemoved(block.position());
-    emit textBlockRemoved(block);
+    // The preview always renders with smart typography.
+    if
+    (
+        !smartTypographyEnabled
+        || (nullptr == exporter)
+        || (exporter != previewExporter)
+        || (previewRevision != revision())
+    ) {
+        return false;
+    }
+
+    blocks = previewBlocks;
+    return true;
+}
+
+bool MarkdownDocument::previewHtml
+(
+    const Exporter *exporter,
+    bool smartTypographyEnabled,
+    int firstLine,
+    int lastLine,
+    QString &html
+) const
+{
+    QStringList blocks;
+
+    if ((firstLine > lastLine) || !previewHtml(exporter, smartTypographyEnabled, blocks)) {
+        return false;
+    }
+
+    // The block lines are a flat list of block index, first line and last
+    // line, in document order.
+    int count = previewBlockLines.size() / 3;
+    int i = 0;
+
+    while ((i < count) && (previewBlockLines[(i * 3) + 1].toInt() < firstLine)) {
+        i++;
+    }
+
+    if ((i >= count) || (previewBlockLines[(i * 3) + 1].toInt() != firstLine)) {
+        return false;
+    }
+
+    int firstBlock = previewBlockLines[i * 3].toInt();
+    int previousBlock = firstBlock - 1;
+    int previousLastLine = firstLine - 1;
+
+    for (; i < count; i++) {
+        int block = previewBlockLines[i * 3].toInt();
+        int blockFirstLine = previewBlockLines[(i * 3) + 1].toInt();
+        int blockLastLine = previewBlockLines[(i * 3) + 2].toInt();
+
+        if (blockFirstLine > lastLine) {
+            break;
+        }
+
+        // Blocks without source lines, such as raw HTML, or lines between
+        // blocks that are not blank, such as reference definitions, would
+        // be left out of the HTML.
+        //
+        if ((block != (previousBlock + 1)) || (blockLastLine > lastLine)) {
+            return false;
+        }
+
+        for (int line = previousLastLine + 1; line < blockFirstLine; line++) {
+            if (!findBlockByNumber(line - 1).text().trimmed().isEmpty()) {
+                return false;
+            }
+        }
+
+        previousBlock = block;
+        previousLastLine = blockLastLine;
+    }
+
+    if ((previousLastLine != lastLine) || (previousBlock >= blocks.size())) {
+        return false;
+    }
+
+    html = blocks.mid(firstBlock, previousBlock - firstBlock + 1).join('\n');
+    return true;
+}
+
+ReferenceIndex *MarkdownDocument::referenceIndex() const
+{
+    return refIndex;
+}
+
+VocabularyIndex *MarkdownDocument::vocabularyIndex() const
+{
+    return vocabIndex;
+}
+
+TableFormatter *MarkdownDocument::tableFormatter() const
+{
+    return tableFmt;
+}
+
+QSharedPointer<DocumentCache> MarkdownDocument::documentCache() const
+{
+    return cache;
+}
+
+void MarkdownDocument::setDocumentCache(const QSharedPointer<DocumentCache> &cache)
+{
+    this->cache = cache;
+}
+
+void MarkdownDocument::beginTransaction()
+{
+    if (0 == transactionDepth++) {
+        transactionStart = -1;
+        transactionEnd = -1;
+        transactionDelta = 0;
+        transactionRevision = revision();
+    }
+}
+
+void MarkdownDocument::commit()
+{
+    if (transactionDepth <= 0) {
+        return;
+    }
+
+    if ((--transactionDepth > 0) || (transactionStart < 0)) {
+        return;
+    }
+
+    int position = transactionStart;
+    int charsAdded = transactionEnd - transactionStart;
+    int charsRemoved = charsAdded - transactionDelta;
+
+    transactionStart = -1;
+    transactionEnd = -1;
+    transactionDelta = 0;
+
+    emit transactionCommitted(position, charsRemoved, charsAdded);
+}
+
+bool MarkdownDocument::isInTransaction() const
+{
+    return transactionDepth > 0;
+}
+
+void MarkdownDocument::notifyTextBlockRemoved(TextBlockData *blockData)
+{
+    if (nullptr != refIndex) {
+        refIndex->removeBlock(blockData);
+    }
+
+    if (nullptr != vocabIndex) {
+        vocabIndex->removeBlock(blockData);
+    }
+
+    removedBlocks.blockCount++;
+    removedBlocks.wordCount += blockData->wordCount;
+    removedBlocks.alphaNumericCharacterCount += blockData->alphaNumericCharacterCount;
+    removedBlocks.sentenceCount += blockData->sentenceCount;
+    removedBlocks.lixLongWordCount += blockData->lixLongWordCount;
+
+    if (!blockData->blankLine) {
+        removedBlocks.nonBlankCount++;
+    }
+
+    emit textBlockDataRemoved(blockData);
 }
 
 void MarkdownDocument::initializeUntitledDocument()
@@ -133,5 +413,127 @@ void MarkdownDocument::initializeUntitledDocument()
     readOnlyFlag = false;
     m_displayName = tr("untitled");
     m_timestamp = QDateTime::currentDateTime();
+
+    // Connect before anyone else can, so that the snapshot is discarded
+    // before any other listener asks for the changed text.
+    //
+    this->connect
+    (
+        this,
+        &QTextDocument::contentsChange,
+        [this](int position, int charsRemoved, int charsAdded) {
+            this->onContentsChange(position, charsRemoved, charsAdded);
+        }
+    );
+
+    // Index the references ahead of the highlighter, which looks them up.
+    refIndex = new ReferenceIndex(this);
+    vocabIndex = new VocabularyIndex(this);
+    tableFmt = new TableFormatter(this);
+}
+
+void MarkdownDocument::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // Blocks are freed while the document is being edited, and this is
+    // the first notice that the edit is done.
+    if (removedBlocks.blockCount > 0) {
+        RemovedBlocks removed = removedBlocks;
+        removedBlocks = RemovedBlocks();
+        emit textBlocksRemoved(removed);
+    }
+
+    // Highlighting also signals a change to the contents, but with the
+    // same number of characters removed as added and without changing
+    // the revision, so keep the snapshot then.  Note that the revision
+    // doesn't change either if undo is disabled, e.g., while loading.
+    //
+    if ((charsRemoved != charsAdded) || (revision() != snapshotRevision)) {
+        snapshotText.clear();
+        snapshotRevision = -1;
+    }
+
+    if (revision() != undoRevision) {
+        undoRevision = revision();
+        countUndoMemory(charsRemoved, charsAdded);
+    }
+
+    if (transactionDepth > 0) {
+        mergeTransactionChange(position, charsRemoved, charsAdded);
+    }
+}
+
+void MarkdownDocument::mergeTransactionChange(int position, int charsRemoved, int charsAdded)
+{
+    // Skip highlighting, as above.
+    if ((charsRemoved == charsAdded) && (revision() == transactionRevision)) {
+        return;
+    }
+
+    transactionRevision = revision();
+
+    if (transactionStart < 0) {
+        transactionStart = position;
+        transactionEnd = position + charsAdded;
+    } else {
+        // The end of the range shifts with the text after the change, or
+        // moves to the end of the change if the change overlaps it.
+        if (transactionEnd >= (position + charsRemoved)) {
+            transactionEnd += charsAdded - charsRemoved;
+        } else {
+            transactionEnd = position + charsAdded;
+        }
+
+        transactionStart = qMin(transactionStart, position);
+    }
+
+    transactionDelta += charsAdded - charsRemoved;
+}
+
+void MarkdownDocument::countUndoMemory(int charsRemoved, int charsAdded)
+{
+    // The history is empty after loading a file, for instance, which
+    // clears it without notice.
+    if (!isUndoRedoEnabled() || (0 == availableUndoSteps())) {
+        undoMemoryEstimate = 0;
+    }
+
+    // Undoing and redoing move steps between the undo and redo stacks,
+    // which holds on to no more memory, while any new edit clears the
+    // redo stack.  So only count the changes made with no steps to redo.
+    if
+    (
+        isUndoRedoEnabled()
+        && (0 == availableRedoSteps())
+        && ((charsRemoved + charsAdded) > 0)
+    ) {
+        undoMemoryEstimate +=
+            ((qint64) (charsRemoved + charsAdded) * sizeof(QChar))
+            + UndoStepOverhead;
+    }
+
+    if
+    (
+        (undoMemoryLimit > 0)
+        && (undoMemoryEstimate > undoMemoryLimit)
+        && !undoTrimPending
+    ) {
+        // Don't clear the history from within the change that is being
+        // recorded in it.
+        undoTrimPending = true;
+
+        QTimer::singleShot
+        (
+            0,
+            this,
+            [this]() {
+                undoTrimPending = false;
+
+                if ((undoMemoryLimit > 0) && (undoMemoryEstimate > undoMemoryLimit)) {
+                    clearUndoRedoStacks();
+                    undoMemoryEstimate = 0;
+                }
+            }
+        );
+    }
 }
 } // namespace ghostwriter
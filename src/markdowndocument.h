@@ -22,12 +22,22 @@
 
 #include <QTextDocument>
 #include <QString>
+#include <QStringList>
+#include <QVariantList>
 #include <QDateTime>
+#include <QSharedPointer>
 #include <QTextBlock>
 #include "markdownast.h"
 
 namespace ghostwriter
 {
+class DocumentCache;
+class Exporter;
+class ReferenceIndex;
+class TableFormatter;
+class TextBlockData;
+class VocabularyIndex;
+
 /**
  * Text document that maintains timestamp, read-only state, and new vs.
  * saved status.
@@ -37,6 +47,20 @@ class MarkdownDocument : public QTextDocument
     Q_OBJECT
 
 public:
+    /**
+     * Totals of the blocks removed from the document by a single edit,
+     * and of their statistics as counted by DocumentStatistics.
+     */
+    struct RemovedBlocks
+    {
+        int blockCount;
+        int nonBlankCount;
+        int wordCount;
+        int alphaNumericCharacterCount;
+        int sentenceCount;
+        int lixLongWordCount;
+    };
+
     /**
      * Constructor.
      */
@@ -95,15 +119,211 @@ public:
      */
     void setTimestamp(const QDateTime &timestamp);
 
+    /**
+     * Returns the document's plain text, as with toPlainText().  The text
+     * is copied out of the document at most once per change to it, and
+     * is implicitly shared with every caller until the next change, so
+     * that the text can be handed to the parser, the HTML preview and
+     * the save and export threads without copying it each time.  The
+     * returned string is safe to pass to other threads.
+     */
+    QString plainTextSnapshot() const;
+
+    /**
+     * Returns the bytes of memory held by the cached plain text snapshot.
+     * See plainTextSnapshot().
+     */
+    qint64 snapshotMemory() const;
+
+    /**
+     * Frees the memory held by the plain text snapshot and the memory
+     * reserved by the AST that its nodes do not use.  Both are rebuilt as
+     * they are needed, so call this method only when memory runs low.
+     */
+    void releaseCaches();
+
+    /**
+     * Returns an estimate of the bytes of memory held by the undo and redo
+     * history, which QTextDocument does not account for.  The estimate
+     * counts the text inserted and removed by each edit since the undo
+     * history was last empty.
+     */
+    qint64 undoMemory() const;
+
+    /**
+     * Sets the estimated memory, in bytes, that the undo history may hold
+     * before it is cleared, or zero for no limit.  QTextDocument neither
+     * exposes nor trims steps of its history, so once the limit is
+     * exceeded, the whole history is cleared, and the limit is best set
+     * generously.  Note that QTextDocument already merges consecutively
+     * typed characters into a single undo step.
+     */
+    void setUndoMemoryLimit(qint64 bytes);
+
+    /**
+     * Returns the AST for the document's Markdown text, or nullptr if
+     * the document has not been parsed yet.
+     */
     MarkdownAST *markdownAST() const;
+
+    /**
+     * Sets the AST for the document's Markdown text.  The document takes
+     * ownership of the AST, freeing the memory of the prior AST, if any.
+     * Emits markdownASTChanged(), even if the AST is the same as the prior
+     * one, so that the AST can be updated in place before calling this
+     * method.  The structure of the whole document is taken to have
+     * changed.
+     */
     void setMarkdownAST(MarkdownAST *ast);
 
     /**
-     * For internal use only with TextBlockData class.  Emits signals
-     * to notify listeners that the given text block is about to be
-     * removed from the document.
+     * Sets the AST for the document's Markdown text, as above, along with
+     * the ranges of lines whose structure changed from the prior AST.
+     */
+    void setMarkdownAST
+    (
+        MarkdownAST *ast,
+        const QVector<MarkdownAST::LineRange> &changedLines
+    );
+
+    /**
+     * Returns the ranges of lines whose structure changed with the AST
+     * last set, so that listeners of markdownASTChanged() can revisit only
+     * those lines, besides the lines that were edited.
+     */
+    QVector<MarkdownAST::LineRange> markdownASTChanges() const;
+
+    /**
+     * Returns true if HTML for the current revision of the document is
+     * being rendered alongside a full parse of its AST, in which case
+     * htmlRendered() will be emitted once it is ready.  Listeners such as
+     * the HTML preview can check this method to avoid parsing the
+     * document a second time.
+     */
+    bool isHtmlRenderPending() const;
+
+    /**
+     * Marks that HTML is being rendered for the given revision of the
+     * document.  See isHtmlRenderPending().
+     */
+    void setHtmlRenderPending(int revision);
+
+    /**
+     * Publishes the HTML rendered for the given revision of the document,
+     * emitting htmlRendered().
+     */
+    void setRenderedHtml(const QString &html, int revision);
+
+    /**
+     * Remembers the top-level HTML blocks that the given exporter rendered
+     * with smart typography from the given revision of the document for
+     * the live preview, so that exporting the same revision to HTML can
+     * write them out rather than render the document again.  The block
+     * lines are the source lines of the blocks, in the format given by
+     * HtmlBlockObserver::blockLines().  Pass in an empty list to forget
+     * them.
+     */
+    void setPreviewHtml
+    (
+        const QStringList &blocks,
+        const QVariantList &blockLines,
+        int revision,
+        const Exporter *exporter
+    );
+
+    /**
+     * Gets the HTML blocks remembered by setPreviewHtml(), if they were
+     * rendered from the current revision of the document by the given
+     * exporter with the given smart typography setting.  Returns false
+     * otherwise.
+     */
+    bool previewHtml
+    (
+        const Exporter *exporter,
+        bool smartTypographyEnabled,
+        QStringList &blocks
+    ) const;
+
+    /**
+     * Gets the HTML of the blocks remembered by setPreviewHtml() that were
+     * rendered from exactly the source lines firstLine to lastLine, as
+     * above.  Lines are numbered from 1.  Returns false if the lines are
+     * not covered by consecutive whole blocks, such as when they begin or
+     * end within a block, or hold text that renders no block of its own.
+     */
+    bool previewHtml
+    (
+        const Exporter *exporter,
+        bool smartTypographyEnabled,
+        int firstLine,
+        int lastLine,
+        QString &html
+    ) const;
+
+    /**
+     * Returns the index of the reference link and footnote definitions
+     * of the document, and of the blocks that refer to them.
+     */
+    ReferenceIndex *referenceIndex() const;
+
+    /**
+     * Returns the index of the words of the document, for word completion
+     * and for finding the words that the document repeats most.
      */
-    void notifyTextBlockRemoved(const QTextBlock &block);
+    VocabularyIndex *vocabularyIndex() const;
+
+    /**
+     * Returns the formatter keeping the columns of the document's pipe
+     * tables aligned.
+     */
+    TableFormatter *tableFormatter() const;
+
+    /**
+     * Returns the disk cache of the AST, statistics and misspellings of
+     * the file loaded into the document, if any, for use while the blocks
+     * of the document are counted and checked for the first time.
+     */
+    QSharedPointer<DocumentCache> documentCache() const;
+
+    /**
+     * Sets the disk cache of the file loaded into the document, or a null
+     * pointer to release it.
+     */
+    void setDocumentCache(const QSharedPointer<DocumentCache> &cache);
+
+    /**
+     * Starts a transaction, during which the changes made to the document
+     * are merged into a single change range instead of being processed
+     * one by one.  Listeners that honor transactions, such as the parser
+     * and the statistics, ignore contentsChange() while isInTransaction()
+     * is true, and process the merged range once transactionCommitted()
+     * is emitted.  Transactions nest, with only the outermost commit()
+     * ending the transaction.  Call this method before a bulk edit such as
+     * replacing all matches of a search or reformatting a table.
+     */
+    void beginTransaction();
+
+    /**
+     * Ends the transaction started by the matching call to
+     * beginTransaction(), emitting transactionCommitted() with the merged
+     * change range if this ends the outermost transaction and the text of
+     * the document changed during it.
+     */
+    void commit();
+
+    /**
+     * Returns true if a transaction is in progress.  See
+     * beginTransaction().
+     */
+    bool isInTransaction() const;
+
+    /**
+     * For internal use only with TextBlockData class.  Notifies listeners
+     * that the text block with the given data is about to be removed from
+     * the document, and adds the block to the totals that are reported
+     * once the edit removing it is done.
+     */
+    void notifyTextBlockRemoved(TextBlockData *blockData);
 
 signals:
     /**
@@ -112,16 +332,41 @@ signals:
     void filePathChanged();
 
     /**
-     * Emitted when the QTextBlock at the given position in the document
-     * is removed.
+     * Emitted when a new or updated AST is set for the document's
+     * Markdown text.
      */
-    void textBlockRemoved(int position);
+    void markdownASTChanged();
 
     /**
-     * Emitted when a QTextBlock is removed from the document.  Parameter
-     * is the QTextBlock that is being removed.
+     * Emitted when HTML has been rendered for the given revision of the
+     * document alongside a full parse of its AST.
      */
-    void textBlockRemoved(const QTextBlock &block);
+    void htmlRendered(const QString &html, int revision);
+
+    /**
+     * Emitted by commit() at the end of a transaction, with a single
+     * change range covering every change made to the text during the
+     * transaction, given as for contentsChange().
+     */
+    void transactionCommitted(int position, int charsRemoved, int charsAdded);
+
+    /**
+     * Emitted once an edit that removed blocks from the document is done,
+     * before contentsChange() reaches other listeners, with the totals of
+     * the removed blocks.  Removing thousands of blocks at once, such as
+     * when deleting a large selection or loading a file, is thus reported
+     * only once.
+     */
+    void textBlocksRemoved(const MarkdownDocument::RemovedBlocks &removed);
+
+    /**
+     * Emitted when a QTextBlock is removed from the document, with the
+     * TextBlockData of the block, which is being freed.  This signal is
+     * emitted for each block in the middle of an edit, so listeners should
+     * only forget the pointer to the data, leaving any other work to
+     * textBlocksRemoved().
+     */
+    void textBlockDataRemoved(TextBlockData *blockData);
 
 private:
     QString m_displayName;
@@ -129,11 +374,74 @@ private:
     bool readOnlyFlag;
     QDateTime m_timestamp;
     MarkdownAST *ast;
+    QVector<MarkdownAST::LineRange> astChanges;
+    int pendingHtmlRevision;
+
+    // HTML blocks of the live preview, their source lines, the revision
+    // they were rendered from, and the exporter that rendered them.
+    QStringList previewBlocks;
+    QVariantList previewBlockLines;
+    int previewRevision;
+    const Exporter *previewExporter;
+    ReferenceIndex *refIndex;
+    VocabularyIndex *vocabIndex;
+    TableFormatter *tableFmt;
+    QSharedPointer<DocumentCache> cache;
+
+    // Text returned by plainTextSnapshot(), and the revision it was taken
+    // at, or -1 if the document has changed since.
+    mutable QString snapshotText;
+    mutable int snapshotRevision;
+
+    // Estimated bytes held by the undo history, its limit, the revision
+    // last counted towards it, and whether clearing the history is queued.
+    qint64 undoMemoryEstimate;
+    qint64 undoMemoryLimit;
+    int undoRevision;
+    bool undoTrimPending;
+
+    // Totals of the blocks removed by the edit in progress.
+    RemovedBlocks removedBlocks;
+
+    // Nesting depth of the transaction in progress, the range of the
+    // document changed by it so far, from start to end in the current
+    // text, the change in the length of the text, and the revision of
+    // the last change merged into the range.
+    int transactionDepth;
+    int transactionStart;
+    int transactionEnd;
+    int transactionDelta;
+    int transactionRevision;
+
+    /*
+    * Estimated bytes of bookkeeping held by each undo step besides its
+    * text.
+    */
+    static const int UndoStepOverhead = 48;
 
     /*
     * Initializes the class for an untitled document.
     */
     void initializeUntitledDocument();
+
+    /*
+    * Discards the plain text snapshot if the given change to the document
+    * changed its text.
+    */
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+    /*
+    * Merges the given change to the document into the change range of the
+    * transaction in progress.
+    */
+    void mergeTransactionChange(int position, int charsRemoved, int charsAdded);
+
+    /*
+    * Counts the given change to the document towards the estimated memory
+    * of the undo history, and queues clearing the history if the estimate
+    * exceeds its limit.
+    */
+    void countUndoMemory(int charsRemoved, int charsAdded);
 };
 } // namespace ghostwriter
 
@@ -19,26 +19,47 @@
  *
  ***********************************************************************/
 
+#include <algorithm>
+#include <functional>
+
+#include <QAbstractItemView>
+#include <QAbstractTextDocumentLayout>
+#include <QAtomicInt>
 #include <QApplication>
 #include <QChar>
 #include <QColor>
+#include <QCompleter>
 #include <QDesktopWidget>
+#include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFileInfo>
+#include <QFuture>
+#include <QFutureWatcher>
 #include <QGuiApplication>
 #include <QHeaderView>
+#include <QKeyEvent>
 #include <QMenu>
 #include <QMimeData>
+#ifndef QT_NO_OPENGL
+#include <QOpenGLWidget>
+#include <QSurfaceFormat>
+#endif
 #include <QPainter>
 #include <QPainterPath>
 #include <QPixmap>
 #include <QScreen>
 #include <QScrollBar>
+#include <QSet>
+#include <QSignalBlocker>
+#include <QSharedPointer>
 #include <QString>
+#include <QStringListModel>
 #include <QTextBoundaryFinder>
 #include <QTextStream>
 #include <QTimer>
 #include <QUrl>
+#include <QVector>
 
 #include <QGridLayout>
 #include <QLayout>
@@ -51,17 +72,37 @@
 #include <QTextCursor>
 
 #include "cmarkgfmapi.h"
+#include "documentcache.h"
+#include "imagestore.h"
+#include "incrementalparser.h"
+#include "latencymonitor.h"
 #include "markdowneditor.h"
 #include "markdownhighlighter.h"
 #include "markdownstates.h"
 #include "spelling/dictionary_manager.h"
 #include "spelling/dictionary_ref.h"
 #include "spelling/spell_checker.h"
+#include "tableformatter.h"
+#include "taskscheduler.h"
+#include "textblockdata.h"
+#include "tracer.h"
+#include "typingactivity.h"
+#include "vocabularyindex.h"
 
 #define GW_TEXT_FADE_FACTOR 1.5
 
 namespace ghostwriter
 {
+/*
+* Result of a full parse of the document run in the background.  The html
+* is null unless HTML rendering was enabled when the parse started.
+*/
+struct ParseResult
+{
+    MarkdownAST *ast = nullptr;
+    QString html;
+};
+
 class MarkdownEditorPrivate
 {
     Q_DECLARE_PUBLIC(MarkdownEditor)
@@ -69,14 +110,15 @@ class MarkdownEditorPrivate
 public:
     MarkdownEditorPrivate(MarkdownEditor *q_ptr)
         : q_ptr(q_ptr),
-          dictionary(DictionaryManager::instance().requestDictionary())
+          dictionary(DictionaryManager::instance().requestDictionary()),
+          incrementalParser(nullptr)
     {
         ;
     }
 
     ~MarkdownEditorPrivate()
     {
-        ;
+        delete incrementalParser;
     }
 
     typedef enum {
@@ -85,10 +127,23 @@ public:
         BlockTypeCode
     } BlockType;
 
+    // Returns the new text of the given block, which is at the given
+    // index within the blocks being transformed.  See transformBlocks().
+    typedef std::function<QString(const QTextBlock &block, int index)> BlockTransform;
+
     MarkdownEditor *q_ptr;
 
     MarkdownDocument *textDocument;
     MarkdownHighlighter *highlighter;
+
+    // The editor whose document this editor is a secondary view of, such
+    // as for a split view, or null if this editor owns the highlighter and
+    // parses the document.  Views share said editor's highlighter, AST
+    // and spell checking, and the editor passes on the settings that
+    // apply to each view to its views.
+    MarkdownEditor *primary;
+    QList<MarkdownEditor *> views;
+    ColorScheme colors;
     QGridLayout *preferredLayout;
     QAction *addWordToDictionaryAction;
     QAction *checkSpellingAction;
@@ -96,8 +151,33 @@ public:
     QTextCursor cursorForWord;
     DictionaryRef dictionary;
     bool spellCheckEnabled;
+
+    // Most misspelled words in view whose suggestions are searched for
+    // when typing pauses, so that the context menu has them at hand.
+    static const int MaxPrefetchedSuggestions = 20;
+    TaskScheduler::CancellationToken suggestionPrefetch;
     bool autoMatchEnabled;
     bool bulletPointCyclingEnabled;
+
+    // Popup offering the words of the document that complete the word
+    // being typed once at least CompletionPrefixLength characters of it
+    // are typed.  Only words of at least CompletedWordLength characters
+    // are offered, since shorter words are as quick to type.
+    static const int CompletionPrefixLength = 3;
+    static const int CompletedWordLength = 7;
+    static const int MaxCompletions = 8;
+    bool wordCompletionEnabled;
+    QCompleter *completer;
+    QStringListModel *completionModel;
+
+    // Whether table cells are re-padded as they are typed in.
+    bool tableFormattingEnabled;
+
+    // Whether dropped images are copied into the assets folder next to the
+    // document, and the width to which they are downscaled, or zero.
+    bool imageImportEnabled;
+    int imageImportMaxWidth;
+
     QList<QAction *> spellingActions;
     bool hemingwayModeEnabled;
     FocusMode focusMode;
@@ -129,31 +209,186 @@ public:
     bool mouseButtonDown;
     QColor cursorColor;
     bool textCursorVisible;
+    LatencyMonitor *latencyMonitor;
     QTimer *cursorBlinkTimer;
 
-    // Timers used to determine when typing has paused.
-    QTimer *typingTimer;
-    QTimer *scaledTypingTimer;
-
-    bool typingHasPaused;
-    bool scaledTypingHasPaused;
-
-    // Use these flags to keep from sending the typingPaused() and
-    // typingPausedScaled() signals multiple times after they have
-    // already been sent the first time after a pause in the user's
-    // typing.
-    //
-    bool typingPausedSignalSent;
-    bool typingPausedScaledSignalSent;
-
+    // Steps the scroll towards the text cursor once per frame in focus
+    // and typewriter modes, so that the cursor moves of a frame, such as
+    // those of a held down arrow key, cause a single scroll between them.
+    static const int ScrollFrameInterval = 16;
+    static const int ScrollEasing = 3;
+    QTimer *scrollFrameTimer;
+
+    // Sentence boundaries within the block last focused in sentence focus
+    // mode, together with the block and its revision that they were found
+    // for.
+    QTextBlock sentenceBlock;
+    int sentenceBlockRevision;
+    QVector<int> sentenceBoundaries;
+
+    // Viewport area of the text cursor as last painted, which needs to be
+    // repainted when the cursor blinks or moves.
+    QRect paintedCursorRect;
+
+    // Whether the viewport is drawn with OpenGL.
+    bool gpuViewportEnabled;
+
+    // Determines when typing has paused, for the typingPaused() and
+    // typingPausedScaled() signals.  The scaled pause lasts a multiple of
+    // the time that incremental parses take, within the given bounds.
+    static const int TypingPauseLength = 1000;
+    static const int ScaledPauseCostFactor = 10;
+    static const int MinScaledPauseLength = 20;
+    static const int MaxScaledPauseLength = 1000;
+    TypingActivity *typingActivity;
+    int typingPause;
+    int scaledTypingPause;
+
+    // Whether the cursor blink timer is kept from waking up the
+    // application, while the window is in the background.
+    bool powerSaving;
+
+    // Line count of the document as of the last parse, for use in
+    // determining how many lines an edit added or removed.
+    int lastBlockCount;
+
+    // Full parses of the document run in the background.  These flags
+    // work the same as in HtmlPreview: if the text changes while a parse
+    // is in progress, another parse is started once it finishes.
+    QFutureWatcher<ParseResult> *parseWatcher;
+    bool parseInProgress;
+    bool parseAgain;
+    int parseRevision;
+
+    // Whether full parses wait until typing pauses, and whether one is
+    // waiting.
+    bool backgroundParseDeferred;
+    bool parseDeferred;
+
+    // Whether parsing is suspended while a file with a cached AST loads,
+    // and whether the result of the parse in progress is to be thrown
+    // away, since it is of the text that the file replaced.
+    bool parsingSuspended;
+    bool parseDiscarded;
+
+    // Pastes with more characters than this are inserted in chunks of
+    // about PasteChunkSize characters from the event loop, for at most
+    // PasteBatchTime milliseconds at a time.  Until the paste is done, the
+    // text still to insert, the position within it of the next chunk, the
+    // cursor at which to insert the chunk, and the document revision after
+    // the last chunk, by which edits from elsewhere cancel the paste.
+    // Full parses wait for the paste to finish.
+    static const int LargePasteSize = 128 * 1024;
+    static const int PasteChunkSize = 32 * 1024;
+    static const int PasteBatchTime = 20;
+    bool pasteInProgress;
+    QString pasteText;
+    int pastePosition;
+    QTextCursor pasteCursor;
+    int pasteRevision;
+    QTimer *pasteTimer;
+
+    // While the editor is being resized, its viewport keeps the width it
+    // had when resizing began, as long as it fits, so that the document is
+    // not laid out again on every step.  Once resizing settles, the paper
+    // margins are set up for the final size.
+    static const int ResizeSettleTime = 150;
+    QTimer *resizeSettleTimer;
+    int liveResizeTextWidth;
+
+    // Zooming applies the first font size right away, and then only the
+    // last of the sizes requested in quick succession, such as while the
+    // mouse wheel turns, since each size lays out and highlights the
+    // document anew.
+    static const int ZoomSettleTime = 150;
+    QTimer *zoomSettleTimer;
+    int pendingFontSize;
+
+    // First and last lines edited since the last AST was published.
+    int dirtyStartLine;
+    int dirtyEndLine;
+
+    // Incremental parses run on the GUI thread, so lines whose parse took
+    // longer than ParseBudget milliseconds, such as those of a huge table
+    // or of deeply nested brackets, are marked as slow.  Edits near slow
+    // lines are parsed in the background instead, and the slow lines are
+    // highlighted without the AST until the parse finishes.  Likewise,
+    // documents of more than SyncParseLimit characters are never parsed
+    // in full on the GUI thread.
+    static const int ParseBudget = 50;
+    static const int SyncParseLimit = 256 * 1024;
+    int slowStartLine;
+    int slowEndLine;
+    bool fallbackHighlighting;
+
+    // Whether full parses also render the document to HTML for the
+    // preview.  Since the HTML preview uses smart typography, so do all
+    // parses for the AST while this is enabled, so that the ASTs parsed
+    // in full agree with those parsed incrementally.
+    bool htmlRenderingEnabled;
+
+    // Splices the edits of the document into its AST between full parses.
+    IncrementalParser *incrementalParser;
+
+    // Backgrounds of the code blocks and block quotes last drawn, for
+    // reuse by repaints that change neither the visible text nor its
+    // layout, such as those of the blinking cursor.  The cache is keyed by
+    // the scroll position, the viewport size and the states of the visible
+    // blocks, and is invalidated whenever the document layout changes.
+    QVector<QPainterPath> blockAreaPaths;
+    QVector<int> blockAreaStates;
+    bool blockAreasValid;
+    int blockAreasFirstBlock;
+    QPointF blockAreasOffset;
+    QSize blockAreasViewportSize;
+
+    // Whether any section has been folded since the last time every
+    // section was unfolded, in which case painting marks the headings of
+    // the folded sections.  Since folding hides the blocks of the shared
+    // document, views use the flag of the editor.
+    bool foldsPresent;
+
+    MarkdownEditorPrivate *owner();
     void toggleCursorBlink();
+    void applyColors(const ColorScheme &colors);
+    void findSentence(const QTextBlock &block, int position, int &start, int &end);
+    QRect textCursorRect() const;
+    void updateTextCursor();
+    void invalidateBlockAreas();
+    void replaceViewport();
+    int centeredScrollValue();
+    void stepScroll();
+    void keepTextWidth(int width);
+    void zoomTo(int fontSize);
+    int zoomedFontSize() const;
+    void onScrolled();
+    void prefetchSuggestions();
+    void addSuggestionActions(QMenu *menu, QAction *before, const QStringList &suggestions);
+    bool blockAreasCurrent() const;
+    void computeBlockAreas();
     void parseDocument();
+    void parseDocument(int position, int charsAdded);
+    void parseDocumentInBackground();
+    void startBackgroundParse();
+    void onParseFinished();
+    void rehighlightLines(QVector<MarkdownAST::LineRange> ranges);
+    void markLinesDirty(int startLine, int endLine, int lineDelta);
+    void shiftSlowLines(int editStartLine, int oldEditEndLine, int lineDelta);
+    void logSlowParse(int firstLine, int lastLine, qint64 msecs);
 
     void handleCarriageReturn();
     bool handleBackspaceKey();
+    bool transformBlocks(const BlockTransform &transform);
     void insertPrefixForBlocks(const QString &prefix);
     void createNumberedList(const QChar marker);
+    int pasteChunkLength(int position, int length) const;
+    void insertNextPasteChunks();
+    void finishPaste();
+    void importImage(const QTextCursor &cursor, const QString &sourcePath);
     bool insertPairedCharacters(const QChar firstChar);
+    int wordStartBeforeCursor(const QTextCursor &cursor) const;
+    void updateCompletions(const QKeyEvent *e);
+    void insertCompletion(const QString &completion);
     bool handleEndPairCharacterTyped(const QChar ch);
     bool handleWhitespaceInEmptyMatch(const QChar whitespace);
     void insertFormattingMarkup(const QString &markup);
@@ -171,6 +406,12 @@ public:
     bool atCodeBlockEnd(const QTextBlock &block) const;
     bool isBlockquote(const QTextBlock &block) const;
     bool isCodeBlock(const QTextBlock &block) const;
+
+    bool findSection(int blockNumber, int &firstBlock, int &lastBlock) const;
+    void setSectionFolded(int firstBlock, int lastBlock, bool folded);
+    void unfoldSection(const QTextBlock &heading);
+    void revealBlock(const QTextBlock &block);
+    void paintFoldMarkers(QPainter &painter);
 };
 
 MarkdownEditor::MarkdownEditor
@@ -181,17 +422,110 @@ MarkdownEditor::MarkdownEditor
 )
     : QPlainTextEdit(parent),
       d_ptr(new MarkdownEditorPrivate(this))
+{
+    initialize(textDocument, colors, nullptr);
+}
+
+MarkdownEditor::MarkdownEditor(MarkdownEditor *primary, QWidget *parent)
+    : QPlainTextEdit(parent),
+      d_ptr(new MarkdownEditorPrivate(this))
+{
+    initialize(primary->d_func()->textDocument, primary->d_func()->colors, primary);
+}
+
+void MarkdownEditor::initialize
+(
+    MarkdownDocument *textDocument,
+    const ColorScheme &colors,
+    MarkdownEditor *primary
+)
 {
     Q_D(MarkdownEditor);
     
     d->textDocument = textDocument;
+    d->primary = primary;
+    d->lastBlockCount = textDocument->blockCount();
+    d->incrementalParser = new IncrementalParser(textDocument);
+    d->parseInProgress = false;
+    d->parseAgain = false;
+    d->parseRevision = 0;
+    d->backgroundParseDeferred = false;
+    d->parseDeferred = false;
+    d->parsingSuspended = false;
+    d->parseDiscarded = false;
+    d->pasteInProgress = false;
+    d->pastePosition = 0;
+    d->pasteRevision = -1;
+    d->htmlRenderingEnabled = false;
+    d->dirtyStartLine = -1;
+    d->dirtyEndLine = -1;
+    d->slowStartLine = -1;
+    d->slowEndLine = -1;
+    d->fallbackHighlighting = false;
+    d->blockAreasValid = false;
+    d->blockAreasFirstBlock = -1;
+    d->sentenceBlockRevision = -1;
+    d->latencyMonitor = new LatencyMonitor(this);
+
+    d->parseWatcher = new QFutureWatcher<ParseResult>(this);
+    this->connect
+    (
+        d->parseWatcher,
+        &QFutureWatcher<ParseResult>::finished,
+        [d]() {
+            d->onParseFinished();
+        }
+    );
     d->autoMatchEnabled = true;
     d->bulletPointCyclingEnabled = true;
+    d->imageImportEnabled = false;
+    d->imageImportMaxWidth = 0;
     d->mouseButtonDown = false;
 
+    d->wordCompletionEnabled = true;
+    d->tableFormattingEnabled = true;
+    d->gpuViewportEnabled = false;
+    d->completionModel = new QStringListModel(this);
+    d->completer = new QCompleter(d->completionModel, this);
+    d->completer->setWidget(this);
+    d->completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    this->connect
+    (
+        d->completer,
+        static_cast<void (QCompleter::*)(const QString &)>(&QCompleter::activated),
+        [d](const QString &completion) {
+            d->insertCompletion(completion);
+        }
+    );
+
     this->setDocument(textDocument);
     this->setAcceptDrops(true);
 
+    this->connect
+    (
+        textDocument->documentLayout(),
+        &QAbstractTextDocumentLayout::update,
+        [d]() {
+            d->invalidateBlockAreas();
+        }
+    );
+    this->connect
+    (
+        textDocument->documentLayout(),
+        &QAbstractTextDocumentLayout::updateBlock,
+        [d]() {
+            d->invalidateBlockAreas();
+        }
+    );
+    this->connect
+    (
+        this->verticalScrollBar(),
+        &QScrollBar::valueChanged,
+        [d]() {
+            d->onScrolled();
+        }
+    );
+
     d->preferredLayout = new QGridLayout();
     d->preferredLayout->setSpacing(0);
     d->preferredLayout->setMargin(0);
@@ -255,38 +589,59 @@ MarkdownEditor::MarkdownEditor
 
     connect(this, SIGNAL(cursorPositionChanged()), this, SLOT(onCursorPositionChanged()));
     connect(this->document(), SIGNAL(contentsChange(int, int, int)), this, SLOT(onContentsChanged(int, int, int)));
-    connect(this->document(), SIGNAL(textBlockRemoved(const QTextBlock &)), this, SLOT(onTextBlockRemoved(const QTextBlock &)));
+    connect(this->document(), SIGNAL(transactionCommitted(int, int, int)), this, SLOT(onContentsChanged(int, int, int)));
     connect(this, SIGNAL(selectionChanged()), this, SLOT(onSelectionChanged()));
 
-    d->highlighter = new MarkdownHighlighter(this, colors);
+    // Views share the highlighter of the editor, so that the document is
+    // highlighted and spell checked only once.
+    if (nullptr == primary) {
+        d->highlighter = new MarkdownHighlighter(this, colors);
+    } else {
+        d->highlighter = primary->d_func()->highlighter;
+        d->highlighter->addView(this);
+        primary->d_func()->views.append(this);
+    }
+
     d->addWordToDictionaryAction = new QAction(tr("Add word to dictionary"), this);
     d->checkSpellingAction = new QAction(tr("Check spelling..."), this);
 
-    d->typingPausedSignalSent = true;
-    d->typingHasPaused = true;
+    d->powerSaving = false;
+    d->foldsPresent = false;
+
+    d->typingActivity = new TypingActivity(this);
+    d->typingPause = d->typingActivity->addPause(MarkdownEditorPrivate::TypingPauseLength);
+    d->scaledTypingPause = d->typingActivity->addAdaptivePause
+        (
+            MarkdownEditorPrivate::ScaledPauseCostFactor,
+            MarkdownEditorPrivate::MinScaledPauseLength,
+            MarkdownEditorPrivate::MaxScaledPauseLength
+        );
 
-    d->typingTimer = new QTimer(this);
-    connect
+    this->connect
     (
-        d->typingTimer,
-        SIGNAL(timeout()),
+        d->typingActivity,
+        &TypingActivity::typingResumed,
         this,
-        SLOT(checkIfTypingPaused())
+        &MarkdownEditor::typingResumed
     );
-    d->typingTimer->start(1000);
+    this->connect
+    (
+        d->typingActivity,
+        &TypingActivity::pauseReached,
+        [this, d](int pause) {
+            if (pause == d->scaledTypingPause) {
+                emit typingPausedScaled();
+                return;
+            }
 
-    d->typingPausedScaledSignalSent = true;
-    d->scaledTypingHasPaused = true;
+            if (d->parseDeferred && !d->parseInProgress) {
+                d->startBackgroundParse();
+            }
 
-    d->scaledTypingTimer = new QTimer(this);
-    connect
-    (
-        d->scaledTypingTimer,
-        SIGNAL(timeout()),
-        this,
-        SLOT(checkIfTypingPausedScaled())
+            d->prefetchSuggestions();
+            emit typingPaused();
+        }
     );
-    d->scaledTypingTimer->start(1000);
 
     this->setColorScheme(colors);
     d->textCursorVisible = true;
@@ -301,11 +656,105 @@ MarkdownEditor::MarkdownEditor
         }
     );
     d->cursorBlinkTimer->start(500);
+
+    d->scrollFrameTimer = new QTimer(this);
+    d->scrollFrameTimer->setTimerType(Qt::PreciseTimer);
+    d->scrollFrameTimer->setInterval(MarkdownEditorPrivate::ScrollFrameInterval);
+    this->connect
+    (
+        d->scrollFrameTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->stepScroll();
+        }
+    );
+
+    d->pasteTimer = new QTimer(this);
+    d->pasteTimer->setInterval(0);
+    this->connect
+    (
+        d->pasteTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->insertNextPasteChunks();
+        }
+    );
+
+    d->liveResizeTextWidth = 0;
+    d->resizeSettleTimer = new QTimer(this);
+    d->resizeSettleTimer->setSingleShot(true);
+    d->resizeSettleTimer->setInterval(MarkdownEditorPrivate::ResizeSettleTime);
+    this->connect
+    (
+        d->resizeSettleTimer,
+        &QTimer::timeout,
+        [this]() {
+            setupPaperMargins();
+            centerCursor();
+        }
+    );
+
+    d->pendingFontSize = 0;
+    d->zoomSettleTimer = new QTimer(this);
+    d->zoomSettleTimer->setSingleShot(true);
+    d->zoomSettleTimer->setInterval(MarkdownEditorPrivate::ZoomSettleTime);
+    this->connect
+    (
+        d->zoomSettleTimer,
+        &QTimer::timeout,
+        [this, d]() {
+            if (d->pendingFontSize > 0) {
+                setFont(this->font().family(), d->pendingFontSize);
+                d->pendingFontSize = 0;
+            }
+        }
+    );
+
+    // Views start out with the settings of the editor.
+    if (nullptr != primary) {
+        MarkdownEditorPrivate *editor = primary->d_func();
+
+        d->autoMatchEnabled = editor->autoMatchEnabled;
+        d->autoMatchFilter = editor->autoMatchFilter;
+        d->bulletPointCyclingEnabled = editor->bulletPointCyclingEnabled;
+        d->wordCompletionEnabled = editor->wordCompletionEnabled;
+        d->tableFormattingEnabled = editor->tableFormattingEnabled;
+        d->imageImportEnabled = editor->imageImportEnabled;
+        d->imageImportMaxWidth = editor->imageImportMaxWidth;
+        d->insertSpacesForTabs = editor->insertSpacesForTabs;
+        d->hemingwayModeEnabled = editor->hemingwayModeEnabled;
+        d->editorWidth = editor->editorWidth;
+        d->editorCorners = editor->editorCorners;
+        d->spellCheckEnabled = editor->spellCheckEnabled;
+        d->dictionary = editor->dictionary;
+        this->setFont(primary->font().family(), primary->font().pointSizeF());
+        this->setTabulationWidth(editor->tabWidth);
+        this->setFocusMode(editor->focusMode);
+        this->setPowerSavingEnabled(editor->powerSaving);
+        this->setGpuViewportEnabled(editor->gpuViewportEnabled);
+    }
 }
 
 MarkdownEditor::~MarkdownEditor()
 {
-    ;
+    Q_D(MarkdownEditor);
+
+    // Views can't outlive the highlighter that they share.
+    if (nullptr != d->primary) {
+        d->primary->d_func()->views.removeAll(this);
+    } else {
+        QList<MarkdownEditor *> views = d->views;
+
+        d->views.clear();
+        qDeleteAll(views);
+    }
+
+    // Wait for the parser thread to finish, and free its result since it
+    // will never be published.
+    if (d->parseInProgress) {
+        d->parseWatcher->waitForFinished();
+        delete d->parseWatcher->result().ast;
+    }
 }
 
 void MarkdownEditor::paintEvent(QPaintEvent *event)
@@ -313,170 +762,60 @@ void MarkdownEditor::paintEvent(QPaintEvent *event)
     Q_D(MarkdownEditor);
     
     QPainter painter(viewport());
-    QRect viewportRect = viewport()->rect();
-    painter.fillRect(viewportRect, Qt::transparent);
-
-    QPointF offset(contentOffset());
-    QTextBlock block = firstVisibleBlock();
-
-    bool firstVisible = true;
-
-    QRectF blockAreaRect; // Code or block quote rect.
-    bool inBlockArea = false;
-    MarkdownEditorPrivate::BlockType blockType = MarkdownEditorPrivate::BlockTypeNone;
-    bool clipTop = false;
-    bool drawBlock = false;
-    int dy = 0;
-    bool done = false;
 
-    int cornerRadius = 5;
+    // An OpenGL viewport keeps its previous frame rather than being filled
+    // with the background, so fill the area being repainted.  Clip to it so
+    // that the parts of the frame left as they were stay consistent.
+    if (d->gpuViewportEnabled) {
+        painter.setClipRect(event->rect());
+        painter.fillRect(event->rect(), d->colors.background);
+    } else {
+        painter.fillRect(viewport()->rect(), Qt::transparent);
+    }
 
-    if (InterfaceStyleSquare == d->editorCorners) {
-        cornerRadius = 0;
+    if (!d->blockAreasCurrent()) {
+        d->computeBlockAreas();
     }
 
     // Draw text block area backgrounds for code blocks and block quotes.
-    // The backgrounds are drawn per each block area (consisting of multiple
-    // text blocks or lines), rather than one rectangle area per text block/
-    // line in case there are margins between each text block.  This way,
-    // the background will extend to cover the margins between text blocks
-    // as well.
-    //
-    // NOTE: Algorithm for looping through text blocks is a partial lift from
-    //       Qt's QPlainTextEdit paintEvent() code. Please refer to the
-    //       LGPL v. 3 license for the original Qt code.
-    //
-    while (block.isValid() && !done) {
-        MarkdownEditorPrivate::BlockType prevType;
-        
-        QRectF r = this->blockBoundingRect(block).translated(offset);
-
-        // If the first visible block is in the middle of a text block area...
-        if (firstVisible 
-                && d->insideBlockArea(block, blockType)
-                && d->insideBlockArea(block.previous(), prevType)
-                && (blockType == prevType)) {
-            clipTop = true;
-            inBlockArea = true;
-            blockAreaRect = r;
-            dy = 0;
-        }
-        // If the block begins a new text block area...
-        else if (!inBlockArea && d->atBlockAreaStart(block, blockType)) {
-            blockAreaRect = r;
-            dy = 0;
-            inBlockArea = true;
-
-            // If this is the first visible block within the viewport
-            // and if the previous block is part of the text block area,
-            // then the rectangle to draw for the block area will have
-            // its top clipped by the viewport and will need to be
-            // drawn specially.
-            //
-            if
-            (
-                firstVisible
-                && d->insideBlockArea(block.previous(), prevType)
-                && (blockType == prevType)
-            ) {
-                clipTop = true;
-            }
-        }
-        // Else if the block ends a text block area...
-        else if (inBlockArea && d->atBlockAreaEnd(block, blockType)) {
-            drawBlock = true;
-            inBlockArea = false;
-            blockAreaRect.setHeight(dy);
-        }
-
-        // If the block is at the end of the document and ends a text
-        // block area...
-        //
-        if (inBlockArea && (block == this->document()->lastBlock())) {
-            drawBlock = true;
-            inBlockArea = false;
-            dy += r.height();
-            blockAreaRect.setHeight(dy);
-        }
-
-        offset.ry() += r.height();
-        dy += r.height();
-
-        // If this is the last text block visible within the viewport...
-        if (offset.y() > viewportRect.height()) {
-            if (inBlockArea) {
-                blockAreaRect.setHeight(dy);
-                drawBlock = true;
-            }
+    if (!d->blockAreaPaths.isEmpty()) {
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QBrush(d->blockColor));
 
-            // Finished drawing.
-            done = true;
+        for (const QPainterPath &path : d->blockAreaPaths) {
+            painter.drawPath(path);
         }
+    }
 
-        if (drawBlock) {
-            painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-            painter.setPen(Qt::NoPen);
-            painter.setBrush(QBrush(d->blockColor));
+    painter.end();
 
-            // If the first visible block is "clipped" such that the previous block
-            // is part of the text block area, then only draw a rectangle with the
-            // bottom corners rounded, and with the top corners square to reflect
-            // that the first visible block is part of a larger block of text.
-            //
-            if (clipTop) {
-                QPainterPath path;
-                path.setFillRule(Qt::WindingFill);
-                path.addRoundedRect(blockAreaRect, cornerRadius, cornerRadius);
-                qreal adjustedHeight = blockAreaRect.height() / 2;
-                path.addRect(blockAreaRect.adjusted(0, 0, 0, -adjustedHeight));
-                painter.drawPath(path.simplified());
-                clipTop = false;
-            }
-            // Else draw the entire rectangle with all corners rounded.
-            else {
-                painter.drawRoundedRect(blockAreaRect, cornerRadius, cornerRadius);
-            }
+    // Draw the visible editor text.
+    QPlainTextEdit::paintEvent(event);
 
-            drawBlock = false;
-        }
+    if (d->owner()->foldsPresent) {
+        QPainter painter(viewport());
 
-        // This fixes the RTL bug of QPlainTextEdit
-        // https://bugreports.qt.io/browse/QTBUG-7516.
-        //
-        // Credit goes to Patrizio Bekerle (qmarkdowntextedit) for discovering
-        // this workaround.
-        //
-        if (block.text().isRightToLeft()) {
-            QTextLayout *layout = block.layout();
-            QTextOption opt = document()->defaultTextOption();
-            opt = QTextOption(Qt::AlignRight);
-            opt.setTextDirection(Qt::RightToLeft);
-            layout->setTextOption(opt);
+        if (d->gpuViewportEnabled) {
+            painter.setClipRect(event->rect());
         }
 
-        block = block.next();
-        firstVisible = false;
+        d->paintFoldMarkers(painter);
+        painter.end();
     }
 
-    painter.end();
-
-    // Draw the visible editor text.
-    QPlainTextEdit::paintEvent(event);
-
     // Draw the text cursor/caret.
     if (d->textCursorVisible && this->hasFocus()) {
-        // Get the cursor rect so that we have the ideal height for it,
-        // and then set it to be 2 pixels wide.  (The width will be zero,
-        // because we set it to be that in the constructor so that
-        // QPlainTextEdit will not draw another cursor underneath this one.)
-        //
-        QRect r = cursorRect();
-        r.setWidth(2);
+        QRect r = d->textCursorRect();
 
         QPainter painter(viewport());
         painter.fillRect(r, QBrush(d->cursorColor));
         painter.end();
+
+        d->paintedCursorRect = r;
     }
+
+    d->latencyMonitor->framePainted();
 }
 
 void MarkdownEditor::setDictionary(const QString &language)
@@ -485,6 +824,25 @@ void MarkdownEditor::setDictionary(const QString &language)
     
     d->dictionary = DictionaryManager::instance().requestDictionary(language);
     d->highlighter->setDictionary(d->dictionary);
+
+    for (MarkdownEditor *view : d->views) {
+        view->d_func()->dictionary = d->dictionary;
+    }
+}
+
+void MarkdownEditor::setAlternativeDictionaries(const QStringList &languages)
+{
+    Q_D(MarkdownEditor);
+
+    QList<DictionaryRef> dictionaries;
+
+    for (const QString &language : languages) {
+        if (!language.isEmpty()) {
+            dictionaries.append(DictionaryManager::instance().requestDictionary(language));
+        }
+    }
+
+    d->highlighter->setAlternativeDictionaries(dictionaries);
 }
 
 QLayout *MarkdownEditor::preferredLayout()
@@ -494,40 +852,83 @@ QLayout *MarkdownEditor::preferredLayout()
     return d->preferredLayout;
 }
 
-bool MarkdownEditor::hemingwayModeEnabled() const
+LatencyMonitor *MarkdownEditor::latencyMonitor() const
 {
     Q_D(const MarkdownEditor);
-    
-    return d->hemingwayModeEnabled;
-}
 
-/**
- * Sets whether Hemingway mode is enabled.
- */
-void MarkdownEditor::setHemingWayModeEnabled(bool enabled)
-{
-    Q_D(MarkdownEditor);
-    
-    d->hemingwayModeEnabled = enabled;
+    return d->latencyMonitor;
 }
 
-FocusMode MarkdownEditor::focusMode() const
+bool MarkdownEditor::isPasting() const
 {
     Q_D(const MarkdownEditor);
-    
-    return d->focusMode;
+
+    return d->pasteInProgress;
 }
 
-void MarkdownEditor::setFocusMode(FocusMode mode)
+void MarkdownEditor::setPowerSavingEnabled(bool enabled)
 {
     Q_D(MarkdownEditor);
-    
-    d->focusMode = mode;
 
-    if (FocusModeDisabled != mode) {
-        connect(this, SIGNAL(cursorPositionChanged()), this, SLOT(focusText()));
-        connect(this, SIGNAL(selectionChanged()), this, SLOT(focusText()));
-        connect(this, SIGNAL(textChanged()), this, SLOT(focusText()));
+    if (enabled == d->powerSaving) {
+        return;
+    }
+
+    d->powerSaving = enabled;
+    d->textCursorVisible = true;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setPowerSavingEnabled(enabled);
+    }
+
+    if (enabled) {
+        // The cursor is not painted while the editor lacks focus, as it
+        // does while the window is inactive, so it need not blink.  The
+        // typing activity's timer is idle anyway once typing has paused.
+        d->cursorBlinkTimer->stop();
+    } else {
+        d->cursorBlinkTimer->start();
+    }
+}
+
+bool MarkdownEditor::hemingwayModeEnabled() const
+{
+    Q_D(const MarkdownEditor);
+    
+    return d->hemingwayModeEnabled;
+}
+
+/**
+ * Sets whether Hemingway mode is enabled.
+ */
+void MarkdownEditor::setHemingWayModeEnabled(bool enabled)
+{
+    Q_D(MarkdownEditor);
+    
+    d->hemingwayModeEnabled = enabled;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setHemingWayModeEnabled(enabled);
+    }
+}
+
+FocusMode MarkdownEditor::focusMode() const
+{
+    Q_D(const MarkdownEditor);
+    
+    return d->focusMode;
+}
+
+void MarkdownEditor::setFocusMode(FocusMode mode)
+{
+    Q_D(MarkdownEditor);
+    
+    d->focusMode = mode;
+
+    if (FocusModeDisabled != mode) {
+        connect(this, SIGNAL(cursorPositionChanged()), this, SLOT(focusText()));
+        connect(this, SIGNAL(selectionChanged()), this, SLOT(focusText()));
+        connect(this, SIGNAL(textChanged()), this, SLOT(focusText()));
         this->focusText();
     } else {
         disconnect(this, SIGNAL(cursorPositionChanged()), this, SLOT(focusText()));
@@ -535,6 +936,10 @@ void MarkdownEditor::setFocusMode(FocusMode mode)
         disconnect(this, SIGNAL(textChanged()), this, SLOT(focusText()));
         this->setExtraSelections(QList<QTextEdit::ExtraSelection>());
     }
+
+    for (MarkdownEditor *view : d->views) {
+        view->setFocusMode(mode);
+    }
 }
 
 void MarkdownEditor::setColorScheme
@@ -544,16 +949,33 @@ void MarkdownEditor::setColorScheme
 {
     Q_D(MarkdownEditor);
     
-    d->highlighter->setColorScheme(colors);
-    d->cursorColor = colors.cursor;
-    d->blockColor = colors.foreground;
-    d->blockColor.setAlpha(10);
+    if (nullptr == d->primary) {
+        d->highlighter->setColorScheme(colors);
+    }
 
-    QColor fadedForegroundColor = colors.foreground;
-    fadedForegroundColor.setAlpha(100);
+    d->applyColors(colors);
+
+    for (MarkdownEditor *view : d->views) {
+        view->setColorScheme(colors);
+    }
+}
+
+void MarkdownEditor::previewColorScheme
+(
+    const ColorScheme &colors
+)
+{
+    Q_D(MarkdownEditor);
+
+    if (nullptr == d->primary) {
+        d->highlighter->previewColorScheme(colors);
+    }
 
-    d->fadeColor = QBrush(fadedForegroundColor);
-    this->focusText();
+    d->applyColors(colors);
+
+    for (MarkdownEditor *view : d->views) {
+        view->previewColorScheme(colors);
+    }
 }
 
 void MarkdownEditor::setFont(const QString &family, double pointSize)
@@ -562,8 +984,16 @@ void MarkdownEditor::setFont(const QString &family, double pointSize)
     
     QFont font(family, pointSize);
     QPlainTextEdit::setFont(font);
-    d->highlighter->setFont(family, pointSize);
+
+    if (nullptr == d->primary) {
+        d->highlighter->setFont(family, pointSize);
+    }
+
     setTabulationWidth(d->tabWidth);
+
+    for (MarkdownEditor *view : d->views) {
+        view->setFont(family, pointSize);
+    }
 }
 
 void MarkdownEditor::setShowTabsAndSpacesEnabled(bool enabled)
@@ -584,6 +1014,10 @@ void MarkdownEditor::setShowTabsAndSpacesEnabled(bool enabled)
 void MarkdownEditor::setupPaperMargins()
 {
     Q_D(MarkdownEditor);
+
+    for (MarkdownEditor *view : d->views) {
+        view->setupPaperMargins();
+    }
     
     if (EditorWidthFull == d->editorWidth) {
         d->preferredLayout->setContentsMargins(0, 0, 0, 0);
@@ -617,6 +1051,13 @@ void MarkdownEditor::setupPaperMargins()
     this->setViewportMargins(margin, 20, margin, 0);
 }
 
+bool MarkdownEditor::isResizing() const
+{
+    Q_D(const MarkdownEditor);
+
+    return d->resizeSettleTimer->isActive();
+}
+
 void MarkdownEditor::dragEnterEvent(QDragEnterEvent *e)
 {
     if (e->mimeData()->hasUrls()) {
@@ -647,29 +1088,33 @@ void MarkdownEditor::dropEvent(QDropEvent *e)
         QString path = url.toLocalFile();
         bool isRelativePath = false;
 
-        QFileInfo fileInfo(path);
-        QString fileExtension = fileInfo.suffix().toLower();
-
         QTextCursor dropCursor = cursorForPosition(e->pos());
 
         // If the file extension indicates an image type, then insert an
         // image link into the text.
-        if
-        (
-            (fileExtension == "jpg") ||
-            (fileExtension == "jpeg") ||
-            (fileExtension == "gif") ||
-            (fileExtension == "bmp") ||
-            (fileExtension == "png") ||
-            (fileExtension == "tif") ||
-            (fileExtension == "tiff") ||
-            (fileExtension == "svg")
-        ) {
+        if (ImageStore::isImageFile(path)) {
+            bool imported = false;
+
             if (!d->textDocument->isNew()) {
                 QFileInfo docInfo(d->textDocument->filePath());
 
                 if (docInfo.exists()) {
-                    path = docInfo.dir().relativeFilePath(path);
+                    QString relativePath = docInfo.dir().relativeFilePath(path);
+
+                    // Images from outside of the document's folder are
+                    // imported into its assets folder, if so enabled.
+                    if
+                    (
+                        d->imageImportEnabled
+                        && url.isLocalFile()
+                        && (relativePath.startsWith("..")
+                            || QDir::isAbsolutePath(relativePath))
+                    ) {
+                        d->importImage(dropCursor, path);
+                        imported = true;
+                    }
+
+                    path = relativePath;
                     isRelativePath = true;
                 }
             }
@@ -678,7 +1123,9 @@ void MarkdownEditor::dropEvent(QDropEvent *e)
                 path = url.toString();
             }
 
-            dropCursor.insertText(QString("![](%1)").arg(path));
+            if (!imported) {
+                dropCursor.insertText(QString("![](%1)").arg(path));
+            }
 
             // We have to call the super class so that clean up occurs,
             // otherwise the editor's cursor will freeze.  We also have to use
@@ -719,7 +1166,35 @@ void MarkdownEditor::keyPressEvent(QKeyEvent *e)
     
     int key = e->key();
 
+    // Modifier keys alone change nothing on screen.
+    switch (key) {
+    case Qt::Key_Shift:
+    case Qt::Key_Control:
+    case Qt::Key_Alt:
+    case Qt::Key_Meta:
+        break;
+    default:
+        d->latencyMonitor->inputReceived();
+        break;
+    }
+
+    // Keys choosing or dismissing a completion are left to its popup.
+    if (d->completer->popup()->isVisible()) {
+        switch (key) {
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+        case Qt::Key_Escape:
+            e->ignore();
+            return;
+        default:
+            break;
+        }
+    }
+
     QTextCursor cursor(this->textCursor());
+    int revision = this->document()->revision();
 
     switch (key) {
     case Qt::Key_Return:
@@ -776,6 +1251,26 @@ void MarkdownEditor::keyPressEvent(QKeyEvent *e)
         }
         break;
     }
+
+    // Keep the columns of a table lined up as its cells are typed in.
+    // New lines and indentation change the table's rows rather than a cell.
+    if
+    (
+        d->tableFormattingEnabled
+        && (revision != this->document()->revision())
+        && (Qt::Key_Return != key)
+        && (Qt::Key_Enter != key)
+        && (Qt::Key_Tab != key)
+        && (Qt::Key_Backtab != key)
+    ) {
+        QTextCursor tableCursor = this->textCursor();
+
+        if (d->textDocument->tableFormatter()->alignCell(tableCursor)) {
+            this->setTextCursor(tableCursor);
+        }
+    }
+
+    d->updateCompletions(e);
 }
 
 bool MarkdownEditor::eventFilter(QObject *watched, QEvent *event)
@@ -865,31 +1360,56 @@ bool MarkdownEditor::eventFilter(QObject *watched, QEvent *event)
         );
 
         d->wordUnderMouse = d->cursorForWord.selectedText();
-        QStringList suggestions = d->dictionary.suggestions(d->wordUnderMouse);
         QMenu *popupMenu = createStandardContextMenu();
         QAction *firstAction = popupMenu->actions().first();
 
         d->spellingActions.clear();
 
-        if (!suggestions.empty()) {
-            for (int i = 0; i < suggestions.size(); i++) {
-                QAction *suggestionAction = new QAction(suggestions[i], this);
+        // Searching for suggestions can take a long time for long words or
+        // for languages with many compounds, so unless they were already
+        // searched for when typing paused, open the menu right away with a
+        // placeholder and fill in the suggestions when they arrive.
+        //
+        QAction *searchingAction = new QAction(tr("Searching for suggestions..."), this);
+        searchingAction->setEnabled(false);
+        d->spellingActions.append(searchingAction);
+        popupMenu->insertAction(firstAction, searchingAction);
+
+        // Set when the menu closes, so that a search that has not yet
+        // started is skipped.
+        QSharedPointer<QAtomicInt> cancelled(new QAtomicInt(0));
+        DictionaryRef dictionary = d->highlighter->dictionary(d->cursorForWord.block());
+        QString word = d->wordUnderMouse;
+        QStringList cachedSuggestions;
 
-                // Need the following line because KDE Plasma 5 will insert a hidden ampersand
-                // into the menu text as a keyboard accelerator.  Go off of the data in the
-                // QAction rather than the text to avoid this.
-                //
-                suggestionAction->setData(suggestions[i]);
+        QFutureWatcher<QStringList> suggestionsWatcher;
 
-                d->spellingActions.append(suggestionAction);
-                popupMenu->insertAction(firstAction, suggestionAction);
+        this->connect
+        (
+            &suggestionsWatcher,
+            &QFutureWatcher<QStringList>::finished,
+            [d, popupMenu, searchingAction, &suggestionsWatcher]() {
+                d->addSuggestionActions(popupMenu, searchingAction, suggestionsWatcher.result());
             }
+        );
+
+        if (dictionary.cachedSuggestions(word, cachedSuggestions)) {
+            d->addSuggestionActions(popupMenu, searchingAction, cachedSuggestions);
         } else {
-            QAction *noSuggestionsAction =
-                new QAction(tr("No spelling suggestions found"), this);
-            noSuggestionsAction->setEnabled(false);
-            d->spellingActions.append(noSuggestionsAction);
-            popupMenu->insertAction(firstAction, noSuggestionsAction);
+            suggestionsWatcher.setFuture
+            (
+                TaskScheduler::instance()->run
+                (
+                    TaskScheduler::Interactive,
+                    [dictionary, word, cancelled]() -> QStringList {
+                        if (cancelled->load()) {
+                            return QStringList();
+                        }
+
+                        return dictionary.suggestions(word);
+                    }
+                )
+            );
         }
 
         popupMenu->insertSeparator(firstAction);
@@ -920,6 +1440,12 @@ bool MarkdownEditor::eventFilter(QObject *watched, QEvent *event)
 
         popupMenu->exec(menuPos);
 
+        // Cancel the search if it is still pending.  A search that is
+        // already running cannot be interrupted, but its result is discarded.
+        //
+        cancelled->store(1);
+        suggestionsWatcher.disconnect();
+
         delete popupMenu;
 
         for (int i = 0; i < d->spellingActions.size(); i++) {
@@ -932,6 +1458,69 @@ bool MarkdownEditor::eventFilter(QObject *watched, QEvent *event)
     }
 }
 
+void MarkdownEditor::insertFromMimeData(const QMimeData *source)
+{
+    Q_D(MarkdownEditor);
+
+    if (d->pasteInProgress) {
+        return;
+    }
+
+    QString text = source->hasText() ? source->text() : QString();
+
+    if (text.length() <= MarkdownEditorPrivate::LargePasteSize) {
+        QPlainTextEdit::insertFromMimeData(source);
+        return;
+    }
+
+    d->pasteInProgress = true;
+    d->pasteText = text;
+    d->pastePosition = 0;
+    d->pasteCursor = this->textCursor();
+
+    int length = d->pasteChunkLength(0, MarkdownEditorPrivate::PasteChunkSize);
+
+    // The text cursor follows the chunks as they are inserted at its
+    // position, and so ends up after the pasted text, as usual.
+    d->pasteCursor.beginEditBlock();
+    d->pasteCursor.removeSelectedText();
+    d->pasteCursor.insertText(text.left(length));
+    d->pasteCursor.endEditBlock();
+
+    d->pastePosition = length;
+    d->pasteRevision = document()->revision();
+
+    this->setReadOnly(true);
+    d->pasteTimer->start();
+
+    emit operationStarted
+    (
+        tr("pasting (%1%)").arg((int) ((100.0 * length) / text.length()))
+    );
+}
+
+bool MarkdownEditor::event(QEvent *e)
+{
+    Q_D(MarkdownEditor);
+
+    if ((QEvent::Resize == e->type()) && this->isVisible()) {
+        QResizeEvent *resize = static_cast<QResizeEvent *>(e);
+
+        if (resize->size().width() != resize->oldSize().width()) {
+            // Set the margins before the viewport is laid out for the new
+            // size, so that it keeps its width.
+            if (!d->resizeSettleTimer->isActive()) {
+                d->liveResizeTextWidth = viewport()->width();
+            }
+
+            d->keepTextWidth(resize->size().width());
+            d->resizeSettleTimer->start();
+        }
+    }
+
+    return QPlainTextEdit::event(e);
+}
+
 void MarkdownEditor::wheelEvent(QWheelEvent *e)
 {    
     Qt::KeyboardModifiers modifier = e->modifiers();
@@ -945,22 +1534,16 @@ void MarkdownEditor::wheelEvent(QWheelEvent *e)
     }
 
     if ((Qt::ControlModifier == modifier) && (0 != numDegrees)) {
-        int fontSize = this->font().pointSize();
-
         if (numDegrees > 0) {
-            fontSize += 1;
+            increaseFontSize();
         } else {
-            fontSize -= 1;
+            decreaseFontSize();
         }
-
-        // check for negative value
-        if (fontSize <= 0) {
-            fontSize = 1;
-        }
-
-        setFont(this->font().family(), fontSize);
-        emit fontSizeChanged(fontSize);
     } else {
+        Q_D(MarkdownEditor);
+
+        // Let the writer scroll away from the text cursor.
+        d->scrollFrameTimer->stop();
         QPlainTextEdit::wheelEvent(e);
     }
 }
@@ -1053,6 +1636,17 @@ void MarkdownEditor::createTaskList()
     d->insertPrefixForBlocks("- [ ] ");
 }
 
+void MarkdownEditor::formatTable()
+{
+    Q_D(MarkdownEditor);
+
+    QTextCursor cursor = this->textCursor();
+
+    if (d->textDocument->tableFormatter()->formatTable(cursor)) {
+        this->setTextCursor(cursor);
+    }
+}
+
 void MarkdownEditor::createBlockquote()
 {
     Q_D(MarkdownEditor);
@@ -1063,38 +1657,29 @@ void MarkdownEditor::createBlockquote()
 // Algorithm lifted from ReText.
 void MarkdownEditor::removeBlockquote()
 {
-    QTextCursor cursor = this->textCursor();
-    QTextBlock block;
-    QTextBlock end;
-
-    if (cursor.hasSelection()) {
-        block = this->document()->findBlock(cursor.selectionStart());
-        end = this->document()->findBlock(cursor.selectionEnd()).next();
-    } else {
-        block = cursor.block();
-        end = block.next();
-    }
+    Q_D(MarkdownEditor);
 
-    cursor.beginEditBlock();
+    d->transformBlocks
+    (
+        [](const QTextBlock &block, int index) {
+            Q_UNUSED(index)
 
-    while (block != end) {
-        cursor.setPosition(block.position());
+            QString text = block.text();
 
-        if (this->document()->characterAt(cursor.position()) == '>') {
-            cursor.deleteChar();
+            if (text.startsWith('>')) {
+                text.remove(0, 1);
 
-            // Delete first space that follow the '>' character, to clean up the
-            // paragraph.
-            //
-            if (this->document()->characterAt(cursor.position()).isSpace()) {
-                cursor.deleteChar();
+                // Delete first space that follow the '>' character, to clean
+                // up the paragraph.
+                //
+                if (!text.isEmpty() && text.at(0).isSpace()) {
+                    text.remove(0, 1);
+                }
             }
-        }
-
-        block = block.next();
-    }
 
-    cursor.endEditBlock();
+            return text;
+        }
+    );
 }
 
 // Algorithm lifted from ReText.
@@ -1105,30 +1690,19 @@ void MarkdownEditor::indentText()
     QTextCursor cursor = this->textCursor();
 
     if (cursor.hasSelection()) {
-        QTextBlock block = this->document()->findBlock(cursor.selectionStart());
-        QTextBlock end = this->document()->findBlock(cursor.selectionEnd()).next();
-
-        cursor.beginEditBlock();
-
-        while (block != end) {
-            cursor.setPosition(block.position());
-
-            if (d->insertSpacesForTabs) {
-                QString indentText = "";
-
-                for (int i = 0; i < d->tabWidth; i++) {
-                    indentText += QString(" ");
-                }
-
-                cursor.insertText(indentText);
-            } else {
-                cursor.insertText("\t");
-            }
+        QString indentText = "\t";
 
-            block = block.next();
+        if (d->insertSpacesForTabs) {
+            indentText = QString(d->tabWidth, ' ');
         }
 
-        cursor.endEditBlock();
+        d->transformBlocks
+        (
+            [indentText](const QTextBlock &block, int index) -> QString {
+                Q_UNUSED(index)
+                return indentText + block.text();
+            }
+        );
     } else {
         int indent = d->tabWidth;
         QString indentText = "";
@@ -1232,39 +1806,40 @@ void MarkdownEditor::unindentText()
 {
     Q_D(MarkdownEditor);
     
-    QTextCursor cursor = this->textCursor();
-    QTextBlock block;
-    QTextBlock end;
+    int tabWidth = d->tabWidth;
 
-    if (cursor.hasSelection()) {
-        block = this->document()->findBlock(cursor.selectionStart());
-        end = this->document()->findBlock(cursor.selectionEnd()).next();
-    } else {
-        block = cursor.block();
-        end = block.next();
-    }
+    // Unindent the blocks and cycle the bullet point as one change.
+    d->textDocument->beginTransaction();
 
-    cursor.beginEditBlock();
+    bool changed = d->transformBlocks
+    (
+        [tabWidth](const QTextBlock &block, int index) -> QString {
+            Q_UNUSED(index)
 
-    while (block != end) {
-        cursor.setPosition(block.position());
+            QString text = block.text();
+
+            if (text.startsWith('\t')) {
+                return text.mid(1);
+            }
 
-        if (this->document()->characterAt(cursor.position()) == '\t') {
-            cursor.deleteChar();
-        } else {
             int pos = 0;
 
-            while
-            (
-                (this->document()->characterAt(cursor.position()) == ' ')
-                && (pos < d->tabWidth)
-            ) {
-                pos += 1;
-                cursor.deleteChar();
+            while ((pos < text.length()) && (text.at(pos) == ' ') && (pos < tabWidth)) {
+                pos++;
             }
+
+            return text.mid(pos);
         }
+    );
 
-        block = block.next();
+    // Cycle the bullet point of the last block, which is the current block
+    // when nothing is selected, as part of the same undo step.
+    QTextCursor cursor(this->document()->findBlock(this->textCursor().selectionEnd()));
+
+    if (changed) {
+        cursor.joinPreviousEditBlock();
+    } else {
+        cursor.beginEditBlock();
     }
 
     if
@@ -1303,91 +1878,130 @@ void MarkdownEditor::unindentText()
 
 
     cursor.endEditBlock();
+    d->textDocument->commit();
 }
 
 bool MarkdownEditor::toggleTaskComplete()
 {
     Q_D(MarkdownEditor);
-    
-    QTextCursor cursor = textCursor();
-    QTextBlock block;
-    QTextBlock end;
 
-    if (cursor.hasSelection()) {
-        block = this->document()->findBlock(cursor.selectionStart());
-        end = this->document()->findBlock(cursor.selectionEnd()).next();
-    } else {
-        block = cursor.block();
-        end = block.next();
-    }
+    QRegularExpression taskListRegex = d->taskListRegex;
 
-    cursor.beginEditBlock();
+    d->transformBlocks
+    (
+        [taskListRegex](const QTextBlock &block, int index) {
+            Q_UNUSED(index)
 
-    while (block != end) {
-        QRegularExpressionMatch match;
+            QString text = block.text();
+            QRegularExpressionMatch match;
 
-        if
-        (
-            (MarkdownStateTaskList == (block.userState() & MarkdownStateMask))
-            && (block.text().indexOf(d->taskListRegex, 0, &match) == 0)
-        ) {
-            QStringList capture = match.capturedTexts();
+            if
+            (
+                (MarkdownStateTaskList == (block.userState() & MarkdownStateMask))
+                && (text.indexOf(taskListRegex, 0, &match) == 0)
+            ) {
+                QStringList capture = match.capturedTexts();
 
-            if (capture.size() == 2) {
-                QChar value = capture.at(1)[0];
-                QChar replacement;
-                int index = block.text().indexOf(" [");
+                if (capture.size() == 2) {
+                    QChar value = capture.at(1)[0];
+                    int column = text.indexOf(" [");
 
-                if (index >= 0) {
-                    index += 2;
-                }
+                    if (column >= 0) {
+                        column += 2;
+                    }
 
-                if (value == 'x') {
-                    replacement = ' ';
-                } else {
-                    replacement = 'x';
+                    if ((column >= 0) && (column < text.length())) {
+                        text[column] = (value == 'x') ? QChar(' ') : QChar('x');
+                    }
                 }
-
-                cursor.setPosition(block.position());
-                cursor.movePosition(QTextCursor::StartOfBlock);
-                cursor.movePosition
-                (
-                    QTextCursor::Right,
-                    QTextCursor::MoveAnchor,
-                    index
-                );
-
-                cursor.deleteChar();
-                cursor.insertText(replacement);
             }
-        }
 
-        block = block.next();
-    }
+            return text;
+        }
+    );
 
-    cursor.endEditBlock();
     return true;
 }
 
-void MarkdownEditor::setEnableLargeHeadingSizes(bool enable)
+void MarkdownEditor::toggleFold()
 {
     Q_D(MarkdownEditor);
-    
-    d->highlighter->setEnableLargeHeadingSizes(enable);
-}
 
-void MarkdownEditor::setAutoMatchEnabled(bool enable)
-{
-    Q_D(MarkdownEditor);
-    
-    d->autoMatchEnabled = enable;
-}
+    QTextCursor cursor = this->textCursor();
+    int firstBlock;
+    int lastBlock;
+
+    if (!d->findSection(cursor.blockNumber(), firstBlock, lastBlock)) {
+        return;
+    }
+
+    QTextBlock heading = d->textDocument->findBlockByNumber(firstBlock);
+    TextBlockData *data = (TextBlockData *) heading.userData();
+
+    if ((nullptr != data) && data->folded) {
+        d->setSectionFolded(firstBlock, lastBlock, false);
+    } else if (lastBlock > firstBlock) {
+        // Move the cursor out of the section before hiding it, to the end
+        // of the heading.
+        if (cursor.blockNumber() != firstBlock) {
+            cursor.setPosition(heading.position() + heading.length() - 1);
+            setTextCursor(cursor);
+        }
+
+        d->setSectionFolded(firstBlock, lastBlock, true);
+    }
+}
+
+void MarkdownEditor::unfoldAll()
+{
+    Q_D(MarkdownEditor);
+
+    if (!d->owner()->foldsPresent) {
+        return;
+    }
+
+    QTextBlock block = d->textDocument->firstBlock();
+
+    while (block.isValid()) {
+        TextBlockData *data = (TextBlockData *) block.userData();
+
+        if ((nullptr != data) && data->folded) {
+            d->unfoldSection(block);
+        }
+
+        block = block.next();
+    }
+
+    d->owner()->foldsPresent = false;
+}
+
+void MarkdownEditor::setEnableLargeHeadingSizes(bool enable)
+{
+    Q_D(MarkdownEditor);
+    
+    d->highlighter->setEnableLargeHeadingSizes(enable);
+}
+
+void MarkdownEditor::setAutoMatchEnabled(bool enable)
+{
+    Q_D(MarkdownEditor);
+    
+    d->autoMatchEnabled = enable;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setAutoMatchEnabled(enable);
+    }
+}
 
 void MarkdownEditor::setAutoMatchEnabled(const QChar openingCharacter, bool enabled)
 {
     Q_D(MarkdownEditor);
     
     d->autoMatchFilter.insert(openingCharacter, enabled);
+
+    for (MarkdownEditor *view : d->views) {
+        view->setAutoMatchEnabled(openingCharacter, enabled);
+    }
 }
 
 void MarkdownEditor::setBulletPointCyclingEnabled(bool enable)
@@ -1395,6 +2009,58 @@ void MarkdownEditor::setBulletPointCyclingEnabled(bool enable)
     Q_D(MarkdownEditor);
     
     d->bulletPointCyclingEnabled = enable;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setBulletPointCyclingEnabled(enable);
+    }
+}
+
+void MarkdownEditor::setWordCompletionEnabled(bool enable)
+{
+    Q_D(MarkdownEditor);
+
+    d->wordCompletionEnabled = enable;
+
+    if (!enable) {
+        d->completer->popup()->hide();
+    }
+
+    for (MarkdownEditor *view : d->views) {
+        view->setWordCompletionEnabled(enable);
+    }
+}
+
+void MarkdownEditor::setTableFormattingEnabled(bool enable)
+{
+    Q_D(MarkdownEditor);
+
+    d->tableFormattingEnabled = enable;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setTableFormattingEnabled(enable);
+    }
+}
+
+void MarkdownEditor::setImageImportEnabled(bool enable)
+{
+    Q_D(MarkdownEditor);
+    
+    d->imageImportEnabled = enable;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setImageImportEnabled(enable);
+    }
+}
+
+void MarkdownEditor::setImageImportMaxWidth(int width)
+{
+    Q_D(MarkdownEditor);
+    
+    d->imageImportMaxWidth = width;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setImageImportMaxWidth(width);
+    }
 }
 
 void MarkdownEditor::setUseUnderlineForEmphasis(bool enable)
@@ -1411,11 +2077,36 @@ void MarkdownEditor::setItalicizeBlockquotes(bool enable)
     d->highlighter->setItalicizeBlockquotes(enable);
 }
 
+void MarkdownEditor::setLongLineThreshold(int characters)
+{
+    Q_D(MarkdownEditor);
+
+    d->highlighter->setLongLineThreshold(characters);
+}
+
+void MarkdownEditor::setGpuViewportEnabled(bool enable)
+{
+    Q_D(MarkdownEditor);
+
+    if (enable != d->gpuViewportEnabled) {
+        d->gpuViewportEnabled = enable;
+        d->replaceViewport();
+    }
+
+    for (MarkdownEditor *view : d->views) {
+        view->setGpuViewportEnabled(enable);
+    }
+}
+
 void MarkdownEditor::setInsertSpacesForTabs(bool enable)
 {
     Q_D(MarkdownEditor);
     
     d->insertSpacesForTabs = enable;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setInsertSpacesForTabs(enable);
+    }
 }
 
 void MarkdownEditor::setTabulationWidth(int width)
@@ -1430,6 +2121,10 @@ void MarkdownEditor::setTabulationWidth(int width)
 #else
     this->setTabStopDistance(fontMetrics.horizontalAdvance(' ') * d->tabWidth);
 #endif
+
+    for (MarkdownEditor *view : d->views) {
+        view->setTabulationWidth(width);
+    }
 }
 
 void MarkdownEditor::setEditorWidth(EditorWidth width)
@@ -1437,6 +2132,10 @@ void MarkdownEditor::setEditorWidth(EditorWidth width)
     Q_D(MarkdownEditor);
     
     d->editorWidth = width;
+
+    for (MarkdownEditor *view : d->views) {
+        view->setEditorWidth(width);
+    }
 }
 
 void MarkdownEditor::setEditorCorners(InterfaceStyle corners)
@@ -1444,6 +2143,11 @@ void MarkdownEditor::setEditorCorners(InterfaceStyle corners)
     Q_D(MarkdownEditor);
     
     d->editorCorners = corners;
+    d->invalidateBlockAreas();
+
+    for (MarkdownEditor *view : d->views) {
+        view->setEditorCorners(corners);
+    }
 }
 
 void MarkdownEditor::runSpellChecker()
@@ -1463,28 +2167,176 @@ void MarkdownEditor::setSpellCheckEnabled(const bool enabled)
     
     d->spellCheckEnabled = enabled;
     d->highlighter->setSpellCheckEnabled(enabled);
+
+    // Views share the highlighter, so they only need to know whether to
+    // offer spelling suggestions.
+    for (MarkdownEditor *view : d->views) {
+        view->d_func()->spellCheckEnabled = enabled;
+    }
+}
+
+void MarkdownEditor::setSpellCheckVisibleOnly(const bool visibleOnly)
+{
+    Q_D(MarkdownEditor);
+
+    d->highlighter->setSpellCheckVisibleOnly(visibleOnly);
+}
+
+void MarkdownEditor::rehighlightLines(int firstLine, int lastLine)
+{
+    Q_D(MarkdownEditor);
+
+    d->highlighter->rehighlightLines(firstLine, lastLine);
+}
+
+void MarkdownEditor::setBackgroundSweepPaused(const bool paused)
+{
+    Q_D(MarkdownEditor);
+
+    d->highlighter->setBackgroundSweepPaused(paused);
+}
+
+void MarkdownEditor::releaseCaches()
+{
+    Q_D(MarkdownEditor);
+
+    d->highlighter->releaseCaches();
+    ((MarkdownDocument *) document())->releaseCaches();
+}
+
+void MarkdownEditor::setBackgroundParseDeferred(const bool deferred)
+{
+    Q_D(MarkdownEditor);
+
+    d->backgroundParseDeferred = deferred;
+
+    if (!deferred && d->parseDeferred && !d->parseInProgress) {
+        d->startBackgroundParse();
+    }
+}
+
+void MarkdownEditor::setHtmlRenderingEnabled(const bool enabled)
+{
+    Q_D(MarkdownEditor);
+
+    if (enabled == d->htmlRenderingEnabled) {
+        return;
+    }
+
+    d->htmlRenderingEnabled = enabled;
+
+    // Smart typography is toggled along with HTML rendering, so the AST
+    // must be parsed again to match.
+    if (d->parseInProgress) {
+        d->parseAgain = true;
+    } else {
+        d->parseDocumentInBackground();
+    }
+}
+
+void MarkdownEditor::suspendParsing()
+{
+    Q_D(MarkdownEditor);
+
+    d->parsingSuspended = true;
+    d->parseDeferred = false;
+    d->parseAgain = false;
+    d->parseDiscarded = d->parseInProgress;
+    d->dirtyStartLine = -1;
+    d->dirtyEndLine = -1;
+    d->slowStartLine = -1;
+    d->slowEndLine = -1;
+
+    if (d->fallbackHighlighting) {
+        d->fallbackHighlighting = false;
+        d->highlighter->setFallbackLines(0, 0);
+    }
+
+    ((MarkdownDocument *) document())->setMarkdownAST(nullptr);
+}
+
+void MarkdownEditor::resumeParsing()
+{
+    Q_D(MarkdownEditor);
+
+    if (!d->parsingSuspended) {
+        return;
+    }
+
+    d->parsingSuspended = false;
+
+    MarkdownDocument *document = (MarkdownDocument *) this->document();
+    QSharedPointer<DocumentCache> cache = document->documentCache();
+    MarkdownAST *ast = nullptr;
+
+    // The cached AST is only good for the same text, parsed with the same
+    // smart typography setting.
+    if
+    (
+        !cache.isNull()
+        && (cache->smartTypography() == d->htmlRenderingEnabled)
+        && (cache->textLength() == (document->characterCount() - 1))
+    ) {
+        ast = cache->takeAST();
+    }
+
+    if (nullptr == ast) {
+        if (d->parseInProgress) {
+            d->parseAgain = true;
+        } else {
+            d->parseDocumentInBackground();
+        }
+
+        return;
+    }
+
+    QVector<MarkdownAST::LineRange> changes;
+    changes.append(MarkdownAST::LineRange(1, document->blockCount()));
+
+    document->setMarkdownAST(ast, changes);
+    d->lastBlockCount = document->blockCount();
+    d->rehighlightLines(changes);
+}
+
+void MarkdownEditor::saveDocumentCache(const QString &spellingKey)
+{
+    Q_D(MarkdownEditor);
+
+    if (d->parsingSuspended || d->parseInProgress || d->parseDeferred || (d->dirtyStartLine > 0)) {
+        return;
+    }
+
+    DocumentCache::save
+    (
+        (MarkdownDocument *) document(),
+        spellingKey,
+        d->htmlRenderingEnabled,
+        d->highlighter->spellingGeneration()
+    );
 }
 
 void MarkdownEditor::increaseFontSize()
 {
-    int fontSize = this->font().pointSize() + 1;
+    Q_D(MarkdownEditor);
 
-    setFont(this->font().family(), fontSize);
-    emit fontSizeChanged(fontSize);
+    if (nullptr != d->primary) {
+        d->primary->increaseFontSize();
+        return;
+    }
 
+    d->zoomTo(d->zoomedFontSize() + 1);
 }
 
 void MarkdownEditor::decreaseFontSize()
 {
-    int fontSize = this->font().pointSize() - 1;
+    Q_D(MarkdownEditor);
 
-    // check for negative value
-    if (fontSize <= 0) {
-        fontSize = 1;
+    if (nullptr != d->primary) {
+        d->primary->decreaseFontSize();
+        return;
     }
 
-    setFont(this->font().family(), fontSize);
-    emit fontSizeChanged(fontSize);
+    d->zoomTo(d->zoomedFontSize() - 1);
 }
 
 void MarkdownEditor::suggestSpelling(QAction *action)
@@ -1494,7 +2346,6 @@ void MarkdownEditor::suggestSpelling(QAction *action)
     if (action == d->addWordToDictionaryAction) {
         this->setTextCursor(d->cursorForWord);
         d->dictionary.addToPersonal(d->wordUnderMouse);
-        d->highlighter->rehighlight();
     } else if (action == d->checkSpellingAction) {
         this->setTextCursor(d->cursorForWord);
         SpellChecker::checkDocument(this, d->highlighter, d->dictionary);
@@ -1503,15 +2354,41 @@ void MarkdownEditor::suggestSpelling(QAction *action)
     }
 }
 
-void MarkdownEditor::onContentsChanged(int position, int charsAdded, int charsRemoved)
+void MarkdownEditor::onContentsChanged(int position, int charsRemoved, int charsAdded)
 {
     Q_D(MarkdownEditor);
+
+    // The editor parses the document and tracks typing for its views.
+    // Changes made during a transaction are handled at once when it is
+    // committed.
+    if ((nullptr != d->primary) || d->textDocument->isInTransaction()) {
+        return;
+    }
     
-    Q_UNUSED(position)
-    Q_UNUSED(charsAdded)
     Q_UNUSED(charsRemoved)
 
-    d->parseDocument();
+    d->parseDocument(position, charsAdded);
+
+    // Unfold the sections whose headings were edited, since they might no
+    // longer be headings, as well as any hidden lines that the edit
+    // reached, such as by replacing all matches of a search.
+    //
+    if (d->foldsPresent) {
+        QTextBlock block = d->textDocument->findBlock(position);
+        QTextBlock last = d->textDocument->findBlock(position + charsAdded);
+
+        while (block.isValid() && (block.blockNumber() <= last.blockNumber())) {
+            TextBlockData *data = (TextBlockData *) block.userData();
+
+            if (!block.isVisible()) {
+                d->revealBlock(block);
+            } else if ((nullptr != data) && data->folded) {
+                d->unfoldSection(block);
+            }
+
+            block = block.next();
+        }
+    }
 
     // Don't use the textChanged() or contentsChanged() (no parameters) signals
     // for checking if the typingResumed() signal needs to be emitted.  These
@@ -1520,20 +2397,7 @@ void MarkdownEditor::onContentsChanged(int position, int charsAdded, int charsRe
     // onContentsChanged(int, int, int) signal, which is only emitted when the
     // document text actually changes.
     //
-    if (d->typingHasPaused || d->scaledTypingHasPaused) {
-        d->typingHasPaused = false;
-        d->scaledTypingHasPaused = false;
-        d->typingPausedSignalSent = false;
-        d->typingPausedScaledSignalSent = false;
-        emit typingResumed();
-    }
-}
-
-void MarkdownEditor::onTextBlockRemoved(const QTextBlock &)
-{
-    Q_D(MarkdownEditor);
-    
-    d->parseDocument();
+    d->typingActivity->recordEdit();
 }
 
 void MarkdownEditor::onSelectionChanged()
@@ -1541,12 +2405,7 @@ void MarkdownEditor::onSelectionChanged()
     QTextCursor cursor = this->textCursor();
 
     if (cursor.hasSelection()) {
-        emit textSelected
-        (
-            cursor.selectedText(),
-            cursor.selectionStart(),
-            cursor.selectionEnd()
-        );
+        emit textSelected(cursor.selectionStart(), cursor.selectionEnd());
     } else {
         emit textDeselected();
     }
@@ -1610,15 +2469,17 @@ void MarkdownEditor::focusText()
             break;
 
         case FocusModeSentence: { // Current sentence
-            QTextBoundaryFinder boundaryFinder(QTextBoundaryFinder::Sentence, this->textCursor().block().text());
             int currentPos = this->textCursor().positionInBlock();
             int lastSentencePos = 0;
             int nextSentencePos = 0;
 
-            boundaryFinder.setPosition(currentPos);
-            lastSentencePos = boundaryFinder.toPreviousBoundary();
-            boundaryFinder.setPosition(currentPos);
-            nextSentencePos = boundaryFinder.toNextBoundary();
+            d->findSentence
+            (
+                this->textCursor().block(),
+                currentPos,
+                lastSentencePos,
+                nextSentencePos
+            );
 
             if (lastSentencePos < 0) {
                 beforeFadedSelection.cursor.movePosition(QTextCursor::StartOfBlock);
@@ -1645,47 +2506,27 @@ void MarkdownEditor::focusText()
             break;
         }
 
-        this->setExtraSelections(selections);
-    }
-}
-
-void MarkdownEditor::checkIfTypingPaused()
-{
-    Q_D(MarkdownEditor);
-    
-    if (d->typingHasPaused && !d->typingPausedSignalSent) {
-        d->typingPausedSignalSent = true;
-        emit typingPaused();
-    }
-
-    d->typingTimer->stop();
-    d->typingTimer->start(1000);
-
-    d->typingHasPaused = true;
-}
+        // Setting the extra selections fades the text anew even if the
+        // selections are the same, which is the case for most cursor moves
+        // and edits, as the selections' cursors follow the edits.
+        //
+        QList<QTextEdit::ExtraSelection> oldSelections = this->extraSelections();
+        bool changed = (oldSelections.size() != selections.size());
 
-void MarkdownEditor::checkIfTypingPausedScaled()
-{
-    Q_D(MarkdownEditor);
-    
-    if (d->scaledTypingHasPaused && !d->typingPausedScaledSignalSent) {
-        d->typingPausedScaledSignalSent = true;
-        emit typingPausedScaled();
-    }
+        for (int i = 0; !changed && (i < selections.size()); i++) {
+            const QTextCursor &oldCursor = oldSelections[i].cursor;
+            const QTextCursor &newCursor = selections[i].cursor;
 
-    // Scale timer interval based on document size.
-    int interval = (document()->characterCount() / 30000) * 20;
+            changed =
+                (oldCursor.selectionStart() != newCursor.selectionStart())
+                || (oldCursor.selectionEnd() != newCursor.selectionEnd())
+                || (oldSelections[i].format != selections[i].format);
+        }
 
-    if (interval > 1000) {
-        interval = 1000;
-    } else if (interval < 20) {
-        interval = 20;
+        if (changed) {
+            this->setExtraSelections(selections);
+        }
     }
-
-    d->scaledTypingTimer->stop();
-    d->scaledTypingTimer->start(interval);
-
-    d->scaledTypingHasPaused = true;
 }
 
 void MarkdownEditor::spellCheckFinished(int result)
@@ -1693,24 +2534,29 @@ void MarkdownEditor::spellCheckFinished(int result)
     Q_UNUSED(result)
     Q_D(MarkdownEditor);
     
-    d->highlighter->rehighlight();
+    d->highlighter->recheckSpelling();
 }
 
 void MarkdownEditor::onCursorPositionChanged()
 {
     Q_D(MarkdownEditor);
+
+    // Unfold the section that the cursor moved into, such as when
+    // navigating to a search match or to a line within a folded section.
+    if (!this->textCursor().block().isVisible()) {
+        d->revealBlock(this->textCursor().block());
+    }
     
     if (!d->mouseButtonDown) {
         QRect cursor = this->cursorRect();
         QRect viewport = this->viewport()->rect();
         int bottom = viewport.bottom() - this->fontMetrics().height();
 
-        if
-        (
-            (d->focusMode != FocusModeDisabled) ||
-            (cursor.bottom() >= bottom) ||
-            (cursor.top() <= viewport.top())
-        ) {
+        if (d->focusMode != FocusModeDisabled) {
+            if (!d->scrollFrameTimer->isActive()) {
+                d->scrollFrameTimer->start();
+            }
+        } else if ((cursor.bottom() >= bottom) || (cursor.top() <= viewport.top())) {
             centerCursor();
         }
     }
@@ -1720,49 +2566,834 @@ void MarkdownEditor::onCursorPositionChanged()
     //
     d->textCursorVisible = true;
     d->cursorBlinkTimer->stop();
-    d->cursorBlinkTimer->start();
 
-    // Update widget to ensure cursor is drawn.
-    update();
+    if (!d->powerSaving) {
+        d->cursorBlinkTimer->start();
+    }
+
+    // Repaint the cursor at its old and new positions.  Everything else
+    // that changes with the cursor position (the selection, focus mode's
+    // highlighted text, and scrolling) is repainted by QPlainTextEdit.
+    //
+    d->updateTextCursor();
 
     emit cursorPositionChanged(this->textCursor().position());
 }
 
+// Returns the private data of the editor that owns the highlighter and
+// parses the document, which is shared with its views.
+//
+MarkdownEditorPrivate *MarkdownEditorPrivate::owner()
+{
+    return (nullptr == primary) ? this : primary->d_func();
+}
+
 void MarkdownEditorPrivate::toggleCursorBlink()
 {
     Q_Q(MarkdownEditor);
     
     this->textCursorVisible = !this->textCursorVisible;
-    q->update();
+
+    if (q->hasFocus()) {
+        updateTextCursor();
+    } else if (!paintedCursorRect.isNull()) {
+        // Erase the cursor that was drawn before the editor lost focus.
+        q->viewport()->update(paintedCursorRect);
+        paintedCursorRect = QRect();
+    }
 }
 
-void MarkdownEditorPrivate::parseDocument()
+// Finds the boundaries of the sentence at the given position in the
+// given block, setting start to the boundary before the position and end
+// to the boundary after it, or either to -1 if there is none.  The
+// boundaries of the block are found once per revision of its text, rather
+// than on every cursor move.
+//
+void MarkdownEditorPrivate::applyColors(const ColorScheme &colors)
 {
     Q_Q(MarkdownEditor);
-    
-    MarkdownAST *ast =
-        CmarkGfmAPI::instance()->parse
-        (
-            q->document()->toPlainText(),
-            false
-        );
 
-    // Note:  MarkdownDocument is responsible for freeing memory
-    // allocated for the AST.
-    //
-    ((MarkdownDocument *) q->document())->setMarkdownAST(ast);
+    this->colors = colors;
+    cursorColor = colors.cursor;
+    blockColor = colors.foreground;
+    blockColor.setAlpha(10);
+
+    QColor fadedForegroundColor = colors.foreground;
+    fadedForegroundColor.setAlpha(100);
+
+    fadeColor = QBrush(fadedForegroundColor);
+    q->focusText();
 }
 
-void MarkdownEditorPrivate::handleCarriageReturn()
+void MarkdownEditorPrivate::findSentence
+(
+    const QTextBlock &block,
+    int position,
+    int &start,
+    int &end
+)
 {
-    Q_Q(MarkdownEditor);
-    
-    QString autoInsertText = "";
-    QTextCursor cursor = q->textCursor();
-    bool endList = false;
+    if ((block != sentenceBlock) || (block.revision() != sentenceBlockRevision)) {
+        QTextBoundaryFinder boundaryFinder(QTextBoundaryFinder::Sentence, block.text());
 
-    if (cursor.positionInBlock() < (cursor.block().length() - 1)) {
-        autoInsertText = priorIndentation();
+        sentenceBlock = block;
+        sentenceBlockRevision = block.revision();
+        sentenceBoundaries.clear();
+
+        if (boundaryFinder.isAtBoundary()) {
+            sentenceBoundaries.append(boundaryFinder.position());
+        }
+
+        for (int pos = boundaryFinder.toNextBoundary(); pos >= 0; pos = boundaryFinder.toNextBoundary()) {
+            sentenceBoundaries.append(pos);
+        }
+    }
+
+    QVector<int>::const_iterator next = std::upper_bound
+        (
+            sentenceBoundaries.constBegin(),
+            sentenceBoundaries.constEnd(),
+            position
+        );
+    QVector<int>::const_iterator previous = std::lower_bound
+        (
+            sentenceBoundaries.constBegin(),
+            sentenceBoundaries.constEnd(),
+            position
+        );
+
+    start = (previous != sentenceBoundaries.constBegin()) ? *(previous - 1) : -1;
+    end = (next != sentenceBoundaries.constEnd()) ? *next : -1;
+}
+
+// Returns the viewport area in which the text cursor is drawn.  The cursor
+// rect has the ideal height for the cursor, and is widened to be 2 pixels
+// wide.  (The width will be zero, because we set it to be that in the
+// constructor so that QPlainTextEdit will not draw another cursor
+// underneath this one.)
+//
+QRect MarkdownEditorPrivate::textCursorRect() const
+{
+    Q_Q(const MarkdownEditor);
+
+    QRect r = q->cursorRect();
+    r.setWidth(2);
+    return r;
+}
+
+// Schedules a repaint of only the parts of the viewport covered by the text
+// cursor, where it was last drawn and where it is now.
+//
+void MarkdownEditorPrivate::updateTextCursor()
+{
+    Q_Q(MarkdownEditor);
+
+    QRect r = textCursorRect();
+
+    if (!paintedCursorRect.isNull() && (paintedCursorRect != r)) {
+        q->viewport()->update(paintedCursorRect);
+    }
+
+    q->viewport()->update(r);
+    paintedCursorRect = r;
+}
+
+void MarkdownEditorPrivate::parseDocument()
+{
+    Q_Q(MarkdownEditor);
+    GW_TRACE_SCOPE("parseDocument");
+    
+    QTextDocument *document = q->document();
+    MarkdownAST *ast = new MarkdownAST();
+
+    CmarkGfmAPI::instance()->parse
+    (
+        document->firstBlock(),
+        document->lastBlock(),
+        htmlRenderingEnabled,
+        ast
+    );
+
+    // Note:  MarkdownDocument is responsible for freeing memory
+    // allocated for the AST.
+    //
+    ((MarkdownDocument *) q->document())->setMarkdownAST(ast);
+    lastBlockCount = q->document()->blockCount();
+}
+
+// Re-parses only the top-level blocks surrounding the edit described by
+// the parameters (as given by QTextDocument::contentsChange()), and then
+// splices the result into the existing AST.  Falls back to a full parse
+// whenever IncrementalParser cannot splice the edit, such as when it
+// might affect the structure of the document beyond the re-parsed region,
+// or when it involves link reference or footnote definitions.
+//
+void MarkdownEditorPrivate::parseDocument(int position, int charsAdded)
+{
+    Q_Q(MarkdownEditor);
+    GW_TRACE_SCOPE("parseDocument (incremental)");
+
+    QTextDocument *document = q->document();
+    MarkdownAST *ast = ((MarkdownDocument *) document)->markdownAST();
+    int blockCount = document->blockCount();
+    IncrementalParser::Region region;
+
+    // Let the parser see every edit, even while parsing is suspended, so
+    // that it keeps count of the references that edits remove.
+    incrementalParser->findEdit(position, charsAdded, lastBlockCount, region);
+
+    // Edits are left unparsed while parsing is suspended, until
+    // resumeParsing() takes care of the whole document at once.
+    if (parsingSuspended) {
+        return;
+    }
+
+    int editStartLine = region.editStartLine;
+    int editEndLine = region.editEndLine;
+    int lineDelta = region.lineDelta;
+
+    shiftSlowLines(editStartLine, region.oldEditEndLine, lineDelta);
+
+    if ((nullptr == ast) || (nullptr == ast->root()) || (nullptr == ast->root()->firstChild())) {
+        // The document was replaced or emptied, so the slow lines are gone.
+        slowStartLine = -1;
+        slowEndLine = -1;
+
+        if (parseInProgress) {
+            parseAgain = true;
+        } else if (document->characterCount() > SyncParseLimit) {
+            parseDocumentInBackground();
+        } else {
+            parseDocument();
+        }
+
+        return;
+    }
+
+    // If a full parse is already under way, the current AST is stale and
+    // can't be spliced into.  Let the parse finish, and start another
+    // one for the newest text.
+    if (parseInProgress) {
+        markLinesDirty(editStartLine, editEndLine, lineDelta);
+        parseAgain = true;
+        return;
+    }
+
+    // Likewise if a deferred full parse is waiting to be started.
+    if (parseDeferred) {
+        markLinesDirty(editStartLine, editEndLine, lineDelta);
+        return;
+    }
+
+    if (!incrementalParser->findRegion(region)) {
+        markLinesDirty(editStartLine, editEndLine, lineDelta);
+        parseDocumentInBackground();
+        return;
+    }
+
+    int firstLine = region.firstLine;
+    int lastLine = region.lastLine;
+
+    // Parse the region in the background if it was slow to parse before.
+    if ((slowStartLine > 0) && (firstLine <= slowEndLine) && (lastLine >= slowStartLine)) {
+        markLinesDirty(editStartLine, editEndLine, lineDelta);
+        fallbackHighlighting = true;
+        highlighter->setFallbackLines(slowStartLine, slowEndLine);
+        parseDocumentInBackground();
+        return;
+    }
+
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+
+    QVector<MarkdownAST::LineRange> changes;
+    bool spliced = incrementalParser->splice(region, htmlRenderingEnabled, changes);
+
+    qint64 parseTime = parseTimer.elapsed();
+    typingActivity->reportCost(parseTime);
+
+    if (parseTime > ParseBudget) {
+        logSlowParse(firstLine, lastLine, parseTime);
+
+        if (slowStartLine > 0) {
+            slowStartLine = qMin(slowStartLine, firstLine);
+            slowEndLine = qMax(slowEndLine, lastLine);
+        } else {
+            slowStartLine = firstLine;
+            slowEndLine = lastLine;
+        }
+    }
+
+    if (!spliced) {
+        markLinesDirty(editStartLine, editEndLine, lineDelta);
+        parseDocumentInBackground();
+        return;
+    }
+
+    lastBlockCount = blockCount;
+
+    // Notify listeners of the updated AST.
+    ((MarkdownDocument *) document)->setMarkdownAST(ast, changes);
+
+    // Only the lines whose structure changed need highlighting again,
+    // aside from the edited lines themselves, which the highlighter will
+    // take care of on its own.
+    rehighlightLines(changes);
+}
+
+void MarkdownEditorPrivate::parseDocumentInBackground()
+{
+    if (parsingSuspended) {
+        return;
+    }
+
+    if (backgroundParseDeferred || pasteInProgress) {
+        parseDeferred = true;
+        return;
+    }
+
+    startBackgroundParse();
+}
+
+void MarkdownEditorPrivate::startBackgroundParse()
+{
+    Q_Q(MarkdownEditor);
+
+    parseDeferred = false;
+    parseInProgress = true;
+    parseAgain = false;
+    parseRevision = q->document()->revision();
+
+    QString text = ((MarkdownDocument *) q->document())->plainTextSnapshot();
+    bool renderHtml = htmlRenderingEnabled;
+
+    // Let the HTML preview know that it can wait for the HTML rendered from
+    // this parse rather than parse the text itself.
+    if (renderHtml) {
+        ((MarkdownDocument *) q->document())->setHtmlRenderPending(parseRevision);
+    }
+
+    QFuture<ParseResult> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Interactive,
+            [text, renderHtml]() {
+                GW_TRACE_SCOPE("parseDocument (background)");
+                ParseResult result;
+
+                if (renderHtml) {
+                    result.ast = CmarkGfmAPI::instance()->parseAndRenderHtml(text, true, result.html);
+                } else {
+                    result.ast = CmarkGfmAPI::instance()->parse(text, false);
+                }
+
+                return result;
+            }
+        );
+    parseWatcher->setFuture(future);
+}
+
+void MarkdownEditorPrivate::onParseFinished()
+{
+    Q_Q(MarkdownEditor);
+
+    ParseResult result = parseWatcher->result();
+    MarkdownAST *ast = result.ast;
+    parseInProgress = false;
+
+    // Even if stale, the HTML is as current as the preview would otherwise
+    // have rendered it, so publish it regardless.
+    if (!result.html.isNull()) {
+        ((MarkdownDocument *) q->document())->setRenderedHtml(result.html, parseRevision);
+    }
+
+    // The text parsed was replaced by that of a file loaded meanwhile,
+    // which resumeParsing() took care of unless there were edits since.
+    if (parseDiscarded) {
+        parseDiscarded = false;
+        delete ast;
+
+        if (parseAgain) {
+            parseDocumentInBackground();
+        }
+
+        return;
+    }
+
+    // If the text changed while parsing, the result is already stale, so
+    // discard it and parse the newest text.  Until then, listeners keep
+    // using the last published AST.
+    if (parseAgain || (parseRevision != q->document()->revision())) {
+        delete ast;
+        parseDocumentInBackground();
+        return;
+    }
+
+    MarkdownDocument *document = (MarkdownDocument *) q->document();
+    int blockCount = document->blockCount();
+    QVector<MarkdownAST::LineRange> changes =
+        ast->changedLineRanges(document->markdownAST(), blockCount - lastBlockCount);
+
+    // The lines edited while the AST was stale were highlighted with
+    // outdated information, so highlight them again along with the lines
+    // whose structure changed.
+    if (dirtyStartLine > 0) {
+        changes.append(MarkdownAST::LineRange(dirtyStartLine, dirtyEndLine));
+    }
+
+    document->setMarkdownAST(ast, changes);
+    lastBlockCount = blockCount;
+    rehighlightLines(changes);
+
+    dirtyStartLine = -1;
+    dirtyEndLine = -1;
+
+    if (fallbackHighlighting) {
+        fallbackHighlighting = false;
+        highlighter->setFallbackLines(0, 0);
+    }
+}
+
+// Rehighlights the given line ranges, merging any that overlap so that no
+// line is highlighted twice.
+//
+void MarkdownEditorPrivate::rehighlightLines(QVector<MarkdownAST::LineRange> ranges)
+{
+    std::sort(ranges.begin(), ranges.end());
+
+    int i = 0;
+
+    while (i < ranges.size()) {
+        MarkdownAST::LineRange range = ranges[i];
+
+        for (i++; (i < ranges.size()) && (ranges[i].first <= (range.second + 1)); i++) {
+            range.second = qMax(range.second, ranges[i].second);
+        }
+
+        highlighter->rehighlightLines(range.first, range.second);
+    }
+}
+
+void MarkdownEditorPrivate::invalidateBlockAreas()
+{
+    blockAreasValid = false;
+}
+
+// Emits the scrolled() signal with the line at the top of the viewport.
+// Since each text block holds one line of Markdown source, the line number
+// is that of the first visible block, plus how much of the block is above
+// the viewport.
+//
+void MarkdownEditorPrivate::onScrolled()
+{
+    Q_Q(MarkdownEditor);
+
+    QTextBlock block = q->firstVisibleBlock();
+
+    if (!block.isValid()) {
+        return;
+    }
+
+    QRectF rect = q->blockBoundingGeometry(block).translated(q->contentOffset());
+    qreal fraction = 0.0;
+
+    if (rect.height() > 0.0) {
+        fraction = qBound(0.0, -rect.top() / rect.height(), 1.0);
+    }
+
+    emit q->scrolled(block.blockNumber() + 1 + fraction);
+}
+
+// Searches, at low priority, for the suggestions of the misspelled words in
+// view whose suggestions are not cached yet, so that the dictionary caches
+// them for the context menu.  Searches still pending from the last pause
+// are skipped, since the view may have moved since.
+//
+void MarkdownEditorPrivate::prefetchSuggestions()
+{
+    Q_Q(MarkdownEditor);
+
+    if (!suggestionPrefetch.isNull()) {
+        TaskScheduler::cancel(suggestionPrefetch);
+        suggestionPrefetch.clear();
+    }
+
+    if (!spellCheckEnabled || q->isReadOnly() || !q->isVisible()) {
+        return;
+    }
+
+    TaskScheduler::CancellationToken token = TaskScheduler::createCancellationToken();
+    QSet<QString> words;
+    int viewportBottom = q->viewport()->height();
+
+    for
+    (
+        QTextBlock block = q->firstVisibleBlock();
+        block.isValid() && (words.size() < MaxPrefetchedSuggestions);
+        block = block.next()
+    ) {
+        if (q->blockBoundingGeometry(block).translated(q->contentOffset()).top() > viewportBottom) {
+            break;
+        }
+
+        QVector<QPair<int, int>> misspellings;
+
+        if (!highlighter->misspellings(block, misspellings)) {
+            continue;
+        }
+
+        DictionaryRef dictionary = highlighter->dictionary(block);
+        QString text = block.text();
+
+        for (const QPair<int, int> &misspelling : misspellings) {
+            QString word = text.mid(misspelling.first, misspelling.second);
+            QStringList cached;
+
+            if (words.contains(word) || dictionary.cachedSuggestions(word, cached)) {
+                continue;
+            }
+
+            words.insert(word);
+
+            // Each word is its own task, so that the searches left when
+            // the next pause cancels this one are skipped.
+            TaskScheduler::instance()->run
+            (
+                TaskScheduler::SpellCheck,
+                [dictionary, word]() {
+                    dictionary.suggestions(word);
+                },
+                token
+            );
+
+            if (words.size() >= MaxPrefetchedSuggestions) {
+                break;
+            }
+        }
+    }
+
+    if (!words.isEmpty()) {
+        suggestionPrefetch = token;
+    }
+}
+
+// Replaces the given placeholder action of the spelling context menu with
+// the given suggestions, or notes that there are none.
+//
+void MarkdownEditorPrivate::addSuggestionActions
+(
+    QMenu *menu,
+    QAction *before,
+    const QStringList &suggestions
+)
+{
+    Q_Q(MarkdownEditor);
+
+    if (suggestions.empty()) {
+        before->setText(MarkdownEditor::tr("No spelling suggestions found"));
+        return;
+    }
+
+    for (int i = 0; i < suggestions.size(); i++) {
+        QAction *suggestionAction = new QAction(suggestions[i], q);
+
+        // Need the following line because KDE Plasma 5 will insert a hidden ampersand
+        // into the menu text as a keyboard accelerator.  Go off of the data in the
+        // QAction rather than the text to avoid this.
+        //
+        suggestionAction->setData(suggestions[i]);
+
+        spellingActions.append(suggestionAction);
+        menu->insertAction(before, suggestionAction);
+    }
+
+    menu->removeAction(before);
+}
+
+// Returns whether the cached block area backgrounds are still those of the
+// visible blocks, i.e., the layout has not changed, the editor has not
+// been scrolled or resized, and the visible blocks have the same states.
+//
+bool MarkdownEditorPrivate::blockAreasCurrent() const
+{
+    Q_Q(const MarkdownEditor);
+
+    QTextBlock block = q->firstVisibleBlock();
+
+    if
+    (
+        !blockAreasValid
+        || (block.blockNumber() != blockAreasFirstBlock)
+        || (q->contentOffset() != blockAreasOffset)
+        || (q->viewport()->size() != blockAreasViewportSize)
+    ) {
+        return false;
+    }
+
+    // The highlighter can change the state of a block without changing
+    // its formats, which leaves the layout untouched.
+    for (int state : blockAreaStates) {
+        while (block.isValid() && !block.isVisible()) {
+            block = block.next();
+        }
+
+        if (!block.isValid() || (block.userState() != state)) {
+            return false;
+        }
+
+        block = block.next();
+    }
+
+    return true;
+}
+
+// Computes the backgrounds for the code blocks and block quotes of the
+// visible blocks.  The backgrounds are drawn per each block area (consisting
+// of multiple text blocks or lines), rather than one rectangle area per text
+// block/line in case there are margins between each text block.  This way,
+// the background will extend to cover the margins between text blocks as
+// well.
+//
+// NOTE: Algorithm for looping through text blocks is a partial lift from
+//       Qt's QPlainTextEdit paintEvent() code. Please refer to the
+//       LGPL v. 3 license for the original Qt code.
+//
+void MarkdownEditorPrivate::computeBlockAreas()
+{
+    Q_Q(MarkdownEditor);
+
+    QRect viewportRect = q->viewport()->rect();
+    QPointF offset(q->contentOffset());
+    QTextBlock block = q->firstVisibleBlock();
+
+    blockAreaPaths.clear();
+    blockAreaStates.clear();
+    blockAreasValid = true;
+    blockAreasFirstBlock = block.blockNumber();
+    blockAreasOffset = offset;
+    blockAreasViewportSize = q->viewport()->size();
+
+    bool firstVisible = true;
+
+    QRectF blockAreaRect; // Code or block quote rect.
+    bool inBlockArea = false;
+    BlockType blockType = BlockTypeNone;
+    bool clipTop = false;
+    bool drawBlock = false;
+    int dy = 0;
+    bool done = false;
+
+    int cornerRadius = 5;
+
+    if (InterfaceStyleSquare == editorCorners) {
+        cornerRadius = 0;
+    }
+
+    while (block.isValid() && !done) {
+        BlockType prevType;
+
+        // Blocks hidden within folded sections take up no space.
+        if (!block.isVisible()) {
+            block = block.next();
+            continue;
+        }
+        
+        blockAreaStates.append(block.userState());
+
+        QRectF r = q->blockBoundingRect(block).translated(offset);
+
+        // If the first visible block is in the middle of a text block area...
+        if (firstVisible 
+                && insideBlockArea(block, blockType)
+                && insideBlockArea(block.previous(), prevType)
+                && (blockType == prevType)) {
+            clipTop = true;
+            inBlockArea = true;
+            blockAreaRect = r;
+            dy = 0;
+        }
+        // If the block begins a new text block area...
+        else if (!inBlockArea && atBlockAreaStart(block, blockType)) {
+            blockAreaRect = r;
+            dy = 0;
+            inBlockArea = true;
+
+            // If this is the first visible block within the viewport
+            // and if the previous block is part of the text block area,
+            // then the rectangle to draw for the block area will have
+            // its top clipped by the viewport and will need to be
+            // drawn specially.
+            //
+            if
+            (
+                firstVisible
+                && insideBlockArea(block.previous(), prevType)
+                && (blockType == prevType)
+            ) {
+                clipTop = true;
+            }
+        }
+        // Else if the block ends a text block area...
+        else if (inBlockArea && atBlockAreaEnd(block, blockType)) {
+            drawBlock = true;
+            inBlockArea = false;
+            blockAreaRect.setHeight(dy);
+        }
+
+        // If the block is at the end of the document and ends a text
+        // block area...
+        //
+        if (inBlockArea && (block == q->document()->lastBlock())) {
+            drawBlock = true;
+            inBlockArea = false;
+            dy += r.height();
+            blockAreaRect.setHeight(dy);
+        }
+
+        offset.ry() += r.height();
+        dy += r.height();
+
+        // If this is the last text block visible within the viewport...
+        if (offset.y() > viewportRect.height()) {
+            if (inBlockArea) {
+                blockAreaRect.setHeight(dy);
+                drawBlock = true;
+            }
+
+            // Finished drawing.
+            done = true;
+        }
+
+        if (drawBlock) {
+            QPainterPath path;
+
+            // If the first visible block is "clipped" such that the previous block
+            // is part of the text block area, then only draw a rectangle with the
+            // bottom corners rounded, and with the top corners square to reflect
+            // that the first visible block is part of a larger block of text.
+            //
+            if (clipTop) {
+                path.setFillRule(Qt::WindingFill);
+                path.addRoundedRect(blockAreaRect, cornerRadius, cornerRadius);
+                qreal adjustedHeight = blockAreaRect.height() / 2;
+                path.addRect(blockAreaRect.adjusted(0, 0, 0, -adjustedHeight));
+                path = path.simplified();
+                clipTop = false;
+            }
+            // Else draw the entire rectangle with all corners rounded.
+            else {
+                path.addRoundedRect(blockAreaRect, cornerRadius, cornerRadius);
+            }
+
+            blockAreaPaths.append(path);
+            drawBlock = false;
+        }
+
+        // This fixes the RTL bug of QPlainTextEdit
+        // https://bugreports.qt.io/browse/QTBUG-7516.
+        //
+        // Credit goes to Patrizio Bekerle (qmarkdowntextedit) for discovering
+        // this workaround.  The text option is reset whenever the block is
+        // laid out again, which also invalidates the block areas.
+        //
+        if (block.text().isRightToLeft()) {
+            QTextLayout *layout = block.layout();
+            QTextOption opt = QTextOption(Qt::AlignRight);
+            opt.setTextDirection(Qt::RightToLeft);
+            layout->setTextOption(opt);
+        }
+
+        block = block.next();
+        firstVisible = false;
+    }
+}
+
+void MarkdownEditorPrivate::markLinesDirty(int startLine, int endLine, int lineDelta)
+{
+    if (dirtyStartLine <= 0) {
+        dirtyStartLine = startLine;
+        dirtyEndLine = endLine;
+        return;
+    }
+
+    dirtyStartLine = qMin(dirtyStartLine, startLine);
+
+    if (dirtyEndLine >= startLine) {
+        dirtyEndLine += lineDelta;
+    }
+
+    dirtyEndLine = qMax(qMax(dirtyEndLine, endLine), dirtyStartLine);
+}
+
+// Keeps the slow lines in step with the edit of the given lines, in terms
+// of the old document text, growing the slow lines to cover the edit if
+// it overlaps them.
+//
+void MarkdownEditorPrivate::shiftSlowLines(int editStartLine, int oldEditEndLine, int lineDelta)
+{
+    if ((slowStartLine <= 0) || (editStartLine > slowEndLine)) {
+        return;
+    }
+
+    if (oldEditEndLine < slowStartLine) {
+        slowStartLine += lineDelta;
+        slowEndLine += lineDelta;
+    } else {
+        slowStartLine = qMin(slowStartLine, editStartLine);
+        slowEndLine = qMax(slowEndLine + lineDelta, slowStartLine);
+    }
+
+    if (fallbackHighlighting) {
+        highlighter->setFallbackLines(slowStartLine, slowEndLine);
+    }
+}
+
+// Logs the top-level block of the given lines that took up the most lines,
+// as the likeliest cause of the parse of those lines being slow.
+//
+void MarkdownEditorPrivate::logSlowParse(int firstLine, int lastLine, qint64 msecs)
+{
+    const MarkdownNode *longest = nullptr;
+    MarkdownAST *fragment = incrementalParser->fragment();
+
+    if (nullptr != fragment->root()) {
+        for (const MarkdownNode *node = fragment->root()->firstChild(); nullptr != node; node = node->next()) {
+            if
+            (
+                (nullptr == longest)
+                || ((node->endLine() - node->startLine()) > (longest->endLine() - longest->startLine()))
+            ) {
+                longest = node;
+            }
+        }
+    }
+
+    if (nullptr == longest) {
+        qWarning().noquote()
+            << QString("Parsing lines %1-%2 took %3 ms.").arg(firstLine).arg(lastLine).arg(msecs);
+        return;
+    }
+
+    qWarning().noquote()
+        << QString("Parsing lines %1-%2 took %3 ms.  Longest block: %4 at lines %5-%6.")
+            .arg(firstLine)
+            .arg(lastLine)
+            .arg(msecs)
+            .arg(MarkdownNode::toString(longest->type()))
+            .arg(longest->startLine() + firstLine - 1)
+            .arg(longest->endLine() + firstLine - 1);
+}
+
+void MarkdownEditorPrivate::handleCarriageReturn()
+{
+    Q_Q(MarkdownEditor);
+    
+    QString autoInsertText = "";
+    QTextCursor cursor = q->textCursor();
+    bool endList = false;
+
+    if (cursor.positionInBlock() < (cursor.block().length() - 1)) {
+        autoInsertText = priorIndentation();
 
         if (cursor.positionInBlock() < autoInsertText.length()) {
             autoInsertText.truncate(cursor.positionInBlock());
@@ -1854,129 +3485,470 @@ bool MarkdownEditorPrivate::handleBackspaceKey()
         return false;
     }
 
-    int backtrackIndex = -1;
+    int backtrackIndex = -1;
+
+    switch (cursor.block().userState() & MarkdownStateMask) {
+    case MarkdownStateNumberedList: {
+        if (emptyNumberedListRegex.match(q->textCursor().block().text()).hasMatch()) {
+            backtrackIndex = cursor.block().text().indexOf(QRegularExpression("\\d"));
+        }
+        break;
+    }
+    case MarkdownStateTaskList:
+        if
+        (
+            emptyBulletListRegex.match(cursor.block().text()).hasMatch()
+            || emptyTaskListRegex.match(cursor.block().text()).hasMatch()
+        ) {
+            backtrackIndex = cursor.block().text().indexOf(QRegularExpression("[+*-]"));
+        }
+        break;
+    case MarkdownStateBlockquote:
+        if (emptyBlockquoteRegex.match(cursor.block().text()).hasMatch()) {
+            backtrackIndex = cursor.block().text().lastIndexOf('>');
+        }
+        break;
+    default:
+        // If the first character in an automatched set is being
+        // deleted, then delete the second matching one along with it.
+        //
+        if (autoMatchEnabled && (cursor.positionInBlock() > 0)) {
+            QString blockText = cursor.block().text();
+
+            if (cursor.positionInBlock() < blockText.length()) {
+                QChar currentChar = blockText[cursor.positionInBlock()];
+                QChar previousChar = blockText[cursor.positionInBlock() - 1];
+
+                if (markupPairs.value(previousChar) == currentChar) {
+                    cursor.movePosition(QTextCursor::Left);
+                    cursor.movePosition
+                    (
+                        QTextCursor::Right,
+                        QTextCursor::KeepAnchor,
+                        2
+                    );
+                    cursor.removeSelectedText();
+                    return true;
+                }
+            }
+        }
+        break;
+    }
+
+    if (backtrackIndex >= 0) {
+        cursor.movePosition(QTextCursor::StartOfBlock);
+        cursor.movePosition
+        (
+            QTextCursor::Right,
+            QTextCursor::MoveAnchor,
+            backtrackIndex
+        );
+
+        cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+        cursor.removeSelectedText();
+        return true;
+    }
+
+    return false;
+}
+
+// Maps the given column of a block's old text to the corresponding
+// column of its new text.  Columns within the text common to the start or
+// the end of both texts keep their place in it, while columns within the
+// changed text move to its end, as the cursor would after typing it.
+//
+static int mapColumn(const QString &oldText, const QString &newText, int column)
+{
+    int shortest = qMin(oldText.length(), newText.length());
+    int prefix = 0;
+
+    while ((prefix < shortest) && (oldText.at(prefix) == newText.at(prefix))) {
+        prefix++;
+    }
+
+    int suffix = 0;
+
+    while
+    (
+        (suffix < (shortest - prefix))
+        && (oldText.at(oldText.length() - suffix - 1) == newText.at(newText.length() - suffix - 1))
+    ) {
+        suffix++;
+    }
+
+    if (column >= (oldText.length() - suffix)) {
+        return column + newText.length() - oldText.length();
+    } else if (column <= prefix) {
+        return column;
+    } else {
+        return newText.length() - suffix;
+    }
+}
+
+// Replaces the text of each block touched by the selection, or of the
+// cursor's block if nothing is selected, with the text returned by the
+// given function for it.  All the blocks are computed before the
+// document is touched, and the changed ones are replaced with a single
+// edit, so that the document, and with it the parse, highlighting and
+// statistics, are updated once however many blocks are transformed, and
+// so that undoing the transformation takes one step.  The selection is
+// kept on the same text.  Returns false if no block changed.
+//
+bool MarkdownEditorPrivate::transformBlocks(const BlockTransform &transform)
+{
+    Q_Q(MarkdownEditor);
+
+    QTextCursor cursor = q->textCursor();
+    QTextBlock block = q->document()->findBlock(cursor.selectionStart());
+    QTextBlock last = q->document()->findBlock(cursor.selectionEnd());
+
+    QVector<int> positions;
+    QStringList oldTexts;
+    QStringList newTexts;
+    int firstChanged = -1;
+    int lastChanged = -1;
+
+    for (int index = 0; block.isValid(); index++) {
+        QString text = block.text();
+        QString newText = transform(block, index);
+
+        if (newText != text) {
+            if (firstChanged < 0) {
+                firstChanged = index;
+            }
+
+            lastChanged = index;
+        }
+
+        positions.append(block.position());
+        oldTexts.append(text);
+        newTexts.append(newText);
+
+        if (block == last) {
+            break;
+        }
+
+        block = block.next();
+    }
+
+    if (firstChanged < 0) {
+        return false;
+    }
+
+    int start = positions[firstChanged];
+    int end = positions[lastChanged] + oldTexts[lastChanged].length();
+    QString replacement;
+
+    for (int i = firstChanged; i <= lastChanged; i++) {
+        if (i > firstChanged) {
+            replacement += '\n';
+        }
+
+        replacement += newTexts[i];
+    }
+
+    int delta = replacement.length() - (end - start);
+
+    auto mapPosition = [&](int position) -> int {
+        if (position < start) {
+            return position;
+        } else if (position > end) {
+            return position + delta;
+        }
+
+        int newBlockStart = start;
+
+        for (int i = firstChanged; i <= lastChanged; i++) {
+            int blockEnd = positions[i] + oldTexts[i].length();
+
+            if (position <= blockEnd) {
+                return newBlockStart
+                    + mapColumn(oldTexts[i], newTexts[i], position - positions[i]);
+            }
+
+            newBlockStart += newTexts[i].length() + 1;
+        }
+
+        return position + delta;
+    };
+
+    int anchor = mapPosition(cursor.anchor());
+    int position = mapPosition(cursor.position());
+
+    textDocument->beginTransaction();
+    cursor.beginEditBlock();
+    cursor.setPosition(start);
+    cursor.setPosition(end, QTextCursor::KeepAnchor);
+    cursor.insertText(replacement);
+    cursor.endEditBlock();
+    textDocument->commit();
+
+    cursor.setPosition(anchor);
+    cursor.setPosition(position, QTextCursor::KeepAnchor);
+    q->setTextCursor(cursor);
+
+    return true;
+}
+
+// Algorithm lifted from ReText.
+void MarkdownEditorPrivate::insertPrefixForBlocks(const QString &prefix)
+{
+    transformBlocks
+    (
+        [prefix](const QTextBlock &block, int index) -> QString {
+            Q_UNUSED(index)
+            return prefix + block.text();
+        }
+    );
+}
+
+void MarkdownEditorPrivate::createNumberedList(const QChar marker)
+{
+    transformBlocks
+    (
+        [marker](const QTextBlock &block, int index) -> QString {
+            return QString("%1").arg(index + 1) + marker + " " + block.text();
+        }
+    );
+}
+
+// Returns the length of the chunk of the pasted text starting at the given
+// position, which is at least the given length, unless the end of the
+// text comes first, and which is extended to the end of a line.
+//
+int MarkdownEditorPrivate::pasteChunkLength(int position, int length) const
+{
+    int end = position + length;
+
+    if (end >= pasteText.length()) {
+        return pasteText.length() - position;
+    }
+
+    // Don't split lines, and with them any "\r\n" line endings.
+    int newline = pasteText.indexOf('\n', end - 1);
+
+    if (newline < 0) {
+        return pasteText.length() - position;
+    }
+
+    return newline + 1 - position;
+}
+
+// Inserts the next chunks of a large paste.  Each chunk is joined to the
+// edit that inserted the first one, so that the paste is undone in one
+// step, but is an edit of its own, so that the parse, highlighting and
+// statistics only process the new chunk.
+//
+void MarkdownEditorPrivate::insertNextPasteChunks()
+{
+    Q_Q(MarkdownEditor);
+
+    // The document was changed or replaced from elsewhere, such as by
+    // opening another file, so the rest of the paste no longer applies.
+    if (q->document()->revision() != pasteRevision) {
+        finishPaste();
+        return;
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    // Process the chunks inserted in this batch as one change.
+    textDocument->beginTransaction();
+
+    while ((pastePosition < pasteText.length()) && (elapsed.elapsed() < PasteBatchTime)) {
+        int length = pasteChunkLength(pastePosition, PasteChunkSize);
+
+        pasteCursor.joinPreviousEditBlock();
+        pasteCursor.insertText(pasteText.mid(pastePosition, length));
+        pasteCursor.endEditBlock();
+        pastePosition += length;
+    }
+
+    textDocument->commit();
+
+    pasteRevision = q->document()->revision();
+
+    if (pastePosition >= pasteText.length()) {
+        finishPaste();
+        return;
+    }
+
+    // Note that this must be the last thing done, since listeners may
+    // process events.
+    emit q->operationUpdate
+    (
+        MarkdownEditor::tr("pasting (%1%)")
+            .arg((int) ((100.0 * pastePosition) / pasteText.length()))
+    );
+}
+
+void MarkdownEditorPrivate::finishPaste()
+{
+    Q_Q(MarkdownEditor);
+
+    pasteTimer->stop();
+    pasteInProgress = false;
+    pasteText = QString();
+    pastePosition = 0;
+    pasteCursor = QTextCursor();
+    pasteRevision = -1;
+
+    q->setReadOnly(false);
+    q->ensureCursorVisible();
+
+    // Catch up on the full parse that waited for the paste.
+    if (parseDeferred && !backgroundParseDeferred && !parseInProgress) {
+        startBackgroundParse();
+    }
+
+    emit q->operationFinished();
+}
+
+// Copies the given image into the assets folder next to the document on a
+// worker thread, since large images take a while to copy or downscale, and
+// then inserts a link to the copy at the given cursor, which follows any
+// edits made meanwhile.  If the image cannot be imported, it is linked to
+// where it is instead.
+//
+void MarkdownEditorPrivate::importImage(const QTextCursor &cursor, const QString &sourcePath)
+{
+    Q_Q(MarkdownEditor);
 
-    switch (cursor.block().userState() & MarkdownStateMask) {
-    case MarkdownStateNumberedList: {
-        if (emptyNumberedListRegex.match(q->textCursor().block().text()).hasMatch()) {
-            backtrackIndex = cursor.block().text().indexOf(QRegularExpression("\\d"));
-        }
-        break;
-    }
-    case MarkdownStateTaskList:
-        if
-        (
-            emptyBulletListRegex.match(cursor.block().text()).hasMatch()
-            || emptyTaskListRegex.match(cursor.block().text()).hasMatch()
-        ) {
-            backtrackIndex = cursor.block().text().indexOf(QRegularExpression("[+*-]"));
-        }
-        break;
-    case MarkdownStateBlockquote:
-        if (emptyBlockquoteRegex.match(cursor.block().text()).hasMatch()) {
-            backtrackIndex = cursor.block().text().lastIndexOf('>');
-        }
-        break;
-    default:
-        // If the first character in an automatched set is being
-        // deleted, then delete the second matching one along with it.
-        //
-        if (autoMatchEnabled && (cursor.positionInBlock() > 0)) {
-            QString blockText = cursor.block().text();
+    QString assetsDir =
+        QFileInfo(textDocument->filePath()).dir().absoluteFilePath("assets");
+    int maxWidth = imageImportMaxWidth;
+    QTextCursor insertCursor(cursor);
 
-            if (cursor.positionInBlock() < blockText.length()) {
-                QChar currentChar = blockText[cursor.positionInBlock()];
-                QChar previousChar = blockText[cursor.positionInBlock() - 1];
+    QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>(q);
 
-                if (markupPairs.value(previousChar) == currentChar) {
-                    cursor.movePosition(QTextCursor::Left);
-                    cursor.movePosition
-                    (
-                        QTextCursor::Right,
-                        QTextCursor::KeepAnchor,
-                        2
-                    );
-                    cursor.removeSelectedText();
-                    return true;
-                }
+    q->connect
+    (
+        watcher,
+        &QFutureWatcher<QString>::finished,
+        q,
+        [this, watcher, insertCursor, sourcePath]() mutable {
+            QString path = watcher->result();
+            watcher->deleteLater();
+
+            if (path.isNull()) {
+                path = QUrl::fromLocalFile(sourcePath).toString();
+            } else if (!textDocument->isNew()) {
+                path = QFileInfo(textDocument->filePath()).dir().relativeFilePath(path);
             }
+
+            insertCursor.insertText(QString("![](%1)").arg(path));
         }
-        break;
-    }
+    );
 
-    if (backtrackIndex >= 0) {
-        cursor.movePosition(QTextCursor::StartOfBlock);
-        cursor.movePosition
+    watcher->setFuture
+    (
+        TaskScheduler::instance()->run
         (
-            QTextCursor::Right,
-            QTextCursor::MoveAnchor,
-            backtrackIndex
-        );
+            TaskScheduler::Interactive,
+            [sourcePath, assetsDir, maxWidth]() {
+                QString err;
+                return ImageStore::importImage(sourcePath, assetsDir, maxWidth, err);
+            }
+        )
+    );
+}
 
-        cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
-        cursor.removeSelectedText();
-        return true;
+// Returns the position within its block of the start of the word that
+// ends at the given cursor.
+int MarkdownEditorPrivate::wordStartBeforeCursor(const QTextCursor &cursor) const
+{
+    QString text = cursor.block().text();
+    int start = cursor.positionInBlock();
+
+    while ((start > 0) && (text[start - 1].isLetterOrNumber() || text[start - 1].isMark())) {
+        start--;
     }
 
-    return false;
+    return start;
 }
 
-// Algorithm lifted from ReText.
-void MarkdownEditorPrivate::insertPrefixForBlocks(const QString &prefix)
+void MarkdownEditorPrivate::updateCompletions(const QKeyEvent *e)
 {
     Q_Q(MarkdownEditor);
-    
+
+    QAbstractItemView *popup = completer->popup();
+    QChar typed = (e->text().size() == 1) ? e->text().at(0) : QChar();
+    bool wordTyped = typed.isLetterOrNumber() || typed.isMark();
+
+    // Deleting characters of the word keeps the popup open, but only
+    // typing opens it.
+    if
+    (
+        !wordCompletionEnabled
+        || q->isReadOnly()
+        || !(wordTyped || ((Qt::Key_Backspace == e->key()) && popup->isVisible()))
+    ) {
+        popup->hide();
+        return;
+    }
+
     QTextCursor cursor = q->textCursor();
-    QTextBlock block;
-    QTextBlock end;
+    QString text = cursor.block().text();
+    int end = cursor.positionInBlock();
+    int start = wordStartBeforeCursor(cursor);
 
-    if (cursor.hasSelection()) {
-        block = q->document()->findBlock(cursor.selectionStart());
-        end = q->document()->findBlock(cursor.selectionEnd()).next();
-    } else {
-        block = cursor.block();
-        end = block.next();
+    if
+    (
+        cursor.hasSelection()
+        || ((end - start) < CompletionPrefixLength)
+        || ((end < text.length()) && (text[end].isLetterOrNumber() || text[end].isMark()))
+    ) {
+        popup->hide();
+        return;
     }
 
-    cursor.beginEditBlock();
+    QStringList completions = textDocument->vocabularyIndex()->completions
+        (
+            text.mid(start, end - start),
+            CompletedWordLength,
+            MaxCompletions
+        );
 
-    while (block != end) {
-        cursor.setPosition(block.position());
-        cursor.insertText(prefix);
-        block = block.next();
+    if (completions.isEmpty()) {
+        popup->hide();
+        return;
     }
 
-    cursor.endEditBlock();
+    completionModel->setStringList(completions);
+    popup->setCurrentIndex(completionModel->index(0, 0));
+
+    QRect rect = q->cursorRect();
+    rect.setWidth
+    (
+        popup->sizeHintForColumn(0)
+        + popup->verticalScrollBar()->sizeHint().width()
+    );
+    completer->complete(rect);
 }
 
-void MarkdownEditorPrivate::createNumberedList(const QChar marker)
+void MarkdownEditorPrivate::insertCompletion(const QString &completion)
 {
     Q_Q(MarkdownEditor);
-    
-    QTextCursor cursor = q->textCursor();
-    QTextBlock block;
-    QTextBlock end;
 
-    if (cursor.hasSelection()) {
-        block = q->document()->findBlock(cursor.selectionStart());
-        end = q->document()->findBlock(cursor.selectionEnd()).next();
-    } else {
-        block = cursor.block();
-        end = block.next();
-    }
-
-    cursor.beginEditBlock();
-
-    int number = 1;
+    QTextCursor cursor = q->textCursor();
+    int start = wordStartBeforeCursor(cursor);
+    QString prefix = cursor.block().text().mid(start, cursor.positionInBlock() - start);
+    QString word = completion;
 
-    while (block != end) {
-        cursor.setPosition(block.position());
-        cursor.insertText(QString("%1").arg(number) + marker + " ");
-        block = block.next();
-        number++;
+    // Words that the document only spells in lowercase take the case of
+    // what was typed, such as at the start of a sentence.
+    if
+    (
+        (completion == completion.toLower())
+        && completion.startsWith(prefix, Qt::CaseInsensitive)
+    ) {
+        word = prefix + completion.mid(prefix.length());
     }
 
-    cursor.endEditBlock();
+    cursor.setPosition(cursor.block().position() + start, QTextCursor::KeepAnchor);
+    cursor.insertText(word);
+    q->setTextCursor(cursor);
 }
 
 bool MarkdownEditorPrivate::insertPairedCharacters(const QChar firstChar)
@@ -2286,4 +4258,341 @@ bool MarkdownEditorPrivate::isCodeBlock(const QTextBlock &block) const
 {
     return (MarkdownStateCodeBlock == (MarkdownStateCodeBlock & block.userState()));
 }
+
+// Finds the section of the document that the given block belongs to,
+// according to the headings of the document's AST:  the section begins at
+// the last heading at or before the block, and ends right before the next
+// heading of the same or higher level, or at the end of the document.
+// Returns false if no heading precedes the block.
+//
+bool MarkdownEditorPrivate::findSection
+(
+    int blockNumber,
+    int &firstBlock,
+    int &lastBlock
+) const
+{
+    MarkdownAST *ast = textDocument->markdownAST();
+
+    if (nullptr == ast) {
+        return false;
+    }
+
+    QVector<MarkdownNode *> headings = ast->headings();
+
+    // Headings are in document order, so find the last one at or before
+    // the block with a binary search.
+    auto next = std::upper_bound
+    (
+        headings.cbegin(),
+        headings.cend(),
+        blockNumber + 1,
+        [](int line, const MarkdownNode *heading) {
+            return line < heading->startLine();
+        }
+    );
+
+    if (next == headings.cbegin()) {
+        return false;
+    }
+
+    const MarkdownNode *heading = *(next - 1);
+
+    firstBlock = heading->startLine() - 1;
+    lastBlock = textDocument->blockCount() - 1;
+
+    for (; next != headings.cend(); next++) {
+        if ((*next)->headingLevel() <= heading->headingLevel()) {
+            lastBlock = (*next)->startLine() - 2;
+            break;
+        }
+    }
+
+    return true;
+}
+
+// Hides or shows the blocks after the heading at the first block, through
+// to the last block, and marks the heading as folded or not.  Since the
+// AST can lag behind the document, unfolding continues past the last block
+// through any blocks that are still hidden.  Unfolding a section also
+// unfolds the sections nested within it.  The blocks are laid out again,
+// and those shown are highlighted, as they were left unformatted while
+// hidden.
+//
+void MarkdownEditorPrivate::setSectionFolded
+(
+    int firstBlock,
+    int lastBlock,
+    bool folded
+)
+{
+    QTextBlock heading = textDocument->findBlockByNumber(firstBlock);
+
+    if (!heading.isValid()) {
+        return;
+    }
+
+    TextBlockData *data = (TextBlockData *) heading.userData();
+
+    if (nullptr == data) {
+        data = new TextBlockData(textDocument, heading);
+        heading.setUserData(data);
+    }
+
+    data->folded = folded;
+
+    QTextBlock block = heading.next();
+    QTextBlock last = heading;
+
+    while
+    (
+        block.isValid()
+        && ((block.blockNumber() <= lastBlock) || (!folded && !block.isVisible()))
+    ) {
+        block.setVisible(!folded);
+
+        if (!folded) {
+            TextBlockData *nested = (TextBlockData *) block.userData();
+
+            if (nullptr != nested) {
+                nested->folded = false;
+            }
+        }
+
+        last = block;
+        block = block.next();
+    }
+
+    if (last == heading) {
+        return;
+    }
+
+    if (folded) {
+        owner()->foldsPresent = true;
+    }
+
+    textDocument->markContentsDirty
+    (
+        heading.position(),
+        last.position() + last.length() - heading.position()
+    );
+    invalidateBlockAreas();
+
+    if (!folded) {
+        highlighter->rehighlightLines(firstBlock + 2, last.blockNumber() + 1);
+    }
+}
+
+// Replaces the viewport with one drawn with OpenGL or with the raster
+// engine, according to the setting, and sets it up as QPlainTextEdit sets
+// up its own.  Without OpenGL support, the raster viewport is kept.
+//
+void MarkdownEditorPrivate::replaceViewport()
+{
+    Q_Q(MarkdownEditor);
+
+    QWidget *viewport = nullptr;
+
+#ifndef QT_NO_OPENGL
+    if (gpuViewportEnabled) {
+        QOpenGLWidget *glViewport = new QOpenGLWidget();
+
+        // Multisample, so that the rounded block backgrounds stay smooth.
+        QSurfaceFormat format = glViewport->format();
+        format.setSamples(4);
+        glViewport->setFormat(format);
+
+        // Only the areas that changed are repainted, such as that of the
+        // text cursor, so the rest of the frame must be kept.
+        glViewport->setUpdateBehavior(QOpenGLWidget::PartialUpdate);
+        viewport = glViewport;
+    }
+#endif
+
+    if (nullptr == viewport) {
+        viewport = new QWidget();
+    }
+
+    // Frees the previous viewport.
+    q->setViewport(viewport);
+
+    viewport->setBackgroundRole(QPalette::Base);
+    viewport->setCursor(Qt::IBeamCursor);
+    viewport->installEventFilter(q);
+
+    paintedCursorRect = QRect();
+    invalidateBlockAreas();
+    viewport->update();
+}
+
+// Sets the side margins so that the viewport keeps the width it had when
+// resizing began, given the new width of the editor.  If that width no
+// longer fits, the viewport takes up the whole width instead.
+//
+void MarkdownEditorPrivate::keepTextWidth(int width)
+{
+    Q_Q(MarkdownEditor);
+
+    QMargins margins = q->viewportMargins();
+    int frame = 2 * q->frameWidth();
+    int margin = qMax(0, (width - frame - liveResizeTextWidth) / 2);
+
+    if ((margins.left() != margin) || (margins.right() != margin)) {
+        q->setViewportMargins(margin, margins.top(), margin, margins.bottom());
+    }
+}
+
+// Returns the font size most recently zoomed to, which may not be applied
+// yet.
+//
+int MarkdownEditorPrivate::zoomedFontSize() const
+{
+    Q_Q(const MarkdownEditor);
+
+    return (pendingFontSize > 0) ? pendingFontSize : q->font().pointSize();
+}
+
+// Zooms to the given font size, applying it right away if no other zoom
+// happened recently, or else once zooming settles.
+//
+void MarkdownEditorPrivate::zoomTo(int fontSize)
+{
+    Q_Q(MarkdownEditor);
+
+    fontSize = qMax(1, fontSize);
+
+    if (zoomSettleTimer->isActive()) {
+        pendingFontSize = fontSize;
+    } else {
+        q->setFont(q->font().family(), fontSize);
+    }
+
+    zoomSettleTimer->start();
+    emit q->fontSizeChanged(fontSize);
+}
+
+// Returns the value of the vertical scroll bar that would center the text
+// cursor, without scrolling to it.
+//
+int MarkdownEditorPrivate::centeredScrollValue()
+{
+    Q_Q(MarkdownEditor);
+
+    QScrollBar *scrollBar = q->verticalScrollBar();
+    QSignalBlocker blocker(scrollBar);
+    int value = scrollBar->value();
+
+    q->centerCursor();
+
+    int centered = scrollBar->value();
+    scrollBar->setValue(value);
+
+    return centered;
+}
+
+// Scrolls part of the way to center the text cursor, for one frame of
+// scrolling.  The target is found anew every frame, so that it follows the
+// cursor as it keeps moving.  Distances longer than a page are jumped
+// rather than animated, since every line in between would be repainted.
+//
+void MarkdownEditorPrivate::stepScroll()
+{
+    Q_Q(MarkdownEditor);
+
+    QScrollBar *scrollBar = q->verticalScrollBar();
+    int distance = centeredScrollValue() - scrollBar->value();
+
+    if (0 == distance) {
+        scrollFrameTimer->stop();
+        return;
+    }
+
+    int step = distance;
+
+    if (qAbs(distance) <= scrollBar->pageStep()) {
+        step = distance / ScrollEasing;
+
+        if (0 == step) {
+            step = (distance > 0) ? 1 : -1;
+        }
+    }
+
+    scrollBar->setValue(scrollBar->value() + step);
+}
+
+// Unfolds the section of the given folded heading.  If the AST no longer
+// finds a section under the heading, such as after the heading was edited,
+// then only the hidden blocks right after the heading are shown.
+//
+void MarkdownEditorPrivate::unfoldSection(const QTextBlock &heading)
+{
+    int firstBlock;
+    int lastBlock;
+
+    if
+    (
+        !findSection(heading.blockNumber(), firstBlock, lastBlock)
+        || (firstBlock != heading.blockNumber())
+    ) {
+        lastBlock = heading.blockNumber();
+    }
+
+    setSectionFolded(heading.blockNumber(), lastBlock, false);
+}
+
+// Unfolds the sections that hide the given block.
+//
+void MarkdownEditorPrivate::revealBlock(const QTextBlock &block)
+{
+    QTextBlock heading = block.previous();
+
+    while (!block.isVisible() && heading.isValid()) {
+        TextBlockData *data = (TextBlockData *) heading.userData();
+
+        if ((nullptr != data) && data->folded && heading.isVisible()) {
+            unfoldSection(heading);
+        }
+
+        heading = heading.previous();
+    }
+}
+
+// Paints an ellipsis after the text of each visible heading whose section
+// is folded.
+//
+void MarkdownEditorPrivate::paintFoldMarkers(QPainter &painter)
+{
+    Q_Q(MarkdownEditor);
+
+    QPointF offset(q->contentOffset());
+    QTextBlock block = q->firstVisibleBlock();
+    int viewportHeight = q->viewport()->height();
+    QString marker = QString(" ") + QChar(0x2026);
+
+    painter.setPen(fadeColor.color());
+
+    while (block.isValid() && (offset.y() <= viewportHeight)) {
+        if (block.isVisible()) {
+            QRectF r = q->blockBoundingRect(block).translated(offset);
+            TextBlockData *data = (TextBlockData *) block.userData();
+            QTextLayout *layout = block.layout();
+
+            if ((nullptr != data) && data->folded && (layout->lineCount() > 0)) {
+                QTextLine line = layout->lineAt(layout->lineCount() - 1);
+                QRectF lineRect = line.naturalTextRect().translated(r.topLeft());
+
+                painter.setFont(layout->font());
+                painter.drawText
+                (
+                    QPointF(lineRect.right(), lineRect.top() + line.ascent()),
+                    marker
+                );
+            }
+
+            offset.ry() += r.height();
+        }
+
+        block = block.next();
+    }
+}
 } // namespace ghostwriter
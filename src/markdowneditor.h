@@ -29,6 +29,8 @@
 
 namespace ghostwriter
 {
+class LatencyMonitor;
+
 /**
  * Markdown editor having special shortcut key handing and live spell checking.
  */
@@ -49,6 +51,16 @@ public:
         QWidget *parent = 0
     );
 
+    /**
+     * Constructs a secondary view of the document of the given editor,
+     * such as for a split view.  The view shares the editor's highlighter,
+     * AST and spell checking rather than building its own, and only its
+     * visible blocks add to the blocks highlighted ahead of the others.
+     * The editor passes on its display and editing settings to the view,
+     * and destroys the view if it outlives the editor.
+     */
+    MarkdownEditor(MarkdownEditor *primary, QWidget *parent = 0);
+
     /**
      * Destructor.
      */
@@ -70,6 +82,13 @@ public:
      */
     Q_SLOT void setDictionary(const QString &language);
 
+    /**
+     * Sets the languages, besides the dictionary language, in which
+     * paragraphs may be written.  The language of each paragraph is
+     * detected when it is spell checked.
+     */
+    Q_SLOT void setAlternativeDictionaries(const QStringList &languages);
+
     /**
      * This editor has a preferred layout that is used to center the text
      * editing area in the parent widget, along with aesthetic margins
@@ -80,6 +99,26 @@ public:
      */
     QLayout *preferredLayout();
 
+    /**
+     * Returns the monitor measuring the time from key presses to the
+     * painting of the editor.  The monitor is owned by the editor.
+     */
+    LatencyMonitor *latencyMonitor() const;
+
+    /**
+     * Sets whether to save power, such as while the window is in the
+     * background.  The cursor stops blinking, and the timers that detect
+     * pauses in typing stop once the last pause has been signalled,
+     * until the text changes again.
+     */
+    void setPowerSavingEnabled(bool enabled);
+
+    /**
+     * Returns true if a large paste is still being inserted.  See
+     * insertFromMimeData().
+     */
+    bool isPasting() const;
+
     /**
      * Gets whether Hemingway mode is enabled.
      */
@@ -105,6 +144,13 @@ public:
      */
     void setColorScheme(const ColorScheme &colors);
 
+    /**
+     * Sets the editor color scheme while it is still being edited,
+     * rehighlighting only the visible blocks.  Call setColorScheme() with
+     * the final colors to rehighlight the rest of the document.
+     */
+    void previewColorScheme(const ColorScheme &colors);
+
     /**
      * Sets the font.
      */
@@ -124,11 +170,22 @@ public:
      * resizeEvent() method, but unfortunately it is not reliable and can
      * cause crashes with calls to setViewportMargins().
      *
+     * While the editor is being resized, it keeps the width of its text
+     * by itself, and sets up its margins once resizing settles, so that
+     * the document is laid out only once.  The parent need not call this
+     * method during a resize, but should call isResizing() to find out.
+     *
      * The parent window should also call this method after
      * calls to setEditorWidth().
      */
     void setupPaperMargins();
 
+    /**
+     * Returns whether the editor is in the midst of being resized, during
+     * which it keeps the width of its text.
+     */
+    bool isResizing() const;
+
 protected:
     void dragEnterEvent(QDragEnterEvent *e);
     void dragMoveEvent(QDragMoveEvent *e);
@@ -136,8 +193,25 @@ protected:
     void dropEvent(QDropEvent *e);
     void keyPressEvent(QKeyEvent *e);
     bool eventFilter(QObject *watched, QEvent *event);
+
+    /**
+     * Overridden to keep the width of the text while the editor is being
+     * resized.  The margins are set before QAbstractScrollArea lays out
+     * the viewport, rather than in resizeEvent().
+     */
+    bool event(QEvent *e);
+
     void wheelEvent(QWheelEvent *e);
 
+    /**
+     * Inserts pasted or dropped text.  Large amounts of text are inserted
+     * in chunks from the event loop, so that the editor repaints and the
+     * parse, highlighting and statistics catch up as it goes, rather than
+     * all at once before anything is shown.  The editor is read-only until
+     * the whole text is inserted, which is undone in one step.
+     */
+    void insertFromMimeData(const QMimeData *source);
+
 signals:
     /**
      * Notifies listeners that a heading was found in the document in the
@@ -164,8 +238,8 @@ signals:
 
     /**
      * Emitted when the user has stopped typing text.
-     * Time emited is scaled per document size up to 1000ms
-     * since last document update.
+     * Time emitted is scaled to the time taken to parse each edit, up to
+     * 1000ms since last document update.
      */
     void typingPausedScaled();
 
@@ -176,16 +250,12 @@ signals:
     void cursorPositionChanged(int position);
 
     /**
-     * Emitted when the user selects text.  The selected text, as
-     * well as the cursor position of the beginning and end of the
-     * selection in the document, are provided as parameters.
+     * Emitted when the user selects text.  The cursor position of the
+     * beginning and end of the selection in the document are provided as
+     * parameters.  The selected text itself is not, since copying it out
+     * of a large document is costly.
      */
-    void textSelected
-    (
-        const QString &selectedText,
-        int selectionStart,
-        int selectionEnd
-    );
+    void textSelected(int selectionStart, int selectionEnd);
 
     /**
      * Emitted when the user deselects text (i.e., no text is currently
@@ -199,6 +269,25 @@ signals:
      */
     void fontSizeChanged(int size);
 
+    /**
+     * Emitted when the editor scrolls.  The number of the line at the top
+     * of the editor is passed as a parameter, starting from 1, with its
+     * fraction giving how much of the line is scrolled out of view.
+     */
+    void scrolled(qreal lineNumber);
+
+    /**
+     * Emitted when a large paste starts, and as it progresses, with a
+     * description of its progress for the status bar.
+     */
+    void operationStarted(const QString &description);
+    void operationUpdate(const QString &description);
+
+    /**
+     * Emitted when a large paste has been inserted in full.
+     */
+    void operationFinished();
+
 public slots:
     /**
      * Sets the cursor position in the editor to the given position.
@@ -259,6 +348,12 @@ public slots:
      */
     void createTaskList();
 
+    /**
+     * Pads the cells of the pipe table at the cursor so that its columns
+     * line up.
+     */
+    void formatTable();
+
     /**
      * Formats current line or selected lines as a block quote.
      */
@@ -286,6 +381,20 @@ public slots:
      */
     bool toggleTaskComplete();
 
+    /**
+     * Folds the section under the heading at or before the text cursor,
+     * hiding its lines up to the next heading of the same or higher level,
+     * or unfolds the section if it is already folded.  Hidden lines are
+     * neither laid out, painted nor highlighted until they are unfolded.
+     * Moving the text cursor into a folded section unfolds it.
+     */
+    void toggleFold();
+
+    /**
+     * Unfolds every folded section.
+     */
+    void unfoldAll();
+
     /**
      * Sets whether large heading sizes are enabled.
      */
@@ -309,6 +418,31 @@ public slots:
      */
     void setBulletPointCyclingEnabled(bool enable);
 
+    /**
+     * Sets whether words used elsewhere in the document are offered for
+     * completion while typing.
+     */
+    void setWordCompletionEnabled(bool enable);
+
+    /**
+     * Sets whether the columns of pipe tables are kept aligned as their
+     * cells are typed in.
+     */
+    void setTableFormattingEnabled(bool enable);
+
+    /**
+     * Sets whether images dropped from outside of the document's folder
+     * are copied into an assets folder next to the document, rather than
+     * linked to where they are.
+     */
+    void setImageImportEnabled(bool enable);
+
+    /**
+     * Sets the width, in pixels, to which imported images are downscaled,
+     * or zero to import images at full size.
+     */
+    void setImageImportMaxWidth(int width);
+
     /**
      * Sets whether emphasized text is underlined or italicized.
      */
@@ -319,6 +453,19 @@ public slots:
      */
     void setItalicizeBlockquotes(bool enable);
 
+    /**
+     * Sets the length, in characters, above which lines are shown in the
+     * plain text format and are not spell checked.
+     */
+    void setLongLineThreshold(int characters);
+
+    /**
+     * Sets whether the editor is drawn with OpenGL rather than with the
+     * raster engine, which moves the work of scrolling and repainting to
+     * the graphics card on high resolution displays.
+     */
+    void setGpuViewportEnabled(bool enable);
+
     /**
      * Sets whether to insert spaces instead of tabs when a tab
      * character is inserted.  The number of spaces inserted is
@@ -352,6 +499,70 @@ public slots:
      */
     void setSpellCheckEnabled(const bool enabled);
 
+    /**
+     * Sets whether live spell checking is limited to the visible text.
+     */
+    void setSpellCheckVisibleOnly(const bool visibleOnly);
+
+    /**
+     * Sets whether the background spell check sweep of the text outside
+     * of the viewport is paused, such as while memory runs low.
+     */
+    void setBackgroundSweepPaused(const bool paused);
+
+    /**
+     * Rehighlights the given range of lines (inclusive), such as when the
+     * style warnings of the MarkdownLinter change for them.
+     */
+    void rehighlightLines(int firstLine, int lastLine);
+
+    /**
+     * Frees the memory held by caches that are rebuilt as needed, namely
+     * the highlighting cached for the blocks away from the viewport, the
+     * document's plain text snapshot, and the memory reserved by its AST.
+     * Call when memory runs low.
+     */
+    void releaseCaches();
+
+    /**
+     * Sets whether full parses of the document, which are needed whenever
+     * an edit can't be parsed incrementally, wait until the user pauses
+     * typing.  Use for large documents, for which each full parse copies
+     * and parses all of the text anew.
+     */
+    void setBackgroundParseDeferred(const bool deferred);
+
+    /**
+     * Sets whether full parses of the document also render it to HTML
+     * with the built-in cmark-gfm processor, publishing the result with
+     * MarkdownDocument::setRenderedHtml().  Enable this when the HTML
+     * preview uses cmark-gfm, so that it can share the parse rather than
+     * parse the document a second time.
+     */
+    void setHtmlRenderingEnabled(const bool enabled);
+
+    /**
+     * Stops parsing the document as its text changes, such as while a
+     * file is being loaded into it whose AST is cached on disk.  The
+     * document's AST is emptied until parsing resumes.
+     */
+    void suspendParsing();
+
+    /**
+     * Resumes parsing the document after suspendParsing().  The AST cached
+     * in the document's DocumentCache is published if it matches the
+     * text, or else the document is parsed in the background.
+     */
+    void resumeParsing();
+
+    /**
+     * Saves the AST of the document, with the statistics and misspellings
+     * of its blocks, to the document's DocumentCache, under the given key
+     * identifying the dictionaries in use.  Nothing is saved unless the
+     * document is unmodified and its AST is up to date.
+     */
+    void saveDocumentCache(const QString &spellingKey);
+
     /**
      * Increases the font size by 1 pt.
      */
@@ -364,17 +575,21 @@ public slots:
 
 protected slots:
     void suggestSpelling(QAction *action);
-    void onContentsChanged(int position, int charsAdded, int charsRemoved);
-    void onTextBlockRemoved(const QTextBlock &);
+    void onContentsChanged(int position, int charsRemoved, int charsAdded);
     void onSelectionChanged();
     void focusText();
-    void checkIfTypingPaused();
-    void checkIfTypingPausedScaled();
     void spellCheckFinished(int result);
     void onCursorPositionChanged();
 
 private:
     QScopedPointer<MarkdownEditorPrivate> d_ptr;
+
+    void initialize
+    (
+        MarkdownDocument *textDocument,
+        const ColorScheme &colors,
+        MarkdownEditor *primary
+    );
 };
 } // namespace ghostwriter
 
@@ -17,13 +17,18 @@
  *
  ***********************************************************************/
 
+#include <limits>
+
 #include <QBrush>
 #include <QColor>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFont>
 #include <QObject>
 #include <QPainter>
+#include <QPoint>
 #include <QRegularExpression>
+#include <QScrollBar>
 #include <QStaticText>
 #include <QString>
 #include <QSyntaxHighlighter>
@@ -31,19 +36,101 @@
 #include <QTextDocument>
 #include <QTextCursor>
 #include <QTextBlockFormat>
+#include <QTimer>
+#include <QMultiHash>
+#include <QPair>
+#include <QtConcurrentMap>
 #include <QStyle>
 #include <QApplication>
 #include <Qt>
 #include <QTextLayout>
 #include <QStack>
 
+#include "codelexer.h"
+#include "documentcache.h"
+#include "highlightprofiler.h"
 #include "markdownhighlighter.h"
 #include "markdownstates.h"
+#include "referenceindex.h"
+#include "spellcheckservice.h"
+#include "textblockdata.h"
 #include "spelling/dictionary_ref.h"
 #include "spelling/dictionary_manager.h"
+#include "tracer.h"
 
 namespace ghostwriter
 {
+// Input and output of the highlighting of a single block of text.  Holds
+// the formats of the block's characters in place of the QSyntaxHighlighter,
+// so that highlights can be computed for any block, on any thread.
+//
+class BlockHighlight
+{
+public:
+    BlockHighlight()
+        : line(0), previousState(MarkdownStateUnknown), state(MarkdownStateUnknown)
+    {
+        ;
+    }
+
+    BlockHighlight(const QString &text, int line, int previousState)
+        : text(text),
+          line(line),
+          previousState(previousState),
+          state(MarkdownStateUnknown),
+          formats(text.length())
+    {
+        ;
+    }
+
+    // Length of the block, including its trailing line separator, as with
+    // QTextBlock::length().
+    int length() const
+    {
+        return text.length() + 1;
+    }
+
+    QTextCharFormat format(int pos) const
+    {
+        if ((pos < 0) || (pos >= formats.size())) {
+            return QTextCharFormat();
+        }
+
+        return formats[pos];
+    }
+
+    // Same semantics as QSyntaxHighlighter::setFormat().
+    void setFormat(int start, int count, const QTextCharFormat &format)
+    {
+        if ((start < 0) || (start >= formats.size())) {
+            return;
+        }
+
+        int end = qMin(start + count, formats.size());
+
+        for (int i = start; i < end; i++) {
+            formats[i] = format;
+        }
+    }
+
+    void setFormat(int start, int count, const QColor &color)
+    {
+        QTextCharFormat format;
+        format.setForeground(color);
+        setFormat(start, count, format);
+    }
+
+    QString text;
+    int line;
+    int previousState;
+    int state;
+    QVector<QTextCharFormat> formats;
+
+    // Positions and lengths of the prose of the block, which is all that
+    // is spell checked.
+    QVector<QPair<int, int>> proseRanges;
+};
+
 class MarkdownHighlighterPrivate
 {
     Q_DISABLE_COPY(MarkdownHighlighterPrivate)
@@ -55,7 +142,10 @@ public:
         dictionary(DictionaryManager::instance().requestDictionary()),
         inBlockquote(false),
         spellCheckEnabled(false),
+        spellCheckVisibleOnly(false),
+        backgroundRehighlight(false),
         typingPaused(true),
+        sweepPaused(false),
         useUndlerlineForEmphasis(false)
     {
         ;
@@ -72,25 +162,157 @@ public:
     QTextBlock currentLine;
     QTextCharFormat defaultFormat;
     DictionaryRef dictionary;
+    QList<DictionaryRef> alternativeDictionaries;
     MarkdownEditor *editor;
+
+    // Secondary views of the document besides the editor's.
+    QList<MarkdownEditor *> views;
+
     QRegularExpression heading1SetextRegex;
     QRegularExpression heading2SetextRegex;
     bool inBlockquote;
     QRegularExpression referenceDefinitionRegex;
     QRegularExpression inlineHtmlCommentRegex;
     bool spellCheckEnabled;
+    bool spellCheckVisibleOnly;
+
+    // Whether the block being highlighted is rehighlighted in the
+    // background, rather than because it is visible or was edited.
+    bool backgroundRehighlight;
+
     bool typingPaused;
+
+    // Whether the spell check sweep is held off regardless of typing,
+    // such as while memory runs low.
+    bool sweepPaused;
+
     bool useLargeHeadings;
     bool useUndlerlineForEmphasis;
     bool italicizeBlockquotes;
 
-    bool isSetextHeadingState(const int state);
+    // Length above which lines are neither highlighted nor spell checked.
+    int longLineThreshold;
+
+    // Incremented whenever a setting that affects the formats of every
+    // block changes, invalidating the formats cached in the blocks'
+    // TextBlockData.
+    uint formatGeneration;
+
+    // Lines highlighted without the AST, while it is out of date for them.
+    int fallbackFirstLine;
+    int fallbackLastLine;
+
+    // Interned formats, so that all ranges formatted alike share the same
+    // QTextCharFormat data rather than each holding a copy.  Keyed by a
+    // hash of the formats' properties, and emptied along with the format
+    // caches whenever the settings change.  The spelling error formats are
+    // keyed likewise by the format of the misspelled text.
+    mutable QMultiHash<uint, QTextCharFormat> formatTable;
+    QMultiHash<uint, QPair<QTextCharFormat, QTextCharFormat>> spellingErrorFormats;
+
+    // Timing of the highlighting phases, when enabled, and the file that
+    // the report is written to when the highlighter is destroyed.
+    mutable HighlightProfiler profiler;
+    QString profilePath;
+
+    // Checks the spelling of blocks in the background.  The generation is
+    // incremented whenever the dictionary or its word lists change,
+    // invalidating the misspellings cached in the blocks' TextBlockData.
+    SpellCheckService *spellChecker;
+    uint spellingGeneration;
+
+    // State of the rehighlighting of the document in the background, as
+    // started by rehighlightLazily().  The cursors track the next block to
+    // highlight and the first block that was already highlighted with the
+    // viewport, so that they stay put as the document is edited.
+    QTimer *rehighlightTimer;
+    QTextCursor rehighlightCursor;
+    QTextCursor rehighlightStop;
+    bool rehighlightWrapped;
+
+    // Maximum amount of time, in milliseconds, to spend on each batch of
+    // blocks rehighlighted in the background.
+    static const int RehighlightBatchTime = 10;
+
+    // Number of blocks whose highlights are computed at once on the
+    // thread pool during a rehighlight of the whole document.
+    static const int ParallelBatchSize = 256;
+
+    // Sweep that queues the blocks outside of the viewport to be spell
+    // checked a few at a time, when only the visible blocks are checked
+    // right away.  The cursor tracks the next block to queue, and is null
+    // once the sweep is done.  The sweep is paused while the user types.
+    QTimer *spellCheckSweepTimer;
+    QTextCursor spellCheckSweepCursor;
+
+    // Number of blocks above and below the viewport that are checked along
+    // with the visible blocks, so that short scrolls show results at once.
+    static const int SpellCheckMargin = 50;
+
+    // Number of blocks queued by each step of the sweep, and the interval
+    // between steps in milliseconds.
+    static const int SpellCheckSweepBatchSize = 32;
+    static const int SpellCheckSweepInterval = 200;
+
+    void invalidateFormats();
+    uint formatHash(const QTextCharFormat &format) const;
+    QTextCharFormat internFormat(const QTextCharFormat &format) const;
+    QTextCharFormat spellingErrorFormat(const QTextCharFormat &format);
+    void applyLintWarnings(const TextBlockData *blockData);
+    void applyDifficultSentences(const TextBlockData *blockData);
+    QVector<QPair<QTextBlock, QTextBlock>> visibleRanges(int margin) const;
+    void onViewScrolled();
+    void rehighlightVisibleBlocks();
+    void checkVisibleBlocks();
+    void startSpellCheckSweep();
+    void sweepNextBatch();
+    void queueSpellCheck
+    (
+        const QTextBlock &block,
+        const QString &text,
+        TextBlockData *blockData,
+        bool urgent
+    );
+    void discardCachedMisspellings();
+    void rehighlightNextBatch();
+    void precomputeHighlights(QTextBlock block, int count);
+    bool isHighlightCurrent(QTextBlock &block) const;
+    TextBlockData *blockData(QTextBlock &block) const;
+    const MarkdownNode *nodeForLine(int line) const;
+    uint highlightKey
+    (
+        const QString &text,
+        const MarkdownNode *const node,
+        const TextBlockData *const blockData,
+        int line,
+        int previousState
+    ) const;
+    void computeHighlight(BlockHighlight &block, const MarkdownNode *const node) const;
+    void highlightWhitespace(BlockHighlight &block) const;
+    QVector<QTextLayout::FormatRange> formatRanges(const BlockHighlight &block) const;
     bool lineMatchesNode(const int line, const MarkdownNode *const node) const;
-    int columnInLine(const MarkdownNode *const node, const QString &lineText) const;
-    void applyFormattingForNode(const MarkdownNode *const node);
-    void highlightRefLinks(const int pos, const int length);
+    int columnInLine(const MarkdownNode *const node, const QString &lineText, int &offset) const;
+    QChar sourceChar(const QChar c) const;
+    void applyFormattingForNode(BlockHighlight &block, const MarkdownNode *const node) const;
+    void highlightRefLinks(BlockHighlight &block, const int pos, const int length) const;
+    int highlightCode
+    (
+        BlockHighlight &block,
+        const CodeLexer *lexer,
+        int start,
+        const QTextCharFormat &codeFormat,
+        int state
+    ) const;
+    void onDefinitionsChanged(const QStringList &labels);
     void setupHeadingFontSize(bool useLargeHeadings);
-    void spellCheck(const QString &text);
+    void spellCheck(const QString &text, TextBlockData *blockData);
+    void onBlockChecked
+    (
+        const QTextBlock &block,
+        const QString &text,
+        const QVector<SpellCheckService::Misspelling> &misspellings,
+        int dictionaryIndex
+    );
 };
 
 MarkdownHighlighter::MarkdownHighlighter
@@ -108,9 +330,65 @@ MarkdownHighlighter::MarkdownHighlighter
     d->typingPaused = true;
     d->useUndlerlineForEmphasis = false;
     d->italicizeBlockquotes = false;
+    d->longLineThreshold = std::numeric_limits<int>::max();
     d->inBlockquote = false;
+    d->formatGeneration = 0;
+    d->fallbackFirstLine = 0;
+    d->fallbackLastLine = 0;
+
+    QByteArray profilePath = qgetenv("GHOSTWRITER_HIGHLIGHT_PROFILE");
+
+    if (!profilePath.isEmpty()) {
+        d->profilePath = QString::fromLocal8Bit(profilePath);
+        d->profiler.setEnabled(true);
+    }
+
+    d->spellingGeneration = 0;
+    d->spellChecker = new SpellCheckService(d->dictionary, this);
+
+    this->connect
+    (
+        d->spellChecker,
+        &SpellCheckService::blockChecked,
+        [d](const QTextBlock &block,
+            const QString &text,
+            const QVector<SpellCheckService::Misspelling> &misspellings,
+            int dictionaryIndex) {
+            d->onBlockChecked(block, text, misspellings, dictionaryIndex);
+        }
+    );
+
+    this->connect
+    (
+        &DictionaryManager::instance(),
+        &DictionaryManager::changed,
+        this,
+        &MarkdownHighlighter::recheckSpelling
+    );
+
+    this->connect
+    (
+        &DictionaryManager::instance(),
+        &DictionaryManager::personalChanged,
+        this,
+        &MarkdownHighlighter::recheckWords
+    );
 
     setDocument(editor->document());
+
+    // Blocks whose references became resolved or broken are rehighlighted
+    // once the edit that changed the definitions is done.
+    this->connect
+    (
+        ((MarkdownDocument *) document())->referenceIndex(),
+        &ReferenceIndex::definitionsChanged,
+        this,
+        [d](const QStringList &labels) {
+            d->onDefinitionsChanged(labels);
+        },
+        Qt::QueuedConnection
+    );
+
     d->referenceDefinitionRegex.setPattern("^\\s*\\[(.+?)[^\\\\]\\]:");
     d->inlineHtmlCommentRegex.setPattern("^\\s*<\\!--.*-->\\s*$");
 
@@ -118,12 +396,48 @@ MarkdownHighlighter::MarkdownHighlighter
     connect(editor, SIGNAL(typingPausedScaled()), this, SLOT(onTypingPaused()));
     connect(editor, SIGNAL(cursorPositionChanged()), this, SLOT(onCursorPositionChanged()));
 
+    d->rehighlightWrapped = false;
+    d->rehighlightTimer = new QTimer(this);
+    d->rehighlightTimer->setInterval(0);
+
+    this->connect
+    (
+        d->rehighlightTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->rehighlightNextBatch();
+        }
+    );
+
+    d->spellCheckSweepTimer = new QTimer(this);
+    d->spellCheckSweepTimer->setInterval(MarkdownHighlighterPrivate::SpellCheckSweepInterval);
+
+    this->connect
+    (
+        d->spellCheckSweepTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->sweepNextBatch();
+        }
+    );
+
+    // Blocks that scroll into view while the document is being
+    // rehighlighted in the background jump the queue.
+    this->connect
+    (
+        editor->verticalScrollBar(),
+        &QScrollBar::valueChanged,
+        [d]() {
+            d->onViewScrolled();
+        }
+    );
+
     connect
     (
         this,
-        SIGNAL(highlightBlockAtPosition(int)),
+        SIGNAL(highlightLines(int, int)),
         this,
-        SLOT(onHighlightBlockAtPosition(int)),
+        SLOT(onHighlightLines(int, int)),
         Qt::QueuedConnection
     );
 
@@ -139,294 +453,1452 @@ MarkdownHighlighter::MarkdownHighlighter
 
 MarkdownHighlighter::~MarkdownHighlighter()
 {
-    ;
+    Q_D(MarkdownHighlighter);
+
+    if (!d->profilePath.isEmpty() && !d->profiler.dump(d->profilePath)) {
+        qWarning() << "Could not write highlighting profile to" << d->profilePath;
+    }
+}
+
+// Note:  Never set the QTextBlockFormat for a QTextBlock from within the
+// highlighter.  Depending on how the block format is modified, a recursive call
+// to the highlighter may be triggered, which will cause the application to
+// crash.
+//
+// Likewise, don't try to set the QTextBlockFormat outside the highlighter
+// (i.e., from within the text editor).  While the application will not crash,
+// the format change will be added to the undo stack.  Attempting to undo from
+// that point on will cause the undo stack to be virtually frozen, since undoing
+// the format operation causes the text to be considered changed, thus
+// triggering the slot that changes the text formatting to be triggered yet
+// again.
+//
+void MarkdownHighlighter::highlightBlock(const QString &text)
+{
+    Q_D(MarkdownHighlighter);
+    GW_TRACE_SCOPE("highlightBlock");
+
+    QTextBlock block = currentBlock();
+    int line = block.blockNumber() + 1;
+    const MarkdownNode *node = d->nodeForLine(line);
+    TextBlockData *blockData = d->blockData(block);
+    uint key;
+
+    {
+        HighlightProfiler::Scope scope(&d->profiler, HighlightProfiler::CacheKey);
+        key = d->highlightKey(text, node, blockData, line, previousBlockState());
+    }
+
+    if (!blockData->highlightCached || (key != blockData->highlightKey)) {
+        BlockHighlight highlight(text, line, previousBlockState());
+        d->computeHighlight(highlight, node);
+
+        blockData->highlightCached = true;
+        blockData->highlightKey = key;
+        blockData->highlightState = highlight.state;
+        blockData->highlightFormats = d->formatRanges(highlight);
+        blockData->proseRanges = highlight.proseRanges;
+    }
+
+    // Blocks hidden within folded sections are not laid out, so leave them
+    // unformatted and unchecked until they are shown again.  Their state is
+    // still set for the highlighting of the blocks that follow.
+    //
+    if (!block.isVisible()) {
+        setCurrentBlockState(blockData->highlightState);
+        blockData->highlightApplied = false;
+        return;
+    }
+
+    {
+        HighlightProfiler::Scope scope(&d->profiler, HighlightProfiler::ApplyFormats);
+
+        for (const QTextLayout::FormatRange &range : blockData->highlightFormats) {
+            setFormat(range.start, range.length, range.format);
+        }
+    }
+
+    if (!blockData->difficultSentences.isEmpty()) {
+        d->applyDifficultSentences(blockData);
+    }
+
+    if (!blockData->lintWarnings.isEmpty()) {
+        d->applyLintWarnings(blockData);
+    }
+
+    setCurrentBlockState(blockData->highlightState);
+    blockData->highlightApplied = true;
+
+    if (d->spellCheckEnabled) {
+        HighlightProfiler::Scope scope(&d->profiler, HighlightProfiler::SpellCheck);
+        d->spellCheck(text, blockData);
+    }
+}
+
+void MarkdownHighlighter::setDictionary(const DictionaryRef &dictionary)
+{
+    Q_D(MarkdownHighlighter);
+
+    d->dictionary = dictionary;
+    d->spellChecker->setDictionary(dictionary);
+    recheckSpelling();
+}
+
+void MarkdownHighlighter::setAlternativeDictionaries(const QList<DictionaryRef> &dictionaries)
+{
+    Q_D(MarkdownHighlighter);
+
+    d->alternativeDictionaries = dictionaries;
+    d->spellChecker->setAlternativeDictionaries(dictionaries);
+    recheckSpelling();
+}
+
+DictionaryRef MarkdownHighlighter::dictionary(const QTextBlock &block) const
+{
+    Q_D(const MarkdownHighlighter);
+
+    TextBlockData *blockData = (TextBlockData *) block.userData();
+
+    if
+    (
+        (nullptr != blockData)
+        && (blockData->spellingDictionary > 0)
+        && (blockData->spellingDictionary <= d->alternativeDictionaries.size())
+    ) {
+        return d->alternativeDictionaries.at(blockData->spellingDictionary - 1);
+    }
+
+    return d->dictionary;
+}
+
+void MarkdownHighlighter::recheckSpelling()
+{
+    Q_D(MarkdownHighlighter);
+
+    d->spellingGeneration++;
+    d->spellChecker->clear();
+    d->discardCachedMisspellings();
+
+    if (d->spellCheckEnabled) {
+        rehighlightLazily();
+        d->startSpellCheckSweep();
+    }
+}
+
+void MarkdownHighlighter::recheckWords(const QStringList &words)
+{
+    Q_D(MarkdownHighlighter);
+
+    if ((nullptr == document()) || words.isEmpty()) {
+        return;
+    }
+
+    d->discardCachedMisspellings();
+
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        TextBlockData *blockData = (TextBlockData *) block.userData();
+
+        if ((nullptr == blockData) || !blockData->spellingChecked) {
+            continue;
+        }
+
+        QString text = block.text();
+        bool affected = false;
+
+        // Match case insensitively, since the dictionary also accepts
+        // capitalized forms of the words.
+        for (const QString &word : words) {
+            if (text.contains(word, Qt::CaseInsensitive)) {
+                affected = true;
+                break;
+            }
+        }
+
+        if (!affected) {
+            continue;
+        }
+
+        // Mark the results as stale, but keep showing them until the block
+        // is checked again to avoid flicker.  Queue the block even if it
+        // is already queued, since that check may have started with the
+        // old words.
+        //
+        blockData->spellingGeneration = d->spellingGeneration - 1;
+        blockData->spellCheckQueued = false;
+
+        if (d->spellCheckEnabled) {
+            d->queueSpellCheck(block, text, blockData, false);
+        }
+    }
+}
+
+bool MarkdownHighlighter::misspellings
+(
+    const QTextBlock &block,
+    QVector<QPair<int, int>> &misspellings
+) const
+{
+    Q_D(const MarkdownHighlighter);
+
+    if (!block.isValid() || (block.document() != document())) {
+        return false;
+    }
+
+    TextBlockData *blockData = (TextBlockData *) block.userData();
+
+    if
+    (
+        (nullptr == blockData)
+        || !blockData->spellingChecked
+        || (d->spellingGeneration != blockData->spellingGeneration)
+        || (qHash(block.text()) != blockData->spellingTextHash)
+    ) {
+        return false;
+    }
+
+    misspellings = blockData->misspellings;
+    return true;
+}
+
+uint MarkdownHighlighter::spellingGeneration() const
+{
+    Q_D(const MarkdownHighlighter);
+
+    return d->spellingGeneration;
+}
+
+void MarkdownHighlighter::increaseFontSize()
+{
+    Q_D(MarkdownHighlighter);
+
+    d->defaultFormat.setFontPointSize(d->defaultFormat.fontPointSize() + 1.0);
+    d->invalidateFormats();
+    rehighlightLazily();
+}
+
+void MarkdownHighlighter::previewColorScheme(const ColorScheme &colors)
+{
+    Q_D(MarkdownHighlighter);
+
+    d->colors = colors;
+    d->defaultFormat.setForeground(QBrush(colors.foreground));
+    d->invalidateFormats();
+    d->rehighlightTimer->stop();
+
+    if (nullptr != document()) {
+        d->rehighlightVisibleBlocks();
+    }
+}
+
+void MarkdownHighlighter::decreaseFontSize()
+{
+    Q_D(MarkdownHighlighter);
+    
+    d->defaultFormat.setFontPointSize(d->defaultFormat.fontPointSize() - 1.0);
+    d->invalidateFormats();
+    rehighlightLazily();
+}
+
+void MarkdownHighlighter::setColorScheme(const ColorScheme &colors)
+{
+    Q_D(MarkdownHighlighter);
+    
+    d->colors = colors;
+    d->defaultFormat.setForeground(QBrush(colors.foreground));
+    d->invalidateFormats();
+    rehighlightLazily();
+}
+
+void MarkdownHighlighter::setEnableLargeHeadingSizes(const bool enable)
+{
+    Q_D(MarkdownHighlighter);
+    
+    d->useLargeHeadings = enable;
+    d->invalidateFormats();
+    rehighlightLazily();
+}
+
+void MarkdownHighlighter::setUseUnderlineForEmphasis(const bool enable)
+{
+    Q_D(MarkdownHighlighter);
+    
+    d->useUndlerlineForEmphasis = enable;
+    d->invalidateFormats();
+    rehighlightLazily();
+}
+
+void MarkdownHighlighter::setItalicizeBlockquotes(const bool enable)
+{
+    Q_D(MarkdownHighlighter);
+    
+    d->italicizeBlockquotes = enable;
+    d->invalidateFormats();
+    rehighlightLazily();
+}
+
+void MarkdownHighlighter::setLongLineThreshold(int characters)
+{
+    Q_D(MarkdownHighlighter);
+
+    if (characters == d->longLineThreshold) {
+        return;
+    }
+
+    d->longLineThreshold = characters;
+    d->invalidateFormats();
+    rehighlightLazily();
+}
+
+void MarkdownHighlighter::setFont(const QString &fontFamily, const double fontSize)
+{
+    Q_D(MarkdownHighlighter);
+    
+    QFont font;
+    font.setFamily(fontFamily);
+    font.setWeight(QFont::Normal);
+    font.setItalic(false);
+    font.setPointSizeF(fontSize);
+    d->defaultFormat.setFont(font);
+
+    d->invalidateFormats();
+    rehighlightLazily();
+}
+
+void MarkdownHighlighter::setSpellCheckEnabled(const bool enabled)
+{
+    Q_D(MarkdownHighlighter);
+    
+    d->spellCheckEnabled = enabled;
+    rehighlightLazily();
+    d->startSpellCheckSweep();
+}
+
+void MarkdownHighlighter::setSpellCheckVisibleOnly(const bool visibleOnly)
+{
+    Q_D(MarkdownHighlighter);
+
+    if (visibleOnly == d->spellCheckVisibleOnly) {
+        return;
+    }
+
+    d->spellCheckVisibleOnly = visibleOnly;
+
+    // Queue the blocks that were skipped for checking.
+    if (!visibleOnly && d->spellCheckEnabled) {
+        rehighlightLazily();
+    }
+
+    d->startSpellCheckSweep();
+}
+
+void MarkdownHighlighter::rehighlightLazily()
+{
+    Q_D(MarkdownHighlighter);
+
+    if (nullptr == document()) {
+        return;
+    }
+
+    d->rehighlightVisibleBlocks();
+
+    // Queue the rest of the document, starting with the blocks below the
+    // viewport and wrapping around to the blocks above it.
+    QTextBlock first = d->editor->cursorForPosition(QPoint(0, 0)).block();
+    QTextBlock last = d->editor->cursorForPosition(QPoint(0, d->editor->viewport()->height())).block();
+    QTextBlock next = last.next();
+
+    d->rehighlightCursor = QTextCursor(document());
+    d->rehighlightStop = QTextCursor(document());
+    d->rehighlightStop.setPosition(first.position());
+    d->rehighlightWrapped = !next.isValid();
+
+    if (next.isValid()) {
+        d->rehighlightCursor.setPosition(next.position());
+    }
+
+    d->rehighlightTimer->start();
+}
+
+void MarkdownHighlighter::setProfilingEnabled(bool enabled)
+{
+    Q_D(MarkdownHighlighter);
+
+    d->profiler.setEnabled(enabled);
+}
+
+QString MarkdownHighlighter::profilingReport() const
+{
+    Q_D(const MarkdownHighlighter);
+
+    return d->profiler.report();
+}
+
+bool MarkdownHighlighter::dumpProfilingReport(const QString &filePath) const
+{
+    Q_D(const MarkdownHighlighter);
+
+    return d->profiler.dump(filePath);
+}
+
+void MarkdownHighlighter::setBackgroundSweepPaused(bool paused)
+{
+    Q_D(MarkdownHighlighter);
+
+    d->sweepPaused = paused;
+
+    if (paused) {
+        d->spellCheckSweepTimer->stop();
+    } else if (d->typingPaused && !d->spellCheckSweepCursor.isNull()) {
+        d->spellCheckSweepTimer->start();
+    }
+}
+
+void MarkdownHighlighter::releaseCaches()
+{
+    Q_D(MarkdownHighlighter);
+
+    if (nullptr == document()) {
+        return;
+    }
+
+    QVector<QPair<QTextBlock, QTextBlock>> ranges =
+        d->visibleRanges(MarkdownHighlighterPrivate::SpellCheckMargin);
+    int number = 0;
+
+    // The formats already applied to the blocks stay in their layouts, so
+    // only the copies cached for reuse are freed.  Blocks whose formats
+    // are freed are simply highlighted from scratch the next time.
+    for
+    (
+        QTextBlock block = document()->begin();
+        block.isValid();
+        block = block.next(), number++
+    ) {
+        bool nearView = false;
+
+        for (const QPair<QTextBlock, QTextBlock> &range : ranges) {
+            if
+            (
+                (number >= range.first.blockNumber())
+                && (number <= range.second.blockNumber())
+            ) {
+                nearView = true;
+                break;
+            }
+        }
+
+        if (nearView) {
+            continue;
+        }
+
+        TextBlockData *blockData = (TextBlockData *) block.userData();
+
+        if ((nullptr != blockData) && blockData->highlightCached) {
+            blockData->highlightCached = false;
+            blockData->highlightFormats = QVector<QTextLayout::FormatRange>();
+            blockData->proseRanges = QVector<QPair<int, int>>();
+        }
+    }
+}
+
+void MarkdownHighlighter::addView(MarkdownEditor *view)
+{
+    Q_D(MarkdownHighlighter);
+
+    d->views.append(view);
+
+    this->connect
+    (
+        view->verticalScrollBar(),
+        &QScrollBar::valueChanged,
+        this,
+        [d]() {
+            d->onViewScrolled();
+        }
+    );
+    this->connect
+    (
+        view,
+        &QObject::destroyed,
+        this,
+        [d, view]() {
+            d->views.removeAll(view);
+        }
+    );
+}
+
+void MarkdownHighlighter::onTypingResumed()
+{
+    Q_D(MarkdownHighlighter);
+    
+    d->typingPaused = false;
+    d->spellCheckSweepTimer->stop();
+}
+
+void MarkdownHighlighter::onTypingPaused()
+{
+    Q_D(MarkdownHighlighter);
+    
+    d->typingPaused = true;
+
+    if (d->spellCheckEnabled) {
+        QTextBlock block = document()->findBlock(d->editor->textCursor().position());
+        rehighlightBlock(block);
+    }
+
+    if (!d->spellCheckSweepCursor.isNull() && !d->sweepPaused) {
+        d->spellCheckSweepTimer->start();
+    }
+}
+
+void MarkdownHighlighter::onCursorPositionChanged()
+{
+    Q_D(MarkdownHighlighter);
+    
+    if
+    (
+        d->spellCheckEnabled &&
+        (d->currentLine != d->editor->textCursor().block())
+    ) {
+        rehighlightBlock(d->currentLine);
+    }
+
+    d->currentLine = d->editor->textCursor().block();
+}
+
+void MarkdownHighlighter::rehighlightLines(int firstLine, int lastLine)
+{
+    emit highlightLines(firstLine, lastLine);
+}
+
+void MarkdownHighlighter::setFallbackLines(int firstLine, int lastLine)
+{
+    Q_D(MarkdownHighlighter);
+
+    if ((firstLine == d->fallbackFirstLine) && (lastLine == d->fallbackLastLine)) {
+        return;
+    }
+
+    if (d->fallbackFirstLine > 0) {
+        rehighlightLines(d->fallbackFirstLine, d->fallbackLastLine);
+    }
+
+    d->fallbackFirstLine = firstLine;
+    d->fallbackLastLine = lastLine;
+
+    if (firstLine > 0) {
+        rehighlightLines(firstLine, lastLine);
+    }
+}
+
+void MarkdownHighlighter::onHighlightLines(int firstLine, int lastLine)
+{
+    Q_D(MarkdownHighlighter);
+
+    QTextBlock block = document()->findBlockByNumber(firstLine - 1);
+
+    for (int line = firstLine; block.isValid() && (line <= lastLine); line++) {
+        if (!d->isHighlightCurrent(block)) {
+            rehighlightBlock(block);
+        }
+
+        block = block.next();
+    }
+}
+
+// Returns the first and last blocks visible in the editor and in each of
+// the secondary views, widened by the given number of blocks above and
+// below each viewport.
+//
+QVector<QPair<QTextBlock, QTextBlock>> MarkdownHighlighterPrivate::visibleRanges(int margin) const
+{
+    QVector<QPair<QTextBlock, QTextBlock>> ranges;
+    QList<MarkdownEditor *> allViews = views;
+
+    allViews.prepend(editor);
+
+    for (const MarkdownEditor *view : allViews) {
+        QTextBlock first = view->cursorForPosition(QPoint(0, 0)).block();
+        QTextBlock last = view->cursorForPosition(QPoint(0, view->viewport()->height())).block();
+
+        for (int i = 0; (i < margin) && first.previous().isValid(); i++) {
+            first = first.previous();
+        }
+
+        for (int i = 0; (i < margin) && last.next().isValid(); i++) {
+            last = last.next();
+        }
+
+        ranges.append(QPair<QTextBlock, QTextBlock>(first, last));
+    }
+
+    return ranges;
+}
+
+void MarkdownHighlighterPrivate::onViewScrolled()
+{
+    if (rehighlightTimer->isActive()) {
+        rehighlightVisibleBlocks();
+    } else if (spellCheckEnabled && spellCheckVisibleOnly) {
+        checkVisibleBlocks();
+    }
+}
+
+void MarkdownHighlighterPrivate::rehighlightVisibleBlocks()
+{
+    Q_Q(MarkdownHighlighter);
+
+    for (const QPair<QTextBlock, QTextBlock> &range : visibleRanges(0)) {
+        QTextBlock block = range.first;
+        QTextBlock last = range.second;
+
+        precomputeHighlights(block, last.blockNumber() - block.blockNumber() + 1);
+
+        while (block.isValid()) {
+            q->rehighlightBlock(block);
+
+            if (block == last) {
+                break;
+            }
+
+            block = block.next();
+        }
+    }
+}
+
+void MarkdownHighlighterPrivate::rehighlightNextBatch()
+{
+    Q_Q(MarkdownHighlighter);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    int stopBlockNumber = rehighlightStop.block().blockNumber();
+    int count = ParallelBatchSize;
+
+    if (rehighlightWrapped) {
+        count = qMin(count, stopBlockNumber - rehighlightCursor.block().blockNumber());
+    }
+
+    precomputeHighlights(rehighlightCursor.block(), count);
+
+    while (elapsed.elapsed() < RehighlightBatchTime) {
+        QTextBlock block = rehighlightCursor.block();
+
+        if
+        (
+            !block.isValid()
+            || (rehighlightWrapped && (block.blockNumber() >= stopBlockNumber))
+        ) {
+            rehighlightTimer->stop();
+            return;
+        }
+
+        backgroundRehighlight = true;
+        q->rehighlightBlock(block);
+        backgroundRehighlight = false;
+
+        QTextBlock next = block.next();
+
+        if (!next.isValid()) {
+            if (rehighlightWrapped) {
+                rehighlightTimer->stop();
+                return;
+            }
+
+            rehighlightWrapped = true;
+            next = q->document()->firstBlock();
+        }
+
+        rehighlightCursor.setPosition(next.position());
+    }
+}
+
+// Combines the given value into the given hash seed.
+//
+// Returns the state in which the given block state left the lexer of the
+// code of a fenced code block.
+//
+static inline int codeLexerState(int blockState)
+{
+    if
+    (
+        (MarkdownStateUnknown == blockState)
+        || (MarkdownStateCodeBlock != (MarkdownStateCodeBlock & blockState))
+    ) {
+        return CodeLexer::InitialState;
+    }
+
+    return (blockState & MarkdownStateCodeLexerMask) >> MarkdownStateCodeLexerShift;
+}
+
+static inline uint combineHash(uint seed, uint value)
+{
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+// Computes the highlights of the given number of blocks, starting with the
+// given block, on the thread pool, and caches them in the blocks'
+// TextBlockData so that rehighlighting the blocks merely applies them.  The
+// AST and the highlighter's settings are only read while this method blocks,
+// so the computation does not need to lock them.
+//
+void MarkdownHighlighterPrivate::precomputeHighlights(QTextBlock block, int count)
+{
+    struct Job
+    {
+        BlockHighlight highlight;
+        const MarkdownNode *node;
+        TextBlockData *blockData;
+        uint key;
+    };
+
+    QVector<Job> jobs;
+
+    for (int i = 0; block.isValid() && (i < count); i++) {
+        int line = block.blockNumber() + 1;
+        QString text = block.text();
+
+        // The previous block's state is that of its last highlight, which
+        // usually does not change.  If it does, the key will not match when
+        // this block is rehighlighted, and its highlight is recomputed then.
+        int previousState = block.previous().isValid()
+            ? block.previous().userState()
+            : MarkdownStateUnknown;
+
+        Job job;
+        job.node = nodeForLine(line);
+        job.blockData = blockData(block);
+
+        {
+            HighlightProfiler::Scope scope(&profiler, HighlightProfiler::CacheKey);
+            job.key = highlightKey(text, job.node, job.blockData, line, previousState);
+        }
+
+        if (!job.blockData->highlightCached || (job.key != job.blockData->highlightKey)) {
+            job.highlight = BlockHighlight(text, line, previousState);
+            jobs.append(job);
+        }
+
+        block = block.next();
+    }
+
+    if (jobs.size() > 1) {
+        QtConcurrent::blockingMap
+        (
+            jobs,
+            [this](Job &job) {
+                computeHighlight(job.highlight, job.node);
+            }
+        );
+    } else if (1 == jobs.size()) {
+        computeHighlight(jobs[0].highlight, jobs[0].node);
+    }
+
+    for (const Job &job : jobs) {
+        job.blockData->highlightCached = true;
+        job.blockData->highlightKey = job.key;
+        job.blockData->highlightState = job.highlight.state;
+        job.blockData->highlightFormats = formatRanges(job.highlight);
+        job.blockData->proseRanges = job.highlight.proseRanges;
+        job.blockData->highlightApplied = false;
+    }
+}
+
+// Returns whether the highlight applied to the given block is still the
+// one that would be computed for it, in which case rehighlighting the block
+// would neither change its formats nor its state.
+//
+bool MarkdownHighlighterPrivate::isHighlightCurrent(QTextBlock &block) const
+{
+    TextBlockData *data = blockData(block);
+    int line = block.blockNumber() + 1;
+    int previousState = block.previous().isValid()
+        ? block.previous().userState()
+        : MarkdownStateUnknown;
+
+    if
+    (
+        !data->highlightCached
+        || !data->highlightApplied
+        || (block.userState() != data->highlightState)
+    ) {
+        return false;
+    }
+
+    HighlightProfiler::Scope scope(&profiler, HighlightProfiler::CacheKey);
+
+    return data->highlightKey
+        == highlightKey(block.text(), nodeForLine(line), data, line, previousState);
+}
+
+// Returns the TextBlockData of the given block, creating it if needed.
+//
+TextBlockData *MarkdownHighlighterPrivate::blockData(QTextBlock &block) const
+{
+    Q_Q(const MarkdownHighlighter);
+
+    TextBlockData *data = (TextBlockData *) block.userData();
+
+    if (nullptr == data) {
+        data = new TextBlockData((MarkdownDocument *) q->document(), block);
+        block.setUserData(data);
+    }
+
+    return data;
+}
+
+// Returns the block node of the AST to highlight the given line with, or
+// null if there is none.
+//
+const MarkdownNode *MarkdownHighlighterPrivate::nodeForLine(int line) const
+{
+    Q_Q(const MarkdownHighlighter);
+
+    HighlightProfiler::Scope scope(&profiler, HighlightProfiler::FindBlock);
+
+    MarkdownAST *ast = ((MarkdownDocument *) q->document())->markdownAST();
+
+    if ((nullptr == ast) || ((line >= fallbackFirstLine) && (line <= fallbackLastLine))) {
+        return nullptr;
+    }
+
+    MarkdownNode *node = ast->findBlockAtLine(line);
+
+    if ((nullptr != node) && (MarkdownNode::Invalid == node->type())) {
+        return nullptr;
+    }
+
+    return node;
+}
+
+// Returns a hash of everything that the highlight computed by
+// computeHighlight() for a block depends on:  the block's text, the
+// previous block's state, the highlighter's settings, whether the labels
+// that the block refers to are defined, and the parts of the AST that are
+// formatted on the block's line.  Nodes of the AST that lie on other lines
+// only contribute their type, as that is all that is consulted of them
+// when locating nodes within the line.
+//
+uint MarkdownHighlighterPrivate::highlightKey
+(
+    const QString &text,
+    const MarkdownNode *const node,
+    const TextBlockData *const blockData,
+    int line,
+    int previousState
+) const
+{
+    Q_Q(const MarkdownHighlighter);
+
+    uint key = qHash(text, formatGeneration);
+
+    if (!blockData->referencedLabels.isEmpty()) {
+        const ReferenceIndex *index =
+            ((MarkdownDocument *) q->document())->referenceIndex();
+        uint resolved = 0;
+
+        for (int i = 0; i < blockData->referencedLabels.size(); i++) {
+            if (index->isDefined(blockData->referencedLabels[i])) {
+                resolved = combineHash(resolved, uint(i + 1));
+            }
+        }
+
+        key = combineHash(key, resolved);
+    }
+
+    // Only blocks outside of the AST carry the previous block's state
+    // forward.  Leaving it out of the key otherwise lets the blocks that
+    // follow a block whose state changed reuse their highlights, which
+    // stops the cascade of rehighlights there.
+    //
+    if (nullptr == node) {
+        key = combineHash(key, uint(previousState));
+        return combineHash(key, uint(MarkdownNode::Invalid));
+    }
+
+    key = combineHash(key, node->isInsideBlockquote() ? 1 : 0);
+
+    // Do a pre-order traversal of the nodes, as in applyFormattingForNode().
+    const MarkdownNode *current = node;
+
+    while (nullptr != current) {
+        key = combineHash(key, uint(current->type()));
+
+        if (lineMatchesNode(line, current)) {
+            key = combineHash(key, uint(current->position()));
+            key = combineHash(key, uint(current->length()));
+            key = combineHash(key, uint(current->startLine() - line));
+            key = combineHash(key, uint((0 == current->endLine()) ? -1 : current->endLine() - line));
+            key = combineHash(key, uint(current->headingLevel()));
+            key = combineHash
+                  (
+                      key,
+                      (current->isSetextHeading() ? 1 : 0)
+                      | (current->isFencedCodeBlock() ? 2 : 0)
+                      | (current->isNumberedListItem() ? 4 : 0)
+                  );
+
+            if (current->isInlineType() && !current->textRef().isEmpty()) {
+                key = combineHash(key, uint(current->textRef().length()));
+                key = combineHash(key, current->textRef().at(0).unicode());
+            }
+
+            // The code of fenced code blocks is lexed according to its
+            // language, picking up where the previous line left off.
+            if (current->isFencedCodeBlock()) {
+                key = combineHash(key, qHash(current->textRef()));
+
+                if (line > current->startLine()) {
+                    key = combineHash(key, uint(codeLexerState(previousState)));
+                }
+            }
+        }
+
+        if ((nullptr != current->firstChild()) && !current->firstChild()->isInvalid()) {
+            current = current->firstChild();
+        } else {
+            while ((current != node) && (nullptr == current->next())) {
+                current = current->parent();
+            }
+
+            current = (current == node) ? nullptr : current->next();
+        }
+    }
+
+    return key;
+}
+
+// Computes the formats and the state of the given block according to its
+// Markdown structure, without regard to spelling.  The result depends only
+// on the block, the given node and the highlighter's settings, so this
+// method may be called from any thread as long as neither the AST nor the
+// settings change in the meantime.
+//
+void MarkdownHighlighterPrivate::computeHighlight
+(
+    BlockHighlight &block,
+    const MarkdownNode *const node
+) const
+{
+    HighlightProfiler::Scope scope(&profiler, HighlightProfiler::ComputeFormats);
+    HighlightProfiler::Scope nodeScope
+    (
+        &profiler,
+        (nullptr != node) ? node->type() : MarkdownNode::Invalid
+    );
+
+    const QString &text = block.text;
+
+    // Lines too long to highlight, such as embedded data or minified code,
+    // get a single format, so that their layout stays cheap.
+    if (text.length() > longLineThreshold) {
+        block.setFormat(0, block.length(), colors.foreground);
+
+        if (block.previousState != MarkdownStateUnknown) {
+            block.state = block.previousState;
+        } else {
+            block.state = MarkdownStateParagraph;
+        }
+
+        return;
+    }
+
+    if (nullptr != node) {
+        applyFormattingForNode(block, node);
+    } else {
+        block.setFormat(0, block.length(), colors.foreground);
+
+        if (text.trimmed().isEmpty()) {
+            block.state = MarkdownStateParagraphBreak;
+        } else if (referenceDefinitionRegex.match(text).hasMatch()) {
+            QTextCharFormat format = defaultFormat;
+            format.setForeground(colors.link);
+
+            block.setFormat(0, text.indexOf(':'), format);
+            block.state = MarkdownStateParagraph;
+        } else if (inlineHtmlCommentRegex.match(text).hasMatch()) {
+            QTextCharFormat format = defaultFormat;
+            format.setForeground(colors.inlineHtml);
+            block.setFormat(0, text.length(), format);
+
+            if (block.previousState != MarkdownStateUnknown) {
+                block.state = block.previousState;
+            } else {
+                block.state = MarkdownStateParagraph;
+            }
+        } else {
+            // Lines that are not parsed yet are taken to be prose.
+            block.proseRanges.append(qMakePair(0, text.length()));
+        }
+    }
+
+    highlightWhitespace(block);
+}
+
+// Makes whitespace transparent (so that any text decoration is not drawn
+// over it), and highlights the last two spaces of the line to indicate
+// line breaks.
+//
+void MarkdownHighlighterPrivate::highlightWhitespace(BlockHighlight &block) const
+{
+    const QString &text = block.text;
+    int i = 0;
+
+    while (i < text.length()) {
+        if (!text[i].isSpace()) {
+            i++;
+            continue;
+        }
+
+        int start = i;
+
+        while ((i < text.length()) && text[i].isSpace()) {
+            i++;
+        }
+
+        QTextCharFormat format = block.format(start);
+        format.setForeground(Qt::transparent);
+        block.setFormat(start, i - start, format);
+    }
+
+    if (text.endsWith("  ")) {
+        QTextCharFormat format = block.format(text.length() - 2);
+        format.setForeground(colors.listMarkup);
+        block.setFormat(text.length() - 2, 2, format);
+    }
+}
+
+// Drops the formats computed with the previous settings.
+//
+void MarkdownHighlighterPrivate::invalidateFormats()
+{
+    formatGeneration++;
+    formatTable.clear();
+    spellingErrorFormats.clear();
+}
+
+// Returns a hash of the properties of the given format that the highlighter
+// sets, for looking up formats in the interning tables.  Formats with equal
+// properties have equal hashes.
+//
+uint MarkdownHighlighterPrivate::formatHash(const QTextCharFormat &format) const
+{
+    uint hash = format.foreground().color().rgba();
+    hash = combineHash(hash, uint(format.fontWeight()));
+    hash = combineHash(hash, qHash(format.fontPointSize()));
+    hash = combineHash
+           (
+               hash,
+               (format.fontItalic() ? 1 : 0)
+               | (format.fontUnderline() ? 2 : 0)
+               | (format.fontStrikeOut() ? 4 : 0)
+           );
+    hash = combineHash(hash, uint(format.underlineStyle()));
+
+    return hash;
+}
+
+// Returns the interned copy of the given format, which shares its data with
+// all the other formats equal to it.
+//
+QTextCharFormat MarkdownHighlighterPrivate::internFormat(const QTextCharFormat &format) const
+{
+    uint hash = formatHash(format);
+
+    QMultiHash<uint, QTextCharFormat>::const_iterator iter = formatTable.constFind(hash);
+
+    while ((formatTable.constEnd() != iter) && (hash == iter.key())) {
+        if (iter.value() == format) {
+            return iter.value();
+        }
+
+        ++iter;
+    }
+
+    formatTable.insert(hash, format);
+    return format;
+}
+
+// Returns the format with which to underline a misspelled word that is
+// otherwise formatted with the given format.
+//
+QTextCharFormat MarkdownHighlighterPrivate::spellingErrorFormat(const QTextCharFormat &format)
+{
+    uint hash = formatHash(format);
+
+    QMultiHash<uint, QPair<QTextCharFormat, QTextCharFormat>>::const_iterator iter =
+        spellingErrorFormats.constFind(hash);
+
+    while ((spellingErrorFormats.constEnd() != iter) && (hash == iter.key())) {
+        if (iter.value().first == format) {
+            return iter.value().second;
+        }
+
+        ++iter;
+    }
+
+    QTextCharFormat errorFormat = format;
+    errorFormat.setUnderlineColor(colors.error);
+    errorFormat.setUnderlineStyle
+    (
+        (QTextCharFormat::UnderlineStyle)
+        QApplication::style()->styleHint
+        (
+            QStyle::SH_SpellCheckUnderlineStyle
+        )
+    );
+
+    spellingErrorFormats.insert(hash, qMakePair(format, errorFormat));
+    return errorFormat;
+}
+
+// Underlines the text of the current block that violates the house style,
+// as found by the MarkdownLinter, with a dotted line in the error color.
+//
+void MarkdownHighlighterPrivate::applyLintWarnings(const TextBlockData *blockData)
+{
+    Q_Q(MarkdownHighlighter);
+
+    for (const MarkdownLinter::Warning &warning : blockData->lintWarnings) {
+        int pos = warning.position;
+        int end = qMin(pos + warning.length, q->currentBlock().length() - 1);
+
+        // Keep the formats of the underlined text, such as its emphasis.
+        while (pos < end) {
+            QTextCharFormat format = q->format(pos);
+            int next = pos + 1;
+
+            while ((next < end) && (q->format(next) == format)) {
+                next++;
+            }
+
+            format.setUnderlineColor(colors.error);
+            format.setUnderlineStyle(QTextCharFormat::DotLine);
+            q->setFormat(pos, next - pos, format);
+            pos = next;
+        }
+    }
 }
 
-// Note:  Never set the QTextBlockFormat for a QTextBlock from within the
-// highlighter.  Depending on how the block format is modified, a recursive call
-// to the highlighter may be triggered, which will cause the application to
-// crash.
-//
-// Likewise, don't try to set the QTextBlockFormat outside the highlighter
-// (i.e., from within the text editor).  While the application will not crash,
-// the format change will be added to the undo stack.  Attempting to undo from
-// that point on will cause the undo stack to be virtually frozen, since undoing
-// the format operation causes the text to be considered changed, thus
-// triggering the slot that changes the text formatting to be triggered yet
-// again.
+// Tints the background of the sentences of the current block that are hard
+// to read, as found by the ReadabilityAnalyzer, with the error color, more
+// strongly for the hardest ones.
 //
-void MarkdownHighlighter::highlightBlock(const QString &text)
+void MarkdownHighlighterPrivate::applyDifficultSentences(const TextBlockData *blockData)
 {
-    Q_D(MarkdownHighlighter);
+    Q_Q(MarkdownHighlighter);
 
-    int line = currentBlock().blockNumber() + 1;
-    int oldState = currentBlock().userState();
+    for (const ReadabilityAnalyzer::Sentence &sentence : blockData->difficultSentences) {
+        int pos = sentence.position;
+        int end = qMin(pos + sentence.length, q->currentBlock().length() - 1);
+        QColor tint = colors.error;
 
-    MarkdownAST *ast = ((MarkdownDocument *) this->document())->markdownAST();
-    MarkdownNode *node = nullptr;
+        tint.setAlpha((ReadabilityAnalyzer::VeryHard == sentence.difficulty) ? 60 : 30);
 
-    if (nullptr != ast) {
-        node = ast->findBlockAtLine(line);
-    }
+        // Keep the formats of the tinted text, such as its emphasis.
+        while (pos < end) {
+            QTextCharFormat format = q->format(pos);
+            int next = pos + 1;
 
-    if ((nullptr != node) && (MarkdownNode::Invalid != node->type())) {
-        d->applyFormattingForNode(node);
-    } else {
-        setFormat(0, currentBlock().length(), d->colors.foreground);
-
-        if (currentBlock().text().trimmed().isEmpty()) {
-            setCurrentBlockState(MarkdownStateParagraphBreak);
-        } else if (d->referenceDefinitionRegex.match(currentBlock().text()).hasMatch()) {
-            QTextCharFormat format = d->defaultFormat;
-            format.setForeground(d->colors.link);
-
-            setFormat(0, currentBlock().text().indexOf(':'), format);
-            setCurrentBlockState(MarkdownStateParagraph);
-        } else if (d->inlineHtmlCommentRegex.match(currentBlock().text()).hasMatch()) {
-            QTextCharFormat format = d->defaultFormat;
-            format.setForeground(d->colors.inlineHtml);
-            setFormat(0, currentBlock().text().length(), format);
-
-            if (previousBlockState() != MarkdownStateUnknown) {
-                setCurrentBlockState(previousBlockState());
-            } else {
-                setCurrentBlockState(MarkdownStateParagraph);
+            while ((next < end) && (q->format(next) == format)) {
+                next++;
             }
+
+            format.setBackground(tint);
+            q->setFormat(pos, next - pos, format);
+            pos = next;
         }
     }
+}
+
+// Returns the formats of the given block as a list of ranges, merging
+// adjacent characters that share the same format.
+//
+QVector<QTextLayout::FormatRange> MarkdownHighlighterPrivate::formatRanges(const BlockHighlight &block) const
+{
+    QVector<QTextLayout::FormatRange> ranges;
+    int i = 0;
 
-    if (d->isSetextHeadingState(oldState) && !d->isSetextHeadingState(currentBlockState())) {
-        QTextBlock block = currentBlock();
+    while (i < block.formats.size()) {
+        QTextLayout::FormatRange range;
+        range.start = i;
+        range.format = block.formats[i];
 
-        while
-        (
-            block.previous().isValid()
-            && (d->isSetextHeadingState(block.previous().userState()))
-        ) {
-            block = block.previous();
+        i++;
+
+        while ((i < block.formats.size()) && (block.formats[i] == range.format)) {
+            i++;
         }
 
-        if (currentBlock() != block) {
-            emit highlightBlockAtPosition(block.position());
+        range.length = i - range.start;
+
+        if (range.format.isValid()) {
+            range.format = internFormat(range.format);
+            ranges.append(range);
         }
-    } else if
-    (
-        currentBlock().previous().isValid()
-        &&
-        (
-            (
-                (MarkdownStatePipeTableDivider == (oldState & MarkdownStateMask))
-                && (MarkdownStatePipeTableDivider != (currentBlockState() & MarkdownStateMask))
-            )
-            ||
-            (
-                (MarkdownStatePipeTableDivider != (oldState & MarkdownStateMask))
-                && (MarkdownStatePipeTableDivider == (currentBlockState() & MarkdownStateMask))
-            )
-        )
-    ) {
-        emit highlightBlockAtPosition(currentBlock().previous().position());
     }
 
-    // Highlight last two spaces of the line to indicate line breaks.
-    //
-    QRegularExpression whitespaceRegex("(\\s+)");
-    QRegularExpressionMatchIterator matchIter = whitespaceRegex.globalMatch(currentBlock().text());
+    return ranges;
+}
 
-    while (matchIter.hasNext()) {
-        QRegularExpressionMatch match = matchIter.next();
-        QTextCharFormat format = this->format(match.capturedStart());
+// Underlines the misspelled words of the current block, as last found by
+// the spell check service.  If the block has not been checked since its
+// text or the dictionary last changed, it is also queued to be checked,
+// and will be rehighlighted once the service reports back.
+//
+void MarkdownHighlighterPrivate::spellCheck(const QString &text, TextBlockData *blockData)
+{
+    Q_Q(MarkdownHighlighter);
+    
+    int cursorPosition = editor->textCursor().position();
+    QTextBlock cursorPosBlock = q->document()->findBlock(cursorPosition);
+    int cursorPosInBlock = -1;
 
-        format.setForeground(Qt::transparent);
-        this->setFormat(match.capturedStart(), match.capturedLength(), format);
+    if (q->currentBlock() == cursorPosBlock) {
+        cursorPosInBlock = cursorPosition - cursorPosBlock.position();
     }
 
-    if (currentBlock().text().endsWith("  ")) {
-        QTextCharFormat format = this->format(currentBlock().text().length() - 2);
-        format.setForeground(d->colors.listMarkup);
-        this->setFormat(currentBlock().text().length() - 2, 2, format);
+    if (!spellCheckVisibleOnly || !backgroundRehighlight) {
+        queueSpellCheck(q->currentBlock(), text, blockData, (cursorPosInBlock >= 0));
     }
 
-    if (d->spellCheckEnabled) {
-        d->spellCheck(text);
-    }
-}
+    // Misspellings found for the same text with an older dictionary are
+    // still shown until the block is checked again, to avoid flicker.
+    // Note that queueing the block may have set its misspellings from the
+    // document's cache.
+    bool textChecked = blockData->spellingChecked
+        && (qHash(text) == blockData->spellingTextHash);
 
-void MarkdownHighlighter::setDictionary(const DictionaryRef &dictionary)
-{
-    Q_D(MarkdownHighlighter);
+    if (!textChecked) {
+        return;
+    }
 
-    d->dictionary = dictionary;
+    for (const SpellCheckService::Misspelling &misspelling : blockData->misspellings) {
+        int startIndex = misspelling.first;
+        int length = misspelling.second;
 
-    if (d->spellCheckEnabled) {
-        rehighlight();
+        if (typingPaused || (cursorPosInBlock != (startIndex + length))) {
+            q->setFormat(startIndex, length, spellingErrorFormat(q->format(startIndex)));
+        }
     }
 }
 
-void MarkdownHighlighter::increaseFontSize()
+// Queues the given block to be checked by the spell check service, unless
+// its misspellings are current or it is already queued.
+//
+void MarkdownHighlighterPrivate::queueSpellCheck
+(
+    const QTextBlock &block,
+    const QString &text,
+    TextBlockData *blockData,
+    bool urgent
+)
 {
-    Q_D(MarkdownHighlighter);
+    // Lines too long to highlight are not checked either.
+    if (text.length() > longLineThreshold) {
+        return;
+    }
 
-    d->defaultFormat.setFontPointSize(d->defaultFormat.fontPointSize() + 1.0);
-    rehighlight();
-}
+    uint textHash = qHash(text);
+    bool textChecked = blockData->spellingChecked
+        && (textHash == blockData->spellingTextHash);
 
-void MarkdownHighlighter::decreaseFontSize()
-{
-    Q_D(MarkdownHighlighter);
-    
-    d->defaultFormat.setFontPointSize(d->defaultFormat.fontPointSize() - 1.0);
-    rehighlight();
-}
+    // Use the misspellings cached from when the document was last open,
+    // if the block has not changed since.
+    if (!textChecked) {
+        QSharedPointer<DocumentCache> cache =
+            ((MarkdownDocument *) block.document())->documentCache();
+        QVector<QPair<int, int>> misspellings;
+        int dictionaryIndex = 0;
 
-void MarkdownHighlighter::setColorScheme(const ColorScheme &colors)
-{
-    Q_D(MarkdownHighlighter);
-    
-    d->colors = colors;
-    d->defaultFormat.setForeground(QBrush(colors.foreground));
-    rehighlight();
-}
+        if
+        (
+            !cache.isNull()
+            && cache->misspellings(block.blockNumber(), text, misspellings, dictionaryIndex)
+            && (dictionaryIndex <= alternativeDictionaries.size())
+        ) {
+            blockData->spellingChecked = true;
+            blockData->spellingTextHash = textHash;
+            blockData->spellingGeneration = spellingGeneration;
+            blockData->misspellings = misspellings;
+            blockData->spellingDictionary = dictionaryIndex;
+            return;
+        }
+    }
 
-void MarkdownHighlighter::setEnableLargeHeadingSizes(const bool enable)
-{
-    Q_D(MarkdownHighlighter);
-    
-    d->useLargeHeadings = enable;
-    rehighlight();
+    if
+    (
+        (!textChecked || (spellingGeneration != blockData->spellingGeneration))
+        && (!blockData->spellCheckQueued
+            || (spellingGeneration != blockData->spellCheckQueuedGeneration))
+    ) {
+        blockData->spellCheckQueued = true;
+        blockData->spellCheckQueuedGeneration = spellingGeneration;
+        spellChecker->check(block, urgent);
+    }
 }
 
-void MarkdownHighlighter::setUseUnderlineForEmphasis(const bool enable)
+// Drops the misspellings cached from when the document was last open, as
+// they are stale once the dictionaries change.
+//
+void MarkdownHighlighterPrivate::discardCachedMisspellings()
 {
-    Q_D(MarkdownHighlighter);
-    
-    d->useUndlerlineForEmphasis = enable;
-    rehighlight();
-}
+    Q_Q(MarkdownHighlighter);
 
-void MarkdownHighlighter::setItalicizeBlockquotes(const bool enable)
-{
-    Q_D(MarkdownHighlighter);
-    
-    d->italicizeBlockquotes = enable;
-    rehighlight();
+    MarkdownDocument *document = (MarkdownDocument *) q->document();
+
+    if ((nullptr != document) && !document->documentCache().isNull()) {
+        document->documentCache()->discardMisspellings();
+    }
 }
 
-void MarkdownHighlighter::setFont(const QString &fontFamily, const double fontSize)
+// Queues the visible blocks to be spell checked, for when only those are
+// checked.  The blocks are repainted with their misspellings once checked.
+//
+void MarkdownHighlighterPrivate::checkVisibleBlocks()
 {
-    Q_D(MarkdownHighlighter);
-    
-    QFont font;
-    font.setFamily(fontFamily);
-    font.setWeight(QFont::Normal);
-    font.setItalic(false);
-    font.setPointSizeF(fontSize);
-    d->defaultFormat.setFont(font);
+    for (const QPair<QTextBlock, QTextBlock> &range : visibleRanges(SpellCheckMargin)) {
+        QTextBlock block = range.first;
+        QTextBlock last = range.second;
 
-    rehighlight();
-}
+        while (block.isValid()) {
+            queueSpellCheck(block, block.text(), blockData(block), false);
 
-void MarkdownHighlighter::setSpellCheckEnabled(const bool enabled)
-{
-    Q_D(MarkdownHighlighter);
-    
-    d->spellCheckEnabled = enabled;
-    rehighlight();
-}
+            if (block == last) {
+                break;
+            }
 
-void MarkdownHighlighter::onTypingResumed()
-{
-    Q_D(MarkdownHighlighter);
-    
-    d->typingPaused = false;
+            block = block.next();
+        }
+    }
 }
 
-void MarkdownHighlighter::onTypingPaused()
+// Starts sweeping the document from the top for blocks to spell check,
+// for when only the visible blocks are checked right away.  The sweep
+// queues the blocks that are not current, a few at a time, so that the
+// whole document is eventually checked without delaying the viewport.
+//
+void MarkdownHighlighterPrivate::startSpellCheckSweep()
 {
-    Q_D(MarkdownHighlighter);
-    
-    d->typingPaused = true;
+    Q_Q(MarkdownHighlighter);
 
-    if (d->spellCheckEnabled) {
-        QTextBlock block = document()->findBlock(d->editor->textCursor().position());
-        rehighlightBlock(block);
+    if (!spellCheckEnabled || !spellCheckVisibleOnly || (nullptr == q->document())) {
+        spellCheckSweepTimer->stop();
+        spellCheckSweepCursor = QTextCursor();
+        return;
+    }
+
+    checkVisibleBlocks();
+    spellCheckSweepCursor = QTextCursor(q->document());
+
+    if (typingPaused && !sweepPaused) {
+        spellCheckSweepTimer->start();
     }
 }
 
-void MarkdownHighlighter::onCursorPositionChanged()
+// Queues the next batch of blocks of the spell check sweep.
+//
+void MarkdownHighlighterPrivate::sweepNextBatch()
 {
-    Q_D(MarkdownHighlighter);
-    
-    if
-    (
-        d->spellCheckEnabled &&
-        (d->currentLine != d->editor->textCursor().block())
-    ) {
-        rehighlightBlock(d->currentLine);
+    if (!spellCheckEnabled || !spellCheckVisibleOnly || spellCheckSweepCursor.isNull()) {
+        spellCheckSweepTimer->stop();
+        spellCheckSweepCursor = QTextCursor();
+        return;
     }
 
-    d->currentLine = d->editor->textCursor().block();
-}
+    QTextBlock block = spellCheckSweepCursor.block();
 
-void MarkdownHighlighter::onHighlightBlockAtPosition(int position)
-{    
-    QTextBlock block = document()->findBlock(position);
-    rehighlightBlock(block);
+    for (int i = 0; (i < SpellCheckSweepBatchSize) && block.isValid(); i++) {
+        queueSpellCheck(block, block.text(), blockData(block), false);
+        block = block.next();
+    }
+
+    if (block.isValid()) {
+        spellCheckSweepCursor.setPosition(block.position());
+    } else {
+        spellCheckSweepTimer->stop();
+        spellCheckSweepCursor = QTextCursor();
+    }
 }
 
-void MarkdownHighlighterPrivate::spellCheck(const QString &text)
+// Stores the misspellings found by the spell check service for the given
+// block, and rehighlights the block if they differ from the ones it was
+// last highlighted with.
+//
+void MarkdownHighlighterPrivate::onBlockChecked
+(
+    const QTextBlock &block,
+    const QString &text,
+    const QVector<SpellCheckService::Misspelling> &misspellings,
+    int dictionaryIndex
+)
 {
     Q_Q(MarkdownHighlighter);
-    
-    int cursorPosition = editor->textCursor().position();
-    QTextBlock cursorPosBlock = q->document()->findBlock(cursorPosition);
-    int cursorPosInBlock = -1;
 
-    if (q->currentBlock() == cursorPosBlock) {
-        cursorPosInBlock = cursorPosition - cursorPosBlock.position();
+    if (!block.isValid() || (block.document() != q->document())) {
+        return;
     }
 
-    QStringRef misspelledWord = dictionary.check(text, 0);
+    TextBlockData *blockData = (TextBlockData *) block.userData();
 
-    while (!misspelledWord.isNull()) {
-        int startIndex = misspelledWord.position();
-        int length = misspelledWord.length();
+    if (nullptr == blockData) {
+        return;
+    }
 
-        if (typingPaused || (cursorPosInBlock != (startIndex + length))) {
-            QTextCharFormat spellingErrorFormat = q->format(startIndex);
-            spellingErrorFormat.setUnderlineColor(colors.error);
-            spellingErrorFormat.setUnderlineStyle
-            (
-                (QTextCharFormat::UnderlineStyle)
-                QApplication::style()->styleHint
-                (
-                    QStyle::SH_SpellCheckUnderlineStyle
-                )
-            );
+    blockData->spellCheckQueued = false;
 
-            q->setFormat(startIndex, length, spellingErrorFormat);
+    // The text was edited while it was being checked, in which case the
+    // block is checked again with its new text.
+    if (block.text() != text) {
+        if (spellCheckEnabled) {
+            blockData->spellCheckQueued = true;
+            blockData->spellCheckQueuedGeneration = spellingGeneration;
+            spellChecker->check(block);
         }
 
-        startIndex += length;
-        misspelledWord = dictionary.check(text, startIndex);
+        return;
+    }
+
+    uint textHash = qHash(text);
+    bool changed;
+
+    if (blockData->spellingChecked && (textHash == blockData->spellingTextHash)) {
+        changed = (blockData->misspellings != misspellings);
+    } else {
+        changed = !misspellings.isEmpty();
+    }
+
+    blockData->spellingChecked = true;
+    blockData->spellingTextHash = textHash;
+    blockData->spellingGeneration = spellingGeneration;
+    blockData->misspellings = misspellings;
+    blockData->spellingDictionary = dictionaryIndex;
+
+    if (changed && spellCheckEnabled) {
+        q->rehighlightBlock(block);
     }
 }
 
-void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *const node)
+void MarkdownHighlighterPrivate::applyFormattingForNode
+(
+    BlockHighlight &block,
+    const MarkdownNode *const node
+) const
 {
-    Q_Q(MarkdownHighlighter);
-    
     MarkdownNode::NodeType type = node->type();
     int pos = node->position();
     int length = node->length();
-    int currentLine = q->currentBlock().blockNumber() + 1;
+    int currentLine = block.line;
     MarkdownState state = MarkdownStateParagraphBreak;
+    const CodeLexer *codeLexer = nullptr;
+    int lexerState = CodeLexer::InitialState;
 
     QTextCharFormat baseFormat = defaultFormat;
     baseFormat.setForeground(colors.foreground);
 
     unsigned int indent = 0;
-    QString text = q->currentBlock().text();
+    const QString &text = block.text;
 
     for (int i = 0; i < text.length(); i++) {
         if (text[i].isSpace()) {
@@ -442,23 +1914,27 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
         baseFormat.setForeground(colors.blockquoteMarkup);
         baseFormat.setFontItalic(italicizeBlockquotes);
 
-        q->setFormat
+        block.setFormat
         (
             0,
-            q->currentBlock().length(),
+            block.length(),
             baseFormat
         );
 
         baseFormat.setForeground(colors.blockquoteText);
     } else {
-        q->setFormat
+        block.setFormat
         (
             0,
-            q->currentBlock().length(),
+            block.length(),
             baseFormat
         );
     }
 
+    // Running offset of the nodes' columns within the line.  See
+    // columnInLine().
+    int columnOffset = 0;
+
     // Do a pre-order traversal of the nodes.
     QStack<const MarkdownNode *> nodes;
     QStack<QTextCharFormat> nodeFormats;
@@ -474,7 +1950,7 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
             parentType = current->parent()->type();
         }
 
-        pos = columnInLine(current, q->currentBlock().text());
+        pos = columnInLine(current, text, columnOffset);
         length = current->length();
         type = current->type();
 
@@ -492,7 +1968,7 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
 
             switch (type) {
             case MarkdownNode::Heading:
-                length = q->currentBlock().length();
+                length = block.length();
                 format.setFontWeight(QFont::Bold);
                 contextFormat.setFontWeight(QFont::Bold);
 
@@ -521,15 +1997,6 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
                     default:
                         state = MarkdownStateUnknown;
                     }
-
-                    // Rehighlight all blocks contained within this heading node.
-                    if (currentLine != current->startLine()) {
-                        QTextBlock block = q->document()->findBlockByNumber(current->startLine() - 1);
-
-                        if (block.isValid()) {
-                            emit q->highlightBlockAtPosition(block.position());
-                        }
-                    }
                 } else {
                     switch (current->headingLevel()) {
                     case 1:
@@ -577,22 +2044,26 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
                     current->isFencedCodeBlock()
                     &&
                     (
-                        ((q->currentBlock().blockNumber() + 1) == current->startLine())
-                        || ((q->currentBlock().blockNumber() + 1) == current->endLine())
+                        (currentLine == current->startLine())
+                        || (currentLine == current->endLine())
                     )
                 ) {
                     format.setForeground(colors.codeMarkup);
                     state = MarkdownStateCodeBlock;
                 } else if
                 (
-                    ((q->currentBlock().blockNumber() + 1) == current->endLine())
+                    (currentLine == current->endLine())
                     && (current->length() <= 0)
                 ) {
                     state = MarkdownStateParagraphBreak;
                 } else {
                     format.setForeground(colors.codeText);
-                    length = q->currentBlock().length() - pos + 1;
+                    length = block.length() - pos + 1;
                     state = MarkdownStateCodeBlock;
+
+                    if (current->isFencedCodeBlock()) {
+                        codeLexer = CodeLexer::forLanguage(current->textRef());
+                    }
                 }
 
                 break;
@@ -642,7 +2113,7 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
                 }
 
                 format.setForeground(colors.codeMarkup);
-                q->setFormat
+                block.setFormat
                 (
                     pos - backticks,
                     length + (2 * backticks),
@@ -679,14 +2150,14 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
             case MarkdownNode::TableHeading:
                 format.setForeground(colors.emphasisMarkup);
                 pos = 0;
-                length = q->currentBlock().length();
+                length = block.length();
                 contextFormat.setFontWeight(QFont::Bold);
                 state = MarkdownStatePipeTableHeader;
                 break;
             case MarkdownNode::TableRow:
                 format.setForeground(colors.emphasisMarkup);
                 pos = 0;
-                length = q->currentBlock().length();
+                length = block.length();
                 state = MarkdownStatePipeTableRow;
                 break;
             case MarkdownNode::TableCell:
@@ -703,7 +2174,7 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
             case MarkdownNode::Table:
                 format.setForeground(colors.emphasisMarkup);
                 pos = 0;
-                length = q->currentBlock().length();
+                length = block.length();
                 state = MarkdownStatePipeTableDivider;
                 break;
             case MarkdownNode::Strikethrough:
@@ -711,9 +2182,9 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
                 contextFormat.setFontStrikeOut(true);
                 break;
             default:
-                if (referenceDefinitionRegex.match(q->currentBlock().text()).hasMatch()) {
+                if (referenceDefinitionRegex.match(text).hasMatch()) {
                     pos = 0;
-                    length = q->currentBlock().text().indexOf(':') + 1;
+                    length = text.indexOf(':') + 1;
                     format.setForeground(colors.link);
                 } else {
                     format.setForeground(colors.blockquoteMarkup);
@@ -722,11 +2193,11 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
                 break;
             }
 
-            if ((length <= 0) || (length > q->currentBlock().length())) {
-                length = q->currentBlock().length();
+            if ((length <= 0) || (length > block.length())) {
+                length = block.length();
             }
 
-            q->setFormat
+            block.setFormat
             (
                 pos,
                 length,
@@ -734,7 +2205,27 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
             );
 
             if (MarkdownNode::Text == type) {
-                highlightRefLinks(pos, length);
+                highlightRefLinks(block, pos, length);
+
+                // The text of an autolink is its URL.
+                if
+                (
+                    (MarkdownNode::Link != parentType)
+                    || !current->parent()->textRef().endsWith(current->textRef())
+                ) {
+                    block.proseRanges.append(qMakePair(pos, length));
+                }
+            } else if ((MarkdownNode::CodeBlock == type) && (nullptr != codeLexer)) {
+                lexerState = highlightCode
+                    (
+                        block,
+                        codeLexer,
+                        pos,
+                        format,
+                        (currentLine > (current->startLine() + 1))
+                            ? codeLexerState(block.previousState)
+                            : CodeLexer::InitialState
+                    );
             } else if (MarkdownNode::TaskListItem == type) {
                 format = contextFormat;
                 format.setForeground(colors.link);
@@ -742,7 +2233,7 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
                 int checkboxStart = text.indexOf('[');
                 int checkboxEnd = text.indexOf(']');
 
-                q->setFormat
+                block.setFormat
                 (
                     checkboxStart,
                     checkboxEnd - checkboxStart + 1,
@@ -762,16 +2253,91 @@ void MarkdownHighlighterPrivate::applyFormattingForNode(const MarkdownNode *cons
 
     if (MarkdownStateUnknown != state) {
         state |= indent;
+        state |= (lexerState << MarkdownStateCodeLexerShift) & MarkdownStateCodeLexerMask;
 
         if (inBlockquote) {
             state |= MarkdownStateBlockquote;
         }
 
-        q->setCurrentBlockState(state);
+        block.state = state;
+    }
+}
+
+// Colors the tokens of the given line of code, starting at the given
+// position, and returns the state in which the line leaves the lexer.
+//
+int MarkdownHighlighterPrivate::highlightCode
+(
+    BlockHighlight &block,
+    const CodeLexer *lexer,
+    int start,
+    const QTextCharFormat &codeFormat,
+    int state
+) const
+{
+    QVector<CodeLexer::Token> tokens;
+    state = lexer->lex(block.text, start, state, tokens);
+
+    for (const CodeLexer::Token &token : tokens) {
+        QTextCharFormat format = codeFormat;
+
+        switch (token.type) {
+        case CodeLexer::Keyword:
+            format.setForeground(colors.headingMarkup);
+            break;
+        case CodeLexer::String:
+            format.setForeground(colors.link);
+            break;
+        case CodeLexer::Number:
+            format.setForeground(colors.image);
+            break;
+        case CodeLexer::Comment:
+            format.setForeground(colors.codeMarkup);
+            break;
+        case CodeLexer::Directive:
+            format.setForeground(colors.inlineHtml);
+            break;
+        }
+
+        block.setFormat(token.start, token.length, format);
+    }
+
+    return state;
+}
+
+// Returns the Markdown source character for the given character of a
+// node's text, undoing any substitutions made by smart typography.
+//
+QChar MarkdownHighlighterPrivate::sourceChar(const QChar c) const
+{
+    switch (c.unicode()) {
+    case 0x2018: // Left single quotation mark
+    case 0x2019: // Right single quotation mark
+        return '\'';
+    case 0x201C: // Left double quotation mark
+    case 0x201D: // Right double quotation mark
+        return '"';
+    case 0x2013: // En dash
+    case 0x2014: // Em dash
+        return '-';
+    case 0x2026: // Horizontal ellipsis
+        return '.';
+    default:
+        return c;
     }
 }
 
-int MarkdownHighlighterPrivate::columnInLine(const MarkdownNode *const node, const QString &lineText) const
+// Returns the column of the given node within the given line.  Nodes that
+// follow a line break within a paragraph have their column computed with
+// a running offset, which the caller must initialize to 0 for each line and
+// pass in for each of the line's nodes, in pre-order.
+//
+int MarkdownHighlighterPrivate::columnInLine
+(
+    const MarkdownNode *const node,
+    const QString &lineText,
+    int &offset
+) const
 {
     MarkdownNode::NodeType prevType = MarkdownNode::Invalid;
 
@@ -779,8 +2345,6 @@ int MarkdownHighlighterPrivate::columnInLine(const MarkdownNode *const node, con
         prevType = node->previous()->type();
     }
 
-    static int offset = 0;
-
     if (node->isBlockType()) {
         offset = 0;
     } else if
@@ -793,11 +2357,11 @@ int MarkdownHighlighterPrivate::columnInLine(const MarkdownNode *const node, con
 
         switch (node->type()) {
         case MarkdownNode::Text:
-            pos = text.indexOf(node->text()[0]);
+            pos = text.indexOf(sourceChar(node->textRef()[0]));
 
-            if (node->text().startsWith('`')) {
+            if (node->textRef().startsWith('`')) {
                 int retValue = pos;
-                pos += node->text().length() - node->length();
+                pos += node->textRef().length() - node->length();
                 offset = node->position() - pos;
                 return retValue;
             }
@@ -831,7 +2395,7 @@ int MarkdownHighlighterPrivate::columnInLine(const MarkdownNode *const node, con
             pos = text.indexOf('~');
             break;
         default:
-            pos = text.indexOf(node->text()[0]);
+            pos = text.indexOf(sourceChar(node->textRef()[0]));
             break;
         }
 
@@ -841,38 +2405,71 @@ int MarkdownHighlighterPrivate::columnInLine(const MarkdownNode *const node, con
     return node->position() - offset;
 }
 
-void MarkdownHighlighterPrivate::highlightRefLinks(const int pos, const int length)
+// Highlights the references within the given range of the block's text
+// that cmark-gfm left as text.  References whose label is defined in the
+// document are highlighted as links, as they are likely being typed ahead
+// of the AST.  Explicit references whose label is not defined are
+// highlighted as errors, while undefined shortcut references are left as
+// the literal text in brackets that they are.
+//
+void MarkdownHighlighterPrivate::highlightRefLinks
+(
+    BlockHighlight &block,
+    const int pos,
+    const int length
+) const
 {
-    Q_Q(MarkdownHighlighter);
+    Q_Q(const MarkdownHighlighter);
+
+    HighlightProfiler::Scope scope(&profiler, HighlightProfiler::RefLinks);
+
+    if (!block.text.contains('[')) {
+        return;
+    }
+
+    const ReferenceIndex *index =
+        ((MarkdownDocument *) q->document())->referenceIndex();
 
-    QStack<int> bracketPos;
-    bool skipNext = false;
-    QTextCharFormat format = q->format(pos);
-    format.setForeground(colors.link);
+    // The brackets of a reference may be split across several text nodes,
+    // so only the part of each reference within the given range is
+    // highlighted here.
+    for (const ReferenceIndex::Reference &ref : ReferenceIndex::parseReferences(block.text)) {
+        int start = qMax(ref.position, pos);
+        int end = qMin(ref.position + ref.length, pos + length);
 
-    for (int i = pos; i < (pos + length) && (i < q->currentBlock().text()); i++) {
-        if (skipNext) {
-            skipNext = false;
+        if (start >= end) {
             continue;
         }
 
-        switch (q->currentBlock().text()[i].toLatin1()) {
-        case '\\':
-            skipNext = true;
-            break;
-        case '[':
-            bracketPos.push(i);
-            break;
-        case ']':
-            if (!bracketPos.isEmpty()) {
-                int start = bracketPos.pop();
+        QTextCharFormat format = block.format(start);
 
-                q->setFormat(start, (i - start + 1), format);
-            }
+        if (index->isDefined(ref.label)) {
+            format.setForeground(colors.link);
+        } else if (ref.explicitReference) {
+            format.setForeground(colors.error);
+        } else {
+            continue;
+        }
 
-            break;
-        default:
-            break;
+        block.setFormat(start, end - start, format);
+    }
+}
+
+// Rehighlights the blocks that refer to the given labels, whose definitions
+// were added or removed.
+//
+void MarkdownHighlighterPrivate::onDefinitionsChanged(const QStringList &labels)
+{
+    Q_Q(MarkdownHighlighter);
+
+    const ReferenceIndex *index =
+        ((MarkdownDocument *) q->document())->referenceIndex();
+
+    for (const QString &label : labels) {
+        for (QTextBlock block : index->referringBlocks(label)) {
+            if (block.isValid() && !isHighlightCurrent(block)) {
+                q->rehighlightBlock(block);
+            }
         }
     }
 }
@@ -902,15 +2499,4 @@ bool MarkdownHighlighterPrivate::lineMatchesNode(const int line, const MarkdownN
             )
         );
 }
-
-bool MarkdownHighlighterPrivate::isSetextHeadingState(const int state)
-{
-    switch (state & MarkdownStateMask) {
-    case MarkdownStateSetextHeading1:
-    case MarkdownStateSetextHeading2:
-        return true;
-    default:
-        return false;
-    }
-}
 } // namespace ghostwriter
@@ -20,7 +20,11 @@
 #ifndef MARKDOWN_HIGHLIGHTER_H
 #define MARKDOWN_HIGHLIGHTER_H
 
+#include <QList>
+#include <QPair>
 #include <QSyntaxHighlighter>
+#include <QTextBlock>
+#include <QVector>
 
 #include "spelling/dictionary_ref.h"
 #include "markdowndocument.h"
@@ -66,6 +70,20 @@ public:
      */
     void setDictionary(const DictionaryRef &dictionary);
 
+    /**
+     * Sets the dictionaries of other languages in which paragraphs may be
+     * written.  Each block is checked against whichever dictionary finds
+     * the fewest misspellings in it, and that language is remembered for
+     * the block.
+     */
+    void setAlternativeDictionaries(const QList<DictionaryRef> &dictionaries);
+
+    /**
+     * Returns the dictionary of the language detected for the given block
+     * when it was last spell checked, or the main dictionary.
+     */
+    DictionaryRef dictionary(const QTextBlock &block) const;
+
     /**
      * Increases the font size by one point.
      */
@@ -81,6 +99,13 @@ public:
      */
     void setColorScheme(const ColorScheme &colors);
 
+    /**
+     * Sets the color scheme, rehighlighting only the visible blocks and
+     * cancelling any queued rehighlighting of the rest of the document.
+     * Intended for previewing colors while they change rapidly.
+     */
+    void previewColorScheme(const ColorScheme &colors);
+
     /**
      * Sets whether large heading sizes are enabled.
      */
@@ -96,6 +121,14 @@ public:
      */
     void setItalicizeBlockquotes(const bool enable);
 
+    /**
+     * Sets the length, in characters, above which lines, such as embedded
+     * data or minified code, are given a single plain format instead of
+     * being highlighted, and are not spell checked.  Laying out such lines
+     * is then far cheaper.
+     */
+    void setLongLineThreshold(int characters);
+
     /**
      * Sets the font family and point size.
      */
@@ -106,20 +139,131 @@ public:
      */
     void setSpellCheckEnabled(const bool enabled);
 
+    /**
+     * Sets whether live spell checking is limited to the blocks that are
+     * visible in the editor, rather than the whole document.  Blocks are
+     * checked as they are scrolled into view.  Use for large documents.
+     */
+    void setSpellCheckVisibleOnly(const bool visibleOnly);
+
+    /**
+     * Rehighlights the given range of lines (inclusive, numbered from 1),
+     * such as those whose structure changed after the document's AST was
+     * updated.  The highlighting is queued in the event system, so this
+     * method is safe to call while the document is being edited.
+     */
+    void rehighlightLines(int firstLine, int lastLine);
+
+    /**
+     * Highlights the given range of lines (inclusive, numbered from 1)
+     * without consulting the AST, the same as text that the AST does not
+     * cover.  Use while the AST for those lines is out of date and is
+     * being parsed again in the background.  The lines leaving and
+     * entering the range are rehighlighted.  Pass in zero for both lines
+     * to highlight every line with the AST again.
+     */
+    void setFallbackLines(int firstLine, int lastLine);
+
+    /**
+     * Rehighlights the entire document without blocking the GUI for the
+     * duration.  The blocks currently visible in the editor are highlighted
+     * right away, and the remaining blocks are highlighted in small batches
+     * from the event loop.  Prefer this method to rehighlight() whenever
+     * a setting that affects the highlighting of every block changes.
+     */
+    void rehighlightLazily();
+
+    /**
+     * Discards the spelling results cached for every block and checks the
+     * document again.  Call whenever the words accepted by the dictionary
+     * change, e.g. when adding a word to the personal dictionary.
+     */
+    void recheckSpelling();
+
+    /**
+     * Checks again only the blocks that contain any of the given words,
+     * keeping the spelling results cached for every other block.  Call
+     * when just those words were added to or removed from the personal
+     * dictionary.
+     */
+    void recheckWords(const QStringList &words);
+
+    /**
+     * Gets the positions and lengths of the misspelled words in the given
+     * block, in order, as found by the background spell check.  Returns
+     * false if the block has not been checked since its text or the
+     * dictionary last changed, in which case the caller should check the
+     * block itself.
+     */
+    bool misspellings
+    (
+        const QTextBlock &block,
+        QVector<QPair<int, int>> &misspellings
+    ) const;
+
+    /**
+     * Returns the current spelling generation, which is advanced whenever
+     * the dictionaries change.  Only the misspellings of the blocks checked
+     * in the current generation are current.
+     */
+    uint spellingGeneration() const;
+
+    /**
+     * Enables or disables timing the phases of highlighting, by phase and
+     * by block node type, for diagnosing slow rehighlights.  Profiling is
+     * also enabled at startup if the GHOSTWRITER_HIGHLIGHT_PROFILE
+     * environment variable is set to the path of a file, in which case the
+     * report is written to that file when the highlighter is destroyed.
+     */
+    void setProfilingEnabled(bool enabled);
+
+    /**
+     * Returns a plain text report of the timings collected so far.
+     */
+    QString profilingReport() const;
+
+    /**
+     * Writes the timing report to the given file.  Returns false if the
+     * file could not be written.
+     */
+    bool dumpProfilingReport(const QString &filePath) const;
+
+    /**
+     * Pauses or resumes the sweep that spell checks the blocks outside of
+     * the viewport, such as while memory runs low.  The visible blocks
+     * are still checked as they are scrolled into view.
+     */
+    void setBackgroundSweepPaused(bool paused);
+
+    /**
+     * Frees the highlighting formats cached for reuse by the blocks that
+     * are not near the viewport, such as when memory runs low.  Those
+     * blocks keep their current formatting.
+     */
+    void releaseCaches();
+
+    /**
+     * Adds a secondary view of the document, such as that of a split
+     * view, which shares this highlighter with the editor.  The blocks
+     * visible in each view are highlighted and spell checked ahead of the
+     * rest of the document.  The view is removed when it is destroyed.
+     */
+    void addView(MarkdownEditor *view);
+
 signals:
     /**
      * FOR INTERNAL USE ONLY
      *
-     * This signal is used internally to restart highlighting on the
-     * previous line, which is needed for setext headings.  Unfortunately,
-     * QSyntaxHighlighter only goes forward in its highlighting, not
-     * backwards.  Neither can rehighlightBlock() be called internally,
-     * since recursive calls to the class will wipe its state data and will
-     * cause the application to crash. This is a workaround to queue a
-     * highlighting action for the prior text block in the event system,
-     * so that recursion isn't used.
+     * This signal is used internally to queue highlighting of a range of
+     * lines, such as the lines before the current one when a setext heading
+     * is formed.  Unfortunately, QSyntaxHighlighter only goes forward in its
+     * highlighting, not backwards.  Neither can rehighlightBlock() be called
+     * internally, since recursive calls to the class will wipe its state
+     * data and will cause the application to crash. This is a workaround to
+     * queue the highlighting action in the event system, so that recursion
+     * isn't used.
      */
-    void highlightBlockAtPosition(int position);
+    void highlightLines(int firstLine, int lastLine);
 
 public slots:
     /**
@@ -150,10 +294,10 @@ public slots:
 
 private slots:
     /*
-    * Highlights the text block at the given cursor position of the
-    * document.  See explanation for highlightBlockAtPosition().
+    * Highlights the given range of lines of the document.  See
+    * explanation for highlightLines().
     */
-    void onHighlightBlockAtPosition(int position);
+    void onHighlightLines(int firstLine, int lastLine);
 
 private:
     QScopedPointer<MarkdownHighlighterPrivate> d_ptr;
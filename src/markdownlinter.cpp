@@ -0,0 +1,710 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFutureWatcher>
+#include <QSet>
+#include <QTextBlock>
+#include <QTextCursor>
+
+#include <algorithm>
+
+#include "markdowndocument.h"
+#include "markdownlinter.h"
+#include "taskscheduler.h"
+#include "textblockdata.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+class MarkdownLinterPrivate
+{
+    Q_DECLARE_PUBLIC(MarkdownLinter)
+
+public:
+    // What the rules need to know of a line, gathered from the document and
+    // its AST on the GUI thread so that the rules can be evaluated on
+    // another thread.
+    struct LintLine
+    {
+        QTextBlock block;
+        QString text;
+
+        // Whether the line is within a paragraph, or within a code block,
+        // HTML block or table, whose lines are taken verbatim.
+        bool paragraph;
+        bool verbatim;
+
+        // Level of the heading starting on the line and of the heading
+        // preceding it, or 0 if none.
+        int headingLevel;
+        int previousHeadingLevel;
+
+        // Marker of the bullet list item starting on the line and its
+        // position, and the marker of the preceding adjacent bullet list,
+        // if the item starts a list that follows another.
+        QChar listMarker;
+        int listMarkerPosition;
+        QChar previousListMarker;
+
+        // Warnings found for the line.
+        QVector<MarkdownLinter::Warning> warnings;
+    };
+
+    MarkdownLinterPrivate(MarkdownLinter *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~MarkdownLinterPrivate()
+    {
+        ;
+    }
+
+    MarkdownLinter *q_ptr;
+    MarkdownDocument *document;
+    bool enabled;
+    int maxLineLength;
+
+    // Range of the document left to check, tracked with cursors so that it
+    // moves with edits, or null cursors if there is none.
+    QTextCursor pendingStart;
+    QTextCursor pendingEnd;
+
+    QFutureWatcher<QVector<LintLine>> *watcher;
+    bool lintInProgress;
+
+    // Revision of the document at its last change.
+    int changeRevision;
+
+    // Blocks that have warnings.
+    QSet<TextBlockData *> flaggedBlocks;
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onMarkdownASTChanged();
+    void markPending(int firstLine, int lastLine);
+    void startLint();
+    void onLintFinished();
+    void clearWarnings();
+    LintLine lintLine
+    (
+        const MarkdownAST *ast,
+        const QVector<MarkdownNode *> &headings,
+        QTextBlock &block
+    ) const;
+    static QChar bulletMarker(const QString &text, const MarkdownNode *item, int &position);
+    static void evaluateRules(LintLine &line, int maxLineLength);
+};
+
+bool MarkdownLinter::Warning::operator==(const Warning &other) const
+{
+    return (position == other.position)
+        && (length == other.length)
+        && (rule == other.rule)
+        && (message == other.message);
+}
+
+bool MarkdownLinter::Warning::operator!=(const Warning &other) const
+{
+    return !(*this == other);
+}
+
+MarkdownLinter::MarkdownLinter(MarkdownDocument *document, QObject *parent)
+    : QObject(parent),
+      d_ptr(new MarkdownLinterPrivate(this))
+{
+    Q_D(MarkdownLinter);
+
+    d->document = document;
+    d->enabled = false;
+    d->maxLineLength = 0;
+    d->lintInProgress = false;
+    d->changeRevision = document->revision();
+    d->watcher = new QFutureWatcher<QVector<MarkdownLinterPrivate::LintLine>>(this);
+
+    this->connect
+    (
+        d->watcher,
+        &QFutureWatcher<QVector<MarkdownLinterPrivate::LintLine>>::finished,
+        [d]() {
+            d->onLintFinished();
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &QTextDocument::contentsChange,
+        this,
+        [d](int position, int charsRemoved, int charsAdded) {
+            d->onContentsChange(position, charsRemoved, charsAdded);
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::markdownASTChanged,
+        this,
+        [d]() {
+            d->onMarkdownASTChanged();
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::textBlockDataRemoved,
+        this,
+        [d](TextBlockData *blockData) {
+            d->flaggedBlocks.remove(blockData);
+        }
+    );
+}
+
+MarkdownLinter::~MarkdownLinter()
+{
+    Q_D(MarkdownLinter);
+
+    d->watcher->waitForFinished();
+}
+
+bool MarkdownLinter::isEnabled() const
+{
+    Q_D(const MarkdownLinter);
+
+    return d->enabled;
+}
+
+void MarkdownLinter::setEnabled(bool enabled)
+{
+    Q_D(MarkdownLinter);
+
+    if (enabled == d->enabled) {
+        return;
+    }
+
+    d->enabled = enabled;
+
+    if (enabled) {
+        d->markPending(1, d->document->blockCount());
+        d->startLint();
+    } else {
+        d->pendingStart = QTextCursor();
+        d->pendingEnd = QTextCursor();
+        d->clearWarnings();
+    }
+}
+
+void MarkdownLinter::setMaxLineLength(int length)
+{
+    Q_D(MarkdownLinter);
+
+    if (length == d->maxLineLength) {
+        return;
+    }
+
+    d->maxLineLength = length;
+
+    if (d->enabled) {
+        d->markPending(1, d->document->blockCount());
+        d->startLint();
+    }
+}
+
+QVector<MarkdownLinter::Warning> MarkdownLinter::warnings() const
+{
+    Q_D(const MarkdownLinter);
+
+    QVector<const TextBlockData *> blocks;
+
+    for (const TextBlockData *blockData : d->flaggedBlocks) {
+        blocks.append(blockData);
+    }
+
+    std::sort
+    (
+        blocks.begin(),
+        blocks.end(),
+        [](const TextBlockData *a, const TextBlockData *b) {
+            return a->blockRef.position() < b->blockRef.position();
+        }
+    );
+
+    QVector<Warning> warnings;
+
+    for (const TextBlockData *blockData : blocks) {
+        int line = blockData->blockRef.blockNumber() + 1;
+
+        for (Warning warning : blockData->lintWarnings) {
+            warning.line = line;
+            warnings.append(warning);
+        }
+    }
+
+    return warnings;
+}
+
+void MarkdownLinterPrivate::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // Highlighting also signals a change to the contents, without changing
+    // the text.  See MarkdownDocument::onContentsChange().
+    if
+    (
+        !enabled
+        || ((charsRemoved == charsAdded)
+            && (charsAdded > 0)
+            && (document->revision() == changeRevision))
+    ) {
+        return;
+    }
+
+    changeRevision = document->revision();
+
+    QTextBlock first = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+
+    markPending(first.blockNumber() + 1, last.blockNumber() + 1);
+}
+
+void MarkdownLinterPrivate::onMarkdownASTChanged()
+{
+    if (!enabled) {
+        return;
+    }
+
+    for (const MarkdownAST::LineRange &range : document->markdownASTChanges()) {
+        markPending(range.first, range.second);
+    }
+
+    startLint();
+}
+
+// Adds the given range of lines to the range left to check.
+//
+void MarkdownLinterPrivate::markPending(int firstLine, int lastLine)
+{
+    QTextBlock first = document->findBlockByNumber(firstLine - 1);
+    QTextBlock last = document->findBlockByNumber(lastLine - 1);
+
+    if (!first.isValid()) {
+        first = document->firstBlock();
+    }
+
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+
+    if (pendingStart.isNull()) {
+        pendingStart = QTextCursor(document);
+        pendingEnd = QTextCursor(document);
+        pendingStart.setPosition(first.position());
+        pendingEnd.setPosition(last.position());
+        return;
+    }
+
+    pendingStart.setPosition(qMin(pendingStart.position(), first.position()));
+    pendingEnd.setPosition(qMax(pendingEnd.position(), last.position()));
+}
+
+// Gathers the lines left to check from the document's AST, and evaluates
+// the rules for them in the background.  If a check is already under way,
+// the lines are checked once it finishes.
+//
+void MarkdownLinterPrivate::startLint()
+{
+    const MarkdownAST *ast = document->markdownAST();
+
+    if (lintInProgress || pendingStart.isNull() || (nullptr == ast) || (nullptr == ast->root())) {
+        return;
+    }
+
+    GW_TRACE_SCOPE("MarkdownLinter::startLint");
+
+    QTextBlock block = pendingStart.block();
+    QTextBlock last = pendingEnd.block();
+    pendingStart = QTextCursor();
+    pendingEnd = QTextCursor();
+
+    QVector<MarkdownNode *> headings = ast->headings();
+
+    // The heading following the range is checked along with it, as the
+    // heading it follows may have changed.
+    for (const MarkdownNode *heading : headings) {
+        if (heading->startLine() > (last.blockNumber() + 1)) {
+            QTextBlock next = document->findBlockByNumber(heading->startLine() - 1);
+
+            if (next.isValid()) {
+                last = next;
+            }
+
+            break;
+        }
+    }
+
+    QVector<LintLine> lines;
+
+    while (block.isValid()) {
+        lines.append(lintLine(ast, headings, block));
+
+        if (block == last) {
+            break;
+        }
+
+        block = block.next();
+    }
+
+    if (lines.isEmpty()) {
+        return;
+    }
+
+    int maxLineLength = this->maxLineLength;
+
+    lintInProgress = true;
+
+    QFuture<QVector<LintLine>> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::SpellCheck,
+            [lines, maxLineLength]() {
+                GW_TRACE_SCOPE("MarkdownLinter::evaluateRules");
+                QVector<LintLine> results = lines;
+
+                for (LintLine &line : results) {
+                    evaluateRules(line, maxLineLength);
+                }
+
+                return results;
+            }
+        );
+    watcher->setFuture(future);
+}
+
+// Stores the warnings found for the checked lines in their blocks.  Lines
+// that were edited in the meantime are skipped, as they are checked again.
+//
+void MarkdownLinterPrivate::onLintFinished()
+{
+    Q_Q(MarkdownLinter);
+
+    lintInProgress = false;
+
+    if (!enabled) {
+        return;
+    }
+
+    QVector<LintLine> results = watcher->result();
+    int firstChanged = -1;
+    int lastChanged = -1;
+
+    for (LintLine &line : results) {
+        if
+        (
+            !line.block.isValid()
+            || (line.block.document() != document)
+            || (line.block.text() != line.text)
+        ) {
+            continue;
+        }
+
+        TextBlockData *blockData = (TextBlockData *) line.block.userData();
+
+        if (nullptr == blockData) {
+            if (line.warnings.isEmpty()) {
+                continue;
+            }
+
+            blockData = new TextBlockData(document, line.block);
+            line.block.setUserData(blockData);
+        }
+
+        if (blockData->lintWarnings == line.warnings) {
+            continue;
+        }
+
+        int lineNumber = line.block.blockNumber() + 1;
+
+        for (MarkdownLinter::Warning &warning : line.warnings) {
+            warning.line = lineNumber;
+        }
+
+        // The warnings are underlined by the highlighter along with its
+        // own formats, which are therefore no longer current.
+        blockData->lintWarnings = line.warnings;
+        blockData->highlightApplied = false;
+
+        if (line.warnings.isEmpty()) {
+            flaggedBlocks.remove(blockData);
+        } else {
+            flaggedBlocks.insert(blockData);
+        }
+
+        if ((firstChanged < 0) || (lineNumber < firstChanged)) {
+            firstChanged = lineNumber;
+        }
+
+        lastChanged = qMax(lastChanged, lineNumber);
+    }
+
+    if (firstChanged > 0) {
+        emit q->warningsChanged(firstChanged, lastChanged);
+    }
+
+    startLint();
+}
+
+void MarkdownLinterPrivate::clearWarnings()
+{
+    Q_Q(MarkdownLinter);
+
+    int firstChanged = -1;
+    int lastChanged = -1;
+
+    for (TextBlockData *blockData : flaggedBlocks) {
+        int lineNumber = blockData->blockRef.blockNumber() + 1;
+
+        blockData->lintWarnings.clear();
+        blockData->highlightApplied = false;
+
+        if ((firstChanged < 0) || (lineNumber < firstChanged)) {
+            firstChanged = lineNumber;
+        }
+
+        lastChanged = qMax(lastChanged, lineNumber);
+    }
+
+    flaggedBlocks.clear();
+
+    if (firstChanged > 0) {
+        emit q->warningsChanged(firstChanged, lastChanged);
+    }
+}
+
+// Gathers what the rules need to know of the given block's line from the
+// deepest block node of the AST at that line.
+//
+MarkdownLinterPrivate::LintLine MarkdownLinterPrivate::lintLine
+(
+    const MarkdownAST *ast,
+    const QVector<MarkdownNode *> &headings,
+    QTextBlock &block
+) const
+{
+    LintLine line;
+    int lineNumber = block.blockNumber() + 1;
+
+    line.block = block;
+    line.text = block.text();
+    line.paragraph = false;
+    line.verbatim = false;
+    line.headingLevel = 0;
+    line.previousHeadingLevel = 0;
+    line.listMarkerPosition = -1;
+
+    const MarkdownNode *node = ast->findBlockAtLine(lineNumber);
+
+    if ((nullptr == node) || node->isInvalid()) {
+        return line;
+    }
+
+    line.paragraph = (MarkdownNode::Paragraph == node->type());
+
+    for (const MarkdownNode *current = node; nullptr != current; current = current->parent()) {
+        switch (current->type()) {
+        case MarkdownNode::CodeBlock:
+        case MarkdownNode::HtmlBlock:
+        case MarkdownNode::Table:
+        case MarkdownNode::TableHeading:
+        case MarkdownNode::TableRow:
+        case MarkdownNode::TableCell:
+            line.verbatim = true;
+            break;
+        case MarkdownNode::ListItem:
+        case MarkdownNode::TaskListItem:
+            if
+            (
+                (current->startLine() == lineNumber)
+                && current->isBulletListItem()
+                && line.listMarker.isNull()
+            ) {
+                line.listMarker =
+                    bulletMarker(line.text, current, line.listMarkerPosition);
+
+                const MarkdownNode *list = current->parent();
+
+                if
+                (
+                    !line.listMarker.isNull()
+                    && (nullptr != list)
+                    && (list->firstChild() == current)
+                    && (nullptr != list->previous())
+                    && (MarkdownNode::BulletList == list->previous()->type())
+                    && (nullptr != list->previous()->firstChild())
+                ) {
+                    const MarkdownNode *item = list->previous()->firstChild();
+                    int position;
+
+                    line.previousListMarker = bulletMarker
+                        (
+                            document->findBlockByNumber(item->startLine() - 1).text(),
+                            item,
+                            position
+                        );
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if ((MarkdownNode::Heading == node->type()) && (node->startLine() == lineNumber)) {
+        line.headingLevel = node->headingLevel();
+
+        for (int i = 0; i < headings.size(); i++) {
+            if (headings[i] == node) {
+                if (i > 0) {
+                    line.previousHeadingLevel = headings[i - 1]->headingLevel();
+                }
+
+                break;
+            }
+        }
+    }
+
+    return line;
+}
+
+// Returns the marker of the given bullet list item, whose first line is the
+// given text, and sets its position within the text.  Returns a null
+// character if the marker cannot be found.
+//
+QChar MarkdownLinterPrivate::bulletMarker
+(
+    const QString &text,
+    const MarkdownNode *item,
+    int &position
+)
+{
+    int start = qMax(0, item->position());
+
+    for (int i = start; i < text.length(); i++) {
+        QChar c = text[i];
+
+        if (('-' == c) || ('*' == c) || ('+' == c)) {
+            position = i;
+            return c;
+        }
+
+        if (!c.isSpace() && ('>' != c)) {
+            break;
+        }
+    }
+
+    position = -1;
+    return QChar();
+}
+
+// Evaluates the rules of the house style for the given line, storing the
+// warnings found in it.  Safe to call from any thread.
+//
+void MarkdownLinterPrivate::evaluateRules(LintLine &line, int maxLineLength)
+{
+    const QString &text = line.text;
+    MarkdownLinter::Warning warning;
+
+    // Set once the warnings are stored, as blocks can't be read from other
+    // threads.
+    warning.line = 0;
+
+    if ((line.headingLevel > 0) && (line.previousHeadingLevel > 0)
+            && (line.headingLevel > (line.previousHeadingLevel + 1))) {
+        warning.position = 0;
+        warning.length = text.length();
+        warning.rule = MarkdownLinter::HeadingIncrement;
+        warning.message = MarkdownLinter::tr("Heading level skips from %1 to %2")
+            .arg(line.previousHeadingLevel)
+            .arg(line.headingLevel);
+        line.warnings.append(warning);
+    }
+
+    int trailing = 0;
+
+    while ((trailing < text.length()) && text[text.length() - trailing - 1].isSpace()) {
+        trailing++;
+    }
+
+    // Two trailing spaces in a paragraph are a line break.
+    bool lineBreak = line.paragraph
+        && (2 == trailing)
+        && (trailing < text.length())
+        && text.endsWith(QLatin1String("  "));
+
+    if ((trailing > 0) && !lineBreak) {
+        warning.position = text.length() - trailing;
+        warning.length = trailing;
+        warning.rule = MarkdownLinter::TrailingWhitespace;
+        warning.message = MarkdownLinter::tr("Trailing whitespace");
+        line.warnings.append(warning);
+    }
+
+    if
+    (
+        !line.listMarker.isNull()
+        && !line.previousListMarker.isNull()
+        && (line.listMarker != line.previousListMarker)
+    ) {
+        warning.position = line.listMarkerPosition;
+        warning.length = 1;
+        warning.rule = MarkdownLinter::ListMarker;
+        warning.message = MarkdownLinter::tr("List marker %1 differs from the preceding list's %2")
+            .arg(line.listMarker)
+            .arg(line.previousListMarker);
+        line.warnings.append(warning);
+    }
+
+    if ((maxLineLength > 0) && !line.verbatim && (text.length() > maxLineLength)) {
+        int indent = 0;
+
+        while ((indent < text.length()) && text[indent].isSpace()) {
+            indent++;
+        }
+
+        // Lines that have no whitespace to wrap at before the limit, such
+        // as those holding a long URL, are left alone.
+        int wrap = text.indexOf(' ', indent);
+
+        if ((wrap >= 0) && (wrap <= maxLineLength)) {
+            warning.position = maxLineLength;
+            warning.length = text.length() - trailing - maxLineLength;
+            warning.rule = MarkdownLinter::LineLength;
+            warning.message = MarkdownLinter::tr("Line is longer than %1 characters")
+                .arg(maxLineLength);
+
+            if (warning.length > 0) {
+                line.warnings.append(warning);
+            }
+        }
+    }
+}
+} // namespace ghostwriter
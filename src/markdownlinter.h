@@ -0,0 +1,124 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef MARKDOWN_LINTER_H
+#define MARKDOWN_LINTER_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+class TextBlockData;
+
+/**
+ * Checks a MarkdownDocument against a house style:  heading levels that
+ * increase by one at a time, no trailing whitespace, consistent bullet list
+ * markers and a maximum line length.
+ *
+ * Only the lines edited or whose structure changed since the last AST are
+ * checked, against the nodes of the new AST, so that the cost of checking
+ * stays proportional to the edit.  The rules are evaluated in the
+ * background, and the warnings are stored in the blocks' TextBlockData.
+ */
+class MarkdownLinterPrivate;
+class MarkdownLinter : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(MarkdownLinter)
+
+public:
+    /**
+     * Rules of the house style.
+     */
+    typedef enum {
+        HeadingIncrement,
+        TrailingWhitespace,
+        ListMarker,
+        LineLength
+    } Rule;
+
+    /**
+     * Violation of a rule within a line of the document.
+     */
+    struct Warning
+    {
+        // Line number, starting from 1, and the range of characters of the
+        // line that violate the rule.
+        int line;
+        int position;
+        int length;
+
+        Rule rule;
+        QString message;
+
+        bool operator==(const Warning &other) const;
+        bool operator!=(const Warning &other) const;
+    };
+
+    /**
+     * Constructor.  Pass in the document to check.
+     */
+    MarkdownLinter(MarkdownDocument *document, QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~MarkdownLinter();
+
+    /**
+     * Returns whether the document is being checked.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Sets whether to check the document.  Enabling checks the whole
+     * document once its AST is available, and disabling clears all
+     * warnings.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Sets the maximum number of characters per line, or zero to not
+     * limit the length of lines.  Code blocks, HTML blocks and tables are
+     * exempt, as are lines that cannot be wrapped before the limit.
+     */
+    void setMaxLineLength(int length);
+
+    /**
+     * Returns all the warnings of the document, in order.
+     */
+    QVector<Warning> warnings() const;
+
+signals:
+    /**
+     * Emitted when the warnings of the given range of lines (inclusive)
+     * change.
+     */
+    void warningsChanged(int firstLine, int lastLine);
+
+private:
+    QScopedPointer<MarkdownLinterPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // MARKDOWN_LINTER_H
@@ -17,48 +17,55 @@
  *
  ***********************************************************************/
 
+#include <QDataStream>
 #include <QQueue>
 #include <QRegularExpression>
 #include <QSharedPointer>
 #include <QStack>
 
 #include "3rdparty/cmark-gfm/core/cmark-gfm.h"
+#include "3rdparty/cmark-gfm/core/node.h"
 #include "3rdparty/cmark-gfm/extensions/cmark-gfm-core-extensions.h"
 
 #include "markdownnode.h"
+#include "utf8columnmap.h"
 
 namespace ghostwriter
 {
 MarkdownNode::MarkdownNode() :
-    m_type(Invalid),
-    m_parent(NULL),
-    m_prev(NULL),
-    m_next(NULL),
-    m_firstChild(NULL),
-    m_lastChild(NULL),
     m_startLine(0),
     m_endLine(0),
     m_position(0),
     m_length(0),
+    m_type(Invalid),
     m_fenceChar('\0'),
     m_headingLevel(0),
-    m_listStartNum(0)
+    m_parent(NULL),
+    m_prev(NULL),
+    m_next(NULL),
+    m_firstChild(NULL),
+    m_lastChild(NULL),
+    m_textBuffer(NULL),
+    m_textOffset(0),
+    m_textLength(0),
+    m_listStartNum(0),
+    m_cmarkNode(NULL)
 {
     ;
 }
 
 MarkdownNode::MarkdownNode
 (
-    cmark_node *node
-)
+    cmark_node *node,
+    QString *textBuffer,
+    const Utf8ColumnMap *columns
+) : MarkdownNode()
 {
-    MarkdownNode();
-
     if (NULL == node) {
         return;
     }
 
-    setDataFrom(node);
+    setDataFrom(node, textBuffer, columns);
 }
 
 MarkdownNode::~MarkdownNode()
@@ -66,19 +73,64 @@ MarkdownNode::~MarkdownNode()
     ;
 }
 
-void MarkdownNode::setDataFrom(cmark_node *node)
+void MarkdownNode::setDataFrom
+(
+    cmark_node *node,
+    QString *textBuffer,
+    const Utf8ColumnMap *columns
+)
+{
+    setFieldsFrom(node, columns);
+    m_cmarkNode = NULL;
+    setText(textOf(node), textBuffer);
+}
+
+void MarkdownNode::setViewOf
+(
+    cmark_node *node,
+    QString *textBuffer,
+    const Utf8ColumnMap *columns
+)
+{
+    setFieldsFrom(node, columns);
+    m_cmarkNode = node;
+
+    // Decode the text now rather than when first requested, since the AST
+    // may be read from several threads at once once it is published, and
+    // decoding appends to the shared text buffer.
+    //
+    setText(textOf(node), textBuffer);
+}
+
+// Copies everything but the text from the given cmark_node.
+//
+void MarkdownNode::setFieldsFrom(cmark_node *node, const Utf8ColumnMap *columns)
 {
-    // Copy data.
     m_type = nodeType(node);
-    m_position = cmark_node_get_start_column(node) - 1;
-    m_length = cmark_node_get_end_column(node) - cmark_node_get_start_column(node) + 1;
     m_startLine = cmark_node_get_start_line(node);
     m_endLine = cmark_node_get_end_line(node);
 
-    if (!isBlockType()) {
-        m_text = QString::fromUtf8(cmark_node_get_literal(node));
+    int startColumn = cmark_node_get_start_column(node);
+    int endColumn = cmark_node_get_end_column(node);
+
+    // Columns are one-based, and the end column is inclusive.  Hence, the
+    // end column converts as the exclusive, zero-based end offset.
+    if (nullptr != columns) {
+        if (startColumn > 0) {
+            startColumn = columns->toUtf16(m_startLine, startColumn - 1) + 1;
+        }
+
+        if (endColumn > 0) {
+            endColumn = columns->toUtf16(m_endLine, endColumn);
+        }
     }
 
+    m_position = startColumn - 1;
+    m_length = endColumn - startColumn + 1;
+    m_fenceChar = '\0';
+    m_headingLevel = 0;
+    m_listStartNum = 0;
+
     if (CodeBlock == m_type) {
         int len;
         int offset;
@@ -91,9 +143,136 @@ void MarkdownNode::setDataFrom(cmark_node *node)
         }
     } else if (Heading == m_type) {
         m_headingLevel = cmark_node_get_heading_level(node);
-        m_text = QString::fromUtf8(cmark_node_get_string_content(node));
-        m_text = this->m_text.simplified();
+    } else if (NumberedList == m_type) {
+        m_listStartNum = cmark_node_get_list_start(node);
+    }
+}
+
+// Returns the text of the given cmark_node, which must be of the same
+// type as this node.
+//
+QString MarkdownNode::textOf(cmark_node *node) const
+{
+    if ((Link == m_type) || (Image == m_type)) {
+        return QString::fromUtf8(cmark_node_get_url(node));
+    } else if (Heading == m_type) {
+        return QString::fromUtf8(cmark_node_get_string_content(node)).simplified();
+    } else if (isFencedCodeBlock()) {
+        // Keep only the language, as in "python" for "{.python .numberLines}".
+        QString info = QString::fromUtf8(cmark_node_get_fence_info(node)).trimmed();
+        int end = 0;
+
+        while ((end < info.length()) && !info[end].isSpace() && ('}' != info[end])) {
+            end++;
+        }
+
+        int start = 0;
+
+        while ((start < end) && (('{' == info[start]) || ('.' == info[start]))) {
+            start++;
+        }
+
+        return info.mid(start, end - start);
+    } else if (!isBlockType()) {
+        return QString::fromUtf8(cmark_node_get_literal(node));
+    }
+
+    return QString();
+}
+
+void MarkdownNode::setDataFrom
+(
+    const MarkdownNode *node,
+    QString *textBuffer,
+    int lineOffset
+)
+{
+    m_type = node->m_type;
+    m_startLine = node->m_startLine;
+    m_endLine = node->m_endLine;
+    m_position = node->m_position;
+    m_length = node->m_length;
+    m_fenceChar = node->m_fenceChar;
+    m_headingLevel = node->m_headingLevel;
+    m_listStartNum = node->m_listStartNum;
+    m_cmarkNode = NULL;
+
+    if (node->m_textLength > 0) {
+        m_textBuffer = textBuffer;
+        m_textOffset = textBuffer->length();
+        m_textLength = node->m_textLength;
+        textBuffer->append(node->textRef());
+    } else {
+        m_textBuffer = NULL;
+        m_textOffset = 0;
+        m_textLength = 0;
+    }
+
+    shiftLines(lineOffset);
+}
+
+void MarkdownNode::writeData(QDataStream &stream) const
+{
+    stream
+        << (quint8) m_type
+        << (quint8) m_fenceChar
+        << (quint8) m_headingLevel
+        << (qint32) m_startLine
+        << (qint32) m_endLine
+        << (qint32) m_position
+        << (qint32) m_length
+        << (qint32) m_listStartNum
+        << text();
+}
+
+void MarkdownNode::readData(QDataStream &stream, QString *textBuffer)
+{
+    quint8 type;
+    quint8 fenceChar;
+    quint8 headingLevel;
+    qint32 startLine;
+    qint32 endLine;
+    qint32 position;
+    qint32 length;
+    qint32 listStartNum;
+    QString text;
+
+    stream
+        >> type
+        >> fenceChar
+        >> headingLevel
+        >> startLine
+        >> endLine
+        >> position
+        >> length
+        >> listStartNum
+        >> text;
+
+    m_type = (type <= LastInlineType) ? type : Invalid;
+    m_fenceChar = fenceChar;
+    m_headingLevel = headingLevel;
+    m_startLine = startLine;
+    m_endLine = endLine;
+    m_position = position;
+    m_length = length;
+    m_listStartNum = listStartNum;
+    m_cmarkNode = NULL;
+    setText(text, textBuffer);
+}
+
+void MarkdownNode::setText(const QString &text, QString *textBuffer)
+{
+    if (text.isEmpty() || (NULL == textBuffer)) {
+        m_textBuffer = NULL;
+        m_textOffset = 0;
+        m_textLength = 0;
+        return;
     }
+
+    m_textBuffer = textBuffer;
+    m_textOffset = textBuffer->length();
+    m_textLength = text.length();
+    textBuffer->append(text);
 }
 
 MarkdownNode *MarkdownNode::parent() const
@@ -120,6 +299,51 @@ void MarkdownNode::appendChild(MarkdownNode *node)
     }
 }
 
+void MarkdownNode::insertChildBefore(MarkdownNode *node, MarkdownNode *sibling)
+{
+    if (NULL == sibling) {
+        appendChild(node);
+        return;
+    }
+
+    if (NULL != node) {
+        node->m_parent = this;
+        node->m_next = sibling;
+        node->m_prev = sibling->m_prev;
+
+        if (NULL == sibling->m_prev) {
+            m_firstChild = node;
+        } else {
+            sibling->m_prev->m_next = node;
+        }
+
+        sibling->m_prev = node;
+    }
+}
+
+void MarkdownNode::removeChild(MarkdownNode *node)
+{
+    if ((NULL == node) || (node->m_parent != this)) {
+        return;
+    }
+
+    if (NULL == node->m_prev) {
+        m_firstChild = node->m_next;
+    } else {
+        node->m_prev->m_next = node->m_next;
+    }
+
+    if (NULL == node->m_next) {
+        m_lastChild = node->m_prev;
+    } else {
+        node->m_next->m_prev = node->m_prev;
+    }
+
+    node->m_parent = NULL;
+    node->m_prev = NULL;
+    node->m_next = NULL;
+}
+
 MarkdownNode *MarkdownNode::firstChild() const
 {
     return m_firstChild;
@@ -165,7 +389,7 @@ QString MarkdownNode::toString() const
            .arg(endLine())
            .arg(position())
            .arg(length())
-           .arg(toString(m_type))
+           .arg(toString(type()))
            .arg(this->text().left(left) + "..." + this->text().right(right));
 }
 
@@ -176,7 +400,7 @@ bool MarkdownNode::isInvalid() const
 
 MarkdownNode::NodeType MarkdownNode::type() const
 {
-    return m_type;
+    return (NodeType) m_type;
 }
 
 int MarkdownNode::position() const
@@ -199,9 +423,64 @@ int MarkdownNode::endLine() const
     return m_endLine;
 }
 
+void MarkdownNode::shiftLines(int delta)
+{
+    // A line number of zero means that cmark-gfm did not provide
+    // one, so leave it as is.
+    if (0 != m_startLine) {
+        m_startLine += delta;
+    }
+
+    if (0 != m_endLine) {
+        m_endLine += delta;
+    }
+}
+
+void MarkdownNode::setEndLine(int line)
+{
+    m_endLine = line;
+}
+
 QString MarkdownNode::text() const
 {
-    return m_text;
+    if (NULL == m_textBuffer) {
+        return QString();
+    }
+
+    return m_textBuffer->mid(m_textOffset, m_textLength);
+}
+
+QStringRef MarkdownNode::textRef() const
+{
+    // Reference a null string rather than no string at all for empty
+    // nodes, so that callers can safely index into the reference the same
+    // as they would with an empty QString.
+    //
+    static const QString nullText;
+
+    if (NULL == m_textBuffer) {
+        return QStringRef(&nullText);
+    }
+
+    return QStringRef(m_textBuffer, m_textOffset, m_textLength);
+}
+
+QString MarkdownNode::literal() const
+{
+    if (NULL == m_cmarkNode) {
+        return QString();
+    }
+
+    if (CodeBlock == m_type) {
+        return QString::fromUtf8(cmark_node_get_literal(m_cmarkNode));
+    } else if (FootnoteDefinition == m_type) {
+        // cmark_node_get_literal() does not give out the label of footnote
+        // definitions, which the parser keeps without the brackets and caret.
+        const cmark_chunk &label = m_cmarkNode->as.literal;
+        return QString::fromUtf8((const char *) label.data, label.len);
+    }
+
+    return QString();
 }
 
 bool MarkdownNode::isBlockType() const
@@ -294,6 +573,11 @@ int MarkdownNode::listItemNumber() const
     return startNum + count;
 }
 
+int MarkdownNode::listStart() const
+{
+    return (NumberedList == m_type) ? m_listStartNum : 0;
+}
+
 bool MarkdownNode::isBulletListItem() const
 {
     return
@@ -378,7 +662,7 @@ MarkdownNode::NodeType MarkdownNode::nodeType(cmark_node *node)
     return Invalid;
 }
 
-QString MarkdownNode::toString(NodeType nodeType) const
+QString MarkdownNode::toString(NodeType nodeType)
 {
     switch (nodeType) {
     case MarkdownNode::Invalid:
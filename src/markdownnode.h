@@ -24,11 +24,24 @@
 #include <QString>
 
 class cmark_node;
+class QDataStream;
 
 namespace ghostwriter
 {
+class Utf8ColumnMap;
+
 /**
  * Markdown node wrapper for cmark-gfm node.
+ *
+ * Nodes do not own their text.  Instead, the text of each node is stored
+ * as an offset and length into a text buffer shared by all the nodes of
+ * the same AST, which avoids a heap allocation per node.  The buffer must
+ * outlive the node.
+ *
+ * A node may also be a view of a cmark_node, in which case it keeps a
+ * pointer to the cmark_node, which must then outlive the node as well.
+ * The text of a view is still decoded into the buffer up front, so that
+ * the nodes of an AST can be read from several threads at once.
  */
 class MarkdownNode
 {
@@ -81,11 +94,15 @@ public:
     MarkdownNode();
 
     /**
-     * Constructor.  Copies data from provided cmark_node.
+     * Constructor.  Copies data from provided cmark_node, appending
+     * its text to the given text buffer.  See setDataFrom() regarding
+     * the column map.
      */
     MarkdownNode
     (
-        cmark_node *node
+        cmark_node *node,
+        QString *textBuffer,
+        const Utf8ColumnMap *columns = nullptr
     );
 
     /**
@@ -94,15 +111,64 @@ public:
     ~MarkdownNode();
 
     /**
-     * Copies data from the provided cmark_node.
+     * Copies data from the provided cmark_node, appending its text
+     * to the given text buffer.  If given a column map for the UTF-8 text
+     * that the node was parsed from, the node's position and length are
+     * converted from bytes to QChars with it.
+     */
+    void setDataFrom
+    (
+        cmark_node *node,
+        QString *textBuffer,
+        const Utf8ColumnMap *columns = nullptr
+    );
+
+    /**
+     * Makes this node a view of the provided cmark_node, which must
+     * outlive this node.  The same as setDataFrom(), except that the
+     * node keeps a pointer to the cmark_node.
      */
-    void setDataFrom(cmark_node *node);
+    void setViewOf
+    (
+        cmark_node *node,
+        QString *textBuffer,
+        const Utf8ColumnMap *columns = nullptr
+    );
+
+    /**
+     * Copies data (but not the tree links) from the provided node,
+     * appending its text to the given text buffer and adding
+     * lineOffset to its start and end lines.
+     */
+    void setDataFrom
+    (
+        const MarkdownNode *node,
+        QString *textBuffer,
+        int lineOffset = 0
+    );
+
+    /**
+     * Writes the data (but not the tree links) of this node to the given
+     * stream, such as for caching the AST on disk.
+     */
+    void writeData(QDataStream &stream) const;
+
+    /**
+     * Reads the data written by writeData() from the given stream,
+     * appending the node's text to the given text buffer.
+     */
+    void readData(QDataStream &stream, QString *textBuffer);
 
     /**
      * Returns a string representation of this node.
      */
     QString toString() const;
 
+    /**
+     * Returns the name of the given node type.
+     */
+    static QString toString(NodeType nodeType);
+
     /**
      * Returns whether this node has valid data.
      */
@@ -118,6 +184,18 @@ public:
      */
     void appendChild(MarkdownNode *node);
 
+    /**
+     * Inserts the given node as a child to this node, placing it
+     * immediately before the given sibling.  If sibling is null,
+     * the node is appended as the last child.
+     */
+    void insertChildBefore(MarkdownNode *node, MarkdownNode *sibling);
+
+    /**
+     * Unlinks the given child node (and its subtree) from this node.
+     */
+    void removeChild(MarkdownNode *node);
+
     /**
      * Returns the first child of this node.
      */
@@ -169,10 +247,38 @@ public:
     int endLine() const;
 
     /**
-     * Returns the text contained in this node.
+     * Shifts the start and end lines of this node (but not of its
+     * children) by the given number of lines.
+     */
+    void shiftLines(int delta);
+
+    /**
+     * Sets the end line of this node in the original Markdown text.
+     */
+    void setEndLine(int line);
+
+    /**
+     * Returns the text contained in this node, the destination URL if
+     * this node is a link or an image, or the language named in the info
+     * string if this node is a fenced code block.
      */
     QString text() const;
 
+    /**
+     * Returns a reference to the text contained in this node, without
+     * copying it out of the AST's text buffer.  Prefer this method over
+     * text() in performance-sensitive code.
+     */
+    QStringRef textRef() const;
+
+    /**
+     * Returns the contents of this node if it has a code block type, or
+     * the label if it has a footnote definition type, as kept by the
+     * cmark_node that this node is a view of.  Returns an empty string
+     * for other nodes, and for nodes that are not views.
+     */
+    QString literal() const;
+
     /**
      * Returns true of this node has a block type.
      */
@@ -220,24 +326,28 @@ public:
      */
     int listItemNumber() const;
 
+    /**
+     * Returns the number of the first item if this node has a numbered
+     * list type, otherwise 0.
+     */
+    int listStart() const;
+
     /**
      * Returns true if this node has a bullet list item type.
      */
     bool isBulletListItem() const;
 
 private:
-    NodeType m_type;
-    MarkdownNode *m_parent;
-    MarkdownNode *m_prev;
-    MarkdownNode *m_next;
-    MarkdownNode *m_firstChild;
-    MarkdownNode *m_lastChild;
-    QString m_text;
+    // Hot fields that are read during searches and highlighting are
+    // kept together at the start of the node.
     int m_startLine;
     int m_endLine;
     int m_position;
     int m_length;
 
+    // NodeType value, stored in a single byte.
+    unsigned char m_type;
+
     // NOTE: Don't encapsulate any of the following fields
     //       in a union construct, as alignment padding will
     //       negate the space-saving benefit.
@@ -248,12 +358,28 @@ private:
     // Heading level if node is a heading.
     unsigned char m_headingLevel;
 
-    // Numbered list starting number if node is a numbered list item.
+    MarkdownNode *m_parent;
+    MarkdownNode *m_prev;
+    MarkdownNode *m_next;
+    MarkdownNode *m_firstChild;
+    MarkdownNode *m_lastChild;
+
+    // Location of this node's text in the AST's shared text buffer.
+    QString *m_textBuffer;
+    int m_textOffset;
+    int m_textLength;
+
+    // Number of the first item if node is a numbered list.
     int m_listStartNum;
 
-    NodeType nodeType(cmark_node *node);
+    // cmark_node that this node is a view of, if any.
+    cmark_node *m_cmarkNode;
+
+    void setFieldsFrom(cmark_node *node, const Utf8ColumnMap *columns);
+    QString textOf(cmark_node *node) const;
+    void setText(const QString &text, QString *textBuffer);
 
-    QString toString(NodeType nodeType) const;
+    NodeType nodeType(cmark_node *node);
 };
 } // namespace ghostwriter
 
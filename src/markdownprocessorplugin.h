@@ -0,0 +1,111 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef MARKDOWN_PROCESSOR_PLUGIN_H
+#define MARKDOWN_PROCESSOR_PLUGIN_H
+
+#include <QString>
+#include <QStringList>
+#include <QtPlugin>
+
+namespace ghostwriter
+{
+/**
+ * Interface for plugins providing a Markdown processor that runs
+ * in-process, so that rendering the live preview and exporting need not
+ * launch a command each time.  A plugin is a shared library built with
+ * Qt's plugin system, whose plugin class implements this interface, and
+ * declares it with Q_INTERFACES() and Q_PLUGIN_METADATA() using
+ * GW_MARKDOWN_PROCESSOR_PLUGIN_IID.  Plugins are loaded at startup from
+ * the plugins directories of the application and of the user's settings.
+ *
+ * Note that rendering and exporting are done on worker threads, possibly
+ * several at once, so the methods of this interface must be reentrant.
+ * Only the standard Qt types are part of this interface, so that plugins
+ * need not link against the application.
+ */
+class MarkdownProcessorPlugin
+{
+public:
+    /**
+     * Destructor.
+     */
+    virtual ~MarkdownProcessorPlugin() { }
+
+    /**
+     * Gets the name of the processor, as shown to the user.  The name
+     * should be unique among processors.
+     */
+    virtual QString name() const = 0;
+
+    /**
+     * Gets the version of the processor.  Exports are redone whenever the
+     * version changes, even if the text did not.
+     */
+    virtual QString version() const = 0;
+
+    /**
+     * Gets the names of the formats to which the processor can export
+     * files, as named in the Export dialog, such as "HTML" or
+     * "Word Document".
+     */
+    virtual QStringList fileFormats() const = 0;
+
+    /**
+     * Returns true if the processor can render HTML for the live preview.
+     */
+    virtual bool isHtmlSupported() const = 0;
+
+    /**
+     * Renders the given text to HTML for the live preview, setting the
+     * html parameter to the HTML body.  Returns false and sets err to an
+     * error message if rendering fails.
+     */
+    virtual bool renderToHtml
+    (
+        const QString &text,
+        bool smartTypographyEnabled,
+        QString &html,
+        QString &err
+    ) = 0;
+
+    /**
+     * Exports the given text to the format with the given name and to the
+     * given output file path.  The input file path is that of the
+     * document, and is empty if the document is new and untitled.
+     * Returns false and sets err to an error message if exporting fails.
+     */
+    virtual bool exportToFile
+    (
+        const QString &formatName,
+        const QString &inputFilePath,
+        const QString &text,
+        const QString &outputFilePath,
+        bool smartTypographyEnabled,
+        QString &err
+    ) = 0;
+};
+} // namespace ghostwriter
+
+#define GW_MARKDOWN_PROCESSOR_PLUGIN_IID \
+    "io.github.wereturtle.ghostwriter.MarkdownProcessorPlugin/1.0"
+
+Q_DECLARE_INTERFACE(ghostwriter::MarkdownProcessorPlugin, GW_MARKDOWN_PROCESSOR_PLUGIN_IID)
+
+#endif // MARKDOWN_PROCESSOR_PLUGIN_H
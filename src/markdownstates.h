@@ -30,7 +30,10 @@ namespace ghostwriter
 * such as a block quote or code block.  The next byte is for the line
 * state, and the final 2 bytes are used to specify the nesting depth
 * (for elements contained within a list).  Use MarkdownStateMask to
-* extract only the middle line state byte.
+* extract only the middle line state byte.  The upper bits of the first
+* byte carry the state of the lexer of the code in a fenced code block
+* over to the next line.  Use MarkdownStateCodeLexerMask and
+* MarkdownStateCodeLexerShift to extract it.
 */
 typedef int MarkdownState;
 
@@ -56,6 +59,8 @@ const MarkdownState MarkdownStateBlockquote           = 0x02000000;
 const MarkdownState MarkdownStateCodeBlock            = 0x04000000;
 
 const MarkdownState MarkdownStateMask                 = 0x00FF0000;
+const MarkdownState MarkdownStateCodeLexerMask        = 0x78000000;
+const int MarkdownStateCodeLexerShift                 = 27;
 } // namespace ghostwriter
 
 #endif // MARKDOWN_STATES_H
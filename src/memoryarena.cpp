@@ -20,22 +20,20 @@
 #ifndef MEMORY_ARENA_CPP
 #define MEMORY_ARENA_CPP
 
-#include <QLinkedListIterator>
-
 #include "memoryarena.h"
 
 namespace ghostwriter
 {
 template<class T>
 MemoryArena<T>::MemoryArena() :
-    slotIndex(0), chunkSize(256)
+    chunkIndex(0), slotIndex(0), chunkSize(256)
 {
     ;
 }
 
 template<class T>
 MemoryArena<T>::MemoryArena(const size_t chunkSize) :
-    slotIndex(0), chunkSize(chunkSize)
+    chunkIndex(0), slotIndex(0), chunkSize(chunkSize)
 {
     ;
 }
@@ -49,29 +47,91 @@ MemoryArena<T>::~MemoryArena()
 template<class T>
 T *MemoryArena<T>::allocate()
 {
-    if (arena.empty() || (slotIndex >= (int)chunkSize)) {
-        arena.push(new Chunk(chunkSize));
+    if (slotIndex >= chunkSize) {
+        chunkIndex++;
         slotIndex = 0;
     }
 
-    int index = slotIndex;
+    if (chunkIndex >= chunks.size()) {
+        // Note that the slots are left uninitialized until allocated.
+        chunks.append(new Slot[chunkSize]);
+    }
+
+    Slot *slot = &(chunks[chunkIndex][slotIndex]);
     slotIndex++;
-    return &(arena.top()->data()[index]);
+
+    return new (slot) T();
+}
+
+template<class T>
+void MemoryArena<T>::reset()
+{
+    destroyAll();
+    chunkIndex = 0;
+    slotIndex = 0;
 }
 
 template<class T>
 void MemoryArena<T>::freeAll()
 {
-    while (!arena.isEmpty()) {
-        Chunk *chunk = arena.pop();
+    destroyAll();
 
-        if (nullptr != chunk) {
-            delete chunk;
-        }
+    for (int i = 0; i < chunks.size(); i++) {
+        delete [] chunks[i];
     }
 
+    chunks.clear();
+    chunkIndex = 0;
     slotIndex = 0;
 }
+
+template<class T>
+void MemoryArena<T>::trim()
+{
+    if ((0 == chunkIndex) && (0 == slotIndex)) {
+        freeAll();
+        return;
+    }
+
+    for (int i = chunkIndex + 1; i < chunks.size(); i++) {
+        delete [] chunks[i];
+    }
+
+    chunks.resize(chunkIndex + 1);
+    chunks.squeeze();
+}
+
+template<class T>
+size_t MemoryArena<T>::count() const
+{
+    if (chunks.isEmpty()) {
+        return 0;
+    }
+
+    return (chunkIndex * chunkSize) + slotIndex;
+}
+
+template<class T>
+size_t MemoryArena<T>::capacity() const
+{
+    return chunks.size() * chunkSize;
+}
+
+template<class T>
+void MemoryArena<T>::destroyAll()
+{
+    if (std::is_trivially_destructible<T>::value || chunks.isEmpty()) {
+        return;
+    }
+
+    for (int i = 0; i <= chunkIndex; i++) {
+        size_t used = (i < chunkIndex) ? chunkSize : slotIndex;
+
+        for (size_t j = 0; j < used; j++) {
+            reinterpret_cast<T *>(&(chunks[i][j]))->~T();
+        }
+    }
+}
 } // namespace ghostwriter
 
 #endif  // MEMORY_ARENA_CPP
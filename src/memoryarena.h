@@ -20,7 +20,10 @@
 #ifndef MEMORY_ARENA_H
 #define MEMORY_ARENA_H
 
-#include <QStack>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
 #include <QVector>
 
 namespace ghostwriter
@@ -31,6 +34,11 @@ namespace ghostwriter
  * parameters in class constructors.  Use this class to avoid
  * new/delete calls for each object allocated when there are many
  * objects of the same type being created and destroyed.
+ *
+ * Objects are bump-allocated from raw (uninitialized) chunks of memory,
+ * and are only constructed as they are allocated.  Call reset() rather
+ * than freeAll() to destroy all the objects while keeping the chunks
+ * around for reuse, so that refilling the arena does not allocate.
  */
 template <class T>
 class MemoryArena
@@ -57,16 +65,47 @@ public:
      */
     T *allocate();
 
+    /**
+     * Destroys all the objects in the arena, but retains the memory
+     * for reuse by subsequent calls to allocate().
+     */
+    void reset();
+
     /**
      * Frees all the memory in the arena.
      */
     void freeAll();
 
+    /**
+     * Frees the chunks that hold no objects, which reset() keeps around
+     * for reuse, while keeping the objects still allocated.
+     */
+    void trim();
+
+    /**
+     * Returns the number of objects allocated since the arena was last
+     * reset or freed.
+     */
+    size_t count() const;
+
+    /**
+     * Returns the number of objects the arena can hold without
+     * allocating more memory.
+     */
+    size_t capacity() const;
+
 private:
-    typedef QVector<T> Chunk;
-    QStack<Chunk *> arena;
-    int slotIndex;
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+    QVector<Slot *> chunks;
+
+    // Index of the chunk from which objects are being allocated, and
+    // the index of the next free slot in that chunk.
+    int chunkIndex;
+    size_t slotIndex;
     size_t chunkSize;
+
+    void destroyAll();
 };
 } // namespace ghostwriter
 
@@ -74,4 +113,4 @@ private:
 #include "memoryarena.cpp"
 #endif
 
-#endif
\ No newline at end of file
+#endif
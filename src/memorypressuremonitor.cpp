@@ -0,0 +1,109 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFile>
+
+#include "memorypressuremonitor.h"
+#include "memoryreport.h"
+
+namespace ghostwriter
+{
+MemoryPressureMonitor::MemoryPressureMonitor(QObject *parent)
+    : QObject(parent), ceiling(0), underPressure(false)
+{
+    pollTimer = new QTimer(this);
+    pollTimer->setInterval(PollInterval);
+    pollTimer->setTimerType(Qt::VeryCoarseTimer);
+
+    this->connect
+    (
+        pollTimer,
+        &QTimer::timeout,
+        [this]() {
+            check();
+        }
+    );
+
+    pollTimer->start();
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor()
+{
+    ;
+}
+
+bool MemoryPressureMonitor::isUnderPressure() const
+{
+    return underPressure;
+}
+
+void MemoryPressureMonitor::setResidentSetCeiling(int megabytes)
+{
+    ceiling = ((qint64) megabytes) * 1024 * 1024;
+    check();
+}
+
+void MemoryPressureMonitor::check()
+{
+    qint64 residentSetSize = (ceiling > 0) ? MemoryReport::readResidentSetSize() : 0;
+    double stall = readMemoryStall();
+
+    bool pressure;
+
+    if (underPressure) {
+        pressure =
+            ((ceiling > 0) && (residentSetSize > (ceiling * ReleasePercentage / 100)))
+            || (stall > (StallThreshold * ReleasePercentage / 100.0));
+    } else {
+        pressure =
+            ((ceiling > 0) && (residentSetSize > ceiling))
+            || (stall > StallThreshold);
+    }
+
+    if (pressure != underPressure) {
+        underPressure = pressure;
+        emit pressureChanged(underPressure);
+    }
+}
+
+// Returns the percentage of the last ten seconds during which some tasks
+// stalled waiting on memory, as reported by the kernel's pressure stall
+// information, or zero if it is not available on this system.
+//
+double MemoryPressureMonitor::readMemoryStall()
+{
+#ifdef Q_OS_LINUX
+    QFile file("/proc/pressure/memory");
+
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        // The first line reads, e.g.:
+        // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+        QList<QByteArray> fields = file.readLine().simplified().split(' ');
+
+        for (const QByteArray &field : fields) {
+            if (field.startsWith("avg10=")) {
+                return field.mid(6).toDouble();
+            }
+        }
+    }
+#endif
+
+    return 0.0;
+}
+} // namespace ghostwriter
@@ -0,0 +1,94 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef MEMORY_PRESSURE_MONITOR_H
+#define MEMORY_PRESSURE_MONITOR_H
+
+#include <QObject>
+#include <QTimer>
+
+namespace ghostwriter
+{
+/**
+ * Polls for memory pressure, so that caches can be shed and background
+ * work paused before the system starts swapping.  Memory is considered
+ * under pressure when the resident set size of the process exceeds a
+ * ceiling set by the user, or, on Linux, when the kernel's pressure stall
+ * information reports that tasks are stalled waiting on memory.  Pressure
+ * lifts only once both signals drop well below their thresholds, so that
+ * the state does not flap.
+ */
+class MemoryPressureMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.  The monitor starts polling right away.
+     */
+    MemoryPressureMonitor(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~MemoryPressureMonitor();
+
+    /**
+     * Returns whether memory is currently under pressure.
+     */
+    bool isUnderPressure() const;
+
+signals:
+    /**
+     * Emitted when memory comes under pressure, or when it no longer is.
+     */
+    void pressureChanged(bool underPressure);
+
+public slots:
+    /**
+     * Sets the resident set size, in megabytes, above which memory is
+     * under pressure.  Zero disables the ceiling.
+     */
+    void setResidentSetCeiling(int megabytes);
+
+    /**
+     * Checks for memory pressure right away, rather than at the next poll.
+     */
+    void check();
+
+private:
+    // Interval between polls, in milliseconds.
+    static const int PollInterval = 5000;
+
+    // Percentage of the last ten seconds during which some tasks stalled
+    // waiting on memory, beyond which memory is under pressure.
+    static const int StallThreshold = 10;
+
+    // Percentage of either threshold below which pressure lifts.
+    static const int ReleasePercentage = 80;
+
+    QTimer *pollTimer;
+    qint64 ceiling;
+    bool underPressure;
+
+    static double readMemoryStall();
+};
+} // namespace ghostwriter
+
+#endif // MEMORY_PRESSURE_MONITOR_H
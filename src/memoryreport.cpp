@@ -0,0 +1,175 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFile>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QTextStream>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+#include "htmlpreview.h"
+#include "markdownast.h"
+#include "markdowndocument.h"
+#include "memoryreport.h"
+#include "textblockdata.h"
+
+namespace ghostwriter
+{
+// Estimated bytes held by the document for each text block, in its
+// fragment and block maps, apart from the text itself.
+static const int BLOCK_OVERHEAD = 128;
+
+// Estimated bytes held by the layout of a laid out block for each
+// character, for its glyphs and their attributes, and for each line.
+static const int LAYOUT_CHARACTER_SIZE = 24;
+static const int LAYOUT_LINE_SIZE = 64;
+
+// Converts the given bytes to a string of kilobytes.
+//
+static QString toKilobytes(qint64 bytes)
+{
+    return QString::number(bytes / 1024.0, 'f', 1);
+}
+
+MemoryReport::MemoryReport(MarkdownDocument *document, HtmlPreview *preview)
+    : residentSetSize(readResidentSetSize())
+{
+    qint64 layoutBytes = 0;
+    qint64 blockDataBytes = 0;
+    qint64 formatBytes = 0;
+    qint64 misspellingBytes = 0;
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        QTextLayout *layout = block.layout();
+
+        if ((nullptr != layout) && (layout->lineCount() > 0)) {
+            layoutBytes += (block.length() * LAYOUT_CHARACTER_SIZE)
+                + (layout->lineCount() * LAYOUT_LINE_SIZE);
+        }
+
+        TextBlockData *blockData = (TextBlockData *) block.userData();
+
+        if (nullptr != blockData) {
+            blockDataBytes += sizeof(TextBlockData);
+            formatBytes += blockData->highlightFormats.capacity()
+                * sizeof(QTextLayout::FormatRange);
+            misspellingBytes += blockData->misspellings.capacity()
+                * sizeof(QPair<int, int>);
+        }
+    }
+
+    add(QObject::tr("Document text"), document->characterCount() * sizeof(QChar), true);
+    add(QObject::tr("Document blocks"), (qint64) document->blockCount() * BLOCK_OVERHEAD, true);
+    add(QObject::tr("Text layouts"), layoutBytes, true);
+    add(QObject::tr("Plain text snapshot"), document->snapshotMemory());
+    add(QObject::tr("Undo history"), document->undoMemory(), true);
+    add(QObject::tr("Block data"), blockDataBytes);
+    add(QObject::tr("Highlight formats"), formatBytes);
+    add(QObject::tr("Misspellings"), misspellingBytes);
+
+    MarkdownAST *ast = document->markdownAST();
+
+    if (nullptr != ast) {
+        add(QObject::tr("AST nodes"), ast->nodeMemory());
+        add(QObject::tr("AST text"), ast->textMemory());
+    }
+
+    if (nullptr != preview) {
+        add(QObject::tr("Preview HTML"), preview->htmlMemory());
+    }
+}
+
+MemoryReport::~MemoryReport()
+{
+    ;
+}
+
+qint64 MemoryReport::total() const
+{
+    qint64 bytes = 0;
+
+    foreach (const Entry &entry, entries) {
+        bytes += entry.bytes;
+    }
+
+    return bytes;
+}
+
+QString MemoryReport::toString() const
+{
+    QString text;
+    QTextStream stream(&text);
+
+    foreach (const Entry &entry, entries) {
+        stream << QString("%1 %2 KB%3\n")
+            .arg(entry.name, -24)
+            .arg(toKilobytes(entry.bytes), 12)
+            .arg(entry.estimated ? QObject::tr(" (estimate)") : QString());
+    }
+
+    stream << QString("%1 %2 KB\n")
+        .arg(QObject::tr("Total"), -24)
+        .arg(toKilobytes(total()), 12);
+
+    if (residentSetSize > 0) {
+        stream << QString("%1 %2 KB\n")
+            .arg(QObject::tr("Process resident set"), -24)
+            .arg(toKilobytes(residentSetSize), 12);
+    }
+
+    stream << "\n"
+        << QObject::tr("Spelling dictionaries and the preview page's own "
+            "memory are held outside of these structures and are not "
+            "included.")
+        << "\n";
+
+    stream.flush();
+    return text;
+}
+
+void MemoryReport::add(const QString &name, qint64 bytes, bool estimated)
+{
+    Entry entry;
+    entry.name = name;
+    entry.bytes = bytes;
+    entry.estimated = estimated;
+
+    entries.append(entry);
+}
+
+qint64 MemoryReport::readResidentSetSize()
+{
+#ifdef Q_OS_LINUX
+    QFile file("/proc/self/statm");
+
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QList<QByteArray> fields = file.readLine().split(' ');
+
+        if (fields.size() > 1) {
+            return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+#endif
+
+    return 0;
+}
+} // namespace ghostwriter
@@ -0,0 +1,85 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <QString>
+#include <QVector>
+
+namespace ghostwriter
+{
+class HtmlPreview;
+class MarkdownDocument;
+
+/**
+ * Accounts for the memory held by an open document and the structures
+ * derived from it:  the document's text and layouts, the per-block data
+ * of the statistics, highlighter and spell checker, the AST, and the HTML
+ * kept by the preview.  Sizes that Qt does not expose, such as those of
+ * the text layouts, are estimated.  The resident set size of the process
+ * is reported alongside, where the platform provides it, so that memory
+ * not accounted for stands out.
+ */
+class MemoryReport
+{
+public:
+    /**
+     * Constructor.  Measures the given document and, if not null, the
+     * given preview.
+     */
+    MemoryReport(MarkdownDocument *document, HtmlPreview *preview = nullptr);
+
+    /**
+     * Destructor.
+     */
+    ~MemoryReport();
+
+    /**
+     * Returns the total bytes accounted for.
+     */
+    qint64 total() const;
+
+    /**
+     * Returns a plain text breakdown of the memory accounted for.
+     */
+    QString toString() const;
+
+    /**
+     * Returns the resident set size of the process in bytes, or zero if
+     * it cannot be read on this platform.
+     */
+    static qint64 readResidentSetSize();
+
+private:
+    struct Entry
+    {
+        QString name;
+        qint64 bytes;
+        bool estimated;
+    };
+
+    QVector<Entry> entries;
+    qint64 residentSetSize;
+
+    void add(const QString &name, qint64 bytes, bool estimated = false);
+};
+} // namespace ghostwriter
+
+#endif // MEMORY_REPORT_H
@@ -0,0 +1,1145 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFile>
+#include <QObject>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QVector>
+
+#include "cmarkgfmapi.h"
+#include "markdownast.h"
+#include "markdownnode.h"
+#include "officedocumentwriter.h"
+#include "tracer.h"
+#include "zipwriter.h"
+
+namespace ghostwriter
+{
+namespace
+{
+const char XmlDeclaration[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+
+// Walks the nodes of a Markdown AST in document order, calling enter() on
+// reaching a node and leave() once done with its children.  The walk does
+// not recurse, so that deeply nested documents cannot exhaust the stack.
+//
+class MarkdownVisitor
+{
+public:
+    virtual ~MarkdownVisitor()
+    {
+        ;
+    }
+
+    void walk(const MarkdownNode *root)
+    {
+        const MarkdownNode *node = root;
+
+        while (nullptr != node) {
+            if (enter(node) && (nullptr != node->firstChild())) {
+                node = node->firstChild();
+                continue;
+            }
+
+            // Leave the node, and then each ancestor of which it is the
+            // last child, up to the next sibling to enter.
+            while (nullptr != node) {
+                leave(node);
+
+                if (root == node) {
+                    node = nullptr;
+                } else if (nullptr != node->next()) {
+                    node = node->next();
+                    break;
+                } else {
+                    node = node->parent();
+                }
+            }
+        }
+    }
+
+protected:
+    // Returns false to skip the children of the node.  The node is left
+    // all the same.
+    virtual bool enter(const MarkdownNode *node) = 0;
+    virtual void leave(const MarkdownNode *node) = 0;
+};
+
+// Visitor that writes the XML of a word processing document.
+//
+class OfficeWriter : public MarkdownVisitor
+{
+public:
+    // Adds the parts of the document to the archive, once walked.
+    virtual bool writeParts(ZipWriter &zip) = 0;
+
+protected:
+    QString body;
+
+    // Returns the contents of the given code block, without the line
+    // break that ends its last line.
+    //
+    static QString codeBlockText(const MarkdownNode *node)
+    {
+        QString code = node->literal();
+
+        if (code.endsWith('\n')) {
+            code.chop(1);
+        }
+
+        return code;
+    }
+
+    // Escapes the given text for XML, dropping the characters that XML
+    // does not allow.
+    //
+    static QString escaped(const QString &text)
+    {
+        QString result;
+        result.reserve(text.length());
+
+        for (const QChar c : text) {
+            ushort code = c.unicode();
+
+            if ('&' == c) {
+                result += "&amp;";
+            } else if ('<' == c) {
+                result += "&lt;";
+            } else if ('>' == c) {
+                result += "&gt;";
+            } else if ('"' == c) {
+                result += "&quot;";
+            } else if
+            (
+                ((code < 0x20) && ('\t' != c) && ('\n' != c) && ('\r' != c))
+                || (0xFFFE == code)
+                || (0xFFFF == code)
+            ) {
+                continue;
+            } else {
+                result += c;
+            }
+        }
+
+        return result;
+    }
+};
+
+// Writes Office Open XML, as read by Microsoft Word.  Word processing
+// documents have no nesting but tables, so block quotes and lists are
+// written as indentation and numbering of flat paragraphs.
+//
+class DocxWriter : public OfficeWriter
+{
+public:
+    DocxWriter()
+        : bold(0),
+          italic(0),
+          strike(0),
+          linkDepth(0),
+          quoteDepth(0),
+          tableHeading(false),
+          inFootnote(false)
+    {
+        ;
+    }
+
+    bool writeParts(ZipWriter &zip)
+    {
+        zip.addFile("[Content_Types].xml", contentTypes());
+        zip.addFile("_rels/.rels", packageRelationships());
+        zip.addFile
+        (
+            "word/document.xml",
+            QByteArray(XmlDeclaration)
+                + "<w:document "
+                  "xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\" "
+                  "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+                  "<w:body>"
+                + body.toUtf8()
+                + "<w:sectPr/></w:body></w:document>"
+        );
+        zip.addFile("word/_rels/document.xml.rels", documentRelationships());
+        zip.addFile("word/styles.xml", styles());
+        return zip.addFile("word/numbering.xml", numbering());
+    }
+
+protected:
+    bool enter(const MarkdownNode *node)
+    {
+        switch (node->type()) {
+        case MarkdownNode::BlockQuote:
+            quoteDepth++;
+            break;
+        case MarkdownNode::BulletList:
+        case MarkdownNode::NumberedList:
+            beginList(node);
+            break;
+        case MarkdownNode::ListItem:
+        case MarkdownNode::TaskListItem:
+            if (!lists.isEmpty()) {
+                lists.last().itemPending = true;
+            }
+            break;
+        case MarkdownNode::Paragraph:
+            if (inFootnote) {
+                beginParagraph("FootnoteText");
+            } else if (quoteDepth > 0) {
+                beginParagraph("BlockText");
+            } else {
+                beginParagraph("BodyText");
+            }
+
+            if (!footnote.isEmpty()) {
+                run(footnote, QString(), true);
+                run(" ");
+                footnote.clear();
+            }
+            break;
+        case MarkdownNode::Heading:
+            beginParagraph(QString("Heading%1").arg(qBound(1, node->headingLevel(), 6)));
+            break;
+        case MarkdownNode::CodeBlock: {
+            beginParagraph("SourceCode");
+            QStringList code = codeBlockText(node).split('\n');
+
+            for (int i = 0; i < code.size(); i++) {
+                if (i > 0) {
+                    body += "<w:r><w:br/></w:r>";
+                }
+
+                run(code[i]);
+            }
+
+            body += "</w:p>";
+            return false;
+        }
+        case MarkdownNode::HtmlBlock:
+        case MarkdownNode::HtmlInline:
+            return false;
+        case MarkdownNode::ThematicBreak:
+            body +=
+                "<w:p><w:pPr><w:pBdr>"
+                "<w:bottom w:val=\"single\" w:sz=\"6\" w:space=\"1\" w:color=\"auto\"/>"
+                "</w:pBdr></w:pPr></w:p>";
+            return false;
+        case MarkdownNode::FootnoteDefinition:
+            inFootnote = true;
+            footnote = node->literal();
+            break;
+        case MarkdownNode::Table:
+            beginTable(node);
+            break;
+        case MarkdownNode::TableHeading:
+            tableHeading = true;
+            body += "<w:tr><w:trPr><w:tblHeader/></w:trPr>";
+            break;
+        case MarkdownNode::TableRow:
+            body += "<w:tr>";
+            break;
+        case MarkdownNode::TableCell:
+            body += "<w:tc><w:p><w:pPr><w:pStyle w:val=\"Compact\"/></w:pPr>";
+            break;
+        case MarkdownNode::Text:
+            run(node->text());
+            return false;
+        case MarkdownNode::Softbreak:
+            run(" ");
+            return false;
+        case MarkdownNode::Linebreak:
+            body += "<w:r><w:br/></w:r>";
+            return false;
+        case MarkdownNode::Code:
+            run(node->text(), "VerbatimChar");
+            return false;
+        case MarkdownNode::Emph:
+            italic++;
+            break;
+        case MarkdownNode::Strong:
+            bold++;
+            break;
+        case MarkdownNode::Strikethrough:
+            strike++;
+            break;
+        case MarkdownNode::Link:
+            links.append(node->text());
+            body += QString("<w:hyperlink r:id=\"rId%1\">").arg(FirstLinkId + links.size() - 1);
+            linkDepth++;
+            break;
+        case MarkdownNode::FootnoteReference:
+            run(node->text(), QString(), true);
+            return false;
+        default:
+            break;
+        }
+
+        return true;
+    }
+
+    void leave(const MarkdownNode *node)
+    {
+        switch (node->type()) {
+        case MarkdownNode::BlockQuote:
+            quoteDepth--;
+            break;
+        case MarkdownNode::BulletList:
+        case MarkdownNode::NumberedList:
+            lists.removeLast();
+            break;
+        case MarkdownNode::Paragraph:
+        case MarkdownNode::Heading:
+            body += "</w:p>";
+            break;
+        case MarkdownNode::FootnoteDefinition:
+            inFootnote = false;
+            footnote.clear();
+            break;
+        case MarkdownNode::Table:
+            // Keep adjacent tables from being merged into one.
+            body += "</w:tbl><w:p/>";
+            break;
+        case MarkdownNode::TableHeading:
+            tableHeading = false;
+            body += "</w:tr>";
+            break;
+        case MarkdownNode::TableRow:
+            body += "</w:tr>";
+            break;
+        case MarkdownNode::TableCell:
+            body += "</w:p></w:tc>";
+            break;
+        case MarkdownNode::Emph:
+            italic--;
+            break;
+        case MarkdownNode::Strong:
+            bold--;
+            break;
+        case MarkdownNode::Strikethrough:
+            strike--;
+            break;
+        case MarkdownNode::Link:
+            body += "</w:hyperlink>";
+            linkDepth--;
+            break;
+        default:
+            break;
+        }
+    }
+
+private:
+    // Relationship IDs of the document part.  The styles and numbering
+    // come first, followed by the targets of the links.
+    static const int StylesId = 1;
+    static const int NumberingId = 2;
+    static const int FirstLinkId = 3;
+
+    // Word numbers at most nine levels of lists.
+    static const int MaxListLevel = 8;
+
+    // List being written, with whether its item has yet to write its
+    // first paragraph, which is the one to be numbered.
+    struct List
+    {
+        int numId;
+        bool itemPending;
+    };
+
+    int bold;
+    int italic;
+    int strike;
+    int linkDepth;
+    int quoteDepth;
+    bool tableHeading;
+    bool inFootnote;
+    QString footnote;
+    QVector<List> lists;
+    QStringList nums;
+    QStringList links;
+
+    void beginList(const MarkdownNode *node)
+    {
+        int level = qMin(lists.size(), (int) MaxListLevel);
+        int numId = nums.size() + 1;
+
+        // Each list gets numbering of its own, so that numbered lists
+        // start again from their first number.
+        if (MarkdownNode::NumberedList == node->type()) {
+            nums.append
+            (
+                QString
+                (
+                    "<w:num w:numId=\"%1\"><w:abstractNumId w:val=\"1\"/>"
+                    "<w:lvlOverride w:ilvl=\"%2\"><w:startOverride w:val=\"%3\"/></w:lvlOverride>"
+                    "</w:num>"
+                ).arg(numId).arg(level).arg(node->listStart())
+            );
+        } else {
+            nums.append
+            (
+                QString("<w:num w:numId=\"%1\"><w:abstractNumId w:val=\"0\"/></w:num>")
+                    .arg(numId)
+            );
+        }
+
+        List list;
+        list.numId = numId;
+        list.itemPending = false;
+        lists.append(list);
+    }
+
+    void beginParagraph(const QString &style)
+    {
+        body += "<w:p><w:pPr><w:pStyle w:val=\"" + style + "\"/>";
+
+        if (!lists.isEmpty() && lists.last().itemPending) {
+            body += QString("<w:numPr><w:ilvl w:val=\"%1\"/><w:numId w:val=\"%2\"/></w:numPr>")
+                .arg(qMin(lists.size() - 1, (int) MaxListLevel))
+                .arg(lists.last().numId);
+            lists.last().itemPending = false;
+        } else {
+            int indent = quoteDepth + lists.size();
+
+            if (indent > 0) {
+                body += QString("<w:ind w:left=\"%1\"/>").arg(indent * 720);
+            }
+        }
+
+        body += "</w:pPr>";
+    }
+
+    void beginTable(const MarkdownNode *node)
+    {
+        int columns = 0;
+
+        if (nullptr != node->firstChild()) {
+            for
+            (
+                const MarkdownNode *cell = node->firstChild()->firstChild();
+                nullptr != cell;
+                cell = cell->next()
+            ) {
+                columns++;
+            }
+        }
+
+        body +=
+            "<w:tbl><w:tblPr><w:tblStyle w:val=\"Table\"/>"
+            "<w:tblW w:w=\"0\" w:type=\"auto\"/></w:tblPr><w:tblGrid>";
+
+        for (int i = 0; i < columns; i++) {
+            body += QString("<w:gridCol w:w=\"%1\"/>").arg(9000 / qMax(columns, 1));
+        }
+
+        body += "</w:tblGrid>";
+    }
+
+    // Writes a run of text with the formatting of the inlines that it is
+    // nested in.
+    void run(const QString &text, const QString &style = QString(), bool superscript = false)
+    {
+        if (text.isEmpty()) {
+            return;
+        }
+
+        QString properties;
+
+        if (!style.isEmpty()) {
+            properties += "<w:rStyle w:val=\"" + style + "\"/>";
+        } else if (linkDepth > 0) {
+            properties += "<w:rStyle w:val=\"Hyperlink\"/>";
+        }
+
+        if ((bold > 0) || tableHeading) {
+            properties += "<w:b/>";
+        }
+
+        if (italic > 0) {
+            properties += "<w:i/>";
+        }
+
+        if (strike > 0) {
+            properties += "<w:strike/>";
+        }
+
+        if (superscript) {
+            properties += "<w:vertAlign w:val=\"superscript\"/>";
+        }
+
+        body += "<w:r>";
+
+        if (!properties.isEmpty()) {
+            body += "<w:rPr>" + properties + "</w:rPr>";
+        }
+
+        body +=
+            "<w:t xml:space=\"preserve\">"
+            + escaped(text).replace('\t', "</w:t><w:tab/><w:t xml:space=\"preserve\">")
+            + "</w:t></w:r>";
+    }
+
+    static QByteArray contentTypes()
+    {
+        return QByteArray(XmlDeclaration)
+            + "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+              "<Default Extension=\"rels\" "
+              "ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+              "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+              "<Override PartName=\"/word/document.xml\" "
+              "ContentType=\"application/vnd.openxmlformats-officedocument.wordprocessingml.document.main+xml\"/>"
+              "<Override PartName=\"/word/styles.xml\" "
+              "ContentType=\"application/vnd.openxmlformats-officedocument.wordprocessingml.styles+xml\"/>"
+              "<Override PartName=\"/word/numbering.xml\" "
+              "ContentType=\"application/vnd.openxmlformats-officedocument.wordprocessingml.numbering+xml\"/>"
+              "</Types>";
+    }
+
+    static QByteArray packageRelationships()
+    {
+        return QByteArray(XmlDeclaration)
+            + "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+              "<Relationship Id=\"rId1\" "
+              "Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" "
+              "Target=\"word/document.xml\"/>"
+              "</Relationships>";
+    }
+
+    QByteArray documentRelationships() const
+    {
+        QString xml =
+            QString
+            (
+                "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+                "<Relationship Id=\"rId%1\" "
+                "Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" "
+                "Target=\"styles.xml\"/>"
+                "<Relationship Id=\"rId%2\" "
+                "Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/numbering\" "
+                "Target=\"numbering.xml\"/>"
+            ).arg(StylesId).arg(NumberingId);
+
+        for (int i = 0; i < links.size(); i++) {
+            xml += QString
+                (
+                    "<Relationship Id=\"rId%1\" "
+                    "Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/hyperlink\" "
+                    "Target=\"%2\" TargetMode=\"External\"/>"
+                ).arg(FirstLinkId + i).arg(escaped(links[i]));
+        }
+
+        xml += "</Relationships>";
+        return QByteArray(XmlDeclaration) + xml.toUtf8();
+    }
+
+    QByteArray numbering() const
+    {
+        static const QStringList bullets = { QString(QChar(0x2022)), QString(QChar(0x25E6)), QString(QChar(0x25AA)) };
+
+        QString xml =
+            "<w:numbering xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\">";
+
+        // Abstract numbering 0 is for bullet lists, and 1 for numbered
+        // lists.
+        for (int numbered = 0; numbered < 2; numbered++) {
+            xml += QString
+                (
+                    "<w:abstractNum w:abstractNumId=\"%1\">"
+                    "<w:multiLevelType w:val=\"hybridMultilevel\"/>"
+                ).arg(numbered);
+
+            for (int level = 0; level <= MaxListLevel; level++) {
+                // Numbered levels are labeled by the number of their own
+                // level only, as in "%2." for the second level.
+                QString label = numbered
+                    ? QString("%") + QString::number(level + 1) + "."
+                    : bullets[level % bullets.size()];
+
+                xml += QString
+                    (
+                        "<w:lvl w:ilvl=\"%1\"><w:start w:val=\"1\"/>"
+                        "<w:numFmt w:val=\"%2\"/><w:lvlText w:val=\"%3\"/>"
+                        "<w:lvlJc w:val=\"left\"/>"
+                        "<w:pPr><w:ind w:left=\"%4\" w:hanging=\"360\"/></w:pPr></w:lvl>"
+                    ).arg
+                    (
+                        QString::number(level),
+                        QString(numbered ? "decimal" : "bullet"),
+                        label,
+                        QString::number((level + 1) * 720)
+                    );
+            }
+
+            xml += "</w:abstractNum>";
+        }
+
+        xml += nums.join(QString());
+        xml += "</w:numbering>";
+
+        return QByteArray(XmlDeclaration) + xml.toUtf8();
+    }
+
+    static QByteArray styles()
+    {
+        static const int headingSizes[] = { 36, 32, 28, 26, 24, 24 };
+
+        QString xml =
+            "<w:styles xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\">"
+            "<w:docDefaults><w:rPrDefault><w:rPr><w:sz w:val=\"24\"/></w:rPr></w:rPrDefault>"
+            "<w:pPrDefault><w:pPr><w:spacing w:after=\"160\"/></w:pPr></w:pPrDefault></w:docDefaults>"
+            "<w:style w:type=\"paragraph\" w:default=\"1\" w:styleId=\"Normal\">"
+            "<w:name w:val=\"Normal\"/><w:qFormat/></w:style>"
+            "<w:style w:type=\"paragraph\" w:styleId=\"BodyText\">"
+            "<w:name w:val=\"Body Text\"/><w:basedOn w:val=\"Normal\"/><w:qFormat/></w:style>"
+            "<w:style w:type=\"paragraph\" w:styleId=\"Compact\">"
+            "<w:name w:val=\"Compact\"/><w:basedOn w:val=\"BodyText\"/>"
+            "<w:pPr><w:spacing w:before=\"36\" w:after=\"36\"/></w:pPr></w:style>"
+            "<w:style w:type=\"paragraph\" w:styleId=\"BlockText\">"
+            "<w:name w:val=\"Block Text\"/><w:basedOn w:val=\"BodyText\"/>"
+            "<w:pPr><w:ind w:left=\"720\" w:right=\"720\"/></w:pPr>"
+            "<w:rPr><w:i/></w:rPr></w:style>"
+            "<w:style w:type=\"paragraph\" w:styleId=\"SourceCode\">"
+            "<w:name w:val=\"Source Code\"/><w:basedOn w:val=\"Normal\"/>"
+            "<w:pPr><w:wordWrap w:val=\"0\"/></w:pPr>"
+            "<w:rPr><w:rFonts w:ascii=\"Consolas\" w:hAnsi=\"Consolas\" w:cs=\"Consolas\"/>"
+            "<w:sz w:val=\"20\"/></w:rPr></w:style>"
+            "<w:style w:type=\"paragraph\" w:styleId=\"FootnoteText\">"
+            "<w:name w:val=\"Footnote Text\"/><w:basedOn w:val=\"Normal\"/>"
+            "<w:rPr><w:sz w:val=\"20\"/></w:rPr></w:style>";
+
+        for (int level = 1; level <= 6; level++) {
+            xml += QString
+                (
+                    "<w:style w:type=\"paragraph\" w:styleId=\"Heading%1\">"
+                    "<w:name w:val=\"heading %1\"/><w:basedOn w:val=\"Normal\"/>"
+                    "<w:next w:val=\"BodyText\"/><w:qFormat/>"
+                    "<w:pPr><w:keepNext/><w:spacing w:before=\"240\" w:after=\"80\"/>"
+                    "<w:outlineLvl w:val=\"%2\"/></w:pPr>"
+                    "<w:rPr><w:b/><w:sz w:val=\"%3\"/></w:rPr></w:style>"
+                ).arg(level).arg(level - 1).arg(headingSizes[level - 1]);
+        }
+
+        xml +=
+            "<w:style w:type=\"character\" w:styleId=\"VerbatimChar\">"
+            "<w:name w:val=\"Verbatim Char\"/>"
+            "<w:rPr><w:rFonts w:ascii=\"Consolas\" w:hAnsi=\"Consolas\" w:cs=\"Consolas\"/>"
+            "<w:sz w:val=\"20\"/></w:rPr></w:style>"
+            "<w:style w:type=\"character\" w:styleId=\"Hyperlink\">"
+            "<w:name w:val=\"Hyperlink\"/>"
+            "<w:rPr><w:color w:val=\"0563C1\"/><w:u w:val=\"single\"/></w:rPr></w:style>"
+            "<w:style w:type=\"table\" w:styleId=\"Table\">"
+            "<w:name w:val=\"Table\"/><w:tblPr><w:tblBorders>"
+            "<w:top w:val=\"single\" w:sz=\"4\" w:space=\"0\" w:color=\"auto\"/>"
+            "<w:left w:val=\"single\" w:sz=\"4\" w:space=\"0\" w:color=\"auto\"/>"
+            "<w:bottom w:val=\"single\" w:sz=\"4\" w:space=\"0\" w:color=\"auto\"/>"
+            "<w:right w:val=\"single\" w:sz=\"4\" w:space=\"0\" w:color=\"auto\"/>"
+            "<w:insideH w:val=\"single\" w:sz=\"4\" w:space=\"0\" w:color=\"auto\"/>"
+            "<w:insideV w:val=\"single\" w:sz=\"4\" w:space=\"0\" w:color=\"auto\"/>"
+            "</w:tblBorders></w:tblPr></w:style>"
+            "</w:styles>";
+
+        return QByteArray(XmlDeclaration) + xml.toUtf8();
+    }
+};
+
+// Writes OpenDocument Text, as read by LibreOffice.  Unlike Word, it nests
+// lists the way Markdown does.
+//
+class OdtWriter : public OfficeWriter
+{
+public:
+    OdtWriter()
+        : quoteDepth(0),
+          tableCount(0),
+          tableHeading(false),
+          inFootnote(false),
+          startValue(1)
+    {
+        ;
+    }
+
+    bool writeParts(ZipWriter &zip)
+    {
+        // The media type must come first, and be stored as is, so that
+        // the file type can be told from a fixed offset into the file.
+        zip.addFile("mimetype", "application/vnd.oasis.opendocument.text", false);
+        zip.addFile("META-INF/manifest.xml", manifest());
+        zip.addFile
+        (
+            "content.xml",
+            QByteArray(XmlDeclaration)
+                + "<office:document-content " + Namespaces + " office:version=\"1.2\">"
+                  "<office:automatic-styles>"
+                  "<style:style style:name=\"TableCell\" style:family=\"table-cell\">"
+                  "<style:table-cell-properties fo:padding=\"0.04in\" "
+                  "fo:border=\"0.5pt solid #000000\"/></style:style>"
+                  "</office:automatic-styles>"
+                  "<office:body><office:text>"
+                + body.toUtf8()
+                + "</office:text></office:body></office:document-content>"
+        );
+        return zip.addFile("styles.xml", styles());
+    }
+
+protected:
+    bool enter(const MarkdownNode *node)
+    {
+        switch (node->type()) {
+        case MarkdownNode::BlockQuote:
+            quoteDepth++;
+            break;
+        case MarkdownNode::BulletList:
+            body += "<text:list text:style-name=\"Bullet\">";
+            break;
+        case MarkdownNode::NumberedList:
+            body += "<text:list text:style-name=\"Numbering\">";
+            startValue = node->listStart();
+            break;
+        case MarkdownNode::ListItem:
+        case MarkdownNode::TaskListItem:
+            if (1 != startValue) {
+                body += QString("<text:list-item text:start-value=\"%1\">").arg(startValue);
+                startValue = 1;
+            } else {
+                body += "<text:list-item>";
+            }
+            break;
+        case MarkdownNode::Paragraph:
+            if (inFootnote) {
+                body += "<text:p text:style-name=\"Footnote\">";
+            } else if (quoteDepth > 0) {
+                body += "<text:p text:style-name=\"Quotations\">";
+            } else {
+                body += "<text:p text:style-name=\"Text_20_body\">";
+            }
+
+            if (!footnote.isEmpty()) {
+                body += "<text:span text:style-name=\"Superscript\">"
+                    + escaped(footnote)
+                    + "</text:span> ";
+                footnote.clear();
+            }
+            break;
+        case MarkdownNode::Heading: {
+            int level = qBound(1, node->headingLevel(), 6);
+            body += QString("<text:h text:style-name=\"Heading_20_%1\" text:outline-level=\"%1\">")
+                .arg(level);
+            break;
+        }
+        case MarkdownNode::CodeBlock:
+            body += "<text:p text:style-name=\"Preformatted_20_Text\">"
+                + preserved(codeBlockText(node))
+                + "</text:p>";
+            return false;
+        case MarkdownNode::HtmlBlock:
+        case MarkdownNode::HtmlInline:
+            return false;
+        case MarkdownNode::ThematicBreak:
+            body += "<text:p text:style-name=\"Horizontal_20_Line\"/>";
+            return false;
+        case MarkdownNode::FootnoteDefinition:
+            inFootnote = true;
+            footnote = node->literal();
+            break;
+        case MarkdownNode::Table:
+            beginTable(node);
+            break;
+        case MarkdownNode::TableHeading:
+            tableHeading = true;
+            body += "<table:table-header-rows><table:table-row>";
+            break;
+        case MarkdownNode::TableRow:
+            body += "<table:table-row>";
+            break;
+        case MarkdownNode::TableCell:
+            body += QString
+                (
+                    "<table:table-cell table:style-name=\"TableCell\" office:value-type=\"string\">"
+                    "<text:p text:style-name=\"%1\">"
+                ).arg(tableHeading ? "Table_20_Heading" : "Table_20_Contents");
+            break;
+        case MarkdownNode::Text:
+            body += escaped(node->text());
+            return false;
+        case MarkdownNode::Softbreak:
+            body += ' ';
+            return false;
+        case MarkdownNode::Linebreak:
+            body += "<text:line-break/>";
+            return false;
+        case MarkdownNode::Code:
+            body += "<text:span text:style-name=\"Source_20_Text\">"
+                + preserved(node->text())
+                + "</text:span>";
+            return false;
+        case MarkdownNode::Emph:
+            body += "<text:span text:style-name=\"Emphasis\">";
+            break;
+        case MarkdownNode::Strong:
+            body += "<text:span text:style-name=\"Strong_20_Emphasis\">";
+            break;
+        case MarkdownNode::Strikethrough:
+            body += "<text:span text:style-name=\"Strikethrough\">";
+            break;
+        case MarkdownNode::Link:
+            body += "<text:a xlink:type=\"simple\" xlink:href=\""
+                + escaped(node->text())
+                + "\">";
+            break;
+        case MarkdownNode::FootnoteReference:
+            body += "<text:span text:style-name=\"Superscript\">"
+                + escaped(node->text())
+                + "</text:span>";
+            return false;
+        default:
+            break;
+        }
+
+        return true;
+    }
+
+    void leave(const MarkdownNode *node)
+    {
+        switch (node->type()) {
+        case MarkdownNode::BlockQuote:
+            quoteDepth--;
+            break;
+        case MarkdownNode::BulletList:
+        case MarkdownNode::NumberedList:
+            body += "</text:list>";
+            break;
+        case MarkdownNode::ListItem:
+        case MarkdownNode::TaskListItem:
+            body += "</text:list-item>";
+            break;
+        case MarkdownNode::Paragraph:
+            body += "</text:p>";
+            break;
+        case MarkdownNode::Heading:
+            body += "</text:h>";
+            break;
+        case MarkdownNode::FootnoteDefinition:
+            inFootnote = false;
+            footnote.clear();
+            break;
+        case MarkdownNode::Table:
+            body += "</table:table>";
+            break;
+        case MarkdownNode::TableHeading:
+            tableHeading = false;
+            body += "</table:table-row></table:table-header-rows>";
+            break;
+        case MarkdownNode::TableRow:
+            body += "</table:table-row>";
+            break;
+        case MarkdownNode::TableCell:
+            body += "</text:p></table:table-cell>";
+            break;
+        case MarkdownNode::Emph:
+        case MarkdownNode::Strong:
+        case MarkdownNode::Strikethrough:
+            body += "</text:span>";
+            break;
+        case MarkdownNode::Link:
+            body += "</text:a>";
+            break;
+        default:
+            break;
+        }
+    }
+
+private:
+    static const char Namespaces[];
+
+    int quoteDepth;
+    int tableCount;
+    bool tableHeading;
+    bool inFootnote;
+    QString footnote;
+
+    // Number of the next list item, if it starts a numbered list.
+    int startValue;
+
+    void beginTable(const MarkdownNode *node)
+    {
+        int columns = 0;
+
+        if (nullptr != node->firstChild()) {
+            for
+            (
+                const MarkdownNode *cell = node->firstChild()->firstChild();
+                nullptr != cell;
+                cell = cell->next()
+            ) {
+                columns++;
+            }
+        }
+
+        tableCount++;
+        body += QString
+            (
+                "<table:table table:name=\"Table%1\">"
+                "<table:table-column table:number-columns-repeated=\"%2\"/>"
+            ).arg(tableCount).arg(qMax(columns, 1));
+    }
+
+    // Escapes the given text, keeping its spaces, tabs and line breaks,
+    // which OpenDocument would otherwise collapse.
+    //
+    static QString preserved(const QString &text)
+    {
+        QString escapedText = escaped(text);
+        QString result;
+        result.reserve(escapedText.length());
+
+        int i = 0;
+
+        while (i < escapedText.length()) {
+            QChar c = escapedText[i];
+
+            if (' ' == c) {
+                int count = 0;
+
+                while ((i < escapedText.length()) && (' ' == escapedText[i])) {
+                    count++;
+                    i++;
+                }
+
+                // A single space between words is kept as is.
+                if ((1 == count) && !result.isEmpty() && !result.endsWith('>')) {
+                    result += ' ';
+                } else {
+                    result += QString("<text:s text:c=\"%1\"/>").arg(count);
+                }
+
+                continue;
+            }
+
+            if ('\t' == c) {
+                result += "<text:tab/>";
+            } else if ('\n' == c) {
+                result += "<text:line-break/>";
+            } else if ('\r' != c) {
+                result += c;
+            }
+
+            i++;
+        }
+
+        return result;
+    }
+
+    static QByteArray manifest()
+    {
+        return QByteArray(XmlDeclaration)
+            + "<manifest:manifest "
+              "xmlns:manifest=\"urn:oasis:names:tc:opendocument:xmlns:manifest:1.0\" "
+              "manifest:version=\"1.2\">"
+              "<manifest:file-entry manifest:full-path=\"/\" manifest:version=\"1.2\" "
+              "manifest:media-type=\"application/vnd.oasis.opendocument.text\"/>"
+              "<manifest:file-entry manifest:full-path=\"content.xml\" "
+              "manifest:media-type=\"text/xml\"/>"
+              "<manifest:file-entry manifest:full-path=\"styles.xml\" "
+              "manifest:media-type=\"text/xml\"/>"
+              "</manifest:manifest>";
+    }
+
+    static QByteArray styles()
+    {
+        static const char *headingSizes[] = { "130%", "115%", "101%", "95%", "85%", "85%" };
+        static const QStringList bullets = { QString(QChar(0x2022)), QString(QChar(0x25E6)), QString(QChar(0x25AA)) };
+
+        QString xml =
+            QString("<office:document-styles ")
+                + QLatin1String(Namespaces)
+                + " office:version=\"1.2\"><office:styles>";
+
+        xml +=
+            "<style:default-style style:family=\"paragraph\">"
+            "<style:paragraph-properties fo:margin-top=\"0in\" fo:margin-bottom=\"0.08in\"/>"
+            "</style:default-style>"
+            "<style:style style:name=\"Standard\" style:family=\"paragraph\" style:class=\"text\"/>"
+            "<style:style style:name=\"Text_20_body\" style:display-name=\"Text body\" "
+            "style:family=\"paragraph\" style:parent-style-name=\"Standard\" style:class=\"text\">"
+            "<style:paragraph-properties fo:margin-top=\"0in\" fo:margin-bottom=\"0.1in\"/>"
+            "</style:style>"
+            "<style:style style:name=\"Heading\" style:family=\"paragraph\" "
+            "style:parent-style-name=\"Standard\" style:next-style-name=\"Text_20_body\" "
+            "style:class=\"text\">"
+            "<style:paragraph-properties fo:margin-top=\"0.17in\" fo:margin-bottom=\"0.08in\" "
+            "fo:keep-with-next=\"always\"/>"
+            "<style:text-properties fo:font-weight=\"bold\"/></style:style>";
+
+        for (int level = 1; level <= 6; level++) {
+            xml += QString
+                (
+                    "<style:style style:name=\"Heading_20_%1\" style:display-name=\"Heading %1\" "
+                    "style:family=\"paragraph\" style:parent-style-name=\"Heading\" "
+                    "style:next-style-name=\"Text_20_body\" style:default-outline-level=\"%1\" "
+                    "style:class=\"text\"><style:text-properties fo:font-size=\"%2\"/></style:style>"
+                ).arg(level).arg(headingSizes[level - 1]);
+        }
+
+        xml +=
+            "<style:style style:name=\"Quotations\" style:family=\"paragraph\" "
+            "style:parent-style-name=\"Standard\" style:class=\"html\">"
+            "<style:paragraph-properties fo:margin-left=\"0.4in\" fo:margin-right=\"0.4in\" "
+            "fo:margin-top=\"0in\" fo:margin-bottom=\"0.1in\"/>"
+            "<style:text-properties fo:font-style=\"italic\"/></style:style>"
+            "<style:style style:name=\"Preformatted_20_Text\" style:display-name=\"Preformatted Text\" "
+            "style:family=\"paragraph\" style:parent-style-name=\"Standard\" style:class=\"html\">"
+            "<style:paragraph-properties fo:margin-top=\"0in\" fo:margin-bottom=\"0.1in\"/>"
+            "<style:text-properties fo:font-family=\"'Liberation Mono'\" "
+            "style:font-family-generic=\"modern\" style:font-pitch=\"fixed\" fo:font-size=\"10pt\"/>"
+            "</style:style>"
+            "<style:style style:name=\"Table_20_Contents\" style:display-name=\"Table Contents\" "
+            "style:family=\"paragraph\" style:parent-style-name=\"Standard\" style:class=\"extra\"/>"
+            "<style:style style:name=\"Table_20_Heading\" style:display-name=\"Table Heading\" "
+            "style:family=\"paragraph\" style:parent-style-name=\"Table_20_Contents\" style:class=\"extra\">"
+            "<style:paragraph-properties fo:text-align=\"center\"/>"
+            "<style:text-properties fo:font-weight=\"bold\"/></style:style>"
+            "<style:style style:name=\"Footnote\" style:family=\"paragraph\" "
+            "style:parent-style-name=\"Standard\" style:class=\"extra\">"
+            "<style:text-properties fo:font-size=\"10pt\"/></style:style>"
+            "<style:style style:name=\"Horizontal_20_Line\" style:display-name=\"Horizontal Line\" "
+            "style:family=\"paragraph\" style:parent-style-name=\"Standard\" style:class=\"html\">"
+            "<style:paragraph-properties fo:margin-top=\"0in\" fo:margin-bottom=\"0.2in\" "
+            "fo:border-bottom=\"0.5pt solid #808080\" fo:padding=\"0in\"/></style:style>"
+            "<style:style style:name=\"Emphasis\" style:family=\"text\">"
+            "<style:text-properties fo:font-style=\"italic\"/></style:style>"
+            "<style:style style:name=\"Strong_20_Emphasis\" style:display-name=\"Strong Emphasis\" "
+            "style:family=\"text\"><style:text-properties fo:font-weight=\"bold\"/></style:style>"
+            "<style:style style:name=\"Source_20_Text\" style:display-name=\"Source Text\" "
+            "style:family=\"text\"><style:text-properties fo:font-family=\"'Liberation Mono'\" "
+            "style:font-family-generic=\"modern\" style:font-pitch=\"fixed\"/></style:style>"
+            "<style:style style:name=\"Strikethrough\" style:family=\"text\">"
+            "<style:text-properties style:text-line-through-style=\"solid\"/></style:style>"
+            "<style:style style:name=\"Superscript\" style:family=\"text\">"
+            "<style:text-properties style:text-position=\"super 58%\"/></style:style>";
+
+        for (int numbered = 0; numbered < 2; numbered++) {
+            xml += QString("<text:list-style style:name=\"%1\">")
+                .arg(numbered ? "Numbering" : "Bullet");
+
+            for (int level = 1; level <= 10; level++) {
+                QString properties = QString
+                    (
+                        "<style:list-level-properties "
+                        "text:list-level-position-and-space-mode=\"label-alignment\">"
+                        "<style:list-level-label-alignment text:label-followed-by=\"listtab\" "
+                        "text:list-tab-stop-position=\"%1in\" fo:text-indent=\"-0.25in\" "
+                        "fo:margin-left=\"%1in\"/></style:list-level-properties>"
+                    ).arg(level * 0.5);
+
+                if (numbered) {
+                    xml += QString
+                        (
+                            "<text:list-level-style-number text:level=\"%1\" "
+                            "style:num-suffix=\".\" style:num-format=\"1\">%2"
+                            "</text:list-level-style-number>"
+                        ).arg(level).arg(properties);
+                } else {
+                    xml += QString
+                        (
+                            "<text:list-level-style-bullet text:level=\"%1\" "
+                            "text:bullet-char=\"%2\">%3</text:list-level-style-bullet>"
+                        ).arg(level).arg(bullets[(level - 1) % bullets.size()]).arg(properties);
+                }
+            }
+
+            xml += "</text:list-style>";
+        }
+
+        xml += "</office:styles></office:document-styles>";
+        return QByteArray(XmlDeclaration) + xml.toUtf8();
+    }
+};
+
+const char OdtWriter::Namespaces[] =
+    "xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\" "
+    "xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\" "
+    "xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\" "
+    "xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\" "
+    "xmlns:fo=\"urn:oasis:names:tc:opendocument:xmlns:xsl-fo-compatible:1.0\" "
+    "xmlns:xlink=\"http://www.w3.org/1999/xlink\"";
+} // namespace
+
+bool OfficeDocumentWriter::isFormatSupported(const ExportFormat *format)
+{
+    return (ExportFormat::DOCX == format) || (ExportFormat::ODT == format);
+}
+
+void OfficeDocumentWriter::write
+(
+    const ExportFormat *format,
+    const QString &text,
+    bool smartTypographyEnabled,
+    const QString &outputFilePath,
+    QString &err
+)
+{
+    GW_TRACE_SCOPE("OfficeDocumentWriter::write");
+
+    if (!isFormatSupported(format)) {
+        err = QObject::tr("%1 format is unsupported by the cmark-gfm processor.")
+              .arg(format->name());
+        return;
+    }
+
+    QScopedPointer<OfficeWriter> writer;
+
+    if (ExportFormat::DOCX == format) {
+        writer.reset(new DocxWriter());
+    } else {
+        writer.reset(new OdtWriter());
+    }
+
+    {
+        QScopedPointer<MarkdownAST> ast
+        (
+            CmarkGfmAPI::instance()->parse(text, smartTypographyEnabled)
+        );
+
+        if (nullptr != ast->root()) {
+            writer->walk(ast->root());
+        }
+    }
+
+    QFile outputFile(outputFilePath);
+
+    if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err = outputFile.errorString();
+        return;
+    }
+
+    ZipWriter zip(&outputFile);
+    bool ok = writer->writeParts(zip) && zip.close();
+
+    // Close the file, which writes out what is left in its buffer.
+    outputFile.close();
+
+    if (QFile::NoError != outputFile.error()) {
+        err = outputFile.errorString();
+    } else if (!ok) {
+        err = QObject::tr("Export failed");
+    } else {
+        err = QString();
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,71 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef OFFICE_DOCUMENT_WRITER_H
+#define OFFICE_DOCUMENT_WRITER_H
+
+#include <QString>
+
+#include "exportformat.h"
+
+namespace ghostwriter
+{
+/**
+ * Writes Markdown text to Word (Office Open XML) and OpenDocument Text
+ * files in-process, without running an external processor such as Pandoc.
+ * The text is parsed with cmark-gfm, and the resulting AST is walked by a
+ * visitor that writes the XML parts of the document, which are then
+ * zipped into the output file.
+ *
+ * Headings, paragraphs, emphasis, block quotes, lists, code, links,
+ * tables, thematic breaks and footnotes are written with named styles,
+ * so that they can be restyled in the word processor.  Raw HTML is left
+ * out, and images are written as their alternate text.
+ *
+ * This class may be used from any thread.
+ */
+class OfficeDocumentWriter
+{
+public:
+    /**
+     * Returns true if the given format can be written, which is the case
+     * for ExportFormat::DOCX and ExportFormat::ODT.
+     */
+    static bool isFormatSupported(const ExportFormat *format);
+
+    /**
+     * Writes the given Markdown text to the given output file in the
+     * given format.  Sets err to a non-null string error message if
+     * writing fails.
+     */
+    static void write
+    (
+        const ExportFormat *format,
+        const QString &text,
+        bool smartTypographyEnabled,
+        const QString &outputFilePath,
+        QString &err
+    );
+
+private:
+    OfficeDocumentWriter();
+};
+} // namespace ghostwriter
+
+#endif // OFFICE_DOCUMENT_WRITER_H
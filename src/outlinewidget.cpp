@@ -18,12 +18,15 @@
  ***********************************************************************/
 
 #include <QListWidgetItem>
+#include <QRegularExpression>
 #include <QString>
 #include <QTextBlock>
 #include <QVariant>
 #include <QPointer>
+#include <QShowEvent>
 
 #include "outlinewidget.h"
+#include "tracer.h"
 
 namespace ghostwriter
 {
@@ -37,6 +40,7 @@ public:
         : q_ptr(q_ptr)
     {
         this->editor = editor;
+        this->sectionWordCountsStale = false;
     }
 
     ~OutlineWidgetPrivate()
@@ -45,9 +49,29 @@ public:
     }
 
     static const int DOCUMENT_POSITION_ROLE;
+    static const int BLOCK_NUMBER_ROLE;
+    static const int HEADING_LEVEL_ROLE;
+    static const int HEADING_TEXT_ROLE;
+    static const int LINE_TEXT_ROLE;
+
+    /*
+    * A heading of the document, as listed in the outline.
+    */
+    struct Heading
+    {
+        QTextBlock block;
+        int level;
+    };
 
     OutlineWidget *q_ptr;
     QPointer<MarkdownEditor> editor;
+    QPointer<DocumentStatistics> statistics;
+
+    /*
+    * True if the section word counts changed while the widget was hidden,
+    * so that they are updated once it is shown.
+    */
+    bool sectionWordCountsStale;
 
     /*
     * Invoked when the user selects one of the headings in the outline
@@ -55,8 +79,29 @@ public:
     */
     void onOutlineHeadingSelected(QListWidgetItem *item);
 
+    /*
+    * Updates the outline with the headings of the document's current AST,
+    * rebuilding only the rows of headings that changed.
+    */
     void reloadOutline();
 
+    /*
+    * Returns whether the given item already shows the given heading.
+    */
+    bool isSameHeading(QListWidgetItem *item, const Heading &heading) const;
+
+    /*
+    * Sets the text and level of the given item from the given heading,
+    * unless it already shows that heading.
+    */
+    void setHeading(QListWidgetItem *item, const Heading &heading);
+
+    /*
+    * Shows the word count of each heading's section, summed from the
+    * document statistics' per-block word counts.
+    */
+    void updateSectionWordCounts();
+
     /*
     * Gets the document position stored in the given item.
     */
@@ -75,6 +120,10 @@ public:
 };
 
 const int OutlineWidgetPrivate::DOCUMENT_POSITION_ROLE = Qt::UserRole + 1;
+const int OutlineWidgetPrivate::BLOCK_NUMBER_ROLE = Qt::UserRole + 2;
+const int OutlineWidgetPrivate::HEADING_LEVEL_ROLE = Qt::UserRole + 3;
+const int OutlineWidgetPrivate::HEADING_TEXT_ROLE = Qt::UserRole + 4;
+const int OutlineWidgetPrivate::LINE_TEXT_ROLE = Qt::UserRole + 5;
 
 OutlineWidget::OutlineWidget(MarkdownEditor *editor, QWidget *parent)
     : QListWidget(parent),
@@ -106,18 +155,12 @@ OutlineWidget::OutlineWidget(MarkdownEditor *editor, QWidget *parent)
         &OutlineWidget::updateCurrentNavigationHeading
     );
 
-    this->connect
-    (
-        editor->document(),
-        &MarkdownDocument::contentsChange,
-        [d](int, int, int) {
-            d->reloadOutline();
-        }
-    );
+    // Reload whenever the document is (re)parsed.  While a parse is in
+    // progress, the outline continues to reflect the last published AST.
     this->connect
     (
         (MarkdownDocument *)editor->document(),
-        static_cast<void (MarkdownDocument::*)(const QTextBlock &)>(&MarkdownDocument::textBlockRemoved),
+        &MarkdownDocument::markdownASTChanged,
         [d]() {
             d->reloadOutline();
         }
@@ -129,6 +172,49 @@ OutlineWidget::~OutlineWidget()
     ;
 }
 
+void OutlineWidget::setDocumentStatistics(DocumentStatistics *statistics)
+{
+    Q_D(OutlineWidget);
+
+    if (d->statistics) {
+        d->statistics->disconnect(this);
+    }
+
+    d->statistics = statistics;
+
+    if (nullptr != statistics) {
+        this->connect
+        (
+            statistics,
+            &DocumentStatistics::statisticsChanged,
+            this,
+            [d]() {
+                d->updateSectionWordCounts();
+            }
+        );
+    }
+
+    if (nullptr != statistics) {
+        d->updateSectionWordCounts();
+    } else {
+        for (int row = 0; row < this->count(); row++) {
+            QListWidgetItem *item = this->item(row);
+            item->setText(item->data(OutlineWidgetPrivate::HEADING_TEXT_ROLE).toString());
+        }
+    }
+}
+
+void OutlineWidget::showEvent(QShowEvent *event)
+{
+    Q_D(OutlineWidget);
+
+    QListWidget::showEvent(event);
+
+    if (d->sectionWordCountsStale) {
+        d->updateSectionWordCounts();
+    }
+}
+
 void OutlineWidget::updateCurrentNavigationHeading(int position)
 {
     Q_D(OutlineWidget);
@@ -199,6 +285,7 @@ void OutlineWidgetPrivate::onOutlineHeadingSelected(QListWidgetItem *item)
 void OutlineWidgetPrivate::reloadOutline()
 {
     Q_Q(OutlineWidget);
+    GW_TRACE_SCOPE("reloadOutline");
 
     // Make sure editor and document haven't been deleted.
     // Otherwise, application may crash on exit.
@@ -207,47 +294,175 @@ void OutlineWidgetPrivate::reloadOutline()
         return;
     }
 
-    q->clear();
-
     if ((nullptr == editor) || (nullptr == editor->document())) {
+        q->clear();
         return;
     }
 
     MarkdownAST *ast = ((MarkdownDocument *) editor->document())->markdownAST();
 
     if (nullptr == ast) {
+        q->clear();
         return;
     }
 
     QVector<MarkdownNode *> headings = ast->headings();
+    QVector<Heading> blocks;
+    blocks.reserve(headings.size());
 
     foreach (MarkdownNode *heading, headings) {
-        QString headingText("   ");
+        Heading entry;
+        entry.block = editor->document()->findBlockByNumber(heading->startLine() - 1);
+        entry.level = heading->headingLevel();
 
-        for (int i = 1; i < heading->headingLevel(); i++) {
-            headingText += "    ";
+        if (entry.block.isValid()) {
+            blocks.append(entry);
         }
+    }
 
-        QTextBlock block = editor->document()->findBlockByNumber(heading->startLine() - 1);
+    // Most reparses leave the headings as they were, or change only the
+    // few around the edit.  Keep the rows that still match at the start and
+    // at the end of the outline, and only rebuild the rows in between.
+    //
+    int oldCount = q->count();
+    int newCount = blocks.size();
+    int prefix = 0;
+    int suffix = 0;
 
-        QRegularExpression headingRegex("^\\s*#*(.*?)\\s*#*?\\s*$");
-        QRegularExpressionMatch match = headingRegex.match(block.text());
+    while
+    (
+        (prefix < oldCount)
+        && (prefix < newCount)
+        && isSameHeading(q->item(prefix), blocks[prefix])
+    ) {
+        prefix++;
+    }
 
-        if (match.isValid() && match.hasMatch()) {
-            headingText += match.captured(1);
-        }
+    while
+    (
+        (suffix < (oldCount - prefix))
+        && (suffix < (newCount - prefix))
+        && isSameHeading(q->item(oldCount - 1 - suffix), blocks[newCount - 1 - suffix])
+    ) {
+        suffix++;
+    }
 
-        if (block.isValid()) {
-            QListWidgetItem *item = new QListWidgetItem();
-            item->setText(headingText);
-            item->setData(DOCUMENT_POSITION_ROLE, QVariant::fromValue(block.position()));
-            q->insertItem(q->count(), item);
-        }
+    int oldEnd = oldCount - suffix;
+    int newEnd = newCount - suffix;
+    int row = prefix;
+
+    // Reuse the rows that changed for the new headings in their place.
+    for (; (row < oldEnd) && (row < newEnd); row++) {
+        setHeading(q->item(row), blocks[row]);
     }
 
+    // Remove the rows of headings that no longer exist...
+    for (int i = row; i < oldEnd; i++) {
+        delete q->takeItem(row);
+    }
+
+    // ...or insert rows for the headings that were added.
+    for (; row < newEnd; row++) {
+        QListWidgetItem *item = new QListWidgetItem();
+        setHeading(item, blocks[row]);
+        q->insertItem(row, item);
+    }
+
+    // Headings after an edit keep their text but may have moved.
+    for (row = 0; row < newCount; row++) {
+        QListWidgetItem *item = q->item(row);
+        item->setData(DOCUMENT_POSITION_ROLE, QVariant::fromValue(blocks[row].block.position()));
+        item->setData(BLOCK_NUMBER_ROLE, QVariant::fromValue(blocks[row].block.blockNumber()));
+    }
+
+    updateSectionWordCounts();
     q->updateCurrentNavigationHeading(editor->textCursor().position());
 }
 
+bool OutlineWidgetPrivate::isSameHeading(QListWidgetItem *item, const Heading &heading) const
+{
+    return (item->data(HEADING_LEVEL_ROLE).value<int>() == heading.level)
+        && (item->data(LINE_TEXT_ROLE).toString() == heading.block.text());
+}
+
+void OutlineWidgetPrivate::setHeading(QListWidgetItem *item, const Heading &heading)
+{
+    static const QRegularExpression headingRegex("^\\s*#*(.*?)\\s*#*?\\s*$");
+
+    if (isSameHeading(item, heading)) {
+        return;
+    }
+
+    QString lineText = heading.block.text();
+    QString headingText("   ");
+
+    for (int i = 1; i < heading.level; i++) {
+        headingText += "    ";
+    }
+
+    QRegularExpressionMatch match = headingRegex.match(lineText);
+
+    if (match.isValid() && match.hasMatch()) {
+        headingText += match.captured(1);
+    }
+
+    item->setText(headingText);
+    item->setData(LINE_TEXT_ROLE, QVariant::fromValue(lineText));
+    item->setData(HEADING_LEVEL_ROLE, QVariant::fromValue(heading.level));
+    item->setData(HEADING_TEXT_ROLE, QVariant::fromValue(headingText));
+}
+
+void OutlineWidgetPrivate::updateSectionWordCounts()
+{
+    Q_Q(OutlineWidget);
+
+    if (!editor || !statistics) {
+        return;
+    }
+
+    if (!q->isVisible()) {
+        sectionWordCountsStale = true;
+        return;
+    }
+
+    sectionWordCountsStale = false;
+
+    // Walk the headings from last to first, keeping track of the block
+    // number of the nearest following heading of each level, so that each
+    // section ends just before the next heading of the same or a higher
+    // level.
+    //
+    const int maxLevel = 6;
+    int lastBlockNumber = editor->document()->blockCount() - 1;
+    int nextHeadingBlock[maxLevel + 1];
+
+    for (int level = 0; level <= maxLevel; level++) {
+        nextHeadingBlock[level] = lastBlockNumber + 1;
+    }
+
+    for (int row = q->count() - 1; row >= 0; row--) {
+        QListWidgetItem *item = q->item(row);
+        int blockNumber = item->data(BLOCK_NUMBER_ROLE).value<int>();
+        int level = qBound(1, item->data(HEADING_LEVEL_ROLE).value<int>(), maxLevel);
+        int endBlockNumber = lastBlockNumber + 1;
+
+        for (int i = 1; i <= level; i++) {
+            endBlockNumber = qMin(endBlockNumber, nextHeadingBlock[i]);
+        }
+
+        nextHeadingBlock[level] = blockNumber;
+
+        int words = statistics->wordCount(blockNumber, endBlockNumber - 1);
+        QString text = OutlineWidget::tr("%1 (%L2)")
+            .arg(item->data(HEADING_TEXT_ROLE).toString())
+            .arg(words);
+
+        if (item->text() != text) {
+            item->setText(text);
+        }
+    }
+}
+
 int OutlineWidgetPrivate::documentPosition(QListWidgetItem *item)
 {
     return item->data(DOCUMENT_POSITION_ROLE).value<int>();
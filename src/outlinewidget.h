@@ -23,6 +23,7 @@
 #include <QScopedPointer>
 #include <QListWidget>
 
+#include "documentstatistics.h"
 #include "markdowneditor.h"
 
 namespace ghostwriter
@@ -41,6 +42,15 @@ public:
     OutlineWidget(MarkdownEditor *editor, QWidget *parent = 0);
     virtual ~OutlineWidget();
 
+    /**
+     * Sets the statistics of the editor's document, from which the word
+     * count of each heading's section is shown in the outline.  A section
+     * runs until the next heading of the same or a higher level, so that
+     * it includes its subsections.  Pass nullptr to no longer show word
+     * counts.
+     */
+    void setDocumentStatistics(DocumentStatistics *statistics);
+
 signals:
     /**
      * Emitted when the user selects one of the headings in the outline
@@ -61,6 +71,9 @@ public slots:
      */
     void updateCurrentNavigationHeading(int position);
 
+protected:
+    void showEvent(QShowEvent *event);
+
 private:
     QScopedPointer<OutlineWidgetPrivate> d_ptr;
 };
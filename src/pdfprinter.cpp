@@ -0,0 +1,337 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QEvent>
+#include <QFile>
+#include <QLocale>
+#include <QMarginsF>
+#include <QPageLayout>
+#include <QSemaphore>
+#include <QSettings>
+#include <QSharedPointer>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QUrl>
+
+#include "pdfprinter.h"
+#include "previewprofile.h"
+#include "sandboxedwebpage.h"
+
+#define GW_PDF_PAGE_SIZE_KEY "Export/pdfPageSize"
+
+namespace ghostwriter
+{
+class PdfPrinterPrivate
+{
+    Q_DECLARE_PUBLIC(PdfPrinter)
+
+public:
+    static PdfPrinter *instance;
+
+    PdfPrinterPrivate(PdfPrinter *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~PdfPrinterPrivate()
+    {
+        ;
+    }
+
+    // Interval in milliseconds at which a thread waiting for printing to
+    // finish checks whether the export has been cancelled.
+    static const int CancelPollInterval = 100;
+
+    // Page margins, in millimeters.  These match the one inch margins of
+    // the Pandoc PDF exports.
+    static const int PageMargin = 25;
+
+    /*
+    * A request to print HTML to a PDF file.  It is shared between the
+    * thread requesting it and the main thread printing it, since the
+    * former may stop waiting when the export is cancelled.
+    */
+    struct Job
+    {
+        QString html;
+        QString baseDir;
+        QString outputFilePath;
+        QPageLayout pageLayout;
+        QString error;
+        QSemaphore done;
+        QAtomicInt cancelled;
+    };
+
+    /*
+    * Event with which other threads post jobs to the main thread.
+    */
+    class PrintEvent : public QEvent
+    {
+    public:
+        PrintEvent(QSharedPointer<Job> job)
+            : QEvent(type()), job(job)
+        {
+            ;
+        }
+
+        static QEvent::Type type()
+        {
+            static QEvent::Type eventType =
+                (QEvent::Type) QEvent::registerEventType();
+
+            return eventType;
+        }
+
+        QSharedPointer<Job> job;
+    };
+
+    PdfPrinter *q_ptr;
+    QString styleSheet;
+
+    /*
+    * Loads the HTML of the given job in a hidden page, and prints it once
+    * loaded.  Releases the job's semaphore when done.  This method runs
+    * on the main thread.
+    */
+    void startJob(QSharedPointer<Job> job);
+
+    /*
+    * Finishes the given job, writing the given PDF data to its output
+    * file unless the job was cancelled.
+    */
+    void finishJob(QSharedPointer<Job> job, const QByteArray &pdf);
+};
+
+PdfPrinter *PdfPrinterPrivate::instance = nullptr;
+
+PdfPrinter *PdfPrinter::instance()
+{
+    if (nullptr == PdfPrinterPrivate::instance) {
+        PdfPrinterPrivate::instance = new PdfPrinter();
+    }
+
+    return PdfPrinterPrivate::instance;
+}
+
+PdfPrinter::PdfPrinter()
+    : QObject(qApp),
+      d_ptr(new PdfPrinterPrivate(this))
+{
+    ;
+}
+
+PdfPrinter::~PdfPrinter()
+{
+    ;
+}
+
+QPageSize::PageSizeId PdfPrinter::defaultPageSize()
+{
+    if (QLocale::ImperialUSSystem == QLocale::system().measurementSystem()) {
+        return QPageSize::Letter;
+    }
+
+    return QPageSize::A4;
+}
+
+QPageSize::PageSizeId PdfPrinter::pageSize()
+{
+    QSettings settings;
+    int id = settings.value(GW_PDF_PAGE_SIZE_KEY, (int) defaultPageSize()).toInt();
+
+    if ((id < 0) || (id > QPageSize::LastPageSize)) {
+        return defaultPageSize();
+    }
+
+    return (QPageSize::PageSizeId) id;
+}
+
+void PdfPrinter::setPageSize(QPageSize::PageSizeId pageSize)
+{
+    QSettings settings;
+    settings.setValue(GW_PDF_PAGE_SIZE_KEY, (int) pageSize);
+}
+
+void PdfPrinter::setStyleSheet(const QString &css)
+{
+    Q_D(PdfPrinter);
+
+    d->styleSheet = css;
+}
+
+bool PdfPrinter::print
+(
+    const QString &html,
+    const QString &baseDir,
+    const QString &outputFilePath,
+    const Exporter *cancellable,
+    QString &err
+)
+{
+    Q_D(PdfPrinter);
+
+    QSharedPointer<PdfPrinterPrivate::Job> job(new PdfPrinterPrivate::Job());
+    job->html = html;
+    job->baseDir = baseDir;
+    job->outputFilePath = outputFilePath;
+    job->pageLayout = QPageLayout
+        (
+            QPageSize(pageSize()),
+            QPageLayout::Portrait,
+            QMarginsF
+            (
+                PdfPrinterPrivate::PageMargin,
+                PdfPrinterPrivate::PageMargin,
+                PdfPrinterPrivate::PageMargin,
+                PdfPrinterPrivate::PageMargin
+            ),
+            QPageLayout::Millimeter
+        );
+
+    if (QThread::currentThread() == this->thread()) {
+        d->startJob(job);
+
+        while (!job->done.tryAcquire()) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    } else {
+        QCoreApplication::postEvent(this, new PdfPrinterPrivate::PrintEvent(job));
+
+        while (!job->done.tryAcquire(1, PdfPrinterPrivate::CancelPollInterval)) {
+            if ((nullptr != cancellable) && cancellable->isExportCancelled()) {
+                job->cancelled.storeRelease(1);
+                err = tr("Export cancelled.");
+                return false;
+            }
+        }
+    }
+
+    err = job->error;
+    return err.isNull();
+}
+
+void PdfPrinter::customEvent(QEvent *event)
+{
+    Q_D(PdfPrinter);
+
+    if (PdfPrinterPrivate::PrintEvent::type() == event->type()) {
+        d->startJob(((PdfPrinterPrivate::PrintEvent *) event)->job);
+    }
+}
+
+void PdfPrinterPrivate::startJob(QSharedPointer<Job> job)
+{
+    Q_Q(PdfPrinter);
+
+    if (job->cancelled.loadAcquire()) {
+        job->done.release();
+        return;
+    }
+
+    SandboxedWebPage *page = new SandboxedWebPage(PreviewProfile::instance(), q);
+
+    // Load the HTML from a file, since the web engine cannot display
+    // HTML larger than 2 MB set directly.  The base element lets relative
+    // URLs resolve against the document's directory rather than against
+    // the temporary file's.
+    //
+    QTemporaryFile *htmlFile =
+        new QTemporaryFile(QDir::temp().absoluteFilePath("ghostwriter-XXXXXX.html"), page);
+
+    if (!htmlFile->open()) {
+        job->error = htmlFile->errorString();
+        job->done.release();
+        page->deleteLater();
+        return;
+    }
+
+    QString baseUrl;
+
+    if (!job->baseDir.isEmpty()) {
+        baseUrl = QUrl::fromLocalFile(QDir(job->baseDir).absolutePath() + "/").toString();
+    }
+
+    htmlFile->write
+    (
+        (QString("<!DOCTYPE html><html><head>"
+            "<meta http-equiv=\"Content-Type\" content=\"text/html; charset=utf-8\" />"
+            "<base href=\"%1\" />"
+            "<style>%2</style>"
+            "</head><body>")
+            .arg(baseUrl.toHtmlEscaped())
+            .arg(styleSheet)).toUtf8()
+    );
+    htmlFile->write(job->html.toUtf8());
+    htmlFile->write("</body></html>");
+    htmlFile->close();
+
+    QObject::connect
+    (
+        page,
+        &QWebEnginePage::loadFinished,
+        [this, page, job](bool ok) {
+            if (!ok) {
+                job->error = PdfPrinter::tr("Could not load the document for printing.");
+                finishJob(job, QByteArray());
+                page->deleteLater();
+                return;
+            }
+
+            page->printToPdf
+            (
+                [this, page, job](const QByteArray &pdf) {
+                    finishJob(job, pdf);
+                    page->deleteLater();
+                },
+                job->pageLayout
+            );
+        }
+    );
+
+    page->load(QUrl::fromLocalFile(htmlFile->fileName()));
+}
+
+void PdfPrinterPrivate::finishJob(QSharedPointer<Job> job, const QByteArray &pdf)
+{
+    if (job->error.isNull() && !job->cancelled.loadAcquire()) {
+        if (pdf.isEmpty()) {
+            job->error = PdfPrinter::tr("Printing to PDF failed.");
+        } else {
+            QFile outputFile(job->outputFilePath);
+
+            if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                job->error = outputFile.errorString();
+            } else {
+                outputFile.write(pdf);
+                outputFile.close();
+
+                if (QFile::NoError != outputFile.error()) {
+                    job->error = outputFile.errorString();
+                }
+            }
+        }
+    }
+
+    job->done.release();
+}
+} // namespace ghostwriter
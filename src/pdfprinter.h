@@ -0,0 +1,110 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PDF_PRINTER_H
+#define PDF_PRINTER_H
+
+#include <QObject>
+#include <QPageSize>
+#include <QScopedPointer>
+#include <QString>
+
+#include "exporter.h"
+
+namespace ghostwriter
+{
+/**
+ * Prints HTML to PDF files in-process with the web engine, the same way
+ * the live preview displays it, so that exporting to PDF needs neither
+ * external processes nor a LaTeX installation.  The page size is the one
+ * last chosen in the Export dialog.
+ *
+ * Printing always happens on the main thread, but print() may be called
+ * from any thread, and blocks until the file is written.
+ */
+class PdfPrinterPrivate;
+class PdfPrinter : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(PdfPrinter)
+
+public:
+    /**
+     * Returns the single instance, creating it if necessary.  Note that
+     * the first call must be made from the main thread.
+     */
+    static PdfPrinter *instance();
+
+    /**
+     * Destructor.
+     */
+    virtual ~PdfPrinter();
+
+    /**
+     * Returns the page size to print with unless one was chosen, which
+     * is US Letter in locales using US measurements, and A4 otherwise.
+     */
+    static QPageSize::PageSizeId defaultPageSize();
+
+    /**
+     * Returns the page size to print with.
+     */
+    static QPageSize::PageSizeId pageSize();
+
+    /**
+     * Sets the page size to print with.
+     */
+    static void setPageSize(QPageSize::PageSizeId pageSize);
+
+    /**
+     * Sets the CSS with which to style the printed HTML.  This method
+     * must be called from the main thread.
+     */
+    void setStyleSheet(const QString &css);
+
+    /**
+     * Prints the given HTML body to the given output file path.  Relative
+     * URLs in the HTML, such as those of images, are resolved against the
+     * given base directory.  Returns false and sets err to an error
+     * message if printing fails, or if the given exporter's export is
+     * cancelled while waiting for printing to finish.
+     */
+    bool print
+    (
+        const QString &html,
+        const QString &baseDir,
+        const QString &outputFilePath,
+        const Exporter *cancellable,
+        QString &err
+    );
+
+protected:
+    /**
+     * Starts printing jobs posted from other threads.
+     */
+    void customEvent(QEvent *event);
+
+private:
+    QScopedPointer<PdfPrinterPrivate> d_ptr;
+
+    PdfPrinter();
+};
+} // namespace ghostwriter
+
+#endif // PDF_PRINTER_H
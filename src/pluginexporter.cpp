@@ -0,0 +1,128 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QDebug>
+#include <QList>
+#include <QObject>
+
+#include "pluginexporter.h"
+
+namespace ghostwriter
+{
+PluginExporter::PluginExporter(MarkdownProcessorPlugin *plugin)
+    : Exporter(plugin->name()), m_plugin(plugin)
+{
+    QList<const ExportFormat *> knownFormats;
+    knownFormats
+        << ExportFormat::HTML
+        << ExportFormat::HTML5
+        << ExportFormat::ODT
+        << ExportFormat::ODF
+        << ExportFormat::RTF
+        << ExportFormat::DOCX
+        << ExportFormat::PDF
+        << ExportFormat::PDF_LATEX
+        << ExportFormat::PDF_CONTEXT
+        << ExportFormat::PDF_WKHTML
+        << ExportFormat::EPUBV2
+        << ExportFormat::EPUBV3
+        << ExportFormat::FICTIONBOOK2
+        << ExportFormat::LATEX
+        << ExportFormat::LYX
+        << ExportFormat::MEMOIR
+        << ExportFormat::GROFFMAN
+        << ExportFormat::MANPAGE;
+
+    foreach (const QString &formatName, plugin->fileFormats()) {
+        const ExportFormat *supported = nullptr;
+
+        foreach (const ExportFormat *format, knownFormats) {
+            if (format->name() == formatName) {
+                supported = format;
+                break;
+            }
+        }
+
+        if (nullptr == supported) {
+            qWarning() << "Markdown processor" << name()
+                << "exports to unknown format" << formatName;
+        } else {
+            m_supportedFormats.append(supported);
+        }
+    }
+
+    setVersion(plugin->version());
+}
+
+PluginExporter::~PluginExporter()
+{
+    ;
+}
+
+bool PluginExporter::isHtmlSupported() const
+{
+    return m_plugin->isHtmlSupported();
+}
+
+void PluginExporter::exportToHtml(const QString &text, QString &html)
+{
+    QString err;
+
+    if (!isHtmlSupported()) {
+        Exporter::exportToHtml(text, html);
+    } else if
+    (
+        !m_plugin->renderToHtml(text, this->m_smartTypographyEnabled, html, err)
+    ) {
+        html = QString("<center><b style='color: red'>") + QObject::tr("Export failed: ") + QString("%1</b></center>").arg(err.toHtmlEscaped());
+    }
+}
+
+void PluginExporter::exportToFile
+(
+    const ExportFormat *format,
+    const QString &inputFilePath,
+    const QString &text,
+    const QString &outputFilePath,
+    QString &err
+)
+{
+    if (!m_supportedFormats.contains(format)) {
+        err = QObject::tr("%1 format is not supported by this processor.").arg(format->name());
+        return;
+    }
+
+    if
+    (
+        m_plugin->exportToFile
+        (
+            format->name(),
+            inputFilePath,
+            text,
+            outputFilePath,
+            this->m_smartTypographyEnabled,
+            err
+        )
+    ) {
+        err = QString();
+    } else if (err.isNull()) {
+        err = QObject::tr("Export failed");
+    }
+}
+} // namespace ghostwriter
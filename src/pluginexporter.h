@@ -0,0 +1,76 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PLUGIN_EXPORTER_H
+#define PLUGIN_EXPORTER_H
+
+#include "exporter.h"
+#include "markdownprocessorplugin.h"
+
+namespace ghostwriter
+{
+/**
+ * Exports Markdown text with a Markdown processor provided by a plugin,
+ * which runs in-process.
+ */
+class PluginExporter : public Exporter
+{
+public:
+    /**
+     * Constructor.  Takes the plugin providing the processor, which must
+     * remain loaded for as long as the exporter exists.
+     */
+    PluginExporter(MarkdownProcessorPlugin *plugin);
+
+    /**
+     * Destructor.
+     */
+    ~PluginExporter();
+
+    /**
+     * Returns true if the processor can render HTML for the live preview.
+     */
+    bool isHtmlSupported() const;
+
+    /**
+     * Exports the given Markdown text to HTML, setting the html parameter
+     * to have the HTML output.
+     */
+    void exportToHtml(const QString &text, QString &html);
+
+    /**
+     * Exports the given Markdown text to the given export format and
+     * output file path.  Sets err to a non-null string error message
+     * if the export fails.
+     */
+    void exportToFile
+    (
+        const ExportFormat *format,
+        const QString &inputFilePath,
+        const QString &text,
+        const QString &outputFilePath,
+        QString &err
+    );
+
+private:
+    MarkdownProcessorPlugin *m_plugin;
+};
+} // namespace ghostwriter
+
+#endif // PLUGIN_EXPORTER_H
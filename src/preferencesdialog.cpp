@@ -24,6 +24,8 @@
 #include <QFormLayout>
 #include <QGroupBox>
 #include <QLineEdit>
+#include <QListWidget>
+#include <QMap>
 #include <QPushButton>
 #include <QSpinBox>
 #include <QTabWidget>
@@ -34,6 +36,7 @@
 #include "localedialog.h"
 #include "messageboxhelper.h"
 #include "preferencesdialog.h"
+#include "stallwatchdog.h"
 
 namespace ghostwriter
 {
@@ -57,8 +60,14 @@ public:
     PreferencesDialog *q_ptr;
 
     AppSettings *appSettings;
+    QTabWidget *tabWidget;
+
+    // Builders of the tabs, by index, for the tabs not yet built.
+    QMap<int, QWidget *(PreferencesDialogPrivate::*)()> pendingTabs;
 
 public:
+    void addLazyTab(QWidget *(PreferencesDialogPrivate::*builder)(), const QString &label);
+    void buildTab(int index);
     void showAutoMatchFilterDialog();
     QWidget *initializeGeneralTab();
     QWidget *initializeEditorTab();
@@ -76,15 +85,26 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
     this->setWindowTitle(tr("Preferences"));
     d->appSettings = AppSettings::instance();
 
-    QTabWidget *tabWidget = new QTabWidget(this);
+    d->tabWidget = new QTabWidget(this);
 
     QVBoxLayout *layout = new QVBoxLayout();
-    layout->addWidget(tabWidget);
+    layout->addWidget(d->tabWidget);
     this->setLayout(layout);
 
-    tabWidget->addTab(d->initializeGeneralTab(), tr("General"));
-    tabWidget->addTab(d->initializeEditorTab(), tr("Editor"));
-    tabWidget->addTab(d->initializeSpellCheckTab(), tr("Spell Check"));
+    // Only the first tab is built up front.  The others are built the
+    // first time they are shown, so that the dialog opens right away.
+    d->tabWidget->addTab(d->initializeGeneralTab(), tr("General"));
+    d->addLazyTab(&PreferencesDialogPrivate::initializeEditorTab, tr("Editor"));
+    d->addLazyTab(&PreferencesDialogPrivate::initializeSpellCheckTab, tr("Spell Check"));
+
+    this->connect
+    (
+        d->tabWidget,
+        &QTabWidget::currentChanged,
+        [d](int index) {
+            d->buildTab(index);
+        }
+    );
 
     QDialogButtonBox *buttonBox = new QDialogButtonBox(Qt::Horizontal, this);
     buttonBox->addButton(QDialogButtonBox::Close);
@@ -92,7 +112,7 @@ PreferencesDialog::PreferencesDialog(QWidget *parent)
 
     connect(buttonBox->button(QDialogButtonBox::Close), SIGNAL(clicked()), this, SLOT(close()));
 
-    tabWidget->setCurrentIndex(0);
+    d->tabWidget->setCurrentIndex(0);
 }
 
 PreferencesDialog::~PreferencesDialog()
@@ -100,6 +120,34 @@ PreferencesDialog::~PreferencesDialog()
     ;
 }
 
+void PreferencesDialogPrivate::addLazyTab
+(
+    QWidget *(PreferencesDialogPrivate::*builder)(),
+    const QString &label
+)
+{
+    Q_Q(PreferencesDialog);
+
+    // The placeholder page holds the tab's place until the tab is built.
+    QWidget *page = new QWidget(q);
+    QVBoxLayout *pageLayout = new QVBoxLayout();
+    pageLayout->setContentsMargins(0, 0, 0, 0);
+    page->setLayout(pageLayout);
+
+    int index = tabWidget->addTab(page, label);
+    pendingTabs.insert(index, builder);
+}
+
+void PreferencesDialogPrivate::buildTab(int index)
+{
+    if (!pendingTabs.contains(index)) {
+        return;
+    }
+
+    QWidget *(PreferencesDialogPrivate::*builder)() = pendingTabs.take(index);
+    tabWidget->widget(index)->layout()->addWidget((this->*builder)());
+}
+
 void PreferencesDialogPrivate::showAutoMatchFilterDialog()
 {
     Q_Q(PreferencesDialog);
@@ -206,6 +254,12 @@ QWidget *PreferencesDialogPrivate::initializeGeneralTab()
     connect(menuBarCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setHideMenuBarInFullScreenEnabled(bool)));
     displayGroupLayout->addRow(menuBarCheckBox);
 
+    QCheckBox *gpuViewportCheckBox = new QCheckBox(tr("Draw the editor with the graphics card (OpenGL)"));
+    gpuViewportCheckBox->setCheckable(true);
+    gpuViewportCheckBox->setChecked(appSettings->gpuViewportEnabled());
+    connect(gpuViewportCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setGpuViewportEnabled(bool)));
+    displayGroupLayout->addRow(gpuViewportCheckBox);
+
     QComboBox *cornersComboBox = new QComboBox(q);
     cornersComboBox->addItem(tr("Rounded"), QVariant(InterfaceStyleRounded));
     cornersComboBox->addItem(tr("Square"), QVariant(InterfaceStyleSquare));
@@ -235,6 +289,14 @@ QWidget *PreferencesDialogPrivate::initializeGeneralTab()
 
     savingGroupLayout->addRow(autoSaveCheckBox);
 
+    QCheckBox *autoSaveJournalCheckBox = new QCheckBox(tr("Auto save edits to a journal until the file is saved or closed"));
+    autoSaveJournalCheckBox->setCheckable(true);
+    autoSaveJournalCheckBox->setChecked(appSettings->autoSaveJournalEnabled());
+    autoSaveJournalCheckBox->setEnabled(appSettings->autoSaveEnabled());
+    connect(autoSaveJournalCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setAutoSaveJournalEnabled(bool)));
+    connect(autoSaveCheckBox, SIGNAL(toggled(bool)), autoSaveJournalCheckBox, SLOT(setEnabled(bool)));
+    savingGroupLayout->addRow(autoSaveJournalCheckBox);
+
     QCheckBox *backupCheckBox = new QCheckBox(tr("Backup file on save"));
     backupCheckBox->setCheckable(true);
     backupCheckBox->setChecked(appSettings->backupFileEnabled());
@@ -253,6 +315,146 @@ QWidget *PreferencesDialogPrivate::initializeGeneralTab()
     connect(rememberHistoryCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setFileHistoryEnabled(bool)));
     historyGroupLayout->addRow(rememberHistoryCheckBox);
 
+    QCheckBox *singleInstanceCheckBox = new QCheckBox(tr("Open files in the running instance"));
+    singleInstanceCheckBox->setCheckable(true);
+    singleInstanceCheckBox->setChecked(appSettings->singleInstanceEnabled());
+    connect(singleInstanceCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setSingleInstanceEnabled(bool)));
+    historyGroupLayout->addRow(singleInstanceCheckBox);
+
+    QGroupBox *largeDocumentGroupBox = new QGroupBox(tr("Large Documents"));
+    tabLayout->addWidget(largeDocumentGroupBox);
+
+    QFormLayout *largeDocumentGroupLayout = new QFormLayout();
+    largeDocumentGroupBox->setLayout(largeDocumentGroupLayout);
+
+    QCheckBox *largeDocumentCheckBox = new QCheckBox(tr("Scale back live features for large documents"));
+    largeDocumentCheckBox->setCheckable(true);
+    largeDocumentCheckBox->setChecked(appSettings->largeDocumentModeEnabled());
+    connect(largeDocumentCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setLargeDocumentModeEnabled(bool)));
+    largeDocumentGroupLayout->addRow(largeDocumentCheckBox);
+
+    // The thresholds are edited in thousands of characters.
+    QSpinBox *largeThresholdInput = new QSpinBox();
+    largeThresholdInput->setRange
+    (
+        appSettings->MIN_LARGE_DOCUMENT_THRESHOLD / 1000,
+        appSettings->MAX_LARGE_DOCUMENT_THRESHOLD / 1000
+    );
+    largeThresholdInput->setSingleStep(100);
+    largeThresholdInput->setSuffix(tr(" thousand characters"));
+    largeThresholdInput->setValue(appSettings->largeDocumentThreshold() / 1000);
+
+    q->connect
+    (
+        largeThresholdInput,
+        static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+        [this](int value) {
+            appSettings->setLargeDocumentThreshold(value * 1000);
+        }
+    );
+
+    largeDocumentGroupLayout->addRow(tr("Large document size"), largeThresholdInput);
+
+    QSpinBox *hugeThresholdInput = new QSpinBox();
+    hugeThresholdInput->setRange
+    (
+        appSettings->MIN_LARGE_DOCUMENT_THRESHOLD / 1000,
+        appSettings->MAX_LARGE_DOCUMENT_THRESHOLD / 1000
+    );
+    hugeThresholdInput->setSingleStep(1000);
+    hugeThresholdInput->setSuffix(tr(" thousand characters"));
+    hugeThresholdInput->setValue(appSettings->hugeDocumentThreshold() / 1000);
+
+    q->connect
+    (
+        hugeThresholdInput,
+        static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+        [this](int value) {
+            appSettings->setHugeDocumentThreshold(value * 1000);
+        }
+    );
+
+    largeDocumentGroupLayout->addRow(tr("Very large document size"), hugeThresholdInput);
+
+    QSpinBox *longLineThresholdInput = new QSpinBox();
+    longLineThresholdInput->setRange
+    (
+        appSettings->MIN_LONG_LINE_THRESHOLD,
+        appSettings->MAX_LONG_LINE_THRESHOLD
+    );
+    longLineThresholdInput->setSingleStep(1000);
+    longLineThresholdInput->setSuffix(tr(" characters"));
+    longLineThresholdInput->setValue(appSettings->longLineThreshold());
+    connect(longLineThresholdInput, SIGNAL(valueChanged(int)), appSettings, SLOT(setLongLineThreshold(int)));
+
+    largeDocumentGroupLayout->addRow(tr("Show lines longer than this plainly"), longLineThresholdInput);
+
+    QGroupBox *previewGroupBox = new QGroupBox(tr("Live Preview"));
+    tabLayout->addWidget(previewGroupBox);
+
+    QFormLayout *previewGroupLayout = new QFormLayout();
+    previewGroupBox->setLayout(previewGroupLayout);
+
+    QSpinBox *idleTimeoutInput = new QSpinBox();
+    idleTimeoutInput->setRange
+    (
+        appSettings->MIN_PREVIEW_IDLE_TIMEOUT,
+        appSettings->MAX_PREVIEW_IDLE_TIMEOUT
+    );
+    idleTimeoutInput->setSingleStep(10);
+    idleTimeoutInput->setSuffix(tr(" seconds"));
+    idleTimeoutInput->setValue(appSettings->previewIdleTimeout());
+    connect(idleTimeoutInput, SIGNAL(valueChanged(int)), appSettings, SLOT(setPreviewIdleTimeout(int)));
+
+    previewGroupLayout->addRow(tr("Unload hidden preview after"), idleTimeoutInput);
+
+    QGroupBox *memoryGroupBox = new QGroupBox(tr("Memory"));
+    tabLayout->addWidget(memoryGroupBox);
+
+    QFormLayout *memoryGroupLayout = new QFormLayout();
+    memoryGroupBox->setLayout(memoryGroupLayout);
+
+    QSpinBox *memoryCeilingInput = new QSpinBox();
+    memoryCeilingInput->setRange
+    (
+        appSettings->MIN_MEMORY_CEILING,
+        appSettings->MAX_MEMORY_CEILING
+    );
+    memoryCeilingInput->setSingleStep(128);
+    memoryCeilingInput->setSuffix(tr(" MB"));
+    memoryCeilingInput->setSpecialValueText(tr("No limit"));
+    memoryCeilingInput->setValue(appSettings->memoryCeiling());
+    connect(memoryCeilingInput, SIGNAL(valueChanged(int)), appSettings, SLOT(setMemoryCeiling(int)));
+
+    memoryGroupLayout->addRow(tr("Free caches above"), memoryCeilingInput);
+
+    QSpinBox *undoLimitInput = new QSpinBox();
+    undoLimitInput->setRange
+    (
+        appSettings->MIN_UNDO_MEMORY_LIMIT,
+        appSettings->MAX_UNDO_MEMORY_LIMIT
+    );
+    undoLimitInput->setSingleStep(16);
+    undoLimitInput->setSuffix(tr(" MB"));
+    undoLimitInput->setSpecialValueText(tr("No limit"));
+    undoLimitInput->setValue(appSettings->undoMemoryLimit());
+    connect(undoLimitInput, SIGNAL(valueChanged(int)), appSettings, SLOT(setUndoMemoryLimit(int)));
+
+    memoryGroupLayout->addRow(tr("Clear undo history above"), undoLimitInput);
+
+    QGroupBox *diagnosticsGroupBox = new QGroupBox(tr("Diagnostics"));
+    tabLayout->addWidget(diagnosticsGroupBox);
+
+    QFormLayout *diagnosticsGroupLayout = new QFormLayout();
+    diagnosticsGroupBox->setLayout(diagnosticsGroupLayout);
+
+    QCheckBox *stallReportsCheckBox = new QCheckBox(tr("Save a report when the application stops responding"));
+    stallReportsCheckBox->setCheckable(true);
+    stallReportsCheckBox->setChecked(appSettings->stallReportsEnabled());
+    stallReportsCheckBox->setToolTip(StallWatchdog::reportDirectory());
+    connect(stallReportsCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setStallReportsEnabled(bool)));
+    diagnosticsGroupLayout->addRow(stallReportsCheckBox);
+
     return tab;
 }
 
@@ -382,6 +584,18 @@ QWidget *PreferencesDialogPrivate::initializeEditorTab()
     connect(cycleBulletPointsCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setBulletPointCyclingEnabled(bool)));
     typingGroupLayout->addRow(cycleBulletPointsCheckBox);
 
+    QCheckBox *wordCompletionCheckBox = new QCheckBox(tr("Complete words used elsewhere in the document"));
+    wordCompletionCheckBox->setCheckable(true);
+    wordCompletionCheckBox->setChecked(appSettings->wordCompletionEnabled());
+    connect(wordCompletionCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setWordCompletionEnabled(bool)));
+    typingGroupLayout->addRow(wordCompletionCheckBox);
+
+    QCheckBox *tableFormattingCheckBox = new QCheckBox(tr("Align table columns while typing"));
+    tableFormattingCheckBox->setCheckable(true);
+    tableFormattingCheckBox->setChecked(appSettings->tableFormattingEnabled());
+    connect(tableFormattingCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setTableFormattingEnabled(bool)));
+    typingGroupLayout->addRow(tableFormattingCheckBox);
+
     QCheckBox *autoMatchCheckBox = new QCheckBox(tr("Automatically match characters"));
     autoMatchCheckBox->setCheckable(true);
     autoMatchCheckBox->setChecked(appSettings->autoMatchEnabled());
@@ -401,6 +615,26 @@ QWidget *PreferencesDialogPrivate::initializeEditorTab()
 
     typingGroupLayout->addRow(matchedCharsButton);
 
+    QCheckBox *imageImportCheckBox = new QCheckBox(tr("Copy dropped images into an assets folder"));
+    imageImportCheckBox->setCheckable(true);
+    imageImportCheckBox->setChecked(appSettings->imageImportEnabled());
+    connect(imageImportCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setImageImportEnabled(bool)));
+    typingGroupLayout->addRow(imageImportCheckBox);
+
+    QSpinBox *imageWidthInput = new QSpinBox();
+    imageWidthInput->setRange
+    (
+        appSettings->MIN_IMAGE_IMPORT_MAX_WIDTH,
+        appSettings->MAX_IMAGE_IMPORT_MAX_WIDTH
+    );
+    imageWidthInput->setSpecialValueText(tr("Full size"));
+    imageWidthInput->setSuffix(tr(" px"));
+    imageWidthInput->setValue(appSettings->imageImportMaxWidth());
+    imageWidthInput->setEnabled(appSettings->imageImportEnabled());
+    connect(imageWidthInput, SIGNAL(valueChanged(int)), appSettings, SLOT(setImageImportMaxWidth(int)));
+    connect(imageImportCheckBox, SIGNAL(toggled(bool)), imageWidthInput, SLOT(setEnabled(bool)));
+    typingGroupLayout->addRow(tr("Downscale copied images to"), imageWidthInput);
+
     return tab;
 }
 
@@ -456,6 +690,76 @@ QWidget *PreferencesDialogPrivate::initializeSpellCheckTab()
 
     languageGroupLayout->addRow(tr("Dictionary"), dictionaryComboBox);
 
+    // Other languages to detect per paragraph, for documents written in
+    // more than one language.
+    //
+    QListWidget *alternativeDictionariesList = new QListWidget();
+    QStringList alternativeLanguages = appSettings->alternativeDictionaryLanguages();
+
+    for (const QString &language : languages) {
+        QListWidgetItem *item = new QListWidgetItem(languageName(language), alternativeDictionariesList);
+        item->setData(Qt::UserRole, language);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(alternativeLanguages.contains(language) ? Qt::Checked : Qt::Unchecked);
+    }
+
+    q->connect
+    (
+        alternativeDictionariesList,
+        &QListWidget::itemChanged,
+    [this, alternativeDictionariesList]() {
+        QStringList languages;
+
+        for (int i = 0; i < alternativeDictionariesList->count(); i++) {
+            QListWidgetItem *item = alternativeDictionariesList->item(i);
+
+            if (Qt::Checked == item->checkState()) {
+                languages.append(item->data(Qt::UserRole).toString());
+            }
+        }
+
+        appSettings->setAlternativeDictionaryLanguages(languages);
+    }
+    );
+
+    languageGroupLayout->addRow(tr("Also detect"), alternativeDictionariesList);
+
+    QGroupBox *lintGroupBox = new QGroupBox(tr("Style Check"));
+    tabLayout->addWidget(lintGroupBox);
+
+    QFormLayout *lintGroupLayout = new QFormLayout();
+    lintGroupBox->setLayout(lintGroupLayout);
+
+    QCheckBox *lintCheckBox = new QCheckBox(tr("Check heading levels, list markers, whitespace and line length"));
+    lintCheckBox->setCheckable(true);
+    lintCheckBox->setChecked(appSettings->lintEnabled());
+    connect(lintCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setLintEnabled(bool)));
+    lintGroupLayout->addRow(lintCheckBox);
+
+    QSpinBox *lineLengthInput = new QSpinBox();
+    lineLengthInput->setRange
+    (
+        appSettings->MIN_LINT_LINE_LENGTH,
+        appSettings->MAX_LINT_LINE_LENGTH
+    );
+    lineLengthInput->setSpecialValueText(tr("No limit"));
+    lineLengthInput->setValue(appSettings->lintLineLength());
+    connect(lineLengthInput, SIGNAL(valueChanged(int)), appSettings, SLOT(setLintLineLength(int)));
+
+    lintGroupLayout->addRow(tr("Maximum line length"), lineLengthInput);
+
+    QCheckBox *webLinksCheckBox = new QCheckBox(tr("Check web links as well as local files"));
+    webLinksCheckBox->setCheckable(true);
+    webLinksCheckBox->setChecked(appSettings->lintWebLinksEnabled());
+    connect(webLinksCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setLintWebLinksEnabled(bool)));
+    lintGroupLayout->addRow(webLinksCheckBox);
+
+    QCheckBox *readabilityCheckBox = new QCheckBox(tr("Highlight sentences that are hard to read"));
+    readabilityCheckBox->setCheckable(true);
+    readabilityCheckBox->setChecked(appSettings->readabilityHighlightEnabled());
+    connect(readabilityCheckBox, SIGNAL(toggled(bool)), appSettings, SLOT(setReadabilityHighlightEnabled(bool)));
+    lintGroupLayout->addRow(readabilityCheckBox);
+
     return tab;
 }
 
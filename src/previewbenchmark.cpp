@@ -0,0 +1,448 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+
+#include "allocationcounter.h"
+#include "appsettings.h"
+#include "exporterfactory.h"
+#include "htmlpreview.h"
+#include "markdowndocument.h"
+#include "previewbenchmark.h"
+#include "previewtiming.h"
+
+namespace ghostwriter
+{
+const QString PreviewBenchmark::BENCHMARK_OPTION = "benchmark-preview";
+
+class PreviewBenchmarkPrivate
+{
+public:
+    PreviewBenchmarkPrivate()
+        : out(stdout), err(stderr)
+    {
+        ;
+    }
+
+    ~PreviewBenchmarkPrivate()
+    {
+        ;
+    }
+
+    // Exit codes of the application.
+    enum {
+        ExitSuccess = 0,
+        ExitBenchmarkFailed = 1,
+        ExitUsageError = 2
+    };
+
+    // Stages of the preview pipeline, in order, and the whole of it.
+    enum {
+        DebounceStage,
+        ExportStage,
+        DiffStage,
+        TransportStage,
+        PatchStage,
+        MathStage,
+        PaintStage,
+        TotalStage,
+        StageCount
+    };
+
+    // Default number of edits per document.
+    static const int DefaultEdits = 50;
+
+    // Milliseconds given to a page to load and show the whole document.
+    static const int LoadTimeout = 30000;
+
+    // Milliseconds given to an update to reach the page.  Edits whose
+    // blocks render to the same HTML never reach it.
+    static const int UpdateTimeout = 5000;
+
+    // Milliseconds left between an update and the next edit, so that work
+    // the page defers, such as highlighting code, does not overlap it.
+    static const int SettleTime = 100;
+
+    QTextStream out;
+    QTextStream err;
+
+    // Milliseconds spent by the updates in each stage.
+    QVector<double> stageTimes[StageCount];
+    int edits;
+    int timeouts;
+
+    // Allocations made while editing each document, if counted.
+    QStringList allocationReports;
+
+    /*
+    * Loads the given document into an offscreen preview and times the
+    * given number of edits to it.  Returns false if the preview could not
+    * load the document.
+    */
+    bool benchmark(const QString &filePath, Exporter *exporter, int editCount);
+
+    /*
+    * Adds the stage times of an update to the collected times.
+    */
+    void addTiming(double editTime, const PreviewTiming &timing);
+
+    /*
+    * Runs the event loop until the preview reports the timing of an
+    * update, or until the given number of milliseconds elapse.  Returns
+    * false on timeout.
+    */
+    bool waitForUpdate(HtmlPreview *preview, int msecs, PreviewTiming &timing);
+
+    /*
+    * Runs the event loop for the given number of milliseconds.
+    */
+    void runEventLoop(int msecs);
+
+    /*
+    * Adds the allocations made between the given counts while making the
+    * given number of edits to the given document to the report.
+    */
+    void addAllocations
+    (
+        const QString &filePath,
+        int editCount,
+        const AllocationCounter::Counts &before,
+        const AllocationCounter::Counts &after
+    );
+
+    /*
+    * Returns the given percentile of the sorted times, in milliseconds.
+    */
+    double percentile(const QVector<double> &sorted, double fraction) const;
+};
+
+PreviewBenchmark::PreviewBenchmark()
+    : d_ptr(new PreviewBenchmarkPrivate())
+{
+    ;
+}
+
+PreviewBenchmark::~PreviewBenchmark()
+{
+    ;
+}
+
+bool PreviewBenchmark::isRequested(const QStringList &arguments)
+{
+    foreach (const QString &argument, arguments) {
+        if (argument == (QString("--") + BENCHMARK_OPTION)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int PreviewBenchmark::exec(const QStringList &arguments)
+{
+    Q_D(PreviewBenchmark);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QObject::tr("Times scripted edits through the live preview and reports the latency of each stage."));
+    QCommandLineOption helpOption = parser.addHelpOption();
+
+    QCommandLineOption benchmarkOption
+    (
+        BENCHMARK_OPTION,
+        QObject::tr("Benchmark the latency of the live preview.")
+    );
+
+    QCommandLineOption editsOption
+    (
+        "edits",
+        QObject::tr("Number of edits to make to each document (default %1).")
+            .arg(PreviewBenchmarkPrivate::DefaultEdits),
+        QObject::tr("count"),
+        QString::number(PreviewBenchmarkPrivate::DefaultEdits)
+    );
+
+    parser.addOption(benchmarkOption);
+    parser.addOption(editsOption);
+    parser.addPositionalArgument
+    (
+        "files",
+        QObject::tr("Markdown files to edit."),
+        "files..."
+    );
+
+    if (!parser.parse(arguments)) {
+        d->err << parser.errorText() << "\n";
+        return PreviewBenchmarkPrivate::ExitUsageError;
+    }
+
+    if (parser.isSet(helpOption)) {
+        parser.showHelp(PreviewBenchmarkPrivate::ExitSuccess);
+    }
+
+    bool ok = false;
+    int editCount = parser.value(editsOption).toInt(&ok);
+
+    if (!ok || (editCount <= 0) || parser.positionalArguments().isEmpty()) {
+        d->err << QObject::tr("Give a positive number of edits and at least one Markdown file.") << "\n";
+        return PreviewBenchmarkPrivate::ExitUsageError;
+    }
+
+    Exporter *exporter = AppSettings::instance()->currentHtmlExporter();
+
+    if ((nullptr == exporter) && !ExporterFactory::instance()->htmlExporters().isEmpty()) {
+        exporter = ExporterFactory::instance()->htmlExporters().first();
+    }
+
+    if (nullptr == exporter) {
+        d->err << QObject::tr("No Markdown processor is available.") << "\n";
+        return PreviewBenchmarkPrivate::ExitBenchmarkFailed;
+    }
+
+    d->edits = 0;
+    d->timeouts = 0;
+
+    foreach (const QString &filePath, parser.positionalArguments()) {
+        if (!d->benchmark(filePath, exporter, editCount)) {
+            return PreviewBenchmarkPrivate::ExitBenchmarkFailed;
+        }
+    }
+
+    QString stageNames[PreviewBenchmarkPrivate::StageCount] = {
+        QObject::tr("Debounce"),
+        QObject::tr("Export"),
+        QObject::tr("Diff"),
+        QObject::tr("Transport"),
+        QObject::tr("Patch"),
+        QObject::tr("MathJax"),
+        QObject::tr("Paint"),
+        QObject::tr("Total")
+    };
+
+    d->out << QObject::tr("Processor: %1").arg(exporter->name()) << "\n";
+    d->out << QObject::tr("Documents: %1").arg(parser.positionalArguments().size()) << "\n";
+    d->out << QObject::tr("Edits: %1, timed out: %2").arg(d->edits).arg(d->timeouts) << "\n";
+
+    for (int i = 0; i < PreviewBenchmarkPrivate::StageCount; i++) {
+        QVector<double> &times = d->stageTimes[i];
+
+        if (times.isEmpty()) {
+            continue;
+        }
+
+        std::sort(times.begin(), times.end());
+
+        d->out << QObject::tr("%1 (ms): p50 %2, p90 %3, p95 %4, p99 %5, max %6")
+            .arg(stageNames[i])
+            .arg(d->percentile(times, 0.50), 0, 'f', 2)
+            .arg(d->percentile(times, 0.90), 0, 'f', 2)
+            .arg(d->percentile(times, 0.95), 0, 'f', 2)
+            .arg(d->percentile(times, 0.99), 0, 'f', 2)
+            .arg(times.last(), 0, 'f', 2) << "\n";
+    }
+
+    foreach (const QString &report, d->allocationReports) {
+        d->out << report << "\n";
+    }
+
+    d->out.flush();
+    return PreviewBenchmarkPrivate::ExitSuccess;
+}
+
+bool PreviewBenchmarkPrivate::benchmark
+(
+    const QString &filePath,
+    Exporter *exporter,
+    int editCount
+)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        err << QObject::tr("Could not read %1.").arg(filePath) << "\n";
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    MarkdownDocument document(stream.readAll());
+    file.close();
+
+    // Edits go at the end of the non-blank lines.
+    QVector<int> lines;
+
+    for (QTextBlock block = document.begin(); block.isValid(); block = block.next()) {
+        if (!block.text().trimmed().isEmpty()) {
+            lines.append(block.blockNumber());
+        }
+    }
+
+    if (lines.isEmpty()) {
+        err << QObject::tr("%1 has no text to edit.").arg(filePath) << "\n";
+        return false;
+    }
+
+    HtmlPreview preview(&document, exporter);
+    preview.setTimingEnabled(true);
+    preview.resize(1024, 768);
+    preview.show();
+
+    PreviewTiming timing;
+
+    if (!waitForUpdate(&preview, LoadTimeout, timing)) {
+        err << QObject::tr("The preview did not load %1.").arg(filePath) << "\n";
+        return false;
+    }
+
+    runEventLoop(SettleTime);
+
+    // Count the allocations of the edits only, not those of loading.
+    AllocationCounter::resetPeak();
+    AllocationCounter::Counts before = AllocationCounter::counts();
+
+    for (int i = 0; i < editCount; i++) {
+        // Scatter the lines edited over the document, editing each line
+        // twice in a row to insert and then remove the character.
+        int line = lines[((i / 2) * 7919) % lines.size()];
+        QTextBlock block = document.findBlockByNumber(line);
+        QTextCursor cursor(block);
+        cursor.movePosition(QTextCursor::EndOfBlock);
+
+        double editTime = PreviewTimingHook::now();
+
+        if (0 == (i % 2)) {
+            cursor.insertText("x");
+        } else {
+            cursor.deletePreviousChar();
+        }
+
+        preview.updatePreview();
+        edits++;
+
+        if (waitForUpdate(&preview, UpdateTimeout, timing)) {
+            addTiming(editTime, timing);
+        } else {
+            timeouts++;
+        }
+
+        runEventLoop(SettleTime);
+    }
+
+    if (AllocationCounter::isEnabled()) {
+        addAllocations(filePath, editCount, before, AllocationCounter::counts());
+    }
+
+    return true;
+}
+
+void PreviewBenchmarkPrivate::addTiming(double editTime, const PreviewTiming &timing)
+{
+    // Skip updates that the page made of its own accord.
+    if ((timing.renderStarted <= 0.0) || (timing.htmlSent <= 0.0)) {
+        return;
+    }
+
+    stageTimes[DebounceStage].append(timing.renderStarted - editTime);
+    stageTimes[ExportStage].append(timing.htmlExported - timing.renderStarted);
+    stageTimes[DiffStage].append(timing.htmlSent - timing.htmlExported);
+    stageTimes[TransportStage].append(timing.received - timing.htmlSent);
+    stageTimes[PatchStage].append(timing.patched - timing.received);
+    stageTimes[MathStage].append(timing.typeset - timing.patched);
+    stageTimes[PaintStage].append(timing.painted - timing.typeset);
+    stageTimes[TotalStage].append(timing.painted - editTime);
+}
+
+void PreviewBenchmarkPrivate::addAllocations
+(
+    const QString &filePath,
+    int editCount,
+    const AllocationCounter::Counts &before,
+    const AllocationCounter::Counts &after
+)
+{
+    qint64 allocations = after.allocations - before.allocations;
+    qint64 bytes = after.bytes - before.bytes;
+
+    allocationReports.append
+    (
+        QObject::tr("%1: %2 allocations (%3 per edit), %4 KiB allocated (%5 KiB per edit), peak live %6 KiB (%7 KiB over the start)")
+            .arg(QFileInfo(filePath).fileName())
+            .arg(allocations)
+            .arg(allocations / editCount)
+            .arg(bytes / 1024)
+            .arg(bytes / 1024 / editCount)
+            .arg(after.peakLiveBytes / 1024)
+            .arg((after.peakLiveBytes - before.liveBytes) / 1024)
+    );
+}
+
+bool PreviewBenchmarkPrivate::waitForUpdate
+(
+    HtmlPreview *preview,
+    int msecs,
+    PreviewTiming &timing
+)
+{
+    QEventLoop loop;
+    bool updated = false;
+
+    QObject::connect
+    (
+        preview,
+        &HtmlPreview::updateTimed,
+        &loop,
+        [&loop, &updated, &timing](const PreviewTiming &update) {
+            timing = update;
+            updated = true;
+            loop.quit();
+        }
+    );
+
+    QTimer::singleShot(msecs, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    return updated;
+}
+
+void PreviewBenchmarkPrivate::runEventLoop(int msecs)
+{
+    QEventLoop loop;
+    QTimer::singleShot(msecs, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+double PreviewBenchmarkPrivate::percentile(const QVector<double> &sorted, double fraction) const
+{
+    int index = qMin(sorted.size() - 1, (int) (fraction * sorted.size()));
+
+    return sorted[index];
+}
+} // namespace ghostwriter
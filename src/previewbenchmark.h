@@ -0,0 +1,83 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PREVIEW_BENCHMARK_H
+#define PREVIEW_BENCHMARK_H
+
+#include <QScopedPointer>
+#include <QStringList>
+
+namespace ghostwriter
+{
+/**
+ * Measures the end-to-end latency of the live preview.  Each given
+ * Markdown document is loaded into a preview on an offscreen page, and
+ * scripted edits are made to it, each followed by an update of the
+ * preview.  The time that each update spends in each stage of the
+ * preview pipeline, from the edit through the export to HTML, the
+ * transport of the changed blocks to the page, the patching of the page,
+ * MathJax and the paint, is collected from both sides of the web channel,
+ * and the percentiles of each stage are printed.
+ *
+ * Each edit inserts a character at the end of a paragraph, and the next
+ * one removes it again, so that the documents keep their structure.
+ *
+ * In builds that count allocations (see AllocationCounter), the
+ * allocations made and the peak of live memory while editing each
+ * document are reported as well.
+ */
+class PreviewBenchmarkPrivate;
+class PreviewBenchmark
+{
+    Q_DECLARE_PRIVATE(PreviewBenchmark)
+
+public:
+    /**
+     * Name of the command line option that selects the benchmark.
+     */
+    static const QString BENCHMARK_OPTION;
+
+    /**
+     * Constructor.
+     */
+    PreviewBenchmark();
+
+    /**
+     * Destructor.
+     */
+    ~PreviewBenchmark();
+
+    /**
+     * Returns true if the given application arguments ask for the preview
+     * benchmark rather than for the editor.
+     */
+    static bool isRequested(const QStringList &arguments);
+
+    /**
+     * Runs the benchmark given by the application arguments, printing the
+     * latency report.  Returns the exit code for the application.
+     */
+    int exec(const QStringList &arguments);
+
+private:
+    QScopedPointer<PreviewBenchmarkPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // PREVIEW_BENCHMARK_H
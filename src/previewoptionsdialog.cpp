@@ -46,6 +46,7 @@ public:
     }
 
     void onExporterChanged(int index);
+    void populateExporters();
     QString fontToString(const QFont &font) const;
 
     AppSettings *appSettings;
@@ -72,22 +73,7 @@ PreviewOptionsDialog::PreviewOptionsDialog(QWidget *parent)
     mainContents->setLayout(optionsLayout);
 
     d->previewerComboBox = new QComboBox(this);
-
-    QList<Exporter *> exporters = d->exporterFactory->htmlExporters();
-    Exporter *currentExporter = d->appSettings->currentHtmlExporter();
-
-    int currentExporterIndex = 0;
-
-    for (int i = 0; i < exporters.length(); i++) {
-        Exporter *exporter = exporters.at(i);
-        d->previewerComboBox->addItem(exporter->name(), QVariant::fromValue((void *) exporter));
-
-        if (exporter == currentExporter) {
-            currentExporterIndex = i;
-        }
-    }
-
-    d->previewerComboBox->setCurrentIndex(currentExporterIndex);
+    d->populateExporters();
 
     this->connect
     (
@@ -98,6 +84,17 @@ PreviewOptionsDialog::PreviewOptionsDialog(QWidget *parent)
         }
     );
 
+    // List Markdown processors as they are detected.  Application settings
+    // will have switched exporters beforehand if needed.
+    this->connect
+    (
+        d->exporterFactory,
+        &ExporterFactory::exportersChanged,
+        [d]() {
+            d->populateExporters();
+        }
+    );
+
     optionsLayout->addRow(tr("Markdown Flavor"), d->previewerComboBox);
 
     QHBoxLayout *fontLayout = new QHBoxLayout();
@@ -171,6 +168,31 @@ void PreviewOptionsDialogPrivate::onExporterChanged(int index)
     appSettings->setCurrentHtmlExporter(exporter);
 }
 
+void PreviewOptionsDialogPrivate::populateExporters()
+{
+    QList<Exporter *> exporters = exporterFactory->htmlExporters();
+    Exporter *currentExporter = appSettings->currentHtmlExporter();
+
+    int currentExporterIndex = 0;
+
+    // Filling the list is no choice of the user, so do not let it change
+    // the current exporter.
+    previewerComboBox->blockSignals(true);
+    previewerComboBox->clear();
+
+    for (int i = 0; i < exporters.length(); i++) {
+        Exporter *exporter = exporters.at(i);
+        previewerComboBox->addItem(exporter->name(), QVariant::fromValue((void *) exporter));
+
+        if (exporter == currentExporter) {
+            currentExporterIndex = i;
+        }
+    }
+
+    previewerComboBox->setCurrentIndex(currentExporterIndex);
+    previewerComboBox->blockSignals(false);
+}
+
 QString PreviewOptionsDialogPrivate::fontToString(const QFont &font) const
 {
     return QObject::tr("%1 %2pt")
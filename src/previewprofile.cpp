@@ -0,0 +1,131 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <QApplication>
+#include <QScreen>
+#include <QWebEngineUrlRequestInfo>
+#include <QWebEngineUrlRequestInterceptor>
+
+#include "imagestore.h"
+#include "previewprofile.h"
+
+namespace ghostwriter
+{
+/**
+ * Asks the web engine not to store remote content in the disk cache, and
+ * serves large local images from their downscaled copies in the
+ * ImageStore.
+ */
+class PreviewRequestInterceptor : public QWebEngineUrlRequestInterceptor
+{
+public:
+    PreviewRequestInterceptor(QObject *parent = nullptr)
+        : QWebEngineUrlRequestInterceptor(parent)
+    {
+        // The preview is never wider than the screen, so images are
+        // downscaled to the screen's width in device pixels.
+        QScreen *screen = QGuiApplication::primaryScreen();
+
+        thumbnailWidth = qRound
+            (
+                screen->availableGeometry().width() * screen->devicePixelRatio()
+            );
+    }
+
+    void interceptRequest(QWebEngineUrlRequestInfo &info)
+    {
+        QString scheme = info.requestUrl().scheme();
+
+        if (("http" == scheme) || ("https" == scheme)) {
+            info.setHttpHeader("Cache-Control", "no-store");
+        } else if
+        (
+            ("file" == scheme)
+            && (QWebEngineUrlRequestInfo::ResourceTypeImage == info.resourceType())
+        ) {
+            QString thumbnail =
+                ImageStore::thumbnail(info.requestUrl().toLocalFile(), thumbnailWidth);
+
+            if (!thumbnail.isNull()) {
+                info.redirect(QUrl::fromLocalFile(thumbnail));
+            }
+        }
+    }
+
+private:
+    int thumbnailWidth;
+};
+
+class PreviewProfilePrivate
+{
+public:
+    static PreviewProfile *instance;
+
+    PreviewProfilePrivate()
+    {
+        ;
+    }
+
+    ~PreviewProfilePrivate()
+    {
+        ;
+    }
+
+    // Largest size of the disk cache, in bytes.  The bundled scripts only
+    // need a few megabytes.
+    static const int MaxCacheSize = 32 * 1024 * 1024;
+};
+
+PreviewProfile *PreviewProfilePrivate::instance = nullptr;
+
+PreviewProfile *PreviewProfile::instance()
+{
+    if (nullptr == PreviewProfilePrivate::instance) {
+        // Parent the profile to the application so that it outlives the
+        // web pages using it.
+        PreviewProfilePrivate::instance = new PreviewProfile(qApp);
+    }
+
+    return PreviewProfilePrivate::instance;
+}
+
+PreviewProfile::~PreviewProfile()
+{
+    ;
+}
+
+PreviewProfile::PreviewProfile(QObject *parent)
+    : QWebEngineProfile(QStringLiteral("preview"), parent),
+    d_ptr(new PreviewProfilePrivate())
+{
+    this->setHttpCacheType(QWebEngineProfile::DiskHttpCache);
+    this->setHttpCacheMaximumSize(PreviewProfilePrivate::MaxCacheSize);
+    this->setPersistentCookiesPolicy(QWebEngineProfile::NoPersistentCookies);
+    this->clearAllVisitedLinks();
+
+    PreviewRequestInterceptor *interceptor = new PreviewRequestInterceptor(this);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    this->setUrlRequestInterceptor(interceptor);
+#else
+    this->setRequestInterceptor(interceptor);
+#endif
+}
+} // namespace ghostwriter
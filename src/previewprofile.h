@@ -0,0 +1,60 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef PREVIEW_PROFILE_H
+#define PREVIEW_PROFILE_H
+
+#include <QScopedPointer>
+#include <QWebEngineProfile>
+
+namespace ghostwriter
+{
+/**
+ * Web engine profile shared by all live previews.  Unlike the default
+ * profile, it is stored on disk, so that the web engine can keep its
+ * cache of the bundled preview scripts between runs.  Remote content that
+ * documents refer to, such as images, is never cached, nor are cookies
+ * kept.  Large local images are displayed from downscaled copies.
+ */
+class PreviewProfilePrivate;
+class PreviewProfile : public QWebEngineProfile
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(PreviewProfile)
+
+public:
+    /**
+     * Returns the single profile instance, creating it if necessary.
+     */
+    static PreviewProfile *instance();
+
+    /**
+     * Destructor.
+     */
+    virtual ~PreviewProfile();
+
+private:
+    QScopedPointer<PreviewProfilePrivate> d_ptr;
+
+    PreviewProfile(QObject *parent = nullptr);
+};
+} // namespace ghostwriter
+
+#endif // PREVIEW_PROFILE_H
@@ -0,0 +1,72 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QDateTime>
+#include <QElapsedTimer>
+
+#include "previewtiming.h"
+
+namespace ghostwriter
+{
+PreviewTimingHook::PreviewTimingHook(QObject *parent)
+    : QObject(parent),
+      enabled(false)
+{
+    ;
+}
+
+PreviewTimingHook::~PreviewTimingHook()
+{
+    ;
+}
+
+double PreviewTimingHook::now()
+{
+    // The wall clock only has millisecond precision, so count from the
+    // first call with the monotonic clock instead.
+    static const qint64 origin = QDateTime::currentMSecsSinceEpoch();
+    static QElapsedTimer clock;
+
+    if (!clock.isValid()) {
+        clock.start();
+    }
+
+    return origin + (clock.nsecsElapsed() / 1.0e6);
+}
+
+void PreviewTimingHook::setEnabled(bool enabled)
+{
+    if (enabled != this->enabled) {
+        this->enabled = enabled;
+        emit enabledChanged(enabled);
+    }
+}
+
+bool PreviewTimingHook::isEnabled() const
+{
+    return enabled;
+}
+
+void PreviewTimingHook::report(double received, double patched, double typeset, double painted)
+{
+    if (enabled) {
+        emit reported(received, patched, typeset, painted);
+    }
+}
+} // namespace ghostwriter
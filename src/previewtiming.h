@@ -0,0 +1,115 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PREVIEW_TIMING_H
+#define PREVIEW_TIMING_H
+
+#include <QObject>
+
+namespace ghostwriter
+{
+/**
+ * Times at which one update of the live preview passed each stage of the
+ * preview pipeline, in milliseconds since the epoch.  The first three are
+ * taken by the application, and the others by the preview page, so that
+ * both clocks share the wall clock as their reference.
+ */
+typedef struct {
+    // The export of the text to HTML started.
+    double renderStarted;
+
+    // The HTML was ready.
+    double htmlExported;
+
+    // The changed HTML blocks were sent to the page.
+    double htmlSent;
+
+    // The page received the changed blocks.
+    double received;
+
+    // The page's nodes were patched with the changed blocks.
+    double patched;
+
+    // MathJax typeset the math in the changed blocks.
+    double typeset;
+
+    // The page painted the changed blocks.
+    double painted;
+} PreviewTiming;
+
+/**
+ * Web channel object through which the preview page reports when it
+ * handled each update of the live preview, for measuring the latency of
+ * the preview.  The page reports only while the hook is enabled.
+ */
+class PreviewTimingHook : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled MEMBER enabled NOTIFY enabledChanged FINAL)
+
+public:
+    /**
+     * Constructor.
+     */
+    explicit PreviewTimingHook(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~PreviewTimingHook();
+
+    /**
+     * Returns the current time in milliseconds since the epoch, with
+     * sub-millisecond precision, as the page's clock gives it.
+     */
+    static double now();
+
+    /**
+     * Sets whether the page reports its timings.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns whether the page reports its timings.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Called by the page once it painted an update, with the times at
+     * which it received, patched, typeset and painted the update.
+     */
+    Q_INVOKABLE void report(double received, double patched, double typeset, double painted);
+
+signals:
+    /**
+     * Emitted when enabling the reports changes.
+     */
+    void enabledChanged(bool enabled);
+
+    /**
+     * Emitted when the page reports the timing of an update.
+     */
+    void reported(double received, double patched, double typeset, double painted);
+
+private:
+    bool enabled;
+};
+} // namespace ghostwriter
+
+#endif // PREVIEW_TIMING_H
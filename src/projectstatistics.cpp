@@ -0,0 +1,388 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QTimer>
+
+#include "projectstatistics.h"
+#include "taskscheduler.h"
+#include "texttokenizer.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+class ProjectStatisticsPrivate
+{
+    Q_DECLARE_PUBLIC(ProjectStatistics)
+
+public:
+    // Delay, in milliseconds, after the folder changes before it is
+    // rescanned, so that a burst of changes, such as from a version
+    // control checkout, rescans it only once.
+    static const int RescanDelay = 1000;
+
+    // Word count of a file, along with what identifies the version of the
+    // file that was counted.
+    struct CachedFile
+    {
+        qint64 size;
+        qint64 lastModified;
+        QByteArray hash;
+        int wordCount;
+    };
+
+    typedef QHash<QString, CachedFile> FileCache;
+
+    ProjectStatisticsPrivate(ProjectStatistics *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~ProjectStatisticsPrivate()
+    {
+        ;
+    }
+
+    ProjectStatistics *q_ptr;
+
+    QString folderPath;
+    QString openFilePath;
+    int openWordCount;
+
+    // Word counts of the Markdown files of the folder, as of the last scan.
+    FileCache files;
+
+    QFileSystemWatcher *folderWatcher;
+    QTimer *rescanTimer;
+    QFutureWatcher<FileCache> *scanWatcher;
+    QString scannedFolderPath;
+    bool scanPending;
+
+    ProjectStatistics::Statistics statistics;
+
+    /*
+    * Counts the words of the Markdown files in the given folder, reusing
+    * the counts of the given cache for the files that did not change.
+    * This method is run on the thread pool.
+    */
+    static FileCache scan(const QString &folderPath, const FileCache &cache);
+
+    void onScanFinished();
+
+    /*
+    * Totals the statistics of the files with the open document's live
+    * word count, emitting statisticsChanged() if they changed.
+    */
+    void updateStatistics();
+};
+
+ProjectStatistics::FileStatistics::FileStatistics()
+    : wordCount(0)
+{
+    ;
+}
+
+bool ProjectStatistics::FileStatistics::operator==(const FileStatistics &other) const
+{
+    return (wordCount == other.wordCount) && (filePath == other.filePath);
+}
+
+ProjectStatistics::Statistics::Statistics()
+    : fileCount(0),
+      wordCount(0),
+      pageCount(0),
+      readingTime(0)
+{
+    ;
+}
+
+bool ProjectStatistics::Statistics::operator==(const Statistics &other) const
+{
+    return (fileCount == other.fileCount)
+        && (wordCount == other.wordCount)
+        && (pageCount == other.pageCount)
+        && (readingTime == other.readingTime)
+        && (files == other.files);
+}
+
+bool ProjectStatistics::Statistics::operator!=(const Statistics &other) const
+{
+    return !(*this == other);
+}
+
+ProjectStatistics::ProjectStatistics(QObject *parent)
+    : QObject(parent), d_ptr(new ProjectStatisticsPrivate(this))
+{
+    Q_D(ProjectStatistics);
+
+    d->openWordCount = 0;
+    d->scanPending = false;
+
+    d->folderWatcher = new QFileSystemWatcher(this);
+    d->rescanTimer = new QTimer(this);
+    d->rescanTimer->setSingleShot(true);
+    d->rescanTimer->setInterval(ProjectStatisticsPrivate::RescanDelay);
+    d->scanWatcher = new QFutureWatcher<ProjectStatisticsPrivate::FileCache>(this);
+
+    this->connect
+    (
+        d->folderWatcher,
+        &QFileSystemWatcher::directoryChanged,
+        d->rescanTimer,
+        static_cast<void (QTimer::*)()>(&QTimer::start)
+    );
+    this->connect(d->rescanTimer, &QTimer::timeout, this, &ProjectStatistics::rescan);
+    this->connect
+    (
+        d->scanWatcher,
+        &QFutureWatcherBase::finished,
+        [d]() {
+            d->onScanFinished();
+        }
+    );
+}
+
+ProjectStatistics::~ProjectStatistics()
+{
+    ;
+}
+
+ProjectStatistics::Statistics ProjectStatistics::statistics() const
+{
+    Q_D(const ProjectStatistics);
+
+    return d->statistics;
+}
+
+void ProjectStatistics::setOpenFile(const QString &filePath)
+{
+    Q_D(ProjectStatistics);
+
+    QString absolutePath;
+    QString folderPath;
+
+    if (!filePath.isEmpty()) {
+        QFileInfo info(filePath);
+        absolutePath = info.absoluteFilePath();
+        folderPath = info.absolutePath();
+    }
+
+    d->openFilePath = absolutePath;
+
+    if (folderPath == d->folderPath) {
+        d->updateStatistics();
+        return;
+    }
+
+    if (!d->folderPath.isEmpty()) {
+        d->folderWatcher->removePath(d->folderPath);
+    }
+
+    d->folderPath = folderPath;
+    d->files.clear();
+
+    if (!folderPath.isEmpty()) {
+        d->folderWatcher->addPath(folderPath);
+    }
+
+    d->updateStatistics();
+    rescan();
+}
+
+void ProjectStatistics::setOpenDocumentWordCount(int wordCount)
+{
+    Q_D(ProjectStatistics);
+
+    if (wordCount != d->openWordCount) {
+        d->openWordCount = wordCount;
+        d->updateStatistics();
+    }
+}
+
+void ProjectStatistics::rescan()
+{
+    Q_D(ProjectStatistics);
+
+    d->rescanTimer->stop();
+
+    if (d->folderPath.isEmpty()) {
+        return;
+    }
+
+    if (d->scanWatcher->isRunning()) {
+        d->scanPending = true;
+        return;
+    }
+
+    QString folderPath = d->folderPath;
+    ProjectStatisticsPrivate::FileCache cache = d->files;
+
+    d->scannedFolderPath = folderPath;
+
+    d->scanWatcher->setFuture
+    (
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Statistics,
+            [folderPath, cache]() {
+                return ProjectStatisticsPrivate::scan(folderPath, cache);
+            }
+        )
+    );
+}
+
+ProjectStatisticsPrivate::FileCache ProjectStatisticsPrivate::scan
+(
+    const QString &folderPath,
+    const FileCache &cache
+)
+{
+    GW_TRACE_SCOPE("ProjectStatistics::scan");
+
+    static const QStringList markdownFilters =
+    {
+        "*.md", "*.markdown", "*.mdown", "*.mkdn", "*.mkd",
+        "*.mdwn", "*.mdtxt", "*.mdtext", "*.Rmd"
+    };
+
+    FileCache files;
+    QFileInfoList entries =
+        QDir(folderPath).entryInfoList(markdownFilters, QDir::Files | QDir::Readable);
+
+    for (const QFileInfo &info : entries) {
+        QString path = info.absoluteFilePath();
+        qint64 lastModified = info.lastModified().toMSecsSinceEpoch();
+        auto cached = cache.constFind(path);
+
+        if
+        (
+            (cached != cache.constEnd())
+            && (cached->size == info.size())
+            && (cached->lastModified == lastModified)
+        ) {
+            files.insert(path, *cached);
+            continue;
+        }
+
+        QFile file(path);
+
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+
+        QByteArray data = file.readAll();
+        CachedFile entry;
+        entry.size = info.size();
+        entry.lastModified = lastModified;
+        entry.hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+
+        // Files that were only touched, or saved without changes, keep
+        // their count.
+        if ((cached != cache.constEnd()) && (cached->hash == entry.hash)) {
+            entry.wordCount = cached->wordCount;
+        } else {
+            entry.wordCount = TextTokenizer::count(QString::fromUtf8(data)).words;
+        }
+
+        files.insert(path, entry);
+    }
+
+    return files;
+}
+
+void ProjectStatisticsPrivate::onScanFinished()
+{
+    // Drop the scan of a folder that is no longer the open document's.
+    if (!scanWatcher->isCanceled() && (scannedFolderPath == folderPath)) {
+        files = scanWatcher->result();
+    }
+
+    if (scanPending) {
+        scanPending = false;
+        q_func()->rescan();
+    }
+
+    updateStatistics();
+}
+
+void ProjectStatisticsPrivate::updateStatistics()
+{
+    Q_Q(ProjectStatistics);
+
+    ProjectStatistics::Statistics newStatistics;
+    bool openFileCounted = false;
+
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        ProjectStatistics::FileStatistics file;
+        file.filePath = it.key();
+
+        if (it.key() == openFilePath) {
+            file.wordCount = openWordCount;
+            openFileCounted = true;
+        } else {
+            file.wordCount = it->wordCount;
+        }
+
+        newStatistics.files.append(file);
+    }
+
+    // The open document counts even before it is saved into the folder
+    // or found by a scan.
+    if (!openFileCounted) {
+        ProjectStatistics::FileStatistics file;
+        file.filePath = openFilePath;
+        file.wordCount = openWordCount;
+        newStatistics.files.append(file);
+    }
+
+    std::sort
+    (
+        newStatistics.files.begin(),
+        newStatistics.files.end(),
+        [](const ProjectStatistics::FileStatistics &a, const ProjectStatistics::FileStatistics &b) {
+            return QString::localeAwareCompare(a.filePath, b.filePath) < 0;
+        }
+    );
+
+    for (const ProjectStatistics::FileStatistics &file : newStatistics.files) {
+        newStatistics.wordCount += file.wordCount;
+    }
+
+    newStatistics.fileCount = newStatistics.files.size();
+
+    // Same page size and reading speed as for the document statistics.
+    newStatistics.pageCount = newStatistics.wordCount / 250;
+    newStatistics.readingTime = newStatistics.wordCount / 270;
+
+    if (newStatistics != statistics) {
+        statistics = newStatistics;
+        emit q->statisticsChanged(statistics);
+    }
+}
+} // namespace ghostwriter
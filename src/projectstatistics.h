@@ -0,0 +1,126 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PROJECT_STATISTICS_H
+#define PROJECT_STATISTICS_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Totals the statistics of the Markdown files in the folder of the open
+ * document, such as the chapters of a book, for the project statistics.
+ * The other files are scanned on the statistics lane of the TaskScheduler
+ * with the same tokenizer as DocumentStatistics, and the word count of
+ * each is cached by size, modification time and content hash, so that
+ * rescanning the folder only counts the files that changed.  The open
+ * document counts with its live word count, so that the totals follow
+ * its edits without rescanning anything.  The folder is rescanned when
+ * its files are added, removed or renamed.
+ */
+class ProjectStatisticsPrivate;
+class ProjectStatistics : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(ProjectStatistics)
+
+public:
+    /**
+     * Word count of one file of the project.
+     */
+    struct FileStatistics
+    {
+        QString filePath;
+        int wordCount;
+
+        FileStatistics();
+
+        bool operator==(const FileStatistics &other) const;
+    };
+
+    /**
+     * Statistics of the whole project.
+     */
+    struct Statistics
+    {
+        int fileCount;
+        int wordCount;
+        int pageCount;
+
+        // Reading time in minutes.
+        int readingTime;
+
+        // Statistics of each file, sorted by file name.
+        QVector<FileStatistics> files;
+
+        Statistics();
+
+        bool operator==(const Statistics &other) const;
+        bool operator!=(const Statistics &other) const;
+    };
+
+    /**
+     * Constructor.
+     */
+    ProjectStatistics(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~ProjectStatistics();
+
+    /**
+     * Returns the last statistics computed.
+     */
+    Statistics statistics() const;
+
+signals:
+    /**
+     * Emitted when the statistics of the project change.
+     */
+    void statisticsChanged(const ProjectStatistics::Statistics &statistics);
+
+public slots:
+    /**
+     * Sets the file path of the open document, rescanning its folder if
+     * the folder changed.  An empty path leaves only the open document in
+     * the project.
+     */
+    void setOpenFile(const QString &filePath);
+
+    /**
+     * Sets the current word count of the open document.
+     */
+    void setOpenDocumentWordCount(int wordCount);
+
+    /**
+     * Rescans the folder of the open document.
+     */
+    void rescan();
+
+private:
+    QScopedPointer<ProjectStatisticsPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // PROJECT_STATISTICS_H
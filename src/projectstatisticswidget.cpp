@@ -0,0 +1,126 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFileInfo>
+#include <QLabel>
+#include <QVector>
+
+#include "projectstatisticswidget.h"
+
+namespace ghostwriter
+{
+class ProjectStatisticsWidgetPrivate
+{
+public:
+    ProjectStatisticsWidgetPrivate()
+    {
+        ;
+    }
+
+    ~ProjectStatisticsWidgetPrivate()
+    {
+        ;
+    }
+
+    QLabel *fileCountLabel;
+    QLabel *wordCountLabel;
+    QLabel *pageCountLabel;
+    QLabel *readingTimeLabel;
+
+    // Number of rows of the totals, after which come the rows of the
+    // files, along with the value label and path of each file row.
+    int totalRowCount;
+    QVector<QLabel *> fileLabels;
+    QStringList filePaths;
+
+    // Latest statistics set, which are displayed once the widget is shown
+    // if it was hidden.
+    ProjectStatistics::Statistics statistics;
+};
+
+ProjectStatisticsWidget::ProjectStatisticsWidget(QWidget *parent)
+    : AbstractStatisticsWidget(parent),
+      d_ptr(new ProjectStatisticsWidgetPrivate())
+{
+    Q_D(ProjectStatisticsWidget);
+
+    d->fileCountLabel = addStatisticLabel(tr("Files:"), "0");
+    d->wordCountLabel = addStatisticLabel(tr("Words:"), "0");
+    d->pageCountLabel = addStatisticLabel(tr("Pages:"), LESS_THAN_ONE_STR, PAGE_STATISTIC_INFO_TOOLTIP_STR);
+    d->readingTimeLabel = addStatisticLabel(tr("Reading Time:"), LESS_THAN_ONE_MINUTE_STR);
+    d->totalRowCount = count();
+}
+
+ProjectStatisticsWidget::~ProjectStatisticsWidget()
+{
+    ;
+}
+
+void ProjectStatisticsWidget::setStatistics(const ProjectStatistics::Statistics &statistics)
+{
+    Q_D(ProjectStatisticsWidget);
+
+    d->statistics = statistics;
+
+    if (!deferDisplay()) {
+        displayStatistics();
+    }
+}
+
+void ProjectStatisticsWidget::displayStatistics()
+{
+    Q_D(ProjectStatisticsWidget);
+
+    const ProjectStatistics::Statistics &statistics = d->statistics;
+
+    setIntegerValueForLabel(d->fileCountLabel, statistics.fileCount);
+    setIntegerValueForLabel(d->wordCountLabel, statistics.wordCount);
+    setPageValueForLabel(d->pageCountLabel, statistics.pageCount);
+    setTimeValueForLabel(d->readingTimeLabel, statistics.readingTime);
+
+    QStringList filePaths;
+
+    for (const ProjectStatistics::FileStatistics &file : statistics.files) {
+        filePaths.append(file.filePath);
+    }
+
+    // Rebuild the file rows only when files come or go, since edits to
+    // the open document only change its count.
+    if (filePaths != d->filePaths) {
+        while (count() > d->totalRowCount) {
+            delete takeItem(count() - 1);
+        }
+
+        d->fileLabels.clear();
+        d->filePaths = filePaths;
+
+        for (const QString &filePath : filePaths) {
+            QString name = filePath.isEmpty()
+                ? tr("untitled")
+                : QFileInfo(filePath).completeBaseName();
+
+            d->fileLabels.append(addStatisticLabel(name + ":", "0", filePath));
+        }
+    }
+
+    for (int i = 0; i < statistics.files.size(); i++) {
+        setIntegerValueForLabel(d->fileLabels[i], statistics.files[i].wordCount);
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,69 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PROJECTSTATISTICSWIDGET_H
+#define PROJECTSTATISTICSWIDGET_H
+
+#include <QScopedPointer>
+
+#include "abstractstatisticswidget.h"
+#include "projectstatistics.h"
+
+namespace ghostwriter
+{
+/**
+ * Widget to display the totals of the project statistics, followed by the
+ * word count of each file of the project.
+ */
+class ProjectStatisticsWidgetPrivate;
+class ProjectStatisticsWidget : public AbstractStatisticsWidget
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(ProjectStatisticsWidget)
+
+public:
+    /**
+     * Constructor.
+     */
+    ProjectStatisticsWidget(QWidget *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~ProjectStatisticsWidget();
+
+public slots:
+    /**
+     * Sets the statistics to display.  While the widget is hidden, the
+     * statistics are only stored, and are displayed once it is shown.
+     */
+    void setStatistics(const ProjectStatistics::Statistics &statistics);
+
+protected:
+    /**
+     * Overridden to display the latest statistics set.
+     */
+    void displayStatistics();
+
+private:
+    QScopedPointer<ProjectStatisticsWidgetPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // PROJECTSTATISTICSWIDGET_H
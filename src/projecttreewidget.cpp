@@ -0,0 +1,571 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <algorithm>
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QQueue>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QTreeWidgetItem>
+#include <QVector>
+
+#include "projecttreewidget.h"
+#include "taskscheduler.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+// Entry of a folder.
+typedef struct
+{
+    QString name;
+    bool isFolder;
+} FolderEntry;
+
+// Entries of a folder, with the folders first and each sorted by name.
+typedef struct
+{
+    QString folderPath;
+
+    // Generation of the tree for which the folder was listed, so that the
+    // listings of a previous root folder are ignored.
+    int generation;
+
+    QVector<FolderEntry> entries;
+} FolderListing;
+
+// Entries of a listing still to be added to the tree.
+typedef struct
+{
+    QString folderPath;
+    QVector<FolderEntry> entries;
+    int next;
+} PendingEntries;
+
+class ProjectTreeWidgetPrivate
+{
+    Q_DECLARE_PUBLIC(ProjectTreeWidget)
+
+public:
+    ProjectTreeWidgetPrivate(ProjectTreeWidget *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~ProjectTreeWidgetPrivate()
+    {
+        ;
+    }
+
+    static const int PATH_ROLE;
+    static const int FOLDER_ROLE;
+
+    // Number of entries added to the tree per turn of the event loop.
+    static const int BATCH_SIZE = 200;
+
+    ProjectTreeWidget *q_ptr;
+
+    QString rootPath;
+    int generation;
+    TaskScheduler::CancellationToken token;
+    QFileSystemWatcher *watcher;
+    QTimer *batchTimer;
+
+    // Items of the folders in the tree by path.  The root folder's item
+    // is the tree's invisible root item.
+    QHash<QString, QTreeWidgetItem *> folderItems;
+
+    QSet<QString> watchedFolders;
+    QSet<QString> foldersListing;
+    QSet<QString> foldersChangedWhileListing;
+    QQueue<PendingEntries> pendingEntries;
+
+    static FolderListing listFolder
+    (
+        const QString &path,
+        int generation,
+        const TaskScheduler::CancellationToken &token
+    );
+    static bool entryLessThan(const FolderEntry &a, const FolderEntry &b);
+
+    void list(const QString &path);
+    void onListed(const FolderListing &listing);
+    void addPendingEntries();
+    void addEntry(QTreeWidgetItem *parent, const QString &folderPath, const FolderEntry &entry);
+    void watch(QTreeWidgetItem *item);
+    void unwatch(QTreeWidgetItem *item);
+    void forget(QTreeWidgetItem *item);
+    void onDirectoryChanged(const QString &path);
+    void onItemSelected(QTreeWidgetItem *item);
+};
+
+const int ProjectTreeWidgetPrivate::PATH_ROLE = Qt::UserRole + 1;
+const int ProjectTreeWidgetPrivate::FOLDER_ROLE = Qt::UserRole + 2;
+
+ProjectTreeWidget::ProjectTreeWidget(QWidget *parent)
+    : QTreeWidget(parent),
+      d_ptr(new ProjectTreeWidgetPrivate(this))
+{
+    Q_D(ProjectTreeWidget);
+
+    d->generation = 0;
+    d->token = TaskScheduler::createCancellationToken();
+    d->watcher = new QFileSystemWatcher(this);
+
+    d->batchTimer = new QTimer(this);
+    d->batchTimer->setInterval(0);
+
+    this->setColumnCount(1);
+    this->setHeaderHidden(true);
+    this->setUniformRowHeights(true);
+    this->setTextElideMode(Qt::ElideRight);
+
+    this->connect
+    (
+        d->batchTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->addPendingEntries();
+        }
+    );
+
+    this->connect
+    (
+        d->watcher,
+        &QFileSystemWatcher::directoryChanged,
+        [d](const QString &path) {
+            d->onDirectoryChanged(path);
+        }
+    );
+
+    this->connect
+    (
+        this,
+        &QTreeWidget::itemExpanded,
+        [d](QTreeWidgetItem *item) {
+            d->watch(item);
+        }
+    );
+
+    this->connect
+    (
+        this,
+        &QTreeWidget::itemCollapsed,
+        [d](QTreeWidgetItem *item) {
+            d->unwatch(item);
+        }
+    );
+
+    this->connect
+    (
+        this,
+        &QTreeWidget::itemActivated,
+        [d](QTreeWidgetItem *item) {
+            d->onItemSelected(item);
+        }
+    );
+
+    this->connect
+    (
+        this,
+        &QTreeWidget::itemClicked,
+        [d](QTreeWidgetItem *item) {
+            d->onItemSelected(item);
+        }
+    );
+}
+
+ProjectTreeWidget::~ProjectTreeWidget()
+{
+    Q_D(ProjectTreeWidget);
+
+    TaskScheduler::cancel(d->token);
+}
+
+QString ProjectTreeWidget::folder() const
+{
+    Q_D(const ProjectTreeWidget);
+
+    return d->rootPath;
+}
+
+void ProjectTreeWidget::setFolder(const QString &path)
+{
+    Q_D(ProjectTreeWidget);
+
+    if (path == d->rootPath) {
+        return;
+    }
+
+    // Abandon the listings of the previous folder.
+    TaskScheduler::cancel(d->token);
+    d->token = TaskScheduler::createCancellationToken();
+    d->generation++;
+
+    if (!d->watchedFolders.isEmpty()) {
+        d->watcher->removePaths(d->watchedFolders.values());
+    }
+
+    d->watchedFolders.clear();
+    d->foldersListing.clear();
+    d->foldersChangedWhileListing.clear();
+    d->pendingEntries.clear();
+    d->batchTimer->stop();
+    d->folderItems.clear();
+    this->clear();
+
+    d->rootPath = path;
+
+    if (!path.isEmpty()) {
+        d->folderItems.insert(path, this->invisibleRootItem());
+        d->watchedFolders.insert(path);
+        d->watcher->addPath(path);
+        d->list(path);
+    }
+}
+
+FolderListing ProjectTreeWidgetPrivate::listFolder
+(
+    const QString &path,
+    int generation,
+    const TaskScheduler::CancellationToken &token
+)
+{
+    GW_TRACE_SCOPE("ProjectTreeWidget::listFolder");
+
+    static const QStringList nameFilters = {
+        "*.md", "*.markdown", "*.mdown", "*.mkdn", "*.mkd",
+        "*.mdwn", "*.mdtxt", "*.mdtext", "*.Rmd", "*.text", "*.txt"
+    };
+
+    FolderListing listing;
+    listing.folderPath = path;
+    listing.generation = generation;
+
+    // Folders are listed whatever their names, since the name filters
+    // only apply to files when AllDirs is given.
+    QDirIterator it
+    (
+        path,
+        nameFilters,
+        QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Readable
+    );
+
+    while (it.hasNext()) {
+        if (TaskScheduler::isCancelled(token)) {
+            return listing;
+        }
+
+        it.next();
+
+        FolderEntry entry;
+        entry.name = it.fileName();
+        entry.isFolder = it.fileInfo().isDir();
+        listing.entries.append(entry);
+    }
+
+    std::sort(listing.entries.begin(), listing.entries.end(), entryLessThan);
+    return listing;
+}
+
+bool ProjectTreeWidgetPrivate::entryLessThan(const FolderEntry &a, const FolderEntry &b)
+{
+    if (a.isFolder != b.isFolder) {
+        return a.isFolder;
+    }
+
+    return QString::compare(a.name, b.name, Qt::CaseInsensitive) < 0;
+}
+
+void ProjectTreeWidgetPrivate::list(const QString &path)
+{
+    Q_Q(ProjectTreeWidget);
+
+    // Changes during a listing might be missing from it, so list the
+    // folder again once it is done.
+    if (foldersListing.contains(path)) {
+        foldersChangedWhileListing.insert(path);
+        return;
+    }
+
+    foldersListing.insert(path);
+
+    QFutureWatcher<FolderListing> *futureWatcher =
+        new QFutureWatcher<FolderListing>(q);
+
+    q->connect
+    (
+        futureWatcher,
+        &QFutureWatcher<FolderListing>::finished,
+        [this, futureWatcher]() {
+            if (!futureWatcher->isCanceled()) {
+                onListed(futureWatcher->result());
+            }
+
+            futureWatcher->deleteLater();
+        }
+    );
+
+    int generation = this->generation;
+    TaskScheduler::CancellationToken token = this->token;
+
+    futureWatcher->setFuture
+    (
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Indexing,
+            [path, generation, token]() {
+                return listFolder(path, generation, token);
+            },
+            token
+        )
+    );
+}
+
+void ProjectTreeWidgetPrivate::onListed(const FolderListing &listing)
+{
+    if (listing.generation != generation) {
+        return;
+    }
+
+    const QString &path = listing.folderPath;
+    foldersListing.remove(path);
+
+    QTreeWidgetItem *parent = folderItems.value(path, nullptr);
+
+    if (nullptr == parent) {
+        foldersChangedWhileListing.remove(path);
+        return;
+    }
+
+    if (foldersChangedWhileListing.remove(path)) {
+        list(path);
+    }
+
+    // The listing supersedes entries of the folder not yet added.
+    for (int i = pendingEntries.size() - 1; i >= 0; i--) {
+        if (pendingEntries[i].folderPath == path) {
+            pendingEntries.removeAt(i);
+        }
+    }
+
+    QHash<QString, bool> listed;
+
+    for (const FolderEntry &entry : listing.entries) {
+        listed.insert(entry.name, entry.isFolder);
+    }
+
+    // Remove the entries that are gone, and keep the others as they are
+    // so that their subfolders stay expanded.
+    QSet<QString> kept;
+
+    for (int i = parent->childCount() - 1; i >= 0; i--) {
+        QTreeWidgetItem *child = parent->child(i);
+        QString name = child->text(0);
+        bool isFolder = child->data(0, FOLDER_ROLE).toBool();
+        auto entry = listed.constFind(name);
+
+        if ((listed.constEnd() == entry) || (entry.value() != isFolder)) {
+            forget(child);
+            delete parent->takeChild(i);
+        } else {
+            kept.insert(name);
+        }
+    }
+
+    PendingEntries added;
+    added.folderPath = path;
+    added.next = 0;
+
+    for (const FolderEntry &entry : listing.entries) {
+        if (!kept.contains(entry.name)) {
+            added.entries.append(entry);
+        }
+    }
+
+    if (listing.entries.isEmpty()) {
+        parent->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+    }
+
+    if (!added.entries.isEmpty()) {
+        pendingEntries.enqueue(added);
+        addPendingEntries();
+    }
+}
+
+void ProjectTreeWidgetPrivate::addPendingEntries()
+{
+    int remaining = BATCH_SIZE;
+
+    while ((remaining > 0) && !pendingEntries.isEmpty()) {
+        PendingEntries &pending = pendingEntries.head();
+        QTreeWidgetItem *parent = folderItems.value(pending.folderPath, nullptr);
+
+        if (nullptr != parent) {
+            while ((remaining > 0) && (pending.next < pending.entries.size())) {
+                addEntry(parent, pending.folderPath, pending.entries[pending.next]);
+                pending.next++;
+                remaining--;
+            }
+
+            if (pending.next < pending.entries.size()) {
+                break;
+            }
+        }
+
+        pendingEntries.dequeue();
+    }
+
+    if (pendingEntries.isEmpty()) {
+        batchTimer->stop();
+    } else if (!batchTimer->isActive()) {
+        batchTimer->start();
+    }
+}
+
+void ProjectTreeWidgetPrivate::addEntry
+(
+    QTreeWidgetItem *parent,
+    const QString &folderPath,
+    const FolderEntry &entry
+)
+{
+    // Find where the entry goes among the children, which are kept in
+    // the same order as the listings.
+    int low = 0;
+    int high = parent->childCount();
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+        QTreeWidgetItem *child = parent->child(middle);
+
+        FolderEntry childEntry;
+        childEntry.name = child->text(0);
+        childEntry.isFolder = child->data(0, FOLDER_ROLE).toBool();
+
+        if (entryLessThan(childEntry, entry)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    QString path = QDir(folderPath).filePath(entry.name);
+
+    QTreeWidgetItem *item = new QTreeWidgetItem();
+    item->setText(0, entry.name);
+    item->setToolTip(0, QDir::toNativeSeparators(path));
+    item->setData(0, PATH_ROLE, path);
+    item->setData(0, FOLDER_ROLE, entry.isFolder);
+
+    if (entry.isFolder) {
+        // Folders are listed when first expanded, so show that they can
+        // be expanded until then.
+        item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+        folderItems.insert(path, item);
+    }
+
+    parent->insertChild(low, item);
+}
+
+void ProjectTreeWidgetPrivate::watch(QTreeWidgetItem *item)
+{
+    QString path = item->data(0, PATH_ROLE).toString();
+
+    if (!watchedFolders.contains(path)) {
+        watchedFolders.insert(path);
+        watcher->addPath(path);
+    }
+
+    // List the folder, or list it again since it was not watched while
+    // collapsed.
+    list(path);
+
+    // Subfolders left expanded when this folder was collapsed are shown
+    // again, so watch them too.
+    for (int i = 0; i < item->childCount(); i++) {
+        QTreeWidgetItem *child = item->child(i);
+
+        if (child->isExpanded()) {
+            watch(child);
+        }
+    }
+}
+
+void ProjectTreeWidgetPrivate::unwatch(QTreeWidgetItem *item)
+{
+    QString path = item->data(0, PATH_ROLE).toString();
+
+    if (watchedFolders.remove(path)) {
+        watcher->removePath(path);
+    }
+
+    for (int i = 0; i < item->childCount(); i++) {
+        QTreeWidgetItem *child = item->child(i);
+
+        if (child->isExpanded()) {
+            unwatch(child);
+        }
+    }
+}
+
+void ProjectTreeWidgetPrivate::forget(QTreeWidgetItem *item)
+{
+    if (!item->data(0, FOLDER_ROLE).toBool()) {
+        return;
+    }
+
+    unwatch(item);
+    folderItems.remove(item->data(0, PATH_ROLE).toString());
+
+    for (int i = 0; i < item->childCount(); i++) {
+        forget(item->child(i));
+    }
+}
+
+void ProjectTreeWidgetPrivate::onDirectoryChanged(const QString &path)
+{
+    // The watcher stops watching a folder that was removed, in which case
+    // its parent's listing will remove it from the tree.
+    if (!QFileInfo::exists(path)) {
+        watchedFolders.remove(path);
+    }
+
+    if (folderItems.contains(path)) {
+        list(path);
+    }
+}
+
+void ProjectTreeWidgetPrivate::onItemSelected(QTreeWidgetItem *item)
+{
+    Q_Q(ProjectTreeWidget);
+
+    if ((nullptr != item) && !item->data(0, FOLDER_ROLE).toBool()) {
+        emit q->fileSelected(item->data(0, PATH_ROLE).toString());
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,77 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PROJECT_TREE_WIDGET_H
+#define PROJECT_TREE_WIDGET_H
+
+#include <QScopedPointer>
+#include <QString>
+#include <QTreeWidget>
+
+namespace ghostwriter
+{
+/**
+ * Sidebar widget showing the folders and Markdown files of the document's
+ * folder as a tree.  Each folder is listed on a worker thread the first
+ * time it is expanded, and its entries are added to the tree in batches so
+ * that huge folders do not block the user interface.  Only the expanded
+ * folders are watched for changes, which are listed again when they change.
+ */
+class ProjectTreeWidgetPrivate;
+class ProjectTreeWidget : public QTreeWidget
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(ProjectTreeWidget)
+
+public:
+    /**
+     * Constructor.
+     */
+    ProjectTreeWidget(QWidget *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~ProjectTreeWidget();
+
+    /**
+     * Gets the folder at the root of the tree.
+     */
+    QString folder() const;
+
+    /**
+     * Sets the folder at the root of the tree.  Pass an empty path if there
+     * is no folder to show, such as when the document has not been saved
+     * yet.
+     */
+    void setFolder(const QString &path);
+
+signals:
+    /**
+     * Emitted when the user selects a file in the tree, with the path of
+     * the file.
+     */
+    void fileSelected(const QString &filePath);
+
+private:
+    QScopedPointer<ProjectTreeWidgetPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // PROJECT_TREE_WIDGET_H
@@ -0,0 +1,454 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFutureWatcher>
+#include <QSet>
+#include <QTextBlock>
+#include <QTextCursor>
+
+#include "markdownast.h"
+#include "markdowndocument.h"
+#include "markdownnode.h"
+#include "readabilityanalyzer.h"
+#include "taskscheduler.h"
+#include "textblockdata.h"
+#include "texttokenizer.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+class ReadabilityAnalyzerPrivate
+{
+    Q_DECLARE_PUBLIC(ReadabilityAnalyzer)
+
+public:
+    // Line to score, gathered on the GUI thread so that it can be scored on
+    // another thread.
+    struct ScoredLine
+    {
+        QTextBlock block;
+        QString text;
+
+        // Whether the line is within a paragraph.  Other lines have no
+        // sentences to score.
+        bool paragraph;
+
+        // Difficult sentences found in the line.
+        QVector<ReadabilityAnalyzer::Sentence> sentences;
+    };
+
+    ReadabilityAnalyzerPrivate(ReadabilityAnalyzer *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~ReadabilityAnalyzerPrivate()
+    {
+        ;
+    }
+
+    ReadabilityAnalyzer *q_ptr;
+    MarkdownDocument *document;
+    bool enabled;
+
+    // Range of the document left to score, tracked with cursors so that it
+    // moves with edits, or null cursors if there is none.
+    QTextCursor pendingStart;
+    QTextCursor pendingEnd;
+
+    QFutureWatcher<QVector<ScoredLine>> *watcher;
+    bool analysisInProgress;
+
+    // Revision of the document at its last change.
+    int changeRevision;
+
+    // Blocks that have difficult sentences.
+    QSet<TextBlockData *> flaggedBlocks;
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onMarkdownASTChanged();
+    void markPending(int firstLine, int lastLine);
+    void startAnalysis();
+    void onAnalysisFinished();
+    void clearSentences();
+    static void scoreLine(ScoredLine &line);
+};
+
+bool ReadabilityAnalyzer::Sentence::operator==(const Sentence &other) const
+{
+    return (position == other.position)
+        && (length == other.length)
+        && (difficulty == other.difficulty);
+}
+
+bool ReadabilityAnalyzer::Sentence::operator!=(const Sentence &other) const
+{
+    return !(*this == other);
+}
+
+ReadabilityAnalyzer::ReadabilityAnalyzer(MarkdownDocument *document, QObject *parent)
+    : QObject(parent),
+      d_ptr(new ReadabilityAnalyzerPrivate(this))
+{
+    Q_D(ReadabilityAnalyzer);
+
+    d->document = document;
+    d->enabled = false;
+    d->analysisInProgress = false;
+    d->changeRevision = document->revision();
+    d->watcher = new QFutureWatcher<QVector<ReadabilityAnalyzerPrivate::ScoredLine>>(this);
+
+    this->connect
+    (
+        d->watcher,
+        &QFutureWatcher<QVector<ReadabilityAnalyzerPrivate::ScoredLine>>::finished,
+        [d]() {
+            d->onAnalysisFinished();
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &QTextDocument::contentsChange,
+        this,
+        [d](int position, int charsRemoved, int charsAdded) {
+            d->onContentsChange(position, charsRemoved, charsAdded);
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::markdownASTChanged,
+        this,
+        [d]() {
+            d->onMarkdownASTChanged();
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::textBlockDataRemoved,
+        this,
+        [d](TextBlockData *blockData) {
+            d->flaggedBlocks.remove(blockData);
+        }
+    );
+}
+
+ReadabilityAnalyzer::~ReadabilityAnalyzer()
+{
+    Q_D(ReadabilityAnalyzer);
+
+    d->watcher->waitForFinished();
+}
+
+bool ReadabilityAnalyzer::isEnabled() const
+{
+    Q_D(const ReadabilityAnalyzer);
+
+    return d->enabled;
+}
+
+void ReadabilityAnalyzer::setEnabled(bool enabled)
+{
+    Q_D(ReadabilityAnalyzer);
+
+    if (enabled == d->enabled) {
+        return;
+    }
+
+    d->enabled = enabled;
+
+    if (enabled) {
+        d->markPending(1, d->document->blockCount());
+        d->startAnalysis();
+    } else {
+        d->pendingStart = QTextCursor();
+        d->pendingEnd = QTextCursor();
+        d->clearSentences();
+    }
+}
+
+void ReadabilityAnalyzerPrivate::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // Highlighting also signals a change to the contents, without changing
+    // the text.  See MarkdownDocument::onContentsChange().
+    if
+    (
+        !enabled
+        || ((charsRemoved == charsAdded)
+            && (charsAdded > 0)
+            && (document->revision() == changeRevision))
+    ) {
+        return;
+    }
+
+    changeRevision = document->revision();
+
+    QTextBlock first = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+
+    markPending(first.blockNumber() + 1, last.blockNumber() + 1);
+}
+
+void ReadabilityAnalyzerPrivate::onMarkdownASTChanged()
+{
+    if (!enabled) {
+        return;
+    }
+
+    // Lines that became or stopped being paragraphs are scored again too.
+    for (const MarkdownAST::LineRange &range : document->markdownASTChanges()) {
+        markPending(range.first, range.second);
+    }
+
+    startAnalysis();
+}
+
+// Adds the given range of lines to the range left to score.
+//
+void ReadabilityAnalyzerPrivate::markPending(int firstLine, int lastLine)
+{
+    QTextBlock first = document->findBlockByNumber(firstLine - 1);
+    QTextBlock last = document->findBlockByNumber(lastLine - 1);
+
+    if (!first.isValid()) {
+        first = document->firstBlock();
+    }
+
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+
+    if (pendingStart.isNull()) {
+        pendingStart = QTextCursor(document);
+        pendingEnd = QTextCursor(document);
+        pendingStart.setPosition(first.position());
+        pendingEnd.setPosition(last.position());
+        return;
+    }
+
+    pendingStart.setPosition(qMin(pendingStart.position(), first.position()));
+    pendingEnd.setPosition(qMax(pendingEnd.position(), last.position()));
+}
+
+// Gathers the lines left to score, and scores their sentences in the
+// background.  If an analysis is already under way, the lines are scored
+// once it finishes.
+//
+void ReadabilityAnalyzerPrivate::startAnalysis()
+{
+    const MarkdownAST *ast = document->markdownAST();
+
+    if
+    (
+        analysisInProgress
+        || pendingStart.isNull()
+        || (nullptr == ast)
+        || (nullptr == ast->root())
+    ) {
+        return;
+    }
+
+    GW_TRACE_SCOPE("ReadabilityAnalyzer::startAnalysis");
+
+    QTextBlock block = pendingStart.block();
+    QTextBlock last = pendingEnd.block();
+    pendingStart = QTextCursor();
+    pendingEnd = QTextCursor();
+
+    QVector<ScoredLine> lines;
+
+    while (block.isValid()) {
+        const MarkdownNode *node = ast->findBlockAtLine(block.blockNumber() + 1);
+
+        ScoredLine line;
+        line.block = block;
+        line.text = block.text();
+        line.paragraph = (nullptr != node)
+            && !node->isInvalid()
+            && (MarkdownNode::Paragraph == node->type());
+        lines.append(line);
+
+        if (block == last) {
+            break;
+        }
+
+        block = block.next();
+    }
+
+    if (lines.isEmpty()) {
+        return;
+    }
+
+    analysisInProgress = true;
+
+    QFuture<QVector<ScoredLine>> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::Statistics,
+            [lines]() {
+                GW_TRACE_SCOPE("ReadabilityAnalyzer::scoreLines");
+                QVector<ScoredLine> results = lines;
+
+                for (ScoredLine &line : results) {
+                    scoreLine(line);
+                }
+
+                return results;
+            }
+        );
+    watcher->setFuture(future);
+}
+
+// Stores the difficult sentences found for the scored lines in their
+// blocks.  Lines that were edited in the meantime are skipped, as they are
+// scored again.
+//
+void ReadabilityAnalyzerPrivate::onAnalysisFinished()
+{
+    Q_Q(ReadabilityAnalyzer);
+
+    analysisInProgress = false;
+
+    if (!enabled) {
+        return;
+    }
+
+    QVector<ScoredLine> results = watcher->result();
+    int firstChanged = -1;
+    int lastChanged = -1;
+
+    for (const ScoredLine &line : results) {
+        if
+        (
+            !line.block.isValid()
+            || (line.block.document() != document)
+            || (line.block.text() != line.text)
+        ) {
+            continue;
+        }
+
+        TextBlockData *blockData = (TextBlockData *) line.block.userData();
+
+        if (nullptr == blockData) {
+            if (line.sentences.isEmpty()) {
+                continue;
+            }
+
+            blockData = new TextBlockData(document, line.block);
+            line.block.setUserData(blockData);
+        }
+
+        if (blockData->difficultSentences == line.sentences) {
+            continue;
+        }
+
+        // The sentences are tinted by the highlighter along with its own
+        // formats, which are therefore no longer current.
+        blockData->difficultSentences = line.sentences;
+        blockData->highlightApplied = false;
+
+        if (line.sentences.isEmpty()) {
+            flaggedBlocks.remove(blockData);
+        } else {
+            flaggedBlocks.insert(blockData);
+        }
+
+        int lineNumber = line.block.blockNumber() + 1;
+
+        if ((firstChanged < 0) || (lineNumber < firstChanged)) {
+            firstChanged = lineNumber;
+        }
+
+        lastChanged = qMax(lastChanged, lineNumber);
+    }
+
+    if (firstChanged > 0) {
+        emit q->difficultSentencesChanged(firstChanged, lastChanged);
+    }
+
+    startAnalysis();
+}
+
+void ReadabilityAnalyzerPrivate::clearSentences()
+{
+    Q_Q(ReadabilityAnalyzer);
+
+    int firstChanged = -1;
+    int lastChanged = -1;
+
+    for (TextBlockData *blockData : flaggedBlocks) {
+        int lineNumber = blockData->blockRef.blockNumber() + 1;
+
+        blockData->difficultSentences.clear();
+        blockData->highlightApplied = false;
+
+        if ((firstChanged < 0) || (lineNumber < firstChanged)) {
+            firstChanged = lineNumber;
+        }
+
+        lastChanged = qMax(lastChanged, lineNumber);
+    }
+
+    flaggedBlocks.clear();
+
+    if (firstChanged > 0) {
+        emit q->difficultSentencesChanged(firstChanged, lastChanged);
+    }
+}
+
+// Finds the sentences of the given line whose LIX score makes them hard to
+// read.
+//
+void ReadabilityAnalyzerPrivate::scoreLine(ScoredLine &line)
+{
+    if (!line.paragraph) {
+        return;
+    }
+
+    for (const TextTokenizer::Sentence &sentence : TextTokenizer::sentences(line.text)) {
+        if (sentence.words < ReadabilityAnalyzer::MinimumWords) {
+            continue;
+        }
+
+        int score = sentence.words + ((100 * sentence.longWords) / sentence.words);
+
+        if (score < ReadabilityAnalyzer::HardScore) {
+            continue;
+        }
+
+        ReadabilityAnalyzer::Sentence difficult;
+        difficult.position = sentence.position;
+        difficult.length = sentence.length;
+        difficult.difficulty = (score >= ReadabilityAnalyzer::VeryHardScore)
+            ? ReadabilityAnalyzer::VeryHard
+            : ReadabilityAnalyzer::Hard;
+        line.sentences.append(difficult);
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,118 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef READABILITYANALYZER_H
+#define READABILITYANALYZER_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QVector>
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+
+/**
+ * Finds the sentences of a MarkdownDocument's paragraphs that are hard to
+ * read, so that they can be tinted in place.  Each sentence is scored with
+ * the LIX formula that DocumentStatistics uses for the whole document, i.e.,
+ * its number of words plus its percentage of long words.
+ *
+ * Only the lines edited or whose structure changed since the last AST are
+ * scored again, in the background, and the difficult sentences found are
+ * stored in the blocks' TextBlockData for the MarkdownHighlighter to tint.
+ */
+class ReadabilityAnalyzerPrivate;
+class ReadabilityAnalyzer : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(ReadabilityAnalyzer)
+
+public:
+    /**
+     * How hard a sentence is to read.
+     */
+    typedef enum {
+        Hard,
+        VeryHard
+    } Difficulty;
+
+    /**
+     * Sentence of a line that is hard to read.
+     */
+    struct Sentence
+    {
+        // Range of characters of the line spanned by the sentence.
+        int position;
+        int length;
+
+        Difficulty difficulty;
+
+        bool operator==(const Sentence &other) const;
+        bool operator!=(const Sentence &other) const;
+    };
+
+    /**
+     * Sentences scoring at least these LIX values are hard and very hard
+     * to read, respectively.
+     */
+    static const int HardScore = 50;
+    static const int VeryHardScore = 60;
+
+    /**
+     * Sentences with fewer words than this are never considered hard to
+     * read, as a few long words would otherwise dominate their score.
+     */
+    static const int MinimumWords = 10;
+
+    /**
+     * Constructor.  Pass in the document to analyze.
+     */
+    ReadabilityAnalyzer(MarkdownDocument *document, QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~ReadabilityAnalyzer();
+
+    /**
+     * Returns whether the document is being analyzed.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Sets whether to analyze the document.  Enabling analyzes the whole
+     * document once its AST is available, and disabling clears all
+     * difficult sentences.
+     */
+    void setEnabled(bool enabled);
+
+signals:
+    /**
+     * Emitted when the difficult sentences of the given range of lines
+     * (inclusive) change.
+     */
+    void difficultSentencesChanged(int firstLine, int lastLine);
+
+private:
+    QScopedPointer<ReadabilityAnalyzerPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // READABILITYANALYZER_H
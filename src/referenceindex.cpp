@@ -0,0 +1,408 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QRegularExpression>
+
+#include "markdowndocument.h"
+#include "referenceindex.h"
+#include "textblockdata.h"
+
+namespace ghostwriter
+{
+//
+// Returns the position of the unescaped ']' closing the '[' at the given
+// position, or -1 if there is none before the next unescaped '['.
+//
+static int closingBracket(const QString &line, int open)
+{
+    for (int i = open + 1; i < line.length(); i++) {
+        switch (line[i].unicode()) {
+        case '\\':
+            i++;
+            break;
+        case '[':
+            return -1;
+        case ']':
+            return (i > (open + 1)) ? i : -1;
+        default:
+            break;
+        }
+    }
+
+    return -1;
+}
+
+//
+// Returns the position following the code span whose opening backticks
+// start at the given position, or the position following the backticks
+// if the span is not closed.
+//
+static int skipCodeSpan(const QString &line, int pos)
+{
+    int start = pos;
+
+    while ((pos < line.length()) && ('`' == line[pos])) {
+        pos++;
+    }
+
+    QString fence = line.mid(start, pos - start);
+    int end = line.indexOf(fence, pos);
+
+    return (end < 0) ? pos : (end + fence.length());
+}
+
+ReferenceIndex::ReferenceIndex(MarkdownDocument *document)
+    : QObject(document), document(document), indexedRevision(-1), removals(0)
+{
+    this->connect
+    (
+        document,
+        &QTextDocument::contentsChange,
+        [this](int position, int charsRemoved, int charsAdded) {
+            this->onContentsChange(position, charsRemoved, charsAdded);
+        }
+    );
+
+    onContentsChange(0, 0, document->characterCount());
+}
+
+ReferenceIndex::~ReferenceIndex()
+{
+    ;
+}
+
+bool ReferenceIndex::isDefined(const QString &label) const
+{
+    return definitions.contains(label);
+}
+
+QVector<QTextBlock> ReferenceIndex::referringBlocks(const QString &label) const
+{
+    QVector<QTextBlock> blocks;
+
+    for (const TextBlockData *blockData : references.value(label)) {
+        blocks.append(blockData->blockRef);
+    }
+
+    return blocks;
+}
+
+QVector<QPair<QString, QTextBlock>> ReferenceIndex::brokenReferences() const
+{
+    QVector<QPair<QString, QTextBlock>> broken;
+
+    for (auto iter = references.constBegin(); iter != references.constEnd(); ++iter) {
+        if (definitions.contains(iter.key())) {
+            continue;
+        }
+
+        // Only the few blocks referring to undefined labels are parsed
+        // again, to tell literal text in brackets from broken references.
+        for (const TextBlockData *blockData : iter.value()) {
+            for (const Reference &ref : parseReferences(blockData->blockRef.text())) {
+                if (ref.explicitReference && (ref.label == iter.key())) {
+                    broken.append(qMakePair(iter.key(), blockData->blockRef));
+                    break;
+                }
+            }
+        }
+    }
+
+    return broken;
+}
+
+int ReferenceIndex::removalCount() const
+{
+    return removals;
+}
+
+void ReferenceIndex::removeBlock(TextBlockData *blockData)
+{
+    // Forget the references first, while the labels that the block
+    // defines are still defined.
+    removeReferences(blockData->referencedLabels, blockData);
+
+    if (!blockData->referenceDefinition.isNull()) {
+        removeDefinition(blockData->referenceDefinition, blockData, removedLabels);
+    }
+}
+
+QString ReferenceIndex::normalizeLabel(const QString &label)
+{
+    return label.simplified().toCaseFolded();
+}
+
+QString ReferenceIndex::parseDefinition(const QString &line)
+{
+    static const QRegularExpression definitionRegex
+    (
+        "^ {0,3}\\[((?:[^\\[\\]\\\\]|\\\\.)+)\\]:"
+    );
+
+    if (!line.contains('[')) {
+        return QString();
+    }
+
+    QRegularExpressionMatch match = definitionRegex.match(line);
+
+    if (!match.hasMatch()) {
+        return QString();
+    }
+
+    QString label = normalizeLabel(match.captured(1));
+
+    return label.isEmpty() ? QString() : label;
+}
+
+QVector<ReferenceIndex::Reference> ReferenceIndex::parseReferences(const QString &line)
+{
+    QVector<Reference> refs;
+    int i = 0;
+
+    while (i < line.length()) {
+        QChar c = line[i];
+
+        if ('\\' == c) {
+            i += 2;
+            continue;
+        }
+
+        if ('`' == c) {
+            i = skipCodeSpan(line, i);
+            continue;
+        }
+
+        if ('[' != c) {
+            i++;
+            continue;
+        }
+
+        int end = closingBracket(line, i);
+
+        if (end < 0) {
+            i++;
+            continue;
+        }
+
+        QString inner = line.mid(i + 1, end - i - 1);
+        QChar next = ((end + 1) < line.length()) ? line[end + 1] : QChar();
+        Reference ref;
+        ref.position = i;
+        ref.length = end - i + 1;
+        ref.explicitReference = false;
+
+        if (inner.startsWith('^') && (inner.length() > 1)) {
+            // Footnote reference, or the definition of a footnote.
+            ref.explicitReference = true;
+        } else if (('(' == next) || (':' == next)) {
+            // Inline link, or the definition of a link.
+            i = end + 1;
+            continue;
+        } else if ('[' == next) {
+            int labelEnd = closingBracket(line, end + 1);
+
+            if (labelEnd >= 0) {
+                QString label = line.mid(end + 2, labelEnd - end - 2);
+
+                if (!label.trimmed().isEmpty()) {
+                    inner = label;
+                }
+
+                ref.length = labelEnd - i + 1;
+                ref.explicitReference = true;
+            } else if (((end + 2) < line.length()) && (']' == line[end + 2])) {
+                // Collapsed reference.
+                ref.length = end - i + 3;
+                ref.explicitReference = true;
+            }
+        }
+
+        ref.label = normalizeLabel(inner);
+        i = ref.position + ref.length;
+
+        // Leave out the definition itself, as well as task list check
+        // boxes and such.
+        if
+        (
+            ref.label.isEmpty()
+            || ((ref.position + ref.length < line.length())
+                && (':' == line[ref.position + ref.length]))
+        ) {
+            continue;
+        }
+
+        refs.append(ref);
+    }
+
+    return refs;
+}
+
+void ReferenceIndex::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // Labels left undefined by the blocks removed during the edit.
+    QStringList changedLabels = removedLabels;
+    removedLabels.clear();
+
+    // Highlighting also signals a change to the contents, without changing
+    // the text.  See MarkdownDocument::onContentsChange().
+    if
+    (
+        (charsRemoved == charsAdded)
+        && (charsAdded > 0)
+        && (document->revision() == indexedRevision)
+    ) {
+        if (!changedLabels.isEmpty()) {
+            emit definitionsChanged(changedLabels);
+        }
+
+        return;
+    }
+
+    indexedRevision = document->revision();
+
+    QTextBlock block = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+
+    while (block.isValid()) {
+        indexBlock(block, changedLabels);
+
+        if (block == last) {
+            break;
+        }
+
+        block = block.next();
+    }
+
+    if (!changedLabels.isEmpty()) {
+        changedLabels.removeDuplicates();
+        emit definitionsChanged(changedLabels);
+    }
+}
+
+void ReferenceIndex::indexBlock(QTextBlock &block, QStringList &changedLabels)
+{
+    TextBlockData *blockData = (TextBlockData *) block.userData();
+    QString text = block.text();
+    QString definition;
+    QStringList labels;
+
+    if (text.contains('[')) {
+        definition = parseDefinition(text);
+
+        for (const Reference &ref : parseReferences(text)) {
+            if (!labels.contains(ref.label)) {
+                labels.append(ref.label);
+            }
+        }
+    }
+
+    if (nullptr == blockData) {
+        if (definition.isNull() && labels.isEmpty()) {
+            return;
+        }
+
+        blockData = new TextBlockData(document, block);
+        block.setUserData(blockData);
+    }
+
+    if (blockData->referenceDefinition != definition) {
+        if (!blockData->referenceDefinition.isNull()) {
+            removeDefinition(blockData->referenceDefinition, blockData, changedLabels);
+        }
+
+        if (!definition.isNull()) {
+            QSet<TextBlockData *> &blocks = definitions[definition];
+
+            if (blocks.isEmpty()) {
+                changedLabels.append(definition);
+            }
+
+            blocks.insert(blockData);
+        }
+
+        blockData->referenceDefinition = definition;
+    }
+
+    if (blockData->referencedLabels != labels) {
+        QStringList removedReferences;
+
+        for (const QString &label : blockData->referencedLabels) {
+            if (!labels.contains(label)) {
+                removedReferences.append(label);
+            }
+        }
+
+        removeReferences(removedReferences, blockData);
+
+        for (const QString &label : labels) {
+            references[label].insert(blockData);
+        }
+
+        blockData->referencedLabels = labels;
+    }
+}
+
+void ReferenceIndex::removeReferences(const QStringList &labels, TextBlockData *blockData)
+{
+    for (const QString &label : labels) {
+        QHash<QString, QSet<TextBlockData *>>::iterator iter = references.find(label);
+
+        if (references.end() == iter) {
+            continue;
+        }
+
+        // Footnotes are numbered in the order they are referred to, and
+        // left out unless referred to.  Links are not affected.
+        if (iter.value().remove(blockData) && label.startsWith('^') && definitions.contains(label)) {
+            removals++;
+        }
+
+        if (iter.value().isEmpty()) {
+            references.erase(iter);
+        }
+    }
+}
+
+void ReferenceIndex::removeDefinition
+(
+    const QString &label,
+    TextBlockData *blockData,
+    QStringList &changedLabels
+)
+{
+    QHash<QString, QSet<TextBlockData *>>::iterator iter = definitions.find(label);
+
+    if (definitions.end() == iter) {
+        return;
+    }
+
+    if (iter.value().remove(blockData)) {
+        removals++;
+    }
+
+    if (iter.value().isEmpty()) {
+        definitions.erase(iter);
+        changedLabels.append(label);
+    }
+}
+} // namespace ghostwriter
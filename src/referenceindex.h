@@ -0,0 +1,204 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef REFERENCEINDEX_H
+#define REFERENCEINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTextBlock>
+#include <QVector>
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+class TextBlockData;
+
+/**
+ * Index of the reference link and footnote definitions of a document,
+ * and of the blocks that refer to them.  The index is kept up to date as
+ * the document changes by rescanning only the blocks that were edited,
+ * so that whether a reference resolves can be looked up without searching
+ * the document.
+ *
+ * Labels are normalized as per the CommonMark specification, i.e., case
+ * folded with their whitespace collapsed.  Footnote labels keep their
+ * leading caret, so that [^1] and [1] are distinct.
+ *
+ * Note that blocks are scanned line by line, without regard to the AST,
+ * so definitions spanning several lines and brackets within code spans
+ * are taken at face value.
+ */
+class ReferenceIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * A reference to a label found in a line of text.
+     */
+    struct Reference
+    {
+        /**
+         * Position and length of the reference within the line, including
+         * its brackets.
+         */
+        int position;
+        int length;
+
+        /**
+         * Normalized label that the reference refers to.
+         */
+        QString label;
+
+        /**
+         * Whether the reference can only be a reference, as is the case
+         * for full ([text][label]) and collapsed ([label][]) references
+         * and for footnote references, rather than literal text in
+         * brackets, as a shortcut reference ([label]) may be.
+         */
+        bool explicitReference;
+    };
+
+    /**
+     * Constructor.  Indexes the given document's text, and then keeps
+     * the index up to date as the document changes.
+     */
+    explicit ReferenceIndex(MarkdownDocument *document);
+
+    /**
+     * Destructor.
+     */
+    virtual ~ReferenceIndex();
+
+    /**
+     * Returns whether the given normalized label is defined anywhere in
+     * the document.
+     */
+    bool isDefined(const QString &label) const;
+
+    /**
+     * Returns the blocks that refer to the given normalized label.
+     */
+    QVector<QTextBlock> referringBlocks(const QString &label) const;
+
+    /**
+     * Returns the labels of explicit references that are not defined in
+     * the document, paired with the blocks that refer to them, in no
+     * particular order.
+     */
+    QVector<QPair<QString, QTextBlock>> brokenReferences() const;
+
+    /**
+     * Returns how many times a block stopped defining a label, or stopped
+     * referring to a defined footnote, since the index was created, such as
+     * when a definition or a footnote reference was deleted or its label
+     * edited.  A change in this count between two edits tells that the
+     * edits removed something that other blocks of the document depend upon
+     * when parsed, even if the label is still defined or referred to
+     * elsewhere.  Removing a definition turns the references to it back
+     * into text, and removing a footnote reference renumbers the footnotes.
+     */
+    int removalCount() const;
+
+    /**
+     * Forgets the definitions and references of the block with the given
+     * data, which is being destroyed.  For internal use only with the
+     * MarkdownDocument class.
+     */
+    void removeBlock(TextBlockData *blockData);
+
+    /**
+     * Returns the given label normalized for matching against others.
+     */
+    static QString normalizeLabel(const QString &label);
+
+    /**
+     * Returns the normalized label defined by the given line, or a null
+     * string if the line does not start a definition.
+     */
+    static QString parseDefinition(const QString &line);
+
+    /**
+     * Returns the references found in the given line, in order.  Inline
+     * links and images ([text](url)) and the line's own definition, if
+     * any, are not references.
+     */
+    static QVector<Reference> parseReferences(const QString &line);
+
+signals:
+    /**
+     * Emitted when labels become defined or undefined, so that the blocks
+     * referring to them can be rehighlighted.
+     */
+    void definitionsChanged(const QStringList &labels);
+
+private:
+    MarkdownDocument *document;
+
+    // Blocks defining and blocks referring to each label.
+    QHash<QString, QSet<TextBlockData *>> definitions;
+    QHash<QString, QSet<TextBlockData *>> references;
+
+    // Revision of the document when last indexed.
+    int indexedRevision;
+
+    // See removalCount().
+    int removals;
+
+    // Labels that became undefined as blocks were removed by the edit in
+    // progress, reported together once the edit is done.
+    QStringList removedLabels;
+
+    /*
+    * Rescans the blocks touched by the given change to the document.
+    */
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+    /*
+    * Rescans the given block, adding the labels whose definition status
+    * changed to the given list.
+    */
+    void indexBlock(QTextBlock &block, QStringList &changedLabels);
+
+    /*
+    * Removes the given block data from the entries in the references of
+    * the given labels.
+    */
+    void removeReferences(const QStringList &labels, TextBlockData *blockData);
+
+    /*
+    * Removes the given block data from the given label's entry in the
+    * definitions, adding the label to the given list if it became
+    * undefined.
+    */
+    void removeDefinition
+    (
+        const QString &label,
+        TextBlockData *blockData,
+        QStringList &changedLabels
+    );
+};
+} // namespace ghostwriter
+
+#endif // REFERENCEINDEX_H
@@ -0,0 +1,191 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCache>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMimeDatabase>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QUrl>
+#include <QVector>
+#include <QtConcurrent>
+
+#include "resourceinliner.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+// Data URIs of the files last inlined, keyed by path, size and
+// modification time, with a cost in kilobytes.
+static QMutex dataUriMutex;
+static QCache<QString, QByteArray> dataUris(64 * 1024);
+
+QString ResourceInliner::inlineResources(const QString &html, const QString &baseDir)
+{
+    GW_TRACE_SCOPE("ResourceInliner::inlineResources");
+
+    static const QRegularExpression referenceRegex
+        (
+            "<(?:img\\b[^>]*?\\bsrc|link\\b[^>]*?\\bhref)\\s*=\\s*([\"'])(.*?)\\1",
+            QRegularExpression::CaseInsensitiveOption
+            | QRegularExpression::DotMatchesEverythingOption
+        );
+
+    struct Reference
+    {
+        int start;
+        int length;
+        QString path;
+    };
+
+    struct Job
+    {
+        QString path;
+        QByteArray uri;
+    };
+
+    QVector<Reference> references;
+    QHash<QString, int> jobIndexes;
+    QVector<Job> jobs;
+
+    QRegularExpressionMatchIterator it = referenceRegex.globalMatch(html);
+
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        QString path = localPath(match.captured(2), baseDir);
+
+        if (path.isNull()) {
+            continue;
+        }
+
+        references.append({ match.capturedStart(2), match.capturedLength(2), path });
+
+        if (!jobIndexes.contains(path)) {
+            jobIndexes.insert(path, jobs.size());
+            jobs.append({ path, QByteArray() });
+        }
+    }
+
+    if (jobs.isEmpty()) {
+        return html;
+    }
+
+    // Each file is read and encoded once, however often it is referenced.
+    QtConcurrent::blockingMap
+    (
+        jobs,
+        [](Job &job) {
+            job.uri = dataUri(job.path);
+        }
+    );
+
+    QString result;
+    int last = 0;
+
+    result.reserve(html.length());
+
+    for (const Reference &reference : references) {
+        const QByteArray &uri = jobs[jobIndexes.value(reference.path)].uri;
+
+        if (uri.isEmpty()) {
+            continue;
+        }
+
+        result += html.midRef(last, reference.start - last);
+        result += QLatin1String(uri);
+        last = reference.start + reference.length;
+    }
+
+    result += html.midRef(last);
+    return result;
+}
+
+QString ResourceInliner::localPath(const QString &reference, const QString &baseDir)
+{
+    QString value = reference.trimmed();
+    value.replace("&amp;", "&");
+
+    if (value.isEmpty() || value.startsWith('#') || value.startsWith("//")) {
+        return QString();
+    }
+
+    QUrl url(value);
+
+    if (url.isLocalFile()) {
+        return url.toLocalFile();
+    }
+
+    if (!url.scheme().isEmpty() || !url.isRelative() || baseDir.isEmpty()) {
+        return QString();
+    }
+
+    QString path = url.path(QUrl::FullyDecoded);
+
+    if (path.isEmpty()) {
+        return QString();
+    }
+
+    return QDir::cleanPath(QDir(baseDir).absoluteFilePath(path));
+}
+
+QByteArray ResourceInliner::dataUri(const QString &filePath)
+{
+    QFileInfo info(filePath);
+
+    if (!info.isFile()) {
+        return QByteArray();
+    }
+
+    QString key = QString("%1\n%2\n%3")
+        .arg(info.absoluteFilePath())
+        .arg(info.size())
+        .arg(info.lastModified().toMSecsSinceEpoch());
+
+    {
+        QMutexLocker locker(&dataUriMutex);
+        QByteArray *cached = dataUris.object(key);
+
+        if (nullptr != cached) {
+            return *cached;
+        }
+    }
+
+    GW_TRACE_SCOPE("ResourceInliner::dataUri");
+
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    QByteArray uri = "data:"
+        + QMimeDatabase().mimeTypeForFile(info).name().toLatin1()
+        + ";base64,"
+        + file.readAll().toBase64();
+
+    QMutexLocker locker(&dataUriMutex);
+    dataUris.insert(key, new QByteArray(uri), (uri.size() / 1024) + 1);
+    return uri;
+}
+} // namespace ghostwriter
@@ -0,0 +1,66 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef RESOURCE_INLINER_H
+#define RESOURCE_INLINER_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace ghostwriter
+{
+/**
+ * Embeds the local files referenced by HTML into it as data URIs, so that
+ * the HTML can be distributed as a single file.  The files are encoded in
+ * parallel, and their encodings are cached by path, size and modification
+ * time, so that exporting the same images again does not read and encode
+ * them again.
+ *
+ * This class may be used from any thread.
+ */
+class ResourceInliner
+{
+public:
+    /**
+     * Returns the given HTML with the local files referenced by the src
+     * attributes of its images and the href attributes of its links, such
+     * as style sheets, replaced by data URIs.  Relative references are
+     * resolved against the given directory, and are left as they are if
+     * the directory is empty.  References to remote resources and to files
+     * that cannot be read are left as they are.
+     */
+    static QString inlineResources(const QString &html, const QString &baseDir);
+
+private:
+    /*
+    * Returns the local file path referenced by the given attribute value,
+    * or a null string if it does not reference a local file.
+    */
+    static QString localPath(const QString &reference, const QString &baseDir);
+
+    /*
+    * Returns the data URI of the file at the given path from the cache,
+    * reading and encoding the file if it is not cached or has changed.
+    * Returns an empty array if the file cannot be read.
+    */
+    static QByteArray dataUri(const QString &filePath);
+};
+} // namespace ghostwriter
+
+#endif // RESOURCE_INLINER_H
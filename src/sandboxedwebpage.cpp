@@ -29,6 +29,12 @@ SandboxedWebPage::SandboxedWebPage(QObject *parent)
 
 }
 
+SandboxedWebPage::SandboxedWebPage(QWebEngineProfile *profile, QObject *parent)
+    : QWebEnginePage(profile, parent)
+{
+
+}
+
 SandboxedWebPage::~SandboxedWebPage()
 {
     ;
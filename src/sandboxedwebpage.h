@@ -21,6 +21,7 @@
 #define SANDBOXEDWEBPAGE_H
 
 #include <QWebEnginePage>
+#include <QWebEngineProfile>
 
 namespace ghostwriter
 {
@@ -40,6 +41,16 @@ public:
         QObject *parent = 0
     );
 
+    /**
+     * Constructor.  Takes the web engine profile in which to load the
+     * page as parameter.
+     */
+    SandboxedWebPage
+    (
+        QWebEngineProfile *profile,
+        QObject *parent = 0
+    );
+
     /**
      * Destructor.
      */
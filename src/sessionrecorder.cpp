@@ -0,0 +1,129 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFile>
+#include <QKeyEvent>
+#include <QTextStream>
+#include <QUrl>
+#include <QWidget>
+
+#include "sessionrecorder.h"
+
+#define GW_RECORD_SESSION_ENV "GHOSTWRITER_RECORD_SESSION"
+
+namespace ghostwriter
+{
+const QString SessionRecorder::FILE_HEADER = "# ghostwriter session 1";
+
+class SessionRecorderPrivate
+{
+public:
+    SessionRecorderPrivate()
+    {
+        ;
+    }
+
+    ~SessionRecorderPrivate()
+    {
+        ;
+    }
+
+    QFile file;
+    QTextStream stream;
+    QElapsedTimer clock;
+};
+
+void SessionRecorder::recordIfRequested(QWidget *widget)
+{
+    QString filePath = QString::fromLocal8Bit(qgetenv(GW_RECORD_SESSION_ENV));
+
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    SessionRecorder *recorder = new SessionRecorder(widget, filePath);
+
+    if (!recorder->isRecording()) {
+        qWarning("Could not open %s to record the session.", qPrintable(filePath));
+        delete recorder;
+    }
+}
+
+SessionRecorder::SessionRecorder(QWidget *widget, const QString &filePath)
+    : QObject(widget), d_ptr(new SessionRecorderPrivate())
+{
+    Q_D(SessionRecorder);
+
+    d->file.setFileName(filePath);
+
+    if (!d->file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return;
+    }
+
+    d->stream.setDevice(&d->file);
+    d->stream << FILE_HEADER << "\n";
+    d->stream.flush();
+    d->clock.start();
+
+    widget->installEventFilter(this);
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    Q_D(SessionRecorder);
+
+    if (d->file.isOpen()) {
+        d->stream.flush();
+        d->file.close();
+    }
+}
+
+bool SessionRecorder::isRecording() const
+{
+    Q_D(const SessionRecorder);
+
+    return d->file.isOpen();
+}
+
+bool SessionRecorder::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_D(SessionRecorder);
+
+    if ((QEvent::KeyPress == event->type()) || (QEvent::KeyRelease == event->type())) {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+
+        d->stream
+            << d->clock.elapsed() << "\t"
+            << ((QEvent::KeyPress == event->type()) ? "P" : "R") << "\t"
+            << keyEvent->key() << "\t"
+            << (int) keyEvent->modifiers() << "\t"
+            << (keyEvent->isAutoRepeat() ? 1 : 0) << "\t"
+            << QString::fromLatin1(QUrl::toPercentEncoding(keyEvent->text()))
+            << "\n";
+
+        // Keystrokes are few enough that each can be written right away,
+        // so that a session ending in a crash is still recorded.
+        d->stream.flush();
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+} // namespace ghostwriter
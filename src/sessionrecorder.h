@@ -0,0 +1,86 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef SESSION_RECORDER_H
+#define SESSION_RECORDER_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+class QWidget;
+
+namespace ghostwriter
+{
+/**
+ * Records the key events typed into a widget, with their timestamps, so
+ * that the writing session can later be replayed with SessionReplayer to
+ * measure typing latency.  Recording is requested with the
+ * GHOSTWRITER_RECORD_SESSION environment variable, which names the file
+ * to record to.
+ *
+ * After a header line, each line of the file holds one event:  the
+ * milliseconds since recording started, P or R for a key press or
+ * release, the key code, the keyboard modifiers, 1 if the event is an
+ * auto-repeat or 0 otherwise, and the percent-encoded text of the key,
+ * separated by tabs.
+ */
+class SessionRecorderPrivate;
+class SessionRecorder : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(SessionRecorder)
+
+public:
+    /**
+     * First line of a session file.
+     */
+    static const QString FILE_HEADER;
+
+    /**
+     * Starts recording the key events sent to the given widget if the
+     * environment requests it.  The recorder is owned by the widget.
+     */
+    static void recordIfRequested(QWidget *widget);
+
+    /**
+     * Constructor.  Records the key events sent to the given widget into
+     * the given file, which is overwritten.
+     */
+    SessionRecorder(QWidget *widget, const QString &filePath);
+
+    /**
+     * Destructor.
+     */
+    virtual ~SessionRecorder();
+
+    /**
+     * Returns true if the file could be opened for recording.
+     */
+    bool isRecording() const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event);
+
+private:
+    QScopedPointer<SessionRecorderPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // SESSION_RECORDER_H
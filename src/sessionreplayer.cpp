@@ -0,0 +1,303 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QKeyEvent>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+
+#include <algorithm>
+
+#include "documentmanager.h"
+#include "mainwindow.h"
+#include "markdowneditor.h"
+#include "sessionrecorder.h"
+#include "sessionreplayer.h"
+
+namespace ghostwriter
+{
+const QString SessionReplayer::REPLAY_OPTION = "replay-session";
+
+class SessionReplayerPrivate
+{
+public:
+    SessionReplayerPrivate()
+        : out(stdout), err(stderr)
+    {
+        ;
+    }
+
+    ~SessionReplayerPrivate()
+    {
+        ;
+    }
+
+    // Exit codes of the application.
+    enum {
+        ExitSuccess = 0,
+        ExitReplayFailed = 1,
+        ExitUsageError = 2
+    };
+
+    // Milliseconds given to the parse, highlighting, statistics and
+    // preview of the loaded document to finish before the replay starts.
+    static const int SettleTime = 2000;
+
+    // Recorded key event.
+    typedef struct {
+        qint64 time;
+        QEvent::Type type;
+        int key;
+        Qt::KeyboardModifiers modifiers;
+        bool autoRepeat;
+        QString text;
+    } Event;
+
+    QTextStream out;
+    QTextStream err;
+
+    /*
+    * Reads the events of the given session file.  Returns false if the
+    * file could not be read or is not a session file.
+    */
+    bool readSession(const QString &filePath, QVector<Event> &events);
+
+    /*
+    * Runs the event loop for the given number of milliseconds.
+    */
+    void runEventLoop(int msecs);
+
+    /*
+    * Returns the given percentile of the sorted latencies, in
+    * milliseconds.
+    */
+    double percentile(const QVector<qint64> &sorted, double fraction) const;
+};
+
+SessionReplayer::SessionReplayer()
+    : d_ptr(new SessionReplayerPrivate())
+{
+    ;
+}
+
+SessionReplayer::~SessionReplayer()
+{
+    ;
+}
+
+bool SessionReplayer::isRequested(const QStringList &arguments)
+{
+    foreach (const QString &argument, arguments) {
+        if (argument.startsWith(QString("--") + REPLAY_OPTION)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int SessionReplayer::exec(const QStringList &arguments)
+{
+    Q_D(SessionReplayer);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QObject::tr("Replays a recorded writing session and reports the typing latency."));
+    QCommandLineOption helpOption = parser.addHelpOption();
+
+    QCommandLineOption replayOption
+    (
+        REPLAY_OPTION,
+        QObject::tr("Session file recorded with GHOSTWRITER_RECORD_SESSION."),
+        QObject::tr("file")
+    );
+
+    parser.addOption(replayOption);
+    parser.addPositionalArgument
+    (
+        "file",
+        QObject::tr("Markdown file to replay the session into."),
+        "file"
+    );
+
+    if (!parser.parse(arguments)) {
+        d->err << parser.errorText() << "\n";
+        return SessionReplayerPrivate::ExitUsageError;
+    }
+
+    if (parser.isSet(helpOption)) {
+        parser.showHelp(SessionReplayerPrivate::ExitSuccess);
+    }
+
+    if (parser.positionalArguments().size() != 1) {
+        d->err << QObject::tr("Give exactly one Markdown file to replay the session into.") << "\n";
+        return SessionReplayerPrivate::ExitUsageError;
+    }
+
+    QVector<SessionReplayerPrivate::Event> events;
+
+    if (!d->readSession(parser.value(replayOption), events)) {
+        d->err << QObject::tr("Could not read session file %1.")
+            .arg(parser.value(replayOption)) << "\n";
+        return SessionReplayerPrivate::ExitUsageError;
+    }
+
+    QString documentPath = parser.positionalArguments().first();
+    QTemporaryDir tempDir;
+    QString copyPath = tempDir.filePath(QFileInfo(documentPath).fileName());
+
+    if (!tempDir.isValid() || !QFile::copy(documentPath, copyPath)) {
+        d->err << QObject::tr("Could not copy %1 to a temporary directory.")
+            .arg(documentPath) << "\n";
+        return SessionReplayerPrivate::ExitReplayFailed;
+    }
+
+    MainWindow window(copyPath);
+    window.show();
+
+    MarkdownEditor *editor = window.findChild<MarkdownEditor *>();
+    DocumentManager *documentManager = window.findChild<DocumentManager *>();
+
+    if ((nullptr == editor) || (nullptr == documentManager)) {
+        return SessionReplayerPrivate::ExitReplayFailed;
+    }
+
+    if (documentManager->isLoading()) {
+        QEventLoop loop;
+        QObject::connect(documentManager, &DocumentManager::documentLoaded, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    d->runEventLoop(SessionReplayerPrivate::SettleTime);
+    editor->setFocus();
+
+    QVector<qint64> latencies;
+    QElapsedTimer clock;
+    clock.start();
+
+    foreach (const SessionReplayerPrivate::Event &event, events) {
+        qint64 wait = event.time - clock.elapsed();
+
+        if (wait > 0) {
+            d->runEventLoop(wait);
+        }
+
+        QKeyEvent keyEvent
+        (
+            event.type,
+            event.key,
+            event.modifiers,
+            event.text,
+            event.autoRepeat
+        );
+
+        QElapsedTimer latency;
+        latency.start();
+
+        QApplication::sendEvent(editor, &keyEvent);
+        QApplication::processEvents();
+
+        if (QEvent::KeyPress == event.type) {
+            latencies.append(latency.nsecsElapsed());
+        }
+    }
+
+    qint64 replayTime = clock.elapsed();
+
+    // Keep the edits from being saved or prompted for as the window is
+    // destroyed.
+    editor->document()->setModified(false);
+
+    std::sort(latencies.begin(), latencies.end());
+
+    d->out << QObject::tr("Keystrokes: %1").arg(latencies.size()) << "\n";
+    d->out << QObject::tr("Recorded duration: %1 ms")
+        .arg(events.isEmpty() ? 0 : events.last().time) << "\n";
+    d->out << QObject::tr("Replay duration: %1 ms").arg(replayTime) << "\n";
+
+    if (!latencies.isEmpty()) {
+        d->out << QObject::tr("Latency (ms): p50 %1, p90 %2, p95 %3, p99 %4, max %5")
+            .arg(d->percentile(latencies, 0.50), 0, 'f', 2)
+            .arg(d->percentile(latencies, 0.90), 0, 'f', 2)
+            .arg(d->percentile(latencies, 0.95), 0, 'f', 2)
+            .arg(d->percentile(latencies, 0.99), 0, 'f', 2)
+            .arg(latencies.last() / 1.0e6, 0, 'f', 2) << "\n";
+    }
+
+    d->out.flush();
+    return SessionReplayerPrivate::ExitSuccess;
+}
+
+bool SessionReplayerPrivate::readSession(const QString &filePath, QVector<Event> &events)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream stream(&file);
+
+    if (stream.readLine() != SessionRecorder::FILE_HEADER) {
+        return false;
+    }
+
+    while (!stream.atEnd()) {
+        QStringList fields = stream.readLine().split('\t');
+
+        if (fields.size() != 6) {
+            continue;
+        }
+
+        Event event;
+        event.time = fields[0].toLongLong();
+        event.type = ("P" == fields[1]) ? QEvent::KeyPress : QEvent::KeyRelease;
+        event.key = fields[2].toInt();
+        event.modifiers = Qt::KeyboardModifiers(fields[3].toInt());
+        event.autoRepeat = ("1" == fields[4]);
+        event.text = QUrl::fromPercentEncoding(fields[5].toLatin1());
+
+        events.append(event);
+    }
+
+    return true;
+}
+
+void SessionReplayerPrivate::runEventLoop(int msecs)
+{
+    QEventLoop loop;
+    QTimer::singleShot(msecs, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+double SessionReplayerPrivate::percentile(const QVector<qint64> &sorted, double fraction) const
+{
+    int index = qMin(sorted.size() - 1, (int) (fraction * sorted.size()));
+
+    return sorted[index] / 1.0e6;
+}
+} // namespace ghostwriter
@@ -0,0 +1,78 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef SESSION_REPLAYER_H
+#define SESSION_REPLAYER_H
+
+#include <QScopedPointer>
+#include <QStringList>
+
+namespace ghostwriter
+{
+/**
+ * Replays a writing session recorded by SessionRecorder into the editor
+ * of a main window with a given document loaded, and prints the latency
+ * percentiles of the keystrokes.  A keystroke's latency runs from sending
+ * its key press to the editor until the work it posted to the event loop,
+ * including the repaint of the editor, has been processed.  Key events
+ * are sent at the times they were recorded, so that work deferred until
+ * typing pauses runs between keystrokes as it would for the writer.
+ *
+ * The document is copied to a temporary directory before it is opened,
+ * so that saving during the replay never touches the original.
+ */
+class SessionReplayerPrivate;
+class SessionReplayer
+{
+    Q_DECLARE_PRIVATE(SessionReplayer)
+
+public:
+    /**
+     * Name of the command line option that selects session replay.
+     */
+    static const QString REPLAY_OPTION;
+
+    /**
+     * Constructor.
+     */
+    SessionReplayer();
+
+    /**
+     * Destructor.
+     */
+    ~SessionReplayer();
+
+    /**
+     * Returns true if the given application arguments ask for a session
+     * replay rather than for the editor.
+     */
+    static bool isRequested(const QStringList &arguments);
+
+    /**
+     * Replays the session given by the application arguments, printing
+     * the latency report.  Returns the exit code for the application.
+     */
+    int exec(const QStringList &arguments);
+
+private:
+    QScopedPointer<SessionReplayerPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // SESSION_REPLAYER_H
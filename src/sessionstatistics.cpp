@@ -17,6 +17,8 @@
  *
  ***********************************************************************/
 
+#include <QFile>
+#include <QTextStream>
 #include <QTimer>
 
 #include "sessionstatistics.h"
@@ -26,9 +28,15 @@ namespace ghostwriter
 SessionStatistics::SessionStatistics(QObject *parent)
     : QObject(parent)
 {
-    sessionTimer = new QTimer(this);
-    connect(sessionTimer, SIGNAL(timeout()), this, SLOT(onSessionTimerExpired()));
-    sessionTimer->setInterval(1000);
+    minuteTimer = new QTimer(this);
+    minuteTimer->setSingleShot(true);
+
+    // Writing time is shown in whole minutes, so firing within a second
+    // of the minute is accurate enough, and lets the system batch wakeups.
+    minuteTimer->setTimerType(Qt::VeryCoarseTimer);
+    powerSaving = false;
+    connect(minuteTimer, SIGNAL(timeout()), this, SLOT(onMinuteElapsed()));
+    sampleBuffer.resize(MaxSamples);
     idle = true;
 
     startNewSession(0);
@@ -39,16 +47,64 @@ SessionStatistics::~SessionStatistics()
 
 }
 
+QVector<SessionStatistics::Sample> SessionStatistics::samples() const
+{
+    QVector<Sample> log;
+    log.reserve(sampleCount);
+
+    for (int i = 0; i < sampleCount; i++) {
+        log.append(sampleBuffer.at((firstSample + i) % MaxSamples));
+    }
+
+    return log;
+}
+
+bool SessionStatistics::exportCsv(const QString &filePath, QString &err) const
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        err = file.errorString();
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    stream << "time,elapsed_ms,words_delta,state\n";
+
+    for (const Sample &sample : samples()) {
+        stream << sessionStartTime.addMSecs(sample.timestamp).toString(Qt::ISODateWithMs)
+               << ',' << sample.timestamp
+               << ',' << sample.wordsDelta
+               << ',' << (sample.typing ? "typing" : "idle")
+               << '\n';
+    }
+
+    stream.flush();
+
+    if (QFile::NoError != file.error()) {
+        err = file.errorString();
+        return false;
+    }
+
+    file.close();
+    return true;
+}
+
 void SessionStatistics::startNewSession(int initialWordCount)
 {
     sessionWordCount = 0;
     totalWordsWritten = 0;
     lastWordCount = initialWordCount;
-    totalSeconds = 0;
-    idleSeconds = 0;
     idle = true;
-    sessionTimer->stop();
-    sessionTimer->start();
+    idleTime = 0;
+    lastTransitionTime = 0;
+    firstSample = 0;
+    sampleCount = 0;
+    sessionStartTime = QDateTime::currentDateTime();
+    sessionClock.start();
+    scheduleMinuteTimer();
 
     emit wordCountChanged(0);
     emit pageCountChanged(0);
@@ -61,6 +117,10 @@ void SessionStatistics::onDocumentWordCountChanged(int newWordCount)
 {
     int deltaWords = newWordCount - lastWordCount;
 
+    if (0 == deltaWords) {
+        return;
+    }
+
     if (deltaWords > 0) {
         totalWordsWritten += deltaWords;
     }
@@ -72,52 +132,130 @@ void SessionStatistics::onDocumentWordCountChanged(int newWordCount)
         sessionWordCount = 0;
     }
 
+    addSample(deltaWords);
+
     emit wordCountChanged(sessionWordCount);
     emit pageCountChanged(sessionWordCount / 250);
+    emit wordsPerMinuteChanged(calculateWPM());
 }
 
 void SessionStatistics::onTypingPaused()
 {
+    if (idle) {
+        return;
+    }
+
+    lastTransitionTime = sessionClock.elapsed();
     idle = true;
+    addSample(0);
+    updateTimeStatistics();
 }
 
 void SessionStatistics::onTypingResumed()
 {
+    if (!idle) {
+        return;
+    }
+
+    qint64 now = sessionClock.elapsed();
+
+    idleTime += now - lastTransitionTime;
+    lastTransitionTime = now;
     idle = false;
+    addSample(0);
+    updateTimeStatistics();
+}
+
+void SessionStatistics::setPowerSavingEnabled(bool enabled)
+{
+    if (enabled == powerSaving) {
+        return;
+    }
+
+    powerSaving = enabled;
+
+    if (enabled) {
+        minuteTimer->stop();
+    } else {
+        updateTimeStatistics();
+        scheduleMinuteTimer();
+    }
+}
+
+void SessionStatistics::onMinuteElapsed()
+{
+    updateTimeStatistics();
+    scheduleMinuteTimer();
 }
 
-void SessionStatistics::onSessionTimerExpired()
+// Appends a sample for the current time and typing state to the session
+// log, overwriting the oldest sample if the log is full.
+//
+void SessionStatistics::addSample(int wordsDelta)
 {
-    unsigned long elapsedTime = (unsigned long)(sessionTimer->interval() / 1000);
+    Sample sample;
+    sample.timestamp = sessionClock.elapsed();
+    sample.wordsDelta = wordsDelta;
+    sample.typing = !idle;
 
-    totalSeconds += elapsedTime;
+    if (sampleCount < MaxSamples) {
+        sampleBuffer[(firstSample + sampleCount) % MaxSamples] = sample;
+        sampleCount++;
+    } else {
+        sampleBuffer[firstSample] = sample;
+        firstSample = (firstSample + 1) % MaxSamples;
+    }
+}
+
+// Returns the idle time of the session so far, in milliseconds.
+//
+qint64 SessionStatistics::elapsedIdleTime() const
+{
+    qint64 elapsed = idleTime;
 
     if (idle) {
-        idleSeconds += elapsedTime;
+        elapsed += sessionClock.elapsed() - lastTransitionTime;
     }
 
-    int wpm = calculateWPM();
+    return elapsed;
+}
 
-    emit wordsPerMinuteChanged(wpm);
-    emit writingTimeChanged(totalSeconds / 60);
-    emit idleTimePercentageChanged((int)(((float)idleSeconds / (float)totalSeconds) * 100.0f));
+// Emits the statistics that change with time alone.
+//
+void SessionStatistics::updateTimeStatistics()
+{
+    qint64 totalTime = sessionClock.elapsed();
+    int idlePercentage = 100;
+
+    if (totalTime > 0) {
+        idlePercentage = (int)(((double)elapsedIdleTime() / (double)totalTime) * 100.0);
+    }
 
-    int timerTime = 1000;
+    emit wordsPerMinuteChanged(calculateWPM());
+    emit writingTimeChanged((unsigned long)(totalTime / 60000));
+    emit idleTimePercentageChanged(idlePercentage);
+}
 
-    if (wpm > 0) {
-        timerTime = 5000;
+// Starts the minute timer so that it fires when the next whole minute of
+// the session elapses.
+//
+void SessionStatistics::scheduleMinuteTimer()
+{
+    if (powerSaving) {
+        return;
     }
 
-    sessionTimer->stop();
-    sessionTimer->start(timerTime);
+    qint64 elapsed = sessionClock.elapsed();
+
+    minuteTimer->start((int)(60000 - (elapsed % 60000)));
 }
 
 int SessionStatistics::calculateWPM() const
 {
-    unsigned long delta = totalSeconds - idleSeconds;
+    qint64 typingTime = sessionClock.elapsed() - elapsedIdleTime();
 
-    if (delta > 0) {
-        return (int)(((float)totalWordsWritten * 60.0f) / (float)delta);
+    if (typingTime >= 1000) {
+        return (int)(((double)totalWordsWritten * 60000.0) / (double)typingTime);
     } else {
         return totalWordsWritten;
     }
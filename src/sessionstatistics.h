@@ -20,20 +20,49 @@
 #ifndef SESSIONSTATISTICS_H
 #define SESSIONSTATISTICS_H
 
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QObject>
+#include <QString>
+#include <QVector>
 
 class QTimer;
 
 namespace ghostwriter
 {
 /**
- * Class to compute session statistics.
+ * Class to compute session statistics.  Statistics are updated as the
+ * word count changes and as typing pauses or resumes, rather than by
+ * polling, and the most recent of these events are kept in a session log
+ * that can be exported.
  */
 class SessionStatistics : public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+     * Entry in the session log.
+     */
+    struct Sample
+    {
+        // Time since the session started, in milliseconds.
+        qint64 timestamp;
+
+        // Change in the document's word count.
+        int wordsDelta;
+
+        // Whether the user was typing (as opposed to idle) at the time.
+        bool typing;
+    };
+
+    /**
+     * Maximum number of samples kept in the session log.  Older samples
+     * are discarded once the log is full.  Statistics are kept for the
+     * entire session regardless.
+     */
+    static const int MaxSamples = 4096;
+
     /**
      * Constructor.
      */
@@ -44,6 +73,18 @@ public:
      */
     virtual ~SessionStatistics();
 
+    /**
+     * Gets the samples of the session log, oldest first.
+     */
+    QVector<Sample> samples() const;
+
+    /**
+     * Writes the session log to the given file as comma-separated values,
+     * one sample per line after a header line.  Returns true if successful,
+     * or else false with the reason given in err.
+     */
+    bool exportCsv(const QString &filePath, QString &err) const;
+
 signals:
     /**
      * Emitted when word count changes.
@@ -81,18 +122,45 @@ public slots:
     void onTypingPaused();
     void onTypingResumed();
 
+    /**
+     * Stops the timer that updates the time statistics while power saving
+     * is enabled, such as while the window is in the background.  The
+     * statistics are brought up to date once power saving is disabled.
+     */
+    void setPowerSavingEnabled(bool enabled);
+
 private slots:
-    void onSessionTimerExpired();
+    void onMinuteElapsed();
 
 private:
     int sessionWordCount;
     int totalWordsWritten;
     int lastWordCount;
-    QTimer *sessionTimer;
     bool idle;
-    unsigned long totalSeconds;
-    unsigned long idleSeconds;
 
+    // Session clock and wall clock time at which the session started.
+    QElapsedTimer sessionClock;
+    QDateTime sessionStartTime;
+
+    // Idle time accumulated before the last time typing resumed or paused,
+    // and when that was, in milliseconds of session time.
+    qint64 idleTime;
+    qint64 lastTransitionTime;
+
+    // Ring buffer of the session log.
+    QVector<Sample> sampleBuffer;
+    int firstSample;
+    int sampleCount;
+
+    // Single-shot timer that fires as each whole minute of the session
+    // elapses, since the writing time is displayed in minutes.
+    QTimer *minuteTimer;
+    bool powerSaving;
+
+    void addSample(int wordsDelta);
+    qint64 elapsedIdleTime() const;
+    void updateTimeStatistics();
+    void scheduleMinuteTimer();
     int calculateWPM() const;
 };
 } // namespace ghostwriter
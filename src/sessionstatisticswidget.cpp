@@ -25,6 +25,11 @@ class SessionStatisticsWidgetPrivate
 {
 public:
     SessionStatisticsWidgetPrivate()
+        : wordCount(0),
+          pageCount(0),
+          wordsPerMinute(0),
+          writingTime(0),
+          idleTime(100)
     {
         ;
     }
@@ -39,6 +44,14 @@ public:
     QLabel *wpmLabel;
     QLabel *writingTimeLabel;
     QLabel *idleTimePercentageLabel;
+
+    // Latest statistics set, which are displayed once the widget is shown
+    // if it was hidden.
+    int wordCount;
+    int pageCount;
+    int wordsPerMinute;
+    unsigned long writingTime;
+    int idleTime;
 };
 
 SessionStatisticsWidget::SessionStatisticsWidget(QWidget *parent) :
@@ -63,34 +76,65 @@ void SessionStatisticsWidget::setWordCount(int value)
 {
     Q_D(SessionStatisticsWidget);
 
-    setIntegerValueForLabel(d->wordCountLabel, value);
+    d->wordCount = value;
+
+    if (!deferDisplay()) {
+        setIntegerValueForLabel(d->wordCountLabel, value);
+    }
 }
 
 void SessionStatisticsWidget::setPageCount(int value)
 {
     Q_D(SessionStatisticsWidget);
 
-    setPageValueForLabel(d->pageCountLabel, value);
+    d->pageCount = value;
+
+    if (!deferDisplay()) {
+        setPageValueForLabel(d->pageCountLabel, value);
+    }
 }
 
 void SessionStatisticsWidget::setWordsPerMinute(int value)
 {
     Q_D(SessionStatisticsWidget);
 
-    setIntegerValueForLabel(d->wpmLabel, value);
+    d->wordsPerMinute = value;
+
+    if (!deferDisplay()) {
+        setIntegerValueForLabel(d->wpmLabel, value);
+    }
 }
 
 void SessionStatisticsWidget::setWritingTime(unsigned long minutes)
 {
     Q_D(SessionStatisticsWidget);
 
-    setTimeValueForLabel(d->writingTimeLabel, minutes);
+    d->writingTime = minutes;
+
+    if (!deferDisplay()) {
+        setTimeValueForLabel(d->writingTimeLabel, minutes);
+    }
 }
 
 void SessionStatisticsWidget::setIdleTime(int percentage)
 {
     Q_D(SessionStatisticsWidget);
 
-    setPercentageValueForLabel(d->idleTimePercentageLabel, percentage);
+    d->idleTime = percentage;
+
+    if (!deferDisplay()) {
+        setPercentageValueForLabel(d->idleTimePercentageLabel, percentage);
+    }
+}
+
+void SessionStatisticsWidget::displayStatistics()
+{
+    Q_D(SessionStatisticsWidget);
+
+    setIntegerValueForLabel(d->wordCountLabel, d->wordCount);
+    setPageValueForLabel(d->pageCountLabel, d->pageCount);
+    setIntegerValueForLabel(d->wpmLabel, d->wordsPerMinute);
+    setTimeValueForLabel(d->writingTimeLabel, d->writingTime);
+    setPercentageValueForLabel(d->idleTimePercentageLabel, d->idleTime);
 }
 } // namespace ghostwriter
@@ -72,6 +72,12 @@ public slots:
      */
     void setIdleTime(int percentage);
 
+protected:
+    /**
+     * Overridden to display the latest session statistics set.
+     */
+    void displayStatistics();
+
 private:
     QScopedPointer<SessionStatisticsWidgetPrivate> d_ptr;
 
@@ -23,10 +23,11 @@
 #include <QLabel>
 #include <QDialogButtonBox>
 #include <QComboBox>
-#include <QFontComboBox>
 #include <QFontInfo>
 #include <QCheckBox>
+#include <QSignalBlocker>
 
+#include "fontcatalogue.h"
 #include "simplefontdialog.h"
 
 namespace ghostwriter
@@ -46,10 +47,12 @@ public:
     }
 
     QFont font;
-    QFontComboBox *fontComboBox;
+    QComboBox *fontComboBox;
     QLineEdit *fontPreview;
     QCheckBox *monospaceOnlyCheckbox;
+    bool monospaceOnly;
 
+    void populateFamilies();
     void onFontFamilyChanged(const QFont &font);
     void onFontSizeChanged(int size);
 };
@@ -66,15 +69,18 @@ SimpleFontDialog::SimpleFontDialog(const QFont &initial, QWidget *parent)
 {
     Q_D(SimpleFontDialog);
 
-    d->fontComboBox = new QFontComboBox(this);
-    d->fontComboBox->setCurrentFont(initial);
+    // The families come from the font catalogue, which enumerates the font
+    // database only once per session, unlike QFontComboBox.
+    d->fontComboBox = new QComboBox(this);
     d->font = initial;
+    d->monospaceOnly = false;
+    d->populateFamilies();
 
     QVBoxLayout *familyLayout = new QVBoxLayout();
     familyLayout->addWidget(new QLabel(tr("Family")));
     familyLayout->addWidget(d->fontComboBox);
 
-    QList<int> sizes = QFontDatabase::standardSizes();
+    QList<int> sizes = FontCatalogue::instance()->standardSizes();
 
     QComboBox *sizeComboBox = new QComboBox(this);
     sizeComboBox->setEditable(true);
@@ -156,9 +162,11 @@ SimpleFontDialog::SimpleFontDialog(const QFont &initial, QWidget *parent)
     this->connect
     (
         d->fontComboBox,
-        &QFontComboBox::currentFontChanged,
-        [d](const QFont & newFont) {
-            d->onFontFamilyChanged(newFont);
+        &QComboBox::currentTextChanged,
+        [d](const QString &family) {
+            if (!family.isEmpty()) {
+                d->onFontFamilyChanged(QFont(family));
+            }
         }
     );
     this->connect
@@ -200,11 +208,9 @@ void SimpleFontDialog::setMonospaceOnly(bool enabled, bool hideCheckbox)
 
     d->monospaceOnlyCheckbox->setVisible(!hideCheckbox);
 
-    if (enabled) {
-        d->fontComboBox->setFontFilters(QFontComboBox::MonospacedFonts);
-    }
-    else {
-        d->fontComboBox->setFontFilters(QFontComboBox::AllFonts);
+    if (enabled != d->monospaceOnly) {
+        d->monospaceOnly = enabled;
+        d->populateFamilies();
     }
 }
 
@@ -212,7 +218,7 @@ bool SimpleFontDialog::monospaceOnly() const
 {
     Q_D(const SimpleFontDialog);
 
-    return d->fontComboBox->fontFilters().testFlag(QFontComboBox::MonospacedFonts);
+    return d->monospaceOnly;
 }
 
 QFont SimpleFontDialog::selectedFont() const
@@ -269,6 +275,30 @@ QFont SimpleFontDialog::monospaceFont(bool *ok, QWidget *parent)
     return monospaceFont(ok, QFont(), parent);
 }
 
+void SimpleFontDialogPrivate::populateFamilies()
+{
+    FontCatalogue *catalogue = FontCatalogue::instance();
+    QStringList families = monospaceOnly
+        ? catalogue->monospaceFamilies()
+        : catalogue->families();
+
+    QString current = QFontInfo(font).family();
+
+    // Keep the selected font's family, even if it is not in the list.
+    QSignalBlocker blocker(fontComboBox);
+    fontComboBox->clear();
+    fontComboBox->addItems(families);
+
+    int index = fontComboBox->findText(current);
+
+    if (index < 0) {
+        fontComboBox->insertItem(0, current);
+        index = 0;
+    }
+
+    fontComboBox->setCurrentIndex(index);
+}
+
 void SimpleFontDialogPrivate::onFontFamilyChanged(const QFont &font)
 {
     int size = this->font.pointSize();
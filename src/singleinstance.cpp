@@ -0,0 +1,158 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+#include "singleinstance.h"
+
+namespace ghostwriter
+{
+SingleInstance::SingleInstance(QObject *parent)
+    : QObject(parent)
+{
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    this->connect
+    (
+        server,
+        &QLocalServer::newConnection,
+        [this]() {
+            acceptConnections();
+        }
+    );
+}
+
+SingleInstance::~SingleInstance()
+{
+    ;
+}
+
+bool SingleInstance::forward(const QString &filePath)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+
+    if (!socket.waitForConnected(ConnectTimeout)) {
+        return false;
+    }
+
+    // The running instance has a working directory of its own.
+    QString path = filePath;
+
+    if (!path.isEmpty()) {
+        path = QFileInfo(path).absoluteFilePath();
+    }
+
+    socket.write(path.toUtf8() + '\n');
+
+    if (!socket.waitForBytesWritten(ResponseTimeout)) {
+        return false;
+    }
+
+    // Wait for the acknowledgement, so that a hung instance does not
+    // swallow the file.
+    while (!socket.canReadLine()) {
+        if (!socket.waitForReadyRead(ResponseTimeout)) {
+            return false;
+        }
+    }
+
+    socket.disconnectFromServer();
+    return true;
+}
+
+bool SingleInstance::isListening() const
+{
+    return server->isListening();
+}
+
+void SingleInstance::setEnabled(bool enabled)
+{
+    if (!enabled) {
+        server->close();
+        return;
+    }
+
+    if (server->isListening()) {
+        return;
+    }
+
+    QString name = serverName();
+
+    // A socket left behind by an instance that crashed keeps the name
+    // taken on Unix.  As no instance answered forward() at startup, it
+    // can safely be removed.
+    if (!server->listen(name) && (QAbstractSocket::AddressInUseError == server->serverError())) {
+        QLocalServer::removeServer(name);
+        server->listen(name);
+    }
+}
+
+void SingleInstance::acceptConnections()
+{
+    while (server->hasPendingConnections()) {
+        QLocalSocket *socket = server->nextPendingConnection();
+
+        this->connect
+        (
+            socket,
+            &QLocalSocket::disconnected,
+            socket,
+            &QLocalSocket::deleteLater
+        );
+
+        this->connect
+        (
+            socket,
+            &QLocalSocket::readyRead,
+            this,
+            [this, socket]() {
+                if (!socket->canReadLine()) {
+                    return;
+                }
+
+                QByteArray line = socket->readLine();
+                line.chop(1);
+                QString filePath = QString::fromUtf8(line);
+
+                socket->write("\n");
+                socket->flush();
+
+                emit openRequested(filePath);
+            }
+        );
+    }
+}
+
+QString SingleInstance::serverName()
+{
+    QByteArray hash = QCryptographicHash::hash
+        (
+            QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation).toUtf8(),
+            QCryptographicHash::Sha1
+        ).toHex();
+
+    return QString("ghostwriter-") + QString::fromLatin1(hash.left(16));
+}
+} // namespace ghostwriter
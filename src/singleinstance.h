@@ -0,0 +1,100 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef SINGLE_INSTANCE_H
+#define SINGLE_INSTANCE_H
+
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+
+namespace ghostwriter
+{
+/**
+ * Lets a running instance of the application open the files that later
+ * launches are given, so that these launches exit right away instead of
+ * paying for a full startup of their own.  The running instance listens
+ * on a local socket private to the current user, and later launches send
+ * it their file path with forward().
+ */
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.  The instance does not listen for requests until it is
+     * enabled.
+     */
+    SingleInstance(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~SingleInstance();
+
+    /**
+     * Sends the given file path to the running instance, if any, returning
+     * true once that instance has received it.  An empty path asks the
+     * running instance to merely bring its window to the front.  Returns
+     * false if no instance is listening or if it does not answer in time,
+     * in which case the caller should start up normally.
+     */
+    static bool forward(const QString &filePath);
+
+    /**
+     * Returns whether this instance is listening for requests.
+     */
+    bool isListening() const;
+
+signals:
+    /**
+     * Emitted when a later launch asks this instance to open the file at
+     * the given absolute path, or merely to bring its window to the front
+     * if the path is empty.
+     */
+    void openRequested(const QString &filePath);
+
+public slots:
+    /**
+     * Starts or stops listening for requests from later launches.
+     */
+    void setEnabled(bool enabled);
+
+private:
+    // Time, in milliseconds, for a later launch to wait for the running
+    // instance to accept its connection, and then to answer.
+    static const int ConnectTimeout = 500;
+    static const int ResponseTimeout = 2000;
+
+    QLocalServer *server;
+
+    void acceptConnections();
+
+    /*
+    * Returns the name of the local socket, which is unique to the current
+    * user's configuration, so that different users do not share a running
+    * instance.
+    */
+    static QString serverName();
+};
+} // namespace ghostwriter
+
+#endif // SINGLE_INSTANCE_H
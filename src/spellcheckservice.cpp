@@ -0,0 +1,300 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFutureWatcher>
+#include <QList>
+#include <QtConcurrentMap>
+
+#include "spellcheckservice.h"
+#include "taskscheduler.h"
+#include "textblockdata.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+class SpellCheckServicePrivate
+{
+    Q_DECLARE_PUBLIC(SpellCheckService)
+
+public:
+    // Text of a block as it was queued for checking, along with the
+    // misspelled words found in it.
+    struct CheckedBlock
+    {
+        QTextBlock block;
+        QString text;
+
+        // Text with everything but its prose blanked out, or an empty
+        // string if the block has no prose.
+        QString prose;
+
+        QVector<SpellCheckService::Misspelling> misspellings;
+        int dictionaryIndex;
+    };
+
+    SpellCheckServicePrivate
+    (
+        SpellCheckService *q_ptr,
+        const DictionaryRef &dictionary
+    ) : q_ptr(q_ptr),
+        dictionary(dictionary),
+        generation(0),
+        checkGeneration(0)
+    {
+        ;
+    }
+
+    ~SpellCheckServicePrivate()
+    {
+        ;
+    }
+
+    // Maximum number of blocks to check on the worker thread at once, so
+    // that urgent blocks queued in the meantime are not kept waiting long.
+    static const int MaxBatchSize = 64;
+
+    SpellCheckService *q_ptr;
+    DictionaryRef dictionary;
+    QList<DictionaryRef> alternativeDictionaries;
+    QList<QTextBlock> pending;
+    QFutureWatcher<QVector<CheckedBlock>> *watcher;
+
+    // Incremented whenever the results of the check in progress become
+    // stale, and compared against the generation the check started with.
+    int generation;
+    int checkGeneration;
+
+    void startCheck();
+    void onCheckFinished();
+
+    static QString proseOf(const QTextBlock &block, const QString &text);
+
+    static QVector<SpellCheckService::Misspelling> findMisspellings
+    (
+        const DictionaryRef &dictionary,
+        const QString &text
+    );
+};
+
+SpellCheckService::SpellCheckService
+(
+    const DictionaryRef &dictionary,
+    QObject *parent
+) : QObject(parent),
+    d_ptr(new SpellCheckServicePrivate(this, dictionary))
+{
+    Q_D(SpellCheckService);
+
+    d->watcher = new QFutureWatcher<QVector<SpellCheckServicePrivate::CheckedBlock>>(this);
+
+    this->connect
+    (
+        d->watcher,
+        &QFutureWatcher<QVector<SpellCheckServicePrivate::CheckedBlock>>::finished,
+        [d]() {
+            d->onCheckFinished();
+        }
+    );
+}
+
+SpellCheckService::~SpellCheckService()
+{
+    Q_D(SpellCheckService);
+
+    d->pending.clear();
+    d->watcher->waitForFinished();
+}
+
+void SpellCheckService::setDictionary(const DictionaryRef &dictionary)
+{
+    Q_D(SpellCheckService);
+
+    clear();
+    d->dictionary = dictionary;
+}
+
+void SpellCheckService::setAlternativeDictionaries(const QList<DictionaryRef> &dictionaries)
+{
+    Q_D(SpellCheckService);
+
+    clear();
+    d->alternativeDictionaries = dictionaries;
+}
+
+void SpellCheckService::check(const QTextBlock &block, bool urgent)
+{
+    Q_D(SpellCheckService);
+
+    if (!block.isValid()) {
+        return;
+    }
+
+    if (urgent) {
+        d->pending.prepend(block);
+    } else {
+        d->pending.append(block);
+    }
+
+    d->startCheck();
+}
+
+void SpellCheckService::clear()
+{
+    Q_D(SpellCheckService);
+
+    d->pending.clear();
+    d->generation++;
+}
+
+void SpellCheckServicePrivate::startCheck()
+{
+    if (watcher->isRunning() || pending.isEmpty()) {
+        return;
+    }
+
+    QVector<CheckedBlock> batch;
+
+    while (!pending.isEmpty() && (batch.size() < MaxBatchSize)) {
+        QTextBlock block = pending.takeFirst();
+
+        if (block.isValid()) {
+            CheckedBlock checked;
+            checked.block = block;
+            checked.text = block.text();
+            checked.prose = proseOf(block, checked.text);
+            checked.dictionaryIndex = 0;
+            batch.append(checked);
+        }
+    }
+
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    checkGeneration = generation;
+
+    DictionaryRef dictionary = this->dictionary;
+    QList<DictionaryRef> alternatives = this->alternativeDictionaries;
+
+    QFuture<QVector<CheckedBlock>> future =
+        TaskScheduler::instance()->run
+        (
+            TaskScheduler::SpellCheck,
+            [dictionary, alternatives, batch]() {
+                QVector<CheckedBlock> results = batch;
+
+                // Dictionaries may be checked concurrently, so spread the
+                // blocks of the batch across the thread pool.
+                QtConcurrent::blockingMap
+                (
+                    results,
+                    [&dictionary, &alternatives](CheckedBlock &checked) {
+                        GW_TRACE_SCOPE("SpellCheckService::checkBlock");
+
+                        if (checked.prose.isEmpty()) {
+                            return;
+                        }
+
+                        checked.misspellings = findMisspellings(dictionary, checked.prose);
+
+                        // Detect the language of the block by which
+                        // dictionary recognizes the most of its words.
+                        for (int i = 0; (i < alternatives.size()) && !checked.misspellings.isEmpty(); i++) {
+                            QVector<SpellCheckService::Misspelling> misspellings =
+                                findMisspellings(alternatives.at(i), checked.prose);
+
+                            if (misspellings.size() < checked.misspellings.size()) {
+                                checked.misspellings = misspellings;
+                                checked.dictionaryIndex = i + 1;
+                            }
+                        }
+                    }
+                );
+
+                return results;
+            }
+        );
+    watcher->setFuture(future);
+}
+
+void SpellCheckServicePrivate::onCheckFinished()
+{
+    Q_Q(SpellCheckService);
+
+    if (checkGeneration == generation) {
+        QVector<CheckedBlock> results = watcher->result();
+
+        for (const CheckedBlock &checked : results) {
+            emit q->blockChecked(checked.block, checked.text, checked.misspellings, checked.dictionaryIndex);
+        }
+    }
+
+    startCheck();
+}
+
+// Returns the given text of the given block with the characters outside of
+// the block's prose replaced by spaces, so that the positions of its words
+// stay the same, or an empty string if the block has no prose.  The prose
+// is as found by the last highlight of the block, and the whole text is
+// prose if the block's highlight is not cached.
+//
+QString SpellCheckServicePrivate::proseOf(const QTextBlock &block, const QString &text)
+{
+    const TextBlockData *blockData = (const TextBlockData *) block.userData();
+
+    if ((nullptr == blockData) || !blockData->highlightCached) {
+        return text;
+    }
+
+    if (blockData->proseRanges.isEmpty()) {
+        return QString();
+    }
+
+    QString prose(text.length(), QChar(' '));
+    QChar *data = prose.data();
+
+    for (const QPair<int, int> &range : blockData->proseRanges) {
+        int start = qBound(0, range.first, text.length());
+        int end = qBound(start, range.first + range.second, text.length());
+
+        for (int i = start; i < end; i++) {
+            data[i] = text[i];
+        }
+    }
+
+    return prose;
+}
+
+QVector<SpellCheckService::Misspelling> SpellCheckServicePrivate::findMisspellings
+(
+    const DictionaryRef &dictionary,
+    const QString &text
+)
+{
+    QVector<SpellCheckService::Misspelling> misspellings;
+    QStringRef word = dictionary.check(text, 0);
+
+    while (!word.isNull()) {
+        misspellings.append(SpellCheckService::Misspelling(word.position(), word.length()));
+        word = dictionary.check(text, word.position() + word.length());
+    }
+
+    return misspellings;
+}
+} // namespace ghostwriter
@@ -0,0 +1,111 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef SPELLCHECKSERVICE_H
+#define SPELLCHECKSERVICE_H
+
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QScopedPointer>
+#include <QString>
+#include <QTextBlock>
+#include <QVector>
+
+#include "spelling/dictionary_ref.h"
+
+namespace ghostwriter
+{
+/**
+ * Checks the spelling of text blocks on a worker thread.  Blocks are
+ * queued with check(), and the misspelled words found in each block are
+ * reported back on the GUI thread with the blockChecked() signal.
+ */
+class SpellCheckServicePrivate;
+class SpellCheckService : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(SpellCheckService)
+
+public:
+    /**
+     * Position and length of a misspelled word within a block's text.
+     */
+    typedef QPair<int, int> Misspelling;
+
+    /**
+     * Constructor.
+     */
+    SpellCheckService(const DictionaryRef &dictionary, QObject *parent = nullptr);
+
+    /**
+     * Destructor.  Waits for any check in progress to finish.
+     */
+    virtual ~SpellCheckService();
+
+    /**
+     * Sets the dictionary to check with.  Pending checks are discarded,
+     * as are the results of any check in progress.
+     */
+    void setDictionary(const DictionaryRef &dictionary);
+
+    /**
+     * Sets the dictionaries of other languages in which blocks may be
+     * written.  A block with misspellings according to the main dictionary
+     * is also checked against each of these, and the misspellings of the
+     * dictionary that finds the fewest are reported.  Pending checks are
+     * discarded, as are the results of any check in progress.
+     */
+    void setAlternativeDictionaries(const QList<DictionaryRef> &dictionaries);
+
+    /**
+     * Queues the given block to be checked with its current text.  Urgent
+     * blocks, such as the one being edited, are checked before any blocks
+     * queued previously.
+     */
+    void check(const QTextBlock &block, bool urgent = false);
+
+    /**
+     * Discards pending checks, as well as the results of any check in
+     * progress.
+     */
+    void clear();
+
+signals:
+    /**
+     * Emitted when the given block has been checked.  The text that was
+     * checked is provided so that the receiver can verify that the block
+     * has not changed since.  The dictionary index is 0 for the main
+     * dictionary, or 1 plus the index of the alternative dictionary with
+     * which the block was checked.
+     */
+    void blockChecked
+    (
+        const QTextBlock &block,
+        const QString &text,
+        const QVector<SpellCheckService::Misspelling> &misspellings,
+        int dictionaryIndex
+    );
+
+private:
+    QScopedPointer<SpellCheckServicePrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // SPELLCHECKSERVICE_H
@@ -20,6 +20,8 @@
 #ifndef ABSTRACT_DICTIONARY_H
 #define ABSTRACT_DICTIONARY_H
 
+#include <QtGlobal>
+
 class QString;
 class QStringList;
 class QStringRef;
@@ -30,12 +32,30 @@ public:
 	virtual ~AbstractDictionary() { }
 
 	virtual bool isValid() const = 0;
+
+	// Whether check() and suggestions() may be called from several threads
+	// at once.  Dictionaries that are not are serialized by the manager.
+	virtual bool isThreadSafe() const { return false; }
 	virtual QStringRef check(const QString& string, int start_at) const = 0;
 	virtual QStringList suggestions(const QString& word) const = 0;
 
+	// Gets the suggestions for the word if they were already searched for
+	// and are still cached, without searching.  Returns false otherwise.
+	virtual bool cachedSuggestions(const QString& word, QStringList& suggestions) const
+	{
+		Q_UNUSED(word);
+		Q_UNUSED(suggestions);
+		return false;
+	}
+
 	virtual void addToPersonal(const QString& word) = 0;
 	virtual void addToSession(const QStringList& words) = 0;
 	virtual void removeFromSession(const QStringList& words) = 0;
+
+	// Frees any results cached to speed up repeated checks, such as when
+	// memory runs low.  Checks stay correct, only slower until the cache
+	// fills again.
+	virtual void releaseCaches() { }
 };
 
 #endif
@@ -0,0 +1,1031 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "dictionary_compiler.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <QTextCodec>
+#include <QVector>
+
+#include <algorithm>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+
+const char Magic[8] = { 'G', 'W', 'D', 'I', 'C', 'T', '0', '1' };
+const quint32 Version = 1;
+
+// Written in the byte order of the machine, so that a dictionary copied
+// over from a machine of the other byte order is rejected.
+const quint32 ByteOrderMark = 0x01020304;
+
+// Most word forms that a dictionary may expand to.  Larger dictionaries
+// are left to Hunspell.
+const int MaxForms = 8000000;
+
+// Most displacements tried for a bucket before giving up on the table.
+const quint32 MaxDisplacement = 1 << 24;
+
+typedef QVector<ushort> Flags;
+
+enum FlagType
+{
+	FlagChar,
+	FlagLong,
+	FlagNum,
+	FlagUtf8
+};
+
+// One character of the condition of an affix rule.
+struct Condition
+{
+	QString chars;
+	bool any;
+	bool negated;
+};
+
+struct AffixRule
+{
+	QString strip;
+	QString add;
+	Flags continuation;
+	QVector<Condition> conditions;
+};
+
+struct AffixClass
+{
+	AffixClass() :
+		cross(false),
+		remaining(0)
+	{
+	}
+
+	bool cross;
+	int remaining;
+	QVector<AffixRule> rules;
+};
+
+// Affix file, limited to the directives that matter for checking words.
+class AffixFile
+{
+public:
+	AffixFile();
+
+	bool read(const QByteArray& data, QString& err);
+
+	// Returns the flags of the given dictionary entry or affix
+	// continuation, which are an alias number if the file defines aliases.
+	Flags entryFlags(const QString& text) const;
+
+	QTextCodec* codec;
+	QHash<ushort, AffixClass> prefixes;
+	QHash<ushort, AffixClass> suffixes;
+	ushort needAffix;
+	ushort forbidden;
+	ushort keepCase;
+	ushort onlyInCompound;
+	bool fullStrip;
+	qint32 compoundMin;
+	QStringList breaks;
+	QList<QVector<quint32> > compoundRules;
+	QSet<ushort> compoundRuleFlags;
+
+private:
+	FlagType flagType;
+	QVector<Flags> aliases;
+
+	Flags parseFlags(const QString& text) const;
+	bool parseAffix(const QStringList& tokens, QHash<ushort, AffixClass>& classes);
+	bool parseCompoundRule(const QString& rule);
+	static QVector<Condition> parseCondition(const QString& condition);
+};
+
+//-----------------------------------------------------------------------------
+
+QTextCodec* codecOf(const QByteArray& aff)
+{
+	// The encoding is needed before the file can be decoded, and its name
+	// is plain ASCII.
+	foreach (const QByteArray& line, aff.split('\n')) {
+		QByteArray directive = line.trimmed();
+		if (directive.startsWith("\xEF\xBB\xBF")) {
+			directive = directive.mid(3);
+		}
+		if (directive.startsWith("SET ") || directive.startsWith("SET\t")) {
+			QByteArray name = directive.mid(4).trimmed();
+			if (name == "microsoft-cp1251") {
+				name = "windows-1251";
+			}
+			return QTextCodec::codecForName(name);
+		}
+	}
+
+	return QTextCodec::codecForName("ISO-8859-1");
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList splitLines(const QString& text)
+{
+	QStringList lines = text.split(QChar('\n'));
+	for (int i = 0; i < lines.size(); ++i) {
+		if (lines[i].endsWith(QChar('\r'))) {
+			lines[i].chop(1);
+		}
+	}
+	if (!lines.isEmpty() && lines[0].startsWith(QChar(0xFEFF))) {
+		lines[0].remove(0, 1);
+	}
+	return lines;
+}
+
+//-----------------------------------------------------------------------------
+
+AffixFile::AffixFile() :
+	codec(0),
+	needAffix(0),
+	forbidden(0),
+	keepCase(0),
+	onlyInCompound(0),
+	fullStrip(false),
+	compoundMin(3),
+	flagType(FlagChar)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+bool AffixFile::read(const QByteArray& data, QString& err)
+{
+	codec = codecOf(data);
+	if (!codec) {
+		err = "unknown encoding";
+		return false;
+	}
+
+	// Tables that start with a line giving their number of entries.
+	QSet<QString> tables_started;
+	bool has_breaks = false;
+
+	foreach (const QString& line, splitLines(codec->toUnicode(data))) {
+		QStringList tokens = line.simplified().split(QChar(' '), QString::SkipEmptyParts);
+		if (tokens.isEmpty() || tokens[0].startsWith(QChar('#'))) {
+			continue;
+		}
+
+		const QString& directive = tokens[0];
+		QString argument = tokens.value(1);
+
+		if ((directive == "PFX") || (directive == "SFX")) {
+			if (!parseAffix(tokens, (directive == "PFX") ? prefixes : suffixes)) {
+				err = QString("malformed %1 rule").arg(directive);
+				return false;
+			}
+			continue;
+		}
+
+		if ((directive == "AF") || (directive == "BREAK") || (directive == "COMPOUNDRULE") || (directive == "ICONV")) {
+			if (!tables_started.contains(directive)) {
+				// The line gives the number of entries.
+				tables_started.insert(directive);
+				if (directive == "BREAK") {
+					has_breaks = true;
+				}
+				continue;
+			}
+
+			if (directive == "AF") {
+				aliases.append(parseFlags(argument));
+			} else if (directive == "BREAK") {
+				breaks.append(argument);
+			} else if (directive == "COMPOUNDRULE") {
+				if (!parseCompoundRule(argument)) {
+					err = "malformed COMPOUNDRULE";
+					return false;
+				}
+			} else if ((argument != tokens.value(2))
+					&& !((argument == QString(QChar(0x2019))) && (tokens.value(2) == "'"))) {
+				// The spell checker turns typographic apostrophes into
+				// plain ones by itself, but no other input conversion.
+				err = "ICONV is not supported";
+				return false;
+			}
+		} else if (directive == "FLAG") {
+			if (argument == "long") {
+				flagType = FlagLong;
+			} else if (argument == "num") {
+				flagType = FlagNum;
+			} else if (argument.compare("UTF-8", Qt::CaseInsensitive) == 0) {
+				flagType = FlagUtf8;
+			}
+		} else if ((directive == "NEEDAFFIX") || (directive == "PSEUDOROOT")) {
+			needAffix = parseFlags(argument).value(0);
+		} else if (directive == "FORBIDDENWORD") {
+			forbidden = parseFlags(argument).value(0);
+		} else if (directive == "KEEPCASE") {
+			keepCase = parseFlags(argument).value(0);
+		} else if (directive == "ONLYINCOMPOUND") {
+			onlyInCompound = parseFlags(argument).value(0);
+		} else if (directive == "COMPOUNDMIN") {
+			compoundMin = qMax(1, argument.toInt());
+		} else if (directive == "FULLSTRIP") {
+			fullStrip = true;
+		} else if (directive == "LANG") {
+			// Turkic languages case the letter i differently.
+			if (argument.startsWith("tr") || argument.startsWith("az") || argument.startsWith("crh")) {
+				err = QString("LANG %1 is not supported").arg(argument);
+				return false;
+			}
+		} else if ((directive == "COMPOUNDFLAG")
+				|| (directive == "COMPOUNDBEGIN")
+				|| (directive == "COMPOUNDMIDDLE")
+				|| (directive == "COMPOUNDEND")
+				|| (directive == "COMPOUNDLAST")
+				|| (directive == "CIRCUMFIX")
+				|| (directive == "COMPLEXPREFIXES")
+				|| (directive == "IGNORE")
+				|| (directive == "CHECKSHARPS")
+				|| (directive == "FORBIDWARN")) {
+			err = QString("%1 is not supported").arg(directive);
+			return false;
+		}
+	}
+
+	if (!has_breaks) {
+		breaks << "-" << "^-" << "-$";
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+Flags AffixFile::entryFlags(const QString& text) const
+{
+	if (!aliases.isEmpty()) {
+		bool ok = false;
+		int alias = text.toInt(&ok);
+		if (ok && (alias > 0) && (alias <= aliases.size())) {
+			return aliases[alias - 1];
+		}
+		return Flags();
+	}
+
+	return parseFlags(text);
+}
+
+//-----------------------------------------------------------------------------
+
+Flags AffixFile::parseFlags(const QString& text) const
+{
+	Flags flags;
+
+	switch (flagType) {
+	case FlagLong:
+		for (int i = 0; (i + 1) < text.size(); i += 2) {
+			flags.append(((text.at(i).unicode() & 0xFF) << 8) | (text.at(i + 1).unicode() & 0xFF));
+		}
+		break;
+	case FlagNum:
+		foreach (const QString& number, text.split(QChar(','), QString::SkipEmptyParts)) {
+			ushort flag = number.toUShort();
+			if (flag) {
+				flags.append(flag);
+			}
+		}
+		break;
+	case FlagChar:
+	case FlagUtf8:
+		for (int i = 0; i < text.size(); ++i) {
+			flags.append(text.at(i).unicode());
+		}
+		break;
+	}
+
+	return flags;
+}
+
+//-----------------------------------------------------------------------------
+
+bool AffixFile::parseAffix(const QStringList& tokens, QHash<ushort, AffixClass>& classes)
+{
+	if (tokens.size() < 4) {
+		return false;
+	}
+
+	ushort flag = parseFlags(tokens[1]).value(0);
+	if (!flag) {
+		return false;
+	}
+
+	AffixClass& affix = classes[flag];
+
+	// Lines that come when no rule is expected start a class.
+	if (affix.remaining <= 0) {
+		affix.cross = (tokens[2] == "Y");
+		affix.remaining = tokens[3].toInt();
+		return true;
+	}
+	affix.remaining--;
+
+	AffixRule rule;
+	rule.strip = (tokens[2] == "0") ? QString() : tokens[2];
+
+	QString add = tokens[3];
+	int slash = add.indexOf(QChar('/'));
+	if (slash >= 0) {
+		rule.continuation = entryFlags(add.mid(slash + 1));
+		add.truncate(slash);
+	}
+	rule.add = (add == "0") ? QString() : add;
+	rule.conditions = parseCondition(tokens.value(4, "."));
+
+	affix.rules.append(rule);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool AffixFile::parseCompoundRule(const QString& rule)
+{
+	// Rules are written as flags, each optionally followed by * or ?.
+	// Flags of more than one character are put within parentheses.
+	QVector<quint32> atoms;
+
+	for (int i = 0; i < rule.size(); ++i) {
+		QChar c = rule.at(i);
+		if ((c == QChar('*')) || (c == QChar('?'))) {
+			if (atoms.isEmpty()) {
+				return false;
+			}
+			atoms.last() |= (c == QChar('*')) ? (1 << 16) : (2 << 16);
+			continue;
+		}
+
+		QString text = c;
+		if (c == QChar('(')) {
+			int end = rule.indexOf(QChar(')'), i);
+			if (end < 0) {
+				return false;
+			}
+			text = rule.mid(i + 1, end - i - 1);
+			i = end;
+		} else if (flagType == FlagLong) {
+			text = rule.mid(i, 2);
+			++i;
+		}
+
+		ushort flag = parseFlags(text).value(0);
+		if (!flag) {
+			return false;
+		}
+		atoms.append(flag);
+		compoundRuleFlags.insert(flag);
+	}
+
+	compoundRules.append(atoms);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector<Condition> AffixFile::parseCondition(const QString& condition)
+{
+	QVector<Condition> conditions;
+
+	if (condition == ".") {
+		return conditions;
+	}
+
+	for (int i = 0; i < condition.size(); ++i) {
+		Condition c;
+		c.any = false;
+		c.negated = false;
+
+		if (condition.at(i) == QChar('.')) {
+			c.any = true;
+		} else if (condition.at(i) == QChar('[')) {
+			int end = condition.indexOf(QChar(']'), i);
+			if (end < 0) {
+				end = condition.size();
+			}
+			c.chars = condition.mid(i + 1, end - i - 1);
+			if (c.chars.startsWith(QChar('^'))) {
+				c.negated = true;
+				c.chars.remove(0, 1);
+			}
+			i = end;
+		} else {
+			c.chars = condition.at(i);
+		}
+
+		conditions.append(c);
+	}
+
+	return conditions;
+}
+
+//-----------------------------------------------------------------------------
+
+bool conditionMatches(const Condition& condition, QChar c)
+{
+	return condition.any || (condition.chars.contains(c) != condition.negated);
+}
+
+//-----------------------------------------------------------------------------
+
+// Generates the word forms of the entries of a dictionary.
+class Expander
+{
+public:
+	Expander(const AffixFile& aff) :
+		m_aff(aff),
+		m_overflow(false)
+	{
+	}
+
+	void expand(const QString& stem, const Flags& flags);
+
+	bool overflowed() const
+	{
+		return m_overflow;
+	}
+
+	QHash<QString, quint8> forms;
+	QHash<QString, QVector<quint16> > pieces;
+
+private:
+	const AffixFile& m_aff;
+	bool m_overflow;
+
+	void add(const QString& form, quint8 entry);
+	bool suffixApplies(const AffixRule& rule, const QString& word) const;
+	bool prefixApplies(const AffixRule& rule, const QString& word) const;
+	static bool allows(const Flags& continuation, ushort flag);
+};
+
+//-----------------------------------------------------------------------------
+
+void Expander::expand(const QString& stem, const Flags& flags)
+{
+	if (stem.isEmpty()) {
+		return;
+	}
+
+	// Pieces of compounds are found at check time, as compounds are
+	// too many to list.
+	if (!m_aff.compoundRuleFlags.isEmpty()) {
+		QVector<quint16> piece_flags;
+		foreach (ushort flag, flags) {
+			if (m_aff.compoundRuleFlags.contains(flag)) {
+				piece_flags.append(flag);
+			}
+		}
+		if (!piece_flags.isEmpty()) {
+			QVector<quint16>& existing = pieces[stem];
+			foreach (quint16 flag, piece_flags) {
+				if (!existing.contains(flag)) {
+					existing.append(flag);
+				}
+			}
+		}
+	}
+
+	if (m_aff.forbidden && flags.contains(m_aff.forbidden)) {
+		add(stem, DictionaryCompiler::EntryForbidden);
+		return;
+	}
+
+	if (m_aff.onlyInCompound && flags.contains(m_aff.onlyInCompound)) {
+		return;
+	}
+
+	quint8 entry = (m_aff.keepCase && flags.contains(m_aff.keepCase)) ? DictionaryCompiler::EntryKeepCase : 0;
+
+	if (!(m_aff.needAffix && flags.contains(m_aff.needAffix))) {
+		add(stem, entry);
+	}
+
+	foreach (ushort suffix_flag, flags) {
+		QHash<ushort, AffixClass>::const_iterator suffix = m_aff.suffixes.constFind(suffix_flag);
+		if (suffix == m_aff.suffixes.constEnd()) {
+			continue;
+		}
+
+		foreach (const AffixRule& rule, suffix->rules) {
+			if (!suffixApplies(rule, stem)) {
+				continue;
+			}
+
+			QString form = stem.left(stem.size() - rule.strip.size()) + rule.add;
+			if (!allows(rule.continuation, m_aff.onlyInCompound) || !allows(rule.continuation, m_aff.forbidden)) {
+				continue;
+			}
+			if (allows(rule.continuation, m_aff.needAffix)) {
+				add(form, entry);
+			}
+
+			// Twofold suffixes, which the suffix's continuation allows.
+			foreach (ushort second_flag, rule.continuation) {
+				QHash<ushort, AffixClass>::const_iterator second = m_aff.suffixes.constFind(second_flag);
+				if (second == m_aff.suffixes.constEnd()) {
+					continue;
+				}
+				foreach (const AffixRule& second_rule, second->rules) {
+					if (suffixApplies(second_rule, form)
+							&& allows(second_rule.continuation, m_aff.onlyInCompound)
+							&& allows(second_rule.continuation, m_aff.needAffix)) {
+						add(form.left(form.size() - second_rule.strip.size()) + second_rule.add, entry);
+					}
+				}
+			}
+
+			if (!suffix->cross) {
+				continue;
+			}
+
+			// Prefixes combined with the suffix, from the stem's flags
+			// or the suffix's continuation.
+			Flags prefix_flags = flags + rule.continuation;
+			foreach (ushort prefix_flag, prefix_flags) {
+				QHash<ushort, AffixClass>::const_iterator prefix = m_aff.prefixes.constFind(prefix_flag);
+				if ((prefix == m_aff.prefixes.constEnd()) || !prefix->cross) {
+					continue;
+				}
+				foreach (const AffixRule& prefix_rule, prefix->rules) {
+					if (prefixApplies(prefix_rule, form)
+							&& allows(prefix_rule.continuation, m_aff.onlyInCompound)
+							&& allows(prefix_rule.continuation, m_aff.needAffix)) {
+						add(prefix_rule.add + form.mid(prefix_rule.strip.size()), entry);
+					}
+				}
+			}
+		}
+	}
+
+	foreach (ushort prefix_flag, flags) {
+		QHash<ushort, AffixClass>::const_iterator prefix = m_aff.prefixes.constFind(prefix_flag);
+		if (prefix == m_aff.prefixes.constEnd()) {
+			continue;
+		}
+
+		foreach (const AffixRule& rule, prefix->rules) {
+			if (prefixApplies(rule, stem)
+					&& allows(rule.continuation, m_aff.onlyInCompound)
+					&& allows(rule.continuation, m_aff.needAffix)
+					&& allows(rule.continuation, m_aff.forbidden)) {
+				add(rule.add + stem.mid(rule.strip.size()), entry);
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Expander::add(const QString& form, quint8 entry)
+{
+	QHash<QString, quint8>::iterator existing = forms.find(form);
+
+	if (existing == forms.end()) {
+		if (forms.size() >= MaxForms) {
+			m_overflow = true;
+			return;
+		}
+		forms.insert(form, entry);
+		return;
+	}
+
+	// A homonym that keeps no case lets the word be capitalized, and a
+	// forbidden homonym forbids the word whatever the others are.
+	quint8 keep_case = existing.value() & entry & DictionaryCompiler::EntryKeepCase;
+	quint8 forbidden = (existing.value() | entry) & DictionaryCompiler::EntryForbidden;
+	existing.value() = keep_case | forbidden;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Expander::suffixApplies(const AffixRule& rule, const QString& word) const
+{
+	int strip = rule.strip.size();
+	int length = word.size();
+
+	if ((strip > length) || ((strip == length) && !m_aff.fullStrip)) {
+		return false;
+	}
+	if (!word.endsWith(rule.strip)) {
+		return false;
+	}
+
+	int count = rule.conditions.size();
+	if (count > length) {
+		return false;
+	}
+	for (int i = 0; i < count; ++i) {
+		if (!conditionMatches(rule.conditions[i], word.at(length - count + i))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Expander::prefixApplies(const AffixRule& rule, const QString& word) const
+{
+	int strip = rule.strip.size();
+	int length = word.size();
+
+	if ((strip > length) || ((strip == length) && !m_aff.fullStrip)) {
+		return false;
+	}
+	if (!word.startsWith(rule.strip)) {
+		return false;
+	}
+
+	int count = rule.conditions.size();
+	if (count > length) {
+		return false;
+	}
+	for (int i = 0; i < count; ++i) {
+		if (!conditionMatches(rule.conditions[i], word.at(i))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool Expander::allows(const Flags& continuation, ushort flag)
+{
+	return !flag || !continuation.contains(flag);
+}
+
+//-----------------------------------------------------------------------------
+
+// Reads the entries of a .dic file into the expander.  Returns false if
+// the dictionary expands to too many forms.
+bool readWords(const QByteArray& data, const AffixFile& aff, Expander& expander)
+{
+	QStringList lines = splitLines(aff.codec->toUnicode(data));
+	bool counted = false;
+
+	foreach (const QString& line, lines) {
+		// Lines starting with a tab are comments.
+		if (line.isEmpty() || line.startsWith(QChar('\t'))) {
+			continue;
+		}
+
+		// The first line gives the number of words.
+		if (!counted) {
+			counted = true;
+			continue;
+		}
+
+		QString word;
+		QString flags;
+		int i = 0;
+
+		for (; i < line.size(); ++i) {
+			QChar c = line.at(i);
+			if ((c == QChar('\\')) && ((i + 1) < line.size()) && (line.at(i + 1) == QChar('/'))) {
+				word.append(QChar('/'));
+				++i;
+			} else if ((c == QChar('/')) && !word.isEmpty()) {
+				break;
+			} else if ((c == QChar(' ')) || (c == QChar('\t'))) {
+				break;
+			} else {
+				word.append(c);
+			}
+		}
+
+		if ((i < line.size()) && (line.at(i) == QChar('/'))) {
+			int end = i + 1;
+			while ((end < line.size()) && (line.at(end) != QChar(' ')) && (line.at(end) != QChar('\t'))) {
+				++end;
+			}
+			flags = line.mid(i + 1, end - i - 1);
+		}
+
+		expander.expand(word, flags.isEmpty() ? Flags() : aff.entryFlags(flags));
+		if (expander.overflowed()) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+quint64 mix(quint64 x)
+{
+	x ^= x >> 30;
+	x *= Q_UINT64_C(0xBF58476D1CE4E5B9);
+	x ^= x >> 27;
+	x *= Q_UINT64_C(0x94D049BB133111EB);
+	x ^= x >> 31;
+	return x;
+}
+
+//-----------------------------------------------------------------------------
+
+qint64 alignedOffset(qint64 offset)
+{
+	return (offset + 7) & ~qint64(7);
+}
+
+}
+
+//-----------------------------------------------------------------------------
+
+bool DictionaryCompiler::compile
+(
+	const QString& affPath,
+	const QString& dicPath,
+	const QString& outputPath,
+	QString& err
+)
+{
+	QFileInfo aff_info(affPath);
+	QFileInfo dic_info(dicPath);
+	QFile aff_file(affPath);
+	QFile dic_file(dicPath);
+
+	if (!aff_file.open(QIODevice::ReadOnly) || !dic_file.open(QIODevice::ReadOnly)) {
+		err = "cannot read the dictionary";
+		return false;
+	}
+
+	AffixFile aff;
+	if (!aff.read(aff_file.readAll(), err)) {
+		return false;
+	}
+
+	Expander expander(aff);
+	if (!readWords(dic_file.readAll(), aff, expander)) {
+		err = "too many word forms";
+		return false;
+	}
+
+	// Gather the words, which are looked up in UTF-8.
+	QVector<QByteArray> words;
+	QVector<quint8> entries;
+	words.reserve(expander.forms.size());
+	entries.reserve(expander.forms.size());
+
+	for (QHash<QString, quint8>::const_iterator i = expander.forms.constBegin(); i != expander.forms.constEnd(); ++i) {
+		QByteArray word = i.key().toUtf8();
+		if (word.size() <= 255) {
+			words.append(word);
+			entries.append(i.value());
+		}
+	}
+	expander.forms.clear();
+
+	// Hash and displace:  the words are hashed into buckets of a few
+	// words, and the largest buckets first are given the displacement
+	// that sends all of their words to free slots.
+	quint32 word_count = words.size();
+	quint32 bucket_count = qMax<quint32>(1, word_count / 4);
+	quint32 slot_count = qMax<quint32>(1, word_count + (word_count / 4));
+
+	QVector<quint64> hashes(word_count);
+	QVector<QVector<quint32> > buckets(bucket_count);
+	for (quint32 i = 0; i < word_count; ++i) {
+		hashes[i] = hash(words[i].constData(), words[i].size());
+		buckets[bucket(hashes[i], bucket_count)].append(i);
+	}
+
+	QVector<quint32> order(bucket_count);
+	for (quint32 i = 0; i < bucket_count; ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&buckets](quint32 a, quint32 b) {
+		return buckets[a].size() > buckets[b].size();
+	});
+
+	QVector<quint32> displacements(bucket_count, 0);
+	QVector<quint32> slots(slot_count, EmptySlot);
+	QVector<quint32> trial;
+
+	foreach (quint32 b, order) {
+		const QVector<quint32>& members = buckets[b];
+		if (members.isEmpty()) {
+			break;
+		}
+
+		quint32 displacement = 0;
+		for (;; ++displacement) {
+			if (displacement >= MaxDisplacement) {
+				err = "cannot build the word table";
+				return false;
+			}
+
+			trial.clear();
+			bool free = true;
+			foreach (quint32 word, members) {
+				quint32 s = slot(hashes[word], displacement, slot_count);
+				if ((slots[s] != EmptySlot) || trial.contains(s)) {
+					free = false;
+					break;
+				}
+				trial.append(s);
+			}
+			if (free) {
+				break;
+			}
+		}
+
+		displacements[b] = displacement;
+		for (int i = 0; i < members.size(); ++i) {
+			slots[trial[i]] = members[i];
+		}
+	}
+
+	// Lay the words out in the pool, and point the slots at them.
+	QByteArray pool;
+	QVector<quint32> offsets(word_count);
+	for (quint32 i = 0; i < word_count; ++i) {
+		offsets[i] = pool.size();
+		pool.append(char(words[i].size()));
+		pool.append(char(entries[i]));
+		pool.append(words[i]);
+	}
+	for (quint32 i = 0; i < slot_count; ++i) {
+		if (slots[i] != EmptySlot) {
+			slots[i] = offsets[slots[i]];
+		}
+	}
+
+	QByteArray extras;
+	{
+		QDataStream stream(&extras, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_5_6);
+		stream << aff.compoundMin << aff.breaks << aff.compoundRules << expander.pieces;
+	}
+
+	Header header;
+	memset(&header, 0, sizeof(Header));
+	memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.byteOrder = ByteOrderMark;
+	header.affSize = aff_info.size();
+	header.affModified = aff_info.lastModified().toMSecsSinceEpoch();
+	header.dicSize = dic_info.size();
+	header.dicModified = dic_info.lastModified().toMSecsSinceEpoch();
+	header.wordCount = word_count;
+	header.bucketCount = bucket_count;
+	header.slotCount = slot_count;
+	header.poolSize = pool.size();
+	header.bucketsOffset = alignedOffset(sizeof(Header));
+	header.slotsOffset = alignedOffset(header.bucketsOffset + (bucket_count * sizeof(quint32)));
+	header.poolOffset = alignedOffset(header.slotsOffset + (slot_count * sizeof(quint32)));
+	header.extrasOffset = alignedOffset(header.poolOffset + pool.size());
+	header.extrasLength = extras.size();
+
+	if (!QDir().mkpath(QFileInfo(outputPath).path())) {
+		err = "cannot create the cache directory";
+		return false;
+	}
+
+	// Write to a temporary file of this process, renamed once complete,
+	// so that other instances never map a partly written dictionary.
+	QString temp_path = outputPath + "." + QString::number(QCoreApplication::applicationPid()) + ".part";
+	QFile file(temp_path);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		err = "cannot write the compiled dictionary";
+		return false;
+	}
+
+	QByteArray padding(8, '\0');
+	bool written =
+		(file.write((const char*) &header, sizeof(Header)) == (qint64) sizeof(Header))
+		&& file.write(padding.constData(), header.bucketsOffset - file.pos()) >= 0
+		&& file.write((const char*) displacements.constData(), bucket_count * sizeof(quint32)) >= 0
+		&& file.write(padding.constData(), header.slotsOffset - file.pos()) >= 0
+		&& file.write((const char*) slots.constData(), slot_count * sizeof(quint32)) >= 0
+		&& file.write(padding.constData(), header.poolOffset - file.pos()) >= 0
+		&& (file.write(pool) == pool.size())
+		&& file.write(padding.constData(), header.extrasOffset - file.pos()) >= 0
+		&& (file.write(extras) == extras.size());
+
+	file.close();
+
+	if (!written || (QFile::NoError != file.error())) {
+		QFile::remove(temp_path);
+		err = "cannot write the compiled dictionary";
+		return false;
+	}
+
+	// Instances that mapped the old file keep it until they unmap it.
+	QFile::remove(outputPath);
+
+	if (!QFile::rename(temp_path, outputPath)) {
+		QFile::remove(temp_path);
+		err = "cannot write the compiled dictionary";
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool DictionaryCompiler::isCurrent
+(
+	const Header* header,
+	qint64 size,
+	const QString& affPath,
+	const QString& dicPath
+)
+{
+	if (size < (qint64) sizeof(Header)) {
+		return false;
+	}
+
+	QFileInfo aff_info(affPath);
+	QFileInfo dic_info(dicPath);
+
+	return
+		(0 == memcmp(header->magic, Magic, sizeof(Magic)))
+		&& (Version == header->version)
+		&& (ByteOrderMark == header->byteOrder)
+		&& (aff_info.size() == header->affSize)
+		&& (aff_info.lastModified().toMSecsSinceEpoch() == header->affModified)
+		&& (dic_info.size() == header->dicSize)
+		&& (dic_info.lastModified().toMSecsSinceEpoch() == header->dicModified)
+		&& (header->bucketCount > 0)
+		&& (header->slotCount > 0)
+		&& (header->bucketsOffset >= (qint64) sizeof(Header))
+		&& (header->slotsOffset >= (qint64) sizeof(Header))
+		&& (header->poolOffset >= (qint64) sizeof(Header))
+		&& (header->extrasOffset >= (qint64) sizeof(Header))
+		&& (header->extrasLength >= 0)
+		&& ((header->bucketsOffset + header->bucketCount * (qint64) sizeof(quint32)) <= size)
+		&& ((header->slotsOffset + header->slotCount * (qint64) sizeof(quint32)) <= size)
+		&& ((header->poolOffset + header->poolSize) <= size)
+		&& ((header->extrasOffset + header->extrasLength) <= size);
+}
+
+//-----------------------------------------------------------------------------
+
+quint64 DictionaryCompiler::hash(const char* word, int length)
+{
+	// FNV-1a, spread by the mixing of bucket() and slot().
+	quint64 h = Q_UINT64_C(14695981039346656037);
+	for (int i = 0; i < length; ++i) {
+		h ^= uchar(word[i]);
+		h *= Q_UINT64_C(1099511628211);
+	}
+	return h;
+}
+
+//-----------------------------------------------------------------------------
+
+quint32 DictionaryCompiler::bucket(quint64 hash, quint32 bucketCount)
+{
+	return quint32(mix(hash) % bucketCount);
+}
+
+//-----------------------------------------------------------------------------
+
+quint32 DictionaryCompiler::slot(quint64 hash, quint32 displacement, quint32 slotCount)
+{
+	return quint32(mix(hash + ((quint64(displacement) + 1) * Q_UINT64_C(0x9E3779B97F4A7C15))) % slotCount);
+}
+
+//-----------------------------------------------------------------------------
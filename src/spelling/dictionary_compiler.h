@@ -0,0 +1,131 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef DICTIONARY_COMPILER_H
+#define DICTIONARY_COMPILER_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * Compiles a Hunspell dictionary, given as its .aff and .dic files, into a
+ * file that can be checked against in place once memory mapped, so that
+ * the dictionary is neither parsed again on each launch nor copied into
+ * the memory of each process that uses it.
+ *
+ * Every word form that the affix rules generate from the words of the
+ * dictionary is listed in a perfect hash table, built by hash and
+ * displace, so that looking a word up takes a single probe.  The break
+ * patterns and compound rules of the dictionary are kept alongside, as
+ * are the pieces that the compound rules join, since compounds cannot be
+ * listed.  Dictionaries whose affix file uses features that cannot be
+ * compiled this way, such as compounding by flags, are refused.
+ */
+class DictionaryCompiler
+{
+public:
+	/**
+	 * Layout of a compiled dictionary:  the header, followed by the
+	 * displacements of the buckets, the slots of the table and the pool of
+	 * words that the slots point into, and then the extras as written by
+	 * QDataStream.  Each section starts at an offset aligned to eight
+	 * bytes.  Each word in the pool is its length in bytes, its entry
+	 * flags, and its UTF-8 bytes.
+	 */
+	struct Header
+	{
+		char magic[8];
+		quint32 version;
+		quint32 byteOrder;
+		qint64 affSize;
+		qint64 affModified;
+		qint64 dicSize;
+		qint64 dicModified;
+		quint32 wordCount;
+		quint32 bucketCount;
+		quint32 slotCount;
+		quint32 poolSize;
+		qint64 bucketsOffset;
+		qint64 slotsOffset;
+		qint64 poolOffset;
+		qint64 extrasOffset;
+		qint64 extrasLength;
+	};
+
+	enum EntryFlag
+	{
+		// Only the word as written is correct, not its capitalized or
+		// uppercased forms.
+		EntryKeepCase = 0x01,
+
+		// The word is incorrect, even if it could be generated otherwise.
+		EntryForbidden = 0x02
+	};
+
+	// Value of the slots that hold no word.
+	static const quint32 EmptySlot = 0xFFFFFFFF;
+
+	/**
+	 * Compiles the dictionary made of the given affix and word files into
+	 * the given output file, replacing it once complete.  Returns false
+	 * and sets err if the dictionary cannot be compiled.
+	 */
+	static bool compile
+	(
+		const QString& affPath,
+		const QString& dicPath,
+		const QString& outputPath,
+		QString& err
+	);
+
+	/**
+	 * Returns true if the header of a compiled dictionary of the given
+	 * size matches the current format, and the given affix and word files
+	 * as they are now.
+	 */
+	static bool isCurrent
+	(
+		const Header* header,
+		qint64 size,
+		const QString& affPath,
+		const QString& dicPath
+	);
+
+	/**
+	 * Returns the hash of the given UTF-8 word, from which its bucket and
+	 * slot are found.
+	 */
+	static quint64 hash(const char* word, int length);
+
+	/**
+	 * Returns the bucket of the word having the given hash.
+	 */
+	static quint32 bucket(quint64 hash, quint32 bucketCount);
+
+	/**
+	 * Returns the slot of the word having the given hash, given the
+	 * displacement of its bucket.
+	 */
+	static quint32 slot(quint64 hash, quint32 displacement, quint32 slotCount);
+
+private:
+	DictionaryCompiler();
+};
+
+#endif
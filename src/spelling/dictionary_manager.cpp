@@ -20,15 +20,19 @@
 #include "dictionary_manager.h"
 
 #ifndef Q_OS_MAC
-#include "dictionary_provider_hunspell.h"
+#include "dictionary_provider_compiled.h"
 #include "dictionary_provider_voikko.h"
 #else
 #include "dictionary_provider_nsspellchecker.h"
 #endif
 #include "dictionary_ref.h"
+#include "taskscheduler.h"
 
 #include <QDir>
 #include <QFile>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSet>
 #include <QTextStream>
 
 #include <algorithm>
@@ -58,6 +62,11 @@ public:
 		return true;
 	}
 
+	bool isThreadSafe() const
+	{
+		return true;
+	}
+
 	QStringRef check(const QString& string, int start_at) const
 	{
 		Q_UNUSED(string);
@@ -150,8 +159,10 @@ void DictionaryManager::addProviders()
 	bool has_hunspell = false;
 	bool has_voikko = false;
 
+	// Hunspell dictionaries are compiled for sharing between instances,
+	// and left to Hunspell itself where they cannot be.
 	foreach (AbstractDictionaryProvider* provider, m_providers) {
-		if (dynamic_cast<DictionaryProviderHunspell*>(provider) != NULL) {
+		if (dynamic_cast<DictionaryProviderCompiled*>(provider) != NULL) {
 			has_hunspell = true;
 		} else if (dynamic_cast<DictionaryProviderVoikko*>(provider) != NULL) {
 			has_voikko = true;
@@ -159,7 +170,7 @@ void DictionaryManager::addProviders()
 	}
 
 	if (!has_hunspell) {
-		addProvider(new DictionaryProviderHunspell);
+		addProvider(new DictionaryProviderCompiled);
 	}
 	if (!has_voikko) {
 		addProvider(new DictionaryProviderVoikko);
@@ -183,6 +194,8 @@ void DictionaryManager::addProviders()
 
 DictionaryRef DictionaryManager::requestDictionary(const QString& language)
 {
+	QWriteLocker locker(lock());
+
 	if (language.isEmpty()) {
 		// Fetch shared default dictionary
 		if (!m_default_dictionary) {
@@ -203,8 +216,10 @@ void DictionaryManager::setDefaultLanguage(const QString& language)
 		return;
 	}
 
+	QWriteLocker locker(lock());
 	m_default_language = language;
 	m_default_dictionary = *requestDictionaryData(m_default_language);
+	locker.unlock();
 
 	// Re-check documents
 	emit changed();
@@ -214,9 +229,11 @@ void DictionaryManager::setDefaultLanguage(const QString& language)
 
 void DictionaryManager::setIgnoreNumbers(bool ignore)
 {
+	QWriteLocker locker(lock());
 	foreach (AbstractDictionaryProvider* provider, m_providers) {
 		provider->setIgnoreNumbers(ignore);
 	}
+	locker.unlock();
 
 	// Re-check documents
 	emit changed();
@@ -226,9 +243,11 @@ void DictionaryManager::setIgnoreNumbers(bool ignore)
 
 void DictionaryManager::setIgnoreUppercase(bool ignore)
 {
+	QWriteLocker locker(lock());
 	foreach (AbstractDictionaryProvider* provider, m_providers) {
 		provider->setIgnoreUppercase(ignore);
 	}
+	locker.unlock();
 
 	// Re-check documents
 	emit changed();
@@ -236,6 +255,32 @@ void DictionaryManager::setIgnoreUppercase(bool ignore)
 
 //-----------------------------------------------------------------------------
 
+void DictionaryManager::releaseCaches()
+{
+	QReadLocker locker(lock());
+	foreach (AbstractDictionary* dictionary, m_dictionaries) {
+		dictionary->releaseCaches();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+QReadWriteLock* DictionaryManager::lock()
+{
+	static QReadWriteLock dictionary_lock(QReadWriteLock::Recursive);
+	return &dictionary_lock;
+}
+
+//-----------------------------------------------------------------------------
+
+QMutex* DictionaryManager::serialMutex()
+{
+	static QMutex serial_mutex;
+	return &serial_mutex;
+}
+
+//-----------------------------------------------------------------------------
+
 QString DictionaryManager::installedPath()
 {
 #ifndef Q_OS_MAC
@@ -263,29 +308,43 @@ void DictionaryManager::setPersonal(const QStringList& words)
 		return;
 	}
 
-	// Remove current personal dictionary
+	// Find the words that were added and removed, so that only those are
+	// updated in the dictionaries and rechecked in documents.
+	QSet<QString> old_words = QSet<QString>::fromList(m_personal);
+	QSet<QString> new_words = QSet<QString>::fromList(personal);
+	QStringList removed = (old_words - new_words).toList();
+	QStringList added = (new_words - old_words).toList();
+
+	QWriteLocker locker(lock());
+
 	foreach (AbstractDictionary* dictionary, m_dictionaries) {
-		dictionary->removeFromSession(m_personal);
+		if (!removed.isEmpty()) {
+			dictionary->removeFromSession(removed);
+		}
+		if (!added.isEmpty()) {
+			dictionary->addToSession(added);
+		}
 	}
 
-	// Update and store personal dictionary
+	// Update and store personal dictionary, appending to the file if
+	// words were only added.  The words are sorted again when loaded.
 	m_personal = personal;
 	QFile file(m_path + "/personal");
-	if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+	QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Text;
+	if (removed.isEmpty()) {
+		mode |= QIODevice::Append;
+	}
+	if (file.open(mode)) {
 		QTextStream stream(&file);
 		stream.setCodec("UTF-8");
-		foreach (const QString& word, m_personal) {
+		foreach (const QString& word, (removed.isEmpty() ? added : m_personal)) {
 			stream << word << "\n";
 		}
 	}
+	locker.unlock();
 
-	// Add personal dictionary
-	foreach (AbstractDictionary* dictionary, m_dictionaries) {
-		dictionary->addToSession(m_personal);
-	}
-
-	// Re-check documents
-	emit changed();
+	// Re-check the parts of documents containing the words
+	emit personalChanged(removed + added);
 }
 
 //-----------------------------------------------------------------------------
@@ -310,8 +369,16 @@ DictionaryManager::DictionaryManager()
 
 DictionaryManager::~DictionaryManager()
 {
+	foreach (QFutureWatcher<AbstractDictionary*>* watcher, m_loading) {
+		watcher->waitForFinished();
+		delete watcher->result();
+	}
+	m_loading.clear();
+
 	foreach (AbstractDictionary* dictionary, m_dictionaries) {
-		delete dictionary;
+		if (dictionary != *DictionaryFallback::instance()) {
+			delete dictionary;
+		}
 	}
 	m_dictionaries.clear();
 
@@ -336,24 +403,80 @@ void DictionaryManager::addProvider(AbstractDictionaryProvider* provider)
 AbstractDictionary** DictionaryManager::requestDictionaryData(const QString& language)
 {
 	if (!m_dictionaries.contains(language)) {
-		AbstractDictionary* dictionary = 0;
-		foreach (AbstractDictionaryProvider* provider, m_providers) {
-			dictionary = provider->requestDictionary(language);
-			if (dictionary && dictionary->isValid()) {
-				break;
-			} else {
-				delete dictionary;
-				dictionary = 0;
-			}
-		}
-
+#ifndef Q_OS_MAC
+		// Hold the slot with the fallback, which accepts every word, until
+		// the dictionary has loaded in the background.  References to the
+		// slot then see the real dictionary.
+		m_dictionaries[language] = *DictionaryFallback::instance();
+		loadDictionary(language);
+#else
+		// NSSpellChecker must be used from the main thread.
+		AbstractDictionary* dictionary = createDictionary(m_providers, language);
 		if (!dictionary) {
 			return DictionaryFallback::instance();
 		}
 		dictionary->addToSession(m_personal);
 		m_dictionaries[language] = dictionary;
+#endif
 	}
 	return &m_dictionaries[language];
 }
 
 //-----------------------------------------------------------------------------
+
+void DictionaryManager::loadDictionary(const QString& language)
+{
+	QFutureWatcher<AbstractDictionary*>* watcher = new QFutureWatcher<AbstractDictionary*>(this);
+	m_loading.insert(language, watcher);
+
+	connect(watcher, &QFutureWatcher<AbstractDictionary*>::finished, this, [this, language, watcher]() {
+		m_loading.remove(language);
+		dictionaryLoaded(language, watcher->result());
+		watcher->deleteLater();
+	});
+
+	QList<AbstractDictionaryProvider*> providers = m_providers;
+	watcher->setFuture(ghostwriter::TaskScheduler::instance()->run(ghostwriter::TaskScheduler::Interactive, [providers, language]() {
+		return createDictionary(providers, language);
+	}));
+}
+
+//-----------------------------------------------------------------------------
+
+void DictionaryManager::dictionaryLoaded(const QString& language, AbstractDictionary* dictionary)
+{
+	if (!dictionary) {
+		// Leave the fallback in place.
+		return;
+	}
+
+	QWriteLocker locker(lock());
+	dictionary->addToSession(m_personal);
+	m_dictionaries[language] = dictionary;
+	if (language == m_default_language) {
+		m_default_dictionary = dictionary;
+	}
+	locker.unlock();
+
+	// Re-check documents
+	emit changed();
+}
+
+//-----------------------------------------------------------------------------
+
+AbstractDictionary* DictionaryManager::createDictionary(const QList<AbstractDictionaryProvider*>& providers, const QString& language)
+{
+	AbstractDictionary* dictionary = 0;
+	foreach (AbstractDictionaryProvider* provider, providers) {
+		dictionary = provider->requestDictionary(language);
+		if (dictionary && dictionary->isValid()) {
+			break;
+		} else {
+			delete dictionary;
+			dictionary = 0;
+		}
+	}
+	return dictionary;
+}
+
+//-----------------------------------------------------------------------------
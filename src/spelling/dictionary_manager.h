@@ -23,7 +23,10 @@
 class AbstractDictionary;
 class AbstractDictionaryProvider;
 class DictionaryRef;
+class QMutex;
+class QReadWriteLock;
 
+#include <QFutureWatcher>
 #include <QHash>
 #include <QObject>
 #include <QStringList>
@@ -48,6 +51,19 @@ public:
 	void setIgnoreUppercase(bool ignore);
 	void setPersonal(const QStringList& words);
 
+	// Frees the results cached by the loaded dictionaries, such as when
+	// memory runs low.
+	void releaseCaches();
+
+	// Guards the dictionaries, which may be checked from several worker
+	// threads at once.  Checks hold it for reading, while changes to the
+	// dictionaries or to the word lists hold it for writing.  The lock is
+	// recursive.
+	static QReadWriteLock* lock();
+
+	// Serializes checks against dictionaries that are not thread-safe.
+	static QMutex* serialMutex();
+
 	static QString installedPath();
 	static QString path();
 	static void setPath(const QString& path);
@@ -55,16 +71,25 @@ public:
 signals:
 	void changed();
 
+	// Emitted instead of changed() when only the given words were added
+	// to or removed from the personal dictionary.
+	void personalChanged(const QStringList& words);
+
 private:
 	DictionaryManager();
 	~DictionaryManager();
 
 	void addProvider(AbstractDictionaryProvider* provider);
 	AbstractDictionary** requestDictionaryData(const QString& language);
+	void loadDictionary(const QString& language);
+	void dictionaryLoaded(const QString& language, AbstractDictionary* dictionary);
+
+	static AbstractDictionary* createDictionary(const QList<AbstractDictionaryProvider*>& providers, const QString& language);
 
 private:
 	QList<AbstractDictionaryProvider*> m_providers;
 	QHash<QString, AbstractDictionary*> m_dictionaries;
+	QHash<QString, QFutureWatcher<AbstractDictionary*>*> m_loading;
 	AbstractDictionary* m_default_dictionary;
 
 	QString m_default_language;
@@ -0,0 +1,581 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include "dictionary_provider_compiled.h"
+
+#include "abstract_dictionary.h"
+#include "dictionary_compiler.h"
+#include "dictionary_manager.h"
+#include "texttokenizer.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+
+static bool f_ignore_numbers = false;
+static bool f_ignore_uppercase = true;
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+
+// Deepest that a word is broken apart at the break patterns.
+const int MaxBreakDepth = 10;
+
+class DictionaryCompiled : public AbstractDictionary
+{
+public:
+	DictionaryCompiled(const QString& language,
+			const QString& path,
+			const QString& aff,
+			const QString& dic,
+			const DictionaryProviderHunspell* hunspell);
+	~DictionaryCompiled();
+
+	bool isValid() const
+	{
+		return m_header;
+	}
+
+	bool isThreadSafe() const
+	{
+		return true;
+	}
+
+	QStringRef check(const QString& string, int start_at) const;
+	QStringList suggestions(const QString& word) const;
+	bool cachedSuggestions(const QString& word, QStringList& suggestions) const;
+
+	void addToPersonal(const QString& word);
+	void addToSession(const QStringList& words);
+	void removeFromSession(const QStringList& words);
+
+	void releaseCaches();
+
+private:
+	enum Lookup
+	{
+		Missing,
+		Found,
+		FoundKeepCase,
+		Forbidden
+	};
+
+	Lookup lookup(const QString& word) const;
+	bool spell(const QString& word, int depth) const;
+	bool isCompound(const QString& word) const;
+	bool matchesRule(const QVector<quint32>& rule, int atom, const QString& word, int pos, int parts) const;
+	AbstractDictionary* hunspell() const;
+
+	static QString sanitized(const QString& word);
+	static bool isNumber(const QString& word);
+
+private:
+	QString m_language;
+	const DictionaryProviderHunspell* m_provider;
+
+	// The mapped dictionary, which is only read, so that it may be
+	// checked against from any thread without locking.
+	QFile m_file;
+	const DictionaryCompiler::Header* m_header;
+	const quint32* m_buckets;
+	const quint32* m_slots;
+	const uchar* m_pool;
+
+	qint32 m_compound_min;
+	QStringList m_breaks;
+	QList<QVector<quint32> > m_compound_rules;
+	QHash<QString, QVector<quint16> > m_compound_pieces;
+
+	// Words added and removed during the session, which are only changed
+	// while the manager's lock is held for writing.
+	QSet<QString> m_session;
+	QSet<QString> m_removed;
+	mutable QReadWriteLock m_session_lock;
+
+	// Hunspell, loaded only to search for suggestions.
+	mutable AbstractDictionary* m_hunspell;
+	mutable QMutex m_hunspell_mutex;
+};
+
+//-----------------------------------------------------------------------------
+
+DictionaryCompiled::DictionaryCompiled(const QString& language,
+		const QString& path,
+		const QString& aff,
+		const QString& dic,
+		const DictionaryProviderHunspell* hunspell) :
+	m_language(language),
+	m_provider(hunspell),
+	m_file(path),
+	m_header(0),
+	m_buckets(0),
+	m_slots(0),
+	m_pool(0),
+	m_compound_min(3),
+	m_hunspell(0)
+{
+	if (!m_file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+
+	qint64 size = m_file.size();
+	const uchar* data = (size >= (qint64) sizeof(DictionaryCompiler::Header)) ? m_file.map(0, size) : 0;
+	if (!data) {
+		m_file.close();
+		return;
+	}
+
+	const DictionaryCompiler::Header* header = (const DictionaryCompiler::Header*) data;
+	if (!DictionaryCompiler::isCurrent(header, size, aff, dic)) {
+		m_file.close();
+		return;
+	}
+
+	QDataStream stream(QByteArray::fromRawData((const char*) data + header->extrasOffset, header->extrasLength));
+	stream.setVersion(QDataStream::Qt_5_6);
+	stream >> m_compound_min >> m_breaks >> m_compound_rules >> m_compound_pieces;
+	if (stream.status() != QDataStream::Ok) {
+		m_file.close();
+		return;
+	}
+	m_compound_min = qMax(1, m_compound_min);
+
+	m_header = header;
+	m_buckets = (const quint32*) (data + header->bucketsOffset);
+	m_slots = (const quint32*) (data + header->slotsOffset);
+	m_pool = data + header->poolOffset;
+}
+
+//-----------------------------------------------------------------------------
+
+DictionaryCompiled::~DictionaryCompiled()
+{
+	delete m_hunspell;
+}
+
+//-----------------------------------------------------------------------------
+
+QStringRef DictionaryCompiled::check(const QString& string, int start_at) const
+{
+	// Words are split with ghostwriter's tokenizer, as for Hunspell.
+	ghostwriter::TextTokenizer::Word word;
+	int pos = start_at;
+
+	while (ghostwriter::TextTokenizer::nextWord(string, pos, word)) {
+		bool isNumber = f_ignore_numbers && word.hasNumber;
+		bool isUppercase = f_ignore_uppercase && !word.hasLowercase;
+
+		if (!isUppercase && !isNumber) {
+			QStringRef check(&string, word.position, word.length);
+
+			if (!spell(sanitized(check.toString()), 0)) {
+				return check;
+			}
+		}
+
+		pos = word.position + word.length;
+	}
+
+	return QStringRef();
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList DictionaryCompiled::suggestions(const QString& word) const
+{
+	QMutexLocker locker(&m_hunspell_mutex);
+	AbstractDictionary* dictionary = hunspell();
+	return dictionary ? dictionary->suggestions(word) : QStringList();
+}
+
+//-----------------------------------------------------------------------------
+
+bool DictionaryCompiled::cachedSuggestions(const QString& word, QStringList& suggestions) const
+{
+	// Don't wait for suggestions being searched for.
+	if (!m_hunspell_mutex.tryLock()) {
+		return false;
+	}
+	bool cached = m_hunspell && m_hunspell->cachedSuggestions(word, suggestions);
+	m_hunspell_mutex.unlock();
+	return cached;
+}
+
+//-----------------------------------------------------------------------------
+
+void DictionaryCompiled::addToPersonal(const QString& word)
+{
+	DictionaryManager::instance().add(sanitized(word));
+}
+
+//-----------------------------------------------------------------------------
+
+void DictionaryCompiled::addToSession(const QStringList& words)
+{
+	QWriteLocker locker(&m_session_lock);
+	foreach (const QString& word, words) {
+		m_session.insert(sanitized(word));
+		m_removed.remove(sanitized(word));
+	}
+	locker.unlock();
+
+	QMutexLocker hunspell_locker(&m_hunspell_mutex);
+	if (m_hunspell) {
+		m_hunspell->addToSession(words);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void DictionaryCompiled::removeFromSession(const QStringList& words)
+{
+	// As with Hunspell, removed words are incorrect from then on.
+	QWriteLocker locker(&m_session_lock);
+	foreach (const QString& word, words) {
+		m_session.remove(sanitized(word));
+		m_removed.insert(sanitized(word));
+	}
+	locker.unlock();
+
+	QMutexLocker hunspell_locker(&m_hunspell_mutex);
+	if (m_hunspell) {
+		m_hunspell->removeFromSession(words);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void DictionaryCompiled::releaseCaches()
+{
+	// Hunspell holds the uncompiled dictionary, and is loaded again once
+	// suggestions are next asked for.
+	QMutexLocker locker(&m_hunspell_mutex);
+	delete m_hunspell;
+	m_hunspell = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+DictionaryCompiled::Lookup DictionaryCompiled::lookup(const QString& word) const
+{
+	{
+		QReadLocker locker(&m_session_lock);
+		if (m_removed.contains(word)) {
+			return Forbidden;
+		}
+		if (m_session.contains(word)) {
+			return Found;
+		}
+	}
+
+	QByteArray utf8 = word.toUtf8();
+	if (utf8.isEmpty() || (utf8.size() > 255)) {
+		return Missing;
+	}
+
+	quint64 hash = DictionaryCompiler::hash(utf8.constData(), utf8.size());
+	quint32 displacement = m_buckets[DictionaryCompiler::bucket(hash, m_header->bucketCount)];
+	quint32 offset = m_slots[DictionaryCompiler::slot(hash, displacement, m_header->slotCount)];
+
+	// The slot holds the only word that could match.
+	if ((DictionaryCompiler::EmptySlot == offset)
+			|| ((quint64(offset) + 2 + utf8.size()) > m_header->poolSize)
+			|| (m_pool[offset] != utf8.size())
+			|| (0 != memcmp(m_pool + offset + 2, utf8.constData(), utf8.size()))) {
+		return Missing;
+	}
+
+	uchar entry = m_pool[offset + 1];
+	if (entry & DictionaryCompiler::EntryForbidden) {
+		return Forbidden;
+	}
+	return (entry & DictionaryCompiler::EntryKeepCase) ? FoundKeepCase : Found;
+}
+
+//-----------------------------------------------------------------------------
+
+bool DictionaryCompiled::spell(const QString& word, int depth) const
+{
+	if (word.isEmpty() || isNumber(word)) {
+		return true;
+	}
+
+	Lookup found = lookup(word);
+	if (Forbidden == found) {
+		return false;
+	} else if (Missing != found) {
+		return true;
+	} else if (isCompound(word)) {
+		return true;
+	}
+
+	// Capitalized words are also correct in lowercase, and uppercased words
+	// in lowercase or capitalized, unless their case is to be kept.
+	QString lower = word.toLower();
+	bool all_caps = (word == word.toUpper()) && (word != lower);
+	bool init_cap = !all_caps && word.at(0).isUpper() && (word.midRef(1) == lower.midRef(1));
+
+	if (all_caps || init_cap) {
+		QStringList forms(lower);
+		if (all_caps) {
+			QString capitalized = lower;
+			capitalized[0] = word.at(0);
+			forms.append(capitalized);
+		}
+
+		foreach (const QString& form, forms) {
+			Lookup found_form = lookup(form);
+			if (Forbidden == found_form) {
+				return false;
+			} else if ((Found == found_form) || isCompound(form)) {
+				return true;
+			}
+		}
+	}
+
+	// Words joined at break patterns, such as hyphens, are correct if their
+	// parts are.
+	if (depth >= MaxBreakDepth) {
+		return false;
+	}
+
+	foreach (const QString& pattern, m_breaks) {
+		if (pattern.startsWith(QChar('^'))) {
+			QString start = pattern.mid(1);
+			if (!start.isEmpty() && (word.size() > start.size()) && word.startsWith(start)
+					&& spell(word.mid(start.size()), depth + 1)) {
+				return true;
+			}
+		} else if (pattern.endsWith(QChar('$'))) {
+			QString end = pattern.left(pattern.size() - 1);
+			if (!end.isEmpty() && (word.size() > end.size()) && word.endsWith(end)
+					&& spell(word.left(word.size() - end.size()), depth + 1)) {
+				return true;
+			}
+		} else if (!pattern.isEmpty()) {
+			int index = word.indexOf(pattern);
+			if ((index > 0) && ((index + pattern.size()) < word.size())
+					&& spell(word.left(index), depth + 1)
+					&& spell(word.mid(index + pattern.size()), depth + 1)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+
+bool DictionaryCompiled::isCompound(const QString& word) const
+{
+	foreach (const QVector<quint32>& rule, m_compound_rules) {
+		if (matchesRule(rule, 0, word, 0, 0)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+
+bool DictionaryCompiled::matchesRule(const QVector<quint32>& rule, int atom, const QString& word, int pos, int parts) const
+{
+	if (atom == rule.size()) {
+		return (pos == word.size()) && (parts >= 2);
+	}
+
+	// Each atom of a rule is a flag, with the quantifier in the high bits:
+	// 1 for any number of pieces, 2 for an optional one.
+	quint16 flag = rule[atom] & 0xFFFF;
+	quint32 quantifier = rule[atom] >> 16;
+
+	if ((0 != quantifier) && matchesRule(rule, atom + 1, word, pos, parts)) {
+		return true;
+	}
+
+	for (int end = pos + m_compound_min; end <= word.size(); ++end) {
+		QHash<QString, QVector<quint16> >::const_iterator piece = m_compound_pieces.constFind(word.mid(pos, end - pos));
+		if ((piece == m_compound_pieces.constEnd()) || !piece->contains(flag)) {
+			continue;
+		}
+		if (matchesRule(rule, (1 == quantifier) ? atom : (atom + 1), word, end, parts + 1)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+
+AbstractDictionary* DictionaryCompiled::hunspell() const
+{
+	// Called with the Hunspell mutex held.
+	if (m_hunspell) {
+		return m_hunspell;
+	}
+
+	m_hunspell = m_provider->requestDictionary(m_language);
+	if (m_hunspell && !m_hunspell->isValid()) {
+		delete m_hunspell;
+		m_hunspell = 0;
+	}
+
+	if (m_hunspell) {
+		QReadLocker locker(&m_session_lock);
+		m_hunspell->addToSession(m_session.values());
+		m_hunspell->removeFromSession(m_removed.values());
+	}
+
+	return m_hunspell;
+}
+
+//-----------------------------------------------------------------------------
+
+QString DictionaryCompiled::sanitized(const QString& word)
+{
+	// Replace any fancy single quotes with a "normal" single quote.
+	QString result = word;
+	result.replace(QChar(0x2019), QLatin1Char('\''));
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+bool DictionaryCompiled::isNumber(const QString& word)
+{
+	// Digits, which may be separated by single periods, commas or dashes.
+	bool after_digit = false;
+
+	for (int i = 0; i < word.size(); ++i) {
+		QChar c = word.at(i);
+		if (c.isDigit()) {
+			after_digit = true;
+		} else if (after_digit && ((c == QChar('.')) || (c == QChar(',')) || (c == QChar('-')))) {
+			after_digit = false;
+		} else {
+			return false;
+		}
+	}
+
+	return after_digit;
+}
+
+}
+
+//-----------------------------------------------------------------------------
+
+DictionaryProviderCompiled::DictionaryProviderCompiled()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList DictionaryProviderCompiled::availableDictionaries() const
+{
+	return m_hunspell.availableDictionaries();
+}
+
+//-----------------------------------------------------------------------------
+
+AbstractDictionary* DictionaryProviderCompiled::requestDictionary(const QString& language) const
+{
+	// Dictionaries compressed with hzip are left to Hunspell.
+	QString aff = QFileInfo("dict:" + language + ".aff").canonicalFilePath();
+	QString dic = QFileInfo("dict:" + language + ".dic").canonicalFilePath();
+	if (language.isEmpty() || aff.isEmpty() || dic.isEmpty()) {
+		return m_hunspell.requestDictionary(language);
+	}
+
+	QString path = compiledPath(language);
+	DictionaryCompiled* dictionary = new DictionaryCompiled(language, path, aff, dic, &m_hunspell);
+	if (dictionary->isValid()) {
+		return dictionary;
+	}
+	delete dictionary;
+
+	// Remember the dictionaries that were refused until their files change,
+	// rather than reading them again on each launch.
+	QFileInfo refused(path + ".refused");
+	if (refused.exists()
+			&& (refused.lastModified() >= QFileInfo(aff).lastModified())
+			&& (refused.lastModified() >= QFileInfo(dic).lastModified())) {
+		return m_hunspell.requestDictionary(language);
+	}
+
+	QString err;
+	if (!DictionaryCompiler::compile(aff, dic, path, err)) {
+		QDir().mkpath(refused.path());
+		QFile marker(refused.filePath());
+		if (marker.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			marker.write(err.toUtf8());
+		}
+		return m_hunspell.requestDictionary(language);
+	}
+
+	dictionary = new DictionaryCompiled(language, path, aff, dic, &m_hunspell);
+	if (!dictionary->isValid()) {
+		delete dictionary;
+		return m_hunspell.requestDictionary(language);
+	}
+	return dictionary;
+}
+
+//-----------------------------------------------------------------------------
+
+void DictionaryProviderCompiled::setIgnoreNumbers(bool ignore)
+{
+	f_ignore_numbers = ignore;
+	m_hunspell.setIgnoreNumbers(ignore);
+}
+
+//-----------------------------------------------------------------------------
+
+void DictionaryProviderCompiled::setIgnoreUppercase(bool ignore)
+{
+	f_ignore_uppercase = ignore;
+	m_hunspell.setIgnoreUppercase(ignore);
+}
+
+//-----------------------------------------------------------------------------
+
+QString DictionaryProviderCompiled::compiledPath(const QString& language)
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+		+ "/dictionaries/" + language + ".gwdic";
+}
+
+//-----------------------------------------------------------------------------
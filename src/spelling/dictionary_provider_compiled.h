@@ -0,0 +1,66 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef DICTIONARY_PROVIDER_COMPILED_H
+#define DICTIONARY_PROVIDER_COMPILED_H
+
+#include "abstract_dictionary_provider.h"
+#include "dictionary_provider_hunspell.h"
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * Provides the Hunspell dictionaries compiled by DictionaryCompiler into
+ * the cache directory, where they are compiled the first time they are
+ * requested, and again whenever their files change.  Compiled
+ * dictionaries are memory mapped read-only, so that every running
+ * instance shares the same pages, and load without parsing.
+ *
+ * Words are checked against the compiled dictionary alone.  Hunspell
+ * itself is only loaded once suggestions are asked for, and released
+ * along with the caches.  Dictionaries that cannot be compiled are
+ * provided by Hunspell, as before.
+ */
+class DictionaryProviderCompiled : public AbstractDictionaryProvider
+{
+public:
+	DictionaryProviderCompiled();
+
+	bool isValid() const
+	{
+		return true;
+	}
+
+	QStringList availableDictionaries() const;
+	AbstractDictionary* requestDictionary(const QString& language) const;
+
+	void setIgnoreNumbers(bool ignore);
+	void setIgnoreUppercase(bool ignore);
+
+	/**
+	 * Returns the path of the compiled dictionary of the given language.
+	 */
+	static QString compiledPath(const QString& language);
+
+private:
+	DictionaryProviderHunspell m_hunspell;
+};
+
+#endif
@@ -22,14 +22,20 @@
 
 #include "abstract_dictionary.h"
 #include "dictionary_manager.h"
+#include "texttokenizer.h"
 
+#include <QCache>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QListIterator>
+#include <QMutex>
+#include <QReadWriteLock>
 #include <QRegExp>
 #include <QStringList>
 #include <QTextCodec>
+#include <QVarLengthArray>
 
 #ifdef _WIN32
 #include "3rdparty/hunspell/hunspell.hxx"
@@ -58,23 +64,72 @@ public:
 		return m_dictionary;
 	}
 
+	bool isThreadSafe() const
+	{
+		return true;
+	}
+
 	QStringRef check(const QString& string, int start_at) const;
 	QStringList suggestions(const QString& word) const;
+	bool cachedSuggestions(const QString& word, QStringList& suggestions) const;
 
 	void addToPersonal(const QString& word);
 	void addToSession(const QStringList& words);
 	void removeFromSession(const QStringList& words);
 
+	void releaseCaches();
+
+private:
+	typedef QVarLengthArray<char, 128> Buffer;
+
+	bool spell(const QStringRef& word) const;
+	void encode(const QString& word, Buffer& buffer) const;
+	QString decode(const char* text) const;
+
 private:
 	Hunspell* m_dictionary;
 	QTextCodec* m_codec;
+
+	// How words are converted to and from the dictionary's encoding:
+	// directly for UTF-8, through lookup tables for single-byte encodings,
+	// or with the general codec otherwise.
+	enum Encoding
+	{
+		EncodingUtf8,
+		EncodingTable,
+		EncodingCodec
+	};
+	Encoding m_encoding;
+	QHash<ushort, char> m_encode_table;
+	QChar m_decode_table[256];
+
+	// Verdicts of recent spell() calls, since the same words are checked
+	// over and over as blocks are rehighlighted.  Cleared when the word
+	// lists change, or when it grows beyond its maximum size.
+	mutable QHash<QString, bool> m_verdicts;
+	static const int MaxVerdicts = 20000;
+
+	// Words are split and looked up in the verdicts concurrently, and only
+	// calls into the Hunspell handle are serialized.  The word lists are
+	// only changed while the manager's lock is held for writing.
+	mutable QReadWriteLock m_verdicts_lock;
+	mutable QMutex m_handle_mutex;
+
+	// Suggestions of the most recently used words, since searching for
+	// them is slow, and they are searched for ahead of time for the
+	// misspellings in view.  Cleared when the word lists change.
+	mutable QCache<QString, QStringList> m_suggestions;
+	mutable QMutex m_suggestions_mutex;
+	static const int MaxSuggestions = 500;
 };
 
 //-----------------------------------------------------------------------------
 
 DictionaryHunspell::DictionaryHunspell(const QString& language) :
 	m_dictionary(0),
-	m_codec(0)
+	m_codec(0),
+	m_encoding(EncodingCodec),
+	m_suggestions(MaxSuggestions)
 {
 	// Find dictionary files
     QString aff = QFileInfo("dict:" + language + ".aff").canonicalFilePath();
@@ -102,6 +157,27 @@ DictionaryHunspell::DictionaryHunspell(const QString& language) :
 	if (!m_codec) {
 		delete m_dictionary;
 		m_dictionary = 0;
+		return;
+	}
+
+	// Pick the fastest conversion for the encoding.  An encoding is used
+	// through the tables if every byte round-trips to a single character.
+	if (m_codec->mibEnum() == 106) {
+		m_encoding = EncodingUtf8;
+	} else {
+		m_encoding = EncodingTable;
+		m_decode_table[0] = QChar(0);
+		for (int i = 1; i < 256; ++i) {
+			QByteArray byte(1, char(i));
+			QString decoded = m_codec->toUnicode(byte);
+			if ((decoded.size() != 1) || (m_codec->fromUnicode(decoded) != byte)) {
+				m_encoding = EncodingCodec;
+				m_encode_table.clear();
+				break;
+			}
+			m_decode_table[i] = decoded.at(0);
+			m_encode_table.insert(decoded.at(0).unicode(), char(i));
+		}
 	}
 }
 
@@ -116,155 +192,193 @@ DictionaryHunspell::~DictionaryHunspell()
 
 QStringRef DictionaryHunspell::check(const QString& string, int start_at) const
 {
-    // Incorporated ghostwriter's word splitting algorithm into the original
-    // FocusWriter algorithm to ensure hyphenated words are counted as one
-    // word.
-
-    bool inWord = false;
-    int separatorCount = 0;
-    int wordLen = 0;
-    bool isNumber = false;
-    bool isUppercase = f_ignore_uppercase;
-    bool isWord = false;
-    int index = -1;
-
-    for (int i = start_at; i < string.length(); i++)
-    {
-        QChar c = string.at(i);
-
-        if (c.isLetterOrNumber() || c.isMark())
-        {
-            inWord = true;
-            separatorCount = 0;
-            wordLen++;
-
-            if (index < 0)
-            {
-                index = i;
-            }
-
-            if (c.isNumber())
-            {
-                isNumber = f_ignore_numbers;
-            }
-            else if (c.isLower())
-            {
-                isUppercase = false;
-            }
-        }
-        else if (c.isSpace() && inWord)
-        {
-            inWord = false;
-            isWord = true;
-
-            if (separatorCount > 0)
-            {
-                wordLen--;
-            }
-        }
-        else
-        {
-            // This is to handle things like double dashes (`--`)
-            // that separate words, while still counting hyphenated
-            // words as a single word.
-            //
-            separatorCount++;
-
-            if (inWord)
-            {
-                // Only count dashes (`-`), periods (`.`) and single
-                // quotation marks (`'`) as separators that can be
-                // used inside a single word.
-                //
-                if
-                (
-                    (1 == separatorCount) &&
-                    (QChar('-') != c) &&
-                    (QChar('.') != c) &&
-                    (QChar('\'') != c)
-                )
-                {
-                    separatorCount = 0;
-                    inWord = false;
-                    isWord = true;
-                }
-                else if (separatorCount > 1)
-                {
-                    separatorCount = 0;
-                    inWord = false;
-                    isWord = true;
-                    wordLen--;
-                }
-                else
-                {
-                    wordLen++;
-                }
-            }
-        }
-
-        if (inWord && ((string.length() - 1) == i))
-        {
-            isWord = true;
-
-            if (separatorCount > 0)
-            {
-                wordLen--;
-            }
-        }
-
-        if (isWord && (index >= 0))
-        {
-            if (!isUppercase && !isNumber)
-            {
-                QStringRef check(&string, index, wordLen);
-                QString word = check.toString();
-
-                // Replace any fancy single quotes with a "normal" single quote.
-                word.replace(QChar(0x2019), QLatin1Char('\''));
-
-                if (!m_dictionary->spell(m_codec->fromUnicode(word).constData()))
-                {
-                    return check;
-                }
-            }
-
-            index = -1;
-            wordLen = 0;
-            separatorCount = 0;
-            isWord = false;
-            inWord = false;
-            isNumber = false;
-            isUppercase = f_ignore_uppercase;
-        }
-    }
+	// Words are split with ghostwriter's tokenizer, which counts hyphenated
+	// words as one word like the document statistics do.
+	ghostwriter::TextTokenizer::Word word;
+	int pos = start_at;
+
+	while (ghostwriter::TextTokenizer::nextWord(string, pos, word)) {
+		bool isNumber = f_ignore_numbers && word.hasNumber;
+		bool isUppercase = f_ignore_uppercase && !word.hasLowercase;
+
+		if (!isUppercase && !isNumber) {
+			QStringRef check(&string, word.position, word.length);
+
+			if (!spell(check)) {
+				return check;
+			}
+		}
+
+		pos = word.position + word.length;
+	}
 
 	return QStringRef();
 }
 
 //-----------------------------------------------------------------------------
 
+bool DictionaryHunspell::spell(const QStringRef& check) const
+{
+	QString word = check.toString();
+
+	{
+		QReadLocker locker(&m_verdicts_lock);
+		QHash<QString, bool>::const_iterator verdict = m_verdicts.constFind(word);
+		if (verdict != m_verdicts.constEnd()) {
+			return verdict.value();
+		}
+	}
+
+	// Replace any fancy single quotes with a "normal" single quote.
+	QString sanitized = word;
+	if (sanitized.contains(QChar(0x2019))) {
+		sanitized.replace(QChar(0x2019), QLatin1Char('\''));
+	}
+
+	Buffer encoded;
+	encode(sanitized, encoded);
+	QMutexLocker handle_locker(&m_handle_mutex);
+	bool correct = m_dictionary->spell(encoded.constData());
+	handle_locker.unlock();
+
+	QWriteLocker locker(&m_verdicts_lock);
+	if (m_verdicts.size() >= MaxVerdicts) {
+		m_verdicts.clear();
+	}
+	m_verdicts.insert(word, correct);
+
+	return correct;
+}
+
+//-----------------------------------------------------------------------------
+
 QStringList DictionaryHunspell::suggestions(const QString& word) const
 {
 	QStringList result;
+
+	if (cachedSuggestions(word, result)) {
+		return result;
+	}
+
 	QString check = word;
 
     // Replace any fancy single quotes with a "normal" single quote.
 	check.replace(QChar(0x2019), QLatin1Char('\''));
 
+	Buffer encoded;
+	encode(check, encoded);
+
+	QMutexLocker handle_locker(&m_handle_mutex);
 	char** suggestions = 0;
-	int count = m_dictionary->suggest(&suggestions, m_codec->fromUnicode(check).constData());
+	int count = m_dictionary->suggest(&suggestions, encoded.constData());
 	if (suggestions != 0) {
 		for (int i = 0; i < count; ++i) {
-            QString word = m_codec->toUnicode(suggestions[i]);
-			result.append(word);
+			result.append(decode(suggestions[i]));
 		}
 		m_dictionary->free_list(&suggestions, count);
 	}
+	handle_locker.unlock();
+
+	QMutexLocker suggestions_locker(&m_suggestions_mutex);
+	m_suggestions.insert(word, new QStringList(result));
 	return result;
 }
 
 //-----------------------------------------------------------------------------
 
+bool DictionaryHunspell::cachedSuggestions(const QString& word, QStringList& suggestions) const
+{
+	QMutexLocker locker(&m_suggestions_mutex);
+	QStringList* cached = m_suggestions.object(word);
+	if (!cached) {
+		return false;
+	}
+	suggestions = *cached;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void DictionaryHunspell::encode(const QString& word, Buffer& buffer) const
+{
+	buffer.clear();
+
+	switch (m_encoding) {
+	case EncodingUtf8:
+		for (int i = 0; i < word.size(); ++i) {
+			uint c = word.at(i).unicode();
+			if (QChar::isHighSurrogate(c) && ((i + 1) < word.size()) && word.at(i + 1).isLowSurrogate()) {
+				c = QChar::surrogateToUcs4(ushort(c), word.at(i + 1).unicode());
+				++i;
+			}
+
+			if (c < 0x80) {
+				buffer.append(char(c));
+			} else if (c < 0x800) {
+				buffer.append(char(0xC0 | (c >> 6)));
+				buffer.append(char(0x80 | (c & 0x3F)));
+			} else if (c < 0x10000) {
+				buffer.append(char(0xE0 | (c >> 12)));
+				buffer.append(char(0x80 | ((c >> 6) & 0x3F)));
+				buffer.append(char(0x80 | (c & 0x3F)));
+			} else {
+				buffer.append(char(0xF0 | (c >> 18)));
+				buffer.append(char(0x80 | ((c >> 12) & 0x3F)));
+				buffer.append(char(0x80 | ((c >> 6) & 0x3F)));
+				buffer.append(char(0x80 | (c & 0x3F)));
+			}
+		}
+		buffer.append('\0');
+		return;
+	case EncodingTable:
+		for (int i = 0; i < word.size(); ++i) {
+			QHash<ushort, char>::const_iterator byte = m_encode_table.constFind(word.at(i).unicode());
+			if (byte == m_encode_table.constEnd()) {
+				// Not representable in the table, so let the codec decide
+				// how to substitute the character.
+				buffer.clear();
+				break;
+			}
+			buffer.append(byte.value());
+		}
+		if (buffer.size() == word.size()) {
+			buffer.append('\0');
+			return;
+		}
+		break;
+	case EncodingCodec:
+		break;
+	}
+
+	QByteArray encoded = m_codec->fromUnicode(word);
+	buffer.clear();
+	buffer.append(encoded.constData(), encoded.size() + 1);
+}
+
+//-----------------------------------------------------------------------------
+
+QString DictionaryHunspell::decode(const char* text) const
+{
+	switch (m_encoding) {
+	case EncodingUtf8:
+		return QString::fromUtf8(text);
+	case EncodingTable:
+	{
+		QString result;
+		for (const unsigned char* c = reinterpret_cast<const unsigned char*>(text); *c; ++c) {
+			result.append(m_decode_table[*c]);
+		}
+		return result;
+	}
+	case EncodingCodec:
+		break;
+	}
+
+	return m_codec->toUnicode(text);
+}
+
+//-----------------------------------------------------------------------------
+
 void DictionaryHunspell::addToPersonal(const QString& word)
 {
     // Replace any fancy single quotes with a "normal" single quote.
@@ -276,8 +390,22 @@ void DictionaryHunspell::addToPersonal(const QString& word)
 
 //-----------------------------------------------------------------------------
 
+void DictionaryHunspell::releaseCaches()
+{
+	QWriteLocker locker(&m_verdicts_lock);
+	m_verdicts = QHash<QString, bool>();
+	locker.unlock();
+
+	QMutexLocker suggestions_locker(&m_suggestions_mutex);
+	m_suggestions.clear();
+}
+
+//-----------------------------------------------------------------------------
+
 void DictionaryHunspell::addToSession(const QStringList& words)
 {
+	m_verdicts.clear();
+	m_suggestions.clear();
 	foreach (const QString& word, words) {
 #ifdef _WIN32
 		m_dictionary->add(m_codec->fromUnicode(word).constData());
@@ -291,6 +419,8 @@ void DictionaryHunspell::addToSession(const QStringList& words)
 
 void DictionaryHunspell::removeFromSession(const QStringList& words)
 {
+	m_verdicts.clear();
+	m_suggestions.clear();
 	foreach (const QString& word, words) {
 #ifdef _WIN32
 		m_dictionary->remove(m_codec->fromUnicode(word).constData());
@@ -331,8 +461,18 @@ DictionaryProviderHunspell::DictionaryProviderHunspell()
 
 QStringList DictionaryProviderHunspell::availableDictionaries() const
 {
-	QStringList result;
+	// Adding or removing files changes the modification time of their
+	// directory, so the cached list is current as long as no time changed.
 	QStringList locations = QDir::searchPaths("dict");
+	QList<QDateTime> times;
+	foreach (const QString& location, locations) {
+		times.append(QFileInfo(location).lastModified());
+	}
+	if ((locations == m_scanned_locations) && (times == m_scanned_times)) {
+		return m_available;
+	}
+
+	QStringList result;
 	QListIterator<QString> i(locations);
 	while (i.hasNext()) {
 		QDir dir(i.next());
@@ -348,6 +488,9 @@ QStringList DictionaryProviderHunspell::availableDictionaries() const
 			}
 		}
 	}
+	m_available = result;
+	m_scanned_locations = locations;
+	m_scanned_times = times;
 	return result;
 }
 
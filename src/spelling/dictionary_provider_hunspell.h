@@ -22,8 +22,9 @@
 
 #include "abstract_dictionary_provider.h"
 
-class QString;
-class QStringList;
+#include <QDateTime>
+#include <QList>
+#include <QStringList>
 
 class DictionaryProviderHunspell : public AbstractDictionaryProvider
 {
@@ -40,6 +41,14 @@ public:
 
 	void setIgnoreNumbers(bool ignore);
 	void setIgnoreUppercase(bool ignore);
+
+private:
+	// Dictionaries found in the search paths, along with the paths and
+	// their modification times when they were scanned.  The paths are
+	// scanned again only once one of them changes.
+	mutable QStringList m_available;
+	mutable QStringList m_scanned_locations;
+	mutable QList<QDateTime> m_scanned_times;
 };
 
 #endif
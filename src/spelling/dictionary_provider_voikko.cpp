@@ -22,6 +22,7 @@
 
 #include "abstract_dictionary.h"
 #include "dictionary_manager.h"
+#include "texttokenizer.h"
 
 #include <QDir>
 #include <QFile>
@@ -128,38 +129,17 @@ DictionaryVoikko::~DictionaryVoikko()
 
 QStringRef DictionaryVoikko::check(const QString& string, int start_at) const
 {
-	int index = -1;
-	int length = 0;
-	int chars = 1;
-	bool is_word = false;
-
-	int count = string.length() - 1;
-	for (int i = start_at; i <= count; ++i) {
-		QChar c = string.at(i);
-		if (c.isLetterOrNumber() || c.category() == QChar::Punctuation_Dash) {
-			if (index == -1) {
-				index = i;
-				chars = 1;
-				length = 0;
-			}
-			length += chars;
-			chars = 1;
-		} else if (c != 0x2019 && c != 0x0027) {
-			if (index != -1) {
-				is_word = true;
-			}
-		} else {
-			chars++;
-		}
-
-		if (is_word || (i == count && index != -1)) {
-			QStringRef check(&string, index, length);
-			if (voikkoSpellCstr(m_handle, check.toString().toUtf8().constData()) != VOIKKO_SPELL_OK) {
-				return check;
-			}
-			index = -1;
-			is_word = false;
+	// Numbers and uppercase words are ignored by voikko itself, according
+	// to the options set on the handle.
+	ghostwriter::TextTokenizer::Word word;
+	int pos = start_at;
+
+	while (ghostwriter::TextTokenizer::nextWord(string, pos, word)) {
+		QStringRef check(&string, word.position, word.length);
+		if (voikkoSpellCstr(m_handle, check.toString().toUtf8().constData()) != VOIKKO_SPELL_OK) {
+			return check;
 		}
+		pos = word.position + word.length;
 	}
 
 	return QStringRef();
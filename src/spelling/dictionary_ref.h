@@ -21,8 +21,10 @@
 #define DICTIONARY_REF_H
 
 #include "abstract_dictionary.h"
-class DictionaryManager;
+#include "dictionary_manager.h"
 
+#include <QMutexLocker>
+#include <QReadWriteLock>
 #include <QStringList>
 #include <QStringRef>
 
@@ -31,16 +33,27 @@ class DictionaryRef
 public:
 	QStringRef check(const QString& string, int start_at) const
 	{
+		QReadLocker locker(DictionaryManager::lock());
+		QMutexLocker serial_locker((*d)->isThreadSafe() ? 0 : DictionaryManager::serialMutex());
 		return (*d)->check(string, start_at);
 	}
 
 	QStringList suggestions(const QString& word) const
 	{
+		QReadLocker locker(DictionaryManager::lock());
+		QMutexLocker serial_locker((*d)->isThreadSafe() ? 0 : DictionaryManager::serialMutex());
 		return (*d)->suggestions(word);
 	}
 
+	bool cachedSuggestions(const QString& word, QStringList& suggestions) const
+	{
+		QReadLocker locker(DictionaryManager::lock());
+		return (*d)->cachedSuggestions(word, suggestions);
+	}
+
 	void addToPersonal(const QString& word)
 	{
+		QWriteLocker locker(DictionaryManager::lock());
 		(*d)->addToPersonal(word);
 	}
 
@@ -21,6 +21,7 @@
 #include "spell_checker.h"
 
 #include "dictionary_ref.h"
+#include "markdownhighlighter.h"
 
 #include <QAction>
 #include <QDialogButtonBox>
@@ -36,11 +37,12 @@
 #include <QTextBlock>
 #include <QPlainTextEdit>
 #include <QTextEdit>
-#include <QSyntaxHighlighter>
+
+#include <algorithm>
 
 //-----------------------------------------------------------------------------
 
-void SpellChecker::checkDocument(QPlainTextEdit* document, QSyntaxHighlighter* spelling_highlighter, DictionaryRef& dictionary)
+void SpellChecker::checkDocument(QPlainTextEdit* document, ghostwriter::MarkdownHighlighter* spelling_highlighter, DictionaryRef& dictionary)
 {
     SpellChecker* checker = new SpellChecker(document, spelling_highlighter, dictionary);
 	checker->m_start_cursor = document->textCursor();
@@ -72,13 +74,9 @@ void SpellChecker::suggestionChanged(QListWidgetItem* suggestion)
 
 void SpellChecker::add()
 {
+    // The dictionary manager rechecks the blocks containing the word.
     m_dictionary.addToPersonal(m_word);
 
-    if (nullptr != m_spelling_highlighter)
-    {
-        m_spelling_highlighter->rehighlight();
-    }
-
 	ignore();
 }
 
@@ -111,6 +109,11 @@ void SpellChecker::changeAll()
 {
 	QString replacement = m_suggestion->text();
 
+	// Replace every occurrence as a single edit, so that the document is
+	// laid out and highlighted once and the change is undone in one step.
+	QTextCursor edit_cursor = m_cursor;
+	edit_cursor.beginEditBlock();
+
 	QTextCursor cursor = m_cursor;
 	cursor.movePosition(QTextCursor::Start);
 	forever {
@@ -122,12 +125,14 @@ void SpellChecker::changeAll()
 		}
 	}
 
+	edit_cursor.endEditBlock();
+
 	check();
 }
 
 //-----------------------------------------------------------------------------
 
-SpellChecker::SpellChecker(QPlainTextEdit* document, QSyntaxHighlighter* spelling_highlighter, DictionaryRef& dictionary) :
+SpellChecker::SpellChecker(QPlainTextEdit* document, ghostwriter::MarkdownHighlighter* spelling_highlighter, DictionaryRef& dictionary) :
 	QDialog(document->parentWidget(), Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint),
 	m_dictionary(dictionary),
 	m_document(document),
@@ -217,8 +222,9 @@ void SpellChecker::check()
 
 		// Check current line
 		QTextBlock block = m_cursor.block();
-		QStringRef word =  m_dictionary.check(block.text(), m_cursor.position() - block.position());
-		if (word.isNull()) {
+		int word_position = -1;
+		int word_length = 0;
+		if (!findMisspelling(block, m_cursor.position() - block.position(), word_position, word_length)) {
 			if (block.next().isValid()) {
                 m_cursor.movePosition(QTextCursor::NextBlock);
 				++m_checked_blocks;
@@ -245,8 +251,8 @@ void SpellChecker::check()
 		}
 
 		// Select misspelled word
-		m_cursor.setPosition(word.position() + block.position());
-		m_cursor.setPosition(m_cursor.position() + word.length(), QTextCursor::KeepAnchor);
+		m_cursor.setPosition(word_position + block.position());
+		m_cursor.setPosition(m_cursor.position() + word_length, QTextCursor::KeepAnchor);
 		m_word = m_cursor.selectedText();
 
 		if (!m_ignored.contains(m_word)) {
@@ -270,7 +276,9 @@ void SpellChecker::check()
 			// Show suggestions
 			m_suggestion->clear();
 			m_suggestions->clear();
-			QStringList words = m_dictionary.suggestions(m_word);
+			QStringList words = m_spelling_highlighter
+				? m_spelling_highlighter->dictionary(m_cursor.block()).suggestions(m_word)
+				: m_dictionary.suggestions(m_word);
 			if (!words.isEmpty()) {
 				foreach (const QString& word, words) {
 					m_suggestions->addItem(word);
@@ -294,3 +302,31 @@ void SpellChecker::check()
 }
 
 //-----------------------------------------------------------------------------
+
+bool SpellChecker::findMisspelling(const QTextBlock& block, int start_at, int& position, int& length) const
+{
+	// Use the misspellings found by the highlighter's background spell
+	// check when they are current, and only check the block otherwise.
+	QVector<QPair<int, int>> misspellings;
+	if (m_spelling_highlighter && m_spelling_highlighter->misspellings(block, misspellings)) {
+		QVector<QPair<int, int>>::const_iterator i = std::lower_bound(misspellings.constBegin(), misspellings.constEnd(),
+				qMakePair(start_at, 0));
+		if (i == misspellings.constEnd()) {
+			return false;
+		}
+		position = i->first;
+		length = i->second;
+		return true;
+	}
+
+	QString text = block.text();
+	QStringRef word = m_dictionary.check(text, start_at);
+	if (word.isNull()) {
+		return false;
+	}
+	position = word.position();
+	length = word.length();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
@@ -30,15 +30,20 @@ class QLineEdit;
 class QListWidget;
 class QListWidgetItem;
 class QPlainTextEdit;
+class QTextBlock;
 class QTextEdit;
-class QSyntaxHighlighter;
+
+namespace ghostwriter
+{
+class MarkdownHighlighter;
+}
 
 class SpellChecker : public QDialog
 {
 	Q_OBJECT
 
 public:
-    static void checkDocument(QPlainTextEdit* document, QSyntaxHighlighter* spelling_highlighter, DictionaryRef& dictionary);
+    static void checkDocument(QPlainTextEdit* document, ghostwriter::MarkdownHighlighter* spelling_highlighter, DictionaryRef& dictionary);
 
 public slots:
 	virtual void reject();
@@ -52,14 +57,15 @@ private slots:
 	void changeAll();
 
 private:
-    SpellChecker(QPlainTextEdit* document, QSyntaxHighlighter* spelling_highlighter, DictionaryRef& dictionary);
+    SpellChecker(QPlainTextEdit* document, ghostwriter::MarkdownHighlighter* spelling_highlighter, DictionaryRef& dictionary);
 	void check();
+	bool findMisspelling(const QTextBlock& block, int start_at, int& position, int& length) const;
 
 private:
 	DictionaryRef& m_dictionary;
 
     QPlainTextEdit* m_document;
-    QSyntaxHighlighter* m_spelling_highlighter;
+    ghostwriter::MarkdownHighlighter* m_spelling_highlighter;
     QTextEdit* m_context;
 	QLineEdit* m_suggestion;
 	QListWidget* m_suggestions;
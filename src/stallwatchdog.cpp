@@ -0,0 +1,272 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QThread>
+
+#include "stallwatchdog.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+/**
+ * Checks the heartbeat of the main thread at every heartbeat interval,
+ * writing a report the first time it finds it silent for too long.
+ */
+class StallWatcherThread : public QThread
+{
+public:
+    StallWatcherThread(StallWatchdog *watchdog)
+        : watchdog(watchdog), stopping(false)
+    {
+        ;
+    }
+
+    void stop()
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        condition.wakeAll();
+    }
+
+protected:
+    void run()
+    {
+        qint64 reportedHeartbeat = -1;
+        qint64 silentSinceTrace = -1;
+        qint64 previousHeartbeat = -1;
+
+        QMutexLocker locker(&mutex);
+
+        while (!stopping) {
+            condition.wait(&mutex, StallWatchdog::HeartbeatInterval);
+
+            if (stopping) {
+                break;
+            }
+
+            qint64 heartbeat = watchdog->lastHeartbeat.loadAcquire();
+            qint64 silence = watchdog->clock.elapsed() - heartbeat;
+
+            // Remember when the main thread went silent on the trace
+            // clock, so that the report can list the work done since.
+            if (heartbeat != previousHeartbeat) {
+                previousHeartbeat = heartbeat;
+                silentSinceTrace = Tracer::isEnabled() ? Tracer::now() : -1;
+            }
+
+            if
+            (
+                (silence >= StallWatchdog::StallThreshold)
+                && (heartbeat != reportedHeartbeat)
+            ) {
+                reportedHeartbeat = heartbeat;
+                watchdog->writeReport(silence, silentSinceTrace);
+            }
+        }
+    }
+
+private:
+    StallWatchdog *watchdog;
+    QMutex mutex;
+    QWaitCondition condition;
+    bool stopping;
+};
+
+StallWatchdog::StallWatchdog(QObject *parent)
+    : QObject(parent),
+      watcher(nullptr),
+      lastHeartbeat(0),
+      documentSize(0)
+{
+    clock.start();
+
+    heartbeatTimer = new QTimer(this);
+    heartbeatTimer->setInterval(HeartbeatInterval);
+
+    this->connect
+    (
+        heartbeatTimer,
+        &QTimer::timeout,
+        [this]() {
+            beat();
+        }
+    );
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    setEnabled(false);
+}
+
+bool StallWatchdog::isEnabled() const
+{
+    return nullptr != watcher;
+}
+
+QString StallWatchdog::reportDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+        + "/stalls";
+}
+
+void StallWatchdog::setEnabled(bool enabled)
+{
+    if (enabled == isEnabled()) {
+        return;
+    }
+
+    Tracer::setActiveSpansTracked(enabled);
+
+    if (enabled) {
+        beat();
+        heartbeatTimer->start();
+        watcher = new StallWatcherThread(this);
+        watcher->start(QThread::LowPriority);
+    } else {
+        heartbeatTimer->stop();
+        watcher->stop();
+        watcher->wait();
+        delete watcher;
+        watcher = nullptr;
+    }
+}
+
+void StallWatchdog::setDocumentSize(int characters)
+{
+    documentSize.storeRelease(characters);
+}
+
+void StallWatchdog::beat()
+{
+    qint64 now = clock.elapsed();
+    qint64 silence = now - lastHeartbeat.loadAcquire();
+
+    lastHeartbeat.storeRelease(now);
+    completeReport(silence);
+}
+
+void StallWatchdog::writeReport(qint64 silence, qint64 traceTime)
+{
+    QStringList active = Tracer::activeMainThreadSpans();
+    QStringList recent;
+
+    if (traceTime >= 0) {
+        recent = Tracer::mainThreadSpansSince(traceTime);
+    }
+
+    QDir directory(reportDirectory());
+
+    if (!directory.mkpath(".")) {
+        return;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    QString filePath = directory.filePath
+    (
+        QString("stall-%1.txt").arg(now.toString("yyyyMMdd-HHmmss-zzz"))
+    );
+
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << QCoreApplication::applicationName() << " "
+        << QCoreApplication::applicationVersion() << " stopped responding\n"
+        << "Time: " << now.toString(Qt::ISODate) << "\n"
+        << "Qt: " << qVersion() << "\n"
+        << "System: " << QSysInfo::prettyProductName() << "\n"
+        << "Unresponsive for: " << silence << " ms when reported\n"
+        << "Document size: " << documentSize.loadAcquire() << " characters\n"
+        << "Running: "
+        << (active.isEmpty() ? QString("(no traced operation)") : active.join(" > "))
+        << "\n";
+
+    if (traceTime >= 0) {
+        stream << "Traced since the last response: "
+            << (recent.isEmpty() ? QString("(none)") : recent.join(", "))
+            << "\n";
+    }
+
+    stream.flush();
+    file.close();
+
+    qWarning("Main thread stopped responding, see %s", qPrintable(filePath));
+
+    {
+        QMutexLocker locker(&reportMutex);
+        reportPath = filePath;
+    }
+
+    removeOldReports();
+}
+
+void StallWatchdog::completeReport(qint64 silence)
+{
+    QString filePath;
+
+    {
+        QMutexLocker locker(&reportMutex);
+
+        if (reportPath.isNull()) {
+            return;
+        }
+
+        filePath = reportPath;
+        reportPath = QString();
+    }
+
+    QFile file(filePath);
+
+    if (file.open(QIODevice::Append | QIODevice::Text)) {
+        QTextStream stream(&file);
+        stream << "Unresponsive for: " << silence << " ms in total\n";
+    }
+
+    qWarning("Main thread responded again after %lld ms", silence);
+    emit stallReported(filePath);
+}
+
+void StallWatchdog::removeOldReports()
+{
+    QDir directory(reportDirectory());
+    QFileInfoList reports = directory.entryInfoList
+    (
+        QStringList("stall-*.txt"),
+        QDir::Files,
+        QDir::Name | QDir::Reversed
+    );
+
+    for (int i = MaxReports; i < reports.size(); i++) {
+        QFile::remove(reports[i].absoluteFilePath());
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,127 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef STALL_WATCHDOG_H
+#define STALL_WATCHDOG_H
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QWaitCondition>
+
+namespace ghostwriter
+{
+class StallWatcherThread;
+
+/**
+ * Watches for the main thread to stop responding, and writes a report of
+ * what it was busy with, so that stalls in the field can be diagnosed.
+ * The main thread beats a heartbeat timer, which a watcher thread checks.
+ * When the heartbeat goes silent for longer than the threshold, the
+ * watcher writes a report to reportDirectory() naming the spans running
+ * on the main thread (see Tracer), such as a parse, a highlight, a save or
+ * an export, along with the size of the document.  If tracing is enabled,
+ * the report also lists the spans that ran since the heartbeat stopped.
+ * Once the main thread responds again, the report is completed with the
+ * length of the stall and stallReported() is emitted.  Only the most
+ * recent reports are kept.
+ */
+class StallWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.  The watchdog is disabled until enabled with
+     * setEnabled().
+     */
+    StallWatchdog(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~StallWatchdog();
+
+    /**
+     * Returns whether the watchdog is running.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Returns the directory that the stall reports are written to.
+     */
+    static QString reportDirectory();
+
+signals:
+    /**
+     * Emitted once the main thread responds again after a stall, with the
+     * path of the report written about it.
+     */
+    void stallReported(const QString &filePath);
+
+public slots:
+    /**
+     * Starts or stops watching for stalls.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Sets the size of the open document in characters, for the reports.
+     */
+    void setDocumentSize(int characters);
+
+private:
+    // Interval between heartbeats, and between checks of the heartbeat,
+    // in milliseconds.
+    static const int HeartbeatInterval = 500;
+
+    // Time in milliseconds that the heartbeat must stay silent before a
+    // report is written.
+    static const int StallThreshold = 2000;
+
+    // Number of most recent reports kept.
+    static const int MaxReports = 20;
+
+    QTimer *heartbeatTimer;
+    StallWatcherThread *watcher;
+
+    // Time of the last heartbeat on the clock, in milliseconds.
+    QElapsedTimer clock;
+    QAtomicInteger<qint64> lastHeartbeat;
+    QAtomicInt documentSize;
+
+    // Report written about the current stall, if any, which the main
+    // thread completes once it responds again.
+    QMutex reportMutex;
+    QString reportPath;
+
+    void beat();
+    void writeReport(qint64 silence, qint64 traceTime);
+    void completeReport(qint64 silence);
+    void removeOldReports();
+
+    friend class StallWatcherThread;
+};
+} // namespace ghostwriter
+
+#endif // STALL_WATCHDOG_H
@@ -0,0 +1,248 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <stdio.h>
+
+#include "startupprofiler.h"
+
+#define GW_STARTUP_PROFILE_ENV "GHOSTWRITER_STARTUP_PROFILE"
+
+namespace ghostwriter
+{
+const char *StartupProfiler::PROFILE_OPTION = "--profile-startup";
+
+bool StartupProfiler::enabled = false;
+QString StartupProfiler::dumpFilePath;
+QElapsedTimer StartupProfiler::clock;
+QVector<StartupProfiler::Entry> StartupProfiler::entries;
+int StartupProfiler::depth = 0;
+qint64 StartupProfiler::firstTextTime = -1;
+
+// Number of phases listed in the ranking of the slowest phases.
+static const int RANKED_PHASE_COUNT = 10;
+
+// Converts the given nanoseconds to a string of milliseconds.
+//
+static QString toMsecs(qint64 nsecs)
+{
+    return QString::number(nsecs / 1000000.0, 'f', 1);
+}
+
+StartupProfiler::Scope::Scope(const char *phase)
+    : index(-1)
+{
+    if (!enabled) {
+        return;
+    }
+
+    Entry entry;
+    entry.name = phase;
+    entry.start = clock.nsecsElapsed();
+    entry.duration = 0;
+    entry.depth = depth;
+
+    index = entries.size();
+    entries.append(entry);
+    depth++;
+}
+
+StartupProfiler::Scope::~Scope()
+{
+    end();
+}
+
+void StartupProfiler::Scope::end()
+{
+    // The profile may have been finished while this phase was in progress.
+    if ((index < 0) || !enabled) {
+        index = -1;
+        return;
+    }
+
+    entries[index].duration = clock.nsecsElapsed() - entries[index].start;
+    index = -1;
+    depth--;
+}
+
+void StartupProfiler::start(const QStringList &arguments)
+{
+    dumpFilePath = QString::fromLocal8Bit(qgetenv(GW_STARTUP_PROFILE_ENV));
+    enabled = arguments.contains(PROFILE_OPTION) || !dumpFilePath.isEmpty();
+    entries.clear();
+    depth = 0;
+    firstTextTime = -1;
+
+    if (enabled) {
+        clock.start();
+    }
+}
+
+bool StartupProfiler::isEnabled()
+{
+    return enabled;
+}
+
+void StartupProfiler::mark(const char *milestone)
+{
+    if (!enabled) {
+        return;
+    }
+
+    Entry entry;
+    entry.name = milestone;
+    entry.start = clock.nsecsElapsed();
+    entry.duration = -1;
+    entry.depth = depth;
+    entries.append(entry);
+}
+
+void StartupProfiler::markFirstText()
+{
+    if (!enabled || (firstTextTime >= 0)) {
+        return;
+    }
+
+    firstTextTime = clock.nsecsElapsed();
+    mark("First text painted");
+}
+
+QString StartupProfiler::report()
+{
+    QString text;
+    QTextStream stream(&text);
+    qint64 total = clock.isValid() ? clock.nsecsElapsed() : 0;
+
+    // Time spent in each phase outside of its nested phases, by entry.
+    QVector<qint64> selfTimes(entries.size(), 0);
+
+    for (int i = 0; i < entries.size(); i++) {
+        const Entry &entry = entries[i];
+
+        if (entry.duration < 0) {
+            continue;
+        }
+
+        selfTimes[i] = entry.duration;
+
+        for (int j = i + 1; (j < entries.size()) && (entries[j].depth > entry.depth); j++) {
+            if ((entries[j].depth == (entry.depth + 1)) && (entries[j].duration > 0)) {
+                selfTimes[i] -= entries[j].duration;
+            }
+        }
+    }
+
+    stream << "Startup profile, in milliseconds since main() was entered\n\n";
+
+    if (firstTextTime >= 0) {
+        stream << "Time to first text: " << toMsecs(firstTextTime) << "\n\n";
+    }
+    stream << QString("%1 %2 %3  %4\n")
+           .arg("start", 9)
+           .arg("time", 9)
+           .arg("self", 9)
+           .arg("phase");
+
+    for (int i = 0; i < entries.size(); i++) {
+        const Entry &entry = entries[i];
+        QString name = QString(entry.depth * 2, ' ') + entry.name;
+
+        if (entry.duration < 0) {
+            stream << QString("%1 %2 %3  * %4\n")
+                   .arg(toMsecs(entry.start), 9)
+                   .arg("", 9)
+                   .arg("", 9)
+                   .arg(name);
+        } else {
+            stream << QString("%1 %2 %3  %4\n")
+                   .arg(toMsecs(entry.start), 9)
+                   .arg(toMsecs(entry.duration), 9)
+                   .arg(toMsecs(selfTimes[i]), 9)
+                   .arg(name);
+        }
+    }
+
+    stream << QString("%1 %2 %3  %4\n")
+           .arg(toMsecs(total), 9)
+           .arg("", 9)
+           .arg("", 9)
+           .arg("total");
+
+    QVector<int> ranking;
+
+    for (int i = 0; i < entries.size(); i++) {
+        if (entries[i].duration >= 0) {
+            ranking.append(i);
+        }
+    }
+
+    std::stable_sort
+    (
+        ranking.begin(),
+        ranking.end(),
+        [&selfTimes](int a, int b) {
+            return selfTimes[a] > selfTimes[b];
+        }
+    );
+
+    stream << "\nSlowest phases, by time spent outside their nested phases\n\n";
+
+    for (int i = 0; (i < ranking.size()) && (i < RANKED_PHASE_COUNT); i++) {
+        qint64 self = selfTimes[ranking[i]];
+        double percent = (total > 0) ? (100.0 * self / total) : 0.0;
+
+        stream << QString("%1. %2 %3%  %4\n")
+               .arg(i + 1, 3)
+               .arg(toMsecs(self), 9)
+               .arg(QString::number(percent, 'f', 1), 5)
+               .arg(entries[ranking[i]].name);
+    }
+
+    stream.flush();
+    return text;
+}
+
+void StartupProfiler::finish()
+{
+    if (!enabled) {
+        return;
+    }
+
+    QString text = report();
+    enabled = false;
+
+    if (dumpFilePath.isEmpty()) {
+        fputs(text.toLocal8Bit().constData(), stderr);
+        fflush(stderr);
+        return;
+    }
+
+    QFile file(dumpFilePath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        qWarning("Could not write startup profile to %s", qPrintable(dumpFilePath));
+        return;
+    }
+
+    file.write(text.toUtf8());
+}
+} // namespace ghostwriter
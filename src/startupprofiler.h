@@ -0,0 +1,122 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Records how long each phase of application startup takes, from entering
+ * main() until the first document is loaded, so that startup regressions
+ * can be caught and the slowest phases ranked.  Profiling is requested
+ * either with the --profile-startup command line option, which prints the
+ * breakdown to stderr, or with the GHOSTWRITER_STARTUP_PROFILE environment
+ * variable, which names the file to write it to.  When profiling is not
+ * requested, timing costs a single check per phase.
+ *
+ * The profiler is meant to be used from the main thread only.
+ */
+class StartupProfiler
+{
+public:
+    /**
+     * Command line option requesting a startup profile.
+     */
+    static const char *PROFILE_OPTION;
+
+    /**
+     * Times the enclosing scope as the named startup phase.  Phases
+     * timed while another is in progress are reported nested within it.
+     */
+    class Scope
+    {
+    public:
+        Scope(const char *phase);
+        ~Scope();
+
+        /**
+         * Ends the phase before the scope is left.
+         */
+        void end();
+
+    private:
+        int index;
+    };
+
+    /**
+     * Starts the startup clock, enabling profiling if the given command
+     * line arguments or the environment request it.  Call this first
+     * thing in main().
+     */
+    static void start(const QStringList &arguments);
+
+    /**
+     * Returns whether startup is being profiled.
+     */
+    static bool isEnabled();
+
+    /**
+     * Records that the named milestone was reached.
+     */
+    static void mark(const char *milestone);
+
+    /**
+     * Records that the text of the first document was painted, which is
+     * the time that the report headlines as the time to first text.
+     */
+    static void markFirstText();
+
+    /**
+     * Returns a plain text breakdown of the phases recorded so far.
+     */
+    static QString report();
+
+    /**
+     * Ends profiling, writing the report to the requested destination.
+     * Does nothing if profiling already ended or was never enabled.
+     */
+    static void finish();
+
+private:
+    struct Entry
+    {
+        const char *name;
+        qint64 start;
+        qint64 duration;
+        int depth;
+    };
+
+    static bool enabled;
+    static QString dumpFilePath;
+    static QElapsedTimer clock;
+    static QVector<Entry> entries;
+    static int depth;
+    static qint64 firstTextTime;
+
+    StartupProfiler();
+};
+} // namespace ghostwriter
+
+#endif // STARTUPPROFILER_H
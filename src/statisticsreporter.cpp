@@ -0,0 +1,350 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+
+#include "documentstatistics.h"
+#include "statisticsreporter.h"
+
+namespace ghostwriter
+{
+const QString StatisticsReporter::STATS_OPTION = "stats";
+
+class StatisticsReporterPrivate
+{
+public:
+    StatisticsReporterPrivate()
+        : out(stdout), err(stderr)
+    {
+        ;
+    }
+
+    ~StatisticsReporterPrivate()
+    {
+        ;
+    }
+
+    // Exit codes of the application.
+    enum {
+        ExitSuccess = 0,
+        ExitReadFailed = 1,
+        ExitUsageError = 2
+    };
+
+    // Statistics of a single file, or the error reading it.
+    typedef struct {
+        QString filePath;
+        QString error;
+        DocumentStatistics::Statistics statistics;
+    } Result;
+
+    QTextStream out;
+    QTextStream err;
+
+    /*
+    * Returns the files matching the given paths, which may contain
+    * wildcards in their file names, or be folders, which match the
+    * Markdown files within them and their subfolders.  Paths matching no
+    * file are added to the unmatched list.
+    */
+    QStringList expandInputs(const QStringList &paths, QStringList &unmatched) const;
+
+    /*
+    * Reads the given file and computes its statistics.  This method is
+    * run on the thread pool.
+    */
+    static void computeStatistics(Result &result);
+
+    void printJson(const QVector<Result> &results);
+    void printCsv(const QVector<Result> &results);
+};
+
+StatisticsReporter::StatisticsReporter()
+    : d_ptr(new StatisticsReporterPrivate())
+{
+    ;
+}
+
+StatisticsReporter::~StatisticsReporter()
+{
+    ;
+}
+
+bool StatisticsReporter::isRequested(const QStringList &arguments)
+{
+    return arguments.contains(QString("--") + STATS_OPTION);
+}
+
+int StatisticsReporter::exec(const QStringList &arguments)
+{
+    Q_D(StatisticsReporter);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QObject::tr("Prints the statistics of Markdown files without opening the editor."));
+    QCommandLineOption helpOption = parser.addHelpOption();
+
+    QCommandLineOption statsOption
+    (
+        STATS_OPTION,
+        QObject::tr("Print the statistics of the given files, and exit.")
+    );
+    QCommandLineOption formatOption
+    (
+        QStringList() << "f" << "format",
+        QObject::tr("Format of the report.  Defaults to json."),
+        "json|csv"
+    );
+    QCommandLineOption jobsOption
+    (
+        QStringList() << "j" << "jobs",
+        QObject::tr("Number of files to count at once."),
+        QObject::tr("count")
+    );
+
+    parser.addOption(statsOption);
+    parser.addOption(formatOption);
+    parser.addOption(jobsOption);
+    parser.addPositionalArgument
+    (
+        "files",
+        QObject::tr("Markdown files to count.  File names may contain "
+            "wildcards, and folders count every Markdown file within them."),
+        "files..."
+    );
+
+    if (!parser.parse(arguments)) {
+        d->err << parser.errorText() << "\n";
+        return StatisticsReporterPrivate::ExitUsageError;
+    }
+
+    if (parser.isSet(helpOption)) {
+        parser.showHelp(StatisticsReporterPrivate::ExitSuccess);
+    }
+
+    QString format = parser.value(formatOption).toLower();
+
+    if (format.isEmpty()) {
+        format = "json";
+    } else if (("json" != format) && ("csv" != format)) {
+        d->err << QObject::tr("The format must be json or csv.") << "\n";
+        return StatisticsReporterPrivate::ExitUsageError;
+    }
+
+    if (parser.isSet(jobsOption)) {
+        bool ok = false;
+        int jobs = parser.value(jobsOption).toInt(&ok);
+
+        if (!ok || (jobs < 1)) {
+            d->err << QObject::tr("The number of jobs must be a positive number.") << "\n";
+            return StatisticsReporterPrivate::ExitUsageError;
+        }
+
+        QThreadPool::globalInstance()->setMaxThreadCount(jobs);
+    }
+
+    QStringList unmatched;
+    QStringList inputs = d->expandInputs(parser.positionalArguments(), unmatched);
+
+    foreach (const QString &path, unmatched) {
+        d->err << QObject::tr("No file matches %1.").arg(path) << "\n";
+    }
+
+    if (inputs.isEmpty()) {
+        d->err << QObject::tr("There are no files to count.") << "\n";
+        return StatisticsReporterPrivate::ExitUsageError;
+    }
+
+    QVector<StatisticsReporterPrivate::Result> results(inputs.size());
+
+    for (int i = 0; i < inputs.size(); i++) {
+        results[i].filePath = inputs[i];
+    }
+
+    QtConcurrent::blockingMap(results, &StatisticsReporterPrivate::computeStatistics);
+
+    int failures = 0;
+
+    foreach (const StatisticsReporterPrivate::Result &result, results) {
+        if (!result.error.isNull()) {
+            failures++;
+            d->err << QObject::tr("Failed to read %1: %2")
+                .arg(result.filePath)
+                .arg(result.error) << "\n";
+        }
+    }
+
+    d->err.flush();
+
+    if ("csv" == format) {
+        d->printCsv(results);
+    } else {
+        d->printJson(results);
+    }
+
+    if ((failures > 0) || !unmatched.isEmpty()) {
+        return StatisticsReporterPrivate::ExitReadFailed;
+    }
+
+    return StatisticsReporterPrivate::ExitSuccess;
+}
+
+QStringList StatisticsReporterPrivate::expandInputs
+(
+    const QStringList &paths,
+    QStringList &unmatched
+) const
+{
+    static const QStringList markdownFilters =
+    {
+        "*.md", "*.markdown", "*.mdown", "*.mkdn", "*.mkd",
+        "*.mdwn", "*.mdtxt", "*.mdtext", "*.Rmd"
+    };
+
+    QStringList files;
+
+    foreach (const QString &path, paths) {
+        QFileInfo pathInfo(path);
+        QString name = pathInfo.fileName();
+        int count = files.size();
+
+        if (pathInfo.isDir()) {
+            QStringList folderFiles;
+            QDirIterator it
+            (
+                pathInfo.absoluteFilePath(),
+                markdownFilters,
+                QDir::Files | QDir::Readable,
+                QDirIterator::Subdirectories
+            );
+
+            while (it.hasNext()) {
+                folderFiles.append(QFileInfo(it.next()).absoluteFilePath());
+            }
+
+            folderFiles.sort();
+            files.append(folderFiles);
+        } else if (name.contains('*') || name.contains('?') || name.contains('[')) {
+            // Shells on some platforms leave wildcards for the program to
+            // expand.
+            QDir dir = pathInfo.dir();
+
+            foreach (const QString &match, dir.entryList(QStringList(name), QDir::Files, QDir::Name)) {
+                files.append(QFileInfo(dir.filePath(match)).absoluteFilePath());
+            }
+        } else if (pathInfo.isFile()) {
+            files.append(pathInfo.absoluteFilePath());
+        }
+
+        if (files.size() == count) {
+            unmatched.append(path);
+        }
+    }
+
+    files.removeDuplicates();
+    return files;
+}
+
+void StatisticsReporterPrivate::computeStatistics(Result &result)
+{
+    QFile file(result.filePath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.error = file.errorString();
+        return;
+    }
+
+    // Line endings are normalized as when the file is opened in the
+    // editor, so that carriage returns do not count as characters.
+    QString text = QString::fromUtf8(file.readAll());
+    text.remove('\r');
+
+    result.statistics = DocumentStatistics::statisticsOf(text);
+}
+
+void StatisticsReporterPrivate::printJson(const QVector<Result> &results)
+{
+    QJsonArray files;
+
+    foreach (const Result &result, results) {
+        if (!result.error.isNull()) {
+            continue;
+        }
+
+        const DocumentStatistics::Statistics &statistics = result.statistics;
+        QJsonObject file;
+
+        file.insert("file", result.filePath);
+        file.insert("words", statistics.wordCount);
+        file.insert("characters", statistics.characterCount);
+        file.insert("sentences", statistics.sentenceCount);
+        file.insert("paragraphs", statistics.paragraphCount);
+        file.insert("pages", statistics.pageCount);
+        file.insert("complexWords", statistics.complexWords);
+        file.insert("readingTime", statistics.readingTime);
+        file.insert("lix", statistics.lixReadingEase);
+        file.insert("cli", statistics.readabilityIndex);
+        files.append(file);
+    }
+
+    out << QString::fromUtf8(QJsonDocument(files).toJson(QJsonDocument::Indented));
+    out.flush();
+}
+
+void StatisticsReporterPrivate::printCsv(const QVector<Result> &results)
+{
+    out << "file,words,characters,sentences,paragraphs,pages,complexWords,readingTime,lix,cli\n";
+
+    foreach (const Result &result, results) {
+        if (!result.error.isNull()) {
+            continue;
+        }
+
+        const DocumentStatistics::Statistics &statistics = result.statistics;
+        QString filePath = result.filePath;
+
+        filePath.replace('"', "\"\"");
+
+        out << '"' << filePath << '"'
+            << ',' << statistics.wordCount
+            << ',' << statistics.characterCount
+            << ',' << statistics.sentenceCount
+            << ',' << statistics.paragraphCount
+            << ',' << statistics.pageCount
+            << ',' << statistics.complexWords
+            << ',' << statistics.readingTime
+            << ',' << statistics.lixReadingEase
+            << ',' << statistics.readabilityIndex
+            << '\n';
+    }
+
+    out.flush();
+}
+} // namespace ghostwriter
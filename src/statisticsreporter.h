@@ -0,0 +1,75 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef STATISTICS_REPORTER_H
+#define STATISTICS_REPORTER_H
+
+#include <QScopedPointer>
+#include <QStringList>
+
+namespace ghostwriter
+{
+/**
+ * Prints the document statistics of Markdown files without a user
+ * interface, for use from scripts.  The statistics are computed in
+ * parallel with DocumentStatistics::statisticsOf(), so that they match
+ * those shown in the editor, and are printed as JSON or CSV in the order
+ * of the files given.
+ */
+class StatisticsReporterPrivate;
+class StatisticsReporter
+{
+    Q_DECLARE_PRIVATE(StatisticsReporter)
+
+public:
+    /**
+     * Name of the command line option that selects the statistics report.
+     */
+    static const QString STATS_OPTION;
+
+    /**
+     * Constructor.
+     */
+    StatisticsReporter();
+
+    /**
+     * Destructor.
+     */
+    ~StatisticsReporter();
+
+    /**
+     * Returns true if the given application arguments ask for the
+     * statistics report rather than for the editor.
+     */
+    static bool isRequested(const QStringList &arguments);
+
+    /**
+     * Prints the statistics of the files given by the application
+     * arguments.  Input file names may contain wildcards, and folders
+     * stand for the Markdown files within them.  Returns the exit code for
+     * the application, which is zero only if every file was read.
+     */
+    int exec(const QStringList &arguments);
+
+private:
+    QScopedPointer<StatisticsReporterPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // STATISTICS_REPORTER_H
@@ -33,6 +33,11 @@ StringObserver::~StringObserver()
 
 void StringObserver::setText(const QString &text)
 {
+    // Don't send the same text over the web channel again.
+    if (text == mText) {
+        return;
+    }
+
     mText = text;
     emit textChanged(mText);
 }
@@ -46,7 +46,8 @@ public:
     virtual ~StringObserver();
 
     /**
-     * Set the text of the string.
+     * Set the text of the string.  The textChanged() signal is only
+     * emitted if the text differs from the current text.
      */
     void setText(const QString &text);
 
@@ -18,6 +18,8 @@
  ***********************************************************************/
 
 #include <QApplication>
+#include <QCache>
+#include <QCryptographicHash>
 #include <QFile>
 #include <QPalette>
 #include <QRegularExpression>
@@ -29,7 +31,8 @@
 
 namespace ghostwriter
 {
-QString StyleSheetBuilder::m_htmlPreviewSass;
+StyleSheetBuilder::CompiledTemplate StyleSheetBuilder::m_htmlPreviewTemplate;
+QString StyleSheetBuilder::m_htmlPreviewBaseCss;
 
 StyleSheetBuilder::StyleSheetBuilder(const ColorScheme &colors,
         const bool roundedCorners,
@@ -111,6 +114,69 @@ StyleSheetBuilder::~StyleSheetBuilder()
     ;
 }
 
+// Number of sets of style sheets kept by StyleSheetBuilder::cached(),
+// enough to switch back and forth between light and dark mode or a few
+// themes without rebuilding.
+//
+static const int STYLE_SHEET_CACHE_SIZE = 8;
+
+StyleSheetBuilder StyleSheetBuilder::cached
+(
+    const ColorScheme &colors,
+    const bool roundedCorners,
+    const QFont &previewTextFont,
+    const QFont &previewCodeFont
+)
+{
+    static QCache<QByteArray, StyleSheetBuilder> cache(STYLE_SHEET_CACHE_SIZE);
+
+    QStringList inputs;
+
+    inputs << colors.foreground.name(QColor::HexArgb)
+        << colors.background.name(QColor::HexArgb)
+        << colors.selection.name(QColor::HexArgb)
+        << colors.cursor.name(QColor::HexArgb)
+        << colors.link.name(QColor::HexArgb)
+        << colors.image.name(QColor::HexArgb)
+        << colors.inlineHtml.name(QColor::HexArgb)
+        << colors.headingText.name(QColor::HexArgb)
+        << colors.headingMarkup.name(QColor::HexArgb)
+        << colors.emphasisText.name(QColor::HexArgb)
+        << colors.emphasisMarkup.name(QColor::HexArgb)
+        << colors.blockquoteText.name(QColor::HexArgb)
+        << colors.blockquoteMarkup.name(QColor::HexArgb)
+        << colors.divider.name(QColor::HexArgb)
+        << colors.listMarkup.name(QColor::HexArgb)
+        << colors.codeText.name(QColor::HexArgb)
+        << colors.codeMarkup.name(QColor::HexArgb)
+        << colors.error.name(QColor::HexArgb)
+        << (roundedCorners ? "rounded" : "square")
+        << previewTextFont.toString()
+        << previewCodeFont.toString();
+
+    QByteArray key = QCryptographicHash::hash
+        (
+            inputs.join('\n').toUtf8(),
+            QCryptographicHash::Sha1
+        );
+
+    StyleSheetBuilder *builder = cache.object(key);
+
+    if (nullptr == builder) {
+        builder = new StyleSheetBuilder
+        (
+            colors,
+            roundedCorners,
+            previewTextFont,
+            previewCodeFont
+        );
+
+        cache.insert(key, builder);
+    }
+
+    return *builder;
+}
+
 QString StyleSheetBuilder::layoutStyleSheet()
 {
     return m_layoutStyleSheet;
@@ -161,6 +227,16 @@ QString StyleSheetBuilder::htmlPreviewCss()
     return m_htmlPreviewCss;
 }
 
+QString StyleSheetBuilder::htmlPreviewBaseCss()
+{
+    return m_htmlPreviewBaseCss;
+}
+
+QHash<QString, QString> StyleSheetBuilder::htmlPreviewCssVariables()
+{
+    return m_htmlPreviewCssVariables;
+}
+
 QColor StyleSheetBuilder::interfaceTextColor() 
 {
     return m_interfaceTextColor;
@@ -482,7 +558,7 @@ void StyleSheetBuilder::buildSidebarWidgetStyleSheet()
 
 void StyleSheetBuilder::buildHtmlPreviewCss(const bool roundedCorners) 
 {
-    if (m_htmlPreviewSass.isNull() || m_htmlPreviewSass.isEmpty())
+    if (m_htmlPreviewTemplate.literals.isEmpty())
     {
         QFile cssFile(":/resources/preview.css");
 
@@ -495,8 +571,17 @@ void StyleSheetBuilder::buildHtmlPreviewCss(const bool roundedCorners)
         QTextStream inStream(&cssFile);
         inStream.setCodec("UTF-8");
         inStream.setAutoDetectUnicode(true);
-        m_htmlPreviewSass = inStream.readAll();
+        m_htmlPreviewTemplate = compileTemplate(inStream.readAll());
         cssFile.close();
+
+        // Refer to every variable as a CSS custom property.
+        QHash<QString, QString> properties;
+
+        foreach (const QString &name, m_htmlPreviewTemplate.variables) {
+            properties.insert(name, QString("var(--%1)").arg(name));
+        }
+
+        m_htmlPreviewBaseCss = expandTemplate(m_htmlPreviewTemplate, properties);
     }
 
     QColor baseScrollColor = this->m_foregroundColor;
@@ -508,30 +593,106 @@ void StyleSheetBuilder::buildHtmlPreviewCss(const bool roundedCorners)
         scrollBarBorderRadius = "3px";
     }
 
-    m_htmlPreviewCss = m_htmlPreviewSass;    
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$textColor", m_foregroundColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$backgroundColor", m_backgroundColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$textFont", m_htmlPreviewTextFont.family().remove(QRegularExpression("\\[.*\\]")).trimmed());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$fontSize", QString("%1pt").arg(m_htmlPreviewTextFont.pointSize()));
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$headingColor", m_headingColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$faintColor", m_faintColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$blockBackground", m_faintColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$codeColor", m_codeColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$linkColor", m_linkColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$blockquoteColor", m_blockquoteColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$thickBorderColor", m_thickBorderColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$scrollBarThumbColor", 
-        QString("rgba(%1, %2, %3, %4)")
+    QString scrollBarColor = QString("rgba(%1, %2, %3, %4)")
         .arg(baseScrollColor.red()).arg(baseScrollColor.green()).arg(baseScrollColor.blue())
-        .arg(baseScrollColor.alphaF()));
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$scrollBarThumbHoverColor", m_accentColor.name());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$scrollBarTrackColor",
-        QString("rgba(%1, %2, %3, %4)")
-        .arg(baseScrollColor.red()).arg(baseScrollColor.green()).arg(baseScrollColor.blue())
-        .arg(baseScrollColor.alphaF()));
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$scrollBarBorderRadius", scrollBarBorderRadius);
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$monospaceFont", m_htmlPreviewCodeFont.family().remove(QRegularExpression("\\[.*\\]")).trimmed());
-    m_htmlPreviewCss = m_htmlPreviewCss.replace("$codeFontSize", QString("%1pt").arg(m_htmlPreviewCodeFont.pointSize()));
+        .arg(baseScrollColor.alphaF());
+
+    QHash<QString, QString> values;
+
+    values.insert("textColor", m_foregroundColor.name());
+    values.insert("backgroundColor", m_backgroundColor.name());
+    values.insert("textFont", QString("\"%1\"").arg(m_htmlPreviewTextFont.family().remove(QRegularExpression("\\[.*\\]")).trimmed()));
+    values.insert("fontSize", QString("%1pt").arg(m_htmlPreviewTextFont.pointSize()));
+    values.insert("headingColor", m_headingColor.name());
+    values.insert("faintColor", m_faintColor.name());
+    values.insert("blockBackground", m_faintColor.name());
+    values.insert("codeColor", m_codeColor.name());
+    values.insert("linkColor", m_linkColor.name());
+    values.insert("blockquoteColor", m_blockquoteColor.name());
+    values.insert("thickBorderColor", m_thickBorderColor.name());
+    values.insert("scrollBarThumbColor", scrollBarColor);
+    values.insert("scrollBarThumbHoverColor", m_accentColor.name());
+    values.insert("scrollBarTrackColor", scrollBarColor);
+    values.insert("scrollBarBorderRadius", scrollBarBorderRadius);
+    values.insert("monospaceFont", QString("\"%1\"").arg(m_htmlPreviewCodeFont.family().remove(QRegularExpression("\\[.*\\]")).trimmed()));
+    values.insert("codeFontSize", QString("%1pt").arg(m_htmlPreviewCodeFont.pointSize()));
+
+    m_htmlPreviewCss = expandTemplate(m_htmlPreviewTemplate, values);
+    m_htmlPreviewCssVariables = values;
+}
+
+StyleSheetBuilder::CompiledTemplate StyleSheetBuilder::compileTemplate(const QString &text)
+{
+    CompiledTemplate compiled;
+    compiled.literalLength = 0;
+    int literalStart = 0;
+    int i = 0;
+
+    while (i < text.length()) {
+        if ('$' != text[i]) {
+            i++;
+            continue;
+        }
+
+        int nameEnd = i + 1;
+
+        while
+        (
+            (nameEnd < text.length())
+            && (text[nameEnd].isLetterOrNumber() || ('_' == text[nameEnd]))
+        ) {
+            nameEnd++;
+        }
+
+        // A lone dollar sign is just text.
+        if ((i + 1) == nameEnd) {
+            i++;
+            continue;
+        }
+
+        compiled.literals.append(text.mid(literalStart, i - literalStart));
+        compiled.variables.append(text.mid(i + 1, nameEnd - i - 1));
+        literalStart = nameEnd;
+        i = nameEnd;
+    }
+
+    compiled.literals.append(text.mid(literalStart));
+
+    foreach (const QString &literal, compiled.literals) {
+        compiled.literalLength += literal.length();
+    }
+
+    return compiled;
+}
+
+QString StyleSheetBuilder::expandTemplate
+(
+    const CompiledTemplate &compiled,
+    const QHash<QString, QString> &values
+)
+{
+    QString result;
+
+    // Leave room for values of a typical length.
+    result.reserve(compiled.literalLength + (compiled.variables.size() * 16));
+
+    for (int i = 0; i < compiled.literals.size(); i++) {
+        result.append(compiled.literals[i]);
+
+        if (i < compiled.variables.size()) {
+            const QString &name = compiled.variables[i];
+            QHash<QString, QString>::const_iterator value = values.constFind(name);
+
+            if (values.constEnd() != value) {
+                result.append(value.value());
+            } else {
+                result.append('$');
+                result.append(name);
+            }
+        }
+    }
+
+    return result;
 }
 
 // Algorithm taken from *Grokking the GIMP* by Carey Bunks,
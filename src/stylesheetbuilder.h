@@ -21,7 +21,9 @@
 #define STYLESHEETBUILDER_H
 
 #include <QFont>
+#include <QHash>
 #include <QString>
+#include <QStringList>
 
 #include "colorscheme.h"
 
@@ -47,6 +49,18 @@ public:
      */
     ~StyleSheetBuilder();
 
+    /**
+     * Returns the style sheets for the given inputs, which are built only
+     * if they were not built for the same inputs recently.
+     */
+    static StyleSheetBuilder cached
+    (
+        const ColorScheme &colors,
+        const bool roundedCorners,
+        const QFont &previewTextFont,
+        const QFont &previewCodeFont
+    );
+
     /**
      * Gets the general layout style sheet.
      */
@@ -99,6 +113,21 @@ public:
      */
     QString htmlPreviewCss();
 
+    /**
+     * Gets the HTML live preview CSS style sheet with the theme's colors
+     * and fonts left out as CSS custom properties, such that the style
+     * sheet is the same for all themes.  The values of the properties
+     * are given by htmlPreviewCssVariables().
+     */
+    QString htmlPreviewBaseCss();
+
+    /**
+     * Gets the values of the CSS custom properties used by
+     * htmlPreviewBaseCss(), keyed by property name without the leading
+     * dashes.
+     */
+    QHash<QString, QString> htmlPreviewCssVariables();
+
     /**
      * Gets the interface text color derived from the color scheme.
      */
@@ -110,6 +139,20 @@ public:
     QColor faintColor();
 
 private:
+    /**
+     * A style sheet template compiled into the literal text between its
+     * $variables and the names of those variables, such that the
+     * template is the first literal followed by alternating variables
+     * and literals.  This lets a template be filled in with a single
+     * pass over it.
+     */
+    struct CompiledTemplate
+    {
+        QStringList literals;
+        QStringList variables;
+        int literalLength;
+    };
+
     QColor m_backgroundColor;
     QColor m_foregroundColor;
     QColor m_faintColor;
@@ -137,8 +180,10 @@ private:
     QString m_findReplaceStyleSheet;
     QString m_sidebarStyleSheet;
     QString m_sidebarWidgetStyleSheet;
-    static QString m_htmlPreviewSass;
+    static CompiledTemplate m_htmlPreviewTemplate;
+    static QString m_htmlPreviewBaseCss;
     QString m_htmlPreviewCss;
+    QHash<QString, QString> m_htmlPreviewCssVariables;
     QFont m_htmlPreviewTextFont;
     QFont m_htmlPreviewCodeFont;
 
@@ -154,6 +199,22 @@ private:
     void buildSidebarWidgetStyleSheet();
     void buildHtmlPreviewCss(const bool roundedCorners);
 
+    /**
+     * Compiles the given template text, in which variables are written
+     * as a dollar sign followed by the variable's name.
+     */
+    static CompiledTemplate compileTemplate(const QString &text);
+
+    /**
+     * Fills in the compiled template with the given values of its
+     * variables.  Variables for which no value is given are left as is.
+     */
+    static QString expandTemplate
+    (
+        const CompiledTemplate &compiled,
+        const QHash<QString, QString> &values
+    );
+
     /**
      * Returns the luminance of this color on a scale of 0.0 (dark) to
      * 1.0 (light).  Luminance is based on how light or dark a color
@@ -0,0 +1,428 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QRegularExpression>
+
+#include "markdownast.h"
+#include "markdowndocument.h"
+#include "markdownnode.h"
+#include "tableformatter.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+TableFormatter::TableFormatter(MarkdownDocument *document)
+    : QObject(document),
+      document(document),
+      formatting(false),
+      changeRevision(document->revision()),
+      blockCount(document->blockCount())
+{
+    this->connect
+    (
+        document,
+        &QTextDocument::contentsChange,
+        [this](int position, int charsRemoved, int charsAdded) {
+            this->onContentsChange(position, charsRemoved, charsAdded);
+        }
+    );
+}
+
+TableFormatter::~TableFormatter()
+{
+    ;
+}
+
+bool TableFormatter::alignCell(QTextCursor &cursor)
+{
+    if (formatting || cursor.hasSelection() || !cursor.block().text().contains('|')) {
+        return false;
+    }
+
+    QTextBlock block = cursor.block();
+    Table *table = tableAt(block);
+
+    // The delimiter row is left as typed until the table is formatted.
+    if ((nullptr == table) || ((block.blockNumber() - table->first.blockNumber()) == 1)) {
+        return false;
+    }
+
+    QVector<Cell> cells = splitRow(block.text());
+    int offset = cursor.positionInBlock();
+    int column = cellAt(cells, offset);
+
+    if (column < 0) {
+        return false;
+    }
+
+    while (table->widths.size() <= column) {
+        table->widths.append(MinimumWidth);
+    }
+
+    int width = contentWidth(cells[column]);
+    bool widened = width > table->widths[column];
+
+    if (widened) {
+        table->widths[column] = width;
+    }
+
+    GW_TRACE_SCOPE("TableFormatter::alignCell");
+
+    QTextCursor edit(document);
+    bool changed = false;
+
+    formatting = true;
+    document->beginTransaction();
+    edit.joinPreviousEditBlock();
+
+    changed = padCell(edit, block, cells[column], table->widths[column], false);
+
+    // Only a column that the cell outgrew needs padding in the other rows.
+    if (widened) {
+        QTextBlock row = table->first;
+
+        for (int i = 0; (i < table->rowCount) && row.isValid(); i++) {
+            if (row != block) {
+                QVector<Cell> rowCells = splitRow(row.text());
+
+                if (column < rowCells.size()) {
+                    changed |= padCell(edit, row, rowCells[column], width, (1 == i));
+                }
+            }
+
+            row = row.next();
+        }
+    }
+
+    edit.endEditBlock();
+    document->commit();
+    formatting = false;
+
+    cursor.setPosition(block.position() + qMin(offset, block.length() - 1));
+    return changed;
+}
+
+bool TableFormatter::formatTable(QTextCursor &cursor)
+{
+    QTextBlock block = cursor.block();
+    QTextBlock first;
+    int rowCount;
+
+    if (formatting || !findTable(block, first, rowCount)) {
+        return false;
+    }
+
+    // Measure the table afresh, as the rows may have been edited without
+    // the formatter.
+    for (int i = 0; i < tables.size(); i++) {
+        if (tables[i].first == first) {
+            tables.remove(i);
+            break;
+        }
+    }
+
+    Table *table = tableAt(block);
+
+    if (nullptr == table) {
+        return false;
+    }
+
+    GW_TRACE_SCOPE("TableFormatter::formatTable");
+
+    QVector<Cell> cells = splitRow(block.text());
+    int offset = cursor.positionInBlock();
+    int column = cellAt(cells, offset);
+    int cellOffset = (column >= 0) ? (offset - cells[column].start) : offset;
+
+    QTextCursor edit(document);
+    QTextBlock row = table->first;
+    bool changed = false;
+
+    formatting = true;
+    document->beginTransaction();
+    edit.beginEditBlock();
+
+    for (int i = 0; (i < table->rowCount) && row.isValid(); i++) {
+        QVector<Cell> rowCells = splitRow(row.text());
+
+        // Pad the cells from last to first so that the positions of the
+        // cells yet to pad stay the same.
+        for (int c = qMin(rowCells.size(), table->widths.size()) - 1; c >= 0; c--) {
+            changed |= padCell(edit, row, rowCells[c], table->widths[c], (1 == i));
+        }
+
+        row = row.next();
+    }
+
+    edit.endEditBlock();
+    document->commit();
+    formatting = false;
+
+    // Keep the cursor at the same place within its cell.
+    cells = splitRow(block.text());
+
+    if ((column >= 0) && (column < cells.size())) {
+        offset = qMin(cells[column].start + cellOffset, cells[column].end);
+    }
+
+    cursor.setPosition(block.position() + qMin(offset, block.length() - 1));
+    return changed;
+}
+
+void TableFormatter::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // Highlighting also signals a change to the contents, without changing
+    // the text.  See MarkdownDocument::onContentsChange().
+    if
+    (
+        (charsRemoved == charsAdded)
+        && (charsAdded > 0)
+        && (document->revision() == changeRevision)
+    ) {
+        return;
+    }
+
+    changeRevision = document->revision();
+
+    // The formatter keeps the index up to date with its own edits.
+    if (formatting) {
+        return;
+    }
+
+    int oldBlockCount = blockCount;
+    blockCount = document->blockCount();
+
+    // Edits within a single line keep the rows of the tables, and at worst
+    // leave a column wider than its cells.
+    if
+    (
+        (oldBlockCount != blockCount)
+        || (document->findBlock(position) != document->findBlock(position + charsAdded))
+    ) {
+        tables.clear();
+    }
+}
+
+TableFormatter::Table *TableFormatter::tableAt(const QTextBlock &block)
+{
+    QTextBlock first;
+    int rowCount;
+
+    if (!findTable(block, first, rowCount)) {
+        return nullptr;
+    }
+
+    for (int i = 0; i < tables.size(); i++) {
+        if ((tables[i].first == first) && (tables[i].rowCount == rowCount)) {
+            tables.move(i, tables.size() - 1);
+            return &tables.last();
+        }
+    }
+
+    Table table;
+    table.first = first;
+    table.rowCount = rowCount;
+
+    QTextBlock row = first;
+
+    for (int i = 0; (i < rowCount) && row.isValid(); i++) {
+        if (1 != i) {
+            QVector<Cell> cells = splitRow(row.text());
+
+            while (table.widths.size() < cells.size()) {
+                table.widths.append(MinimumWidth);
+            }
+
+            for (int c = 0; c < cells.size(); c++) {
+                table.widths[c] = qMax(table.widths[c], contentWidth(cells[c]));
+            }
+        }
+
+        row = row.next();
+    }
+
+    if (tables.size() >= MaxIndexedTables) {
+        tables.removeFirst();
+    }
+
+    tables.append(table);
+    return &tables.last();
+}
+
+bool TableFormatter::findTable(const QTextBlock &block, QTextBlock &first, int &rowCount) const
+{
+    static const QRegularExpression delimiterRowRegex
+    (
+        "^\\s*\\|?\\s*:?-+:?\\s*(\\|\\s*:?-+:?\\s*)*\\|?\\s*$"
+    );
+
+    const MarkdownAST *ast = document->markdownAST();
+
+    if ((nullptr == ast) || (nullptr == ast->root())) {
+        return false;
+    }
+
+    const MarkdownNode *node = ast->findBlockAtLine(block.blockNumber() + 1);
+
+    while ((nullptr != node) && (MarkdownNode::Table != node->type())) {
+        node = node->parent();
+    }
+
+    if (nullptr == node) {
+        return false;
+    }
+
+    first = document->findBlockByNumber(node->startLine() - 1);
+    rowCount = node->endLine() - node->startLine() + 1;
+
+    // The AST can lag behind the latest edits, so make sure that its lines
+    // still hold a table around the block.
+    return first.isValid()
+        && (rowCount >= 2)
+        && (block.blockNumber() >= first.blockNumber())
+        && (block.blockNumber() < (first.blockNumber() + rowCount))
+        && delimiterRowRegex.match(first.next().text()).hasMatch();
+}
+
+bool TableFormatter::padCell
+(
+    QTextCursor &edit,
+    const QTextBlock &block,
+    const Cell &cell,
+    int width,
+    bool delimiterRow
+) const
+{
+    if (!cell.closed) {
+        return false;
+    }
+
+    int position = block.position();
+    bool changed = false;
+    int contentEnd = cell.contentEnd;
+
+    // Pad the trailing side last, after any change to the content.
+    if (delimiterRow) {
+        QString content = block.text().mid(cell.contentStart, contentWidth(cell));
+        bool left = content.startsWith(':');
+        bool right = (content.length() > 1) && content.endsWith(':');
+        int dashes = qMax(1, qMax(MinimumWidth, width) - (left ? 1 : 0) - (right ? 1 : 0));
+        QString delimiter = QString(left ? ":" : "") + QString(dashes, '-') + QString(right ? ":" : "");
+
+        if (delimiter != content) {
+            edit.setPosition(position + cell.contentStart);
+            edit.setPosition(position + cell.contentEnd, QTextCursor::KeepAnchor);
+            edit.insertText(delimiter);
+            contentEnd = cell.contentStart + delimiter.length();
+            changed = true;
+        }
+    }
+
+    int end = cell.end + (contentEnd - cell.contentEnd);
+
+    // Every cell of a column spans the column's width, plus a space on
+    // either side, between its pipes.
+    int trailing = qMax(1, (width + 2) - (contentEnd - cell.start));
+    int current = end - contentEnd;
+
+    if (current < trailing) {
+        edit.setPosition(position + end);
+        edit.insertText(QString(trailing - current, ' '));
+        changed = true;
+    } else if (current > trailing) {
+        edit.setPosition(position + end - (current - trailing));
+        edit.setPosition(position + end, QTextCursor::KeepAnchor);
+        edit.removeSelectedText();
+        changed = true;
+    }
+
+    return changed;
+}
+
+QVector<TableFormatter::Cell> TableFormatter::splitRow(const QString &text)
+{
+    QVector<Cell> cells;
+    int i = 0;
+
+    while ((i < text.length()) && text[i].isSpace()) {
+        i++;
+    }
+
+    if ((i < text.length()) && ('|' == text[i])) {
+        i++;
+    }
+
+    int start = i;
+
+    auto addCell = [&cells, &text](int start, int end, bool closed) {
+        Cell cell;
+        cell.start = start;
+        cell.end = end;
+        cell.closed = closed;
+        cell.contentStart = start;
+        cell.contentEnd = end;
+
+        while ((cell.contentStart < end) && text[cell.contentStart].isSpace()) {
+            cell.contentStart++;
+        }
+
+        while ((cell.contentEnd > cell.contentStart) && text[cell.contentEnd - 1].isSpace()) {
+            cell.contentEnd--;
+        }
+
+        // An empty cell keeps a space before its padding, as other cells do.
+        if (cell.contentStart == cell.contentEnd) {
+            cell.contentStart = cell.contentEnd = qMin(start + 1, end);
+        }
+
+        cells.append(cell);
+    };
+
+    for (; i < text.length(); i++) {
+        if ('\\' == text[i]) {
+            i++;
+        } else if ('|' == text[i]) {
+            addCell(start, i, true);
+            start = i + 1;
+        }
+    }
+
+    if (!text.mid(start).trimmed().isEmpty()) {
+        addCell(start, text.length(), false);
+    }
+
+    return cells;
+}
+
+int TableFormatter::cellAt(const QVector<Cell> &cells, int position)
+{
+    for (int i = 0; i < cells.size(); i++) {
+        if ((position >= cells[i].start) && (position <= cells[i].end)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int TableFormatter::contentWidth(const Cell &cell)
+{
+    return cell.contentEnd - cell.contentStart;
+}
+} // namespace ghostwriter
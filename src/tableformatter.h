@@ -0,0 +1,161 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TABLEFORMATTER_H
+#define TABLEFORMATTER_H
+
+#include <QObject>
+#include <QString>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QVector>
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+
+/**
+ * Keeps the columns of a document's pipe tables aligned as their cells are
+ * edited.
+ *
+ * The formatter indexes the width of each column of the tables it formats,
+ * found from the table's rows once, when the table is first edited.  An edit
+ * to a cell then only re-pads that cell to its column's width, unless the
+ * cell outgrows the column, in which case only that column is re-padded in
+ * the other rows of the table.  Edits spanning several lines that the
+ * formatter did not make itself discard the index, as they may add or
+ * remove rows.
+ */
+class TableFormatter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.
+     */
+    explicit TableFormatter(MarkdownDocument *document);
+
+    /**
+     * Destructor.
+     */
+    virtual ~TableFormatter();
+
+    /**
+     * Re-pads the table cell at the given cursor, which was just edited,
+     * joining the change with the previous edit of the document so that
+     * both are undone together.  The cursor keeps its position within its
+     * line.  Returns true if the document was changed, or false if the
+     * cursor is not in a pipe table's row.
+     */
+    bool alignCell(QTextCursor &cursor);
+
+    /**
+     * Pads every cell of the table at the given cursor to the width of its
+     * column, as a single edit.  The cursor keeps its position within its
+     * line.  Returns true if the document was changed.
+     */
+    bool formatTable(QTextCursor &cursor);
+
+private:
+    // Cell of a table row.  The cell spans from after its opening pipe
+    // (or from the start of the line) to its closing pipe (or to the end of
+    // the line), and its content is the cell's text without the whitespace
+    // around it.
+    struct Cell
+    {
+        int start;
+        int end;
+        int contentStart;
+        int contentEnd;
+        bool closed;
+    };
+
+    // Column widths of a table, indexed by the table's first line.
+    struct Table
+    {
+        QTextBlock first;
+        int rowCount;
+        QVector<int> widths;
+    };
+
+    // Narrowest that a delimiter row's cell can be.
+    static const int MinimumWidth = 3;
+
+    // Most tables indexed at once.  The least recently formatted table is
+    // dropped from the index when another is formatted.
+    static const int MaxIndexedTables = 16;
+
+    MarkdownDocument *document;
+    QVector<Table> tables;
+
+    // Whether the document is being changed by the formatter.
+    bool formatting;
+
+    // Revision and block count of the document at its last change.
+    int changeRevision;
+    int blockCount;
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+    /*
+    * Returns the index entry of the table containing the given block,
+    * indexing the table first if needed, or nullptr if the block is not in
+    * a pipe table.
+    */
+    Table *tableAt(const QTextBlock &block);
+
+    /*
+    * Finds the first line and the number of rows of the pipe table
+    * containing the given block from the document's AST.  Returns false if
+    * the block is not in a pipe table.
+    */
+    bool findTable(const QTextBlock &block, QTextBlock &first, int &rowCount) const;
+
+    /*
+    * Pads the given cell of the given row to the given width, widening or
+    * narrowing the dashes instead if the row is the delimiter row.  Returns
+    * true if the row was changed.
+    */
+    bool padCell
+    (
+        QTextCursor &edit,
+        const QTextBlock &block,
+        const Cell &cell,
+        int width,
+        bool delimiterRow
+    ) const;
+
+    /*
+    * Splits the given table row into its cells.  Escaped pipes do not
+    * separate cells.
+    */
+    static QVector<Cell> splitRow(const QString &text);
+
+    /*
+    * Returns the index of the cell of the given row containing the given
+    * position within the row, or -1 if none does.
+    */
+    static int cellAt(const QVector<Cell> &cells, int position);
+
+    static int contentWidth(const Cell &cell);
+};
+} // namespace ghostwriter
+
+#endif // TABLEFORMATTER_H
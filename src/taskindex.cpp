@@ -0,0 +1,367 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <algorithm>
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QTextBlock>
+#include <QTextCursor>
+
+#include "markdownast.h"
+#include "markdowndocument.h"
+#include "markdownnode.h"
+#include "taskindex.h"
+#include "textblockdata.h"
+#include "tracer.h"
+
+namespace ghostwriter
+{
+class TaskIndexPrivate
+{
+    Q_DECLARE_PUBLIC(TaskIndex)
+
+public:
+    TaskIndexPrivate(TaskIndex *q_ptr)
+        : q_ptr(q_ptr)
+    {
+        ;
+    }
+
+    ~TaskIndexPrivate()
+    {
+        ;
+    }
+
+    // Task of a block.  Its line is found from the block when listed,
+    // since it shifts as lines are added and removed above it.
+    struct Entry
+    {
+        bool complete;
+        QString text;
+    };
+
+    TaskIndex *q_ptr;
+    MarkdownDocument *document;
+
+    // Range of the document left to index, tracked with cursors so that it
+    // moves with edits, or null cursors if there is none.
+    QTextCursor pendingStart;
+    QTextCursor pendingEnd;
+
+    // Revision of the document at its last change.
+    int changeRevision;
+
+    QHash<TextBlockData *, Entry> entries;
+    int completeCount;
+
+    // Whether entries were removed along with their blocks since the
+    // last tasksChanged() signal.
+    bool removedSinceChange;
+
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onMarkdownASTChanged();
+    void onTextBlockDataRemoved(TextBlockData *blockData);
+    void markPending(int firstLine, int lastLine);
+    void indexPending();
+    bool removeEntry(TextBlockData *blockData);
+};
+
+TaskIndex::TaskIndex(MarkdownDocument *document, QObject *parent)
+    : QObject(parent),
+      d_ptr(new TaskIndexPrivate(this))
+{
+    Q_D(TaskIndex);
+
+    d->document = document;
+    d->changeRevision = document->revision();
+    d->completeCount = 0;
+    d->removedSinceChange = false;
+
+    this->connect
+    (
+        document,
+        &QTextDocument::contentsChange,
+        this,
+        [d](int position, int charsRemoved, int charsAdded) {
+            d->onContentsChange(position, charsRemoved, charsAdded);
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::markdownASTChanged,
+        this,
+        [d]() {
+            d->onMarkdownASTChanged();
+        }
+    );
+
+    this->connect
+    (
+        document,
+        &MarkdownDocument::textBlockDataRemoved,
+        this,
+        [d](TextBlockData *blockData) {
+            d->onTextBlockDataRemoved(blockData);
+        }
+    );
+
+    if (nullptr != document->markdownAST()) {
+        d->markPending(1, document->blockCount());
+        d->indexPending();
+    }
+}
+
+TaskIndex::~TaskIndex()
+{
+    ;
+}
+
+QVector<TaskIndex::Task> TaskIndex::tasks() const
+{
+    Q_D(const TaskIndex);
+
+    QVector<Task> tasks;
+    tasks.reserve(d->entries.size());
+
+    for (auto i = d->entries.constBegin(); i != d->entries.constEnd(); i++) {
+        Task task;
+        task.line = i.key()->blockRef.blockNumber() + 1;
+        task.complete = i.value().complete;
+        task.text = i.value().text;
+        tasks.append(task);
+    }
+
+    std::sort
+    (
+        tasks.begin(),
+        tasks.end(),
+        [](const Task &a, const Task &b) {
+            return a.line < b.line;
+        }
+    );
+
+    return tasks;
+}
+
+int TaskIndex::openCount() const
+{
+    Q_D(const TaskIndex);
+
+    return d->entries.size() - d->completeCount;
+}
+
+int TaskIndex::completeCount() const
+{
+    Q_D(const TaskIndex);
+
+    return d->completeCount;
+}
+
+void TaskIndexPrivate::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // Highlighting also signals a change to the contents, without changing
+    // the text.  See MarkdownDocument::onContentsChange().
+    if
+    (
+        (charsRemoved == charsAdded)
+        && (charsAdded > 0)
+        && (document->revision() == changeRevision)
+    ) {
+        return;
+    }
+
+    changeRevision = document->revision();
+
+    QTextBlock first = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+
+    markPending(first.blockNumber() + 1, last.blockNumber() + 1);
+}
+
+void TaskIndexPrivate::onMarkdownASTChanged()
+{
+    for (const MarkdownAST::LineRange &range : document->markdownASTChanges()) {
+        markPending(range.first, range.second);
+    }
+
+    indexPending();
+}
+
+void TaskIndexPrivate::onTextBlockDataRemoved(TextBlockData *blockData)
+{
+    // Only forget the entry here, as the block is being freed in the
+    // middle of an edit.  Listeners hear of it with the next AST.
+    if (removeEntry(blockData)) {
+        removedSinceChange = true;
+    }
+}
+
+// Adds the given range of lines to the range left to index.
+//
+void TaskIndexPrivate::markPending(int firstLine, int lastLine)
+{
+    QTextBlock first = document->findBlockByNumber(firstLine - 1);
+    QTextBlock last = document->findBlockByNumber(lastLine - 1);
+
+    if (!first.isValid()) {
+        first = document->firstBlock();
+    }
+
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+
+    if (pendingStart.isNull()) {
+        pendingStart = QTextCursor(document);
+        pendingEnd = QTextCursor(document);
+        pendingStart.setPosition(first.position());
+        pendingEnd.setPosition(last.position());
+        return;
+    }
+
+    pendingStart.setPosition(qMin(pendingStart.position(), first.position()));
+    pendingEnd.setPosition(qMax(pendingEnd.position(), last.position()));
+}
+
+// Indexes the tasks of the lines left to index from the document's AST.
+//
+void TaskIndexPrivate::indexPending()
+{
+    Q_Q(TaskIndex);
+
+    const MarkdownAST *ast = document->markdownAST();
+
+    if (pendingStart.isNull() || (nullptr == ast) || (nullptr == ast->root())) {
+        return;
+    }
+
+    GW_TRACE_SCOPE("TaskIndex::indexPending");
+
+    // Matches the list marker and check box of a task list item, and
+    // captures whether it is checked and the task's text.
+    static const QRegularExpression taskRegex
+    (
+        "^\\s*(?:[-+*]|\\d{1,9}[.)])\\s+\\[([ xX])\\](?:\\s+(.*))?$"
+    );
+
+    QTextBlock first = pendingStart.block();
+    QTextBlock last = pendingEnd.block();
+    pendingStart = QTextCursor();
+    pendingEnd = QTextCursor();
+
+    int firstLine = first.blockNumber() + 1;
+    int lastLine = last.blockNumber() + 1;
+    bool changed = removedSinceChange;
+    removedSinceChange = false;
+
+    // Tasks of the range are found afresh, so set the old ones aside to
+    // tell whether any of them actually changed.
+    QHash<TextBlockData *, Entry> previous;
+
+    for (QTextBlock block = first; block.isValid(); block = block.next()) {
+        TextBlockData *blockData = (TextBlockData *) block.userData();
+
+        if ((nullptr != blockData) && entries.contains(blockData)) {
+            previous.insert(blockData, entries.value(blockData));
+            removeEntry(blockData);
+        }
+
+        if (block == last) {
+            break;
+        }
+    }
+
+    // Items of a list that starts before the range are walked as well, so
+    // skip the ones outside of it.
+    for (const MarkdownNode *item : ast->nodesInLineRange<MarkdownNode::TaskListItem>(firstLine, lastLine)) {
+        if ((item->startLine() < firstLine) || (item->startLine() > lastLine)) {
+            continue;
+        }
+
+        QTextBlock block = document->findBlockByNumber(item->startLine() - 1);
+        QRegularExpressionMatch match = taskRegex.match(block.text());
+
+        if (!block.isValid() || !match.hasMatch()) {
+            continue;
+        }
+
+        TextBlockData *blockData = (TextBlockData *) block.userData();
+
+        if (nullptr == blockData) {
+            blockData = new TextBlockData(document, block);
+            block.setUserData(blockData);
+        }
+
+        Entry entry;
+        entry.complete = (match.captured(1) != " ");
+        entry.text = match.captured(2).trimmed();
+        entries.insert(blockData, entry);
+
+        if (entry.complete) {
+            completeCount++;
+        }
+
+        auto old = previous.find(blockData);
+
+        if
+        (
+            (previous.end() == old)
+            || (old.value().complete != entry.complete)
+            || (old.value().text != entry.text)
+        ) {
+            changed = true;
+        }
+
+        if (previous.end() != old) {
+            previous.erase(old);
+        }
+    }
+
+    // Tasks set aside that were not found again are gone.
+    if (changed || !previous.isEmpty()) {
+        emit q->tasksChanged();
+    }
+}
+
+// Forgets the task of the given block, if any, returning true if there
+// was one.
+//
+bool TaskIndexPrivate::removeEntry(TextBlockData *blockData)
+{
+    auto entry = entries.find(blockData);
+
+    if (entries.end() == entry) {
+        return false;
+    }
+
+    if (entry.value().complete) {
+        completeCount--;
+    }
+
+    entries.erase(entry);
+    return true;
+}
+} // namespace ghostwriter
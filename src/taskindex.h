@@ -0,0 +1,98 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TASK_INDEX_H
+#define TASK_INDEX_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+
+/**
+ * Index of the task list items (i.e., "- [ ]" and "- [x]") of a document.
+ *
+ * The index follows the TaskListItem nodes of the document's AST.  When the
+ * AST changes, only the lines that were edited or whose structure changed
+ * are indexed again, so that keeping the index current costs as much as the
+ * edit rather than as much as the document.
+ */
+class TaskIndexPrivate;
+class TaskIndex : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(TaskIndex)
+
+public:
+    /**
+     * Task list item of the document.
+     */
+    struct Task
+    {
+        // Line number of the task, starting from 1.
+        int line;
+
+        // Whether the task is checked off.
+        bool complete;
+
+        // Text of the task, following its check box.
+        QString text;
+    };
+
+    /**
+     * Constructor.  Pass in the document to index.
+     */
+    TaskIndex(MarkdownDocument *document, QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~TaskIndex();
+
+    /**
+     * Returns all the tasks of the document, in order of line.
+     */
+    QVector<Task> tasks() const;
+
+    /**
+     * Returns the number of tasks that are not checked off.
+     */
+    int openCount() const;
+
+    /**
+     * Returns the number of tasks that are checked off.
+     */
+    int completeCount() const;
+
+signals:
+    /**
+     * Emitted when tasks are added, removed or changed.
+     */
+    void tasksChanged();
+
+private:
+    QScopedPointer<TaskIndexPrivate> d_ptr;
+};
+} // namespace ghostwriter
+
+#endif // TASK_INDEX_H
@@ -0,0 +1,167 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QTextBlock>
+
+#include "tasklistwidget.h"
+
+namespace ghostwriter
+{
+// Role of the item data holding the line of each task.
+static const int LINE_ROLE = Qt::UserRole + 1;
+
+TaskListWidget::TaskListWidget
+(
+    TaskIndex *index,
+    MarkdownEditor *editor,
+    QWidget *parent
+) : QTreeWidget(parent),
+    index(index),
+    editor(editor),
+    stale(false)
+{
+    this->setColumnCount(1);
+    this->setHeaderHidden(true);
+    this->setUniformRowHeights(true);
+    this->setTextElideMode(Qt::ElideRight);
+
+    openItem = new QTreeWidgetItem(this);
+    completeItem = new QTreeWidgetItem(this);
+    openItem->setExpanded(true);
+    completeItem->setExpanded(false);
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(RefreshInterval);
+
+    this->connect
+    (
+        refreshTimer,
+        &QTimer::timeout,
+        [this]() {
+            refresh();
+        }
+    );
+
+    this->connect
+    (
+        index,
+        &TaskIndex::tasksChanged,
+        this,
+        [this]() {
+            scheduleRefresh();
+        }
+    );
+
+    this->connect
+    (
+        this,
+        &TaskListWidget::itemActivated,
+        [this](QTreeWidgetItem *item) {
+            onItemActivated(item);
+        }
+    );
+
+    this->connect
+    (
+        this,
+        &TaskListWidget::itemClicked,
+        [this](QTreeWidgetItem *item) {
+            onItemActivated(item);
+        }
+    );
+
+    refresh();
+}
+
+TaskListWidget::~TaskListWidget()
+{
+    ;
+}
+
+void TaskListWidget::showEvent(QShowEvent *event)
+{
+    QTreeWidget::showEvent(event);
+
+    if (stale) {
+        refresh();
+    }
+}
+
+void TaskListWidget::refresh()
+{
+    stale = false;
+
+    qDeleteAll(openItem->takeChildren());
+    qDeleteAll(completeItem->takeChildren());
+
+    QVector<TaskIndex::Task> tasks;
+
+    if (index) {
+        tasks = index->tasks();
+    }
+
+    QList<QTreeWidgetItem *> openTasks;
+    QList<QTreeWidgetItem *> completeTasks;
+
+    for (const TaskIndex::Task &task : tasks) {
+        QTreeWidgetItem *item = new QTreeWidgetItem();
+        item->setText(0, task.text.isEmpty() ? tr("Line %1").arg(task.line) : task.text);
+        item->setToolTip(0, tr("Line %1: %2").arg(task.line).arg(task.text));
+        item->setData(0, LINE_ROLE, task.line);
+
+        if (task.complete) {
+            completeTasks.append(item);
+        } else {
+            openTasks.append(item);
+        }
+    }
+
+    openItem->addChildren(openTasks);
+    completeItem->addChildren(completeTasks);
+    openItem->setText(0, tr("Open (%1)").arg(openTasks.size()));
+    completeItem->setText(0, tr("Done (%1)").arg(completeTasks.size()));
+}
+
+void TaskListWidget::scheduleRefresh()
+{
+    if (isVisible()) {
+        refreshTimer->start();
+    } else {
+        stale = true;
+    }
+}
+
+void TaskListWidget::onItemActivated(QTreeWidgetItem *item)
+{
+    // Make sure editor and document haven't been deleted, and skip the
+    // group items.
+    if (!editor || (nullptr == item) || (nullptr == item->parent())) {
+        return;
+    }
+
+    QTextBlock block =
+        editor->document()->findBlockByNumber(item->data(0, LINE_ROLE).toInt() - 1);
+
+    if (block.isValid()) {
+        editor->navigateDocument(block.position());
+        editor->setFocus();
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,92 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TASK_LIST_WIDGET_H
+#define TASK_LIST_WIDGET_H
+
+#include <QPointer>
+#include <QTimer>
+#include <QTreeWidget>
+
+#include "markdowneditor.h"
+#include "taskindex.h"
+
+namespace ghostwriter
+{
+/**
+ * Sidebar list of the open and completed tasks of a TaskIndex, with their
+ * counts, for use in navigating to them in the editor.
+ */
+class TaskListWidget : public QTreeWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.  Lists the tasks of the given index, which indexes the
+     * given editor's document.
+     */
+    TaskListWidget
+    (
+        TaskIndex *index,
+        MarkdownEditor *editor,
+        QWidget *parent = nullptr
+    );
+
+    /**
+     * Destructor.
+     */
+    virtual ~TaskListWidget();
+
+protected:
+    void showEvent(QShowEvent *event);
+
+private:
+    // Interval, in milliseconds, over which changes to the tasks are
+    // gathered before the list is rebuilt.
+    static const int RefreshInterval = 250;
+
+    QPointer<TaskIndex> index;
+    QPointer<MarkdownEditor> editor;
+    QTimer *refreshTimer;
+    QTreeWidgetItem *openItem;
+    QTreeWidgetItem *completeItem;
+
+    // Whether the tasks changed while the widget was hidden, so that the
+    // list is rebuilt once it is shown.
+    bool stale;
+
+    /*
+    * Rebuilds the list from the index's tasks.
+    */
+    void refresh();
+
+    /*
+    * Rebuilds the list once shown, or shortly if already shown.
+    */
+    void scheduleRefresh();
+
+    /*
+    * Moves the editor's cursor to the task of the given item.
+    */
+    void onItemActivated(QTreeWidgetItem *item);
+};
+} // namespace ghostwriter
+
+#endif // TASK_LIST_WIDGET_H
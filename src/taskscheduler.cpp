@@ -0,0 +1,163 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include "taskscheduler.h"
+
+namespace ghostwriter
+{
+// Priorities in the global thread pool of the lanes that share it.
+static const int LANE_PRIORITIES[TaskScheduler::LaneCount] = { 4, 3, 2, 1, 0 };
+
+TaskScheduler *TaskScheduler::instance()
+{
+    static TaskScheduler scheduler;
+    return &scheduler;
+}
+
+TaskScheduler::CancellationToken TaskScheduler::createCancellationToken()
+{
+    return CancellationToken(new QAtomicInt(0));
+}
+
+void TaskScheduler::cancel(const CancellationToken &token)
+{
+    if (!token.isNull()) {
+        token->storeRelease(1);
+    }
+}
+
+bool TaskScheduler::isCancelled(const CancellationToken &token)
+{
+    return !token.isNull() && (0 != token->loadAcquire());
+}
+
+TaskScheduler::Task::Task(Lane lane, const CancellationToken &token)
+    : lane(lane), token(token)
+{
+    ;
+}
+
+TaskScheduler::Task::~Task()
+{
+    ;
+}
+
+void TaskScheduler::Task::run()
+{
+    if (isCancelled(token) || isFutureCancelled()) {
+        skip();
+    } else {
+        execute();
+    }
+
+    TaskScheduler::instance()->taskFinished(lane);
+}
+
+TaskScheduler::TaskScheduler()
+{
+    int threads = qMax(1, QThread::idealThreadCount());
+
+    // Interactive work may use every core, since the writer is waiting on
+    // it, while each sweep gets a single thread.  The spell check sweep
+    // spreads its blocks across the global pool by itself.
+    interactivePool.setMaxThreadCount(threads);
+
+    for (int i = 0; i < LaneCount; i++) {
+        running[i] = 0;
+        limits[i] = 1;
+        suspended[i] = false;
+    }
+
+    limits[Interactive] = threads;
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    interactivePool.waitForDone();
+}
+
+void TaskScheduler::setLaneSuspended(Lane lane, bool suspended)
+{
+    if (Interactive == lane) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+
+    this->suspended[lane] = suspended;
+    startQueued(lane);
+}
+
+bool TaskScheduler::isLaneSuspended(Lane lane) const
+{
+    QMutexLocker locker(&mutex);
+
+    return suspended[lane];
+}
+
+void TaskScheduler::enqueue(Lane lane, Task *task)
+{
+    QMutexLocker locker(&mutex);
+
+    if (!suspended[lane] && (running[lane] < limits[lane])) {
+        start(lane, task);
+    } else {
+        queued[lane].enqueue(task);
+    }
+}
+
+// Starts the given task.  The mutex must be locked.
+//
+void TaskScheduler::start(Lane lane, Task *task)
+{
+    running[lane]++;
+
+    if (Interactive == lane) {
+        interactivePool.start(task);
+    } else {
+        QThreadPool::globalInstance()->start(task, LANE_PRIORITIES[lane]);
+    }
+}
+
+void TaskScheduler::taskFinished(Lane lane)
+{
+    QMutexLocker locker(&mutex);
+
+    running[lane]--;
+    startQueued(lane);
+}
+
+// Starts queued tasks of the given lane up to its limit, unless the lane
+// is suspended.  The mutex must be locked.
+//
+void TaskScheduler::startQueued(Lane lane)
+{
+    while
+    (
+        !suspended[lane]
+        && (running[lane] < limits[lane])
+        && !queued[lane].isEmpty()
+    ) {
+        start(lane, queued[lane].dequeue());
+    }
+}
+} // namespace ghostwriter
@@ -0,0 +1,251 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QMutex>
+#include <QQueue>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include <functional>
+#include <type_traits>
+
+namespace ghostwriter
+{
+/**
+ * Runs background work for all subsystems in priority lanes, so that work
+ * the writer is waiting on is never held up by sweeps.  Interactive work,
+ * such as parsing, loading and saving, has a thread pool of its own.  The
+ * other lanes share the global thread pool, in which queued work of a
+ * higher lane starts before that of a lower one, and each lane runs at
+ * most a few tasks at once.
+ *
+ * Tasks can be cancelled cooperatively with a cancellation token, which a
+ * task polls while running.  A task whose token is cancelled, or whose
+ * future is cancelled, before it starts is skipped.
+ *
+ * Lanes other than the interactive one can be suspended, such as while
+ * memory runs low, in which case their tasks stay queued until the lane
+ * is resumed.
+ */
+class TaskScheduler
+{
+public:
+    /**
+     * Lanes of work, from the highest priority to the lowest.
+     */
+    typedef enum {
+        Interactive,
+        Preview,
+        Statistics,
+        SpellCheck,
+        Indexing,
+        LaneCount
+    } Lane;
+
+    /**
+     * Flag by which a task is asked to stop.  Tasks poll it with
+     * isCancelled().
+     */
+    typedef QSharedPointer<QAtomicInt> CancellationToken;
+
+    /**
+     * Returns the single instance of the scheduler.
+     */
+    static TaskScheduler *instance();
+
+    /**
+     * Returns a new cancellation token, not yet cancelled.
+     */
+    static CancellationToken createCancellationToken();
+
+    /**
+     * Asks the tasks holding the given token to stop.
+     */
+    static void cancel(const CancellationToken &token);
+
+    /**
+     * Returns true if the given token was cancelled.  A null token is
+     * never cancelled.
+     */
+    static bool isCancelled(const CancellationToken &token);
+
+    /**
+     * Runs the given function in the given lane, returning a future for
+     * its result.  The function is skipped if the token is cancelled
+     * before the function starts.
+     */
+    template <typename Function>
+    QFuture<typename std::result_of<Function()>::type> run
+    (
+        Lane lane,
+        Function function,
+        const CancellationToken &token = CancellationToken()
+    );
+
+    /**
+     * Suspends or resumes starting the queued tasks of the given lane.
+     * Tasks already running are not interrupted.  The interactive lane
+     * cannot be suspended.
+     */
+    void setLaneSuspended(Lane lane, bool suspended);
+
+    /**
+     * Returns true if the given lane is suspended.
+     */
+    bool isLaneSuspended(Lane lane) const;
+
+private:
+    // Queued task of a lane.
+    class Task : public QRunnable
+    {
+    public:
+        Task(Lane lane, const CancellationToken &token);
+        virtual ~Task();
+
+        void run();
+
+    protected:
+        virtual bool isFutureCancelled() const = 0;
+        virtual void execute() = 0;
+        virtual void skip() = 0;
+
+    private:
+        Lane lane;
+        CancellationToken token;
+    };
+
+    template <typename T>
+    class FunctionTask : public Task
+    {
+    public:
+        FunctionTask(Lane lane, const std::function<T()> &function, const CancellationToken &token)
+            : Task(lane, token), function(function)
+        {
+            futureInterface.reportStarted();
+        }
+
+        QFuture<T> future()
+        {
+            return futureInterface.future();
+        }
+
+    protected:
+        bool isFutureCancelled() const
+        {
+            return futureInterface.isCanceled();
+        }
+
+        void execute()
+        {
+            T result = function();
+            futureInterface.reportResult(result);
+            futureInterface.reportFinished();
+        }
+
+        void skip()
+        {
+            futureInterface.reportCanceled();
+            futureInterface.reportFinished();
+        }
+
+    private:
+        std::function<T()> function;
+        QFutureInterface<T> futureInterface;
+    };
+
+    QThreadPool interactivePool;
+    mutable QMutex mutex;
+    int running[LaneCount];
+    int limits[LaneCount];
+    bool suspended[LaneCount];
+    QQueue<Task *> queued[LaneCount];
+
+    TaskScheduler();
+    ~TaskScheduler();
+
+    void enqueue(Lane lane, Task *task);
+    void start(Lane lane, Task *task);
+    void startQueued(Lane lane);
+    void taskFinished(Lane lane);
+};
+
+template <>
+class TaskScheduler::FunctionTask<void> : public TaskScheduler::Task
+{
+public:
+    FunctionTask(Lane lane, const std::function<void()> &function, const CancellationToken &token)
+        : Task(lane, token), function(function)
+    {
+        futureInterface.reportStarted();
+    }
+
+    QFuture<void> future()
+    {
+        return futureInterface.future();
+    }
+
+protected:
+    bool isFutureCancelled() const
+    {
+        return futureInterface.isCanceled();
+    }
+
+    void execute()
+    {
+        function();
+        futureInterface.reportFinished();
+    }
+
+    void skip()
+    {
+        futureInterface.reportCanceled();
+        futureInterface.reportFinished();
+    }
+
+private:
+    std::function<void()> function;
+    QFutureInterface<void> futureInterface;
+};
+
+template <typename Function>
+QFuture<typename std::result_of<Function()>::type> TaskScheduler::run
+(
+    Lane lane,
+    Function function,
+    const CancellationToken &token
+)
+{
+    typedef typename std::result_of<Function()>::type Result;
+
+    FunctionTask<Result> *task = new FunctionTask<Result>(lane, function, token);
+    QFuture<Result> future = task->future();
+
+    enqueue(lane, task);
+    return future;
+}
+} // namespace ghostwriter
+
+#endif // TASK_SCHEDULER_H
@@ -20,21 +20,31 @@
 #ifndef TEXTBLOCKDATA_H
 #define TEXTBLOCKDATA_H
 
-#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
 #include <QTextBlock>
 #include <QTextBlockUserData>
+#include <QTextLayout>
+#include <QVector>
 
 #include "markdowndocument.h"
+#include "markdownlinter.h"
+#include "readabilityanalyzer.h"
 
 namespace ghostwriter
 {
 /**
  * User data for use with the MarkdownHighlighter and DocumentStatistics.
+ *
+ * Every block of the document carries an instance, so this class is kept
+ * plain and compact:  it is not a QObject, its fields are ordered to avoid
+ * padding, and its flags are packed into bit fields.  Data that only some
+ * blocks have is held in implicitly shared containers, which cost a single
+ * pointer while empty.
  */
-class TextBlockData : public QObject, public QTextBlockUserData
+class TextBlockData : public QTextBlockUserData
 {
-    Q_OBJECT
-
 public:
     /**
      * Constructor.
@@ -46,7 +56,18 @@ public:
         alphaNumericCharacterCount = 0;
         sentenceCount = 0;
         lixLongWordCount = 0;
+        highlightKey = 0;
+        highlightState = -1;
+        spellingTextHash = 0;
+        spellingGeneration = 0;
+        spellCheckQueuedGeneration = 0;
+        spellingDictionary = 0;
         blankLine = true;
+        highlightCached = false;
+        highlightApplied = false;
+        spellingChecked = false;
+        spellCheckQueued = false;
+        folded = false;
     }
 
     /**
@@ -54,22 +75,114 @@ public:
      */
     virtual ~TextBlockData()
     {
-        document->notifyTextBlockRemoved(blockRef);
+        document->notifyTextBlockRemoved(this);
     }
 
     MarkdownDocument *document;
 
+    /**
+     * Parent text block.  For use with fetching the block's document
+     * position, which can shift as text is inserted and deleted.
+     */
+    QTextBlock blockRef;
+
+    /**
+     * Formats last computed for this block by the MarkdownHighlighter.
+     * See highlightKey below.
+     */
+    QVector<QTextLayout::FormatRange> highlightFormats;
+
+    /**
+     * Positions and lengths of the misspelled words in this block, as last
+     * reported by the spell check service.  See spellingTextHash below.
+     */
+    QVector<QPair<int, int>> misspellings;
+
+    /**
+     * Positions and lengths of the prose in this block, i.e., its text
+     * outside of code, URLs and HTML, as found by the MarkdownHighlighter
+     * alongside the highlight formats above.  Only prose is spell checked.
+     */
+    QVector<QPair<int, int>> proseRanges;
+
+    /**
+     * Normalized label of the reference link or footnote defined by this
+     * block, if any, and the labels that the block refers to, as indexed
+     * by the document's ReferenceIndex.
+     */
+    QString referenceDefinition;
+    QStringList referencedLabels;
+
+    /**
+     * Case folded words of the block, sorted, as indexed by the document's
+     * VocabularyIndex.  The strings share their data with the index.
+     */
+    QStringList vocabulary;
+
+    /**
+     * Style warnings found in this block by the MarkdownLinter.
+     */
+    QVector<MarkdownLinter::Warning> lintWarnings;
+
+    /**
+     * Sentences of this block that are hard to read, as found by the
+     * ReadabilityAnalyzer.
+     */
+    QVector<ReadabilityAnalyzer::Sentence> difficultSentences;
+
+    /**
+     * Statistics of the block, as counted by DocumentStatistics.
+     */
     int wordCount;
     int alphaNumericCharacterCount;
     int sentenceCount;
     int lixLongWordCount;
-    bool blankLine;
 
     /**
-     * Parent text block.  For use with fetching the block's document
-     * position, which can shift as text is inserted and deleted.
+     * Block state resulting from the highlight formats above, and the key
+     * (a hash of the inputs to the highlighting) that they were computed
+     * for.  The highlighter reuses them for as long as the key remains the
+     * same.
      */
-    QTextBlock blockRef;
+    uint highlightKey;
+    int highlightState;
+
+    /**
+     * Hash of the text and the MarkdownHighlighter's spelling generation
+     * that the misspellings above were found for, the spelling generation
+     * in which the block was last queued to be checked, and the index of
+     * the dictionary whose language was detected for the block (0 for the
+     * main dictionary).
+     */
+    uint spellingTextHash;
+    uint spellingGeneration;
+    uint spellCheckQueuedGeneration;
+    qint16 spellingDictionary;
+
+    /**
+     * Whether the block is blank, as counted by DocumentStatistics.
+     */
+    bool blankLine : 1;
+
+    /**
+     * Whether the highlight formats above are cached, and whether they are
+     * the formats currently applied to the block.
+     */
+    bool highlightCached : 1;
+    bool highlightApplied : 1;
+
+    /**
+     * Whether the misspellings above were reported, and whether the block
+     * is queued to be checked.
+     */
+    bool spellingChecked : 1;
+    bool spellCheckQueued : 1;
+
+    /**
+     * Whether this block is a heading whose section is folded in the
+     * MarkdownEditor, i.e., whether the blocks of the section are hidden.
+     */
+    bool folded : 1;
 };
 } // namespace ghostwriter
 
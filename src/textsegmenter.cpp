@@ -0,0 +1,218 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QTextBoundaryFinder>
+
+#ifdef GW_USE_ICU
+#include <QThreadStorage>
+
+#include <unicode/brkiter.h>
+#include <unicode/locid.h>
+#include <unicode/utext.h>
+#endif
+
+#include "textsegmenter.h"
+
+namespace ghostwriter
+{
+namespace
+{
+// Adds the segment of the given text from start to end to the given
+// counts if it has letters or numbers.
+//
+void addWord(const QString &text, int start, int end, TextTokenizer::Counts &counts)
+{
+    int letterOrNumberCount = 0;
+
+    for (int i = start; i < end; i++) {
+        if (text[i].isLetterOrNumber()) {
+            letterOrNumberCount++;
+        }
+    }
+
+    if (letterOrNumberCount <= 0) {
+        return;
+    }
+
+    counts.words++;
+    counts.alphaNumericCharacters += letterOrNumberCount;
+
+    if ((end - start) > TextTokenizer::LongWordLength) {
+        counts.longWords++;
+    }
+}
+
+#ifdef GW_USE_ICU
+// Break iterators of a thread, which are costly to create, since they load
+// their rules and dictionaries.  They are reset to each new text instead.
+//
+struct BreakIterators
+{
+    icu::BreakIterator *words;
+    icu::BreakIterator *sentences;
+
+    BreakIterators()
+    {
+        UErrorCode status = U_ZERO_ERROR;
+        words = icu::BreakIterator::createWordInstance(icu::Locale::getRoot(), status);
+
+        status = U_ZERO_ERROR;
+        sentences = icu::BreakIterator::createSentenceInstance(icu::Locale::getRoot(), status);
+    }
+
+    ~BreakIterators()
+    {
+        delete words;
+        delete sentences;
+    }
+};
+
+QThreadStorage<BreakIterators *> breakIterators;
+
+BreakIterators *localBreakIterators()
+{
+    if (!breakIterators.hasLocalData()) {
+        breakIterators.setLocalData(new BreakIterators());
+    }
+
+    return breakIterators.localData();
+}
+
+// Counts the words and sentences of the given text with the given ICU
+// break iterators.
+//
+void countWithIcu
+(
+    const QString &text,
+    BreakIterators *iterators,
+    TextTokenizer::Counts &counts
+)
+{
+    // Let the iterators read the text in place rather than copy it.
+    UErrorCode status = U_ZERO_ERROR;
+    UText *utext = utext_openUChars
+        (
+            nullptr,
+            reinterpret_cast<const UChar *>(text.utf16()),
+            text.length(),
+            &status
+        );
+
+    iterators->words->setText(utext, status);
+    iterators->sentences->setText(utext, status);
+
+    if (U_FAILURE(status)) {
+        utext_close(utext);
+        return;
+    }
+
+    int start = iterators->words->first();
+
+    for
+    (
+        int end = iterators->words->next();
+        icu::BreakIterator::DONE != end;
+        start = end, end = iterators->words->next()
+    ) {
+        // Skip spaces and punctuation.
+        if (iterators->words->getRuleStatus() >= UBRK_WORD_NONE_LIMIT) {
+            addWord(text, start, end, counts);
+        }
+    }
+
+    start = iterators->sentences->first();
+
+    for
+    (
+        int end = iterators->sentences->next();
+        icu::BreakIterator::DONE != end;
+        start = end, end = iterators->sentences->next()
+    ) {
+        for (int i = start; i < end; i++) {
+            if (!text[i].isSpace()) {
+                counts.sentences++;
+                break;
+            }
+        }
+    }
+
+    utext_close(utext);
+}
+#endif
+} // namespace
+
+bool TextSegmenter::needsSegmentation(const QString &text)
+{
+    const ushort *chars = text.utf16();
+    int length = text.length();
+
+    for (int i = 0; i < length; i++) {
+        if ((chars[i] >= 0x0E00) && isUnspacedScript(chars[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+TextTokenizer::Counts TextSegmenter::count(const QString &text)
+{
+    TextTokenizer::Counts counts;
+    counts.words = 0;
+    counts.longWords = 0;
+    counts.alphaNumericCharacters = 0;
+    counts.sentences = 0;
+
+#ifdef GW_USE_ICU
+    BreakIterators *iterators = localBreakIterators();
+
+    if ((nullptr != iterators->words) && (nullptr != iterators->sentences)) {
+        countWithIcu(text, iterators, counts);
+        return counts;
+    }
+#endif
+
+    QTextBoundaryFinder boundaryFinder(QTextBoundaryFinder::Word, text);
+    int start = 0;
+    int end = boundaryFinder.toNextBoundary();
+
+    while (end >= 0) {
+        addWord(text, start, end, counts);
+        start = end;
+        end = boundaryFinder.toNextBoundary();
+    }
+
+    counts.sentences = TextTokenizer::countSentences(text);
+    return counts;
+}
+
+bool TextSegmenter::isUnspacedScript(const ushort c)
+{
+    return
+        ((c >= 0x0E00) && (c <= 0x0FFF)) // Thai, Lao and Tibetan
+        || ((c >= 0x1000) && (c <= 0x109F)) // Myanmar
+        || ((c >= 0x1780) && (c <= 0x17FF)) // Khmer
+        || ((c >= 0x3040) && (c <= 0x30FF)) // Hiragana and Katakana
+        || ((c >= 0x31F0) && (c <= 0x31FF)) // Katakana extensions
+        || ((c >= 0x3400) && (c <= 0x4DBF)) // CJK extension A
+        || ((c >= 0x4E00) && (c <= 0x9FFF)) // CJK unified ideographs
+        || ((c >= 0xF900) && (c <= 0xFAFF)) // CJK compatibility ideographs
+        || ((c >= 0xD840) && (c <= 0xD87F)); // CJK extensions B to F (high surrogates)
+}
+} // namespace ghostwriter
@@ -0,0 +1,67 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TEXTSEGMENTER_H
+#define TEXTSEGMENTER_H
+
+#include <QString>
+
+#include "texttokenizer.h"
+
+namespace ghostwriter
+{
+/**
+ * Counts the words and sentences of text in scripts that are written
+ * without spaces between words, such as Chinese, Japanese and Thai, for
+ * which the heuristics of TextTokenizer find a whole line to be one word.
+ *
+ * Where ghostwriter is built with ICU, text is segmented by ICU's
+ * dictionary-based break iterators.  Each thread creates its iterators
+ * once and resets them to each new text.  Otherwise, text is segmented by
+ * QTextBoundaryFinder, which breaks between every ideograph.
+ *
+ * Segmenting is much slower than the heuristics, so TextTokenizer only
+ * segments text for which needsSegmentation() is true.  The counts are
+ * kept per block by the document statistics, so only edited blocks are
+ * segmented again.
+ */
+class TextSegmenter
+{
+public:
+    /**
+     * Returns true if the given text has characters of a script that is
+     * written without spaces.  Text of characters below U+0E00, such as
+     * ASCII text, is rejected on the first pass.
+     */
+    static bool needsSegmentation(const QString &text);
+
+    /**
+     * Counts the words, long words, alphanumeric characters and sentences
+     * of the given text.
+     */
+    static TextTokenizer::Counts count(const QString &text);
+
+private:
+    TextSegmenter();
+
+    static bool isUnspacedScript(const ushort c);
+};
+} // namespace ghostwriter
+
+#endif // TEXTSEGMENTER_H
@@ -0,0 +1,322 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QTextBoundaryFinder>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define TOKENIZER_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TOKENIZER_NEON
+#endif
+
+#include "textsegmenter.h"
+#include "texttokenizer.h"
+
+namespace ghostwriter
+{
+bool TextTokenizer::nextWord(const QString &text, int start, Word &word)
+{
+    const QChar *data = text.constData();
+    int length = text.length();
+    int i = start;
+
+    while (i < length) {
+        ushort c = data[i].unicode();
+
+        if ((c < 0x80) ? isAsciiWordCharacter(c) : isWordCharacter(data[i])) {
+            break;
+        }
+
+        i++;
+    }
+
+    if (i >= length) {
+        return false;
+    }
+
+    word.position = i;
+    word.letterOrNumberCount = 0;
+    word.hasNumber = false;
+    word.hasLowercase = false;
+
+    int end = i;
+
+    while (i < length) {
+        // Most words are entirely ASCII, which is classified many
+        // characters at a time.
+        int run = asciiWordRunLength(data + i, length - i, word);
+
+        if (run > 0) {
+            i += run;
+            end = i;
+            continue;
+        }
+
+        QChar c = data[i];
+
+        if ((c.unicode() >= 0x80) && isWordCharacter(c)) {
+            if (c.isNumber()) {
+                word.hasNumber = true;
+                word.letterOrNumberCount++;
+            } else if (c.isLetter()) {
+                word.hasLowercase = word.hasLowercase || c.isLower();
+                word.letterOrNumberCount++;
+            }
+
+            i++;
+            end = i;
+        } else if
+        (
+            isInnerSeparator(c)
+            && ((i + 1) < length)
+            && isWordCharacter(data[i + 1])
+        ) {
+            i++;
+        } else {
+            break;
+        }
+    }
+
+    word.length = end - word.position;
+    return true;
+}
+
+TextTokenizer::Counts TextTokenizer::count(const QString &text)
+{
+    // Text in scripts without spaces between words would otherwise count
+    // as one word per line.
+    if (TextSegmenter::needsSegmentation(text)) {
+        return TextSegmenter::count(text);
+    }
+
+    Counts counts;
+    counts.words = 0;
+    counts.longWords = 0;
+    counts.alphaNumericCharacters = 0;
+
+    Word word;
+    int pos = 0;
+
+    while (nextWord(text, pos, word)) {
+        counts.words++;
+        counts.alphaNumericCharacters += word.letterOrNumberCount;
+
+        if (word.length > LongWordLength) {
+            counts.longWords++;
+        }
+
+        pos = word.position + word.length;
+    }
+
+    counts.sentences = countSentences(text);
+
+    return counts;
+}
+
+int TextTokenizer::countSentences(const QString &text)
+{
+    int count = 0;
+
+    QString trimmedText = text.trimmed();
+
+    if (trimmedText.length() > 0) {
+        QTextBoundaryFinder boundaryFinder(QTextBoundaryFinder::Sentence, trimmedText);
+        int nextSentencePos = 0;
+
+        boundaryFinder.setPosition(0);
+
+        while (nextSentencePos >= 0) {
+            int oldPos = nextSentencePos;
+            nextSentencePos = boundaryFinder.toNextBoundary();
+
+            if
+            (
+                ((nextSentencePos - oldPos) > 1) ||
+                (((nextSentencePos - oldPos) > 0) &&
+                 !trimmedText[oldPos].isSpace())
+            ) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+QVector<TextTokenizer::Sentence> TextTokenizer::sentences(const QString &text)
+{
+    QVector<Sentence> sentences;
+    QTextBoundaryFinder boundaryFinder(QTextBoundaryFinder::Sentence, text);
+    Word word;
+    int start = 0;
+    int pos = 0;
+
+    while (start < text.length()) {
+        int end = boundaryFinder.toNextBoundary();
+
+        if (end < 0) {
+            end = text.length();
+        }
+
+        int last = end;
+
+        while ((last > start) && text[last - 1].isSpace()) {
+            last--;
+        }
+
+        while ((start < last) && text[start].isSpace()) {
+            start++;
+        }
+
+        if (start < last) {
+            Sentence sentence;
+            sentence.position = start;
+            sentence.length = last - start;
+            sentence.words = 0;
+            sentence.longWords = 0;
+
+            pos = qMax(pos, start);
+
+            while (nextWord(text, pos, word) && (word.position < end)) {
+                sentence.words++;
+
+                if (word.length > LongWordLength) {
+                    sentence.longWords++;
+                }
+
+                pos = word.position + word.length;
+            }
+
+            sentences.append(sentence);
+        }
+
+        start = end;
+    }
+
+    return sentences;
+}
+
+bool TextTokenizer::isWordCharacter(const QChar c)
+{
+    return c.isLetterOrNumber() || c.isMark();
+}
+
+bool TextTokenizer::isAsciiWordCharacter(const ushort c)
+{
+    return
+        ((ushort)(c - '0') < 10)
+        || ((ushort)((c | 0x20) - 'a') < 26);
+}
+
+// Returns the number of ASCII letters and digits at the start of the given
+// characters, adding them to the given word's counts.  Uses SSE2 or NEON
+// where available to classify eight characters per instruction.
+//
+int TextTokenizer::asciiWordRunLength(const QChar *data, int length, Word &word)
+{
+    const ushort *chars = reinterpret_cast<const ushort *>(data);
+    int i = 0;
+
+#if defined(TOKENIZER_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i digitBase = _mm_set1_epi16('0');
+    const __m128i digitRange = _mm_set1_epi16(10 - 1);
+    const __m128i lowerBase = _mm_set1_epi16('a');
+    const __m128i letterRange = _mm_set1_epi16(26 - 1);
+    const __m128i caseBit = _mm_set1_epi16(0x20);
+
+    while ((i + 8) <= length) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chars + i));
+
+        // An unsigned (c - base) <= range, computed with a saturating
+        // subtraction since SSE2 lacks unsigned 16-bit comparisons.
+        __m128i digit = _mm_cmpeq_epi16
+            (_mm_subs_epu16(_mm_sub_epi16(c, digitBase), digitRange), zero);
+        __m128i lower = _mm_cmpeq_epi16
+            (_mm_subs_epu16(_mm_sub_epi16(c, lowerBase), letterRange), zero);
+        __m128i letter = _mm_cmpeq_epi16
+            (
+                _mm_subs_epu16
+                (
+                    _mm_sub_epi16(_mm_or_si128(c, caseBit), lowerBase),
+                    letterRange
+                ),
+                zero
+            );
+
+        if (0xFFFF != _mm_movemask_epi8(_mm_or_si128(digit, letter))) {
+            break;
+        }
+
+        word.hasNumber = word.hasNumber || (0 != _mm_movemask_epi8(digit));
+        word.hasLowercase = word.hasLowercase || (0 != _mm_movemask_epi8(lower));
+        i += 8;
+    }
+#elif defined(TOKENIZER_NEON)
+    const uint16x8_t digitBase = vdupq_n_u16('0');
+    const uint16x8_t digitRange = vdupq_n_u16(10);
+    const uint16x8_t lowerBase = vdupq_n_u16('a');
+    const uint16x8_t letterRange = vdupq_n_u16(26);
+    const uint16x8_t caseBit = vdupq_n_u16(0x20);
+
+    while ((i + 8) <= length) {
+        uint16x8_t c = vld1q_u16(chars + i);
+
+        uint16x8_t digit = vcltq_u16(vsubq_u16(c, digitBase), digitRange);
+        uint16x8_t lower = vcltq_u16(vsubq_u16(c, lowerBase), letterRange);
+        uint16x8_t letter = vcltq_u16
+            (vsubq_u16(vorrq_u16(c, caseBit), lowerBase), letterRange);
+
+        if (0 == vminvq_u16(vorrq_u16(digit, letter))) {
+            break;
+        }
+
+        word.hasNumber = word.hasNumber || (0 != vmaxvq_u16(digit));
+        word.hasLowercase = word.hasLowercase || (0 != vmaxvq_u16(lower));
+        i += 8;
+    }
+#endif
+
+    while ((i < length) && isAsciiWordCharacter(chars[i])) {
+        ushort c = chars[i];
+
+        if ((ushort)(c - '0') < 10) {
+            word.hasNumber = true;
+        } else if ((ushort)(c - 'a') < 26) {
+            word.hasLowercase = true;
+        }
+
+        i++;
+    }
+
+    word.letterOrNumberCount += i;
+    return i;
+}
+
+bool TextTokenizer::isInnerSeparator(const QChar c)
+{
+    return
+        (QChar('-') == c)
+        || (QChar('.') == c)
+        || (QChar('\'') == c)
+        || (QChar(0x2019) == c); // Right single quotation mark
+}
+} // namespace ghostwriter
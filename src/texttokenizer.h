@@ -0,0 +1,126 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TEXTTOKENIZER_H
+#define TEXTTOKENIZER_H
+
+#include <QString>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Splits text into words and sentences.  Shared by the document statistics
+ * and the spell checking dictionaries so that both agree on what a word is.
+ *
+ * A word is a run of letters, numbers and combining marks.  A single dash,
+ * period or apostrophe between two word characters is considered part of
+ * the word, so that hyphenated words, contractions and abbreviations count
+ * as one word, whereas double dashes (`--`) separate words.
+ */
+class TextTokenizer
+{
+public:
+    /**
+     * A word found in a text.
+     */
+    struct Word
+    {
+        // Position and length of the word within the text.
+        int position;
+        int length;
+
+        // Number of letters and numbers in the word, which excludes any
+        // marks and inner separators.
+        int letterOrNumberCount;
+
+        bool hasNumber;
+        bool hasLowercase;
+    };
+
+    /**
+     * Word and sentence counts of a text.
+     */
+    struct Counts
+    {
+        int words;
+
+        // Number of words longer than LongWordLength characters, for
+        // computing the LIX readability score.
+        int longWords;
+
+        int alphaNumericCharacters;
+        int sentences;
+    };
+
+    /**
+     * A sentence found in a text, with the counts of its words needed to
+     * score its readability.
+     */
+    struct Sentence
+    {
+        // Position and length of the sentence within the text, excluding
+        // the whitespace that follows it.
+        int position;
+        int length;
+
+        int words;
+        int longWords;
+    };
+
+    /**
+     * Words longer than this many characters count as long words.
+     */
+    static const int LongWordLength = 6;
+
+    /**
+     * Finds the first word in the given text that starts at or after the
+     * given position.  Returns true and fills in the word if one is found,
+     * or returns false otherwise.
+     */
+    static bool nextWord(const QString &text, int start, Word &word);
+
+    /**
+     * Counts the words, long words, alphanumeric characters and sentences
+     * of the given text.
+     */
+    static Counts count(const QString &text);
+
+    /**
+     * Counts the sentences of the given text.
+     */
+    static int countSentences(const QString &text);
+
+    /**
+     * Splits the given text into its sentences.  Runs of whitespace between
+     * sentences are not sentences of their own.
+     */
+    static QVector<Sentence> sentences(const QString &text);
+
+private:
+    TextTokenizer();
+
+    static bool isWordCharacter(const QChar c);
+    static bool isAsciiWordCharacter(const ushort c);
+    static int asciiWordRunLength(const QChar *data, int length, Word &word);
+    static bool isInnerSeparator(const QChar c);
+};
+} // namespace ghostwriter
+
+#endif // TEXTTOKENIZER_H
@@ -27,6 +27,7 @@
 #include <QLineEdit>
 #include <QDialogButtonBox>
 #include <QPushButton>
+#include <QTimer>
 
 #include "themeeditordialog.h"
 #include "theme.h"
@@ -46,7 +47,7 @@ public:
         ThemeEditorDialog *q_ptr,
         const Theme &theme
     )
-        : q_ptr(q_ptr), theme(theme)
+        : q_ptr(q_ptr), theme(theme), originalTheme(theme), previewed(false)
     {
         Q_Q(ThemeEditorDialog);
     
@@ -54,6 +55,10 @@ public:
         this->darkColors = theme.darkColorScheme();
         this->oldThemeName = theme.name();
         this->themeNameEdit = new QLineEdit(theme.name(), q);
+
+        this->previewTimer = new QTimer(q);
+        this->previewTimer->setSingleShot(true);
+        this->previewTimer->setInterval(PREVIEW_INTERVAL);
     }
 
     ~ThemeEditorDialogPrivate()
@@ -61,10 +66,20 @@ public:
         ;
     }
 
+    /*
+    * Milliseconds over which color changes are coalesced into a single
+    * preview, so that dragging through the color dialog updates the
+    * preview at most once per frame.
+    */
+    static const int PREVIEW_INTERVAL = 16;
+
     ThemeEditorDialog *q_ptr;
 
     QLineEdit *themeNameEdit;
+    QTimer *previewTimer;
     Theme theme;
+    Theme originalTheme;
+    bool previewed;
     ColorScheme lightColors;
     ColorScheme darkColors;
     QString oldThemeName;
@@ -77,7 +92,15 @@ public:
         const QVector<QColor *> &colors
     );
     void addColorsToLayout(QGridLayout *layout);
+    void schedulePreview();
+    void emitPreview();
     bool saveTheme();
+
+    /*
+    * Fills in the colors that the editor does not expose from the colors
+    * that it does.
+    */
+    static void deriveColors(ColorScheme &colors);
 };
 
 ThemeEditorDialog::ThemeEditorDialog(const Theme &theme, QWidget *parent)
@@ -111,6 +134,14 @@ ThemeEditorDialog::ThemeEditorDialog(const Theme &theme, QWidget *parent)
     connect(buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
     connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
 
+    this->connect
+    (
+        d->previewTimer,
+        &QTimer::timeout,
+        [d]() {
+            d->emitPreview();
+        }
+    );
 }
 
 ThemeEditorDialog::~ThemeEditorDialog()
@@ -136,6 +167,15 @@ void ThemeEditorDialog::accept()
 
 void ThemeEditorDialog::reject()
 {
+    Q_D(ThemeEditorDialog);
+
+    // Revert any colors that were previewed but not kept.
+    d->previewTimer->stop();
+
+    if (d->previewed) {
+        emit themePreviewed(d->originalTheme);
+    }
+
     QDialog::reject();
 }
 
@@ -163,8 +203,19 @@ void ThemeEditorDialogPrivate::addColorRowToLayout
             (
                 button,
                 &ColorButton::changed,
-                [colorPtr](const QColor & color) {
+                [this, colorPtr](const QColor & color) {
                     *colorPtr = color;
+                    schedulePreview();
+                }
+            );
+
+            q->connect
+            (
+                button,
+                &ColorButton::previewed,
+                [this, colorPtr](const QColor & color) {
+                    *colorPtr = color;
+                    schedulePreview();
                 }
             );
         }
@@ -192,25 +243,33 @@ void ThemeEditorDialogPrivate::addColorsToLayout(QGridLayout *layout)
     addColorRowToLayout(layout, ++row, QObject::tr("Error"),      { &lightColors.error,          &darkColors.error          });
 }
 
+void ThemeEditorDialogPrivate::schedulePreview()
+{
+    // Let the first change through at once and coalesce the ones that
+    // follow it within the same frame.
+    if (!previewTimer->isActive()) {
+        previewTimer->start();
+    }
+}
+
+void ThemeEditorDialogPrivate::emitPreview()
+{
+    Q_Q(ThemeEditorDialog);
+
+    deriveColors(lightColors);
+    deriveColors(darkColors);
+    previewed = true;
+
+    emit q->themePreviewed(Theme(oldThemeName, lightColors, darkColors, false));
+}
+
 bool ThemeEditorDialogPrivate::saveTheme()
 {
     Q_Q(ThemeEditorDialog);
     
-    lightColors.headingMarkup = lightColors.emphasisMarkup;
-    lightColors.divider = lightColors.headingMarkup;
-    lightColors.image = lightColors.link;
-    lightColors.inlineHtml = lightColors.emphasisMarkup;
-    lightColors.blockquoteMarkup = lightColors.emphasisMarkup;
-    lightColors.codeText = lightColors.blockquoteText;
-    lightColors.codeMarkup = lightColors.emphasisMarkup;
-
-    darkColors.headingMarkup = darkColors.emphasisMarkup;
-    darkColors.divider = darkColors.headingMarkup;
-    darkColors.image = darkColors.link;
-    darkColors.inlineHtml = darkColors.emphasisMarkup;
-    darkColors.blockquoteMarkup = darkColors.emphasisMarkup;
-    darkColors.codeText = darkColors.blockquoteText;
-    darkColors.codeMarkup = darkColors.emphasisMarkup;
+    previewTimer->stop();
+    deriveColors(lightColors);
+    deriveColors(darkColors);
 
     theme = Theme(themeNameEdit->text(), lightColors, darkColors, false);
 
@@ -231,4 +290,15 @@ bool ThemeEditorDialogPrivate::saveTheme()
 
     return true;
 }
+
+void ThemeEditorDialogPrivate::deriveColors(ColorScheme &colors)
+{
+    colors.headingMarkup = colors.emphasisMarkup;
+    colors.divider = colors.headingMarkup;
+    colors.image = colors.link;
+    colors.inlineHtml = colors.emphasisMarkup;
+    colors.blockquoteMarkup = colors.emphasisMarkup;
+    colors.codeText = colors.blockquoteText;
+    colors.codeMarkup = colors.emphasisMarkup;
+}
 } // namespace ghostwriter
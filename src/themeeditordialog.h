@@ -53,6 +53,14 @@ public:
      */
     const Theme &theme() const;
 
+signals:
+    /**
+     * Emitted while the user edits colors, at most once per frame, with
+     * the theme as it would look if saved, so that it can be previewed
+     * live.  Emitted with the original theme if the user cancels.
+     */
+    void themePreviewed(const Theme &theme);
+
 private slots:
     void accept();
     void reject();
@@ -19,8 +19,10 @@
 
 #include <QByteArray>
 #include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QIODevice>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -35,6 +37,7 @@
 
 #include "appsettings.h"
 #include "colorscheme.h"
+#include "startupprofiler.h"
 #include "themerepository.h"
 
 
@@ -56,10 +59,44 @@ public:
         ;
     }
 
+    /*
+    * A custom theme as last parsed from its file, which is reused for as
+    * long as the file remains unchanged.
+    */
+    struct CachedTheme
+    {
+        QDateTime lastModified;
+        qint64 size;
+        Theme theme;
+        QString err;
+    };
+
     QList<Theme> builtInThemes;
     QStringList customThemeNames;
     QString themeDirectoryPath;
     QDir themeDirectory;
+    mutable QHash<QString, CachedTheme> themeCache;
+
+    /*
+    * Parses the custom theme with the given name from its JSON file.
+    */
+    Theme parseTheme
+    (
+        const QString &name,
+        const QFileInfo &themeFileInfo,
+        QString &err
+    ) const;
+
+    /*
+    * Caches the given theme along with the state of its file.
+    */
+    void cacheTheme
+    (
+        const QString &name,
+        const QFileInfo &themeFileInfo,
+        const Theme &theme,
+        const QString &err
+    ) const;
 
     void loadClassicTheme();
     void loadPlainstractionTheme();
@@ -74,6 +111,7 @@ ThemeRepository *ThemeRepositoryPrivate::instance = nullptr;
 ThemeRepository *ThemeRepository::instance()
 {
     if (nullptr == ThemeRepositoryPrivate::instance) {
+        StartupProfiler::Scope scope("ThemeRepository");
         ThemeRepositoryPrivate::instance = new ThemeRepository();
     }
 
@@ -163,52 +201,22 @@ Theme ThemeRepository::loadTheme(const QString &name, QString &err) const
             return theme;
         }
 
-        QFile themeFile(themeFilePath);
-
-        if (!themeFile.open(QIODevice::ReadOnly)) {
-            err = tr("Could not open theme file for reading: %1")
-                  .arg(themeFilePath);
-            return theme;
+        // Parse the theme only if its file changed since it was last read.
+        QHash<QString, ThemeRepositoryPrivate::CachedTheme>::const_iterator cached =
+            d->themeCache.constFind(name);
+
+        if
+        (
+            (d->themeCache.constEnd() != cached)
+            && (cached->lastModified == themeFileInfo.lastModified())
+            && (cached->size == themeFileInfo.size())
+        ) {
+            err = cached->err;
+            return cached->theme;
         }
 
-        QJsonDocument json = QJsonDocument::fromJson(themeFile.readAll());
-
-        themeFile.close();
-
-        if (json.isNull() || !json.isObject() || json.isEmpty()) {
-            err = tr("Invalid theme format: %1")
-                  .arg(themeFilePath);
-            return d->builtInThemes[0];
-        }
-
-        QJsonObject themeObject = json.object();
-        QJsonValue lightColorsObj = themeObject.value("light");
-        QJsonValue darkColorsObj = themeObject.value("dark");
-        Theme theme;
-
-        if (d->isValidJsonObj(lightColorsObj) && d->isValidJsonObj(darkColorsObj)) {
-            ColorScheme lightColors;
-            ColorScheme darkColors;
-            bool valid = true;
-
-            valid &= d->loadColorsFromJsonObject(lightColorsObj.toObject(), lightColors);
-            valid &= d->loadColorsFromJsonObject(darkColorsObj.toObject(), darkColors);
-
-            if (!valid) {
-                err = tr("Invalid or missing value(s) in %1").arg(themeFileInfo.completeBaseName());
-            }
-
-            theme = Theme(name, lightColors, darkColors, false);
-        } else {
-            ColorScheme colors;
-            bool valid = d->loadColorsFromJsonObject(themeObject, colors);
-
-            if (!valid) {
-                err = tr("Invalid or missing value(s) in %1").arg(themeFileInfo.completeBaseName());
-            }
-
-            theme = Theme(name, colors);
-        }
+        theme = d->parseTheme(name, themeFileInfo, err);
+        d->cacheTheme(name, themeFileInfo, theme, err);
 
         return theme;
     } else {
@@ -235,6 +243,7 @@ void ThemeRepository::deleteTheme(const QString &name, QString &err)
 
     // Finally, remove the theme from the available themes list.
     d->customThemeNames.removeOne(name);
+    d->themeCache.remove(name);
 }
 
 void ThemeRepository::saveTheme(const QString &name, Theme &theme, QString &err)
@@ -268,6 +277,8 @@ void ThemeRepository::saveTheme(const QString &name, Theme &theme, QString &err)
                 return;
             }
 
+            d->themeCache.remove(name);
+
             // Now update the available themes list with the new theme name.
             for (int i = 0; i < d->customThemeNames.size(); i++) {
                 if (name == d->customThemeNames[i]) {
@@ -307,6 +318,7 @@ void ThemeRepository::saveTheme(const QString &name, Theme &theme, QString &err)
     }
 
     themeFile.close();
+    d->cacheTheme(theme.name(), QFileInfo(themeFile), theme, QString());
 
     if (isNewTheme) {
         d->customThemeNames.append(theme.name());
@@ -356,6 +368,82 @@ QString ThemeRepository::generateUntitledThemeName() const
     return name;
 }
 
+Theme ThemeRepositoryPrivate::parseTheme
+(
+    const QString &name,
+    const QFileInfo &themeFileInfo,
+    QString &err
+) const
+{
+    QString themeFilePath = themeFileInfo.filePath();
+    QFile themeFile(themeFilePath);
+
+    err = QString();
+
+    if (!themeFile.open(QIODevice::ReadOnly)) {
+        err = ThemeRepository::tr("Could not open theme file for reading: %1")
+              .arg(themeFilePath);
+        return builtInThemes[0];
+    }
+
+    QJsonDocument json = QJsonDocument::fromJson(themeFile.readAll());
+
+    themeFile.close();
+
+    if (json.isNull() || !json.isObject() || json.isEmpty()) {
+        err = ThemeRepository::tr("Invalid theme format: %1")
+              .arg(themeFilePath);
+        return builtInThemes[0];
+    }
+
+    QJsonObject themeObject = json.object();
+    QJsonValue lightColorsObj = themeObject.value("light");
+    QJsonValue darkColorsObj = themeObject.value("dark");
+    Theme theme;
+
+    if (isValidJsonObj(lightColorsObj) && isValidJsonObj(darkColorsObj)) {
+        ColorScheme lightColors;
+        ColorScheme darkColors;
+        bool valid = true;
+
+        valid &= loadColorsFromJsonObject(lightColorsObj.toObject(), lightColors);
+        valid &= loadColorsFromJsonObject(darkColorsObj.toObject(), darkColors);
+
+        if (!valid) {
+            err = ThemeRepository::tr("Invalid or missing value(s) in %1").arg(themeFileInfo.completeBaseName());
+        }
+
+        theme = Theme(name, lightColors, darkColors, false);
+    } else {
+        ColorScheme colors;
+        bool valid = loadColorsFromJsonObject(themeObject, colors);
+
+        if (!valid) {
+            err = ThemeRepository::tr("Invalid or missing value(s) in %1").arg(themeFileInfo.completeBaseName());
+        }
+
+        theme = Theme(name, colors);
+    }
+
+    return theme;
+}
+
+void ThemeRepositoryPrivate::cacheTheme
+(
+    const QString &name,
+    const QFileInfo &themeFileInfo,
+    const Theme &theme,
+    const QString &err
+) const
+{
+    CachedTheme cached;
+    cached.lastModified = themeFileInfo.lastModified();
+    cached.size = themeFileInfo.size();
+    cached.theme = theme;
+    cached.err = err;
+    themeCache.insert(name, cached);
+}
+
 void ThemeRepositoryPrivate::loadClassicTheme()
 {
     ColorScheme lightColors;
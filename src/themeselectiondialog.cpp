@@ -20,12 +20,14 @@
 #include <QCheckBox>
 #include <QColor>
 #include <QDialogButtonBox>
+#include <QFutureWatcher>
 #include <QGridLayout>
 #include <QIcon>
 #include <QList>
 #include <QListWidget>
 #include <QListWidgetItem>
 #include <QMessageBox>
+#include <QPixmap>
 #include <QPushButton>
 #include <QSize>
 #include <QString>
@@ -78,6 +80,9 @@ public:
     //
     QStringList builtInThemes;
 
+    // Watchers of the theme previews still being rendered for the list.
+    QList<QFutureWatcher<QImage> *> previewWatchers;
+
     void buildThemeList(const QString &currentThemeName = nullptr);
     void loadSelectedTheme();
     void createNewTheme();
@@ -246,6 +251,14 @@ void ThemeSelectionDialogPrivate::buildThemeList(const QString &currentThemeName
 
     this->themeListWidget->clear();
 
+    // Previews still being rendered for the old list are no longer needed.
+    foreach (QFutureWatcher<QImage> *watcher, this->previewWatchers) {
+        watcher->disconnect();
+        watcher->deleteLater();
+    }
+
+    this->previewWatchers.clear();
+
     for (int i = 0; i < availableThemes.size(); i++) {
         QString themeName = availableThemes[i];
         QString err;
@@ -261,17 +274,49 @@ void ThemeSelectionDialogPrivate::buildThemeList(const QString &currentThemeName
             colors = theme.lightColorScheme();
         }
 
-        ColorSchemePreviewer previewer
+        // Show the theme's background color until its preview is ready.
+        QPixmap placeholder
         (
-            colors,
-            theme.isReadOnly(),
-            (err.isNull() || err.isEmpty()),
-            GW_LIST_WIDGET_ICON_WIDTH,
-            GW_LIST_WIDGET_ICON_HEIGHT,
-            dpr
+            GW_LIST_WIDGET_ICON_WIDTH * dpr,
+            GW_LIST_WIDGET_ICON_HEIGHT * dpr
         );
 
-        themeIcon = previewer.icon();
+        placeholder.setDevicePixelRatio(dpr);
+        placeholder.fill(colors.background);
+        themeIcon = placeholder;
+
+        QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this->themeListWidget);
+        this->previewWatchers.append(watcher);
+
+        this->themeListWidget->connect
+        (
+            watcher,
+            &QFutureWatcher<QImage>::finished,
+            [this, watcher, themeName]() {
+                QList<QListWidgetItem *> items =
+                    this->themeListWidget->findItems(themeName, Qt::MatchExactly);
+
+                if (!items.isEmpty()) {
+                    items.first()->setIcon(QPixmap::fromImage(watcher->result()));
+                }
+
+                this->previewWatchers.removeOne(watcher);
+                watcher->deleteLater();
+            }
+        );
+
+        watcher->setFuture
+        (
+            ColorSchemePreviewer::renderAsync
+            (
+                colors,
+                theme.isReadOnly(),
+                (err.isNull() || err.isEmpty()),
+                GW_LIST_WIDGET_ICON_WIDTH,
+                GW_LIST_WIDGET_ICON_HEIGHT,
+                dpr
+            )
+        );
 
         QListWidgetItem *item = new QListWidgetItem
         (
@@ -377,6 +422,16 @@ void ThemeSelectionDialogPrivate::createNewTheme()
     ThemeEditorDialog *themeEditorDialog = new ThemeEditorDialog(newTheme, q);
     themeEditorDialog->setAttribute(Qt::WA_DeleteOnClose);
 
+    // Forward live edits so that the main window can preview them.
+    //
+    q->connect
+    (
+        themeEditorDialog,
+        &ThemeEditorDialog::themePreviewed,
+        q,
+        &ThemeSelectionDialog::themePreviewed
+    );
+
     q->connect
     (
         themeEditorDialog,
@@ -480,6 +535,16 @@ void ThemeSelectionDialogPrivate::editTheme()
         ThemeEditorDialog *themeEditorDialog = new ThemeEditorDialog(themeToEdit, q);
         themeEditorDialog->setAttribute(Qt::WA_DeleteOnClose);
 
+        // Forward live edits so that the main window can preview them.
+        //
+        q->connect
+        (
+            themeEditorDialog,
+            &ThemeEditorDialog::themePreviewed,
+            q,
+            &ThemeSelectionDialog::themePreviewed
+        );
+
         q->connect
         (
             themeEditorDialog,
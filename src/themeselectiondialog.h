@@ -60,6 +60,13 @@ public:
      */
     const Theme &theme() const;
 
+signals:
+    /**
+     * Emitted while a theme is being edited, so that its colors can be
+     * previewed live.
+     */
+    void themePreviewed(const Theme &theme);
+
 private:
     QScopedPointer<ThemeSelectionDialogPrivate> d_ptr;
 };
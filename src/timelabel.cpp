@@ -55,6 +55,7 @@ TimeLabel::TimeLabel(QWidget *parent) :
     Q_D(TimeLabel);
     
     d->timer = new QTimer(this);
+    d->timer->setSingleShot(true);
     this->connect
     (
         d->timer,
@@ -72,6 +73,17 @@ TimeLabel::~TimeLabel()
     ;
 }
 
+void TimeLabel::setPowerSavingEnabled(bool enabled)
+{
+    Q_D(TimeLabel);
+
+    if (enabled) {
+        d->timer->stop();
+    } else if (!d->timer->isActive()) {
+        d->updateTimeOfDay();
+    }
+}
+
 void TimeLabelPrivate::updateTimeOfDay()
 {
     Q_Q(TimeLabel);
@@ -82,12 +94,10 @@ void TimeLabelPrivate::updateTimeOfDay()
     QTime nextTime = currentTime.addSecs(60);
     nextTime.setHMS(nextTime.hour(), nextTime.minute(), 0);
 
-    // Set the timer as a single shot rather than a recurring 1000 ms
+    // The timer is a single shot rather than a recurring 1000 ms
     // interval, since we don't want the time to slowly drift away
     // from being accurate due to small timer inaccuracies.
     //
-    timer->setSingleShot(true);
-
     int interval = currentTime.msecsTo(nextTime);
 
     // Ensure interval is never negative.
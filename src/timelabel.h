@@ -47,6 +47,13 @@ public:
      */
     virtual ~TimeLabel();
 
+    /**
+     * Stops updating the time while power saving is enabled, such as
+     * while the window is in the background.  The time is brought up to
+     * date once power saving is disabled again.
+     */
+    void setPowerSavingEnabled(bool enabled);
+
 private:
     QScopedPointer<TimeLabelPrivate> d_ptr;
 
@@ -0,0 +1,254 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+
+#include "tracer.h"
+
+#define GW_TRACE_ENV "GHOSTWRITER_TRACE"
+
+namespace ghostwriter
+{
+bool Tracer::enabled = false;
+QString Tracer::filePath;
+QElapsedTimer Tracer::clock;
+QMutex Tracer::mutex;
+QVector<Tracer::Event> Tracer::events;
+QHash<Qt::HANDLE, int> Tracer::threadIds;
+QStringList Tracer::threadNames;
+bool Tracer::activeSpansTracked = false;
+Qt::HANDLE Tracer::mainThreadId = nullptr;
+QAtomicPointer<const char> Tracer::activeSpans[Tracer::MaxActiveDepth];
+QAtomicInt Tracer::activeDepth(0);
+
+Tracer::Scope::Scope(const char *name)
+    : name(name), start(-1), active(false)
+{
+    if (enabled) {
+        start = clock.nsecsElapsed();
+    }
+
+    if (activeSpansTracked && (QThread::currentThreadId() == mainThreadId)) {
+        int depth = activeDepth.loadAcquire();
+
+        if (depth < MaxActiveDepth) {
+            activeSpans[depth].storeRelease(name);
+        }
+
+        activeDepth.storeRelease(depth + 1);
+        active = true;
+    }
+}
+
+Tracer::Scope::~Scope()
+{
+    if (start >= 0) {
+        record(name, start, clock.nsecsElapsed() - start);
+    }
+
+    if (active) {
+        activeDepth.storeRelease(activeDepth.loadAcquire() - 1);
+    }
+}
+
+void Tracer::start()
+{
+    filePath = QString::fromLocal8Bit(qgetenv(GW_TRACE_ENV));
+
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    clock.start();
+    enabled = true;
+}
+
+bool Tracer::isEnabled()
+{
+    return enabled;
+}
+
+qint64 Tracer::now()
+{
+    return clock.nsecsElapsed();
+}
+
+QStringList Tracer::mainThreadSpansSince(qint64 time)
+{
+    QMutexLocker locker(&mutex);
+    QHash<QString, QPair<int, qint64>> spans;
+
+    // Spans are recorded as they end, so walk back only as far as the
+    // first span that ended before the given time.
+    for (int i = events.size() - 1; i >= 0; i--) {
+        const Event &event = events[i];
+
+        if ((event.start + event.duration) < time) {
+            break;
+        }
+
+        if ("Main" == threadNames[event.thread]) {
+            QPair<int, qint64> &span = spans[event.name];
+            span.first++;
+            span.second += event.duration;
+        }
+    }
+
+    QList<QPair<qint64, QString>> ranked;
+
+    for
+    (
+        QHash<QString, QPair<int, qint64>>::const_iterator it = spans.constBegin();
+        it != spans.constEnd();
+        ++it
+    ) {
+        ranked.append
+        (
+            qMakePair
+            (
+                it.value().second,
+                QString("%1 x%2").arg(it.key()).arg(it.value().first)
+            )
+        );
+    }
+
+    std::sort(ranked.begin(), ranked.end());
+
+    QStringList names;
+
+    for (int i = ranked.size() - 1; i >= 0; i--) {
+        names.append(ranked[i].second);
+    }
+
+    return names;
+}
+
+void Tracer::setActiveSpansTracked(bool tracked)
+{
+    mainThreadId = QThread::currentThreadId();
+    activeSpansTracked = tracked;
+}
+
+QStringList Tracer::activeMainThreadSpans()
+{
+    QStringList names;
+    int depth = activeDepth.loadAcquire();
+
+    for (int i = 0; i < qMin(depth, (int) MaxActiveDepth); i++) {
+        const char *name = activeSpans[i].loadAcquire();
+
+        if (nullptr != name) {
+            names.append(name);
+        }
+    }
+
+    if (depth > MaxActiveDepth) {
+        names.append(QString("(%1 more)").arg(depth - MaxActiveDepth));
+    }
+
+    return names;
+}
+
+void Tracer::finish()
+{
+    if (!enabled) {
+        return;
+    }
+
+    enabled = false;
+
+    QMutexLocker locker(&mutex);
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning("Could not write trace to %s.", qPrintable(filePath));
+        return;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << "{\"traceEvents\":[\n";
+
+    for (int i = 0; i < threadNames.size(); i++) {
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << i << ",\"args\":{\"name\":\"" << threadNames[i] << "\"}},\n";
+    }
+
+    // Timestamps and durations are in microseconds.
+    for (int i = 0; i < events.size(); i++) {
+        const Event &event = events[i];
+
+        stream << "{\"name\":\"" << event.name
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << QString::number(event.start / 1000.0, 'f', 3)
+            << ",\"dur\":" << QString::number(event.duration / 1000.0, 'f', 3)
+            << "}" << ((i + 1) < events.size() ? ",\n" : "\n");
+    }
+
+    stream << "]}\n";
+    stream.flush();
+
+    events.clear();
+    events.squeeze();
+}
+
+void Tracer::record(const char *name, qint64 start, qint64 duration)
+{
+    QMutexLocker locker(&mutex);
+
+    if (events.size() >= MaxEvents) {
+        return;
+    }
+
+    Qt::HANDLE handle = QThread::currentThreadId();
+    QHash<Qt::HANDLE, int>::const_iterator it = threadIds.constFind(handle);
+    int thread;
+
+    if (threadIds.constEnd() == it) {
+        thread = threadNames.size();
+        threadIds.insert(handle, thread);
+
+        if
+        (
+            (nullptr != QCoreApplication::instance())
+            && (QThread::currentThread() == QCoreApplication::instance()->thread())
+        ) {
+            threadNames.append("Main");
+        } else {
+            threadNames.append(QString("Worker %1").arg(thread));
+        }
+    } else {
+        thread = it.value();
+    }
+
+    Event event;
+    event.name = name;
+    event.start = start;
+    event.duration = duration;
+    event.thread = thread;
+
+    events.append(event);
+}
+} // namespace ghostwriter
@@ -0,0 +1,159 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Records spans of work on any thread, including the thread pool, as
+ * Chrome trace events.  The trace can be loaded into chrome://tracing or
+ * the Perfetto UI to see how the latency of an edit is spread across the
+ * subsystems and threads.  Tracing is enabled with the GHOSTWRITER_TRACE
+ * environment variable, which names the JSON file to write the trace to
+ * when the application exits.  When tracing is not enabled, a span costs
+ * a single check.
+ *
+ * Independently of tracing, the tracer can keep the stack of spans that
+ * are running on the main thread, so that a watchdog on another thread
+ * can tell what the main thread is busy with when it stops responding.
+ *
+ * Spans are best recorded with the GW_TRACE_SCOPE() macro.
+ */
+class Tracer
+{
+public:
+    /**
+     * Records the enclosing scope as a span with the given name, which
+     * must outlive the tracer, such as a string literal.
+     */
+    class Scope
+    {
+    public:
+        Scope(const char *name);
+        ~Scope();
+
+    private:
+        const char *name;
+        qint64 start;
+        bool active;
+    };
+
+    /**
+     * Enables tracing if the environment requests it.  Call this first
+     * thing in main().
+     */
+    static void start();
+
+    /**
+     * Returns whether tracing is enabled.
+     */
+    static bool isEnabled();
+
+    /**
+     * Returns the current time on the trace clock, in nanoseconds.
+     */
+    static qint64 now();
+
+    /**
+     * Returns the names of the spans that ran on the main thread since the
+     * given time on the trace clock, each followed by the number of times
+     * it ran, such as "highlightBlock x12".  The most costly spans are
+     * listed first.
+     */
+    static QStringList mainThreadSpansSince(qint64 time);
+
+    /**
+     * Starts or stops keeping the stack of spans running on the main
+     * thread, whether or not tracing is enabled.  Call this from the main
+     * thread.
+     */
+    static void setActiveSpansTracked(bool tracked);
+
+    /**
+     * Returns the names of the spans running on the main thread, the
+     * outermost first.  Can be called from any thread, and returns an
+     * empty list unless the active spans are tracked.
+     */
+    static QStringList activeMainThreadSpans();
+
+    /**
+     * Ends tracing, writing the trace to the requested file.  Does nothing
+     * if tracing already ended or was never enabled.
+     */
+    static void finish();
+
+private:
+    // Largest number of spans kept, so that a long session cannot
+    // exhaust memory.  Later spans are dropped.
+    static const int MaxEvents = 2000000;
+
+    // Deepest nesting of active spans kept.  Deeper spans are counted but
+    // not named.
+    static const int MaxActiveDepth = 32;
+
+    struct Event
+    {
+        const char *name;
+        qint64 start;
+        qint64 duration;
+        int thread;
+    };
+
+    static bool enabled;
+    static QString filePath;
+    static QElapsedTimer clock;
+    static QMutex mutex;
+    static QVector<Event> events;
+    static QHash<Qt::HANDLE, int> threadIds;
+    static QStringList threadNames;
+
+    // Stack of the spans running on the main thread, which only the main
+    // thread changes.
+    static bool activeSpansTracked;
+    static Qt::HANDLE mainThreadId;
+    static QAtomicPointer<const char> activeSpans[MaxActiveDepth];
+    static QAtomicInt activeDepth;
+
+    Tracer();
+
+    static void record(const char *name, qint64 start, qint64 duration);
+};
+} // namespace ghostwriter
+
+#define GW_TRACE_CONCAT_(a, b) a##b
+#define GW_TRACE_CONCAT(a, b) GW_TRACE_CONCAT_(a, b)
+
+/**
+ * Records the enclosing scope as a span with the given name.
+ */
+#define GW_TRACE_SCOPE(name) \
+    ghostwriter::Tracer::Scope GW_TRACE_CONCAT(gwTraceScope, __LINE__)(name)
+
+#endif // TRACER_H
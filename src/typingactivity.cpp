@@ -0,0 +1,167 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <limits>
+
+#include "typingactivity.h"
+
+namespace ghostwriter
+{
+TypingActivity::TypingActivity(QObject *parent)
+    : QObject(parent),
+      lastEdit(0),
+      averageCost(0.0),
+      typing(false)
+{
+    clock.start();
+
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::CoarseTimer);
+
+    this->connect
+    (
+        timer,
+        &QTimer::timeout,
+        [this]() {
+            checkPauses();
+        }
+    );
+}
+
+TypingActivity::~TypingActivity()
+{
+    ;
+}
+
+int TypingActivity::addPause(int milliseconds)
+{
+    return addAdaptivePause(0, milliseconds, milliseconds);
+}
+
+int TypingActivity::addAdaptivePause(int costFactor, int minimum, int maximum)
+{
+    Pause pause;
+    pause.costFactor = costFactor;
+    pause.minimum = minimum;
+    pause.maximum = qMax(minimum, maximum);
+    pause.reached = !typing;
+
+    pauses.append(pause);
+    scheduleNextPause();
+
+    return pauses.size() - 1;
+}
+
+int TypingActivity::pauseLength(int pause) const
+{
+    const Pause &p = pauses[pause];
+
+    return qBound
+    (
+        p.minimum,
+        (int) (p.costFactor * averageCost),
+        p.maximum
+    );
+}
+
+bool TypingActivity::isTyping() const
+{
+    return typing;
+}
+
+qint64 TypingActivity::idleTime() const
+{
+    return clock.elapsed() - lastEdit;
+}
+
+void TypingActivity::recordEdit()
+{
+    lastEdit = clock.elapsed();
+
+    if (typing) {
+        // The pending timer checks the time of the last edit when it
+        // fires, and is set again from there.
+        if (!timer->isActive()) {
+            scheduleNextPause();
+        }
+
+        return;
+    }
+
+    typing = true;
+
+    for (Pause &pause : pauses) {
+        pause.reached = false;
+    }
+
+    scheduleNextPause();
+    emit typingResumed();
+}
+
+void TypingActivity::reportCost(int milliseconds)
+{
+    averageCost += (milliseconds - averageCost) * CostWeight / 100.0;
+}
+
+void TypingActivity::checkPauses()
+{
+    qint64 idle = idleTime();
+    QVector<int> reached;
+
+    for (int i = 0; i < pauses.size(); i++) {
+        if (!pauses[i].reached && (idle >= pauseLength(i))) {
+            pauses[i].reached = true;
+            reached.append(i);
+        }
+    }
+
+    // Typing resumes with the next edit once any pause is reached, which
+    // starts every pause over.
+    if (!reached.isEmpty()) {
+        typing = false;
+    }
+
+    // Set the timer before notifying, since a subscriber may edit the
+    // text in response.
+    scheduleNextPause();
+
+    for (int pause : reached) {
+        emit pauseReached(pause);
+    }
+}
+
+void TypingActivity::scheduleNextPause()
+{
+    qint64 next = std::numeric_limits<qint64>::max();
+
+    for (int i = 0; i < pauses.size(); i++) {
+        if (!pauses[i].reached) {
+            next = qMin(next, lastEdit + pauseLength(i));
+        }
+    }
+
+    if (std::numeric_limits<qint64>::max() == next) {
+        timer->stop();
+        return;
+    }
+
+    timer->start((int) qMax(Q_INT64_C(0), next - clock.elapsed()));
+}
+} // namespace ghostwriter
@@ -0,0 +1,134 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef TYPING_ACTIVITY_H
+#define TYPING_ACTIVITY_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Tracks when the writer pauses typing, for the work that waits for a
+ * pause.  Each subscriber registers the length of pause it waits for,
+ * and is notified with pauseReached() once per pause in the typing.  A
+ * pause may be of fixed length, or adapt to the cost of the work done in
+ * response to each edit, as reported with reportCost(), so that the
+ * pause grows when that work slows down, such as in a large document.
+ *
+ * Edits only record the time on a monotonic clock.  A single coarse
+ * timer is then set for the next pause due, and is not set again while it
+ * is pending, so that typing does not restart a timer on every key.  Once
+ * every pause is reached, the timer stays idle until the next edit.
+ */
+class TypingActivity : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.  Typing starts out paused.
+     */
+    TypingActivity(QObject *parent = nullptr);
+
+    /**
+     * Destructor.
+     */
+    virtual ~TypingActivity();
+
+    /**
+     * Registers a pause of the given length in milliseconds, and returns
+     * its identifier for pauseReached().
+     */
+    int addPause(int milliseconds);
+
+    /**
+     * Registers a pause lasting the given multiple of the average cost
+     * reported with reportCost(), bounded by the given minimum and maximum
+     * lengths in milliseconds.  Returns its identifier for pauseReached().
+     */
+    int addAdaptivePause(int costFactor, int minimum, int maximum);
+
+    /**
+     * Returns the current length in milliseconds of the given pause.
+     */
+    int pauseLength(int pause) const;
+
+    /**
+     * Returns true if no pause was reached since the last edit.
+     */
+    bool isTyping() const;
+
+    /**
+     * Returns the milliseconds elapsed since the last edit.
+     */
+    qint64 idleTime() const;
+
+signals:
+    /**
+     * Emitted on the first edit after a pause was reached.
+     */
+    void typingResumed();
+
+    /**
+     * Emitted when the typing has paused for the length of the given
+     * pause.
+     */
+    void pauseReached(int pause);
+
+public slots:
+    /**
+     * Records an edit to the text.
+     */
+    void recordEdit();
+
+    /**
+     * Reports the time in milliseconds taken by the work done in response
+     * to an edit, to which the adaptive pauses are fit.
+     */
+    void reportCost(int milliseconds);
+
+private:
+    // Weight of each new cost in the moving average, in percent.
+    static const int CostWeight = 20;
+
+    struct Pause
+    {
+        int costFactor;
+        int minimum;
+        int maximum;
+        bool reached;
+    };
+
+    QElapsedTimer clock;
+    qint64 lastEdit;
+    double averageCost;
+    bool typing;
+    QVector<Pause> pauses;
+    QTimer *timer;
+
+    void checkPauses();
+    void scheduleNextPause();
+};
+} // namespace ghostwriter
+
+#endif // TYPING_ACTIVITY_H
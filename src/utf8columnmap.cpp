@@ -0,0 +1,125 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include "utf8columnmap.h"
+
+namespace ghostwriter
+{
+Utf8ColumnMap::Utf8ColumnMap()
+    : lineStart(-1), lineBytes(0), lineUtf16(0)
+{
+    ;
+}
+
+Utf8ColumnMap::~Utf8ColumnMap()
+{
+    ;
+}
+
+void Utf8ColumnMap::appendAscii(int count)
+{
+    if (lineStart >= 0) {
+        for (int i = 0; i < count; i++) {
+            table.append(lineUtf16 + i);
+        }
+    }
+
+    lineBytes += count;
+    lineUtf16 += count;
+}
+
+void Utf8ColumnMap::appendCharacter(int utf16Length, int utf8Length)
+{
+    if ((lineStart < 0) && (utf16Length == utf8Length)) {
+        lineBytes += utf8Length;
+        lineUtf16 += utf16Length;
+        return;
+    }
+
+    // Start a table for the line upon its first multibyte character.  Up
+    // to this point, the line's byte and UTF-16 offsets were the same.
+    if (lineStart < 0) {
+        lineStart = table.size();
+
+        for (int i = 0; i < lineBytes; i++) {
+            table.append(i);
+        }
+    }
+
+    for (int i = 0; i < utf8Length; i++) {
+        table.append(lineUtf16);
+    }
+
+    lineBytes += utf8Length;
+    lineUtf16 += utf16Length;
+}
+
+void Utf8ColumnMap::endLine()
+{
+    if (lineStart >= 0) {
+        table.append(lineUtf16);
+    }
+
+    lines.append({ lineStart, lineBytes });
+
+    lineStart = -1;
+    lineBytes = 0;
+    lineUtf16 = 0;
+}
+
+void Utf8ColumnMap::finish()
+{
+    if ((lineBytes > 0) || (lineStart >= 0)) {
+        endLine();
+    }
+}
+
+int Utf8ColumnMap::toUtf16(int line, int byteOffset) const
+{
+    int index = line - 1;
+
+    if ((index < 0) || (index >= lines.size())) {
+        return byteOffset;
+    }
+
+    const Line &entry = lines[index];
+
+    if (entry.tableStart < 0) {
+        return byteOffset;
+    }
+
+    if (byteOffset < 0) {
+        byteOffset = 0;
+    } else if (byteOffset > entry.byteLength) {
+        byteOffset = entry.byteLength;
+    }
+
+    return table[entry.tableStart + byteOffset];
+}
+
+void Utf8ColumnMap::clear()
+{
+    lines.clear();
+    table.clear();
+    lineStart = -1;
+    lineBytes = 0;
+    lineUtf16 = 0;
+}
+} // namespace ghostwriter
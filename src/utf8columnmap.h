@@ -0,0 +1,112 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2020 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef UTF8_COLUMN_MAP_H
+#define UTF8_COLUMN_MAP_H
+
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Maps the byte columns that cmark-gfm reports for UTF-8 text back to
+ * UTF-16 columns (i.e., QChar indices) within each line of the original
+ * QString text.  The map is built one character at a time as the text is
+ * encoded to UTF-8.
+ *
+ * Only lines that contain multibyte characters have a lookup table, since
+ * the byte and UTF-16 columns of ASCII lines are the same.
+ */
+class Utf8ColumnMap
+{
+public:
+    /**
+     * Constructor.
+     */
+    Utf8ColumnMap();
+
+    /**
+     * Destructor.
+     */
+    ~Utf8ColumnMap();
+
+    /**
+     * Appends the given number of ASCII characters, not including line
+     * breaks, to the current line.
+     */
+    void appendAscii(int count);
+
+    /**
+     * Appends a character to the current line that is the given number
+     * of UTF-16 code units (QChars) long and encodes to the given number
+     * of UTF-8 bytes.
+     */
+    void appendCharacter(int utf16Length, int utf8Length);
+
+    /**
+     * Ends the current line and begins the next one.
+     */
+    void endLine();
+
+    /**
+     * Ends the last line of text, if it did not end with a line break.
+     * Call this method after all the text has been appended.
+     */
+    void finish();
+
+    /**
+     * Returns the zero-based UTF-16 offset within the given line (numbered
+     * from 1, as with cmark-gfm) of the given zero-based byte offset into
+     * the UTF-8 encoding of the line.  Byte offsets within a multibyte
+     * character map to the start of that character.  Offsets for lines
+     * that are not in the map are returned unchanged.
+     */
+    int toUtf16(int line, int byteOffset) const;
+
+    /**
+     * Removes all lines from the map.
+     */
+    void clear();
+
+private:
+    typedef struct
+    {
+        // Index of the line's first entry in the table, or -1 if the line
+        // is ASCII and needs no table.
+        int tableStart;
+
+        // Length of the line in UTF-8 bytes.
+        int byteLength;
+    } Line;
+
+    QVector<Line> lines;
+
+    // Lookup tables for the lines with multibyte characters, holding the
+    // UTF-16 offset of each byte of the line, plus one trailing entry for
+    // the end of the line.
+    QVector<int> table;
+
+    int lineStart;
+    int lineBytes;
+    int lineUtf16;
+};
+} // namespace ghostwriter
+
+#endif // UTF8_COLUMN_MAP_H
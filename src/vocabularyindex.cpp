@@ -0,0 +1,307 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <algorithm>
+
+#include "markdowndocument.h"
+#include "textblockdata.h"
+#include "texttokenizer.h"
+#include "tracer.h"
+#include "vocabularyindex.h"
+
+namespace ghostwriter
+{
+//
+// Returns whether the given word has a letter, so that numbers, which
+// are not worth completing, are left out of the index.
+//
+static bool hasLetter(const QString &word)
+{
+    for (const QChar c : word) {
+        if (c.isLetter()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+VocabularyIndex::VocabularyIndex(MarkdownDocument *document)
+    : QObject(document),
+      document(document),
+      indexedRevision(-1),
+      rebuildPending(false)
+{
+    this->connect
+    (
+        document,
+        &QTextDocument::contentsChange,
+        [this](int position, int charsRemoved, int charsAdded) {
+            this->onContentsChange(position, charsRemoved, charsAdded);
+        }
+    );
+
+    onContentsChange(0, 0, document->characterCount());
+}
+
+VocabularyIndex::~VocabularyIndex()
+{
+    ;
+}
+
+int VocabularyIndex::frequency(const QString &word)
+{
+    ensureIndexed();
+
+    QMap<QString, Entry>::const_iterator iter = words.constFind(word.toCaseFolded());
+
+    return (words.constEnd() == iter) ? 0 : iter->count;
+}
+
+QStringList VocabularyIndex::completions(const QString &prefix, int minimumLength, int maxCount)
+{
+    ensureIndexed();
+
+    QString foldedPrefix = prefix.toCaseFolded();
+    QVector<const Entry *> matches;
+
+    minimumLength = qMax(minimumLength, prefix.length() + 1);
+
+    for
+    (
+        QMap<QString, Entry>::const_iterator iter = words.lowerBound(foldedPrefix);
+        (words.constEnd() != iter) && iter.key().startsWith(foldedPrefix);
+        ++iter
+    ) {
+        if (iter->spelling.length() >= minimumLength) {
+            matches.append(&iter.value());
+        }
+    }
+
+    // The matches are already in alphabetical order, which the stable
+    // sort keeps for words used equally often.
+    std::stable_sort
+    (
+        matches.begin(),
+        matches.end(),
+        [](const Entry *a, const Entry *b) {
+            return a->count > b->count;
+        }
+    );
+
+    QStringList spellings;
+
+    for (int i = 0; (i < matches.size()) && (i < maxCount); i++) {
+        spellings.append(matches[i]->spelling);
+    }
+
+    return spellings;
+}
+
+QVector<QPair<QString, int>> VocabularyIndex::mostFrequentWords(int count, int minimumLength)
+{
+    ensureIndexed();
+
+    QVector<QPair<QString, int>> mostFrequent;
+
+    if (count <= 0) {
+        return mostFrequent;
+    }
+
+    // Keep only the top few while scanning, since count is small.
+    for (const Entry &entry : words) {
+        if
+        (
+            (entry.count < 2)
+            || (entry.spelling.length() < minimumLength)
+            || ((mostFrequent.size() >= count) && (entry.count <= mostFrequent.last().second))
+        ) {
+            continue;
+        }
+
+        int i = mostFrequent.size();
+
+        while ((i > 0) && (mostFrequent[i - 1].second < entry.count)) {
+            i--;
+        }
+
+        mostFrequent.insert(i, qMakePair(entry.spelling, entry.count));
+
+        if (mostFrequent.size() > count) {
+            mostFrequent.removeLast();
+        }
+    }
+
+    return mostFrequent;
+}
+
+void VocabularyIndex::removeBlock(TextBlockData *blockData)
+{
+    for (const QString &word : blockData->vocabulary) {
+        removeWord(word);
+    }
+}
+
+void VocabularyIndex::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // Highlighting also signals a change to the contents, without changing
+    // the text.  See MarkdownDocument::onContentsChange().
+    if
+    (
+        (charsRemoved == charsAdded)
+        && (charsAdded > 0)
+        && (document->revision() == indexedRevision)
+    ) {
+        return;
+    }
+
+    indexedRevision = document->revision();
+
+    QTextBlock block = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+
+    if ((last.blockNumber() - block.blockNumber()) > LargeEditBlockCount) {
+        rebuildPending = true;
+        return;
+    }
+
+    while (block.isValid()) {
+        indexBlock(block);
+
+        if (block == last) {
+            break;
+        }
+
+        block = block.next();
+    }
+}
+
+void VocabularyIndex::ensureIndexed()
+{
+    if (!rebuildPending) {
+        return;
+    }
+
+    GW_TRACE_SCOPE("VocabularyIndex::ensureIndexed");
+
+    rebuildPending = false;
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        indexBlock(block);
+    }
+}
+
+void VocabularyIndex::indexBlock(QTextBlock &block)
+{
+    TextBlockData *blockData = (TextBlockData *) block.userData();
+    QString text = block.text();
+    QVector<QPair<QString, QString>> found;
+    TextTokenizer::Word word;
+    int position = 0;
+
+    while (TextTokenizer::nextWord(text, position, word)) {
+        QString spelling = text.mid(word.position, word.length);
+        position = word.position + word.length;
+
+        if (!word.hasNumber || hasLetter(spelling)) {
+            found.append(qMakePair(spelling.toCaseFolded(), spelling));
+        }
+    }
+
+    if (nullptr == blockData) {
+        if (found.isEmpty()) {
+            return;
+        }
+
+        blockData = new TextBlockData(document, block);
+        block.setUserData(blockData);
+    }
+
+    std::sort
+    (
+        found.begin(),
+        found.end(),
+        [](const QPair<QString, QString> &a, const QPair<QString, QString> &b) {
+            return a.first < b.first;
+        }
+    );
+
+    // Both lists are sorted, so a single pass finds the words that were
+    // removed from the block and those that were added to it.  Words left
+    // unchanged keep the keys of their entries.
+    const QStringList &previous = blockData->vocabulary;
+    QStringList vocabulary;
+    int i = 0;
+    int j = 0;
+
+    vocabulary.reserve(found.size());
+
+    while ((i < previous.size()) || (j < found.size())) {
+        if ((j >= found.size()) || ((i < previous.size()) && (previous[i] < found[j].first))) {
+            removeWord(previous[i]);
+            i++;
+        } else if ((i >= previous.size()) || (found[j].first < previous[i])) {
+            vocabulary.append(addWord(found[j].first, found[j].second));
+            j++;
+        } else {
+            vocabulary.append(previous[i]);
+            i++;
+            j++;
+        }
+    }
+
+    blockData->vocabulary = vocabulary;
+}
+
+QString VocabularyIndex::addWord(const QString &foldedWord, const QString &spelling)
+{
+    QMap<QString, Entry>::iterator iter = words.find(foldedWord);
+
+    if (words.end() == iter) {
+        iter = words.insert(foldedWord, { 1, spelling });
+    } else {
+        iter->count++;
+
+        if ((iter->spelling != foldedWord) && (spelling == foldedWord)) {
+            iter->spelling = spelling;
+        }
+    }
+
+    return iter.key();
+}
+
+void VocabularyIndex::removeWord(const QString &foldedWord)
+{
+    QMap<QString, Entry>::iterator iter = words.find(foldedWord);
+
+    if (words.end() == iter) {
+        return;
+    }
+
+    iter->count--;
+
+    if (iter->count <= 0) {
+        words.erase(iter);
+    }
+}
+} // namespace ghostwriter
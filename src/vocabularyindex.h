@@ -0,0 +1,147 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef VOCABULARYINDEX_H
+#define VOCABULARYINDEX_H
+
+#include <QMap>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QTextBlock>
+#include <QVector>
+
+namespace ghostwriter
+{
+class MarkdownDocument;
+class TextBlockData;
+
+/**
+ * Index of the words of a document, with the number of times each is
+ * used, for word completion and for finding the words that a document
+ * repeats most.  The index is kept up to date as the document changes
+ * by retokenizing only the blocks that were edited, and by adding and
+ * removing only the words by which each block's words changed.
+ *
+ * Words are split by the TextTokenizer and matched case folded.  Each
+ * word's entry keeps a spelling of the word as written, preferring an
+ * all lowercase spelling, so that a word that is only capitalized at the
+ * start of a sentence is completed in lowercase.
+ *
+ * Edits of many blocks at once, such as loading a file, are not indexed
+ * until the index is next queried, so that documents are not tokenized
+ * for it while nothing uses it.
+ */
+class VocabularyIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor.  Indexes the given document's text, and then keeps
+     * the index up to date as the document changes.
+     */
+    explicit VocabularyIndex(MarkdownDocument *document);
+
+    /**
+     * Destructor.
+     */
+    virtual ~VocabularyIndex();
+
+    /**
+     * Returns how many times the given word is used in the document,
+     * regardless of case.
+     */
+    int frequency(const QString &word);
+
+    /**
+     * Returns the spellings of at most maxCount words of the document that
+     * start with the given prefix, regardless of case, and are at least
+     * minimumLength characters long, as well as longer than the prefix.
+     * The most used words come first.
+     */
+    QStringList completions(const QString &prefix, int minimumLength, int maxCount);
+
+    /**
+     * Returns the spellings of at most count words that are used more than
+     * once in the document and are at least minimumLength characters long,
+     * paired with how many times each is used, the most used first.
+     */
+    QVector<QPair<QString, int>> mostFrequentWords(int count, int minimumLength);
+
+    /**
+     * Forgets the words of the block with the given data, which is being
+     * destroyed.  For internal use only with the MarkdownDocument class.
+     */
+    void removeBlock(TextBlockData *blockData);
+
+private:
+    // Edits of more blocks than this are indexed on the next query.
+    static const int LargeEditBlockCount = 500;
+
+    struct Entry
+    {
+        int count;
+        QString spelling;
+    };
+
+    MarkdownDocument *document;
+
+    // Entries of the words, keyed by the case folded words.  Since the
+    // map is ordered, the words starting with a prefix are adjacent.
+    QMap<QString, Entry> words;
+
+    // Revision of the document when last indexed.
+    int indexedRevision;
+
+    // Whether blocks were edited without being indexed.
+    bool rebuildPending;
+
+    /*
+    * Reindexes the blocks touched by the given change to the document.
+    */
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+    /*
+    * Reindexes every block of the document if a large edit has yet to be
+    * indexed.
+    */
+    void ensureIndexed();
+
+    /*
+    * Retokenizes the given block, updating the index by the words that
+    * were added to it or removed from it since it was last indexed.
+    */
+    void indexBlock(QTextBlock &block);
+
+    /*
+    * Counts one more use of the given case folded word, returning the key
+    * of its entry, which the block's list of words shares.
+    */
+    QString addWord(const QString &foldedWord, const QString &spelling);
+
+    /*
+    * Counts one less use of the given case folded word.
+    */
+    void removeWord(const QString &foldedWord);
+};
+} // namespace ghostwriter
+
+#endif // VOCABULARYINDEX_H
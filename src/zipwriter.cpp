@@ -0,0 +1,209 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QDateTime>
+
+#include "zipwriter.h"
+
+namespace ghostwriter
+{
+namespace
+{
+const quint32 LocalFileHeaderSignature = 0x04034b50;
+const quint32 CentralFileHeaderSignature = 0x02014b50;
+const quint32 EndOfCentralDirectorySignature = 0x06054b50;
+
+// Version 2.0 of the format, which introduced deflate.
+const quint16 ZipVersion = 20;
+
+// Flag marking file names as UTF-8.
+const quint16 Utf8NamesFlag = 0x0800;
+
+const quint16 StoredMethod = 0;
+const quint16 DeflatedMethod = 8;
+
+// Lookup table of the CRC-32 checksum used by zip.
+struct Crc32Table
+{
+    quint32 values[256];
+
+    Crc32Table()
+    {
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 c = i;
+
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            }
+
+            values[i] = c;
+        }
+    }
+};
+} // namespace
+
+ZipWriter::ZipWriter(QIODevice *device)
+    : mDevice(device),
+      mOffset(0),
+      mOk(true)
+{
+    QDateTime now = QDateTime::currentDateTime();
+    QDate date = now.date();
+    QTime time = now.time();
+
+    // MS-DOS dates start in 1980, and times have a resolution of two
+    // seconds.
+    mDosDate = ((qMax(date.year(), 1980) - 1980) << 9) | (date.month() << 5) | date.day();
+    mDosTime = (time.hour() << 11) | (time.minute() << 5) | (time.second() / 2);
+}
+
+ZipWriter::~ZipWriter()
+{
+    ;
+}
+
+bool ZipWriter::addFile(const QString &name, const QByteArray &data, bool compressed)
+{
+    Entry entry;
+    entry.name = name.toUtf8();
+    entry.method = StoredMethod;
+    entry.crc = crc32(data);
+    entry.size = data.size();
+    entry.offset = mOffset;
+
+    QByteArray deflated;
+
+    if (compressed && !data.isEmpty()) {
+        // qCompress() prepends the uncompressed size to a zlib stream,
+        // which wraps the raw deflate data that zip expects between a
+        // two byte header and a four byte checksum.
+        //
+        deflated = qCompress(data);
+
+        if ((deflated.size() > 10) && ((deflated.size() - 10) < data.size())) {
+            deflated = deflated.mid(6, deflated.size() - 10);
+            entry.method = DeflatedMethod;
+        }
+    }
+
+    const QByteArray &contents = (DeflatedMethod == entry.method) ? deflated : data;
+    entry.compressedSize = contents.size();
+
+    write32(LocalFileHeaderSignature);
+    write16(ZipVersion);
+    write16(Utf8NamesFlag);
+    write16(entry.method);
+    write16(mDosTime);
+    write16(mDosDate);
+    write32(entry.crc);
+    write32(entry.compressedSize);
+    write32(entry.size);
+    write16(entry.name.size());
+    write16(0);
+    write(entry.name);
+    write(contents);
+
+    mEntries.append(entry);
+    return mOk;
+}
+
+bool ZipWriter::close()
+{
+    quint32 directoryOffset = mOffset;
+
+    for (const Entry &entry : mEntries) {
+        write32(CentralFileHeaderSignature);
+        write16(ZipVersion);
+        write16(ZipVersion);
+        write16(Utf8NamesFlag);
+        write16(entry.method);
+        write16(mDosTime);
+        write16(mDosDate);
+        write32(entry.crc);
+        write32(entry.compressedSize);
+        write32(entry.size);
+        write16(entry.name.size());
+        write16(0); // Extra field length
+        write16(0); // Comment length
+        write16(0); // Disk number
+        write16(0); // Internal attributes
+        write32(0); // External attributes
+        write32(entry.offset);
+        write(entry.name);
+    }
+
+    quint32 directorySize = mOffset - directoryOffset;
+
+    write32(EndOfCentralDirectorySignature);
+    write16(0); // Disk number
+    write16(0); // Disk with the central directory
+    write16(mEntries.size());
+    write16(mEntries.size());
+    write32(directorySize);
+    write32(directoryOffset);
+    write16(0); // Comment length
+
+    mEntries.clear();
+    return mOk;
+}
+
+void ZipWriter::write16(quint16 value)
+{
+    char bytes[2] = { char(value & 0xFF), char((value >> 8) & 0xFF) };
+    write(QByteArray::fromRawData(bytes, 2));
+}
+
+void ZipWriter::write32(quint32 value)
+{
+    char bytes[4] =
+    {
+        char(value & 0xFF),
+        char((value >> 8) & 0xFF),
+        char((value >> 16) & 0xFF),
+        char((value >> 24) & 0xFF)
+    };
+
+    write(QByteArray::fromRawData(bytes, 4));
+}
+
+void ZipWriter::write(const QByteArray &bytes)
+{
+    if (!mOk) {
+        return;
+    }
+
+    mOk = (mDevice->write(bytes) == bytes.size());
+    mOffset += bytes.size();
+}
+
+quint32 ZipWriter::crc32(const QByteArray &data)
+{
+    // Function-local statics are initialized in a thread-safe manner.
+    static const Crc32Table table;
+
+    quint32 crc = 0xFFFFFFFF;
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+
+    for (int i = 0; i < data.size(); i++) {
+        crc = table.values[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+} // namespace ghostwriter
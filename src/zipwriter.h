@@ -0,0 +1,95 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef ZIP_WRITER_H
+#define ZIP_WRITER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+namespace ghostwriter
+{
+/**
+ * Writes a zip archive, such as an Office Open XML or OpenDocument file,
+ * to a device.  Each file is written out to the device as soon as it is
+ * added, so that only the central directory of the archive is kept until
+ * the archive is closed.  Files are compressed with deflate, using
+ * qCompress(), unless they are to be stored as they are.
+ *
+ * This class may be used from any thread, but each instance from only
+ * one thread at a time.
+ */
+class ZipWriter
+{
+public:
+    /**
+     * Constructor.  The given device must be open for writing, and must
+     * outlive this writer.
+     */
+    ZipWriter(QIODevice *device);
+
+    /**
+     * Destructor.  Does not close the archive.
+     */
+    ~ZipWriter();
+
+    /**
+     * Adds a file with the given name and contents to the archive.  Pass
+     * false for compressed to store the file as it is, as OpenDocument
+     * requires of its mimetype file.  Returns false if writing to the
+     * device failed.
+     */
+    bool addFile(const QString &name, const QByteArray &data, bool compressed = true);
+
+    /**
+     * Writes the central directory that ends the archive.  No files can
+     * be added afterwards.  Returns false if writing to the device failed.
+     */
+    bool close();
+
+private:
+    // Central directory record of a file that was added.
+    struct Entry
+    {
+        QByteArray name;
+        quint16 method;
+        quint32 crc;
+        quint32 compressedSize;
+        quint32 size;
+        quint32 offset;
+    };
+
+    QIODevice *mDevice;
+    QVector<Entry> mEntries;
+    quint32 mOffset;
+    quint16 mDosTime;
+    quint16 mDosDate;
+    bool mOk;
+
+    void write16(quint16 value);
+    void write32(quint32 value);
+    void write(const QByteArray &bytes);
+
+    static quint32 crc32(const QByteArray &data);
+};
+} // namespace ghostwriter
+
+#endif // ZIP_WRITER_H
@@ -0,0 +1,74 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QScopedPointer>
+#include <QString>
+#include <QtTest>
+
+#include "cmarkgfmapi.h"
+#include "markdownast.h"
+
+using namespace ghostwriter;
+
+class TestCmarkGfmAPI : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void footnotesAreRenderedAfterParse();
+    void footnotesAreRenderedAgainFromCache();
+};
+
+void TestCmarkGfmAPI::footnotesAreRenderedAfterParse()
+{
+    QString html;
+    QScopedPointer<MarkdownAST> ast(CmarkGfmAPI::instance()->parseAndRenderHtml(
+        "Some text.[^1]\n\n[^1]: The footnote.\n",
+        false,
+        html
+    ));
+
+    QVERIFY(!ast.isNull());
+    QVERIFY(html.contains("<sup class=\"footnote-ref\">"));
+    QVERIFY(html.contains("<section class=\"footnotes\">"));
+    QVERIFY(html.contains("The footnote."));
+}
+
+void TestCmarkGfmAPI::footnotesAreRenderedAgainFromCache()
+{
+    // The second render reuses the cached HTML of the paragraph, and must
+    // still find the footnote definition that the first render gave back
+    // to the document.
+    //
+    const QString text = "Other text.[^note]\n\n[^note]: Another footnote.\n";
+
+    for (int i = 0; i < 2; i++) {
+        QString html;
+        QScopedPointer<MarkdownAST> ast(CmarkGfmAPI::instance()->parseAndRenderHtml(text, false, html));
+
+        QVERIFY(html.contains("<section class=\"footnotes\">"));
+        QVERIFY(html.contains("Another footnote."));
+    }
+
+    QString html = CmarkGfmAPI::instance()->renderToHtml(text, false);
+    QVERIFY(html.contains("Another footnote."));
+}
+
+QTEST_GUILESS_MAIN(TestCmarkGfmAPI)
+#include "tst_cmarkgfmapi.moc"
@@ -0,0 +1,225 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QString>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "abstract_dictionary.h"
+#include "dictionary_provider_compiled.h"
+
+class TestCompiledDictionary : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void checksWords_data();
+    void checksWords();
+    void compilesOnce();
+    void followsSessionWords();
+    void leavesUnsupportedDictionariesToHunspell();
+
+private:
+    QTemporaryDir m_dir;
+    DictionaryProviderCompiled *m_provider;
+
+    static bool isCorrect(const AbstractDictionary *dictionary, const QString &word);
+    void writeFile(const QString &fileName, const QByteArray &bytes);
+};
+
+void TestCompiledDictionary::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+
+    writeFile
+    (
+        "gw_TEST.aff",
+        "SET UTF-8\n"
+        "KEEPCASE K\n"
+        "FORBIDDENWORD X\n"
+        "NEEDAFFIX N\n"
+        "ONLYINCOMPOUND c\n"
+        "COMPOUNDMIN 1\n"
+        "COMPOUNDRULE 1\n"
+        "COMPOUNDRULE n*1t\n"
+        "\n"
+        "PFX U Y 1\n"
+        "PFX U 0 un .\n"
+        "\n"
+        "SFX S Y 2\n"
+        "SFX S y ies [^aeiou]y\n"
+        "SFX S 0 s [^y]\n"
+        "\n"
+        "SFX D Y 1\n"
+        "SFX D 0 ed [^e]\n"
+    );
+    writeFile
+    (
+        "gw_TEST.dic",
+        "12\n"
+        "cry/S\n"
+        "do/U\n"
+        "lock/UDS\n"
+        "bake/NS\n"
+        "Paris\n"
+        "iPod/KS\n"
+        "foo/X\n"
+        "1/n1\n"
+        "st/tc\n"
+        "well\n"
+        "known\n"
+        "it's\n"
+    );
+
+    // Compounding by flags is not compiled.
+    writeFile
+    (
+        "gw_COMPOUND.aff",
+        "SET UTF-8\n"
+        "COMPOUNDFLAG Z\n"
+    );
+    writeFile
+    (
+        "gw_COMPOUND.dic",
+        "2\n"
+        "foot/Z\n"
+        "ball/Z\n"
+    );
+
+    QDir::setSearchPaths("dict", QStringList(m_dir.path()));
+    QFile::remove(DictionaryProviderCompiled::compiledPath("gw_TEST"));
+    QFile::remove(DictionaryProviderCompiled::compiledPath("gw_COMPOUND"));
+    QFile::remove(DictionaryProviderCompiled::compiledPath("gw_COMPOUND") + ".refused");
+
+    m_provider = new DictionaryProviderCompiled();
+    m_provider->setIgnoreUppercase(false);
+    m_provider->setIgnoreNumbers(false);
+}
+
+void TestCompiledDictionary::cleanupTestCase()
+{
+    delete m_provider;
+    m_provider = nullptr;
+}
+
+void TestCompiledDictionary::checksWords_data()
+{
+    QTest::addColumn<QString>("word");
+    QTest::addColumn<bool>("correct");
+
+    QTest::newRow("stem") << "cry" << true;
+    QTest::newRow("suffix with strip") << "cries" << true;
+    QTest::newRow("suffix not matching condition") << "crys" << false;
+    QTest::newRow("prefix") << "undo" << true;
+    QTest::newRow("prefix and suffix") << "unlocked" << true;
+    QTest::newRow("stem needing affix") << "bake" << false;
+    QTest::newRow("affixed stem needing affix") << "bakes" << true;
+    QTest::newRow("proper noun") << "Paris" << true;
+    QTest::newRow("lowercased proper noun") << "paris" << false;
+    QTest::newRow("uppercased proper noun") << "PARIS" << true;
+    QTest::newRow("capitalized") << "Cries" << true;
+    QTest::newRow("uppercased") << "UNLOCKS" << true;
+    QTest::newRow("kept case") << "iPods" << true;
+    QTest::newRow("uppercased kept case") << "IPOD" << false;
+    QTest::newRow("forbidden") << "foo" << false;
+    QTest::newRow("compound") << "1st" << true;
+    QTest::newRow("repeated compound") << "11st" << true;
+    QTest::newRow("only in compound") << "st" << false;
+    QTest::newRow("hyphenated") << "well-known" << true;
+    QTest::newRow("hyphenated misspelling") << "well-knwn" << false;
+    QTest::newRow("number") << "2021" << true;
+    QTest::newRow("typographic apostrophe") << QString::fromUtf8("it\xE2\x80\x99s") << true;
+}
+
+void TestCompiledDictionary::checksWords()
+{
+    QFETCH(QString, word);
+    QFETCH(bool, correct);
+
+    QScopedPointer<AbstractDictionary> dictionary(m_provider->requestDictionary("gw_TEST"));
+
+    QVERIFY(dictionary->isValid());
+    QCOMPARE(isCorrect(dictionary.data(), word), correct);
+}
+
+void TestCompiledDictionary::compilesOnce()
+{
+    QScopedPointer<AbstractDictionary> first(m_provider->requestDictionary("gw_TEST"));
+    QFileInfo compiled(DictionaryProviderCompiled::compiledPath("gw_TEST"));
+
+    QVERIFY(compiled.exists());
+    QDateTime modified = compiled.lastModified();
+
+    // A second instance maps the same file.
+    QScopedPointer<AbstractDictionary> second(m_provider->requestDictionary("gw_TEST"));
+    compiled.refresh();
+
+    QVERIFY(second->isValid());
+    QCOMPARE(compiled.lastModified(), modified);
+    QVERIFY(isCorrect(second.data(), "unlocked"));
+}
+
+void TestCompiledDictionary::followsSessionWords()
+{
+    QScopedPointer<AbstractDictionary> dictionary(m_provider->requestDictionary("gw_TEST"));
+
+    QVERIFY(!isCorrect(dictionary.data(), "ghostwriter"));
+
+    dictionary->addToSession(QStringList("ghostwriter"));
+    QVERIFY(isCorrect(dictionary.data(), "ghostwriter"));
+    QVERIFY(isCorrect(dictionary.data(), "Ghostwriter"));
+
+    dictionary->removeFromSession(QStringList("ghostwriter"));
+    QVERIFY(!isCorrect(dictionary.data(), "ghostwriter"));
+}
+
+void TestCompiledDictionary::leavesUnsupportedDictionariesToHunspell()
+{
+    QScopedPointer<AbstractDictionary> dictionary(m_provider->requestDictionary("gw_COMPOUND"));
+
+    QVERIFY(!dictionary.isNull());
+    QVERIFY(dictionary->isValid());
+    QVERIFY(!QFile::exists(DictionaryProviderCompiled::compiledPath("gw_COMPOUND")));
+    QVERIFY(QFile::exists(DictionaryProviderCompiled::compiledPath("gw_COMPOUND") + ".refused"));
+    QVERIFY(isCorrect(dictionary.data(), "football"));
+}
+
+bool TestCompiledDictionary::isCorrect(const AbstractDictionary *dictionary, const QString &word)
+{
+    return dictionary->check(word, 0).isNull();
+}
+
+void TestCompiledDictionary::writeFile(const QString &fileName, const QByteArray &bytes)
+{
+    QFile file(m_dir.filePath(fileName));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(bytes), (qint64) bytes.size());
+}
+
+QTEST_GUILESS_MAIN(TestCompiledDictionary)
+#include "tst_compileddictionary.moc"
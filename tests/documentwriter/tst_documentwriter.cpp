@@ -0,0 +1,145 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QSignalSpy>
+#include <QString>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "documentwriter.h"
+
+using namespace ghostwriter;
+
+class TestDocumentWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writesText_data();
+    void writesText();
+    void externalChangesAfterSaveAreSeen_data();
+    void externalChangesAfterSaveAreSeen();
+
+private:
+    static QByteArray readFile(const QString &filePath);
+    static void writeFile(const QString &filePath, const QByteArray &bytes);
+};
+
+void TestDocumentWriter::writesText_data()
+{
+    QTest::addColumn<bool>("createBackup");
+
+    QTest::newRow("without backup") << false;
+    QTest::newRow("with backup") << true;
+}
+
+void TestDocumentWriter::writesText()
+{
+    QFETCH(bool, createBackup);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString filePath = dir.filePath("document.md");
+    writeFile(filePath, "Old text\n");
+
+    QString err = DocumentWriter::write(filePath, QString::fromUtf8("New text é\n"), createBackup);
+
+    QVERIFY2(err.isNull(), qPrintable(err));
+
+    // The text is written with native line endings.
+    QByteArray bytes = readFile(filePath);
+    bytes.replace("\r\n", "\n");
+    QCOMPARE(bytes, QString::fromUtf8("New text é\n").toUtf8());
+    QCOMPARE(QFile::exists(filePath + ".backup"), createBackup);
+
+    if (createBackup) {
+        QCOMPARE(readFile(filePath + ".backup"), QByteArray("Old text\n"));
+    }
+}
+
+void TestDocumentWriter::externalChangesAfterSaveAreSeen_data()
+{
+    writesText_data();
+}
+
+void TestDocumentWriter::externalChangesAfterSaveAreSeen()
+{
+    QFETCH(bool, createBackup);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString filePath = dir.filePath("document.md");
+    writeFile(filePath, "Old text\n");
+
+    QFileSystemWatcher watcher;
+    QVERIFY(watcher.addPath(filePath));
+
+    // Save twice, as the first save replaces the file that the watcher was
+    // first set up with, and the second replaces the one rewatched.
+    for (int i = 0; i < 2; i++) {
+        QString err = DocumentWriter::write(filePath, "Saved text\n", createBackup);
+        QVERIFY2(err.isNull(), qPrintable(err));
+        DocumentWriter::rewatch(&watcher, filePath);
+    }
+
+    QCOMPARE(watcher.files(), QStringList(filePath));
+
+    // Let the notifications of the saves themselves go by.
+    QTest::qWait(200);
+    QSignalSpy spy(&watcher, &QFileSystemWatcher::fileChanged);
+
+    if (createBackup) {
+        // The backup holds the replaced file, so it must not be mistaken
+        // for the document.
+        writeFile(filePath + ".backup", "Changed backup\n");
+        QTest::qWait(200);
+        QCOMPARE(spy.count(), 0);
+    }
+
+    writeFile(filePath, "Changed elsewhere\n");
+
+    QTRY_VERIFY(spy.count() > 0);
+    QCOMPARE(spy.first().first().toString(), filePath);
+}
+
+QByteArray TestDocumentWriter::readFile(const QString &filePath)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    return file.readAll();
+}
+
+void TestDocumentWriter::writeFile(const QString &filePath, const QByteArray &bytes)
+{
+    QFile file(filePath);
+
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(bytes), qint64(bytes.size()));
+}
+
+QTEST_GUILESS_MAIN(TestDocumentWriter)
+#include "tst_documentwriter.moc"
@@ -0,0 +1,202 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2021 wereturtle
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include <QGuiApplication>
+#include <QScopedPointer>
+#include <QString>
+#include <QTextCursor>
+#include <QtTest>
+
+#include "cmarkgfmapi.h"
+#include "incrementalparser.h"
+#include "markdownast.h"
+#include "markdowndocument.h"
+
+using namespace ghostwriter;
+
+class TestIncrementalParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void splicedAstMatchesFullParse_data();
+    void splicedAstMatchesFullParse();
+
+private:
+    MarkdownDocument *document;
+    IncrementalParser *parser;
+    int lastBlockCount;
+    int splices;
+
+    void parseFully();
+    void onContentsChange(int position, int charsAdded);
+};
+
+// Each edit replaces the first occurrence of "before" with "after".  The
+// spliced column tells whether the edit can be spliced into the AST, or
+// must be parsed with the whole document.
+//
+void TestIncrementalParser::splicedAstMatchesFullParse_data()
+{
+    QTest::addColumn<QString>("before");
+    QTest::addColumn<QString>("after");
+    QTest::addColumn<bool>("spliced");
+
+    QTest::newRow("edited paragraph")
+        << "Second paragraph." << "Second, edited paragraph." << true;
+    QTest::newRow("added paragraph")
+        << "Second paragraph." << "Second paragraph.\n\nNew paragraph." << true;
+    QTest::newRow("deleted paragraph")
+        << "Second paragraph.\n\n" << "" << true;
+    QTest::newRow("added link reference")
+        << "Fourth paragraph." << "Fourth [link][foo]." << false;
+    QTest::newRow("deleted link reference")
+        << "Seventh [link][foo]." << "Seventh link." << true;
+    QTest::newRow("added footnote reference")
+        << "Fourth paragraph." << "Fourth paragraph.[^1]" << false;
+    QTest::newRow("deleted footnote reference")
+        << "Fifth paragraph.[^1]" << "Fifth paragraph." << false;
+    QTest::newRow("added link definition")
+        << "Fourth paragraph." << "Fourth paragraph.\n\n[bar]: http://example.org" << false;
+    QTest::newRow("deleted link definition")
+        << "[foo]: http://example.com\n\n" << "" << false;
+    QTest::newRow("broken link definition")
+        << "[foo]:" << "foo]:" << false;
+    QTest::newRow("deleted footnote definition")
+        << "\n\n[^1]: The note." << "" << false;
+}
+
+void TestIncrementalParser::splicedAstMatchesFullParse()
+{
+    QFETCH(QString, before);
+    QFETCH(QString, after);
+    QFETCH(bool, spliced);
+
+    MarkdownDocument markdownDocument
+    (
+        "A [link][foo].\n"
+        "\n"
+        "First paragraph.\n"
+        "\n"
+        "Second paragraph.\n"
+        "\n"
+        "Third paragraph.\n"
+        "\n"
+        "Fourth paragraph.\n"
+        "\n"
+        "Fifth paragraph.[^1]\n"
+        "\n"
+        "Sixth paragraph.\n"
+        "\n"
+        "Seventh [link][foo].\n"
+        "\n"
+        "See [bar] too.\n"
+        "\n"
+        "Eighth paragraph.\n"
+        "\n"
+        "[foo]: http://example.com\n"
+        "\n"
+        "Ninth paragraph.\n"
+        "\n"
+        "Tenth paragraph.\n"
+        "\n"
+        "[^1]: The note.\n"
+    );
+
+    document = &markdownDocument;
+    parseFully();
+
+    IncrementalParser incrementalParser(document);
+    parser = &incrementalParser;
+    splices = 0;
+
+    QMetaObject::Connection connection = this->connect
+    (
+        document,
+        &QTextDocument::contentsChange,
+        [this](int position, int charsRemoved, int charsAdded) {
+            Q_UNUSED(charsRemoved)
+            onContentsChange(position, charsAdded);
+        }
+    );
+
+    int position = document->toPlainText().indexOf(before);
+    QVERIFY(position >= 0);
+
+    QTextCursor cursor(document);
+    cursor.setPosition(position);
+    cursor.setPosition(position + before.length(), QTextCursor::KeepAnchor);
+    cursor.insertText(after);
+
+    this->disconnect(connection);
+
+    MarkdownAST expected;
+    CmarkGfmAPI::instance()->parse(document->firstBlock(), document->lastBlock(), false, &expected);
+
+    QCOMPARE(document->markdownAST()->toString(), expected.toString());
+    QCOMPARE(splices > 0, spliced);
+}
+
+// Parses the whole document, as MarkdownEditor does when an edit cannot
+// be spliced.
+//
+void TestIncrementalParser::parseFully()
+{
+    MarkdownAST *ast = new MarkdownAST();
+    CmarkGfmAPI::instance()->parse(document->firstBlock(), document->lastBlock(), false, ast);
+    document->setMarkdownAST(ast);
+    lastBlockCount = document->blockCount();
+}
+
+// Splices the edit into the AST if possible, as MarkdownEditor does.
+//
+void TestIncrementalParser::onContentsChange(int position, int charsAdded)
+{
+    IncrementalParser::Region region;
+    QVector<MarkdownAST::LineRange> changes;
+    MarkdownAST *ast = document->markdownAST();
+
+    parser->findEdit(position, charsAdded, lastBlockCount, region);
+
+    if (parser->findRegion(region) && parser->splice(region, false, changes)) {
+        document->setMarkdownAST(ast, changes);
+        lastBlockCount = document->blockCount();
+        splices++;
+    } else {
+        parseFully();
+    }
+}
+
+// MarkdownDocument lays its text out with fonts, which need a GUI
+// application, so run the tests offscreen where there is no display.
+//
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QGuiApplication app(argc, argv);
+    TestIncrementalParser test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_incrementalparser.moc"
@@ -0,0 +1,65 @@
+################################################################################
+#
+# Copyright (C) 2021 wereturtle
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+################################################################################
+
+# Settings shared by the unit tests, each of which links against the
+# ghostwriter-core library built by core.pro.
+
+QT = core gui concurrent network testlib
+
+CONFIG += testcase
+CONFIG += console
+CONFIG += warn_on
+CONFIG += c++11
+CONFIG -= app_bundle
+
+DEFINES += GW_NO_WEBENGINE
+DEFINES += CMARK_GFM_STATIC_DEFINE
+DEFINES += CMARK_GFM_EXTENSIONS_STATIC_DEFINE
+DEFINES += CMARK_NO_SHORT_NAMES
+
+INCLUDEPATH += \
+    $$PWD/.. \
+    $$PWD/../src \
+    $$PWD/../src/spelling \
+    $$PWD/../3rdparty/cmark-gfm/core \
+    $$PWD/../3rdparty/cmark-gfm/extensions
+
+CONFIG(debug, debug|release) {
+    CORE_DIR = $$shadowed($$PWD/..)/build/debug
+}
+else {
+    CORE_DIR = $$shadowed($$PWD/..)/build/release
+}
+
+LIBS += -L$$CORE_DIR -lghostwriter-core
+
+unix {
+    PRE_TARGETDEPS += $$CORE_DIR/libghostwriter-core.a
+}
+
+macx {
+    LIBS += -framework AppKit
+} else:unix {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += hunspell
+
+    packagesExist(icu-uc icu-i18n) {
+        PKGCONFIG += icu-uc icu-i18n
+    }
+}